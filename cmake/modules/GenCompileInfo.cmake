@@ -19,7 +19,9 @@ function(generate_compile_info)
             "WITH_EXIV2=${WITH_EXIV2}"
             "WITH_SYSTEMD=${WITH_SYSTEMD}"
             "WITH_LASTFM=${WITH_LASTFM}"
+            "WITH_ZLIB=${WITH_ZLIB}"
             "WITH_DEBUG=${WITH_DEBUG}"
+            "WITH_GPERFTOOLS=${WITH_GPERFTOOLS}"
             "WITH_TESTS=${WITH_TESTS}")
 
     string (REPLACE ";" "\\n" COMPILE_INFO_STR "${COMPILE_INFO_LIST}")
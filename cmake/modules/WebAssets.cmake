@@ -0,0 +1,51 @@
+#
+# Prepare the web UI for installation
+#
+# Copies the web directory, adds the content hash to the asset links
+# of index.html and writes .gz and .br variants of the text files.
+# The server sends those below /content/assets/<hash>/ with
+# Content-Encoding and cache headers.
+#
+# Run in script mode:
+#   cmake -DWEB_SOURCE_DIR=... -DWEB_OUTPUT_DIR=... [-DGZIP=...] [-DBROTLI=...] -P WebAssets.cmake
+#
+
+file(REMOVE_RECURSE "${WEB_OUTPUT_DIR}")
+get_filename_component(WEB_OUTPUT_PARENT "${WEB_OUTPUT_DIR}" DIRECTORY)
+file(COPY "${WEB_SOURCE_DIR}" DESTINATION "${WEB_OUTPUT_PARENT}")
+
+# hash over names and content, so a changed file changes all links
+file(GLOB_RECURSE WEB_FILES RELATIVE "${WEB_OUTPUT_DIR}" "${WEB_OUTPUT_DIR}/*")
+list(SORT WEB_FILES)
+set(WEB_HASHES "")
+foreach(WEB_FILE ${WEB_FILES})
+    file(SHA256 "${WEB_OUTPUT_DIR}/${WEB_FILE}" FILE_HASH)
+    string(APPEND WEB_HASHES "${WEB_FILE}:${FILE_HASH}\n")
+endforeach()
+string(SHA256 WEB_HASH "${WEB_HASHES}")
+string(SUBSTRING "${WEB_HASH}" 0 12 WEB_HASH)
+
+# the links stay relative, so the UI keeps working behind a proxy with a path prefix
+file(READ "${WEB_OUTPUT_DIR}/index.html" INDEX_HTML)
+string(REGEX REPLACE "(src|href)=\"((js|vendor|assets|icons)/[^\"]*)\"" "\\1=\"content/assets/${WEB_HASH}/\\2\"" INDEX_HTML "${INDEX_HTML}")
+file(WRITE "${WEB_OUTPUT_DIR}/index.html" "${INDEX_HTML}")
+
+foreach(WEB_FILE ${WEB_FILES})
+    if(WEB_FILE MATCHES "\\.(js|css|html|json|svg|xml|ttf|eot|ico)$" AND NOT WEB_FILE STREQUAL "index.html")
+        set(WEB_PATH "${WEB_OUTPUT_DIR}/${WEB_FILE}")
+        if(GZIP)
+            execute_process(COMMAND "${GZIP}" -9 -n -k -f "${WEB_PATH}" RESULT_VARIABLE GZIP_RESULT)
+            if(NOT GZIP_RESULT EQUAL 0)
+                message(FATAL_ERROR "Failed to compress ${WEB_FILE}")
+            endif()
+        endif()
+        if(BROTLI)
+            execute_process(COMMAND "${BROTLI}" -q 11 -k -f "${WEB_PATH}" RESULT_VARIABLE BROTLI_RESULT)
+            if(NOT BROTLI_RESULT EQUAL 0)
+                message(FATAL_ERROR "Failed to compress ${WEB_FILE}")
+            endif()
+        endif()
+    endif()
+endforeach()
+
+message(STATUS "Web UI assets: ${WEB_HASH}")
@@ -3,6 +3,8 @@ import {Clients} from '../../../web/js/gerbera-clients.module';
 import mockConfig from './fixtures/config';
 import clientsDataJson from './fixtures/clients-data';
 import gerberaEmptyClients from './fixtures/clients-empty';
+import clientsStreamsJson from './fixtures/clients-streams';
+import clientsTranscodingJson from './fixtures/clients-transcoding';
 
 describe('Gerbera Clients', () => {
   let lsSpy;
@@ -52,5 +54,26 @@ describe('Gerbera Clients', () => {
       expect($('#clientgrid').find('tr').length).toEqual(3);
       clientsDataJson.success = true;
     });
+
+    it('loads the stream statistics into the stream grid', () => {
+      Clients.loadItems(clientsStreamsJson);
+      expect($('#streamgrid').find('tr').length).toEqual(3);
+      expect($('#streamgrid').find('td.grb-client-rate').first().text()).toBe('4096');
+      expect($('#streamgrid').find('td.grb-client-latency').first().text()).toBe('3000 / 150 / 40 / 8 / 2 / 0');
+      expect($('#streamgrid').find('td.grb-client-state').last().text()).toBe('done');
+    });
+
+    it('does not show streams if statistics are disabled', () => {
+      Clients.loadItems(clientsDataJson);
+      expect($('#streamgrid').find('tr').length).toEqual(0);
+    });
+
+    it('loads the transcoding slots into the transcode grid', () => {
+      Clients.loadItems(clientsTranscodingJson);
+      expect($('#transcodegrid').find('tr').length).toEqual(4);
+      expect($('#transcodegrid').find('td.grb-client-queued').first().text()).toBe('1');
+      expect($('#transcodegrid').find('td.grb-client-limit').last().text()).toBe('unlimited');
+      expect($('#transcodegrid').find('td.grb-client-fallbacks').last().text()).toBe('4');
+    });
   });
  });
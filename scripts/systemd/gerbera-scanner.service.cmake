@@ -0,0 +1,17 @@
+[Unit]
+Description=${SYSTEMD_DESCRIPTION} (scanner)
+After=${SYSTEMD_AFTER_TARGET}
+
+[Service]
+Type=simple
+User=gerbera
+Group=gerbera
+ExecStart=${CMAKE_INSTALL_PREFIX}/bin/gerbera -c /etc/gerbera/config.xml --role scanner
+Restart=on-failure
+RestartSec=5
+Nice=10
+IOSchedulingClass=idle
+MemoryMax=2G
+
+[Install]
+WantedBy=multi-user.target
@@ -0,0 +1,14 @@
+[Unit]
+Description=${SYSTEMD_DESCRIPTION} (server)
+After=${SYSTEMD_AFTER_TARGET}
+
+[Service]
+Type=simple
+User=gerbera
+Group=gerbera
+ExecStart=${CMAKE_INSTALL_PREFIX}/bin/gerbera -c /etc/gerbera/config.xml --role server
+Restart=on-failure
+RestartSec=5
+
+[Install]
+WantedBy=multi-user.target
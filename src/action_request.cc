@@ -36,6 +36,72 @@
 #include "util/tools.h"
 #include "util/upnp_quirks.h"
 
+/// \brief the document as printed for the log
+static std::string printXml(const pugi::xml_document& document)
+{
+    std::ostringstream buf;
+    document.print(buf, "", 0);
+    return buf.str();
+}
+
+#if !defined(USING_NPUPNP)
+/// \brief copies elements, attributes and text of the IXML node below parent
+///
+/// Whitespace between the elements is dropped, like pugixml does when parsing.
+static void ixmlToXml(IXML_Node* node, pugi::xml_node parent)
+{
+    for (auto child = ixmlNode_getFirstChild(node); child != nullptr; child = ixmlNode_getNextSibling(child)) {
+        switch (ixmlNode_getNodeType(child)) {
+        case eELEMENT_NODE: {
+            auto element = parent.append_child(ixmlNode_getNodeName(child));
+            auto attributes = ixmlNode_getAttributes(child);
+            if (attributes != nullptr) {
+                for (unsigned long i = 0; i < ixmlNamedNodeMap_getLength(attributes); i++) {
+                    auto attribute = ixmlNamedNodeMap_item(attributes, i);
+                    auto value = ixmlNode_getNodeValue(attribute);
+                    element.append_attribute(ixmlNode_getNodeName(attribute)) = value != nullptr ? value : "";
+                }
+                ixmlNamedNodeMap_free(attributes);
+            }
+            ixmlToXml(child, element);
+            break;
+        }
+        case eTEXT_NODE:
+        case eCDATA_SECTION_NODE: {
+            std::string_view value = ixmlNode_getNodeValue(child) != nullptr ? ixmlNode_getNodeValue(child) : "";
+            if (value.find_first_not_of(" \t\r\n") != std::string_view::npos)
+                parent.append_child(pugi::node_pcdata).set_value(value.data());
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+/// \brief creates elements, attributes and text of the pugixml node below parent in document
+static void xmlToIxml(const pugi::xml_node& node, IXML_Document* document, IXML_Node* parent)
+{
+    // the SDK takes DOMString, which is not const, but copies all values
+    for (auto&& child : node.children()) {
+        if (child.type() == pugi::node_element) {
+            IXML_Element* element = nullptr;
+            if (ixmlDocument_createElementEx(document, const_cast<char*>(child.name()), &element) != IXML_SUCCESS)
+                throw_std_runtime_error("Could not create element {}", child.name());
+            ixmlNode_appendChild(parent, reinterpret_cast<IXML_Node*>(element));
+            for (auto&& attribute : child.attributes())
+                ixmlElement_setAttribute(element, const_cast<char*>(attribute.name()), const_cast<char*>(attribute.value()));
+            xmlToIxml(child, document, reinterpret_cast<IXML_Node*>(element));
+        } else if (child.type() == pugi::node_pcdata || child.type() == pugi::node_cdata) {
+            IXML_Node* text = nullptr;
+            if (ixmlDocument_createTextNodeEx(document, const_cast<char*>(child.value()), &text) != IXML_SUCCESS)
+                throw_std_runtime_error("Could not create text of {}", node.name());
+            ixmlNode_appendChild(parent, text);
+        }
+    }
+}
+#endif
+
 ActionRequest::ActionRequest(const std::shared_ptr<Context>& context, UpnpActionRequest* upnp_request)
     : upnp_request(upnp_request)
     , errCode(UPNP_E_SUCCESS)
@@ -72,16 +138,17 @@ std::unique_ptr<pugi::xml_document> ActionRequest::getRequest() const
 {
     auto request = std::make_unique<pugi::xml_document>();
 #if defined(USING_NPUPNP)
-    auto ret = request->load_string(upnp_request->xmlAction.c_str());
+    // the SDK already decoded the arguments of the action element
+    auto root = request->append_child(actionName.c_str());
+    for (auto&& [name, value] : upnp_request->args)
+        root.append_child(name.c_str()).append_child(pugi::node_pcdata).set_value(value.c_str());
 #else
-    DOMString cxml = ixmlPrintDocument(UpnpActionRequest_get_ActionRequest(upnp_request));
-    auto ret = request->load_string(cxml);
-    ixmlFreeDOMString(cxml);
+    auto action = UpnpActionRequest_get_ActionRequest(upnp_request);
+    if (action == nullptr)
+        throw_std_runtime_error("Action {} without request", actionName);
+    ixmlToXml(reinterpret_cast<IXML_Node*>(action), *request);
 #endif
 
-    if (ret.status != pugi::xml_parse_status::status_ok)
-        throw_std_runtime_error("Unable to parse ixml");
-
     return request;
 }
 
@@ -98,25 +165,29 @@ void ActionRequest::setErrorCode(int errCode)
 void ActionRequest::update()
 {
     if (response != nullptr) {
-        std::ostringstream buf;
-        response->print(buf, "", 0);
-        std::string xml = buf.str();
-        log_debug("ActionRequest::update(): {}", xml.c_str());
+        log_debug("ActionRequest::update(): {}", printXml(*response));
 
 #if defined(USING_NPUPNP)
-        UpnpActionRequest_set_xmlResponse(upnp_request, xml);
+        // the SDK writes the response element of the action from the arguments
+        auto root = response->document_element();
+        upnp_request->resdata.clear();
+        for (auto&& child : root.children())
+            upnp_request->resdata.emplace_back(child.name(), child.child_value());
         UpnpActionRequest_set_ErrCode(upnp_request, errCode);
 #else
         IXML_Document* result = nullptr;
-        int err = ixmlParseBufferEx(xml.c_str(), &result);
-
-        if (err != IXML_SUCCESS) {
-            log_error("ActionRequest::update(): could not convert to iXML");
-            UpnpActionRequest_set_ErrCode(upnp_request, UPNP_E_ACTION_FAILED);
-        } else {
+        try {
+            if (ixmlDocument_createDocumentEx(&result) != IXML_SUCCESS)
+                throw_std_runtime_error("Could not create document");
+            xmlToIxml(*response, result, reinterpret_cast<IXML_Node*>(result));
             log_debug("ActionRequest::update(): converted to iXML, code {}", errCode);
             UpnpActionRequest_set_ActionResult(upnp_request, result);
             UpnpActionRequest_set_ErrCode(upnp_request, errCode);
+        } catch (const std::runtime_error& e) {
+            log_error("ActionRequest::update(): could not convert to iXML: {}", e.what());
+            if (result != nullptr)
+                ixmlDocument_free(result);
+            UpnpActionRequest_set_ErrCode(upnp_request, UPNP_E_ACTION_FAILED);
         }
 #endif
     } else {
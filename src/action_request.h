@@ -49,6 +49,10 @@ class Quirks;
 /// structure. The idea is to get the XML of the request, process it outside
 /// of the class, create a response XML and put it back in. Before passing
 /// *upnp_request back to the SDK the update() function MUST be called.
+///
+/// The request and the response are copied between the DOM of the SDK and
+/// pugixml node by node, or taken from the argument lists with npupnp, they
+/// are never printed and parsed again.
 class ActionRequest {
 protected:
     /// \brief Upnp_Action_Request that comes from the SDK.
@@ -95,6 +99,8 @@ public:
     std::string getServiceID() const;
 
     /// \brief Returns the XML representation of the request, that comes to us.
+    ///
+    /// The arguments are the children of the document element.
     std::unique_ptr<pugi::xml_document> getRequest() const;
 
     /// \brief Returns the client quirks
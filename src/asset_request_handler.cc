@@ -0,0 +1,147 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    asset_request_handler.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file asset_request_handler.cc
+
+#include "asset_request_handler.h" // API
+
+#include <sys/stat.h>
+
+#include "config/config_manager.h"
+#include "content/content_manager.h"
+#include "iohandler/file_io_handler.h"
+#include "util/compression.h"
+#include "util/mime.h"
+#include "util/tools.h"
+#include "util/upnp_headers.h"
+
+AssetRequestHandler::AssetRequestHandler(std::shared_ptr<ContentManager> content)
+    : RequestHandler(std::move(content))
+{
+}
+
+fs::path AssetRequestHandler::getAssetPath(const fs::path& webRoot, const std::string& url)
+{
+    auto prefix = fmt::format("/{}/{}/", SERVER_VIRTUAL_DIR, CONTENT_ASSETS_HANDLER);
+    if (!startswith(url, prefix))
+        throw_std_runtime_error("There is something wrong with the link {}", url);
+
+    // skip the hash, it only makes the url unique
+    auto hashEnd = url.find('/', prefix.length());
+    if (hashEnd == std::string::npos)
+        throw_std_runtime_error("There is something wrong with the link {}", url);
+
+    auto relative = fs::path(url.substr(hashEnd + 1)).lexically_normal();
+    if (relative.empty() || relative.is_absolute() || *relative.begin() == "..")
+        throw_std_runtime_error("Invalid asset path {}", url);
+
+    return webRoot / relative;
+}
+
+std::string AssetRequestHandler::getAssetMimeType(const fs::path& path)
+{
+    static const std::map<std::string, std::string> assetTypes {
+        { ".css", "text/css" },
+        { ".eot", "application/vnd.ms-fontobject" },
+        { ".html", "text/html" },
+        { ".ico", "image/x-icon" },
+        { ".js", "text/javascript" },
+        { ".json", MIMETYPE_JSON },
+        { ".png", "image/png" },
+        { ".svg", "image/svg+xml" },
+        { ".ttf", "font/ttf" },
+        { ".woff", "font/woff" },
+        { ".woff2", "font/woff2" },
+        { ".xml", MIMETYPE_XML },
+    };
+    return getValueOrDefault(assetTypes, toLower(path.extension().string()), MIMETYPE_DEFAULT);
+}
+
+fs::path AssetRequestHandler::getVariant(const fs::path& path, Encoding encoding)
+{
+    switch (encoding) {
+    case Encoding::Brotli:
+        return path.string() + ".br";
+    case Encoding::Gzip:
+        return path.string() + ".gz";
+    case Encoding::Identity:
+        break;
+    }
+    return path;
+}
+
+AssetRequestHandler::Encoding AssetRequestHandler::selectEncoding(const fs::path& path, const std::string& acceptEncoding)
+{
+    std::error_code ec;
+    for (auto encoding : { Encoding::Brotli, Encoding::Gzip }) {
+        if (acceptsEncoding(acceptEncoding, encoding == Encoding::Brotli ? "br" : "gzip") && isRegularFile(getVariant(path, encoding), ec))
+            return encoding;
+    }
+    return Encoding::Identity;
+}
+
+void AssetRequestHandler::getInfo(const char* filename, UpnpFileInfo* info)
+{
+    auto path = getAssetPath(config->getOption(CFG_SERVER_WEBROOT), filename);
+
+    auto encoding = selectEncoding(path, Headers::getHeader(info, "Accept-Encoding"));
+    auto variant = getVariant(path, encoding);
+
+    struct stat statbuf;
+    if (stat(variant.c_str(), &statbuf) != 0 || !S_ISREG(statbuf.st_mode))
+        throw_std_runtime_error("Failed to stat {}", variant.c_str());
+
+    UpnpFileInfo_set_FileLength(info, statbuf.st_size);
+    UpnpFileInfo_set_LastModified(info, statbuf.st_mtime);
+    UpnpFileInfo_set_IsDirectory(info, 0);
+    UpnpFileInfo_set_IsReadable(info, access(variant.c_str(), R_OK) == 0);
+
+    std::string mimetype = getAssetMimeType(path);
+#if defined(USING_NPUPNP)
+    UpnpFileInfo_set_ContentType(info, mimetype);
+#else
+    UpnpFileInfo_set_ContentType(info, ixmlCloneDOMString(mimetype.c_str()));
+#endif
+
+    Headers headers;
+    headers.addHeader("Cache-Control", "public, max-age=31536000, immutable");
+    headers.addHeader("Vary", "Accept-Encoding");
+    if (encoding != Encoding::Identity)
+        headers.addHeader("Content-Encoding", encoding == Encoding::Brotli ? "br" : "gzip");
+    headers.writeHeaders(info);
+
+    // open has no access to the request headers
+    setRequestCookie(reinterpret_cast<const void*>(static_cast<std::uintptr_t>(encoding)));
+}
+
+std::unique_ptr<IOHandler> AssetRequestHandler::open(const char* filename, enum UpnpOpenFileMode mode)
+{
+    if (mode != UPNP_READ)
+        throw_std_runtime_error("UPNP_WRITE unsupported");
+
+    auto path = getAssetPath(config->getOption(CFG_SERVER_WEBROOT), filename);
+    auto encoding = static_cast<Encoding>(reinterpret_cast<std::uintptr_t>(getRequestCookie()));
+    auto io_handler = std::make_unique<FileIOHandler>(getVariant(path, encoding));
+    io_handler->open(mode);
+    return io_handler;
+}
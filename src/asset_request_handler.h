@@ -0,0 +1,66 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    asset_request_handler.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file asset_request_handler.h
+/// \brief Definition of the AssetRequestHandler class.
+#ifndef __ASSET_REQUEST_HANDLER_H__
+#define __ASSET_REQUEST_HANDLER_H__
+
+#include <filesystem>
+
+#include "common.h"
+#include "request_handler.h"
+namespace fs = std::filesystem;
+
+/// \brief Serves the files of the web UI below /content/assets/<hash>/
+///
+/// The hash is written into index.html when the UI is installed and changes with the content,
+/// so the files can be cached forever. Precompressed .br and .gz variants are sent when the
+/// browser accepts them.
+class AssetRequestHandler : public RequestHandler {
+public:
+    explicit AssetRequestHandler(std::shared_ptr<ContentManager> content);
+
+    void getInfo(const char* filename, UpnpFileInfo* info) override;
+    std::unique_ptr<IOHandler> open(const char* filename, enum UpnpOpenFileMode mode) override;
+
+    /// \brief file in the web root for the url, throws for paths leaving the web root
+    static fs::path getAssetPath(const fs::path& webRoot, const std::string& url);
+
+    /// \brief mime type of the UI files, browsers refuse modules with other types
+    static std::string getAssetMimeType(const fs::path& path);
+
+    enum class Encoding {
+        Identity = 0,
+        Gzip,
+        Brotli,
+    };
+
+    /// \brief best precompressed variant of the file the browser accepts
+    static Encoding selectEncoding(const fs::path& path, const std::string& acceptEncoding);
+
+protected:
+    static fs::path getVariant(const fs::path& path, Encoding encoding);
+};
+
+#endif // __ASSET_REQUEST_HANDLER_H__
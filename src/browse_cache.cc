@@ -0,0 +1,115 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    browse_cache.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file browse_cache.cc
+
+#include "browse_cache.h" // API
+
+#include <algorithm>
+#include <tuple>
+
+bool BrowseCache::Key::operator<(const Key& other) const
+{
+    return std::tie(objectID, browseFlag, filter, startingIndex, requestedCount, sortCriteria, quirkFlags)
+        < std::tie(other.objectID, other.browseFlag, other.filter, other.startingIndex, other.requestedCount, other.sortCriteria, other.quirkFlags);
+}
+
+BrowseCache::BrowseCache(std::chrono::seconds ttl, std::size_t capacity)
+    : ttl(ttl)
+    , capacity(capacity)
+{
+}
+
+void BrowseCache::erase(Cache::iterator entry)
+{
+    for (int objectID : entry->second.objectIDs) {
+        auto object = byObject.find(objectID);
+        if (object == byObject.end())
+            continue;
+        object->second.erase(&entry->first);
+        if (object->second.empty())
+            byObject.erase(object);
+    }
+    cache.erase(entry);
+}
+
+std::shared_ptr<const BrowseResult> BrowseCache::get(const Key& key)
+{
+    AutoLock lock(mutex);
+    auto entry = cache.find(key);
+    if (entry == cache.end()) {
+        requests.misses.inc();
+        return nullptr;
+    }
+    if (entry->second.expires <= Clock::now()) {
+        erase(entry);
+        requests.misses.inc();
+        return nullptr;
+    }
+    requests.hits.inc();
+    cache.touch(entry);
+    return entry->second.result;
+}
+
+void BrowseCache::put(const Key& key, std::vector<int> objectIDs, std::shared_ptr<const BrowseResult> result)
+{
+    std::sort(objectIDs.begin(), objectIDs.end());
+    objectIDs.erase(std::unique(objectIDs.begin(), objectIDs.end()), objectIDs.end());
+
+    AutoLock lock(mutex);
+    auto entry = cache.find(key);
+    if (entry != cache.end())
+        erase(entry);
+
+    entry = cache.put(key, Entry { std::move(objectIDs), std::move(result), Clock::now() + ttl });
+    for (int objectID : entry->second.objectIDs)
+        byObject[objectID].insert(&entry->first);
+
+    while (cache.size() > capacity)
+        erase(std::prev(cache.end()));
+}
+
+void BrowseCache::invalidate(int objectID)
+{
+    AutoLock lock(mutex);
+    auto object = byObject.find(objectID);
+    if (object == byObject.end())
+        return;
+    auto keys = std::move(object->second);
+    byObject.erase(object);
+    for (auto&& key : keys)
+        erase(cache.find(*key));
+}
+
+void BrowseCache::clear()
+{
+    AutoLock lock(mutex);
+    byObject.clear();
+    cache.clear();
+}
+
+std::size_t BrowseCache::size()
+{
+    AutoLock lock(mutex);
+    return cache.size();
+}
@@ -0,0 +1,107 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    browse_cache.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file browse_cache.h
+#ifndef __BROWSE_CACHE_H__
+#define __BROWSE_CACHE_H__
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "util/lru_cache.h"
+#include "util/metrics.h"
+
+/// \brief Browse result sent for a request
+struct BrowseResult {
+    std::string didl;
+    std::size_t numberReturned;
+    int totalMatches;
+};
+
+/// \brief Keeps whole Browse results for clients that repeat the same request
+///
+/// Players re-issue the same Browse when they return to a menu. The result is stored per
+/// request arguments and client quirks until the update manager reports a change of the
+/// browsed object, one of the returned objects or their parents. References to items in other
+/// containers are not reported when the original changes, so results also expire after ttl.
+class BrowseCache {
+public:
+    /// \brief arguments of the Browse request and the client quirk flags
+    struct Key {
+        int objectID;
+        std::string browseFlag;
+        std::string filter;
+        std::string startingIndex;
+        std::string requestedCount;
+        std::string sortCriteria;
+        unsigned int quirkFlags;
+
+        bool operator<(const Key& other) const;
+    };
+
+    BrowseCache(std::chrono::seconds ttl, std::size_t capacity);
+
+    /// \brief result stored for key or nullptr
+    std::shared_ptr<const BrowseResult> get(const Key& key);
+
+    /// \brief remember result for key, objectIDs are the ids that make it stale when changed
+    void put(const Key& key, std::vector<int> objectIDs, std::shared_ptr<const BrowseResult> result);
+
+    /// \brief drop the results that contain the object
+    void invalidate(int objectID);
+
+    void clear();
+
+    std::size_t size();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        /// \brief without duplicates
+        std::vector<int> objectIDs;
+        std::shared_ptr<const BrowseResult> result;
+        Clock::time_point expires;
+    };
+    using Cache = LruCache<Key, Entry>;
+
+    /// \brief remove the entry and its keys from byObject, lock must be held
+    void erase(Cache::iterator entry);
+
+    std::chrono::seconds ttl;
+    std::size_t capacity;
+    Cache cache;
+    /// \brief keys of the results containing each object
+    std::unordered_map<int, std::unordered_set<const Key*>> byObject;
+    std::mutex mutex;
+    Metrics::CacheRequests requests { "browse" };
+
+    using AutoLock = std::lock_guard<std::mutex>;
+};
+
+#endif // __BROWSE_CACHE_H__
@@ -0,0 +1,339 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    browse_snapshot.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file browse_snapshot.cc
+
+#include "browse_snapshot.h" // API
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "browse_cache.h"
+#include "common.h"
+#include "util/tools.h"
+#include "util/xml_writer.h"
+
+static constexpr char SNAPSHOT_MAGIC[8] = { 'G', 'R', 'B', 'S', 'N', 'A', 'P', '1' };
+
+struct BrowseSnapshot::Mapping {
+    char* data;
+    std::size_t size;
+    const IndexEntry* index { nullptr };
+    std::size_t objectCount { 0 };
+    const std::int32_t* children { nullptr };
+    std::size_t childrenCount { 0 };
+
+    Mapping(char* data, std::size_t size)
+        : data(data)
+        , size(size)
+    {
+    }
+    ~Mapping() { munmap(data, size); }
+
+    const IndexEntry* find(int id) const
+    {
+        auto last = index + objectCount;
+        auto entry = std::lower_bound(index, last, id, [](const IndexEntry& e, int value) { return e.id < value; });
+        return entry != last && entry->id == id ? entry : nullptr;
+    }
+
+    std::string_view fragment(const IndexEntry& entry) const { return { data + entry.fragmentOffset, std::size_t(entry.fragmentLength) }; }
+};
+
+BrowseSnapshot::BrowseSnapshot(fs::path file, std::chrono::seconds rebuildDelay)
+    : file(std::move(file))
+    , rebuildDelay(rebuildDelay)
+{
+    // the database may have changed while the server was stopped, the first rebuild starts at once
+    lastChange = std::chrono::steady_clock::now() - rebuildDelay;
+}
+
+BrowseSnapshot::~BrowseSnapshot() = default;
+
+std::shared_ptr<BrowseSnapshot::Mapping> BrowseSnapshot::map(const fs::path& file)
+{
+    int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw_std_runtime_error("Failed to open {}: {}", file.c_str(), std::strerror(errno));
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) != 0 || std::size_t(statbuf.st_size) < sizeof(Header)) {
+        ::close(fd);
+        throw_std_runtime_error("Browse snapshot {} is truncated", file.c_str());
+    }
+    auto size = std::size_t(statbuf.st_size);
+    void* addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    int mapError = errno;
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        throw_std_runtime_error("Failed to map {}: {}", file.c_str(), std::strerror(mapError));
+
+    auto result = std::make_shared<Mapping>(static_cast<char*>(addr), size);
+    Header header;
+    std::memcpy(&header, result->data, sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0
+        || header.indexOffset % alignof(IndexEntry) != 0 || header.childrenOffset % alignof(std::int32_t) != 0
+        || header.indexOffset + header.objectCount * sizeof(IndexEntry) > size
+        || header.childrenOffset + header.childrenCount * sizeof(std::int32_t) > size)
+        throw_std_runtime_error("Browse snapshot {} is damaged", file.c_str());
+
+    result->index = reinterpret_cast<const IndexEntry*>(result->data + header.indexOffset);
+    result->objectCount = header.objectCount;
+    result->children = reinterpret_cast<const std::int32_t*>(result->data + header.childrenOffset);
+    result->childrenCount = header.childrenCount;
+    return result;
+}
+
+bool BrowseSnapshot::browse(int objectID, bool directChildren, std::size_t startingIndex, std::size_t requestedCount, XmlStreamWriter& didl, BrowseResult& result)
+{
+    std::shared_ptr<Mapping> current;
+    const IndexEntry* entry = nullptr;
+    {
+        AutoLock lock(mutex);
+        if (mapping && !stale.count(objectID))
+            entry = mapping->find(objectID);
+        // the element of the object is part of the listing of its parent
+        if (entry && !directChildren && stale.count(entry->parentID))
+            entry = nullptr;
+        if (!entry || (directChildren && entry->childCount < 0)) {
+            requests.misses.inc();
+            return false;
+        }
+        current = mapping;
+    }
+    requests.hits.inc();
+
+    if (!directChildren) {
+        didl.addFragment(current->fragment(*entry));
+        result.numberReturned = 1;
+        result.totalMatches = 1;
+        return true;
+    }
+
+    auto total = std::size_t(entry->childCount);
+    auto first = std::min(startingIndex, total);
+    auto last = requestedCount == 0 ? total : std::min(total, first + requestedCount);
+    for (auto i = first; i < last; i++) {
+        auto child = current->find(current->children[entry->firstChild + i]);
+        if (child)
+            didl.addFragment(current->fragment(*child));
+    }
+    result.numberReturned = last - first;
+    result.totalMatches = int(total);
+    return true;
+}
+
+void BrowseSnapshot::markStale(const std::shared_ptr<Mapping>& in, int id)
+{
+    stale.insert(id);
+    if (auto entry = in->find(id))
+        stale.insert(entry->parentID);
+}
+
+void BrowseSnapshot::invalidate(int containerID)
+{
+    AutoLock lock(mutex);
+    if (mapping)
+        markStale(mapping, containerID);
+    if (building)
+        changedWhileBuilding.push_back(containerID);
+    lastChange = std::chrono::steady_clock::now();
+    cond.notify_one();
+}
+
+void BrowseSnapshot::clear()
+{
+    AutoLock lock(mutex);
+    mapping = nullptr;
+    stale.clear();
+    full = true;
+    if (building)
+        clearedWhileBuilding = true;
+    lastChange = std::chrono::steady_clock::now();
+    cond.notify_one();
+}
+
+bool BrowseSnapshot::waitForRebuild()
+{
+    AutoLockU lock(mutex);
+    while (!stopped) {
+        if (!full && stale.empty()) {
+            cond.wait(lock);
+            continue;
+        }
+        // imports report changes all the time, the file is written when they are done
+        auto due = lastChange + rebuildDelay;
+        if (std::chrono::steady_clock::now() >= due)
+            return true;
+        cond.wait_until(lock, due);
+    }
+    return false;
+}
+
+void BrowseSnapshot::shutdown()
+{
+    AutoLock lock(mutex);
+    stopped = true;
+    cond.notify_all();
+}
+
+void BrowseSnapshot::rebuild(const Object& root, const ListChildren& list, const std::atomic_bool& stop)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<Mapping> previous;
+    std::unordered_set<int> changed;
+    {
+        AutoLock lock(mutex);
+        if (!full)
+            previous = mapping;
+        changed = stale;
+        full = false;
+        building = true;
+        clearedWhileBuilding = false;
+        changedWhileBuilding.clear();
+    }
+
+    fs::path temp = file;
+    temp += ".tmp";
+    auto abandon = [&] {
+        std::error_code ec;
+        fs::remove(temp, ec);
+        AutoLock lock(mutex);
+        building = false;
+        // the stale containers of the mapping were not cleared, only the first rebuild has to start over
+        full = full || clearedWhileBuilding || !previous;
+        // try again after the delay
+        lastChange = std::chrono::steady_clock::now();
+    };
+
+    std::size_t copied = 0;
+    std::size_t listed = 0;
+    std::vector<IndexEntry> index;
+    std::vector<std::int32_t> children;
+    std::shared_ptr<Mapping> next;
+    try {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw_std_runtime_error("Failed to create {}: {}", temp.c_str(), std::strerror(errno));
+
+        Header header {};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        std::uint64_t offset = sizeof(header);
+        std::unordered_map<int, std::size_t> position;
+        auto add = [&](int id, int parentID, bool isContainer, std::string_view fragment) {
+            if (position.count(id))
+                return false;
+            position[id] = index.size();
+            index.push_back(IndexEntry { id, parentID, isContainer ? 0 : -1, 0, offset, fragment.size() });
+            out.write(fragment.data(), fragment.size());
+            offset += fragment.size();
+            return true;
+        };
+
+        add(root.id, INVALID_OBJECT_ID, true, root.fragment);
+        std::vector<int> queue { root.id };
+        for (std::size_t next = 0; next < queue.size(); next++) {
+            if (stop) {
+                abandon();
+                return;
+            }
+            int containerID = queue.at(next);
+            auto firstChild = children.size();
+            auto old = previous && !changed.count(containerID) ? previous->find(containerID) : nullptr;
+            if (old && old->childCount >= 0) {
+                for (auto i = old->firstChild; i < old->firstChild + std::uint32_t(old->childCount); i++) {
+                    auto child = previous->find(previous->children[i]);
+                    if (!child || !add(child->id, containerID, child->childCount >= 0, previous->fragment(*child)))
+                        continue;
+                    children.push_back(child->id);
+                    if (child->childCount >= 0)
+                        queue.push_back(child->id);
+                }
+                copied++;
+            } else {
+                for (auto&& obj : list(containerID)) {
+                    if (!add(obj.id, containerID, obj.isContainer, obj.fragment))
+                        continue;
+                    children.push_back(obj.id);
+                    if (obj.isContainer)
+                        queue.push_back(obj.id);
+                }
+                listed++;
+            }
+            auto&& entry = index.at(position.at(containerID));
+            entry.firstChild = std::uint32_t(firstChild);
+            entry.childCount = std::int32_t(children.size() - firstChild);
+        }
+
+        std::sort(index.begin(), index.end(), [](const IndexEntry& a, const IndexEntry& b) { return a.id < b.id; });
+        auto padding = (alignof(IndexEntry) - offset % alignof(IndexEntry)) % alignof(IndexEntry);
+        out.write("\0\0\0\0\0\0\0\0", padding);
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        header.objectCount = index.size();
+        header.indexOffset = offset + padding;
+        header.childrenOffset = header.indexOffset + index.size() * sizeof(IndexEntry);
+        header.childrenCount = children.size();
+        out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(IndexEntry));
+        out.write(reinterpret_cast<const char*>(children.data()), children.size() * sizeof(std::int32_t));
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.close();
+        if (!out)
+            throw_std_runtime_error("Failed to write {}", temp.c_str());
+
+        // running requests keep the previous mapping, it stays valid after the file is replaced
+        fs::rename(temp, file);
+        next = map(file);
+    } catch (const std::exception&) {
+        abandon();
+        throw;
+    }
+
+    {
+        AutoLock lock(mutex);
+        building = false;
+        if (clearedWhileBuilding) {
+            // the configuration changed, the objects have to be rendered again
+            full = true;
+            return;
+        }
+        mapping = next;
+        stale.clear();
+        for (int id : changedWhileBuilding)
+            markStale(mapping, id);
+        changedWhileBuilding.clear();
+    }
+    log_info("Browse snapshot of {} objects written in {} ms, {} containers listed, {} kept", index.size(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count(), listed, copied);
+}
+
+std::size_t BrowseSnapshot::size()
+{
+    AutoLock lock(mutex);
+    return mapping ? mapping->objectCount : 0;
+}
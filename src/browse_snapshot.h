@@ -0,0 +1,151 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    browse_snapshot.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file browse_snapshot.h
+#ifndef __BROWSE_SNAPSHOT_H__
+#define __BROWSE_SNAPSHOT_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+namespace fs = std::filesystem;
+
+#include "util/metrics.h"
+
+// forward declaration
+class XmlStreamWriter;
+struct BrowseResult;
+
+/// \brief Read-only copy of the tree answering Browse requests without a query
+///
+/// The file holds the DIDL-Lite of every object rendered for the filter "*" and a client
+/// without quirks, and the children of every container in the order of the database. It is
+/// memory mapped, so a Browse only looks up the object and copies the fragments of the page.
+/// A change reported by the update manager marks the container and its parent as stale, they are
+/// answered from the database until the file is written again. The rewrite takes the unchanged
+/// containers from the previous file and only lists the stale ones.
+class BrowseSnapshot {
+public:
+    /// \brief object as listed in its parent container
+    struct Object {
+        int id;
+        bool isContainer;
+        /// \brief DIDL-Lite element written by releaseFragment
+        std::string fragment;
+    };
+
+    /// \brief children of the container in browse order
+    using ListChildren = std::function<std::vector<Object>(int containerID)>;
+
+    /// \param file replaced on each rebuild
+    /// \param rebuildDelay time without changes before the file is written again
+    BrowseSnapshot(fs::path file, std::chrono::seconds rebuildDelay);
+    ~BrowseSnapshot();
+
+    /// \brief append the requested page to didl and set the counts of result
+    /// \return false if the object is not in the snapshot or changed since it was written.
+    bool browse(int objectID, bool directChildren, std::size_t startingIndex, std::size_t requestedCount, XmlStreamWriter& didl, BrowseResult& result);
+
+    /// \brief the container changed, it and its parent are answered from the database until the next rebuild
+    void invalidate(int containerID);
+
+    /// \brief drop the snapshot, the next rebuild lists all containers again
+    void clear();
+
+    /// \brief block until there are changes and none came for the rebuild delay
+    /// \return false when shut down.
+    bool waitForRebuild();
+
+    /// \brief wake up waitForRebuild
+    void shutdown();
+
+    /// \brief write the file and map it
+    /// \param root the root container
+    /// \param list called for the new and stale containers only
+    /// \param stop abandons the new file when set
+    void rebuild(const Object& root, const ListChildren& list, const std::atomic_bool& stop);
+
+    /// \brief objects in the mapped snapshot
+    std::size_t size();
+
+protected:
+    struct Mapping;
+
+    /// \brief on disk at the start of the file
+    struct Header {
+        char magic[8];
+        std::uint64_t objectCount;
+        std::uint64_t indexOffset;
+        std::uint64_t childrenOffset;
+        std::uint64_t childrenCount;
+    };
+
+    /// \brief on disk for each object, sorted by id
+    struct IndexEntry {
+        std::int32_t id;
+        std::int32_t parentID;
+        /// \brief -1 for items
+        std::int32_t childCount;
+        std::uint32_t firstChild;
+        std::uint64_t fragmentOffset;
+        std::uint64_t fragmentLength;
+    };
+
+    static std::shared_ptr<Mapping> map(const fs::path& file);
+
+    /// \brief add id and its parent in the mapping to stale
+    void markStale(const std::shared_ptr<Mapping>& in, int id);
+
+    fs::path file;
+    std::chrono::seconds rebuildDelay;
+
+    std::shared_ptr<Mapping> mapping;
+    /// \brief objects changed since mapping was written
+    std::unordered_set<int> stale;
+    /// \brief containers changed while a rebuild runs, stale in the new mapping
+    std::vector<int> changedWhileBuilding;
+    /// \brief all containers have to be listed on the next rebuild
+    bool full { true };
+    bool building { false };
+    bool clearedWhileBuilding { false };
+    bool stopped { false };
+    std::chrono::steady_clock::time_point lastChange;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    Metrics::CacheRequests requests { "snapshot" };
+
+    using AutoLock = std::lock_guard<std::mutex>;
+    using AutoLockU = std::unique_lock<std::mutex>;
+};
+
+#endif // __BROWSE_SNAPSHOT_H__
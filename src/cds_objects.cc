@@ -32,6 +32,8 @@
 #include "cds_objects.h" // API
 
 #include <filesystem>
+#include <mutex>
+#include <unordered_set>
 
 #include "database/database.h"
 #include "util/tools.h"
@@ -39,8 +41,19 @@
 static constexpr bool IS_CDS_ITEM(unsigned int type) { return type & OBJECT_TYPE_ITEM; }
 static constexpr bool IS_CDS_PURE_ITEM(unsigned int type) { return type == OBJECT_TYPE_ITEM; }
 
+const std::string& CdsObject::intern(const std::string& value)
+{
+    // elements of an unordered_set keep their address on rehash, the pool outlives all objects
+    static auto pool = new std::unordered_set<std::string>();
+    static std::mutex mutex;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    return *pool->insert(value).first;
+}
+
 CdsObject::CdsObject()
-    : mtime(0)
+    : upnpClass(&intern(""))
+    , mtime(0)
     , sizeOnDisk(0)
 {
     id = INVALID_OBJECT_ID;
@@ -57,7 +70,7 @@ void CdsObject::copyTo(const std::shared_ptr<CdsObject>& obj)
     obj->setRefID(refID);
     obj->setParentID(parentID);
     obj->setTitle(title);
-    obj->setClass(upnpClass);
+    obj->setClass(*upnpClass);
     obj->setLocation(location);
     obj->setMTime(mtime);
     obj->setSizeOnDisk(sizeOnDisk);
@@ -75,7 +88,7 @@ bool CdsObject::equals(const std::shared_ptr<CdsObject>& obj, bool exactly)
             && parentID == obj->getParentID()
             && isRestricted() == obj->isRestricted()
             && title == obj->getTitle()
-            && upnpClass == obj->getClass()
+            && upnpClass == obj->upnpClass
             && sortPriority == obj->getSortPriority()))
         return false;
 
@@ -109,7 +122,7 @@ void CdsObject::validate()
     if (this->title.empty())
         throw_std_runtime_error("Object validation failed: missing title");
 
-    if (this->upnpClass.empty())
+    if (upnpClass->empty())
         throw_std_runtime_error("Object validation failed: missing upnp class");
 }
 
@@ -133,13 +146,13 @@ std::shared_ptr<CdsObject> CdsObject::createObject(unsigned int objectType)
 
 CdsItem::CdsItem()
     : CdsObject()
-    , mimeType(MIMETYPE_DEFAULT)
+    , mimeType(&intern(MIMETYPE_DEFAULT))
     , partNumber(0)
     , trackNumber(0)
     , bookMarkPos(0)
 {
     objectType = OBJECT_TYPE_ITEM;
-    upnpClass = "object.item";
+    setClass("object.item");
 }
 
 void CdsItem::copyTo(const std::shared_ptr<CdsObject>& obj)
@@ -149,7 +162,7 @@ void CdsItem::copyTo(const std::shared_ptr<CdsObject>& obj)
         return;
     auto item = std::static_pointer_cast<CdsItem>(obj);
     //    item->setDescription(description);
-    item->setMimeType(mimeType);
+    item->setMimeType(*mimeType);
     item->setTrackNumber(trackNumber);
     item->setPartNumber(partNumber);
     item->setServiceID(serviceID);
@@ -160,14 +173,14 @@ bool CdsItem::equals(const std::shared_ptr<CdsObject>& obj, bool exactly)
     auto item = std::static_pointer_cast<CdsItem>(obj);
     if (!CdsObject::equals(obj, exactly))
         return false;
-    return (mimeType == item->getMimeType() && partNumber == item->getPartNumber() && trackNumber == item->getTrackNumber() && serviceID == item->getServiceID() && bookMarkPos == item->getBookMarkPos());
+    return (mimeType == item->mimeType && partNumber == item->getPartNumber() && trackNumber == item->getTrackNumber() && serviceID == item->getServiceID() && bookMarkPos == item->getBookMarkPos());
 }
 
 void CdsItem::validate()
 {
     CdsObject::validate();
-    //    log_info("mime: [{}] loc [{}]", this->mimeType.c_str(), this->location.c_str());
-    if (this->mimeType.empty())
+    //    log_info("mime: [{}] loc [{}]", mimeType->c_str(), this->location.c_str());
+    if (mimeType->empty())
         throw_std_runtime_error("Item validation failed: missing mimetype");
 
     if (this->location.empty())
@@ -188,14 +201,14 @@ CdsItemExternalURL::CdsItemExternalURL()
 {
     objectType |= OBJECT_TYPE_ITEM_EXTERNAL_URL;
 
-    upnpClass = UPNP_CLASS_ITEM;
-    mimeType = MIMETYPE_DEFAULT;
+    setClass(UPNP_CLASS_ITEM);
+    setMimeType(MIMETYPE_DEFAULT);
 }
 
 void CdsItemExternalURL::validate()
 {
     CdsItem::validate();
-    if (this->mimeType.empty())
+    if (mimeType->empty())
         throw_std_runtime_error("URL Item validation failed: missing mimetype");
 
     if (this->location.empty())
@@ -210,7 +223,7 @@ CdsContainer::CdsContainer()
     updateID = 0;
     // searchable = 0; is now in objectFlags; by default all flags (except "restricted") are not set
     childCount = -1;
-    upnpClass = UPNP_CLASS_CONTAINER;
+    setClass(UPNP_CLASS_CONTAINER);
     autoscanType = OBJECT_AUTOSCAN_NONE;
 }
 
@@ -67,7 +67,9 @@ static constexpr bool IS_CDS_ITEM_EXTERNAL_URL(unsigned int type) { return type
 #define OBJECT_FLAG_PROXY_URL 0x00000020u
 #define OBJECT_FLAG_ONLINE_SERVICE 0x00000040u
 #define OBJECT_FLAG_OGG_THEORA 0x00000080u
+#define OBJECT_FLAG_PENDING_METADATA 0x00000100u
 #define OBJECT_FLAG_PLAYED 0x00000200u
+#define OBJECT_FLAG_PENDING_TRANSCODE 0x00000400u
 
 #define OBJECT_AUTOSCAN_NONE 0u
 #define OBJECT_AUTOSCAN_UI 1u
@@ -88,8 +90,8 @@ protected:
     /// \brief dc:title
     std::string title;
 
-    /// \brief upnp:class
-    std::string upnpClass;
+    /// \brief upnp:class, interned, objects of a class share the string
+    const std::string* upnpClass;
 
     /// \brief Physical location of the media.
     fs::path location;
@@ -166,19 +168,19 @@ public:
     void setTitle(const std::string& title) { this->title = title; }
 
     /// \brief Retrieve the title.
-    std::string getTitle() const { return title; }
+    const std::string& getTitle() const { return title; }
 
     /// \brief set the upnp:class
-    void setClass(const std::string& upnpClass) { this->upnpClass = upnpClass; }
+    void setClass(const std::string& upnpClass) { this->upnpClass = &intern(upnpClass); }
 
     /// \brief Retrieve class
-    std::string getClass() const { return upnpClass; }
+    const std::string& getClass() const { return *upnpClass; }
 
     /// \brief Set the physical location of the media (usually an absolute path)
     void setLocation(fs::path location) { this->location = std::move(location); }
 
     /// \brief Retrieve media location.
-    fs::path getLocation() const { return location; }
+    const fs::path& getLocation() const { return location; }
 
     /// \brief Set modification time of the media file.
     void setMTime(time_t mtime) { this->mtime = mtime; }
@@ -242,12 +244,12 @@ public:
     }
 
     /// \brief Query entire metadata dictionary.
-    std::map<std::string, std::string> getMetadata() const { return metadata; }
+    const std::map<std::string, std::string>& getMetadata() const { return metadata; }
 
     /// \brief Set entire metadata dictionary.
-    void setMetadata(const std::map<std::string, std::string>& metadata)
+    void setMetadata(std::map<std::string, std::string> metadata)
     {
-        this->metadata = metadata;
+        this->metadata = std::move(metadata);
     }
 
     /// \brief Set a single metadata value.
@@ -269,7 +271,7 @@ public:
     }
 
     /// \brief Query entire auxdata dictionary.
-    std::map<std::string, std::string> getAuxData() const { return auxdata; }
+    const std::map<std::string, std::string>& getAuxData() const { return auxdata; }
 
     /// \brief Set a single auxdata value.
     void setAuxData(const std::string& key, const std::string& value)
@@ -278,9 +280,9 @@ public:
     }
 
     /// \brief Set entire auxdata dictionary.
-    void setAuxData(const std::map<std::string, std::string>& auxdata)
+    void setAuxData(std::map<std::string, std::string> auxdata)
     {
-        this->auxdata = auxdata;
+        this->auxdata = std::move(auxdata);
     }
 
     /// \brief Removes auxdata with the given key
@@ -293,15 +295,15 @@ public:
     size_t getResourceCount() const { return resources.size(); }
 
     /// \brief Query resources
-    std::vector<std::shared_ptr<CdsResource>> getResources() const
+    const std::vector<std::shared_ptr<CdsResource>>& getResources() const
     {
         return resources;
     }
 
     /// \brief Set resources
-    void setResources(const std::vector<std::shared_ptr<CdsResource>>& res)
+    void setResources(std::vector<std::shared_ptr<CdsResource>> res)
     {
-        resources = res;
+        resources = std::move(res);
     }
 
     /// \brief Search resources for given handler id
@@ -360,13 +362,18 @@ public:
     static std::shared_ptr<CdsObject> createObject(unsigned int objectType);
 
     static std::string mapObjectType(unsigned int objectType);
+
+    /// \brief shared copy of value, used for upnp:class and mime type
+    ///
+    /// Their values come from a small set, the strings are never freed.
+    static const std::string& intern(const std::string& value);
 };
 
 /// \brief An Item in the content directory.
 class CdsItem : public CdsObject {
 protected:
-    /// \brief mime-type of the media.
-    std::string mimeType;
+    /// \brief mime-type of the media, interned
+    const std::string* mimeType;
 
     /// \brief number of part, e.g. disk or season
     int partNumber;
@@ -384,13 +391,13 @@ public:
     explicit CdsItem();
 
     /// \brief Set mime-type information of the media.
-    void setMimeType(const std::string& mimeType) { this->mimeType = mimeType; }
+    void setMimeType(const std::string& mimeType) { this->mimeType = &intern(mimeType); }
 
     bool isItem() const override { return true; }
     bool isPureItem() const override { return true; }
 
     /// \brief Query mime-type information.
-    std::string getMimeType() const { return mimeType; }
+    const std::string& getMimeType() const { return *mimeType; }
 
     /// \brief Sets the upnp:originalTrackNumber property
     void setTrackNumber(int trackNumber) { this->trackNumber = trackNumber; }
@@ -418,7 +425,7 @@ public:
     void setServiceID(const std::string& serviceID) { this->serviceID = serviceID; }
 
     /// \brief Retrieve the unique service ID.
-    std::string getServiceID() const { return serviceID; }
+    const std::string& getServiceID() const { return serviceID; }
 
     /// \brief Retrieve the last known bookmark position in milliseconds.
     void setBookMarkPos(const unsigned int bookMarkPos) { this->bookMarkPos = bookMarkPos; }
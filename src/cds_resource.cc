@@ -31,7 +31,7 @@
 
 #include "cds_resource.h" // API
 
-#include <sstream>
+#include <array>
 
 #include "util/tools.h"
 
@@ -42,14 +42,14 @@ CdsResource::CdsResource(int handlerType)
     this->handlerType = handlerType;
 }
 CdsResource::CdsResource(int handlerType,
-    const std::map<std::string, std::string>& attributes,
-    const std::map<std::string, std::string>& parameters,
-    const std::map<std::string, std::string>& options)
+    std::map<std::string, std::string> attributes,
+    std::map<std::string, std::string> parameters,
+    std::map<std::string, std::string> options)
+    : handlerType(handlerType)
+    , attributes(std::move(attributes))
+    , parameters(std::move(parameters))
+    , options(std::move(options))
 {
-    this->handlerType = handlerType;
-    this->attributes = attributes;
-    this->parameters = parameters;
-    this->options = options;
 }
 
 void CdsResource::addAttribute(resource_attributes_t res, std::string value)
@@ -84,17 +84,17 @@ int CdsResource::getHandlerType() const
     return handlerType;
 }
 
-std::map<std::string, std::string> CdsResource::getAttributes() const
+const std::map<std::string, std::string>& CdsResource::getAttributes() const
 {
     return attributes;
 }
 
-std::map<std::string, std::string> CdsResource::getParameters() const
+const std::map<std::string, std::string>& CdsResource::getParameters() const
 {
     return parameters;
 }
 
-std::map<std::string, std::string> CdsResource::getOptions() const
+const std::map<std::string, std::string>& CdsResource::getOptions() const
 {
     return options;
 }
@@ -131,25 +131,26 @@ std::shared_ptr<CdsResource> CdsResource::clone()
 std::string CdsResource::encode()
 {
     // encode resources
-    std::ostringstream buf;
-    buf << handlerType;
-    buf << RESOURCE_PART_SEP;
-    buf << dictEncode(attributes);
-    buf << RESOURCE_PART_SEP;
-    buf << dictEncode(parameters);
-    buf << RESOURCE_PART_SEP;
-    buf << dictEncode(options);
-    return buf.str();
+    return fmt::format("{}{}{}{}{}{}{}", handlerType, RESOURCE_PART_SEP, dictEncodeCompact(attributes), RESOURCE_PART_SEP,
+        dictEncodeCompact(parameters), RESOURCE_PART_SEP, dictEncodeCompact(options));
 }
 
-std::shared_ptr<CdsResource> CdsResource::decode(const std::string& serial)
+std::shared_ptr<CdsResource> CdsResource::decode(std::string_view serial)
 {
-    std::vector<std::string> parts = splitString(serial, RESOURCE_PART_SEP, true);
-    size_t size = parts.size();
+    // the parts are decoded straight from the database row
+    std::array<std::string_view, 5> parts;
+    size_t size = 0;
+    for (size_t pos = 0; size < parts.size();) {
+        auto next = serial.find(RESOURCE_PART_SEP, pos);
+        parts[size++] = serial.substr(pos, next == std::string_view::npos ? next : next - pos);
+        if (next == std::string_view::npos)
+            break;
+        pos = next + 1;
+    }
     if (size < 2 || size > 4)
         throw_std_runtime_error("Could not parse resources");
 
-    int handlerType = std::stoi(parts[0]);
+    int handlerType = std::stoi(std::string(parts[0]));
 
     std::map<std::string, std::string> attr;
     dictDecode(parts[1], &attr);
@@ -162,6 +163,5 @@ std::shared_ptr<CdsResource> CdsResource::decode(const std::string& serial)
     if (size >= 4)
         dictDecode(parts[3], &opt);
 
-    auto resource = std::make_shared<CdsResource>(handlerType, attr, par, opt);
-    return resource;
+    return std::make_shared<CdsResource>(handlerType, std::move(attr), std::move(par), std::move(opt));
 }
@@ -35,6 +35,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 
 #include "common.h"
 #include "metadata/metadata_handler.h"
@@ -49,6 +50,12 @@
 
 #define RESOURCE_OPTION_FOURCC "4cc"
 
+/// \brief transcoding profile that produced a resource transcoded ahead of time
+#define RESOURCE_OPTION_PROFILE "prf"
+
+/// \brief key of the embedded picture in the artwork store
+#define RESOURCE_OPTION_ARTWORK "art"
+
 class CdsResource {
 protected:
     int handlerType;
@@ -64,9 +71,9 @@ public:
     /// \param handler_type id of the associated handler
     explicit CdsResource(int handlerType);
     CdsResource(int handlerType,
-        const std::map<std::string, std::string>& attributes,
-        const std::map<std::string, std::string>& parameters,
-        const std::map<std::string, std::string>& options);
+        std::map<std::string, std::string> attributes,
+        std::map<std::string, std::string> parameters,
+        std::map<std::string, std::string> options);
 
     /// \brief Adds a resource attribute.
     ///
@@ -102,9 +109,9 @@ public:
     void addOption(const std::string& name, std::string value);
 
     int getHandlerType() const;
-    std::map<std::string, std::string> getAttributes() const;
-    std::map<std::string, std::string> getParameters() const;
-    std::map<std::string, std::string> getOptions() const;
+    const std::map<std::string, std::string>& getAttributes() const;
+    const std::map<std::string, std::string>& getParameters() const;
+    const std::map<std::string, std::string>& getOptions() const;
     std::string getAttribute(resource_attributes_t res) const;
     std::string getParameter(const std::string& name) const;
     std::string getOption(const std::string& name) const;
@@ -118,7 +125,7 @@ public:
 
     /// \brief urlencode into string
     std::string encode();
-    static std::shared_ptr<CdsResource> decode(const std::string& serial);
+    static std::shared_ptr<CdsResource> decode(std::string_view serial);
 };
 
 #endif // __CDS_RESOURCE_H__
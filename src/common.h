@@ -60,6 +60,8 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #define CONTENT_SERVE_HANDLER "serve"
 #define CONTENT_ONLINE_HANDLER "online"
 #define CONTENT_UI_HANDLER "interface"
+#define CONTENT_ASSETS_HANDLER "assets"
+#define CONTENT_METRICS_HANDLER "metrics"
 #define DEVICE_DESCRIPTION_PATH "description.xml"
 
 // SEPARATOR
@@ -72,6 +74,7 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #define MIMETYPE_XML "text/xml"
 #define MIMETYPE_TEXT "text/plain"
 #define MIMETYPE_JSON "application/json" // RFC 4627
+#define MIMETYPE_EVENT_STREAM "text/event-stream"
 // default mime types for items in the cds
 #define MIMETYPE_DEFAULT "application/octet-stream"
 
@@ -92,6 +95,9 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #define DEFAULT_FILESYSTEM_CHARSET "UTF-8"
 #define DEFAULT_FALLBACK_CHARSET "US-ASCII"
 #define DEFAULT_JS_CHARSET "UTF-8"
+#define DEFAULT_JS_GC_INTERVAL 1000
+#define DEFAULT_JS_GC_HEAP_GROWTH 4096
+#define DEFAULT_JS_TIMEOUT 0
 
 #define DEFAULT_CONFIG_HOME ".config/gerbera"
 #define DEFAULT_TMPDIR "/tmp/"
@@ -99,6 +105,9 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #define DEFAULT_UI_EN_VALUE YES
 #define DEFAULT_UI_SHOW_TOOLTIPS_VALUE YES
 #define DEFAULT_POLL_WHEN_IDLE_VALUE NO
+#define DEFAULT_UI_UPDATE_STREAMS 4
+#define DEFAULT_UI_COMPRESSION_LEVEL 6
+#define DEFAULT_UI_COMPRESSION_THRESHOLD 2048 // bytes
 #define DEFAULT_POLL_INTERVAL 2
 #define DEFAULT_ACCOUNTS_EN_VALUE NO
 #define DEFAULT_ACCOUNT_USER "gerbera"
@@ -117,8 +126,59 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #define DEFAULT_JS_DIR "js"
 #define DEFAULT_HIDDEN_FILES_VALUE NO
 #define DEFAULT_FOLLOW_SYMLINKS_VALUE YES
+#define DEFAULT_IMPORT_EXTRACTION_THREADS 0
+#define DEFAULT_IMPORT_DEDUPLICATE_METADATA NO
+#define DEFAULT_IMPORT_LAZY_METADATA NO
+#define DEFAULT_IMPORT_STATISTICS NO
+#define DEFAULT_IMPORT_CHANGE_DETECTION NO
+#define DEFAULT_IMPORT_STORAGE_AWARENESS_ENABLED NO
+#define DEFAULT_IMPORT_STORAGE_AWARENESS_IDLE_TIME 600 // seconds
+#define DEFAULT_IMPORT_STORAGE_AWARENESS_MAX_DELAY 86400 // seconds
+#define STORAGE_CHECK_INTERVAL 60 // seconds
+#define PLAY_STATE_FLUSH_INTERVAL 5 // seconds
+#define UPDATE_ID_STORE_INTERVAL 10 // seconds
+#define DEFAULT_INOTIFY_BACKEND "inotify"
+#define DEFAULT_AUTOSCAN_SETTLE_DELAY 2
 #define DEFAULT_RESOURCES_CASE_SENSITIVE YES
 #define DEFAULT_UPNP_STRING_LIMIT (-1)
+#define DEFAULT_READ_AHEAD_THREADS 0
+#define DEFAULT_READ_AHEAD_CHUNKS 4
+#define DEFAULT_READ_AHEAD_CACHE_SIZE 0 // MiB
+#define DEFAULT_READ_AHEAD_PREDICT_NEXT 0 // MiB
+#define RESOURCE_CACHE_MAX_AGE 86400 // seconds
+#define DEFAULT_IDLE_IO_THREADS 8
+#define READ_AHEAD_CHUNK_SIZE (256 * 1024)
+#define DEFAULT_THUMBNAIL_STORE_SIZE 0 // MiB
+#define DEFAULT_THUMBNAIL_STORE_FILE "thumbnails.store"
+#define DEFAULT_BROWSE_SNAPSHOT_ENABLED NO
+#define DEFAULT_BROWSE_SNAPSHOT_FILE "browse.snapshot"
+#define DEFAULT_BROWSE_SNAPSHOT_DELAY 30 // seconds
+#define DEFAULT_STREAM_STATISTICS NO
+#define DEFAULT_METRICS_ENABLED NO
+#define DEFAULT_MEMORY_ACCOUNTING NO
+#define DEFAULT_PROFILING_ENABLED NO
+#define DEFAULT_PROFILING_DURATION 30
+#define DEFAULT_TRACE_SAMPLE 0
+#define DEFAULT_UPNP_EVENT_INTERVAL 2000 // milliseconds
+#define DEFAULT_UPNP_EVENT_CSV_LIMIT 4096 // bytes
+#define DEFAULT_UPNP_EVENT_SUBSCRIPTION_TIMEOUT 300 // seconds
+#define DEFAULT_UPNP_MAX_JOBS 100 // MAX_JOBS_TOTAL of libupnp
+#define DEFAULT_UPNP_WORKERS 12 // MAX_THREADS of libupnp
+#define DEFAULT_UPNP_CONTROL_RESERVE 2
+#define DEFAULT_UPNP_DATA_RESERVE 2
+#define DEFAULT_CLUSTER_ROLE "standalone"
+#define DEFAULT_CLUSTER_POLL_INTERVAL 2 // seconds
+#define DEFAULT_CLUSTER_KEEP 3600 // seconds
+#define FILE_REQUEST_CACHE_TTL 5 // seconds
+#define FILE_REQUEST_CACHE_SIZE 256
+#define WEB_RESPONSE_STORE_TTL 30 // seconds
+#define WEB_RESPONSE_STORE_SIZE 64
+#define DIDL_CACHE_SIZE 4096
+#define BROWSE_CACHE_TTL 60 // seconds
+#define BROWSE_CACHE_SIZE 256
+#define DIDL_RENDER_THREADS 3
+#define DIDL_RENDER_CHUNK 128 // objects
+#define DIDL_PARALLEL_RENDER_MIN 512 // objects
 #define DEFAULT_SESSION_TIMEOUT 30
 #define SESSION_TIMEOUT_CHECK_INTERVAL (5 * 60)
 #define DEFAULT_PRES_URL_APPENDTO_ATTR "none"
@@ -127,6 +187,7 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #define DEFAULT_ITEMS_PER_PAGE_3 50
 #define DEFAULT_ITEMS_PER_PAGE_4 100
 #define DEFAULT_LAYOUT_TYPE "builtin"
+#define DEFAULT_LAYOUT_RUNTIMES 1
 #define DEFAULT_HIDE_PC_DIRECTORY NO
 #define DEFAULT_CLIENTS_EN_VALUE NO
 
@@ -144,9 +205,28 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 
 #ifdef ONLINE_SERVICES
 #define CFG_DEFAULT_UPDATE_AT_START 10 // seconds
+#define DEFAULT_ONLINE_CONTENT_PARALLEL_FETCHES 2
 #endif
 
 #define DEFAULT_TRANSCODING_ENABLED NO
+#define DEFAULT_TRANSCODING_CACHE_SIZE 0 // MiB
+#define DEFAULT_TRANSCODING_CACHE_DIR "transcode-cache"
+#define DEFAULT_TRANSCODING_MAX_CONCURRENT 0
+#define DEFAULT_TRANSCODING_QUEUE_TIMEOUT 10 // seconds
+#define DEFAULT_TRANSCODING_USE_PIPES NO
+#define DEFAULT_TRANSCODING_STALL_TIMEOUT 60 // seconds
+#define DEFAULT_TRANSCODING_STALL_RESTARTS 0
+#define DEFAULT_TRANSCODING_HLS_IDLE_TIMEOUT 60 // seconds
+#define DEFAULT_TRANSCODING_HLS_SEGMENTS_AHEAD 5
+#define DEFAULT_TRANSCODING_PRETRANSCODE NO
+#define DEFAULT_TRANSCODING_PRETRANSCODE_DIR "pretranscoded"
+#define DEFAULT_TRANSCODING_PRETRANSCODE_HOURS ""
+#define DEFAULT_TRANSCODING_PRETRANSCODE_NICE 19
+#define PRETRANSCODE_CHECK_INTERVAL 60 // seconds
+#define HLS_SESSION_CHECK_INTERVAL 1 // seconds
+#define HLS_SEGMENT_TIMEOUT 30 // seconds
+#define HLS_PLAYLIST_NAME "index.m3u8"
+#define TRANSCODE_PIPE_SIZE (1024 * 1024)
 #define DEFAULT_AUDIO_BUFFER_SIZE 1048576
 #define DEFAULT_AUDIO_CHUNK_SIZE 131072
 #define DEFAULT_AUDIO_FILL_SIZE 262144
@@ -160,6 +240,9 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #define URL_VALUE_TRANSCODE_NO_RES_ID "none"
 
 #define URL_VALUE_TRANSCODE "1"
+#define URL_PARAM_HLS_VARIANT "hls_variant"
+#define URL_PARAM_HLS_SESSION "hls_session"
+#define URL_PARAM_HLS_FILE "hls_file"
 #define MT_SQLITE_SYNC_FULL 2
 #define MT_SQLITE_SYNC_NORMAL 1
 #define MT_SQLITE_SYNC_OFF 0
@@ -167,13 +250,28 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #define DEFAULT_SQLITE_RESTORE "restore"
 #define DEFAULT_SQLITE_BACKUP_ENABLED NO
 #define DEFAULT_SQLITE_BACKUP_INTERVAL 600
+#define DEFAULT_SQLITE_READERS 2
+#define MT_SQLITE_TEMP_STORE_DEFAULT 0
+#define MT_SQLITE_TEMP_STORE_FILE 1
+#define MT_SQLITE_TEMP_STORE_MEMORY 2
+#define DEFAULT_SQLITE_JOURNAL_MODE "wal"
+#define DEFAULT_SQLITE_CACHE_SIZE -2000
+#define DEFAULT_SQLITE_MMAP_SIZE 0
+#define DEFAULT_SQLITE_TEMP_STORE "default"
 #define DEFAULT_SQLITE_ENABLED YES
+#define DEFAULT_STORAGE_FULLTEXT_SEARCH NO
+#define DEFAULT_STORAGE_WARM_UP_DEPTH 2
+#define DEFAULT_STORAGE_QUERY_PROFILE NO
+#define DEFAULT_STORAGE_SLOW_QUERY_TIME 0
+#define DEFAULT_STORAGE_MAINTENANCE_INTERVAL 3600
+#define DEFAULT_STORAGE_MAINTENANCE_FULL_VACUUM NO
 
 #ifdef HAVE_MYSQL
 #define DEFAULT_MYSQL_HOST "localhost"
 #define DEFAULT_MYSQL_DB "gerbera"
 #define DEFAULT_MYSQL_USER "gerbera"
 #define DEFAULT_MYSQL_ENABLED NO
+#define DEFAULT_MYSQL_CONNECTIONS 4
 
 #else //HAVE_MYSQL
 #define DEFAULT_MYSQL_ENABLED NO
@@ -185,6 +283,7 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #define INVALID_OBJECT_ID (-333)
 #define INVALID_OBJECT_ID_2 (-666)
 #define CHECK_SOCKET (-666)
+#define SPLICE_UNSUPPORTED (-667)
 
 // database
 #define LOC_DIR_PREFIX 'D'
@@ -202,9 +301,24 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #ifdef HAVE_CURL
 #define DEFAULT_CURL_BUFFER_SIZE 262144
 #define DEFAULT_CURL_INITIAL_FILL_SIZE 0
+#define DEFAULT_CURL_SPOOL_SIZE 0
+#define DEFAULT_CURL_SPOOL_FILL_SIZE 0
+#define CURL_SPOOL_FILL_TIMEOUT 10 // seconds
 #endif
 
 #define DEFAULT_LIBOPTS_ENTRY_SEPARATOR "; "
+#define DEFAULT_LIBOPTS_IMAGE_HEADER_SIZE 256 // KiB
+
+#ifdef HAVE_FFMPEG
+// 0 keeps the defaults of ffmpeg
+#define DEFAULT_FFMPEG_PROBESIZE 0
+#define DEFAULT_FFMPEG_ANALYZEDURATION 0
+#define DEFAULT_FFMPEG_HEADER_ONLY NO
+#endif
+
+#ifdef HAVE_MATROSKA
+#define DEFAULT_MKV_COVER_ART YES
+#endif
 
 #if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
 #define DEFAULT_FFMPEGTHUMBNAILER_ENABLED NO
@@ -215,6 +329,10 @@ static constexpr bool IS_FORBIDDEN_CDS_ID(int id) { return id <= CDS_ID_FS_ROOT;
 #define DEFAULT_FFMPEGTHUMBNAILER_IMAGE_QUALITY 8
 #define DEFAULT_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED YES
 #define DEFAULT_FFMPEGTHUMBNAILER_CACHE_DIR ""
+#define DEFAULT_FFMPEGTHUMBNAILER_CACHE_SIZE 256 // MiB
+#define DEFAULT_FFMPEGTHUMBNAILER_THREADS 2
+#define DEFAULT_FFMPEGTHUMBNAILER_QUEUE_SIZE 256
+#define DEFAULT_FFMPEGTHUMBNAILER_PREGENERATE NO
 #endif
 
 #if defined(HAVE_LASTFMLIB)
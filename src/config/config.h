@@ -62,9 +62,39 @@ enum config_option_t {
     CFG_SERVER_HIDE_PC_DIRECTORY,
     CFG_SERVER_BOOKMARK_FILE,
     CFG_SERVER_UPNP_TITLE_AND_DESC_STRING_LIMIT,
+    CFG_SERVER_READ_AHEAD_THREADS,
+    CFG_SERVER_READ_AHEAD_CHUNKS,
+    CFG_SERVER_READ_AHEAD_CACHE_SIZE,
+    CFG_SERVER_READ_AHEAD_PREDICT_NEXT,
+    CFG_SERVER_THUMBNAIL_STORE_SIZE,
+    CFG_SERVER_THUMBNAIL_STORE_FILE,
+    CFG_SERVER_BROWSE_SNAPSHOT_ENABLED,
+    CFG_SERVER_BROWSE_SNAPSHOT_FILE,
+    CFG_SERVER_BROWSE_SNAPSHOT_DELAY,
+    CFG_SERVER_STREAM_STATISTICS,
+    CFG_SERVER_METRICS_ENABLED,
+    CFG_SERVER_MEMORY_ACCOUNTING,
+    CFG_SERVER_PROFILING_ENABLED,
+    CFG_SERVER_PROFILING_DIRECTORY,
+    CFG_SERVER_PROFILING_DURATION,
+    CFG_SERVER_TRACE_SAMPLE,
+    CFG_SERVER_TRACE_FILE,
+    CFG_SERVER_UPNP_EVENT_INTERVAL,
+    CFG_SERVER_UPNP_EVENT_CSV_LIMIT,
+    CFG_SERVER_UPNP_EVENT_SUBSCRIPTION_TIMEOUT,
+    CFG_SERVER_UPNP_MAX_JOBS,
+    CFG_SERVER_UPNP_WORKERS,
+    CFG_SERVER_UPNP_CONTROL_RESERVE,
+    CFG_SERVER_UPNP_DATA_RESERVE,
+    CFG_SERVER_CLUSTER_ROLE,
+    CFG_SERVER_CLUSTER_POLL_INTERVAL,
+    CFG_SERVER_CLUSTER_KEEP,
     CFG_SERVER_UI_ENABLED,
     CFG_SERVER_UI_POLL_INTERVAL,
     CFG_SERVER_UI_POLL_WHEN_IDLE,
+    CFG_SERVER_UI_UPDATE_STREAMS,
+    CFG_SERVER_UI_COMPRESSION_LEVEL,
+    CFG_SERVER_UI_COMPRESSION_THRESHOLD,
     CFG_SERVER_UI_ACCOUNTS_ENABLED,
     CFG_SERVER_UI_ACCOUNT_LIST,
     CFG_SERVER_UI_SESSION_TIMEOUT,
@@ -75,9 +105,20 @@ enum config_option_t {
     CFG_SERVER_STORAGE_MYSQL,
     CFG_SERVER_STORAGE_SQLITE,
     CFG_SERVER_STORAGE_DRIVER,
+    CFG_SERVER_STORAGE_FULLTEXT_SEARCH,
+    CFG_SERVER_STORAGE_WARM_UP_DEPTH,
+    CFG_SERVER_STORAGE_QUERY_PROFILE,
+    CFG_SERVER_STORAGE_SLOW_QUERY_TIME,
+    CFG_SERVER_STORAGE_MAINTENANCE_INTERVAL,
+    CFG_SERVER_STORAGE_MAINTENANCE_FULL_VACUUM,
     CFG_SERVER_STORAGE_SQLITE_ENABLED,
     CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE,
     CFG_SERVER_STORAGE_SQLITE_SYNCHRONOUS,
+    CFG_SERVER_STORAGE_SQLITE_READERS,
+    CFG_SERVER_STORAGE_SQLITE_JOURNAL_MODE,
+    CFG_SERVER_STORAGE_SQLITE_CACHE_SIZE,
+    CFG_SERVER_STORAGE_SQLITE_MMAP_SIZE,
+    CFG_SERVER_STORAGE_SQLITE_TEMP_STORE,
     CFG_SERVER_STORAGE_SQLITE_RESTORE,
     CFG_SERVER_STORAGE_SQLITE_BACKUP_ENABLED,
     CFG_SERVER_STORAGE_SQLITE_BACKUP_INTERVAL,
@@ -91,6 +132,7 @@ enum config_option_t {
     CFG_SERVER_STORAGE_MYSQL_PASSWORD,
     CFG_SERVER_STORAGE_MYSQL_DATABASE,
     CFG_SERVER_STORAGE_MYSQL_INIT_SQL_FILE,
+    CFG_SERVER_STORAGE_MYSQL_CONNECTIONS,
 #endif
 #if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
     CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_ENABLED,
@@ -101,6 +143,10 @@ enum config_option_t {
     CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_IMAGE_QUALITY,
     CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED,
     CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR,
+    CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_SIZE,
+    CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THREADS,
+    CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_QUEUE_SIZE,
+    CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_PREGENERATE,
 #endif
     CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_ENABLED,
     CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_STRING_MODE_PREPEND,
@@ -119,6 +165,9 @@ enum config_option_t {
     CFG_IMPORT_PLAYLIST_CHARSET,
 #ifdef HAVE_JS
     CFG_IMPORT_SCRIPTING_CHARSET,
+    CFG_IMPORT_SCRIPTING_GC_INTERVAL,
+    CFG_IMPORT_SCRIPTING_GC_HEAP_GROWTH,
+    CFG_IMPORT_SCRIPTING_TIMEOUT,
     CFG_IMPORT_SCRIPTING_COMMON_SCRIPT,
     CFG_IMPORT_SCRIPTING_CUSTOM_SCRIPT,
     CFG_IMPORT_SCRIPTING_PLAYLIST_SCRIPT,
@@ -129,9 +178,12 @@ enum config_option_t {
     CFG_IMPORT_SCRIPTING_IMPORT_LAYOUT_VIDEO,
     CFG_IMPORT_SCRIPTING_IMPORT_LAYOUT_IMAGE,
     CFG_IMPORT_SCRIPTING_IMPORT_LAYOUT_TRAILER,
+    CFG_IMPORT_SCRIPTING_IMPORT_RUNTIMES,
+    CFG_IMPORT_SCRIPTING_IMPORT_FUNCTION,
 #endif // JS
     CFG_IMPORT_SCRIPTING_VIRTUAL_LAYOUT_TYPE,
     CFG_IMPORT_SCRIPTING_IMPORT_GENRE_MAP,
+    CFG_IMPORT_SCRIPTING_IMPORT_TEMPLATE_CHAINS,
 #ifdef HAVE_MAGIC
     CFG_IMPORT_MAGIC_FILE,
 #endif
@@ -139,6 +191,8 @@ enum config_option_t {
     CFG_IMPORT_AUTOSCAN_USE_INOTIFY,
 #ifdef HAVE_INOTIFY
     CFG_IMPORT_AUTOSCAN_INOTIFY_LIST,
+    CFG_IMPORT_AUTOSCAN_INOTIFY_BACKEND,
+    CFG_IMPORT_AUTOSCAN_SETTLE_DELAY,
 #endif
     CFG_IMPORT_MAPPINGS_IGNORE_UNKNOWN_EXTENSIONS,
     CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_CASE_SENSITIVE,
@@ -156,13 +210,32 @@ enum config_option_t {
 #if defined(HAVE_TAGLIB)
     CFG_IMPORT_LIBOPTS_ID3_AUXDATA_TAGS_LIST,
     CFG_IMPORT_LIBOPTS_ID3_CHARSET,
+    CFG_IMPORT_LIBOPTS_ID3_ARTWORK_DIR,
 #endif
     CFG_TRANSCODING_TRANSCODING_ENABLED,
     CFG_TRANSCODING_PROFILE_LIST,
+    CFG_TRANSCODING_CACHE_SIZE,
+    CFG_TRANSCODING_CACHE_DIR,
+    CFG_TRANSCODING_MAX_CONCURRENT,
+    CFG_TRANSCODING_QUEUE_TIMEOUT,
+    CFG_TRANSCODING_USE_PIPES,
+    CFG_TRANSCODING_STALL_TIMEOUT,
+    CFG_TRANSCODING_STALL_RESTARTS,
+    CFG_TRANSCODING_HLS_IDLE_TIMEOUT,
+    CFG_TRANSCODING_HLS_SEGMENTS_AHEAD,
+    CFG_TRANSCODING_PRETRANSCODE,
+    CFG_TRANSCODING_PRETRANSCODE_DIR,
+    CFG_TRANSCODING_PRETRANSCODE_HOURS,
+    CFG_TRANSCODING_PRETRANSCODE_NICE,
 #ifdef HAVE_CURL
     CFG_EXTERNAL_TRANSCODING_CURL_BUFFER_SIZE,
     CFG_EXTERNAL_TRANSCODING_CURL_FILL_SIZE,
+    CFG_EXTERNAL_TRANSCODING_CURL_SPOOL_SIZE,
+    CFG_EXTERNAL_TRANSCODING_CURL_SPOOL_FILL_SIZE,
 #endif //HAVE_CURL
+#ifdef ONLINE_SERVICES
+    CFG_ONLINE_CONTENT_PARALLEL_FETCHES,
+#endif
 #ifdef SOPCAST
     CFG_ONLINE_CONTENT_SOPCAST_ENABLED,
     CFG_ONLINE_CONTENT_SOPCAST_REFRESH,
@@ -179,6 +252,12 @@ enum config_option_t {
 #if defined(HAVE_FFMPEG)
     CFG_IMPORT_LIBOPTS_FFMPEG_AUXDATA_TAGS_LIST,
     CFG_IMPORT_LIBOPTS_FFMPEG_CHARSET,
+    CFG_IMPORT_LIBOPTS_FFMPEG_PROBESIZE,
+    CFG_IMPORT_LIBOPTS_FFMPEG_ANALYZEDURATION,
+    CFG_IMPORT_LIBOPTS_FFMPEG_HEADER_ONLY,
+#endif
+#ifdef HAVE_MATROSKA
+    CFG_IMPORT_LIBOPTS_MKV_COVER_ART,
 #endif
     CFG_CLIENTS_LIST,
     CFG_CLIENTS_LIST_ENABLED,
@@ -186,6 +265,8 @@ enum config_option_t {
     CFG_IMPORT_LAYOUT_MAPPING,
     CFG_IMPORT_LIBOPTS_ENTRY_SEP,
     CFG_IMPORT_LIBOPTS_ENTRY_LEGACY_SEP,
+    CFG_IMPORT_LIBOPTS_IMAGE_HEADER_SIZE,
+    CFG_IMPORT_LIBOPTS_SKIP_EXTRACTORS,
     CFG_IMPORT_DIRECTORIES_LIST,
     CFG_IMPORT_RESOURCES_CASE_SENSITIVE,
     CFG_IMPORT_RESOURCES_FANART_FILE_LIST,
@@ -203,7 +284,16 @@ enum config_option_t {
     CFG_UPNP_ARTIST_PROPERTIES,
     CFG_UPNP_TITLE_PROPERTIES,
     CFG_THREAD_SCOPE_SYSTEM,
+    CFG_THREAD_IDLE_IO_THREADS,
     CFG_IMPORT_READABLE_NAMES,
+    CFG_IMPORT_EXTRACTION_THREADS,
+    CFG_IMPORT_DEDUPLICATE_METADATA,
+    CFG_IMPORT_LAZY_METADATA,
+    CFG_IMPORT_STATISTICS,
+    CFG_IMPORT_CHANGE_DETECTION,
+    CFG_IMPORT_STORAGE_AWARENESS_ENABLED,
+    CFG_IMPORT_STORAGE_AWARENESS_IDLE_TIME,
+    CFG_IMPORT_STORAGE_AWARENESS_MAX_DELAY,
 
     CFG_MAX,
 
@@ -220,6 +310,9 @@ enum config_option_t {
     ATTR_IMPORT_MAPPINGS_M2CTYPE_LIST_MIMETYPE,
     ATTR_IMPORT_MAPPINGS_M2CTYPE_LIST_AS,
     ATTR_IMPORT_LAYOUT_GENRE,
+    ATTR_IMPORT_LAYOUT_CHAIN,
+    ATTR_IMPORT_LAYOUT_CHAIN_PATH,
+    ATTR_IMPORT_LAYOUT_CHAIN_MEDIA,
     ATTR_IMPORT_LAYOUT_SCRIPT_OPTION,
     ATTR_IMPORT_LAYOUT_SCRIPT_OPTION_NAME,
     ATTR_IMPORT_LAYOUT_SCRIPT_OPTION_VALUE,
@@ -230,6 +323,8 @@ enum config_option_t {
     ATTR_IMPORT_RESOURCES_NAME,
     ATTR_IMPORT_LIBOPTS_AUXDATA_DATA,
     ATTR_IMPORT_LIBOPTS_AUXDATA_TAG,
+    ATTR_IMPORT_LIBOPTS_SKIP,
+    ATTR_IMPORT_LIBOPTS_SKIP_EXTRACTORS,
     ATTR_TRANSCODING_MIMETYPE_PROF_MAP,
     ATTR_TRANSCODING_MIMETYPE_PROF_MAP_TRANSCODE,
     ATTR_TRANSCODING_MIMETYPE_PROF_MAP_MIMETYPE,
@@ -250,6 +345,10 @@ enum config_option_t {
     ATTR_TRANSCODING_PROFILES_PROFLE_THUMB,
     ATTR_TRANSCODING_PROFILES_PROFLE_FIRST,
     ATTR_TRANSCODING_PROFILES_PROFLE_ACCOGG,
+    ATTR_TRANSCODING_PROFILES_PROFLE_MAXCONCURRENT,
+    ATTR_TRANSCODING_PROFILES_PROFLE_FALLBACK,
+    ATTR_TRANSCODING_PROFILES_PROFLE_HARDWARE,
+    ATTR_TRANSCODING_PROFILES_PROFLE_PRETRANSCODE,
     ATTR_TRANSCODING_PROFILES_PROFLE_AGENT,
     ATTR_TRANSCODING_PROFILES_PROFLE_AGENT_COMMAND,
     ATTR_TRANSCODING_PROFILES_PROFLE_AGENT_ARGS,
@@ -257,6 +356,9 @@ enum config_option_t {
     ATTR_TRANSCODING_PROFILES_PROFLE_BUFFER_SIZE,
     ATTR_TRANSCODING_PROFILES_PROFLE_BUFFER_CHUNK,
     ATTR_TRANSCODING_PROFILES_PROFLE_BUFFER_FILL,
+    ATTR_TRANSCODING_PROFILES_PROFLE_HLS,
+    ATTR_TRANSCODING_PROFILES_PROFLE_HLS_BANDWIDTH,
+    ATTR_TRANSCODING_PROFILES_PROFLE_HLS_VARIANTS,
     ATTR_AUTOSCAN_DIRECTORY,
     ATTR_AUTOSCAN_DIRECTORY_LOCATION,
     ATTR_AUTOSCAN_DIRECTORY_MODE,
@@ -259,6 +259,88 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigIntSetup>(CFG_SERVER_UPNP_TITLE_AND_DESC_STRING_LIMIT,
         "/server/upnp-string-limit", "config-server.html#upnp-string-limit",
         DEFAULT_UPNP_STRING_LIMIT, ConfigIntSetup::CheckUpnpStringLimitValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_READ_AHEAD_THREADS,
+        "/server/read-ahead/attribute::threads", "config-server.html#read-ahead",
+        DEFAULT_READ_AHEAD_THREADS, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_READ_AHEAD_CHUNKS,
+        "/server/read-ahead/attribute::chunks", "config-server.html#read-ahead",
+        DEFAULT_READ_AHEAD_CHUNKS, 1, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_READ_AHEAD_CACHE_SIZE,
+        "/server/read-ahead/attribute::cache-size", "config-server.html#read-ahead",
+        DEFAULT_READ_AHEAD_CACHE_SIZE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_READ_AHEAD_PREDICT_NEXT,
+        "/server/read-ahead/attribute::predict-next", "config-server.html#read-ahead",
+        DEFAULT_READ_AHEAD_PREDICT_NEXT, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_THUMBNAIL_STORE_SIZE,
+        "/server/thumbnail-store/attribute::size", "config-server.html#thumbnail-store",
+        DEFAULT_THUMBNAIL_STORE_SIZE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigPathSetup>(CFG_SERVER_THUMBNAIL_STORE_FILE,
+        "/server/thumbnail-store/attribute::file", "config-server.html#thumbnail-store",
+        DEFAULT_THUMBNAIL_STORE_FILE, true, false),
+    std::make_shared<ConfigBoolSetup>(CFG_SERVER_BROWSE_SNAPSHOT_ENABLED,
+        "/server/browse-snapshot/attribute::enabled", "config-server.html#browse-snapshot",
+        DEFAULT_BROWSE_SNAPSHOT_ENABLED),
+    std::make_shared<ConfigPathSetup>(CFG_SERVER_BROWSE_SNAPSHOT_FILE,
+        "/server/browse-snapshot/attribute::file", "config-server.html#browse-snapshot",
+        DEFAULT_BROWSE_SNAPSHOT_FILE, true, false),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_BROWSE_SNAPSHOT_DELAY,
+        "/server/browse-snapshot/attribute::rebuild-delay", "config-server.html#browse-snapshot",
+        DEFAULT_BROWSE_SNAPSHOT_DELAY, 1, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigBoolSetup>(CFG_SERVER_STREAM_STATISTICS,
+        "/server/stream-statistics/attribute::enabled", "config-server.html#stream-statistics",
+        DEFAULT_STREAM_STATISTICS),
+    std::make_shared<ConfigBoolSetup>(CFG_SERVER_METRICS_ENABLED,
+        "/server/metrics/attribute::enabled", "config-server.html#metrics",
+        DEFAULT_METRICS_ENABLED),
+    std::make_shared<ConfigBoolSetup>(CFG_SERVER_MEMORY_ACCOUNTING,
+        "/server/memory-accounting/attribute::enabled", "config-server.html#memory-accounting",
+        DEFAULT_MEMORY_ACCOUNTING),
+    std::make_shared<ConfigBoolSetup>(CFG_SERVER_PROFILING_ENABLED,
+        "/server/profiling/attribute::enabled", "config-server.html#profiling",
+        DEFAULT_PROFILING_ENABLED),
+    std::make_shared<ConfigPathSetup>(CFG_SERVER_PROFILING_DIRECTORY,
+        "/server/profiling/attribute::directory", "config-server.html#profiling",
+        "", false, false),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_PROFILING_DURATION,
+        "/server/profiling/attribute::duration", "config-server.html#profiling",
+        DEFAULT_PROFILING_DURATION, 1, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_TRACE_SAMPLE,
+        "/server/trace/attribute::sample", "config-server.html#trace",
+        DEFAULT_TRACE_SAMPLE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigPathSetup>(CFG_SERVER_TRACE_FILE,
+        "/server/trace/attribute::file", "config-server.html#trace",
+        "", true, false),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_UPNP_EVENT_INTERVAL,
+        "/server/upnp-events/attribute::interval", "config-server.html#upnp-events",
+        DEFAULT_UPNP_EVENT_INTERVAL, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_UPNP_EVENT_CSV_LIMIT,
+        "/server/upnp-events/attribute::csv-limit", "config-server.html#upnp-events",
+        DEFAULT_UPNP_EVENT_CSV_LIMIT, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_UPNP_EVENT_SUBSCRIPTION_TIMEOUT,
+        "/server/upnp-events/attribute::subscription-timeout", "config-server.html#upnp-events",
+        DEFAULT_UPNP_EVENT_SUBSCRIPTION_TIMEOUT, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_UPNP_MAX_JOBS,
+        "/server/upnp-threads/attribute::max-jobs", "config-server.html#upnp-threads",
+        DEFAULT_UPNP_MAX_JOBS, 1, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_UPNP_WORKERS,
+        "/server/upnp-threads/attribute::workers", "config-server.html#upnp-threads",
+        DEFAULT_UPNP_WORKERS, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_UPNP_CONTROL_RESERVE,
+        "/server/upnp-threads/attribute::control-reserve", "config-server.html#upnp-threads",
+        DEFAULT_UPNP_CONTROL_RESERVE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_UPNP_DATA_RESERVE,
+        "/server/upnp-threads/attribute::data-reserve", "config-server.html#upnp-threads",
+        DEFAULT_UPNP_DATA_RESERVE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigEnumSetup<std::string>>(CFG_SERVER_CLUSTER_ROLE,
+        "/server/cluster/attribute::role", "config-server.html#cluster",
+        DEFAULT_CLUSTER_ROLE,
+        std::map<std::string, std::string>({ { "standalone", "standalone" }, { "importer", "importer" }, { "frontend", "frontend" } })),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_CLUSTER_POLL_INTERVAL,
+        "/server/cluster/attribute::poll-interval", "config-server.html#cluster",
+        DEFAULT_CLUSTER_POLL_INTERVAL, 1, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_CLUSTER_KEEP,
+        "/server/cluster/attribute::keep", "config-server.html#cluster",
+        DEFAULT_CLUSTER_KEEP, 60, ConfigIntSetup::CheckMinValue),
 
     std::make_shared<ConfigStringSetup>(CFG_SERVER_STORAGE,
         "/server/storage", "config-server.html#storage",
@@ -290,6 +372,9 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigPathSetup>(CFG_SERVER_STORAGE_MYSQL_INIT_SQL_FILE,
         "/server/storage/mysql/init-sql-file", "config-server.html#storage",
         "", true), // This should really be "dataDir / mysql.sql"
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_STORAGE_MYSQL_CONNECTIONS,
+        "/server/storage/mysql/connections", "config-server.html#storage",
+        DEFAULT_MYSQL_CONNECTIONS, 1, ConfigIntSetup::CheckMinValue),
 #else
     std::make_shared<ConfigBoolSetup>(CFG_SERVER_STORAGE_MYSQL_ENABLED,
         "/server/storage/mysql/attribute::enabled", "config-server.html#storage",
@@ -299,6 +384,24 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
         "/server/storage/sqlite3", "config-server.html#storage"),
     std::make_shared<ConfigStringSetup>(CFG_SERVER_STORAGE_DRIVER,
         "/server/storage/driver", "config-server.html#storage"),
+    std::make_shared<ConfigBoolSetup>(CFG_SERVER_STORAGE_FULLTEXT_SEARCH,
+        "/server/storage/attribute::fulltext-search", "config-server.html#storage",
+        DEFAULT_STORAGE_FULLTEXT_SEARCH),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_STORAGE_WARM_UP_DEPTH,
+        "/server/storage/attribute::warm-up-depth", "config-server.html#storage",
+        DEFAULT_STORAGE_WARM_UP_DEPTH, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigBoolSetup>(CFG_SERVER_STORAGE_QUERY_PROFILE,
+        "/server/storage/attribute::query-profile", "config-server.html#storage",
+        DEFAULT_STORAGE_QUERY_PROFILE),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_STORAGE_SLOW_QUERY_TIME,
+        "/server/storage/attribute::slow-query-time", "config-server.html#storage",
+        DEFAULT_STORAGE_SLOW_QUERY_TIME, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_STORAGE_MAINTENANCE_INTERVAL,
+        "/server/storage/attribute::maintenance-interval", "config-server.html#storage",
+        DEFAULT_STORAGE_MAINTENANCE_INTERVAL, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigBoolSetup>(CFG_SERVER_STORAGE_MAINTENANCE_FULL_VACUUM,
+        "/server/storage/attribute::maintenance-full-vacuum", "config-server.html#storage",
+        DEFAULT_STORAGE_MAINTENANCE_FULL_VACUUM),
     std::make_shared<ConfigBoolSetup>(CFG_SERVER_STORAGE_SQLITE_ENABLED,
         "/server/storage/sqlite3/attribute::enabled", "config-server.html#storage",
         DEFAULT_SQLITE_ENABLED),
@@ -308,6 +411,21 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigIntSetup>(CFG_SERVER_STORAGE_SQLITE_SYNCHRONOUS,
         "/server/storage/sqlite3/synchronous", "config-server.html#storage",
         DEFAULT_SQLITE_SYNC, ConfigIntSetup::CheckSqlLiteSyncValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_STORAGE_SQLITE_READERS,
+        "/server/storage/sqlite3/readers", "config-server.html#storage",
+        DEFAULT_SQLITE_READERS, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigStringSetup>(CFG_SERVER_STORAGE_SQLITE_JOURNAL_MODE,
+        "/server/storage/sqlite3/journal-mode", "config-server.html#storage",
+        DEFAULT_SQLITE_JOURNAL_MODE, ConfigStringSetup::CheckSqlLiteJournalValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_STORAGE_SQLITE_CACHE_SIZE,
+        "/server/storage/sqlite3/cache-size", "config-server.html#storage",
+        DEFAULT_SQLITE_CACHE_SIZE),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_STORAGE_SQLITE_MMAP_SIZE,
+        "/server/storage/sqlite3/mmap-size", "config-server.html#storage",
+        DEFAULT_SQLITE_MMAP_SIZE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_STORAGE_SQLITE_TEMP_STORE,
+        "/server/storage/sqlite3/temp-store", "config-server.html#storage",
+        DEFAULT_SQLITE_TEMP_STORE, ConfigIntSetup::CheckSqlLiteTempStoreValue),
     std::make_shared<ConfigBoolSetup>(CFG_SERVER_STORAGE_SQLITE_RESTORE,
         "/server/storage/sqlite3/on-error", "config-server.html#storage",
         DEFAULT_SQLITE_RESTORE, ConfigBoolSetup::CheckSqlLiteRestoreValue),
@@ -337,6 +455,15 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigBoolSetup>(CFG_SERVER_UI_POLL_WHEN_IDLE,
         "/server/ui/attribute::poll-when-idle", "config-server.html#ui",
         DEFAULT_POLL_WHEN_IDLE_VALUE),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_UI_UPDATE_STREAMS,
+        "/server/ui/attribute::update-streams", "config-server.html#ui",
+        DEFAULT_UI_UPDATE_STREAMS, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_UI_COMPRESSION_LEVEL,
+        "/server/ui/attribute::compression-level", "config-server.html#ui",
+        DEFAULT_UI_COMPRESSION_LEVEL, ConfigIntSetup::CheckCompressionLevelValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_UI_COMPRESSION_THRESHOLD,
+        "/server/ui/attribute::compression-threshold", "config-server.html#ui",
+        DEFAULT_UI_COMPRESSION_THRESHOLD, 0, ConfigIntSetup::CheckMinValue),
     std::make_shared<ConfigBoolSetup>(CFG_SERVER_UI_ACCOUNTS_ENABLED,
         "/server/ui/accounts/attribute::enabled", "config-server.html#ui",
         DEFAULT_ACCOUNTS_EN_VALUE),
@@ -359,6 +486,9 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigBoolSetup>(CFG_THREAD_SCOPE_SYSTEM,
         "/server/attribute::system-threads", "config-server.html#system-threads",
         YES),
+    std::make_shared<ConfigIntSetup>(CFG_THREAD_IDLE_IO_THREADS,
+        "/server/attribute::idle-io-threads", "config-server.html#system-threads",
+        DEFAULT_IDLE_IO_THREADS, 0, ConfigIntSetup::CheckMinValue),
 
     std::make_shared<ConfigClientSetup>(CFG_CLIENTS_LIST,
         "/clients", "config-clients.html#clients"),
@@ -387,6 +517,30 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigBoolSetup>(CFG_IMPORT_READABLE_NAMES,
         "/import/attribute::readable-names", "config-import.html#import",
         YES),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_EXTRACTION_THREADS,
+        "/import/attribute::extraction-threads", "config-import.html#import",
+        DEFAULT_IMPORT_EXTRACTION_THREADS, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigBoolSetup>(CFG_IMPORT_DEDUPLICATE_METADATA,
+        "/import/attribute::deduplicate-metadata", "config-import.html#import",
+        DEFAULT_IMPORT_DEDUPLICATE_METADATA),
+    std::make_shared<ConfigBoolSetup>(CFG_IMPORT_LAZY_METADATA,
+        "/import/attribute::lazy-metadata", "config-import.html#import",
+        DEFAULT_IMPORT_LAZY_METADATA),
+    std::make_shared<ConfigBoolSetup>(CFG_IMPORT_STATISTICS,
+        "/import/attribute::statistics", "config-import.html#import",
+        DEFAULT_IMPORT_STATISTICS),
+    std::make_shared<ConfigBoolSetup>(CFG_IMPORT_CHANGE_DETECTION,
+        "/import/attribute::change-detection", "config-import.html#import",
+        DEFAULT_IMPORT_CHANGE_DETECTION),
+    std::make_shared<ConfigBoolSetup>(CFG_IMPORT_STORAGE_AWARENESS_ENABLED,
+        "/import/storage-awareness/attribute::enabled", "config-import.html#storage-awareness",
+        DEFAULT_IMPORT_STORAGE_AWARENESS_ENABLED),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_STORAGE_AWARENESS_IDLE_TIME,
+        "/import/storage-awareness/attribute::idle-time", "config-import.html#storage-awareness",
+        DEFAULT_IMPORT_STORAGE_AWARENESS_IDLE_TIME, 1, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_STORAGE_AWARENESS_MAX_DELAY,
+        "/import/storage-awareness/attribute::max-delay", "config-import.html#storage-awareness",
+        DEFAULT_IMPORT_STORAGE_AWARENESS_MAX_DELAY, 0, ConfigIntSetup::CheckMinValue),
     std::make_shared<ConfigDictionarySetup>(CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_LIST,
         "/import/mappings/extension-mimetype", "config-import.html#extension-mimetype",
         ATTR_IMPORT_MAPPINGS_MIMETYPE_MAP, ATTR_IMPORT_MAPPINGS_MIMETYPE_FROM, ATTR_IMPORT_MAPPINGS_MIMETYPE_TO,
@@ -415,6 +569,15 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigStringSetup>(CFG_IMPORT_SCRIPTING_CHARSET,
         "/import/scripting/attribute::script-charset", "config-import.html#scripting",
         DEFAULT_JS_CHARSET),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_SCRIPTING_GC_INTERVAL,
+        "/import/scripting/attribute::gc-interval", "config-import.html#scripting",
+        DEFAULT_JS_GC_INTERVAL, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_SCRIPTING_GC_HEAP_GROWTH,
+        "/import/scripting/attribute::gc-heap-growth", "config-import.html#scripting",
+        DEFAULT_JS_GC_HEAP_GROWTH, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_SCRIPTING_TIMEOUT,
+        "/import/scripting/attribute::timeout", "config-import.html#scripting",
+        DEFAULT_JS_TIMEOUT, 0, ConfigIntSetup::CheckMinValue),
     std::make_shared<ConfigPathSetup>(CFG_IMPORT_SCRIPTING_COMMON_SCRIPT,
         "/import/scripting/common-script", "config-import.html#common-script",
         "", true, false),
@@ -442,6 +605,12 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigStringSetup>(CFG_IMPORT_SCRIPTING_IMPORT_LAYOUT_TRAILER,
         "/import/scripting/virtual-layout/attribute::trailer-layout", "config-import.html#scripting",
         ""),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_SCRIPTING_IMPORT_RUNTIMES,
+        "/import/scripting/virtual-layout/attribute::runtimes", "config-import.html#scripting",
+        DEFAULT_LAYOUT_RUNTIMES, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigStringSetup>(CFG_IMPORT_SCRIPTING_IMPORT_FUNCTION,
+        "/import/scripting/virtual-layout/attribute::import-function", "config-import.html#scripting",
+        ""),
     std::make_shared<ConfigDictionarySetup>(CFG_IMPORT_SCRIPTING_IMPORT_SCRIPT_OPTIONS,
         "/import/scripting/virtual-layout/script-options", "config-import.html#layout",
         ATTR_IMPORT_LAYOUT_SCRIPT_OPTION, ATTR_IMPORT_LAYOUT_SCRIPT_OPTION_NAME, ATTR_IMPORT_LAYOUT_SCRIPT_OPTION_VALUE),
@@ -449,6 +618,9 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigDictionarySetup>(CFG_IMPORT_SCRIPTING_IMPORT_GENRE_MAP,
         "/import/scripting/virtual-layout/genre-map", "config-import.html#layout",
         ATTR_IMPORT_LAYOUT_GENRE, ATTR_IMPORT_LAYOUT_MAPPING_FROM, ATTR_IMPORT_LAYOUT_MAPPING_TO),
+    std::make_shared<ConfigDictionarySetup>(CFG_IMPORT_SCRIPTING_IMPORT_TEMPLATE_CHAINS,
+        "/import/scripting/virtual-layout/template-chains", "config-import.html#layout",
+        ATTR_IMPORT_LAYOUT_CHAIN, ATTR_IMPORT_LAYOUT_CHAIN_PATH, ATTR_IMPORT_LAYOUT_CHAIN_MEDIA),
     std::make_shared<ConfigStringSetup>(CFG_IMPORT_FILESYSTEM_CHARSET,
         "/import/filesystem-charset", "config-import.html#filesystem-charset",
         DEFAULT_FILESYSTEM_CHARSET),
@@ -461,13 +633,52 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigEnumSetup<std::string>>(CFG_IMPORT_SCRIPTING_VIRTUAL_LAYOUT_TYPE,
         "/import/scripting/virtual-layout/attribute::type", "config-import.html#scripting",
         DEFAULT_LAYOUT_TYPE,
-        std::map<std::string, std::string>({ { "js", "js" }, { "builtin", "builtin" }, { "disabled", "disabled" } })),
+        std::map<std::string, std::string>({ { "js", "js" }, { "builtin", "builtin" }, { "template", "template" }, { "disabled", "disabled" } })),
 
     std::make_shared<ConfigBoolSetup>(CFG_TRANSCODING_TRANSCODING_ENABLED,
         "/transcoding/attribute::enabled", "config-transcode.html#transcoding",
         DEFAULT_TRANSCODING_ENABLED),
     std::make_shared<ConfigTranscodingSetup>(CFG_TRANSCODING_PROFILE_LIST,
         "/transcoding", "config-transcode.html#transcoding"),
+    std::make_shared<ConfigIntSetup>(CFG_TRANSCODING_CACHE_SIZE,
+        "/transcoding/attribute::cache-size", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_CACHE_SIZE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigPathSetup>(CFG_TRANSCODING_CACHE_DIR,
+        "/transcoding/attribute::cache-dir", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_CACHE_DIR, false, false),
+    std::make_shared<ConfigIntSetup>(CFG_TRANSCODING_MAX_CONCURRENT,
+        "/transcoding/attribute::max-concurrent", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_MAX_CONCURRENT, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_TRANSCODING_QUEUE_TIMEOUT,
+        "/transcoding/attribute::queue-timeout", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_QUEUE_TIMEOUT, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigBoolSetup>(CFG_TRANSCODING_USE_PIPES,
+        "/transcoding/attribute::use-pipes", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_USE_PIPES),
+    std::make_shared<ConfigIntSetup>(CFG_TRANSCODING_STALL_TIMEOUT,
+        "/transcoding/attribute::stall-timeout", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_STALL_TIMEOUT, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_TRANSCODING_STALL_RESTARTS,
+        "/transcoding/attribute::stall-restarts", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_STALL_RESTARTS, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_TRANSCODING_HLS_IDLE_TIMEOUT,
+        "/transcoding/attribute::hls-idle-timeout", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_HLS_IDLE_TIMEOUT, 1, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_TRANSCODING_HLS_SEGMENTS_AHEAD,
+        "/transcoding/attribute::hls-segments-ahead", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_HLS_SEGMENTS_AHEAD, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigBoolSetup>(CFG_TRANSCODING_PRETRANSCODE,
+        "/transcoding/attribute::pretranscode", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_PRETRANSCODE),
+    std::make_shared<ConfigPathSetup>(CFG_TRANSCODING_PRETRANSCODE_DIR,
+        "/transcoding/attribute::pretranscode-dir", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_PRETRANSCODE_DIR, false, false),
+    std::make_shared<ConfigStringSetup>(CFG_TRANSCODING_PRETRANSCODE_HOURS,
+        "/transcoding/attribute::pretranscode-hours", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_PRETRANSCODE_HOURS, ConfigStringSetup::CheckHourRangeValue),
+    std::make_shared<ConfigIntSetup>(CFG_TRANSCODING_PRETRANSCODE_NICE,
+        "/transcoding/attribute::pretranscode-nice", "config-transcode.html#transcoding",
+        DEFAULT_TRANSCODING_PRETRANSCODE_NICE, 0, ConfigIntSetup::CheckMinValue),
 
     std::make_shared<ConfigStringSetup>(CFG_IMPORT_LIBOPTS_ENTRY_SEP,
         "/import/library-options/attribute::multi-value-separator", "config-import.html#library-options",
@@ -475,6 +686,12 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigStringSetup>(CFG_IMPORT_LIBOPTS_ENTRY_LEGACY_SEP,
         "/import/library-options/attribute::legacy-value-separator", "config-import.html#library-options",
         ""),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_LIBOPTS_IMAGE_HEADER_SIZE,
+        "/import/library-options/attribute::image-header-size", "config-import.html#library-options",
+        DEFAULT_LIBOPTS_IMAGE_HEADER_SIZE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigDictionarySetup>(CFG_IMPORT_LIBOPTS_SKIP_EXTRACTORS,
+        "/import/library-options/skip-extractors", "config-import.html#skip-extractors",
+        ATTR_IMPORT_LIBOPTS_SKIP, ATTR_IMPORT_MAPPINGS_M2CTYPE_LIST_MIMETYPE, ATTR_IMPORT_LIBOPTS_SKIP_EXTRACTORS),
     std::make_shared<ConfigBoolSetup>(CFG_IMPORT_RESOURCES_CASE_SENSITIVE,
         "/import/resources/attribute::case-sensitive", "config-import.html#resources",
         DEFAULT_RESOURCES_CASE_SENSITIVE),
@@ -531,6 +748,18 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigStringSetup>(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR, // ConfigPathSetup
         "/server/extended-runtime-options/ffmpegthumbnailer/cache-dir", "config-extended.html#ffmpegthumbnailer",
         DEFAULT_FFMPEGTHUMBNAILER_CACHE_DIR),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_SIZE,
+        "/server/extended-runtime-options/ffmpegthumbnailer/cache-dir/attribute::size", "config-extended.html#ffmpegthumbnailer",
+        DEFAULT_FFMPEGTHUMBNAILER_CACHE_SIZE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THREADS,
+        "/server/extended-runtime-options/ffmpegthumbnailer/attribute::threads", "config-extended.html#ffmpegthumbnailer",
+        DEFAULT_FFMPEGTHUMBNAILER_THREADS, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_QUEUE_SIZE,
+        "/server/extended-runtime-options/ffmpegthumbnailer/attribute::queue-size", "config-extended.html#ffmpegthumbnailer",
+        DEFAULT_FFMPEGTHUMBNAILER_QUEUE_SIZE, 1, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigBoolSetup>(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_PREGENERATE,
+        "/server/extended-runtime-options/ffmpegthumbnailer/attribute::pregenerate", "config-extended.html#ffmpegthumbnailer",
+        DEFAULT_FFMPEGTHUMBNAILER_PREGENERATE),
 #endif
 
     std::make_shared<ConfigBoolSetup>(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_ENABLED,
@@ -559,6 +788,11 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
         "/server/extended-runtime-options/lastfm/password", "config-extended.html#lastfm",
         false, DEFAULT_LASTFM_PASSWORD, true),
 #endif
+#ifdef ONLINE_SERVICES
+    std::make_shared<ConfigIntSetup>(CFG_ONLINE_CONTENT_PARALLEL_FETCHES,
+        "/import/online-content/attribute::parallel-fetches", "config-online.html#online-content",
+        DEFAULT_ONLINE_CONTENT_PARALLEL_FETCHES, 1, ConfigIntSetup::CheckMinValue),
+#endif
 #ifdef SOPCAST
     std::make_shared<ConfigBoolSetup>(CFG_ONLINE_CONTENT_SOPCAST_ENABLED,
         "/import/online-content/SopCast/attribute::enabled", "config-online.html#sopcast",
@@ -599,6 +833,13 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigAutoscanSetup>(CFG_IMPORT_AUTOSCAN_INOTIFY_LIST,
         "/import/autoscan", "config-import.html#autoscan",
         ScanMode::INotify),
+    std::make_shared<ConfigEnumSetup<std::string>>(CFG_IMPORT_AUTOSCAN_INOTIFY_BACKEND,
+        "/import/autoscan/attribute::inotify-backend", "config-import.html#autoscan",
+        DEFAULT_INOTIFY_BACKEND,
+        std::map<std::string, std::string>({ { "inotify", "inotify" }, { "fanotify", "fanotify" } })),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_AUTOSCAN_SETTLE_DELAY,
+        "/import/autoscan/attribute::settle-delay", "config-import.html#autoscan",
+        DEFAULT_AUTOSCAN_SETTLE_DELAY, 0, ConfigIntSetup::CheckMinValue),
 #endif
     std::make_shared<ConfigSetup>(ATTR_AUTOSCAN_DIRECTORY,
         "directory", "config-import.html#autoscan",
@@ -634,6 +875,12 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigIntSetup>(CFG_EXTERNAL_TRANSCODING_CURL_FILL_SIZE,
         "/transcoding/attribute::fetch-buffer-fill-size", "config-transcode.html#transcoding",
         DEFAULT_CURL_INITIAL_FILL_SIZE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_EXTERNAL_TRANSCODING_CURL_SPOOL_SIZE,
+        "/transcoding/attribute::fetch-spool-size", "config-transcode.html#transcoding",
+        DEFAULT_CURL_SPOOL_SIZE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_EXTERNAL_TRANSCODING_CURL_SPOOL_FILL_SIZE,
+        "/transcoding/attribute::fetch-spool-fill-size", "config-transcode.html#transcoding",
+        DEFAULT_CURL_SPOOL_FILL_SIZE, 0, ConfigIntSetup::CheckMinValue),
 #endif //HAVE_CURL
 #ifdef HAVE_LIBEXIF
     std::make_shared<ConfigArraySetup>(CFG_IMPORT_LIBOPTS_EXIF_AUXDATA_TAGS_LIST,
@@ -658,6 +905,9 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigStringSetup>(CFG_IMPORT_LIBOPTS_ID3_CHARSET,
         "/import/library-options/id3/attribute::charset", "config-import.html#charset",
         ""),
+    std::make_shared<ConfigPathSetup>(CFG_IMPORT_LIBOPTS_ID3_ARTWORK_DIR,
+        "/import/library-options/id3/attribute::artwork-dir", "config-import.html#id3",
+        "", false, false),
 #endif
 #ifdef HAVE_FFMPEG
     std::make_shared<ConfigArraySetup>(CFG_IMPORT_LIBOPTS_FFMPEG_AUXDATA_TAGS_LIST,
@@ -666,6 +916,20 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigStringSetup>(CFG_IMPORT_LIBOPTS_FFMPEG_CHARSET,
         "/import/library-options/ffmpeg/attribute::charset", "config-import.html#charset",
         ""),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_LIBOPTS_FFMPEG_PROBESIZE,
+        "/import/library-options/ffmpeg/attribute::probesize", "config-import.html#ffmpeg",
+        DEFAULT_FFMPEG_PROBESIZE, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(CFG_IMPORT_LIBOPTS_FFMPEG_ANALYZEDURATION,
+        "/import/library-options/ffmpeg/attribute::analyzeduration", "config-import.html#ffmpeg",
+        DEFAULT_FFMPEG_ANALYZEDURATION, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigBoolSetup>(CFG_IMPORT_LIBOPTS_FFMPEG_HEADER_ONLY,
+        "/import/library-options/ffmpeg/attribute::header-only", "config-import.html#ffmpeg",
+        DEFAULT_FFMPEG_HEADER_ONLY),
+#endif
+#ifdef HAVE_MATROSKA
+    std::make_shared<ConfigBoolSetup>(CFG_IMPORT_LIBOPTS_MKV_COVER_ART,
+        "/import/library-options/mkv/attribute::cover-art", "config-import.html#mkv",
+        DEFAULT_MKV_COVER_ART),
 #endif
 #ifdef HAVE_MAGIC
     std::make_shared<ConfigPathSetup>(CFG_IMPORT_MAGIC_FILE,
@@ -681,7 +945,7 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
         NO),
     std::make_shared<ConfigEnumSetup<transcoding_type_t>>(ATTR_TRANSCODING_PROFILES_PROFLE_TYPE,
         "attribute::type", "config-transcode.html#profiles",
-        std::map<std::string, transcoding_type_t>({ { "none", TR_None }, { "external", TR_External }, /* for the future...{"remote", TR_Remote}*/ })),
+        std::map<std::string, transcoding_type_t>({ { "none", TR_None }, { "external", TR_External }, { "hls", TR_Hls }, /* for the future...{"remote", TR_Remote}*/ })),
     std::make_shared<ConfigEnumSetup<avi_fourcc_listmode_t>>(ATTR_TRANSCODING_PROFILES_PROFLE_AVI4CC_MODE,
         "mode", "config-transcode.html#profiles",
         std::map<std::string, avi_fourcc_listmode_t>({ { "ignore", FCC_Ignore }, { "process", FCC_Process }, { "disabled", FCC_None } })),
@@ -703,6 +967,18 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
         "first-resource", "config-transcode.html#profiles"),
     std::make_shared<ConfigBoolSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_ACCOGG,
         "accept-ogg-theora", "config-transcode.html#profiles"),
+    std::make_shared<ConfigIntSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_MAXCONCURRENT,
+        "max-concurrent", "config-transcode.html#profiles",
+        0, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigStringSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_FALLBACK,
+        "fallback", "config-transcode.html#profiles",
+        ""),
+    std::make_shared<ConfigStringSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_HARDWARE,
+        "hardware", "config-transcode.html#profiles",
+        ""),
+    std::make_shared<ConfigBoolSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_PRETRANSCODE,
+        "pretranscode", "config-transcode.html#profiles",
+        NO),
     std::make_shared<ConfigArraySetup>(ATTR_TRANSCODING_PROFILES_PROFLE_AVI4CC,
         "avi-fourcc-list", "config-transcode.html#profiles",
         ATTR_TRANSCODING_PROFILES_PROFLE_AVI4CC_4CC, CFG_MAX, true, true),
@@ -715,6 +991,12 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigIntSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_BUFFER_FILL,
         "attribute::fill-size", "config-transcode.html#profiles",
         0, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigIntSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_HLS_BANDWIDTH,
+        "attribute::bandwidth", "config-transcode.html#profiles",
+        0, 0, ConfigIntSetup::CheckMinValue),
+    std::make_shared<ConfigStringSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_HLS_VARIANTS,
+        "attribute::variants", "config-transcode.html#profiles",
+        ""),
     std::make_shared<ConfigIntSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_SAMPFREQ,
         "sample-frequency", "config-transcode.html#profiles",
         "-1", ConfigIntSetup::CheckProfileNumberValue),
@@ -749,6 +1031,9 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigStringSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_BUFFER,
         "buffer", "config-transcode.html#profiles",
         true),
+    std::make_shared<ConfigStringSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_HLS,
+        "hls", "config-transcode.html#profiles",
+        false),
     std::make_shared<ConfigStringSetup>(ATTR_TRANSCODING_MIMETYPE_PROF_MAP_MIMETYPE,
         "attribute::mimetype", "config-transcode.html#profiles",
         ""),
@@ -814,10 +1099,19 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
     std::make_shared<ConfigStringSetup>(ATTR_IMPORT_LAYOUT_MAPPING_TO,
         "attribute::to", "config-import.html#layout",
         ""),
+    std::make_shared<ConfigStringSetup>(ATTR_IMPORT_LAYOUT_CHAIN_PATH,
+        "attribute::path", "config-import.html#layout",
+        ""),
+    std::make_shared<ConfigStringSetup>(ATTR_IMPORT_LAYOUT_CHAIN_MEDIA,
+        "attribute::media", "config-import.html#layout",
+        ""),
 
     std::make_shared<ConfigStringSetup>(ATTR_IMPORT_LIBOPTS_AUXDATA_TAG,
         "attribute::tag", "config-import.html#auxdata",
         ""),
+    std::make_shared<ConfigStringSetup>(ATTR_IMPORT_LIBOPTS_SKIP_EXTRACTORS,
+        "attribute::extractors", "config-import.html#skip-extractors",
+        ""),
     std::make_shared<ConfigStringSetup>(ATTR_SERVER_UI_ACCOUNT_LIST_PASSWORD,
         "attribute::password", "config-server.html#ui",
         ""),
@@ -856,6 +1150,8 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
         "add-file", ""),
     std::make_shared<ConfigSetup>(ATTR_IMPORT_LIBOPTS_AUXDATA_DATA,
         "add-data", ""),
+    std::make_shared<ConfigSetup>(ATTR_IMPORT_LIBOPTS_SKIP,
+        "skip", ""),
     std::make_shared<ConfigSetup>(ATTR_TRANSCODING_MIMETYPE_PROF_MAP_TRANSCODE,
         "transcode", ""),
     std::make_shared<ConfigSetup>(ATTR_IMPORT_LAYOUT_MAPPING_PATH,
@@ -864,6 +1160,8 @@ const std::vector<std::shared_ptr<ConfigSetup>> ConfigManager::complexOptions =
         "script-option", ""),
     std::make_shared<ConfigSetup>(ATTR_IMPORT_LAYOUT_GENRE,
         "genre", ""),
+    std::make_shared<ConfigSetup>(ATTR_IMPORT_LAYOUT_CHAIN,
+        "chain", ""),
     std::make_shared<ConfigSetup>(ATTR_IMPORT_SYSTEM_DIR_ADD_PATH,
         "add-path", ""),
 
@@ -919,16 +1217,20 @@ const std::map<config_option_t, std::vector<config_option_t>> ConfigManager::par
 
     { ATTR_TRANSCODING_MIMETYPE_PROF_MAP_MIMETYPE, {} },
 
-    { ATTR_IMPORT_MAPPINGS_M2CTYPE_LIST_MIMETYPE, { CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST } },
+    { ATTR_IMPORT_MAPPINGS_M2CTYPE_LIST_MIMETYPE, { CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST, CFG_IMPORT_LIBOPTS_SKIP_EXTRACTORS } },
     { ATTR_IMPORT_MAPPINGS_M2CTYPE_LIST_TREAT, { CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST } },
     { ATTR_IMPORT_MAPPINGS_M2CTYPE_LIST_AS, { CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST } },
     { ATTR_IMPORT_MAPPINGS_MIMETYPE_FROM, { CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_LIST, CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST, CFG_IMPORT_MAPPINGS_MIMETYPE_TO_UPNP_CLASS_LIST } },
     { ATTR_IMPORT_MAPPINGS_MIMETYPE_TO, { CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_LIST, CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST, CFG_IMPORT_MAPPINGS_MIMETYPE_TO_UPNP_CLASS_LIST } },
 
+    { ATTR_IMPORT_LIBOPTS_SKIP_EXTRACTORS, { CFG_IMPORT_LIBOPTS_SKIP_EXTRACTORS } },
+
     { ATTR_IMPORT_RESOURCES_NAME, { CFG_IMPORT_RESOURCES_FANART_FILE_LIST, CFG_IMPORT_RESOURCES_CONTAINERART_FILE_LIST, CFG_IMPORT_RESOURCES_RESOURCE_FILE_LIST, CFG_IMPORT_RESOURCES_SUBTITLE_FILE_LIST, CFG_IMPORT_SYSTEM_DIRECTORIES } },
 
     { ATTR_IMPORT_LAYOUT_MAPPING_FROM, { CFG_IMPORT_LAYOUT_MAPPING, CFG_IMPORT_SCRIPTING_IMPORT_GENRE_MAP } },
     { ATTR_IMPORT_LAYOUT_MAPPING_TO, { CFG_IMPORT_LAYOUT_MAPPING, CFG_IMPORT_SCRIPTING_IMPORT_GENRE_MAP } },
+    { ATTR_IMPORT_LAYOUT_CHAIN_PATH, { CFG_IMPORT_SCRIPTING_IMPORT_TEMPLATE_CHAINS } },
+    { ATTR_IMPORT_LAYOUT_CHAIN_MEDIA, { CFG_IMPORT_SCRIPTING_IMPORT_TEMPLATE_CHAINS } },
 #ifdef HAVE_JS
     { ATTR_IMPORT_LAYOUT_SCRIPT_OPTION_NAME, { CFG_IMPORT_SCRIPTING_IMPORT_SCRIPT_OPTIONS } },
     { ATTR_IMPORT_LAYOUT_SCRIPT_OPTION_VALUE, { CFG_IMPORT_SCRIPTING_IMPORT_SCRIPT_OPTIONS } },
@@ -1007,7 +1309,63 @@ std::shared_ptr<ConfigOption> ConfigManager::setOption(const pugi::xml_node& roo
 
 void ConfigManager::addOption(config_option_t option, std::shared_ptr<ConfigOption> optionValue)
 {
-    options->at(option) = optionValue;
+    // reload() replaces options while other threads read them
+    std::atomic_store(&options->at(option), std::move(optionValue));
+}
+
+/// \brief elements of the options reload() replaces, a change anywhere else needs a restart
+static constexpr std::array reloadableElements = {
+    "/clients/client",
+    "/transcoding/profiles/profile",
+    "/transcoding/mimetype-profile-mappings",
+    "/import/layout/path",
+};
+
+/// \brief options read from reloadableElements
+static const std::vector<config_option_t> reloadableOptions = {
+    CFG_CLIENTS_LIST,
+    CFG_TRANSCODING_PROFILE_LIST,
+    CFG_IMPORT_LAYOUT_MAPPING,
+};
+
+std::string ConfigManager::staticContent(const pugi::xml_document& doc)
+{
+    pugi::xml_document copy;
+    copy.reset(doc);
+    for (auto&& xpath : reloadableElements) {
+        for (auto&& node : copy.select_nodes(fmt::format("/{}{}", ConfigSetup::ROOT_NAME, xpath).c_str()))
+            node.parent().remove_child(node.node());
+    }
+    std::ostringstream buf;
+    copy.print(buf, "", pugi::format_raw);
+    return buf.str();
+}
+
+bool ConfigManager::reload(const std::shared_ptr<Database>& database)
+{
+    log_info("Reloading configuration from: {}", filename.c_str());
+    pugi::xml_document doc;
+    pugi::xml_parse_result result = doc.load_file(filename.c_str());
+    if (result.status != pugi::xml_parse_status::status_ok) {
+        throw ConfigParseException(result.description());
+    }
+
+    if (staticContent(doc) != staticConfig) {
+        log_info("Configuration changed beyond clients, transcoding profiles and layout mappings");
+        return false;
+    }
+
+    auto root = doc.document_element();
+    std::map<std::string, std::string> args;
+    args["isEnabled"] = getBoolOption(CFG_CLIENTS_LIST_ENABLED) ? "true" : "false";
+    setOption(root, CFG_CLIENTS_LIST, &args);
+    args["isEnabled"] = getBoolOption(CFG_TRANSCODING_TRANSCODING_ENABLED) ? "true" : "false";
+    setOption(root, CFG_TRANSCODING_PROFILE_LIST, &args);
+    setOption(root, CFG_IMPORT_LAYOUT_MAPPING);
+
+    // changes made in the web ui still apply
+    applyDatabaseValues(database->getConfigValues(), reloadableOptions);
+    return true;
 }
 
 void ConfigManager::load(const fs::path& userHome)
@@ -1025,6 +1383,8 @@ void ConfigManager::load(const fs::path& userHome)
         throw ConfigParseException(result.description());
     }
 
+    staticConfig = staticContent(*xmlDoc);
+
     log_info("Checking configuration...");
 
     auto root = xmlDoc->document_element();
@@ -1096,6 +1456,7 @@ void ConfigManager::load(const fs::path& userHome)
         setOption(root, CFG_SERVER_STORAGE_MYSQL_PORT);
         setOption(root, CFG_SERVER_STORAGE_MYSQL_SOCKET);
         setOption(root, CFG_SERVER_STORAGE_MYSQL_PASSWORD);
+        setOption(root, CFG_SERVER_STORAGE_MYSQL_CONNECTIONS);
 
         co = findConfigSetup(CFG_SERVER_STORAGE_MYSQL_INIT_SQL_FILE);
         co->setDefaultValue(dataDir / "mysql.sql");
@@ -1112,6 +1473,11 @@ void ConfigManager::load(const fs::path& userHome)
     if (sqlite3_en) {
         setOption(root, CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE);
         setOption(root, CFG_SERVER_STORAGE_SQLITE_SYNCHRONOUS);
+        setOption(root, CFG_SERVER_STORAGE_SQLITE_READERS);
+        setOption(root, CFG_SERVER_STORAGE_SQLITE_JOURNAL_MODE);
+        setOption(root, CFG_SERVER_STORAGE_SQLITE_CACHE_SIZE);
+        setOption(root, CFG_SERVER_STORAGE_SQLITE_MMAP_SIZE);
+        setOption(root, CFG_SERVER_STORAGE_SQLITE_TEMP_STORE);
         setOption(root, CFG_SERVER_STORAGE_SQLITE_RESTORE);
         setOption(root, CFG_SERVER_STORAGE_SQLITE_BACKUP_ENABLED);
         setOption(root, CFG_SERVER_STORAGE_SQLITE_BACKUP_INTERVAL);
@@ -1129,12 +1495,21 @@ void ConfigManager::load(const fs::path& userHome)
 
     co = findConfigSetup(CFG_SERVER_STORAGE_DRIVER);
     co->makeOption(dbDriver, self);
+    setOption(root, CFG_SERVER_STORAGE_FULLTEXT_SEARCH);
+    setOption(root, CFG_SERVER_STORAGE_WARM_UP_DEPTH);
+    setOption(root, CFG_SERVER_STORAGE_QUERY_PROFILE);
+    setOption(root, CFG_SERVER_STORAGE_SLOW_QUERY_TIME);
+    setOption(root, CFG_SERVER_STORAGE_MAINTENANCE_INTERVAL);
+    setOption(root, CFG_SERVER_STORAGE_MAINTENANCE_FULL_VACUUM);
 
     // now go through the optional settings and fix them if anything is missing
     setOption(root, CFG_SERVER_UI_ENABLED);
     setOption(root, CFG_SERVER_UI_SHOW_TOOLTIPS);
     setOption(root, CFG_SERVER_UI_POLL_WHEN_IDLE);
     setOption(root, CFG_SERVER_UI_POLL_INTERVAL);
+    setOption(root, CFG_SERVER_UI_UPDATE_STREAMS);
+    setOption(root, CFG_SERVER_UI_COMPRESSION_LEVEL);
+    setOption(root, CFG_SERVER_UI_COMPRESSION_THRESHOLD);
 
     auto def_ipp = setOption(root, CFG_SERVER_UI_DEFAULT_ITEMS_PER_PAGE)->getIntOption();
 
@@ -1152,6 +1527,7 @@ void ConfigManager::load(const fs::path& userHome)
     setOption(root, CFG_UPNP_ARTIST_PROPERTIES);
     setOption(root, CFG_UPNP_TITLE_PROPERTIES);
     setOption(root, CFG_THREAD_SCOPE_SYSTEM);
+    setOption(root, CFG_THREAD_IDLE_IO_THREADS);
 
     bool cl_en = setOption(root, CFG_CLIENTS_LIST_ENABLED)->getBoolOption();
     args["isEnabled"] = cl_en ? "true" : "false";
@@ -1161,6 +1537,14 @@ void ConfigManager::load(const fs::path& userHome)
     setOption(root, CFG_IMPORT_HIDDEN_FILES);
     setOption(root, CFG_IMPORT_FOLLOW_SYMLINKS);
     setOption(root, CFG_IMPORT_READABLE_NAMES);
+    setOption(root, CFG_IMPORT_EXTRACTION_THREADS);
+    setOption(root, CFG_IMPORT_DEDUPLICATE_METADATA);
+    setOption(root, CFG_IMPORT_LAZY_METADATA);
+    setOption(root, CFG_IMPORT_STATISTICS);
+    setOption(root, CFG_IMPORT_CHANGE_DETECTION);
+    setOption(root, CFG_IMPORT_STORAGE_AWARENESS_ENABLED);
+    setOption(root, CFG_IMPORT_STORAGE_AWARENESS_IDLE_TIME);
+    setOption(root, CFG_IMPORT_STORAGE_AWARENESS_MAX_DELAY);
     setOption(root, CFG_IMPORT_MAPPINGS_IGNORE_UNKNOWN_EXTENSIONS);
     bool csens = setOption(root, CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_CASE_SENSITIVE)->getBoolOption();
     args["tolower"] = fmt::to_string(!csens);
@@ -1255,6 +1639,33 @@ void ConfigManager::load(const fs::path& userHome)
     setOption(root, CFG_VIRTUAL_URL);
     setOption(root, CFG_SERVER_PRESENTATION_URL);
     setOption(root, CFG_SERVER_UPNP_TITLE_AND_DESC_STRING_LIMIT);
+    setOption(root, CFG_SERVER_READ_AHEAD_THREADS);
+    setOption(root, CFG_SERVER_READ_AHEAD_CHUNKS);
+    setOption(root, CFG_SERVER_READ_AHEAD_CACHE_SIZE);
+    setOption(root, CFG_SERVER_READ_AHEAD_PREDICT_NEXT);
+    setOption(root, CFG_SERVER_THUMBNAIL_STORE_SIZE);
+    setOption(root, CFG_SERVER_THUMBNAIL_STORE_FILE);
+    setOption(root, CFG_SERVER_BROWSE_SNAPSHOT_ENABLED);
+    setOption(root, CFG_SERVER_BROWSE_SNAPSHOT_FILE);
+    setOption(root, CFG_SERVER_BROWSE_SNAPSHOT_DELAY);
+    setOption(root, CFG_SERVER_STREAM_STATISTICS);
+    setOption(root, CFG_SERVER_METRICS_ENABLED);
+    setOption(root, CFG_SERVER_MEMORY_ACCOUNTING);
+    setOption(root, CFG_SERVER_PROFILING_ENABLED);
+    setOption(root, CFG_SERVER_PROFILING_DIRECTORY);
+    setOption(root, CFG_SERVER_PROFILING_DURATION);
+    setOption(root, CFG_SERVER_TRACE_SAMPLE);
+    setOption(root, CFG_SERVER_TRACE_FILE);
+    setOption(root, CFG_SERVER_UPNP_EVENT_INTERVAL);
+    setOption(root, CFG_SERVER_UPNP_EVENT_CSV_LIMIT);
+    setOption(root, CFG_SERVER_UPNP_EVENT_SUBSCRIPTION_TIMEOUT);
+    setOption(root, CFG_SERVER_UPNP_MAX_JOBS);
+    setOption(root, CFG_SERVER_UPNP_WORKERS);
+    setOption(root, CFG_SERVER_UPNP_CONTROL_RESERVE);
+    setOption(root, CFG_SERVER_UPNP_DATA_RESERVE);
+    setOption(root, CFG_SERVER_CLUSTER_ROLE);
+    setOption(root, CFG_SERVER_CLUSTER_POLL_INTERVAL);
+    setOption(root, CFG_SERVER_CLUSTER_KEEP);
 
     temp = setOption(root, CFG_SERVER_APPEND_PRESENTATION_URL_TO)->getOption();
     if (((temp == "ip") || (temp == "port")) && getOption(CFG_SERVER_PRESENTATION_URL).empty()) {
@@ -1284,8 +1695,11 @@ void ConfigManager::load(const fs::path& userHome)
     setOption(root, CFG_IMPORT_SCRIPTING_IMPORT_LAYOUT_VIDEO);
     setOption(root, CFG_IMPORT_SCRIPTING_IMPORT_LAYOUT_IMAGE);
     setOption(root, CFG_IMPORT_SCRIPTING_IMPORT_LAYOUT_TRAILER);
+    setOption(root, CFG_IMPORT_SCRIPTING_IMPORT_RUNTIMES);
+    setOption(root, CFG_IMPORT_SCRIPTING_IMPORT_FUNCTION);
 #endif
     setOption(root, CFG_IMPORT_SCRIPTING_IMPORT_GENRE_MAP);
+    setOption(root, CFG_IMPORT_SCRIPTING_IMPORT_TEMPLATE_CHAINS);
 
     auto layoutType = setOption(root, CFG_IMPORT_SCRIPTING_VIRTUAL_LAYOUT_TYPE)->getOption();
 
@@ -1296,6 +1710,9 @@ void ConfigManager::load(const fs::path& userHome)
                                  "virtual-layout.");
 #else
     charset = setOption(root, CFG_IMPORT_SCRIPTING_CHARSET)->getOption();
+    setOption(root, CFG_IMPORT_SCRIPTING_GC_INTERVAL);
+    setOption(root, CFG_IMPORT_SCRIPTING_GC_HEAP_GROWTH);
+    setOption(root, CFG_IMPORT_SCRIPTING_TIMEOUT);
     if (layoutType == "js") {
         try {
             auto conv = std::make_unique<StringConverter>(charset,
@@ -1332,6 +1749,8 @@ void ConfigManager::load(const fs::path& userHome)
     } else {
         setOption({}, CFG_IMPORT_AUTOSCAN_INOTIFY_LIST); // set empty list
     }
+    setOption(root, CFG_IMPORT_AUTOSCAN_INOTIFY_BACKEND);
+    setOption(root, CFG_IMPORT_AUTOSCAN_SETTLE_DELAY);
 #endif
     args.clear();
 
@@ -1341,11 +1760,26 @@ void ConfigManager::load(const fs::path& userHome)
     args["isEnabled"] = tr_en ? "true" : "false";
     setOption(root, CFG_TRANSCODING_PROFILE_LIST, &args);
     args.clear();
+    setOption(root, CFG_TRANSCODING_CACHE_SIZE);
+    setOption(root, CFG_TRANSCODING_CACHE_DIR);
+    setOption(root, CFG_TRANSCODING_MAX_CONCURRENT);
+    setOption(root, CFG_TRANSCODING_QUEUE_TIMEOUT);
+    setOption(root, CFG_TRANSCODING_USE_PIPES);
+    setOption(root, CFG_TRANSCODING_STALL_TIMEOUT);
+    setOption(root, CFG_TRANSCODING_STALL_RESTARTS);
+    setOption(root, CFG_TRANSCODING_HLS_IDLE_TIMEOUT);
+    setOption(root, CFG_TRANSCODING_HLS_SEGMENTS_AHEAD);
+    setOption(root, CFG_TRANSCODING_PRETRANSCODE);
+    setOption(root, CFG_TRANSCODING_PRETRANSCODE_DIR);
+    setOption(root, CFG_TRANSCODING_PRETRANSCODE_HOURS);
+    setOption(root, CFG_TRANSCODING_PRETRANSCODE_NICE);
 
 #ifdef HAVE_CURL
     if (tr_en) {
         setOption(root, CFG_EXTERNAL_TRANSCODING_CURL_BUFFER_SIZE);
         setOption(root, CFG_EXTERNAL_TRANSCODING_CURL_FILL_SIZE);
+        setOption(root, CFG_EXTERNAL_TRANSCODING_CURL_SPOOL_SIZE);
+        setOption(root, CFG_EXTERNAL_TRANSCODING_CURL_SPOOL_FILL_SIZE);
     }
 #endif //HAVE_CURL
 
@@ -1364,6 +1798,8 @@ void ConfigManager::load(const fs::path& userHome)
     setOption(root, CFG_IMPORT_LIBOPTS_ENTRY_SEP, &args);
     setOption(root, CFG_IMPORT_LIBOPTS_ENTRY_LEGACY_SEP, &args);
     args.clear();
+    setOption(root, CFG_IMPORT_LIBOPTS_IMAGE_HEADER_SIZE);
+    setOption(root, CFG_IMPORT_LIBOPTS_SKIP_EXTRACTORS);
 
 #ifdef HAVE_LIBEXIF
     setOption(root, CFG_IMPORT_LIBOPTS_EXIF_AUXDATA_TAGS_LIST);
@@ -1378,11 +1814,22 @@ void ConfigManager::load(const fs::path& userHome)
 #ifdef HAVE_TAGLIB
     setOption(root, CFG_IMPORT_LIBOPTS_ID3_AUXDATA_TAGS_LIST);
     setOption(root, CFG_IMPORT_LIBOPTS_ID3_CHARSET);
+    co = findConfigSetup(CFG_IMPORT_LIBOPTS_ID3_ARTWORK_DIR);
+    args["resolveEmpty"] = "false";
+    co->makeOption(root, self, &args);
+    args.clear();
 #endif
 
 #ifdef HAVE_FFMPEG
     setOption(root, CFG_IMPORT_LIBOPTS_FFMPEG_AUXDATA_TAGS_LIST);
     setOption(root, CFG_IMPORT_LIBOPTS_FFMPEG_CHARSET);
+    setOption(root, CFG_IMPORT_LIBOPTS_FFMPEG_PROBESIZE);
+    setOption(root, CFG_IMPORT_LIBOPTS_FFMPEG_ANALYZEDURATION);
+    setOption(root, CFG_IMPORT_LIBOPTS_FFMPEG_HEADER_ONLY);
+#endif
+
+#ifdef HAVE_MATROSKA
+    setOption(root, CFG_IMPORT_LIBOPTS_MKV_COVER_ART);
 #endif
 
 #if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
@@ -1395,6 +1842,10 @@ void ConfigManager::load(const fs::path& userHome)
         setOption(root, CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_IMAGE_QUALITY);
         setOption(root, CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED);
         setOption(root, CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR);
+        setOption(root, CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_SIZE);
+        setOption(root, CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THREADS);
+        setOption(root, CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_QUEUE_SIZE);
+        setOption(root, CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_PREGENERATE);
     }
 #endif
 
@@ -1437,6 +1888,10 @@ void ConfigManager::load(const fs::path& userHome)
     }
 #endif
 
+#ifdef ONLINE_SERVICES
+    setOption(root, CFG_ONLINE_CONTENT_PARALLEL_FETCHES);
+#endif
+
 #ifdef SOPCAST
     setOption(root, CFG_ONLINE_CONTENT_SOPCAST_ENABLED);
 
@@ -1472,18 +1927,58 @@ void ConfigManager::load(const fs::path& userHome)
     xmlDoc = nullptr;
 }
 
+void ConfigManager::setupImportBenchmark(const fs::path& databaseFile)
+{
+    auto self = getSelf();
+    if (getOption(CFG_SERVER_STORAGE_DRIVER) != "sqlite3") {
+        // the sqlite tuning was not read, use the defaults
+        for (auto&& option : { CFG_SERVER_STORAGE_SQLITE_SYNCHRONOUS, CFG_SERVER_STORAGE_SQLITE_READERS, CFG_SERVER_STORAGE_SQLITE_JOURNAL_MODE,
+                 CFG_SERVER_STORAGE_SQLITE_CACHE_SIZE, CFG_SERVER_STORAGE_SQLITE_MMAP_SIZE, CFG_SERVER_STORAGE_SQLITE_TEMP_STORE,
+                 CFG_SERVER_STORAGE_SQLITE_RESTORE, CFG_SERVER_STORAGE_SQLITE_BACKUP_INTERVAL }) {
+            setOption({}, option);
+        }
+        auto co = findConfigSetup(CFG_SERVER_STORAGE_SQLITE_INIT_SQL_FILE);
+        co->setDefaultValue(dataDir / "sqlite3.sql");
+        co->makeOption(pugi::xml_node(), self);
+        findConfigSetup(CFG_SERVER_STORAGE_DRIVER)->makeOption("sqlite3", self);
+    }
+    addOption(CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE, std::make_shared<Option>(databaseFile));
+    addOption(CFG_SERVER_STORAGE_SQLITE_BACKUP_ENABLED, std::make_shared<BoolOption>(false));
+    addOption(CFG_IMPORT_STATISTICS, std::make_shared<BoolOption>(true));
+
+    // only the benchmark directory is imported
+    setOption({}, CFG_IMPORT_AUTOSCAN_TIMED_LIST);
+#ifdef HAVE_INOTIFY
+    setOption({}, CFG_IMPORT_AUTOSCAN_INOTIFY_LIST);
+#endif
+}
+
+void ConfigManager::setupProcessRole(const std::string& role)
+{
+    if (role != "scanner" && role != "server")
+        throw_std_runtime_error("Invalid role {}, use scanner or server", role);
+    auto clusterRole = getOption(CFG_SERVER_CLUSTER_ROLE);
+    if (clusterRole != "standalone")
+        log_warning("Role {} replaces cluster role {} of the config file", role, clusterRole);
+    addOption(CFG_SERVER_CLUSTER_ROLE, std::make_shared<Option>(role == "scanner" ? "importer" : "frontend"));
+}
+
 void ConfigManager::updateConfigFromDatabase(std::shared_ptr<Database> database)
 {
     auto values = database->getConfigValues();
-    auto self = getSelf();
     origValues.clear();
     log_info("Loading {} configuration items from database", values.size());
+    applyDatabaseValues(values, {});
+}
 
+void ConfigManager::applyDatabaseValues(const std::vector<ConfigValue>& values, const std::vector<config_option_t>& only)
+{
+    auto self = getSelf();
     for (const auto& cfgValue : values) {
         try {
             auto cs = ConfigManager::findConfigSetupByPath(cfgValue.key, true);
 
-            if (cs != nullptr) {
+            if (cs != nullptr && (only.empty() || std::find(only.begin(), only.end(), cs->option) != only.end())) {
                 if (cfgValue.item == cs->xpath) {
                     origValues[cfgValue.item] = cs->getCurrentValue();
                     cs->makeOption(cfgValue.value, self);
@@ -1528,7 +2023,7 @@ void ConfigManager::setOrigValue(const std::string& item, int value)
 // The validate function ensures that the array is completely filled!
 std::string ConfigManager::getOption(config_option_t option) const
 {
-    auto o = options->at(option);
+    const auto& o = (*options)[option];
     if (o == nullptr) {
         throw std::runtime_error("option not set");
     }
@@ -1537,7 +2032,7 @@ std::string ConfigManager::getOption(config_option_t option) const
 
 int ConfigManager::getIntOption(config_option_t option) const
 {
-    auto o = options->at(option);
+    const auto& o = (*options)[option];
     if (o == nullptr) {
         throw std::runtime_error("option not set");
     }
@@ -1546,7 +2041,7 @@ int ConfigManager::getIntOption(config_option_t option) const
 
 bool ConfigManager::getBoolOption(config_option_t option) const
 {
-    auto o = options->at(option);
+    const auto& o = (*options)[option];
     if (o == nullptr) {
         throw std::runtime_error("option not set");
     }
@@ -1555,7 +2050,7 @@ bool ConfigManager::getBoolOption(config_option_t option) const
 
 std::map<std::string, std::string> ConfigManager::getDictionaryOption(config_option_t option) const
 {
-    return options->at(option)->getDictionaryOption();
+    return std::atomic_load(&options->at(option))->getDictionaryOption();
 }
 
 std::vector<std::string> ConfigManager::getArrayOption(config_option_t option) const
@@ -1570,7 +2065,7 @@ std::shared_ptr<AutoscanList> ConfigManager::getAutoscanListOption(config_option
 
 std::shared_ptr<ClientConfigList> ConfigManager::getClientConfigListOption(config_option_t option) const
 {
-    return options->at(option)->getClientConfigListOption();
+    return std::atomic_load(&options->at(option))->getClientConfigListOption();
 }
 
 std::shared_ptr<DirectoryConfigList> ConfigManager::getDirectoryTweakOption(config_option_t option) const
@@ -1580,5 +2075,5 @@ std::shared_ptr<DirectoryConfigList> ConfigManager::getDirectoryTweakOption(conf
 
 std::shared_ptr<TranscodingProfileList> ConfigManager::getTranscodingProfileListOption(config_option_t option) const
 {
-    return options->at(option)->getTranscodingProfileListOption();
+    return std::atomic_load(&options->at(option))->getTranscodingProfileListOption();
 }
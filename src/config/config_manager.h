@@ -49,6 +49,7 @@ class AutoscanDirectory;
 class ClientConfigList;
 class ClientConfig;
 class ConfigSetup;
+class ConfigValue;
 class DirectoryConfigList;
 enum class ScanMode;
 enum class ClientType;
@@ -91,8 +92,22 @@ public:
     }
 
     void load(const fs::path& userHome);
+
+    /// \brief switch to a fresh sqlite database and drop the autoscan directories for an import benchmark
+    /// \param databaseFile sqlite file to create, must not exist.
+    void setupImportBenchmark(const fs::path& databaseFile);
+
+    /// \brief run only the imports or only the serving part of a shared database
+    /// \param role "scanner" imports as cluster importer, "server" serves as cluster frontend.
+    void setupProcessRole(const std::string& role);
+
     void updateConfigFromDatabase(std::shared_ptr<Database> database) override;
 
+    /// \brief read the clients, transcoding profiles and layout mappings again while the server keeps running
+    /// \param database to apply the values changed in the web ui.
+    /// \return false if other parts of the config file changed as well, the server has to restart for them.
+    bool reload(const std::shared_ptr<Database>& database);
+
     /// \brief add a config option
     /// \param option option type to add.
     /// \param option option to add.
@@ -165,12 +180,18 @@ protected:
     std::map<std::string, std::string> origValues;
 
     std::unique_ptr<pugi::xml_document> xmlDoc;
+    /// \brief config file without the elements reload() replaces
+    std::string staticConfig;
+    static std::string staticContent(const pugi::xml_document& doc);
 
     std::unique_ptr<std::vector<std::shared_ptr<ConfigOption>>> options;
 
     std::shared_ptr<ConfigOption> setOption(const pugi::xml_node& root, config_option_t option, const std::map<std::string, std::string>* arguments = nullptr);
 
     std::shared_ptr<Config> getSelf();
+
+    /// \brief apply the values stored in the database, all if only is empty
+    void applyDatabaseValues(const std::vector<ConfigValue>& values, const std::vector<config_option_t>& only);
 };
 
 #endif // __CONFIG_MANAGER_H__
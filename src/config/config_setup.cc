@@ -24,6 +24,7 @@
 
 #include "config_setup.h" // API
 
+#include <algorithm>
 #include <cstdio>
 #include <filesystem>
 #include <iostream>
@@ -38,6 +39,7 @@
 #include "content/autoscan.h"
 #include "directory_tweak.h"
 #include "metadata/metadata_handler.h"
+#include "transcoding/hardware_accelerators.h"
 #include "transcoding/transcoding.h"
 
 #ifdef HAVE_INOTIFY
@@ -171,6 +173,23 @@ std::shared_ptr<ConfigOption> ConfigStringSetup::newOption(const std::string& op
     return optionValue;
 }
 
+bool ConfigStringSetup::CheckSqlLiteJournalValue(std::string& value)
+{
+    static const std::vector<std::string> modes { "delete", "truncate", "persist", "memory", "wal", "off" };
+    auto mode = toLower(value);
+    if (std::find(modes.begin(), modes.end(), mode) == modes.end())
+        return false;
+    value.assign(mode);
+    return true;
+}
+
+bool ConfigStringSetup::CheckHourRangeValue(std::string& value)
+{
+    int start;
+    int end;
+    return value.empty() || parseHourRange(value, start, end);
+}
+
 bool ConfigPathSetup::checkPathValue(std::string& optValue, std::string& pathValue) const
 {
     if (rawCheck != nullptr && !rawCheck(optValue)) {
@@ -371,6 +390,21 @@ bool ConfigIntSetup::CheckSqlLiteSyncValue(std::string& value)
     return true;
 }
 
+bool ConfigIntSetup::CheckSqlLiteTempStoreValue(std::string& value)
+{
+    auto temp_int = 0;
+    if (value == "default" || value == fmt::to_string(MT_SQLITE_TEMP_STORE_DEFAULT))
+        temp_int = MT_SQLITE_TEMP_STORE_DEFAULT;
+    else if (value == "file" || value == fmt::to_string(MT_SQLITE_TEMP_STORE_FILE))
+        temp_int = MT_SQLITE_TEMP_STORE_FILE;
+    else if (value == "memory" || value == fmt::to_string(MT_SQLITE_TEMP_STORE_MEMORY))
+        temp_int = MT_SQLITE_TEMP_STORE_MEMORY;
+    else
+        return false;
+    value.assign(fmt::to_string(temp_int));
+    return true;
+}
+
 bool ConfigIntSetup::CheckProfileNumberValue(std::string& value)
 {
     auto temp_int = 0;
@@ -397,6 +431,11 @@ bool ConfigIntSetup::CheckImageQualityValue(int value)
     return !(value < 0 || value > 10);
 }
 
+bool ConfigIntSetup::CheckCompressionLevelValue(int value)
+{
+    return !(value < 0 || value > 9);
+}
+
 bool ConfigIntSetup::CheckUpnpStringLimitValue(int value)
 {
     return !((value != -1) && (value < 4));
@@ -1089,6 +1128,33 @@ bool ConfigTranscodingSetup::createTranscodingProfileListFromNode(const pugi::xm
             if (cs->hasXmlElement(child))
                 prof->setTheora(cs->getXmlContent(child));
         }
+        {
+            auto cs = findConfigSetup<ConfigIntSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_MAXCONCURRENT);
+            if (cs->hasXmlElement(child))
+                prof->setMaxConcurrent(cs->getXmlContent(child));
+        }
+        {
+            auto cs = findConfigSetup<ConfigStringSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_FALLBACK);
+            if (cs->hasXmlElement(child))
+                prof->setFallback(cs->getXmlContent(child));
+        }
+        {
+            auto cs = findConfigSetup<ConfigStringSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_HARDWARE);
+            if (cs->hasXmlElement(child)) {
+                auto hardware = toLower(cs->getXmlContent(child));
+                auto known = HardwareAccelerators::getKnown();
+                if (std::find(known.begin(), known.end(), hardware) == known.end()) {
+                    log_error("Error in configuration: transcoding profile \"{}\" requires unknown hardware \"{}\", use one of {}", prof->getName(), hardware, join(known, ", "));
+                    return false;
+                }
+                prof->setHardware(hardware);
+            }
+        }
+        {
+            auto cs = findConfigSetup<ConfigBoolSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_PRETRANSCODE);
+            if (cs->hasXmlElement(child))
+                prof->setPretranscode(cs->getXmlContent(child));
+        }
 
         sub = findConfigSetup<ConfigSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_AGENT)->getXmlElement(child);
         prof->setCommand(findConfigSetup<ConfigStringSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_AGENT_COMMAND)->getXmlContent(sub));
@@ -1110,6 +1176,17 @@ bool ConfigTranscodingSetup::createTranscodingProfileListFromNode(const pugi::xm
 
         prof->setBufferOptions(buffer, chunk, fill);
 
+        {
+            auto cs = findConfigSetup<ConfigSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_HLS);
+            if (cs->hasXmlElement(child)) {
+                sub = cs->getXmlElement(child);
+                prof->setBandwidth(findConfigSetup<ConfigIntSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_HLS_BANDWIDTH)->getXmlContent(sub));
+                auto variants = splitString(findConfigSetup<ConfigStringSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_HLS_VARIANTS)->getXmlContent(sub), ',');
+                std::for_each(variants.begin(), variants.end(), trimStringInPlace);
+                prof->setVariants(variants);
+            }
+        }
+
         bool set = false;
         for (const auto& [key, val] : mt_mappings) {
             if (val == prof->getName()) {
@@ -1126,6 +1203,30 @@ bool ConfigTranscodingSetup::createTranscodingProfileListFromNode(const pugi::xm
         }
     }
 
+    for (const auto& [key, val] : result->getList()) {
+        for (const auto& [name, prof] : *val) {
+            for (auto&& variant : prof->getVariants()) {
+                auto var = result->getByName(variant, true);
+                if (prof->getType() != TR_Hls || var == nullptr || var->getType() != TR_Hls) {
+                    log_error("Error in configuration: variant \"{}\" of transcoding profile \"{}\" is not a hls profile", variant, prof->getName());
+                    return false;
+                }
+            }
+            if (prof->getFallback().empty())
+                continue;
+            auto fallback = result->getByName(prof->getFallback(), true);
+            if (fallback == nullptr) {
+                log_error("Error in configuration: fallback \"{}\" of transcoding profile \"{}\" does not exist", prof->getFallback(), prof->getName());
+                return false;
+            }
+            // the client was promised the mime type of the original profile
+            if (fallback->getTargetMimeType() != prof->getTargetMimeType()) {
+                log_error("Error in configuration: fallback \"{}\" of transcoding profile \"{}\" has a different mime type", prof->getFallback(), prof->getName());
+                return false;
+            }
+        }
+    }
+
     auto tpl = result->getList();
     for (const auto& [key, val] : mt_mappings) {
         if (!tpl.count(key)) {
@@ -1296,6 +1397,20 @@ bool ConfigTranscodingSetup::updateDetail(const std::string& optItem, std::strin
                 log_debug("New Transcoding Detail {} {}", index, config->getTranscodingProfileListOption(option)->getByName(entry->getName(), true)->isTheora());
                 return true;
             }
+            index = getItemPath(i, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_MAXCONCURRENT);
+            if (optItem == index) {
+                config->setOrigValue(index, entry->getMaxConcurrent());
+                entry->setMaxConcurrent(findConfigSetup<ConfigIntSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_MAXCONCURRENT)->checkIntValue(optValue));
+                log_debug("New Transcoding Detail {} {}", index, config->getTranscodingProfileListOption(option)->getByName(entry->getName(), true)->getMaxConcurrent());
+                return true;
+            }
+            index = getItemPath(i, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_HLS, ATTR_TRANSCODING_PROFILES_PROFLE_HLS_BANDWIDTH);
+            if (optItem == index) {
+                config->setOrigValue(index, entry->getBandwidth());
+                entry->setBandwidth(findConfigSetup<ConfigIntSetup>(ATTR_TRANSCODING_PROFILES_PROFLE_HLS_BANDWIDTH)->checkIntValue(optValue));
+                log_debug("New Transcoding Detail {} {}", index, config->getTranscodingProfileListOption(option)->getByName(entry->getName(), true)->getBandwidth());
+                return true;
+            }
 
             size_t buffer = entry->getBufferSize();
             size_t chunk = entry->getBufferChunkSize();
@@ -1612,6 +1727,7 @@ bool ConfigDirectorySetup::updateItem(size_t i, const std::string& optItem, cons
         auto pathValue = optValue;
         if (findConfigSetup<ConfigPathSetup>(ATTR_DIRECTORIES_TWEAK_LOCATION)->checkPathValue(optValue, pathValue)) {
             entry->setLocation(pathValue);
+            config->getDirectoryTweakOption(option)->updateIndex();
             log_debug("New Tweak Detail {} {}", index, config->getDirectoryTweakOption(option)->get(i)->getLocation().string());
             return true;
         }
@@ -1621,6 +1737,7 @@ bool ConfigDirectorySetup::updateItem(size_t i, const std::string& optItem, cons
         if (entry->getOrig())
             config->setOrigValue(index, entry->getInherit());
         entry->setInherit(findConfigSetup<ConfigBoolSetup>(ATTR_DIRECTORIES_TWEAK_INHERIT)->checkValue(optValue));
+        config->getDirectoryTweakOption(option)->updateIndex();
         log_debug("New Tweak Detail {} {}", index, config->getDirectoryTweakOption(option)->get(i)->getInherit());
         return true;
     }
@@ -216,6 +216,9 @@ public:
     void makeOption(const pugi::xml_node& root, const std::shared_ptr<Config>& config, const std::map<std::string, std::string>* arguments = nullptr) override;
 
     std::shared_ptr<ConfigOption> newOption(const std::string& optValue);
+
+    static bool CheckSqlLiteJournalValue(std::string& value);
+    static bool CheckHourRangeValue(std::string& value);
 };
 
 template <class En>
@@ -404,12 +407,16 @@ public:
 
     static bool CheckSqlLiteSyncValue(std::string& value);
 
+    static bool CheckSqlLiteTempStoreValue(std::string& value);
+
     static bool CheckProfileNumberValue(std::string& value);
 
     static bool CheckMinValue(int value, int minValue);
 
     static bool CheckImageQualityValue(int value);
 
+    static bool CheckCompressionLevelValue(int value);
+
     static bool CheckPortValue(int value);
 
     static bool CheckUpnpStringLimitValue(int value);
@@ -69,6 +69,32 @@ void DirectoryConfigList::_add(const std::shared_ptr<DirectoryTweak>& dir, size_
     }
     list.push_back(dir);
     indexMap[index] = dir;
+    _updateIndex();
+}
+
+void DirectoryConfigList::updateIndex()
+{
+    AutoLock lock(mutex);
+    _updateIndex();
+}
+
+void DirectoryConfigList::_updateIndex()
+{
+    index.children.clear();
+    index.tweak = nullptr;
+    for (auto&& dir : list) {
+        auto node = &index;
+        for (auto&& part : dir->getLocation()) {
+            auto&& child = node->children[part.string()];
+            if (child == nullptr)
+                child = std::make_unique<Node>();
+            node = child.get();
+        }
+        // like the search through the list the first entry of a location wins
+        if (node->tweak == nullptr)
+            node->tweak = dir;
+    }
+    lastValid = false;
 }
 
 size_t DirectoryConfigList::getEditSize() const
@@ -104,13 +130,32 @@ std::shared_ptr<DirectoryTweak> DirectoryConfigList::get(const fs::path& locatio
 {
     AutoLock lock(mutex);
     const auto& myLocation = location.has_filename() ? location.parent_path() : location;
-    for (auto testLoc = myLocation; testLoc.has_parent_path() && testLoc != "/"; testLoc = testLoc.parent_path()) {
-        auto entry = std::find_if(list.begin(), list.end(), [&](const auto& d) { return (d->getLocation() == myLocation || d->getInherit()) && d->getLocation() == testLoc; });
-        if (entry != list.end() && *entry != nullptr) {
-            return *entry;
+    if (lastValid && lastDirectory == myLocation)
+        return lastTweak;
+
+    // the deepest tweak on the path, a parent's one only if it is inherited
+    std::shared_ptr<DirectoryTweak> result;
+    const Node* node = &index;
+    std::size_t depth = 0;
+    bool complete = true;
+    for (auto&& part : myLocation) {
+        auto child = node->children.find(part.string());
+        if (child == node->children.end()) {
+            complete = false;
+            break;
         }
+        node = child->second.get();
+        // the root directory and the first component of a relative path have no tweaks
+        if (++depth > 1 && node->tweak != nullptr && node->tweak->getInherit())
+            result = node->tweak;
     }
-    return nullptr;
+    if (complete && depth > 1 && node->tweak != nullptr)
+        result = node->tweak;
+
+    lastDirectory = myLocation;
+    lastTweak = result;
+    lastValid = true;
+    return result;
 }
 
 void DirectoryConfigList::remove(size_t id, bool edit)
@@ -124,6 +169,7 @@ void DirectoryConfigList::remove(size_t id, bool edit)
         }
 
         list.erase(list.begin() + id);
+        _updateIndex();
         log_debug("ID {} removed!", id);
     } else {
         if (!indexMap.count(id)) {
@@ -136,6 +182,7 @@ void DirectoryConfigList::remove(size_t id, bool edit)
         if (id >= origSize) {
             indexMap.erase(id);
         }
+        _updateIndex();
         log_debug("ID {} removed!", id);
     }
 }
@@ -29,7 +29,9 @@
 
 #include <filesystem>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 namespace fs = std::filesystem;
 
@@ -60,8 +62,12 @@ public:
 
     std::shared_ptr<DirectoryTweak> get(size_t id, bool edit = false);
 
+    /// \brief the tweak of the directory of location or of the nearest parent it is inherited from
     std::shared_ptr<DirectoryTweak> get(const fs::path& location);
 
+    /// \brief update the lookup after the location of a tweak was changed
+    void updateIndex();
+
     size_t getEditSize() const;
 
     size_t size() const { return list.size(); }
@@ -81,6 +87,20 @@ protected:
 
     std::vector<std::shared_ptr<DirectoryTweak>> list;
     void _add(const std::shared_ptr<DirectoryTweak>& dir, size_t index);
+
+    /// \brief one path component, the tweak configured for the path ending with it
+    struct Node {
+        std::shared_ptr<DirectoryTweak> tweak;
+        std::unordered_map<std::string, std::unique_ptr<Node>> children;
+    };
+    /// \brief the tweaks by their location, so a lookup only walks the components of the path
+    Node index;
+    void _updateIndex();
+
+    /// \brief result of the last lookup, the files of a directory are imported one after the other
+    fs::path lastDirectory;
+    std::shared_ptr<DirectoryTweak> lastTweak;
+    bool lastValid { false };
 };
 
 /// \brief Provides information about one directory.
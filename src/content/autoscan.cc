@@ -145,6 +145,36 @@ ScanMode AutoscanDirectory::remapScanmode(const std::string& scanmode)
     throw_std_runtime_error("Illegal scanmode ({}) given to remapScanmode()", scanmode.c_str());
 }
 
+void AutoscanDirectory::addStaleObject(int objectID)
+{
+    AutoLock lock(mutex);
+    staleObjects.insert(objectID);
+}
+
+void AutoscanDirectory::addStaleObjects(const std::unordered_set<int>& objectIDs)
+{
+    AutoLock lock(mutex);
+    staleObjects.insert(objectIDs.begin(), objectIDs.end());
+}
+
+std::unordered_set<int> AutoscanDirectory::takeStaleObjects()
+{
+    AutoLock lock(mutex);
+    return std::exchange(staleObjects, {});
+}
+
+void AutoscanDirectory::addListedDirectory(int containerID, time_t mtime)
+{
+    AutoLock lock(mutex);
+    listedDirectories.emplace_back(containerID, mtime);
+}
+
+std::vector<std::pair<int, time_t>> AutoscanDirectory::takeListedDirectories()
+{
+    AutoLock lock(mutex);
+    return std::exchange(listedDirectories, {});
+}
+
 void AutoscanDirectory::copyTo(const std::shared_ptr<AutoscanDirectory>& copy) const
 {
     copy->location = location;
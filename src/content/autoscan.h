@@ -35,6 +35,9 @@
 
 #include <filesystem>
 #include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 namespace fs = std::filesystem;
 
 #include "util/timer.h"
@@ -136,6 +139,28 @@ public:
     }
     int getActiveScanCount() const { return activeScanCount; }
 
+    /// \brief Marks the current scan as the continuation of one that was interrupted.
+    ///
+    /// Directories that were completely processed before and did not change
+    /// since are not listed again.
+    void setResumed(bool resumed) { this->resumed = resumed; }
+    bool isResumed() const { return resumed; }
+
+    /// \brief Collects the objects the tasks of the current scan did not find any more.
+    ///
+    /// Each directory task removes what was collected until it ends, so
+    /// the skipped links of a directory go with its other missing entries.
+    void addStaleObject(int objectID);
+    void addStaleObjects(const std::unordered_set<int>& objectIDs);
+    std::unordered_set<int> takeStaleObjects();
+
+    /// \brief Directories listed completely by the current scan, with their mtime.
+    ///
+    /// Their state is stored after the stale objects are removed, a resumed
+    /// scan must not skip a directory whose missing entries are still there.
+    void addListedDirectory(int containerID, time_t mtime);
+    std::vector<std::pair<int, time_t>> takeListedDirectories();
+
     /// \brief copies all properties to another object
     void copyTo(const std::shared_ptr<AutoscanDirectory>& copy) const;
 
@@ -163,6 +188,26 @@ protected:
     std::shared_ptr<Timer::Parameter> timer_parameter;
     std::map<std::string, time_t> lastModified;
     unsigned int activeScanCount { 0 };
+    bool resumed { false };
+    // filled by the scan tasks, taken by whichever task ends first
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::unordered_set<int> staleObjects;
+    std::vector<std::pair<int, time_t>> listedDirectories;
+};
+
+/// \brief Backend watching the event driven (inotify) autoscan directories
+class AutoscanMonitor {
+public:
+    virtual ~AutoscanMonitor() = default;
+
+    virtual void run() = 0;
+
+    /// \brief Start monitoring a directory
+    virtual void monitor(const std::shared_ptr<AutoscanDirectory>& dir) = 0;
+
+    /// \brief Stop monitoring a directory
+    virtual void unmonitor(const std::shared_ptr<AutoscanDirectory>& dir) = 0;
 };
 
 #endif
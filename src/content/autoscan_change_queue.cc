@@ -0,0 +1,176 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    autoscan_change_queue.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file autoscan_change_queue.cc
+
+#ifdef HAVE_INOTIFY
+#include "autoscan_change_queue.h" // API
+
+#include <algorithm>
+
+#include "content_manager.h"
+#include "database/database.h"
+
+AutoscanChangeQueue::AutoscanChangeQueue(std::shared_ptr<ContentManager> content)
+    : config(content->getContext()->getConfig())
+    , database(content->getContext()->getDatabase())
+    , content(std::move(content))
+    , delay(std::chrono::seconds(config->getIntOption(CFG_IMPORT_AUTOSCAN_SETTLE_DELAY)))
+{
+}
+
+AutoscanChangeQueue::Change& AutoscanChangeQueue::update(const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& path, bool isDir)
+{
+    auto [entry, inserted] = changes.try_emplace(path.string());
+    // unlike the iterator, references stay valid when update() inserts the source below
+    const auto& key = entry->first;
+    auto& change = entry->second;
+    if (inserted) {
+        change.path = path;
+        change.remove = false;
+        change.add = false;
+    } else if (!change.movedFrom.empty()) {
+        // changed again after the rename, remove the source and import the target instead
+        auto from = change.movedFrom;
+        change.movedFrom.clear();
+        auto& source = update(change.adir, from, change.isDir);
+        source.remove = true;
+        source.add = false;
+        change.remove = true;
+        change.add = true;
+    }
+    change.adir = adir;
+    change.isDir = isDir;
+    change.cookie = 0;
+    change.due = std::chrono::steady_clock::now() + delay;
+    order.emplace_back(change.due, key);
+    return change;
+}
+
+void AutoscanChangeQueue::push(const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& path, bool isDir, bool remove, bool add)
+{
+    auto& change = update(adir, path, isDir);
+    // only the last state of the path counts
+    change.remove = change.remove || remove || !add;
+    change.add = add;
+}
+
+void AutoscanChangeQueue::movedFrom(std::uint32_t cookie, const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& path, bool isDir)
+{
+    auto& change = update(adir, path, isDir);
+    change.remove = true;
+    change.add = false;
+    change.cookie = cookie;
+    moveSources[cookie] = path.string();
+}
+
+void AutoscanChangeQueue::movedTo(std::uint32_t cookie, const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& path, bool isDir)
+{
+    auto source = moveSources.find(cookie);
+    if (source != moveSources.end()) {
+        auto from = changes.find(source->second);
+        moveSources.erase(source);
+        // the source must not have changed after IN_MOVED_FROM and the target has to be new
+        if (from != changes.end() && from->second.cookie == cookie && from->second.adir == adir && from->second.isDir == isDir
+            && changes.find(path.string()) == changes.end()) {
+            auto fromPath = from->second.path;
+            changes.erase(from);
+            update(adir, path, isDir).movedFrom = fromPath;
+            return;
+        }
+    }
+    push(adir, path, isDir, false, true);
+}
+
+bool AutoscanChangeQueue::isMoveSource(const fs::path& path) const
+{
+    return std::any_of(changes.begin(), changes.end(), [&](auto&& entry) { return entry.second.movedFrom == path; });
+}
+
+void AutoscanChangeQueue::process(bool idle)
+{
+    // without delay the two halves of a rename read in one go are still paired
+    if (delay.count() == 0 && !idle)
+        return;
+
+    auto now = std::chrono::steady_clock::now();
+    while (!order.empty() && order.front().first <= now) {
+        auto [due, key] = order.front();
+        order.pop_front();
+        auto entry = changes.find(key);
+        if (entry == changes.end() || entry->second.due != due)
+            continue;
+
+        auto change = entry->second;
+        changes.erase(entry);
+        if (change.cookie != 0)
+            moveSources.erase(change.cookie);
+        apply(change);
+    }
+}
+
+int AutoscanChangeQueue::timeout() const
+{
+    if (order.empty())
+        return -1;
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(order.front().first - std::chrono::steady_clock::now());
+    return std::max(0, static_cast<int>(wait.count()));
+}
+
+void AutoscanChangeQueue::apply(const Change& change)
+{
+    const auto& adir = change.adir;
+    if (!change.movedFrom.empty()) {
+        log_debug("Moving {} to {}", change.movedFrom.c_str(), change.path.c_str());
+        content->moveObject(adir, change.movedFrom, change.path);
+        return;
+    }
+
+    if (change.remove) {
+        log_debug("deleting {}", change.path.c_str());
+        int objectID = database->findObjectIDByPath(change.path, !change.isDir);
+        if (objectID != INVALID_OBJECT_ID)
+            content->removeObject(adir, objectID, true);
+    }
+
+    if (change.add) {
+        log_debug("Adding {}", change.path.c_str());
+        std::error_code ec;
+        auto dirEnt = fs::directory_entry(change.path, ec);
+        if (!ec) {
+            AutoScanSetting asSetting;
+            asSetting.adir = adir;
+            asSetting.followSymlinks = config->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS);
+            asSetting.recursive = adir->getRecursive();
+            asSetting.hidden = adir->getHidden();
+            asSetting.rescanResource = true;
+            asSetting.mergeOptions(config, change.path);
+            // path, rootpath, settings, async, priority, cancellable
+            content->addFile(dirEnt, adir->getLocation(), asSetting, true, TaskPriority::Normal, false);
+        } else {
+            log_error("Failed to read {}: {}", change.path.c_str(), ec.message());
+        }
+    }
+}
+
+#endif // HAVE_INOTIFY
@@ -0,0 +1,99 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    autoscan_change_queue.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file autoscan_change_queue.h
+#ifndef __AUTOSCAN_CHANGE_QUEUE_H__
+#define __AUTOSCAN_CHANGE_QUEUE_H__
+
+#ifdef HAVE_INOTIFY
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+#include "autoscan.h"
+
+// forward declaration
+class Config;
+class ContentManager;
+class Database;
+
+/// \brief Collects the changes reported by inotify or fanotify for each path
+///
+/// A path is handed to the content manager once no event arrived for it during the settle delay,
+/// so a file written in many chunks is imported once. A rename reported with a matching cookie only moves the object.
+class AutoscanChangeQueue {
+public:
+    explicit AutoscanChangeQueue(std::shared_ptr<ContentManager> content);
+
+    /// \brief path has to be removed, added again or both
+    void push(const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& path, bool isDir, bool remove, bool add);
+
+    /// \brief first half of a rename, handled like a removal until the matching movedTo() arrives
+    void movedFrom(std::uint32_t cookie, const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& path, bool isDir);
+    /// \brief second half of a rename, handled like a new file if the removal of the source cannot be turned into a move
+    void movedTo(std::uint32_t cookie, const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& path, bool isDir);
+
+    /// \brief path is the source of a pending move, its object must not be removed
+    bool isMoveSource(const fs::path& path) const;
+
+    /// \brief hand the settled changes to the content manager
+    /// \param idle no more events are waiting, allows to process changes without delay
+    void process(bool idle);
+
+    /// \brief milliseconds until the next change settles, -1 if there is none
+    int timeout() const;
+
+private:
+    struct Change {
+        std::shared_ptr<AutoscanDirectory> adir;
+        fs::path path;
+        bool isDir;
+        bool remove;
+        bool add;
+        /// \brief set if path was only renamed from this location
+        fs::path movedFrom;
+        std::uint32_t cookie;
+        std::chrono::steady_clock::time_point due;
+    };
+
+    void apply(const Change& change);
+    Change& update(const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& path, bool isDir);
+
+    std::shared_ptr<Config> config;
+    std::shared_ptr<Database> database;
+    std::shared_ptr<ContentManager> content;
+
+    std::chrono::milliseconds delay;
+    std::unordered_map<std::string, Change> changes;
+    /// \brief paths in the order of their due time, stale if the change was updated later
+    std::deque<std::pair<std::chrono::steady_clock::time_point, std::string>> order;
+    /// \brief sources of renames waiting for their IN_MOVED_TO
+    std::unordered_map<std::uint32_t, std::string> moveSources;
+};
+
+#endif // HAVE_INOTIFY
+
+#endif // __AUTOSCAN_CHANGE_QUEUE_H__
@@ -0,0 +1,458 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    autoscan_fanotify.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file autoscan_fanotify.cc
+
+#ifdef HAVE_FANOTIFY
+#include "autoscan_fanotify.h" // API
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/fanotify.h>
+#include <sys/statfs.h>
+#include <unistd.h>
+
+#include "content_manager.h"
+#include "database/database.h"
+
+#define FANOTIFY_EVENTS (FAN_CREATE | FAN_DELETE | FAN_CLOSE_WRITE | FAN_ONDIR)
+
+#ifndef FAN_RENAME
+#define FAN_RENAME 0x10000000
+#define FAN_EVENT_INFO_TYPE_OLD_DFID_NAME 10
+#define FAN_EVENT_INFO_TYPE_NEW_DFID_NAME 12
+#endif
+
+static std::uint64_t fsidKey(const void* fsid)
+{
+    std::uint64_t key;
+    std::memcpy(&key, fsid, sizeof(key));
+    return key;
+}
+
+/// \brief path is the directory or below it
+static bool isInside(const fs::path& path, const fs::path& dir)
+{
+    auto rel = path.lexically_relative(dir);
+    return !rel.empty() && *rel.begin() != "..";
+}
+
+AutoscanFanotify::AutoscanFanotify(std::shared_ptr<ContentManager> content)
+    : config(content->getContext()->getConfig())
+    , database(content->getContext()->getDatabase())
+    , content(std::move(content))
+{
+    fanotify_fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_REPORT_DFID_NAME, O_RDONLY | O_LARGEFILE);
+    if (fanotify_fd < 0)
+        throw_std_runtime_error("Unable to initialize fanotify: {}", std::strerror(errno));
+
+    int stop_fds_pipe[2];
+    if (pipe2(stop_fds_pipe, O_CLOEXEC) < 0) {
+        close(fanotify_fd);
+        throw_std_runtime_error("Unable to create pipe");
+    }
+    stop_fd_read = stop_fds_pipe[0];
+    stop_fd_write = stop_fds_pipe[1];
+    changes = std::make_unique<AutoscanChangeQueue>(this->content);
+    eventMask = FANOTIFY_EVENTS | FAN_RENAME;
+    shutdownFlag = true;
+}
+
+AutoscanFanotify::~AutoscanFanotify()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!shutdownFlag) {
+        log_debug("start");
+        shutdownFlag = true;
+        char stop = 's';
+        if (write(stop_fd_write, &stop, 1) == -1) {
+            log_error("fanotify: could not send stop: {}", std::strerror(errno));
+        }
+        lock.unlock();
+        thread_.join();
+        log_debug("fanotify thread died.");
+    }
+    for (auto&& [fsid, filesystem] : filesystems)
+        close(filesystem.mountFd);
+    close(fanotify_fd);
+    close(stop_fd_read);
+    close(stop_fd_write);
+}
+
+void AutoscanFanotify::run()
+{
+    AutoLock lock(mutex);
+
+    if (shutdownFlag) {
+        shutdownFlag = false;
+        thread_ = std::thread { &AutoscanFanotify::threadProc, this };
+    }
+}
+
+void AutoscanFanotify::monitor(const std::shared_ptr<AutoscanDirectory>& dir)
+{
+    assert(dir->getScanMode() == ScanMode::INotify);
+    log_debug("Requested to monitor \"{}\"", dir->getLocation().c_str());
+    AutoLock lock(mutex);
+    monitorQueue.push(dir);
+    char stop = 'm';
+    if (write(stop_fd_write, &stop, 1) == -1) {
+        log_error("fanotify: could not wake up thread: {}", std::strerror(errno));
+    }
+}
+
+void AutoscanFanotify::unmonitor(const std::shared_ptr<AutoscanDirectory>& dir)
+{
+    // must not be persistent
+    assert(!dir->persistent());
+
+    log_debug("Requested to stop monitoring \"{}\"", dir->getLocation().c_str());
+    AutoLock lock(mutex);
+    unmonitorQueue.push(dir);
+    char stop = 'u';
+    if (write(stop_fd_write, &stop, 1) == -1) {
+        log_error("fanotify: could not wake up thread: {}", std::strerror(errno));
+    }
+}
+
+void AutoscanFanotify::threadProc()
+{
+    std::array<pollfd, 2> fds {};
+    fds[0].fd = fanotify_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = stop_fd_read;
+    fds[1].events = POLLIN;
+
+    while (!shutdownFlag) {
+        try {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!unmonitorQueue.empty()) {
+                auto adir = unmonitorQueue.front();
+                unmonitorQueue.pop();
+                lock.unlock();
+                removeDirectory(adir);
+                lock.lock();
+            }
+            while (!monitorQueue.empty()) {
+                auto adir = monitorQueue.front();
+                monitorQueue.pop();
+                lock.unlock();
+                addDirectory(adir);
+                lock.lock();
+            }
+            lock.unlock();
+
+            if (poll(fds.data(), fds.size(), changes->timeout()) < 0) {
+                if (errno != EINTR)
+                    log_error("fanotify: poll failed: {}", std::strerror(errno));
+                continue;
+            }
+
+            if (fds[1].revents & POLLIN) {
+                char buf[16];
+                if (read(stop_fd_read, buf, sizeof(buf)) == -1) {
+                    log_error("fanotify: could not read stop: {}", std::strerror(errno));
+                }
+            }
+
+            if (fds[0].revents & POLLIN) {
+                ssize_t len = read(fanotify_fd, buffer.data(), buffer.size());
+                if (len < 0) {
+                    if (errno != EAGAIN && errno != EINTR)
+                        log_error("fanotify: read failed: {}", std::strerror(errno));
+                    continue;
+                }
+                auto event = reinterpret_cast<fanotify_event_metadata*>(buffer.data());
+                for (; FAN_EVENT_OK(event, len); event = FAN_EVENT_NEXT(event, len)) {
+                    if (event->vers != FANOTIFY_METADATA_VERSION) {
+                        log_error("fanotify: unexpected metadata version {}", event->vers);
+                        break;
+                    }
+                    handleEvent(event);
+                }
+            }
+            changes->process(true);
+        } catch (const std::runtime_error& e) {
+            log_error("Fanotify thread caught exception: {}", e.what());
+        }
+    }
+}
+
+void AutoscanFanotify::addDirectory(const std::shared_ptr<AutoscanDirectory>& adir)
+{
+    fs::path location = adir->getLocation();
+    if (location.empty())
+        return;
+
+    std::error_code ec;
+    bool missing = !fs::is_directory(location, ec);
+    if (missing && !adir->persistent()) {
+        log_error("Failed to read {}: {}", location.c_str(), ec.message());
+        return;
+    }
+
+    // a missing location is watched on the filesystem of its first existing parent
+    auto markPath = location;
+    while (!fs::is_directory(markPath, ec) && markPath.has_relative_path())
+        markPath = markPath.parent_path();
+
+    std::uint64_t fsid;
+    if (!addMark(markPath, fsid))
+        return;
+
+    log_debug("Adding fanotify watch: {}", location.c_str());
+    directories.push_back({ adir, fsid, missing });
+    if (!missing)
+        content->rescanDirectory(adir, adir->getObjectID(), location, false);
+}
+
+void AutoscanFanotify::removeDirectory(const std::shared_ptr<AutoscanDirectory>& adir)
+{
+    auto entry = std::find_if(directories.begin(), directories.end(), [&](auto&& mon) { return mon.adir->getLocation() == adir->getLocation(); });
+    if (entry == directories.end()) {
+        log_debug("unmonitor called, but it isn't monitored? ({})", adir->getLocation().c_str());
+        return;
+    }
+    log_debug("Removing fanotify watch: {}", adir->getLocation().c_str());
+    auto fsid = entry->fsid;
+    directories.erase(entry);
+    removeMark(fsid);
+}
+
+bool AutoscanFanotify::addMark(const fs::path& path, std::uint64_t& fsid)
+{
+    struct statfs st;
+    if (statfs(path.c_str(), &st) < 0) {
+        log_error("Cannot watch {} with fanotify: {}", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    fsid = fsidKey(&st.f_fsid);
+
+    auto filesystem = filesystems.find(fsid);
+    if (filesystem != filesystems.end()) {
+        filesystem->second.users++;
+        return true;
+    }
+
+    int mountFd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (mountFd < 0) {
+        log_error("Cannot watch {} with fanotify: {}", path.c_str(), std::strerror(errno));
+        return false;
+    }
+    int result = fanotify_mark(fanotify_fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, eventMask, AT_FDCWD, path.c_str());
+    if (result < 0 && errno == EINVAL && (eventMask & FAN_RENAME)) {
+        // FAN_RENAME needs Linux 5.17, older kernels report renames as unrelated FAN_MOVED_FROM and FAN_MOVED_TO
+        eventMask = (eventMask & ~FAN_RENAME) | FAN_MOVED_FROM | FAN_MOVED_TO;
+        result = fanotify_mark(fanotify_fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, eventMask, AT_FDCWD, path.c_str());
+    }
+    if (result < 0) {
+        // e.g. EXDEV for btrfs subvolumes or ENODEV for filesystems without fsid
+        log_error("Cannot watch {} with fanotify: {}", path.c_str(), std::strerror(errno));
+        close(mountFd);
+        return false;
+    }
+    filesystems[fsid] = { mountFd, 1 };
+    return true;
+}
+
+void AutoscanFanotify::removeMark(std::uint64_t fsid)
+{
+    auto filesystem = filesystems.find(fsid);
+    if (filesystem == filesystems.end() || --filesystem->second.users > 0)
+        return;
+
+    if (fanotify_mark(fanotify_fd, FAN_MARK_REMOVE | FAN_MARK_FILESYSTEM, eventMask, filesystem->second.mountFd, nullptr) < 0) {
+        log_debug("Error removing fanotify mark: {}", std::strerror(errno));
+    }
+    close(filesystem->second.mountFd);
+    filesystems.erase(filesystem);
+    handleCache.clear();
+}
+
+void AutoscanFanotify::handleEvent(fanotify_event_metadata* event)
+{
+    auto mask = event->mask;
+    if (mask & FAN_Q_OVERFLOW) {
+        log_warning("fanotify event queue overflowed, rescanning all monitored directories");
+        rescanAll();
+        return;
+    }
+
+    bool isDir = mask & FAN_ONDIR;
+    // directory paths in the cache change with the directory
+    if (isDir && (mask & (FAN_DELETE | FAN_MOVED_FROM | FAN_RENAME)))
+        handleCache.clear();
+
+    // FAN_RENAME has a record for each side, everything else one for the parent directory
+    fs::path path;
+    fs::path oldPath;
+    auto info = reinterpret_cast<char*>(event) + event->metadata_len;
+    auto end = reinterpret_cast<char*>(event) + event->event_len;
+    while (info + sizeof(fanotify_event_info_fid) <= end) {
+        auto fid = reinterpret_cast<fanotify_event_info_fid*>(info);
+        if (fid->hdr.len == 0)
+            break;
+        if (fid->hdr.info_type == FAN_EVENT_INFO_TYPE_OLD_DFID_NAME)
+            oldPath = resolveEntry(fid);
+        else if (fid->hdr.info_type == FAN_EVENT_INFO_TYPE_DFID_NAME || fid->hdr.info_type == FAN_EVENT_INFO_TYPE_NEW_DFID_NAME)
+            path = resolveEntry(fid);
+        info += fid->hdr.len;
+    }
+    log_debug("fanotify event: 0x{:x} {} {}", mask, oldPath.c_str(), path.c_str());
+
+    if (!path.empty() && isDir && (mask & (FAN_CREATE | FAN_MOVED_TO | FAN_RENAME)))
+        recheckMissing(path);
+
+    if (mask & FAN_RENAME) {
+        auto oldDir = oldPath.empty() ? nullptr : getAppropriateAutoscan(oldPath);
+        auto newDir = path.empty() ? nullptr : getAppropriateAutoscan(path);
+        if (oldDir != nullptr && oldDir == newDir && oldPath != oldDir->getLocation()) {
+            if (++renameCookie == 0)
+                ++renameCookie;
+            changes->movedFrom(renameCookie, oldDir, oldPath, isDir);
+            changes->movedTo(renameCookie, newDir, path, isDir);
+            return;
+        }
+        if (oldDir != nullptr) {
+            removedLocation(oldDir, oldPath);
+            changes->push(oldDir, oldPath, isDir, true, false);
+        }
+        if (newDir != nullptr)
+            changes->push(newDir, path, isDir, false, true);
+        return;
+    }
+
+    if (path.empty())
+        return;
+    auto adir = getAppropriateAutoscan(path);
+    if (adir == nullptr)
+        return;
+
+    if (mask & (FAN_DELETE | FAN_MOVED_FROM))
+        removedLocation(adir, path);
+
+    // files are added once they are closed after writing
+    bool add = (mask & (FAN_MOVED_TO | FAN_CLOSE_WRITE)) || (isDir && (mask & FAN_CREATE));
+    if (add || (mask & (FAN_DELETE | FAN_MOVED_FROM)))
+        changes->push(adir, path, isDir, mask & (FAN_DELETE | FAN_MOVED_FROM | FAN_CLOSE_WRITE), add);
+}
+
+void AutoscanFanotify::removedLocation(const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& path)
+{
+    if (path != adir->getLocation() || !adir->persistent())
+        return;
+
+    auto mon = std::find_if(directories.begin(), directories.end(), [&](auto&& entry) { return entry.adir == adir; });
+    if (mon != directories.end())
+        mon->missing = true;
+    content->handlePeristentAutoscanRemove(adir);
+}
+
+fs::path AutoscanFanotify::resolveEntry(fanotify_event_info_fid* fid)
+{
+    auto handle = reinterpret_cast<file_handle*>(fid->handle);
+    std::string name = reinterpret_cast<const char*>(handle->f_handle + handle->handle_bytes);
+    if (name.empty() || name == ".")
+        return {};
+
+    auto dir = resolveDirectory(fsidKey(&fid->fsid), handle);
+    return dir.empty() ? dir : dir / name;
+}
+
+fs::path AutoscanFanotify::resolveDirectory(std::uint64_t fsid, const void* handle)
+{
+    auto filesystem = filesystems.find(fsid);
+    if (filesystem == filesystems.end())
+        return {};
+
+    auto fh = static_cast<const file_handle*>(handle);
+    auto key = std::string(static_cast<const char*>(handle), sizeof(file_handle) + fh->handle_bytes);
+    auto cached = handleCache.find(key);
+    if (cached != handleCache.end())
+        return cached->second;
+
+    int fd = open_by_handle_at(filesystem->second.mountFd, const_cast<file_handle*>(fh), O_PATH | O_CLOEXEC);
+    if (fd < 0) {
+        // ESTALE when the directory was removed before the event was read
+        if (errno != ESTALE)
+            log_debug("fanotify: cannot open directory handle: {}", std::strerror(errno));
+        return {};
+    }
+    std::error_code ec;
+    auto path = fs::read_symlink(fmt::format("/proc/self/fd/{}", fd), ec);
+    close(fd);
+    if (ec)
+        return {};
+
+    handleCache[key] = path;
+    return path;
+}
+
+std::shared_ptr<AutoscanDirectory> AutoscanFanotify::getAppropriateAutoscan(const fs::path& path) const
+{
+    std::shared_ptr<AutoscanDirectory> bestMatch;
+    std::size_t bestLength = 0;
+    for (auto&& mon : directories) {
+        fs::path location = mon.adir->getLocation();
+        if (mon.missing || !isInside(path, location) || location.native().length() < bestLength)
+            continue;
+        if (!mon.adir->getRecursive() && path != location && path.parent_path() != location)
+            continue;
+        if (!mon.adir->getHidden()) {
+            auto rel = path.lexically_relative(location);
+            if (std::any_of(rel.begin(), rel.end(), [](auto&& part) { return part.native().front() == '.' && part != "."; }))
+                continue;
+        }
+        bestMatch = mon.adir;
+        bestLength = location.native().length();
+    }
+    return bestMatch;
+}
+
+void AutoscanFanotify::recheckMissing(const fs::path& path)
+{
+    std::error_code ec;
+    for (auto&& mon : directories) {
+        fs::path location = mon.adir->getLocation();
+        if (mon.missing && isInside(location, path) && fs::is_directory(location, ec)) {
+            log_debug("Autoscan directory {} was created again", location.c_str());
+            mon.missing = false;
+            content->handlePersistentAutoscanRecreate(mon.adir);
+            content->rescanDirectory(mon.adir, mon.adir->getObjectID(), location, false);
+        }
+    }
+}
+
+void AutoscanFanotify::rescanAll()
+{
+    for (auto&& mon : directories) {
+        if (!mon.missing)
+            content->rescanDirectory(mon.adir, mon.adir->getObjectID(), mon.adir->getLocation(), false);
+    }
+}
+
+#endif // HAVE_FANOTIFY
@@ -0,0 +1,130 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    autoscan_fanotify.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file autoscan_fanotify.h
+#ifndef __AUTOSCAN_FANOTIFY_H__
+#define __AUTOSCAN_FANOTIFY_H__
+
+#ifdef HAVE_FANOTIFY
+
+#include <array>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "autoscan.h"
+#include "autoscan_change_queue.h"
+#include "config/config.h"
+#include "context.h"
+
+// forward declaration
+class ContentManager;
+struct fanotify_event_metadata;
+struct fanotify_event_info_fid;
+
+/// \brief Watches autoscan directories with one fanotify mark per filesystem
+///
+/// Needs Linux 5.9 or later and CAP_SYS_ADMIN. Changes are reported by parent directory and name,
+/// so new subdirectories need no setup and the number of directories is not limited by max_user_watches.
+class AutoscanFanotify : public AutoscanMonitor {
+public:
+    /// \brief throws if fanotify is not available to the process
+    explicit AutoscanFanotify(std::shared_ptr<ContentManager> content);
+    ~AutoscanFanotify() override;
+
+    void run() override;
+
+    /// \brief Start monitoring a directory
+    void monitor(const std::shared_ptr<AutoscanDirectory>& dir) override;
+
+    /// \brief Stop monitoring a directory
+    void unmonitor(const std::shared_ptr<AutoscanDirectory>& dir) override;
+
+private:
+    std::shared_ptr<Config> config;
+    std::shared_ptr<Database> database;
+    std::shared_ptr<ContentManager> content;
+
+    void threadProc();
+
+    std::thread thread_;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+
+    std::queue<std::shared_ptr<AutoscanDirectory>> monitorQueue;
+    std::queue<std::shared_ptr<AutoscanDirectory>> unmonitorQueue;
+    std::unique_ptr<AutoscanChangeQueue> changes;
+
+    int fanotify_fd;
+    /// \brief events requested for the marks, FAN_RENAME is replaced on kernels without it
+    std::uint64_t eventMask;
+    /// \brief pairs the two sides of a FAN_RENAME in the change queue
+    std::uint32_t renameCookie { 0 };
+    int stop_fd_read;
+    int stop_fd_write;
+    alignas(8) std::array<char, 65536> buffer;
+
+    /// \brief mark shared by all autoscan directories on one filesystem
+    struct Filesystem {
+        /// \brief directory on the filesystem for open_by_handle_at()
+        int mountFd;
+        int users;
+    };
+    std::map<std::uint64_t, Filesystem> filesystems;
+
+    struct Monitored {
+        std::shared_ptr<AutoscanDirectory> adir;
+        std::uint64_t fsid;
+        /// \brief persistent directory that is waiting to be created again
+        bool missing;
+    };
+    std::vector<Monitored> directories;
+
+    /// \brief paths of directory handles seen in events, cleared when a directory is moved or deleted
+    std::unordered_map<std::string, fs::path> handleCache;
+
+    void addDirectory(const std::shared_ptr<AutoscanDirectory>& adir);
+    void removeDirectory(const std::shared_ptr<AutoscanDirectory>& adir);
+    bool addMark(const fs::path& path, std::uint64_t& fsid);
+    void removeMark(std::uint64_t fsid);
+
+    void handleEvent(fanotify_event_metadata* event);
+    void removedLocation(const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& path);
+    fs::path resolveEntry(fanotify_event_info_fid* fid);
+    fs::path resolveDirectory(std::uint64_t fsid, const void* handle);
+    std::shared_ptr<AutoscanDirectory> getAppropriateAutoscan(const fs::path& path) const;
+    void recheckMissing(const fs::path& path);
+    void rescanAll();
+
+    /// \brief is set to true by the destructor if the fanotify thread should terminate
+    bool shutdownFlag;
+};
+
+#endif // HAVE_FANOTIFY
+
+#endif // __AUTOSCAN_FANOTIFY_H__
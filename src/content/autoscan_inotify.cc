@@ -32,6 +32,7 @@
 #ifdef HAVE_INOTIFY
 #include "autoscan_inotify.h" // API
 
+#include <algorithm>
 #include <cassert>
 
 #include "content_manager.h"
@@ -54,7 +55,7 @@ AutoscanInotify::AutoscanInotify(std::shared_ptr<ContentManager> content)
         }
     }
 
-    watches = std::make_unique<std::unordered_map<int, std::shared_ptr<Wd>>>();
+    changes = std::make_unique<AutoscanChangeQueue>(this->content);
     shutdownFlag = true;
     events = IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT;
 }
@@ -70,7 +71,7 @@ AutoscanInotify::~AutoscanInotify()
         thread_.join();
         log_debug("inotify thread died.");
         inotify = nullptr;
-        watches->clear();
+        watches.clear();
     }
 }
 
@@ -147,8 +148,8 @@ void AutoscanInotify::threadProc()
 
             lock.unlock();
 
-            /* --- get event --- (blocking) */
-            inotify_event* event = inotify->nextEvent();
+            /* --- get event --- (blocking until the next change settles) */
+            inotify_event* event = inotify->nextEvent(changes->timeout());
             /* --- */
 
             if (event) {
@@ -157,24 +158,20 @@ void AutoscanInotify::threadProc()
                 std::string name = event->name;
                 log_debug("inotify event: {} 0x{:x} {}", wd, mask, name.c_str());
 
-                std::shared_ptr<Wd> wdObj = nullptr;
-                try {
-                    wdObj = watches->at(wd);
-                } catch (const std::out_of_range& ex) {
+                auto entry = watches.find(wd);
+                if (entry == watches.end()) {
                     inotify->removeWatch(wd);
                     continue;
                 }
+                // new watches are added while handling the event, the entry stays where it is until it is erased below
+                auto& wdObj = entry->second;
 
-                fs::path path = wdObj->getPath();
+                fs::path path = wdObj.path;
                 if (!(mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)))
                     path /= name;
 
-                std::shared_ptr<AutoscanDirectory> adir;
                 auto watchAs = getAppropriateAutoscan(wdObj, path);
-                if (watchAs != nullptr)
-                    adir = watchAs->getAutoscanDirectory();
-                else
-                    adir = nullptr;
+                auto adir = watchAs != nullptr ? watchAs->adir : nullptr;
 
                 if (mask & IN_MOVE_SELF) {
                     checkMoveWatches(wd, wdObj);
@@ -206,42 +203,39 @@ void AutoscanInotify::threadProc()
                     }
                 }
 
-                if (adir != nullptr && mask & (IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_UNMOUNT | IN_CREATE)) {
-                    if (!(mask & (IN_MOVED_TO | IN_CREATE))) {
-                        log_debug("deleting {}", path.c_str());
-
-                        if (mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)) {
-                            if (mask & IN_MOVE_SELF)
-                                inotify->removeWatch(wd);
-                            auto watch = getStartPoint(wdObj);
-                            if (watch != nullptr) {
-                                if (adir->persistent()) {
-                                    monitorNonexisting(path, watch->getAutoscanDirectory());
-                                    content->handlePeristentAutoscanRemove(adir);
-                                }
-                            }
+                if (adir != nullptr && mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT)) {
+                    if (mask & IN_MOVE_SELF)
+                        inotify->removeWatch(wd);
+                    auto watch = getStartPoint(wdObj);
+                    if (watch != nullptr) {
+                        if (adir->persistent()) {
+                            auto startAdir = watch->adir;
+                            monitorNonexisting(path, startAdir);
+                            content->handlePeristentAutoscanRemove(adir);
                         }
+                    }
 
+                    // the object of a paired rename is moved by the change queue
+                    if (!changes->isMoveSource(path)) {
+                        log_debug("deleting {}", path.c_str());
                         int objectID = database->findObjectIDByPath(path, !(mask & IN_ISDIR));
                         if (objectID != INVALID_OBJECT_ID)
-                            content->removeObject(adir, objectID, !(mask & IN_MOVED_TO));
+                            content->removeObject(adir, objectID, true);
                     }
-                    if (mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)) {
-                        log_debug("Adding {}", path.c_str());
+                }
+                if (adir != nullptr && mask & (IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE)) {
+                    bool isDir = mask & IN_ISDIR;
+                    if (mask & IN_MOVED_FROM)
+                        changes->movedFrom(event->cookie, adir, path, isDir);
+                    else if (mask & IN_MOVED_TO)
+                        changes->movedTo(event->cookie, adir, path, isDir);
+                    else
+                        changes->push(adir, path, isDir, mask & (IN_DELETE | IN_CLOSE_WRITE), !(mask & IN_DELETE));
+
+                    if (isDir && (mask & (IN_MOVED_TO | IN_CREATE))) {
                         auto dirEnt = fs::directory_entry(path, ec);
                         if (!ec) {
-                            AutoScanSetting asSetting;
-                            asSetting.adir = adir;
-                            asSetting.followSymlinks = config->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS);
-                            asSetting.recursive = adir->getRecursive();
-                            asSetting.hidden = adir->getHidden();
-                            asSetting.rescanResource = true;
-                            asSetting.mergeOptions(config, path);
-                            // path, recursive, async, hidden, rescanResource, low priority, cancellable
-                            content->addFile(dirEnt, adir->getLocation(), asSetting, true, true, false);
-                            if (mask & IN_ISDIR) {
-                                monitorUnmonitorRecursive(dirEnt, false, adir, false, asSetting.followSymlinks);
-                            }
+                            monitorUnmonitorRecursive(dirEnt, false, adir, false, config->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS));
                         } else {
                             log_error("Failed to read {}: {}", path.c_str(), ec.message());
                         }
@@ -250,9 +244,10 @@ void AutoscanInotify::threadProc()
                 if (mask & IN_IGNORED) {
                     removeWatchMoves(wd);
                     removeDescendants(wd);
-                    watches->erase(wd);
+                    watches.erase(wd);
                 }
             }
+            changes->process(event == nullptr);
         } catch (const std::runtime_error& e) {
             log_error("Inotify thread caught exception: {}", e.what());
         }
@@ -298,34 +293,21 @@ int AutoscanInotify::addMoveWatch(const fs::path& path, int removeWd, int parent
 {
     int wd = inotify->addWatch(path, events);
     if (wd >= 0) {
-        bool alreadyThere = false;
-
-        std::shared_ptr<Wd> wdObj = nullptr;
-        try {
-            wdObj = watches->at(wd);
-
-            int parentWdSet = wdObj->getParentWd();
-            if (parentWdSet >= 0) {
-                if (parentWd != parentWdSet) {
-                    log_debug("error: parentWd doesn't match wd: {}, parent is: {}, should be: {}", wd, parentWdSet, parentWd);
-                    wdObj->setParentWd(parentWd);
+        auto entry = watches.find(wd);
+        if (entry != watches.end()) {
+            auto& wdObj = entry->second;
+            if (wdObj.parentWd >= 0) {
+                if (parentWd != wdObj.parentWd) {
+                    log_debug("error: parentWd doesn't match wd: {}, parent is: {}, should be: {}", wd, wdObj.parentWd, parentWd);
+                    wdObj.parentWd = parentWd;
                 }
             } else
-                wdObj->setParentWd(parentWd);
-
-            //find
-            //alreadyThere =...
-            //FIXME: not finished?
-
-        } catch (const std::out_of_range& ex) {
-            wdObj = std::make_shared<Wd>(path, wd, parentWd);
-            watches->emplace(wd, wdObj);
+                wdObj.parentWd = parentWd;
+        } else {
+            entry = watches.emplace(wd, Wd { path, parentWd, {} }).first;
         }
 
-        if (!alreadyThere) {
-            auto watch = std::make_shared<WatchMove>(removeWd);
-            wdObj->addWatch(watch);
-        }
+        entry->second.watches.emplace_back(removeWd);
     }
     return wd;
 }
@@ -355,8 +337,11 @@ void AutoscanInotify::recheckNonexistingMonitor(int curWd, const std::vector<std
         bool pathExists = fs::is_directory(path);
         //        log_debug("checking {}: {}", path.c_str(), pathExists);
         if (pathExists) {
-            if (curWd != -1)
-                removeNonexistingMonitor(curWd, watches->at(curWd), pathAr);
+            if (curWd != -1) {
+                auto entry = watches.find(curWd);
+                if (entry != watches.end())
+                    removeNonexistingMonitor(curWd, entry->second, pathAr);
+            }
             if (first) {
                 monitorDirectory(path, adir, true);
                 content->handlePersistentAutoscanRecreate(adir);
@@ -370,85 +355,62 @@ void AutoscanInotify::recheckNonexistingMonitor(int curWd, const std::vector<std
     }
 }
 
-void AutoscanInotify::checkMoveWatches(int wd, const std::shared_ptr<Wd>& wdObj)
+void AutoscanInotify::checkMoveWatches(int wd, Wd& wdObj)
 {
-    auto wdWatches = wdObj->getWdWatches();
-    for (auto it = wdWatches->begin(); it != wdWatches->end(); /*++it*/) {
-        auto& watchToCheck = *it;
-        if (watchToCheck->getType() == WatchType::Move) {
-            if (wdWatches->size() == 1) {
-                inotify->removeWatch(wd);
-                ++it;
-            } else {
-                it = wdWatches->erase(it);
-            }
+    std::vector<int> removeWds;
+    for (std::size_t i = 0; i < wdObj.watches.size();) {
+        if (wdObj.watches[i].type == WatchType::Move) {
+            removeWds.push_back(wdObj.watches[i].removeWd);
+            if (dropWatch(wd, wdObj, i))
+                continue;
+        }
+        ++i;
+    }
 
-            auto watchMv = std::static_pointer_cast<WatchMove>(watchToCheck);
-            int removeWd = watchMv->getRemoveWd();
-            try {
-                auto wdToRemove = watches->at(removeWd);
+    for (int removeWd : removeWds) {
+        auto entry = watches.find(removeWd);
+        if (entry == watches.end())
+            continue;
+        auto& wdToRemove = entry->second;
 
-                recheckNonexistingMonitors(removeWd, wdToRemove);
+        recheckNonexistingMonitors(removeWd, wdToRemove);
 
-                fs::path path = wdToRemove->getPath();
-                log_debug("found wd to remove because of move event: {} {}", removeWd, path.c_str());
+        fs::path path = wdToRemove.path;
+        log_debug("found wd to remove because of move event: {} {}", removeWd, path.c_str());
 
-                inotify->removeWatch(removeWd);
-                auto watchToRemove = getStartPoint(wdToRemove);
-                if (watchToRemove != nullptr) {
-                    std::shared_ptr<AutoscanDirectory> adir = watchToRemove->getAutoscanDirectory();
-                    if (adir->persistent()) {
-                        monitorNonexisting(path, adir);
-                        content->handlePeristentAutoscanRemove(adir);
-                    }
+        inotify->removeWatch(removeWd);
+        auto watchToRemove = getStartPoint(wdToRemove);
+        if (watchToRemove != nullptr) {
+            auto adir = watchToRemove->adir;
+            if (adir->persistent()) {
+                monitorNonexisting(path, adir);
+                content->handlePeristentAutoscanRemove(adir);
+            }
 
-                    int objectID = database->findObjectIDByPath(path, true);
-                    if (objectID != INVALID_OBJECT_ID)
-                        content->removeObject(adir, objectID, false);
-                }
-            } catch (const std::out_of_range& ex) {
-            } // Not found in map
-        } else
-            ++it;
+            int objectID = database->findObjectIDByPath(path, true);
+            if (objectID != INVALID_OBJECT_ID)
+                content->removeObject(adir, objectID, false);
+        }
     }
 }
 
-void AutoscanInotify::recheckNonexistingMonitors(int wd, const std::shared_ptr<Wd>& wdObj)
+void AutoscanInotify::recheckNonexistingMonitors(int wd, const Wd& wdObj)
 {
-    auto wdWatches = wdObj->getWdWatches();
-    for (const auto& watch : *wdWatches) {
-        if (watch->getType() == WatchType::Autoscan) {
-            auto watchAs = std::static_pointer_cast<WatchAutoscan>(watch);
-            auto pathAr = watchAs->getNonexistingPathArray();
-            if (!pathAr.empty()) {
-                recheckNonexistingMonitor(wd, pathAr, watchAs->getAutoscanDirectory());
-            }
-        }
+    // rechecking removes the watches it is done for
+    std::vector<std::pair<std::vector<std::string>, std::shared_ptr<AutoscanDirectory>>> nonexisting;
+    for (auto&& watch : wdObj.watches) {
+        if (watch.type == WatchType::Autoscan && !watch.nonexistingPathArray.empty())
+            nonexisting.emplace_back(watch.nonexistingPathArray, watch.adir);
     }
+    for (auto&& [pathAr, adir] : nonexisting)
+        recheckNonexistingMonitor(wd, pathAr, adir);
 }
 
-void AutoscanInotify::removeNonexistingMonitor(int wd, const std::shared_ptr<Wd>& wdObj, const std::vector<std::string>& pathAr)
+void AutoscanInotify::removeNonexistingMonitor(int wd, Wd& wdObj, const std::vector<std::string>& pathAr)
 {
-    auto wdWatches = wdObj->getWdWatches();
-    for (auto it = wdWatches->begin(); it != wdWatches->end(); /*++it*/) {
-        auto& watch = *it;
-        if (watch->getType() == WatchType::Autoscan) {
-            auto watchAs = std::static_pointer_cast<WatchAutoscan>(watch);
-            if (watchAs->getNonexistingPathArray() == pathAr) {
-                if (wdWatches->size() == 1) {
-                    // should be done automatically, because removeWatch triggers an IGNORED event
-                    //watches->remove(wd);
-
-                    inotify->removeWatch(wd);
-                    ++it;
-                } else {
-                    it = wdWatches->erase(it);
-                }
-                return;
-            }
-        } else
-            ++it;
-    }
+    auto watch = std::find_if(wdObj.watches.begin(), wdObj.watches.end(), [&](auto&& w) { return w.type == WatchType::Autoscan && w.nonexistingPathArray == pathAr; });
+    if (watch != wdObj.watches.end())
+        dropWatch(wd, wdObj, watch - wdObj.watches.begin());
 }
 
 void AutoscanInotify::monitorUnmonitorRecursive(const fs::directory_entry& startPath, bool unmonitor, const std::shared_ptr<AutoscanDirectory>& adir, bool startPoint, bool followSymlinks)
@@ -503,11 +465,11 @@ int AutoscanInotify::monitorDirectory(const fs::path& path, const std::shared_pt
         if (startPoint)
             parentWd = watchPathForMoves(path, wd);
 
-        std::shared_ptr<Wd> wdObj = nullptr;
-        try {
-            wdObj = watches->at(wd);
-            if (parentWd >= 0 && wdObj->getParentWd() < 0) {
-                wdObj->setParentWd(parentWd);
+        auto entry = watches.find(wd);
+        if (entry != watches.end()) {
+            auto& wdObj = entry->second;
+            if (parentWd >= 0 && wdObj.parentWd < 0) {
+                wdObj.parentWd = parentWd;
             }
 
             if (pathArray == nullptr)
@@ -515,23 +477,19 @@ int AutoscanInotify::monitorDirectory(const fs::path& path, const std::shared_pt
 
             // should we check for already existing "nonexisting" watches?
             // ...
-        } catch (const std::out_of_range& ex) {
-            wdObj = std::make_shared<Wd>(path, wd, parentWd);
-            watches->emplace(wd, wdObj);
+        } else {
+            entry = watches.emplace(wd, Wd { path, parentWd, {} }).first;
         }
 
         if (!alreadyWatching) {
-            auto watch = std::make_shared<WatchAutoscan>(startPoint, adir);
-            if (pathArray != nullptr) {
-                watch->setNonexistingPathArray(*pathArray);
-            }
-            wdObj->addWatch(watch);
-
+            int startPointWd = INOTIFY_ROOT;
             if (!startPoint) {
-                int startPointWd = inotify->addWatch(adir->getLocation(), events);
+                startPointWd = inotify->addWatch(adir->getLocation(), events);
                 log_debug("getting start point for {} -> {} wd={}", path.c_str(), adir->getLocation().c_str(), startPointWd);
-                if (wd >= 0)
-                    addDescendant(startPointWd, wd, adir);
+            }
+            auto& watch = entry->second.watches.emplace_back(adir, startPoint, startPointWd);
+            if (pathArray != nullptr) {
+                watch.nonexistingPathArray = *pathArray;
             }
         }
     }
@@ -551,64 +509,40 @@ void AutoscanInotify::unmonitorDirectory(const fs::path& path, const std::shared
         return;
     }
 
-    auto wdObj = watches->at(wd);
-    if (wdObj == nullptr) {
+    auto entry = watches.find(wd);
+    if (entry == watches.end()) {
         log_error("wd not found in watches!? ({}, {})", wd, path.c_str());
         return;
     }
+    auto& wdObj = entry->second;
 
     auto watchAs = getAppropriateAutoscan(wdObj, adir);
     if (watchAs == nullptr) {
         log_debug("autoscan not found in watches? ({}, {})", wd, path.c_str());
     } else {
-        if (wdObj->getWdWatches()->size() == 1) {
-            // should be done automatically, because removeWatch triggers an IGNORED event
-            //watches->remove(wd);
-
-            inotify->removeWatch(wd);
-        } else {
-            removeFromWdObj(wdObj, watchAs);
-        }
+        dropWatch(wd, wdObj, watchAs - wdObj.watches.data());
     }
 }
 
-std::shared_ptr<AutoscanInotify::WatchAutoscan> AutoscanInotify::getAppropriateAutoscan(const std::shared_ptr<Wd>& wdObj, const std::shared_ptr<AutoscanDirectory>& adir)
+const AutoscanInotify::Watch* AutoscanInotify::getAppropriateAutoscan(const Wd& wdObj, const std::shared_ptr<AutoscanDirectory>& adir)
 {
-    auto wdWatches = wdObj->getWdWatches();
-    for (const auto& watch : *wdWatches) {
-        if (watch->getType() == WatchType::Autoscan) {
-            auto watchAs = std::static_pointer_cast<WatchAutoscan>(watch);
-            if (watchAs->getNonexistingPathArray().empty()) {
-                if (watchAs->getAutoscanDirectory()->getLocation() == adir->getLocation()) {
-                    return watchAs;
-                }
-            }
-        }
+    for (auto&& watch : wdObj.watches) {
+        if (watch.type == WatchType::Autoscan && watch.nonexistingPathArray.empty() && watch.adir->getLocation() == adir->getLocation())
+            return &watch;
     }
     return nullptr;
 }
 
-std::shared_ptr<AutoscanInotify::WatchAutoscan> AutoscanInotify::getAppropriateAutoscan(const std::shared_ptr<Wd>& wdObj, const fs::path& path)
+const AutoscanInotify::Watch* AutoscanInotify::getAppropriateAutoscan(const Wd& wdObj, const fs::path& path)
 {
-    fs::path pathBestMatch;
-    std::shared_ptr<WatchAutoscan> bestMatch = nullptr;
-    auto wdWatches = wdObj->getWdWatches();
-    for (const auto& watch : *wdWatches) {
-        if (watch->getType() == WatchType::Autoscan) {
-            auto watchAs = std::static_pointer_cast<WatchAutoscan>(watch);
-            if (watchAs->getNonexistingPathArray().empty()) {
-                fs::path testLocation = watchAs->getAutoscanDirectory()->getLocation();
-                if (startswith(path, testLocation)) {
-                    if (!pathBestMatch.empty()) {
-                        if (pathBestMatch.string().length() < testLocation.string().length()) {
-                            pathBestMatch = testLocation;
-                            bestMatch = watchAs;
-                        }
-                    } else {
-                        pathBestMatch = testLocation;
-                        bestMatch = watchAs;
-                    }
-                }
+    std::size_t bestLength = 0;
+    const Watch* bestMatch = nullptr;
+    for (auto&& watch : wdObj.watches) {
+        if (watch.type == WatchType::Autoscan && watch.nonexistingPathArray.empty()) {
+            const auto& testLocation = watch.adir->getLocation().native();
+            if (startswith(path, testLocation) && (bestMatch == nullptr || bestLength < testLocation.length())) {
+                bestLength = testLocation.length();
+                bestMatch = &watch;
             }
         }
     }
@@ -620,109 +554,57 @@ void AutoscanInotify::removeWatchMoves(int wd)
     bool first = true;
     int checkWd = wd;
     do {
-        std::shared_ptr<Wd> wdObj = nullptr;
-        try {
-            wdObj = watches->at(checkWd);
-        } catch (const std::out_of_range& ex) {
+        auto entry = watches.find(checkWd);
+        if (entry == watches.end())
             break;
-        }
 
-        auto wdWatches = wdObj->getWdWatches();
-        if (wdWatches->empty())
+        auto& wdObj = entry->second;
+        if (wdObj.watches.empty())
             break;
 
         if (first) {
             first = false;
         } else {
-            for (auto it = wdWatches->begin(); it != wdWatches->end(); /*++it*/) {
-                auto& watch = *it;
-                if (watch->getType() == WatchType::Move) {
-                    auto watchMv = std::static_pointer_cast<WatchMove>(watch);
-                    if (watchMv->getRemoveWd() == wd) {
-                        log_debug("removing watch move");
-                        if (wdWatches->size() == 1) {
-                            inotify->removeWatch(checkWd);
-                            ++it;
-                        } else
-                            it = wdWatches->erase(it);
-                    } else
-                        ++it;
+            for (std::size_t i = 0; i < wdObj.watches.size();) {
+                if (wdObj.watches[i].type == WatchType::Move && wdObj.watches[i].removeWd == wd) {
+                    log_debug("removing watch move");
+                    if (dropWatch(checkWd, wdObj, i))
+                        continue;
                 }
+                ++i;
             }
         }
-        checkWd = wdObj->getParentWd();
+        checkWd = wdObj.parentWd;
     } while (checkWd >= 0);
 }
 
-bool AutoscanInotify::removeFromWdObj(const std::shared_ptr<Wd>& wdObj, const std::shared_ptr<Watch>& toRemove)
+bool AutoscanInotify::dropWatch(int wd, Wd& wdObj, std::size_t index)
 {
-    auto wdWatches = wdObj->getWdWatches();
-    for (auto it = wdWatches->begin(); it != wdWatches->end(); /*++it*/) {
-        auto& watch = *it;
-        if (watch == toRemove) {
-            if (wdWatches->size() == 1) {
-                inotify->removeWatch(wdObj->getWd());
-                ++it;
-            } else
-                it = wdWatches->erase(it);
-            return true;
-        }
-        ++it;
+    if (wdObj.watches.size() == 1) {
+        // the entry is erased with the IN_IGNORED event
+        inotify->removeWatch(wd);
+        return false;
     }
-    return false;
+    wdObj.watches.erase(wdObj.watches.begin() + index);
+    return true;
 }
 
-std::shared_ptr<AutoscanInotify::WatchAutoscan> AutoscanInotify::getStartPoint(const std::shared_ptr<Wd>& wdObj)
+const AutoscanInotify::Watch* AutoscanInotify::getStartPoint(const Wd& wdObj)
 {
-    auto wdWatches = wdObj->getWdWatches();
-    for (const auto& watch : *wdWatches) {
-        if (watch->getType() == WatchType::Autoscan) {
-            auto watchAs = std::static_pointer_cast<WatchAutoscan>(watch);
-            if (watchAs->isStartPoint())
-                return watchAs;
-        }
-    }
-    return nullptr;
-}
-
-void AutoscanInotify::addDescendant(int startPointWd, int addWd, const std::shared_ptr<AutoscanDirectory>& adir)
-{
-    //    log_debug("called for {}, (adir->path={}); adding {}", startPointWd, adir->getLocation().c_str(), addWd);
-    std::shared_ptr<Wd> wdObj = nullptr;
-    try {
-        wdObj = watches->at(startPointWd);
-    } catch (const std::out_of_range& ex) {
-        return;
-    }
-    if (wdObj == nullptr)
-        return;
-
-    //   log_debug("found wdObj");
-    auto watch = getAppropriateAutoscan(wdObj, adir);
-    if (watch == nullptr)
-        return;
-    //    log_debug("adding descendant");
-    watch->addDescendant(addWd);
-    //    log_debug("added descendant to {} (adir->path={}): {}; now: {}", startPointWd, adir->getLocation().c_str(), addWd, watch->getDescendants()->toCSV().c_str());
+    auto watch = std::find_if(wdObj.watches.begin(), wdObj.watches.end(), [](auto&& w) { return w.type == WatchType::Autoscan && w.startPoint; });
+    return watch != wdObj.watches.end() ? &*watch : nullptr;
 }
 
 void AutoscanInotify::removeDescendants(int wd)
 {
-    std::shared_ptr<Wd> wdObj = nullptr;
-    try {
-        wdObj = watches->at(wd);
-    } catch (const std::out_of_range& ex) {
+    auto entry = watches.find(wd);
+    if (entry == watches.end() || getStartPoint(entry->second) == nullptr)
         return;
-    }
 
-    auto wdWatches = wdObj->getWdWatches();
-    for (const auto& watch : *wdWatches) {
-        if (watch->getType() == WatchType::Autoscan) {
-            auto watchAs = std::static_pointer_cast<WatchAutoscan>(watch);
-            for (int descWd : watchAs->getDescendants()) {
-                inotify->removeWatch(descWd);
-            }
-        }
+    // start points are removed rarely, their subdirectories link to them instead of being listed
+    for (auto&& [descWd, descObj] : watches) {
+        if (std::any_of(descObj.watches.begin(), descObj.watches.end(), [=](auto&& w) { return w.type == WatchType::Autoscan && w.startPointWd == wd; }))
+            inotify->removeWatch(descWd);
     }
 }
 
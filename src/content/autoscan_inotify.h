@@ -39,6 +39,7 @@
 #include <vector>
 
 #include "autoscan.h"
+#include "autoscan_change_queue.h"
 #include "config/config.h"
 #include "context.h"
 #include "util/mt_inotify.h"
@@ -49,18 +50,18 @@ class ContentManager;
 #define INOTIFY_ROOT (-1)
 #define INOTIFY_UNKNOWN_PARENT_WD (-2)
 
-class AutoscanInotify {
+class AutoscanInotify : public AutoscanMonitor {
 public:
     explicit AutoscanInotify(std::shared_ptr<ContentManager> content);
-    ~AutoscanInotify();
+    ~AutoscanInotify() override;
 
-    void run();
+    void run() override;
 
     /// \brief Start monitoring a directory
-    void monitor(const std::shared_ptr<AutoscanDirectory>& dir);
+    void monitor(const std::shared_ptr<AutoscanDirectory>& dir) override;
 
     /// \brief Stop monitoring a directory
-    void unmonitor(const std::shared_ptr<AutoscanDirectory>& dir);
+    void unmonitor(const std::shared_ptr<AutoscanDirectory>& dir) override;
 
 private:
     std::shared_ptr<Config> config;
@@ -72,6 +73,7 @@ private:
     std::thread thread_;
 
     std::unique_ptr<Inotify> inotify;
+    std::unique_ptr<AutoscanChangeQueue> changes;
 
     std::mutex mutex;
     using AutoLock = std::lock_guard<std::mutex>;
@@ -87,103 +89,68 @@ private:
         Move
     };
 
-    class Watch {
-    public:
-        explicit Watch(WatchType type)
+    /// \brief one reason to watch a directory, stored in the Wd of the directory
+    struct Watch {
+        Watch(std::shared_ptr<AutoscanDirectory> adir, bool startPoint, int startPointWd)
+            : type(WatchType::Autoscan)
+            , adir(std::move(adir))
+            , startPoint(startPoint)
+            , startPointWd(startPointWd)
         {
-            this->type = type;
         }
-        WatchType getType() const { return type; }
-
-    private:
-        WatchType type;
-    };
-
-    class WatchAutoscan : public Watch {
-    public:
-        WatchAutoscan(bool startPoint, std::shared_ptr<AutoscanDirectory> adir)
-            : Watch(WatchType::Autoscan)
+        explicit Watch(int removeWd)
+            : type(WatchType::Move)
+            , removeWd(removeWd)
         {
-            this->adir = std::move(adir);
-            this->startPoint = startPoint;
         }
-        std::shared_ptr<AutoscanDirectory> getAutoscanDirectory() const { return adir; }
-        bool isStartPoint() const { return startPoint; }
-        std::vector<std::string> getNonexistingPathArray() const { return nonexistingPathArray; }
-        void setNonexistingPathArray(const std::vector<std::string>& nonexistingPathArray) { this->nonexistingPathArray = nonexistingPathArray; }
-        void addDescendant(int wd)
-        {
-            descendants.push_back(wd);
-        }
-        const std::vector<int>& getDescendants() const { return descendants; }
 
-    private:
+        WatchType type;
+        /// \brief Autoscan: the autoscan directory the directory belongs to
         std::shared_ptr<AutoscanDirectory> adir;
-        bool startPoint;
-        std::vector<int> descendants;
+        /// \brief Autoscan: the directory is the location of adir
+        bool startPoint { false };
+        /// \brief Autoscan: wd of the location of adir, the watches of the subdirectories are removed with it
+        int startPointWd { INOTIFY_ROOT };
+        /// \brief Move: wd of the start point that is gone when this parent directory is moved
+        int removeWd { INOTIFY_ROOT };
+        /// \brief Autoscan: the missing location of a persistent autoscan this parent is watched for
         std::vector<std::string> nonexistingPathArray;
     };
 
-    class WatchMove : public Watch {
-    public:
-        explicit WatchMove(int removeWd)
-            : Watch(WatchType::Move)
-        {
-            this->removeWd = removeWd;
-        }
-        int getRemoveWd() const { return removeWd; }
-
-    private:
-        int removeWd;
-    };
-
-    class Wd {
-    public:
-        Wd(fs::path path, int wd, int parentWd)
-            : wdWatches(std::make_shared<std::vector<std::shared_ptr<Watch>>>())
-        {
-            this->path = std::move(path);
-            this->wd = wd;
-            this->parentWd = parentWd;
-        }
-        fs::path getPath() const { return path; }
-        int getWd() const { return wd; }
-        int getParentWd() const { return parentWd; }
-        void setParentWd(int parentWd) { this->parentWd = parentWd; }
-
-        std::shared_ptr<std::vector<std::shared_ptr<Watch>>> getWdWatches() const { return wdWatches; }
-        void addWatch(const std::shared_ptr<Watch>& w) { wdWatches->push_back(w); }
-
-    private:
-        std::shared_ptr<std::vector<std::shared_ptr<Watch>>> wdWatches;
+    /// \brief a watched directory
+    struct Wd {
         fs::path path;
         int parentWd;
-        int wd;
+        std::vector<Watch> watches;
     };
 
-    std::unique_ptr<std::unordered_map<int, std::shared_ptr<Wd>>> watches;
+    /// \brief the watched directories by their watch descriptor
+    std::unordered_map<int, Wd> watches;
 
     void monitorUnmonitorRecursive(const fs::directory_entry& startPath, bool unmonitor, const std::shared_ptr<AutoscanDirectory>& adir, bool startPoint, bool followSymlinks);
     int monitorDirectory(const fs::path& path, const std::shared_ptr<AutoscanDirectory>& adir, bool startPoint, const std::vector<std::string>* pathArray = nullptr);
     void unmonitorDirectory(const fs::path& path, const std::shared_ptr<AutoscanDirectory>& adir);
 
-    static std::shared_ptr<WatchAutoscan> getAppropriateAutoscan(const std::shared_ptr<Wd>& wdObj, const std::shared_ptr<AutoscanDirectory>& adir);
-    static std::shared_ptr<WatchAutoscan> getAppropriateAutoscan(const std::shared_ptr<Wd>& wdObj, const fs::path& path);
-    static std::shared_ptr<WatchAutoscan> getStartPoint(const std::shared_ptr<Wd>& wdObj);
+    static const Watch* getAppropriateAutoscan(const Wd& wdObj, const std::shared_ptr<AutoscanDirectory>& adir);
+    static const Watch* getAppropriateAutoscan(const Wd& wdObj, const fs::path& path);
+    static const Watch* getStartPoint(const Wd& wdObj);
 
-    bool removeFromWdObj(const std::shared_ptr<Wd>& wdObj, const std::shared_ptr<Watch>& toRemove);
+    /// \brief remove the watch at index, the last one of the directory is kept until the IN_IGNORED event of removing the inotify watch
+    ///
+    /// \return whether the watch was erased from wdObj
+    bool dropWatch(int wd, Wd& wdObj, std::size_t index);
 
     void monitorNonexisting(const fs::path& path, const std::shared_ptr<AutoscanDirectory>& adir);
     void recheckNonexistingMonitor(int curWd, const std::vector<std::string>& pathAr, const std::shared_ptr<AutoscanDirectory>& adir);
-    void recheckNonexistingMonitors(int wd, const std::shared_ptr<Wd>& wdObj);
-    void removeNonexistingMonitor(int wd, const std::shared_ptr<Wd>& wdObj, const std::vector<std::string>& pathAr);
+    void recheckNonexistingMonitors(int wd, const Wd& wdObj);
+    void removeNonexistingMonitor(int wd, Wd& wdObj, const std::vector<std::string>& pathAr);
 
     int watchPathForMoves(const fs::path& path, int wd);
     int addMoveWatch(const fs::path& path, int removeWd, int parentWd);
-    void checkMoveWatches(int wd, const std::shared_ptr<Wd>& wdObj);
+    void checkMoveWatches(int wd, Wd& wdObj);
     void removeWatchMoves(int wd);
 
-    void addDescendant(int startPointWd, int addWd, const std::shared_ptr<AutoscanDirectory>& adir);
+    /// \brief remove the watches of the subdirectories of the start points on wd
     void removeDescendants(int wd);
 
     /// \brief is set to true by shutdown() if the inotify thread should terminate
@@ -0,0 +1,73 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    change_follower.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file change_follower.cc
+
+#include "change_follower.h" // API
+
+#include "database/database.h"
+#include "update_manager.h"
+
+ChangeFollower::ChangeFollower(std::shared_ptr<Database> database, std::shared_ptr<UpdateManager> updateManager, std::shared_ptr<Timer> timer, unsigned int pollInterval)
+    : database(std::move(database))
+    , updateManager(std::move(updateManager))
+    , timer(std::move(timer))
+    , pollInterval(pollInterval)
+{
+}
+
+void ChangeFollower::run()
+{
+    changeLog.sequence = database->getChangeLogSequence();
+    log_info("Following the changes of the other nodes after entry {}", changeLog.sequence);
+    timer->addTimerSubscriber(this, pollInterval);
+}
+
+void ChangeFollower::shutdown()
+{
+    timer->removeTimerSubscriber(this, nullptr, true);
+}
+
+void ChangeFollower::timerNotify(std::shared_ptr<Timer::Parameter> parameter)
+{
+    Database::ChangeLog changes;
+    try {
+        changes = database->readChangeLog(changeLog);
+    } catch (const std::runtime_error& e) {
+        log_warning("Could not read the change log: {}", e.what());
+        return;
+    }
+    changeLog.sequence = changes.sequence;
+    changeLog.gaps = changes.gaps;
+    changeLog.readTime = changes.readTime;
+
+    if (!changes.complete) {
+        log_warning("Changes of other nodes were pruned before they were read, refreshing all clients");
+        updateManager->refreshAll();
+        return;
+    }
+    for (auto&& updateIDs : changes.updateIDs) {
+        log_debug("Containers changed by another node: {}", updateIDs);
+        updateManager->containersUpdated(updateIDs);
+    }
+}
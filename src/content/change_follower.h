@@ -0,0 +1,64 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    change_follower.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file change_follower.h
+#ifndef __CHANGE_FOLLOWER_H__
+#define __CHANGE_FOLLOWER_H__
+
+#include <cstdint>
+#include <memory>
+
+#include "database/database.h"
+#include "util/timer.h"
+
+// forward declaration
+class UpdateManager;
+
+/// \brief Applies the changes other nodes of a cluster wrote to the change log of the shared database
+///
+/// The log is polled by sequence number, numbers skipped by a read are read again for a while.
+/// Each change drops what the database and the server keep of the containers and is sent to the
+/// subscribed clients like a local change.
+class ChangeFollower : public Timer::Subscriber {
+public:
+    ChangeFollower(std::shared_ptr<Database> database, std::shared_ptr<UpdateManager> updateManager, std::shared_ptr<Timer> timer, unsigned int pollInterval);
+
+    /// \brief start after the latest entry, older ones are already in the database
+    void run();
+    void shutdown();
+
+    void timerNotify(std::shared_ptr<Timer::Parameter> parameter) override;
+
+    /// \brief sequence number of the latest entry applied
+    std::int64_t getSequence() const { return changeLog.sequence; }
+
+protected:
+    std::shared_ptr<Database> database;
+    std::shared_ptr<UpdateManager> updateManager;
+    std::shared_ptr<Timer> timer;
+    unsigned int pollInterval;
+    /// \brief position of the last read, without the changes
+    Database::ChangeLog changeLog;
+};
+
+#endif // __CHANGE_FOLLOWER_H__
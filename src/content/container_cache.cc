@@ -0,0 +1,87 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    container_cache.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file container_cache.cc
+
+#include "container_cache.h" // API
+
+#include "common.h"
+#include "util/tools.h"
+
+ContainerCache::ContainerCache(std::size_t capacity)
+    : capacity(capacity)
+{
+    memory = MemoryAccounting::getInstance().add("container-cache", [this] {
+        AutoLock lock(mutex);
+        return entries.size() * (MemoryAccounting::HASH_NODE + sizeof(decltype(entries)::IndexValue) + MemoryAccounting::LIST_NODE + sizeof(decltype(entries)::Entry))
+            + entries.bucket_count() * sizeof(void*)
+            + art.size() * (MemoryAccounting::HASH_NODE + sizeof(decltype(art)::value_type)) + art.bucket_count() * sizeof(void*);
+    });
+}
+
+int ContainerCache::get(const std::string& chain)
+{
+    AutoLock lock(mutex);
+    auto entry = entries.get(stringHash(chain));
+    return entry != entries.end() ? entry->second : INVALID_OBJECT_ID;
+}
+
+void ContainerCache::put(const std::string& chain, int objectID)
+{
+    if (capacity == 0)
+        return;
+
+    auto key = stringHash(chain);
+    AutoLock lock(mutex);
+    if (entries.find(key) == entries.end()) {
+        while (entries.size() >= capacity)
+            entries.pop_back();
+    }
+    entries.put(key, objectID);
+}
+
+void ContainerCache::clear()
+{
+    AutoLock lock(mutex);
+    entries.clear();
+    art.clear();
+}
+
+ContainerCache::Art ContainerCache::getArt(int objectID)
+{
+    AutoLock lock(mutex);
+    auto entry = art.find(objectID);
+    return entry != art.end() ? entry->second : Art::Unknown;
+}
+
+void ContainerCache::setArt(int objectID, Art value)
+{
+    if (capacity == 0)
+        return;
+
+    AutoLock lock(mutex);
+    // the state is looked up again for the containers of the next items
+    if (art.size() >= capacity && art.find(objectID) == art.end())
+        art.clear();
+    art[objectID] = value;
+}
@@ -0,0 +1,73 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    container_cache.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file container_cache.h
+#ifndef __CONTAINER_CACHE_H__
+#define __CONTAINER_CACHE_H__
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "util/lru_cache.h"
+#include "util/memory_accounting.h"
+
+/// \brief Size bounded LRU cache of virtual container ids by chain
+///
+/// Only a 64 bit hash of the chain is kept, a miss falls back to the location lookup in the database.
+/// The cache also remembers what was found out about the art of the containers, so the layout does
+/// not look for it again with every item it adds.
+class ContainerCache {
+public:
+    /// \brief art of a container as far as the layout knows it
+    enum class Art {
+        Unknown,
+        /// \brief there is no art file for the container and no item had art yet
+        NoFile,
+        /// \brief the container has an art resource
+        Assigned,
+    };
+
+    explicit ContainerCache(std::size_t capacity = 16384);
+
+    /// \brief id of the container created for chain or INVALID_OBJECT_ID
+    int get(const std::string& chain);
+    void put(const std::string& chain, int objectID);
+    void clear();
+
+    Art getArt(int objectID);
+    void setArt(int objectID, Art art);
+
+private:
+    std::size_t capacity;
+    /// \brief object id by hash of the chain
+    LruCache<std::int64_t, int, std::unordered_map> entries;
+    std::unordered_map<int, Art> art;
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::unique_ptr<MemoryAccounting::Registration> memory;
+};
+
+#endif // __CONTAINER_CACHE_H__
@@ -31,19 +31,35 @@
 
 #include "content_manager.h" // API
 
+#include <algorithm>
 #include <cerrno>
 #include <chrono>
 #include <cstring>
 #include <regex>
+#include <thread>
+#include <unordered_map>
 
+#include "change_follower.h"
 #include "config/config_manager.h"
+#include "config/config_setup.h"
 #include "config/directory_tweak.h"
+#include "content/import_statistics.h"
 #include "database/database.h"
 #include "layout/builtin_layout.h"
+#include "layout/template_layout.h"
+#include "metadata/directory_index.h"
+#include "metadata/duplicate_index.h"
 #include "metadata/metadata_handler.h"
+#include "playlist_parser.h"
+#include "transcoding/hardware_accelerators.h"
+#include "transcoding/hls_session_manager.h"
+#include "transcoding/pretranscode_queue.h"
+#include "transcoding/transcode_cache.h"
+#include "transcoding/transcode_scheduler.h"
 #include "update_manager.h"
 #include "util/mime.h"
 #include "util/process.h"
+#include "util/storage_activity.h"
 #include "util/string_converter.h"
 #include "util/timer.h"
 #include "util/tools.h"
@@ -73,6 +89,19 @@
 #include "scripting/scripting_runtime.h"
 #endif
 
+// new items of a directory scan are written to the database in batches of this size
+#define IMPORT_BATCH_SIZE 100
+// or when the oldest item of the batch waited for this many milliseconds
+#define IMPORT_BATCH_INTERVAL 2000
+// big removals are done in chunks of this many items, each with one notification per changed container
+#define REMOVE_CHUNK_SIZE 1000
+// number of subdirectories listed ahead of the walk
+#define DIRECTORY_PREFETCH_COUNT 8
+// the layout is rebuilt for this many items at a time
+#define LAYOUT_REBUILD_CHUNK 500
+// title of the hidden container the new layout is built in
+#define LAYOUT_REBUILD_TITLE "relayout"
+
 ContentManager::ContentManager(const std::shared_ptr<Context>& context,
     const std::shared_ptr<Server>& server, std::shared_ptr<Timer> timer)
     : config(context->getConfig())
@@ -80,16 +109,27 @@ ContentManager::ContentManager(const std::shared_ptr<Context>& context,
     , database(context->getDatabase())
     , session_manager(context->getSessionManager())
     , context(context)
+    , importStatistics(context->getImportStatistics())
     , timer(std::move(timer))
 {
-    taskID = 1;
-    working = false;
     shutdownFlag = false;
     layout_enabled = false;
 
     update_manager = std::make_shared<UpdateManager>(config, database, server);
+    // one thread for each task owner, their tasks are run one at a time
+#ifdef ONLINE_SERVICES
+    // except for online services, which fetch in parallel
+    std::size_t parallelFetches = config->getIntOption(CFG_ONLINE_CONTENT_PARALLEL_FETCHES);
+    std::size_t taskThreads = 1 + parallelFetches;
+#else
+    std::size_t taskThreads = 1;
+#endif
+    bool pretranscode = config->getBoolOption(CFG_TRANSCODING_TRANSCODING_ENABLED) && config->getBoolOption(CFG_TRANSCODING_PRETRANSCODE);
+    if (pretranscode)
+        taskThreads++;
+    scheduler = std::make_shared<TaskScheduler>(config, taskThreads, [db = database] { db->threadCleanup(); });
 #ifdef ONLINE_SERVICES
-    task_processor = std::make_shared<TaskProcessor>(config);
+    scheduler->setConcurrency(TaskProcessorTask, parallelFetches);
 #endif
 #ifdef HAVE_JS
     scripting_runtime = std::make_shared<ScriptingRuntime>();
@@ -99,24 +139,86 @@ ContentManager::ContentManager(const std::shared_ptr<Context>& context,
 #endif
 
     mimetype_contenttype_map = config->getDictionaryOption(CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
+    if (config->getBoolOption(CFG_IMPORT_DEDUPLICATE_METADATA))
+        duplicates = std::make_unique<DuplicateIndex>();
+    directories = std::make_unique<DirectoryIndex>();
+    lazyMetadata = config->getBoolOption(CFG_IMPORT_LAZY_METADATA);
+    changeDetection = config->getBoolOption(CFG_IMPORT_CHANGE_DETECTION);
+    followSymlinks = config->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS);
+    readableNames = config->getBoolOption(CFG_IMPORT_READABLE_NAMES);
+    containerArtParentCount = containerArtParentCount;
+    containerArtMinDepth = containerArtMinDepth;
+    if (config->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_ENABLED))
+        markPlayedContent = config->getArrayOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_CONTENT_LIST);
+    markPlayedSuppressUpdates = config->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_SUPPRESS_CDS_UPDATES);
+
+    auto cacheSize = config->getIntOption(CFG_TRANSCODING_CACHE_SIZE);
+    if (cacheSize > 0)
+        transcodeCache = std::make_shared<TranscodeCache>(config->getOption(CFG_TRANSCODING_CACHE_DIR), std::size_t(cacheSize) * 1024 * 1024);
+    transcodeScheduler = std::make_shared<TranscodeScheduler>(config->getIntOption(CFG_TRANSCODING_MAX_CONCURRENT),
+        std::chrono::seconds(config->getIntOption(CFG_TRANSCODING_QUEUE_TIMEOUT)));
+    hlsSessions = std::make_shared<HlsSessionManager>(this->timer, transcodeScheduler, config->getOption(CFG_SERVER_TMPDIR),
+        std::chrono::seconds(config->getIntOption(CFG_TRANSCODING_HLS_IDLE_TIMEOUT)), config->getIntOption(CFG_TRANSCODING_HLS_SEGMENTS_AHEAD));
+    hardwareAccelerators = std::make_shared<HardwareAccelerators>();
+    if (pretranscode)
+        pretranscodeQueue = std::make_shared<PretranscodeQueue>(config, this->timer);
+
+    layoutMappings = readLayoutMappings();
+}
+
+std::vector<std::pair<std::regex, std::string>> ContentManager::readLayoutMappings() const
+{
+    std::vector<std::pair<std::regex, std::string>> result;
+    for (const auto& [key, val] : config->getDictionaryOption(CFG_IMPORT_LAYOUT_MAPPING)) {
+        try {
+            result.emplace_back(std::regex(key, std::regex::ECMAScript | std::regex::optimize), val);
+        } catch (const std::regex_error& e) {
+            log_error("Ignoring layout mapping {}: {}", key, e.what());
+        }
+    }
+    return result;
+}
+
+void ContentManager::reloadConfig()
+{
+    auto mappings = readLayoutMappings();
+    {
+        std::lock_guard<std::mutex> lock(mappedChainsMutex);
+        layoutMappings = std::move(mappings);
+        mappedChains.clear();
+    }
+    reloadLayout();
 }
 
 void ContentManager::run()
 {
-#ifdef ONLINE_SERVICES
-    task_processor->run();
-#endif
     update_manager->run();
 #ifdef HAVE_LASTFMLIB
     last_fm->run();
 #endif
-    threadRunner = std::make_unique<ThreadRunner<std::condition_variable_any, std::recursive_mutex>>("ContentTaskThread", ContentManager::staticThreadProc, this, config);
+    scheduler->run();
 
-    if (!threadRunner->isAlive()) {
-        throw_std_runtime_error("Could not start task thread");
+    auto clusterRole = config->getOption(CFG_SERVER_CLUSTER_ROLE);
+    if (clusterRole != "standalone") {
+        changeFollower = std::make_unique<ChangeFollower>(database, update_manager, timer, config->getIntOption(CFG_SERVER_CLUSTER_POLL_INTERVAL));
+        changeFollower->run();
     }
+    // a frontend leaves the autoscan directories and the online services in the shared database to the importer
+    bool importing = clusterRole != "frontend";
 
-    auto config_timed_list = config->getAutoscanListOption(CFG_IMPORT_AUTOSCAN_TIMED_LIST);
+    int importThreads = config->getIntOption(CFG_IMPORT_EXTRACTION_THREADS);
+    if (importThreads == 0)
+        importThreads = std::thread::hardware_concurrency();
+    for (int i = 0; i < importThreads; i++) {
+        auto worker = std::make_unique<ThreadRunner<std::condition_variable, std::mutex>>(fmt::format("ImportThread{}", i), ContentManager::staticImportThreadProc, this, config);
+        if (!worker->isAlive()) {
+            throw_std_runtime_error("Could not start import thread");
+        }
+        importWorkers.push_back(std::move(worker));
+    }
+    log_debug("started {} import threads", importWorkers.size());
+
+    auto config_timed_list = importing ? config->getAutoscanListOption(CFG_IMPORT_AUTOSCAN_TIMED_LIST) : std::make_shared<AutoscanList>(database);
     for (size_t i = 0; i < config_timed_list->size(); i++) {
         auto dir = config_timed_list->get(i);
         if (dir != nullptr) {
@@ -127,14 +229,41 @@ void ContentManager::run()
         }
     }
 
-    database->updateAutoscanList(ScanMode::Timed, config_timed_list);
-    autoscan_timed = database->getAutoscanList(ScanMode::Timed);
+    if (lazyMetadata && importing) {
+        // items still waiting from the last run
+        auto pendingIDs = database->getFlaggedObjectIDs(OBJECT_FLAG_PENDING_METADATA);
+        if (!pendingIDs.empty())
+            log_info("Reading the metadata of {} pending items", pendingIDs.size());
+        for (std::size_t offset = 0; offset < pendingIDs.size(); offset += IMPORT_BATCH_SIZE) {
+            auto last = pendingIDs.begin() + std::min(pendingIDs.size(), offset + IMPORT_BATCH_SIZE);
+            readMetadata(std::vector<int>(pendingIDs.begin() + offset, last), "");
+        }
+    }
+
+    if (importing) {
+        database->updateAutoscanList(ScanMode::Timed, config_timed_list);
+        autoscan_timed = database->getAutoscanList(ScanMode::Timed);
+    } else {
+        autoscan_timed = config_timed_list;
+    }
 
     auto self = shared_from_this();
+    if (pretranscodeQueue != nullptr)
+        pretranscodeQueue->run(self);
 #ifdef HAVE_INOTIFY
-    inotify = std::make_unique<AutoscanInotify>(self);
+#ifdef HAVE_FANOTIFY
+    if (config->getOption(CFG_IMPORT_AUTOSCAN_INOTIFY_BACKEND) == "fanotify") {
+        try {
+            inotify = std::make_unique<AutoscanFanotify>(self);
+        } catch (const std::runtime_error& e) {
+            log_warning("{}, falling back to inotify", e.what());
+        }
+    }
+#endif
+    if (inotify == nullptr)
+        inotify = std::make_unique<AutoscanInotify>(self);
 
-    if (config->getBoolOption(CFG_IMPORT_AUTOSCAN_USE_INOTIFY)) {
+    if (importing && config->getBoolOption(CFG_IMPORT_AUTOSCAN_USE_INOTIFY)) {
         auto config_inotify_list = config->getAutoscanListOption(CFG_IMPORT_AUTOSCAN_INOTIFY_LIST);
         for (size_t i = 0; i < config_inotify_list->size(); i++) {
             auto dir = config_inotify_list->get(i);
@@ -165,7 +294,7 @@ void ContentManager::run()
     online_services = std::make_unique<OnlineServiceList>();
 
 #ifdef SOPCAST
-    if (config->getBoolOption(CFG_ONLINE_CONTENT_SOPCAST_ENABLED)) {
+    if (importing && config->getBoolOption(CFG_ONLINE_CONTENT_SOPCAST_ENABLED)) {
         try {
             auto sc = std::make_shared<SopCastService>(self);
 
@@ -191,7 +320,7 @@ void ContentManager::run()
 #endif // SOPCAST
 
 #ifdef ATRAILERS
-    if (config->getBoolOption(CFG_ONLINE_CONTENT_ATRAILERS_ENABLED)) {
+    if (importing && config->getBoolOption(CFG_ONLINE_CONTENT_ATRAILERS_ENABLED)) {
         try {
             auto at = std::make_shared<ATrailersService>(self);
 
@@ -217,6 +346,7 @@ void ContentManager::run()
 
 #endif // ONLINE_SERVICES
 
+    playlist_parser = std::make_unique<PlaylistParser>(self);
     if (layout_enabled)
         initLayout();
 
@@ -227,7 +357,7 @@ void ContentManager::run()
     autoscan_timed->notifyAll(this);
 
 #ifdef HAVE_INOTIFY
-    if (config->getBoolOption(CFG_IMPORT_AUTOSCAN_USE_INOTIFY)) {
+    if (importing && config->getBoolOption(CFG_IMPORT_AUTOSCAN_USE_INOTIFY)) {
         /// \todo change this (we need a new autoscan architecture)
         for (size_t i = 0; i < autoscan_inotify->size(); i++) {
             std::shared_ptr<AutoscanDirectory> adir = autoscan_inotify->get(i);
@@ -249,13 +379,34 @@ void ContentManager::run()
         log_debug("Adding timed scan with interval {}", adir->getInterval());
         timer->addTimerSubscriber(this, adir->getInterval(), param, false);
     }
+
+    if (importing && config->getBoolOption(CFG_IMPORT_STORAGE_AWARENESS_ENABLED)) {
+        storageActivity = std::make_unique<StorageActivity>(std::chrono::seconds(config->getIntOption(CFG_IMPORT_STORAGE_AWARENESS_IDLE_TIME)));
+        storageMaxDelay = std::chrono::seconds(config->getIntOption(CFG_IMPORT_STORAGE_AWARENESS_MAX_DELAY));
+        auto param = std::make_shared<Timer::Parameter>(Timer::Parameter::timer_param_t::IDStorageCheck, 0);
+        timer->addTimerSubscriber(this, STORAGE_CHECK_INTERVAL, param, false);
+    }
+
+    auto playStateParam = std::make_shared<Timer::Parameter>(Timer::Parameter::timer_param_t::IDPlayState, 0);
+    timer->addTimerSubscriber(this, PLAY_STATE_FLUSH_INTERVAL, playStateParam, false);
+
+    // update ids of an idle server are written as well, the database writes them on shutdown
+    auto updateIDParam = std::make_shared<Timer::Parameter>(Timer::Parameter::timer_param_t::IDUpdateIDs, 0);
+    timer->addTimerSubscriber(this, UPDATE_ID_STORE_INTERVAL, updateIDParam, false);
+
+    // a frontend shares the database with the importing node, which maintains it
+    int maintenanceInterval = config->getIntOption(CFG_SERVER_STORAGE_MAINTENANCE_INTERVAL);
+    if (importing && maintenanceInterval > 0) {
+        auto param = std::make_shared<Timer::Parameter>(Timer::Parameter::timer_param_t::IDDatabaseMaintenance, 0);
+        timer->addTimerSubscriber(this, maintenanceInterval, param, false);
+    }
 }
 
 ContentManager::~ContentManager() { log_debug("ContentManager destroyed"); }
 
 void ContentManager::registerExecutor(const std::shared_ptr<Executor>& exec)
 {
-    auto lock = threadRunner->lockGuard("registerExecutor");
+    AutoLock lock(mutex);
     process_list.push_back(exec);
 }
 
@@ -270,7 +421,7 @@ void ContentManager::unregisterExecutor(const std::shared_ptr<Executor>& exec)
     if (shutdownFlag)
         return;
 
-    auto lock = threadRunner->lockGuard("unregisterExecutor");
+    AutoLock lock(mutex);
 
     process_list.erase(std::remove_if(process_list.begin(), process_list.end(), [&](const auto& e) { return e == exec; }), process_list.end());
 }
@@ -281,13 +432,19 @@ void ContentManager::timerNotify(std::shared_ptr<Timer::Parameter> parameter)
         return;
 
     if (parameter->whoami() == Timer::Parameter::IDAutoscan) {
-        std::shared_ptr<AutoscanDirectory> adir = autoscan_timed->get(parameter->getID());
-
-        // do not rescan while other scans are still active
-        if (adir == nullptr || adir->getActiveScanCount() > 0 || adir->getTaskCount() > 0)
-            return;
-
-        rescanDirectory(adir, adir->getObjectID());
+        runTimedScan(parameter->getID(), true);
+    } else if (parameter->whoami() == Timer::Parameter::IDStorageCheck) {
+        runPostponedScans();
+    } else if (parameter->whoami() == Timer::Parameter::IDPlayState) {
+        flushPlayStates();
+    } else if (parameter->whoami() == Timer::Parameter::IDDatabaseMaintenance) {
+        runDatabaseMaintenance();
+    } else if (parameter->whoami() == Timer::Parameter::IDUpdateIDs) {
+        try {
+            database->storeUpdateIDs();
+        } catch (const std::runtime_error& e) {
+            log_error("Could not store the update ids: {}", e.what());
+        }
     }
 #ifdef ONLINE_SERVICES
     else if (parameter->whoami() == Timer::Parameter::IDOnlineContent) {
@@ -296,12 +453,89 @@ void ContentManager::timerNotify(std::shared_ptr<Timer::Parameter> parameter)
 #endif // ONLINE_SERVICES
 }
 
+void ContentManager::runTimedScan(int scanID, bool postpone)
+{
+    std::shared_ptr<AutoscanDirectory> adir = autoscan_timed->get(scanID);
+
+    // do not rescan while other scans are still active
+    if (adir == nullptr || adir->getActiveScanCount() > 0 || adir->getTaskCount() > 0)
+        return;
+
+    if (postpone && storageActivity && postponeScan(adir))
+        return;
+
+    rescanDirectory(adir, adir->getObjectID());
+}
+
+bool ContentManager::postponeScan(const std::shared_ptr<AutoscanDirectory>& adir)
+{
+    auto disk = storageActivity->getDisk(adir->getLocation());
+    bool active = storageActivity->isActive(disk);
+
+    std::lock_guard<std::mutex> lock(postponedScansMutex);
+    auto now = std::chrono::steady_clock::now();
+    auto [entry, added] = postponedScans.emplace(adir->getScanID(), now);
+    if (active || now - entry->second >= storageMaxDelay) {
+        postponedScans.erase(entry);
+        return false;
+    }
+    if (added)
+        log_debug("Disk {} is idle, postponing the scan of {}", disk, adir->getLocation().c_str());
+    return true;
+}
+
+void ContentManager::runPostponedScans()
+{
+    std::map<int, std::chrono::steady_clock::time_point> waiting;
+    {
+        std::lock_guard<std::mutex> lock(postponedScansMutex);
+        waiting = postponedScans;
+    }
+    if (waiting.empty())
+        return;
+
+    // one wake-up of a disk runs all scans waiting for it
+    auto now = std::chrono::steady_clock::now();
+    std::map<std::string, std::pair<bool, std::vector<int>>> disks;
+    for (auto&& [scanID, since] : waiting) {
+        auto adir = autoscan_timed->get(scanID);
+        auto&& disk = disks[adir ? storageActivity->getDisk(adir->getLocation()) : ""];
+        disk.first = disk.first || now - since >= storageMaxDelay;
+        disk.second.push_back(scanID);
+    }
+
+    for (auto&& [disk, scans] : disks) {
+        auto&& [overdue, scanIDs] = scans;
+        if (!overdue && !storageActivity->isActive(disk))
+            continue;
+        log_info("Running {} postponed scans on {}{}", scanIDs.size(), disk.empty() ? "a removed location" : disk, overdue ? ", waited too long" : "");
+        {
+            std::lock_guard<std::mutex> lock(postponedScansMutex);
+            for (int scanID : scanIDs)
+                postponedScans.erase(scanID);
+        }
+        for (int scanID : scanIDs)
+            runTimedScan(scanID, false);
+    }
+}
+
+void ContentManager::runDatabaseMaintenance()
+{
+    // the next interval catches the idle time after an import
+    if (getCurrentTask() != nullptr || !getTasklist().empty() || getImportQueueLength() > 0) {
+        log_debug("Database maintenance skipped, tasks are running");
+        return;
+    }
+    database->runMaintenance();
+}
+
 void ContentManager::shutdown()
 {
     log_debug("start");
-    auto lock = threadRunner->uniqueLock();
+    std::unique_lock<std::recursive_mutex> lock(mutex);
     log_debug("updating last_modified data for autoscan in database...");
     autoscan_timed->updateLMinDB();
+    flushPlayStates();
 
 #ifdef HAVE_JS
     destroyJS();
@@ -330,18 +564,38 @@ void ContentManager::shutdown()
 #endif
 
     shutdownFlag = true;
+    transcodeScheduler->shutdown();
 
     for (const auto& exec : process_list) {
         if (exec != nullptr)
             exec->kill();
     }
 
-    log_debug("signalling...");
-    threadRunner->notify();
     lock.unlock();
-    log_debug("waiting for thread...");
 
-    threadRunner->join();
+    // the transcoders are gone, the cache writers only have to notice it
+    if (transcodeCache != nullptr)
+        transcodeCache->shutdown();
+    hlsSessions->shutdown();
+    if (pretranscodeQueue != nullptr)
+        pretranscodeQueue->shutdown();
+
+    // stop the import workers first, the task threads may wait for one of their jobs
+    {
+        std::lock_guard<std::mutex> importLock(importMutex);
+        importCond.notify_all();
+    }
+    for (auto&& worker : importWorkers)
+        worker->join();
+    {
+        std::lock_guard<std::mutex> importLock(importMutex);
+        importQueue.clear();
+    }
+    importWorkers.clear();
+
+    log_debug("waiting for task threads...");
+
+    scheduler->shutdown();
 
 #ifdef HAVE_LASTFMLIB
     last_fm->shutdown();
@@ -350,10 +604,10 @@ void ContentManager::shutdown()
 #ifdef HAVE_JS
     scripting_runtime = nullptr;
 #endif
-#ifdef ONLINE_SERVICES
-    task_processor->shutdown();
-    task_processor = nullptr;
-#endif
+    if (changeFollower != nullptr) {
+        changeFollower->shutdown();
+        changeFollower = nullptr;
+    }
     update_manager->shutdown();
     update_manager = nullptr;
 
@@ -362,36 +616,28 @@ void ContentManager::shutdown()
 
 std::shared_ptr<GenericTask> ContentManager::getCurrentTask()
 {
-    auto lock = threadRunner->lockGuard("getCurrentTask");
+    // the web UI shows the progress of imports rather than online service refreshes
+    auto tasks = scheduler->getWorkerTasks();
+    auto task = std::find_if(tasks.begin(), tasks.end(), [](const auto& t) { return t != nullptr && t->getOwner() == ContentManagerTask; });
+    if (task == tasks.end())
+        task = std::find_if(tasks.begin(), tasks.end(), [](const auto& t) { return t != nullptr; });
+    return task != tasks.end() ? *task : nullptr;
+}
 
-    auto task = currentTask;
-    return task;
+std::vector<std::shared_ptr<GenericTask>> ContentManager::getWorkerTasks()
+{
+    return scheduler->getWorkerTasks();
 }
 
 std::deque<std::shared_ptr<GenericTask>> ContentManager::getTasklist()
 {
-    auto lock = threadRunner->lockGuard("getTasklist");
-
-    std::deque<std::shared_ptr<GenericTask>> taskList;
-#ifdef ONLINE_SERVICES
-    taskList = task_processor->getTasklist();
-#endif
-    auto t = getCurrentTask();
-
-    // if there is no current task, then the queues are empty
-    // and we do not have to allocate the array
-    if (t == nullptr)
-        return taskList;
-
-    taskList.push_back(t);
-    std::copy_if(taskQueue1.begin(), taskQueue1.end(), std::back_inserter(taskList), [](const auto& task) { return task->isValid(); });
-
-    for (const auto& task : taskQueue2) {
-        if (task->isValid())
-            taskList.clear();
-    }
+    return scheduler->getTasklist();
+}
 
-    return taskList;
+std::size_t ContentManager::getImportQueueLength()
+{
+    std::lock_guard<std::mutex> importLock(importMutex);
+    return importQueue.size();
 }
 
 void ContentManager::addVirtualItem(const std::shared_ptr<CdsObject>& obj, bool allow_fifo)
@@ -427,7 +673,8 @@ std::time_t to_time_t(TP tp)
     return std::chrono::system_clock::to_time_t(asSystemTime);
 }
 
-std::shared_ptr<CdsObject> ContentManager::createSingleItem(const fs::directory_entry& dirEnt, fs::path& rootPath, bool followSymlinks, bool checkDatabase, bool processExisting, bool firstChild, const std::shared_ptr<CMAddFileTask>& task)
+std::shared_ptr<CdsObject> ContentManager::createSingleItem(const fs::directory_entry& dirEnt, fs::path& rootPath, bool followSymlinks, bool checkDatabase, bool processExisting, bool firstChild, const std::shared_ptr<CMAddFileTask>& task,
+    std::vector<std::shared_ptr<CdsObject>>* batch)
 {
     auto obj = checkDatabase ? database->findObjectByPath(dirEnt.path()) : nullptr;
     bool isNew = false;
@@ -439,34 +686,191 @@ std::shared_ptr<CdsObject> ContentManager::createSingleItem(const fs::directory_
             return nullptr;
         }
         if (obj->isItem()) {
-            addObject(obj, firstChild);
+            if (batch != nullptr) {
+                // added and processed by flushImportBatch
+                obj->validate();
+                batch->push_back(obj);
+                return obj;
+            }
+            {
+                ImportStatistics::StageTimer stageTimer(importStatistics.get(), ImportStatistics::Stage::DatabaseInsert);
+                addObject(obj, firstChild);
+            }
+            if (changeDetection)
+                storeFileState(obj);
+            if (importStatistics != nullptr)
+                importStatistics->addFiles(1);
             isNew = true;
         }
     } else if (obj->isItem() && processExisting) {
         MetadataHandler::setMetadata(context, std::static_pointer_cast<CdsItem>(obj), dirEnt);
     }
-    if (obj->isItem() && layout != nullptr && (processExisting || isNew)) {
+    if (obj->isItem() && (processExisting || isNew)) {
+        processLayout(obj, rootPath, task);
+    }
+    return obj;
+}
+
+void ContentManager::flushImportBatch(std::vector<std::shared_ptr<CdsObject>>& batch, fs::path& rootPath, const std::shared_ptr<CMAddFileTask>& task)
+{
+    if (batch.empty())
+        return;
+
+    int containerChanged = INVALID_OBJECT_ID;
+    try {
+        ImportStatistics::StageTimer stageTimer(importStatistics.get(), ImportStatistics::Stage::DatabaseInsert);
+        database->addObjects(batch, &containerChanged);
+    } catch (const std::runtime_error& e) {
+        log_warning("Adding {} items at once failed, adding them one by one: {}", batch.size(), e.what());
+        for (const auto& obj : batch) {
+            obj->setID(INVALID_OBJECT_ID);
+            try {
+                addObject(obj, false);
+            } catch (const std::runtime_error& ex) {
+                log_warning("skipping {} (ex:{})", obj->getLocation().c_str(), ex.what());
+            }
+        }
+    }
+    update_manager->containerChanged(containerChanged);
+    session_manager->containerChangedUI(containerChanged);
+
+    std::unordered_set<int> parentIDs;
+    for (const auto& obj : batch) {
+        if (obj->getID() != INVALID_OBJECT_ID)
+            parentIDs.insert(obj->getParentID());
+    }
+    for (int parentID : parentIDs)
+        update_manager->containerChanged(parentID);
+
+    if (importStatistics != nullptr)
+        importStatistics->addFiles(std::count_if(batch.begin(), batch.end(), [](const auto& obj) { return obj->getID() != INVALID_OBJECT_ID; }));
+
+    std::vector<int> pendingIDs;
+    std::vector<std::shared_ptr<CdsObject>> layoutObjects;
+    for (const auto& obj : batch) {
+        if (obj->getID() == INVALID_OBJECT_ID)
+            continue;
+        if (changeDetection)
+            storeFileState(obj);
+        if (obj->getFlag(OBJECT_FLAG_PENDING_METADATA))
+            pendingIDs.push_back(obj->getID());
+        else
+            layoutObjects.push_back(obj);
+    }
+    if (layout != nullptr && layout->isParallel() && layoutObjects.size() > 1) {
+        // every job needs its own copy of the root path, processLayout fills it in
+        if (rootPath.empty() && (task != nullptr))
+            rootPath = task->getRootPath();
+        std::vector<std::future<void>> jobs;
+        jobs.reserve(layoutObjects.size());
+        for (const auto& obj : layoutObjects) {
+            jobs.push_back(queueImportJob([this, obj, rootPath, task]() mutable {
+                processLayout(obj, rootPath, task);
+            }));
+        }
+        for (auto&& job : jobs) {
+            try {
+                job.get();
+            } catch (const std::future_error& ex) {
+                // the job was dropped by shutdown()
+                log_debug("layout skipped: {}", ex.what());
+            }
+        }
+    } else if (!layoutObjects.empty()) {
+        processLayout(layoutObjects, rootPath, task);
+    }
+    if (!pendingIDs.empty()) {
+        if (rootPath.empty() && (task != nullptr))
+            rootPath = task->getRootPath();
+        readMetadata(pendingIDs, rootPath);
+    }
+    batch.clear();
+}
+
+std::future<std::shared_ptr<CdsObject>> ContentManager::extractObjectFromFile(const fs::path& path, bool followSymlinks)
+{
+    return queueImportJob([this, path, followSymlinks] {
+        std::error_code ec;
+        auto dirEnt = fs::directory_entry(path, ec);
+        return createObjectFromFile(dirEnt, followSymlinks);
+    });
+}
+
+void ContentManager::collectPendingImports(std::deque<PendingImport>& pending, std::vector<std::shared_ptr<CdsObject>>& batch)
+{
+    for (auto&& [path, result] : pending) {
         try {
-            if (rootPath.empty() && (task != nullptr))
-                rootPath = task->getRootPath();
+            auto obj = result.get();
+            if (obj == nullptr) { // object ignored
+                log_debug("Link to file or directory ignored: {}", path.c_str());
+                continue;
+            }
+            obj->validate();
+            batch.push_back(obj);
+        } catch (const std::runtime_error& ex) {
+            log_warning("skipping {} (ex:{})", path.c_str(), ex.what());
+        } catch (const std::future_error& ex) {
+            // the job was dropped by shutdown()
+            log_debug("skipping {} (ex:{})", path.c_str(), ex.what());
+        }
+    }
+    pending.clear();
+}
+
+void ContentManager::processLayout(const std::shared_ptr<CdsObject>& obj, fs::path& rootPath, const std::shared_ptr<CMAddFileTask>& task)
+{
+    if (rootPath.empty() && (task != nullptr))
+        rootPath = task->getRootPath();
+
+    if (obj->getFlag(OBJECT_FLAG_PENDING_METADATA)) {
+        // the layout is built from the metadata, so it runs once that is read
+        readMetadata({ obj->getID() }, rootPath);
+        return;
+    }
 
+    if (layout != nullptr) {
+        ImportStatistics::StageTimer stageTimer(importStatistics.get(), ImportStatistics::Stage::Layout);
+        try {
             layout->processCdsObject(obj, rootPath);
 
             std::string mimetype = std::static_pointer_cast<CdsItem>(obj)->getMimeType();
             std::string content_type = getValueOrDefault(mimetype_contenttype_map, mimetype);
 
-#ifdef HAVE_JS
-            if ((playlist_parser_script != nullptr) && (content_type == CONTENT_TYPE_PLAYLIST))
-                playlist_parser_script->processPlaylistObject(obj, task);
-#else
             if (content_type == CONTENT_TYPE_PLAYLIST)
-                log_warning("Playlist {} will not be parsed: Gerbera was compiled without JS support!", obj->getLocation().c_str());
-#endif // JS
+                parsePlaylist(obj, mimetype, task);
+        } catch (const std::runtime_error& e) {
+            log_error("{}", e.what());
+        }
+    }
+}
+
+void ContentManager::processLayout(const std::vector<std::shared_ptr<CdsObject>>& objects, fs::path& rootPath, const std::shared_ptr<CMAddFileTask>& task)
+{
+    if (rootPath.empty() && (task != nullptr))
+        rootPath = task->getRootPath();
+
+    if (layout == nullptr)
+        return;
+
+    {
+        ImportStatistics::StageTimer stageTimer(importStatistics.get(), ImportStatistics::Stage::Layout);
+        try {
+            layout->processCdsObjects(objects, rootPath);
+        } catch (const std::runtime_error& e) {
+            log_error("{}", e.what());
+        }
+    }
+
+    for (const auto& obj : objects) {
+        std::string mimetype = std::static_pointer_cast<CdsItem>(obj)->getMimeType();
+        if (getValueOrDefault(mimetype_contenttype_map, mimetype) != CONTENT_TYPE_PLAYLIST)
+            continue;
+        try {
+            parsePlaylist(obj, mimetype, task);
         } catch (const std::runtime_error& e) {
             log_error("{}", e.what());
         }
     }
-    return obj;
 }
 
 int ContentManager::_addFile(const fs::directory_entry& dirEnt, fs::path rootPath, AutoScanSetting& asSetting, const std::shared_ptr<CMAddFileTask>& task)
@@ -508,16 +912,16 @@ bool ContentManager::updateAttachedResources(const std::shared_ptr<AutoscanDirec
         AutoScanSetting asSetting;
         asSetting.adir = adir;
         adir->setCurrentLMT(parentPath, time_t(1));
-        asSetting.followSymlinks = config->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS);
+        asSetting.followSymlinks = followSymlinks;
         asSetting.hidden = config->getBoolOption(CFG_IMPORT_HIDDEN_FILES);
         asSetting.recursive = true;
         asSetting.rescanResource = false;
         asSetting.mergeOptions(config, parentPath);
         std::error_code ec;
-        // addFile(const fs::directory_entry& path, AutoScanSetting& asSetting, bool async, bool lowPriority, bool cancellable)
+        // addFile(const fs::directory_entry& path, AutoScanSetting& asSetting, bool async, TaskPriority priority, bool cancellable)
         auto dirEntry = fs::directory_entry(parentPath, ec);
         if (!ec) {
-            addFile(dirEntry, asSetting, true, true, false);
+            addFile(dirEntry, asSetting, true, TaskPriority::Background, false);
             log_debug("Forced rescan of {} for resource {}", parentPath.c_str(), location);
             parentRemoved = true;
         } else {
@@ -546,19 +950,67 @@ void ContentManager::_removeObject(const std::shared_ptr<AutoscanDirectory>& adi
     }
     // Removing a file can lead to virtual directories to drop empty and be removed
     // So current container cache must be invalidated
-    containerMap.clear();
+    containerCache.clear();
 
     if (!parentRemoved) {
-        auto changedContainers = database->removeObject(objectID, all);
-        if (changedContainers != nullptr) {
-            session_manager->containerChangedUI(changedContainers->ui);
-            update_manager->containersChanged(changedContainers->upnp);
+        if (!all) {
+            // empty big containers a chunk at a time, so neither the ids nor the changed containers of the whole subtree are held at once
+            std::vector<int> chunk;
+            while (!shutdownFlag && !(chunk = database->getSubtreeItems(objectID, REMOVE_CHUNK_SIZE)).empty()) {
+                log_debug("removing {} items below {}", chunk.size(), objectID);
+                auto list = std::make_unique<std::unordered_set<int>>(chunk.begin(), chunk.end());
+                auto changedContainers = database->removeObjects(list);
+                if (changedContainers != nullptr)
+                    notifyChangedContainers(changedContainers->ui, changedContainers->upnp);
+            }
+            if (shutdownFlag)
+                return;
         }
+        auto changedContainers = database->removeObject(objectID, all);
+        if (changedContainers != nullptr)
+            notifyChangedContainers(changedContainers->ui, changedContainers->upnp);
     }
     // reload accounting
     // loadAccounting();
 }
 
+void ContentManager::storeFileState(const std::shared_ptr<CdsObject>& obj)
+{
+    DuplicateIndex::FileIdentity identity;
+    if (!DuplicateIndex::identify(obj->getLocation(), identity) || !DuplicateIndex::readFingerprint(obj->getLocation(), identity))
+        return;
+    try {
+        database->setFileState(obj->getID(), { identity.size, static_cast<std::int64_t>(identity.inode), identity.birthTime, identity.head, identity.tail });
+    } catch (const std::runtime_error& e) {
+        log_warning("Could not store the state of {}: {}", obj->getLocation().c_str(), e.what());
+    }
+}
+
+bool ContentManager::isFileTouched(int objectID, const fs::path& path)
+{
+    Database::FileState state;
+    if (!database->getFileState(objectID, state))
+        return false;
+
+    // a file saved by renaming a new one over it has another inode and creation time
+    DuplicateIndex::FileIdentity identity;
+    if (!DuplicateIndex::identify(path, identity) || identity.size != state.size
+        || static_cast<std::int64_t>(identity.inode) != state.inode || identity.birthTime != state.birthTime)
+        return false;
+    return DuplicateIndex::readFingerprint(path, identity) && identity.head == state.head && identity.tail == state.tail;
+}
+
+void ContentManager::notifyChangedContainers(std::vector<int>& ui, std::vector<int>& upnp)
+{
+    // a removal lists the parent once per removed child
+    for (auto list : { &ui, &upnp }) {
+        std::sort(list->begin(), list->end());
+        list->erase(std::unique(list->begin(), list->end()), list->end());
+    }
+    session_manager->containerChangedUI(ui);
+    update_manager->containersChanged(upnp);
+}
+
 int ContentManager::ensurePathExistence(fs::path path)
 {
     int updateID;
@@ -578,6 +1030,8 @@ void ContentManager::_rescanDirectory(std::shared_ptr<AutoscanDirectory>& adir,
         throw_std_runtime_error("ID valid but nullptr returned? this should never happen");
 
     fs::path rootpath = adir->getLocation();
+    // subdirectories are scanned with the priority of the scan that found them
+    auto priority = task != nullptr ? task->getPriority() : TaskPriority::Background;
 
     fs::path location;
     std::shared_ptr<CdsContainer> parentContainer;
@@ -623,6 +1077,10 @@ void ContentManager::_rescanDirectory(std::shared_ptr<AutoscanDirectory>& adir,
         return;
     }
 
+    // a new scan of the whole directory, the tasks of an earlier one are done
+    if (containerID == adir->getObjectID() && adir->getTaskCount() <= 1)
+        startScanCheckpoint(adir);
+
     log_debug("Rescanning location: {}", location.c_str());
 
     std::error_code ec;
@@ -657,14 +1115,37 @@ void ContentManager::_rescanDirectory(std::shared_ptr<AutoscanDirectory>& adir,
     AutoScanSetting asSetting;
     asSetting.adir = adir;
     asSetting.recursive = adir->getRecursive();
-    asSetting.followSymlinks = config->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS);
+    asSetting.followSymlinks = followSymlinks;
     asSetting.hidden = adir->getHidden();
     asSetting.mergeOptions(config, location);
 
     log_debug("Rescanning options {}: recursive={} hidden={} followSymlinks={}", location.c_str(), asSetting.recursive, asSetting.hidden, asSetting.followSymlinks);
 
+    // entries added, removed or renamed change the mtime of the directory, a timed scan only lists changed ones
+    std::error_code mtimeEc;
+    auto dirMTime = to_time_t(rootDir.last_write_time(mtimeEc));
+    if (!mtimeEc && (adir->getScanMode() == ScanMode::Timed || adir->isResumed()) && database->isDirectoryUnchanged(containerID, dirMTime)) {
+        log_debug("Skipping unchanged directory {}", location.c_str());
+        if (asSetting.recursive) {
+            for (auto&& [path, child] : database->getChildStats(containerID, false)) {
+                if (child.isContainer)
+                    rescanDirectory(adir, child.id, path, task == nullptr || task->isCancellable(), priority);
+            }
+        }
+        return;
+    }
+
     // request only items if non-recursive scan is wanted
     auto list = database->getObjects(containerID, !asSetting.recursive);
+    // the walk compares against this snapshot and only goes to the database for changed entries
+    auto childStats = database->getChildStats(containerID, !asSetting.recursive);
+    auto findChild = [&](const fs::path& path) {
+        auto entry = childStats.find(path.string());
+        return entry != childStats.end() ? &entry->second : nullptr;
+    };
+    // the files known from the last scan, new ones are counted when they turn up
+    if (task != nullptr)
+        task->addItemsTotal(std::count_if(childStats.begin(), childStats.end(), [](auto&& child) { return !child.second.isContainer; }));
 
     unsigned int thisTaskID;
     if (task != nullptr) {
@@ -696,30 +1177,44 @@ void ContentManager::_rescanDirectory(std::shared_ptr<AutoscanDirectory>& adir,
         }
 
         if (!asSetting.followSymlinks && dirEnt.is_symlink()) {
-            int objectID = database->findObjectIDByPath(newPath);
+            auto child = findChild(newPath);
+            int objectID = child != nullptr ? child->id : INVALID_OBJECT_ID;
             if (objectID > 0) {
                 if (list != nullptr)
                     list->erase(objectID);
-                removeObject(adir, objectID, false);
+                adir->addStaleObject(objectID);
             }
             log_debug("link {} skipped", newPath.c_str());
             continue;
         }
 
         asSetting.recursive = adir->getRecursive();
-        asSetting.followSymlinks = config->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS);
+        asSetting.followSymlinks = followSymlinks;
         asSetting.hidden = adir->getHidden();
         asSetting.mergeOptions(config, location);
         auto lwt = to_time_t(dirEnt.last_write_time(ec));
 
         if (isRegularFile(dirEnt, ec)) {
-            int objectID = database->findObjectIDByPath(newPath);
+            auto child = findChild(newPath);
+            int objectID = child != nullptr ? child->id : INVALID_OBJECT_ID;
+            if (task != nullptr) {
+                if (objectID <= 0)
+                    task->addItemsTotal(1);
+                task->addItemsDone(1, dirEnt.file_size(ec));
+            }
             if (objectID > 0) {
                 if (list != nullptr)
                     list->erase(objectID);
 
                 // check modification time and update file if chagned
-                if (last_modified_current_max < lwt) {
+                if (last_modified_current_max < lwt && child->mtime != lwt && changeDetection && isFileTouched(objectID, newPath)) {
+                    log_debug("{} was touched, keeping its metadata", newPath.c_str());
+                    auto obj = database->loadObject(objectID);
+                    obj->setMTime(lwt);
+                    database->updateObject(obj, nullptr);
+                    if (last_modified_new_max < lwt)
+                        last_modified_new_max = lwt;
+                } else if (last_modified_current_max < lwt && child->mtime != lwt) {
                     // re-add object - we have to do this in order to trigger
                     // layout
                     removeObject(adir, objectID, false, false);
@@ -739,7 +1234,9 @@ void ContentManager::_rescanDirectory(std::shared_ptr<AutoscanDirectory>& adir,
                     last_modified_new_max = lwt;
             }
         } else if (dirEnt.is_directory(ec) && asSetting.recursive) {
-            int objectID = database->findObjectIDByPath(newPath);
+            auto child = findChild(newPath);
+            // the snapshot has no containers if the scan was not recursive at its start
+            int objectID = child != nullptr ? child->id : database->findObjectIDByPath(newPath);
             if (last_modified_new_max < lwt)
                 last_modified_new_max = lwt;
             if (objectID > 0) {
@@ -747,7 +1244,7 @@ void ContentManager::_rescanDirectory(std::shared_ptr<AutoscanDirectory>& adir,
                 if (list != nullptr)
                     list->erase(objectID);
                 // add a task to rescan the directory that was found
-                rescanDirectory(adir, objectID, newPath, task->isCancellable());
+                rescanDirectory(adir, objectID, newPath, task->isCancellable(), priority);
             } else {
                 log_debug("addSubDirectory {}", newPath.c_str());
 
@@ -756,7 +1253,7 @@ void ContentManager::_rescanDirectory(std::shared_ptr<AutoscanDirectory>& adir,
                 // this lock will make sure that remove is not in the process of invalidating
                 // the AutocsanDirectories in the autoscan_timed list at the time when we
                 // are checking for validity.
-                auto lock = threadRunner->lockGuard("addSubDirectory " + newPath.string());
+                AutoLock lock(mutex);
 
                 // it is possible that someone hits remove while the container is being scanned
                 // in this case we will invalidate the autoscan entry
@@ -769,8 +1266,8 @@ void ContentManager::_rescanDirectory(std::shared_ptr<AutoscanDirectory>& adir,
                 asSetting.recursive = true;
                 asSetting.rescanResource = false;
                 asSetting.mergeOptions(config, newPath);
-                // const fs::path& path, const fs::path& rootpath, AutoScanSetting& asSetting, bool async, bool lowPriority, unsigned int parentTaskID, bool cancellable
-                addFileInternal(dirEnt, rootpath, asSetting, true, true, thisTaskID, task->isCancellable());
+                // const fs::path& path, const fs::path& rootpath, AutoScanSetting& asSetting, bool async, TaskPriority priority, unsigned int parentTaskID, bool cancellable
+                addFileInternal(dirEnt, rootpath, asSetting, true, priority, thisTaskID, task->isCancellable());
                 log_debug("addSubDirectory {} done", newPath.c_str());
             }
         }
@@ -784,17 +1281,18 @@ void ContentManager::_rescanDirectory(std::shared_ptr<AutoscanDirectory>& adir,
     if ((shutdownFlag) || ((task != nullptr) && !task->isValid())) {
         return;
     }
-    if (list != nullptr && !list->empty()) {
-        auto changedContainers = database->removeObjects(list);
-        if (changedContainers != nullptr) {
-            session_manager->containerChangedUI(changedContainers->ui);
-            update_manager->containersChanged(changedContainers->upnp);
-        }
-    }
+    if (list != nullptr && !list->empty())
+        adir->addStaleObjects(*list);
+
+    // the directory was listed completely
+    if (!mtimeEc)
+        adir->addListedDirectory(containerID, dirMTime);
+    removeStaleObjects(adir);
 }
 
 /* scans the given directory and adds everything recursively */
-void ContentManager::addRecursive(std::shared_ptr<AutoscanDirectory>& adir, const fs::directory_entry& subDir, bool followSymlinks, bool hidden, const std::shared_ptr<CMAddFileTask>& task)
+void ContentManager::addRecursive(std::shared_ptr<AutoscanDirectory>& adir, const fs::directory_entry& subDir, bool followSymlinks, bool hidden, const std::shared_ptr<CMAddFileTask>& task,
+    std::future<std::vector<ListedEntry>> listing)
 {
     auto f2i = StringConverter::f2i(config);
 
@@ -840,19 +1338,65 @@ void ContentManager::addRecursive(std::shared_ptr<AutoscanDirectory>& adir, cons
         last_modified_new_max = last_modified_current_max;
         adir->setCurrentLMT(subDir.path(), 0);
     }
-    auto dIter = fs::directory_iterator(subDir, ec);
-    if (ec) {
-        log_error("addRecursive: Failed to iterate {}, {}", subDir.path().c_str(), ec.message());
+    std::vector<ListedEntry> entries;
+    try {
+        if (listing.valid()) {
+            entries = listing.get();
+        } else {
+            ImportStatistics::StageTimer stageTimer(importStatistics.get(), ImportStatistics::Stage::Listing);
+            entries = listDirectory(subDir.path(), followSymlinks);
+        }
+    } catch (const std::runtime_error& e) {
+        log_error("addRecursive: Failed to iterate {}, {}", subDir.path().c_str(), e.what());
+        return;
+    } catch (const std::future_error& e) {
+        // the listing was dropped by shutdown()
         return;
     }
+    // the total grows with every directory the walk lists
+    if (task != nullptr)
+        task->addItemsTotal(std::count_if(entries.begin(), entries.end(), [=](auto&& entry) {
+            return S_ISREG(entry.st.st_mode) && (followSymlinks || !entry.isSymlink) && (hidden || entry.path.filename().string()[0] != '.');
+        }));
+
+    // the import workers list the next subdirectories while this one is processed
+    std::size_t nextPrefetch = 0;
+    std::unordered_map<std::size_t, std::future<std::vector<ListedEntry>>> prefetched;
+    auto prefetch = [&]() {
+        for (; prefetched.size() < DIRECTORY_PREFETCH_COUNT && nextPrefetch < entries.size(); nextPrefetch++) {
+            const auto& entry = entries.at(nextPrefetch);
+            if (!S_ISDIR(entry.st.st_mode) || (entry.isSymlink && !followSymlinks) || (entry.path.filename().string()[0] == '.' && !hidden))
+                continue;
+            prefetched.emplace(nextPrefetch, queueImportJob([this, path = entry.path, followSymlinks] {
+                ImportStatistics::StageTimer stageTimer(importStatistics.get(), ImportStatistics::Stage::Listing);
+                return listDirectory(path, followSymlinks);
+            }));
+        }
+    };
 
     bool firstChild = true;
-    for (const auto& subDirEnt : dIter) {
-        const auto& newPath = subDirEnt.path();
+    fs::path batchRootPath("");
+    std::vector<std::shared_ptr<CdsObject>> batch;
+    std::deque<PendingImport> pending;
+    auto batchStart = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < entries.size(); i++) {
+        const auto& entry = entries.at(i);
+        const auto& newPath = entry.path;
         const auto& name = newPath.filename().string();
         if (name[0] == '.' && !hidden) {
             continue;
         }
+        if (entry.isSymlink && !followSymlinks) {
+            log_debug("Link to file or directory ignored: {}", newPath.c_str());
+            continue;
+        }
+        std::future<std::vector<ListedEntry>> subListing;
+        auto ahead = prefetched.find(i);
+        if (ahead != prefetched.end()) {
+            subListing = std::move(ahead->second);
+            prefetched.erase(ahead);
+        }
+        prefetch();
         if ((shutdownFlag) || ((task != nullptr) && !task->isValid()))
             break;
 
@@ -862,32 +1406,64 @@ void ContentManager::addRecursive(std::shared_ptr<AutoscanDirectory>& adir, cons
         // For the Web UI
         if (task != nullptr) {
             task->setDescription(fmt::format("Importing: {}", newPath.c_str()));
+            if (S_ISREG(entry.st.st_mode))
+                task->addItemsDone(1, entry.st.st_size);
         }
 
         try {
             fs::path rootPath("");
-            // check database if parent, process existing
-            auto obj = createSingleItem(subDirEnt, rootPath, followSymlinks, (parentID > 0), true, firstChild, task);
+            if (batch.empty() && pending.empty())
+                batchStart = std::chrono::steady_clock::now();
 
-            if (obj != nullptr) {
-                firstChild = false;
-                auto lwt = to_time_t(subDirEnt.last_write_time(ec));
-                if (last_modified_current_max < lwt) {
-                    last_modified_new_max = lwt;
+            // check database if parent, process existing
+            auto obj = (parentID > 0) ? database->findObjectByPath(newPath) : nullptr;
+            auto lwt = entry.st.st_mtime;
+            if (obj == nullptr && S_ISREG(entry.st.st_mode)) {
+                // new file, the import workers read its metadata while the walk goes on
+                pending.emplace_back(newPath, extractObjectFromFile(newPath, followSymlinks));
+            } else {
+                auto subDirEnt = fs::directory_entry(newPath, ec);
+                if (obj == nullptr) {
+                    obj = createSingleItem(subDirEnt, rootPath, followSymlinks, false, true, firstChild, task, &batch);
+                    if (obj == nullptr)
+                        continue;
+                } else if (obj->isItem()) {
+                    MetadataHandler::setMetadata(context, std::static_pointer_cast<CdsItem>(obj), subDirEnt);
+                    processLayout(obj, rootPath, task);
                 }
-                if (obj->isItem()) {
+
+                if (obj->isItem() && obj->getID() != INVALID_OBJECT_ID) {
                     parentID = obj->getParentID();
                 }
                 if (obj->isContainer()) {
-                    addRecursive(adir, subDirEnt, followSymlinks, hidden, task);
+                    addRecursive(adir, subDirEnt, followSymlinks, hidden, task, std::move(subListing));
                 }
             }
+            firstChild = false;
+            if (last_modified_current_max < lwt) {
+                last_modified_new_max = lwt;
+            }
+            if (pending.size() + batch.size() >= IMPORT_BATCH_SIZE || std::chrono::steady_clock::now() - batchStart >= std::chrono::milliseconds(IMPORT_BATCH_INTERVAL)) {
+                collectPendingImports(pending, batch);
+                flushImportBatch(batch, batchRootPath, task);
+            }
         } catch (const std::runtime_error& ex) {
             log_warning("skipping {} (ex:{})", newPath.c_str(), ex.what());
         }
     }
+    collectPendingImports(pending, batch);
+    flushImportBatch(batch, batchRootPath, task);
 
     finishScan(adir, subDir.path(), parentContainer, last_modified_new_max);
+
+    // the directory was listed completely, so a resumed scan can skip it
+    if (adir != nullptr && !shutdownFlag && (task == nullptr || task->isValid())) {
+        std::error_code mtimeEc;
+        auto dirMTime = to_time_t(subDir.last_write_time(mtimeEc));
+        int containerID = parentID != INVALID_OBJECT_ID ? parentID : database->findObjectIDByPath(subDir.path());
+        if (!mtimeEc && containerID != INVALID_OBJECT_ID)
+            database->setDirectoryState(containerID, dirMTime);
+    }
 }
 
 void ContentManager::finishScan(const std::shared_ptr<AutoscanDirectory>& adir, const std::string& location, std::shared_ptr<CdsContainer>& parent, time_t lmt)
@@ -1029,6 +1605,9 @@ void ContentManager::addObject(const std::shared_ptr<CdsObject>& obj, bool first
     int containerChanged = INVALID_OBJECT_ID;
     log_debug("Adding: parent ID is {}", obj->getParentID());
 
+    if (pretranscodeQueue != nullptr && obj->isItem())
+        pretranscodeQueue->mark(std::static_pointer_cast<CdsItem>(obj));
+
     database->addObject(obj, &containerChanged);
     log_debug("After adding: parent ID is {}", obj->getParentID());
 
@@ -1056,6 +1635,27 @@ void ContentManager::addContainer(int parentID, std::string title, const std::st
     addContainerChain(database->buildContainerPath(parentID, escape(std::move(title), VIRTUAL_CONTAINER_ESCAPE, VIRTUAL_CONTAINER_SEPARATOR)), upnpClass);
 }
 
+std::string ContentManager::mapContainerChain(const std::string& chain)
+{
+    std::lock_guard<std::mutex> lock(mappedChainsMutex);
+    if (layoutMappings.empty())
+        return chain;
+
+    auto mapped = mappedChains.find(chain);
+    if (mapped != mappedChains.end())
+        return mapped->second;
+
+    std::string newChain = chain;
+    for (const auto& [pattern, replacement] : layoutMappings) {
+        newChain = std::regex_replace(newChain, pattern, replacement);
+    }
+    // the builtin layout creates a handful of chains per artist and album, start over instead of growing without bounds
+    if (mappedChains.size() >= 10000)
+        mappedChains.clear();
+    mappedChains.emplace(chain, newChain);
+    return newChain;
+}
+
 std::pair<int, bool> ContentManager::addContainerTree(const std::vector<std::shared_ptr<CdsObject>>& chain)
 {
     std::string tree;
@@ -1070,19 +1670,22 @@ std::pair<int, bool> ContentManager::addContainerTree(const std::vector<std::sha
         }
         tree = fmt::format("{}{}{}", tree, VIRTUAL_CONTAINER_SEPARATOR, item->getTitle());
         log_debug("Received chain item {}", tree);
-        for (const auto& [key, val] : config->getDictionaryOption(CFG_IMPORT_LAYOUT_MAPPING)) {
-            tree = std::regex_replace(tree, std::regex(key), val);
-        }
-        if (!containerMap.count(tree)) {
+        tree = mapContainerChain(tree);
+        auto path = layoutRoot + tree;
+        result = containerCache.get(path);
+        if (result == INVALID_OBJECT_ID) {
             item->setMetadata(M_TITLE, item->getTitle());
-            database->addContainerChain(tree, item->getClass(), INVALID_OBJECT_ID, &result, createdIds, item->getMetadata());
-            auto container = std::dynamic_pointer_cast<CdsContainer>(database->loadObject(result));
-            containerMap[tree] = container;
+            ImportStatistics::StageTimer stageTimer(importStatistics.get(), ImportStatistics::Stage::ContainerChain);
+            database->addContainerChain(path, item->getClass(), INVALID_OBJECT_ID, &result, createdIds, item->getMetadata());
+            containerCache.put(path, result);
             isNew = true;
-        } else {
-            result = containerMap[tree]->getID();
         }
-        assignFanArt({ containerMap[tree] }, item);
+        // most items land in containers whose art is settled already, they do not have to be loaded
+        auto art = containerCache.getArt(result);
+        if (art == ContainerCache::Art::Assigned || (art == ContainerCache::Art::NoFile && !hasAlbumArt(item)))
+            continue;
+        auto container = std::dynamic_pointer_cast<CdsContainer>(database->loadObject(result));
+        assignFanArt({ container }, item);
     }
 
     if (!createdIds.empty()) {
@@ -1101,10 +1704,7 @@ std::pair<int, bool> ContentManager::addContainerChain(const std::string& chain,
     if (chain.empty())
         throw_std_runtime_error("addContainerChain() called with empty chain parameter");
 
-    std::string newChain = chain;
-    for (const auto& [key, val] : config->getDictionaryOption(CFG_IMPORT_LAYOUT_MAPPING)) {
-        newChain = std::regex_replace(newChain, std::regex(key), val);
-    }
+    std::string newChain = layoutRoot + mapContainerChain(chain);
 
     log_debug("Received chain: {} -> {} ({}) [{}]", chain.c_str(), newChain.c_str(), lastClass.c_str(), dictEncodeSimple(lastMetadata).c_str());
     // copy artist to album artist if empty
@@ -1121,24 +1721,28 @@ std::pair<int, bool> ContentManager::addContainerChain(const std::string& chain,
             lastMetadata.erase(itm);
         }
     }
-    int containerID = INVALID_OBJECT_ID;
-    std::vector<std::shared_ptr<CdsContainer>> containerList;
-    if (!containerMap.count(newChain)) {
+    std::unique_lock<std::mutex> chainLock(containerChainMutex);
+    int containerID = containerCache.get(newChain);
+    if (containerID == INVALID_OBJECT_ID) {
         lastMetadata[MetadataHandler::getMetaFieldName(M_TITLE)] = splitString(newChain, '/').back();
+        ImportStatistics::StageTimer stageTimer(importStatistics.get(), ImportStatistics::Stage::ContainerChain);
         database->addContainerChain(newChain, lastClass, lastRefID, &containerID, updateID, lastMetadata);
-
-        for (const auto& contId : updateID) {
-            auto container = std::dynamic_pointer_cast<CdsContainer>(database->loadObject(contId));
-            containerMap[container->getLocation()] = container;
-            containerList.emplace_back(container);
-        }
+        containerCache.put(newChain, containerID);
         isNew = true;
-    } else {
-        containerID = containerMap[newChain]->getID();
-        containerList.emplace_back(containerMap[newChain]);
     }
 
     if (!updateID.empty()) {
+        // the created containers are the last ones of the chain, so the chains of their parents are known without loading them
+        auto path = reduceString(newChain, VIRTUAL_CONTAINER_SEPARATOR);
+        std::vector<std::shared_ptr<CdsContainer>> containerList;
+        for (const auto& contId : updateID) {
+            containerCache.put(path, contId);
+            std::string title;
+            Database::stripAndUnescapeVirtualContainerFromPath(path, path, title);
+            if (origObj != nullptr)
+                containerList.emplace_back(std::dynamic_pointer_cast<CdsContainer>(database->loadObject(contId)));
+        }
+        chainLock.unlock();
         assignFanArt(containerList, origObj);
         update_manager->containerChanged(updateID.back());
         session_manager->containerChangedUI(updateID.back());
@@ -1147,18 +1751,30 @@ std::pair<int, bool> ContentManager::addContainerChain(const std::string& chain,
     return { containerID, isNew };
 }
 
+bool ContentManager::hasAlbumArt(const std::shared_ptr<CdsObject>& obj)
+{
+    const auto& resources = obj->getResources();
+    return std::any_of(resources.begin(), resources.end(), [](const auto& res) { return res->isMetaResource(ID3_ALBUM_ART); });
+}
+
 void ContentManager::assignFanArt(const std::vector<std::shared_ptr<CdsContainer>>& containerList, const std::shared_ptr<CdsObject>& origObj)
 {
     if (origObj != nullptr) {
         int count = 0;
         for (auto& container : containerList) {
+            auto art = containerCache.getArt(container->getID());
+            if (art == ContainerCache::Art::Assigned) {
+                count++;
+                continue;
+            }
+            bool changed = false;
             const std::vector<std::shared_ptr<CdsResource>>& resources = container->getResources();
             auto fanart = std::find_if(resources.begin(), resources.end(), [=](const auto& res) { return res->isMetaResource(ID3_ALBUM_ART); });
-            if (fanart == resources.end()) {
+            if (fanart == resources.end() && art == ContainerCache::Art::Unknown) {
+                // searches the file system, only done once per container
                 MetadataHandler::createHandler(context, CH_CONTAINERART)->fillMetadata(container);
-                int containerChanged = INVALID_OBJECT_ID;
-                database->updateObject(container, &containerChanged);
                 fanart = std::find_if(resources.begin(), resources.end(), [=](const auto& res) { return res->isMetaResource(ID3_ALBUM_ART); });
+                changed = fanart != resources.end();
             }
             auto location = container->getLocation().string();
             if (fanart != resources.end() && (*fanart)->getHandlerType() != CH_CONTAINERART) {
@@ -1171,21 +1787,26 @@ void ContentManager::assignFanArt(const std::vector<std::shared_ptr<CdsContainer
                 } catch (const ObjectNotFoundException& e) {
                     container->removeResource((*fanart)->getHandlerType());
                     fanart = resources.end();
+                    changed = true;
                 }
             }
-            if (fanart == resources.end() && (origObj->isContainer() || (count < config->getIntOption(CFG_IMPORT_RESOURCES_CONTAINERART_PARENTCOUNT) && container->getParentID() != CDS_ID_ROOT && std::count(location.begin(), location.end(), '/') > config->getIntOption(CFG_IMPORT_RESOURCES_CONTAINERART_MINDEPTH)))) {
+            if (fanart == resources.end() && (origObj->isContainer() || (count < containerArtParentCount && container->getParentID() != CDS_ID_ROOT && std::count(location.begin(), location.end(), '/') > containerArtMinDepth))) {
                 const std::vector<std::shared_ptr<CdsResource>>& origResources = origObj->getResources();
-                fanart = std::find_if(origResources.begin(), origResources.end(), [=](const auto& res) { return res->isMetaResource(ID3_ALBUM_ART); });
-                if (fanart != origResources.end()) {
-                    if ((*fanart)->getAttribute(R_RESOURCE_FILE).empty()) {
-                        (*fanart)->addAttribute(R_FANART_OBJ_ID, fmt::to_string(origObj->getID() != INVALID_OBJECT_ID ? origObj->getID() : origObj->getRefID()));
-                        (*fanart)->addAttribute(R_FANART_RES_ID, fmt::to_string(fanart - origResources.begin()));
+                auto origArt = std::find_if(origResources.begin(), origResources.end(), [=](const auto& res) { return res->isMetaResource(ID3_ALBUM_ART); });
+                if (origArt != origResources.end()) {
+                    if ((*origArt)->getAttribute(R_RESOURCE_FILE).empty()) {
+                        (*origArt)->addAttribute(R_FANART_OBJ_ID, fmt::to_string(origObj->getID() != INVALID_OBJECT_ID ? origObj->getID() : origObj->getRefID()));
+                        (*origArt)->addAttribute(R_FANART_RES_ID, fmt::to_string(origArt - origResources.begin()));
                     }
-                    container->addResource(*fanart);
+                    container->addResource(*origArt);
+                    changed = true;
                 }
+            }
+            if (changed) {
                 int containerChanged = INVALID_OBJECT_ID;
                 database->updateObject(container, &containerChanged);
             }
+            containerCache.setArt(container->getID(), hasAlbumArt(container) ? ContainerCache::Art::Assigned : ContainerCache::Art::NoFile);
             count++;
         }
     }
@@ -1195,10 +1816,13 @@ void ContentManager::updateObject(const std::shared_ptr<CdsObject>& obj, bool se
 {
     obj->validate();
 
+    if (pretranscodeQueue != nullptr && obj->isItem())
+        pretranscodeQueue->mark(std::static_pointer_cast<CdsItem>(obj));
+
     int containerChanged = INVALID_OBJECT_ID;
-    database->updateObject(obj, &containerChanged);
+    bool changed = database->updateObject(obj, &containerChanged);
 
-    if (send_updates) {
+    if (send_updates && changed) {
         update_manager->containerChanged(containerChanged);
         session_manager->containerChangedUI(containerChanged);
 
@@ -1223,19 +1847,24 @@ std::shared_ptr<CdsObject> ContentManager::createObjectFromFile(const fs::direct
     std::shared_ptr<CdsObject> obj;
     if (isRegularFile(dirEnt, ec) || (allow_fifo && dirEnt.is_fifo(ec))) { // item
         /* retrieve information about item and decide if it should be included */
-        std::string mimetype = mime->getMimeType(dirEnt.path(), MIMETYPE_DEFAULT);
-        if (mimetype.empty()) {
-            return nullptr;
-        }
-        log_debug("Mime '{}' for file {}", mimetype, dirEnt.path().c_str());
-
-        std::string upnp_class = mime->mimeTypeToUpnpClass(mimetype);
-        if (upnp_class.empty()) {
-            std::string content_type = getValueOrDefault(mimetype_contenttype_map, mimetype);
-            if (content_type == CONTENT_TYPE_OGG) {
-                upnp_class = isTheora(dirEnt.path())
-                    ? UPNP_CLASS_VIDEO_ITEM
-                    : UPNP_CLASS_MUSIC_TRACK;
+        std::string mimetype;
+        std::string upnp_class;
+        {
+            ImportStatistics::StageTimer stageTimer(importStatistics.get(), ImportStatistics::Stage::Mime);
+            mimetype = mime->getMimeType(dirEnt.path(), MIMETYPE_DEFAULT);
+            if (mimetype.empty()) {
+                return nullptr;
+            }
+            log_debug("Mime '{}' for file {}", mimetype, dirEnt.path().c_str());
+
+            upnp_class = mime->mimeTypeToUpnpClass(mimetype);
+            if (upnp_class.empty()) {
+                std::string content_type = getValueOrDefault(mimetype_contenttype_map, mimetype);
+                if (content_type == CONTENT_TYPE_OGG) {
+                    upnp_class = isTheora(dirEnt.path())
+                        ? UPNP_CLASS_VIDEO_ITEM
+                        : UPNP_CLASS_MUSIC_TRACK;
+                }
             }
         }
         log_debug("UpnpClass '{}' for file {}", upnp_class, dirEnt.path().c_str());
@@ -1255,13 +1884,16 @@ std::shared_ptr<CdsObject> ContentManager::createObjectFromFile(const fs::direct
 
         auto f2i = StringConverter::f2i(config);
         auto title = dirEnt.path().filename().string();
-        if (config->getBoolOption(CFG_IMPORT_READABLE_NAMES) && upnp_class != UPNP_CLASS_ITEM) {
+        if (readableNames && upnp_class != UPNP_CLASS_ITEM) {
             title = dirEnt.path().stem().string();
             title = replaceAllString(title, "_", " ");
         }
         obj->setTitle(f2i->convert(title));
 
-        MetadataHandler::setMetadata(context, item, dirEnt);
+        if (lazyMetadata)
+            MetadataHandler::setBasicMetadata(item, dirEnt);
+        else
+            MetadataHandler::setMetadata(context, item, dirEnt, duplicates.get(), directories.get());
     } else if (dirEnt.is_directory(ec)) {
         auto cont = std::make_shared<CdsContainer>();
         obj = cont;
@@ -1288,7 +1920,7 @@ std::shared_ptr<CdsObject> ContentManager::createObjectFromFile(const fs::direct
 void ContentManager::initLayout()
 {
     if (layout == nullptr) {
-        auto lock = threadRunner->lockGuard("initLayout");
+        AutoLock lock(mutex);
         if (layout == nullptr) {
             std::string layout_type = config->getOption(CFG_IMPORT_SCRIPTING_VIRTUAL_LAYOUT_TYPE);
             auto self = shared_from_this();
@@ -1301,6 +1933,8 @@ void ContentManager::initLayout()
 #endif
                 } else if (layout_type == "builtin") {
                     layout = std::make_shared<BuiltinLayout>(self);
+                } else if (layout_type == "template") {
+                    layout = std::make_shared<TemplateLayout>(self);
                 }
             } catch (const std::runtime_error& e) {
                 layout = nullptr;
@@ -1312,10 +1946,26 @@ void ContentManager::initLayout()
     }
 }
 
+void ContentManager::parsePlaylist(const std::shared_ptr<CdsObject>& obj, const std::string& mimetype, const std::shared_ptr<CMAddFileTask>& task)
+{
+#ifdef HAVE_JS
+    if (playlist_parser_script != nullptr) {
+        playlist_parser_script->processPlaylistObject(obj, task);
+        return;
+    }
+#endif // JS
+    if (PlaylistParser::canParse(mimetype))
+        playlist_parser->processPlaylistObject(obj, task);
+    else
+        log_warning("Playlist {} will not be parsed: only m3u and pls are read without a playlist script", obj->getLocation().c_str());
+}
+
 #ifdef HAVE_JS
 void ContentManager::initJS()
 {
-    if (playlist_parser_script == nullptr) {
+    // m3u and pls are read by the playlist parser, a script only runs if it is not the default one
+    auto scriptSetup = ConfigManager::findConfigSetup(CFG_IMPORT_SCRIPTING_PLAYLIST_SCRIPT);
+    if (playlist_parser_script == nullptr && config->getOption(CFG_IMPORT_SCRIPTING_PLAYLIST_SCRIPT) != scriptSetup->getDefaultValue()) {
         auto self = shared_from_this();
         playlist_parser_script = std::make_unique<PlaylistParserScript>(self, scripting_runtime);
     }
@@ -1342,102 +1992,148 @@ void ContentManager::reloadLayout()
 #endif // HAVE_JS
 }
 
-void ContentManager::threadProc()
+void ContentManager::rebuildLayout()
 {
-    std::shared_ptr<GenericTask> task;
-    auto lock = threadRunner->uniqueLock();
-    working = true;
-    while (!shutdownFlag) {
-        currentTask = nullptr;
-
-        task = nullptr;
-        if (!taskQueue1.empty()) {
-            task = taskQueue1.front();
-            taskQueue1.pop_front();
-        } else if (!taskQueue2.empty()) {
-            task = taskQueue2.front();
-            taskQueue2.pop_front();
-        }
-
-        if (task == nullptr) {
-            working = false;
-            /* if nothing to do, sleep until awakened */
-            threadRunner->wait(lock);
-            working = true;
-            continue;
-        }
+    auto self = shared_from_this();
+    auto task = std::make_shared<CMRebuildLayoutTask>(self);
+    task->setDescription("Rebuilding the virtual layout");
+    task->setGroup("layout");
+    addTask(task);
+}
 
-        currentTask = task;
-        lock.unlock();
+void ContentManager::_rebuildLayout(const std::shared_ptr<GenericTask>& task)
+{
+    // in the task thread, so no import uses the old layout at the same time
+    reloadLayout();
+    if (layout == nullptr) {
+        log_warning("No layout configured, nothing to rebuild");
+        return;
+    }
 
-        // log_debug("content manager Async START {}", task->getDescription().c_str());
-        try {
-            if (task->isValid())
-                task->run();
-        } catch (const ServerShutdownException& se) {
-            shutdownFlag = true;
-        } catch (const std::runtime_error& e) {
-            log_error("Exception caught: {}", e.what());
+    auto autoscanDirs = getAutoscanDirectories();
+    auto getRootPath = [&](const fs::path& location) {
+        fs::path rootPath;
+        for (auto&& adir : autoscanDirs) {
+            auto&& dir = adir->getLocation();
+            if (startswith(location.string(), dir.string()) && dir.string().size() > rootPath.string().size())
+                rootPath = dir;
         }
-        // log_debug("content manager ASYNC STOP  {}", task->getDescription().c_str());
+        return rootPath;
+    };
+
+    int shadowID = database->addShadowContainer(LAYOUT_REBUILD_TITLE);
+    {
+        std::lock_guard<std::mutex> lock(containerChainMutex);
+        containerCache.clear();
+        layoutRoot = fmt::format("{}{}", VIRTUAL_CONTAINER_SEPARATOR, LAYOUT_REBUILD_TITLE);
+    }
+    auto finish = [&] {
+        std::lock_guard<std::mutex> lock(containerChainMutex);
+        layoutRoot.clear();
+        containerCache.clear();
+    };
 
-        if (!shutdownFlag) {
-            lock.lock();
+    std::size_t count = 0;
+    try {
+        int lastID = INVALID_OBJECT_ID;
+        for (auto ids = database->getItemIDs(lastID, LAYOUT_REBUILD_CHUNK); !ids.empty(); ids = database->getItemIDs(lastID, LAYOUT_REBUILD_CHUNK)) {
+            for (int objectID : ids) {
+                if (shutdownFlag || !task->isValid())
+                    throw_std_runtime_error("rebuild of the layout was cancelled");
+                lastID = objectID;
+
+                try {
+                    auto obj = database->loadObject(objectID);
+                    // pending items are laid out once their metadata is read
+                    if (!obj->isItem() || obj->getFlag(OBJECT_FLAG_PENDING_METADATA))
+                        continue;
+                    auto rootPath = getRootPath(obj->getLocation());
+                    processLayout(obj, rootPath, nullptr);
+                    count++;
+                } catch (const ObjectNotFoundException& e) {
+                    log_debug("Item {} was removed during the rebuild of the layout", objectID);
+                }
+            }
         }
+    } catch (const std::runtime_error& e) {
+        log_warning("Keeping the old layout: {}", e.what());
+        finish();
+        database->removeObject(shadowID, false);
+        return;
     }
 
-    database->threadCleanup();
+    {
+        std::lock_guard<std::mutex> lock(containerChainMutex);
+        database->swapShadowContainer(shadowID);
+    }
+    finish();
+    update_manager->containerChanged(CDS_ID_ROOT);
+    session_manager->containerChangedUI(CDS_ID_ROOT);
+    log_info("Rebuilt the layout of {} items", count);
+}
+
+void ContentManager::importThreadProc()
+{
+    std::unique_lock<std::mutex> lock(importMutex);
+    while (!shutdownFlag) {
+        if (importQueue.empty()) {
+            importCond.wait(lock);
+            continue;
+        }
+        auto job = std::move(importQueue.front());
+        importQueue.pop_front();
+        lock.unlock();
+
+        // exceptions are passed to the waiting task thread by the future
+        job();
+
+        lock.lock();
+    }
 }
 
-void* ContentManager::staticThreadProc(void* arg)
+void* ContentManager::staticImportThreadProc(void* arg)
 {
     auto inst = static_cast<ContentManager*>(arg);
-    inst->threadProc();
+    inst->importThreadProc();
     return nullptr;
 }
 
-void ContentManager::addTask(const std::shared_ptr<GenericTask>& task, bool lowPriority)
+void ContentManager::addTask(const std::shared_ptr<GenericTask>& task, TaskPriority priority)
 {
-    auto lock = threadRunner->lockGuard("addTask");
-
-    task->setID(taskID++);
-
-    if (!lowPriority)
-        taskQueue1.push_back(task);
-    else
-        taskQueue2.push_back(task);
-    threadRunner->notify();
+    scheduler->addTask(task, priority);
 }
 
-int ContentManager::addFile(const fs::directory_entry& dirEnt, AutoScanSetting& asSetting, bool async, bool lowPriority, bool cancellable)
+int ContentManager::addFile(const fs::directory_entry& dirEnt, AutoScanSetting& asSetting, bool async, TaskPriority priority, bool cancellable)
 {
     fs::path rootpath;
     if (dirEnt.is_directory())
         rootpath = dirEnt.path();
-    return addFileInternal(dirEnt, rootpath, asSetting, async, lowPriority, 0, cancellable);
+    return addFileInternal(dirEnt, rootpath, asSetting, async, priority, 0, cancellable);
 }
 
-int ContentManager::addFile(const fs::directory_entry& dirEnt, const fs::path& rootpath, AutoScanSetting& asSetting, bool async, bool lowPriority, bool cancellable)
+int ContentManager::addFile(const fs::directory_entry& dirEnt, const fs::path& rootpath, AutoScanSetting& asSetting, bool async, TaskPriority priority, bool cancellable)
 {
-    return addFileInternal(dirEnt, rootpath, asSetting, async, lowPriority, 0, cancellable);
+    return addFileInternal(dirEnt, rootpath, asSetting, async, priority, 0, cancellable);
 }
 
 int ContentManager::addFileInternal(
-    const fs::directory_entry& dirEnt, const fs::path& rootpath, AutoScanSetting& asSetting, bool async, bool lowPriority, unsigned int parentTaskID, bool cancellable)
+    const fs::directory_entry& dirEnt, const fs::path& rootpath, AutoScanSetting& asSetting, bool async, TaskPriority priority, unsigned int parentTaskID, bool cancellable)
 {
     if (async) {
         auto self = shared_from_this();
         auto task = std::make_shared<CMAddFileTask>(self, dirEnt, rootpath, asSetting, cancellable);
         task->setDescription(fmt::format("Importing: {}", dirEnt.path().c_str()));
         task->setParentID(parentTaskID);
-        addTask(task, lowPriority);
+        if (asSetting.adir != nullptr)
+            task->setGroup(asSetting.adir->getLocation());
+        addTask(task, priority);
         return INVALID_OBJECT_ID;
     }
     return _addFile(dirEnt, rootpath, asSetting);
 }
 
 #ifdef ONLINE_SERVICES
-void ContentManager::fetchOnlineContent(service_type_t serviceType, bool lowPriority, bool cancellable, bool unscheduled_refresh)
+void ContentManager::fetchOnlineContent(service_type_t serviceType, TaskPriority priority, bool cancellable, bool unscheduled_refresh)
 {
     auto service = online_services->getService(serviceType);
     if (service == nullptr) {
@@ -1448,11 +2144,12 @@ void ContentManager::fetchOnlineContent(service_type_t serviceType, bool lowPrio
     unsigned int parentTaskID = 0;
 
     auto self = shared_from_this();
-    auto task = std::make_shared<CMFetchOnlineContentTask>(self, task_processor, timer, service, layout, cancellable, unscheduled_refresh);
+    auto task = std::make_shared<CMFetchOnlineContentTask>(self, scheduler, timer, service, layout, cancellable, unscheduled_refresh);
     task->setDescription("Updating content from " + service->getServiceName());
     task->setParentID(parentTaskID);
+    task->setGroup(service->getServiceName());
     service->incTaskCount();
-    addTask(task, lowPriority);
+    addTask(task, priority);
 }
 
 void ContentManager::cleanupOnlineServiceObjects(const std::shared_ptr<OnlineService>& service)
@@ -1460,28 +2157,15 @@ void ContentManager::cleanupOnlineServiceObjects(const std::shared_ptr<OnlineSer
     log_debug("Finished fetch cycle for service: {}", service->getServiceName().c_str());
 
     if (service->getItemPurgeInterval() > 0) {
-        auto ids = database->getServiceObjectIDs(service->getDatabasePrefix());
-
-        auto current = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-        int64_t last = 0;
-        std::string temp;
-
-        for (int object_id : *ids) {
-            auto obj = database->loadObject(object_id);
-            if (obj == nullptr)
-                continue;
-
-            temp = obj->getAuxData(ONLINE_SERVICE_LAST_UPDATE);
-            if (temp.empty())
-                continue;
-
-            last = std::stoll(temp);
+        auto stale = std::make_unique<std::unordered_set<int>>(service->takeStaleObjects());
+        if (stale->empty())
+            return;
 
-            if ((service->getItemPurgeInterval() > 0) && ((current - last) > service->getItemPurgeInterval())) {
-                log_debug("Purging old online service object {}", obj->getTitle().c_str());
-                removeObject(nullptr, object_id, false);
-            }
-        }
+        log_debug("Purging {} old {} objects", stale->size(), service->getServiceName());
+        containerCache.clear();
+        auto changedContainers = database->removeObjects(stale);
+        if (changedContainers != nullptr)
+            notifyChangedContainers(changedContainers->ui, changedContainers->upnp);
     }
 }
 
@@ -1499,33 +2183,9 @@ void ContentManager::invalidateAddTask(const std::shared_ptr<GenericTask>& t, co
     }
 }
 
-void ContentManager::invalidateTask(unsigned int taskID, task_owner_t taskOwner)
+void ContentManager::invalidateTask(unsigned int taskID)
 {
-    if (taskOwner == ContentManagerTask) {
-        auto lock = threadRunner->lockGuard("invalidateTask");
-        auto tc = getCurrentTask();
-        if (tc != nullptr) {
-            if ((tc->getID() == taskID) || (tc->getParentID() == taskID)) {
-                tc->invalidate();
-            }
-        }
-
-        for (const auto& t1 : taskQueue1) {
-            if ((t1->getID() == taskID) || (t1->getParentID() == taskID)) {
-                t1->invalidate();
-            }
-        }
-
-        for (const auto& t2 : taskQueue2) {
-            if ((t2->getID() == taskID) || (t2->getParentID() == taskID)) {
-                t2->invalidate();
-            }
-        }
-    }
-#ifdef ONLINE_SERVICES
-    else if (taskOwner == TaskProcessorTask)
-        task_processor->invalidateTask(taskID);
-#endif
+    scheduler->invalidateTask(taskID);
 }
 
 void ContentManager::removeObject(const std::shared_ptr<AutoscanDirectory>& adir, int objectID, bool rescanResource, bool async, bool all)
@@ -1569,31 +2229,193 @@ void ContentManager::removeObject(const std::shared_ptr<AutoscanDirectory>& adir
             }
 #endif
 
-            auto lock = threadRunner->lockGuard("removeObject " + path.string());
+            AutoLock lock(mutex);
 
             // we have to make sure that a currently running autoscan task will not
             // launch add tasks for directories that anyway are going to be deleted
-            for (const auto& t : taskQueue1) {
-                invalidateAddTask(t, path);
-            }
+            scheduler->forEachTask([&](const auto& t) { invalidateAddTask(t, path); });
+        }
+
+        if (adir != nullptr)
+            task->setGroup(adir->getLocation());
+        addTask(task);
+    } else {
+        _removeObject(adir, objectID, rescanResource, all);
+    }
+}
 
-            for (const auto& t : taskQueue2) {
-                invalidateAddTask(t, path);
+void ContentManager::moveObject(const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& from, const fs::path& to)
+{
+    auto self = shared_from_this();
+    auto task = std::make_shared<CMMoveObjectTask>(self, adir, from, to);
+    task->setDescription(fmt::format("Moving: {}", to.c_str()));
+    task->setGroup(adir->getLocation());
+    addTask(task);
+}
+
+void ContentManager::readMetadata(const std::vector<int>& objectIDs, const fs::path& rootpath, TaskPriority priority)
+{
+    auto self = shared_from_this();
+    auto task = std::make_shared<CMReadMetadataTask>(self, objectIDs, rootpath);
+    task->setDescription(fmt::format("Reading metadata of {} items", objectIDs.size()));
+    task->setGroup("metadata");
+    addTask(task, priority);
+}
+
+void ContentManager::promoteMetadata(const std::vector<std::shared_ptr<CdsObject>>& objects)
+{
+    std::vector<int> objectIDs;
+    std::map<std::string, bool> activeDisks;
+    for (const auto& obj : objects) {
+        if (!obj->isItem() || !obj->getFlag(OBJECT_FLAG_PENDING_METADATA))
+            continue;
+        if (storageActivity) {
+            // the browse is answered from the database, it must not spin up a disk to read the file
+            auto disk = storageActivity->getDisk(obj->getLocation());
+            auto state = activeDisks.find(disk);
+            if (state == activeDisks.end())
+                state = activeDisks.emplace(disk, storageActivity->isActive(disk)).first;
+            if (!state->second)
+                continue;
+        }
+        std::lock_guard<std::mutex> lock(promotedObjectsMutex);
+        if (promotedObjects.insert(obj->getID()).second)
+            objectIDs.push_back(obj->getID());
+    }
+    if (objectIDs.empty())
+        return;
+
+    // the queued background task skips these items once they are done
+    log_debug("Reading metadata of {} requested items first", objectIDs.size());
+    readMetadata(objectIDs, "", TaskPriority::Interactive);
+}
+
+void ContentManager::_readMetadata(const std::vector<int>& objectIDs, fs::path rootpath)
+{
+    for (int objectID : objectIDs) {
+        try {
+            auto obj = database->loadObject(objectID);
+            if (!obj->isItem() || !obj->getFlag(OBJECT_FLAG_PENDING_METADATA))
+                continue;
+
+            std::error_code ec;
+            auto dirEnt = fs::directory_entry(obj->getLocation(), ec);
+            if (ec) {
+                log_warning("Failed to read {}: {}", obj->getLocation().c_str(), ec.message());
+                continue;
             }
 
-            auto t = getCurrentTask();
-            if (t != nullptr) {
-                invalidateAddTask(t, path);
+            auto item = std::static_pointer_cast<CdsItem>(obj);
+            item->setResources({});
+            MetadataHandler::setMetadata(context, item, dirEnt, duplicates.get(), directories.get());
+            item->clearFlag(OBJECT_FLAG_PENDING_METADATA);
+
+            int containerChanged = INVALID_OBJECT_ID;
+            if (database->updateObject(item, &containerChanged)) {
+                update_manager->containerChanged(item->getParentID());
+                session_manager->containerChangedUI(item->getParentID());
             }
+
+            processLayout(item, rootpath, nullptr);
+        } catch (const ObjectNotFoundException& e) {
+            log_debug("Item {} was removed before its metadata was read", objectID);
+        } catch (const std::runtime_error& e) {
+            log_warning("Failed to read metadata of item {}: {}", objectID, e.what());
         }
+    }
 
-        addTask(task);
-    } else {
-        _removeObject(adir, objectID, rescanResource, all);
+    std::lock_guard<std::mutex> lock(promotedObjectsMutex);
+    for (int objectID : objectIDs)
+        promotedObjects.erase(objectID);
+}
+
+void ContentManager::_moveObject(const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& from, const fs::path& to)
+{
+    // the rename replaced an existing entry
+    int objectID = database->findObjectIDByPath(to);
+    if (objectID != INVALID_OBJECT_ID)
+        _removeObject(adir, objectID, false, false);
+
+    containerCache.clear();
+    auto changedContainers = database->relocateSubtree(from, to);
+    if (changedContainers != nullptr) {
+        log_debug("Moved {} to {}", from.c_str(), to.c_str());
+        session_manager->containerChangedUI(changedContainers->ui);
+        update_manager->containersChanged(changedContainers->upnp);
+        return;
+    }
+
+    std::error_code ec;
+    auto dirEnt = fs::directory_entry(to, ec);
+    if (ec) {
+        log_error("Failed to read {}: {}", to.c_str(), ec.message());
+        return;
+    }
+    AutoScanSetting asSetting;
+    asSetting.adir = adir;
+    asSetting.followSymlinks = followSymlinks;
+    asSetting.recursive = adir->getRecursive();
+    asSetting.hidden = adir->getHidden();
+    asSetting.rescanResource = true;
+    asSetting.mergeOptions(config, to);
+    addFile(dirEnt, adir->getLocation(), asSetting, true, TaskPriority::Normal, false);
+}
+
+std::string ContentManager::getScanCheckpointKey(const std::shared_ptr<AutoscanDirectory>& adir)
+{
+    return fmt::format("scan_checkpoint_{}", adir->getObjectID());
+}
+
+void ContentManager::startScanCheckpoint(const std::shared_ptr<AutoscanDirectory>& adir)
+{
+    auto key = getScanCheckpointKey(adir);
+    bool resumed = !database->getInternalSetting(key).empty();
+    if (resumed)
+        log_info("Continuing the interrupted scan of {}", adir->getLocation().c_str());
+    adir->setResumed(resumed);
+    // stays set until all tasks of the scan are done
+    database->storeInternalSetting(key, fmt::to_string(std::time(nullptr)));
+}
+
+void ContentManager::finishScanCheckpoint(const std::shared_ptr<AutoscanDirectory>& adir)
+{
+    // tasks stopped by a shutdown leave the scan unfinished
+    if (shutdownFlag || adir->getTaskCount() > 0)
+        return;
+    // left over by tasks that ended early
+    removeStaleObjects(adir);
+    adir->setResumed(false);
+    database->storeInternalSetting(getScanCheckpointKey(adir), "");
+}
+
+void ContentManager::removeStaleObjects(const std::shared_ptr<AutoscanDirectory>& adir)
+{
+    // a task adds its stale objects before its directory, so taking the
+    // directories first never stores one whose objects are still there
+    auto listedDirectories = adir->takeListedDirectories();
+    auto staleObjects = adir->takeStaleObjects();
+    if (!staleObjects.empty()) {
+        log_debug("Removing {} objects missing from {}", staleObjects.size(), adir->getLocation().c_str());
+        // the removal can purge virtual containers
+        containerCache.clear();
+        auto chunk = std::make_unique<std::unordered_set<int>>();
+        for (auto it = staleObjects.begin(); it != staleObjects.end();) {
+            chunk->insert(*it);
+            it = staleObjects.erase(it);
+            if (chunk->size() < REMOVE_CHUNK_SIZE && it != staleObjects.end())
+                continue;
+            auto changedContainers = database->removeObjects(chunk);
+            if (changedContainers != nullptr)
+                notifyChangedContainers(changedContainers->ui, changedContainers->upnp);
+            chunk->clear();
+        }
     }
+
+    for (auto&& [containerID, mtime] : listedDirectories)
+        database->setDirectoryState(containerID, mtime);
 }
 
-void ContentManager::rescanDirectory(const std::shared_ptr<AutoscanDirectory>& adir, int objectId, std::string descPath, bool cancellable)
+void ContentManager::rescanDirectory(const std::shared_ptr<AutoscanDirectory>& adir, int objectId, std::string descPath, bool cancellable, TaskPriority priority)
 {
     // building container path for the description
     auto self = shared_from_this();
@@ -1605,7 +2427,8 @@ void ContentManager::rescanDirectory(const std::shared_ptr<AutoscanDirectory>& a
         descPath = adir->getLocation();
 
     task->setDescription("Scan: " + descPath);
-    addTask(task, true); // adding with low priority
+    task->setGroup(adir->getLocation());
+    addTask(task, priority);
 }
 
 std::shared_ptr<AutoscanDirectory> ContentManager::getAutoscanDirectory(int scanID, ScanMode scanMode) const
@@ -1733,7 +2556,7 @@ void ContentManager::setAutoscanDirectory(const std::shared_ptr<AutoscanDirector
         if (dir->getScanMode() == ScanMode::Timed) {
             autoscan_timed->add(dir);
             reloadLayout();
-            timerNotify(dir->getTimerParameter());
+            runTimedScan(dir->getScanID(), false);
         }
 #ifdef HAVE_INOTIFY
         if (config->getBoolOption(CFG_IMPORT_AUTOSCAN_USE_INOTIFY)) {
@@ -1780,7 +2603,7 @@ void ContentManager::setAutoscanDirectory(const std::shared_ptr<AutoscanDirector
 
     if (dir->getScanMode() == ScanMode::Timed) {
         autoscan_timed->add(copy);
-        timerNotify(copy->getTimerParameter());
+        runTimedScan(copy->getScanID(), false);
     }
 #ifdef HAVE_INOTIFY
     if (config->getBoolOption(CFG_IMPORT_AUTOSCAN_USE_INOTIFY)) {
@@ -1800,16 +2623,17 @@ void ContentManager::triggerPlayHook(const std::shared_ptr<CdsObject>& obj)
 {
     log_debug("start");
 
-    if (config->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_ENABLED) && !obj->getFlag(OBJECT_FLAG_PLAYED)) {
-        std::vector<std::string> mark_list = config->getArrayOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_CONTENT_LIST);
+    promoteMetadata({ obj });
 
-        bool mark = std::any_of(mark_list.begin(), mark_list.end(), [&](const auto& i) { return startswith(std::static_pointer_cast<CdsItem>(obj)->getMimeType(), i); });
+    if (!markPlayedContent.empty() && !obj->getFlag(OBJECT_FLAG_PLAYED)) {
+        bool mark = std::any_of(markPlayedContent.begin(), markPlayedContent.end(), [&](const auto& i) { return startswith(std::static_pointer_cast<CdsItem>(obj)->getMimeType(), i); });
         if (mark) {
             obj->setFlag(OBJECT_FLAG_PLAYED);
 
-            bool supress = config->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_SUPPRESS_CDS_UPDATES);
             log_debug("Marking object {} as played", obj->getTitle().c_str());
-            updateObject(obj, !supress);
+            // written with the next flush, so the start of the playback does not wait for the database
+            std::lock_guard<std::mutex> lock(playStatesMutex);
+            playedObjects[obj->getID()] = obj;
         }
     }
 
@@ -1821,6 +2645,57 @@ void ContentManager::triggerPlayHook(const std::shared_ptr<CdsObject>& obj)
     log_debug("end");
 }
 
+void ContentManager::setBookmark(int objectID, int position)
+{
+    std::lock_guard<std::mutex> lock(playStatesMutex);
+    bookmarks[objectID] = position;
+}
+
+void ContentManager::flushPlayStates()
+{
+    std::map<int, std::shared_ptr<CdsObject>> played;
+    std::map<int, int> positions;
+    {
+        std::lock_guard<std::mutex> lock(playStatesMutex);
+        played.swap(playedObjects);
+        positions.swap(bookmarks);
+    }
+    if (played.empty() && positions.empty())
+        return;
+
+    std::map<int, int> flags;
+    std::unordered_set<int> changedContainers;
+    for (auto&& [objectID, obj] : played) {
+        flags[objectID] = obj->getFlags();
+        if (!markPlayedSuppressUpdates)
+            changedContainers.insert(obj->getParentID());
+    }
+
+    std::map<int, int> changedBookmarks;
+    std::unordered_set<int> changedBookmarkContainers;
+    for (auto&& [objectID, position] : positions) {
+        try {
+            auto item = std::dynamic_pointer_cast<CdsItem>(database->loadObject(objectID));
+            if (item == nullptr || static_cast<int>(item->getBookMarkPos()) == position)
+                continue;
+            changedBookmarks[objectID] = position;
+            changedBookmarkContainers.insert(item->getParentID());
+        } catch (const std::runtime_error& e) {
+            log_debug("No bookmark for object {}: {}", objectID, e.what());
+        }
+    }
+
+    log_debug("Storing {} played flags and {} bookmarks", flags.size(), changedBookmarks.size());
+    database->updatePlayStates(flags, changedBookmarks);
+
+    for (auto&& containerID : changedBookmarkContainers) {
+        changedContainers.insert(containerID);
+        session_manager->containerChangedUI(containerID);
+    }
+    for (auto&& containerID : changedContainers)
+        update_manager->containerChanged(containerID);
+}
+
 CMAddFileTask::CMAddFileTask(std::shared_ptr<ContentManager> content,
     fs::directory_entry dirEnt, fs::path rootpath, AutoScanSetting& asSetting, bool cancellable)
     : GenericTask(ContentManagerTask)
@@ -1846,6 +2721,7 @@ void CMAddFileTask::run()
     content->_addFile(dirEnt, rootpath, asSetting, self);
     if (asSetting.adir != nullptr) {
         asSetting.adir->decTaskCount();
+        content->finishScanCheckpoint(asSetting.adir);
         if (asSetting.adir->updateLMT()) {
             log_debug("CMAddFileTask::run: Updating last_modified for autoscan directory {}", asSetting.adir->getLocation().c_str());
             content->getContext()->getDatabase()->updateAutoscanDirectory(asSetting.adir);
@@ -1871,6 +2747,49 @@ void CMRemoveObjectTask::run()
     content->_removeObject(adir, objectID, rescanResource, all);
 }
 
+CMMoveObjectTask::CMMoveObjectTask(std::shared_ptr<ContentManager> content, std::shared_ptr<AutoscanDirectory> adir,
+    fs::path from, fs::path to)
+    : GenericTask(ContentManagerTask)
+    , content(std::move(content))
+    , adir(std::move(adir))
+    , from(std::move(from))
+    , to(std::move(to))
+{
+    this->taskType = MoveObject;
+    cancellable = false;
+}
+
+void CMMoveObjectTask::run()
+{
+    content->_moveObject(adir, from, to);
+}
+
+CMReadMetadataTask::CMReadMetadataTask(std::shared_ptr<ContentManager> content, std::vector<int> objectIDs, fs::path rootpath)
+    : GenericTask(ContentManagerTask)
+    , content(std::move(content))
+    , objectIDs(std::move(objectIDs))
+    , rootpath(std::move(rootpath))
+{
+    this->taskType = ReadMetadata;
+}
+
+void CMReadMetadataTask::run()
+{
+    content->_readMetadata(objectIDs, rootpath);
+}
+
+CMRebuildLayoutTask::CMRebuildLayoutTask(std::shared_ptr<ContentManager> content)
+    : GenericTask(ContentManagerTask)
+    , content(std::move(content))
+{
+    this->taskType = RebuildLayout;
+}
+
+void CMRebuildLayoutTask::run()
+{
+    content->_rebuildLayout(shared_from_this());
+}
+
 CMRescanDirectoryTask::CMRescanDirectoryTask(std::shared_ptr<ContentManager> content,
     std::shared_ptr<AutoscanDirectory> adir, int containerId, bool cancellable)
     : GenericTask(ContentManagerTask)
@@ -1890,6 +2809,7 @@ void CMRescanDirectoryTask::run()
     auto self = shared_from_this();
     content->_rescanDirectory(adir, containerID, self);
     adir->decTaskCount();
+    content->finishScanCheckpoint(adir);
     if (adir->updateLMT()) {
         log_debug("CMRescanDirectoryTask::run: Updating last_modified for autoscan directory {}", adir->getLocation().c_str());
         content->getContext()->getDatabase()->updateAutoscanDirectory(adir);
@@ -1898,11 +2818,11 @@ void CMRescanDirectoryTask::run()
 
 #ifdef ONLINE_SERVICES
 CMFetchOnlineContentTask::CMFetchOnlineContentTask(std::shared_ptr<ContentManager> content,
-    std::shared_ptr<TaskProcessor> task_processor, std::shared_ptr<Timer> timer,
+    std::shared_ptr<TaskScheduler> scheduler, std::shared_ptr<Timer> timer,
     std::shared_ptr<OnlineService> service, std::shared_ptr<Layout> layout, bool cancellable, bool unscheduled_refresh)
     : GenericTask(ContentManagerTask)
     , content(std::move(content))
-    , task_processor(std::move(task_processor))
+    , scheduler(std::move(scheduler))
     , timer(std::move(timer))
     , service(std::move(service))
     , layout(std::move(layout))
@@ -1920,8 +2840,10 @@ void CMFetchOnlineContentTask::run()
     }
     try {
         std::shared_ptr<GenericTask> t(
-            new TPFetchOnlineContentTask(content, task_processor, timer, service, layout, cancellable, unscheduled_refresh));
-        task_processor->addTask(t);
+            new TPFetchOnlineContentTask(content, scheduler, timer, service, layout, cancellable, unscheduled_refresh));
+        t->setDescription(getDescription());
+        t->setGroup(service->getServiceName());
+        scheduler->addTask(t, getPriority());
     } catch (const std::runtime_error& ex) {
         log_error("{}", ex.what());
     }
@@ -31,20 +31,30 @@
 #ifndef __CONTENT_MANAGER_H__
 #define __CONTENT_MANAGER_H__
 
+#include <atomic>
+#include <condition_variable>
 #include <deque>
+#include <functional>
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <regex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "autoscan.h"
 #include "cds_objects.h"
 #include "common.h"
+#include "container_cache.h"
 #include "context.h"
 #include "util/generic_task.h"
+#include "util/task_scheduler.h"
 #include "util/thread_runner.h"
 #include "util/timer.h"
+#include "util/tools.h"
 
 #ifdef HAVE_JS
 // this is somewhat not nice, the playlist header needs the cm header and
@@ -61,6 +71,9 @@ class ScriptingRuntime;
 #ifdef HAVE_INOTIFY
 #include "autoscan_inotify.h"
 #endif // HAVE_INOTIFY
+#ifdef HAVE_FANOTIFY
+#include "autoscan_fanotify.h"
+#endif // HAVE_FANOTIFY
 
 #include "config/directory_tweak.h"
 #include "transcoding/transcoding.h"
@@ -72,11 +85,21 @@ class ScriptingRuntime;
 #include "util/executor.h"
 
 // forward declarations
+class ChangeFollower;
 class ContentManager;
+class DirectoryIndex;
+class DuplicateIndex;
+class ImportStatistics;
 class LastFm;
+class PlaylistParser;
 class Runtime;
 class Server;
-class TaskProcessor;
+class HardwareAccelerators;
+class TranscodeCache;
+class TranscodeScheduler;
+class HlsSessionManager;
+class PretranscodeQueue;
+class StorageActivity;
 
 class CMAddFileTask : public GenericTask, public std::enable_shared_from_this<CMAddFileTask> {
 protected:
@@ -107,6 +130,39 @@ public:
     void run() override;
 };
 
+class CMMoveObjectTask : public GenericTask {
+protected:
+    std::shared_ptr<ContentManager> content;
+    std::shared_ptr<AutoscanDirectory> adir;
+    fs::path from;
+    fs::path to;
+
+public:
+    CMMoveObjectTask(std::shared_ptr<ContentManager> content, std::shared_ptr<AutoscanDirectory> adir,
+        fs::path from, fs::path to);
+    void run() override;
+};
+
+class CMReadMetadataTask : public GenericTask {
+protected:
+    std::shared_ptr<ContentManager> content;
+    std::vector<int> objectIDs;
+    fs::path rootpath;
+
+public:
+    CMReadMetadataTask(std::shared_ptr<ContentManager> content, std::vector<int> objectIDs, fs::path rootpath);
+    void run() override;
+};
+
+class CMRebuildLayoutTask : public GenericTask, public std::enable_shared_from_this<CMRebuildLayoutTask> {
+protected:
+    std::shared_ptr<ContentManager> content;
+
+public:
+    explicit CMRebuildLayoutTask(std::shared_ptr<ContentManager> content);
+    void run() override;
+};
+
 class CMRescanDirectoryTask : public GenericTask, public std::enable_shared_from_this<CMRescanDirectoryTask> {
 protected:
     std::shared_ptr<ContentManager> content;
@@ -123,7 +179,7 @@ public:
 class CMFetchOnlineContentTask : public GenericTask {
 protected:
     std::shared_ptr<ContentManager> content;
-    std::shared_ptr<TaskProcessor> task_processor;
+    std::shared_ptr<TaskScheduler> scheduler;
     std::shared_ptr<Timer> timer;
     std::shared_ptr<OnlineService> service;
     std::shared_ptr<Layout> layout;
@@ -131,7 +187,7 @@ protected:
 
 public:
     CMFetchOnlineContentTask(std::shared_ptr<ContentManager> content,
-        std::shared_ptr<TaskProcessor> task_processor,
+        std::shared_ptr<TaskScheduler> scheduler,
         std::shared_ptr<Timer> timer,
         std::shared_ptr<OnlineService> service, std::shared_ptr<Layout> layout,
         bool cancellable, bool unscheduled_refresh);
@@ -149,16 +205,22 @@ public:
 
     void timerNotify(std::shared_ptr<Timer::Parameter> parameter) override;
 
-    bool isBusy() const { return working; }
+    bool isBusy() const { return scheduler->isBusy(); }
 
     /// \brief Returns the task that is currently being executed.
     std::shared_ptr<GenericTask> getCurrentTask();
 
-    /// \brief Returns the list of all enqueued tasks, including the current or nullptr if no tasks are present.
+    /// \brief Returns the task of each task thread, nullptr if the thread is idle.
+    std::vector<std::shared_ptr<GenericTask>> getWorkerTasks();
+
+    /// \brief Returns the number of files and directory listings waiting for the import threads.
+    std::size_t getImportQueueLength();
+
+    /// \brief Returns the list of all running and enqueued tasks.
     std::deque<std::shared_ptr<GenericTask>> getTasklist();
 
     /// \brief Find a task identified by the task ID and invalidate it.
-    void invalidateTask(unsigned int taskID, task_owner_t taskOwner = ContentManagerTask);
+    void invalidateTask(unsigned int taskID);
 
     /* the functions below return true if the task has been enqueued */
 
@@ -168,10 +230,10 @@ public:
     /// \param async queue task or perform a blocking call
     /// \param hidden true allows to import hidden files, false ignores them
     /// \param rescanResource true allows to reload a directory containing a resource
-    /// \param queue for immediate processing or in normal order
+    /// \param priority position of the task in the queue
     /// \return object ID of the added file - only in blockign mode, when used in async mode this function will return INVALID_OBJECT_ID
     int addFile(const fs::directory_entry& dirEnt, AutoScanSetting& asSetting,
-        bool async = true, bool lowPriority = false, bool cancellable = true);
+        bool async = true, TaskPriority priority = TaskPriority::Normal, bool cancellable = true);
 
     /// \brief Adds a file or directory to the database.
     /// \param dirEnt absolute path to the file
@@ -180,14 +242,25 @@ public:
     /// \param async queue task or perform a blocking call
     /// \param hidden true allows to import hidden files, false ignores them
     /// \param rescanResource true allows to reload a directory containing a resource
-    /// \param queue for immediate processing or in normal order
+    /// \param priority position of the task in the queue
     /// \return object ID of the added file - only in blockign mode, when used in async mode this function will return INVALID_OBJECT_ID
     int addFile(const fs::directory_entry& dirEnt, const fs::path& rootpath, AutoScanSetting& asSetting,
-        bool async = true, bool lowPriority = false, bool cancellable = true);
+        bool async = true, TaskPriority priority = TaskPriority::Normal, bool cancellable = true);
 
     int ensurePathExistence(fs::path path);
     void removeObject(const std::shared_ptr<AutoscanDirectory>& adir, int objectID, bool rescanResource, bool async = true, bool all = false);
 
+    /// \brief Follows a rename in the database instead of removing and importing the object again
+    /// \param from old path of the file or directory
+    /// \param to new path, imported normally if from is not in the database
+    void moveObject(const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& from, const fs::path& to);
+
+    /// \brief Reads the metadata of items imported with lazy-metadata and runs the layout for them
+    void readMetadata(const std::vector<int>& objectIDs, const fs::path& rootpath, TaskPriority priority = TaskPriority::Background);
+
+    /// \brief Reads the metadata of items a client asked for before the other pending items
+    void promoteMetadata(const std::vector<std::shared_ptr<CdsObject>>& objects);
+
     /// \brief Updates an object in the database using the given parameters.
     /// \param objectID ID of the object to update
     /// \param parameters key value pairs of fields to be updated
@@ -199,7 +272,7 @@ public:
 #ifdef ONLINE_SERVICES
     /// \brief Creates a layout based from data that is obtained from an
     /// online service (like YouTube, SopCast, etc.)
-    void fetchOnlineContent(service_type_t service, bool lowPriority = true,
+    void fetchOnlineContent(service_type_t service, TaskPriority priority = TaskPriority::Background,
         bool cancellable = true,
         bool unscheduled_refresh = false);
 
@@ -274,11 +347,31 @@ public:
     /// \brief handles the recreation of a persistent autoscan directory
     void handlePersistentAutoscanRecreate(const std::shared_ptr<AutoscanDirectory>& adir);
 
-    void rescanDirectory(const std::shared_ptr<AutoscanDirectory>& adir, int objectId, std::string descPath = "", bool cancellable = true);
+    /// \brief rescan a timed autoscan directory unless it is still being scanned
+    /// \param postpone wait until the disk holding it is spinning if storage awareness is enabled
+    void runTimedScan(int scanID, bool postpone);
+    /// \brief remember the scan if its disk is idle and it was not put off for longer than the maximum delay
+    /// \return true if the scan has to wait.
+    bool postponeScan(const std::shared_ptr<AutoscanDirectory>& adir);
+    /// \brief run the postponed scans of the disks that became active and of those with an overdue scan
+    void runPostponedScans();
+    /// \brief run the database maintenance unless a task is active or waiting
+    void runDatabaseMaintenance();
+
+    void rescanDirectory(const std::shared_ptr<AutoscanDirectory>& adir, int objectId, std::string descPath = "", bool cancellable = true,
+        TaskPriority priority = TaskPriority::Background);
 
     /// \brief instructs ContentManager to reload scripting environment
     void reloadLayout();
 
+    /// \brief apply reloaded layout mappings and scripts, see ConfigManager::reload()
+    void reloadConfig();
+
+    /// \brief Reloads the layout and builds the virtual containers of all items again from the stored metadata
+    ///
+    /// The new containers are created below a hidden container and replace the old ones when all items are done.
+    void rebuildLayout();
+
     /// \brief register executor
     ///
     /// When an external process is launched we will register the executor
@@ -295,8 +388,25 @@ public:
     /// The handler will then remove the executor from the list.
     void unregisterExecutor(const std::shared_ptr<Executor>& exec);
 
+    /// \brief cache for the output of external transcoders, nullptr if disabled
+    std::shared_ptr<TranscodeCache> getTranscodeCache() const { return transcodeCache; }
+
+    /// \brief slots for the external transcoders
+    std::shared_ptr<TranscodeScheduler> getTranscodeScheduler() const { return transcodeScheduler; }
+
+    /// \brief sessions of the hls transcoding profiles
+    std::shared_ptr<HlsSessionManager> getHlsSessionManager() const { return hlsSessions; }
+
+    /// \brief video accelerators found at startup
+    std::shared_ptr<HardwareAccelerators> getHardwareAccelerators() const { return hardwareAccelerators; }
+
     void triggerPlayHook(const std::shared_ptr<CdsObject>& obj);
 
+    /// \brief remember the bookmark position of an item, it is stored with the next flush of the play states
+    void setBookmark(int objectID, int position);
+    /// \brief store the played flags and bookmarks collected since the last flush in one transaction
+    void flushPlayStates();
+
     void initLayout();
     void destroyLayout();
 
@@ -315,46 +425,156 @@ protected:
     std::shared_ptr<Mime> mime;
     std::shared_ptr<Database> database;
     std::shared_ptr<UpdateManager> update_manager;
+    /// \brief applies the changes of the other nodes sharing the database, nullptr if there are none
+    std::unique_ptr<ChangeFollower> changeFollower;
     std::shared_ptr<web::SessionManager> session_manager;
     std::shared_ptr<Context> context;
-    ///\brief cache for containers while creating new layout
-    std::map<std::string, std::shared_ptr<CdsContainer>> containerMap;
+    std::shared_ptr<ImportStatistics> importStatistics;
+    ///\brief ids of virtual containers already created by the layout
+    ContainerCache containerCache;
+    /// \brief held while a chain is looked up and created, layouts running in parallel must not create it twice
+    std::mutex containerChainMutex;
+    /// \brief prepended to all chains while the layout is rebuilt
+    std::string layoutRoot;
+
+    /// \brief CFG_IMPORT_LAYOUT_MAPPING compiled when the config is loaded, applied in order
+    std::vector<std::pair<std::regex, std::string>> layoutMappings;
+    std::vector<std::pair<std::regex, std::string>> readLayoutMappings() const;
+    /// \brief chains already passed through the layout mappings
+    std::unordered_map<std::string, std::string> mappedChains;
+    std::mutex mappedChainsMutex;
+    /// \brief apply the layout mappings to a virtual container chain
+    std::string mapContainerChain(const std::string& chain);
 
     std::shared_ptr<Timer> timer;
-    std::shared_ptr<TaskProcessor> task_processor;
     std::shared_ptr<ScriptingRuntime> scripting_runtime;
     std::shared_ptr<LastFm> last_fm;
 
     std::map<std::string, std::string> mimetype_contenttype_map;
 
+    /// \brief metadata of the imported files for identical copies, nullptr if disabled
+    std::unique_ptr<DuplicateIndex> duplicates;
+    /// \brief files of the recently imported directories for fanart, subtitles and resources
+    std::unique_ptr<DirectoryIndex> directories;
+
+    /// \brief CFG_IMPORT_LAZY_METADATA, new items only get the basic metadata and are queued for readMetadata()
+    bool lazyMetadata;
+    /// \brief CFG_IMPORT_CHANGE_DETECTION, the file state of new items is stored so a touch does not read the metadata again
+    bool changeDetection;
+    /// \brief import options read for every file or directory, fetched once
+    bool followSymlinks;
+    bool readableNames;
+    int containerArtParentCount;
+    int containerArtMinDepth;
+    /// \brief CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_CONTENT_LIST, empty if marking is disabled
+    std::vector<std::string> markPlayedContent;
+    bool markPlayedSuppressUpdates;
+    /// \brief objects marked played and bookmark positions set since the last flush, the last value per object
+    std::map<int, std::shared_ptr<CdsObject>> playedObjects;
+    std::map<int, int> bookmarks;
+    std::mutex playStatesMutex;
+    /// \brief pending items already queued by promoteMetadata()
+    std::unordered_set<int> promotedObjects;
+    std::mutex promotedObjectsMutex;
+
+    /// \brief CFG_IMPORT_STORAGE_AWARENESS_ENABLED, nullptr if timed scans and metadata reads may wake up the disks
+    std::unique_ptr<StorageActivity> storageActivity;
+    std::chrono::seconds storageMaxDelay {};
+    /// \brief scan ids of the timed scans waiting for their disk and when they were due first
+    std::map<int, std::chrono::steady_clock::time_point> postponedScans;
+    std::mutex postponedScansMutex;
+
     std::shared_ptr<AutoscanList> autoscan_timed;
 #ifdef HAVE_INOTIFY
-    std::unique_ptr<AutoscanInotify> inotify;
+    std::unique_ptr<AutoscanMonitor> inotify;
     std::shared_ptr<AutoscanList> autoscan_inotify;
 #endif
 
     std::vector<std::shared_ptr<Executor>> process_list;
+    std::shared_ptr<TranscodeCache> transcodeCache;
+    std::shared_ptr<TranscodeScheduler> transcodeScheduler;
+    std::shared_ptr<HlsSessionManager> hlsSessions;
+    std::shared_ptr<HardwareAccelerators> hardwareAccelerators;
+    std::shared_ptr<PretranscodeQueue> pretranscodeQueue;
 
     int addFileInternal(const fs::directory_entry& dirEnt, const fs::path& rootpath,
         AutoScanSetting& asSetting,
         bool async = true,
-        bool lowPriority = false,
+        TaskPriority priority = TaskPriority::Normal,
         unsigned int parentTaskID = 0,
         bool cancellable = true);
     int _addFile(const fs::directory_entry& dirEnt, fs::path rootPath, AutoScanSetting& asSetting,
         const std::shared_ptr<CMAddFileTask>& task = nullptr);
 
     void _removeObject(const std::shared_ptr<AutoscanDirectory>& adir, int objectID, bool rescanResource, bool all);
+    /// \brief add the entries of a playlist with the configured playlist script or the playlist parser
+    void parsePlaylist(const std::shared_ptr<CdsObject>& obj, const std::string& mimetype, const std::shared_ptr<CMAddFileTask>& task);
+    /// \brief remember size, inode and fingerprint of the item's file
+    void storeFileState(const std::shared_ptr<CdsObject>& obj);
+    /// \brief true if the file still matches the stored state, i.e. only the modification time changed
+    bool isFileTouched(int objectID, const fs::path& path);
+
+    /// \brief send one update per container, the lists are sorted and deduplicated
+    void notifyChangedContainers(std::vector<int>& ui, std::vector<int>& upnp);
+    void _moveObject(const std::shared_ptr<AutoscanDirectory>& adir, const fs::path& from, const fs::path& to);
+    void _readMetadata(const std::vector<int>& objectIDs, fs::path rootpath);
+    void _rebuildLayout(const std::shared_ptr<GenericTask>& task);
 
     void _rescanDirectory(std::shared_ptr<AutoscanDirectory>& adir, int containerID, const std::shared_ptr<GenericTask>& task = nullptr);
+
+    /// \brief mt_internal_setting entry that is set while a scan of adir is unfinished
+    static std::string getScanCheckpointKey(const std::shared_ptr<AutoscanDirectory>& adir);
+    /// \brief mark the scan as unfinished, continuing it if the last one was interrupted
+    void startScanCheckpoint(const std::shared_ptr<AutoscanDirectory>& adir);
+    /// \brief clear the mark once the last task of the scan is done
+    void finishScanCheckpoint(const std::shared_ptr<AutoscanDirectory>& adir);
+    /// \brief remove the objects the scan of adir did not find, in chunks of REMOVE_CHUNK_SIZE
+    void removeStaleObjects(const std::shared_ptr<AutoscanDirectory>& adir);
     /* for recursive addition */
-    void addRecursive(std::shared_ptr<AutoscanDirectory>& adir, const fs::directory_entry& subDir, bool followSymlinks, bool hidden, const std::shared_ptr<CMAddFileTask>& task);
-    std::shared_ptr<CdsObject> createSingleItem(const fs::directory_entry& dirEnt, fs::path& rootPath, bool followSymlinks, bool checkDatabase, bool processExisting, bool firstChild, const std::shared_ptr<CMAddFileTask>& task);
+    /// \param listing entries of subDir listed ahead by the import workers, listed here if not valid
+    void addRecursive(std::shared_ptr<AutoscanDirectory>& adir, const fs::directory_entry& subDir, bool followSymlinks, bool hidden, const std::shared_ptr<CMAddFileTask>& task,
+        std::future<std::vector<ListedEntry>> listing = {});
+    std::shared_ptr<CdsObject> createSingleItem(const fs::directory_entry& dirEnt, fs::path& rootPath, bool followSymlinks, bool checkDatabase, bool processExisting, bool firstChild, const std::shared_ptr<CMAddFileTask>& task,
+        std::vector<std::shared_ptr<CdsObject>>* batch = nullptr);
+    void processLayout(const std::shared_ptr<CdsObject>& obj, fs::path& rootPath, const std::shared_ptr<CMAddFileTask>& task);
+    /// \brief run the layout for items with metadata in one call
+    void processLayout(const std::vector<std::shared_ptr<CdsObject>>& objects, fs::path& rootPath, const std::shared_ptr<CMAddFileTask>& task);
+    /// \brief write the items collected by addRecursive with one database call and run the layout on them
+    void flushImportBatch(std::vector<std::shared_ptr<CdsObject>>& batch, fs::path& rootPath, const std::shared_ptr<CMAddFileTask>& task);
+
+    using PendingImport = std::pair<fs::path, std::future<std::shared_ptr<CdsObject>>>;
+    /// \brief run createObjectFromFile() for a new file on the import workers
+    std::future<std::shared_ptr<CdsObject>> extractObjectFromFile(const fs::path& path, bool followSymlinks);
+
+    /// \brief queue a job for the import workers, it runs on the calling thread if there are none
+    template <typename Fn>
+    auto queueImportJob(Fn&& fn) -> std::future<decltype(fn())>
+    {
+        auto job = std::make_shared<std::packaged_task<decltype(fn())()>>(std::forward<Fn>(fn));
+        auto result = job->get_future();
+        if (importWorkers.empty()) {
+            (*job)();
+            return result;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(importMutex);
+            importQueue.emplace_back([job] { (*job)(); });
+        }
+        importCond.notify_one();
+        return result;
+    }
+    /// \brief collect the extracted objects in the order of the directory walk for flushImportBatch()
+    void collectPendingImports(std::deque<PendingImport>& pending, std::vector<std::shared_ptr<CdsObject>>& batch);
     bool updateAttachedResources(const std::shared_ptr<AutoscanDirectory>& adir, const char* location, const std::string& parentPath, bool all);
     void finishScan(const std::shared_ptr<AutoscanDirectory>& adir, const std::string& location, std::shared_ptr<CdsContainer>& parent, time_t lmt);
     static void invalidateAddTask(const std::shared_ptr<GenericTask>& t, const fs::path& path);
 
+    /// \brief give the containers an art resource, from an art file in the container or from origObj
+    ///
+    /// The result is kept in the container cache, containers that have art are skipped afterwards.
     void assignFanArt(const std::vector<std::shared_ptr<CdsContainer>>& containerList, const std::shared_ptr<CdsObject>& origObj);
+    static bool hasAlbumArt(const std::shared_ptr<CdsObject>& obj);
 
     template <typename T>
     void updateCdsObject(std::shared_ptr<T>& item, const std::map<std::string, std::string>& parameters);
@@ -365,34 +585,41 @@ protected:
     std::unique_ptr<OnlineServiceList> online_services;
 #endif //ONLINE_SERVICES
 
+    std::unique_ptr<PlaylistParser> playlist_parser;
 #ifdef HAVE_JS
     std::unique_ptr<PlaylistParserScript> playlist_parser_script;
 #endif
 
     bool layout_enabled;
 
-    static void* staticThreadProc(void* arg);
-    void threadProc();
-
-    void addTask(const std::shared_ptr<GenericTask>& task, bool lowPriority = false);
+    void addTask(const std::shared_ptr<GenericTask>& task, TaskPriority priority = TaskPriority::Normal);
 
-    std::unique_ptr<ThreadRunner<std::condition_variable_any, std::recursive_mutex>> threadRunner;
+    /// \brief runs the queued tasks of the content manager and the online services
+    std::shared_ptr<TaskScheduler> scheduler;
 
-    bool working;
-    bool shutdownFlag;
+    std::recursive_mutex mutex;
+    using AutoLock = std::lock_guard<std::recursive_mutex>;
 
-    std::deque<std::shared_ptr<GenericTask>> taskQueue1; // priority 1
-    std::deque<std::shared_ptr<GenericTask>> taskQueue2; // priority 2
-    std::shared_ptr<GenericTask> currentTask;
+    /// \brief metadata extraction of new files, the task thread keeps walking and writes the results in order
+    std::vector<std::unique_ptr<ThreadRunner<std::condition_variable, std::mutex>>> importWorkers;
+    std::deque<std::function<void()>> importQueue;
+    std::mutex importMutex;
+    std::condition_variable importCond;
+    static void* staticImportThreadProc(void* arg);
+    void importThreadProc();
 
-    unsigned int taskID;
+    std::atomic_bool shutdownFlag;
 
     friend void CMAddFileTask::run();
     friend void CMRemoveObjectTask::run();
+    friend void CMMoveObjectTask::run();
+    friend void CMReadMetadataTask::run();
+    friend void CMRebuildLayoutTask::run();
     friend void CMRescanDirectoryTask::run();
 #ifdef ONLINE_SERVICES
     friend void CMFetchOnlineContentTask::run();
 #endif
+    friend class PretranscodeQueue;
 };
 
 #endif // __CONTENT_MANAGER_H__
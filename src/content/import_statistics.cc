@@ -0,0 +1,116 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    import_statistics.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file import_statistics.cc
+
+#include "import_statistics.h" // API
+
+/// \brief files imported after a longer pause belong to a new run
+static constexpr auto IMPORT_RUN_PAUSE = std::chrono::minutes(1);
+
+ImportStatistics::ImportStatistics(bool enabled)
+    : enabled(enabled)
+{
+}
+
+void ImportStatistics::add(Stage stage, std::chrono::steady_clock::duration time)
+{
+    auto& counter = counters.at(static_cast<std::size_t>(stage));
+    counter.calls++;
+    counter.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(time).count();
+}
+
+void ImportStatistics::addFiles(unsigned long count)
+{
+    if (!enabled || count == 0)
+        return;
+
+    files += count;
+    auto now = std::chrono::steady_clock::now();
+    AutoLock lock(mutex);
+    if (runFiles == 0 || now - lastFile > IMPORT_RUN_PAUSE) {
+        runFiles = 0;
+        runStart = now;
+    }
+    runFiles += count;
+    lastFile = now;
+}
+
+ImportStatistics::Snapshot ImportStatistics::getSnapshot()
+{
+    Snapshot snapshot;
+    for (std::size_t i = 0; i < counters.size(); i++) {
+        snapshot.stages.at(i).calls = counters.at(i).calls;
+        snapshot.stages.at(i).time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(counters.at(i).nanoseconds));
+    }
+    snapshot.files = files;
+
+    AutoLock lock(mutex);
+    auto elapsed = std::chrono::duration<double>(lastFile - runStart).count();
+    if (elapsed > 0)
+        snapshot.filesPerSecond = runFiles / elapsed;
+    return snapshot;
+}
+
+const char* ImportStatistics::getStageName(Stage stage)
+{
+    switch (stage) {
+    case Stage::Listing:
+        return "listing";
+    case Stage::Mime:
+        return "mime";
+    case Stage::TagLib:
+        return "taglib";
+    case Stage::Exiv2:
+        return "exiv2";
+    case Stage::LibExif:
+        return "libexif";
+    case Stage::Matroska:
+        return "matroska";
+    case Stage::Ffmpeg:
+        return "ffmpeg";
+    case Stage::FanArt:
+        return "fanart";
+    case Stage::Subtitle:
+        return "subtitle";
+    case Stage::Resources:
+        return "resources";
+    case Stage::Layout:
+        return "layout";
+    case Stage::DatabaseInsert:
+        return "database-insert";
+    case Stage::ContainerChain:
+        return "container-chain";
+    case Stage::ScriptCopyObject:
+        return "script-copy-object";
+    case Stage::ScriptContainerTree:
+        return "script-container-tree";
+    case Stage::ScriptAddObject:
+        return "script-add-object";
+    case Stage::ScriptCharset:
+        return "script-charset";
+    case Stage::Max:
+        break;
+    }
+    return "unknown";
+}
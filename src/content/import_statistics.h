@@ -0,0 +1,126 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    import_statistics.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file import_statistics.h
+#ifndef __IMPORT_STATISTICS_H__
+#define __IMPORT_STATISTICS_H__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+/// \brief Time spent and number of calls per stage of the import, and the import rate
+///
+/// All counters are atomics, so the import threads record without locking.
+/// If disabled, a StageTimer does not even read the clock.
+class ImportStatistics {
+public:
+    enum class Stage {
+        Listing, ///< readdir and stat of the directory entries
+        Mime,
+        TagLib,
+        Exiv2,
+        LibExif,
+        Matroska,
+        Ffmpeg,
+        FanArt,
+        Subtitle,
+        Resources,
+        Layout,
+        DatabaseInsert,
+        ContainerChain,
+        ScriptCopyObject, ///< native functions called by the import and playlist scripts
+        ScriptContainerTree,
+        ScriptAddObject,
+        ScriptCharset,
+        Max
+    };
+
+    struct StageCounters {
+        unsigned long calls { 0 };
+        std::chrono::microseconds time { 0 };
+    };
+
+    struct Snapshot {
+        std::array<StageCounters, static_cast<std::size_t>(Stage::Max)> stages;
+        unsigned long files { 0 };
+        /// \brief files per second of the current import run
+        double filesPerSecond { 0 };
+    };
+
+    /// \brief measures the scope it lives in for one stage
+    class StageTimer {
+    public:
+        StageTimer(ImportStatistics* statistics, Stage stage)
+            : statistics(statistics != nullptr && statistics->isEnabled() ? statistics : nullptr)
+            , stage(stage)
+        {
+            if (this->statistics != nullptr)
+                start = std::chrono::steady_clock::now();
+        }
+        ~StageTimer()
+        {
+            if (statistics != nullptr)
+                statistics->add(stage, std::chrono::steady_clock::now() - start);
+        }
+        StageTimer(const StageTimer&) = delete;
+        StageTimer& operator=(const StageTimer&) = delete;
+
+    private:
+        ImportStatistics* statistics;
+        Stage stage;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    explicit ImportStatistics(bool enabled);
+
+    bool isEnabled() const { return enabled; }
+
+    void add(Stage stage, std::chrono::steady_clock::duration time);
+    /// \brief count imported files, a pause of a minute starts a new run for the rate
+    void addFiles(unsigned long count);
+
+    Snapshot getSnapshot();
+    static const char* getStageName(Stage stage);
+
+private:
+    struct Counters {
+        std::atomic_ulong calls { 0 };
+        std::atomic<std::int64_t> nanoseconds { 0 };
+    };
+
+    bool enabled;
+    std::array<Counters, static_cast<std::size_t>(Stage::Max)> counters;
+    std::atomic_ulong files { 0 };
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    unsigned long runFiles { 0 };
+    std::chrono::steady_clock::time_point runStart;
+    std::chrono::steady_clock::time_point lastFile;
+};
+
+#endif // __IMPORT_STATISTICS_H__
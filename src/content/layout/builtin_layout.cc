@@ -363,7 +363,13 @@ void BuiltinLayout::addATrailers(const std::shared_ptr<CdsObject>& obj)
 BuiltinLayout::BuiltinLayout(std::shared_ptr<ContentManager> content)
     : Layout(std::move(content))
 {
-    genreMap = config->getDictionaryOption(CFG_IMPORT_SCRIPTING_IMPORT_GENRE_MAP);
+    for (const auto& [from, to] : config->getDictionaryOption(CFG_IMPORT_SCRIPTING_IMPORT_GENRE_MAP)) {
+        try {
+            genreMap.emplace_back(std::regex(from, std::regex::ECMAScript | std::regex::icase | std::regex::optimize), to);
+        } catch (const std::regex_error& e) {
+            log_error("Ignoring genre mapping {}: {}", from, e.what());
+        }
+    }
 #ifdef ENABLE_PROFILING
     PROF_INIT_GLOBAL(layout_profiling, "builtin layout");
 #endif
@@ -371,9 +377,9 @@ BuiltinLayout::BuiltinLayout(std::shared_ptr<ContentManager> content)
 
 std::string BuiltinLayout::mapGenre(const std::string& genre)
 {
-    for (const auto& [from, to] : genreMap) {
-        if (std::regex_match(genre, std::regex(from, std::regex::ECMAScript | std::regex::icase))) {
-            return std::regex_replace(genre, std::regex(from, std::regex::ECMAScript | std::regex::icase), to);
+    for (const auto& [pattern, to] : genreMap) {
+        if (std::regex_match(genre, pattern)) {
+            return std::regex_replace(genre, pattern, to);
         }
     }
     return genre;
@@ -34,6 +34,8 @@
 
 #include <map>
 #include <memory>
+#include <regex>
+#include <vector>
 
 #include "layout.h"
 
@@ -56,9 +58,9 @@ public:
 protected:
     void add(const std::shared_ptr<CdsObject>& obj, const std::pair<int, bool>& parentID, bool use_ref = true);
     static std::string esc(std::string str);
-    void addVideo(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath);
-    void addImage(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath);
-    void addAudio(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath);
+    virtual void addVideo(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath);
+    virtual void addImage(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath);
+    virtual void addAudio(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath);
     std::string mapGenre(const std::string& genre);
 #ifdef SOPCAST
     void addSopCast(const std::shared_ptr<CdsObject>& obj);
@@ -66,7 +68,8 @@ protected:
 #ifdef ATRAILERS
     void addATrailers(const std::shared_ptr<CdsObject>& obj);
 #endif
-    std::map<std::string, std::string> genreMap;
+    /// \brief CFG_IMPORT_SCRIPTING_IMPORT_GENRE_MAP compiled once
+    std::vector<std::pair<std::regex, std::string>> genreMap;
 #ifdef ENABLE_PROFILING
     bool profiling_initialized;
     profiling_t layout_profiling;
@@ -32,23 +32,75 @@
 #ifdef HAVE_JS
 #include "js_layout.h" // API
 
+#include <future>
+#include <thread>
+
+#include "config/config.h"
 #include "content/scripting/import_script.h"
+#include "content/scripting/scripting_runtime.h"
 
 JSLayout::JSLayout(const std::shared_ptr<ContentManager>& content,
     const std::shared_ptr<ScriptingRuntime>& runtime)
     : Layout(content)
-    , import_script(std::make_unique<ImportScript>(content, runtime))
 {
+    std::size_t count = config->getIntOption(CFG_IMPORT_SCRIPTING_IMPORT_RUNTIMES);
+    if (count == 0)
+        count = std::max(1U, std::thread::hardware_concurrency());
+
+    // every runtime is a heap of its own, so the additional ones compile the script in parallel
+    std::vector<std::future<std::unique_ptr<ImportScript>>> loads;
+    for (std::size_t i = 1; i < count; i++) {
+        runtimes.push_back(std::make_shared<ScriptingRuntime>());
+        loads.push_back(std::async(std::launch::async, [&content, rt = runtimes.back()] { return std::make_unique<ImportScript>(content, rt); }));
+    }
+    import_scripts.push_back(std::make_unique<ImportScript>(content, runtime));
+    for (auto&& load : loads)
+        import_scripts.push_back(load.get());
+    for (auto&& script : import_scripts)
+        idleScripts.push_back(script.get());
+    if (count > 1)
+        log_info("Import script loaded into {} runtimes", count);
 }
 
-JSLayout::~JSLayout() = default;
+JSLayout::~JSLayout()
+{
+    // the scripts keep contexts in their runtimes
+    import_scripts.clear();
+    runtimes.clear();
+}
 
 void JSLayout::processCdsObject(std::shared_ptr<CdsObject> obj, fs::path rootpath)
 {
-    if (import_script == nullptr)
-        return;
+    withScript([&](ImportScript* script) { script->processCdsObject(obj, rootpath); });
+}
+
+void JSLayout::processCdsObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, const fs::path& rootpath)
+{
+    withScript([&](ImportScript* script) { script->processCdsObjects(objects, rootpath); });
+}
+
+void JSLayout::withScript(const std::function<void(ImportScript*)>& fn)
+{
+    ImportScript* script;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idleCond.wait(lock, [this] { return !idleScripts.empty(); });
+        script = idleScripts.back();
+        idleScripts.pop_back();
+    }
 
-    import_script->processCdsObject(obj, rootpath);
+    auto release = [this, script] {
+        std::lock_guard<std::mutex> lock(mutex);
+        idleScripts.push_back(script);
+        idleCond.notify_one();
+    };
+    try {
+        fn(script);
+    } catch (...) {
+        release();
+        throw;
+    }
+    release();
 }
 
 #endif // HAVE_JS
@@ -32,7 +32,11 @@
 #ifndef __JS_LAYOUT_H__
 #define __JS_LAYOUT_H__
 
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include "layout.h"
 
@@ -41,10 +45,21 @@ class ContentManager;
 class ImportScript;
 class ScriptingRuntime;
 
+/// \brief Layout built by the import script
+///
+/// With more than one runtime configured, every further import script gets a Duktape heap of its own,
+/// each object is processed by the next idle one.
 class JSLayout : public Layout {
 protected:
-    std::shared_ptr<ScriptingRuntime> runtime;
-    std::unique_ptr<ImportScript> import_script;
+    /// \brief heaps of the additional import scripts, the first one runs in the shared runtime
+    std::vector<std::shared_ptr<ScriptingRuntime>> runtimes;
+    std::vector<std::unique_ptr<ImportScript>> import_scripts;
+    std::vector<ImportScript*> idleScripts;
+    std::mutex mutex;
+    std::condition_variable idleCond;
+
+    /// \brief run fn with the next idle import script
+    void withScript(const std::function<void(ImportScript*)>& fn);
 
 public:
     JSLayout(const std::shared_ptr<ContentManager>& content,
@@ -52,6 +67,8 @@ public:
     ~JSLayout() override;
 
     void processCdsObject(std::shared_ptr<CdsObject> obj, fs::path rootpath) override;
+    void processCdsObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, const fs::path& rootpath) override;
+    bool isParallel() const override { return import_scripts.size() > 1; }
 };
 
 #endif // __JS_LAYOUT_H__
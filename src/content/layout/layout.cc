@@ -33,3 +33,14 @@ Layout::Layout(std::shared_ptr<ContentManager> content)
     , content(std::move(content))
 {
 }
+
+void Layout::processCdsObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, const fs::path& rootpath)
+{
+    for (auto&& obj : objects) {
+        try {
+            processCdsObject(obj, rootpath);
+        } catch (const std::runtime_error& e) {
+            log_error("{}", e.what());
+        }
+    }
+}
@@ -34,6 +34,7 @@
 
 #include <filesystem>
 #include <memory>
+#include <vector>
 namespace fs = std::filesystem;
 
 #include "context.h"
@@ -48,6 +49,11 @@ public:
 
     virtual ~Layout() = default;
     virtual void processCdsObject(std::shared_ptr<CdsObject> obj, fs::path rootpath) = 0;
+    /// \brief process the objects of one import batch, one at a time unless the layout can do better
+    virtual void processCdsObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, const fs::path& rootpath);
+
+    /// \brief processCdsObject may be called from several threads at once
+    virtual bool isParallel() const { return false; }
 
 protected:
     std::shared_ptr<Config> config;
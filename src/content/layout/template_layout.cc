@@ -0,0 +1,219 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    template_layout.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file template_layout.cc
+
+#include "template_layout.h" // API
+
+#include "config/config_manager.h"
+#include "content/content_manager.h"
+#include "metadata/metadata_handler.h"
+#include "util/string_converter.h"
+
+/// \brief short placeholder names of metadata fields
+static const std::map<std::string, metadata_fields_t> fieldNames {
+    { "title", M_TITLE },
+    { "artist", M_ARTIST },
+    { "album", M_ALBUM },
+    { "albumartist", M_ALBUMARTIST },
+    { "genre", M_GENRE },
+    { "composer", M_COMPOSER },
+    { "conductor", M_CONDUCTOR },
+    { "orchestra", M_ORCHESTRA },
+    { "date", M_DATE },
+    { "author", M_AUTHOR },
+    { "director", M_DIRECTOR },
+    { "publisher", M_PUBLISHER },
+    { "actor", M_ACTOR },
+    { "producer", M_PRODUCER },
+    { "region", M_REGION },
+};
+
+/// \brief class of a container named by the placeholder
+static const std::map<std::string, std::string> fieldClasses {
+    { "album", UPNP_CLASS_MUSIC_ALBUM },
+    { "artist", UPNP_CLASS_MUSIC_ARTIST },
+    { "albumartist", UPNP_CLASS_MUSIC_ARTIST },
+    { "genre", UPNP_CLASS_MUSIC_GENRE },
+    { "composer", UPNP_CLASS_MUSIC_COMPOSER },
+};
+
+TemplateLayout::TemplateLayout(std::shared_ptr<ContentManager> content)
+    : BuiltinLayout(std::move(content))
+{
+    for (const auto& [path, media] : config->getDictionaryOption(CFG_IMPORT_SCRIPTING_IMPORT_TEMPLATE_CHAINS)) {
+        if (media != "audio" && media != "video" && media != "image") {
+            log_error("Ignoring layout template {}: unknown media type '{}'", path, media);
+            continue;
+        }
+        try {
+            chains[media].push_back(parseChain(path));
+        } catch (const std::runtime_error& e) {
+            log_error("Ignoring layout template {}: {}", path, e.what());
+        }
+    }
+}
+
+TemplateLayout::Chain TemplateLayout::parseChain(const std::string& path)
+{
+    Chain chain;
+    std::size_t pos = 0;
+    while (pos < path.size()) {
+        auto start = path.find('%', pos);
+        if (start == std::string::npos) {
+            chain.parts.push_back(Part { path.substr(pos), {}, std::nullopt });
+            break;
+        }
+        if (start > pos)
+            chain.parts.push_back(Part { path.substr(pos, start - pos), {}, std::nullopt });
+
+        auto end = path.find('%', start + 1);
+        if (end == std::string::npos)
+            throw_std_runtime_error("placeholder at {} is not closed", start);
+        auto placeholder = path.substr(start + 1, end - start - 1);
+        Part part;
+        auto bar = placeholder.find('|');
+        if (bar != std::string::npos) {
+            part.fallback = placeholder.substr(bar + 1);
+            placeholder.erase(bar);
+        }
+        for (auto&& field : splitString(placeholder, ','))
+            part.fields.push_back(trimString(field));
+        if (part.fields.empty())
+            throw_std_runtime_error("empty placeholder at {}", start);
+        chain.parts.push_back(std::move(part));
+        pos = end + 1;
+    }
+
+    // "/Audio/Albums/%album%" creates album containers
+    auto size = chain.parts.size();
+    if (size >= 2 && !chain.parts[size - 1].fields.empty() && !chain.parts[size - 2].text.empty() && chain.parts[size - 2].text.back() == '/')
+        chain.lastClass = getValueOrDefault(fieldClasses, chain.parts[size - 1].fields.front());
+    return chain;
+}
+
+std::optional<std::string> TemplateLayout::expandChain(const Chain& chain, const std::map<std::string, std::string>& values)
+{
+    std::string result;
+    for (auto&& part : chain.parts) {
+        if (part.fields.empty()) {
+            result.append(part.text);
+            continue;
+        }
+        std::string value;
+        for (auto&& field : part.fields) {
+            value = getValueOrDefault(values, field);
+            if (!value.empty())
+                break;
+        }
+        if (value.empty()) {
+            if (!part.fallback)
+                return std::nullopt;
+            value = part.fallback.value();
+        }
+        result.append(value);
+    }
+    return result;
+}
+
+std::map<std::string, std::string> TemplateLayout::getValues(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath)
+{
+    std::map<std::string, std::string> values;
+    for (auto&& [key, value] : obj->getMetadata())
+        values[key] = esc(value);
+    for (auto&& [name, field] : fieldNames)
+        values[name] = esc(obj->getMetadata(field));
+    if (values["title"].empty())
+        values["title"] = esc(obj->getTitle());
+    if (!values["genre"].empty())
+        values["genre"] = esc(mapGenre(obj->getMetadata(M_GENRE)));
+
+    auto date = obj->getMetadata(M_DATE);
+    auto dateParts = splitString(date, '-');
+    if (!dateParts.empty())
+        values["year"] = esc(dateParts[0]);
+    if (dateParts.size() > 1)
+        values["month"] = esc(dateParts[1]);
+
+    // the directory keeps its separators, every level becomes a container
+    auto f2i = StringConverter::f2i(config);
+    if (!rootpath.empty())
+        values["directory"] = f2i->convert(fs::relative(obj->getLocation().parent_path(), config->getBoolOption(CFG_IMPORT_LAYOUT_PARENT_PATH) ? rootpath.parent_path() : rootpath));
+    else
+        values["directory"] = esc(f2i->convert(getLastPath(obj->getLocation())));
+    if (values["directory"] == ".")
+        values["directory"].clear();
+    return values;
+}
+
+void TemplateLayout::addChains(const std::vector<Chain>& mediaChains, const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath)
+{
+    auto values = getValues(obj, rootpath);
+    bool first = true;
+    for (auto&& chain : mediaChains) {
+        auto path = expandChain(chain, values);
+        if (!path)
+            continue;
+
+        bool isAlbum = chain.lastClass == UPNP_CLASS_MUSIC_ALBUM;
+        auto id = content->addContainerChain(path.value(), chain.lastClass, isAlbum ? obj->getID() : INVALID_OBJECT_ID, isAlbum ? obj : nullptr);
+        // the first reference points to the original object, all others reuse its ref id
+        if (first && obj->getID() != INVALID_OBJECT_ID) {
+            obj->setRefID(obj->getID());
+            add(obj, id);
+        } else if (first) {
+            add(obj, id);
+            obj->setRefID(obj->getID());
+        } else {
+            add(obj, id);
+        }
+        first = false;
+    }
+}
+
+void TemplateLayout::addVideo(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath)
+{
+    auto mediaChains = chains.find("video");
+    if (mediaChains == chains.end())
+        BuiltinLayout::addVideo(obj, rootpath);
+    else
+        addChains(mediaChains->second, obj, rootpath);
+}
+
+void TemplateLayout::addImage(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath)
+{
+    auto mediaChains = chains.find("image");
+    if (mediaChains == chains.end())
+        BuiltinLayout::addImage(obj, rootpath);
+    else
+        addChains(mediaChains->second, obj, rootpath);
+}
+
+void TemplateLayout::addAudio(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath)
+{
+    auto mediaChains = chains.find("audio");
+    if (mediaChains == chains.end())
+        BuiltinLayout::addAudio(obj, rootpath);
+    else
+        addChains(mediaChains->second, obj, rootpath);
+}
@@ -0,0 +1,78 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    template_layout.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file template_layout.h
+#ifndef __TEMPLATE_LAYOUT_H__
+#define __TEMPLATE_LAYOUT_H__
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "builtin_layout.h"
+
+/// \brief Layout built from the path templates of CFG_IMPORT_SCRIPTING_IMPORT_TEMPLATE_CHAINS
+///
+/// A template like "/Audio/Artists/%artist%/%album|Unknown%" is parsed once into literal text and placeholders.
+/// A placeholder names one or more fields separated by ',', the first one with a value is used, otherwise the
+/// fallback after '|'. A template with an empty placeholder and no fallback is skipped for the object.
+/// Media types without templates keep the builtin layout.
+class TemplateLayout : public BuiltinLayout {
+public:
+    explicit TemplateLayout(std::shared_ptr<ContentManager> content);
+
+    struct Part {
+        /// \brief literal text, empty for placeholders
+        std::string text;
+        std::vector<std::string> fields;
+        std::optional<std::string> fallback;
+    };
+
+    struct Chain {
+        std::vector<Part> parts;
+        /// \brief upnp:class of the last container, derived from the placeholder that makes up the last segment
+        std::string lastClass;
+    };
+
+    /// \brief parse a template, throws if a placeholder is not closed or empty
+    static Chain parseChain(const std::string& path);
+
+    /// \brief fill in the values, nullopt if a placeholder without fallback has no value
+    static std::optional<std::string> expandChain(const Chain& chain, const std::map<std::string, std::string>& values);
+
+protected:
+    void addVideo(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath) override;
+    void addImage(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath) override;
+    void addAudio(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath) override;
+
+    /// \brief escaped placeholder values of obj, metadata by upnp name and by short name
+    std::map<std::string, std::string> getValues(const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath);
+    void addChains(const std::vector<Chain>& mediaChains, const std::shared_ptr<CdsObject>& obj, const fs::path& rootpath);
+
+    /// \brief parsed templates by media type
+    std::map<std::string, std::vector<Chain>> chains;
+};
+
+#endif // __TEMPLATE_LAYOUT_H__
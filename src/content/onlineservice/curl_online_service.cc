@@ -84,9 +84,14 @@ std::unique_ptr<pugi::xml_document> CurlOnlineService::getData()
     if (retcode != 200)
         return nullptr;
 
-    log_debug("GOT BUFFER{}", buffer.c_str());
+    log_debug("Got {} bytes of {} XML", buffer.size(), serviceName);
+    // feeds are UTF-8 as a rule, the conversion copies the whole feed several times and only runs for broken ones
+    if (!isValidUTF8(buffer)) {
+        log_warning("{} XML is not valid UTF-8, replacing illegal characters", serviceName);
+        buffer = sc->convert(buffer);
+    }
     auto doc = std::make_unique<pugi::xml_document>();
-    pugi::xml_parse_result result = doc->load_string(sc->convert(buffer).c_str());
+    pugi::xml_parse_result result = doc->load_buffer(buffer.data(), buffer.size(), pugi::parse_default, pugi::encoding_utf8);
     if (result.status != pugi::xml_parse_status::status_ok) {
         log_error("Error parsing {} XML: {}", serviceName, result.description());
         return nullptr;
@@ -120,6 +125,10 @@ bool CurlOnlineService::refreshServiceData(std::shared_ptr<Layout> layout)
     auto sc = getContentHandler();
     sc->setServiceContent(reply);
 
+    // only new and changed objects are written, the others are just marked as seen
+    loadObjectIndex();
+    auto current = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
     std::shared_ptr<CdsObject> obj;
     do {
         /// \todo add try/catch here and a possibility do find out if we
@@ -130,12 +139,25 @@ bool CurlOnlineService::refreshServiceData(std::shared_ptr<Layout> layout)
 
         obj->setVirtual(true);
 
-        auto old = database->loadObjectByServiceID(std::static_pointer_cast<CdsItem>(obj)->getServiceID());
+        auto serviceID = std::static_pointer_cast<CdsItem>(obj)->getServiceID();
+        auto hash = contentHash(obj);
+        auto entry = objectIndex.find(serviceID);
+        if (entry != objectIndex.end() && entry->second.hash == hash) {
+            entry->second.lastSeen = current;
+            continue;
+        }
+        obj->setAuxData(ONLINE_SERVICE_CONTENT_HASH, hash);
+
+        auto old = database->loadObjectByServiceID(serviceID);
         if (old == nullptr) {
             log_debug("Adding new {} object", serviceName);
 
             if (layout != nullptr)
                 layout->processCdsObject(obj, "");
+            // the layout may have added a copy
+            auto added = database->loadObjectByServiceID(serviceID);
+            if (added != nullptr)
+                objectIndex[serviceID] = IndexEntry { added->getID(), hash, current };
         } else {
             log_debug("Updating existing {} object", serviceName);
             obj->setID(old->getID());
@@ -146,6 +168,7 @@ bool CurlOnlineService::refreshServiceData(std::shared_ptr<Layout> layout)
             //            newt.tv_nsec = 0;
             //            newt.tv_sec = obj->getAuxData(ONLINE_SERVICE_LAST_UPDATE).toLong();
             content->updateObject(obj);
+            objectIndex[serviceID] = IndexEntry { old->getID(), hash, current };
         }
 
         //        if (server->getShutdownStatus())
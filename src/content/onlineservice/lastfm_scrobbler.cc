@@ -36,17 +36,23 @@
 #include "metadata/metadata_handler.h"
 #include "util/tools.h"
 
+/// \brief first delay before logging in again, doubled up to LASTFM_MAX_RETRY_DELAY
+static constexpr auto LASTFM_RETRY_DELAY = std::chrono::seconds(30);
+static constexpr auto LASTFM_MAX_RETRY_DELAY = std::chrono::minutes(15);
+/// \brief Last.fm does not accept older plays
+static constexpr auto LASTFM_MAX_AGE = std::chrono::hours(14 * 24);
+
 LastFm::LastFm(std::shared_ptr<Context> context)
     : config(context->getConfig())
-    , scrobbler(NULL)
+    , database(context->getDatabase())
+    , scrobbler(nullptr)
     , currentTrackId(-1)
 {
 }
 
 LastFm::~LastFm()
 {
-    if (currentTrackId != -1 && scrobbler)
-        finished_playing(scrobbler);
+    shutdown();
 }
 
 void LastFm::run()
@@ -54,66 +60,159 @@ void LastFm::run()
     if (!config->getBoolOption(CFG_SERVER_EXTOPTS_LASTFM_ENABLED))
         return;
 
-    std::string username = config->getOption(CFG_SERVER_EXTOPTS_LASTFM_USERNAME);
-    std::string password = config->getOption(CFG_SERVER_EXTOPTS_LASTFM_PASSWORD);
-
-    scrobbler = create_scrobbler(username.c_str(), password.c_str(), 0, 0);
-    authenticate_scrobbler(scrobbler);
-    set_commit_only_mode(scrobbler, 1);
+    thread = std::make_unique<StdThreadRunner>("LastFmThread", LastFm::staticThreadProc, this, config);
+    if (!thread->isAlive()) {
+        log_error("Could not start the Last.fm thread");
+        thread = nullptr;
+    }
 }
 
 void LastFm::shutdown()
 {
-    if (!scrobbler)
+    if (thread == nullptr)
         return;
 
-    finished_playing(scrobbler);
-    destroy_scrobbler(scrobbler);
-    scrobbler = NULL;
+    {
+        AutoLock lock(mutex);
+        shutdownFlag = true;
+        cond.notify_all();
+    }
+    thread->join();
+    thread = nullptr;
 }
 
-void LastFm::startedPlaying(std::shared_ptr<CdsItem> item)
+void LastFm::startedPlaying(const std::shared_ptr<CdsItem>& item)
 {
-    if (currentTrackId == item->getID() || scrobbler == NULL)
+    if (currentTrackId == item->getID() || thread == nullptr)
         return;
 
     currentTrackId = item->getID();
 
-    log_debug("Artist:\t{}",
-        item->getMetadata(M_ARTIST).c_str());
-    log_debug("Title:\t{}",
-        item->getMetadata(M_TITLE).c_str());
+    Database::Scrobble scrobble;
+    scrobble.artist = item->getMetadata(M_ARTIST);
+    scrobble.title = item->getMetadata(M_TITLE);
+    scrobble.album = item->getMetadata(M_ALBUM);
+    log_debug("Artist:\t{}", scrobble.artist);
+    log_debug("Title:\t{}", scrobble.title);
 
-    std::string artist = item->getMetadata(M_ARTIST);
-    std::string title = item->getMetadata(M_TITLE);
+    std::string trackNr = item->getMetadata(M_TRACKNUMBER);
+    if (!trackNr.empty())
+        scrobble.trackNumber = std::atoi(trackNr.c_str());
+    if (item->getResourceCount() > 0) {
+        std::string duration = item->getResource(0)->getAttribute(R_DURATION);
+        scrobble.length = HMSFToMilliseconds(duration) / 1000;
+    }
+    scrobble.started = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
 
-    if (artist.empty() || title.empty()) {
-        finished_playing(scrobbler);
+    if (scrobble.artist.empty() || scrobble.title.empty())
         currentTrackId = -1;
+
+    // an empty play just ends the current track
+    AutoLock lock(mutex);
+    queue.push_back(std::move(scrobble));
+    cond.notify_one();
+}
+
+void* LastFm::staticThreadProc(void* arg)
+{
+    static_cast<LastFm*>(arg)->threadProc();
+    return nullptr;
+}
+
+bool LastFm::connect()
+{
+    std::string username = config->getOption(CFG_SERVER_EXTOPTS_LASTFM_USERNAME);
+    std::string password = config->getOption(CFG_SERVER_EXTOPTS_LASTFM_PASSWORD);
+
+    scrobbler = create_scrobbler(username.c_str(), password.c_str(), 0, 0);
+    if (scrobbler == nullptr)
+        return false;
+    authenticate_scrobbler(scrobbler);
+    set_commit_only_mode(scrobbler, 1);
+    return true;
+}
+
+void LastFm::submit(const Database::Scrobble& scrobble)
+{
+    if (scrobble.artist.empty() || scrobble.title.empty()) {
+        finished_playing(scrobbler);
         return;
     }
 
     submission_info* info = create_submission_info();
-    info->artist = const_cast<char*>(artist.c_str());
-    info->track = const_cast<char*>(title.c_str());
+    info->artist = const_cast<char*>(scrobble.artist.c_str());
+    info->track = const_cast<char*>(scrobble.title.c_str());
+    if (!scrobble.album.empty())
+        info->album = const_cast<char*>(scrobble.album.c_str());
+    if (scrobble.trackNumber > 0)
+        info->track_nr = scrobble.trackNumber;
+    if (scrobble.length > 0)
+        info->track_length_in_secs = scrobble.length;
 
-    std::string album = item->getMetadata(M_ALBUM);
-    if (!album.empty())
-        info->album = const_cast<char*>(album.c_str());
+    started_playing(scrobbler, info);
 
-    std::string trackNr = item->getMetadata(M_TRACKNUMBER);
-    if (!trackNr.empty())
-        info->track_nr = atoi(trackNr.c_str());
+    destroy_submission_info(info);
+}
 
-    if (item->getResourceCount() > 0) {
-        auto resource = item->getResource(0);
-        std::string duration = resource->getAttribute(R_DURATION);
-        info->track_length_in_secs = HMSFToMilliseconds(duration.c_str()) / 1000;
+void LastFm::threadProc()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // plays of the last run that were not submitted
+    auto oldest = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now() - LASTFM_MAX_AGE);
+    try {
+        for (auto&& scrobble : database->takeScrobbles()) {
+            if (scrobble.started >= oldest)
+                queue.push_back(std::move(scrobble));
+        }
+    } catch (const std::runtime_error& e) {
+        log_warning("Could not load the stored Last.fm plays: {}", e.what());
     }
 
-    started_playing(scrobbler, info);
+    auto retryDelay = std::chrono::duration_cast<std::chrono::seconds>(LASTFM_RETRY_DELAY);
+    while (!shutdownFlag) {
+        if (queue.empty()) {
+            cond.wait(lock, [this] { return shutdownFlag || !queue.empty(); });
+            continue;
+        }
+
+        if (scrobbler == nullptr) {
+            lock.unlock();
+            bool connected = connect();
+            lock.lock();
+            if (!connected) {
+                log_warning("Could not log in to Last.fm, retrying in {}s", retryDelay.count());
+                cond.wait_for(lock, retryDelay, [this] { return shutdownFlag; });
+                retryDelay = std::min(retryDelay * 2, std::chrono::duration_cast<std::chrono::seconds>(LASTFM_MAX_RETRY_DELAY));
+                continue;
+            }
+            retryDelay = std::chrono::duration_cast<std::chrono::seconds>(LASTFM_RETRY_DELAY);
+        }
+
+        // everything that was queued meanwhile is submitted in one go
+        std::deque<Database::Scrobble> batch;
+        batch.swap(queue);
+        lock.unlock();
+        for (auto&& scrobble : batch)
+            submit(scrobble);
+        lock.lock();
+    }
 
-    destroy_submission_info(info);
+    if (scrobbler != nullptr) {
+        finished_playing(scrobbler);
+        destroy_scrobbler(scrobbler);
+        scrobbler = nullptr;
+    }
+
+    if (!queue.empty()) {
+        try {
+            database->storeScrobbles({ queue.begin(), queue.end() });
+            log_debug("Stored {} Last.fm plays for the next start", queue.size());
+        } catch (const std::runtime_error& e) {
+            log_warning("Could not store the Last.fm plays: {}", e.what());
+        }
+        queue.clear();
+    }
 }
 
 #endif //HAVE_LASTFMLIB
@@ -35,44 +35,65 @@
 #ifndef __LASTFM_H__
 #define __LASTFM_H__
 
+#include <condition_variable>
 #include <cstdlib>
+#include <deque>
 #include <lastfmlib/lastfmscrobblerc.h>
 #include <memory>
+#include <mutex>
 
 #include "cds_objects.h"
 #include "config/config_manager.h"
 #include "context.h"
+#include "database/database.h"
+#include "util/thread_runner.h"
 
+/// \brief Submits plays to Last.fm on a thread of its own
+///
+/// Plays are queued by startedPlaying, so the request that starts playback never waits for the network.
+/// Plays that were not submitted when the server stops are kept in the database for the next start.
 class LastFm {
 public:
     explicit LastFm(std::shared_ptr<Context> context);
     ~LastFm();
 
-    /// \brief Initializes the LastFm client.
+    /// \brief Starts the scrobbler thread.
     ///
-    /// This function reads information from the config and initializes
-    /// various variables (like username and password).
+    /// The thread reads the user name and password from the config,
+    /// authenticates and submits the queued plays.
     void run();
 
-    /// \brief Destroys the LastFm client.
+    /// \brief Stops the scrobbler thread.
     ///
-    /// This function destroys the LastFm client after submitting the
-    /// last Track info
+    /// The last track is submitted and the plays that are still queued are stored.
     void shutdown();
 
     /// \brief indicates that a new file has started playing.
     ///
-    /// This function uses notifies Last.fm that the user started listening
-    /// to a file
+    /// The play is queued for the scrobbler thread.
     ///
     /// \param item the audio item that is being played
-    void startedPlaying(std::shared_ptr<CdsItem> item);
+    void startedPlaying(const std::shared_ptr<CdsItem>& item);
 
 private:
     std::shared_ptr<Config> config;
+    std::shared_ptr<Database> database;
 
     lastfm_scrobbler* scrobbler;
     int currentTrackId;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::condition_variable cond;
+    bool shutdownFlag { false };
+    std::deque<Database::Scrobble> queue;
+    std::unique_ptr<StdThreadRunner> thread;
+
+    static void* staticThreadProc(void* arg);
+    void threadProc();
+    /// \brief log in, false if the scrobbler could not be created
+    bool connect();
+    void submit(const Database::Scrobble& scrobble);
 };
 
 #endif //__LASTFM_H__
@@ -35,7 +35,9 @@
 
 #include <array>
 
+#include "cds_objects.h"
 #include "content/content_manager.h"
+#include "database/database.h"
 #include "util/tools.h"
 
 // DO NOT FORGET TO ADD SERVICE STORAGE PREFIXES TO THIS ARRAY WHEN ADDING
@@ -90,4 +92,51 @@ char OnlineService::getDatabasePrefix()
     return getDatabasePrefix(getServiceType());
 }
 
+void OnlineService::loadObjectIndex()
+{
+    if (indexLoaded)
+        return;
+
+    for (auto&& [serviceID, object] : database->getServiceObjects(getDatabasePrefix())) {
+        auto lastUpdate = object.auxData.find(ONLINE_SERVICE_LAST_UPDATE);
+        objectIndex[serviceID] = IndexEntry {
+            object.objectID,
+            getValueOrDefault(object.auxData, ONLINE_SERVICE_CONTENT_HASH),
+            lastUpdate != object.auxData.end() && !lastUpdate->second.empty() ? std::time_t(std::stoll(lastUpdate->second)) : 0,
+        };
+    }
+    indexLoaded = true;
+    log_debug("{} has {} objects", getServiceName(), objectIndex.size());
+}
+
+std::unordered_set<int> OnlineService::takeStaleObjects()
+{
+    loadObjectIndex();
+
+    std::unordered_set<int> stale;
+    auto current = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    for (auto it = objectIndex.begin(); it != objectIndex.end();) {
+        if (it->second.lastSeen > 0 && current - it->second.lastSeen > purge_interval) {
+            stale.insert(it->second.objectID);
+            it = objectIndex.erase(it);
+        } else
+            ++it;
+    }
+    return stale;
+}
+
+std::string OnlineService::contentHash(const std::shared_ptr<CdsObject>& obj)
+{
+    auto auxData = obj->getAuxData();
+    auxData.erase(ONLINE_SERVICE_LAST_UPDATE);
+    auxData.erase(ONLINE_SERVICE_CONTENT_HASH);
+
+    auto fields = fmt::format("{}\n{}\n{}\n{}\n{}", obj->getTitle(), obj->getClass(), obj->getLocation().string(), dictEncode(obj->getMetadata()), dictEncode(auxData));
+    if (obj->isItem())
+        fields += fmt::format("\n{}", std::static_pointer_cast<CdsItem>(obj)->getMimeType());
+    for (auto&& resource : obj->getResources())
+        fields += fmt::format("\n{}\n{}\n{}", dictEncode(resource->getAttributes()), dictEncode(resource->getParameters()), dictEncode(resource->getOptions()));
+    return fmt::to_string(stringHash(fields));
+}
+
 #endif //ONLINE_SERVICES
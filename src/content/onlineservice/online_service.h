@@ -35,7 +35,10 @@
 #ifndef __ONLINE_SERVICE_H__
 #define __ONLINE_SERVICE_H__
 
+#include <ctime>
+#include <map>
 #include <memory>
+#include <unordered_set>
 #include <vector>
 
 #include "util/timer.h"
@@ -43,11 +46,13 @@
 // forward declaration
 class Config;
 class Database;
+class CdsObject;
 class ContentManager;
 class Layout;
 
 #define ONLINE_SERVICE_AUX_ID "ols"
 #define ONLINE_SERVICE_LAST_UPDATE "lu"
+#define ONLINE_SERVICE_CONTENT_HASH "oh"
 
 // make sure to add the database prefixes when adding new services
 enum service_type_t {
@@ -127,7 +132,28 @@ public:
     /// \brieg Retrieves the "purte after" interval in seconds
     int getItemPurgeInterval() const { return purge_interval; }
 
+    /// \brief Ids of the objects the service did not deliver within the purge interval
+    ///
+    /// The objects are dropped from the index, the caller removes them from the database.
+    std::unordered_set<int> takeStaleObjects();
+
 protected:
+    /// \brief what the service knows about an object in the database
+    struct IndexEntry {
+        int objectID;
+        std::string hash;
+        /// \brief last refresh that delivered the object, 0 if unknown
+        std::time_t lastSeen;
+    };
+
+    /// \brief objects by service id, loaded from the database on first use
+    std::map<std::string, IndexEntry> objectIndex;
+    bool indexLoaded { false };
+    void loadObjectIndex();
+
+    /// \brief hash of the fields a refresh can change, the update time is left out
+    static std::string contentHash(const std::shared_ptr<CdsObject>& obj);
+
     std::shared_ptr<Config> config;
     std::shared_ptr<Database> database;
     std::shared_ptr<ContentManager> content;
@@ -34,126 +34,10 @@
 
 #include "content/content_manager.h"
 #include "content/layout/layout.h"
-
-void TaskProcessor::run()
-{
-    threadRunner = std::make_unique<StdThreadRunner>("TaskProcessorThread", TaskProcessor::staticThreadProc, this, config);
-
-    if (!threadRunner->isAlive())
-        throw_std_runtime_error("Failed to task processor thread");
-}
-
-void TaskProcessor::shutdown()
-{
-    log_debug("Shutting down TaskProcessor");
-    shutdownFlag = true;
-    threadRunner->notify();
-    threadRunner->join();
-}
-
-void* TaskProcessor::staticThreadProc(void* arg)
-{
-    auto inst = static_cast<TaskProcessor*>(arg);
-    inst->threadProc();
-    return nullptr;
-}
-
-void TaskProcessor::threadProc()
-{
-    std::shared_ptr<GenericTask> task;
-    auto lock = threadRunner->uniqueLock();
-    working = true;
-
-    while (!shutdownFlag) {
-        currentTask = nullptr;
-
-        task = nullptr;
-        if (!taskQueue.empty()) {
-            task = taskQueue.front();
-            taskQueue.pop_front();
-        }
-
-        if (task == nullptr) {
-            working = false;
-            threadRunner->wait(lock);
-            working = true;
-            continue;
-        }
-
-        currentTask = task;
-        lock.unlock();
-
-        try {
-            if (task->isValid())
-                task->run();
-        } catch (const ServerShutdownException& se) {
-            shutdownFlag = true;
-        } catch (const std::runtime_error& e) {
-            log_error("Exception caught: {}", e.what());
-        }
-
-        if (!shutdownFlag) {
-            lock.lock();
-        }
-    }
-}
-
-void TaskProcessor::addTask(const std::shared_ptr<GenericTask>& task)
-{
-    auto lock = threadRunner->lockGuard();
-
-    task->setID(taskID++);
-
-    taskQueue.push_back(task);
-    threadRunner->notify();
-}
-
-std::shared_ptr<GenericTask> TaskProcessor::getCurrentTask()
-{
-    std::shared_ptr<GenericTask> task;
-    auto lock = threadRunner->lockGuard();
-    task = currentTask;
-    return task;
-}
-
-void TaskProcessor::invalidateTask(unsigned int taskID)
-{
-    auto lock = threadRunner->lockGuard();
-    auto tc = getCurrentTask();
-    if (tc != nullptr) {
-        if ((tc->getID() == taskID) || (tc->getParentID() == taskID)) {
-            tc->invalidate();
-        }
-    }
-
-    for (const auto& tq : taskQueue) {
-        if ((tq->getID() == taskID) || (tq->getParentID() == taskID)) {
-            tq->invalidate();
-        }
-    }
-}
-
-std::deque<std::shared_ptr<GenericTask>> TaskProcessor::getTasklist()
-{
-    std::deque<std::shared_ptr<GenericTask>> taskList;
-
-    auto lock = threadRunner->lockGuard();
-    auto tc = getCurrentTask();
-
-    // if there is no current task, then the queues are empty
-    // and we do not have to allocate the array
-    if (tc == nullptr)
-        return taskList;
-
-    taskList.push_back(tc);
-
-    std::copy_if(taskQueue.begin(), taskQueue.end(), std::back_inserter(taskList), [](const auto& task) { return task->isValid(); });
-
-    return taskList;
-}
+#include "util/task_scheduler.h"
 
 TPFetchOnlineContentTask::TPFetchOnlineContentTask(std::shared_ptr<ContentManager> content,
-    std::shared_ptr<TaskProcessor> task_processor,
+    std::shared_ptr<TaskScheduler> scheduler,
     std::shared_ptr<Timer> timer,
     std::shared_ptr<OnlineService> service,
     std::shared_ptr<Layout> layout,
@@ -161,7 +45,7 @@ TPFetchOnlineContentTask::TPFetchOnlineContentTask(std::shared_ptr<ContentManage
     bool unscheduled_refresh)
     : GenericTask(TaskProcessorTask)
     , content(std::move(content))
-    , task_processor(std::move(task_processor))
+    , scheduler(std::move(scheduler))
     , timer(std::move(timer))
     , service(std::move(service))
     , layout(std::move(layout))
@@ -186,8 +70,10 @@ void TPFetchOnlineContentTask::run()
 
             if ((service->getRefreshInterval() > 0) || unscheduled_refresh) {
                 auto t = std::make_shared<TPFetchOnlineContentTask>(
-                    content, task_processor, timer, service, layout, cancellable, unscheduled_refresh);
-                task_processor->addTask(t);
+                    content, scheduler, timer, service, layout, cancellable, unscheduled_refresh);
+                t->setDescription(getDescription());
+                t->setGroup(getGroup());
+                scheduler->addTask(t, getPriority());
             }
         } else {
             content->cleanupOnlineServiceObjects(service);
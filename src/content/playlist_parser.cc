@@ -0,0 +1,255 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    playlist_parser.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+
+/// \file playlist_parser.cc
+
+#include "playlist_parser.h" // API
+
+#include <fstream>
+#include <regex>
+
+#include "cds_objects.h"
+#include "config/config.h"
+#include "content_manager.h"
+#include "database/database.h"
+#include "upnp_common.h"
+#include "util/generic_task.h"
+#include "util/string_converter.h"
+#include "util/tools.h"
+
+#define PLAYLIST_TYPE_M3U "audio/x-mpegurl"
+#define PLAYLIST_TYPE_PLS "audio/x-scpls"
+
+PlaylistParser::PlaylistParser(std::shared_ptr<ContentManager> content)
+    : content(std::move(content))
+{
+    auto context = this->content->getContext();
+    config = context->getConfig();
+    database = context->getDatabase();
+    p2i = StringConverter::p2i(config);
+#ifdef HAVE_JS
+    linkObjects = config->getBoolOption(CFG_IMPORT_SCRIPTING_PLAYLIST_SCRIPT_LINK_OBJECTS);
+#else
+    linkObjects = true;
+#endif
+}
+
+PlaylistParser::~PlaylistParser() = default;
+
+bool PlaylistParser::canParse(const std::string& mimeType)
+{
+    return mimeType == PLAYLIST_TYPE_M3U || mimeType == PLAYLIST_TYPE_PLS;
+}
+
+/// \brief next line that is not empty, without surrounding whitespace
+static bool readLine(std::istream& file, std::string& line, const std::shared_ptr<GenericTask>& task)
+{
+    while (std::getline(file, line)) {
+        if (task != nullptr && !task->isValid())
+            return false;
+        trimStringInPlace(line);
+        if (!line.empty())
+            return true;
+    }
+    return false;
+}
+
+std::vector<PlaylistParser::Entry> PlaylistParser::readM3u(std::istream& file, const std::shared_ptr<GenericTask>& task)
+{
+    static const std::regex extInf("^#EXTINF:(-?\\d+),\\s?(\\S.+)$", std::regex::icase);
+
+    std::vector<Entry> entries;
+    std::string title;
+    std::string line;
+    std::smatch matches;
+    while (readLine(file, line, task)) {
+        if (std::regex_match(line, matches, extInf)) {
+            title = matches[2];
+        } else if (line.front() != '#') {
+            entries.push_back({ line, title, 0 });
+            title.clear();
+        }
+    }
+    return entries;
+}
+
+std::vector<PlaylistParser::Entry> PlaylistParser::readPls(std::istream& file, const std::shared_ptr<GenericTask>& task)
+{
+    static const std::regex fileLine("^File\\s*(\\d+)\\s*=\\s*(\\S.+)$", std::regex::icase);
+    static const std::regex titleLine("^Title\\s*(\\d+)\\s*=\\s*(\\S.+)$", std::regex::icase);
+
+    std::vector<Entry> entries;
+    std::string location;
+    std::string title;
+    int lastId = -1;
+    std::string line;
+    std::smatch matches;
+    while (readLine(file, line, task)) {
+        bool isFile = std::regex_match(line, matches, fileLine);
+        if (!isFile && !std::regex_match(line, matches, titleLine))
+            continue;
+
+        // File1=..., Title1=... belong together, the entry is done when the number changes
+        int id = stoiString(matches[1]);
+        if (lastId == -1)
+            lastId = id;
+        if (lastId != id) {
+            if (!location.empty())
+                entries.push_back({ location, title, lastId });
+            location.clear();
+            title.clear();
+            lastId = id;
+        }
+        (isFile ? location : title) = matches[2];
+    }
+    if (!location.empty())
+        entries.push_back({ location, title, lastId });
+    return entries;
+}
+
+void PlaylistParser::processPlaylistObject(const std::shared_ptr<CdsObject>& playlist, const std::shared_ptr<GenericTask>& task)
+{
+    if (!playlist->isPureItem())
+        throw_std_runtime_error("only allowed for pure items");
+
+    auto mimeType = std::static_pointer_cast<CdsItem>(playlist)->getMimeType();
+    std::ifstream file(playlist->getLocation());
+    if (!file)
+        throw_std_runtime_error("Failed to open file: {}", playlist->getLocation().c_str());
+
+    log_debug("Processing playlist: {}", playlist->getLocation().c_str());
+    auto entries = (mimeType == PLAYLIST_TYPE_PLS) ? readPls(file, task) : readM3u(file, task);
+
+    auto playlistTitle = playlist->getTitle();
+    auto dot = playlistTitle.rfind('.');
+    if (dot != std::string::npos && dot > 1)
+        playlistTitle = playlistTitle.substr(0, dot);
+    auto lastPath = playlist->getLocation().parent_path().filename().string();
+
+    auto container = [](const std::string& title, const std::string& upnpClass) {
+        auto result = std::make_shared<CdsContainer>();
+        result->setTitle(title);
+        result->setClass(upnpClass);
+        return std::static_pointer_cast<CdsObject>(result);
+    };
+    std::vector<int> parentIDs;
+    parentIDs.push_back(content->addContainerTree({ container("Playlists", UPNP_CLASS_CONTAINER),
+                                                      container("All Playlists", UPNP_CLASS_CONTAINER),
+                                                      container(playlistTitle, UPNP_CLASS_PLAYLIST_CONTAINER) })
+                            .first);
+    if (!lastPath.empty()) {
+        parentIDs.push_back(content->addContainerTree({ container("Playlists", UPNP_CLASS_CONTAINER),
+                                                          container("Directories", UPNP_CLASS_CONTAINER),
+                                                          container(lastPath, UPNP_CLASS_CONTAINER),
+                                                          container(playlistTitle, UPNP_CLASS_PLAYLIST_CONTAINER) })
+                                .first);
+    }
+    parentIDs.erase(std::remove(parentIDs.begin(), parentIDs.end(), INVALID_OBJECT_ID), parentIDs.end());
+
+    int playlistOrder = 1;
+    for (auto&& entry : entries) {
+        if (task != nullptr && !task->isValid())
+            return;
+        int order = entry.order > 0 ? entry.order : playlistOrder++;
+        try {
+            addEntry(playlist, playlistTitle, entry, order, parentIDs);
+        } catch (const ServerShutdownException& se) {
+            throw se;
+        } catch (const std::runtime_error& e) {
+            log_error("{}", e.what());
+        }
+    }
+}
+
+void PlaylistParser::addEntry(const std::shared_ptr<CdsObject>& playlist, const std::string& playlistTitle, const Entry& entry, int order, const std::vector<int>& parentIDs)
+{
+    std::string title = p2i->convert(entry.title);
+
+    if (entry.location.find("://") != std::string::npos) {
+        for (auto&& parentID : parentIDs) {
+            auto item = std::make_shared<CdsItemExternalURL>();
+            item->setVirtual(true);
+            item->setRestricted(true);
+            item->setLocation(entry.location);
+            item->setTitle(title.empty() ? entry.location : title);
+            item->setClass(UPNP_CLASS_MUSIC_TRACK);
+            // most playlist formats do not tell the mimetype
+            item->setMimeType("audio/mpeg");
+            item->setMetadata(M_DESCRIPTION, fmt::format("Song from {}", playlistTitle));
+            item->setTrackNumber(order);
+
+            auto resource = std::make_shared<CdsResource>(CH_DEFAULT);
+            resource->addAttribute(R_PROTOCOLINFO, renderProtocolInfo(item->getMimeType(), "http-get"));
+            item->addResource(resource);
+
+            if (linkObjects) {
+                item->setFlag(OBJECT_FLAG_PLAYLIST_REF);
+                item->setRefID(playlist->getID());
+            }
+            item->setParentID(parentID);
+            content->addObject(item, false);
+        }
+        return;
+    }
+
+    fs::path location = entry.location;
+    if (location.is_relative())
+        location = playlist->getLocation().parent_path() / location;
+
+    std::error_code ec;
+    auto dirEnt = fs::directory_entry(location, ec);
+    if (ec) {
+        log_error("Failed to read {}: {}", location.c_str(), ec.message());
+        return;
+    }
+
+    AutoScanSetting asSetting;
+    asSetting.followSymlinks = config->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS);
+    asSetting.recursive = false;
+    asSetting.hidden = config->getBoolOption(CFG_IMPORT_HIDDEN_FILES);
+    asSetting.rescanResource = false;
+    asSetting.mergeOptions(config, location);
+
+    int objectID = content->addFile(dirEnt, asSetting, false);
+    auto original = objectID != INVALID_OBJECT_ID ? database->loadObject(objectID) : nullptr;
+    if (original == nullptr || !original->isItem()) {
+        log_debug("Skipping item: {}", location.c_str());
+        return;
+    }
+
+    for (auto&& parentID : parentIDs) {
+        auto item = std::static_pointer_cast<CdsItem>(CdsObject::createObject(original->getObjectType()));
+        original->copyTo(item);
+        item->setVirtual(true);
+        auto metaTitle = original->getMetadata(M_TITLE);
+        if (!metaTitle.empty())
+            item->setTitle(metaTitle);
+        item->setTrackNumber(order);
+        item->setFlag(OBJECT_FLAG_USE_RESOURCE_REF);
+        item->setRefID(objectID);
+        item->setParentID(parentID);
+        item->setID(INVALID_OBJECT_ID);
+        content->addObject(item, false);
+    }
+}
@@ -0,0 +1,78 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    playlist_parser.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+
+/// \file playlist_parser.h
+#ifndef __PLAYLIST_PARSER_H__
+#define __PLAYLIST_PARSER_H__
+
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <vector>
+
+#include "common.h"
+namespace fs = std::filesystem;
+
+// forward declaration
+class CdsObject;
+class Config;
+class ContentManager;
+class Database;
+class GenericTask;
+class StringConverter;
+
+/// \brief Adds the entries of m3u and pls playlists without running the playlist script
+///
+/// Creates the same containers and items as the default playlists.js.
+class PlaylistParser {
+public:
+    explicit PlaylistParser(std::shared_ptr<ContentManager> content);
+    ~PlaylistParser();
+
+    /// \brief true if the playlist can be parsed, i.e. it is a m3u or pls file
+    static bool canParse(const std::string& mimeType);
+
+    void processPlaylistObject(const std::shared_ptr<CdsObject>& playlist, const std::shared_ptr<GenericTask>& task);
+
+protected:
+    /// \brief entry of the playlist, order 0 means it is numbered in the order of the file
+    struct Entry {
+        std::string location;
+        std::string title;
+        int order { 0 };
+    };
+
+    static std::vector<Entry> readM3u(std::istream& file, const std::shared_ptr<GenericTask>& task);
+    static std::vector<Entry> readPls(std::istream& file, const std::shared_ptr<GenericTask>& task);
+
+    void addEntry(const std::shared_ptr<CdsObject>& playlist, const std::string& playlistTitle, const Entry& entry, int order, const std::vector<int>& parentIDs);
+
+    std::shared_ptr<ContentManager> content;
+    std::shared_ptr<Config> config;
+    std::shared_ptr<Database> database;
+    std::unique_ptr<StringConverter> p2i;
+    bool linkObjects;
+};
+
+#endif // __PLAYLIST_PARSER_H__
@@ -35,22 +35,98 @@
 #include "config/config_manager.h"
 #include "content/content_manager.h"
 #include "js_functions.h"
+#include "scripting_runtime.h"
 
 ImportScript::ImportScript(std::shared_ptr<ContentManager> content,
     const std::shared_ptr<ScriptingRuntime>& runtime)
     : Script(std::move(content), runtime, "import")
 {
     std::string scriptPath = config->getOption(CFG_IMPORT_SCRIPTING_IMPORT_SCRIPT);
+    timeout = std::chrono::milliseconds(config->getIntOption(CFG_IMPORT_SCRIPTING_TIMEOUT));
+    importFunction = config->getOption(CFG_IMPORT_SCRIPTING_IMPORT_FUNCTION);
 
     try {
         load(scriptPath);
     } catch (const std::runtime_error& ex) {
         throw ex;
     }
+
+    if (!importFunction.empty()) {
+        // the script only defines the function, there is no orig yet
+        execute();
+        ScriptingRuntime::AutoLock lock(runtime->getMutex());
+        duk_get_global_string(ctx, importFunction.c_str());
+        bool isFunction = duk_is_function(ctx, -1);
+        duk_pop(ctx);
+        if (!isFunction)
+            throw_std_runtime_error("Import script {} does not define the function {}", scriptPath, importFunction);
+    }
+}
+
+void ImportScript::processCdsObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, const std::string& scriptpath)
+{
+    if (importFunction.empty()) {
+        for (auto&& obj : objects) {
+            try {
+                processCdsObject(obj, scriptpath);
+            } catch (const std::runtime_error& e) {
+                log_error("{}", e.what());
+            }
+        }
+        return;
+    }
+
+    for (auto&& obj : objects)
+        batch[obj->getID()] = obj;
+    try {
+        ScriptingRuntime::AutoLock lock(runtime->getMutex());
+        duk_get_global_string(ctx, importFunction.c_str());
+        duk_push_array(ctx);
+        duk_uarridx_t index = 0;
+        for (auto&& obj : objects) {
+            cdsObject2dukObject(obj);
+            duk_put_prop_index(ctx, -2, index++);
+        }
+        duk_push_string(ctx, scriptpath.c_str());
+        auto autoScan = content->getAutoscanDirectory(scriptpath);
+        if (autoScan && !scriptpath.empty())
+            duk_push_sprintf(ctx, "%d", autoScan->getScanID());
+        else
+            duk_push_undefined(ctx);
+
+        auto start = std::chrono::steady_clock::now();
+        auto limit = timeout * objects.size();
+        runtime->setTimeout(limit);
+        if (duk_pcall(ctx, 3) != DUK_EXEC_SUCCESS) {
+            bool timedOut = runtime->isTimedOut();
+            runtime->setTimeout(std::chrono::milliseconds::zero());
+            log_error("Failed to execute {}: {}", importFunction, duk_safe_to_string(ctx, -1));
+            duk_pop(ctx);
+            if (timedOut)
+                log_error("Import script was aborted after {} ms on {} objects in {}", limit.count(), objects.size(), scriptpath);
+            throw_std_runtime_error("Script: failed to execute {}", importFunction);
+        }
+        runtime->setTimeout(std::chrono::milliseconds::zero());
+        duk_pop(ctx);
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        if (timeout.count() > 0 && duration > limit)
+            log_warning("Import script took {} ms on {} objects in {}", duration.count(), objects.size(), scriptpath);
+    } catch (const std::runtime_error&) {
+        batch.clear();
+        throw;
+    }
+    batch.clear();
+
+    collectGarbage();
 }
 
 void ImportScript::processCdsObject(const std::shared_ptr<CdsObject>& obj, const std::string& scriptpath)
 {
+    if (!importFunction.empty()) {
+        processCdsObjects({ obj }, scriptpath);
+        return;
+    }
+
     processed = obj;
     try {
         cdsObject2dukObject(obj);
@@ -62,7 +138,21 @@ void ImportScript::processCdsObject(const std::shared_ptr<CdsObject>& obj, const
             duk_push_sprintf(ctx, "%d", autoScan->getScanID());
             duk_put_global_string(ctx, "object_autoscan_id");
         }
-        execute();
+        auto start = std::chrono::steady_clock::now();
+        runtime->setTimeout(timeout);
+        try {
+            execute();
+        } catch (const std::runtime_error&) {
+            bool timedOut = runtime->isTimedOut();
+            runtime->setTimeout(std::chrono::milliseconds::zero());
+            if (timedOut)
+                log_error("Import script was aborted after {} ms on {}", timeout.count(), obj->getLocation().c_str());
+            throw;
+        }
+        runtime->setTimeout(std::chrono::milliseconds::zero());
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        if (timeout.count() > 0 && duration > timeout)
+            log_warning("Import script took {} ms on {}", duration.count(), obj->getLocation().c_str());
         duk_push_global_object(ctx);
         duk_del_prop_string(ctx, -1, "orig");
         duk_del_prop_string(ctx, -1, "object_script_path");
@@ -79,10 +169,6 @@ void ImportScript::processCdsObject(const std::shared_ptr<CdsObject>& obj, const
 
     processed = nullptr;
 
-    gc_counter++;
-    if (gc_counter > JS_CALL_GC_AFTER_NUM) {
-        duk_gc(ctx, 0);
-        gc_counter = 0;
-    }
+    collectGarbage();
 }
 #endif // HAVE_JS
@@ -32,7 +32,9 @@
 #ifndef __SCRIPTING_IMPORT_SCRIPT_H__
 #define __SCRIPTING_IMPORT_SCRIPT_H__
 
+#include <chrono>
 #include <memory>
+#include <vector>
 
 #include "common.h"
 #include "script.h"
@@ -48,7 +50,15 @@ public:
     ~ImportScript() override = default;
 
     void processCdsObject(const std::shared_ptr<CdsObject>& obj, const std::string& scriptpath);
+    /// \brief pass all objects to the import function at once, processed one by one if there is none
+    void processCdsObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, const std::string& scriptpath);
     script_class_t whoami() override { return S_IMPORT; }
+
+protected:
+    /// \brief time one object may take, zero for no limit
+    std::chrono::milliseconds timeout;
+    /// \brief CFG_IMPORT_SCRIPTING_IMPORT_FUNCTION, empty to run the whole script for each object
+    std::string importFunction;
 };
 
 #endif // __SCRIPTING_IMPORT_SCRIPT_H__
@@ -36,6 +36,7 @@
 
 #include "config/config_manager.h"
 #include "content/content_manager.h"
+#include "content/import_statistics.h"
 #include "database/database.h"
 #include "metadata/metadata_handler.h"
 #include "script.h"
@@ -55,6 +56,7 @@ duk_ret_t js_print(duk_context* ctx)
 duk_ret_t js_copyObject(duk_context* ctx)
 {
     auto* self = Script::getContextScript(ctx);
+    ImportStatistics::StageTimer stageTimer(self->getImportStatistics(), ImportStatistics::Stage::ScriptCopyObject);
     if (!duk_is_object(ctx, 0))
         return duk_error(ctx, DUK_ERR_TYPE_ERROR, "copyObject argument is not an object");
     auto cds_obj = self->dukObject2cdsObject(nullptr);
@@ -65,6 +67,7 @@ duk_ret_t js_copyObject(duk_context* ctx)
 duk_ret_t js_addContainerTree(duk_context* ctx)
 {
     auto* self = Script::getContextScript(ctx);
+    ImportStatistics::StageTimer stageTimer(self->getImportStatistics(), ImportStatistics::Stage::ScriptContainerTree);
 
     if (!duk_is_array(ctx, 0)) {
         log_js("js_addContainerTree: No Array");
@@ -106,9 +109,39 @@ duk_ret_t js_addContainerTree(duk_context* ctx)
     return 0;
 }
 
+/// \brief the object the script runs for, in an import batch the one with the id of the object at idx
+static std::shared_ptr<CdsObject> getOrigObject(duk_context* ctx, Script* self, duk_idx_t idx)
+{
+    if (self->whoami() == S_PLAYLIST)
+        duk_get_global_string(ctx, "playlist");
+    else if (self->whoami() == S_IMPORT)
+        duk_get_global_string(ctx, "orig");
+    else
+        duk_push_undefined(ctx);
+
+    if (duk_is_undefined(ctx, -1)) {
+        duk_pop(ctx);
+        if (self->whoami() == S_IMPORT) {
+            // objects of a batch and their copies keep the id
+            duk_dup(ctx, idx);
+            auto orig_object = self->getBatchObject(self->getIntProperty("id", INVALID_OBJECT_ID));
+            duk_pop(ctx);
+            if (orig_object != nullptr)
+                return orig_object;
+        }
+        log_debug("Could not retrieve orig/playlist object");
+        return nullptr;
+    }
+
+    auto orig_object = self->dukObject2cdsObject(self->getProcessedObject());
+    duk_pop(ctx);
+    return orig_object;
+}
+
 duk_ret_t js_addCdsObject(duk_context* ctx)
 {
     auto* self = Script::getContextScript(ctx);
+    ImportStatistics::StageTimer stageTimer(self->getImportStatistics(), ImportStatistics::Stage::ScriptAddObject);
 
     if (!duk_is_object(ctx, 0))
         return 0;
@@ -138,29 +171,18 @@ duk_ret_t js_addCdsObject(duk_context* ctx)
             i2i = StringConverter::i2i(config);
         }
 
-        if (self->whoami() == S_PLAYLIST)
-            duk_get_global_string(ctx, "playlist");
-        else if (self->whoami() == S_IMPORT)
-            duk_get_global_string(ctx, "orig");
-        else
-            duk_push_undefined(ctx);
-        //stack: js_cds_obj path containerclass js_orig_obj
-
-        if (duk_is_undefined(ctx, -1)) {
-            log_debug("Could not retrieve orig/playlist object");
-            return 0;
-        }
-
-        auto orig_object = self->dukObject2cdsObject(self->getProcessedObject());
+        auto orig_object = getOrigObject(ctx, self, 0);
         if (orig_object == nullptr)
             return 0;
+        duk_push_undefined(ctx);
+        //stack: js_cds_obj path containerclass undefined
 
         std::shared_ptr<CdsObject> cds_obj;
         auto cm = self->getContent();
         int pcd_id = INVALID_OBJECT_ID;
 
         duk_swap_top(ctx, 0);
-        //stack: js_orig_obj path containerclass js_cds_obj
+        //stack: undefined path containerclass js_cds_obj
         if (self->whoami() == S_PLAYLIST) {
             int otype = self->getIntProperty("objectType", -1);
             if (otype == -1) {
@@ -248,9 +270,88 @@ duk_ret_t js_addCdsObject(duk_context* ctx)
     return 0;
 }
 
+duk_ret_t js_addCdsObjects(duk_context* ctx)
+{
+    auto* self = Script::getContextScript(ctx);
+    ImportStatistics::StageTimer stageTimer(self->getImportStatistics(), ImportStatistics::Stage::ScriptAddObject);
+
+    if (self->whoami() != S_IMPORT)
+        return duk_error(ctx, DUK_ERR_TYPE_ERROR, "addCdsObjects is only available in the import script");
+    if (!duk_is_object(ctx, 0) || !duk_is_array(ctx, 1))
+        return 0;
+    duk_to_object(ctx, 0);
+
+    try {
+        auto orig_object = getOrigObject(ctx, self, 0);
+        if (orig_object == nullptr)
+            return 0;
+
+        // the object is converted once and copied for each chain
+        duk_dup(ctx, 0);
+        auto cds_obj = self->dukObject2cdsObject(orig_object);
+        duk_pop(ctx);
+        if (cds_obj == nullptr)
+            return 0;
+
+        auto i2i = StringConverter::i2i(self->getConfig());
+        auto cm = self->getContent();
+        duk_push_array(ctx);
+        //stack: js_cds_obj chains ids
+        duk_uarridx_t index = 0;
+        auto length = duk_get_length(ctx, 1);
+        for (duk_size_t i = 0; i < length; i++) {
+            std::string path;
+            std::string containerclass;
+            duk_get_prop_index(ctx, 1, i);
+            if (duk_is_array(ctx, -1)) {
+                duk_get_prop_index(ctx, -1, 0);
+                path = duk_to_string(ctx, -1);
+                duk_pop(ctx);
+                duk_get_prop_index(ctx, -1, 1);
+                if (!duk_is_null_or_undefined(ctx, -1))
+                    containerclass = duk_to_string(ctx, -1);
+                duk_pop(ctx);
+            } else if (!duk_is_null_or_undefined(ctx, -1)) {
+                path = duk_to_string(ctx, -1);
+            }
+            duk_pop(ctx);
+            if (path.empty()) {
+                log_js("addCdsObjects: no chain at {}", i);
+                continue;
+            }
+
+            std::pair<int, bool> parentId = { stoiString(path), false };
+            if (parentId.first <= 0)
+                parentId = cm->addContainerChain(i2i->convert(path), containerclass, INVALID_OBJECT_ID, orig_object);
+
+            auto obj = CdsObject::createObject(cds_obj->getObjectType());
+            cds_obj->copyTo(obj);
+            obj->setParentID(parentId.first);
+            if (!obj->isExternalItem()) {
+                obj->setRefID(orig_object->getID());
+                obj->setFlag(OBJECT_FLAG_USE_RESOURCE_REF);
+            }
+            obj->setID(INVALID_OBJECT_ID);
+            cm->addObject(obj, parentId.second);
+
+            std::string tmp = fmt::to_string(parentId.first);
+            duk_push_string(ctx, tmp.c_str());
+            duk_put_prop_index(ctx, -2, index++);
+        }
+        return 1;
+    } catch (const ServerShutdownException& se) {
+        log_warning("Aborting script execution due to server shutdown.");
+        return duk_error(ctx, DUK_ERR_ERROR, "Aborting script execution due to server shutdown.\n");
+    } catch (const std::runtime_error& e) {
+        log_error("{}", e.what());
+    }
+    return 0;
+}
+
 static duk_ret_t convert_charset_generic(duk_context* ctx, charset_convert_t chr)
 {
     auto* self = Script::getContextScript(ctx);
+    ImportStatistics::StageTimer stageTimer(self->getImportStatistics(), ImportStatistics::Stage::ScriptCharset);
     if (duk_get_top(ctx) != 1)
         return DUK_RET_SYNTAX_ERROR;
     if (!duk_is_string(ctx, 0))
@@ -43,6 +43,9 @@ duk_ret_t js_print(duk_context* ctx);
 /// \brief Adds an object to the database.
 duk_ret_t js_addCdsObject(duk_context* ctx);
 
+/// \brief Adds an object to several container chains at once.
+duk_ret_t js_addCdsObjects(duk_context* ctx);
+
 /// \brief Creates a tree of containers.
 duk_ret_t js_addContainerTree(duk_context* ctx);
 
@@ -202,10 +202,6 @@ void PlaylistParserScript::processPlaylistObject(const std::shared_ptr<CdsObject
     currentObjectID = INVALID_OBJECT_ID;
     currentTask = nullptr;
 
-    gc_counter++;
-    if (gc_counter > JS_CALL_GC_AFTER_NUM) {
-        duk_gc(ctx, 0);
-        gc_counter = 0;
-    }
+    collectGarbage();
 }
 #endif // HAVE_JS
@@ -32,7 +32,11 @@
 #ifdef HAVE_JS
 #include "script.h" // API
 
+#include <array>
+#include <cstring>
 #include <fmt/chrono.h>
+#include <map>
+#include <mutex>
 
 #include "cds_objects.h"
 #include "config/config_manager.h"
@@ -54,9 +58,10 @@
 #include "content/onlineservice/atrailers_content_handler.h"
 #endif
 
-static constexpr std::array<duk_function_list_entry, 9> js_global_functions = { {
+static constexpr std::array<duk_function_list_entry, 10> js_global_functions = { {
     { "print", js_print, DUK_VARARGS },
     { "addCdsObject", js_addCdsObject, 3 },
+    { "addCdsObjects", js_addCdsObjects, 2 },
     { "addContainerTree", js_addContainerTree, 1 },
     { "copyObject", js_copyObject, 1 },
     { "f2i", js_f2i, 1 },
@@ -147,7 +152,10 @@ Script::Script(std::shared_ptr<ContentManager> content,
     , runtime(runtime)
     , name(name)
 {
+    importStatistics = this->content->getContext()->getImportStatistics().get();
     gc_counter = 0;
+    gcInterval = config->getIntOption(CFG_IMPORT_SCRIPTING_GC_INTERVAL);
+    gcHeapGrowth = std::size_t(config->getIntOption(CFG_IMPORT_SCRIPTING_GC_HEAP_GROWTH)) * 1024;
 
     this->runtime = runtime;
 
@@ -346,6 +354,188 @@ void Script::defineFunctions(const duk_function_list_entry* functions)
     duk_pop(ctx);
 }
 
+/// \brief hidden properties of a js object created by cdsObject2dukObject
+#define JS_LAZY_SOURCE DUK_HIDDEN_SYMBOL("source")
+#define JS_LAZY_FIELDS DUK_HIDDEN_SYMBOL("lazy")
+
+/// \brief properties that are only converted when the script reads them
+enum LazyField {
+    LAZY_META = 1,
+    LAZY_AUX = 2,
+    LAZY_RES = 4,
+};
+static constexpr std::array<std::pair<LazyField, const char*>, 3> lazyFields { {
+    { LAZY_META, "meta" },
+    { LAZY_AUX, "aux" },
+    { LAZY_RES, "res" },
+} };
+
+/// \brief source of the object at idx if field was not converted yet
+static std::shared_ptr<CdsObject> getLazySource(duk_context* ctx, duk_idx_t idx, int field)
+{
+    idx = duk_normalize_index(ctx, idx);
+    duk_get_prop_string(ctx, idx, JS_LAZY_FIELDS);
+    int lazy = duk_is_number(ctx, -1) ? duk_get_int(ctx, -1) : 0;
+    duk_pop(ctx);
+    if (!(lazy & field))
+        return nullptr;
+
+    duk_get_prop_string(ctx, idx, JS_LAZY_SOURCE);
+    auto source = static_cast<std::shared_ptr<CdsObject>*>(duk_get_pointer(ctx, -1));
+    duk_pop(ctx);
+    return source ? *source : nullptr;
+}
+
+/// \brief replace the accessor of field by the value on top of the stack
+static void materializeLazyField(duk_context* ctx, duk_idx_t idx, int field)
+{
+    idx = duk_normalize_index(ctx, idx);
+    duk_get_prop_string(ctx, idx, JS_LAZY_FIELDS);
+    int lazy = duk_get_int(ctx, -1) & ~field;
+    duk_pop(ctx);
+    duk_push_int(ctx, lazy);
+    duk_put_prop_string(ctx, idx, JS_LAZY_FIELDS);
+
+    for (const auto& [lazyField, key] : lazyFields) {
+        if (lazyField != field)
+            continue;
+        duk_push_string(ctx, key);
+        duk_dup(ctx, -2);
+        duk_def_prop(ctx, idx, DUK_DEFPROP_HAVE_VALUE | DUK_DEFPROP_SET_WRITABLE | DUK_DEFPROP_SET_ENUMERABLE | DUK_DEFPROP_SET_CONFIGURABLE);
+    }
+}
+
+static duk_ret_t lazyGetter(duk_context* ctx)
+{
+    auto field = duk_get_current_magic(ctx);
+    duk_push_this(ctx);
+    auto source = getLazySource(ctx, -1, field);
+    if (source == nullptr)
+        return 0;
+
+    auto self = Script::getContextScript(ctx);
+    if (field == LAZY_META)
+        self->pushMetadata(source);
+    else if (field == LAZY_AUX)
+        self->pushAuxData(source);
+    else
+        self->pushResources(source);
+    materializeLazyField(ctx, -2, field);
+    return 1;
+}
+
+static duk_ret_t lazySetter(duk_context* ctx)
+{
+    auto field = duk_get_current_magic(ctx);
+    duk_push_this(ctx);
+    duk_dup(ctx, 0);
+    materializeLazyField(ctx, -2, field);
+    return 0;
+}
+
+static duk_ret_t lazySourceFinalizer(duk_context* ctx)
+{
+    duk_get_prop_string(ctx, 0, JS_LAZY_SOURCE);
+    delete static_cast<std::shared_ptr<CdsObject>*>(duk_get_pointer(ctx, -1));
+    duk_pop(ctx);
+    duk_push_pointer(ctx, nullptr);
+    duk_put_prop_string(ctx, 0, JS_LAZY_SOURCE);
+    return 0;
+}
+
+/// \brief compiled scripts of all runtimes, every import runtime loads the same files
+struct CompiledScript {
+    std::uint64_t sourceHash;
+    std::vector<std::byte> code;
+};
+static std::map<std::string, CompiledScript> compiledScripts;
+static std::mutex compiledScriptsMutex;
+
+/// \brief written in front of the bytecode, the format changes with the Duktape version
+struct CompiledScriptHeader {
+    std::uint64_t sourceHash;
+    long dukVersion;
+};
+
+static fs::path getCompiledScriptPath(const std::shared_ptr<Config>& config, const std::string& scriptPath)
+{
+    auto home = fs::path(config->getOption(CFG_SERVER_HOME));
+    return home / "script-cache" / fmt::format("{:016x}.bc", std::uint64_t(stringHash(scriptPath)));
+}
+
+static duk_ret_t loadFunction(duk_context* ctx, [[maybe_unused]] void* udata)
+{
+    duk_load_function(ctx);
+    return 1;
+}
+
+bool Script::loadCompiled(const std::string& scriptPath, std::uint64_t sourceHash)
+{
+    std::vector<std::byte> code;
+    {
+        std::lock_guard<std::mutex> lock(compiledScriptsMutex);
+        auto entry = compiledScripts.find(scriptPath);
+        if (entry != compiledScripts.end() && entry->second.sourceHash == sourceHash)
+            code = entry->second.code;
+    }
+    if (code.empty()) {
+        auto cacheFile = getCompiledScriptPath(config, scriptPath);
+        std::optional<std::vector<std::byte>> data;
+        try {
+            data = readBinaryFile(cacheFile);
+        } catch (const std::runtime_error& e) {
+            log_debug("{}: {}", cacheFile.c_str(), e.what());
+        }
+        if (!data || data->size() <= sizeof(CompiledScriptHeader))
+            return false;
+        CompiledScriptHeader header;
+        std::memcpy(&header, data->data(), sizeof(header));
+        if (header.sourceHash != sourceHash || header.dukVersion != DUK_VERSION)
+            return false;
+        code.assign(data->begin() + sizeof(header), data->end());
+        std::lock_guard<std::mutex> lock(compiledScriptsMutex);
+        compiledScripts[scriptPath] = CompiledScript { sourceHash, code };
+    }
+
+    std::memcpy(duk_push_fixed_buffer(ctx, code.size()), code.data(), code.size());
+    if (duk_safe_call(ctx, loadFunction, nullptr, 1, 1) != DUK_EXEC_SUCCESS) {
+        log_warning("Ignoring compiled {}: {}", scriptPath, duk_safe_to_string(ctx, -1));
+        duk_pop(ctx);
+        return false;
+    }
+    log_debug("Loaded compiled {}", scriptPath);
+    return true;
+}
+
+void Script::storeCompiled(const std::string& scriptPath, std::uint64_t sourceHash)
+{
+    // the compiled function is on top of the stack and stays there
+    duk_dup_top(ctx);
+    duk_dump_function(ctx);
+    duk_size_t size;
+    auto data = static_cast<const std::byte*>(duk_get_buffer(ctx, -1, &size));
+    std::vector<std::byte> code(data, data + size);
+    duk_pop(ctx);
+
+    CompiledScriptHeader header { sourceHash, DUK_VERSION };
+    std::vector<std::byte> file(sizeof(header));
+    std::memcpy(file.data(), &header, sizeof(header));
+    file.insert(file.end(), code.begin(), code.end());
+    {
+        std::lock_guard<std::mutex> lock(compiledScriptsMutex);
+        compiledScripts[scriptPath] = CompiledScript { sourceHash, std::move(code) };
+    }
+
+    auto cacheFile = getCompiledScriptPath(config, scriptPath);
+    try {
+        fs::create_directories(cacheFile.parent_path());
+        writeBinaryFile(cacheFile, file.data(), file.size());
+    } catch (const std::runtime_error& e) {
+        // also catches fs::filesystem_error, the cache is optional
+        log_debug("Could not store compiled {}: {}", scriptPath, e.what());
+    }
+}
+
 void Script::_load(const std::string& scriptPath)
 {
     std::string scriptText = readTextFile(scriptPath);
@@ -360,11 +550,16 @@ void Script::_load(const std::string& scriptPath)
         throw_std_runtime_error("Failed to convert import script: {}", e.what());
     }
 
+    auto sourceHash = std::uint64_t(stringHash(scriptText));
+    if (loadCompiled(scriptPath, sourceHash))
+        return;
+
     duk_push_string(ctx, scriptPath.c_str());
     if (duk_pcompile_lstring_filename(ctx, 0, scriptText.c_str(), scriptText.length()) != 0) {
         log_error("Failed to load script: {}", duk_safe_to_string(ctx, -1));
         throw_std_runtime_error("Scripting: failed to compile {}", scriptPath.c_str());
     }
+    storeCompiled(scriptPath, sourceHash);
 }
 
 void Script::load(const std::string& scriptPath)
@@ -385,6 +580,20 @@ void Script::_execute()
     duk_pop(ctx);
 }
 
+void Script::collectGarbage()
+{
+    gc_counter++;
+    bool countReached = gcInterval > 0 && gc_counter >= gcInterval;
+    bool heapGrown = gcHeapGrowth > 0 && runtime->getHeapSize() > heapAfterGc + gcHeapGrowth;
+    if (!countReached && !heapGrown)
+        return;
+
+    duk_gc(ctx, 0);
+    heapAfterGc = runtime->getHeapSize();
+    log_debug("{}: garbage collected after {} runs, heap is {} bytes", name, gc_counter, heapAfterGc);
+    gc_counter = 0;
+}
+
 void Script::execute()
 {
     ScriptingRuntime::AutoLock lock(runtime->getMutex());
@@ -413,6 +622,10 @@ std::shared_ptr<CdsObject> Script::dukObject2cdsObject(const std::shared_ptr<Cds
     }
 
     auto obj = CdsObject::createObject(objType);
+    // untouched lazy properties are copied from the source object, they cannot have been changed
+    auto metaSource = getLazySource(ctx, -1, LAZY_META);
+    auto auxSource = getLazySource(ctx, -1, LAZY_AUX);
+    auto resSource = getLazySource(ctx, -1, LAZY_RES);
 
     // CdsObject
     obj->setVirtual(true); // JS creates only virtual objects
@@ -465,35 +678,48 @@ std::shared_ptr<CdsObject> Script::dukObject2cdsObject(const std::shared_ptr<Cds
     if (b >= 0)
         obj->setRestricted(b);
 
-    duk_get_prop_string(ctx, -1, "meta");
-    if (!duk_is_null_or_undefined(ctx, -1) && duk_is_object(ctx, -1)) {
-        duk_to_object(ctx, -1);
-        // only metadata enumerated in mt_keys is allowed
+    auto setMetadata = [&](metadata_fields_t sym, const std::string& val) {
+        if (sym == M_TRACKNUMBER) {
+            int j = stoiString(val, 0);
+            if (j > 0) {
+                obj->setMetadata(sym, val);
+                std::static_pointer_cast<CdsItem>(obj)->setTrackNumber(j);
+            } else
+                std::static_pointer_cast<CdsItem>(obj)->setTrackNumber(0);
+        } else if (sym == M_PARTNUMBER) {
+            int j = stoiString(val, 0);
+            if (j > 0) {
+                obj->setMetadata(sym, val);
+                std::static_pointer_cast<CdsItem>(obj)->setPartNumber(j);
+            } else
+                std::static_pointer_cast<CdsItem>(obj)->setPartNumber(0);
+        } else {
+            obj->setMetadata(sym, val);
+        }
+    };
+
+    if (metaSource != nullptr) {
         for (const auto& [sym, upnp] : mt_keys) {
-            val = getProperty(upnp);
-            if (!val.empty()) {
-                if (sym == M_TRACKNUMBER) {
-                    int j = stoiString(val, 0);
-                    if (j > 0) {
-                        obj->setMetadata(sym, val);
-                        std::static_pointer_cast<CdsItem>(obj)->setTrackNumber(j);
-                    } else
-                        std::static_pointer_cast<CdsItem>(obj)->setTrackNumber(0);
-                } else if (sym == M_PARTNUMBER) {
-                    int j = stoiString(val, 0);
-                    if (j > 0) {
-                        obj->setMetadata(sym, val);
-                        std::static_pointer_cast<CdsItem>(obj)->setPartNumber(j);
-                    } else
-                        std::static_pointer_cast<CdsItem>(obj)->setPartNumber(0);
-                } else {
-                    val = sc->convert(val);
-                    obj->setMetadata(sym, val);
-                }
+            val = metaSource->getMetadata(sym);
+            if (sym == M_TRACKNUMBER && metaSource->isItem() && std::static_pointer_cast<CdsItem>(metaSource)->getTrackNumber() > 0)
+                val = fmt::to_string(std::static_pointer_cast<CdsItem>(metaSource)->getTrackNumber());
+            if (!val.empty())
+                setMetadata(sym, val);
+        }
+    } else {
+        // the script read or replaced meta, or created the object itself
+        duk_get_prop_string(ctx, -1, "meta");
+        if (!duk_is_null_or_undefined(ctx, -1) && duk_is_object(ctx, -1)) {
+            duk_to_object(ctx, -1);
+            // only metadata enumerated in mt_keys is allowed
+            for (const auto& [sym, upnp] : mt_keys) {
+                val = getProperty(upnp);
+                if (!val.empty())
+                    setMetadata(sym, sym == M_TRACKNUMBER || sym == M_PARTNUMBER ? val : sc->convert(val));
             }
         }
+        duk_pop(ctx);
     }
-    duk_pop(ctx);
 
     // stuff that has not been exported to js
     if (pcd != nullptr) {
@@ -505,8 +731,11 @@ std::shared_ptr<CdsObject> Script::dukObject2cdsObject(const std::shared_ptr<Cds
         if (i >= 0)
             obj->setFlags(i);
 
-        duk_get_prop_string(ctx, -1, "res");
-        if (!duk_is_null_or_undefined(ctx, -1) && duk_is_object(ctx, -1)) {
+        if (resSource != nullptr)
+            obj->setResources(resSource->getResources());
+        else
+            duk_get_prop_string(ctx, -1, "res");
+        if (resSource == nullptr && !duk_is_null_or_undefined(ctx, -1) && duk_is_object(ctx, -1)) {
             duk_to_object(ctx, -1);
             auto keys = getPropertyNames();
 
@@ -550,10 +779,14 @@ std::shared_ptr<CdsObject> Script::dukObject2cdsObject(const std::shared_ptr<Cds
                 resCount++;
             }
         }
-        duk_pop(ctx); // res
-
-        duk_get_prop_string(ctx, -1, "aux");
-        if (!duk_is_null_or_undefined(ctx, -1) && duk_is_object(ctx, -1)) {
+        if (resSource == nullptr)
+            duk_pop(ctx); // res
+
+        if (auxSource != nullptr)
+            obj->setAuxData(auxSource->getAuxData());
+        else
+            duk_get_prop_string(ctx, -1, "aux");
+        if (auxSource == nullptr && !duk_is_null_or_undefined(ctx, -1) && duk_is_object(ctx, -1)) {
             duk_to_object(ctx, -1);
             auto keys = getPropertyNames();
             for (const auto& sym : keys) {
@@ -564,7 +797,8 @@ std::shared_ptr<CdsObject> Script::dukObject2cdsObject(const std::shared_ptr<Cds
                 }
             }
         }
-        duk_pop(ctx); // aux
+        if (auxSource == nullptr)
+            duk_pop(ctx); // aux
     }
 
     // CdsItem
@@ -649,6 +883,64 @@ std::shared_ptr<CdsObject> Script::dukObject2cdsObject(const std::shared_ptr<Cds
     return obj;
 }
 
+void Script::pushMetadata(const std::shared_ptr<CdsObject>& obj)
+{
+    duk_push_object(ctx);
+    // stack: meta_js
+
+    auto meta = obj->getMetadata();
+    for (const auto& [key, val] : meta) {
+        setProperty(key, val);
+    }
+
+    if (std::static_pointer_cast<CdsItem>(obj)->getTrackNumber() > 0)
+        setProperty(MetadataHandler::getMetaFieldName(M_TRACKNUMBER), fmt::to_string(std::static_pointer_cast<CdsItem>(obj)->getTrackNumber()));
+}
+
+void Script::pushAuxData(const std::shared_ptr<CdsObject>& obj)
+{
+    duk_push_object(ctx);
+    // stack: aux_js
+
+    auto aux = obj->getAuxData();
+
+#ifdef HAVE_ATRAILERS
+    auto tmp = obj->getAuxData(ATRAILERS_AUXDATA_POST_DATE);
+    if (!tmp.empty())
+        aux[ATRAILERS_AUXDATA_POST_DATE] = tmp;
+#endif
+
+    for (const auto& [key, val] : aux) {
+        setProperty(key, val);
+    }
+}
+
+void Script::pushResources(const std::shared_ptr<CdsObject>& obj)
+{
+    duk_push_object(ctx);
+    // stack: res_js
+
+    if (obj->getResourceCount() > 0) {
+        int resCount = 0;
+        for (const auto& res : obj->getResources()) {
+            setProperty(fmt::format("{}:handlerType", resCount), fmt::format("{}", res->getHandlerType()));
+            auto attributes = res->getAttributes();
+            for (const auto& [key, val] : attributes) {
+                setProperty(resCount == 0 ? key : fmt::format("{}-{}", resCount, key), val);
+            }
+            auto parameters = res->getParameters();
+            for (const auto& [key, val] : parameters) {
+                setProperty(fmt::format("{}#{}", resCount, key), val);
+            }
+            auto options = res->getOptions();
+            for (const auto& [key, val] : options) {
+                setProperty(fmt::format("{}%{}", resCount, key), val);
+            }
+            resCount++;
+        }
+    }
+}
+
 void Script::cdsObject2dukObject(const std::shared_ptr<CdsObject>& obj)
 {
     std::string val;
@@ -701,71 +993,21 @@ void Script::cdsObject2dukObject(const std::shared_ptr<CdsObject>& obj)
 #endif
         setIntProperty("onlineservice", 0);
 
-    // setting metadata
-    {
-        duk_push_object(ctx);
-        // stack: js meta_js
-
-        auto meta = obj->getMetadata();
-        for (const auto& [key, val] : meta) {
-            setProperty(key, val);
-        }
-
-        if (std::static_pointer_cast<CdsItem>(obj)->getTrackNumber() > 0)
-            setProperty(MetadataHandler::getMetaFieldName(M_TRACKNUMBER), fmt::to_string(std::static_pointer_cast<CdsItem>(obj)->getTrackNumber()));
-
-        duk_put_prop_string(ctx, -2, "meta");
-        // stack: js
-    }
-
-    // setting auxdata
-    {
-        duk_push_object(ctx);
-        // stack: js aux_js
-
-        auto aux = obj->getAuxData();
-
-#ifdef HAVE_ATRAILERS
-        auto tmp = obj->getAuxData(ATRAILERS_AUXDATA_POST_DATE);
-        if (!tmp.empty())
-            aux[ATRAILERS_AUXDATA_POST_DATE] = tmp;
-#endif
-
-        for (const auto& [key, val] : aux) {
-            setProperty(key, val);
-        }
-
-        duk_put_prop_string(ctx, -2, "aux");
-        // stack: js
-    }
-
-    // setting resource
-    {
-        duk_push_object(ctx);
-        // stack: js res_js
-
-        if (obj->getResourceCount() > 0) {
-            int resCount = 0;
-            for (const auto& res : obj->getResources()) {
-                setProperty(fmt::format("{}:handlerType", resCount), fmt::format("{}", res->getHandlerType()));
-                auto attributes = res->getAttributes();
-                for (const auto& [key, val] : attributes) {
-                    setProperty(resCount == 0 ? key : fmt::format("{}-{}", resCount, key), val);
-                }
-                auto parameters = res->getParameters();
-                for (const auto& [key, val] : parameters) {
-                    setProperty(fmt::format("{}#{}", resCount, key), val);
-                }
-                auto options = res->getOptions();
-                for (const auto& [key, val] : options) {
-                    setProperty(fmt::format("{}%{}", resCount, key), val);
-                }
-                resCount++;
-            }
-        }
-
-        duk_put_prop_string(ctx, -2, "res");
-        // stack: js
+    // metadata, auxdata and resources are only converted when the script reads them
+    auto jsObject = duk_normalize_index(ctx, -1);
+    duk_push_pointer(ctx, new std::shared_ptr<CdsObject>(obj));
+    duk_put_prop_string(ctx, jsObject, JS_LAZY_SOURCE);
+    duk_push_int(ctx, LAZY_META | LAZY_AUX | LAZY_RES);
+    duk_put_prop_string(ctx, jsObject, JS_LAZY_FIELDS);
+    duk_push_c_function(ctx, lazySourceFinalizer, 1);
+    duk_set_finalizer(ctx, jsObject);
+    for (const auto& [field, key] : lazyFields) {
+        duk_push_string(ctx, key);
+        duk_push_c_function(ctx, lazyGetter, 0);
+        duk_set_magic(ctx, -1, field);
+        duk_push_c_function(ctx, lazySetter, 1);
+        duk_set_magic(ctx, -1, field);
+        duk_def_prop(ctx, jsObject, DUK_DEFPROP_HAVE_GETTER | DUK_DEFPROP_HAVE_SETTER | DUK_DEFPROP_SET_ENUMERABLE | DUK_DEFPROP_SET_CONFIGURABLE);
     }
 
     // CdsItem
@@ -813,4 +1055,9 @@ std::shared_ptr<CdsObject> Script::getProcessedObject()
     return processed;
 }
 
+std::shared_ptr<CdsObject> Script::getBatchObject(int objectID) const
+{
+    return getValueOrDefault(batch, objectID, std::shared_ptr<CdsObject>());
+}
+
 #endif // HAVE_JS
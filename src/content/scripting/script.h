@@ -33,6 +33,7 @@
 #define __SCRIPTING_SCRIPT_H__
 
 #include <duktape.h>
+#include <map>
 #include <mutex>
 
 #include "common.h"
@@ -41,12 +42,10 @@
 // forward declaration
 class CdsObject;
 class ContentManager;
+class ImportStatistics;
 class ScriptingRuntime;
 class StringConverter;
 
-// perform garbage collection after script has been run for x times
-#define JS_CALL_GC_AFTER_NUM (1000)
-
 enum script_class_t {
     S_IMPORT = 0,
     S_PLAYLIST
@@ -80,9 +79,16 @@ public:
     std::shared_ptr<CdsObject> dukObject2cdsObject(const std::shared_ptr<CdsObject>& pcd);
     void cdsObject2dukObject(const std::shared_ptr<CdsObject>& obj);
 
+    /// \brief push the meta, aux and res objects of obj, called when the script first reads them
+    void pushMetadata(const std::shared_ptr<CdsObject>& obj);
+    void pushAuxData(const std::shared_ptr<CdsObject>& obj);
+    void pushResources(const std::shared_ptr<CdsObject>& obj);
+
     virtual script_class_t whoami() = 0;
 
     std::shared_ptr<CdsObject> getProcessedObject();
+    /// \brief object of the running import batch with that id, nullptr if there is none
+    std::shared_ptr<CdsObject> getBatchObject(int objectID) const;
 
     std::string convertToCharset(const std::string& str, charset_convert_t chr);
 
@@ -91,17 +97,26 @@ public:
     std::shared_ptr<Config> getConfig() const { return config; }
     std::shared_ptr<Database> getDatabase() const { return database; }
     std::shared_ptr<ContentManager> getContent() const { return content; }
+    /// \brief where the native functions record their time, nullptr if not collected
+    ImportStatistics* getImportStatistics() const { return importStatistics; }
 
 protected:
     Script(std::shared_ptr<ContentManager> content,
         const std::shared_ptr<ScriptingRuntime>& runtime, const std::string& name);
 
     void execute();
+    /// \brief run the garbage collector once enough objects were processed or the heap grew enough since the last run
+    void collectGarbage();
     int gc_counter;
+    int gcInterval;
+    std::size_t gcHeapGrowth;
+    std::size_t heapAfterGc { 0 };
 
     // object that is currently being processed by the script (set in import
     // script)
     std::shared_ptr<CdsObject> processed;
+    /// \brief objects passed to the import function, by id
+    std::map<int, std::shared_ptr<CdsObject>> batch;
 
     duk_context* ctx;
 
@@ -110,10 +125,15 @@ protected:
     std::shared_ptr<Database> database;
     std::shared_ptr<ContentManager> content;
     std::shared_ptr<ScriptingRuntime> runtime;
+    ImportStatistics* importStatistics;
 
 private:
     std::string name;
     void _load(const std::string& scriptPath);
+    /// \brief push the bytecode compiled from the same source, false if there is none
+    bool loadCompiled(const std::string& scriptPath, std::uint64_t sourceHash);
+    /// \brief keep the bytecode of the compiled function on top of the stack in memory and in the server home
+    void storeCompiled(const std::string& scriptPath, std::uint64_t sourceHash);
     void _execute();
     std::unique_ptr<StringConverter> _p2i;
     std::unique_ptr<StringConverter> _j2i;
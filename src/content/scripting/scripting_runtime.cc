@@ -32,18 +32,86 @@
 #ifdef HAVE_JS
 #include "scripting_runtime.h" // API
 
+#include <cstddef>
+#include <cstdlib>
+
 [[noreturn]] static void fatal_handler([[maybe_unused]] void* udata, const char* msg)
 {
     log_error("Fatal Duktape error: {}", msg ? msg : "no message");
     abort();
 }
 
+/// \brief every allocation is prefixed with its size, keeps the payload aligned like malloc does
+static constexpr std::size_t ALLOC_HEADER = alignof(std::max_align_t);
+
+void* ScriptingRuntime::heapAlloc(void* udata, duk_size_t size)
+{
+    if (size == 0)
+        return nullptr;
+    auto base = static_cast<char*>(malloc(size + ALLOC_HEADER));
+    if (!base)
+        return nullptr;
+    *reinterpret_cast<std::size_t*>(base) = size;
+    static_cast<ScriptingRuntime*>(udata)->heapSize += size;
+    return base + ALLOC_HEADER;
+}
+
+void* ScriptingRuntime::heapRealloc(void* udata, void* ptr, duk_size_t size)
+{
+    if (!ptr)
+        return heapAlloc(udata, size);
+    if (size == 0) {
+        heapFree(udata, ptr);
+        return nullptr;
+    }
+    auto base = static_cast<char*>(ptr) - ALLOC_HEADER;
+    auto oldSize = *reinterpret_cast<std::size_t*>(base);
+    base = static_cast<char*>(realloc(base, size + ALLOC_HEADER));
+    if (!base)
+        return nullptr;
+    *reinterpret_cast<std::size_t*>(base) = size;
+    auto self = static_cast<ScriptingRuntime*>(udata);
+    self->heapSize += size;
+    self->heapSize -= oldSize;
+    return base + ALLOC_HEADER;
+}
+
+void ScriptingRuntime::heapFree(void* udata, void* ptr)
+{
+    if (!ptr)
+        return;
+    auto base = static_cast<char*>(ptr) - ALLOC_HEADER;
+    static_cast<ScriptingRuntime*>(udata)->heapSize -= *reinterpret_cast<std::size_t*>(base);
+    free(base);
+}
+
+extern "C" duk_bool_t gerbera_duk_exec_timeout_check(void* udata)
+{
+    return udata && static_cast<ScriptingRuntime*>(udata)->isTimedOut();
+}
+
+void ScriptingRuntime::setTimeout(std::chrono::milliseconds timeout)
+{
+    if (timeout.count() > 0)
+        deadline = std::chrono::duration_cast<std::chrono::nanoseconds>((std::chrono::steady_clock::now() + timeout).time_since_epoch()).count();
+    else
+        deadline = 0;
+}
+
+bool ScriptingRuntime::isTimedOut() const
+{
+    std::int64_t end = deadline;
+    return end > 0 && std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() > end;
+}
+
 ScriptingRuntime::ScriptingRuntime()
 {
-    ctx = duk_create_heap(nullptr, nullptr, nullptr, nullptr, fatal_handler);
+    ctx = duk_create_heap(heapAlloc, heapRealloc, heapFree, this, fatal_handler);
+    memory = MemoryAccounting::getInstance().add("script-heaps", [this] { return heapSize.load(); });
 }
 ScriptingRuntime::~ScriptingRuntime()
 {
+    memory.reset();
     duk_destroy_heap(ctx);
 }
 
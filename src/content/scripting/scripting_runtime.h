@@ -32,16 +32,32 @@
 #ifndef __SCRIPTING_RUNTIME_H__
 #define __SCRIPTING_RUNTIME_H__
 
+#include <atomic>
+#include <chrono>
 #include <duktape.h>
 #include <mutex>
 
 #include "common.h"
+#include "util/memory_accounting.h"
+
+/// \brief called by Duktape while a script runs if built with DUK_USE_EXEC_TIMEOUT_CHECK, udata is the runtime
+extern "C" duk_bool_t gerbera_duk_exec_timeout_check(void* udata);
 
 /// \brief ScriptingRuntime class definition.
 class ScriptingRuntime {
 protected:
     duk_context* ctx;
     std::recursive_mutex mutex;
+    /// \brief bytes currently allocated by the heap
+    std::atomic<std::size_t> heapSize { 0 };
+    /// \brief steady clock time in nanoseconds when the running script is aborted, zero for no limit
+    std::atomic<std::int64_t> deadline { 0 };
+
+    static void* heapAlloc(void* udata, duk_size_t size);
+    static void* heapRealloc(void* udata, void* ptr, duk_size_t size);
+    static void heapFree(void* udata, void* ptr);
+
+    std::unique_ptr<MemoryAccounting::Registration> memory;
 
 public:
     ScriptingRuntime();
@@ -51,6 +67,15 @@ public:
     duk_context* createContext(const std::string& name);
     void destroyContext(const std::string& name);
 
+    /// \brief bytes allocated by all contexts of this runtime
+    std::size_t getHeapSize() const { return heapSize; }
+
+    /// \brief abort the running script after timeout, zero removes the limit
+    ///
+    /// Only effective if Duktape was built with DUK_USE_EXEC_TIMEOUT_CHECK=gerbera_duk_exec_timeout_check
+    void setTimeout(std::chrono::milliseconds timeout);
+    bool isTimedOut() const;
+
     using AutoLock = std::lock_guard<std::recursive_mutex>;
     std::recursive_mutex& getMutex() { return mutex; }
 };
@@ -34,13 +34,16 @@
 #include <chrono>
 #include <csignal>
 
+#include "browse_cache.h"
+#include "browse_snapshot.h"
+#include "config/config.h"
 #include "database/database.h"
+#include "didl_cache.h"
 #include "server.h"
 #include "upnp_cds.h"
 #include "util/tools.h"
 
 /* following constants in milliseconds */
-#define SPEC_INTERVAL 2000
 #define MIN_SLEEP 1
 
 #define MAX_OBJECT_IDS 1000
@@ -56,6 +59,8 @@ UpdateManager::UpdateManager(std::shared_ptr<Config> config, std::shared_ptr<Dat
     , flushPolicy(FLUSH_SPEC)
     , lastContainerChanged(INVALID_OBJECT_ID)
 {
+    eventInterval = this->config->getIntOption(CFG_SERVER_UPNP_EVENT_INTERVAL);
+    csvLimit = this->config->getIntOption(CFG_SERVER_UPNP_EVENT_CSV_LIMIT);
 }
 
 void UpdateManager::run()
@@ -91,6 +96,18 @@ void UpdateManager::containersChanged(const std::vector<int>& objectIDs, int flu
         this->flushPolicy = flushPolicy;
         signal = true;
     }
+    auto didlCache = server ? server->getDidlCache() : nullptr;
+    auto browseCache = server ? server->getBrowseCache() : nullptr;
+    auto browseSnapshot = server ? server->getBrowseSnapshot() : nullptr;
+    for (int objectID : objectIDs) {
+        if (didlCache)
+            didlCache->invalidate(objectID);
+        if (browseCache)
+            browseCache->invalidate(objectID);
+        if (browseSnapshot)
+            browseSnapshot->invalidate(objectID);
+    }
+
     size_t size = objectIDs.size();
     size_t hashSize = objectIDHash->size();
 
@@ -122,6 +139,17 @@ void UpdateManager::containerChanged(int objectID, int flushPolicy)
     if (objectID == INVALID_OBJECT_ID)
         return;
 
+    // drop the rendered DIDL-Lite right away, the event is only sent later
+    auto didlCache = server ? server->getDidlCache() : nullptr;
+    if (didlCache)
+        didlCache->invalidate(objectID);
+    auto browseCache = server ? server->getBrowseCache() : nullptr;
+    if (browseCache)
+        browseCache->invalidate(objectID);
+    auto browseSnapshot = server ? server->getBrowseSnapshot() : nullptr;
+    if (browseSnapshot)
+        browseSnapshot->invalidate(objectID);
+
     auto lock = threadRunner->lockGuard();
 
     if (objectID != lastContainerChanged || flushPolicy > this->flushPolicy) {
@@ -155,6 +183,95 @@ void UpdateManager::containerChanged(int objectID, int flushPolicy)
 
 /* private stuff */
 
+void UpdateManager::collectUpdates()
+{
+    lastContainerChanged = INVALID_OBJECT_ID;
+    std::string updateString;
+    try {
+        updateString = database->incrementUpdateIDs(objectIDHash);
+        objectIDHash->clear(); // hash_data_array will be invalid after clear()
+    } catch (const std::runtime_error& e) {
+        log_error("Fatal error when sending updates: {}", e.what());
+        log_error("Forcing Gerbera shutdown.");
+        kill(0, SIGINT);
+        return;
+    }
+
+    // pairs of container id and update id, a container changed again keeps its latest id
+    auto values = splitString(updateString, ',');
+    for (std::size_t i = 0; i + 1 < values.size(); i += 2)
+        pendingUpdateIDs[std::stoi(values[i])] = std::stoi(values[i + 1]);
+}
+
+void UpdateManager::containersUpdated(const std::string& updateIDs)
+{
+    auto values = splitString(updateIDs, ',');
+    auto didlCache = server ? server->getDidlCache() : nullptr;
+    auto browseCache = server ? server->getBrowseCache() : nullptr;
+    auto browseSnapshot = server ? server->getBrowseSnapshot() : nullptr;
+    for (std::size_t i = 0; i + 1 < values.size(); i += 2) {
+        auto objectID = std::stoi(values[i]);
+        if (didlCache)
+            didlCache->invalidate(objectID);
+        if (browseCache)
+            browseCache->invalidate(objectID);
+        if (browseSnapshot)
+            browseSnapshot->invalidate(objectID);
+    }
+
+    auto lock = threadRunner->lockGuard();
+    // signalling thread if it could have been idle
+    bool signal = !haveUpdates() && !havePendingEvent();
+    for (std::size_t i = 0; i + 1 < values.size(); i += 2) {
+        auto&& updateID = pendingUpdateIDs[std::stoi(values[i])];
+        updateID = std::max(updateID, std::stoi(values[i + 1]));
+    }
+    if (signal)
+        threadRunner->notify();
+}
+
+void UpdateManager::refreshAll()
+{
+    auto didlCache = server ? server->getDidlCache() : nullptr;
+    if (didlCache)
+        didlCache->clear();
+    auto browseCache = server ? server->getBrowseCache() : nullptr;
+    if (browseCache)
+        browseCache->clear();
+    auto browseSnapshot = server ? server->getBrowseSnapshot() : nullptr;
+    if (browseSnapshot)
+        browseSnapshot->clear();
+
+    auto lock = threadRunner->lockGuard();
+    bool signal = !haveUpdates() && !havePendingEvent();
+    pendingRefresh = true;
+    if (signal)
+        threadRunner->notify();
+}
+
+std::string UpdateManager::takePendingEvent()
+{
+    if (pendingRefresh) {
+        log_debug("Changes were missed, sending SystemUpdateID only");
+        pendingRefresh = false;
+        pendingUpdateIDs.clear();
+        return "";
+    }
+
+    std::vector<std::string> pairs;
+    pairs.reserve(pendingUpdateIDs.size());
+    for (auto&& [objectID, updateID] : pendingUpdateIDs)
+        pairs.push_back(fmt::format("{},{}", objectID, updateID));
+    pendingUpdateIDs.clear();
+
+    auto updateString = join(pairs, ",");
+    if (csvLimit > 0 && updateString.length() > csvLimit) {
+        log_debug("{} containers changed, sending SystemUpdateID only", pairs.size());
+        return "";
+    }
+    return updateString;
+}
+
 void UpdateManager::threadProc()
 {
     struct timespec lastUpdate;
@@ -162,66 +279,40 @@ void UpdateManager::threadProc()
 
     auto lock = threadRunner->uniqueLock();
 
-    //cond.notify_one();
     while (!shutdownFlag) {
-        if (haveUpdates()) {
-            long sleepMillis = 0;
+        if (haveUpdates() || havePendingEvent()) {
             struct timespec now;
             getTimespecNow(&now);
-            long timeDiff = getDeltaMillis(&lastUpdate, &now);
-            switch (flushPolicy) {
-            case FLUSH_SPEC:
-                sleepMillis = SPEC_INTERVAL - timeDiff;
-                break;
-            case FLUSH_ASAP:
-                sleepMillis = 0;
-                break;
-            }
-            bool sendUpdates = true;
-            if (sleepMillis >= MIN_SLEEP && objectIDHash->size() < MAX_OBJECT_IDS) {
-                struct timespec timeout;
-                getTimespecAfterMillis(sleepMillis, &timeout, &now);
+            long sleepMillis = 0;
+            if (flushPolicy != FLUSH_ASAP)
+                sleepMillis = eventInterval - getDeltaMillis(&lastUpdate, &now);
 
+            if (sleepMillis >= MIN_SLEEP && objectIDHash->size() < MAX_OBJECT_IDS) {
                 log_debug("threadProc: sleeping for {} millis", sleepMillis);
-                auto ret = threadRunner->waitFor(lock, sleepMillis);
-
-                if (!shutdownFlag) {
-                    if (ret == std::cv_status::timeout)
-                        sendUpdates = false;
-                } else
-                    sendUpdates = false;
+                threadRunner->waitFor(lock, sleepMillis);
+                continue;
             }
 
-            if (sendUpdates) {
-                log_debug("sending updates...");
-                lastContainerChanged = INVALID_OBJECT_ID;
-                flushPolicy = FLUSH_SPEC;
-                std::string updateString;
-
-                try {
-                    updateString = database->incrementUpdateIDs(objectIDHash);
-                    objectIDHash->clear(); // hash_data_array will be invalid after clear()
-                } catch (const std::runtime_error& e) {
-                    log_error("Fatal error when sending updates: {}", e.what());
-                    log_error("Forcing Gerbera shutdown.");
-                    kill(0, SIGINT);
-                }
-                lock.unlock(); // we don't need to hold the lock during the sending of the updates
-                if (!updateString.empty()) {
-                    try {
-                        log_debug("updates sent: \"{}\"", updateString.c_str());
-                        server->sendCDSSubscriptionUpdate(updateString);
-                        getTimespecNow(&lastUpdate);
-                    } catch (const std::runtime_error& e) {
-                        log_error("Fatal error when sending updates: {}", e.what());
-                        log_error("Forcing Gerbera shutdown.");
-                        kill(0, SIGINT);
-                    }
-                } else {
-                    log_debug("NOT sending updates (string empty or invalid).");
-                }
-                lock.lock();
+            // a full hash is written right away, the event still waits for the interval
+            if (haveUpdates())
+                collectUpdates();
+            if (sleepMillis >= MIN_SLEEP || !havePendingEvent())
+                continue;
+
+            log_debug("sending updates...");
+            flushPolicy = FLUSH_SPEC;
+            auto updateString = takePendingEvent();
+            lock.unlock(); // we don't need to hold the lock during the sending of the updates
+            try {
+                log_debug("updates sent: \"{}\"", updateString.c_str());
+                server->sendCDSSubscriptionUpdate(updateString);
+                getTimespecNow(&lastUpdate);
+            } catch (const std::runtime_error& e) {
+                log_error("Fatal error when sending updates: {}", e.what());
+                log_error("Forcing Gerbera shutdown.");
+                kill(0, SIGINT);
             }
+            lock.lock();
         } else {
             //nothing to do
             threadRunner->wait(lock);
@@ -32,6 +32,7 @@
 #ifndef __UPDATE_MANAGER_H__
 #define __UPDATE_MANAGER_H__
 
+#include <map>
 #include <memory>
 #include <unordered_set>
 #include <vector>
@@ -57,6 +58,12 @@ public:
     void containerChanged(int objectID, int flushPolicy = FLUSH_SPEC);
     void containersChanged(const std::vector<int>& objectIDs, int flushPolicy = FLUSH_SPEC);
 
+    /// \brief another node of the cluster changed the containers and counted their update ids
+    /// \param updateIDs container and update id pairs as returned by Database::incrementUpdateIDs
+    void containersUpdated(const std::string& updateIDs);
+    /// \brief changes of other nodes were missed, the clients are told to refresh everything
+    void refreshAll();
+
 protected:
     std::shared_ptr<Config> config;
     std::shared_ptr<Database> database;
@@ -71,10 +78,25 @@ protected:
 
     int lastContainerChanged;
 
+    /// \brief minimum milliseconds between two events
+    long eventInterval;
+    /// \brief longest ContainerUpdateIDs list, longer lists send the SystemUpdateID only, 0 for no limit
+    std::size_t csvLimit;
+    /// \brief update ids already written to the database but not sent yet, the latest per container
+    std::map<int, int> pendingUpdateIDs;
+    /// \brief the pending event only sends the SystemUpdateID
+    bool pendingRefresh { false };
+
+    /// \brief write the update ids of the changed containers and add them to the pending event
+    void collectUpdates();
+    /// \brief ContainerUpdateIDs of the pending event, empty if it gets too long
+    std::string takePendingEvent();
+
     static void* staticThreadProc(void* arg);
     void threadProc();
 
     bool haveUpdates() const { return !objectIDHash->empty(); }
+    bool havePendingEvent() const { return !pendingUpdateIDs.empty() || pendingRefresh; }
 };
 
 #endif // __UPDATE_MANAGER_H__
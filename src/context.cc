@@ -30,12 +30,22 @@ Context::Context(std::shared_ptr<Config> config,
     std::shared_ptr<Mime> mime,
     std::shared_ptr<Database> database,
     std::shared_ptr<Server> server,
-    std::shared_ptr<web::SessionManager> session_manager)
+    std::shared_ptr<web::SessionManager> session_manager,
+    std::shared_ptr<ImportStatistics> importStatistics,
+    std::shared_ptr<StreamStatistics> streamStatistics,
+    std::shared_ptr<ThumbnailService> thumbnailService,
+    std::shared_ptr<ThumbnailCache> artworkStore,
+    std::shared_ptr<MetadataRegistry> metadataRegistry)
     : config(std::move(config))
     , clients(std::move(clients))
     , mime(std::move(mime))
     , database(std::move(database))
     , server(std::move(server))
     , session_manager(std::move(session_manager))
+    , importStatistics(std::move(importStatistics))
+    , streamStatistics(std::move(streamStatistics))
+    , thumbnailService(std::move(thumbnailService))
+    , artworkStore(std::move(artworkStore))
+    , metadataRegistry(std::move(metadataRegistry))
 {
 }
@@ -32,8 +32,13 @@
 class Config;
 class Clients;
 class Database;
+class ImportStatistics;
+class MetadataRegistry;
 class Mime;
 class Server;
+class StreamStatistics;
+class ThumbnailCache;
+class ThumbnailService;
 class UpdateManager;
 namespace web {
 class SessionManager;
@@ -46,7 +51,12 @@ public:
         std::shared_ptr<Mime> mime,
         std::shared_ptr<Database> database,
         std::shared_ptr<Server> server,
-        std::shared_ptr<web::SessionManager> session_manager);
+        std::shared_ptr<web::SessionManager> session_manager,
+        std::shared_ptr<ImportStatistics> importStatistics = nullptr,
+        std::shared_ptr<StreamStatistics> streamStatistics = nullptr,
+        std::shared_ptr<ThumbnailService> thumbnailService = nullptr,
+        std::shared_ptr<ThumbnailCache> artworkStore = nullptr,
+        std::shared_ptr<MetadataRegistry> metadataRegistry = nullptr);
 
     virtual ~Context() = default;
 
@@ -80,6 +90,36 @@ public:
         return session_manager;
     }
 
+    /// \brief collects the timing of the import stages, nullptr in tests
+    std::shared_ptr<ImportStatistics> getImportStatistics() const
+    {
+        return importStatistics;
+    }
+
+    /// \brief collects latency and throughput of the served files, nullptr in tests
+    std::shared_ptr<StreamStatistics> getStreamStatistics() const
+    {
+        return streamStatistics;
+    }
+
+    /// \brief generates the video thumbnails, nullptr if ffmpegthumbnailer is disabled
+    std::shared_ptr<ThumbnailService> getThumbnailService() const
+    {
+        return thumbnailService;
+    }
+
+    /// \brief embedded album art extracted during the import, nullptr if disabled
+    std::shared_ptr<ThumbnailCache> getArtworkStore() const
+    {
+        return artworkStore;
+    }
+
+    /// \brief metadata extractors by mime type, nullptr in tests
+    std::shared_ptr<MetadataRegistry> getMetadataRegistry() const
+    {
+        return metadataRegistry;
+    }
+
 private:
     std::shared_ptr<Config> config;
     std::shared_ptr<Clients> clients;
@@ -87,6 +127,11 @@ private:
     std::shared_ptr<Database> database;
     std::shared_ptr<Server> server;
     std::shared_ptr<web::SessionManager> session_manager;
+    std::shared_ptr<ImportStatistics> importStatistics;
+    std::shared_ptr<StreamStatistics> streamStatistics;
+    std::shared_ptr<ThumbnailService> thumbnailService;
+    std::shared_ptr<ThumbnailCache> artworkStore;
+    std::shared_ptr<MetadataRegistry> metadataRegistry;
 };
 
 #endif // __CONTEXT_H__
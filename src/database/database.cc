@@ -31,11 +31,31 @@
 
 #include "database.h" // API
 
+#include <algorithm>
+
 #include "config/config_manager.h"
 #include "database/mysql/mysql_database.h"
 #include "database/sqlite3/sqlite_database.h"
 #include "util/tools.h"
 
+std::vector<BrowseParam::SortCriterion> BrowseParam::parseSortCriteria(const std::string& sortCriteria)
+{
+    auto supported = splitString(BROWSE_SORT_CAPABILITIES, ',');
+    std::vector<SortCriterion> result;
+    for (auto&& entry : splitString(sortCriteria, ',')) {
+        auto property = trimString(entry);
+        if (property.empty())
+            continue;
+        bool descending = property.front() == '-';
+        if (property.front() == '+' || property.front() == '-')
+            property.erase(0, 1);
+        if (std::find(supported.begin(), supported.end(), property) == supported.end())
+            throw_std_runtime_error("Unsupported sort property {}", property);
+        result.push_back({ property, descending });
+    }
+    return result;
+}
+
 Database::Database(std::shared_ptr<Config> config)
     : config(std::move(config))
 {
@@ -32,10 +32,12 @@
 #ifndef __STORAGE_H__
 #define __STORAGE_H__
 
+#include <ctime>
 #include <filesystem>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 namespace fs = std::filesystem;
@@ -46,6 +48,7 @@ class AutoscanList;
 class CdsObject;
 class Config;
 class ConfigValue;
+class QueryProfiler;
 enum class ScanMode;
 class Timer;
 
@@ -55,11 +58,27 @@ class Timer;
 #define BROWSE_EXACT_CHILDCOUNT 0x00000008
 #define BROWSE_TRACK_SORT 0x00000010
 #define BROWSE_HIDE_FS_ROOT 0x00000020
+// projection of the returned objects, callers that only need id, title and class skip decoding the rest
+#define BROWSE_NO_METADATA 0x00000040
+#define BROWSE_NO_AUXDATA 0x00000080
+#define BROWSE_NO_RESOURCES 0x00000100
+#define BROWSE_BASIC_PROPERTIES (BROWSE_NO_METADATA | BROWSE_NO_AUXDATA | BROWSE_NO_RESOURCES)
+
+/// \brief properties a browse can be sorted by, answered to GetSortCapabilities
+#define BROWSE_SORT_CAPABILITIES "dc:title,upnp:class,upnp:originalTrackNumber,dc:date,upnp:artist,upnp:album,upnp:genre"
 
 class BrowseParam {
+public:
+    /// \brief one property of the SortCriteria argument
+    struct SortCriterion {
+        std::string property;
+        bool descending;
+    };
+
 protected:
     unsigned int flags;
     int objectID;
+    std::vector<SortCriterion> sortCriteria;
 
     int startingIndex;
     int requestedCount;
@@ -109,6 +128,13 @@ public:
     int getStartingIndex() const { return startingIndex; }
     int getRequestedCount() const { return requestedCount; }
 
+    /// \brief order of the children instead of the title, only properties of BROWSE_SORT_CAPABILITIES
+    void setSortCriteria(std::vector<SortCriterion> sortCriteria) { this->sortCriteria = std::move(sortCriteria); }
+    const std::vector<SortCriterion>& getSortCriteria() const { return sortCriteria; }
+
+    /// \brief split "+upnp:artist,-dc:date" into its properties, throws if a property is not supported
+    static std::vector<SortCriterion> parseSortCriteria(const std::string& sortCriteria);
+
     int getTotalMatches() const { return totalMatches; }
 
     void setTotalMatches(int totalMatches)
@@ -147,8 +173,16 @@ public:
     /// \brief shutdown the Database with its possible threads
     virtual void shutdown() = 0;
 
+    /// \brief read the indexes used by browsing once, so they are in the caches of the database and the OS
+    virtual void warmUpIndexes() = 0;
+
     virtual void addObject(std::shared_ptr<CdsObject> object, int* changedContainer) = 0;
 
+    /// \brief Adds several new objects in one transaction.
+    /// \param objects objects without id, the assigned ids are stored in the objects
+    /// \param changedContainer will be filled with the last container created for the objects' paths
+    virtual void addObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, int* changedContainer) = 0;
+
     /// \brief Adds a virtual container chain specified by path.
     /// \param path container path separated by '/'. Slashes in container
     /// titles must be escaped.
@@ -176,7 +210,14 @@ public:
     /// It will be escaped.
     virtual fs::path buildContainerPath(int parentID, const std::string& title) = 0;
 
-    virtual void updateObject(std::shared_ptr<CdsObject> object, int* changedContainer) = 0;
+    /// \brief store the changed columns and metadata of the object
+    /// \return false if the stored object was the same and nothing was written
+    virtual bool updateObject(std::shared_ptr<CdsObject> object, int* changedContainer) = 0;
+
+    /// \brief store the flags and bookmark positions of played objects in one transaction
+    /// \param flags the flags by object id
+    /// \param bookmarks the bookmark positions of items by object id
+    virtual void updatePlayStates(const std::map<int, int>& flags, const std::map<int, int>& bookmarks) = 0;
 
     virtual std::vector<std::shared_ptr<CdsObject>> browse(const std::unique_ptr<BrowseParam>& param) = 0;
     virtual std::vector<std::shared_ptr<CdsObject>> search(const std::unique_ptr<SearchParam>& param, int* numMatches) = 0;
@@ -229,12 +270,79 @@ public:
     /// \return changed container ids
     virtual std::unique_ptr<ChangedContainers> removeObject(int objectID, bool all) = 0;
 
+    /// \brief Changes the location of a moved file or directory and of everything below it in one transaction.
+    ///
+    /// Ids, metadata and references stay as they are, so nothing has to be imported again.
+    /// \param oldPath old path, does not exist any more
+    /// \param newPath new path
+    /// \return changed container ids, nullptr if oldPath is not in the database
+    virtual std::unique_ptr<ChangedContainers> relocateSubtree(const fs::path& oldPath, const fs::path& newPath) = 0;
+
     /// \brief Get all objects under the given parentID.
     /// \param parentID parent container
     /// \param withoutContainer if false: all children are returned; if true: only items are returned
     /// \return DBHash containing the objectID's - nullptr if there are none!
     virtual std::unique_ptr<std::unordered_set<int>> getObjects(int parentID, bool withoutContainer) = 0;
 
+    /// \brief Get items anywhere below the given container, used to remove big subtrees in chunks.
+    /// \param containerID top of the subtree
+    /// \param limit maximum number of ids returned
+    /// \return item ids, empty if the subtree has no (more) items
+    virtual std::vector<int> getSubtreeItems(int containerID, std::size_t limit) = 0;
+
+    /// \brief Get the items of the filesystem tree in id order, used to walk all items in chunks.
+    /// \param afterID only ids above this one
+    /// \param limit maximum number of ids returned
+    virtual std::vector<int> getItemIDs(int afterID, std::size_t limit) = 0;
+
+    /// \brief Create a virtual container outside of the root, chains starting with its title are built below it.
+    /// A left over container of the same title is removed first.
+    /// \return id of the container
+    virtual int addShadowContainer(const std::string& title) = 0;
+
+    /// \brief Replace the virtual containers below the root by the children of the shadow container.
+    /// The old layout and the shadow container are removed.
+    /// \return changed container ids
+    virtual std::unique_ptr<ChangedContainers> swapShadowContainer(int shadowID) = 0;
+
+    class ObjectStat {
+    public:
+        int id;
+        time_t mtime;
+        bool isContainer;
+    };
+
+    /// \brief Get the filesystem children of the given parentID keyed by their location.
+    /// \param parentID parent container
+    /// \param withoutContainer if false: all children are returned; if true: only items are returned
+    /// \return id and last modification time of each child, loaded with one query
+    virtual std::unordered_map<std::string, ObjectStat> getChildStats(int parentID, bool withoutContainer) = 0;
+
+    /// \brief Check if a directory is the same as at its last complete scan.
+    /// \param objectID container of the directory
+    /// \param mtime current modification time of the directory
+    /// \return true if the stored mtime and child count still match
+    virtual bool isDirectoryUnchanged(int objectID, time_t mtime) = 0;
+
+    /// \brief Remember the modification time and the current child count of a completely scanned directory.
+    virtual void setDirectoryState(int objectID, time_t mtime) = 0;
+
+    /// \brief what a file looked like when its metadata was read, to tell a touch from an edit
+    struct FileState {
+        std::int64_t size { 0 };
+        std::int64_t inode { 0 };
+        std::int64_t birthTime { 0 };
+        std::int64_t head { 0 };
+        std::int64_t tail { 0 };
+    };
+
+    /// \brief Get the stored state of an item's file.
+    /// \return false if there is none
+    virtual bool getFileState(int objectID, FileState& state) = 0;
+
+    /// \brief Remember the state of an item's file.
+    virtual void setFileState(int objectID, const FileState& state) = 0;
+
     /// \brief Remove all objects found in list
     /// \param list a DBHash containing objectIDs that have to be removed
     /// \param all if true and the object to be removed is a reference
@@ -244,10 +352,71 @@ public:
     /// \brief Loads an object given by the online service ID.
     virtual std::shared_ptr<CdsObject> loadObjectByServiceID(const std::string& serviceID) = 0;
 
-    /// \brief Return an array of object ID's for a particular service.
+    /// \brief a play that was not submitted to Last.fm
+    struct Scrobble {
+        std::string artist;
+        std::string title;
+        std::string album;
+        int trackNumber { 0 };
+        int length { 0 };
+        std::int64_t started { 0 };
+    };
+
+    /// \brief Keep plays for the next start, all in one statement
+    virtual void storeScrobbles(const std::vector<Scrobble>& scrobbles) = 0;
+
+    /// \brief Return and forget the kept plays, oldest first
+    virtual std::vector<Scrobble> takeScrobbles() = 0;
+
+    /// \brief entries the other nodes of a cluster wrote to the change log
+    struct ChangeLog {
+        /// \brief sequence number of the highest entry read
+        std::int64_t sequence { 0 };
+        /// \brief numbers below the sequence not seen yet, with the time they were first missed
+        ///
+        /// Transactions of several nodes commit out of order, so a lower number
+        /// can turn up later. Rolled back inserts leave numbers that never do.
+        std::map<std::int64_t, std::time_t> gaps;
+        /// \brief time of the read, entries pruned after it may have been missed by the next one
+        std::time_t readTime { 0 };
+        /// \brief false if entries following the previous read may have been pruned
+        bool complete { true };
+        /// \brief container and update id pairs of each entry, like the result of incrementUpdateIDs
+        std::vector<std::string> updateIDs;
+    };
+
+    /// \brief Sequence number of the latest entry in the change log
+    virtual std::int64_t getChangeLogSequence() = 0;
+
+    /// \brief Read the changes of the other nodes following the previous read
+    ///
+    /// The result is passed to the next call, the gaps of previous are read again for a while.
+    /// Objects, update ids and results the database keeps in memory are updated to the changes.
+    virtual ChangeLog readChangeLog(const ChangeLog& previous) = 0;
+
+    /// \brief object of an online service with the aux data the service keeps its state in
+    struct ServiceObject {
+        int objectID;
+        std::map<std::string, std::string> auxData;
+    };
+
+    /// \brief Return the objects of a particular service by service id.
     ///
     /// In the database, the service is identified by a service id prefix.
-    virtual std::unique_ptr<std::vector<int>> getServiceObjectIDs(char servicePrefix) = 0;
+    virtual std::map<std::string, ServiceObject> getServiceObjects(char servicePrefix) = 0;
+
+    /// \brief write the objects, metadata, autoscans, config values and file states to a dump file
+    virtual void exportDatabase(const fs::path& path) = 0;
+    /// \brief replace the tables written by exportDatabase with the contents of a dump file
+    virtual void importDatabase(const fs::path& path) = 0;
+
+    /// \brief refresh the statistics of the query planner and give free space back, a run takes small steps only
+    virtual void runMaintenance() = 0;
+    /// \brief time and result of the last maintenance run, empty if there was none
+    virtual std::string getMaintenanceStatus() = 0;
+
+    /// \brief write the container update ids counted in memory to the database
+    virtual void storeUpdateIDs() = 0;
 
     /* accounting methods */
     virtual int getTotalFiles(bool isVirtual = false, const std::string& mimeType = "", const std::string& upnpClass = "") = 0;
@@ -289,6 +458,9 @@ public:
     /// \brief clears the given flag in all objects in the DB
     virtual void clearFlagInDB(int flag) = 0;
 
+    /// \brief ids of all objects with the given flag set
+    virtual std::vector<int> getFlaggedObjectIDs(int flag) = 0;
+
     virtual std::string getFsRootName() = 0;
 
     virtual void threadCleanup() = 0;
@@ -296,10 +468,14 @@ public:
 
     virtual void doMetadataMigration() = 0;
 
-protected:
-    /* helper for addContainerChain */
+    /// \brief statistics of the queries, nullptr if the database does not time them
+    virtual std::shared_ptr<QueryProfiler> getQueryProfiler() { return nullptr; }
+
+    /// \brief split a virtual container path into the path of the parent and the unescaped title
     static void stripAndUnescapeVirtualContainerFromPath(std::string path, std::string& first, std::string& last);
 
+protected:
+
     static std::shared_ptr<Database> createInstance(const std::shared_ptr<Config>& config, const std::shared_ptr<Timer>& timer);
     friend class Server;
 
@@ -14,7 +14,7 @@ CREATE TABLE `mt_cds_object` (
   `upnp_class` varchar(80) default NULL,
   `dc_title` varchar(255) default NULL,
   `location` blob,
-  `location_hash` int(11) unsigned default NULL,
+  `location_hash` bigint(20) default NULL,
   `metadata` blob,
   `auxdata` blob,
   `resources` blob,
@@ -26,6 +26,7 @@ CREATE TABLE `mt_cds_object` (
   `service_id` varchar(255) default NULL,
   `bookmark_pos` int(11) unsigned NOT NULL default '0',
   `last_modified` bigint(20) unsigned default NULL,
+  `child_count` int(11) NOT NULL default '0',
   PRIMARY KEY  (`id`),
   KEY `cds_object_ref_id` (`ref_id`),
   KEY `cds_object_parent_id` (`parent_id`,`object_type`,`dc_title`),
@@ -33,19 +34,20 @@ CREATE TABLE `mt_cds_object` (
   KEY `location_parent` (`location_hash`,`parent_id`),
   KEY `cds_object_track_number` (`part_number`,`track_number`),
   KEY `cds_object_service_id` (`service_id`),
+  KEY `grb_cds_object_upnp_class` (`upnp_class`),
   CONSTRAINT `mt_cds_object_ibfk_1` FOREIGN KEY (`ref_id`) REFERENCES `mt_cds_object` (`id`) ON DELETE CASCADE ON UPDATE CASCADE,
   CONSTRAINT `mt_cds_object_ibfk_2` FOREIGN KEY (`parent_id`) REFERENCES `mt_cds_object` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
 ) ENGINE=MyISAM CHARSET=utf8;
-INSERT INTO `mt_cds_object` VALUES (-1,NULL,-1,0,NULL,NULL,NULL,NULL,NULL,NULL,NULL,0,NULL,9,NULL,NULL,NULL,0,NULL);
-INSERT INTO `mt_cds_object` VALUES (0,NULL,-1,1,'object.container','Root',NULL,NULL,NULL,NULL,NULL,0,NULL,9,NULL,NULL,NULL,0,NULL);
+INSERT INTO `mt_cds_object` VALUES (-1,NULL,-1,0,NULL,NULL,NULL,NULL,NULL,NULL,NULL,0,NULL,9,NULL,NULL,NULL,0,NULL,2);
+INSERT INTO `mt_cds_object` VALUES (0,NULL,-1,1,'object.container','Root',NULL,NULL,NULL,NULL,NULL,0,NULL,9,NULL,NULL,NULL,0,NULL,1);
 UPDATE `mt_cds_object` SET `id`='0' WHERE `id`='1';
-INSERT INTO `mt_cds_object` VALUES (1,NULL,0,1,'object.container','PC Directory',NULL,NULL,NULL,NULL,NULL,0,NULL,9,NULL,NULL,NULL,0,NULL);
+INSERT INTO `mt_cds_object` VALUES (1,NULL,0,1,'object.container','PC Directory',NULL,NULL,NULL,NULL,NULL,0,NULL,9,NULL,NULL,NULL,0,NULL,0);
 CREATE TABLE `mt_internal_setting` (
   `key` varchar(40) NOT NULL,
   `value` varchar(255) NOT NULL,
   PRIMARY KEY  (`key`)
 ) ENGINE=MyISAM CHARSET=utf8;
-INSERT INTO `mt_internal_setting` VALUES ('db_version','10');
+INSERT INTO `mt_internal_setting` VALUES ('db_version','19');
 CREATE TABLE `mt_autoscan` (
   `id` int(11) NOT NULL auto_increment,
   `obj_id` int(11) default NULL,
@@ -70,6 +72,8 @@ CREATE TABLE `mt_metadata` (
   `property_value` text NOT NULL,
   PRIMARY KEY `id` (`id`),
   KEY `metadata_item_id` (`item_id`),
+  KEY `grb_metadata_property` (`property_name`),
+  KEY `grb_metadata_item_property` (`item_id`,`property_name`),
   CONSTRAINT `mt_metadata_idfk1` FOREIGN KEY (`item_id`) REFERENCES `mt_cds_object` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
 ) ENGINE=MyISAM CHARSET=utf8;
 CREATE TABLE `grb_config_value` (
@@ -79,6 +83,41 @@ CREATE TABLE `grb_config_value` (
   `status` varchar(20) NOT NULL)
   ENGINE=MyISAM CHARSET=utf8;
 CREATE INDEX grb_config_value_item ON grb_config_value(item);
+CREATE TABLE `grb_directory_state` (
+  `id` int(11) NOT NULL,
+  `mtime` bigint(20) unsigned NOT NULL,
+  `child_count` int(11) NOT NULL,
+  PRIMARY KEY (`id`),
+  CONSTRAINT `grb_directory_state_fk` FOREIGN KEY (`id`) REFERENCES `mt_cds_object` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
+) ENGINE=MyISAM CHARSET=utf8;
+CREATE TABLE `grb_file_state` (
+  `id` int(11) NOT NULL,
+  `size` bigint(20) NOT NULL,
+  `inode` bigint(20) NOT NULL,
+  `birth_time` bigint(20) NOT NULL,
+  `head` bigint(20) NOT NULL,
+  `tail` bigint(20) NOT NULL,
+  PRIMARY KEY (`id`),
+  CONSTRAINT `grb_file_state_fk` FOREIGN KEY (`id`) REFERENCES `mt_cds_object` (`id`) ON DELETE CASCADE ON UPDATE CASCADE
+) ENGINE=MyISAM CHARSET=utf8;
+CREATE TABLE `grb_scrobble` (
+  `id` int(11) NOT NULL auto_increment,
+  `artist` varchar(255) NOT NULL,
+  `title` varchar(255) NOT NULL,
+  `album` varchar(255) NOT NULL,
+  `track_number` int(11) NOT NULL,
+  `length` int(11) NOT NULL,
+  `started` bigint(20) NOT NULL,
+  PRIMARY KEY (`id`)
+) ENGINE=MyISAM CHARSET=utf8;
+CREATE TABLE `grb_change_log` (
+  `id` int(11) NOT NULL auto_increment,
+  `node` varchar(255) NOT NULL,
+  `update_ids` mediumtext NOT NULL,
+  `changed` bigint(20) NOT NULL,
+  PRIMARY KEY (`id`),
+  KEY `grb_change_log_changed` (`changed`)
+) ENGINE=MyISAM CHARSET=utf8;
 /*!40101 SET SQL_MODE=@OLD_SQL_MODE */;
 /*!40014 SET FOREIGN_KEY_CHECKS=@OLD_FOREIGN_KEY_CHECKS */;
 /*!40014 SET UNIQUE_CHECKS=@OLD_UNIQUE_CHECKS */;
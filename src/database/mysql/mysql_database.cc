@@ -38,6 +38,7 @@
 #include <zlib.h>
 
 #include "config/config_manager.h"
+#include "database/search_handler.h"
 #include "util/tools.h"
 
 //#define MYSQL_SET_NAMES "/*!40101 SET NAMES utf8 */"
@@ -94,9 +95,78 @@
 // updates 9->10: last_modified
 #define MYSQL_UPDATE_9_10_1 "ALTER TABLE `mt_cds_object` ADD `last_modified` bigint(20) unsigned default NULL AFTER `bookmark_pos`"
 
+// updates 10->11: child_count
+#define MYSQL_UPDATE_10_11_1 "ALTER TABLE `mt_cds_object` ADD `child_count` int(11) NOT NULL default '0' AFTER `last_modified`"
+#define MYSQL_UPDATE_10_11_2 "UPDATE `mt_cds_object` `o` JOIN (SELECT `parent_id`, COUNT(*) AS `cnt` FROM `mt_cds_object` GROUP BY `parent_id`) `c` ON `o`.`id` = `c`.`parent_id` SET `o`.`child_count` = `c`.`cnt`"
+
+// updates 11->12: metadata property index
+#define MYSQL_UPDATE_11_12_1 "CREATE INDEX `grb_metadata_property` ON `mt_metadata`(`property_name`)"
+
+// updates 12->13: 64 bit location hash, the marked rows are hashed again by migrateLocationHashes
+#define MYSQL_UPDATE_12_13_1 "ALTER TABLE `mt_cds_object` MODIFY `location_hash` bigint(20) default NULL"
+#define MYSQL_UPDATE_12_13_2 "UPDATE `mt_cds_object` SET `location_hash` = -1 WHERE `location_hash` IS NOT NULL"
+
+// updates 13->14: directory state of timed autoscans
+#define MYSQL_UPDATE_13_14_1 "CREATE TABLE `grb_directory_state` ( \
+  `id` int(11) NOT NULL, \
+  `mtime` bigint(20) unsigned NOT NULL, \
+  `child_count` int(11) NOT NULL, \
+  PRIMARY KEY (`id`), \
+  CONSTRAINT `grb_directory_state_fk` FOREIGN KEY (`id`) REFERENCES `mt_cds_object` (`id`) ON DELETE CASCADE ON UPDATE CASCADE \
+) ENGINE=MyISAM CHARSET=utf8"
+
+// updates 14->15: file state for change detection
+#define MYSQL_UPDATE_14_15_1 "CREATE TABLE `grb_file_state` ( \
+  `id` int(11) NOT NULL, \
+  `size` bigint(20) NOT NULL, \
+  `inode` bigint(20) NOT NULL, \
+  `birth_time` bigint(20) NOT NULL, \
+  `head` bigint(20) NOT NULL, \
+  `tail` bigint(20) NOT NULL, \
+  PRIMARY KEY (`id`), \
+  CONSTRAINT `grb_file_state_fk` FOREIGN KEY (`id`) REFERENCES `mt_cds_object` (`id`) ON DELETE CASCADE ON UPDATE CASCADE \
+) ENGINE=MyISAM CHARSET=utf8"
+
+// updates 15->16: metadata lookup of one property, used to sort by metadata
+#define MYSQL_UPDATE_15_16_1 "CREATE INDEX `grb_metadata_item_property` ON `mt_metadata`(`item_id`,`property_name`)"
+
+// updates 16->17: class range of derivedfrom searches
+#define MYSQL_UPDATE_16_17_1 "CREATE INDEX `grb_cds_object_upnp_class` ON `mt_cds_object`(`upnp_class`)"
+
+// updates 17->18: Last.fm plays that were not submitted before a shutdown
+#define MYSQL_UPDATE_17_18_1 "CREATE TABLE `grb_scrobble` ( \
+  `id` int(11) NOT NULL auto_increment, \
+  `artist` varchar(255) NOT NULL, \
+  `title` varchar(255) NOT NULL, \
+  `album` varchar(255) NOT NULL, \
+  `track_number` int(11) NOT NULL, \
+  `length` int(11) NOT NULL, \
+  `started` bigint(20) NOT NULL, \
+  PRIMARY KEY (`id`) \
+) ENGINE=MyISAM CHARSET=utf8"
+
+// updates 18->19: change log of the nodes sharing the database
+#define MYSQL_UPDATE_18_19_1 "CREATE TABLE `grb_change_log` ( \
+  `id` int(11) NOT NULL auto_increment, \
+  `node` varchar(255) NOT NULL, \
+  `update_ids` mediumtext NOT NULL, \
+  `changed` bigint(20) NOT NULL, \
+  PRIMARY KEY (`id`), \
+  KEY `grb_change_log_changed` (`changed`) \
+) ENGINE=MyISAM CHARSET=utf8"
+
+#define MYSQL_INSERT_SETTINGS "SELECT @@max_allowed_packet, (SELECT `ENGINE` FROM `information_schema`.`TABLES` WHERE `TABLE_SCHEMA`=DATABASE() AND `TABLE_NAME`='mt_cds_object'), @@innodb_autoinc_lock_mode, @@auto_increment_increment"
+#define MYSQL_ANALYZE_TABLES "ANALYZE TABLE `mt_cds_object`, `mt_metadata`, `mt_autoscan`, `grb_config_value`, `grb_directory_state`, `grb_file_state`"
+// optional FULLTEXT index on the metadata values
+#define MYSQL_FULLTEXT_CHECK "SHOW INDEX FROM `mt_metadata` WHERE `Key_name`='grb_metadata_fulltext'"
+#define MYSQL_FULLTEXT_CREATE "ALTER TABLE `mt_metadata` ADD FULLTEXT `grb_metadata_fulltext` (`property_value`)"
+// first server versions with WITH RECURSIVE
+#define MYSQL_RECURSIVE_VERSION 80000
+#define MARIADB_RECURSIVE_VERSION 100202
+
 #define MYSQL_UPDATE_VERSION "UPDATE `mt_internal_setting` SET `value`='{}' WHERE `key`='db_version' AND `value`='{}'"
 
-static const auto dbUpdates = std::array<std::vector<const char*>, 9> { {
+static const auto dbUpdates = std::array<std::vector<const char*>, 18> { {
     { MYSQL_UPDATE_1_2_1, MYSQL_UPDATE_1_2_2, MYSQL_UPDATE_1_2_3, MYSQL_UPDATE_1_2_4, MYSQL_UPDATE_1_2_5 },
     { MYSQL_UPDATE_2_3_1, MYSQL_UPDATE_2_3_2, MYSQL_UPDATE_2_3_3 },
     { MYSQL_UPDATE_3_4_1, MYSQL_UPDATE_3_4_2 },
@@ -106,6 +176,15 @@ static const auto dbUpdates = std::array<std::vector<const char*>, 9> { {
     { MYSQL_UPDATE_7_8_1, MYSQL_UPDATE_7_8_2, MYSQL_UPDATE_7_8_3 },
     { MYSQL_UPDATE_8_9_1 },
     { MYSQL_UPDATE_9_10_1 },
+    { MYSQL_UPDATE_10_11_1, MYSQL_UPDATE_10_11_2 },
+    { MYSQL_UPDATE_11_12_1 },
+    { MYSQL_UPDATE_12_13_1, MYSQL_UPDATE_12_13_2 },
+    { MYSQL_UPDATE_13_14_1 },
+    { MYSQL_UPDATE_14_15_1 },
+    { MYSQL_UPDATE_15_16_1 },
+    { MYSQL_UPDATE_16_17_1 },
+    { MYSQL_UPDATE_17_18_1 },
+    { MYSQL_UPDATE_18_19_1 },
 } };
 
 MySQLDatabase::MySQLDatabase(std::shared_ptr<Config> config)
@@ -118,13 +197,17 @@ MySQLDatabase::MySQLDatabase(std::shared_ptr<Config> config)
 }
 MySQLDatabase::~MySQLDatabase()
 {
-    AutoLock lock(mysqlMutex); // just to ensure, that we don't close while another thread
+    std::unique_lock<std::mutex> lock(poolMutex); // just to ensure, that we don't close while another thread
     // is executing a query
+    poolCond.wait(lock, [this] { return freeConnections.size() == connections.size(); });
 
-    if (mysql_connection) {
-        mysql_close(&db);
-        mysql_connection = false;
+    for (auto&& conn : connections) {
+        clearStatementCache(conn.get());
+        mysql_close(&conn->db);
     }
+    connections.clear();
+    freeConnections.clear();
+    mysql_connection = false;
     log_debug("calling mysql_server_end...");
     mysql_server_end();
     log_debug("...ok");
@@ -149,26 +232,8 @@ void MySQLDatabase::threadCleanup()
     }
 }
 
-void MySQLDatabase::init()
+MysqlConnection* MySQLDatabase::connect()
 {
-    log_debug("start");
-    SQLDatabase::init();
-
-    std::unique_lock<decltype(mysqlMutex)> lock(mysqlMutex);
-    int ret;
-
-    if (!mysql_thread_safe()) {
-        throw_std_runtime_error("mysql library is not thread safe");
-    }
-
-    /// \todo write destructor function
-    ret = pthread_key_create(&mysql_init_key, nullptr);
-    if (ret) {
-        throw_std_runtime_error("could not create pthread_key");
-    }
-    mysql_server_init(0, nullptr, nullptr);
-    pthread_setspecific(mysql_init_key, reinterpret_cast<void*>(1));
-
     std::string dbHost = config->getOption(CFG_SERVER_STORAGE_MYSQL_HOST);
     std::string dbName = config->getOption(CFG_SERVER_STORAGE_MYSQL_DATABASE);
     std::string dbUser = config->getOption(CFG_SERVER_STORAGE_MYSQL_USERNAME);
@@ -176,21 +241,18 @@ void MySQLDatabase::init()
     std::string dbPass = config->getOption(CFG_SERVER_STORAGE_MYSQL_PASSWORD);
     std::string dbSock = config->getOption(CFG_SERVER_STORAGE_MYSQL_SOCKET);
 
-    MYSQL* res_mysql;
-
-    res_mysql = mysql_init(&db);
+    auto conn = std::make_unique<MysqlConnection>();
+    MYSQL* res_mysql = mysql_init(&conn->db);
     if (!res_mysql) {
         throw_std_runtime_error("mysql_init failed");
     }
 
-    mysql_init_key_initialized = true;
-
-    mysql_options(&db, MYSQL_SET_CHARSET_NAME, "utf8mb4");
+    mysql_options(&conn->db, MYSQL_SET_CHARSET_NAME, "utf8mb4");
 
     bool my_bool_var = true;
-    mysql_options(&db, MYSQL_OPT_RECONNECT, &my_bool_var);
+    mysql_options(&conn->db, MYSQL_OPT_RECONNECT, &my_bool_var);
 
-    res_mysql = mysql_real_connect(&db,
+    res_mysql = mysql_real_connect(&conn->db,
         dbHost.c_str(),
         dbUser.c_str(),
         (dbPass.empty() ? nullptr : dbPass.c_str()),
@@ -200,9 +262,61 @@ void MySQLDatabase::init()
         0 // flags
     );
     if (!res_mysql) {
-        throw_std_runtime_error("The connection to the MySQL database has failed: {}", getError(&db));
+        std::string myError = getError(&conn->db);
+        mysql_close(&conn->db);
+        throw_std_runtime_error("The connection to the MySQL database has failed: {}", myError);
+    }
+    return conn.release();
+}
+
+MysqlConnection* MySQLDatabase::acquireConnection(bool& pinned)
+{
+    pinned = transactionThread == std::this_thread::get_id();
+    if (pinned)
+        return transactionConnection;
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    poolCond.wait(lock, [this] { return !freeConnections.empty(); });
+    auto conn = freeConnections.back();
+    freeConnections.pop_back();
+    return conn;
+}
+
+void MySQLDatabase::releaseConnection(MysqlConnection* conn)
+{
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        freeConnections.push_back(conn);
+    }
+    poolCond.notify_all();
+}
+
+void MySQLDatabase::init()
+{
+    log_debug("start");
+    SQLDatabase::init();
+
+    int ret;
+
+    if (!mysql_thread_safe()) {
+        throw_std_runtime_error("mysql library is not thread safe");
     }
 
+    /// \todo write destructor function
+    ret = pthread_key_create(&mysql_init_key, nullptr);
+    if (ret) {
+        throw_std_runtime_error("could not create pthread_key");
+    }
+    mysql_server_init(0, nullptr, nullptr);
+    pthread_setspecific(mysql_init_key, reinterpret_cast<void*>(1));
+
+    mysql_init_key_initialized = true;
+
+    {
+        std::lock_guard<std::mutex> poolLock(poolMutex);
+        connections.push_back(std::unique_ptr<MysqlConnection>(connect()));
+        freeConnections.push_back(connections.back().get());
+    }
     mysql_connection = true;
 
     std::string dbVersion;
@@ -224,9 +338,10 @@ void MySQLDatabase::init()
                 continue;
             }
             log_debug("executing statement: '{}'", statement);
-            ret = mysql_real_query(&db, statement.c_str(), statement.size());
+            ConnectionLease conn(this);
+            ret = mysql_real_query(&conn.get()->db, statement.c_str(), statement.size());
             if (ret) {
-                std::string myError = getError(&db);
+                std::string myError = getError(&conn.get()->db);
                 throw DatabaseException(myError, fmt::format("Mysql: error while creating db: {}", myError));
             }
         }
@@ -246,9 +361,9 @@ void MySQLDatabase::init()
         if (dbVersion == fmt::to_string(version)) {
             log_info("Running an automatic database upgrade from database version {} to version {}...", version, version + 1);
             for (const auto& upgradeCmd : upgrade) {
-                _exec(upgradeCmd);
+                SQLDatabase::exec(upgradeCmd);
             }
-            _exec(fmt::format(MYSQL_UPDATE_VERSION, version + 1, version).c_str());
+            SQLDatabase::exec(fmt::format(MYSQL_UPDATE_VERSION, version + 1, version));
             dbVersion = fmt::to_string(version + 1);
             log_info("Database upgrade to version {} successful.", dbVersion.c_str());
         }
@@ -258,11 +373,114 @@ void MySQLDatabase::init()
     if (dbVersion != fmt::to_string(version))
         throw_std_runtime_error("The database seems to be from a newer version (database version {})", dbVersion);
 
-    lock.unlock();
+    // the other connections start after the upgrades, so their statements see the final schema
+    int poolSize = config->getIntOption(CFG_SERVER_STORAGE_MYSQL_CONNECTIONS);
+    {
+        std::lock_guard<std::mutex> poolLock(poolMutex);
+        for (int i = 1; i < poolSize; i++) {
+            connections.push_back(std::unique_ptr<MysqlConnection>(connect()));
+            freeConnections.push_back(connections.back().get());
+        }
+    }
+    poolCond.notify_all();
+    log_debug("opened {} mysql connections", connections.size());
+
+    readInsertSettings();
+    migrateLocationHashes();
+    initFulltextSearch();
 
     log_debug("end");
 }
 
+void MySQLDatabase::readInsertSettings()
+{
+    auto res = select(MYSQL_INSERT_SETTINGS, strlen(MYSQL_INSERT_SETTINGS));
+    std::unique_ptr<SQLRow> row;
+    if (res == nullptr || (row = res->nextRow()) == nullptr)
+        return;
+    maxStatementSize = stoulString(row->col(0));
+    auto engine = toLower(row->col(1));
+    myisamTables = engine == "myisam";
+    // MyISAM locks the table for the statement, InnoDB hands out the ids of a multi-row INSERT in one block except in the interleaved mode
+    consecutiveInsertIds = myisamTables || (engine == "innodb" && stoiString(row->col(2), 2) < 2);
+    // replicated servers often step the ids by the number of nodes, the ids of a block are not consecutive then
+    auto increment = stoiString(row->col(3), 1);
+    if (increment != 1)
+        consecutiveInsertIds = false;
+    log_debug("max_allowed_packet {}, MyISAM tables {}, auto_increment_increment {}, consecutive insert ids {}", maxStatementSize, myisamTables, increment, consecutiveInsertIds);
+}
+
+bool MySQLDatabase::isInsertFull(std::size_t rows, std::size_t length) const
+{
+    if (maxStatementSize == 0)
+        return SQLDatabase::isInsertFull(rows, length);
+    // leave room for the rows added before the size is checked again
+    return length >= maxStatementSize / 2;
+}
+
+std::string MySQLDatabase::maintain()
+{
+    // one row per table and message
+    auto res = select(MYSQL_ANALYZE_TABLES, strlen(MYSQL_ANALYZE_TABLES));
+    std::size_t tables = 0;
+    std::vector<std::string> errors;
+    std::unique_ptr<SQLRow> row;
+    while (res != nullptr && (row = res->nextRow()) != nullptr) {
+        if (row->col(2) == "error")
+            errors.push_back(fmt::format("{}: {}", row->col(0), row->col(3)));
+        else if (row->col(2) == "status")
+            tables++;
+    }
+    if (!errors.empty())
+        throw_std_runtime_error("ANALYZE TABLE failed for {}", join(errors, ", "));
+    return fmt::format("analyzed {} tables", tables);
+}
+
+void MySQLDatabase::deferIndexes(const std::string& table, bool defer)
+{
+    // InnoDB has nothing like it and ends the transaction at an ALTER TABLE, MyISAM has no transactions to end
+    if (!myisamTables)
+        return;
+    auto query = fmt::format("ALTER TABLE `{}` {} KEYS", table, defer ? "DISABLE" : "ENABLE");
+    exec(query.c_str(), query.size());
+}
+
+std::vector<std::string> MySQLDatabase::getWarmUpQueries() const
+{
+    // counting through the index loads it into the buffer pool
+    return {
+        "SELECT COUNT(*) FROM `mt_cds_object` FORCE INDEX (`cds_object_parent_id`)",
+        "SELECT COUNT(*) FROM `mt_cds_object` FORCE INDEX (`location_parent`)",
+    };
+}
+
+void MySQLDatabase::deferForeignKeys(bool defer)
+{
+    // InnoDB cannot defer the checks, they are off while the rows are added and stay off for the connection otherwise
+    auto query = defer ? "SET FOREIGN_KEY_CHECKS = 0" : "SET FOREIGN_KEY_CHECKS = 1";
+    exec(query, strlen(query));
+}
+
+std::shared_ptr<SQLEmitter> MySQLDatabase::prepareFulltextSearch()
+{
+    auto res = select(MYSQL_FULLTEXT_CHECK, strlen(MYSQL_FULLTEXT_CHECK));
+    if (res == nullptr || res->nextRow() == nullptr) {
+        log_info("Creating the full-text search index...");
+        exec(MYSQL_FULLTEXT_CREATE, strlen(MYSQL_FULLTEXT_CREATE));
+    }
+    return std::make_shared<MysqlFulltextSQLEmitter>();
+}
+
+bool MySQLDatabase::supportsRecursiveQueries()
+{
+    auto db = &connections.front()->db;
+    auto version = mysql_get_server_version(db);
+    std::string serverInfo = mysql_get_server_info(db);
+    if (serverInfo.find("MariaDB") != std::string::npos)
+        return version >= MARIADB_RECURSIVE_VERSION;
+    return version >= MYSQL_RECURSIVE_VERSION;
+}
+
 std::shared_ptr<Database> MySQLDatabase::getSelf()
 {
     return shared_from_this();
@@ -277,7 +495,8 @@ std::string MySQLDatabase::quote(std::string value) const
      */
     auto q = new char[value.length() * 2 + 2];
     *q = '\'';
-    auto size = mysql_real_escape_string(const_cast<MYSQL*>(&db), q + 1, value.c_str(), value.length());
+    // escaping only reads the character set of the connection
+    auto size = mysql_real_escape_string(const_cast<MYSQL*>(&connections.front()->db), q + 1, value.c_str(), value.length());
     q[size + 1] = '\'';
     std::string ret(q, size + 2);
     delete[] q;
@@ -295,16 +514,69 @@ std::string MySQLDatabase::getError(MYSQL* db)
 
 void MySQLDatabase::beginTransaction()
 {
-    _exec("START TRANSACTION");
+    transactionMutex.lock();
+    if (transactionDepth++ == 0) {
+        checkMysqlThreadInit();
+        bool pinned;
+        auto conn = acquireConnection(pinned);
+        try {
+            _exec(conn, "START TRANSACTION");
+        } catch (const std::runtime_error& e) {
+            releaseConnection(conn);
+            transactionDepth--;
+            transactionMutex.unlock();
+            throw;
+        }
+        transactionConnection = conn;
+        transactionThread = std::this_thread::get_id();
+    }
 }
 
 void MySQLDatabase::commit()
 {
-    _exec("COMMIT");
+    // releases the level taken by beginTransaction()
+    std::unique_lock<std::recursive_mutex> lock(transactionMutex, std::adopt_lock);
+    if (--transactionDepth == 0) {
+        auto conn = transactionConnection;
+        transactionThread = std::thread::id();
+        transactionConnection = nullptr;
+        bool failed = std::exchange(rollbackOnly, false);
+        try {
+            _exec(conn, failed ? "ROLLBACK" : "COMMIT");
+        } catch (const std::runtime_error& e) {
+            releaseConnection(conn);
+            throw;
+        }
+        releaseConnection(conn);
+        if (failed)
+            throw_std_runtime_error("Transaction rolled back, a nested part of it failed");
+    }
+}
+
+void MySQLDatabase::rollback()
+{
+    // only the outermost level can roll back, an inner rollback makes its commit roll back instead
+    std::unique_lock<std::recursive_mutex> lock(transactionMutex, std::adopt_lock);
+    if (--transactionDepth > 0) {
+        rollbackOnly = true;
+        return;
+    }
+    auto conn = transactionConnection;
+    transactionThread = std::thread::id();
+    transactionConnection = nullptr;
+    rollbackOnly = false;
+    try {
+        _exec(conn, "ROLLBACK");
+    } catch (const std::runtime_error& e) {
+        releaseConnection(conn);
+        throw;
+    }
+    releaseConnection(conn);
 }
 
 std::shared_ptr<SQLResult> MySQLDatabase::select(const char* query, int length)
 {
+    QueryTimer timer(this, query);
 #ifdef MYSQL_SELECT_DEBUG
     log_debug("{}", query);
     print_backtrace();
@@ -313,25 +585,28 @@ std::shared_ptr<SQLResult> MySQLDatabase::select(const char* query, int length)
     int res;
 
     checkMysqlThreadInit();
-    AutoLock lock(mysqlMutex);
-    res = mysql_real_query(&db, query, length);
+    ConnectionLease conn(this);
+    auto db = &conn.get()->db;
+    res = mysql_real_query(db, query, length);
     if (res) {
-        std::string myError = getError(&db);
+        std::string myError = getError(db);
         throw DatabaseException(myError, "Mysql: mysql_real_query() failed: " + myError + "; query: " + query);
     }
 
     MYSQL_RES* mysql_res;
-    mysql_res = mysql_store_result(&db);
+    mysql_res = mysql_store_result(db);
     if (!mysql_res) {
-        std::string myError = getError(&db);
+        std::string myError = getError(db);
         throw DatabaseException(myError, "Mysql: mysql_store_result() failed: " + myError + "; query: " + query);
     }
 
+    timer.setRows(mysql_num_rows(mysql_res));
     return std::static_pointer_cast<SQLResult>(std::make_shared<MysqlResult>(mysql_res));
 }
 
 int MySQLDatabase::exec(const char* query, int length, bool getLastInsertId)
 {
+    QueryTimer timer(this, query);
 #ifdef MYSQL_EXEC_DEBUG
     log_debug("{}", query);
     print_backtrace();
@@ -340,18 +615,163 @@ int MySQLDatabase::exec(const char* query, int length, bool getLastInsertId)
     int res;
 
     checkMysqlThreadInit();
-    AutoLock lock(mysqlMutex);
-    res = mysql_real_query(&db, query, length);
+    ConnectionLease conn(this);
+    auto db = &conn.get()->db;
+    res = mysql_real_query(db, query, length);
     if (res) {
-        std::string myError = getError(&db);
+        std::string myError = getError(db);
         throw DatabaseException(myError, "Mysql: mysql_real_query() failed: " + myError + "; query: " + query);
     }
     int insert_id = -1;
     if (getLastInsertId)
-        insert_id = mysql_insert_id(&db);
+        insert_id = mysql_insert_id(db);
     return insert_id;
 }
 
+std::shared_ptr<SQLResult> MySQLDatabase::selectPrepared(const std::string& query, const std::vector<SQLParam>& params)
+{
+    QueryTimer timer(this, query);
+#ifdef MYSQL_SELECT_DEBUG
+    log_debug("{}", query);
+    print_backtrace();
+#endif
+
+    checkMysqlThreadInit();
+    ConnectionLease conn(this);
+    std::shared_ptr<SQLResult> result;
+    try {
+        result = executeStatement(getStatement(conn.get(), query), params);
+    } catch (const DatabaseException& e) {
+        // the statement handle does not survive a reconnect, so prepare it once more
+        log_debug("retrying prepared statement: {}", e.what());
+        dropStatement(conn.get(), query);
+        result = executeStatement(getStatement(conn.get(), query), params);
+    }
+    timer.setRows(result->getNumRows());
+    return result;
+}
+
+MYSQL_STMT* MySQLDatabase::getStatement(MysqlConnection* conn, const std::string& query)
+{
+    auto&& statementCache = conn->statementCache;
+    auto it = statementCache.find(query);
+    if (it != statementCache.end())
+        return it->second;
+
+    MYSQL_STMT* stmt = mysql_stmt_init(&conn->db);
+    if (!stmt) {
+        std::string myError = getError(&conn->db);
+        throw DatabaseException(myError, "Mysql: mysql_stmt_init() failed: " + myError);
+    }
+    if (mysql_stmt_prepare(stmt, query.c_str(), query.length())) {
+        std::string myError = mysql_stmt_error(stmt);
+        mysql_stmt_close(stmt);
+        throw DatabaseException(myError, "Mysql: mysql_stmt_prepare() failed: " + myError + "; query: " + query);
+    }
+    statementCache[query] = stmt;
+    return stmt;
+}
+
+void MySQLDatabase::dropStatement(MysqlConnection* conn, const std::string& query)
+{
+    auto it = conn->statementCache.find(query);
+    if (it != conn->statementCache.end()) {
+        mysql_stmt_close(it->second);
+        conn->statementCache.erase(it);
+    }
+}
+
+void MySQLDatabase::clearStatementCache(MysqlConnection* conn)
+{
+    for (auto&& [query, stmt] : conn->statementCache)
+        mysql_stmt_close(stmt);
+    conn->statementCache.clear();
+}
+
+std::shared_ptr<SQLResult> MySQLDatabase::executeStatement(MYSQL_STMT* stmt, const std::vector<SQLParam>& params)
+{
+    using mysql_bool = std::remove_pointer_t<decltype(MYSQL_BIND::is_null)>;
+
+    // the bind buffers must be mutable, so work on a copy of the values
+    auto values = params;
+    std::vector<MYSQL_BIND> paramBind(values.size());
+    std::vector<unsigned long> paramLength(values.size());
+    for (std::size_t i = 0; i < values.size(); i++) {
+        auto& bind = paramBind[i];
+        bind = {};
+        if (std::holds_alternative<int>(values[i])) {
+            bind.buffer_type = MYSQL_TYPE_LONG;
+            bind.buffer = &std::get<int>(values[i]);
+        } else if (std::holds_alternative<long long>(values[i])) {
+            bind.buffer_type = MYSQL_TYPE_LONGLONG;
+            bind.buffer = &std::get<long long>(values[i]);
+        } else if (std::holds_alternative<std::string>(values[i])) {
+            auto& text = std::get<std::string>(values[i]);
+            paramLength[i] = text.length();
+            bind.buffer_type = MYSQL_TYPE_STRING;
+            bind.buffer = text.data();
+            bind.buffer_length = text.length();
+            bind.length = &paramLength[i];
+        } else {
+            bind.buffer_type = MYSQL_TYPE_NULL;
+        }
+    }
+
+    if ((!paramBind.empty() && mysql_stmt_bind_param(stmt, paramBind.data())) || mysql_stmt_execute(stmt) || mysql_stmt_store_result(stmt)) {
+        std::string myError = mysql_stmt_error(stmt);
+        throw DatabaseException(myError, "Mysql: prepared statement failed: " + myError);
+    }
+
+    // bind empty string buffers to learn the length of each column, then fetch the columns one by one
+    unsigned int ncolumn = mysql_stmt_field_count(stmt);
+    std::vector<MYSQL_BIND> resultBind(ncolumn);
+    std::vector<unsigned long> resultLength(ncolumn);
+    auto resultNull = std::make_unique<mysql_bool[]>(ncolumn);
+    for (unsigned int col = 0; col < ncolumn; col++) {
+        resultBind[col] = {};
+        resultBind[col].buffer_type = MYSQL_TYPE_STRING;
+        resultBind[col].length = &resultLength[col];
+        resultBind[col].is_null = &resultNull[col];
+    }
+    if (ncolumn > 0 && mysql_stmt_bind_result(stmt, resultBind.data())) {
+        std::string myError = mysql_stmt_error(stmt);
+        mysql_stmt_free_result(stmt);
+        throw DatabaseException(myError, "Mysql: mysql_stmt_bind_result() failed: " + myError);
+    }
+
+    auto result = std::make_shared<MysqlStmtResult>();
+    int ret;
+    while ((ret = mysql_stmt_fetch(stmt)) == 0 || ret == MYSQL_DATA_TRUNCATED) {
+        std::vector<std::optional<std::string>> row;
+        row.reserve(ncolumn);
+        for (unsigned int col = 0; col < ncolumn; col++) {
+            if (resultNull[col]) {
+                row.emplace_back(std::nullopt);
+                continue;
+            }
+            std::string value(resultLength[col], '\0');
+            if (!value.empty()) {
+                MYSQL_BIND colBind = {};
+                unsigned long colLength = 0;
+                colBind.buffer_type = MYSQL_TYPE_STRING;
+                colBind.buffer = value.data();
+                colBind.buffer_length = value.length();
+                colBind.length = &colLength;
+                mysql_stmt_fetch_column(stmt, &colBind, col, 0);
+            }
+            row.emplace_back(std::move(value));
+        }
+        result->rows.push_back(std::move(row));
+    }
+    mysql_stmt_free_result(stmt);
+    if (ret != MYSQL_NO_DATA) {
+        std::string myError = mysql_stmt_error(stmt);
+        throw DatabaseException(myError, "Mysql: mysql_stmt_fetch() failed: " + myError);
+    }
+
+    return result;
+}
+
 void MySQLDatabase::shutdownDriver()
 {
 }
@@ -368,10 +788,10 @@ void MySQLDatabase::storeInternalSetting(const std::string& key, const std::stri
     SQLDatabase::exec(q.str());
 }
 
-void MySQLDatabase::_exec(const char* query, int length)
+void MySQLDatabase::_exec(MysqlConnection* conn, const char* query, int length)
 {
-    if (mysql_real_query(&db, query, (length > 0 ? length : strlen(query)))) {
-        std::string myError = getError(&db);
+    if (mysql_real_query(&conn->db, query, (length > 0 ? length : strlen(query)))) {
+        std::string myError = getError(&conn->db);
         throw DatabaseException(myError, "Mysql: error while updating db: " + myError);
     }
 }
@@ -411,6 +831,16 @@ std::unique_ptr<SQLRow> MysqlResult::nextRow()
     return nullptr;
 }
 
+/* MysqlStmtResult */
+
+std::unique_ptr<SQLRow> MysqlStmtResult::nextRow()
+{
+    if (cur_row < rows.size()) {
+        return std::make_unique<MysqlStmtRow>(std::move(rows[cur_row++]));
+    }
+    return nullptr;
+}
+
 /* MysqlRow */
 
 MysqlRow::MysqlRow(MYSQL_ROW mysql_row)
@@ -36,11 +36,23 @@
 
 #include "common.h"
 #include "database/sql_database.h"
+#include <atomic>
+#include <condition_variable>
+#include <map>
 #include <mutex>
 #include <mysql.h>
+#include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
+/// \brief A connection of the MySQL pool with its own prepared statements
+struct MysqlConnection {
+    MYSQL db;
+    /// \brief prepared statements of the connection, keyed by query text
+    std::map<std::string, MYSQL_STMT*> statementCache;
+};
+
 class MySQLDatabase : public SQLDatabase, public std::enable_shared_from_this<SQLDatabase> {
 public:
     explicit MySQLDatabase(std::shared_ptr<Config> config);
@@ -50,6 +62,14 @@ private:
     void init() override;
     void shutdownDriver() override;
     std::shared_ptr<Database> getSelf() override;
+    std::shared_ptr<SQLEmitter> prepareFulltextSearch() override;
+    bool supportsRecursiveQueries() override;
+    std::vector<std::string> getWarmUpQueries() const override;
+    void deferForeignKeys(bool defer) override;
+    void deferIndexes(const std::string& table, bool defer) override;
+    std::string maintain() override;
+    bool hasConsecutiveInsertIds() const override { return consecutiveInsertIds; }
+    bool isInsertFull(std::size_t rows, std::size_t length) const override;
 
     std::string quote(std::string value) const override;
     std::string quote(const char* str) const override { return quote(std::string(str)); }
@@ -62,22 +82,75 @@ private:
     std::string quote(long long val) const override { return fmt::to_string(val); }
     std::shared_ptr<SQLResult> select(const char* query, int length) override;
     int exec(const char* query, int length, bool getLastInsertId = false) override;
+    std::shared_ptr<SQLResult> selectPrepared(const std::string& query, const std::vector<SQLParam>& params) override;
 
     void beginTransaction() override;
     void commit() override;
+    void rollback() override;
 
     void storeInternalSetting(const std::string& key, const std::string& value) override;
 
-    void _exec(const char* query, int length = -1);
-
-    MYSQL db;
+    void _exec(MysqlConnection* conn, const char* query, int length = -1);
 
     bool mysql_connection;
 
+    /// \brief the tables are MyISAM, which builds the indexes of a table after a load when its keys are disabled
+    bool myisamTables { false };
+    /// \brief a multi-row INSERT receives consecutive auto increment ids
+    bool consecutiveInsertIds { false };
+    /// \brief the longest statement the server accepts
+    std::size_t maxStatementSize { 0 };
+    void readInsertSettings();
+
     static std::string getError(MYSQL* db);
 
-    std::recursive_mutex mysqlMutex;
-    using AutoLock = std::lock_guard<decltype(mysqlMutex)>;
+    /// \brief the pool, connections[0] also serves quote()
+    std::vector<std::unique_ptr<MysqlConnection>> connections;
+    std::vector<MysqlConnection*> freeConnections;
+    std::mutex poolMutex;
+    std::condition_variable poolCond;
+    MysqlConnection* connect();
+    /// \brief connection of the transaction of the calling thread or a free one of the pool
+    /// \param pinned set to true if the connection belongs to the transaction and must not be released
+    MysqlConnection* acquireConnection(bool& pinned);
+    void releaseConnection(MysqlConnection* conn);
+
+    /// \brief connection used by one call, it goes back to the pool at the end of the scope unless a transaction pinned it
+    class ConnectionLease {
+    public:
+        explicit ConnectionLease(MySQLDatabase* mysql)
+            : mysql(mysql)
+        {
+            conn = mysql->acquireConnection(pinned);
+        }
+        ~ConnectionLease()
+        {
+            if (!pinned)
+                mysql->releaseConnection(conn);
+        }
+        ConnectionLease(const ConnectionLease&) = delete;
+        ConnectionLease& operator=(const ConnectionLease&) = delete;
+
+        MysqlConnection* get() const { return conn; }
+
+    private:
+        MySQLDatabase* mysql;
+        MysqlConnection* conn;
+        bool pinned { false };
+    };
+
+    /// \brief held by the thread running a transaction, its connection stays out of the pool until the commit
+    std::recursive_mutex transactionMutex;
+    int transactionDepth { 0 };
+    /// \brief set by a nested rollback, the outermost commit rolls back instead
+    bool rollbackOnly { false };
+    std::atomic<std::thread::id> transactionThread;
+    MysqlConnection* transactionConnection { nullptr };
+
+    MYSQL_STMT* getStatement(MysqlConnection* conn, const std::string& query);
+    static void dropStatement(MysqlConnection* conn, const std::string& query);
+    static void clearStatementCache(MysqlConnection* conn);
+    std::shared_ptr<SQLResult> executeStatement(MYSQL_STMT* stmt, const std::vector<SQLParam>& params);
 
     void threadCleanup() override;
     bool threadCleanupRequired() const override { return true; }
@@ -103,6 +176,34 @@ private:
     friend class MySQLDatabase;
 };
 
+/// \brief Represents a result of a prepared statement, the values are copied out of the statement
+class MysqlStmtResult : public SQLResult {
+public:
+    MysqlStmtResult() = default;
+
+private:
+    std::unique_ptr<SQLRow> nextRow() override;
+    unsigned long long getNumRows() const override { return rows.size(); }
+
+    std::vector<std::vector<std::optional<std::string>>> rows;
+    std::size_t cur_row { 0 };
+
+    friend class MySQLDatabase;
+};
+
+class MysqlStmtRow : public SQLRow {
+public:
+    explicit MysqlStmtRow(std::vector<std::optional<std::string>> row)
+        : row(std::move(row))
+    {
+    }
+
+private:
+    char* col_c_str(int index) const override { return row[index] ? const_cast<char*>(row[index]->c_str()) : nullptr; }
+
+    std::vector<std::optional<std::string>> row;
+};
+
 class MysqlRow : public SQLRow {
 public:
     explicit MysqlRow(MYSQL_ROW mysql_row);
@@ -0,0 +1,146 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    object_cache.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file object_cache.cc
+
+#include "object_cache.h" // API
+
+#include <algorithm>
+
+#include "cds_objects.h"
+
+ObjectCache::ObjectCache(std::size_t capacity)
+    : capacity(capacity)
+{
+    memory = MemoryAccounting::getInstance().add("object-cache", [this] {
+        AutoLock lock(mutex);
+        std::size_t bytes = entries.bucket_count() * sizeof(void*) + locations.bucket_count() * sizeof(void*);
+        for (auto&& [objectID, entry] : entries)
+            bytes += MemoryAccounting::LIST_NODE + sizeof(Cache::Entry) + MemoryAccounting::HASH_NODE + sizeof(Cache::IndexValue) + MemoryAccounting::estimate(entry.location) + estimateObject(entry.obj);
+        for (auto&& [location, objectID] : locations)
+            bytes += MemoryAccounting::HASH_NODE + sizeof(decltype(locations)::value_type) + MemoryAccounting::estimate(location);
+        return bytes;
+    });
+}
+
+std::shared_ptr<CdsObject> ObjectCache::get(int objectID)
+{
+    AutoLock lock(mutex);
+    return lookup(objectID);
+}
+
+std::shared_ptr<CdsObject> ObjectCache::getByLocation(const std::string& location)
+{
+    AutoLock lock(mutex);
+    auto loc = locations.find(location);
+    if (loc == locations.end()) {
+        misses++;
+        requests.misses.inc();
+        return nullptr;
+    }
+    return lookup(loc->second);
+}
+
+std::shared_ptr<CdsObject> ObjectCache::lookup(int objectID)
+{
+    auto entry = entries.get(objectID);
+    if (entry == entries.end()) {
+        misses++;
+        requests.misses.inc();
+        return nullptr;
+    }
+    hits++;
+    requests.hits.inc();
+    return copyObject(entry->second.obj);
+}
+
+void ObjectCache::put(const std::shared_ptr<CdsObject>& obj, std::size_t generation, const std::string& location)
+{
+    if (capacity == 0)
+        return;
+
+    AutoLock lock(mutex);
+    if (generation != this->generation)
+        return;
+
+    auto entry = entries.find(obj->getID());
+    if (entry != entries.end())
+        remove(entry);
+    while (entries.size() >= capacity)
+        remove(std::prev(entries.end()));
+
+    entries.put(obj->getID(), { copyObject(obj), location });
+    if (!location.empty())
+        locations[location] = obj->getID();
+}
+
+void ObjectCache::erase(const std::vector<int>& objectIDs)
+{
+    AutoLock lock(mutex);
+    generation++;
+    for (auto it = entries.begin(); it != entries.end();) {
+        const auto& obj = it->second.obj;
+        bool drop = std::find_if(objectIDs.begin(), objectIDs.end(), [&](int id) { return id == obj->getID() || id == obj->getRefID(); }) != objectIDs.end();
+        it = drop ? remove(it) : std::next(it);
+    }
+}
+
+void ObjectCache::clear()
+{
+    AutoLock lock(mutex);
+    generation++;
+    entries.clear();
+    locations.clear();
+}
+
+ObjectCache::Cache::iterator ObjectCache::remove(Cache::iterator entry)
+{
+    if (!entry->second.location.empty())
+        locations.erase(entry->second.location);
+    return entries.erase(entry);
+}
+
+std::shared_ptr<CdsObject> ObjectCache::copyObject(const std::shared_ptr<CdsObject>& obj)
+{
+    auto copy = CdsObject::createObject(obj->getObjectType());
+    obj->copyTo(copy);
+    if (obj->isContainer()) {
+        auto cont = std::static_pointer_cast<CdsContainer>(obj);
+        auto contCopy = std::static_pointer_cast<CdsContainer>(copy);
+        contCopy->setAutoscanType(cont->getAutoscanType());
+        contCopy->setChildCount(cont->getChildCount());
+    }
+    return copy;
+}
+
+std::size_t ObjectCache::estimateObject(const std::shared_ptr<CdsObject>& obj)
+{
+    std::size_t bytes = obj->isItem() ? sizeof(CdsItem) : sizeof(CdsContainer);
+    bytes += MemoryAccounting::estimate(obj->getTitle()) + MemoryAccounting::estimate(obj->getLocation().native());
+    bytes += MemoryAccounting::estimate(obj->getMetadata()) + MemoryAccounting::estimate(obj->getAuxData());
+    for (auto&& resource : obj->getResources()) {
+        bytes += sizeof(CdsResource) + sizeof(resource);
+        bytes += MemoryAccounting::estimate(resource->getAttributes()) + MemoryAccounting::estimate(resource->getParameters()) + MemoryAccounting::estimate(resource->getOptions());
+    }
+    return bytes;
+}
@@ -0,0 +1,93 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    object_cache.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file object_cache.h
+
+#ifndef __OBJECT_CACHE_H__
+#define __OBJECT_CACHE_H__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util/lru_cache.h"
+#include "util/memory_accounting.h"
+#include "util/metrics.h"
+
+class CdsObject;
+
+/// \brief Size bounded LRU cache of objects loaded from the database
+///
+/// Callers always get their own copy, so changing a returned object does not change the cache.
+class ObjectCache {
+public:
+    explicit ObjectCache(std::size_t capacity);
+
+    /// \brief copy of the cached object or nullptr
+    std::shared_ptr<CdsObject> get(int objectID);
+    /// \brief copy of the cached object stored with the database location or nullptr
+    std::shared_ptr<CdsObject> getByLocation(const std::string& location);
+
+    /// \brief number to pass to put(), taken before loading the object from the database
+    std::size_t getGeneration() const { return generation; }
+    /// \brief store the object unless entries were invalidated since generation was taken
+    void put(const std::shared_ptr<CdsObject>& obj, std::size_t generation, const std::string& location = "");
+
+    /// \brief drop the objects and all cached objects referencing them
+    void erase(const std::vector<int>& objectIDs);
+    void clear();
+
+    unsigned long getHits() const { return hits; }
+    unsigned long getMisses() const { return misses; }
+
+private:
+    struct Entry {
+        std::shared_ptr<CdsObject> obj;
+        std::string location;
+    };
+    using Cache = LruCache<int, Entry, std::unordered_map>;
+
+    std::shared_ptr<CdsObject> lookup(int objectID);
+    /// \brief returns the next less recently used entry
+    Cache::iterator remove(Cache::iterator entry);
+    static std::shared_ptr<CdsObject> copyObject(const std::shared_ptr<CdsObject>& obj);
+    /// \brief bytes of the object with its strings, metadata and resources
+    static std::size_t estimateObject(const std::shared_ptr<CdsObject>& obj);
+
+    std::size_t capacity;
+    Cache entries;
+    std::unordered_map<std::string, int> locations;
+    std::mutex mutex;
+    std::atomic_size_t generation { 0 };
+    std::atomic_ulong hits { 0 };
+    std::atomic_ulong misses { 0 };
+    Metrics::CacheRequests requests { "object" };
+
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::unique_ptr<MemoryAccounting::Registration> memory;
+};
+
+#endif // __OBJECT_CACHE_H__
@@ -0,0 +1,142 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    query_profiler.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file query_profiler.cc
+
+#include "query_profiler.h" // API
+
+#include <algorithm>
+#include <cctype>
+
+#include "util/logger.h"
+
+QueryProfiler::QueryProfiler(bool aggregate, std::chrono::milliseconds slowTime, std::size_t maxFingerprints)
+    : aggregate(aggregate)
+    , slowTime(slowTime)
+    , maxFingerprints(maxFingerprints)
+{
+}
+
+static bool endsWith(const std::string& str, std::string_view suffix)
+{
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string QueryProfiler::fingerprint(std::string_view query)
+{
+    auto isWord = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+
+    std::string result;
+    result.reserve(query.size());
+    std::size_t i = 0;
+    while (i < query.size()) {
+        char c = query[i];
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            while (i < query.size() && std::isspace(static_cast<unsigned char>(query[i])))
+                i++;
+            if (!result.empty())
+                result.push_back(' ');
+            continue;
+        }
+
+        bool literal = false;
+        if (c == '\'') {
+            // '' and \' do not end the string
+            for (i++; i < query.size(); i++) {
+                if (query[i] == '\\')
+                    i++;
+                else if (query[i] == '\'' && (i + 1 >= query.size() || query[i + 1] != '\''))
+                    break;
+                else if (query[i] == '\'')
+                    i++;
+            }
+            i++;
+            literal = true;
+        } else if (std::isdigit(static_cast<unsigned char>(c)) && (result.empty() || !isWord(result.back()))) {
+            while (i < query.size() && (isWord(query[i]) || query[i] == '.'))
+                i++;
+            literal = true;
+        }
+        if (literal) {
+            result.push_back('?');
+        } else {
+            result.push_back(c);
+            i++;
+        }
+
+        // IN lists and rows of multi-row inserts differ in length
+        for (auto list : { std::string_view("?,?"), std::string_view("?, ?"), std::string_view("(?),(?)"), std::string_view("(?), (?)") }) {
+            if (endsWith(result, list)) {
+                result.erase(result.size() - list.size() + list.find(',', 1));
+                break;
+            }
+        }
+    }
+    while (!result.empty() && result.back() == ' ')
+        result.pop_back();
+    return result;
+}
+
+void QueryProfiler::record(std::string_view query, long long rows, std::chrono::steady_clock::duration duration)
+{
+    double ms = std::chrono::duration<double, std::milli>(duration).count();
+    bool slow = slowTime.count() > 0 && duration >= slowTime;
+    if (slow) {
+        if (rows >= 0)
+            log_warning("Slow query took {:.1f} ms for {} rows: {}", ms, rows, query);
+        else
+            log_warning("Slow query took {:.1f} ms: {}", ms, query);
+    }
+    if (!aggregate)
+        return;
+
+    auto key = fingerprint(query);
+    AutoLock lock(mutex);
+    auto entry = statistics.find(key);
+    if (entry == statistics.end()) {
+        if (statistics.size() >= maxFingerprints)
+            return;
+        entry = statistics.emplace(key, Statistics { key, 0, 0, 0, 0, 0 }).first;
+    }
+    auto&& stats = entry->second;
+    stats.count++;
+    if (slow)
+        stats.slow++;
+    if (rows > 0)
+        stats.rows += rows;
+    stats.totalMs += ms;
+    stats.maxMs = std::max(stats.maxMs, ms);
+}
+
+std::vector<QueryProfiler::Statistics> QueryProfiler::getStatistics()
+{
+    std::vector<Statistics> result;
+    {
+        AutoLock lock(mutex);
+        result.reserve(statistics.size());
+        for (auto&& [key, stats] : statistics)
+            result.push_back(stats);
+    }
+    std::sort(result.begin(), result.end(), [](auto&& a, auto&& b) { return a.totalMs > b.totalMs; });
+    return result;
+}
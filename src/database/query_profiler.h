@@ -0,0 +1,80 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    query_profiler.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file query_profiler.h
+#ifndef __QUERY_PROFILER_H__
+#define __QUERY_PROFILER_H__
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// \brief Duration and row count of the database queries, summed up per query fingerprint
+///
+/// The fingerprint replaces the literals of a query by ?, so queries differing only in ids or
+/// names count together. Queries taking at least the slow query time are logged in full.
+class QueryProfiler {
+public:
+    struct Statistics {
+        std::string fingerprint;
+        unsigned long count;
+        /// \brief queries that took at least the slow query time
+        unsigned long slow;
+        /// \brief rows returned by the selects
+        unsigned long long rows;
+        double totalMs;
+        double maxMs;
+    };
+
+    /// \param aggregate sum up the queries per fingerprint
+    /// \param slowTime log queries taking at least this long, 0 to log none
+    /// \param maxFingerprints queries of further fingerprints are not summed up
+    QueryProfiler(bool aggregate, std::chrono::milliseconds slowTime, std::size_t maxFingerprints = 1000);
+
+    /// \brief whether queries have to be timed at all
+    bool isEnabled() const { return aggregate || slowTime.count() > 0; }
+    bool isAggregating() const { return aggregate; }
+
+    /// \brief query with the literals replaced by ?, lists of literals collapsed and whitespace normalized
+    static std::string fingerprint(std::string_view query);
+
+    /// \param rows rows returned, -1 for statements without result
+    void record(std::string_view query, long long rows, std::chrono::steady_clock::duration duration);
+
+    /// \brief most expensive fingerprints first
+    std::vector<Statistics> getStatistics();
+
+private:
+    bool aggregate;
+    std::chrono::milliseconds slowTime;
+    std::size_t maxFingerprints;
+    std::map<std::string, Statistics> statistics;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+};
+
+#endif // __QUERY_PROFILER_H__
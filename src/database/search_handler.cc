@@ -63,6 +63,42 @@ static std::string aslowercase(const std::string& src)
     return copy;
 }
 
+/// \brief classes of the UPnP ContentDirectory specification, derivedfrom compares them case insensitive
+static const std::vector<std::string_view> upnpClasses {
+    "object",
+    "object.item",
+    "object.item.imageItem",
+    "object.item.imageItem.photo",
+    "object.item.audioItem",
+    "object.item.audioItem.musicTrack",
+    "object.item.audioItem.audioBroadcast",
+    "object.item.audioItem.audioBook",
+    "object.item.videoItem",
+    "object.item.videoItem.movie",
+    "object.item.videoItem.videoBroadcast",
+    "object.item.videoItem.musicVideoClip",
+    "object.item.playlistItem",
+    "object.item.textItem",
+    "object.item.bookmarkItem",
+    "object.item.epgItem",
+    "object.container",
+    "object.container.person",
+    "object.container.person.musicArtist",
+    "object.container.playlistContainer",
+    "object.container.album",
+    "object.container.album.musicAlbum",
+    "object.container.album.photoAlbum",
+    "object.container.genre",
+    "object.container.genre.musicGenre",
+    "object.container.genre.movieGenre",
+    "object.container.channelGroup",
+    "object.container.epgContainer",
+    "object.container.storageSystem",
+    "object.container.storageVolume",
+    "object.container.storageFolder",
+    "object.container.bookmarkFolder",
+};
+
 std::unique_ptr<SearchToken> SearchLexer::nextToken()
 {
     for (; currentPos < input.length();) {
@@ -183,6 +219,34 @@ std::shared_ptr<ASTNode> SearchParser::parse()
     return parseSearchExpression();
 }
 
+std::string SearchParser::normalizeCriteria(const std::string& searchCriteria)
+{
+    std::string result;
+    result.reserve(searchCriteria.length());
+    bool quoted = false;
+    bool escaping = false;
+    for (auto ch : searchCriteria) {
+        if (quoted) {
+            result.push_back(ch);
+            if (escaping)
+                escaping = false;
+            else if (ch == '\\')
+                escaping = true;
+            else if (ch == '"')
+                quoted = false;
+        } else if (std::isspace(static_cast<unsigned char>(ch))) {
+            if (!result.empty() && result.back() != ' ')
+                result.push_back(' ');
+        } else {
+            result.push_back(ch);
+            quoted = (ch == '"');
+        }
+    }
+    if (!result.empty() && result.back() == ' ')
+        result.pop_back();
+    return result;
+}
+
 std::shared_ptr<ASTNode> SearchParser::parseSearchExpression()
 {
     std::stack<std::shared_ptr<ASTNode>> nodeStack;
@@ -499,9 +563,14 @@ std::string DefaultSQLEmitter::emit(const ASTStringOperator* node, const std::st
                     << "like"
                     << " lower('" << value << "%') and c.upnp_class is not null)";
     } else if (lcOperator == "derivedfrom") {
-        sqlFragment << "c.upnp_class "
-                    << "like"
-                    << " lower('" << value << "%')";
+        // the class and all classes below it form one range of the index on upnp_class, '/' follows '.'
+        auto upnpClass = value;
+        auto lcClass = aslowercase(value);
+        auto known = std::find_if(upnpClasses.begin(), upnpClasses.end(), [&](auto&& cls) { return aslowercase(std::string(cls)) == lcClass; });
+        if (known != upnpClasses.end())
+            upnpClass = *known;
+        replaceAllString(upnpClass, "'", "''");
+        sqlFragment << "(c.upnp_class >= '" << upnpClass << "' and c.upnp_class < '" << upnpClass << "/')";
     }
     return sqlFragment.str();
 }
@@ -537,3 +606,71 @@ std::string DefaultSQLEmitter::emit(const ASTOrOperator* node, const std::string
     sqlFragment << lhs << " or " << rhs;
     return sqlFragment.str();
 }
+
+std::string FulltextSQLEmitter::emit(const ASTStringOperator* node, const std::string& property,
+    const std::string& value) const
+{
+    if (aslowercase(node->getValue()) != "contains")
+        return DefaultSQLEmitter::emit(node, property, value);
+
+    std::vector<std::string> words;
+    std::istringstream wordStream(value);
+    std::string word;
+    while (wordStream >> word)
+        words.push_back(word);
+    if (words.empty())
+        return DefaultSQLEmitter::emit(node, property, value);
+
+    std::ostringstream sqlFragment;
+    sqlFragment << "(m.property_name='" << property << "' and " << emitMatch(words) << " and c.upnp_class is not null)";
+    return sqlFragment.str();
+}
+
+std::string SqliteFulltextSQLEmitter::emitMatch(const std::vector<std::string>& words) const
+{
+    // every word as quoted prefix term, FTS5 combines them with AND
+    std::ostringstream match;
+    for (auto word : words) {
+        replaceAllString(word, "\"", "\"\"");
+        replaceAllString(word, "'", "''");
+        if (match.tellp() > 0)
+            match << ' ';
+        match << '"' << word << "\"*";
+    }
+    std::ostringstream sqlFragment;
+    sqlFragment << "m.id in (select rowid from grb_metadata_fts where grb_metadata_fts match '" << match.str() << "')";
+    return sqlFragment.str();
+}
+
+std::string MysqlFulltextSQLEmitter::emitMatch(const std::vector<std::string>& words) const
+{
+    // boolean mode: every word is required and matched as prefix, operators in the value are dropped
+    std::ostringstream match;
+    for (const auto& word : words) {
+        std::string term;
+        std::copy_if(word.begin(), word.end(), std::back_inserter(term), [](char c) {
+            return std::string("+-<>()~*\"@'\\").find(c) == std::string::npos;
+        });
+        if (term.empty())
+            continue;
+        if (match.tellp() > 0)
+            match << ' ';
+        match << '+' << term << '*';
+    }
+    std::ostringstream sqlFragment;
+    if (match.tellp() == 0) {
+        // nothing left to look up in the index, the words are matched literally
+        std::string pattern;
+        for (char c : join(words, " ")) {
+            if (c == '%' || c == '_' || c == '|')
+                pattern += '|';
+            else if (c == '\'' || c == '\\')
+                pattern += c;
+            pattern += c;
+        }
+        sqlFragment << "lower(m.property_value) like lower('%" << pattern << "%') escape '|'";
+        return sqlFragment.str();
+    }
+    sqlFragment << "match(m.property_value) against('" << match.str() << "' in boolean mode)";
+    return sqlFragment.str();
+}
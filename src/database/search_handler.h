@@ -376,6 +376,7 @@ public:
 };
 
 class DefaultSQLEmitter : public SQLEmitter {
+public:
     std::string emitSQL(const ASTNode* node) const override;
     std::string emit(const ASTAsterisk* node) const override { return "*"; }
     std::string emit(const ASTParenthesis* node, const std::string& bracketedNode) const override;
@@ -392,6 +393,32 @@ class DefaultSQLEmitter : public SQLEmitter {
     char tableQuote() const override { return '"'; }
 };
 
+/// \brief Emitter answering 'contains' from a full-text index on the metadata values instead of a LIKE scan
+///
+/// The words of the value are matched as word prefixes, all other operators are emitted like DefaultSQLEmitter does
+class FulltextSQLEmitter : public DefaultSQLEmitter {
+public:
+    using DefaultSQLEmitter::emit;
+    std::string emit(const ASTStringOperator* node,
+        const std::string& property, const std::string& value) const override;
+
+protected:
+    /// \brief predicate on m.property_value matching all words
+    virtual std::string emitMatch(const std::vector<std::string>& words) const = 0;
+};
+
+/// \brief Full-text search using the sqlite3 FTS5 table grb_metadata_fts
+class SqliteFulltextSQLEmitter : public FulltextSQLEmitter {
+protected:
+    std::string emitMatch(const std::vector<std::string>& words) const override;
+};
+
+/// \brief Full-text search using the FULLTEXT index of mt_metadata on MySQL
+class MysqlFulltextSQLEmitter : public FulltextSQLEmitter {
+protected:
+    std::string emitMatch(const std::vector<std::string>& words) const override;
+};
+
 class SearchParser {
 public:
     SearchParser(const SQLEmitter& sqlEmitter, const std::string& searchCriteria)
@@ -401,6 +428,9 @@ public:
     }
     std::shared_ptr<ASTNode> parse();
 
+    /// \brief criteria with runs of whitespace outside of quoted strings collapsed, equal criteria result in equal SQL
+    static std::string normalizeCriteria(const std::string& searchCriteria);
+
 protected:
     void getNextToken();
     std::shared_ptr<ASTNode> parseSearchExpression();
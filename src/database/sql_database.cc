@@ -32,12 +32,19 @@
 #include "sql_database.h" // API
 
 #include <algorithm>
+#include <array>
 #include <climits>
+#include <cstring>
+#include <ctime>
 #include <filesystem>
 #include <fmt/chrono.h>
+#include <fstream>
 #include <list>
+#include <optional>
+#include <set>
 #include <sstream>
 #include <string>
+#include <strings.h>
 #include <vector>
 
 #include "cds_objects.h"
@@ -47,9 +54,25 @@
 #include "search_handler.h"
 #include "util/string_converter.h"
 #include "util/tools.h"
+#include "util/trace.h"
 
 #define MAX_REMOVE_SIZE 1000
+#define MAX_INSERT_ROWS 500
+#define BROWSE_CURSOR_CACHE_SIZE 64
+#define SEARCH_COUNT_CACHE_SIZE 64
+#define SEARCH_QUERY_CACHE_SIZE 64
+#define OBJECT_CACHE_SIZE 1024
+#define UPDATE_ID_CACHE_SIZE 4096
+#define UPDATE_ID_FLUSH_SIZE 100
+#define CHANGE_LOG_PRUNE_INTERVAL 60000 // milliseconds
+// longest time an entry may commit after one with a higher number, later gaps are taken as rolled back
+#define CHANGE_LOG_GAP_WINDOW 120 // seconds
+#define CHANGE_LOG_MAX_GAPS 1000
 #define MAX_REMOVE_RECURSION 500
+#define DUMP_MAGIC "GRBDUMP"
+#define DUMP_VERSION 1
+#define DUMP_BUFFER_SIZE (1024 * 1024)
+#define DUMP_NULL 0xFFFFFFFFu
 
 #define SQL_NULL "NULL"
 
@@ -141,11 +164,50 @@ enum class MetadataCol {
 
 /* enum for createObjectFromRow's mode parameter */
 
+SQLTransaction::SQLTransaction(SQLDatabase* database, bool active)
+    : database(active ? database : nullptr)
+{
+    if (this->database != nullptr)
+        this->database->beginTransaction();
+}
+
+SQLTransaction::~SQLTransaction()
+{
+    try {
+        rollback();
+    } catch (const std::runtime_error& e) {
+        log_error("Rollback failed: {}", e.what());
+    }
+}
+
+void SQLTransaction::commit()
+{
+    // the driver has left the transaction even if the commit fails
+    if (auto db = std::exchange(database, nullptr))
+        db->commit();
+}
+
+void SQLTransaction::rollback()
+{
+    if (auto db = std::exchange(database, nullptr))
+        db->rollback();
+}
+
 SQLDatabase::SQLDatabase(std::shared_ptr<Config> config)
     : Database(std::move(config))
+    , objectCache(std::make_unique<ObjectCache>(OBJECT_CACHE_SIZE))
+    , queryProfiler(std::make_shared<QueryProfiler>(this->config->getBoolOption(CFG_SERVER_STORAGE_QUERY_PROFILE),
+          std::chrono::milliseconds(this->config->getIntOption(CFG_SERVER_STORAGE_SLOW_QUERY_TIME))))
 {
     table_quote_begin = '\0';
     table_quote_end = '\0';
+
+    auto role = this->config->getOption(CFG_SERVER_CLUSTER_ROLE);
+    if (role != "standalone") {
+        // each node has its own UDN, the role tells the scanner and the server process of one node apart
+        clusterNode = fmt::format("{}/{}", this->config->getOption(CFG_SERVER_UDN), role);
+        pruneChangeLog = role == "importer";
+    }
 }
 
 void SQLDatabase::init()
@@ -160,11 +222,101 @@ void SQLDatabase::init()
     sqlEmitter = std::make_shared<DefaultSQLEmitter>();
 }
 
+void SQLDatabase::initFulltextSearch()
+{
+    if (!config->getBoolOption(CFG_SERVER_STORAGE_FULLTEXT_SEARCH))
+        return;
+
+    try {
+        auto emitter = prepareFulltextSearch();
+        if (emitter != nullptr) {
+            sqlEmitter = emitter;
+            log_info("Full-text search index enabled");
+        } else {
+            log_warning("Full-text search is not supported by the database driver");
+        }
+    } catch (const std::runtime_error& e) {
+        log_warning("Full-text search index not available, searching without it: {}", e.what());
+    }
+}
+
+void SQLDatabase::migrateLocationHashes()
+{
+    std::ostringstream qb;
+    qb << "SELECT " << TQ("id") << ',' << TQ("location")
+       << " FROM " << TQ(CDS_OBJECT_TABLE)
+       << " WHERE " << TQ("location_hash") << "=-1";
+    auto res = select(qb);
+    if (res == nullptr)
+        throw_std_runtime_error("db error");
+
+    std::vector<std::pair<int, std::int64_t>> hashes;
+    std::unique_ptr<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr) {
+        hashes.emplace_back(std::stoi(row->col(0)), stringHash(row->col(1)));
+    }
+    if (hashes.empty())
+        return;
+
+    log_info("Updating the location hashes of {} objects...", hashes.size());
+    SQLTransaction transaction(this);
+    for (std::size_t offset = 0; offset < hashes.size(); offset += MAX_INSERT_ROWS) {
+        auto last = std::min(hashes.size(), offset + MAX_INSERT_ROWS);
+        std::ostringstream bufUpdate;
+        bufUpdate << "UPDATE " << TQ(CDS_OBJECT_TABLE) << " SET " << TQ("location_hash") << " = CASE " << TQ("id");
+        for (auto i = offset; i < last; i++)
+            bufUpdate << " WHEN " << hashes[i].first << " THEN " << hashes[i].second;
+        bufUpdate << " ELSE " << TQ("location_hash") << " END WHERE " << TQ("id") << " IN (";
+        for (auto i = offset; i < last; i++)
+            bufUpdate << (i == offset ? "" : ",") << hashes[i].first;
+        bufUpdate << ')';
+        exec(bufUpdate.str());
+    }
+    transaction.commit();
+}
+
 void SQLDatabase::shutdown()
 {
+    log_debug("Object cache: {} hits, {} misses", objectCache->getHits(), objectCache->getMisses());
+    {
+        AutoLock lock(updateIDMutex);
+        flushUpdateIDs(true);
+    }
     shutdownDriver();
 }
 
+void SQLDatabase::warmUpIndexes()
+{
+    for (auto&& query : getWarmUpQueries()) {
+        auto res = select(query.c_str(), query.size());
+        if (res != nullptr)
+            res->nextRow();
+    }
+}
+
+void SQLDatabase::runMaintenance()
+{
+    auto start = std::chrono::steady_clock::now();
+    std::string result;
+    try {
+        result = maintain();
+        log_info("Database maintenance: {}", result);
+    } catch (const std::runtime_error& e) {
+        result = fmt::format("failed: {}", e.what());
+        log_warning("Database maintenance {}", result);
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    AutoLock lock(maintenanceMutex);
+    maintenanceStatus = fmt::format("{:%Y-%m-%d %H:%M:%S}: {} ({} ms)", fmt::localtime(std::time(nullptr)), result, duration.count());
+}
+
+std::string SQLDatabase::getMaintenanceStatus()
+{
+    AutoLock lock(maintenanceMutex);
+    return maintenanceStatus;
+}
+
 std::shared_ptr<CdsObject> SQLDatabase::checkRefID(const std::shared_ptr<CdsObject>& obj)
 {
     if (!obj->isVirtual())
@@ -193,7 +345,7 @@ std::shared_ptr<CdsObject> SQLDatabase::checkRefID(const std::shared_ptr<CdsObje
     return findObjectByPath(location);
 }
 
-std::vector<std::shared_ptr<SQLDatabase::AddUpdateTable>> SQLDatabase::_addUpdateObject(const std::shared_ptr<CdsObject>& obj, Operation op, int* changedContainer)
+std::vector<std::shared_ptr<SQLDatabase::AddUpdateTable>> SQLDatabase::_addUpdateObject(const std::shared_ptr<CdsObject>& obj, Operation op, int* changedContainer, LibraryKey* libraryKey)
 {
     std::shared_ptr<CdsObject> refObj = nullptr;
     bool hasReference = false;
@@ -245,7 +397,7 @@ std::vector<std::shared_ptr<SQLDatabase::AddUpdateTable>> SQLDatabase::_addUpdat
     if (op == Operation::Update)
         cdsObjectSql["auxdata"] = SQL_NULL;
     if (auto auxData = obj->getAuxData(); !auxData.empty() && (!hasReference || auxData != refObj->getAuxData())) {
-        cdsObjectSql["auxdata"] = quote(dictEncode(auxData));
+        cdsObjectSql["auxdata"] = quote(dictEncodeCompact(auxData));
     }
 
     if (!hasReference || (!obj->getFlag(OBJECT_FLAG_USE_RESOURCE_REF) && !refObj->resourcesEqual(obj))) {
@@ -332,6 +484,14 @@ std::vector<std::shared_ptr<SQLDatabase::AddUpdateTable>> SQLDatabase::_addUpdat
         }
 
         cdsObjectSql["mime_type"] = quote(item->getMimeType());
+
+        if (libraryKey != nullptr) {
+            // referencing items have neither location nor class of their own
+            char locationPrefix = '\0';
+            if (!hasReference)
+                locationPrefix = obj->isPureItem() ? LOC_FILE_PREFIX : item->getLocation().native().front();
+            *libraryKey = { locationPrefix, item->getMimeType(), !hasReference || refObj->getClass() != obj->getClass() ? obj->getClass() : "" };
+        }
     }
 
     std::vector<std::shared_ptr<SQLDatabase::AddUpdateTable>> returnVal;
@@ -374,10 +534,9 @@ void SQLDatabase::addObject(std::shared_ptr<CdsObject> obj, int* changedContaine
     if (obj->getID() != INVALID_OBJECT_ID)
         throw_std_runtime_error("Tried to add an object with an object ID set");
 
-    std::vector<std::shared_ptr<SQLDatabase::AddUpdateTable>> tables = _addUpdateObject(obj, Operation::Insert, changedContainer);
-    bool withTrans = tables.size() > 1;
-    if (withTrans)
-        beginTransaction();
+    LibraryKey libraryKey;
+    std::vector<std::shared_ptr<SQLDatabase::AddUpdateTable>> tables = _addUpdateObject(obj, Operation::Insert, changedContainer, &libraryKey);
+    SQLTransaction transaction(this, tables.size() > 1);
     for (const auto& addUpdateTable : tables) {
         auto qb = sqlForInsert(obj, addUpdateTable);
         log_debug("Generated insert: {}", qb->str().c_str());
@@ -385,17 +544,123 @@ void SQLDatabase::addObject(std::shared_ptr<CdsObject> obj, int* changedContaine
         if (addUpdateTable->getTableName() == CDS_OBJECT_TABLE) {
             int newId = exec(qb->str(), true);
             obj->setID(newId);
+            _changeChildCount(obj->getParentID(), 1);
         } else {
             exec(qb->str(), false);
         }
     }
-    if (withTrans)
-        commit();
+    transaction.commit();
+    if (!tables.empty() && obj->isItem())
+        changeLibraryStats({ libraryKey }, 1);
 }
 
-void SQLDatabase::updateObject(std::shared_ptr<CdsObject> obj, int* changedContainer)
+void SQLDatabase::addObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, int* changedContainer)
+{
+    if (objects.empty())
+        return;
+
+    std::ostringstream metadataInsert;
+    std::size_t metadataRows = 0;
+    auto flushMetadata = [&]() {
+        if (metadataRows > 0) {
+            exec(metadataInsert.str());
+            metadataInsert.str("");
+            metadataRows = 0;
+        }
+    };
+    // collect metadata of all objects into multi-row inserts
+    auto addMetadata = [&](const std::shared_ptr<CdsObject>& obj, const std::shared_ptr<AddUpdateTable>& addUpdateTable) {
+        auto dict = addUpdateTable->getDict();
+        if (metadataRows == 0) {
+            metadataInsert << "INSERT INTO " << TQ(METADATA_TABLE)
+                           << " (" << TQ("item_id") << ',' << TQ("property_name") << ',' << TQ("property_value") << ") VALUES ";
+        } else {
+            metadataInsert << ',';
+        }
+        metadataInsert << '(' << obj->getID() << ',' << dict["property_name"] << ',' << dict["property_value"] << ')';
+        if (isInsertFull(++metadataRows, metadataInsert.tellp()))
+            flushMetadata();
+    };
+
+    // object rows waiting for their ids, one multi-row insert per set of columns
+    struct PendingObjects {
+        std::ostringstream values;
+        std::vector<std::pair<std::shared_ptr<CdsObject>, std::vector<std::shared_ptr<AddUpdateTable>>>> objects;
+    };
+    std::map<std::string, PendingObjects> pendingObjects;
+    auto flushObjects = [&](const std::string& columns, PendingObjects& pending) {
+        if (pending.objects.empty())
+            return;
+        std::ostringstream insert;
+        insert << "INSERT INTO " << TQ(CDS_OBJECT_TABLE) << " (" << columns << ") VALUES " << pending.values.str();
+        int objectID = exec(insert.str(), true);
+        for (auto&& [obj, metadata] : pending.objects) {
+            obj->setID(objectID++);
+            _changeChildCount(obj->getParentID(), 1);
+            for (auto&& addUpdateTable : metadata)
+                addMetadata(obj, addUpdateTable);
+        }
+        pending.values.str("");
+        pending.objects.clear();
+    };
+    bool multiRowObjects = hasConsecutiveInsertIds();
+
+    std::vector<LibraryKey> libraryKeys;
+    SQLTransaction transaction(this);
+    try {
+        for (const auto& obj : objects) {
+            if (obj->getID() != INVALID_OBJECT_ID)
+                throw_std_runtime_error("Tried to add an object with an object ID set");
+
+            LibraryKey libraryKey;
+            auto tables = _addUpdateObject(obj, Operation::Insert, changedContainer, &libraryKey);
+            auto objectTable = std::find_if(tables.begin(), tables.end(), [](auto&& table) { return table->getTableName() == CDS_OBJECT_TABLE; });
+            if (objectTable == tables.end())
+                continue;
+            if (obj->isItem())
+                libraryKeys.push_back(libraryKey);
+
+            auto addUpdateTable = *objectTable;
+            tables.erase(objectTable);
+            if (!multiRowObjects) {
+                auto qb = sqlForInsert(obj, addUpdateTable);
+                obj->setID(exec(qb->str(), true));
+                _changeChildCount(obj->getParentID(), 1);
+                for (auto&& metadata : tables)
+                    addMetadata(obj, metadata);
+                continue;
+            }
+
+            std::ostringstream columns;
+            std::ostringstream values;
+            for (auto&& [column, value] : addUpdateTable->getDict()) {
+                columns << (columns.tellp() == 0 ? "" : ",") << TQ(column);
+                values << (values.tellp() == 0 ? "(" : ",") << value;
+            }
+            values << ')';
+            auto&& pending = pendingObjects[columns.str()];
+            pending.values << (pending.objects.empty() ? "" : ",") << values.str();
+            pending.objects.emplace_back(obj, std::move(tables));
+            if (isInsertFull(pending.objects.size(), pending.values.tellp()))
+                flushObjects(columns.str(), pending);
+        }
+        for (auto&& [columns, pending] : pendingObjects)
+            flushObjects(columns, pending);
+        flushMetadata();
+    } catch (const std::runtime_error& e) {
+        transaction.rollback();
+        // containers created for the rolled back objects are gone again
+        clearContainerPaths();
+        throw;
+    }
+    transaction.commit();
+    changeLibraryStats(libraryKeys, 1);
+}
+
+bool SQLDatabase::updateObject(std::shared_ptr<CdsObject> obj, int* changedContainer)
 {
     std::vector<std::shared_ptr<AddUpdateTable>> data;
+    LibraryKey libraryKey;
     if (obj->getID() == CDS_ID_FS_ROOT) {
         std::map<std::string, std::string> cdsObjectSql;
 
@@ -407,12 +672,53 @@ void SQLDatabase::updateObject(std::shared_ptr<CdsObject> obj, int* changedConta
     } else {
         if (IS_FORBIDDEN_CDS_ID(obj->getID()))
             throw_std_runtime_error("Tried to update an object with a forbidden ID ({})", obj->getID());
-        data = _addUpdateObject(obj, Operation::Update, changedContainer);
+        data = _addUpdateObject(obj, Operation::Update, changedContainer, &libraryKey);
+    }
+
+    int oldParentID = INVALID_OBJECT_ID;
+    std::vector<LibraryKey> oldLibraryKey;
+    if (obj->getID() != CDS_ID_FS_ROOT) {
+        // the stored values of the columns to write, only those that differ are written
+        auto objectTable = std::find_if(data.begin(), data.end(), [](auto&& table) { return table->getTableName() == CDS_OBJECT_TABLE; });
+        std::map<std::string, std::string> dict;
+        if (objectTable != data.end())
+            dict = (*objectTable)->getDict();
+
+        std::ostringstream qb;
+        qb << "SELECT " << TQ("parent_id") << ',' << TQ("object_type") << ",SUBSTR(" << TQ("location") << ",1,1)," << TQ("mime_type") << ',' << TQ("upnp_class");
+        for (auto&& [column, value] : dict)
+            qb << ',' << TQ(column);
+        qb << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE " << TQ("id") << "=?";
+        auto res = selectPrepared(qb.str(), { obj->getID() });
+        std::unique_ptr<SQLRow> row;
+        if (res != nullptr && (row = res->nextRow()) != nullptr) {
+            oldParentID = std::stoi(row->col(0));
+            if (std::stoi(row->col(1)) != OBJECT_TYPE_CONTAINER)
+                oldLibraryKey.emplace_back(row->col(2).empty() ? '\0' : row->col(2).front(), row->col(3), row->col(4));
+
+            if (objectTable != data.end()) {
+                std::map<std::string, std::string> changed;
+                int index = 5;
+                for (auto&& [column, value] : dict) {
+                    const char* stored = row->col_c_str(index++);
+                    // numbers are written without quotes
+                    bool same = stored == nullptr ? value == SQL_NULL : value != SQL_NULL && (value == stored || value == quote(std::string(stored)));
+                    if (!same)
+                        changed.emplace(column, value);
+                }
+                if (changed.empty())
+                    data.erase(objectTable);
+                else
+                    *objectTable = std::make_shared<AddUpdateTable>(CDS_OBJECT_TABLE, changed, Operation::Update);
+            }
+        }
+    }
+    if (data.empty()) {
+        log_debug("Object {} is unchanged", obj->getID());
+        return false;
     }
 
-    bool withTrans = data.size() > 1;
-    if (withTrans)
-        beginTransaction();
+    SQLTransaction transaction(this, data.size() > 1);
     for (const auto& addUpdateTable : data) {
         Operation op = addUpdateTable->getOperation();
         std::unique_ptr<std::ostringstream> qb;
@@ -432,21 +738,42 @@ void SQLDatabase::updateObject(std::shared_ptr<CdsObject> obj, int* changedConta
         log_debug("upd_query: {}", qb->str());
         exec(qb->str());
     }
-    if (withTrans)
-        commit();
+    if (oldParentID != INVALID_OBJECT_ID && oldParentID != obj->getParentID()) {
+        _changeChildCount(oldParentID, -1);
+        _changeChildCount(obj->getParentID(), 1);
+    }
+    transaction.commit();
+    changeLibraryStats(oldLibraryKey, -1);
+    if (obj->isItem() && obj->getID() != CDS_ID_FS_ROOT)
+        changeLibraryStats({ libraryKey }, 1);
+    objectCache->erase({ obj->getID() });
+    // virtual containers get a new location above
+    if (obj->isContainer() && obj->isVirtual())
+        removeContainerPaths({ obj->getID() });
+    // the sort key of the object may have changed
+    clearResultCaches();
+    return true;
 }
 
 std::shared_ptr<CdsObject> SQLDatabase::loadObject(int objectID)
 {
+    TraceSpan span("db.loadObject");
     std::ostringstream qb;
     //log_debug("sql_query = {}",sql_query.c_str());
 
-    qb << sql_query << " WHERE " << TQD('f', "id") << '=' << objectID;
+    auto obj = objectCache->get(objectID);
+    if (obj != nullptr)
+        return obj;
+    auto generation = objectCache->getGeneration();
 
-    auto res = select(qb);
+    qb << sql_query << " WHERE " << TQD('f', "id") << "=?";
+
+    auto res = selectPrepared(qb.str(), { objectID });
     std::unique_ptr<SQLRow> row;
     if (res != nullptr && (row = res->nextRow()) != nullptr) {
-        return createObjectFromRow(row);
+        obj = createObjectFromRow(row);
+        objectCache->put(obj, generation);
+        return obj;
     }
     throw ObjectNotFoundException(fmt::format("Object not found: {}", objectID));
 }
@@ -464,30 +791,72 @@ std::shared_ptr<CdsObject> SQLDatabase::loadObjectByServiceID(const std::string&
     return nullptr;
 }
 
-std::unique_ptr<std::vector<int>> SQLDatabase::getServiceObjectIDs(char servicePrefix)
+std::map<std::string, Database::ServiceObject> SQLDatabase::getServiceObjects(char servicePrefix)
 {
-    auto objectIDs = std::make_unique<std::vector<int>>();
+    std::map<std::string, ServiceObject> objects;
 
     std::ostringstream qb;
-    qb << "SELECT " << TQ("id")
+    qb << "SELECT " << TQ("id") << ',' << TQ("service_id") << ',' << TQ("auxdata")
        << " FROM " << TQ(CDS_OBJECT_TABLE)
        << " WHERE " << TQ("service_id")
        << " LIKE " << quote(std::string(1, servicePrefix) + '%');
 
-    auto res = select(qb);
+    auto res = selectStreaming(qb.str());
     if (res == nullptr)
         throw_std_runtime_error("db error");
 
     std::unique_ptr<SQLRow> row;
     while ((row = res->nextRow()) != nullptr) {
-        objectIDs->push_back(std::stoi(row->col(0)));
+        auto& object = objects[row->col(1)];
+        object.objectID = std::stoi(row->col(0));
+        dictDecode(row->col(2), &object.auxData);
     }
 
-    return objectIDs;
+    return objects;
+}
+
+void SQLDatabase::storeScrobbles(const std::vector<Scrobble>& scrobbles)
+{
+    if (scrobbles.empty())
+        return;
+
+    std::ostringstream ins;
+    ins << "INSERT INTO " << TQ(SCROBBLE_TABLE)
+        << " (" << TQ("artist") << ',' << TQ("title") << ',' << TQ("album") << ',' << TQ("track_number") << ',' << TQ("length") << ',' << TQ("started") << ") VALUES ";
+    bool first = true;
+    for (auto&& scrobble : scrobbles) {
+        if (!first)
+            ins << ',';
+        first = false;
+        ins << '(' << quote(scrobble.artist) << ',' << quote(scrobble.title) << ',' << quote(scrobble.album)
+            << ',' << scrobble.trackNumber << ',' << scrobble.length << ',' << scrobble.started << ')';
+    }
+    exec(ins.str());
+}
+
+std::vector<Database::Scrobble> SQLDatabase::takeScrobbles()
+{
+    std::vector<Scrobble> scrobbles;
+
+    std::ostringstream q;
+    q << "SELECT " << TQ("artist") << ',' << TQ("title") << ',' << TQ("album") << ',' << TQ("track_number") << ',' << TQ("length") << ',' << TQ("started")
+      << " FROM " << TQ(SCROBBLE_TABLE) << " ORDER BY " << TQ("id");
+    auto res = select(q);
+    std::unique_ptr<SQLRow> row;
+    while (res != nullptr && (row = res->nextRow()) != nullptr)
+        scrobbles.push_back(Scrobble { row->col(0), row->col(1), row->col(2), std::stoi(row->col(3)), std::stoi(row->col(4)), std::stoll(row->col(5)) });
+
+    if (!scrobbles.empty()) {
+        std::ostringstream del;
+        del << "DELETE FROM " << TQ(SCROBBLE_TABLE);
+        exec(del.str());
+    }
+    return scrobbles;
 }
 
 std::vector<std::shared_ptr<CdsObject>> SQLDatabase::browse(const std::unique_ptr<BrowseParam>& param)
 {
+    TraceSpan span("db.browse");
     int objectID;
     int objectType = 0;
 
@@ -502,8 +871,8 @@ std::vector<std::shared_ptr<CdsObject>> SQLDatabase::browse(const std::unique_pt
     std::ostringstream qb;
     qb << "SELECT " << TQ("object_type")
        << " FROM " << TQ(CDS_OBJECT_TABLE)
-       << " WHERE " << TQ("id") << '=' << objectID;
-    res = select(qb);
+       << " WHERE " << TQ("id") << "=?";
+    res = selectPrepared(qb.str(), { objectID });
     if (res != nullptr && (row = res->nextRow()) != nullptr) {
         objectType = std::stoi(row->col(0));
     } else {
@@ -521,22 +890,86 @@ std::vector<std::shared_ptr<CdsObject>> SQLDatabase::browse(const std::unique_pt
         param->setTotalMatches(1);
     }
 
-    // order by code..
-    auto orderByCode = [&]() {
-        std::ostringstream qb;
+    // sort keys, the id makes the order unique so a following page can seek past the last row
+    // metadata keys are not part of the row (col -1), pages sorted by them are skipped by offset
+    struct SortKey {
+        std::string expr;
+        bool desc;
+        int col;
+        bool numeric;
+    };
+    std::vector<SortKey> sortKeys;
+    auto field = [&](const char* name) {
+        std::ostringstream f;
+        f << TQD('f', name);
+        return f.str();
+    };
+    const auto& sortCriteria = param->getSortCriteria();
+    if (sortCriteria.empty()) {
+        if (getContainers && getItems) {
+            std::ostringstream isContainer;
+            isContainer << '(' << TQD('f', "object_type") << '=' << quote(OBJECT_TYPE_CONTAINER) << ')';
+            sortKeys.push_back({ isContainer.str(), true, _object_type, true });
+        }
         if (param->getFlag(BROWSE_TRACK_SORT)) {
-            qb << TQD('f', "part_number") << ',';
-            qb << TQD('f', "track_number") << ',';
+            sortKeys.push_back({ field("part_number"), false, _part_number, true });
+            sortKeys.push_back({ field("track_number"), false, _track_number, true });
         }
-        qb << TQD('f', "dc_title");
-        return qb.str();
+    }
+    bool sortedByTitle = false;
+    std::string sortString;
+    for (const auto& criterion : sortCriteria) {
+        sortString.append(criterion.descending ? "-" : "+").append(criterion.property).append(",");
+        if (criterion.property == "dc:title") {
+            sortKeys.push_back({ field("dc_title"), criterion.descending, _dc_title, false });
+            sortedByTitle = true;
+        } else if (criterion.property == "upnp:class") {
+            sortKeys.push_back({ field("upnp_class"), criterion.descending, _upnp_class, false });
+        } else if (criterion.property == "upnp:originalTrackNumber") {
+            sortKeys.push_back({ field("track_number"), criterion.descending, _track_number, true });
+        } else {
+            // the value of the object itself or of the referenced original
+            auto property = quote(criterion.property);
+            auto metadataValue = [&](const char* idColumn) {
+                std::ostringstream value;
+                value << "(SELECT " << TQD('m', "property_value") << " FROM " << TQ(METADATA_TABLE) << ' ' << TQ('m')
+                      << " WHERE " << TQD('m', "item_id") << '=' << TQD('f', idColumn)
+                      << " AND " << TQD('m', "property_name") << '=' << property << " LIMIT 1)";
+                return value.str();
+            };
+            sortKeys.push_back({ fmt::format("COALESCE({},{})", metadataValue("id"), metadataValue("ref_id")), criterion.descending, -1, false });
+        }
+    }
+    if (!sortedByTitle)
+        sortKeys.push_back({ field("dc_title"), false, _dc_title, false });
+    sortKeys.push_back({ field("id"), false, _id, true });
+    bool seekable = std::all_of(sortKeys.begin(), sortKeys.end(), [](const SortKey& key) { return key.col >= 0; });
+
+    auto sortKeyValues = [&](const std::unique_ptr<SQLRow>& sortRow) {
+        std::vector<SQLParam> values;
+        for (const auto& key : sortKeys) {
+            const char* value = sortRow->col_c_str(key.col);
+            if (value == nullptr)
+                values.emplace_back(std::monostate());
+            else if (key.col == _object_type)
+                values.emplace_back(std::stoi(value) == OBJECT_TYPE_CONTAINER ? 1 : 0);
+            else if (key.numeric)
+                values.emplace_back(std::stoi(value));
+            else
+                values.emplace_back(std::string(value));
+        }
+        return values;
     };
 
+    std::vector<SQLParam> params;
     qb.str("");
     qb << sql_query << " WHERE ";
 
+    bool storeCursor = false;
+    int count = 0;
+    BrowseCursorKey cursorKey;
     if (param->getFlag(BROWSE_DIRECT_CHILDREN) && IS_CDS_CONTAINER(objectType)) {
-        int count = param->getRequestedCount();
+        count = param->getRequestedCount();
         bool doLimit = true;
         if (!count) {
             if (param->getStartingIndex())
@@ -545,7 +978,8 @@ std::vector<std::shared_ptr<CdsObject>> SQLDatabase::browse(const std::unique_pt
                 doLimit = false;
         }
 
-        qb << TQD('f', "parent_id") << '=' << objectID;
+        qb << TQD('f', "parent_id") << "=?";
+        params.emplace_back(objectID);
 
         if (objectID == CDS_ID_ROOT && hideFsRoot)
             qb << " AND " << TQD('f', "id") << "!="
@@ -555,64 +989,170 @@ std::vector<std::shared_ptr<CdsObject>> SQLDatabase::browse(const std::unique_pt
             qb << " AND 0=1";
         } else if (getContainers && !getItems) {
             qb << " AND " << TQD('f', "object_type") << '='
-               << quote(OBJECT_TYPE_CONTAINER)
-               << " ORDER BY " << orderByCode();
+               << quote(OBJECT_TYPE_CONTAINER);
         } else if (!getContainers && getItems) {
             qb << " AND (" << TQD('f', "object_type") << " & "
                << quote(OBJECT_TYPE_ITEM) << ") = "
-               << quote(OBJECT_TYPE_ITEM)
-               << " ORDER BY " << orderByCode();
-        } else {
-            qb << " ORDER BY ("
-               << TQD('f', "object_type") << '=' << quote(OBJECT_TYPE_CONTAINER)
-               << ") DESC, " << orderByCode();
+               << quote(OBJECT_TYPE_ITEM);
+        }
+
+        // continue behind the last row of the previous page instead of skipping StartingIndex rows
+        std::vector<SQLParam> seekKey;
+        if (param->getStartingIndex() > 0 && seekable && (getContainers || getItems)) {
+            AutoLock lock(browseCursorMutex);
+            auto cursor = browseCursors.find({ objectID, param->getFlags(), param->getStartingIndex(), sortString });
+            if (cursor != browseCursors.end()) {
+                seekKey = std::move(cursor->second);
+                browseCursors.erase(cursor);
+            }
+        }
+        if (!seekKey.empty()) {
+            // (k1 > v1 OR (k1 = v1 AND (k2 > v2 OR ...))), NULL sorts first ascending and last descending
+            qb << " AND ";
+            for (std::size_t i = 0; i < sortKeys.size(); i++) {
+                const auto& key = sortKeys.at(i);
+                bool isNull = std::holds_alternative<std::monostate>(seekKey.at(i));
+                bool isLast = i + 1 == sortKeys.size();
+                qb << '(';
+                if (isNull && key.desc) {
+                    // nothing follows the NULLs
+                    qb << "0=1";
+                } else if (isNull) {
+                    qb << key.expr << " IS NOT NULL";
+                } else if (key.desc) {
+                    qb << key.expr << " < ? OR " << key.expr << " IS NULL";
+                    params.push_back(seekKey.at(i));
+                } else {
+                    qb << key.expr << " > ?";
+                    params.push_back(seekKey.at(i));
+                }
+                if (isLast)
+                    break;
+                qb << " OR (" << key.expr;
+                if (isNull) {
+                    qb << " IS NULL";
+                } else {
+                    qb << " = ?";
+                    params.push_back(seekKey.at(i));
+                }
+                qb << " AND ";
+            }
+            for (std::size_t i = 1; i < sortKeys.size(); i++)
+                qb << "))";
+            qb << ')';
+        }
+
+        if (getContainers || getItems) {
+            qb << " ORDER BY ";
+            for (const auto& key : sortKeys) {
+                if (&key != &sortKeys.front())
+                    qb << ',';
+                qb << key.expr << (key.desc ? " DESC" : "");
+            }
+        }
+        if (doLimit) {
+            params.emplace_back(count);
+            if (seekKey.empty()) {
+                qb << " LIMIT ? OFFSET ?";
+                params.emplace_back(param->getStartingIndex());
+            } else {
+                qb << " LIMIT ?";
+            }
+            storeCursor = count != std::numeric_limits<int>::max() && seekable && (getContainers || getItems);
+            cursorKey = { objectID, param->getFlags(), param->getStartingIndex() + count, sortString };
         }
-        if (doLimit)
-            qb << " LIMIT " << count << " OFFSET " << param->getStartingIndex();
     } else // metadata
     {
-        qb << TQD('f', "id") << '=' << objectID << " LIMIT 1";
+        qb << TQD('f', "id") << "=? LIMIT 1";
+        params.emplace_back(objectID);
     }
     log_debug("QUERY: {}", qb.str().c_str());
-    res = select(qb);
+    res = selectPrepared(qb.str(), params);
 
     std::vector<std::shared_ptr<CdsObject>> arr;
 
+    // fetch the metadata of the whole page, including that of referenced objects, with one query
+    std::vector<std::unique_ptr<SQLRow>> rows;
+    std::vector<int> metadataIds;
     while ((row = res->nextRow()) != nullptr) {
-        auto obj = createObjectFromRow(row);
+        metadataIds.push_back(std::stoi(row->col(_id)));
+        int refId = stoiString(row->col(_ref_id));
+        if (refId != CDS_ID_ROOT)
+            metadataIds.push_back(refId);
+        rows.push_back(std::move(row));
+    }
+    unsigned int projection = param->getFlag(BROWSE_BASIC_PROPERTIES);
+    MetadataMap metadata;
+    if (!(projection & BROWSE_NO_METADATA))
+        metadata = retrieveMetadataForObjects(metadataIds);
+
+    std::vector<SQLParam> lastKey;
+    for (const auto& pageRow : rows) {
+        auto obj = createObjectFromRow(pageRow, &metadata, projection);
         arr.push_back(obj);
-        row = nullptr;
+        if (storeCursor && static_cast<int>(arr.size()) == count)
+            lastKey = sortKeyValues(pageRow);
+    }
+    rows.clear();
+
+    // a full page was returned, remember where it ended for the request of the next page
+    if (!lastKey.empty()) {
+        AutoLock lock(browseCursorMutex);
+        if (browseCursors.size() >= BROWSE_CURSOR_CACHE_SIZE)
+            browseCursors.clear();
+        browseCursors[cursorKey] = std::move(lastKey);
     }
 
     row = nullptr;
     res = nullptr;
 
-    // update childCount fields
+    // update childCount fields with one query for the whole page
+    std::vector<int> containerIds;
     for (const auto& obj : arr) {
-        if (obj->isContainer()) {
-            auto cont = std::static_pointer_cast<CdsContainer>(obj);
-            cont->setChildCount(getChildCount(cont->getID(), getContainers, getItems, hideFsRoot));
+        if (obj->isContainer())
+            containerIds.push_back(obj->getID());
+    }
+    if (!containerIds.empty()) {
+        auto childCounts = getChildCounts(containerIds, getContainers, getItems, hideFsRoot);
+        for (const auto& obj : arr) {
+            if (obj->isContainer()) {
+                auto cont = std::static_pointer_cast<CdsContainer>(obj);
+                auto count = childCounts.find(cont->getID());
+                cont->setChildCount(count != childCounts.end() ? count->second : 0);
+            }
         }
     }
 
     return arr;
 }
 
-std::vector<std::shared_ptr<CdsObject>> SQLDatabase::search(const std::unique_ptr<SearchParam>& param, int* numMatches)
+std::string SQLDatabase::getSearchSQL(const std::string& searchCriteria)
 {
-    std::unique_ptr<SearchParser> searchParser = std::make_unique<SearchParser>(*sqlEmitter, param->searchCriteria());
+    auto criteria = SearchParser::normalizeCriteria(searchCriteria);
+    {
+        AutoLock lock(searchQueryMutex);
+        auto query = searchQueries.find(criteria);
+        if (query != searchQueries.end())
+            return query->second;
+    }
+
+    auto searchParser = std::make_unique<SearchParser>(*sqlEmitter, criteria);
     std::shared_ptr<ASTNode> rootNode = searchParser->parse();
     std::string searchSQL(rootNode->emitSQL());
     if (!searchSQL.length())
         throw_std_runtime_error("failed to generate SQL for search");
 
-    std::ostringstream countSQL;
-    countSQL << "select count(*) " << searchSQL;
-    auto sqlResult = select(countSQL);
-    std::unique_ptr<SQLRow> countRow = sqlResult->nextRow();
-    if (countRow != nullptr) {
-        *numMatches = std::stoi(countRow->col(0));
-    }
+    AutoLock lock(searchQueryMutex);
+    if (searchQueries.size() >= SEARCH_QUERY_CACHE_SIZE)
+        searchQueries.clear();
+    searchQueries[criteria] = searchSQL;
+    return searchSQL;
+}
+
+std::vector<std::shared_ptr<CdsObject>> SQLDatabase::search(const std::unique_ptr<SearchParam>& param, int* numMatches)
+{
+    TraceSpan span("db.search");
+    std::string searchSQL = getSearchSQL(param->searchCriteria());
 
     std::ostringstream retrievalSQL;
     retrievalSQL << SELECT_DATA_FOR_SEARCH << " " << searchSQL;
@@ -624,30 +1164,77 @@ std::vector<std::shared_ptr<CdsObject>> SQLDatabase::search(const std::unique_pt
     }
 
     log_debug("Search resolves to SQL [{}]", retrievalSQL.str().c_str());
-    sqlResult = select(retrievalSQL);
+    auto sqlResult = select(retrievalSQL);
 
     std::vector<std::shared_ptr<CdsObject>> arr;
 
+    std::vector<std::unique_ptr<SQLRow>> rows;
+    std::vector<int> metadataIds;
     std::unique_ptr<SQLRow> sqlRow;
     while ((sqlRow = sqlResult->nextRow()) != nullptr) {
-        auto obj = createObjectFromSearchRow(sqlRow);
+        metadataIds.push_back(std::stoi(sqlRow->col(to_underlying(SearchCol::id))));
+        rows.push_back(std::move(sqlRow));
+    }
+    auto metadata = retrieveMetadataForObjects(metadataIds);
+
+    for (const auto& searchRow : rows) {
+        auto obj = createObjectFromSearchRow(searchRow, &metadata);
         arr.push_back(obj);
-        sqlRow = nullptr;
     }
+    rows.clear();
     sqlRow = nullptr;
     sqlResult = nullptr;
 
+    // the total is known without counting if the result ended on this page
+    int pageSize = arr.size();
+    if ((requestedCount == 0 || pageSize < requestedCount) && (pageSize > 0 || startingIndex == 0)) {
+        *numMatches = startingIndex + pageSize;
+        return arr;
+    }
+
+    {
+        AutoLock lock(searchCountMutex);
+        auto count = searchCounts.find(searchSQL);
+        if (count != searchCounts.end()) {
+            *numMatches = count->second;
+            return arr;
+        }
+    }
+
+    std::ostringstream countSQL;
+    countSQL << "select count(*) " << searchSQL;
+    sqlResult = select(countSQL);
+    std::unique_ptr<SQLRow> countRow = sqlResult->nextRow();
+    if (countRow != nullptr) {
+        *numMatches = std::stoi(countRow->col(0));
+        AutoLock lock(searchCountMutex);
+        if (searchCounts.size() >= SEARCH_COUNT_CACHE_SIZE)
+            searchCounts.clear();
+        searchCounts[searchSQL] = *numMatches;
+    }
+
     return arr;
 }
 
 int SQLDatabase::getChildCount(int contId, bool containers, bool items, bool hideFsRoot)
 {
+    TraceSpan span("db.childCount");
     if (!containers && !items)
         return 0;
 
     std::ostringstream qb;
+    if (containers && items && !(contId == CDS_ID_ROOT && hideFsRoot)) {
+        qb << "SELECT " << TQ("child_count") << " FROM " << TQ(CDS_OBJECT_TABLE)
+           << " WHERE " << TQ("id") << "=?";
+        auto res = selectPrepared(qb.str(), { contId });
+        std::unique_ptr<SQLRow> row;
+        if (res != nullptr && (row = res->nextRow()) != nullptr)
+            return std::stoi(row->col(0));
+        return 0;
+    }
+
     qb << "SELECT COUNT(*) FROM " << TQ(CDS_OBJECT_TABLE)
-       << " WHERE " << TQ("parent_id") << '=' << contId;
+       << " WHERE " << TQ("parent_id") << "=?";
     if (containers && !items)
         qb << " AND " << TQ("object_type") << '=' << OBJECT_TYPE_CONTAINER;
     else if (items && !containers)
@@ -656,7 +1243,7 @@ int SQLDatabase::getChildCount(int contId, bool containers, bool items, bool hid
     if (contId == CDS_ID_ROOT && hideFsRoot) {
         qb << " AND " << TQ("id") << "!=" << quote(CDS_ID_FS_ROOT);
     }
-    auto res = select(qb);
+    auto res = selectPrepared(qb.str(), { contId });
 
     std::unique_ptr<SQLRow> row;
     if (res != nullptr && (row = res->nextRow()) != nullptr) {
@@ -666,25 +1253,68 @@ int SQLDatabase::getChildCount(int contId, bool containers, bool items, bool hid
     return 0;
 }
 
-std::vector<std::string> SQLDatabase::getMimeTypes()
+std::map<int, int> SQLDatabase::getChildCounts(const std::vector<int>& contIds, bool containers, bool items, bool hideFsRoot)
 {
-    std::vector<std::string> arr;
+    TraceSpan span("db.childCounts");
+    std::map<int, int> result;
+    if (contIds.empty() || (!containers && !items))
+        return result;
+
+    if (containers && items) {
+        std::ostringstream qb;
+        qb << "SELECT " << TQ("id") << ',' << TQ("child_count") << " FROM " << TQ(CDS_OBJECT_TABLE)
+           << " WHERE " << TQ("id") << " IN (" << toCSV(contIds) << ')';
+        auto res = select(qb);
+        if (res == nullptr)
+            throw_std_runtime_error("db error");
+
+        std::unique_ptr<SQLRow> row;
+        while ((row = res->nextRow()) != nullptr) {
+            result[std::stoi(row->col(0))] = std::stoi(row->col(1));
+        }
+        if (hideFsRoot && result.find(CDS_ID_ROOT) != result.end())
+            result[CDS_ID_ROOT] = getChildCount(CDS_ID_ROOT, containers, items, hideFsRoot);
+        return result;
+    }
 
     std::ostringstream qb;
-    qb << "SELECT DISTINCT " << TQ("mime_type")
-       << " FROM " << TQ(CDS_OBJECT_TABLE)
-       << " WHERE " << TQ("mime_type") << " IS NOT NULL ORDER BY "
-       << TQ("mime_type");
+    qb << "SELECT " << TQ("parent_id") << ", COUNT(*) FROM " << TQ(CDS_OBJECT_TABLE)
+       << " WHERE " << TQ("parent_id") << " IN (" << toCSV(contIds) << ')';
+    if (containers && !items)
+        qb << " AND " << TQ("object_type") << '=' << OBJECT_TYPE_CONTAINER;
+    else if (items && !containers)
+        qb << " AND (" << TQ("object_type") << " & " << OBJECT_TYPE_ITEM
+           << ") = " << OBJECT_TYPE_ITEM;
+    // the fs root is only a child of the root container
+    if (hideFsRoot && std::find(contIds.begin(), contIds.end(), CDS_ID_ROOT) != contIds.end()) {
+        qb << " AND " << TQ("id") << "!=" << quote(CDS_ID_FS_ROOT);
+    }
+    qb << " GROUP BY " << TQ("parent_id");
     auto res = select(qb);
     if (res == nullptr)
         throw_std_runtime_error("db error");
 
     std::unique_ptr<SQLRow> row;
     while ((row = res->nextRow()) != nullptr) {
-        arr.push_back(std::string(row->col(0)));
+        result[std::stoi(row->col(0))] = std::stoi(row->col(1));
     }
+    return result;
+}
 
-    return arr;
+std::vector<std::string> SQLDatabase::getMimeTypes()
+{
+    AutoLock lock(libraryStatsMutex);
+    if (!libraryStatsLoaded) {
+        countLibraryItems("", 1);
+        libraryStatsLoaded = true;
+    }
+
+    std::set<std::string> mimeTypes;
+    for (auto&& [key, count] : libraryStats) {
+        if (!std::get<1>(key).empty())
+            mimeTypes.insert(std::get<1>(key));
+    }
+    return { mimeTypes.begin(), mimeTypes.end() };
 }
 
 std::shared_ptr<CdsObject> SQLDatabase::findObjectByPath(fs::path fullpath, bool wasRegularFile)
@@ -696,40 +1326,114 @@ std::shared_ptr<CdsObject> SQLDatabase::findObjectByPath(fs::path fullpath, bool
     else
         dbLocation = addLocationPrefix(LOC_DIR_PREFIX, fullpath);
 
+    if (dbLocation.front() == LOC_DIR_PREFIX) {
+        int objectID = findContainerIDByLocation(dbLocation);
+        return objectID != INVALID_OBJECT_ID ? loadObject(objectID) : nullptr;
+    }
+
+    auto obj = objectCache->getByLocation(dbLocation);
+    if (obj != nullptr)
+        return obj;
+    auto generation = objectCache->getGeneration();
+
     std::ostringstream qb;
     qb << sql_query
-       << " WHERE " << TQD('f', "location_hash") << '=' << quote(stringHash(dbLocation))
-       << " AND " << TQD('f', "location") << '=' << quote(dbLocation)
+       << " WHERE " << TQD('f', "location_hash") << "=?"
+       << " AND " << TQD('f', "location") << "=?"
        << " AND " << TQD('f', "ref_id") << " IS NULL "
                                            "LIMIT 1";
 
-    auto res = select(qb);
+    auto res = selectPrepared(qb.str(), { static_cast<long long>(stringHash(dbLocation)), dbLocation });
     if (res == nullptr)
         throw_std_runtime_error("error while doing select: {}", qb.str());
 
     std::unique_ptr<SQLRow> row = res->nextRow();
     if (row == nullptr)
         return nullptr;
-    return createObjectFromRow(row);
+    obj = createObjectFromRow(row);
+    objectCache->put(obj, generation, dbLocation);
+    return obj;
 }
 
 int SQLDatabase::findObjectIDByPath(fs::path fullpath, bool wasRegularFile)
 {
+    std::error_code ec;
+    if (!wasRegularFile && !isRegularFile(fullpath, ec))
+        return findContainerIDByLocation(addLocationPrefix(LOC_DIR_PREFIX, fullpath));
+
     auto obj = findObjectByPath(fullpath, wasRegularFile);
     if (obj == nullptr)
         return INVALID_OBJECT_ID;
     return obj->getID();
 }
 
+int SQLDatabase::findContainerIDByLocation(const std::string& dbLocation)
+{
+    AutoLock lock(containerPathMutex);
+    if (!containerPathsLoaded) {
+        std::ostringstream qb;
+        qb << "SELECT " << TQ("id") << ',' << TQ("location")
+           << " FROM " << TQ(CDS_OBJECT_TABLE)
+           << " WHERE " << TQ("object_type") << '=' << OBJECT_TYPE_CONTAINER
+           << " AND " << TQ("ref_id") << " IS NULL"
+           << " AND " << TQ("location") << " LIKE " << quote(std::string(1, LOC_DIR_PREFIX) + '%');
+        auto res = selectStreaming(qb.str());
+        if (res == nullptr)
+            throw_std_runtime_error("db error");
+
+        std::unique_ptr<SQLRow> row;
+        while ((row = res->nextRow()) != nullptr) {
+            int objectID = std::stoi(row->col(0));
+            containerPaths[row->col(1)] = objectID;
+            containerLocations[objectID] = row->col(1);
+        }
+        containerPathsLoaded = true;
+        log_debug("Loaded {} container paths", containerPaths.size());
+    }
+
+    auto entry = containerPaths.find(dbLocation);
+    return entry != containerPaths.end() ? entry->second : INVALID_OBJECT_ID;
+}
+
+void SQLDatabase::addContainerPath(int objectID, const std::string& dbLocation)
+{
+    AutoLock lock(containerPathMutex);
+    // otherwise the row is part of the next load
+    if (containerPathsLoaded) {
+        containerPaths[dbLocation] = objectID;
+        containerLocations[objectID] = dbLocation;
+    }
+}
+
+void SQLDatabase::removeContainerPaths(const std::vector<int32_t>& objectIDs)
+{
+    AutoLock lock(containerPathMutex);
+    for (auto&& objectID : objectIDs) {
+        auto entry = containerLocations.find(objectID);
+        if (entry != containerLocations.end()) {
+            containerPaths.erase(entry->second);
+            containerLocations.erase(entry);
+        }
+    }
+}
+
+void SQLDatabase::clearContainerPaths()
+{
+    AutoLock lock(containerPathMutex);
+    containerPaths.clear();
+    containerLocations.clear();
+    containerPathsLoaded = false;
+}
+
 int SQLDatabase::ensurePathExistence(fs::path path, int* changedContainer)
 {
     *changedContainer = INVALID_OBJECT_ID;
     if (path == std::string(1, DIR_SEPARATOR))
         return CDS_ID_FS_ROOT;
 
-    auto obj = findObjectByPath(path);
-    if (obj != nullptr)
-        return obj->getID();
+    int objectID = findObjectIDByPath(path);
+    if (objectID != INVALID_OBJECT_ID)
+        return objectID;
 
     int parentID = ensurePathExistence(path.parent_path(), changedContainer);
 
@@ -785,6 +1489,9 @@ int SQLDatabase::createContainer(int parentID, std::string name, const std::stri
 
     int newId = exec(qb.str(), true); // true = get last id#
     log_debug("Created object row, id: {}", newId);
+    _changeChildCount(parentID, 1);
+    if (!isVirtual && refID <= 0)
+        addContainerPath(newId, dbLocation);
 
     if (!itemMetadata.empty()) {
         for (const auto& [key, val] : itemMetadata) {
@@ -842,35 +1549,60 @@ void SQLDatabase::addContainerChain(std::string virtualPath, const std::string&
         *containerID = CDS_ID_ROOT;
         return;
     }
+
+    // paths and titles of the chain, the last container first
+    std::vector<std::pair<std::string, std::string>> levels;
+    for (auto path = virtualPath; path != std::string(1, VIRTUAL_CONTAINER_SEPARATOR);) {
+        std::string parent, title;
+        stripAndUnescapeVirtualContainerFromPath(path, parent, title);
+        levels.emplace_back(path, title);
+        path = parent;
+    }
+
+    // resolve the existing part of the chain with one query
     std::ostringstream qb;
-    std::string dbLocation = addLocationPrefix(LOC_VIRT_PREFIX, virtualPath);
-    qb << "SELECT " << TQ("id") << " FROM " << TQ(CDS_OBJECT_TABLE)
-       << " WHERE " << TQ("location_hash") << '=' << quote(stringHash(dbLocation))
-       << " AND " << TQ("location") << '=' << quote(dbLocation)
-       << " LIMIT 1";
+    qb << "SELECT " << TQ("id") << ',' << TQ("location") << " FROM " << TQ(CDS_OBJECT_TABLE)
+       << " WHERE " << TQ("location_hash") << " IN (";
+    for (std::size_t i = 0; i < levels.size(); i++)
+        qb << (i == 0 ? "" : ",") << quote(stringHash(addLocationPrefix(LOC_VIRT_PREFIX, levels.at(i).first)));
+    qb << ')';
 
+    std::map<std::string, int> existing;
     auto res = select(qb);
     if (res != nullptr) {
-        std::unique_ptr<SQLRow> row = res->nextRow();
-        if (row != nullptr) {
-            if (containerID != nullptr)
-                *containerID = std::stoi(row->col(0));
-            return;
+        std::unique_ptr<SQLRow> row;
+        while ((row = res->nextRow()) != nullptr)
+            existing.emplace(row->col(1), std::stoi(row->col(0)));
+    }
+
+    int parentContainerID = CDS_ID_ROOT;
+    std::size_t missing = 0;
+    for (; missing < levels.size(); missing++) {
+        auto found = existing.find(addLocationPrefix(LOC_VIRT_PREFIX, levels.at(missing).first));
+        if (found != existing.end()) {
+            parentContainerID = found->second;
+            break;
         }
     }
+    if (missing == 0) {
+        if (containerID != nullptr)
+            *containerID = parentContainerID;
+        return;
+    }
 
-    int parentContainerID = 0;
-    std::string newpath, container, newClass;
-    stripAndUnescapeVirtualContainerFromPath(virtualPath, newpath, container);
+    // the classes are given for the last containers of the chain
     auto classes = splitString(lastClass, '/');
-    if (!classes.empty()) {
-        newClass = classes.back();
-        classes.pop_back();
+    SQLTransaction transaction(this);
+    for (auto i = missing; i-- > 0;) {
+        auto newClass = i < classes.size() ? classes.at(classes.size() - 1 - i) : "";
+        if (i == 0)
+            parentContainerID = createContainer(parentContainerID, levels.at(i).second, levels.at(i).first, true, newClass, lastRefID, lastMetadata);
+        else
+            parentContainerID = createContainer(parentContainerID, levels.at(i).second, levels.at(i).first, true, newClass, INVALID_OBJECT_ID, std::map<std::string, std::string>());
+        updateID.emplace(updateID.begin(), parentContainerID);
     }
-    addContainerChain(newpath, classes.empty() ? "" : join(classes, '/'), INVALID_OBJECT_ID, &parentContainerID, updateID, std::map<std::string, std::string>());
-
-    *containerID = createContainer(parentContainerID, container, virtualPath, true, newClass, lastRefID, lastMetadata);
-    updateID.emplace(updateID.begin(), *containerID);
+    transaction.commit();
+    *containerID = parentContainerID;
 }
 
 std::string SQLDatabase::addLocationPrefix(char prefix, const std::string& path)
@@ -890,7 +1622,7 @@ fs::path SQLDatabase::stripLocationPrefix(std::string dbLocation, char* prefix)
     return dbLocation.substr(1);
 }
 
-std::shared_ptr<CdsObject> SQLDatabase::createObjectFromRow(const std::unique_ptr<SQLRow>& row)
+std::shared_ptr<CdsObject> SQLDatabase::createObjectFromRow(const std::unique_ptr<SQLRow>& row, const MetadataMap* metadata, unsigned int projection)
 {
     int objectType = std::stoi(row->col(_object_type));
     auto obj = CdsObject::createObject(objectType);
@@ -905,35 +1637,47 @@ std::shared_ptr<CdsObject> SQLDatabase::createObjectFromRow(const std::unique_pt
     obj->setFlags(std::stoi(row->col(_flags)));
     obj->setMTime(stoulString(row->col(_last_modified)));
 
-    auto meta = retrieveMetadataForObject(obj->getID());
-    if (!meta.empty()) {
-        obj->setMetadata(meta);
-    } else if (obj->getRefID() != CDS_ID_ROOT) {
-        meta = retrieveMetadataForObject(obj->getRefID());
-        if (!meta.empty())
-            obj->setMetadata(meta);
-    }
-    if (meta.empty()) {
-        // fallback to metadata that might be in mt_cds_object, which
-        // will be useful if retrieving for schema upgrade
-        std::string metadataStr = row->col(_metadata);
-        dictDecode(metadataStr, &meta);
-        obj->setMetadata(meta);
+    if (!(projection & BROWSE_NO_METADATA)) {
+        auto getMetadata = [&](int objectId) {
+            if (metadata == nullptr)
+                return retrieveMetadataForObject(objectId);
+            auto entry = metadata->find(objectId);
+            return entry != metadata->end() ? entry->second : std::map<std::string, std::string>();
+        };
+        auto meta = getMetadata(obj->getID());
+        if (meta.empty() && obj->getRefID() != CDS_ID_ROOT)
+            meta = getMetadata(obj->getRefID());
+        if (meta.empty()) {
+            // fallback to metadata that might be in mt_cds_object, which
+            // will be useful if retrieving for schema upgrade
+            dictDecode(row->colView(_metadata), &meta);
+        }
+        obj->setMetadata(std::move(meta));
     }
 
-    std::string auxdataStr = fallbackString(row->col(_auxdata), row->col(_ref_auxdata));
-    std::map<std::string, std::string> aux;
-    dictDecode(auxdataStr, &aux);
-    obj->setAuxData(aux);
+    // the column of the object or of the referenced original, decoded without copying the row
+    auto colOrRef = [&](int col, int refCol) {
+        auto value = row->colView(col);
+        return value.empty() ? row->colView(refCol) : value;
+    };
 
-    std::string resources_str = fallbackString(row->col(_resources), row->col(_ref_resources));
-    bool resource_zero_ok = false;
-    if (!resources_str.empty()) {
-        std::vector<std::string> resources = splitString(resources_str,
-            RESOURCE_SEP);
-        resource_zero_ok = !resources.empty();
-        for (const auto& resource : resources) {
-            obj->addResource(CdsResource::decode(resource));
+    if (!(projection & BROWSE_NO_AUXDATA)) {
+        std::map<std::string, std::string> aux;
+        dictDecode(colOrRef(_auxdata, _ref_auxdata), &aux);
+        obj->setAuxData(std::move(aux));
+    }
+
+    // without resources the check for the first one can't be done
+    bool resource_zero_ok = projection & BROWSE_NO_RESOURCES;
+    if (!resource_zero_ok) {
+        auto resources = colOrRef(_resources, _ref_resources);
+        for (std::size_t pos = 0; pos < resources.length();) {
+            auto next = std::min(resources.find(RESOURCE_SEP, pos), resources.length());
+            if (next > pos) {
+                obj->addResource(CdsResource::decode(resources.substr(pos, next - pos)));
+                resource_zero_ok = true;
+            }
+            pos = next + 1;
         }
     }
 
@@ -943,7 +1687,7 @@ std::shared_ptr<CdsObject> SQLDatabase::createObjectFromRow(const std::unique_pt
 
     if (obj->isContainer()) {
         auto cont = std::static_pointer_cast<CdsContainer>(obj);
-        cont->setUpdateID(std::stoi(row->col(_update_id)));
+        cont->setUpdateID(getUpdateID(obj->getID(), std::stoi(row->col(_update_id))));
         char locationPrefix;
         cont->setLocation(stripLocationPrefix(row->col(_location), &locationPrefix));
         if (locationPrefix == LOC_VIRT_PREFIX)
@@ -995,7 +1739,7 @@ std::shared_ptr<CdsObject> SQLDatabase::createObjectFromRow(const std::unique_pt
     return obj;
 }
 
-std::shared_ptr<CdsObject> SQLDatabase::createObjectFromSearchRow(const std::unique_ptr<SQLRow>& row)
+std::shared_ptr<CdsObject> SQLDatabase::createObjectFromSearchRow(const std::unique_ptr<SQLRow>& row, const MetadataMap* metadata)
 {
     int objectType = std::stoi(row->col(_object_type));
     auto obj = CdsObject::createObject(objectType);
@@ -1008,9 +1752,15 @@ std::shared_ptr<CdsObject> SQLDatabase::createObjectFromSearchRow(const std::uni
     obj->setTitle(row->col(to_underlying(SearchCol::dc_title)));
     obj->setClass(row->col(to_underlying(SearchCol::upnp_class)));
 
-    auto meta = retrieveMetadataForObject(obj->getID());
-    if (!meta.empty())
-        obj->setMetadata(meta);
+    if (metadata == nullptr) {
+        auto meta = retrieveMetadataForObject(obj->getID());
+        if (!meta.empty())
+            obj->setMetadata(meta);
+    } else {
+        auto meta = metadata->find(obj->getID());
+        if (meta != metadata->end())
+            obj->setMetadata(meta->second);
+    }
 
     std::string resources_str = row->col(to_underlying(SearchCol::resources));
     bool resource_zero_ok = false;
@@ -1048,112 +1798,503 @@ std::map<std::string, std::string> SQLDatabase::retrieveMetadataForObject(int ob
     qb << SELECT_METADATA
        << " FROM " << TQ(METADATA_TABLE)
        << " WHERE " << TQ("item_id")
-       << " = " << objectId;
-    auto res = select(qb);
+       << " = ?";
+    auto res = selectPrepared(qb.str(), { objectId });
 
     std::map<std::string, std::string> metadata;
     if (res == nullptr)
         return metadata;
 
-    std::unique_ptr<SQLRow> row;
-    while ((row = res->nextRow()) != nullptr) {
-        metadata[row->col(to_underlying(MetadataCol::m_property_name))] = row->col(to_underlying(MetadataCol::m_property_value));
+    std::unique_ptr<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr) {
+        metadata[row->col(to_underlying(MetadataCol::m_property_name))] = row->col(to_underlying(MetadataCol::m_property_value));
+    }
+    return metadata;
+}
+
+SQLDatabase::MetadataMap SQLDatabase::retrieveMetadataForObjects(const std::vector<int>& objectIds)
+{
+    MetadataMap metadata;
+    if (objectIds.empty())
+        return metadata;
+
+    std::ostringstream qb;
+    qb << "SELECT " << TQ("item_id") << ',' << TQ("property_name") << ',' << TQ("property_value")
+       << " FROM " << TQ(METADATA_TABLE)
+       << " WHERE " << TQ("item_id")
+       << " IN (" << toCSV(objectIds) << ')';
+    auto res = select(qb);
+    if (res == nullptr)
+        return metadata;
+
+    std::unique_ptr<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr) {
+        metadata[std::stoi(row->col(0))][row->col(1)] = row->col(2);
+    }
+    return metadata;
+}
+
+int SQLDatabase::getTotalFiles(bool isVirtual, const std::string& mimeType, const std::string& upnpClass)
+{
+    AutoLock lock(libraryStatsMutex);
+    if (!libraryStatsLoaded) {
+        countLibraryItems("", 1);
+        libraryStatsLoaded = true;
+    }
+
+    auto locationPrefix = isVirtual ? LOC_VIRT_PREFIX : LOC_FILE_PREFIX;
+    int total = 0;
+    for (auto&& [key, count] : libraryStats) {
+        auto&& [keyPrefix, keyMimeType, keyClass] = key;
+        if (keyPrefix == locationPrefix && startswith(keyMimeType, mimeType) && startswith(keyClass, upnpClass))
+            total += count;
+    }
+    return total;
+}
+
+void SQLDatabase::countLibraryItems(const std::string& objectIDs, int sign)
+{
+    std::ostringstream query;
+    query << "SELECT SUBSTR(" << TQ("location") << ",1,1)," << TQ("mime_type") << ',' << TQ("upnp_class") << ",COUNT(*)"
+          << " FROM " << TQ(CDS_OBJECT_TABLE)
+          << " WHERE " << TQ("object_type") << " != " << quote(OBJECT_TYPE_CONTAINER);
+    if (!objectIDs.empty())
+        query << " AND " << TQ("id") << " IN (" << objectIDs << ')';
+    query << " GROUP BY SUBSTR(" << TQ("location") << ",1,1)," << TQ("mime_type") << ',' << TQ("upnp_class");
+
+    auto res = select(query);
+    if (res == nullptr)
+        throw_std_runtime_error("db error");
+    std::unique_ptr<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr) {
+        auto locationPrefix = row->col(0);
+        LibraryKey key { locationPrefix.empty() ? '\0' : locationPrefix.front(), row->col(1), row->col(2) };
+        if ((libraryStats[key] += sign * std::stoi(row->col(3))) <= 0)
+            libraryStats.erase(key);
+    }
+}
+
+void SQLDatabase::changeLibraryStats(const std::vector<LibraryKey>& keys, int delta)
+{
+    AutoLock lock(libraryStatsMutex);
+    if (!libraryStatsLoaded)
+        return;
+    for (auto&& key : keys) {
+        if ((libraryStats[key] += delta) <= 0)
+            libraryStats.erase(key);
+    }
+}
+
+std::string SQLDatabase::incrementUpdateIDs(const std::unique_ptr<std::unordered_set<int>>& ids)
+{
+    if (ids->empty())
+        return "";
+
+    AutoLock lock(updateIDMutex);
+    std::vector<int> missing;
+    for (const auto& id : *ids) {
+        if (updateIDs.find(id) == updateIDs.end())
+            missing.push_back(id);
+    }
+    if (!missing.empty()) {
+        std::ostringstream bufSelect;
+        bufSelect << "SELECT " << TQ("id") << ',' << TQ("update_id") << " FROM "
+                  << TQ(CDS_OBJECT_TABLE) << " WHERE " << TQ("id") << " IN (" << join(missing, ',') << ')';
+        auto res = select(bufSelect);
+        if (res == nullptr)
+            throw_std_runtime_error("Error while fetching update ids");
+
+        std::unique_ptr<SQLRow> row;
+        while ((row = res->nextRow()) != nullptr) {
+            updateIDs[std::stoi(row->col(0))] = std::stoi(row->col(1));
+        }
+    }
+    objectCache->erase(std::vector<int>(ids->begin(), ids->end()));
+
+    std::list<std::string> rows;
+    for (const auto& id : *ids) {
+        auto entry = updateIDs.find(id);
+        if (entry == updateIDs.end())
+            continue; // removed from the database
+        entry->second++;
+        dirtyUpdateIDs.insert(id);
+        rows.emplace_back(fmt::format("{},{}", id, entry->second));
+    }
+
+    // the other nodes of a cluster load the containers with the stored update ids, the others are written by storeUpdateIDs() in time
+    if (!clusterNode.empty() || dirtyUpdateIDs.size() >= UPDATE_ID_FLUSH_SIZE)
+        flushUpdateIDs(false);
+
+    if (rows.empty())
+        return "";
+    auto result = join(rows, ",");
+    if (!clusterNode.empty())
+        writeChangeLog(result);
+    return result;
+}
+
+void SQLDatabase::writeChangeLog(const std::string& updateIDs)
+{
+    auto now = std::int64_t(std::time(nullptr));
+    std::ostringstream ins;
+    ins << "INSERT INTO " << TQ(CHANGE_LOG_TABLE) << " (" << TQ("node") << ',' << TQ("update_ids") << ',' << TQ("changed")
+        << ") VALUES (" << quote(clusterNode) << ',' << quote(updateIDs) << ',' << now << ')';
+    exec(ins.str());
+
+    if (pruneChangeLog && getDeltaMillis(&lastChangeLogPrune) >= CHANGE_LOG_PRUNE_INTERVAL) {
+        getTimespecNow(&lastChangeLogPrune);
+        std::ostringstream del;
+        del << "DELETE FROM " << TQ(CHANGE_LOG_TABLE) << " WHERE " << TQ("changed") << " < " << now - config->getIntOption(CFG_SERVER_CLUSTER_KEEP);
+        exec(del.str());
+    }
+}
+
+std::int64_t SQLDatabase::getChangeLogSequence()
+{
+    std::ostringstream q;
+    q << "SELECT MAX(" << TQ("id") << ") FROM " << TQ(CHANGE_LOG_TABLE);
+    auto res = select(q);
+    std::unique_ptr<SQLRow> row;
+    if (res == nullptr || (row = res->nextRow()) == nullptr || row->col(0).empty())
+        return 0;
+    return std::stoll(row->col(0));
+}
+
+Database::ChangeLog SQLDatabase::readChangeLog(const ChangeLog& previous)
+{
+    ChangeLog changes;
+    changes.sequence = previous.sequence;
+    changes.gaps = previous.gaps;
+    changes.readTime = std::time(nullptr);
+    // entries are pruned by age, the ones written since the previous read are still there
+    changes.complete = previous.readTime == 0 || changes.readTime - previous.readTime < config->getIntOption(CFG_SERVER_CLUSTER_KEEP);
+
+    std::ostringstream q;
+    q << "SELECT " << TQ("id") << ',' << TQ("node") << ',' << TQ("update_ids") << " FROM " << TQ(CHANGE_LOG_TABLE)
+      << " WHERE " << TQ("id") << " > " << previous.sequence;
+    if (!previous.gaps.empty()) {
+        q << " OR " << TQ("id") << " IN (";
+        for (auto gap = previous.gaps.begin(); gap != previous.gaps.end(); ++gap)
+            q << (gap == previous.gaps.begin() ? "" : ",") << gap->first;
+        q << ')';
+    }
+    q << " ORDER BY " << TQ("id");
+    auto res = select(q);
+    if (res == nullptr)
+        throw_std_runtime_error("Error while reading the change log");
+
+    std::unique_ptr<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr) {
+        auto id = std::stoll(row->col(0));
+        if (id <= previous.sequence) {
+            // a gap of an earlier read was committed now
+            changes.gaps.erase(id);
+        } else {
+            // the numbers skipped since the highest one read may still commit, the first read starts after the latest entry
+            if (previous.sequence > 0 || changes.sequence > previous.sequence) {
+                for (auto missing = changes.sequence + 1; missing < id && missing - changes.sequence <= CHANGE_LOG_MAX_GAPS; missing++)
+                    changes.gaps.emplace(missing, changes.readTime);
+            }
+            changes.sequence = id;
+        }
+        if (row->col(1) != clusterNode)
+            changes.updateIDs.push_back(row->col(2));
+    }
+
+    for (auto gap = changes.gaps.begin(); gap != changes.gaps.end();) {
+        if (changes.readTime - gap->second > CHANGE_LOG_GAP_WINDOW || changes.gaps.size() > CHANGE_LOG_MAX_GAPS) {
+            log_debug("Change log entry {} did not turn up, it was rolled back", gap->first);
+            gap = changes.gaps.erase(gap);
+        } else {
+            ++gap;
+        }
+    }
+    if (changes.updateIDs.empty() && changes.complete)
+        return changes;
+
+    {
+        AutoLock lock(updateIDMutex);
+        for (auto&& entry : changes.updateIDs) {
+            auto values = splitString(entry, ',');
+            for (std::size_t i = 0; i + 1 < values.size(); i += 2) {
+                auto&& updateID = updateIDs[std::stoi(values[i])];
+                updateID = std::max(updateID, std::stoi(values[i + 1]));
+            }
+        }
+    }
+    // the entries only name the changed containers, not the changed items in them
+    objectCache->clear();
+    clearResultCaches();
+    return changes;
+}
+
+void SQLDatabase::storeUpdateIDs()
+{
+    AutoLock lock(updateIDMutex);
+    flushUpdateIDs(false);
+}
+
+void SQLDatabase::flushUpdateIDs(bool wait)
+{
+    if (!dirtyUpdateIDs.empty()) {
+        std::vector<int> dirty(dirtyUpdateIDs.begin(), dirtyUpdateIDs.end());
+        dirtyUpdateIDs.clear();
+
+        for (std::size_t offset = 0; offset < dirty.size(); offset += MAX_INSERT_ROWS) {
+            auto last = std::min(dirty.size(), offset + MAX_INSERT_ROWS);
+            std::ostringstream bufUpdate;
+            bufUpdate << "UPDATE " << TQ(CDS_OBJECT_TABLE) << " SET " << TQ("update_id") << " = CASE " << TQ("id");
+            for (auto i = offset; i < last; i++)
+                bufUpdate << " WHEN " << dirty[i] << " THEN " << updateIDs[dirty[i]];
+            bufUpdate << " ELSE " << TQ("update_id") << " END WHERE " << TQ("id") << " IN (";
+            for (auto i = offset; i < last; i++)
+                bufUpdate << (i == offset ? "" : ",") << dirty[i];
+            bufUpdate << ')';
+            auto done = execAsync(bufUpdate.str());
+            if (wait)
+                done.get();
+        }
+    }
+
+    // the written ids are in the database as well, only as many stay in memory as fit
+    for (auto entry = updateIDs.begin(); entry != updateIDs.end() && updateIDs.size() > UPDATE_ID_CACHE_SIZE;) {
+        if (dirtyUpdateIDs.find(entry->first) == dirtyUpdateIDs.end())
+            entry = updateIDs.erase(entry);
+        else
+            ++entry;
+    }
+}
+
+int SQLDatabase::getUpdateID(int objectID, int storedUpdateID)
+{
+    AutoLock lock(updateIDMutex);
+    auto entry = updateIDs.find(objectID);
+    return entry != updateIDs.end() ? entry->second : storedUpdateID;
+}
+
+std::unique_ptr<std::unordered_set<int>> SQLDatabase::getObjects(int parentID, bool withoutContainer)
+{
+    std::ostringstream q;
+    q << "SELECT " << TQ("id") << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE ";
+    if (withoutContainer)
+        q << TQ("object_type") << " != " << OBJECT_TYPE_CONTAINER << " AND ";
+    q << TQ("parent_id") << '=';
+    q << parentID;
+    auto res = selectStreaming(q.str());
+    if (res == nullptr)
+        throw_std_runtime_error("db error");
+
+    auto ret = std::make_unique<std::unordered_set<int>>();
+    std::unique_ptr<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr) {
+        ret->insert(std::stoi(row->col(0)));
+    }
+    if (ret->empty())
+        return nullptr;
+    return ret;
+}
+
+std::vector<int> SQLDatabase::getSubtreeItems(int containerID, std::size_t limit)
+{
+    // walk the containers level by level, only the container ids of one level are kept
+    std::vector<int> result;
+    std::vector<int> level { containerID };
+    int count = 0;
+    while (!level.empty() && result.size() < limit) {
+        std::ostringstream q;
+        q << "SELECT " << TQ("id") << ',' << TQ("object_type")
+          << " FROM " << TQ(CDS_OBJECT_TABLE)
+          << " WHERE " << TQ("parent_id") << " IN (" << join(level, ',') << ')';
+        auto res = selectStreaming(q.str());
+        if (res == nullptr)
+            throw_std_runtime_error("db error");
+
+        level.clear();
+        std::unique_ptr<SQLRow> row;
+        while ((row = res->nextRow()) != nullptr) {
+            int id = std::stoi(row->col(0));
+            if (IS_CDS_CONTAINER(std::stoi(row->col(1))))
+                level.push_back(id);
+            else if (result.size() < limit)
+                result.push_back(id);
+        }
+
+        if (count++ > MAX_REMOVE_RECURSION)
+            throw_std_runtime_error("there seems to be an infinite loop...");
     }
-    return metadata;
+    return result;
 }
 
-int SQLDatabase::getTotalFiles(bool isVirtual, const std::string& mimeType, const std::string& upnpClass)
+std::vector<int> SQLDatabase::getItemIDs(int afterID, std::size_t limit)
 {
-    std::ostringstream query;
-    query << "SELECT COUNT(*) FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE "
-          << TQ("object_type") << " != " << quote(OBJECT_TYPE_CONTAINER);
-    if (!mimeType.empty()) {
-        query << " AND " << TQ("mime_type") << " LIKE " << quote(mimeType + "%");
-    }
-    if (!upnpClass.empty()) {
-        query << " AND " << TQ("upnp_class") << " LIKE " << quote(upnpClass + "%");
-    }
-    if (isVirtual) {
-        query << " AND " << TQ("location") << " LIKE " << quote(fmt::format("{}%", LOC_VIRT_PREFIX));
-    } else {
-        query << " AND " << TQ("location") << " LIKE " << quote(fmt::format("{}%", LOC_FILE_PREFIX));
-    }
-    //<< " AND is_virtual = 0";
+    // items created by scripts below virtual containers are part of the layout
+    std::ostringstream q;
+    q << "SELECT " << TQ("id") << " FROM " << TQ(CDS_OBJECT_TABLE)
+      << " WHERE " << TQ("id") << " > " << afterID
+      << " AND " << TQ("ref_id") << " IS NULL"
+      << " AND " << TQ("object_type") << " != " << OBJECT_TYPE_CONTAINER
+      << " AND (" << TQ("parent_id") << '=' << CDS_ID_FS_ROOT << " OR " << TQ("parent_id") << " IN ("
+      << "SELECT " << TQ("id") << " FROM " << TQ(CDS_OBJECT_TABLE)
+      << " WHERE " << TQ("object_type") << '=' << OBJECT_TYPE_CONTAINER
+      << " AND " << TQ("location") << " LIKE " << quote(fmt::format("{}%", LOC_DIR_PREFIX)) << "))"
+      << " ORDER BY " << TQ("id") << " LIMIT " << limit;
+    auto res = select(q);
+    if (res == nullptr)
+        throw_std_runtime_error("db error");
 
-    auto res = select(query);
+    std::vector<int> result;
+    std::unique_ptr<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr)
+        result.push_back(std::stoi(row->col(0)));
+    return result;
+}
 
+int SQLDatabase::addShadowContainer(const std::string& title)
+{
+    auto path = fmt::format("{}{}", VIRTUAL_CONTAINER_SEPARATOR, title);
+    auto dbLocation = addLocationPrefix(LOC_VIRT_PREFIX, path);
+    std::ostringstream q;
+    q << "SELECT " << TQ("id") << " FROM " << TQ(CDS_OBJECT_TABLE)
+      << " WHERE " << TQ("location_hash") << '=' << quote(stringHash(dbLocation))
+      << " AND " << TQ("location") << '=' << quote(dbLocation);
+    auto res = select(q);
     std::unique_ptr<SQLRow> row;
-    if (res != nullptr && (row = res->nextRow()) != nullptr) {
-        return std::stoi(row->col(0));
+    while (res != nullptr && (row = res->nextRow()) != nullptr) {
+        log_info("Removing the unfinished layout {}", row->col(0));
+        removeObject(std::stoi(row->col(0)), false);
     }
-    return 0;
+
+    // the parent of the root cannot be browsed
+    return createContainer(CDS_ID_ROOT - 1, title, path, true, UPNP_CLASS_CONTAINER, INVALID_OBJECT_ID, {});
 }
 
-std::string SQLDatabase::incrementUpdateIDs(const std::unique_ptr<std::unordered_set<int>>& ids)
+std::unique_ptr<Database::ChangedContainers> SQLDatabase::swapShadowContainer(int shadowID)
 {
-    if (ids->empty())
-        return "";
-    std::ostringstream inBuf;
+    std::ostringstream qLoc;
+    qLoc << "SELECT " << TQ("location") << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE " << TQ("id") << '=' << shadowID;
+    auto res = select(qLoc);
+    std::unique_ptr<SQLRow> row;
+    if (res == nullptr || (row = res->nextRow()) == nullptr)
+        throw_std_runtime_error("shadow container {} does not exist", shadowID);
+    auto shadowLocation = row->col(0);
 
-    bool first = true;
-    for (const auto& id : *ids) {
-        if (first) {
-            inBuf << "IN (" << id;
-            first = false;
-        } else {
-            inBuf << ',' << id;
-        }
-    }
-    inBuf << ')';
+    // one statement, so browsing sees either the old or the new layout
+    std::ostringstream q;
+    q << "UPDATE " << TQ(CDS_OBJECT_TABLE)
+      << " SET " << TQ("parent_id") << "=CASE WHEN " << TQ("parent_id") << '=' << CDS_ID_ROOT << " THEN " << shadowID << " ELSE " << CDS_ID_ROOT << " END"
+      << " WHERE (" << TQ("parent_id") << '=' << CDS_ID_ROOT << " AND " << TQ("id") << " NOT IN (" << CDS_ID_FS_ROOT << ',' << shadowID << "))"
+      << " OR " << TQ("parent_id") << '=' << shadowID;
+    exec(q.str());
+    _refreshChildCounts({ CDS_ID_ROOT, shadowID });
 
-    std::ostringstream bufUpdate;
-    bufUpdate << "UPDATE " << TQ(CDS_OBJECT_TABLE) << " SET " << TQ("update_id")
-              << '=' << TQ("update_id") << " + 1 WHERE " << TQ("id") << ' ';
-    bufUpdate << inBuf.str();
-    exec(bufUpdate.str());
+    auto changed = removeObject(shadowID, false);
 
-    std::ostringstream bufSelect;
-    bufSelect << "SELECT " << TQ("id") << ',' << TQ("update_id") << " FROM "
-              << TQ(CDS_OBJECT_TABLE) << " WHERE " << TQ("id") << ' ';
-    bufSelect << inBuf.str();
-    auto res = select(bufSelect);
+    // the chains of the new layout lose the prefix of the shadow container
+    std::ostringstream qChains;
+    qChains << "SELECT " << TQ("id") << ',' << TQ("location") << " FROM " << TQ(CDS_OBJECT_TABLE)
+            << " WHERE " << TQ("location") << " LIKE " << quote(fmt::format("{}{}%", shadowLocation, VIRTUAL_CONTAINER_SEPARATOR));
+    res = select(qChains);
     if (res == nullptr)
-        throw_std_runtime_error("Error while fetching update ids");
-
-    std::unique_ptr<SQLRow> row;
-    std::list<std::string> rows;
-    while ((row = res->nextRow()) != nullptr) {
-        std::ostringstream s;
-        s << row->col(0) << ',' << row->col(1);
-        rows.emplace_back(s.str());
-    }
-    if (rows.empty())
-        return "";
-    return join(rows, ",");
+        throw_std_runtime_error("db error");
+    std::vector<std::pair<int, std::string>> chains;
+    while ((row = res->nextRow()) != nullptr)
+        chains.emplace_back(std::stoi(row->col(0)), addLocationPrefix(LOC_VIRT_PREFIX, row->col(1).substr(shadowLocation.size())));
+
+    SQLTransaction transaction(this);
+    for (auto&& [id, location] : chains) {
+        std::ostringstream u;
+        u << "UPDATE " << TQ(CDS_OBJECT_TABLE)
+          << " SET " << TQ("location") << '=' << quote(location) << ',' << TQ("location_hash") << '=' << quote(stringHash(location))
+          << " WHERE " << TQ("id") << '=' << id;
+        exec(u.str());
+    }
+    transaction.commit();
+    clearResultCaches();
+    return changed;
 }
 
-std::unique_ptr<std::unordered_set<int>> SQLDatabase::getObjects(int parentID, bool withoutContainer)
+std::unordered_map<std::string, Database::ObjectStat> SQLDatabase::getChildStats(int parentID, bool withoutContainer)
 {
     std::ostringstream q;
-    q << "SELECT " << TQ("id") << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE ";
+    q << "SELECT " << TQ("id") << ',' << TQ("location") << ',' << TQ("last_modified") << ',' << TQ("object_type")
+      << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE ";
     if (withoutContainer)
         q << TQ("object_type") << " != " << OBJECT_TYPE_CONTAINER << " AND ";
-    q << TQ("parent_id") << '=';
-    q << parentID;
-    auto res = select(q);
+    q << TQ("parent_id") << '=' << parentID;
+    auto res = selectStreaming(q.str());
     if (res == nullptr)
         throw_std_runtime_error("db error");
-    if (res->getNumRows() == 0)
-        return nullptr;
 
-    auto ret = std::make_unique<std::unordered_set<int>>();
+    std::unordered_map<std::string, ObjectStat> ret;
     std::unique_ptr<SQLRow> row;
     while ((row = res->nextRow()) != nullptr) {
-        ret->insert(std::stoi(row->col(0)));
+        char prefix;
+        auto location = stripLocationPrefix(row->col(1), &prefix);
+        // virtual containers have no file behind them
+        if (prefix != LOC_FILE_PREFIX && prefix != LOC_DIR_PREFIX)
+            continue;
+        ret[location.string()] = { std::stoi(row->col(0)), time_t(stoulString(row->col(2))), IS_CDS_CONTAINER(std::stoi(row->col(3))) };
     }
     return ret;
 }
 
+bool SQLDatabase::isDirectoryUnchanged(int objectID, time_t mtime)
+{
+    std::ostringstream q;
+    q << "SELECT " << TQD('s', "mtime") << ',' << TQD('s', "child_count") << ',' << TQD('o', "child_count")
+      << " FROM " << TQ(DIRECTORY_STATE_TABLE) << " s"
+      << " JOIN " << TQ(CDS_OBJECT_TABLE) << " o ON " << TQD('o', "id") << '=' << TQD('s', "id")
+      << " WHERE " << TQD('s', "id") << "=?";
+    auto res = selectPrepared(q.str(), { objectID });
+    std::unique_ptr<SQLRow> row;
+    if (res == nullptr || (row = res->nextRow()) == nullptr)
+        return false;
+    return time_t(stoulString(row->col(0))) == mtime && row->col(1) == row->col(2);
+}
+
+void SQLDatabase::setDirectoryState(int objectID, time_t mtime)
+{
+    std::ostringstream del;
+    del << "DELETE FROM " << TQ(DIRECTORY_STATE_TABLE) << " WHERE " << TQ("id") << '=' << objectID;
+    exec(del.str());
+
+    std::ostringstream ins;
+    ins << "INSERT INTO " << TQ(DIRECTORY_STATE_TABLE) << " (" << TQ("id") << ',' << TQ("mtime") << ',' << TQ("child_count") << ')'
+        << " SELECT " << TQ("id") << ',' << quote(mtime) << ',' << TQ("child_count")
+        << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE " << TQ("id") << '=' << objectID;
+    exec(ins.str());
+}
+
+bool SQLDatabase::getFileState(int objectID, FileState& state)
+{
+    std::ostringstream q;
+    q << "SELECT " << TQ("size") << ',' << TQ("inode") << ',' << TQ("birth_time") << ',' << TQ("head") << ',' << TQ("tail")
+      << " FROM " << TQ(FILE_STATE_TABLE) << " WHERE " << TQ("id") << "=?";
+    auto res = selectPrepared(q.str(), { objectID });
+    std::unique_ptr<SQLRow> row;
+    if (res == nullptr || (row = res->nextRow()) == nullptr)
+        return false;
+    state.size = std::stoll(row->col(0));
+    state.inode = std::stoll(row->col(1));
+    state.birthTime = std::stoll(row->col(2));
+    state.head = std::stoll(row->col(3));
+    state.tail = std::stoll(row->col(4));
+    return true;
+}
+
+void SQLDatabase::setFileState(int objectID, const FileState& state)
+{
+    std::ostringstream del;
+    del << "DELETE FROM " << TQ(FILE_STATE_TABLE) << " WHERE " << TQ("id") << '=' << objectID;
+    exec(del.str());
+
+    std::ostringstream ins;
+    ins << "INSERT INTO " << TQ(FILE_STATE_TABLE)
+        << " (" << TQ("id") << ',' << TQ("size") << ',' << TQ("inode") << ',' << TQ("birth_time") << ',' << TQ("head") << ',' << TQ("tail") << ')'
+        << " VALUES (" << objectID << ',' << state.size << ',' << state.inode << ',' << state.birthTime << ',' << state.head << ',' << state.tail << ')';
+    exec(ins.str());
+}
+
 std::unique_ptr<Database::ChangedContainers> SQLDatabase::removeObjects(const std::unique_ptr<std::unordered_set<int>>& list, bool all)
 {
     size_t count = list->size();
@@ -1171,7 +2312,7 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::removeObjects(const st
            << " FROM " << TQ(CDS_OBJECT_TABLE)
            << " WHERE " << TQ("id") << " IN (" << join(*list, ",") << ")";
 
-    auto res = select(idsBuf);
+    auto res = selectStreaming(idsBuf.str());
     if (res == nullptr)
         throw_std_runtime_error("sql error");
 
@@ -1190,9 +2331,139 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::removeObjects(const st
     return _purgeEmptyContainers(rr);
 }
 
+std::unique_ptr<Database::ChangedContainers> SQLDatabase::relocateSubtree(const fs::path& oldPath, const fs::path& newPath)
+{
+    // oldPath is gone, so it cannot tell whether it was a directory
+    auto obj = findObjectByPath(oldPath, false);
+    bool isContainer = obj != nullptr;
+    if (obj == nullptr)
+        obj = findObjectByPath(oldPath, true);
+    if (obj == nullptr)
+        return nullptr;
+
+    auto changedContainers = std::make_unique<ChangedContainers>();
+    int changedContainer = INVALID_OBJECT_ID;
+    int parentID = ensurePathExistence(newPath.parent_path(), &changedContainer);
+    if (changedContainer != INVALID_OBJECT_ID)
+        changedContainers->upnp.push_back(changedContainer);
+    changedContainers->upnp.push_back(obj->getParentID());
+    changedContainers->upnp.push_back(parentID);
+    changedContainers->ui = changedContainers->upnp;
+
+    // new location of the object and, for directories, of everything below it
+    std::vector<std::pair<int, std::string>> locations;
+    std::vector<int32_t> containerIDs;
+    char prefix = isContainer ? LOC_DIR_PREFIX : LOC_FILE_PREFIX;
+    locations.emplace_back(obj->getID(), addLocationPrefix(prefix, newPath));
+    if (isContainer) {
+        containerIDs.push_back(obj->getID());
+        for (char childPrefix : { LOC_FILE_PREFIX, LOC_DIR_PREFIX }) {
+            auto oldBase = addLocationPrefix(childPrefix, oldPath / "");
+            auto newBase = addLocationPrefix(childPrefix, newPath / "");
+            std::ostringstream qb;
+            qb << "SELECT " << TQ("id") << ',' << TQ("location")
+               << " FROM " << TQ(CDS_OBJECT_TABLE)
+               << " WHERE " << TQ("location") << " LIKE " << quote(oldBase + '%')
+               << " AND " << TQ("ref_id") << " IS NULL";
+            auto res = selectStreaming(qb.str());
+            if (res == nullptr)
+                throw_std_runtime_error("db error");
+
+            std::unique_ptr<SQLRow> row;
+            while ((row = res->nextRow()) != nullptr) {
+                std::string location = row->col(1);
+                // LIKE also matches _ and % in the path as wildcards
+                if (!startswith(location, oldBase))
+                    continue;
+                int objectID = std::stoi(row->col(0));
+                locations.emplace_back(objectID, newBase + location.substr(oldBase.length()));
+                if (childPrefix == LOC_DIR_PREFIX)
+                    containerIDs.push_back(objectID);
+            }
+        }
+    }
+
+    SQLTransaction transaction(this);
+    for (std::size_t offset = 0; offset < locations.size(); offset += MAX_INSERT_ROWS) {
+        auto last = std::min(locations.size(), offset + MAX_INSERT_ROWS);
+        std::ostringstream locationCase;
+        std::ostringstream hashCase;
+        std::ostringstream ids;
+        for (auto i = offset; i < last; i++) {
+            locationCase << " WHEN " << locations[i].first << " THEN " << quote(locations[i].second);
+            hashCase << " WHEN " << locations[i].first << " THEN " << stringHash(locations[i].second);
+            ids << (i == offset ? "" : ",") << locations[i].first;
+        }
+        std::ostringstream bufUpdate;
+        bufUpdate << "UPDATE " << TQ(CDS_OBJECT_TABLE)
+                  << " SET " << TQ("location") << " = CASE " << TQ("id") << locationCase.str() << " ELSE " << TQ("location") << " END"
+                  << ',' << TQ("location_hash") << " = CASE " << TQ("id") << hashCase.str() << " ELSE " << TQ("location_hash") << " END"
+                  << " WHERE " << TQ("id") << " IN (" << ids.str() << ')';
+        exec(bufUpdate.str());
+    }
+
+    // titles taken from the file name follow the rename
+    std::ostringstream bufUpdate;
+    bufUpdate << "UPDATE " << TQ(CDS_OBJECT_TABLE)
+              << " SET " << TQ("parent_id") << '=' << quote(parentID)
+              << ',' << TQ("dc_title") << " = CASE WHEN " << TQ("dc_title") << '=' << quote(oldPath.filename().string())
+              << " THEN " << quote(newPath.filename().string()) << " ELSE " << TQ("dc_title") << " END"
+              << " WHERE " << TQ("id") << '=' << quote(obj->getID());
+    exec(bufUpdate.str());
+    if (obj->getParentID() != parentID) {
+        _changeChildCount(obj->getParentID(), -1);
+        _changeChildCount(parentID, 1);
+    }
+    transaction.commit();
+    // browse cursors and search counts hold the old tree
+    clearResultCaches();
+
+    std::vector<int> objectIDs;
+    objectIDs.reserve(locations.size() + 2);
+    for (auto&& [objectID, location] : locations)
+        objectIDs.push_back(objectID);
+    // the child counts of both parents changed
+    objectIDs.push_back(obj->getParentID());
+    objectIDs.push_back(parentID);
+    objectCache->erase(objectIDs);
+    removeContainerPaths(containerIDs);
+    for (auto&& [objectID, location] : locations) {
+        if (location.front() == LOC_DIR_PREFIX)
+            addContainerPath(objectID, location);
+    }
+
+    return changedContainers;
+}
+
 void SQLDatabase::_removeObjects(const std::vector<int32_t>& objectIDs)
 {
     auto objectIdsStr = join(objectIDs, ',');
+    objectCache->erase(objectIDs);
+    {
+        AutoLock lock(libraryStatsMutex);
+        if (libraryStatsLoaded)
+            countLibraryItems(objectIdsStr, -1);
+    }
+    {
+        AutoLock lock(updateIDMutex);
+        for (const auto& id : objectIDs) {
+            updateIDs.erase(id);
+            dirtyUpdateIDs.erase(id);
+        }
+    }
+
+    // remember the parents to fix their child_count after the delete
+    std::ostringstream parentSel;
+    parentSel << "SELECT DISTINCT " << TQ("parent_id")
+              << " FROM " << TQ(CDS_OBJECT_TABLE)
+              << " WHERE " << TQ("id") << " IN (" << objectIdsStr << ')';
+    auto parentRes = select(parentSel);
+    std::vector<int> parentIDs;
+    if (parentRes != nullptr) {
+        std::unique_ptr<SQLRow> row;
+        while ((row = parentRes->nextRow()) != nullptr)
+            parentIDs.push_back(std::stoi(row->col(0)));
+    }
     std::ostringstream sel;
     sel << "SELECT " << TQD('a', "id") << ',' << TQD('a', "persistent")
         << ',' << TQD('o', "location")
@@ -1238,11 +2509,320 @@ void SQLDatabase::_removeObjects(const std::vector<int32_t>& objectIDs)
         }
     }
 
+    // MyISAM tables don't cascade
+    std::ostringstream qState;
+    qState << "DELETE FROM " << TQ(DIRECTORY_STATE_TABLE)
+           << " WHERE " << TQ("id")
+           << " IN (" << objectIdsStr << ')';
+    exec(qState.str());
+
+    std::ostringstream qFileState;
+    qFileState << "DELETE FROM " << TQ(FILE_STATE_TABLE)
+               << " WHERE " << TQ("id")
+               << " IN (" << objectIdsStr << ')';
+    exec(qFileState.str());
+
     std::ostringstream qObject;
     qObject << "DELETE FROM " << TQ(CDS_OBJECT_TABLE)
             << " WHERE " << TQ("id")
             << " IN (" << objectIdsStr << ')';
     exec(qObject.str());
+    removeContainerPaths(objectIDs);
+
+    _refreshChildCounts(parentIDs);
+}
+
+void SQLDatabase::updatePlayStates(const std::map<int, int>& flags, const std::map<int, int>& bookmarks)
+{
+    std::vector<int> objectIDs;
+    SQLTransaction transaction(this);
+    for (auto&& [objectID, value] : flags) {
+        std::ostringstream q;
+        q << "UPDATE " << TQ(CDS_OBJECT_TABLE)
+          << " SET " << TQ("flags") << '=' << quote(value)
+          << " WHERE " << TQ("id") << '=' << quote(objectID);
+        exec(q.str());
+        objectIDs.push_back(objectID);
+    }
+    for (auto&& [objectID, value] : bookmarks) {
+        std::ostringstream q;
+        q << "UPDATE " << TQ(CDS_OBJECT_TABLE)
+          << " SET " << TQ("bookmark_pos") << '=' << quote(value)
+          << " WHERE " << TQ("id") << '=' << quote(objectID);
+        exec(q.str());
+        objectIDs.push_back(objectID);
+    }
+    transaction.commit();
+    objectCache->erase(objectIDs);
+    // the bookmarks are part of the cached browse results
+    if (!bookmarks.empty())
+        clearResultCaches();
+}
+
+/// \brief the tables of a database dump with their columns, the referenced tables first
+static const std::vector<std::pair<std::string, std::vector<std::string>>> dumpTables {
+    { CDS_OBJECT_TABLE, { "id", "ref_id", "parent_id", "object_type", "upnp_class", "dc_title", "location", "location_hash", "metadata", "auxdata", "resources", "update_id", "mime_type", "flags", "part_number", "track_number", "service_id", "bookmark_pos", "last_modified", "child_count" } },
+    { METADATA_TABLE, { "id", "item_id", "property_name", "property_value" } },
+    { AUTOSCAN_TABLE, { "id", "obj_id", "scan_level", "scan_mode", "recursive", "hidden", "interval", "last_modified", "persistent", "location", "path_ids", "touched" } },
+    { CONFIG_VALUE_TABLE, { "item", "key", "item_value", "status" } },
+    { DIRECTORY_STATE_TABLE, { "id", "mtime", "child_count" } },
+    { FILE_STATE_TABLE, { "id", "size", "inode", "birth_time", "head", "tail" } },
+};
+
+// dump numbers are little endian, strings are prefixed by their length, DUMP_NULL as length is NULL
+static void writeDumpNumber(std::ostream& out, std::uint32_t value)
+{
+    std::array<char, 4> bytes { char(value), char(value >> 8), char(value >> 16), char(value >> 24) };
+    out.write(bytes.data(), bytes.size());
+}
+
+static void writeDumpString(std::ostream& out, std::string_view value)
+{
+    writeDumpNumber(out, value.size());
+    out.write(value.data(), value.size());
+}
+
+static int readDumpByte(std::istream& in)
+{
+    auto c = in.get();
+    if (c == std::istream::traits_type::eof())
+        throw_std_runtime_error("Database dump is truncated");
+    return c;
+}
+
+static std::uint32_t readDumpNumber(std::istream& in)
+{
+    std::array<unsigned char, 4> bytes {};
+    if (!in.read(reinterpret_cast<char*>(bytes.data()), bytes.size()))
+        throw_std_runtime_error("Database dump is truncated");
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | std::uint32_t(bytes[3]) << 24;
+}
+
+static std::optional<std::string> readDumpValue(std::istream& in)
+{
+    auto length = readDumpNumber(in);
+    if (length == DUMP_NULL)
+        return std::nullopt;
+    std::string value(length, '\0');
+    if (!in.read(value.data(), length))
+        throw_std_runtime_error("Database dump is truncated");
+    return value;
+}
+
+void SQLDatabase::exportDatabase(const fs::path& path)
+{
+    std::vector<char> buffer(DUMP_BUFFER_SIZE);
+    std::ofstream out;
+    out.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw_std_runtime_error("Failed to open {} for writing: {}", path.c_str(), std::strerror(errno));
+
+    out.write(DUMP_MAGIC, sizeof(DUMP_MAGIC));
+    writeDumpNumber(out, DUMP_VERSION);
+    writeDumpString(out, getInternalSetting("db_version"));
+    for (auto&& [table, columns] : dumpTables) {
+        std::ostringstream q;
+        writeDumpString(out, table);
+        writeDumpNumber(out, columns.size());
+        for (auto&& column : columns) {
+            writeDumpString(out, column);
+            q << (q.tellp() == 0 ? "SELECT " : ",") << TQ(column);
+        }
+        q << " FROM " << TQ(table);
+
+        std::size_t rows = 0;
+        auto res = selectStreaming(q.str());
+        std::unique_ptr<SQLRow> row;
+        while (res != nullptr && (row = res->nextRow()) != nullptr) {
+            out.put(1);
+            for (std::size_t i = 0; i < columns.size(); i++) {
+                auto value = row->col_c_str(i);
+                if (value == nullptr)
+                    writeDumpNumber(out, DUMP_NULL);
+                else
+                    writeDumpString(out, value);
+            }
+            rows++;
+        }
+        out.put(0);
+        log_info("Exported {} rows of {}", rows, table);
+    }
+    // an empty table name ends the dump
+    writeDumpString(out, "");
+
+    out.close();
+    if (!out)
+        throw_std_runtime_error("Failed to write {}: {}", path.c_str(), std::strerror(errno));
+}
+
+void SQLDatabase::importDatabase(const fs::path& path)
+{
+    std::vector<char> buffer(DUMP_BUFFER_SIZE);
+    std::ifstream in;
+    in.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    in.open(path, std::ios::binary);
+    if (!in)
+        throw_std_runtime_error("Failed to open {}: {}", path.c_str(), std::strerror(errno));
+
+    std::array<char, sizeof(DUMP_MAGIC)> magic {};
+    if (!in.read(magic.data(), magic.size()) || std::memcmp(magic.data(), DUMP_MAGIC, magic.size()) != 0)
+        throw_std_runtime_error("{} is not a database dump", path.c_str());
+    auto version = readDumpNumber(in);
+    if (version != DUMP_VERSION)
+        throw_std_runtime_error("Unsupported version {} of database dump {}", version, path.c_str());
+    // the columns and their meaning change with the schema
+    auto dbVersion = readDumpValue(in).value_or("");
+    if (dbVersion != getInternalSetting("db_version"))
+        throw_std_runtime_error("Database dump {} has schema version {}, the database has {}", path.c_str(), dbVersion, getInternalSetting("db_version"));
+
+    SQLTransaction transaction(this);
+    try {
+        deferForeignKeys(true);
+        for (auto table = dumpTables.rbegin(); table != dumpTables.rend(); ++table) {
+            std::ostringstream del;
+            del << "DELETE FROM " << TQ(table->first);
+            exec(del.str());
+        }
+
+        std::string table;
+        while (!(table = readDumpValue(in).value_or("")).empty()) {
+            auto known = std::find_if(dumpTables.begin(), dumpTables.end(), [&](auto&& entry) { return entry.first == table; });
+            if (known == dumpTables.end())
+                throw_std_runtime_error("Unknown table {} in database dump", table);
+            auto columnCount = readDumpNumber(in);
+            if (columnCount == 0)
+                throw_std_runtime_error("No columns of {} in database dump", table);
+
+            std::ostringstream insert;
+            insert << "INSERT INTO " << TQ(table) << " (";
+            for (std::uint32_t i = 0; i < columnCount; i++) {
+                auto column = readDumpValue(in).value_or("");
+                if (std::find(known->second.begin(), known->second.end(), column) == known->second.end())
+                    throw_std_runtime_error("Unknown column {} of {} in database dump", column, table);
+                insert << (i == 0 ? "" : ",") << TQ(column);
+            }
+            insert << ") VALUES ";
+            auto prefix = insert.str();
+            deferIndexes(table, true);
+
+            std::size_t rows = 0;
+            std::size_t pending = 0;
+            std::ostringstream values;
+            while (readDumpByte(in) != 0) {
+                values << (pending == 0 ? "(" : ",(");
+                for (std::uint32_t i = 0; i < columnCount; i++) {
+                    auto value = readDumpValue(in);
+                    values << (i == 0 ? "" : ",") << (value.has_value() ? quote(value.value()) : SQL_NULL);
+                }
+                values << ')';
+                rows++;
+                if (isInsertFull(++pending, values.tellp())) {
+                    exec(prefix + values.str());
+                    values.str("");
+                    pending = 0;
+                }
+            }
+            if (pending > 0)
+                exec(prefix + values.str());
+            deferIndexes(table, false);
+            log_info("Imported {} rows into {}", rows, table);
+        }
+        deferForeignKeys(false);
+    } catch (const std::runtime_error& e) {
+        try {
+            for (auto&& [name, columns] : dumpTables)
+                deferIndexes(name, false);
+            deferForeignKeys(false);
+        } catch (const std::runtime_error&) {
+        }
+        throw;
+    }
+    transaction.commit();
+
+    objectCache->clear();
+    clearResultCaches();
+    {
+        AutoLock lock(libraryStatsMutex);
+        libraryStats.clear();
+        libraryStatsLoaded = false;
+    }
+    {
+        AutoLock lock(updateIDMutex);
+        updateIDs.clear();
+        dirtyUpdateIDs.clear();
+    }
+}
+
+bool SQLDatabase::isInsertFull(std::size_t rows, std::size_t length) const
+{
+    return rows >= MAX_INSERT_ROWS;
+}
+
+std::future<void> SQLDatabase::execAsync(const std::string& query)
+{
+    std::promise<void> done;
+    try {
+        exec(query);
+        done.set_value();
+    } catch (const std::runtime_error& e) {
+        log_error("{}", e.what());
+        done.set_exception(std::current_exception());
+    }
+    return done.get_future();
+}
+
+void SQLDatabase::clearResultCaches()
+{
+    {
+        AutoLock lock(browseCursorMutex);
+        browseCursors.clear();
+    }
+    AutoLock lock(searchCountMutex);
+    searchCounts.clear();
+}
+
+void SQLDatabase::_changeChildCount(int containerID, int delta)
+{
+    clearResultCaches();
+    std::ostringstream q;
+    q << "UPDATE " << TQ(CDS_OBJECT_TABLE)
+      << " SET " << TQ("child_count") << '=' << TQ("child_count") << (delta < 0 ? '-' : '+') << std::abs(delta)
+      << " WHERE " << TQ("id") << '=' << containerID;
+    exec(q.str());
+}
+
+void SQLDatabase::_refreshChildCounts(const std::vector<int>& containerIDs)
+{
+    clearResultCaches();
+    if (containerIDs.empty())
+        return;
+
+    std::map<int, int> counts;
+    std::ostringstream qCount;
+    qCount << "SELECT " << TQ("parent_id") << ", COUNT(*) FROM " << TQ(CDS_OBJECT_TABLE)
+           << " WHERE " << TQ("parent_id") << " IN (" << toCSV(containerIDs) << ")"
+           << " GROUP BY " << TQ("parent_id");
+    auto res = select(qCount);
+    if (res == nullptr)
+        throw_std_runtime_error("db error");
+    std::unique_ptr<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr)
+        counts[std::stoi(row->col(0))] = std::stoi(row->col(1));
+
+    std::ostringstream q;
+    q << "UPDATE " << TQ(CDS_OBJECT_TABLE) << " SET " << TQ("child_count") << '=';
+    if (counts.empty()) {
+        // CASE needs at least one WHEN
+        q << '0';
+    } else {
+        q << "CASE " << TQ("id");
+        for (auto&& [id, count] : counts)
+            q << " WHEN " << id << " THEN " << count;
+        q << " ELSE 0 END";
+    }
+    q << " WHERE " << TQ("id") << " IN (" << toCSV(containerIDs) << ')';
+    exec(q.str());
 }
 
 std::unique_ptr<Database::ChangedContainers> SQLDatabase::removeObject(int objectID, bool all)
@@ -1287,6 +2867,9 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::_recursiveRemove(
     const std::vector<int32_t>& items, const std::vector<int32_t>& containers,
     bool all)
 {
+    if (supportsRecursiveQueries())
+        return _recursiveRemoveSubtree(items, containers, all);
+
     log_debug("start");
     std::ostringstream itemsSql;
     itemsSql << "SELECT DISTINCT " << TQ("id") << ',' << TQ("parent_id")
@@ -1318,7 +2901,7 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::_recursiveRemove(
         parentIds.insert(parentIds.end(), containers.begin(), containers.end());
         std::ostringstream sql;
         sql << parentsSql.str() << join(parentIds, ',') << ')';
-        res = select(sql);
+        res = selectStreaming(sql.str());
         if (res == nullptr)
             throw DatabaseException("", "sql error");
         parentIds.clear();
@@ -1334,7 +2917,7 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::_recursiveRemove(
             removeIds.insert(removeIds.end(), parentIds.begin(), parentIds.end());
             std::ostringstream sql;
             sql << parentsSql.str() << join(parentIds, ',') << ')';
-            res = select(sql);
+            res = selectStreaming(sql.str());
             if (res == nullptr)
                 throw DatabaseException("", std::string("sql error: ") + sql.str());
             parentIds.clear();
@@ -1346,7 +2929,7 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::_recursiveRemove(
         if (!itemIds.empty()) {
             std::ostringstream sql;
             sql << itemsSql.str() << join(itemIds, ',') << ')';
-            res = select(sql);
+            res = selectStreaming(sql.str());
             if (res == nullptr)
                 throw DatabaseException("", std::string("sql error: ") + sql.str());
             itemIds.clear();
@@ -1359,7 +2942,7 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::_recursiveRemove(
         if (!containerIds.empty()) {
             std::ostringstream sql;
             sql << containersSql.str() << join(containerIds, ',') << ')';
-            res = select(sql);
+            res = selectStreaming(sql.str());
             if (res == nullptr)
                 throw DatabaseException("", std::string("sql error: ") + sql.str());
             containerIds.clear();
@@ -1402,6 +2985,96 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::_recursiveRemove(
     return changedContainers;
 }
 
+std::unique_ptr<Database::ChangedContainers> SQLDatabase::_recursiveRemoveSubtree(
+    const std::vector<int32_t>& items, const std::vector<int32_t>& containers,
+    bool all)
+{
+    log_debug("start");
+    auto changedContainers = std::make_unique<ChangedContainers>();
+    std::vector<int32_t> startIds(items);
+    startIds.insert(startIds.end(), containers.begin(), containers.end());
+    if (startIds.empty())
+        return changedContainers;
+
+    // children and references of everything in the subtree, with all also the originals of references below the start
+    std::ostringstream sql;
+    sql << "WITH RECURSIVE " << TQ("subtree") << '(' << TQ("id") << ',' << TQ("ref_id") << ',' << TQ("parent_id") << ',' << TQ("nested") << ") AS ("
+        << "SELECT " << TQ("id") << ',' << TQ("ref_id") << ',' << TQ("parent_id") << ",0"
+        << " FROM " << TQ(CDS_OBJECT_TABLE) << " WHERE " << TQ("id") << " IN (" << join(startIds, ',') << ')'
+        << " UNION SELECT " << TQD('o', "id") << ',' << TQD('o', "ref_id") << ',' << TQD('o', "parent_id") << ",1"
+        << " FROM " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('o') << " JOIN " << TQ("subtree") << ' ' << TQ('s')
+        << " ON " << TQD('o', "parent_id") << '=' << TQD('s', "id")
+        << " OR " << TQD('o', "ref_id") << '=' << TQD('s', "id");
+    if (all)
+        sql << " OR (" << TQD('s', "nested") << "=1 AND " << TQD('o', "id") << '=' << TQD('s', "ref_id") << ')';
+    sql << ") SELECT " << TQ("id") << ',' << TQ("parent_id") << ',' << TQ("nested") << " FROM " << TQ("subtree");
+
+    auto res = selectStreaming(sql.str());
+    if (res == nullptr)
+        throw DatabaseException("", std::string("sql error: ") + sql.str());
+
+    std::unordered_set<int32_t> removeSet;
+    std::vector<int32_t> removeIds;
+    std::unordered_set<int32_t> startParents;
+    std::unordered_set<int32_t> nestedParents;
+    std::unique_ptr<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr) {
+        int32_t id = std::stoi(row->col(0));
+        std::string parentId = row->col(1);
+        if (!parentId.empty())
+            (row->col(2) == "0" ? startParents : nestedParents).insert(std::stoi(parentId));
+        if (removeSet.insert(id).second)
+            removeIds.push_back(id);
+    }
+
+    // same split as the level by level removal: parents of removed containers are changed in the ui, the others for upnp
+    auto& startChanged = containers.empty() ? changedContainers->upnp : changedContainers->ui;
+    for (auto&& parentId : startParents) {
+        if (removeSet.find(parentId) == removeSet.end())
+            startChanged.push_back(parentId);
+    }
+    for (auto&& parentId : nestedParents) {
+        if (removeSet.find(parentId) == removeSet.end())
+            changedContainers->upnp.push_back(parentId);
+    }
+
+    for (std::size_t offset = 0; offset < removeIds.size(); offset += MAX_REMOVE_SIZE) {
+        auto last = removeIds.begin() + std::min(removeIds.size(), offset + MAX_REMOVE_SIZE);
+        _removeObjects(std::vector<int32_t>(removeIds.begin() + offset, last));
+    }
+    log_debug("end");
+    return changedContainers;
+}
+
+Metrics::Histogram& SQLDatabase::queryDuration(std::string_view query)
+{
+    static constexpr std::array<std::string_view, 4> statements { "SELECT", "INSERT", "UPDATE", "DELETE" };
+    static const auto histograms = [] {
+        std::array<Metrics::Histogram*, statements.size() + 1> result {};
+        for (std::size_t i = 0; i <= statements.size(); i++) {
+            auto statement = i < statements.size() ? statements.at(i) : "other";
+            result.at(i) = &Metrics::getInstance().histogram("gerbera_db_query_duration_seconds", "Time to run database queries", Metrics::label("statement", statement));
+        }
+        return result;
+    }();
+
+    auto start = query.find_first_not_of(" \t\r\n(");
+    query.remove_prefix(std::min(start, query.size()));
+    for (std::size_t i = 0; i < statements.size(); i++) {
+        if (query.size() >= statements.at(i).size() && strncasecmp(query.data(), statements.at(i).data(), statements.at(i).size()) == 0)
+            return *histograms.at(i);
+    }
+    return *histograms.back();
+}
+
+SQLDatabase::QueryTimer::~QueryTimer()
+{
+    auto duration = std::chrono::steady_clock::now() - start;
+    queryDuration(query).observe(duration);
+    if (database->queryProfiler->isEnabled())
+        database->queryProfiler->record(query, rows, duration);
+}
+
 std::string SQLDatabase::toCSV(const std::vector<int>& input)
 {
     return join(input, ",");
@@ -1417,15 +3090,13 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::_purgeEmptyContainers(
         return changedContainers;
 
     std::ostringstream selectSql;
-    selectSql << "SELECT " << TQD('a', "id")
-              << ", COUNT(" << TQD('b', "parent_id")
-              << ")," << TQD('a', "parent_id") << ',' << TQD('a', "flags")
-              << " FROM " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('a')
-              << " LEFT JOIN " << TQ(CDS_OBJECT_TABLE) << ' ' << TQ('b')
-              << " ON " << TQD('a', "id") << '=' << TQD('b', "parent_id")
-              << " WHERE " << TQD('a', "object_type") << '=' << quote(1)
-              << " AND " << TQD('a', "id") << " IN ("; //(a.flags & " << OBJECT_FLAG_PERSISTENT_CONTAINER << ") = 0 AND
-    std::string strSel2(") GROUP BY a.id"); // HAVING COUNT(b.parent_id)=0");
+    selectSql << "SELECT " << TQ("id")
+              << ',' << TQ("child_count")
+              << ',' << TQ("parent_id") << ',' << TQ("flags")
+              << " FROM " << TQ(CDS_OBJECT_TABLE)
+              << " WHERE " << TQ("object_type") << '=' << quote(1)
+              << " AND " << TQ("id") << " IN (";
+    std::string strSel2(")");
 
     std::ostringstream bufSelUpnp;
     bufSelUpnp << selectSql.str();
@@ -1452,7 +3123,7 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::_purgeEmptyContainers(
             std::ostringstream sql;
             sql << selectSql.str() << join(selUpnp, ',') << strSel2;
             log_debug("upnp-sql: {}", sql.str().c_str());
-            res = select(sql.str());
+            res = selectStreaming(sql.str());
             selUpnp.clear();
             if (res == nullptr)
                 throw_std_runtime_error("db error");
@@ -1473,7 +3144,7 @@ std::unique_ptr<Database::ChangedContainers> SQLDatabase::_purgeEmptyContainers(
             std::ostringstream sql;
             sql << selectSql.str() << join(selUi, ',') << strSel2;
             log_debug("ui-sql: {}", sql.str().c_str());
-            res = select(sql.str());
+            res = selectStreaming(sql.str());
             selUi.clear();
             if (res == nullptr)
                 throw_std_runtime_error("db error");
@@ -1765,6 +3436,8 @@ void SQLDatabase::addAutoscanDirectory(std::shared_ptr<AutoscanDirectory> adir)
 {
     if (adir == nullptr)
         throw_std_runtime_error("addAutoscanDirectory called with adir==nullptr");
+    // cached containers carry their autoscan type
+    objectCache->clear();
     if (adir->getDatabaseID() >= 0)
         throw_std_runtime_error("tried to add autoscan directory with a database id set");
     int objectID;
@@ -1810,6 +3483,7 @@ void SQLDatabase::updateAutoscanDirectory(std::shared_ptr<AutoscanDirectory> adi
 {
     if (adir == nullptr)
         throw_std_runtime_error("updateAutoscanDirectory called with adir==nullptr");
+    objectCache->clear();
 
     log_debug("id: {}, obj_id: {}", adir->getDatabaseID(), adir->getObjectID());
 
@@ -1848,6 +3522,7 @@ void SQLDatabase::removeAutoscanDirectory(std::shared_ptr<AutoscanDirectory> adi
 
 void SQLDatabase::_removeAutoscanDirectory(int autoscanID)
 {
+    objectCache->clear();
     if (autoscanID == INVALID_OBJECT_ID)
         return;
     int objectID = _getAutoscanObjectID(autoscanID);
@@ -1886,6 +3561,7 @@ void SQLDatabase::_autoscanChangePersistentFlag(int objectID, bool persistent)
       << OBJECT_FLAG_PERSISTENT_CONTAINER
       << ") WHERE " << TQ("id") << '=' << quote(objectID);
     exec(q.str());
+    objectCache->erase({ objectID });
 }
 
 void SQLDatabase::checkOverlappingAutoscans(std::shared_ptr<AutoscanDirectory> adir)
@@ -2026,6 +3702,7 @@ void SQLDatabase::setFsRootName(const std::string& rootName)
 
 void SQLDatabase::clearFlagInDB(int flag)
 {
+    objectCache->clear();
     std::ostringstream qb;
     qb << "UPDATE "
        << TQ(CDS_OBJECT_TABLE)
@@ -2040,6 +3717,26 @@ void SQLDatabase::clearFlagInDB(int flag)
     exec(qb.str());
 }
 
+std::vector<int> SQLDatabase::getFlaggedObjectIDs(int flag)
+{
+    std::ostringstream qb;
+    qb << "SELECT " << TQ("id")
+       << " FROM " << TQ(CDS_OBJECT_TABLE)
+       << " WHERE " << TQ("flags")
+       << "&" << flag;
+
+    auto res = selectStreaming(qb.str());
+    if (res == nullptr)
+        throw_std_runtime_error("db error");
+
+    std::vector<int> objectIDs;
+    std::unique_ptr<SQLRow> row;
+    while ((row = res->nextRow()) != nullptr) {
+        objectIDs.push_back(std::stoi(row->col(0)));
+    }
+    return objectIDs;
+}
+
 void SQLDatabase::generateMetadataDBOperations(const std::shared_ptr<CdsObject>& obj, Operation op,
     std::vector<std::shared_ptr<AddUpdateTable>>& operations)
 {
@@ -2055,7 +3752,10 @@ void SQLDatabase::generateMetadataDBOperations(const std::shared_ptr<CdsObject>&
         // get current metadata from DB: if only it really was a dictionary...
         auto dbMetadata = retrieveMetadataForObject(obj->getID());
         for (const auto& [key, val] : dict) {
-            Operation operation = dbMetadata.count(key) ? Operation::Update : Operation::Insert;
+            auto stored = dbMetadata.find(key);
+            if (stored != dbMetadata.end() && stored->second == val)
+                continue;
+            Operation operation = stored != dbMetadata.end() ? Operation::Update : Operation::Insert;
             std::map<std::string, std::string> metadataSql;
             metadataSql["property_name"] = quote(key);
             metadataSql["property_value"] = quote(val);
@@ -2122,11 +3822,11 @@ std::unique_ptr<std::ostringstream> SQLDatabase::sqlForUpdate(const std::shared_
         *qb << TQ(it->first) << '='
             << it->second;
     }
-    *qb << " WHERE " << TQ("id") << " = " << obj->getID();
-
-    // relying on only one element when tableName is mt_metadata
+    // the rows of the metadata table belong to the object by item_id
     if (tableName == METADATA_TABLE)
-        *qb << " AND " << TQ("property_name") << " = " << dict.begin()->first;
+        *qb << " WHERE " << TQ("item_id") << " = " << obj->getID() << " AND " << TQ("property_name") << " = " << dict["property_name"];
+    else
+        *qb << " WHERE " << TQ("id") << " = " << obj->getID();
 
     return qb;
 }
@@ -2141,18 +3841,18 @@ std::unique_ptr<std::ostringstream> SQLDatabase::sqlForDelete(const std::shared_
     auto dict = addUpdateTable->getDict();
 
     auto qb = std::make_unique<std::ostringstream>();
-    *qb << "DELETE FROM " << TQ(tableName)
-        << " WHERE " << TQ("id") << " = " << obj->getID();
-
-    // relying on only one element when tableName is mt_metadata
+    *qb << "DELETE FROM " << TQ(tableName);
     if (tableName == METADATA_TABLE)
-        *qb << " AND " << TQ("property_name") << " = " << dict.begin()->first;
+        *qb << " WHERE " << TQ("item_id") << " = " << obj->getID() << " AND " << TQ("property_name") << " = " << dict["property_name"];
+    else
+        *qb << " WHERE " << TQ("id") << " = " << obj->getID();
 
     return qb;
 }
 
 void SQLDatabase::doMetadataMigration()
 {
+    objectCache->clear();
     log_debug("Checking if metadata migration is required");
     std::ostringstream qbCountNotNull;
     qbCountNotNull << "SELECT COUNT(*)"
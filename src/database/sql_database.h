@@ -32,12 +32,20 @@
 #ifndef __SQL_STORAGE_H__
 #define __SQL_STORAGE_H__
 
+#include <ctime>
+#include <future>
 #include <mutex>
 #include <sstream>
+#include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <variant>
 
 #include "database.h"
+#include "object_cache.h"
+#include "query_profiler.h"
+#include "util/metrics.h"
 
 // forward declaration
 class SQLResult;
@@ -51,6 +59,10 @@ class SQLEmitter;
 #define AUTOSCAN_TABLE "mt_autoscan"
 #define METADATA_TABLE "mt_metadata"
 #define CONFIG_VALUE_TABLE "grb_config_value"
+#define DIRECTORY_STATE_TABLE "grb_directory_state"
+#define FILE_STATE_TABLE "grb_file_state"
+#define SCROBBLE_TABLE "grb_scrobble"
+#define CHANGE_LOG_TABLE "grb_change_log"
 
 class SQLRow {
 public:
@@ -65,9 +77,19 @@ public:
     }
     virtual char* col_c_str(int index) const = 0;
 
+    /// \brief column value without a copy, valid until the next row is fetched
+    std::string_view colView(int index) const
+    {
+        const char* c = col_c_str(index);
+        return c ? std::string_view(c) : std::string_view();
+    }
+
     virtual ~SQLRow() = default;
 };
 
+/// \brief A typed parameter bound to a '?' placeholder of a prepared statement, std::monostate binds NULL
+using SQLParam = std::variant<std::monostate, int, long long, std::string>;
+
 class SQLResult {
 public:
     //SQLResult();
@@ -91,10 +113,22 @@ public:
 
     virtual void beginTransaction() = 0;
     virtual void commit() = 0;
+    virtual void rollback() = 0;
 
     virtual std::shared_ptr<SQLResult> select(const char* query, int length) = 0;
     virtual int exec(const char* query, int length, bool getLastInsertId = false) = 0;
 
+    /// \brief run a select through the prepared statement cache of the driver
+    /// \param query SQL text with '?' placeholders, the text is the cache key so it must not contain literal values
+    /// \param params values bound to the placeholders in order
+    virtual std::shared_ptr<SQLResult> selectPrepared(const std::string& query, const std::vector<SQLParam>& params) = 0;
+
+    /// \brief run a select whose rows are fetched while they are read instead of all at once
+    ///
+    /// getNumRows() only counts the rows read so far. The result has to be read to the end or dropped
+    /// before the next write, drivers without cursors return a buffered result.
+    virtual std::shared_ptr<SQLResult> selectStreaming(const std::string& query) { return select(query); }
+
     /* wrapper functions for select and exec */
     std::shared_ptr<SQLResult> select(const std::string& buf)
     {
@@ -110,19 +144,46 @@ public:
         return exec(query.c_str(), query.length(), getLastInsertId);
     }
 
+    /// \brief queue a write without waiting for it, later reads still see its result
+    ///
+    /// The default runs the statement right away, drivers with a writer thread queue it instead
+    virtual std::future<void> execAsync(const std::string& query);
+
     void addObject(std::shared_ptr<CdsObject> object, int* changedContainer) override;
-    void updateObject(std::shared_ptr<CdsObject> object, int* changedContainer) override;
+    void addObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, int* changedContainer) override;
+    bool updateObject(std::shared_ptr<CdsObject> object, int* changedContainer) override;
+    void updatePlayStates(const std::map<int, int>& flags, const std::map<int, int>& bookmarks) override;
+    void exportDatabase(const fs::path& path) override;
+    void importDatabase(const fs::path& path) override;
 
     std::shared_ptr<CdsObject> loadObject(int objectID) override;
     int getChildCount(int contId, bool containers, bool items, bool hideFsRoot) override;
 
     std::unique_ptr<std::unordered_set<int>> getObjects(int parentID, bool withoutContainer) override;
+    std::vector<int> getSubtreeItems(int containerID, std::size_t limit) override;
+    std::vector<int> getItemIDs(int afterID, std::size_t limit) override;
+    int addShadowContainer(const std::string& title) override;
+    std::unique_ptr<ChangedContainers> swapShadowContainer(int shadowID) override;
+    std::unordered_map<std::string, ObjectStat> getChildStats(int parentID, bool withoutContainer) override;
+    bool isDirectoryUnchanged(int objectID, time_t mtime) override;
+    void setDirectoryState(int objectID, time_t mtime) override;
+    bool getFileState(int objectID, FileState& state) override;
+    void setFileState(int objectID, const FileState& state) override;
 
     std::unique_ptr<ChangedContainers> removeObject(int objectID, bool all) override;
     std::unique_ptr<ChangedContainers> removeObjects(const std::unique_ptr<std::unordered_set<int>>& list, bool all = false) override;
+    std::unique_ptr<ChangedContainers> relocateSubtree(const fs::path& oldPath, const fs::path& newPath) override;
 
     std::shared_ptr<CdsObject> loadObjectByServiceID(const std::string& serviceID) override;
-    std::unique_ptr<std::vector<int>> getServiceObjectIDs(char servicePrefix) override;
+    std::map<std::string, ServiceObject> getServiceObjects(char servicePrefix) override;
+    void storeScrobbles(const std::vector<Scrobble>& scrobbles) override;
+    std::vector<Scrobble> takeScrobbles() override;
+    std::int64_t getChangeLogSequence() override;
+    ChangeLog readChangeLog(const ChangeLog& previous) override;
+
+    void runMaintenance() override;
+    std::string getMaintenanceStatus() override;
+    void storeUpdateIDs() override;
 
     /* accounting methods */
     int getTotalFiles(bool isVirtual = false, const std::string& mimeType = "", const std::string& upnpClass = "") override;
@@ -161,11 +222,16 @@ public:
     void shutdown() override;
     virtual void shutdownDriver() = 0;
 
+    void warmUpIndexes() override;
+
     int ensurePathExistence(fs::path path, int* changedContainer) override;
 
     std::string getFsRootName() override;
 
     void clearFlagInDB(int flag) override;
+    std::vector<int> getFlaggedObjectIDs(int flag) override;
+
+    std::shared_ptr<QueryProfiler> getQueryProfiler() override { return queryProfiler; }
 
 protected:
     explicit SQLDatabase(std::shared_ptr<Config> config);
@@ -178,12 +244,111 @@ protected:
     char table_quote_begin;
     char table_quote_end;
 
+    /// \brief latency histogram of the statement type the query starts with
+    static Metrics::Histogram& queryDuration(std::string_view query);
+
+    /// \brief times a query for the metrics and the query profiler until it goes out of scope
+    class QueryTimer {
+    public:
+        QueryTimer(const SQLDatabase* database, std::string_view query)
+            : database(database)
+            , query(query)
+        {
+        }
+        ~QueryTimer();
+
+        /// \brief rows returned by the query
+        void setRows(long long rows) { this->rows = rows; }
+
+    private:
+        const SQLDatabase* database;
+        std::string_view query;
+        long long rows { -1 };
+        std::chrono::steady_clock::time_point start { std::chrono::steady_clock::now() };
+    };
+
+    /// \brief switch search to the full-text index if it is enabled in the config, called by the drivers once the database is ready
+    void initFulltextSearch();
+    /// \brief hash the locations marked with location_hash -1 by the schema upgrade again, called by the drivers after the upgrades
+    void migrateLocationHashes();
+    /// \brief create the full-text index if it is missing, returns the emitter using it or nullptr if the driver has none
+    virtual std::shared_ptr<SQLEmitter> prepareFulltextSearch() { return nullptr; }
+    /// \brief whether the database understands WITH RECURSIVE, removals collect whole subtrees with one query then
+    virtual bool supportsRecursiveQueries() { return false; }
+    /// \brief queries scanning the indexes used by browsing, run by warmUpIndexes()
+    virtual std::vector<std::string> getWarmUpQueries() const { return {}; }
+    /// \brief check the foreign keys at the commit of the current transaction or not at all, an import adds children before their parents
+    virtual void deferForeignKeys(bool defer) { }
+    /// \brief driver specific maintenance statements of runMaintenance(), returns a summary of what was done
+    virtual std::string maintain() { return {}; }
+    /// \brief stop updating the secondary indexes of a table while rows are loaded into it and build them at the end
+    virtual void deferIndexes(const std::string& table, bool defer) { }
+    /// \brief whether a multi-row INSERT into the object table assigns consecutive ids and returns the first one
+    ///
+    /// addObjects then inserts the rows of a batch together instead of one by one.
+    virtual bool hasConsecutiveInsertIds() const { return false; }
+    /// \brief whether a multi-row INSERT of \p rows rows and \p length bytes has to run before more rows are added
+    virtual bool isInsertFull(std::size_t rows, std::size_t length) const;
+
 private:
     std::string sql_query;
 
-    std::shared_ptr<CdsObject> createObjectFromRow(const std::unique_ptr<SQLRow>& row);
-    std::shared_ptr<CdsObject> createObjectFromSearchRow(const std::unique_ptr<SQLRow>& row);
+    using MetadataMap = std::map<int, std::map<std::string, std::string>>;
+    /// \brief metadata is loaded per object unless it has been fetched for the whole result with retrieveMetadataForObjects
+    /// \param projection BROWSE_NO_* flags naming the columns that are not decoded
+    std::shared_ptr<CdsObject> createObjectFromRow(const std::unique_ptr<SQLRow>& row, const MetadataMap* metadata = nullptr, unsigned int projection = 0);
+    std::shared_ptr<CdsObject> createObjectFromSearchRow(const std::unique_ptr<SQLRow>& row, const MetadataMap* metadata = nullptr);
     std::map<std::string, std::string> retrieveMetadataForObject(int objectId);
+    /// \brief metadata of all objects with one query, objects without metadata are missing from the result
+    MetadataMap retrieveMetadataForObjects(const std::vector<int>& objectIds);
+    /// \brief number of children for each of the containers, containers without children are missing from the result
+    std::map<int, int> getChildCounts(const std::vector<int>& contIds, bool containers, bool items, bool hideFsRoot);
+
+    /// \brief sort key of the last row of a browse page, lets the following page seek instead of skipping rows
+    using BrowseCursorKey = std::tuple<int, int, int, std::string>; // objectID, flags, starting index of the next page, sort criteria
+    std::map<BrowseCursorKey, std::vector<SQLParam>> browseCursors;
+    std::mutex browseCursorMutex;
+    /// \brief generated SQL per search, keyed by the normalized criteria, the tree does not change it
+    std::map<std::string, std::string> searchQueries;
+    std::mutex searchQueryMutex;
+    /// \brief SQL of the search criteria, lexed, parsed and emitted only for unknown criteria
+    std::string getSearchSQL(const std::string& searchCriteria);
+    /// \brief number of matches per search, keyed by the generated SQL
+    std::map<std::string, int> searchCounts;
+    std::mutex searchCountMutex;
+    /// \brief forget browse cursors and search counts, called on every change of the tree
+    void clearResultCaches();
+
+    /// \brief the columns of an item getTotalFiles and getMimeTypes look at, as they are stored
+    using LibraryKey = std::tuple<char, std::string, std::string>; // first character of the location, mime type, upnp class
+    /// \brief number of items per key, read with the first request and then kept up to date by adding and removing objects
+    std::map<LibraryKey, int> libraryStats;
+    bool libraryStatsLoaded { false };
+    std::mutex libraryStatsMutex;
+    /// \brief add sign times the number of items per key of objectIDs, or of all objects if empty, libraryStatsMutex is held
+    void countLibraryItems(const std::string& objectIDs, int sign);
+    void changeLibraryStats(const std::vector<LibraryKey>& keys, int delta);
+
+    /// \brief result of the last runMaintenance() for the web UI
+    std::string maintenanceStatus;
+    std::mutex maintenanceMutex;
+
+    /// \brief container update ids counted in memory, written back to the database by flushUpdateIDs
+    std::unordered_map<int, int> updateIDs;
+    std::unordered_set<int> dirtyUpdateIDs;
+    std::mutex updateIDMutex;
+    /// \brief write changed update ids and evict written ones above UPDATE_ID_CACHE_SIZE, updateIDMutex has to be held
+    void flushUpdateIDs(bool wait);
+    /// \brief update id of the container, the in memory value if it is newer than the stored one
+    int getUpdateID(int objectID, int storedUpdateID);
+
+    /// \brief node name written to the change log, empty if the database is not shared by a cluster
+    std::string clusterNode;
+    /// \brief whether this node removes old entries from the change log
+    bool pruneChangeLog { false };
+    struct timespec lastChangeLogPrune {};
+    /// \brief add the changed update ids for the other nodes, updateIDMutex has to be held
+    void writeChangeLog(const std::string& updateIDs);
 
     enum class Operation {
         Insert,
@@ -209,7 +374,8 @@ private:
         std::map<std::string, std::string> dict;
         Operation operation;
     };
-    std::vector<std::shared_ptr<AddUpdateTable>> _addUpdateObject(const std::shared_ptr<CdsObject>& obj, Operation op, int* changedContainer);
+    /// \param libraryKey set to the columns of an item that count in the library statistics
+    std::vector<std::shared_ptr<AddUpdateTable>> _addUpdateObject(const std::shared_ptr<CdsObject>& obj, Operation op, int* changedContainer, LibraryKey* libraryKey = nullptr);
 
     void generateMetadataDBOperations(const std::shared_ptr<CdsObject>& obj, Operation op,
         std::vector<std::shared_ptr<AddUpdateTable>>& operations);
@@ -221,11 +387,18 @@ private:
     /* helper for removeObject(s) */
     void _removeObjects(const std::vector<int32_t>& objectIDs);
 
+    /* helpers for the child_count column */
+    void _changeChildCount(int containerID, int delta);
+    void _refreshChildCounts(const std::vector<int>& containerIDs);
+
     static std::string toCSV(const std::vector<int>& input);
 
     std::unique_ptr<ChangedContainers> _recursiveRemove(
         const std::vector<int32_t>& items,
         const std::vector<int32_t>& containers, bool all);
+    std::unique_ptr<ChangedContainers> _recursiveRemoveSubtree(
+        const std::vector<int32_t>& items,
+        const std::vector<int32_t>& containers, bool all);
 
     virtual std::unique_ptr<ChangedContainers> _purgeEmptyContainers(std::unique_ptr<ChangedContainers>& maybeEmpty);
 
@@ -251,8 +424,43 @@ private:
 
     std::string fsRootName;
     std::shared_ptr<SQLEmitter> sqlEmitter;
+    /// \brief objects of loadObject and findObjectByPath, every write to mt_cds_object has to invalidate its entries
+    std::unique_ptr<ObjectCache> objectCache;
+    std::shared_ptr<QueryProfiler> queryProfiler;
+
+    /// \brief ids of all filesystem containers by database location, loaded on first use and kept in sync by createContainer and _removeObjects
+    std::unordered_map<std::string, int> containerPaths;
+    std::unordered_map<int, std::string> containerLocations;
+    bool containerPathsLoaded { false };
+    std::mutex containerPathMutex;
+    /// \brief id of the filesystem container with the database location, INVALID_OBJECT_ID if there is none
+    int findContainerIDByLocation(const std::string& dbLocation);
+    void addContainerPath(int objectID, const std::string& dbLocation);
+    void removeContainerPaths(const std::vector<int32_t>& objectIDs);
+    /// \brief drop the index, it is reloaded on the next lookup
+    void clearContainerPaths();
 
     using AutoLock = std::lock_guard<std::mutex>;
 };
 
+/// \brief A transaction of a SQLDatabase that is rolled back unless it was committed
+///
+/// Leaving the scope by an exception releases the transaction, a nested
+/// transaction that is rolled back makes the outer one roll back as well.
+class SQLTransaction {
+public:
+    /// \param active false for a guard that does nothing, for callers that only sometimes need a transaction
+    explicit SQLTransaction(SQLDatabase* database, bool active = true);
+    ~SQLTransaction();
+
+    SQLTransaction(const SQLTransaction&) = delete;
+    SQLTransaction& operator=(const SQLTransaction&) = delete;
+
+    void commit();
+    void rollback();
+
+private:
+    SQLDatabase* database;
+};
+
 #endif // __SQL_STORAGE_H__
@@ -1,3 +1,4 @@
+PRAGMA auto_vacuum = INCREMENTAL;
 BEGIN TRANSACTION;
 CREATE TABLE "mt_cds_object" (
   "id" integer primary key,
@@ -7,7 +8,7 @@ CREATE TABLE "mt_cds_object" (
   "upnp_class" varchar(80) default NULL,
   "dc_title" varchar(255) default NULL,
   "location" text default NULL,
-  "location_hash" integer unsigned default NULL,
+  "location_hash" integer default NULL,
   "metadata" text default NULL,
   "auxdata" text default NULL,
   "resources" text default NULL,
@@ -19,17 +20,18 @@ CREATE TABLE "mt_cds_object" (
   "service_id" varchar(255) default NULL,
   "bookmark_pos" integer unsigned NOT NULL default 0,
   "last_modified" integer unsigned default NULL,
+  "child_count" integer NOT NULL default 0,
   CONSTRAINT "cds_object_ibfk_1" FOREIGN KEY ("ref_id") REFERENCES "mt_cds_object" ("id") ON DELETE CASCADE ON UPDATE CASCADE,
   CONSTRAINT "cds_object_ibfk_2" FOREIGN KEY ("parent_id") REFERENCES "mt_cds_object" ("id") ON DELETE CASCADE ON UPDATE CASCADE
 );
-INSERT INTO "mt_cds_object" VALUES(-1, NULL, -1, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, NULL, 9, NULL, NULL, NULL, 0, NULL);
-INSERT INTO "mt_cds_object" VALUES(0, NULL, -1, 1, 'object.container', 'Root', NULL, NULL, NULL, NULL, NULL, 0, NULL, 9, NULL, NULL, NULL, 0, NULL);
-INSERT INTO "mt_cds_object" VALUES(1, NULL, 0, 1, 'object.container', 'PC Directory', NULL, NULL, NULL, NULL, NULL, 0, NULL, 9, NULL, NULL, NULL, 0, NULL);
+INSERT INTO "mt_cds_object" VALUES(-1, NULL, -1, 0, NULL, NULL, NULL, NULL, NULL, NULL, NULL, 0, NULL, 9, NULL, NULL, NULL, 0, NULL, 2);
+INSERT INTO "mt_cds_object" VALUES(0, NULL, -1, 1, 'object.container', 'Root', NULL, NULL, NULL, NULL, NULL, 0, NULL, 9, NULL, NULL, NULL, 0, NULL, 1);
+INSERT INTO "mt_cds_object" VALUES(1, NULL, 0, 1, 'object.container', 'PC Directory', NULL, NULL, NULL, NULL, NULL, 0, NULL, 9, NULL, NULL, NULL, 0, NULL, 0);
 CREATE TABLE "mt_internal_setting" (
   "key" varchar(40) primary key NOT NULL,
   "value" varchar(255) NOT NULL
 );
-INSERT INTO "mt_internal_setting" VALUES('db_version', '10');
+INSERT INTO "mt_internal_setting" VALUES('db_version', '19');
 CREATE TABLE "mt_autoscan" (
   "id" integer primary key,
   "obj_id" integer default NULL,
@@ -57,6 +59,36 @@ CREATE TABLE "grb_config_value" (
   "key" varchar(255) NOT NULL,
   "item_value" varchar(255) NOT NULL,
   "status" varchar(20) NOT NULL);
+CREATE TABLE "grb_directory_state" (
+  "id" integer primary key,
+  "mtime" integer unsigned NOT NULL,
+  "child_count" integer NOT NULL,
+  CONSTRAINT "grb_directory_state_fk" FOREIGN KEY ("id") REFERENCES "mt_cds_object" ("id") ON DELETE CASCADE ON UPDATE CASCADE
+);
+CREATE TABLE "grb_file_state" (
+  "id" integer primary key,
+  "size" integer NOT NULL,
+  "inode" integer NOT NULL,
+  "birth_time" integer NOT NULL,
+  "head" integer NOT NULL,
+  "tail" integer NOT NULL,
+  CONSTRAINT "grb_file_state_fk" FOREIGN KEY ("id") REFERENCES "mt_cds_object" ("id") ON DELETE CASCADE ON UPDATE CASCADE
+);
+CREATE TABLE "grb_scrobble" (
+  "id" integer primary key,
+  "artist" varchar(255) NOT NULL,
+  "title" varchar(255) NOT NULL,
+  "album" varchar(255) NOT NULL,
+  "track_number" integer NOT NULL,
+  "length" integer NOT NULL,
+  "started" integer NOT NULL
+);
+CREATE TABLE "grb_change_log" (
+  "id" integer primary key autoincrement,
+  "node" varchar(255) NOT NULL,
+  "update_ids" text NOT NULL,
+  "changed" integer NOT NULL
+);
 CREATE INDEX mt_cds_object_ref_id ON mt_cds_object(ref_id);
 CREATE INDEX mt_cds_object_parent_id ON mt_cds_object(parent_id,object_type,dc_title);
 CREATE INDEX mt_object_type ON mt_cds_object(object_type);
@@ -65,6 +97,10 @@ CREATE INDEX grb_track_number ON mt_cds_object(part_number,track_number);
 CREATE INDEX mt_internal_setting_key ON mt_internal_setting(key);
 CREATE UNIQUE INDEX mt_autoscan_obj_id ON mt_autoscan(obj_id);
 CREATE INDEX mt_cds_object_service_id ON mt_cds_object(service_id);
+CREATE INDEX grb_cds_object_upnp_class ON mt_cds_object(upnp_class);
 CREATE INDEX mt_metadata_item_id ON mt_metadata(item_id);
+CREATE INDEX grb_metadata_property ON mt_metadata(property_name);
+CREATE INDEX grb_metadata_item_property ON mt_metadata(item_id,property_name);
 CREATE INDEX grb_config_value_item ON grb_config_value(item);
+CREATE INDEX grb_change_log_changed ON grb_change_log(changed);
 COMMIT;
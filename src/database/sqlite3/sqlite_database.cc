@@ -35,8 +35,26 @@
 #include <zlib.h>
 
 #include "config/config_manager.h"
+#include "database/search_handler.h"
+#include "util/memory_accounting.h"
 
 #define DB_BACKUP_FORMAT "{}.backup"
+#define DB_BACKUP_TMP_FORMAT "{}.backup.tmp"
+// pages copied per backup step between the other tasks
+#define SQLITE3_BACKUP_STEP_PAGES 256
+
+// number of prepared statements kept per connection before the cache is flushed
+#define SQLITE3_STATEMENT_CACHE_SIZE 64
+// milliseconds a read connection waits for a lock held during a wal checkpoint
+#define SQLITE3_READER_BUSY_TIMEOUT 5000
+// queued asynchronous writes run in one transaction
+#define SQLITE3_ASYNC_BATCH_SIZE 100
+// free pages given back by one maintenance run
+#define SQLITE3_VACUUM_STEP_PAGES 1024
+// value of PRAGMA auto_vacuum for incremental vacuums
+#define SQLITE3_AUTO_VACUUM_INCREMENTAL 2
+// first version with WITH RECURSIVE
+#define SQLITE3_RECURSIVE_VERSION 3008003
 
 // updates 1->2
 #define SQLITE3_UPDATE_1_2_1 "DROP INDEX mt_autoscan_obj_id"
@@ -117,9 +135,72 @@ PRAGMA foreign_keys = ON;"
 // updates 9->10: last_modified
 #define SQLITE3_UPDATE_9_10_1 "ALTER TABLE \"mt_cds_object\" ADD \"last_modified\" integer unsigned default NULL"
 
+// updates 10->11: child_count
+#define SQLITE3_UPDATE_10_11_1 "ALTER TABLE \"mt_cds_object\" ADD \"child_count\" integer NOT NULL default 0"
+#define SQLITE3_UPDATE_10_11_2 "UPDATE \"mt_cds_object\" SET \"child_count\" = (SELECT COUNT(*) FROM \"mt_cds_object\" \"c\" WHERE \"c\".\"parent_id\" = \"mt_cds_object\".\"id\")"
+
+// updates 11->12: metadata property index
+#define SQLITE3_UPDATE_11_12_1 "CREATE INDEX grb_metadata_property ON mt_metadata(property_name)"
+
+// updates 12->13: 64 bit location hash, the marked rows are hashed again by migrateLocationHashes
+#define SQLITE3_UPDATE_12_13_1 "UPDATE \"mt_cds_object\" SET \"location_hash\" = -1 WHERE \"location_hash\" IS NOT NULL"
+
+// updates 13->14: directory state of timed autoscans
+#define SQLITE3_UPDATE_13_14_1 "CREATE TABLE \"grb_directory_state\" ( \
+  \"id\" integer primary key, \
+  \"mtime\" integer unsigned NOT NULL, \
+  \"child_count\" integer NOT NULL, \
+  CONSTRAINT \"grb_directory_state_fk\" FOREIGN KEY (\"id\") REFERENCES \"mt_cds_object\" (\"id\") ON DELETE CASCADE ON UPDATE CASCADE)"
+
+// updates 14->15: file state for change detection
+#define SQLITE3_UPDATE_14_15_1 "CREATE TABLE \"grb_file_state\" ( \
+  \"id\" integer primary key, \
+  \"size\" integer NOT NULL, \
+  \"inode\" integer NOT NULL, \
+  \"birth_time\" integer NOT NULL, \
+  \"head\" integer NOT NULL, \
+  \"tail\" integer NOT NULL, \
+  CONSTRAINT \"grb_file_state_fk\" FOREIGN KEY (\"id\") REFERENCES \"mt_cds_object\" (\"id\") ON DELETE CASCADE ON UPDATE CASCADE)"
+
+// updates 15->16: metadata lookup of one property, used to sort by metadata
+#define SQLITE3_UPDATE_15_16_1 "CREATE INDEX grb_metadata_item_property ON mt_metadata(item_id,property_name)"
+
+// updates 16->17: class range of derivedfrom searches
+#define SQLITE3_UPDATE_16_17_1 "CREATE INDEX grb_cds_object_upnp_class ON mt_cds_object(upnp_class)"
+
+// updates 17->18: Last.fm plays that were not submitted before a shutdown
+#define SQLITE3_UPDATE_17_18_1 "CREATE TABLE \"grb_scrobble\" ( \
+  \"id\" integer primary key, \
+  \"artist\" varchar(255) NOT NULL, \
+  \"title\" varchar(255) NOT NULL, \
+  \"album\" varchar(255) NOT NULL, \
+  \"track_number\" integer NOT NULL, \
+  \"length\" integer NOT NULL, \
+  \"started\" integer NOT NULL)"
+
+// updates 18->19: change log of the nodes sharing the database, ids are not reused after pruning
+#define SQLITE3_UPDATE_18_19_1 "CREATE TABLE \"grb_change_log\" ( \
+  \"id\" integer primary key autoincrement, \
+  \"node\" varchar(255) NOT NULL, \
+  \"update_ids\" text NOT NULL, \
+  \"changed\" integer NOT NULL)"
+#define SQLITE3_UPDATE_18_19_2 "CREATE INDEX grb_change_log_changed ON grb_change_log(changed)"
+
+// optional FTS5 index on the metadata values, kept in sync by triggers on mt_metadata
+#define SQLITE3_FULLTEXT_CHECK "SELECT \"name\" FROM \"sqlite_master\" WHERE \"type\"='table' AND \"name\"='grb_metadata_fts'"
+#define SQLITE3_FULLTEXT_1 "CREATE VIRTUAL TABLE \"grb_metadata_fts\" USING fts5(\"property_value\", content='mt_metadata', content_rowid='id')"
+#define SQLITE3_FULLTEXT_2 "CREATE TRIGGER \"grb_metadata_fts_insert\" AFTER INSERT ON \"mt_metadata\" BEGIN \
+INSERT INTO \"grb_metadata_fts\"(\"rowid\", \"property_value\") VALUES (new.\"id\", new.\"property_value\"); END"
+#define SQLITE3_FULLTEXT_3 "CREATE TRIGGER \"grb_metadata_fts_delete\" AFTER DELETE ON \"mt_metadata\" BEGIN \
+INSERT INTO \"grb_metadata_fts\"(\"grb_metadata_fts\", \"rowid\", \"property_value\") VALUES ('delete', old.\"id\", old.\"property_value\"); END"
+#define SQLITE3_FULLTEXT_4 "CREATE TRIGGER \"grb_metadata_fts_update\" AFTER UPDATE ON \"mt_metadata\" BEGIN \
+INSERT INTO \"grb_metadata_fts\"(\"grb_metadata_fts\", \"rowid\", \"property_value\") VALUES ('delete', old.\"id\", old.\"property_value\"); \
+INSERT INTO \"grb_metadata_fts\"(\"rowid\", \"property_value\") VALUES (new.\"id\", new.\"property_value\"); END"
+#define SQLITE3_FULLTEXT_5 "INSERT INTO \"grb_metadata_fts\"(\"grb_metadata_fts\") VALUES ('rebuild')"
+
 #define SQLITE3_UPDATE_VERSION "UPDATE \"mt_internal_setting\" SET \"value\"='{}' WHERE \"key\"='db_version' AND \"value\"='{}'"
 
-static const auto dbUpdates = std::array<std::vector<const char*>, 9> { {
+static const auto dbUpdates = std::array<std::vector<const char*>, 18> { {
     { SQLITE3_UPDATE_1_2_1, SQLITE3_UPDATE_1_2_2, SQLITE3_UPDATE_1_2_3 },
     { SQLITE3_UPDATE_2_3_1, SQLITE3_UPDATE_2_3_2 },
     { SQLITE3_UPDATE_3_4_1, SQLITE3_UPDATE_3_4_2 },
@@ -129,6 +210,15 @@ static const auto dbUpdates = std::array<std::vector<const char*>, 9> { {
     { SQLITE3_UPDATE_7_8_1, SQLITE3_UPDATE_7_8_2, SQLITE3_UPDATE_7_8_3 },
     { SQLITE3_UPDATE_8_9_1 },
     { SQLITE3_UPDATE_9_10_1 },
+    { SQLITE3_UPDATE_10_11_1, SQLITE3_UPDATE_10_11_2 },
+    { SQLITE3_UPDATE_11_12_1 },
+    { SQLITE3_UPDATE_12_13_1 },
+    { SQLITE3_UPDATE_13_14_1 },
+    { SQLITE3_UPDATE_14_15_1 },
+    { SQLITE3_UPDATE_15_16_1 },
+    { SQLITE3_UPDATE_16_17_1 },
+    { SQLITE3_UPDATE_17_18_1 },
+    { SQLITE3_UPDATE_18_19_1, SQLITE3_UPDATE_18_19_2 },
 } };
 
 Sqlite3Database::Sqlite3Database(std::shared_ptr<Config> config, std::shared_ptr<Timer> timer)
@@ -141,14 +231,35 @@ Sqlite3Database::Sqlite3Database(std::shared_ptr<Config> config, std::shared_ptr
     dirty = false;
     dbInitDone = false;
     hasBackupTimer = false;
+    sqliteStatus = SQLITE_OK;
 }
 
 void Sqlite3Database::prepare()
 {
-    _exec("PRAGMA locking_mode = EXCLUSIVE");
+    // readers need the shared memory wal-index, which sqlite does not create in exclusive mode
+    if (useReaders())
+        _exec("PRAGMA locking_mode = NORMAL");
+    else
+        _exec("PRAGMA locking_mode = EXCLUSIVE");
     _exec("PRAGMA foreign_keys = ON");
-    _exec("PRAGMA journal_mode = WAL;");
+    SQLDatabase::exec(fmt::format("PRAGMA journal_mode = {}", config->getOption(CFG_SERVER_STORAGE_SQLITE_JOURNAL_MODE)));
     SQLDatabase::exec(fmt::format("PRAGMA synchronous = {}", config->getIntOption(CFG_SERVER_STORAGE_SQLITE_SYNCHRONOUS)));
+    SQLDatabase::exec(getConnectionPragmas());
+}
+
+bool Sqlite3Database::useReaders() const
+{
+    // without wal the readers would wait for every write
+    return config->getIntOption(CFG_SERVER_STORAGE_SQLITE_READERS) > 0 && config->getOption(CFG_SERVER_STORAGE_SQLITE_JOURNAL_MODE) == "wal";
+}
+
+std::string Sqlite3Database::getConnectionPragmas() const
+{
+    // settings of a single connection, the readers get them too
+    return fmt::format("PRAGMA cache_size = {}; PRAGMA mmap_size = {}; PRAGMA temp_store = {};",
+        config->getIntOption(CFG_SERVER_STORAGE_SQLITE_CACHE_SIZE),
+        config->getIntOption(CFG_SERVER_STORAGE_SQLITE_MMAP_SIZE),
+        config->getIntOption(CFG_SERVER_STORAGE_SQLITE_TEMP_STORE));
 }
 
 void Sqlite3Database::init()
@@ -156,6 +267,9 @@ void Sqlite3Database::init()
     dbInitDone = false;
     SQLDatabase::init();
 
+    // page caches and statements of all connections, sqlite only counts them for the whole process
+    static auto memory = MemoryAccounting::getInstance().add("sqlite", [] { return static_cast<std::size_t>(sqlite3_memory_used()); });
+
     std::string dbFilePath = config->getOption(CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE);
     log_debug("SQLite path: {}", dbFilePath);
 
@@ -164,8 +278,10 @@ void Sqlite3Database::init()
         throw DatabaseException("", fmt::format("Error while accessing sqlite database file ({}): {}", dbFilePath.c_str(), std::strerror(errno)));
 
     taskQueueOpen = true;
+    std::unique_lock<std::mutex> startup(startupMutex);
     threadRunner = std::make_unique<StdThreadRunner>("SQLiteThread", Sqlite3Database::staticThreadProc, this, config);
     auto lock = threadRunner->uniqueLock();
+    startup.unlock();
 
     if (!threadRunner->isAlive()) {
         throw DatabaseException("", fmt::format("Could not start sqlite thread: {}", std::strerror(errno)));
@@ -266,6 +382,9 @@ void Sqlite3Database::init()
             this->addTask(btask);
             btask->waitForTask();
         }
+        migrateLocationHashes();
+        initFulltextSearch();
+        openReaders();
         dbInitDone = true;
     } catch (const std::runtime_error& e) {
         log_error("prematurely shutting down.");
@@ -274,6 +393,77 @@ void Sqlite3Database::init()
     }
 }
 
+bool Sqlite3Database::supportsRecursiveQueries()
+{
+    return sqlite3_libversion_number() >= SQLITE3_RECURSIVE_VERSION;
+}
+
+void Sqlite3Database::deferForeignKeys(bool defer)
+{
+    // ends with the transaction
+    if (defer)
+        _exec("PRAGMA defer_foreign_keys = ON");
+}
+
+int Sqlite3Database::getPragma(const char* name)
+{
+    auto query = fmt::format("PRAGMA {}", name);
+    auto res = select(query.c_str(), query.size());
+    std::unique_ptr<SQLRow> row;
+    if (res == nullptr || (row = res->nextRow()) == nullptr)
+        throw_std_runtime_error("PRAGMA {} returned nothing", name);
+    return stoiString(row->col(0));
+}
+
+std::string Sqlite3Database::maintain()
+{
+    std::vector<std::string> result;
+    // only analyzes the tables whose statistics are missing or out of date
+    _exec("PRAGMA optimize");
+    result.emplace_back("optimized");
+
+    int freePages = getPragma("freelist_count");
+    if (getPragma("auto_vacuum") == SQLITE3_AUTO_VACUUM_INCREMENTAL) {
+        if (freePages > 0) {
+            _exec(fmt::format("PRAGMA incremental_vacuum({})", SQLITE3_VACUUM_STEP_PAGES).c_str());
+            result.push_back(fmt::format("released {} of {} free pages", std::min(freePages, SQLITE3_VACUUM_STEP_PAGES), freePages));
+        }
+    } else if (freePages > 0 && freePages >= getPragma("page_count") / 4) {
+        if (config->getBoolOption(CFG_SERVER_STORAGE_MAINTENANCE_FULL_VACUUM)) {
+            // the mode of an existing database only changes with a VACUUM, which rebuilds the file once
+            _exec("PRAGMA auto_vacuum = INCREMENTAL");
+            _exec("VACUUM");
+            result.push_back(fmt::format("vacuumed {} free pages and switched to incremental vacuums", freePages));
+        } else {
+            result.push_back(fmt::format("{} free pages, enable maintenance-full-vacuum to release them", freePages));
+        }
+    }
+    return join(result, ", ");
+}
+
+std::vector<std::string> Sqlite3Database::getWarmUpQueries() const
+{
+    // counting through the index reads all of its pages
+    return {
+        "SELECT COUNT(*) FROM \"mt_cds_object\" INDEXED BY mt_cds_object_parent_id",
+        "SELECT COUNT(*) FROM \"mt_cds_object\" INDEXED BY mt_location_parent",
+        "SELECT COUNT(*) FROM \"mt_metadata\" INDEXED BY grb_metadata_item_property",
+    };
+}
+
+std::shared_ptr<SQLEmitter> Sqlite3Database::prepareFulltextSearch()
+{
+    auto res = select(SQLITE3_FULLTEXT_CHECK, strlen(SQLITE3_FULLTEXT_CHECK));
+    if (res == nullptr || res->nextRow() == nullptr) {
+        log_info("Creating the full-text search index...");
+        SQLTransaction transaction(this);
+        for (auto&& cmd : { SQLITE3_FULLTEXT_1, SQLITE3_FULLTEXT_2, SQLITE3_FULLTEXT_3, SQLITE3_FULLTEXT_4, SQLITE3_FULLTEXT_5 })
+            _exec(cmd);
+        transaction.commit();
+    }
+    return std::make_shared<SqliteFulltextSQLEmitter>();
+}
+
 std::shared_ptr<Database> Sqlite3Database::getSelf()
 {
     return shared_from_this();
@@ -300,22 +490,90 @@ std::string Sqlite3Database::getError(const std::string& query, const std::strin
 
 void Sqlite3Database::beginTransaction()
 {
-    _exec("BEGIN TRANSACTION");
+    transactionMutex.lock();
+    if (transactionDepth++ == 0) {
+        try {
+            _exec("BEGIN TRANSACTION");
+        } catch (const std::runtime_error& e) {
+            transactionDepth--;
+            transactionMutex.unlock();
+            throw;
+        }
+        transactionThread = std::this_thread::get_id();
+    }
 }
 
 void Sqlite3Database::commit()
 {
-    _exec("COMMIT");
+    // releases the level taken by beginTransaction()
+    std::unique_lock<std::recursive_mutex> lock(transactionMutex, std::adopt_lock);
+    if (--transactionDepth == 0) {
+        transactionThread = std::thread::id();
+        if (std::exchange(rollbackOnly, false)) {
+            _exec("ROLLBACK");
+            throw_std_runtime_error("Transaction rolled back, a nested part of it failed");
+        }
+        try {
+            _exec("COMMIT");
+        } catch (const std::runtime_error& e) {
+            // a failed commit leaves the transaction open
+            try {
+                _exec("ROLLBACK");
+            } catch (const std::runtime_error&) {
+            }
+            throw;
+        }
+    }
+}
+
+void Sqlite3Database::rollback()
+{
+    // only the outermost level can roll back, an inner rollback makes its commit roll back instead
+    std::unique_lock<std::recursive_mutex> lock(transactionMutex, std::adopt_lock);
+    if (--transactionDepth == 0) {
+        transactionThread = std::thread::id();
+        rollbackOnly = false;
+        _exec("ROLLBACK");
+    } else {
+        rollbackOnly = true;
+    }
 }
 
 std::shared_ptr<SQLResult> Sqlite3Database::select(const char* query, int length)
 {
+    QueryTimer timer(this, query);
     try {
-        log_debug("Adding select to Queue: {}", query);
         auto stask = std::make_shared<SLSelectTask>(query);
-        addTask(stask);
-        stask->waitForTask();
-        return stask->getResult();
+        if (!runOnReader(stask)) {
+            log_debug("Adding select to Queue: {}", query);
+            addTask(stask);
+            stask->waitForTask();
+        }
+        auto result = stask->getResult();
+        timer.setRows(result->getNumRows());
+        return result;
+    } catch (const std::runtime_error& e) {
+        if (dbInitDone) {
+            log_error("prematurely shutting down.");
+            shutdown();
+        }
+        throw_std_runtime_error(e.what());
+    }
+}
+
+std::shared_ptr<SQLResult> Sqlite3Database::selectPrepared(const std::string& query, const std::vector<SQLParam>& params)
+{
+    QueryTimer timer(this, query);
+    try {
+        auto stask = std::make_shared<SLPreparedSelectTask>(query, params);
+        if (!runOnReader(stask)) {
+            log_debug("Adding prepared select to Queue: {}", query);
+            addTask(stask);
+            stask->waitForTask();
+        }
+        auto result = stask->getResult();
+        timer.setRows(result->getNumRows());
+        return result;
     } catch (const std::runtime_error& e) {
         if (dbInitDone) {
             log_error("prematurely shutting down.");
@@ -325,8 +583,135 @@ std::shared_ptr<SQLResult> Sqlite3Database::select(const char* query, int length
     }
 }
 
+sqlite3_stmt* Sqlite3Database::getStatement(sqlite3* db, SLStatementCache& cache, const std::string& query)
+{
+    auto it = cache.find(query);
+    if (it != cache.end())
+        return it->second;
+
+    if (cache.size() >= SQLITE3_STATEMENT_CACHE_SIZE)
+        clearStatementCache(cache);
+
+    sqlite3_stmt* stmt = nullptr;
+    int ret = sqlite3_prepare_v2(db, query.c_str(), query.length(), &stmt, nullptr);
+    if (ret != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        throw DatabaseException("", getError(query, "", db, ret));
+    }
+    cache[query] = stmt;
+    return stmt;
+}
+
+void Sqlite3Database::clearStatementCache(SLStatementCache& cache)
+{
+    for (auto&& [query, stmt] : cache)
+        sqlite3_finalize(stmt);
+    cache.clear();
+}
+
+void Sqlite3Database::openReaders()
+{
+    int readerCount = useReaders() ? config->getIntOption(CFG_SERVER_STORAGE_SQLITE_READERS) : 0;
+    auto pragmas = getConnectionPragmas();
+    std::string dbFilePath = config->getOption(CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE);
+
+    std::lock_guard<std::mutex> lock(readerMutex);
+    for (int i = 0; i < readerCount; i++) {
+        sqlite3* db = nullptr;
+        int res = sqlite3_open_v2(dbFilePath.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr);
+        if (res != SQLITE_OK) {
+            log_warning("Sqlite3Database: could not open read connection to '{}', continuing with {} readers", dbFilePath, readers.size());
+            sqlite3_close(db);
+            break;
+        }
+        sqlite3_busy_timeout(db, SQLITE3_READER_BUSY_TIMEOUT);
+        sqlite3_exec(db, pragmas.c_str(), nullptr, nullptr, nullptr);
+        readers.push_back(std::make_unique<SLReader>(SLReader { db, {} }));
+        freeReaders.push_back(readers.back().get());
+    }
+    readersOpen = !readers.empty();
+    log_debug("Sqlite3Database: opened {} read connections", readers.size());
+}
+
+void Sqlite3Database::closeReaders()
+{
+    std::unique_lock<std::mutex> lock(readerMutex);
+    readersOpen = false;
+    // wait for running selects to hand back their connection
+    readerCond.wait(lock, [this] { return freeReaders.size() == readers.size(); });
+    for (auto&& reader : readers) {
+        clearStatementCache(reader->statementCache);
+        sqlite3_close(reader->db);
+    }
+    freeReaders.clear();
+    readers.clear();
+}
+
+bool Sqlite3Database::runOnReader(const std::shared_ptr<SLTask>& task)
+{
+    auto reader = acquireReader(true);
+    if (reader == nullptr)
+        return false;
+
+    try {
+        task->runReader(*reader, this);
+    } catch (const std::runtime_error& e) {
+        releaseReader(reader);
+        throw;
+    }
+    releaseReader(reader);
+    return true;
+}
+
+SLReader* Sqlite3Database::acquireReader(bool wait)
+{
+    if (transactionThread == std::this_thread::get_id())
+        return nullptr;
+    // queued behind the pending writes the read sees their result
+    if (pendingAsyncWrites > 0)
+        return nullptr;
+
+    std::unique_lock<std::mutex> lock(readerMutex);
+    if (wait)
+        readerCond.wait(lock, [this] { return !readersOpen || !freeReaders.empty(); });
+    if (!readersOpen || freeReaders.empty())
+        return nullptr;
+    auto reader = freeReaders.back();
+    freeReaders.pop_back();
+    return reader;
+}
+
+void Sqlite3Database::releaseReader(SLReader* reader)
+{
+    {
+        std::lock_guard<std::mutex> lock(readerMutex);
+        freeReaders.push_back(reader);
+    }
+    readerCond.notify_all();
+}
+
+std::shared_ptr<SQLResult> Sqlite3Database::selectStreaming(const std::string& query)
+{
+    // a thread reading several streams at once must not wait for its own readers
+    auto reader = acquireReader(false);
+    if (reader == nullptr)
+        return select(query.c_str(), query.length());
+
+    log_debug("Streaming: {}", query);
+    sqlite3_stmt* stmt = nullptr;
+    int ret = sqlite3_prepare_v2(reader->db, query.c_str(), query.length(), &stmt, nullptr);
+    if (ret != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        auto error = getError(query, "", reader->db, ret);
+        releaseReader(reader);
+        throw DatabaseException("", error);
+    }
+    return std::make_shared<Sqlite3StreamResult>(this, reader, stmt);
+}
+
 int Sqlite3Database::exec(const char* query, int length, bool getLastInsertId)
 {
+    QueryTimer timer(this, query);
     try {
         log_debug("Adding query to Queue: {}", query);
         auto etask = std::make_shared<SLExecTask>(query, getLastInsertId);
@@ -342,6 +727,57 @@ int Sqlite3Database::exec(const char* query, int length, bool getLastInsertId)
     }
 }
 
+std::future<void> Sqlite3Database::execAsync(const std::string& query)
+{
+    log_debug("Adding async query to Queue: {}", query);
+    auto etask = std::make_shared<SLAsyncExecTask>(query);
+    auto future = etask->getFuture();
+    pendingAsyncWrites++;
+    try {
+        addTask(etask);
+    } catch (const std::runtime_error& e) {
+        pendingAsyncWrites--;
+        throw;
+    }
+    return future;
+}
+
+void Sqlite3Database::runAsyncBatch(sqlite3* db, const std::vector<std::shared_ptr<SLAsyncExecTask>>& batch)
+{
+    // only run outside of the transactions of other threads, see threadProc
+    bool ownTransaction = batch.size() > 1;
+    if (ownTransaction)
+        sqlite3_exec(db, "BEGIN TRANSACTION", nullptr, nullptr, nullptr);
+
+    std::vector<std::string> errors(batch.size());
+    for (std::size_t i = 0; i < batch.size(); i++) {
+        try {
+            batch.at(i)->run(&db, this);
+        } catch (const std::runtime_error& e) {
+            errors.at(i) = e.what();
+        }
+    }
+
+    std::string commitError;
+    if (ownTransaction) {
+        int ret = sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr);
+        if (ret != SQLITE_OK) {
+            commitError = getError("COMMIT", "", db, ret);
+            sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+        }
+    }
+    dirty = true;
+
+    for (std::size_t i = 0; i < batch.size(); i++) {
+        const auto& error = errors.at(i).empty() ? commitError : errors.at(i);
+        if (error.empty())
+            batch.at(i)->sendSignal();
+        else
+            batch.at(i)->sendSignal(error);
+    }
+    pendingAsyncWrites -= batch.size();
+}
+
 void* Sqlite3Database::staticThreadProc(void* arg)
 {
     log_debug("Sqlite3Database::staticThreadProc - running thread");
@@ -362,21 +798,66 @@ void Sqlite3Database::threadProc()
     std::string dbFilePath = config->getOption(CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE);
 
     int res = sqlite3_open(dbFilePath.c_str(), &db);
+    {
+        std::lock_guard<std::mutex> startup(startupMutex);
+    }
+    auto lock = threadRunner->uniqueLock();
     if (res != SQLITE_OK) {
         startupError = fmt::format("Sqlite3Database.init: could not open '{}'", dbFilePath);
+        threadRunner->notify();
         return;
     }
 
-    auto lock = threadRunner->uniqueLock();
     // tell init() that we are ready
     threadRunner->notify();
 
+    // thread whose transaction is open on the connection
+    std::thread::id owner;
+    // tasks queued while a transaction is open, they neither see its rows nor get rolled back with it.
+    // Those of other threads are all held back to keep their order, async writes of the owner as well,
+    // so an own write of the owner is only visible to it once the transaction has ended.
+    std::vector<std::shared_ptr<SLTask>> heldBack;
+    auto holdBack = [&](const std::shared_ptr<SLTask>& task, bool async) {
+        return !sqlite3_get_autocommit(db) && (async || task->getThread() != owner);
+    };
+    auto releaseHeldBack = [&] {
+        // ahead of the tasks queued since
+        std::queue<std::shared_ptr<SLTask>> queue;
+        for (auto&& task : heldBack)
+            queue.push(task);
+        for (; !taskQueue.empty(); taskQueue.pop())
+            queue.push(taskQueue.front());
+        taskQueue.swap(queue);
+        heldBack.clear();
+    };
+
     while (!shutdownFlag) {
         while (!taskQueue.empty()) {
             auto task = taskQueue.front();
             taskQueue.pop();
 
+            auto asyncTask = std::dynamic_pointer_cast<SLAsyncExecTask>(task);
+            if (holdBack(task, asyncTask != nullptr)) {
+                heldBack.push_back(task);
+                continue;
+            }
+            if (asyncTask != nullptr) {
+                std::vector<std::shared_ptr<SLAsyncExecTask>> batch { asyncTask };
+                while (!taskQueue.empty() && batch.size() < SQLITE3_ASYNC_BATCH_SIZE) {
+                    asyncTask = std::dynamic_pointer_cast<SLAsyncExecTask>(taskQueue.front());
+                    if (asyncTask == nullptr)
+                        break;
+                    batch.push_back(asyncTask);
+                    taskQueue.pop();
+                }
+                lock.unlock();
+                runAsyncBatch(db, batch);
+                lock.lock();
+                continue;
+            }
+
             lock.unlock();
+            bool wasAutocommit = sqlite3_get_autocommit(db);
             try {
                 task->run(&db, this);
                 if (task->didContamination())
@@ -387,21 +868,30 @@ void Sqlite3Database::threadProc()
             } catch (const std::runtime_error& e) {
                 task->sendSignal(e.what());
             }
+            if (sqlite3_get_autocommit(db))
+                owner = std::thread::id();
+            else if (wasAutocommit)
+                owner = task->getThread();
             lock.lock();
+            if (!heldBack.empty() && sqlite3_get_autocommit(db))
+                releaseHeldBack();
         }
 
-        /* if nothing to do, sleep until awakened */
-        threadRunner->wait(lock);
+        /* if nothing to do, sleep until awakened, shutdown may have been signalled while a task was running */
+        threadRunner->wait(lock, [this] { return shutdownFlag || !taskQueue.empty(); });
     }
     log_debug("Sqlite3Database::threadProc - exiting");
 
     taskQueueOpen = false;
+    for (auto&& task : heldBack)
+        task->sendSignal("Sorry, sqlite3 thread is shutting down");
     while (!taskQueue.empty()) {
         auto task = taskQueue.front();
         taskQueue.pop();
         task->sendSignal("Sorry, sqlite3 thread is shutting down");
     }
 
+    clearStatementCache(statementCache);
     if (db) {
         log_debug("Sqlite3Database::staticThreadProc - closing database");
         if (sqlite3_close(db) == SQLITE_OK) {
@@ -430,6 +920,7 @@ void Sqlite3Database::addTask(const std::shared_ptr<SLTask>& task, bool onlyIfDi
 void Sqlite3Database::shutdownDriver()
 {
     log_debug("start");
+    closeReaders();
     auto lock = threadRunner->uniqueLock();
     if (!shutdownFlag) {
         shutdownFlag = true;
@@ -507,6 +998,7 @@ void SLInitTask::run(sqlite3** db, Sqlite3Database* sl)
     log_debug("Running: init");
     std::string dbFilePath = config->getOption(CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE);
 
+    sl->clearStatementCache(sl->statementCache);
     sqlite3_close(*db);
 
     int res = sqlite3_open(dbFilePath.c_str(), db);
@@ -570,6 +1062,71 @@ void SLSelectTask::run(sqlite3** db, Sqlite3Database* sl)
     pres->cur_row = 0;
 }
 
+/* SLPreparedSelectTask */
+
+SLPreparedSelectTask::SLPreparedSelectTask(const std::string& query, const std::vector<SQLParam>& params)
+    : SLTask()
+    , query(query)
+    , params(params)
+{
+}
+
+void SLPreparedSelectTask::run(sqlite3** db, Sqlite3Database* sl)
+{
+    runStatement(*db, sl->statementCache, sl);
+}
+
+void SLPreparedSelectTask::runReader(SLReader& reader, Sqlite3Database* sl)
+{
+    runStatement(reader.db, reader.statementCache, sl);
+}
+
+void SLPreparedSelectTask::runStatement(sqlite3* db, SLStatementCache& cache, Sqlite3Database* sl)
+{
+    log_debug("Running: {}", query);
+    pres = std::make_shared<Sqlite3StmtResult>();
+
+    auto stmt = sl->getStatement(db, cache, query);
+    int ret = SQLITE_OK;
+    int index = 1;
+    for (auto&& param : params) {
+        if (std::holds_alternative<int>(param))
+            ret = sqlite3_bind_int(stmt, index, std::get<int>(param));
+        else if (std::holds_alternative<long long>(param))
+            ret = sqlite3_bind_int64(stmt, index, std::get<long long>(param));
+        else if (std::holds_alternative<std::string>(param)) {
+            auto&& text = std::get<std::string>(param);
+            ret = sqlite3_bind_text(stmt, index, text.c_str(), text.length(), SQLITE_STATIC);
+        } else
+            ret = sqlite3_bind_null(stmt, index);
+        if (ret != SQLITE_OK)
+            break;
+        index++;
+    }
+
+    if (ret == SQLITE_OK) {
+        int ncolumn = sqlite3_column_count(stmt);
+        while ((ret = sqlite3_step(stmt)) == SQLITE_ROW) {
+            std::vector<std::optional<std::string>> row;
+            row.reserve(ncolumn);
+            for (int col = 0; col < ncolumn; col++) {
+                auto text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+                if (text != nullptr)
+                    row.emplace_back(std::string(text, sqlite3_column_bytes(stmt, col)));
+                else
+                    row.emplace_back(std::nullopt);
+            }
+            pres->rows.push_back(std::move(row));
+        }
+    }
+
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    if (ret != SQLITE_DONE && ret != SQLITE_OK) {
+        throw DatabaseException("", sl->getError(query, "", db, ret));
+    }
+}
+
 /* SLExecTask */
 
 SLExecTask::SLExecTask(const char* query, bool getLastInsertId)
@@ -602,11 +1159,55 @@ void SLExecTask::run(sqlite3** db, Sqlite3Database* sl)
     contamination = true;
 }
 
+/* SLAsyncExecTask */
+SLAsyncExecTask::SLAsyncExecTask(std::string query)
+    : query(std::move(query))
+{
+}
+
+void SLAsyncExecTask::run(sqlite3** db, Sqlite3Database* sl)
+{
+    SLExecTask(query.c_str(), false).run(db, sl);
+    contamination = true;
+}
+
+void SLAsyncExecTask::sendSignal()
+{
+    promise.set_value();
+    SLTask::sendSignal();
+}
+
+void SLAsyncExecTask::sendSignal(std::string error)
+{
+    log_error("Asynchronous query failed: {}", error);
+    promise.set_exception(std::make_exception_ptr(DatabaseException("", error)));
+    this->error = std::move(error);
+    SLTask::sendSignal();
+}
+
 /* SLBackupTask */
-SLBackupTask::SLBackupTask(std::shared_ptr<Config> config, bool restore)
+SLBackupTask::SLBackupTask(std::shared_ptr<Config> config, bool restore, int stepPages)
     : config(std::move(config))
     , restore(restore)
+    , stepPages(stepPages)
+{
+}
+
+SLBackupTask::~SLBackupTask()
 {
+    finishBackup();
+}
+
+void SLBackupTask::finishBackup()
+{
+    if (backup != nullptr) {
+        sqlite3_backup_finish(backup);
+        backup = nullptr;
+    }
+    if (backupDb != nullptr) {
+        sqlite3_close(backupDb);
+        backupDb = nullptr;
+    }
 }
 
 void SLBackupTask::run(sqlite3** db, Sqlite3Database* sl)
@@ -615,11 +1216,35 @@ void SLBackupTask::run(sqlite3** db, Sqlite3Database* sl)
     std::string dbFilePath = config->getOption(CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE);
 
     if (!restore) {
+        auto tmpPath = fmt::format(DB_BACKUP_TMP_FORMAT, dbFilePath);
+        if (backup == nullptr) {
+            // the previous backup is still copying
+            if (sl->backupRunning)
+                return;
+            if (sqlite3_open(tmpPath.c_str(), &backupDb) == SQLITE_OK)
+                backup = sqlite3_backup_init(backupDb, "main", *db, "main");
+            if (backup == nullptr) {
+                log_error("error while making sqlite3 backup: {}", backupDb != nullptr ? sqlite3_errmsg(backupDb) : "out of memory");
+                finishBackup();
+                return;
+            }
+            sl->backupRunning = true;
+        }
+
+        int ret = sqlite3_backup_step(backup, stepPages);
+        if (ret == SQLITE_OK || ret == SQLITE_BUSY || ret == SQLITE_LOCKED) {
+            // let the waiting queries run before the next pages
+            sl->addTask(shared_from_this());
+            return;
+        }
+        finishBackup();
+        sl->backupRunning = false;
+        if (ret != SQLITE_DONE) {
+            log_error("error while making sqlite3 backup: {}", sqlite3_errstr(ret));
+            return;
+        }
         try {
-            fs::copy(
-                dbFilePath,
-                fmt::format(DB_BACKUP_FORMAT, dbFilePath),
-                fs::copy_options::overwrite_existing);
+            fs::rename(tmpPath, fmt::format(DB_BACKUP_FORMAT, dbFilePath));
             log_debug("sqlite3 backup successful");
             decontamination = true;
         } catch (const std::runtime_error& e) {
@@ -627,6 +1252,7 @@ void SLBackupTask::run(sqlite3** db, Sqlite3Database* sl)
         }
     } else {
         log_info("trying to restore sqlite3 database from backup...");
+        sl->clearStatementCache(sl->statementCache);
         sqlite3_close(*db);
         try {
             fs::copy(
@@ -671,6 +1297,69 @@ std::unique_ptr<SQLRow> Sqlite3Result::nextRow()
     return nullptr;
 }
 
+/* Sqlite3StmtResult */
+
+std::unique_ptr<SQLRow> Sqlite3StmtResult::nextRow()
+{
+    if (cur_row < rows.size()) {
+        return std::make_unique<Sqlite3StmtRow>(std::move(rows[cur_row++]));
+    }
+    return nullptr;
+}
+
+/* Sqlite3StreamResult */
+
+Sqlite3StreamResult::Sqlite3StreamResult(Sqlite3Database* sl, SLReader* reader, sqlite3_stmt* stmt)
+    : sl(sl)
+    , reader(reader)
+    , stmt(stmt)
+{
+}
+
+Sqlite3StreamResult::~Sqlite3StreamResult()
+{
+    finish();
+}
+
+void Sqlite3StreamResult::finish()
+{
+    if (stmt == nullptr)
+        return;
+    sqlite3_finalize(stmt);
+    stmt = nullptr;
+    sl->releaseReader(reader);
+}
+
+std::unique_ptr<SQLRow> Sqlite3StreamResult::nextRow()
+{
+    if (stmt == nullptr)
+        return nullptr;
+
+    int ret = sqlite3_step(stmt);
+    if (ret != SQLITE_ROW) {
+        std::string error;
+        if (ret != SQLITE_DONE)
+            error = sl->getError(sqlite3_sql(stmt), "", reader->db, ret);
+        finish();
+        if (!error.empty())
+            throw DatabaseException("", error);
+        return nullptr;
+    }
+
+    int ncolumn = sqlite3_column_count(stmt);
+    std::vector<std::optional<std::string>> row;
+    row.reserve(ncolumn);
+    for (int col = 0; col < ncolumn; col++) {
+        auto text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+        if (text != nullptr)
+            row.emplace_back(std::string(text, sqlite3_column_bytes(stmt, col)));
+        else
+            row.emplace_back(std::nullopt);
+    }
+    nrow++;
+    return std::make_unique<Sqlite3StmtRow>(std::move(row));
+}
+
 /* Sqlite3Row */
 
 Sqlite3Row::Sqlite3Row(char** row)
@@ -682,6 +1371,6 @@ Sqlite3Row::Sqlite3Row(char** row)
 
 void Sqlite3Database::timerNotify(std::shared_ptr<Timer::Parameter> param)
 {
-    auto btask = std::make_shared<SLBackupTask>(config, false);
+    auto btask = std::make_shared<SLBackupTask>(config, false, SQLITE3_BACKUP_STEP_PAGES);
     this->addTask(btask, true);
 }
@@ -33,9 +33,15 @@
 #ifndef __SQLITE3_STORAGE_H__
 #define __SQLITE3_STORAGE_H__
 
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <optional>
 #include <queue>
 #include <sqlite3.h>
 #include <sstream>
+#include <thread>
 #include <unistd.h>
 
 #include "database/sql_database.h"
@@ -44,6 +50,16 @@
 
 class Sqlite3Database;
 class Sqlite3Result;
+class Sqlite3StmtResult;
+class Sqlite3StreamResult;
+
+using SLStatementCache = std::map<std::string, sqlite3_stmt*>;
+
+/// \brief A read-only connection of the reader pool with its own prepared statements
+struct SLReader {
+    sqlite3* db;
+    SLStatementCache statementCache;
+};
 
 /// \brief A virtual class that represents a task to be done by the sqlite3 thread.
 class SLTask {
@@ -55,14 +71,17 @@ public:
     /// \param sl The instance of Sqlite3Database to do the queries with.
     virtual void run(sqlite3** db, Sqlite3Database* sl) = 0;
 
+    /// \brief run the task on a read-only connection of the reader pool
+    virtual void runReader(SLReader& reader, Sqlite3Database* sl) { run(&reader.db, sl); }
+
     /// \brief returns true if the task is not completed
     /// \return true if the task is not completed yet, false if the task is finished and the results are ready.
     bool is_running() const;
 
     /// \brief notify the creator of the task using the supplied pthread_mutex and pthread_cond, that the task is finished
-    void sendSignal();
+    virtual void sendSignal();
 
-    void sendSignal(std::string error);
+    virtual void sendSignal(std::string error);
 
     void waitForTask();
 
@@ -71,6 +90,9 @@ public:
 
     std::string getError() const { return error; }
 
+    /// \brief thread that created the task
+    std::thread::id getThread() const { return thread; }
+
     virtual ~SLTask() = default;
 
 protected:
@@ -89,6 +111,8 @@ protected:
     std::mutex mutex;
 
     std::string error;
+
+    std::thread::id thread { std::this_thread::get_id() };
 };
 
 /// \brief A task for the sqlite3 thread to inititally create the database.
@@ -118,6 +142,28 @@ protected:
     std::shared_ptr<Sqlite3Result> pres;
 };
 
+/// \brief A task for the sqlite3 thread to do a SQL select with a cached prepared statement.
+class SLPreparedSelectTask : public SLTask {
+public:
+    /// \brief Constructor for the sqlite3 prepared select task
+    /// \param query The SQL query string with '?' placeholders
+    /// \param params The values to bind to the placeholders
+    SLPreparedSelectTask(const std::string& query, const std::vector<SQLParam>& params);
+    void run(sqlite3** db, Sqlite3Database* sl) override;
+    void runReader(SLReader& reader, Sqlite3Database* sl) override;
+    [[nodiscard]] std::shared_ptr<SQLResult> getResult() const { return std::static_pointer_cast<SQLResult>(pres); }
+
+protected:
+    void runStatement(sqlite3* db, SLStatementCache& cache, Sqlite3Database* sl);
+
+    /// \brief The SQL query string
+    const std::string& query;
+    /// \brief The parameters to bind
+    const std::vector<SQLParam>& params;
+    /// \brief The Sqlite3StmtResult
+    std::shared_ptr<Sqlite3StmtResult> pres;
+};
+
 /// \brief A task for the sqlite3 thread to do a SQL exec.
 class SLExecTask : public SLTask {
 public:
@@ -135,16 +181,41 @@ protected:
     bool getLastInsertIdFlag;
 };
 
+/// \brief A task for the sqlite3 thread to do a SQL exec nobody waits for.
+///
+/// Consecutive queued tasks of this kind are run in one transaction.
+class SLAsyncExecTask : public SLTask {
+public:
+    explicit SLAsyncExecTask(std::string query);
+    void run(sqlite3** db, Sqlite3Database* sl) override;
+    void sendSignal() override;
+    void sendSignal(std::string error) override;
+    std::future<void> getFuture() { return promise.get_future(); }
+
+protected:
+    std::string query;
+    std::promise<void> promise;
+};
+
 /// \brief A task for the sqlite3 thread to do a SQL exec.
-class SLBackupTask : public SLTask {
+class SLBackupTask : public SLTask, public std::enable_shared_from_this<SLBackupTask> {
 public:
     /// \brief Constructor for the sqlite3 backup task
-    SLBackupTask(std::shared_ptr<Config> config, bool restore);
+    /// \param stepPages number of pages copied per run, the task queues itself again until the copy is complete, -1 copies everything at once
+    SLBackupTask(std::shared_ptr<Config> config, bool restore, int stepPages = -1);
+    ~SLBackupTask() override;
     void run(sqlite3** db, Sqlite3Database* sl) override;
 
 protected:
+    void finishBackup();
+
     std::shared_ptr<Config> config;
     bool restore;
+    int stepPages;
+
+    /// \brief online backup of the writer connection, its own writes between the steps are copied as well
+    sqlite3_backup* backup { nullptr };
+    sqlite3* backupDb { nullptr };
 };
 
 /// \brief The Database class for using SQLite3
@@ -155,9 +226,17 @@ public:
 
 private:
     void prepare();
+    std::string getConnectionPragmas() const;
+    bool useReaders() const;
     void init() override;
     void shutdownDriver() override;
     std::shared_ptr<Database> getSelf() override;
+    std::shared_ptr<SQLEmitter> prepareFulltextSearch() override;
+    bool supportsRecursiveQueries() override;
+    std::vector<std::string> getWarmUpQueries() const override;
+    void deferForeignKeys(bool defer) override;
+    std::string maintain() override;
+    int getPragma(const char* name);
 
     std::string quote(std::string value) const override;
     std::string quote(const char* str) const override { return quote(std::string(str)); }
@@ -171,9 +250,25 @@ private:
 
     std::shared_ptr<SQLResult> select(const char* query, int length) override;
     int exec(const char* query, int length, bool getLastInsertId = false) override;
+    std::shared_ptr<SQLResult> selectPrepared(const std::string& query, const std::vector<SQLParam>& params) override;
+    std::future<void> execAsync(const std::string& query) override;
+    std::shared_ptr<SQLResult> selectStreaming(const std::string& query) override;
+
+    /// \brief number of queued SLAsyncExecTasks, reads go through the writer while there are any
+    std::atomic_int pendingAsyncWrites { 0 };
+    void runAsyncBatch(sqlite3* db, const std::vector<std::shared_ptr<SLAsyncExecTask>>& batch);
 
     void beginTransaction() override;
     void commit() override;
+    void rollback() override;
+
+    /// \brief held by the thread running a transaction, so transactions of other threads wait instead of nesting
+    std::recursive_mutex transactionMutex;
+    int transactionDepth { 0 };
+    /// \brief set by a nested rollback, the outermost commit rolls back instead
+    bool rollbackOnly { false };
+    /// \brief the thread with the open transaction reads through the writer to see its own changes
+    std::atomic<std::thread::id> transactionThread;
 
     void storeInternalSetting(const std::string& key, const std::string& value) override;
 
@@ -184,6 +279,8 @@ private:
     std::string getError(const std::string& query, const std::string& error, sqlite3* db, int errorCode);
 
     std::unique_ptr<StdThreadRunner> threadRunner;
+    /// \brief held by init() until threadRunner is assigned, the thread starts before the constructor returns
+    std::mutex startupMutex;
     static void* staticThreadProc(void* arg);
     void threadProc();
 
@@ -201,15 +298,44 @@ private:
     void threadCleanup() override { }
     bool threadCleanupRequired() const override { return false; }
 
+    /// \brief prepared statements of the writer connection, keyed by query text
+    ///
+    /// Only accessed by the sqlite3 thread, must be cleared before the connection is closed
+    SLStatementCache statementCache;
+    sqlite3_stmt* getStatement(sqlite3* db, SLStatementCache& cache, const std::string& query);
+    static void clearStatementCache(SLStatementCache& cache);
+
+    /// \brief read-only connections serving select() while the sqlite3 thread writes
+    std::vector<std::unique_ptr<SLReader>> readers;
+    std::vector<SLReader*> freeReaders;
+    std::mutex readerMutex;
+    std::condition_variable readerCond;
+    bool readersOpen { false };
+
+    void openReaders();
+    void closeReaders();
+    /// \brief run the task on a free reader, returns false if there is no reader pool
+    bool runOnReader(const std::shared_ptr<SLTask>& task);
+    /// \brief take a reader out of the pool, returns nullptr if reads have to go through the writer
+    /// \param wait wait for a busy pool instead of returning nullptr
+    SLReader* acquireReader(bool wait);
+    void releaseReader(SLReader* reader);
+
     bool dirty;
     bool dbInitDone;
     bool hasBackupTimer;
-    int sqliteStatus;
+    /// \brief an SLBackupTask copies the database step by step, only used by the sqlite3 thread
+    bool backupRunning { false };
+    std::atomic_int sqliteStatus;
 
     friend class SLSelectTask;
+    friend class SLPreparedSelectTask;
     friend class SLExecTask;
+    friend class SLAsyncExecTask;
     friend class SLInitTask;
+    friend class SLBackupTask;
     friend class Sqlite3BackupTimerSubscriber;
+    friend class Sqlite3StreamResult;
 };
 
 /// \brief Represents a result of a sqlite3 select
@@ -245,4 +371,54 @@ private:
     char** row;
 };
 
+/// \brief Represents a result of a sqlite3 prepared statement, the values are copied out of the statement
+class Sqlite3StmtResult : public SQLResult {
+public:
+    Sqlite3StmtResult() = default;
+
+private:
+    std::unique_ptr<SQLRow> nextRow() override;
+    [[nodiscard]] unsigned long long getNumRows() const override { return rows.size(); }
+
+    std::vector<std::vector<std::optional<std::string>>> rows;
+    std::size_t cur_row { 0 };
+
+    friend class SLPreparedSelectTask;
+};
+
+/// \brief Represents a row of a result of a sqlite3 prepared statement
+class Sqlite3StmtRow : public SQLRow {
+public:
+    explicit Sqlite3StmtRow(std::vector<std::optional<std::string>> row)
+        : row(std::move(row))
+    {
+    }
+
+private:
+    char* col_c_str(int index) const override { return row[index] ? const_cast<char*>(row[index]->c_str()) : nullptr; }
+    std::vector<std::optional<std::string>> row;
+};
+
+/// \brief Represents a result of a sqlite3 select that steps the statement on a reader connection row by row
+///
+/// The reader stays out of the pool until the last row was read or the result is destroyed
+class Sqlite3StreamResult : public SQLResult {
+public:
+    Sqlite3StreamResult(Sqlite3Database* sl, SLReader* reader, sqlite3_stmt* stmt);
+    ~Sqlite3StreamResult() override;
+
+    Sqlite3StreamResult(const Sqlite3StreamResult&) = delete;
+    Sqlite3StreamResult& operator=(const Sqlite3StreamResult&) = delete;
+
+private:
+    std::unique_ptr<SQLRow> nextRow() override;
+    [[nodiscard]] unsigned long long getNumRows() const override { return nrow; }
+    void finish();
+
+    Sqlite3Database* sl;
+    SLReader* reader;
+    sqlite3_stmt* stmt;
+    unsigned long long nrow { 0 };
+};
+
 #endif // __SQLITE3_STORAGE_H__
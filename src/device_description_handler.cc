@@ -25,22 +25,20 @@
 
 #include "iohandler/mem_io_handler.h"
 #include "util/tools.h"
+#include "util/upnp_headers.h"
 
-DeviceDescriptionHandler::DeviceDescriptionHandler(std::shared_ptr<ContentManager> content, UpnpXMLBuilder* xmlBuilder)
+DeviceDescriptionHandler::DeviceDescriptionHandler(std::shared_ptr<ContentManager> content, const std::string& deviceDescription, time_t lastModified)
     : RequestHandler(std::move(content))
-    , xmlBuilder(xmlBuilder)
+    , deviceDescription(deviceDescription)
+    , lastModified(lastModified)
+    , eTag(fmt::format("\"{:x}-{:x}\"", static_cast<std::uint64_t>(stringHash(deviceDescription)), lastModified))
 {
-    auto desc = xmlBuilder->renderDeviceDescription();
-
-    std::ostringstream buf;
-    desc->print(buf, "", 0);
-    deviceDescription = buf.str();
 }
 
 void DeviceDescriptionHandler::getInfo(const char* filename, UpnpFileInfo* info)
 {
-    // We should be able to do the generation here, but libupnp doesnt support the request cookies yet
-    UpnpFileInfo_set_FileLength(info, -1);
+    UpnpFileInfo_set_FileLength(info, deviceDescription.length());
+    UpnpFileInfo_set_LastModified(info, lastModified);
 #if defined(USING_NPUPNP)
     UpnpFileInfo_set_ContentType(info, "application/xml");
 #else
@@ -48,6 +46,11 @@ void DeviceDescriptionHandler::getInfo(const char* filename, UpnpFileInfo* info)
 #endif
     UpnpFileInfo_set_IsReadable(info, 1);
     UpnpFileInfo_set_IsDirectory(info, 0);
+
+    // the document only changes with a new server instance
+    Headers headers;
+    headers.addHeader("ETag", eTag);
+    headers.writeHeaders(info);
 }
 
 std::unique_ptr<IOHandler> DeviceDescriptionHandler::open(const char* filename, enum UpnpOpenFileMode mode)
@@ -25,19 +25,20 @@
 #define GERBERA_DEVICE_DESCRIPTION_HANDLER_H
 
 #include "request_handler.h"
-#include "upnp_xml.h"
 #include <memory>
 
+/// \brief Serves the device description rendered by the server at startup
 class DeviceDescriptionHandler : public RequestHandler {
 public:
-    explicit DeviceDescriptionHandler(std::shared_ptr<ContentManager> content, UpnpXMLBuilder* xmlBuilder);
+    DeviceDescriptionHandler(std::shared_ptr<ContentManager> content, const std::string& deviceDescription, time_t lastModified);
 
     void getInfo(const char* filename, UpnpFileInfo* info) override;
     std::unique_ptr<IOHandler> open(const char* filename, enum UpnpOpenFileMode mode) override;
 
 protected:
-    UpnpXMLBuilder* xmlBuilder;
     std::string deviceDescription;
+    time_t lastModified;
+    std::string eTag;
 };
 
 #endif //GERBERA_DEVICE_DESCRIPTION_HANDLER_H
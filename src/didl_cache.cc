@@ -0,0 +1,129 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    didl_cache.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file didl_cache.cc
+
+#include "didl_cache.h" // API
+
+#include "cds_objects.h"
+
+DidlCache::Validator::Validator(const std::shared_ptr<CdsObject>& obj)
+    : parentID(obj->getParentID())
+    , title(obj->getTitle())
+    , flags(obj->getFlags())
+    , mtime(obj->getMTime())
+    , version(0)
+    , childCount(0)
+{
+    if (obj->isContainer()) {
+        auto cont = std::static_pointer_cast<CdsContainer>(obj);
+        version = cont->getUpdateID();
+        childCount = cont->getChildCount();
+    } else if (obj->isItem()) {
+        version = std::static_pointer_cast<CdsItem>(obj)->getBookMarkPos();
+    }
+}
+
+bool DidlCache::Validator::operator==(const Validator& other) const
+{
+    return parentID == other.parentID && flags == other.flags && mtime == other.mtime && version == other.version && childCount == other.childCount && title == other.title;
+}
+
+DidlCache::DidlCache(std::size_t capacity)
+    : capacity(capacity)
+{
+}
+
+void DidlCache::erase(Cache::iterator entry)
+{
+    for (int id : { std::get<0>(entry->first), entry->second.validator.parentID }) {
+        auto container = byContainer.find(id);
+        if (container == byContainer.end())
+            continue;
+        container->second.erase(&entry->first);
+        if (container->second.empty())
+            byContainer.erase(container);
+    }
+    cache.erase(entry);
+}
+
+std::shared_ptr<const std::string> DidlCache::get(const std::shared_ptr<CdsObject>& obj, unsigned int quirkFlags, std::size_t stringLimit, const std::string& filter)
+{
+    AutoLock lock(mutex);
+    auto entry = cache.find({ obj->getID(), quirkFlags, stringLimit, filter });
+    if (entry == cache.end()) {
+        requests.misses.inc();
+        return nullptr;
+    }
+    if (!(entry->second.validator == Validator(obj))) {
+        erase(entry);
+        requests.misses.inc();
+        return nullptr;
+    }
+    requests.hits.inc();
+    cache.touch(entry);
+    return entry->second.fragment;
+}
+
+std::shared_ptr<const std::string> DidlCache::put(const std::shared_ptr<CdsObject>& obj, unsigned int quirkFlags, std::size_t stringLimit, const std::string& filter, std::string fragment)
+{
+    auto result = std::make_shared<const std::string>(std::move(fragment));
+    Key key { obj->getID(), quirkFlags, stringLimit, filter };
+
+    AutoLock lock(mutex);
+    auto entry = cache.find(key);
+    if (entry != cache.end())
+        erase(entry);
+    entry = cache.put(key, Entry { Validator(obj), result });
+    byContainer[obj->getID()].insert(&entry->first);
+    byContainer[entry->second.validator.parentID].insert(&entry->first);
+
+    while (cache.size() > capacity)
+        erase(std::prev(cache.end()));
+    return result;
+}
+
+void DidlCache::invalidate(int containerID)
+{
+    AutoLock lock(mutex);
+    auto container = byContainer.find(containerID);
+    if (container == byContainer.end())
+        return;
+    auto keys = std::move(container->second);
+    byContainer.erase(container);
+    for (auto&& key : keys)
+        erase(cache.find(*key));
+}
+
+void DidlCache::clear()
+{
+    AutoLock lock(mutex);
+    byContainer.clear();
+    cache.clear();
+}
+
+std::size_t DidlCache::size()
+{
+    AutoLock lock(mutex);
+    return cache.size();
+}
@@ -0,0 +1,101 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    didl_cache.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file didl_cache.h
+#ifndef __DIDL_CACHE_H__
+#define __DIDL_CACHE_H__
+
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "util/lru_cache.h"
+#include "util/metrics.h"
+
+// forward declaration
+class CdsObject;
+
+/// \brief Keeps the rendered DIDL-Lite of objects for the next browse
+///
+/// A fragment is stored per object, client quirks, string limit and filter. It is dropped when
+/// the update manager reports a change of the object or its parent container, and it is
+/// not used if the title, flags, modification time, bookmark or container update id of
+/// the object read from the database differ from the rendered one.
+class DidlCache {
+public:
+    explicit DidlCache(std::size_t capacity);
+
+    /// \brief rendered fragment of obj or nullptr
+    std::shared_ptr<const std::string> get(const std::shared_ptr<CdsObject>& obj, unsigned int quirkFlags, std::size_t stringLimit, const std::string& filter);
+
+    /// \brief remember fragment rendered for obj
+    std::shared_ptr<const std::string> put(const std::shared_ptr<CdsObject>& obj, unsigned int quirkFlags, std::size_t stringLimit, const std::string& filter, std::string fragment);
+
+    /// \brief drop the fragments of the container and its children
+    void invalidate(int containerID);
+
+    void clear();
+
+    std::size_t size();
+
+private:
+    using Key = std::tuple<int, unsigned int, std::size_t, std::string>;
+
+    /// \brief values the fragment was rendered from
+    struct Validator {
+        int parentID;
+        std::string title;
+        unsigned int flags;
+        std::time_t mtime;
+        /// \brief update id of containers, bookmark of items
+        long version;
+        int childCount;
+
+        explicit Validator(const std::shared_ptr<CdsObject>& obj);
+        bool operator==(const Validator& other) const;
+    };
+
+    struct Entry {
+        Validator validator;
+        std::shared_ptr<const std::string> fragment;
+    };
+    using Cache = LruCache<Key, Entry>;
+
+    /// \brief remove the entry and its keys from byContainer, lock must be held
+    void erase(Cache::iterator entry);
+
+    std::size_t capacity;
+    Cache cache;
+    /// \brief keys of the fragments of each object and of the children of each container
+    std::unordered_map<int, std::unordered_set<const Key*>> byContainer;
+    std::mutex mutex;
+    Metrics::CacheRequests requests { "didl" };
+
+    using AutoLock = std::lock_guard<std::mutex>;
+};
+
+#endif // __DIDL_CACHE_H__
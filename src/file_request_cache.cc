@@ -0,0 +1,99 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    file_request_cache.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file file_request_cache.cc
+
+#include "file_request_cache.h" // API
+
+FileRequestCache::FileRequestCache(std::chrono::seconds ttl, std::size_t capacity)
+    : ttl(ttl)
+    , capacity(capacity)
+{
+}
+
+std::shared_ptr<ResolvedFileRequest> FileRequestCache::get(const std::string& url, const std::string& client, const void*& token)
+{
+    AutoLock lock(mutex);
+    expire(Clock::now());
+    auto client_it = clients.find({ url, client });
+    if (client_it == clients.end()) {
+        requests.misses.inc();
+        return nullptr;
+    }
+    requests.hits.inc();
+    token = reinterpret_cast<const void*>(client_it->second);
+    return entries.at(client_it->second).request;
+}
+
+std::shared_ptr<ResolvedFileRequest> FileRequestCache::get(const void* token, const std::string& url)
+{
+    AutoLock lock(mutex);
+    expire(Clock::now());
+    auto entry = entries.find(reinterpret_cast<std::uintptr_t>(token));
+    if (entry == entries.end() || entry->second.key.first != url)
+        return nullptr;
+    return entry->second.request;
+}
+
+const void* FileRequestCache::put(const std::string& url, const std::string& client, const std::shared_ptr<ResolvedFileRequest>& request)
+{
+    AutoLock lock(mutex);
+    auto now = Clock::now();
+    expire(now);
+
+    ClientKey key { url, client };
+    auto client_it = clients.find(key);
+    if (client_it != clients.end())
+        entries.erase(client_it->second);
+    while (!entries.empty() && entries.size() >= capacity) {
+        clients.erase(entries.begin()->second.key);
+        entries.erase(entries.begin());
+    }
+
+    auto token = nextToken++;
+    entries[token] = Entry { key, request, now + ttl };
+    clients[key] = token;
+    return reinterpret_cast<const void*>(token);
+}
+
+void FileRequestCache::expire(Clock::time_point now)
+{
+    // all entries share the ttl, so they expire in token order
+    while (!entries.empty() && entries.begin()->second.expires <= now) {
+        clients.erase(entries.begin()->second.key);
+        entries.erase(entries.begin());
+    }
+}
+
+void FileRequestCache::clear()
+{
+    AutoLock lock(mutex);
+    entries.clear();
+    clients.clear();
+}
+
+std::size_t FileRequestCache::size()
+{
+    AutoLock lock(mutex);
+    return entries.size();
+}
@@ -0,0 +1,117 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    file_request_cache.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file file_request_cache.h
+#ifndef __FILE_REQUEST_CACHE_H__
+#define __FILE_REQUEST_CACHE_H__
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+
+#include "util/metrics.h"
+namespace fs = std::filesystem;
+
+// forward declaration
+class CdsObject;
+class TranscodingProfile;
+
+/// \brief file request after the url was resolved to the object and file to serve
+struct ResolvedFileRequest {
+    /// \brief address of the client that asked for it, empty if unknown
+    std::string client;
+    std::map<std::string, std::string> params;
+    std::shared_ptr<CdsObject> obj;
+    fs::path path;
+    struct stat statbuf;
+    bool readable { false };
+    bool isSrt { false };
+    std::size_t resId;
+    std::string resourceHandler;
+    /// \brief metadata handler serving the resource, -1 to serve the file
+    int handlerType { -1 };
+    /// \brief mime type set by the subtitle check
+    std::string mimeType;
+    std::string trProfile;
+    std::shared_ptr<TranscodingProfile> profile;
+    /// \brief length reported by the resource handler, -1 if not asked yet
+    off_t resourceSize { -1 };
+    /// \brief position in milliseconds the transcoder starts at
+    int startTime { 0 };
+    /// \brief byte range start the position was derived from, 0 for time seeks
+    off_t startOffset { 0 };
+    /// \brief playlist created for the length in getInfo of a hls request
+    std::string hlsPlaylist;
+};
+
+/// \brief Keeps resolved file requests for a few seconds
+///
+/// libupnp calls getInfo and open for every request and players fetching short ranges
+/// send the same url over and over. getInfo stores what it resolved for the url and client,
+/// the returned token is passed to open of the same request as upnp request cookie.
+class FileRequestCache {
+public:
+    FileRequestCache(std::chrono::seconds ttl, std::size_t capacity);
+
+    /// \brief request resolved for url and client or nullptr, token is set on a hit
+    std::shared_ptr<ResolvedFileRequest> get(const std::string& url, const std::string& client, const void*& token);
+    /// \brief request stored with token if it was resolved for url or nullptr
+    std::shared_ptr<ResolvedFileRequest> get(const void* token, const std::string& url);
+
+    /// \brief remember request and return the token for open
+    const void* put(const std::string& url, const std::string& client, const std::shared_ptr<ResolvedFileRequest>& request);
+
+    void clear();
+
+    std::size_t size();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using ClientKey = std::pair<std::string, std::string>;
+
+    struct Entry {
+        ClientKey key;
+        std::shared_ptr<ResolvedFileRequest> request;
+        Clock::time_point expires;
+    };
+
+    void expire(Clock::time_point now);
+
+    std::chrono::seconds ttl;
+    std::size_t capacity;
+    /// \brief tokens are handed out in ascending order, so the first entry is the oldest
+    std::uintptr_t nextToken { 1 };
+    std::map<std::uintptr_t, Entry> entries;
+    std::map<ClientKey, std::uintptr_t> clients;
+    std::mutex mutex;
+    Metrics::CacheRequests requests { "file_request" };
+
+    using AutoLock = std::lock_guard<std::mutex>;
+};
+
+#endif // __FILE_REQUEST_CACHE_H__
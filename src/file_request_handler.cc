@@ -33,27 +33,51 @@
 
 #include <filesystem>
 
+#include <netdb.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include "config/config_manager.h"
 #include "content/content_manager.h"
 #include "database/database.h"
+#include "file_request_cache.h"
 #include "iohandler/file_io_handler.h"
+#include "iohandler/mem_io_handler.h"
+#include "iohandler/metered_io_handler.h"
+#include "iohandler/offset_io_handler.h"
+#include "iohandler/playback_predictor.h"
+#include "iohandler/stream_statistics.h"
+#include "iohandler/thumbnail_store.h"
 #include "metadata/metadata_handler.h"
+#include "transcoding/hls_session_manager.h"
 #include "transcoding/transcode_dispatcher.h"
+#include "util/mime.h"
 #include "util/process.h"
 #include "util/tools.h"
 #include "util/upnp_headers.h"
 #include "util/upnp_quirks.h"
 #include "web/session_manager.h"
 
-FileRequestHandler::FileRequestHandler(std::shared_ptr<ContentManager> content, UpnpXMLBuilder* xmlBuilder)
+FileRequestHandler::FileRequestHandler(std::shared_ptr<ContentManager> content, UpnpXMLBuilder* xmlBuilder, std::shared_ptr<ReadAheadPool> readAheadPool, std::shared_ptr<FileRequestCache> requestCache, std::shared_ptr<ThumbnailStore> thumbnailStore, std::shared_ptr<PlaybackPredictor> playbackPredictor)
     : RequestHandler(std::move(content))
     , xmlBuilder(xmlBuilder)
+    , readAheadPool(std::move(readAheadPool))
+    , requestCache(std::move(requestCache))
+    , thumbnailStore(std::move(thumbnailStore))
+    , playbackPredictor(std::move(playbackPredictor))
 {
 }
 
+/// \brief numeric address of the client, the port changes with each connection
+static std::string clientAddress(const struct sockaddr* addr)
+{
+    char hoststr[NI_MAXHOST];
+    int len = addr->sa_family == AF_INET6 ? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+    if (getnameinfo(addr, len, hoststr, sizeof(hoststr), nullptr, 0, NI_NUMERICHOST) != 0)
+        return "";
+    return hoststr;
+}
+
 static bool checkFileAndSubtitle(fs::path& path, const std::shared_ptr<CdsObject>& obj, const size_t& res_id, std::string& mimeType, struct stat& statbuf, const std::string& rh)
 {
     bool is_srt = false;
@@ -76,6 +100,149 @@ static bool checkFileAndSubtitle(fs::path& path, const std::shared_ptr<CdsObject
     return is_srt;
 }
 
+/// \brief position a seekable transcoding has to start at, from TimeSeekRange.dlna.org or an estimate for a byte Range
+static void getSeekStart(const std::map<std::string, std::string>& requestHeaders, const std::shared_ptr<ResolvedFileRequest>& request, int& startTime, off_t& startOffset)
+{
+    startTime = 0;
+    startOffset = 0;
+    auto item = std::dynamic_pointer_cast<CdsItem>(request->obj);
+    if (item == nullptr || item->getResourceCount() == 0 || request->profile == nullptr || !request->profile->isSeekable())
+        return;
+
+    std::string timeSeek;
+    std::string range;
+    for (auto&& [key, value] : requestHeaders) {
+        auto name = toLower(key);
+        if (name == toLower(UPNP_DLNA_TIME_SEEK_RANGE_HEADER))
+            timeSeek = value;
+        else if (name == "range")
+            range = value;
+    }
+
+    // npt=10.5- or npt=0:00:10.500-0:01:00
+    if (startswith(timeSeek, "npt=")) {
+        startTime = std::max(nptToMilliseconds(trimString(timeSeek.substr(4, timeSeek.find('-') - 4))), 0);
+        return;
+    }
+
+    // bytes=1000000-, the transcoded size is unknown so use the position in the original file
+    if (!startswith(range, "bytes="))
+        return;
+    off_t offset = std::strtoll(range.c_str() + 6, nullptr, 10);
+    if (offset <= 0)
+        return;
+
+    auto res = item->getResource(0);
+    auto duration = res->getAttribute(R_DURATION).empty() ? 0 : HMSFToMilliseconds(res->getAttribute(R_DURATION));
+    // upnp bitrate is in bytes per second
+    off_t bitrate = std::strtoll(res->getAttribute(R_BITRATE).c_str(), nullptr, 10);
+    if (bitrate <= 0 && duration > 0)
+        bitrate = request->statbuf.st_size * 1000 / duration;
+    if (bitrate <= 0)
+        return;
+
+    auto start = offset * 1000 / bitrate;
+    startTime = int(duration > 0 ? std::min<off_t>(start, duration) : start);
+    startOffset = offset;
+}
+
+std::shared_ptr<ResolvedFileRequest> FileRequestHandler::resolve(const char* filename)
+{
+    auto request = std::make_shared<ResolvedFileRequest>();
+    request->params = parseParameters(filename, LINK_FILE_REQUEST_HANDLER);
+    request->obj = getObjectById(request->params);
+    request->resourceHandler = getValueOrDefault(request->params, RESOURCE_HANDLER);
+
+    // determining which resource to serve
+    auto res_id_it = request->params.find(URL_RESOURCE_ID);
+    request->resId = (res_id_it != request->params.end() && res_id_it->second != URL_VALUE_TRANSCODE_NO_RES_ID) ? std::stoi(res_id_it->second) : std::numeric_limits<std::size_t>::max();
+
+    auto obj = request->obj;
+    if (!obj->isItem() && request->resourceHandler.empty()) {
+        throw_std_runtime_error("Requested object {} is not an item", filename);
+    }
+
+    auto item = std::dynamic_pointer_cast<CdsItem>(obj);
+    request->path = item != nullptr ? item->getLocation() : "";
+    request->isSrt = checkFileAndSubtitle(request->path, obj, request->resId, request->mimeType, request->statbuf, request->resourceHandler);
+    request->readable = access(request->path.c_str(), R_OK) == 0;
+
+    // some resources are created dynamically and not saved in the database,
+    // so we can not load such a resource for a particular item, we will have
+    // to trust the resource handler parameter
+    if ((request->resId > 0 && request->resId < obj->getResourceCount()) || !request->resourceHandler.empty()) {
+        request->handlerType = !request->resourceHandler.empty() ? std::stoi(request->resourceHandler) : obj->getResource(request->resId)->getHandlerType();
+    }
+
+    // for transcoded resourecs res_id will always be negative
+    request->trProfile = getValueOrDefault(request->params, URL_PARAM_TRANSCODE_PROFILE_NAME);
+    if (!request->trProfile.empty()) {
+        request->profile = config->getTranscodingProfileListOption(CFG_TRANSCODING_PROFILE_LIST)
+                               ->getByName(request->trProfile);
+    }
+    return request;
+}
+
+std::unique_ptr<IOHandler> FileRequestHandler::serveResource(const std::shared_ptr<ResolvedFileRequest>& request)
+{
+    bool store = thumbnailStore != nullptr && ThumbnailStore::isStored(request->handlerType);
+    if (store) {
+        auto io_handler = thumbnailStore->get(request->obj->getID(), request->resId, request->statbuf);
+        if (io_handler != nullptr)
+            return io_handler;
+    }
+
+    auto h = MetadataHandler::createHandler(context, request->handlerType);
+    auto io_handler = h->serveContent(request->obj, request->resId);
+    if (!store || io_handler == nullptr)
+        return io_handler;
+
+    std::string data;
+    char buf[16 * 1024];
+    io_handler->open(UPNP_READ);
+    for (std::size_t bytes; (bytes = io_handler->read(buf, sizeof(buf))) > 0;)
+        data.append(buf, bytes);
+    io_handler->close();
+
+    auto stored = thumbnailStore->put(request->obj->getID(), request->resId, request->statbuf, data);
+    if (stored != nullptr)
+        return stored;
+    return std::make_unique<MemIOHandler>(data);
+}
+
+std::unique_ptr<IOHandler> FileRequestHandler::meter(const std::shared_ptr<ResolvedFileRequest>& request, std::unique_ptr<IOHandler> ioHandler)
+{
+    auto statistics = context->getStreamStatistics();
+    if (statistics == nullptr || !statistics->isEnabled())
+        return ioHandler;
+
+    auto stream = statistics->start(request->client, request->obj->getID(), request->path);
+    return std::make_unique<MeteredIOHandler>(std::move(ioHandler), statistics, stream);
+}
+
+std::string FileRequestHandler::getHlsPlaylist(const std::shared_ptr<ResolvedFileRequest>& request)
+{
+    auto item = std::dynamic_pointer_cast<CdsItem>(request->obj);
+    if (item == nullptr)
+        throw_std_runtime_error("Hls transcoding of object {} which is not an item", request->obj->getID());
+
+    std::vector<std::shared_ptr<TranscodingProfile>> variants { request->profile };
+    auto profiles = config->getTranscodingProfileListOption(CFG_TRANSCODING_PROFILE_LIST);
+    for (auto&& name : request->profile->getVariants()) {
+        auto variant = profiles->getByName(name);
+        if (variant != nullptr)
+            variants.push_back(variant);
+    }
+    if (variants.size() > 1 && request->params.find(URL_PARAM_HLS_VARIANT) == request->params.end())
+        return HlsSessionManager::getMasterPlaylist(item, variants, request->params);
+
+    bool started = false;
+    auto playlist = content->getHlsSessionManager()->getPlaylist(item, request->profile, request->client, request->params, request->startTime, started);
+    if (started)
+        content->triggerPlayHook(item);
+    return playlist;
+}
+
 void FileRequestHandler::getInfo(const char* filename, UpnpFileInfo* info)
 {
     log_debug("start");
@@ -87,30 +254,56 @@ void FileRequestHandler::getInfo(const char* filename, UpnpFileInfo* info)
 
     auto headers = std::make_unique<Headers>();
 
-    auto params = parseParameters(filename, LINK_FILE_REQUEST_HANDLER);
-    auto obj = getObjectById(params);
-    std::string rh = getValueOrDefault(params, RESOURCE_HANDLER);
-
-    // determining which resource to serve
-    auto res_id_it = params.find(URL_RESOURCE_ID);
-    size_t res_id = (res_id_it != params.end() && res_id_it->second != URL_VALUE_TRANSCODE_NO_RES_ID) ? std::stoi(res_id_it->second) : std::numeric_limits<std::size_t>::max();
+    std::string client = clientAddress(reinterpret_cast<const struct sockaddr*>(ctrlPtIPAddr));
+    const void* token = nullptr;
+    auto request = requestCache != nullptr ? requestCache->get(filename, client, token) : nullptr;
+    if (request != nullptr) {
+        log_debug("reusing resolved request {}", filename);
+    } else {
+        request = resolve(filename);
+        request->client = client;
+        if (request->handlerType != -1) {
+            auto io_handler = serveResource(request);
+
+            // get size
+            io_handler->open(UPNP_READ);
+            io_handler->seek(0L, SEEK_END);
+            request->resourceSize = io_handler->tell();
+            io_handler->close();
+        }
+        if (requestCache != nullptr)
+            token = requestCache->put(filename, client, request);
+    }
 
-    if (!obj->isItem() && rh.empty()) {
-        throw_std_runtime_error("Requested object {} is not an item", filename);
+    int startTime;
+    off_t startOffset;
+    getSeekStart(*Headers::readHeaders(info), request, startTime, startOffset);
+    if (startTime != request->startTime || startOffset != request->startOffset) {
+        // the resolved request is shared with other requests for the url
+        request = std::make_shared<ResolvedFileRequest>(*request);
+        request->startTime = startTime;
+        request->startOffset = startOffset;
+        if (requestCache != nullptr)
+            token = requestCache->put(filename, client, request);
+    }
+    // a hls playlist grows while the transcoder runs, so the one of the last request can not be reused
+    bool hlsSegment = !getValueOrDefault(request->params, URL_PARAM_HLS_SESSION).empty();
+    if (request->profile != nullptr && request->profile->getType() == TR_Hls && !hlsSegment) {
+        request = std::make_shared<ResolvedFileRequest>(*request);
+        request->hlsPlaylist = getHlsPlaylist(request);
+        if (requestCache != nullptr)
+            token = requestCache->put(filename, client, request);
     }
+    setRequestCookie(token);
 
+    auto obj = request->obj;
     auto item = std::dynamic_pointer_cast<CdsItem>(obj);
+    const fs::path& path = request->path;
+    std::string mimeType = request->mimeType;
+    const struct stat& statbuf = request->statbuf;
+    size_t res_id = request->resId;
 
-    fs::path path = item != nullptr ? item->getLocation() : "";
-    std::string mimeType;
-    struct stat statbuf;
-    bool is_srt = checkFileAndSubtitle(path, obj, res_id, mimeType, statbuf, rh);
-
-    if (access(path.c_str(), R_OK) == 0) {
-        UpnpFileInfo_set_IsReadable(info, 1);
-    } else {
-        UpnpFileInfo_set_IsReadable(info, 0);
-    }
+    UpnpFileInfo_set_IsReadable(info, request->readable ? 1 : 0);
 
     std::string header;
     log_debug("path: {}", path.c_str());
@@ -118,21 +311,10 @@ void FileRequestHandler::getInfo(const char* filename, UpnpFileInfo* info)
         header = fmt::format("Content-Disposition: attachment; filename=\"{}\"", path.filename().c_str());
     }
 
-    // for transcoded resourecs res_id will always be negative
-    std::string tr_profile = getValueOrDefault(params, URL_PARAM_TRANSCODE_PROFILE_NAME);
-
     log_debug("fetching resource id {}", res_id);
 
-    // some resources are created dynamically and not saved in the database,
-    // so we can not load such a resource for a particular item, we will have
-    // to trust the resource handler parameter
-    if ((res_id > 0 && res_id < obj->getResourceCount()) || !rh.empty()) {
-        int res_handler;
-        if (!rh.empty())
-            res_handler = std::stoi(rh);
-        else {
-            auto resource = obj->getResource(res_id);
-            res_handler = resource->getHandlerType();
+    if (request->handlerType != -1) {
+        if (request->resourceHandler.empty()) {
             // http-get:*:image/jpeg:*
             std::string protocolInfo = getValueOrDefault(obj->getResource(res_id)->getAttributes(), "protocolInfo");
             if (!protocolInfo.empty()) {
@@ -140,26 +322,33 @@ void FileRequestHandler::getInfo(const char* filename, UpnpFileInfo* info)
             }
         }
 
-        auto h = MetadataHandler::createHandler(context, res_handler);
         if (mimeType.empty())
-            mimeType = h->getMimeType();
-
-        auto io_handler = h->serveContent(obj, res_id);
+            mimeType = MetadataHandler::createHandler(context, request->handlerType)->getMimeType();
 
-        // get size
-        io_handler->open(UPNP_READ);
-        io_handler->seek(0L, SEEK_END);
-        off_t size = io_handler->tell();
-        io_handler->close();
+        UpnpFileInfo_set_FileLength(info, request->resourceSize);
 
-        UpnpFileInfo_set_FileLength(info, size);
-    } else if (!is_srt && !tr_profile.empty()) {
-        auto tp = config->getTranscodingProfileListOption(CFG_TRANSCODING_PROFILE_LIST)
-                      ->getByName(tr_profile);
+        // art and thumbnails are extracted from the media file, so they only change with it
+        headers->addHeader("ETag", fmt::format("\"{:x}-{:x}-{:x}-{:x}\"", obj->getID(), res_id, statbuf.st_mtime, request->resourceSize));
+        if (startswith(mimeType, "image/"))
+            headers->addHeader("Cache-Control", fmt::format("public, max-age={}", RESOURCE_CACHE_MAX_AGE));
+    } else if (!request->isSrt && !request->trProfile.empty()) {
+        auto tp = request->profile;
         if (tp == nullptr)
-            throw_std_runtime_error("Transcoding of file {} but no profile matching the name {} found", path.c_str(), tr_profile.c_str());
+            throw_std_runtime_error("Transcoding of file {} but no profile matching the name {} found", path.c_str(), request->trProfile.c_str());
 
         mimeType = tp->getTargetMimeType();
+        if (tp->getType() == TR_Hls) {
+            if (hlsSegment) {
+                auto segment = content->getHlsSessionManager()->getSegment(getValueOrDefault(request->params, URL_PARAM_HLS_SESSION), getValueOrDefault(request->params, URL_PARAM_HLS_FILE));
+                struct stat segmentStat;
+                if (stat(segment.c_str(), &segmentStat) != 0)
+                    throw_std_runtime_error("Failed to stat {}: {}", segment.c_str(), std::strerror(errno));
+                mimeType = mime->getMimeType(segment, "video/mp2t");
+                UpnpFileInfo_set_FileLength(info, segmentStat.st_size);
+            } else {
+                UpnpFileInfo_set_FileLength(info, request->hlsPlaylist.size());
+            }
+        }
 
         auto mappings = config->getDictionaryOption(
             CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
@@ -172,19 +361,28 @@ void FileRequestHandler::getInfo(const char* filename, UpnpFileInfo* info)
                 mimeType += fmt::format(";channels={}", nrch);
         }
 
+        // answer a time seek with the range that is served
+        if (request->startTime > 0 && request->startOffset == 0) {
+            auto duration = obj->getResource(0)->getAttribute(R_DURATION);
+            auto range = fmt::format("npt={}-", millisecondsToHMSF(request->startTime));
+            if (!duration.empty())
+                range += fmt::format("{}/{}", duration, duration);
+            headers->addHeader(UPNP_DLNA_TIME_SEEK_RANGE_HEADER, range);
+        }
+
+        if (tp->getType() != TR_Hls) {
 #ifdef UPNP_USING_CHUNKED
-        UpnpFileInfo_set_FileLength(info, UPNP_USING_CHUNKED);
+            UpnpFileInfo_set_FileLength(info, UPNP_USING_CHUNKED);
 #else
-        UpnpFileInfo_set_FileLength(info, -1);
+            UpnpFileInfo_set_FileLength(info, -1);
 #endif
+        }
     } else if (item != nullptr) {
         UpnpFileInfo_set_FileLength(info, statbuf.st_size);
 
         quirks->addCaptionInfo(item, headers);
 
-        auto mappings = config->getDictionaryOption(
-            CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
-        std::string dlnaContentHeader = getDLNAContentHeader(config, getValueOrDefault(mappings, item->getMimeType()));
+        const auto& dlnaContentHeader = xmlBuilder->getDLNAMimeInfo(item->getMimeType()).contentFeatures;
         if (!dlnaContentHeader.empty()) {
             headers->addHeader(UPNP_DLNA_CONTENT_FEATURES_HEADER, dlnaContentHeader);
         }
@@ -193,7 +391,7 @@ void FileRequestHandler::getInfo(const char* filename, UpnpFileInfo* info)
     if (mimeType.empty() && item != nullptr)
         mimeType = item->getMimeType();
 
-    std::string dlnaTransferHeader = getDLNATransferHeader(config, mimeType);
+    const auto& dlnaTransferHeader = xmlBuilder->getDLNAMimeInfo(mimeType).transferMode;
     if (!dlnaTransferHeader.empty()) {
         headers->addHeader(UPNP_DLNA_TRANSFER_MODE_HEADER, dlnaTransferHeader);
     }
@@ -226,28 +424,19 @@ std::unique_ptr<IOHandler> FileRequestHandler::open(const char* filename, enum U
         throw_std_runtime_error("UPNP_WRITE unsupported");
     }
 
-    auto params = parseParameters(filename, LINK_FILE_REQUEST_HANDLER);
-    auto obj = getObjectById(params);
-    std::string rh = getValueOrDefault(params, RESOURCE_HANDLER);
-
-    // determining which resource to serve
-    auto res_id_it = params.find(URL_RESOURCE_ID);
-    size_t res_id = (res_id_it != params.end() && res_id_it->second != URL_VALUE_TRANSCODE_NO_RES_ID) ? std::stoi(res_id_it->second) : std::numeric_limits<std::size_t>::max();
-
-    if (!obj->isItem() && rh.empty()) {
-        throw_std_runtime_error("requested object {} is not an item", filename);
+    auto request = requestCache != nullptr ? requestCache->get(getRequestCookie(), filename) : nullptr;
+    if (request != nullptr) {
+        log_debug("reusing resolved request {}", filename);
+    } else {
+        request = resolve(filename);
     }
 
+    auto obj = request->obj;
     auto item = std::dynamic_pointer_cast<CdsItem>(obj);
+    const fs::path& path = request->path;
+    size_t res_id = request->resId;
 
-    fs::path path = item != nullptr ? item->getLocation() : "";
-    std::string mimeType;
-    struct stat statbuf;
-    bool is_srt = checkFileAndSubtitle(path, obj, res_id, mimeType, statbuf, rh);
-
-    // for transcoded resourecs res_id will always be negative
-    auto tr_profile = getValueOrDefault(params, URL_PARAM_TRANSCODE_PROFILE_NAME);
-    if (!tr_profile.empty()) {
+    if (!request->trProfile.empty()) {
         if (res_id != std::numeric_limits<std::size_t>::max())
             throw_std_runtime_error("Invalid resource ID given");
     } else {
@@ -256,38 +445,46 @@ std::unique_ptr<IOHandler> FileRequestHandler::open(const char* filename, enum U
     }
     log_debug("fetching resource id {}", res_id);
 
-    // some resources are created dynamically and not saved in the database,
-    // so we can not load such a resource for a particular item, we will have
-    // to trust the resource handler parameter
-    if ((res_id > 0 && res_id < obj->getResourceCount()) || !rh.empty()) {
-        auto res_handler = int { !rh.empty() ? std::stoi(rh) : obj->getResource(res_id)->getHandlerType() };
+    if (request->handlerType != -1) {
+        auto io_handler = serveResource(request);
+        io_handler->open(mode);
+
+        log_debug("end");
+        return meter(request, std::move(io_handler));
+    }
 
-        auto h = MetadataHandler::createHandler(context, res_handler);
-        auto io_handler = h->serveContent(obj, res_id);
+    if (!request->isSrt && request->profile != nullptr && request->profile->getType() == TR_Hls) {
+        std::unique_ptr<IOHandler> io_handler;
+        auto sessionId = getValueOrDefault(request->params, URL_PARAM_HLS_SESSION);
+        if (!sessionId.empty())
+            io_handler = std::make_unique<FileIOHandler>(content->getHlsSessionManager()->getSegment(sessionId, getValueOrDefault(request->params, URL_PARAM_HLS_FILE)));
+        else
+            io_handler = std::make_unique<MemIOHandler>(!request->hlsPlaylist.empty() ? request->hlsPlaylist : getHlsPlaylist(request));
         io_handler->open(mode);
 
         log_debug("end");
-        return io_handler;
+        return meter(request, std::move(io_handler));
     }
 
-    if (!is_srt && !tr_profile.empty()) {
-        std::string range = getValueOrDefault(params, "range");
+    if (!request->isSrt && !request->trProfile.empty()) {
+        std::string range = getValueOrDefault(request->params, "range");
 
         auto tr_d = std::make_unique<TranscodeDispatcher>(content);
-        auto tp = config->getTranscodingProfileListOption(CFG_TRANSCODING_PROFILE_LIST)
-                      ->getByName(tr_profile);
-
-        auto io_handler = tr_d->serveContent(tp, path, item, range);
+        auto io_handler = tr_d->serveContent(request->profile, path, item, range, request->startTime);
         io_handler->open(mode);
+        if (request->startOffset > 0)
+            io_handler = std::make_unique<OffsetIOHandler>(std::move(io_handler), request->startOffset);
 
         log_debug("end");
-        return io_handler;
+        return meter(request, std::move(io_handler));
     }
 
-    auto io_handler = std::make_unique<FileIOHandler>(path);
+    auto io_handler = std::make_unique<FileIOHandler>(path, readAheadPool);
     io_handler->open(mode);
     content->triggerPlayHook(obj);
+    if (playbackPredictor != nullptr)
+        playbackPredictor->played(obj);
 
     log_debug("end");
-    return io_handler;
+    return meter(request, std::move(io_handler));
 }
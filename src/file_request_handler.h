@@ -37,12 +37,35 @@
 #include "upnp_xml.h"
 #include <memory>
 
+// forward declaration
+class FileRequestCache;
+class PlaybackPredictor;
+class ReadAheadPool;
+class ThumbnailStore;
+struct ResolvedFileRequest;
+
 class FileRequestHandler : public RequestHandler {
 protected:
     UpnpXMLBuilder* xmlBuilder;
+    std::shared_ptr<ReadAheadPool> readAheadPool;
+    std::shared_ptr<FileRequestCache> requestCache;
+    std::shared_ptr<ThumbnailStore> thumbnailStore;
+    std::shared_ptr<PlaybackPredictor> playbackPredictor;
+
+    /// \brief parse the url and look up object, file and transcoding profile
+    std::shared_ptr<ResolvedFileRequest> resolve(const char* filename);
+
+    /// \brief handler of the metadata handler for the resource, taken from the thumbnail store if possible
+    std::unique_ptr<IOHandler> serveResource(const std::shared_ptr<ResolvedFileRequest>& request);
+
+    /// \brief record the stream in the statistics if they are enabled
+    std::unique_ptr<IOHandler> meter(const std::shared_ptr<ResolvedFileRequest>& request, std::unique_ptr<IOHandler> ioHandler);
+
+    /// \brief master or media playlist of a hls profile, starts the transcoder if the client has no session yet
+    std::string getHlsPlaylist(const std::shared_ptr<ResolvedFileRequest>& request);
 
 public:
-    explicit FileRequestHandler(std::shared_ptr<ContentManager> content, UpnpXMLBuilder* xmlBuilder);
+    explicit FileRequestHandler(std::shared_ptr<ContentManager> content, UpnpXMLBuilder* xmlBuilder, std::shared_ptr<ReadAheadPool> readAheadPool = nullptr, std::shared_ptr<FileRequestCache> requestCache = nullptr, std::shared_ptr<ThumbnailStore> thumbnailStore = nullptr, std::shared_ptr<PlaybackPredictor> playbackPredictor = nullptr);
 
     void getInfo(const char* filename, UpnpFileInfo* info) override;
     std::unique_ptr<IOHandler> open(const char* filename, enum UpnpOpenFileMode mode) override;
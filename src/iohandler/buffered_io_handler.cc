@@ -93,43 +93,11 @@ void BufferedIOHandler::threadProc()
             log_debug("buffer fill level: {:03.2f}%  (bufSize: {}; a: {}; b: {})", percentFillLevel, bufSize, a, b);
         }
 #endif
-        if (empty)
-            a = b = 0;
-
-        if (doSeek && !empty && (seekWhence == SEEK_SET || (seekWhence == SEEK_CUR && seekOffset > 0))) {
-            auto currentFillSize = int(b - a);
-            if (currentFillSize <= 0)
-                currentFillSize += bufSize;
-
-            auto relSeek = int(seekOffset);
-            if (seekWhence == SEEK_SET)
-                relSeek -= posRead;
-
-            if (relSeek <= currentFillSize) { // we have everything we need in the buffer already
-                a += relSeek;
-                posRead += relSeek;
-                if (a >= bufSize)
-                    a -= bufSize;
-                if (a == b) {
-                    empty = true;
-                    a = b = 0;
-                }
-
-                /// \todo do we need to wait for initialFillSize again?
-
-                doSeek = false;
-                threadRunner->notify();
-            }
-        }
-
-        // note: seeking could be optimized some more (backward seeking)
-        // but this should suffice for now
-
+        // seeks into the buffered data are handled by IOHandlerBufferHelper::seek
         if (doSeek) { // seek not been processed yet
             try {
                 underlyingHandler->seek(seekOffset, seekWhence);
-                empty = true;
-                a = b = 0;
+                clearBuffer();
             } catch (const std::runtime_error& e) {
                 log_error("Error while seeking in buffer: {}", e.what());
             }
@@ -141,7 +109,7 @@ void BufferedIOHandler::threadProc()
             threadRunner->notify();
         }
 
-        maxWrite = (empty ? bufSize : (a < b ? bufSize - b : a - b));
+        maxWrite = getWriteSize();
         if (maxWrite == 0) {
             threadRunner->wait(lock);
         } else {
@@ -159,10 +127,7 @@ void BufferedIOHandler::threadProc()
                     threadRunner->notify();
                 }
                 if (waitForInitialFillSize) {
-                    auto currentFillSize = int(b - a);
-                    if (currentFillSize <= 0)
-                        currentFillSize += bufSize;
-                    if (size_t(currentFillSize) >= initialFillSize) {
+                    if (getFillSize() >= initialFillSize) {
                         log_debug("buffer: initial fillsize reached");
                         waitForInitialFillSize = false;
                         threadRunner->notify();
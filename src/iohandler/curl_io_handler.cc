@@ -32,7 +32,10 @@
 #ifdef HAVE_CURL
 #include "curl_io_handler.h" // API
 
+#include <algorithm>
+
 #include "config/config_manager.h"
+#include "util/curl_engine.h"
 #include "util/tools.h"
 
 CurlIOHandler::CurlIOHandler(std::shared_ptr<Config> config, const std::string& URL, CURL* curl_handle, size_t bufSize, size_t initialFillSize)
@@ -66,22 +69,33 @@ void CurlIOHandler::open(enum UpnpOpenFileMode mode)
     IOHandlerBufferHelper::open(mode);
 }
 
+size_t CurlIOHandler::read(char* buf, size_t length)
+{
+    auto ret = IOHandlerBufferHelper::read(buf, length);
+
+    auto lock = threadRunner->uniqueLock();
+    if (pausedWrite > 0 && getFreeSize() + behind >= pausedWrite) {
+        pausedWrite = 0;
+        lock.unlock();
+        CurlEngine::getInstance().unpause(curl_handle);
+    }
+    return ret;
+}
+
 void CurlIOHandler::close()
 {
     IOHandlerBufferHelper::close();
 
-    if (external_curl_handle && curl_handle != nullptr)
+    if (!external_curl_handle && curl_handle != nullptr) {
         curl_easy_cleanup(curl_handle);
+        curl_handle = nullptr;
+    }
 }
 
-void CurlIOHandler::threadProc()
+void CurlIOHandler::startBufferThread()
 {
-    CURLcode res;
-    assert(curl_handle != nullptr);
-    assert(!URL.empty());
-
-    //char error_buffer[CURL_ERROR_SIZE] = {'\0'};
-    //curl_easy_setopt(curl_handle, CURLOPT_ERRORBUFFER, error_buffer);
+    // only used for the synchronisation with the engine thread
+    threadRunner = std::make_unique<IOBufferPool::Job>();
 
     curl_easy_setopt(curl_handle, CURLOPT_URL, URL.c_str());
     curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1);
@@ -97,45 +111,94 @@ void CurlIOHandler::threadProc()
     if (logEnabled)
         curl_easy_setopt(curl_handle, CURLOPT_VERBOSE, 1);
 
-    //curl_easy_setopt(curl_handle, CURLOPT_CONNECTTIMEOUT,
-
-    //proxy..
-
     curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, CurlIOHandler::curlCallback);
     curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void*)this);
 
-    auto lock = threadRunner->uniqueLock(std::defer_lock);
-    do {
-        lock.lock();
-        if (doSeek) {
-            log_debug("SEEK: {} {}", seekOffset, seekWhence);
-
-            if (seekWhence == SEEK_SET) {
-                posRead = seekOffset;
-                curl_easy_setopt(curl_handle, CURLOPT_RESUME_FROM_LARGE, seekOffset);
-            } else if (seekWhence == SEEK_CUR) {
-                posRead += seekOffset;
-                curl_easy_setopt(curl_handle, CURLOPT_RESUME_FROM_LARGE, posRead);
-            } else {
-                log_error("CurlIOHandler currently does not support SEEK_END");
-                static_assert(true);
-            }
-
-            /// \todo should we do that?
-            waitForInitialFillSize = (initialFillSize > 0);
-
-            doSeek = false;
-            threadRunner->notify();
+    startTransfer();
+}
+
+void CurlIOHandler::startTransfer()
+{
+    CurlEngine::getInstance().add(config, curl_handle, [this](CURLcode res) { transferDone(res); });
+}
+
+void CurlIOHandler::stopBufferThread()
+{
+    auto lock = threadRunner->uniqueLock();
+    threadShutdown = true;
+    threadRunner->notify();
+    lock.unlock();
+
+    CurlEngine::getInstance().remove(curl_handle);
+    threadRunner = nullptr;
+}
+
+void CurlIOHandler::seekSource(IOBufferPool::Job::AutoLockU& lock)
+{
+    log_debug("SEEK: {} {}", seekOffset, seekWhence);
+    doSeek = false;
+    off_t target;
+    if (seekWhence == SEEK_SET) {
+        target = seekOffset;
+    } else if (seekWhence == SEEK_CUR) {
+        target = posRead + seekOffset;
+    } else if (contentLength >= 0) {
+        target = contentLength + seekOffset;
+    } else {
+        throw_std_runtime_error("CurlIOHandler does not know the length of {} for SEEK_END", URL);
+    }
+
+    // a short jump ahead is cheaper to read through than to reconnect for
+    auto fetched = posRead + off_t(getFillSize());
+    if (!eof && !readError && target >= fetched && target - fetched <= off_t(bufSize)) {
+        skipBytes += target - fetched;
+        clearBuffer();
+        posRead = target;
+        waitForInitialFillSize = (initialFillSize > 0);
+        if (pausedWrite > 0) {
+            pausedWrite = 0;
+            CurlEngine::getInstance().unpause(curl_handle);
         }
-        lock.unlock();
-        res = curl_easy_perform(curl_handle);
-    } while (doSeek);
+        return;
+    }
+
+    // the engine thread calls back with the lock
+    lock.unlock();
+    CurlEngine::getInstance().remove(curl_handle);
+    lock.lock();
 
+    clearBuffer();
+    eof = false;
+    readError = false;
+    pausedWrite = 0;
+    posRead = target;
+    /// \todo should we do that?
+    waitForInitialFillSize = (initialFillSize > 0);
+    restartAt(target);
+}
+
+void CurlIOHandler::restartAt(off_t position)
+{
+    // reissue the request with "Range: bytes=position-" or read from the start and drop the data before position
+    transferOffset = rangeSupported ? position : 0;
+    skipBytes = position - transferOffset;
+    curl_easy_setopt(curl_handle, CURLOPT_RESUME_FROM_LARGE, curl_off_t(transferOffset));
+    startTransfer();
+}
+
+void CurlIOHandler::transferDone(CURLcode res)
+{
+    auto lock = threadRunner->uniqueLock();
+    if (res == CURLE_RANGE_ERROR && transferOffset > 0 && !threadShutdown) {
+        log_debug("{} does not support ranges, seeking by reading from the start", URL);
+        rangeSupported = false;
+        restartAt(transferOffset + skipBytes);
+        return;
+    }
     if (res != CURLE_OK)
         readError = true;
     else
         eof = true;
-
     threadRunner->notify();
 }
 
@@ -147,70 +210,35 @@ size_t CurlIOHandler::curlCallback(void* ptr, size_t size, size_t nmemb, void* d
     assert(wantWrite <= ego->bufSize);
     auto& threadRunner = ego->threadRunner;
 
-    //log_debug("URL: {}; size: {}; nmemb: {}; wantWrite: {}", ego->URL.c_str(), size, nmemb, wantWrite);
-
     auto lock = threadRunner->uniqueLock();
+    if (ego->threadShutdown)
+        return 0;
 
-    bool first = true;
-
-    int bufFree = 0;
-    do {
-        if (ego->doSeek && !ego->empty && (ego->seekWhence == SEEK_SET || (ego->seekWhence == SEEK_CUR && ego->seekOffset > 0))) {
-            auto currentFillSize = int(ego->b - ego->a);
-            if (currentFillSize <= 0)
-                currentFillSize += ego->bufSize;
-
-            auto relSeek = int(ego->seekOffset);
-            if (ego->seekWhence == SEEK_SET)
-                relSeek -= ego->posRead;
-
-            if (relSeek <= currentFillSize) { // we have everything we need in the buffer already
-                ego->a += relSeek;
-                ego->posRead += relSeek;
-                if (ego->a >= ego->bufSize)
-                    ego->a -= ego->bufSize;
-                if (ego->a == ego->b) {
-                    ego->empty = true;
-                    ego->a = ego->b = 0;
-                }
-                /// \todo do we need to wait for initialFillSize again?
-
-                ego->doSeek = false;
-                threadRunner->notify();
-            }
-        }
-
-        // note: seeking could be optimized some more (backward seeking)
-        // but this should suffice for now
-
-        if (ego->doSeek) { // seek not been processed yet
-            ego->a = ego->b = 0;
-            ego->empty = true;
+    if (ego->contentLength < 0) {
+        curl_off_t length;
+        if (curl_easy_getinfo(ego->curl_handle, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length) == CURLE_OK && length >= 0)
+            ego->contentLength = ego->transferOffset + length;
+    }
 
-            // terminate this request, because we need a new request
-            // after the seek
-            return 0;
-        }
+    // data before the seek position
+    if (ego->skipBytes > 0) {
+        auto skip = std::min<size_t>(ego->skipBytes, wantWrite);
+        ego->skipBytes -= skip;
+        ptr = static_cast<char*>(ptr) + skip;
+        wantWrite -= skip;
+        if (wantWrite == 0)
+            return size * nmemb;
+    }
 
-        if (!first) {
-            threadRunner->wait(lock);
-        } else
-            first = false;
-
-        if (ego->threadShutdown)
-            return 0;
-
-        if (ego->empty) {
-            ego->a = ego->b = 0;
-            bufFree = ego->bufSize;
-        } else {
-            bufFree = ego->a - ego->b;
-            if (bufFree < 0)
-                bufFree += ego->bufSize;
-        }
-    } while (size_t(bufFree) < wantWrite);
+    // the engine thread serves all streams, so a full buffer pauses the transfer until read() made room
+    if (ego->makeRoom(wantWrite) < wantWrite) {
+        // curl delivers the whole chunk again, the skipped part included
+        ego->skipBytes += size * nmemb - wantWrite;
+        ego->pausedWrite = wantWrite;
+        return CURL_WRITEFUNC_PAUSE;
+    }
 
-    size_t maxWrite = (ego->empty ? ego->bufSize : (ego->a < ego->b ? ego->bufSize - ego->b : ego->a - ego->b));
+    size_t maxWrite = ego->bufSize - ego->b;
     size_t write1 = (wantWrite > maxWrite ? maxWrite : wantWrite);
     size_t write2 = (write1 < wantWrite ? wantWrite - write1 : 0);
 
@@ -224,7 +252,6 @@ size_t CurlIOHandler::curlCallback(void* ptr, size_t size, size_t nmemb, void* d
 
     lock.lock();
 
-    //ego->bytesCurl += wantWrite;
     ego->b += wantWrite;
     if (ego->b >= ego->bufSize)
         ego->b -= ego->bufSize;
@@ -233,17 +260,14 @@ size_t CurlIOHandler::curlCallback(void* ptr, size_t size, size_t nmemb, void* d
         threadRunner->notify();
     }
     if (ego->waitForInitialFillSize) {
-        auto currentFillSize = int(ego->b - ego->a);
-        if (currentFillSize <= 0)
-            currentFillSize += ego->bufSize;
-        if (size_t(currentFillSize) >= ego->initialFillSize) {
+        if (ego->getFillSize() >= ego->initialFillSize) {
             log_debug("buffer: initial fillsize reached");
             ego->waitForInitialFillSize = false;
             threadRunner->notify();
         }
     }
 
-    return wantWrite;
+    return size * nmemb;
 }
 
 #endif //HAVE_CURL
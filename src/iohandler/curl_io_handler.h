@@ -42,21 +42,39 @@
 
 class Config;
 
+/// \brief Buffers a remote stream, the transfer runs on the CurlEngine thread
 class CurlIOHandler : public IOHandlerBufferHelper {
 public:
     CurlIOHandler(std::shared_ptr<Config> config, const std::string& URL, CURL* curl_handle, size_t bufSize, size_t initialFillSize);
 
     void open(enum UpnpOpenFileMode mode) override;
+    size_t read(char* buf, size_t length) override;
     void close() override;
 
 private:
     CURL* curl_handle;
     bool external_curl_handle;
     std::string URL;
-    //off_t bytesCurl;
+    /// \brief size of the write the transfer was paused at, 0 while it runs
+    size_t pausedWrite { 0 };
+    /// \brief position the running transfer started at
+    off_t transferOffset { 0 };
+    /// \brief bytes the transfer delivers before the read position
+    off_t skipBytes { 0 };
+    /// \brief cleared when the server ignored a Range request
+    bool rangeSupported { true };
+    /// \brief size of the resource if the server sent it, -1 otherwise
+    off_t contentLength { -1 };
 
     static size_t curlCallback(void* ptr, size_t size, size_t nmemb, void* data);
-    void threadProc() override;
+    void transferDone(CURLcode res);
+    void startTransfer();
+    /// \brief start a new transfer at position, called with the lock held
+    void restartAt(off_t position);
+
+    void startBufferThread() override;
+    void stopBufferThread() override;
+    void seekSource(IOBufferPool::Job::AutoLockU& lock) override;
 };
 
 #endif // __CURL_IO_HANDLER_H__
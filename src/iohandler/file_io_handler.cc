@@ -31,80 +31,227 @@
 
 #include "file_io_handler.h" // API
 
-#include <cstdio>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "cds_objects.h"
 
-FileIOHandler::FileIOHandler(fs::path filename)
+/// \brief bytes asked to be read ahead of the current position
+static constexpr off_t READAHEAD_WINDOW = 4 * 1024 * 1024;
+/// \brief bytes read in sequence after a seek before read-ahead is used again
+static constexpr off_t SEQUENTIAL_AFTER_SEEK = 1024 * 1024;
+
+#ifdef __APPLE__
+// no posix_fadvise, the hints are dropped
+#define POSIX_FADV_RANDOM 1
+#define POSIX_FADV_SEQUENTIAL 2
+#define POSIX_FADV_WILLNEED 3
+#endif
+
+FileIOHandler::FileIOHandler(fs::path filename, std::shared_ptr<ReadAheadPool> readAhead)
     : filename(std::move(filename))
-    , f(nullptr)
+    , fd(-1)
+    , readAhead(std::move(readAhead))
 {
 }
 
 FileIOHandler::~FileIOHandler()
 {
-    if (f != nullptr)
+    if (fd >= 0)
         close();
 }
 
 void FileIOHandler::open(enum UpnpOpenFileMode mode)
 {
     if (mode == UPNP_READ) {
-#ifdef __linux__
-        f = ::fopen(filename.c_str(), "rbe");
-#else
-        f = ::fopen(filename.c_str(), "rb");
-#endif
+        fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
     } else {
         throw_std_runtime_error("open: UpnpOpenFileMode mode not supported");
     }
 
-    if (f == nullptr) {
+    if (fd < 0) {
         throw_std_runtime_error("Failed to open: {}", filename.c_str());
     }
+    offset = 0;
+    randomAccess = false;
+    struct stat statbuf;
+    if (readAhead != nullptr && readAhead->hasCache() && fstat(fd, &statbuf) == 0)
+        fileKey = std::make_unique<ReadAheadPool::FileKey>(ReadAheadPool::FileKey { statbuf.st_dev, statbuf.st_ino, statbuf.st_size, statbuf.st_mtime });
+    // media is streamed front to back, let the kernel read ahead further
+    advise(0, 0, POSIX_FADV_SEQUENTIAL);
+    advise(0, READAHEAD_WINDOW, POSIX_FADV_WILLNEED);
+    adviseEnd = READAHEAD_WINDOW;
 }
 
-size_t FileIOHandler::read(char* buf, size_t length)
+void FileIOHandler::advise(off_t start, off_t length, int advice)
 {
-    size_t ret = 0;
+#ifdef __APPLE__
+    (void)start;
+    (void)length;
+    (void)advice;
+#else
+    posix_fadvise(fd, start, length, advice);
+#endif
+}
 
-    ret = fread(buf, sizeof(char), length, f);
+size_t FileIOHandler::readFile(char* buf, size_t length, off_t pos)
+{
+    size_t ret = 0;
 
-    if (ret == 0) {
-        if (feof(f))
-            return 0;
-        if (ferror(f))
+    while (ret < length) {
+        auto bytes = ::pread(fd, buf + ret, length - ret, pos + ret);
+        if (bytes == 0)
+            break;
+        if (bytes < 0) {
+            if (errno == EINTR)
+                continue;
+            if (ret > 0)
+                break;
             return -1;
+        }
+        ret += bytes;
     }
-
     return ret;
 }
 
-size_t FileIOHandler::write(char* buf, size_t length)
+size_t FileIOHandler::readChunks(char* buf, size_t length)
 {
+    auto chunkSize = off_t(readAhead->getChunkSize());
+    auto pos = offset;
+    // the chunks of the old position are of no use after a seek
+    if (!chunks.empty() && (pos < chunks.front()->offset || pos >= chunks.front()->offset + chunkSize))
+        dropChunks();
+    // aligned, so streams of the same file request the same chunks
+    if (chunks.empty())
+        nextChunk = pos - pos % chunkSize;
+    while (chunks.size() < readAhead->getChunksPerStream()) {
+        chunks.push_back(readAhead->request(fd, nextChunk, fileKey.get()));
+        nextChunk += chunkSize;
+    }
+
     size_t ret = 0;
+    while (ret < length && !chunks.empty()) {
+        auto chunk = chunks.front();
+        if (!readAhead->wait(chunk)) {
+            // the next read goes to the file and reports the error
+            dropChunks();
+            break;
+        }
+        auto start = std::size_t(pos - chunk->offset);
+        if (start >= chunk->length)
+            break; // end of file
+        auto bytes = std::min(chunk->length - start, length - ret);
+        std::copy_n(chunk->data.data() + start, bytes, buf + ret);
+        ret += bytes;
+        pos += bytes;
 
-    ret = fwrite(buf, sizeof(char), length, f);
+        if (pos == chunk->offset + chunkSize) {
+            chunks.pop_front();
+            readAhead->release(chunk);
+            chunks.push_back(readAhead->request(fd, nextChunk, fileKey.get()));
+            nextChunk += chunkSize;
+        }
+    }
 
+    if (ret == 0 && chunks.empty())
+        return readFile(buf, length, offset);
+    return ret;
+}
+
+void FileIOHandler::dropChunks()
+{
+    for (auto&& chunk : chunks)
+        readAhead->release(chunk);
+    chunks.clear();
+}
+
+size_t FileIOHandler::read(char* buf, size_t length)
+{
+    auto ret = readAhead != nullptr ? readChunks(buf, length) : readFile(buf, length, offset);
+    if (ret == size_t(-1))
+        return ret;
+    offset += ret;
+
+    if (randomAccess) {
+        sequentialBytes += ret;
+        if (sequentialBytes < SEQUENTIAL_AFTER_SEEK)
+            return ret;
+        log_debug("{}: sequential access again at {}", filename.c_str(), offset);
+        randomAccess = false;
+        advise(0, 0, POSIX_FADV_SEQUENTIAL);
+        adviseEnd = offset;
+    }
+    // keep half a window in flight ahead of the reader
+    if (ret > 0 && offset + READAHEAD_WINDOW / 2 > adviseEnd) {
+        auto start = std::max(offset, adviseEnd);
+        adviseEnd = offset + READAHEAD_WINDOW;
+        advise(start, adviseEnd - start, POSIX_FADV_WILLNEED);
+    }
+
+    return ret;
+}
+
+size_t FileIOHandler::write(char* buf, size_t length)
+{
+    auto ret = ::pwrite(fd, buf, length, offset);
+    if (ret < 0)
+        return 0;
+
+    offset += ret;
     return ret;
 }
 
 void FileIOHandler::seek(off_t offset, int whence)
 {
-    if (fseeko(f, offset, whence) != 0) {
-        throw_std_runtime_error("fseek failed");
+    off_t target = offset;
+    if (whence == SEEK_CUR) {
+        target += this->offset;
+    } else if (whence == SEEK_END) {
+        struct stat statbuf;
+        if (fstat(fd, &statbuf) != 0)
+            throw_std_runtime_error("fstat failed");
+        target += statbuf.st_size;
+    } else if (whence != SEEK_SET) {
+        throw_std_runtime_error("seek: invalid whence {}", whence);
     }
+    if (target < 0) {
+        throw_std_runtime_error("seek before start of {}", filename.c_str());
+    }
+    if (target == this->offset)
+        return;
+
+    // positioning for a range request before any data was read is not a jump
+    bool started = this->offset > 0 || randomAccess;
+    this->offset = target;
+    if (started) {
+        log_debug("{}: random access at {}", filename.c_str(), target);
+        randomAccess = true;
+        sequentialBytes = 0;
+        advise(0, 0, POSIX_FADV_RANDOM);
+        return;
+    }
+    adviseEnd = target + READAHEAD_WINDOW;
+    advise(target, READAHEAD_WINDOW, POSIX_FADV_WILLNEED);
 }
 
 off_t FileIOHandler::tell()
 {
-    return ftello(f);
+    return offset;
 }
 
 void FileIOHandler::close()
 {
-    if (f != nullptr && fclose(f) != 0) {
-        throw_std_runtime_error("fclose failed");
+    // pending reads must be done before the descriptor can be reused
+    if (readAhead != nullptr)
+        dropChunks();
+
+    // the descriptor is gone even if close reports an error
+    int ret = fd >= 0 ? ::close(fd) : 0;
+    fd = -1;
+    if (ret != 0) {
+        throw_std_runtime_error("close failed");
     }
-    f = nullptr;
 }
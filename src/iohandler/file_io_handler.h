@@ -32,11 +32,14 @@
 #ifndef __FILE_IO_HANDLER_H__
 #define __FILE_IO_HANDLER_H__
 
+#include <deque>
 #include <filesystem>
+#include <memory>
 namespace fs = std::filesystem;
 
 #include "common.h"
 #include "io_handler.h"
+#include "read_ahead_pool.h"
 
 /// \brief Allows the web server to read from a file.
 class FileIOHandler : public IOHandler {
@@ -44,12 +47,41 @@ protected:
     /// \brief Name of the file.
     fs::path filename;
 
-    /// \brief Handle of the file.
-    FILE* f;
+    /// \brief Descriptor of the file.
+    ///
+    /// Plain read() copies straight into the buffer of the web server, stdio
+    /// would add a second copy through its own buffer.
+    int fd;
+
+    /// \brief Position of the next read, reads use pread.
+    off_t offset { 0 };
+
+    /// \brief End of the range the kernel was asked to read ahead.
+    off_t adviseEnd { 0 };
+
+    /// \brief Set after a seek until enough data was read in sequence again.
+    bool randomAccess { false };
+    off_t sequentialBytes { 0 };
+
+    /// \brief Reads the chunks in advance if set.
+    std::shared_ptr<ReadAheadPool> readAhead;
+    std::deque<std::shared_ptr<ReadAheadPool::Chunk>> chunks;
+    /// \brief Offset of the next chunk to request.
+    off_t nextChunk { 0 };
+    /// \brief Version of the file to share chunks with other streams, unset without cache.
+    std::unique_ptr<ReadAheadPool::FileKey> fileKey;
+
+    /// \brief Hint the kernel about the access pattern, a no-op without posix_fadvise.
+    void advise(off_t start, off_t length, int advice);
+
+    size_t readFile(char* buf, size_t length, off_t pos);
+    size_t readChunks(char* buf, size_t length);
+    void dropChunks();
 
 public:
     /// \brief Sets the filename to work with.
-    explicit FileIOHandler(fs::path filename);
+    /// \param readAhead pool that reads the file in advance, nullptr reads on demand.
+    explicit FileIOHandler(fs::path filename, std::shared_ptr<ReadAheadPool> readAhead = nullptr);
     ~FileIOHandler();
 
     /// \brief Opens file for reading (writing is not supported)
@@ -58,6 +90,7 @@ public:
     /// \brief Reads a previously opened file sequentially.
     /// \param buf Data from the file will be copied into this buffer.
     /// \param length Number of bytes to be copied into the buffer.
+    /// \return number of bytes read, less than length only at the end of the file.
     size_t read(char* buf, size_t length) override;
 
     /// \brief Writes to a previously opened file.
@@ -0,0 +1,165 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    io_buffer_pool.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+
+/// \file io_buffer_pool.cc
+
+#include "io_buffer_pool.h" // API
+
+#include <algorithm>
+
+#include "exceptions.h"
+
+/// \brief memory of the buffers kept while no handler uses them
+static constexpr std::size_t MAX_IDLE_BUFFER_MEMORY = 64 * 1024 * 1024;
+
+void IOBufferPool::Job::join()
+{
+    auto lock = uniqueLock();
+    doneCond.wait(lock, [this] { return done; });
+}
+
+IOBufferPool& IOBufferPool::getInstance()
+{
+    static IOBufferPool instance;
+    return instance;
+}
+
+IOBufferPool::IOBufferPool()
+{
+    memory = MemoryAccounting::getInstance().add("io-buffers", [this] {
+        AutoLock lock(mutex);
+        return usedBufferMemory + idleBufferMemory;
+    });
+}
+
+IOBufferPool::~IOBufferPool()
+{
+    {
+        AutoLock lock(mutex);
+        shutdownFlag = true;
+        jobCond.notify_all();
+    }
+    for (auto&& worker : workers)
+        worker->thread->join();
+    for (auto&& [size, buffer] : idleBuffers)
+        delete[] buffer;
+}
+
+char* IOBufferPool::getBuffer(std::size_t size)
+{
+    {
+        AutoLock lock(mutex);
+        auto idle = idleBuffers.find(size);
+        if (idle != idleBuffers.end()) {
+            auto buffer = idle->second;
+            idleBuffers.erase(idle);
+            idleBufferMemory -= size;
+            usedBufferMemory += size;
+            return buffer;
+        }
+        usedBufferMemory += size;
+    }
+    return new char[size];
+}
+
+void IOBufferPool::returnBuffer(char* buffer, std::size_t size)
+{
+    {
+        AutoLock lock(mutex);
+        usedBufferMemory -= size;
+        if (idleBufferMemory + size <= MAX_IDLE_BUFFER_MEMORY) {
+            idleBuffers.emplace(size, buffer);
+            idleBufferMemory += size;
+            return;
+        }
+    }
+    delete[] buffer;
+}
+
+void IOBufferPool::start(const std::shared_ptr<Config>& config, Job* job, std::function<void()> fn)
+{
+    job->fn = std::move(fn);
+
+    AutoLock lock(mutex);
+    maxIdleWorkers = config->getIntOption(CFG_THREAD_IDLE_IO_THREADS);
+    // threads that ended because too many were idle
+    workers.erase(std::remove_if(workers.begin(), workers.end(), [](auto&& worker) {
+        if (!worker->finished)
+            return false;
+        worker->thread->join();
+        return true;
+    }),
+        workers.end());
+
+    jobs.push_back(job);
+    if (idleWorkers > jobs.size() - 1) {
+        jobCond.notify_one();
+        return;
+    }
+
+    auto worker = std::make_unique<Worker>();
+    worker->pool = this;
+    worker->thread = std::make_unique<StdThreadRunner>("BufferHelperThread", IOBufferPool::staticThreadProc, worker.get(), config);
+    if (!worker->thread->isAlive()) {
+        jobs.pop_back();
+        job->done = true;
+        throw_std_runtime_error("Could not start buffer thread");
+    }
+    workers.push_back(std::move(worker));
+}
+
+void* IOBufferPool::staticThreadProc(void* arg)
+{
+    auto worker = static_cast<Worker*>(arg);
+    worker->pool->threadProc(worker);
+    return nullptr;
+}
+
+void IOBufferPool::threadProc(Worker* worker)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!shutdownFlag) {
+        if (jobs.empty()) {
+            if (idleWorkers >= maxIdleWorkers)
+                break;
+            idleWorkers++;
+            jobCond.wait(lock);
+            idleWorkers--;
+            continue;
+        }
+        auto job = jobs.front();
+        jobs.pop_front();
+        lock.unlock();
+
+        job->fn();
+        {
+            auto jobLock = job->uniqueLock();
+            job->done = true;
+            job->doneCond.notify_all();
+        }
+
+        lock.lock();
+    }
+    worker->finished = true;
+}
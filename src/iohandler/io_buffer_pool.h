@@ -0,0 +1,122 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    io_buffer_pool.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+
+/// \file io_buffer_pool.h
+#ifndef __IO_BUFFER_POOL_H__
+#define __IO_BUFFER_POOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "util/memory_accounting.h"
+#include "util/thread_runner.h"
+
+// forward declaration
+class Config;
+
+/// \brief Buffers and threads of the buffered IOHandlers and IOHandlerChainers, kept for the next handler
+///
+/// Previews and seeks open and close handlers in quick succession, the pool saves
+/// them from allocating a buffer of several megabytes and starting a thread each time.
+/// A job blocks on its stream until the stream ends, so the pool does not limit the running
+/// threads, only the idle ones (CFG_THREAD_IDLE_IO_THREADS).
+class IOBufferPool {
+public:
+    /// \brief a job of the pool, offers the synchronisation of a StdThreadRunner
+    class Job {
+    public:
+        using AutoLockU = std::unique_lock<std::mutex>;
+
+        AutoLockU uniqueLock() { return AutoLockU(mutex); }
+        AutoLockU uniqueLock(std::defer_lock_t tag) { return AutoLockU(mutex, tag); }
+        void wait(AutoLockU& lock) { cond.wait(lock); }
+        template <class Predicate>
+        void wait(AutoLockU& lock, Predicate pred)
+        {
+            cond.wait(lock, pred);
+        }
+        void notify() { cond.notify_one(); }
+
+        /// \brief block until the job returned
+        void join();
+
+    private:
+        friend class IOBufferPool;
+
+        std::function<void()> fn;
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::condition_variable doneCond;
+        bool done { false };
+    };
+
+    static IOBufferPool& getInstance();
+    ~IOBufferPool();
+
+    /// \brief buffer of size bytes, a returned buffer of the same size is used first
+    char* getBuffer(std::size_t size);
+    /// \brief keep the buffer for the next handler unless the idle buffers exceed the memory cap
+    void returnBuffer(char* buffer, std::size_t size);
+
+    /// \brief run fn as job on an idle thread, starts a new one if all are busy
+    ///
+    /// The job must be stored before, fn usually synchronises through it right away.
+    void start(const std::shared_ptr<Config>& config, Job* job, std::function<void()> fn);
+
+protected:
+    IOBufferPool();
+
+    struct Worker {
+        IOBufferPool* pool;
+        std::unique_ptr<StdThreadRunner> thread;
+        bool finished { false };
+    };
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::condition_variable jobCond;
+    bool shutdownFlag { false };
+
+    std::multimap<std::size_t, char*> idleBuffers;
+    std::size_t idleBufferMemory { 0 };
+    /// \brief memory of the buffers handed out to handlers
+    std::size_t usedBufferMemory { 0 };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::deque<Job*> jobs;
+    std::size_t idleWorkers { 0 };
+    std::size_t maxIdleWorkers { DEFAULT_IDLE_IO_THREADS };
+
+    static void* staticThreadProc(void* arg);
+    void threadProc(Worker* worker);
+
+    std::unique_ptr<MemoryAccounting::Registration> memory;
+};
+
+#endif // __IO_BUFFER_POOL_H__
@@ -86,6 +86,12 @@ size_t IOHandler::write(char* buf, size_t length)
     return 0;
 }
 
+/// \brief Moves data into a file descriptor, only data coming from a pipe can do that.
+size_t IOHandler::splice(int fd, size_t length)
+{
+    return SPLICE_UNSUPPORTED;
+}
+
 /// \fn static int web_seek (UpnpWebFileHandle f, long offset,
 ///                   int origin)
 /// \brief Performs a seek on an open file.
@@ -55,6 +55,12 @@ public:
     /// \param length Number of bytes to write.
     virtual size_t write(char* buf, size_t length);
 
+    /// \brief Moves data directly into a file descriptor without copying it through a buffer.
+    /// \param fd Descriptor the data is written to.
+    /// \param length Maximum number of bytes to move.
+    /// \return like read, or SPLICE_UNSUPPORTED if the data has to be read instead.
+    virtual size_t splice(int fd, size_t length);
+
     /// \brief Performs a seek on an open/initialized data.
     /// \param offset Number of bytes to move in the buffer.
 
@@ -31,6 +31,7 @@
 
 #include "io_handler_buffer_helper.h" // API
 
+#include <algorithm>
 #include <cstdlib>
 
 #include "config/config_manager.h"
@@ -52,12 +53,16 @@ IOHandlerBufferHelper::IOHandlerBufferHelper(std::shared_ptr<Config> config, siz
     eof = false;
     readError = false;
     a = b = posRead = 0;
+    behind = 0;
+    // small backward seeks of a player are served from memory
+    keepBehind = bufSize / 4;
     empty = true;
     signalAfterEveryRead = false;
     checkSocket = false;
 
     seekEnabled = false;
     doSeek = false;
+    seekHits = seekMisses = 0;
 }
 
 void IOHandlerBufferHelper::open(enum UpnpOpenFileMode mode)
@@ -65,7 +70,7 @@ void IOHandlerBufferHelper::open(enum UpnpOpenFileMode mode)
     if (isOpen)
         throw_std_runtime_error("tried to reopen an open IOHandlerBufferHelper");
 
-    buffer = new char[bufSize];
+    buffer = IOBufferPool::getInstance().getBuffer(bufSize);
     startBufferThread();
     isOpen = true;
 }
@@ -122,7 +127,7 @@ size_t IOHandlerBufferHelper::read(char* buf, size_t length)
 
     bool signalled = false;
     // was the buffer full or became it "full" while we read?
-    if (signalAfterEveryRead || a == b) {
+    if (signalAfterEveryRead || getFreeSize() == 0) {
         threadRunner->notify();
         signalled = true;
     }
@@ -130,6 +135,7 @@ size_t IOHandlerBufferHelper::read(char* buf, size_t length)
     a += didRead;
     if (a >= bufSize)
         a -= bufSize;
+    behind = std::min(behind + didRead, keepBehind);
     if (a == b) {
         empty = true;
         if (!signalled)
@@ -140,11 +146,43 @@ size_t IOHandlerBufferHelper::read(char* buf, size_t length)
     return didRead;
 }
 
+size_t IOHandlerBufferHelper::getFillSize() const
+{
+    if (empty)
+        return 0;
+    return b > a ? b - a : bufSize - a + b;
+}
+
+size_t IOHandlerBufferHelper::getFreeSize() const
+{
+    return bufSize - getFillSize() - behind;
+}
+
+size_t IOHandlerBufferHelper::getWriteSize() const
+{
+    return std::min(getFreeSize(), bufSize - b);
+}
+
+size_t IOHandlerBufferHelper::makeRoom(size_t wanted)
+{
+    auto free = getFreeSize();
+    if (free < wanted && behind > 0) {
+        behind -= std::min(behind, wanted - free);
+        free = getFreeSize();
+    }
+    return free;
+}
+
+void IOHandlerBufferHelper::clearBuffer()
+{
+    empty = true;
+    a = b = 0;
+    behind = 0;
+}
+
 void IOHandlerBufferHelper::seek(off_t offset, int whence)
 {
     log_debug("seek called: {} {}", offset, whence);
-    if (!seekEnabled)
-        throw_std_runtime_error("seek currently disabled in this IOHandlerBufferHelper");
 
     assert(isOpen);
 
@@ -159,12 +197,45 @@ void IOHandlerBufferHelper::seek(off_t offset, int whence)
 
     auto lock = threadRunner->uniqueLock();
 
+    // a seek into the buffered data or into the kept data just moves the read position
+    if (whence != SEEK_END) {
+        auto relSeek = whence == SEEK_SET ? offset - posRead : offset;
+        bool hit = true;
+        if (relSeek >= 0 && size_t(relSeek) <= getFillSize()) {
+            a = (a + relSeek) % bufSize;
+            behind = std::min(behind + relSeek, keepBehind);
+            if (a == b)
+                empty = true;
+            // the writer may wait for room
+            threadRunner->notify();
+        } else if (relSeek < 0 && size_t(-relSeek) <= behind) {
+            a = (a + bufSize - size_t(-relSeek)) % bufSize;
+            behind -= size_t(-relSeek);
+            empty = false;
+        } else {
+            hit = false;
+        }
+        if (hit) {
+            posRead += relSeek;
+            seekHits++;
+            return;
+        }
+    }
+    seekMisses++;
+
+    if (!seekEnabled)
+        throw_std_runtime_error("seek currently disabled in this IOHandlerBufferHelper");
+
     // if another seek isn't processed yet - well we don't care as this new seek
     // will change the position anyway
     doSeek = true;
     seekOffset = offset;
     seekWhence = whence;
+    seekSource(lock);
+}
 
+void IOHandlerBufferHelper::seekSource(IOBufferPool::Job::AutoLockU& lock)
+{
     // tell the probably sleeping thread to process our seek
     threadRunner->notify();
 
@@ -180,7 +251,9 @@ void IOHandlerBufferHelper::close()
         throw_std_runtime_error("close called on closed IOHandlerBufferHelper");
     isOpen = false;
     stopBufferThread();
-    delete[] buffer;
+    if (seekHits > 0 || seekMisses > 0)
+        log_debug("buffer seeks: {} served from the buffer, {} refilled", seekHits, seekMisses);
+    IOBufferPool::getInstance().returnBuffer(buffer, bufSize);
     buffer = nullptr;
 }
 
@@ -188,7 +261,8 @@ void IOHandlerBufferHelper::close()
 
 void IOHandlerBufferHelper::startBufferThread()
 {
-    threadRunner = std::make_unique<StdThreadRunner>("BufferHelperThread", IOHandlerBufferHelper::staticThreadProc, this, config);
+    threadRunner = std::make_unique<IOBufferPool::Job>();
+    IOBufferPool::getInstance().start(config, threadRunner.get(), [this] { threadProc(); });
 }
 
 void IOHandlerBufferHelper::stopBufferThread()
@@ -201,10 +275,3 @@ void IOHandlerBufferHelper::stopBufferThread()
     threadRunner->join();
     threadRunner = nullptr;
 }
-
-void* IOHandlerBufferHelper::staticThreadProc(void* arg)
-{
-    auto inst = static_cast<IOHandlerBufferHelper*>(arg);
-    inst->threadProc();
-    return nullptr;
-}
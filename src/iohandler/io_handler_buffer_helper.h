@@ -35,8 +35,8 @@
 #include <upnp.h>
 
 #include "common.h"
+#include "io_buffer_pool.h"
 #include "io_handler.h"
-#include "util/thread_runner.h"
 
 class Config;
 
@@ -77,20 +77,42 @@ protected:
     size_t a;
     size_t b;
     off_t posRead;
+    /// \brief bytes before a that were read already but are kept for backward seeks
+    size_t behind;
+    size_t keepBehind;
+
+    /// \brief bytes between a and b, the caller holds the lock
+    size_t getFillSize() const;
+    /// \brief bytes that can be written without touching unread or kept data
+    size_t getFreeSize() const;
+    /// \brief bytes that can be written at b without wrapping around
+    size_t getWriteSize() const;
+    /// \brief bytes that can be written, drops kept data if wanted does not fit otherwise
+    size_t makeRoom(size_t wanted);
+    /// \brief forget all buffered data, used when the source seeks
+    void clearBuffer();
 
     // seek stuff...
     bool seekEnabled;
     bool doSeek;
     off_t seekOffset;
     int seekWhence;
+    /// \brief seeks served from the buffer and seeks that needed a refill
+    unsigned int seekHits;
+    unsigned int seekMisses;
+
+    /// \brief restart the source at the position of a seek outside of the buffer
+    /// called with the lock held, the default hands the seek to threadProc and waits
+    virtual void seekSource(IOBufferPool::Job::AutoLockU& lock);
 
     // thread stuff..
-    void startBufferThread();
-    void stopBufferThread();
-    static void* staticThreadProc(void* arg);
-    virtual void threadProc() = 0;
+    /// \brief start filling the buffer, the default runs threadProc on a thread of the pool
+    virtual void startBufferThread();
+    virtual void stopBufferThread();
+    virtual void threadProc() { }
 
-    std::unique_ptr<StdThreadRunner> threadRunner;
+    /// \brief buffer thread taken from the IOBufferPool
+    std::unique_ptr<IOBufferPool::Job> threadRunner;
     bool threadShutdown;
 };
 
@@ -35,7 +35,8 @@
 
 #include "exceptions.h"
 
-IOHandlerChainer::IOHandlerChainer(std::unique_ptr<IOHandler>& readFrom, std::unique_ptr<IOHandler>& writeTo, int chunkSize)
+IOHandlerChainer::IOHandlerChainer(std::unique_ptr<IOHandler>& readFrom, std::unique_ptr<IOHandler>& writeTo, int chunkSize, std::shared_ptr<Config> config)
+    : config(std::move(config))
 {
     if (chunkSize <= 0)
         throw_std_runtime_error("chunkSize must be positive");
@@ -43,15 +44,40 @@ IOHandlerChainer::IOHandlerChainer(std::unique_ptr<IOHandler>& readFrom, std::un
         throw_std_runtime_error("readFrom and writeTo need to be set");
     status = 0;
     readFrom->open(UPNP_READ);
+    this->minChunkSize = chunkSize;
+    this->maxChunkSize = std::size_t(chunkSize) * IOHC_MAX_CHUNK_FACTOR;
     this->chunkSize = chunkSize;
     this->readFrom = std::move(readFrom);
     this->writeTo = std::move(writeTo);
-    buf = new char[chunkSize];
     startThread();
 }
 
+void IOHandlerChainer::startThread()
+{
+    readJob = std::make_unique<IOBufferPool::Job>();
+    IOBufferPool::getInstance().start(config, readJob.get(), [this] { threadProc(); });
+    threadRunning = true;
+}
+
+bool IOHandlerChainer::kill()
+{
+    if (!threadRunning)
+        return true;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        threadShutdown = true;
+    }
+    cond.notify_all();
+
+    threadRunning = false;
+    readJob->join();
+    return true;
+}
+
 void IOHandlerChainer::threadProc()
 {
+    int result = 0;
     try {
         bool again = false;
         do {
@@ -64,30 +90,26 @@ void IOHandlerChainer::threadProc()
             }
         } while (!threadShutdownCheck() && again);
 
-        bool stopLoop = false;
-        while (!threadShutdownCheck() && !stopLoop) {
-            int numRead = readFrom->read(buf, chunkSize);
-            if (numRead == 0) {
-                status = IOHC_NORMAL_SHUTDOWN;
-                stopLoop = true;
-            } else if (numRead < 0) {
-                status = IOHC_READ_ERROR;
-                stopLoop = true;
-            } else {
-                int numWritten = 0;
-                while (!threadShutdownCheck() && numWritten == 0 && !stopLoop) {
-                    numWritten = writeTo->write(buf, numRead);
-                    if (numWritten != 0 && numWritten != numRead) {
-                        status = IOHC_WRITE_ERROR;
-                        stopLoop = true;
-                    }
-                }
-            }
+        if (!threadShutdownCheck()) {
+            writeJob = std::make_unique<IOBufferPool::Job>();
+            IOBufferPool::getInstance().start(config, writeJob.get(), [this] { writeProc(); });
+            result = readProc();
         }
     } catch (const std::runtime_error& e) {
         log_debug("{}", e.what());
-        status = IOHC_EXCEPTION;
+        result = IOHC_EXCEPTION;
     }
+
+    // the status is only set once the writer is done with all chunks
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readDone = true;
+    }
+    cond.notify_all();
+    if (writeJob != nullptr)
+        writeJob->join();
+    status = writeStatus != 0 ? writeStatus.load() : result;
+
     try {
         if (threadShutdownCheck())
             status = IOHC_FORCED_SHUTDOWN;
@@ -98,3 +120,85 @@ void IOHandlerChainer::threadProc()
         status = IOHC_EXCEPTION;
     }
 }
+
+int IOHandlerChainer::readProc()
+{
+    while (!threadShutdownCheck()) {
+        std::vector<char> chunk;
+        {
+            // kill() only wakes one of the threads, so do not wait forever
+            std::unique_lock<std::mutex> lock(mutex);
+            while (filled.size() >= IOHC_BUFFERS && !writeFailed && !threadShutdown)
+                cond.wait_for(lock, std::chrono::milliseconds(100));
+            if (writeFailed || threadShutdown)
+                return 0;
+            if (!spare.empty()) {
+                chunk = std::move(spare.back());
+                spare.pop_back();
+            }
+        }
+
+        chunk.resize(chunkSize);
+        int numRead = readFrom->read(chunk.data(), chunk.size());
+        if (numRead == 0)
+            return IOHC_NORMAL_SHUTDOWN;
+        if (numRead < 0)
+            return IOHC_READ_ERROR;
+
+        if (std::size_t(numRead) == chunkSize && chunkSize < maxChunkSize)
+            chunkSize *= 2;
+        else if (std::size_t(numRead) < chunkSize / 4 && chunkSize > minChunkSize)
+            chunkSize /= 2;
+
+        chunk.resize(numRead);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            filled.push_back(std::move(chunk));
+        }
+        cond.notify_all();
+    }
+    return 0;
+}
+
+void IOHandlerChainer::writeProc()
+{
+    try {
+        while (true) {
+            std::vector<char> chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                while (filled.empty() && !readDone && !threadShutdown)
+                    cond.wait_for(lock, std::chrono::milliseconds(100));
+                if (threadShutdown || filled.empty())
+                    return;
+                chunk = std::move(filled.front());
+                filled.pop_front();
+            }
+            cond.notify_all();
+
+            int numRead = chunk.size();
+            int numWritten = 0;
+            while (!threadShutdownCheck() && numWritten == 0) {
+                numWritten = writeTo->write(chunk.data(), chunk.size());
+                if (numWritten != 0 && numWritten != numRead) {
+                    writeStatus = IOHC_WRITE_ERROR;
+                    break;
+                }
+            }
+            if (writeStatus != 0)
+                break;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            spare.push_back(std::move(chunk));
+        }
+    } catch (const std::runtime_error& e) {
+        log_debug("{}", e.what());
+        writeStatus = IOHC_EXCEPTION;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        writeFailed = true;
+    }
+    cond.notify_all();
+}
@@ -38,38 +38,69 @@
 #define IOHC_WRITE_ERROR 4
 #define IOHC_EXCEPTION 5
 
+/// \brief chunks read ahead of the writer
+#define IOHC_BUFFERS 4
+#define IOHC_MAX_CHUNK_FACTOR 16
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "io_buffer_pool.h"
 #include "io_handler.h"
 #include "util/thread_executor.h"
 
 /// \brief gets two IOHandler, starts a thread which reads from one IOHandler
 /// and writes the data to the other IOHandler
+///
+/// Reading and writing run on separate threads with a few chunks in between,
+/// so a slow consumer does not stall the source until all chunks are queued.
+/// The chunk size grows while the source fills every chunk and shrinks again
+/// when it only delivers small pieces.
+/// Both threads are taken from the IOBufferPool.
 class IOHandlerChainer : public ThreadExecutor {
 public:
     /// \brief initialize the IOHandlerChainer
     /// \param readFrom the IOHandler to read from
     /// \param writeTo the IOHandler to write to
-    /// \param chunkSize the amount of bytes to read/write at once. a buffer of
-    /// this size will be allocated
-    IOHandlerChainer(std::unique_ptr<IOHandler>& readFrom, std::unique_ptr<IOHandler>& writeTo, int chunkSize);
+    /// \param chunkSize the amount of bytes to read/write at once at the start,
+    /// it grows up to IOHC_MAX_CHUNK_FACTOR times this size
+    IOHandlerChainer(std::unique_ptr<IOHandler>& readFrom, std::unique_ptr<IOHandler>& writeTo, int chunkSize, std::shared_ptr<Config> config);
     int getStatus() override { return status; }
 
-    ~IOHandlerChainer() override
-    {
-        if (buf != nullptr) {
-            delete[] buf;
-            buf = nullptr;
-        }
-    }
+    /// \brief stop the chain and wait until both jobs returned
+    bool kill() override;
+
+    ~IOHandlerChainer() override { kill(); }
 
 protected:
     void threadProc() override;
+    /// \brief run threadProc on the pool instead of an own thread
+    void startThread() override;
 
 private:
-    int status;
-    char* buf;
-    int chunkSize;
+    /// \brief returns the status the chain ends with, 0 if stopped
+    int readProc();
+    void writeProc();
+
+    std::atomic_int status;
+    std::atomic_int writeStatus { 0 };
+    std::size_t minChunkSize;
+    std::size_t maxChunkSize;
+    std::size_t chunkSize;
     std::unique_ptr<IOHandler> readFrom;
     std::unique_ptr<IOHandler> writeTo;
+    std::shared_ptr<Config> config;
+    std::unique_ptr<IOBufferPool::Job> readJob;
+    std::unique_ptr<IOBufferPool::Job> writeJob;
+
+    /// \brief chunks read but not written yet, guarded by mutex
+    std::deque<std::vector<char>> filled;
+    /// \brief written chunks ready to be filled again
+    std::vector<std::vector<char>> spare;
+    bool readDone { false };
+    bool writeFailed { false };
 };
 
 #endif // __IO_HANDLER_CHAINER_H__
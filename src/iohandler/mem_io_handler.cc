@@ -39,25 +39,32 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+static std::shared_ptr<const char> copyBuffer(const void* buffer, std::size_t length)
+{
+    auto copy = std::shared_ptr<char>(new char[length], std::default_delete<char[]>());
+    memcpy(copy.get(), buffer, length);
+    return copy;
+}
+
 MemIOHandler::MemIOHandler(const void* buffer, int length)
-    : buffer(new char[length])
+    : buffer(copyBuffer(buffer, length))
     , length(length)
     , pos(-1)
 {
-    memcpy(this->buffer, buffer, length);
 }
 
 MemIOHandler::MemIOHandler(const std::string& str)
-    : buffer(new char[str.length()])
+    : buffer(copyBuffer(str.c_str(), str.length()))
     , length(str.length())
     , pos(-1)
 {
-    memcpy(this->buffer, str.c_str(), length);
 }
 
-MemIOHandler::~MemIOHandler()
+MemIOHandler::MemIOHandler(std::shared_ptr<const char> buffer, off_t length)
+    : buffer(std::move(buffer))
+    , length(length)
+    , pos(-1)
 {
-    delete[] buffer;
 }
 
 void MemIOHandler::open(enum UpnpOpenFileMode mode)
@@ -78,7 +85,7 @@ size_t MemIOHandler::read(char* buf, size_t length)
     if (length > size_t(rest))
         length = rest;
 
-    memcpy(buf, buffer + pos, length);
+    memcpy(buf, buffer.get() + pos, length);
     pos = pos + length;
     ret = int(length);
 
@@ -32,6 +32,8 @@
 #ifndef __MEM_IO_HANDLER_H__
 #define __MEM_IO_HANDLER_H__
 
+#include <memory>
+
 #include "common.h"
 #include "io_handler.h"
 
@@ -39,7 +41,7 @@
 class MemIOHandler : public IOHandler {
 protected:
     /// \brief buffer that is holding our data.
-    char* buffer;
+    std::shared_ptr<const char> buffer;
     off_t length;
 
     /// \brief current offset in the buffer
@@ -50,7 +52,9 @@ public:
     /// \param buffer all operations will be done on this buffer.
     MemIOHandler(const void* buffer, int length);
     explicit MemIOHandler(const std::string& str);
-    ~MemIOHandler() override;
+    /// \brief Serves data owned by someone else without copying it.
+    /// \param buffer keeps the data alive while the handler exists.
+    MemIOHandler(std::shared_ptr<const char> buffer, off_t length);
 
     ///
     void open(enum UpnpOpenFileMode mode) override;
@@ -0,0 +1,75 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    metered_io_handler.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file metered_io_handler.cc
+
+#include "metered_io_handler.h" // API
+
+MeteredIOHandler::MeteredIOHandler(std::unique_ptr<IOHandler> handler, std::shared_ptr<StreamStatistics> statistics, std::shared_ptr<StreamStatistics::Stream> stream)
+    : handler(std::move(handler))
+    , statistics(std::move(statistics))
+    , stream(std::move(stream))
+{
+}
+
+MeteredIOHandler::~MeteredIOHandler()
+{
+    // the stream is over even if close was never called
+    statistics->finish(stream);
+}
+
+void MeteredIOHandler::open(enum UpnpOpenFileMode mode)
+{
+    handler->open(mode);
+}
+
+size_t MeteredIOHandler::read(char* buf, size_t length)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto ret = handler->read(buf, length);
+    // handlers report errors as -1
+    stream->addRead(std::chrono::steady_clock::now() - start, ssize_t(ret) > 0 ? ret : 0);
+    return ret;
+}
+
+size_t MeteredIOHandler::write(char* buf, size_t length)
+{
+    return handler->write(buf, length);
+}
+
+void MeteredIOHandler::seek(off_t offset, int whence)
+{
+    stream->addSeek();
+    handler->seek(offset, whence);
+}
+
+off_t MeteredIOHandler::tell()
+{
+    return handler->tell();
+}
+
+void MeteredIOHandler::close()
+{
+    handler->close();
+    statistics->finish(stream);
+}
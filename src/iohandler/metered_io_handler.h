@@ -0,0 +1,52 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    metered_io_handler.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file metered_io_handler.h
+#ifndef __METERED_IO_HANDLER_H__
+#define __METERED_IO_HANDLER_H__
+
+#include <memory>
+
+#include "io_handler.h"
+#include "stream_statistics.h"
+
+/// \brief Passes all calls to another IOHandler and records them in the stream statistics
+class MeteredIOHandler : public IOHandler {
+public:
+    MeteredIOHandler(std::unique_ptr<IOHandler> handler, std::shared_ptr<StreamStatistics> statistics, std::shared_ptr<StreamStatistics::Stream> stream);
+    ~MeteredIOHandler() override;
+
+    void open(enum UpnpOpenFileMode mode) override;
+    size_t read(char* buf, size_t length) override;
+    size_t write(char* buf, size_t length) override;
+    void seek(off_t offset, int whence) override;
+    off_t tell() override;
+    void close() override;
+
+private:
+    std::unique_ptr<IOHandler> handler;
+    std::shared_ptr<StreamStatistics> statistics;
+    std::shared_ptr<StreamStatistics::Stream> stream;
+};
+
+#endif // __METERED_IO_HANDLER_H__
@@ -0,0 +1,84 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    offset_io_handler.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file offset_io_handler.cc
+
+#include "offset_io_handler.h" // API
+
+#include "util/tools.h"
+
+OffsetIOHandler::OffsetIOHandler(std::unique_ptr<IOHandler> handler, off_t offset)
+    : handler(std::move(handler))
+    , offset(offset)
+{
+}
+
+void OffsetIOHandler::open(enum UpnpOpenFileMode mode)
+{
+    handler->open(mode);
+}
+
+size_t OffsetIOHandler::read(char* buf, size_t length)
+{
+    auto ret = handler->read(buf, length);
+    // handlers report errors as -1
+    if (ssize_t(ret) > 0)
+        position += ret;
+    return ret;
+}
+
+size_t OffsetIOHandler::write(char* buf, size_t length)
+{
+    return handler->write(buf, length);
+}
+
+void OffsetIOHandler::seek(off_t offset, int whence)
+{
+    if (whence == SEEK_END) {
+        handler->seek(offset, whence);
+        position = base + handler->tell();
+        return;
+    }
+
+    off_t target = whence == SEEK_CUR ? position + offset : offset;
+    if (base == 0 && position == 0 && target == this->offset) {
+        base = position = target;
+        return;
+    }
+    if (target == position)
+        return;
+    if (target < base)
+        throw_std_runtime_error("Cannot seek to {}, the stream starts at {}", target, base);
+    handler->seek(target - base, SEEK_SET);
+    position = target;
+}
+
+off_t OffsetIOHandler::tell()
+{
+    return position;
+}
+
+void OffsetIOHandler::close()
+{
+    handler->close();
+}
@@ -0,0 +1,56 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    offset_io_handler.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file offset_io_handler.h
+#ifndef __OFFSET_IO_HANDLER_H__
+#define __OFFSET_IO_HANDLER_H__
+
+#include <memory>
+
+#include "io_handler.h"
+
+/// \brief Serves a stream that was started at a byte offset, i.e. a transcoder started in the middle of the file
+///
+/// Until the first seek the stream is at 0 like any other handler, libupnp then moves it
+/// to the start of the requested range, which is where the stream already is.
+/// Positions beyond that are passed on relative to the offset.
+class OffsetIOHandler : public IOHandler {
+public:
+    OffsetIOHandler(std::unique_ptr<IOHandler> handler, off_t offset);
+
+    void open(enum UpnpOpenFileMode mode) override;
+    size_t read(char* buf, size_t length) override;
+    size_t write(char* buf, size_t length) override;
+    void seek(off_t offset, int whence) override;
+    off_t tell() override;
+    void close() override;
+
+private:
+    std::unique_ptr<IOHandler> handler;
+    off_t offset;
+    /// \brief offset of the stream once it was moved there, 0 before
+    off_t base { 0 };
+    off_t position { 0 };
+};
+
+#endif // __OFFSET_IO_HANDLER_H__
@@ -0,0 +1,179 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    playback_predictor.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file playback_predictor.cc
+
+#include "playback_predictor.h" // API
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cds_objects.h"
+#include "database/database.h"
+#include "exceptions.h"
+#include "read_ahead_pool.h"
+#include "upnp_common.h"
+#include "util/logger.h"
+
+/// \brief played objects waiting for the lookup, a client skipping through an album only needs the last ones
+static constexpr std::size_t PREDICT_QUEUE_SIZE = 4;
+/// \brief played objects remembered to skip the range requests of the same track
+static constexpr std::size_t PREDICT_RECENT_SIZE = 16;
+
+PlaybackPredictor::PlaybackPredictor(std::shared_ptr<Config> config, std::shared_ptr<Database> database, std::shared_ptr<ReadAheadPool> readAhead, std::size_t prefetchSize)
+    : config(std::move(config))
+    , database(std::move(database))
+    , readAhead(std::move(readAhead))
+    , prefetchSize(prefetchSize)
+{
+}
+
+PlaybackPredictor::~PlaybackPredictor()
+{
+    if (thread)
+        shutdown();
+}
+
+void PlaybackPredictor::run()
+{
+    thread = std::make_unique<StdThreadRunner>("PlaybackPredictor", PlaybackPredictor::staticThreadProc, this, config);
+    if (!thread->isAlive())
+        throw_std_runtime_error("Could not start playback predictor thread");
+}
+
+void PlaybackPredictor::shutdown()
+{
+    {
+        AutoLock lock(mutex);
+        shutdownFlag = true;
+        queue.clear();
+        cond.notify_all();
+    }
+    if (thread)
+        thread->join();
+    thread = nullptr;
+}
+
+void PlaybackPredictor::played(const std::shared_ptr<CdsObject>& obj)
+{
+    AutoLock lock(mutex);
+    if (shutdownFlag || std::find(recent.begin(), recent.end(), obj->getID()) != recent.end())
+        return;
+    recent.push_back(obj->getID());
+    if (recent.size() > PREDICT_RECENT_SIZE)
+        recent.pop_front();
+
+    queue.push_back(obj);
+    if (queue.size() > PREDICT_QUEUE_SIZE)
+        queue.pop_front();
+    cond.notify_one();
+}
+
+std::shared_ptr<CdsObject> PlaybackPredictor::findNext(const std::vector<std::shared_ptr<CdsObject>>& children, int objectID)
+{
+    auto played = std::find_if(children.begin(), children.end(), [=](auto&& child) { return child->getID() == objectID; });
+    if (played == children.end())
+        return nullptr;
+    auto next = std::find_if(played + 1, children.end(), [](auto&& child) { return child->isItem() && !child->isExternalItem() && !child->getLocation().empty(); });
+    return next != children.end() ? *next : nullptr;
+}
+
+std::shared_ptr<CdsObject> PlaybackPredictor::predict(const std::shared_ptr<CdsObject>& obj)
+{
+    auto parent = database->loadObject(obj->getParentID());
+    if (parent->getClass() != UPNP_CLASS_MUSIC_ALBUM && parent->getClass() != UPNP_CLASS_PLAYLIST_CONTAINER)
+        return nullptr;
+
+    // the order the client got in the browse response
+    auto param = std::make_unique<BrowseParam>(parent->getID(), BROWSE_DIRECT_CHILDREN | BROWSE_ITEMS | BROWSE_TRACK_SORT | BROWSE_BASIC_PROPERTIES);
+    return findNext(database->browse(param), obj->getID());
+}
+
+void PlaybackPredictor::prefetch(const fs::path& location)
+{
+    int fd = ::open(location.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        log_debug("Failed to open {} for prefetching: {}", location.c_str(), std::strerror(errno));
+        return;
+    }
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) != 0) {
+        ::close(fd);
+        return;
+    }
+    auto length = std::min<off_t>(statbuf.st_size, prefetchSize);
+
+    if (readAhead != nullptr && readAhead->hasCache()) {
+        // the same chunks FileIOHandler asks for, they start at multiples of the chunk size
+        ReadAheadPool::FileKey key { statbuf.st_dev, statbuf.st_ino, statbuf.st_size, statbuf.st_mtime };
+        std::vector<std::shared_ptr<ReadAheadPool::Chunk>> chunks;
+        for (off_t offset = 0; offset < length; offset += readAhead->getChunkSize())
+            chunks.push_back(readAhead->request(fd, offset, &key));
+        // cached chunks read a copy of the descriptor, the others have to be done before it is closed
+        for (auto&& chunk : chunks) {
+            if (!chunk->cached)
+                readAhead->wait(chunk);
+            readAhead->release(chunk);
+        }
+    } else {
+#ifndef __APPLE__
+        posix_fadvise(fd, 0, length, POSIX_FADV_WILLNEED);
+#endif
+    }
+    ::close(fd);
+    log_debug("Prefetched {} bytes of {}", length, location.c_str());
+}
+
+void* PlaybackPredictor::staticThreadProc(void* arg)
+{
+    auto inst = static_cast<PlaybackPredictor*>(arg);
+    inst->threadProc();
+    return nullptr;
+}
+
+void PlaybackPredictor::threadProc()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!shutdownFlag) {
+        if (queue.empty()) {
+            cond.wait(lock);
+            continue;
+        }
+        auto obj = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        try {
+            auto next = predict(obj);
+            if (next != nullptr)
+                prefetch(next->getLocation());
+        } catch (const std::runtime_error& e) {
+            log_debug("No prediction for object {}: {}", obj->getID(), e.what());
+        }
+
+        lock.lock();
+    }
+}
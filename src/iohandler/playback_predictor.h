@@ -0,0 +1,93 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    playback_predictor.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file playback_predictor.h
+#ifndef __PLAYBACK_PREDICTOR_H__
+#define __PLAYBACK_PREDICTOR_H__
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+namespace fs = std::filesystem;
+
+#include "util/thread_runner.h"
+
+// forward declaration
+class CdsObject;
+class Config;
+class Database;
+class ReadAheadPool;
+
+/// \brief Reads the start of the next track while a track of an album or playlist is played
+///
+/// Renderers play the items of these containers one after the other. The predictor looks up the
+/// item following the played one in browse order and reads the first bytes of its file on its own
+/// thread, so the request for it does not wait for a slow disk or network share. The chunks go to
+/// the cache of the read ahead pool if there is one, otherwise the kernel is asked to read them
+/// into the page cache.
+class PlaybackPredictor {
+public:
+    /// \param readAhead pool whose cache gets the chunks, nullptr or a pool without cache uses posix_fadvise
+    /// \param prefetchSize bytes read of the next file
+    PlaybackPredictor(std::shared_ptr<Config> config, std::shared_ptr<Database> database, std::shared_ptr<ReadAheadPool> readAhead, std::size_t prefetchSize);
+    ~PlaybackPredictor();
+
+    void run();
+    void shutdown();
+
+    /// \brief queue reading the item following obj, returns at once
+    void played(const std::shared_ptr<CdsObject>& obj);
+
+    /// \brief item after objectID in children that has a local file, nullptr if it is the last one
+    static std::shared_ptr<CdsObject> findNext(const std::vector<std::shared_ptr<CdsObject>>& children, int objectID);
+
+    /// \brief read the first bytes of the file
+    void prefetch(const fs::path& location);
+
+protected:
+    std::shared_ptr<Config> config;
+    std::shared_ptr<Database> database;
+    std::shared_ptr<ReadAheadPool> readAhead;
+    std::size_t prefetchSize;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::condition_variable cond;
+    bool shutdownFlag { false };
+    /// \brief played objects waiting for the lookup, the oldest are dropped
+    std::deque<std::shared_ptr<CdsObject>> queue;
+    /// \brief objects predicted recently, each range request of a track calls played again
+    std::deque<int> recent;
+    std::unique_ptr<StdThreadRunner> thread;
+
+    /// \brief the item following obj in its album or playlist, nullptr for other containers
+    std::shared_ptr<CdsObject> predict(const std::shared_ptr<CdsObject>& obj);
+
+    static void* staticThreadProc(void* arg);
+    void threadProc();
+};
+
+#endif // __PLAYBACK_PREDICTOR_H__
@@ -133,6 +133,25 @@ ProcessIOHandler::ProcessIOHandler(std::shared_ptr<ContentManager> content,
     registerAll();
 }
 
+ProcessIOHandler::ProcessIOHandler(std::shared_ptr<ContentManager> content,
+    int pipeFd, const std::shared_ptr<Executor>& mainProc,
+    std::vector<std::shared_ptr<ProcListItem>> procList,
+    bool ignoreSeek)
+    : content(std::move(content))
+    , procList(std::move(procList))
+    , mainProc(mainProc)
+    , fd(pipeFd)
+    , isPipe(true)
+    , ignoreSeek(ignoreSeek)
+{
+    if ((mainProc != nullptr) && ((!mainProc->isAlive() || abort()))) {
+        killAll();
+        ::close(fd);
+        throw_std_runtime_error("process terminated early");
+    }
+    registerAll();
+}
+
 void ProcessIOHandler::open(enum UpnpOpenFileMode mode)
 {
     if ((mainProc != nullptr) && ((!mainProc->isAlive() || abort()))) {
@@ -140,6 +159,14 @@ void ProcessIOHandler::open(enum UpnpOpenFileMode mode)
         throw_std_runtime_error("process terminated early");
     }
 
+    if (isPipe) {
+        if (mode != UPNP_READ)
+            throw_std_runtime_error("open: transcoder output can only be read");
+        // the transcoder keeps its end blocking, only the reads must not hang
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        return;
+    }
+
     if (mode == UPNP_READ)
 #ifdef __linux__
         fd = ::open(filename.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
@@ -169,12 +196,25 @@ void ProcessIOHandler::open(enum UpnpOpenFileMode mode)
 }
 
 size_t ProcessIOHandler::read(char* buf, size_t length)
+{
+    return transfer(length, [=](size_t done, size_t remaining) { return ::read(fd, buf + done, remaining); });
+}
+
+size_t ProcessIOHandler::splice(int outFd, size_t length)
+{
+#ifdef __linux__
+    if (isPipe)
+        return transfer(length, [=](size_t done, size_t remaining) { return ::splice(fd, nullptr, outFd, nullptr, remaining, SPLICE_F_MOVE | SPLICE_F_NONBLOCK); });
+#endif
+    return SPLICE_UNSUPPORTED;
+}
+
+size_t ProcessIOHandler::transfer(size_t length, const std::function<ssize_t(size_t done, size_t remaining)>& op)
 {
     fd_set readSet;
     struct timespec timeout;
     ssize_t bytes_read = 0;
     size_t num_bytes = 0;
-    char* p_buffer = buf;
     int exit_status = EXIT_SUCCESS;
     int ret = 0;
     int timeout_count = 0;
@@ -212,6 +252,12 @@ size_t ProcessIOHandler::read(char* buf, size_t length)
                 return 0;
             }
 
+            auto now = std::chrono::steady_clock::now();
+            if (idleSince == std::chrono::steady_clock::time_point())
+                idleSince = now;
+            if (!onIdle(now - idleSince))
+                return -1;
+
             timeout_count++;
             if (timeout_count > MAX_TIMEOUTS) {
                 log_debug("max timeouts, checking socket!");
@@ -221,22 +267,24 @@ size_t ProcessIOHandler::read(char* buf, size_t length)
 
         if (FD_ISSET(fd, &readSet)) {
             timeout_count = 0;
-            bytes_read = ::read(fd, p_buffer, length);
+            bytes_read = op(num_bytes, length);
             if (bytes_read == 0)
                 break;
 
             if (bytes_read < 0) {
+                if (errno == EAGAIN)
+                    continue;
                 log_debug("aborting read!!!");
                 return -1;
             }
 
+            idleSince = std::chrono::steady_clock::time_point();
+            onData(bytes_read);
             num_bytes = num_bytes + bytes_read;
             length = length - bytes_read;
 
             if (length == 0)
                 break;
-
-            p_buffer = buf + num_bytes;
         }
     }
 
@@ -359,7 +407,7 @@ void ProcessIOHandler::close()
 {
     bool ret;
 
-    log_debug("terminating process, closing {}", this->filename.c_str());
+    log_debug("terminating process, closing {}", isPipe ? "pipe" : this->filename.c_str());
     unregisterAll();
 
     if (mainProc != nullptr) {
@@ -369,9 +417,12 @@ void ProcessIOHandler::close()
 
     killAll();
 
-    ::close(fd);
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
 
-    unlink(filename.c_str());
+    if (!isPipe)
+        unlink(filename.c_str());
 
     if (!ret)
         throw_std_runtime_error("failed to kill process");
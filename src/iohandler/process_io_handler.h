@@ -32,7 +32,9 @@
 #ifndef __PROCESS_IO_HANDLER_H__
 #define __PROCESS_IO_HANDLER_H__
 
+#include <chrono>
 #include <filesystem>
+#include <functional>
 #include <memory>
 namespace fs = std::filesystem;
 
@@ -69,6 +71,13 @@ public:
         std::vector<std::shared_ptr<ProcListItem>> procList = std::vector<std::shared_ptr<ProcListItem>>(),
         bool ignoreSeek = false);
 
+    /// \brief Reads the output of mainProc from a pipe.
+    /// \param pipeFd read end of the pipe, the handler closes it
+    ProcessIOHandler(std::shared_ptr<ContentManager> content,
+        int pipeFd, const std::shared_ptr<Executor>& mainProc,
+        std::vector<std::shared_ptr<ProcListItem>> procList = std::vector<std::shared_ptr<ProcListItem>>(),
+        bool ignoreSeek = false);
+
     /// \brief Opens file for reading (writing is not supported)
     void open(enum UpnpOpenFileMode mode) override;
 
@@ -77,6 +86,9 @@ public:
     /// \param length Number of bytes to be copied into the buffer.
     size_t read(char* buf, size_t length) override;
 
+    /// \brief Moves data from the pipe into fd with splice(), not available for fifos.
+    size_t splice(int outFd, size_t length) override;
+
     /// \brief Writes to a previously opened file.
     /// \param buf Data from the buffer will be written to the file.
     /// \param length Number of bytes to be written from the buffer.
@@ -110,11 +122,27 @@ protected:
     fs::path filename;
 
     /// \brief file descriptor
-    int fd {};
+    int fd { -1 };
+
+    /// \brief fd is an anonymous pipe instead of the fifo in filename
+    bool isPipe { false };
 
     /// \brief if this flag is set seek on a fifo will not return an error
     bool ignoreSeek;
 
+    /// \brief start of the current wait for data, unset while data arrives
+    std::chrono::steady_clock::time_point idleSince;
+
+    /// \brief wait for data and call op until length bytes are moved or the process ended
+    size_t transfer(size_t length, const std::function<ssize_t(size_t done, size_t remaining)>& op);
+
+    /// \brief called after each read that moved data
+    virtual void onData(size_t length) { }
+    /// \brief called on each read timeout while the main process is running
+    /// \param idle time since data arrived last
+    /// \return false to end the stream with an error
+    virtual bool onIdle(std::chrono::steady_clock::duration idle) { return true; }
+
     bool abort() const;
     void killAll() const;
     void registerAll();
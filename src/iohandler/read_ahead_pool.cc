@@ -0,0 +1,203 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    read_ahead_pool.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+
+/// \file read_ahead_pool.cc
+
+#include "read_ahead_pool.h" // API
+
+#include <algorithm>
+#include <cerrno>
+#include <unistd.h>
+
+#include "exceptions.h"
+
+ReadAheadPool::ReadAheadPool(std::shared_ptr<Config> config, std::size_t threadCount, std::size_t chunkSize, std::size_t chunksPerStream, std::size_t cacheSize)
+    : config(std::move(config))
+    , threadCount(std::max<std::size_t>(threadCount, 1))
+    , chunkSize(chunkSize)
+    , chunksPerStream(std::max<std::size_t>(chunksPerStream, 1))
+    , cacheSize(cacheSize)
+{
+}
+
+ReadAheadPool::~ReadAheadPool()
+{
+    if (!threads.empty())
+        shutdown();
+}
+
+void ReadAheadPool::run()
+{
+    AutoLock lock(mutex);
+    for (std::size_t i = 0; i < threadCount; i++) {
+        auto thread = std::make_unique<StdThreadRunner>(fmt::format("ReadAhead{}", i), ReadAheadPool::staticThreadProc, this, config);
+        if (!thread->isAlive())
+            throw_std_runtime_error("Could not start read ahead thread");
+        threads.push_back(std::move(thread));
+    }
+    log_debug("started {} read ahead threads", threads.size());
+}
+
+void ReadAheadPool::shutdown()
+{
+    {
+        AutoLock lock(mutex);
+        shutdownFlag = true;
+        for (auto&& chunk : queue) {
+            if (chunk->cached)
+                ::close(chunk->fd);
+            chunk->state = Chunk::State::Cancelled;
+        }
+        queue.clear();
+        cache.clear();
+        queueCond.notify_all();
+        doneCond.notify_all();
+    }
+    for (auto&& thread : threads)
+        thread->join();
+    threads.clear();
+}
+
+std::shared_ptr<ReadAheadPool::Chunk> ReadAheadPool::request(int fd, off_t offset, const FileKey* file)
+{
+    auto chunk = std::make_shared<Chunk>();
+    chunk->fd = fd;
+    chunk->offset = offset;
+
+    AutoLock lock(mutex);
+    if (shutdownFlag) {
+        chunk->state = Chunk::State::Cancelled;
+        return chunk;
+    }
+    if (file != nullptr && cacheSize > 0) {
+        CacheKey key { file->device, file->inode, file->size, file->mtime, offset };
+        auto entry = cache.find(key);
+        if (entry != cache.end() && !entry->second->failed) {
+            cache.touch(entry);
+            return entry->second;
+        }
+        if (entry != cache.end())
+            cache.erase(entry);
+
+        // the chunk may outlive the stream that requested it
+        chunk->fd = ::dup(fd);
+        if (chunk->fd >= 0) {
+            chunk->cached = true;
+            cache.put(key, chunk);
+            trimCache();
+        } else {
+            chunk->fd = fd;
+        }
+    }
+    if (!freeBuffers.empty()) {
+        chunk->data = std::move(freeBuffers.back());
+        freeBuffers.pop_back();
+    }
+    queue.push_back(chunk);
+    queueCond.notify_one();
+    return chunk;
+}
+
+bool ReadAheadPool::wait(const std::shared_ptr<Chunk>& chunk)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCond.wait(lock, [&] { return chunk->state == Chunk::State::Done || chunk->state == Chunk::State::Cancelled; });
+    return chunk->state == Chunk::State::Done && !chunk->failed;
+}
+
+void ReadAheadPool::release(const std::shared_ptr<Chunk>& chunk)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    // other streams may still read it, trimCache takes care of the buffer
+    if (chunk->cached)
+        return;
+    if (chunk->state == Chunk::State::Queued) {
+        // the thread skips it when it comes up
+        chunk->state = Chunk::State::Cancelled;
+    }
+    doneCond.wait(lock, [&] { return chunk->state != Chunk::State::Reading; });
+    if (chunk->data.capacity() == chunkSize)
+        freeBuffers.push_back(std::move(chunk->data));
+    chunk->data.clear();
+}
+
+void ReadAheadPool::trimCache()
+{
+    std::size_t memory = cache.size() * chunkSize;
+    for (auto entry = cache.end(); memory > cacheSize && entry != cache.begin();) {
+        --entry;
+        auto& chunk = entry->second;
+        // read or waited for by a stream
+        if (chunk.use_count() > 1 || chunk->state == Chunk::State::Queued || chunk->state == Chunk::State::Reading)
+            continue;
+        if (chunk->data.capacity() == chunkSize)
+            freeBuffers.push_back(std::move(chunk->data));
+        entry = cache.erase(entry);
+        memory -= chunkSize;
+    }
+}
+
+void* ReadAheadPool::staticThreadProc(void* arg)
+{
+    auto inst = static_cast<ReadAheadPool*>(arg);
+    inst->threadProc();
+    return nullptr;
+}
+
+void ReadAheadPool::threadProc()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!shutdownFlag) {
+        if (queue.empty()) {
+            queueCond.wait(lock);
+            continue;
+        }
+        auto chunk = std::move(queue.front());
+        queue.pop_front();
+        if (chunk->state != Chunk::State::Queued)
+            continue;
+        chunk->state = Chunk::State::Reading;
+        lock.unlock();
+
+        chunk->data.resize(chunkSize);
+        std::size_t length = 0;
+        while (length < chunkSize) {
+            auto bytes = ::pread(chunk->fd, chunk->data.data() + length, chunkSize - length, chunk->offset + length);
+            if (bytes < 0 && errno == EINTR)
+                continue;
+            if (bytes < 0)
+                chunk->failed = true;
+            if (bytes <= 0)
+                break;
+            length += bytes;
+        }
+        chunk->length = length;
+        if (chunk->cached)
+            ::close(chunk->fd);
+
+        lock.lock();
+        chunk->state = Chunk::State::Done;
+        doneCond.notify_all();
+    }
+}
@@ -0,0 +1,128 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    read_ahead_pool.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+
+/// \file read_ahead_pool.h
+#ifndef __READ_AHEAD_POOL_H__
+#define __READ_AHEAD_POOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <sys/types.h>
+#include <tuple>
+#include <vector>
+
+#include "util/lru_cache.h"
+#include "util/thread_runner.h"
+
+// forward declaration
+class Config;
+
+/// \brief A few threads shared by all streams that read the next chunks of served files in advance
+///
+/// The web server still reads each stream on its own thread, but the data is usually in memory
+/// by the time it asks, so a slow disk does not stall every stream in turn.
+/// Chunk buffers are recycled and not released while the server runs.
+///
+/// With a cache, chunks are shared by all streams of the same file: clients watching the same movie
+/// or requesting overlapping ranges wait for the same read instead of reading the disk again.
+class ReadAheadPool {
+public:
+    /// \brief identity of a file version, a changed file does not match its cached chunks
+    struct FileKey {
+        dev_t device;
+        ino_t inode;
+        off_t size;
+        time_t mtime;
+    };
+
+    struct Chunk {
+        enum class State {
+            Queued,
+            Reading,
+            Done,
+            Cancelled,
+        };
+
+        int fd;
+        off_t offset;
+        std::vector<char> data;
+        /// \brief bytes read, less than the chunk size at the end of the file
+        std::size_t length { 0 };
+        bool failed { false };
+        State state { State::Queued };
+        /// \brief chunk is shared through the cache and reads its own copy of the descriptor
+        bool cached { false };
+    };
+
+    /// \param chunksPerStream chunks a stream keeps in flight ahead of the reader
+    /// \param cacheSize memory of the shared chunks, 0 disables sharing
+    ReadAheadPool(std::shared_ptr<Config> config, std::size_t threadCount, std::size_t chunkSize, std::size_t chunksPerStream, std::size_t cacheSize = 0);
+    ~ReadAheadPool();
+
+    void run();
+    void shutdown();
+
+    std::size_t getChunkSize() const { return chunkSize; }
+    std::size_t getChunksPerStream() const { return chunksPerStream; }
+    bool hasCache() const { return cacheSize > 0; }
+
+    /// \brief queue reading chunk size bytes of fd at offset
+    /// \param file share the chunk with other streams of the file, offset must be a multiple of the chunk size
+    std::shared_ptr<Chunk> request(int fd, off_t offset, const FileKey* file = nullptr);
+
+    /// \brief block until the chunk was read, false if reading failed or the pool is shut down
+    bool wait(const std::shared_ptr<Chunk>& chunk);
+
+    /// \brief return the buffer of the chunk, waits if it is being read so fd can be closed afterwards
+    void release(const std::shared_ptr<Chunk>& chunk);
+
+protected:
+    std::shared_ptr<Config> config;
+    std::size_t threadCount;
+    std::size_t chunkSize;
+    std::size_t chunksPerStream;
+    std::size_t cacheSize;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::condition_variable queueCond;
+    std::condition_variable doneCond;
+    bool shutdownFlag { false };
+
+    std::deque<std::shared_ptr<Chunk>> queue;
+    std::vector<std::vector<char>> freeBuffers;
+
+    using CacheKey = std::tuple<dev_t, ino_t, off_t, time_t, off_t>;
+    LruCache<CacheKey, std::shared_ptr<Chunk>> cache;
+    /// \brief drop the least recently used chunks nobody reads until the cache fits its size
+    void trimCache();
+    std::vector<std::unique_ptr<StdThreadRunner>> threads;
+
+    static void* staticThreadProc(void* arg);
+    void threadProc();
+};
+
+#endif // __READ_AHEAD_POOL_H__
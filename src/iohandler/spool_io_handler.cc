@@ -0,0 +1,191 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    spool_io_handler.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file spool_io_handler.cc
+
+#include "spool_io_handler.h" // API
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+#include "exceptions.h"
+
+/// \brief bytes taken from the source at once
+#define SPOOL_CHUNK_SIZE (64 * 1024)
+
+SpoolIOHandler::SpoolIOHandler(std::shared_ptr<Config> config, std::unique_ptr<IOHandler> source, fs::path tmpDir, std::size_t size)
+    : config(std::move(config))
+    , source(std::move(source))
+    , tmpDir(std::move(tmpDir))
+    , size(size)
+{
+    if (this->size == 0)
+        throw_std_runtime_error("spool size must be positive");
+}
+
+SpoolIOHandler::~SpoolIOHandler()
+{
+    if (fd >= 0)
+        close();
+}
+
+void SpoolIOHandler::open(enum UpnpOpenFileMode mode)
+{
+    if (mode != UPNP_READ)
+        throw_std_runtime_error("spool can only be read");
+
+    std::string name = tmpDir / "grb_spool_XXXXXX";
+#ifdef __linux__
+    fd = mkostemp(name.data(), O_CLOEXEC);
+#else
+    fd = mkstemp(name.data());
+    if (fd >= 0)
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+    if (fd < 0)
+        throw_std_runtime_error("Could not create spool file in {}: {}", tmpDir.c_str(), std::strerror(errno));
+    // the data is only reached through fd, nothing is left behind
+    unlink(name.c_str());
+
+    try {
+        source->open(UPNP_READ);
+    } catch (const std::runtime_error&) {
+        ::close(fd);
+        fd = -1;
+        throw;
+    }
+
+    threadRunner = std::make_unique<IOBufferPool::Job>();
+    IOBufferPool::getInstance().start(config, threadRunner.get(), [this] { threadProc(); });
+}
+
+void SpoolIOHandler::threadProc()
+{
+    std::vector<char> chunk(SPOOL_CHUNK_SIZE);
+    bool ended = false;
+    bool failed = false;
+    while (!ended && !failed) {
+        std::size_t room;
+        {
+            AutoLockU lock(mutex);
+            cond.wait(lock, [this] { return shutdown || written - consumed < size; });
+            if (shutdown)
+                break;
+            room = size - (written - consumed);
+        }
+
+        auto bytes = static_cast<ssize_t>(source->read(chunk.data(), std::min(room, chunk.size())));
+        if (bytes == CHECK_SOCKET)
+            continue;
+        if (bytes == 0) {
+            ended = true;
+            break;
+        }
+        if (bytes < 0) {
+            failed = true;
+            break;
+        }
+
+        // the part between written and consumed is not touched by the reader
+        std::size_t done = 0;
+        while (done < std::size_t(bytes) && !failed) {
+            auto offset = (written + done) % size;
+            auto length = std::min(std::size_t(bytes) - done, size - offset);
+            auto ret = pwrite(fd, chunk.data() + done, length, offset);
+            if (ret <= 0) {
+                log_error("Could not write to spool file: {}", std::strerror(errno));
+                failed = true;
+            } else {
+                done += ret;
+            }
+        }
+
+        AutoLockU lock(mutex);
+        written += done;
+        cond.notify_all();
+    }
+
+    AutoLockU lock(mutex);
+    eof = ended;
+    readError = failed;
+    cond.notify_all();
+}
+
+size_t SpoolIOHandler::read(char* buf, size_t length)
+{
+    std::uint64_t start;
+    std::size_t available;
+    {
+        AutoLockU lock(mutex);
+        cond.wait(lock, [this] { return written > consumed || eof || readError || shutdown; });
+        if (written == consumed)
+            return readError ? -1 : 0;
+        start = consumed;
+        available = std::min<std::uint64_t>(written - consumed, length);
+    }
+
+    std::size_t done = 0;
+    while (done < available) {
+        auto offset = (start + done) % size;
+        auto ret = pread(fd, buf + done, std::min(available - done, size - offset), offset);
+        if (ret <= 0) {
+            log_error("Could not read from spool file: {}", std::strerror(errno));
+            return -1;
+        }
+        done += ret;
+    }
+
+    AutoLockU lock(mutex);
+    consumed += done;
+    cond.notify_all();
+    return done;
+}
+
+std::size_t SpoolIOHandler::waitForFill(std::size_t fill, std::chrono::milliseconds timeout)
+{
+    AutoLockU lock(mutex);
+    cond.wait_for(lock, timeout, [&] { return written >= std::min(fill, size) || eof || readError || shutdown; });
+    return written;
+}
+
+void SpoolIOHandler::close()
+{
+    if (fd < 0)
+        return;
+
+    {
+        AutoLockU lock(mutex);
+        shutdown = true;
+        cond.notify_all();
+    }
+    // the source is closed once its last read returned
+    threadRunner->join();
+    threadRunner = nullptr;
+    source->close();
+
+    ::close(fd);
+    fd = -1;
+}
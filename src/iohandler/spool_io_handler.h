@@ -0,0 +1,85 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    spool_io_handler.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file spool_io_handler.h
+#ifndef __SPOOL_IO_HANDLER_H__
+#define __SPOOL_IO_HANDLER_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+namespace fs = std::filesystem;
+
+#include "io_buffer_pool.h"
+#include "io_handler.h"
+
+class Config;
+
+/// \brief Reads ahead of the consumer into a temporary file
+///
+/// The file is used as a ring of fixed size, so a stream of any length never takes more disk
+/// space than that. The read ahead runs on its own thread, a consumer that is slow for a while
+/// does not stop the source and a source that hangs for a while does not starve the consumer
+/// as long as there is data in the file.
+class SpoolIOHandler : public IOHandler {
+public:
+    /// \param source handler to read from, it is opened and closed with this handler
+    /// \param tmpDir directory of the file, it is removed at once and only kept open
+    /// \param size bytes read ahead at most
+    SpoolIOHandler(std::shared_ptr<Config> config, std::unique_ptr<IOHandler> source, fs::path tmpDir, std::size_t size);
+    ~SpoolIOHandler() override;
+
+    void open(enum UpnpOpenFileMode mode) override;
+    size_t read(char* buf, size_t length) override;
+    void close() override;
+
+    /// \brief wait until fill bytes are read ahead, the source ended or timeout passed
+    /// \return bytes read ahead
+    std::size_t waitForFill(std::size_t fill, std::chrono::milliseconds timeout);
+
+protected:
+    void threadProc();
+
+    std::shared_ptr<Config> config;
+    std::unique_ptr<IOHandler> source;
+    fs::path tmpDir;
+    std::size_t size;
+    int fd { -1 };
+
+    /// \brief bytes written to and read from the file since the start
+    std::uint64_t written { 0 };
+    std::uint64_t consumed { 0 };
+    bool eof { false };
+    bool readError { false };
+    bool shutdown { false };
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    using AutoLockU = std::unique_lock<std::mutex>;
+
+    std::unique_ptr<IOBufferPool::Job> threadRunner;
+};
+
+#endif // __SPOOL_IO_HANDLER_H__
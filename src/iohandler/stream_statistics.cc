@@ -0,0 +1,105 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    stream_statistics.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file stream_statistics.cc
+
+#include "stream_statistics.h" // API
+
+#include <algorithm>
+
+void StreamStatistics::Stream::addRead(std::chrono::steady_clock::duration time, std::size_t length)
+{
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+    auto bucket = std::upper_bound(LATENCY_BOUNDS.begin(), LATENCY_BOUNDS.end(), us - 1) - LATENCY_BOUNDS.begin();
+    latency.at(bucket)++;
+    reads++;
+    if (time > STALL_TIME)
+        stalls++;
+    if (length > 0) {
+        bytes += length;
+        if (firstByte < 0)
+            firstByte = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+StreamStatistics::StreamStatistics(bool enabled, std::size_t keepFinished)
+    : enabled(enabled)
+    , keepFinished(keepFinished)
+{
+}
+
+std::shared_ptr<StreamStatistics::Stream> StreamStatistics::start(const std::string& client, int objectID, const std::string& location)
+{
+    AutoLock lock(mutex);
+    auto stream = std::make_shared<Stream>(nextID++, client, objectID, location);
+    active.push_back(stream);
+    return stream;
+}
+
+void StreamStatistics::finish(const std::shared_ptr<Stream>& stream)
+{
+    if (!stream->active.exchange(false))
+        return;
+    stream->end = std::chrono::steady_clock::now().time_since_epoch().count();
+
+    AutoLock lock(mutex);
+    active.remove(stream);
+    finished.push_front(stream);
+    if (finished.size() > keepFinished)
+        finished.pop_back();
+}
+
+std::vector<StreamStatistics::Snapshot> StreamStatistics::getSnapshot()
+{
+    std::vector<std::shared_ptr<Stream>> streams;
+    {
+        AutoLock lock(mutex);
+        streams.assign(active.begin(), active.end());
+        streams.insert(streams.end(), finished.begin(), finished.end());
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::vector<Snapshot> result;
+    result.reserve(streams.size());
+    for (auto&& stream : streams) {
+        Snapshot snapshot;
+        snapshot.id = stream->id;
+        snapshot.client = stream->client;
+        snapshot.objectID = stream->objectID;
+        snapshot.location = stream->location;
+        snapshot.active = stream->active;
+        auto end = snapshot.active ? now : std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(stream->end.load()));
+        snapshot.seconds = std::chrono::duration<double>(end - stream->start).count();
+        long firstByte = stream->firstByte;
+        snapshot.firstByteMs = firstByte < 0 ? -1 : firstByte / 1000.0;
+        snapshot.bytes = stream->bytes;
+        snapshot.bytesPerSecond = snapshot.seconds > 0 ? snapshot.bytes / snapshot.seconds : 0;
+        snapshot.reads = stream->reads;
+        snapshot.seeks = stream->seeks;
+        snapshot.stalls = stream->stalls;
+        for (std::size_t i = 0; i < snapshot.latency.size(); i++)
+            snapshot.latency.at(i) = stream->latency.at(i);
+        result.push_back(std::move(snapshot));
+    }
+    return result;
+}
@@ -0,0 +1,122 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    stream_statistics.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file stream_statistics.h
+#ifndef __STREAM_STATISTICS_H__
+#define __STREAM_STATISTICS_H__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// \brief Bytes, read latency, seeks and stalls of the files being served
+///
+/// Each stream is updated by the thread serving it, the counters are atomics
+/// so the web UI can take a snapshot at any time. Finished streams are kept
+/// for a while, so short requests show up as well.
+class StreamStatistics {
+public:
+    /// \brief upper bounds of the read latency buckets in microseconds, the last bucket is open
+    static constexpr std::array<long, 5> LATENCY_BOUNDS { 100, 1000, 10000, 100000, 1000000 };
+    /// \brief a read taking longer than this starved the client
+    static constexpr auto STALL_TIME = std::chrono::milliseconds(100);
+
+    using Histogram = std::array<unsigned long, LATENCY_BOUNDS.size() + 1>;
+
+    struct Stream {
+        Stream(unsigned long id, std::string client, int objectID, std::string location)
+            : id(id)
+            , client(std::move(client))
+            , objectID(objectID)
+            , location(std::move(location))
+            , start(std::chrono::steady_clock::now())
+        {
+        }
+
+        const unsigned long id;
+        const std::string client;
+        const int objectID;
+        const std::string location;
+        const std::chrono::steady_clock::time_point start;
+
+        /// \brief microseconds after start until the first data was read, -1 before
+        std::atomic_long firstByte { -1 };
+        std::atomic<std::uint64_t> bytes { 0 };
+        std::atomic_ulong reads { 0 };
+        std::atomic_ulong seeks { 0 };
+        std::atomic_ulong stalls { 0 };
+        std::array<std::atomic_ulong, LATENCY_BOUNDS.size() + 1> latency {};
+        std::atomic_bool active { true };
+        std::atomic<std::chrono::steady_clock::rep> end { 0 };
+
+        /// \brief count a read that took time and returned length bytes
+        void addRead(std::chrono::steady_clock::duration time, std::size_t length);
+        void addSeek() { seeks++; }
+    };
+
+    struct Snapshot {
+        unsigned long id;
+        std::string client;
+        int objectID;
+        std::string location;
+        bool active;
+        double seconds;
+        /// \brief milliseconds until the first data was read, -1 if none yet
+        double firstByteMs;
+        std::uint64_t bytes;
+        double bytesPerSecond;
+        unsigned long reads;
+        unsigned long seeks;
+        unsigned long stalls;
+        Histogram latency;
+    };
+
+    explicit StreamStatistics(bool enabled, std::size_t keepFinished = 32);
+
+    bool isEnabled() const { return enabled; }
+
+    /// \brief register a stream, it counts as active until finish()
+    std::shared_ptr<Stream> start(const std::string& client, int objectID, const std::string& location);
+    void finish(const std::shared_ptr<Stream>& stream);
+
+    /// \brief active streams first, then the most recently finished ones
+    std::vector<Snapshot> getSnapshot();
+
+private:
+    bool enabled;
+    std::size_t keepFinished;
+    unsigned long nextID { 1 };
+    std::list<std::shared_ptr<Stream>> active;
+    /// \brief most recently finished first
+    std::list<std::shared_ptr<Stream>> finished;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+};
+
+#endif // __STREAM_STATISTICS_H__
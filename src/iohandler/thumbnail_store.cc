@@ -0,0 +1,201 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    thumbnail_store.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file thumbnail_store.cc
+
+#include "thumbnail_store.h" // API
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "mem_io_handler.h"
+#include "metadata/metadata_handler.h"
+
+/// \brief marks a complete record, "GTHS"
+static constexpr std::uint32_t RECORD_MAGIC = 0x53485447;
+
+static std::size_t alignRecord(std::size_t offset)
+{
+    return (offset + 7) & ~std::size_t(7);
+}
+
+struct ThumbnailStore::Mapping {
+    char* data;
+    std::size_t size;
+
+    Mapping(char* data, std::size_t size)
+        : data(data)
+        , size(size)
+    {
+    }
+    ~Mapping() { munmap(data, size); }
+};
+
+ThumbnailStore::ThumbnailStore(fs::path file, std::size_t capacity)
+    : file(std::move(file))
+    , capacity(capacity)
+{
+    if (capacity < sizeof(RecordHeader))
+        throw_std_runtime_error("Thumbnail store {} is too small", this->file.c_str());
+    open(false);
+    // the written part of the mapping is in the page cache once it was served
+    memory = MemoryAccounting::getInstance().add("thumbnail-store", [this] {
+        AutoLock lock(mutex);
+        return writeOffset + entries.size() * (MemoryAccounting::TREE_NODE + sizeof(decltype(entries)::value_type));
+    });
+}
+
+ThumbnailStore::~ThumbnailStore() = default;
+
+bool ThumbnailStore::isStored(int handlerType)
+{
+    switch (handlerType) {
+    case CH_LIBEXIF:
+    case CH_ID3:
+    case CH_MP4:
+    case CH_FFTH:
+    case CH_FLAC:
+    case CH_MATROSKA:
+        return true;
+    default:
+        // fanart, subtitles and other resources are files of their own
+        return false;
+    }
+}
+
+void ThumbnailStore::open(bool reset)
+{
+    if (reset) {
+        // mappings held by running requests stay valid after the file is gone
+        std::error_code ec;
+        fs::remove(file, ec);
+    }
+
+    int fd = ::open(file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw_std_runtime_error("Failed to open {}: {}", file.c_str(), std::strerror(errno));
+
+    struct stat statbuf;
+    bool fresh = fstat(fd, &statbuf) != 0 || std::size_t(statbuf.st_size) != capacity;
+    if (fresh) {
+        // allocate all blocks now, writing to a mapped hole fails with SIGBUS when the disk is full
+#ifdef __APPLE__
+        int ret = ftruncate(fd, 0) != 0 || ftruncate(fd, capacity) != 0 ? errno : 0;
+#else
+        int ret = ftruncate(fd, 0) != 0 ? errno : posix_fallocate(fd, 0, capacity);
+#endif
+        if (ret != 0) {
+            ::close(fd);
+            throw_std_runtime_error("Failed to allocate {}: {}", file.c_str(), std::strerror(ret));
+        }
+    }
+
+    void* addr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int mapError = errno;
+    ::close(fd);
+    if (addr == MAP_FAILED)
+        throw_std_runtime_error("Failed to map {}: {}", file.c_str(), std::strerror(mapError));
+
+    mapping = std::make_shared<Mapping>(static_cast<char*>(addr), capacity);
+    entries.clear();
+    writeOffset = 0;
+    if (!fresh)
+        scan();
+}
+
+void ThumbnailStore::scan()
+{
+    std::size_t offset = 0;
+    while (offset + sizeof(RecordHeader) <= capacity) {
+        RecordHeader header;
+        std::memcpy(&header, mapping->data + offset, sizeof(header));
+        if (header.magic != RECORD_MAGIC || header.length > capacity - offset - sizeof(RecordHeader))
+            break;
+        // a later record of the same resource replaces the earlier one
+        entries[{ header.objectID, header.resID }] = Entry { offset + sizeof(RecordHeader), header.length, header.mtime, header.fileSize };
+        offset = alignRecord(offset + sizeof(RecordHeader) + header.length);
+    }
+    writeOffset = offset;
+    log_debug("Thumbnail store {} holds {} resources in {} bytes", file.c_str(), entries.size(), writeOffset);
+}
+
+std::unique_ptr<IOHandler> ThumbnailStore::get(int objectID, int resID, const struct stat& statbuf)
+{
+    AutoLock lock(mutex);
+    auto entry = entries.find({ objectID, resID });
+    if (entry == entries.end() || entry->second.mtime != statbuf.st_mtime || entry->second.fileSize != statbuf.st_size)
+        return nullptr;
+
+    auto data = std::shared_ptr<const char>(mapping, mapping->data + entry->second.offset);
+    return std::make_unique<MemIOHandler>(data, entry->second.length);
+}
+
+std::unique_ptr<IOHandler> ThumbnailStore::put(int objectID, int resID, const struct stat& statbuf, const std::string& data)
+{
+    // large images would push out all others
+    std::size_t recordSize = sizeof(RecordHeader) + data.size();
+    if (recordSize > capacity / 4)
+        return nullptr;
+
+    std::shared_ptr<Mapping> target;
+    std::size_t offset;
+    {
+        AutoLock lock(mutex);
+        if (writeOffset + recordSize > capacity) {
+            log_debug("Thumbnail store {} is full, starting over", file.c_str());
+            try {
+                open(true);
+            } catch (const std::runtime_error& e) {
+                log_warning("{}", e.what());
+                return nullptr;
+            }
+        }
+        target = mapping;
+        offset = writeOffset;
+        writeOffset = alignRecord(offset + recordSize);
+    }
+
+    // header goes last, so an interrupted write ends the scan on the next start
+    std::memcpy(target->data + offset + sizeof(RecordHeader), data.data(), data.size());
+    RecordHeader header { RECORD_MAGIC, std::uint32_t(data.size()), objectID, resID, statbuf.st_mtime, statbuf.st_size };
+    std::memcpy(target->data + offset, &header, sizeof(header));
+
+    AutoLock lock(mutex);
+    if (target == mapping)
+        entries[{ objectID, resID }] = Entry { offset + sizeof(RecordHeader), data.size(), header.mtime, header.fileSize };
+    return std::make_unique<MemIOHandler>(std::shared_ptr<const char>(target, target->data + offset + sizeof(RecordHeader)), data.size());
+}
+
+std::size_t ThumbnailStore::getUsed()
+{
+    AutoLock lock(mutex);
+    return writeOffset;
+}
+
+std::size_t ThumbnailStore::getCount()
+{
+    AutoLock lock(mutex);
+    return entries.size();
+}
@@ -0,0 +1,101 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    thumbnail_store.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file thumbnail_store.h
+#ifndef __THUMBNAIL_STORE_H__
+#define __THUMBNAIL_STORE_H__
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+namespace fs = std::filesystem;
+
+#include "util/memory_accounting.h"
+
+// forward declaration
+class IOHandler;
+
+/// \brief Keeps album art and thumbnails ready to be served from a memory mapped file
+///
+/// Extracting embedded images means opening and parsing the media file for every request.
+/// The data is appended to a file of fixed size on first access and later served straight
+/// from the mapping. The index is rebuilt from the file on startup. Each record remembers
+/// size and modification time of the media file, so changed files are extracted again.
+/// When the file is full it is replaced by an empty one.
+class ThumbnailStore {
+public:
+    ThumbnailStore(fs::path file, std::size_t capacity);
+    ~ThumbnailStore();
+
+    /// \brief whether resources of the metadata handler are kept in the store
+    static bool isStored(int handlerType);
+
+    /// \brief handler for the stored resource or nullptr
+    /// \param statbuf state of the media file the resource was extracted from
+    std::unique_ptr<IOHandler> get(int objectID, int resID, const struct stat& statbuf);
+
+    /// \brief store data and return a handler for the stored copy, nullptr if it does not fit
+    std::unique_ptr<IOHandler> put(int objectID, int resID, const struct stat& statbuf, const std::string& data);
+
+    std::size_t getUsed();
+    std::size_t getCount();
+
+protected:
+    struct Mapping;
+
+    /// \brief on disk in front of each record
+    struct RecordHeader {
+        std::uint32_t magic;
+        std::uint32_t length;
+        std::int32_t objectID;
+        std::int32_t resID;
+        std::int64_t mtime;
+        std::int64_t fileSize;
+    };
+
+    struct Entry {
+        std::size_t offset;
+        std::size_t length;
+        std::int64_t mtime;
+        std::int64_t fileSize;
+    };
+
+    /// \brief map the file, replace it if reset is set or it does not have the expected size
+    void open(bool reset);
+    void scan();
+
+    fs::path file;
+    std::size_t capacity;
+    std::shared_ptr<Mapping> mapping;
+    std::size_t writeOffset { 0 };
+    std::map<std::pair<int, int>, Entry> entries;
+    std::mutex mutex;
+
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::unique_ptr<MemoryAccounting::Registration> memory;
+};
+
+#endif // __THUMBNAIL_STORE_H__
@@ -66,12 +66,15 @@
 #include "config/config_generator.h"
 #include "config/config_manager.h"
 #include "content/content_manager.h"
+#include "content/import_statistics.h"
 #include "contrib/cxxopts.hpp"
 #include "server.h"
+#include "util/profiler.h"
 
 static struct {
     int shutdown_flag = 0;
     int restart_flag = 0;
+    int profile_flag = 0;
     pthread_t main_thread_id;
 
     std::mutex mutex;
@@ -113,6 +116,8 @@ static void signalHandler(int signum)
         }
     } else if (signum == SIGHUP) {
         _ctx.restart_flag = 1;
+    } else if (signum == SIGUSR2) {
+        _ctx.profile_flag = 1;
     }
 
     _ctx.cond.notify_one();
@@ -141,6 +146,69 @@ static void installSignalHandler()
     if (sigaction(SIGPIPE, &action, nullptr) < 0) {
         log_error("Could not register SIGPIPE handler!");
     }
+
+    if (sigaction(SIGUSR2, &action, nullptr) < 0) {
+        log_error("Could not register SIGUSR2 handler!");
+    }
+}
+
+/// \brief import dir into the benchmark database, wait until all tasks are done and print the statistics
+static int runImportBenchmark(const std::shared_ptr<Server>& server, const std::shared_ptr<ConfigManager>& configManager, const fs::path& dir)
+{
+    auto content = server->getContent();
+    std::error_code ec;
+    auto dirEnt = fs::directory_entry(dir, ec);
+    if (ec || !dirEnt.is_directory()) {
+        log_error("Failed to read {}: {}", dir.c_str(), ec ? ec.message() : "not a directory");
+        return EXIT_FAILURE;
+    }
+
+    AutoScanSetting asSetting;
+    asSetting.followSymlinks = configManager->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS);
+    asSetting.recursive = true;
+    asSetting.hidden = configManager->getBoolOption(CFG_IMPORT_HIDDEN_FILES);
+    asSetting.rescanResource = false;
+    asSetting.mergeOptions(configManager, dir);
+
+    log_info("Benchmarking import of {}", dir.c_str());
+    auto start = std::chrono::steady_clock::now();
+    content->addFile(dirEnt, asSetting, true);
+    while (!_ctx.shutdown_flag && content->isBusy()) {
+        _ctx.cond.wait_for(_ctx.lock, std::chrono::milliseconds(100));
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (_ctx.shutdown_flag) {
+        log_warning("Import benchmark interrupted");
+        return EXIT_FAILURE;
+    }
+
+    auto snapshot = content->getContext()->getImportStatistics()->getSnapshot();
+    std::cout << fmt::format("{:<16}{:>10}{:>14}{:>14}", "stage", "calls", "time [ms]", "per call [us]") << std::endl;
+    for (std::size_t i = 0; i < snapshot.stages.size(); i++) {
+        auto&& stage = snapshot.stages.at(i);
+        if (stage.calls == 0)
+            continue;
+        std::cout << fmt::format("{:<16}{:>10}{:>14.1f}{:>14.1f}", ImportStatistics::getStageName(static_cast<ImportStatistics::Stage>(i)),
+                         stage.calls, stage.time.count() / 1000.0, static_cast<double>(stage.time.count()) / stage.calls)
+                  << std::endl;
+    }
+    std::cout << fmt::format("{} files in {:.2f} s, {:.1f} files/s", snapshot.files, elapsed, elapsed > 0 ? snapshot.files / elapsed : 0.0) << std::endl;
+    return EXIT_SUCCESS;
+}
+
+/// \brief write the database to a dump file or replace it by one, without starting the server
+static int runDatabaseDump(const std::shared_ptr<Config>& config, const fs::path& path, bool import)
+{
+    try {
+        auto start = std::chrono::steady_clock::now();
+        Server::transferDatabase(config, path, import);
+        log_info("{} {} in {:.2f} s", import ? "Imported database from" : "Exported database to", path.c_str(),
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    } catch (const std::runtime_error& e) {
+        log_error("{}", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
 }
 
 int main(int argc, char** argv, char** envp)
@@ -149,6 +217,7 @@ int main(int argc, char** argv, char** envp)
 
     options.add_options() //
         ("D,debug", "Enable debugging", cxxopts::value<bool>()->default_value("false")) //
+        ("debug-mode", "Enable debugging of these subsystems only, e.g. content,database", cxxopts::value<std::vector<std::string>>(), "SUBSYSTEMS") //
         ("d,daemon", "Daemonize after startup", cxxopts::value<bool>()->default_value("false")) //
         ("u,user", "Drop privs to user", cxxopts::value<std::string>()) //
         ("P,pidfile", "Write a pidfile to the specified location, e.g. /run/gerbera.pid", cxxopts::value<std::string>()) //
@@ -164,6 +233,10 @@ int main(int argc, char** argv, char** envp)
         ("h,help", "Print this help and exit") //
         ("create-config", "Print a default config.xml file and exit") //
         ("add-file", "Scan a file into the DB on startup, can be specified multiple times", cxxopts::value<std::vector<std::string>>(), "FILE") //
+        ("benchmark-import", "Import a directory into a temporary database, print the import statistics and exit", cxxopts::value<std::string>(), "DIR") //
+        ("role", "Run only the imports (scanner) or only the UPnP and web server (server) on a shared database", cxxopts::value<std::string>(), "ROLE") //
+        ("export-db", "Write the database to a dump file and exit", cxxopts::value<std::string>(), "FILE") //
+        ("import-db", "Replace the database by a dump file written with --export-db and exit", cxxopts::value<std::string>(), "FILE") //
         ;
 
     try {
@@ -198,6 +271,10 @@ int main(int argc, char** argv, char** envp)
         }
 
         bool debug = opts["debug"].as<bool>();
+        if (opts.count("debug-mode") > 0) {
+            GrbLogger::setDebugSubsystems(opts["debug-mode"].as<std::vector<std::string>>());
+            debug = true;
+        }
         if (debug) {
             spdlog::set_level(spdlog::level::debug);
             spdlog::set_pattern("%Y-%m-%d %X.%e %6l: [%s:%#] %!(): %v");
@@ -442,8 +519,39 @@ int main(int argc, char** argv, char** envp)
             interface = opts["interface"].as<std::string>();
         }
 
+        std::optional<std::string> role;
+        if (opts.count("role") > 0) {
+            role = opts["role"].as<std::string>();
+            if (opts.count("benchmark-import") > 0) {
+                log_error("--role can not be used with --benchmark-import");
+                exit(EXIT_FAILURE);
+            }
+            if (role == "server" && opts.count("add-file") > 0) {
+                log_error("--add-file is imported by the scanner, it can not be used with --role=server");
+                exit(EXIT_FAILURE);
+            }
+        }
+        std::optional<std::string> exportFile;
+        std::optional<std::string> importFile;
+        if (opts.count("export-db") > 0)
+            exportFile = opts["export-db"].as<std::string>();
+        if (opts.count("import-db") > 0)
+            importFile = opts["import-db"].as<std::string>();
+        if (exportFile.has_value() && importFile.has_value()) {
+            log_error("--export-db can not be used with --import-db");
+            exit(EXIT_FAILURE);
+        }
+        if ((exportFile.has_value() || importFile.has_value()) && (opts.count("benchmark-import") > 0 || role.has_value())) {
+            log_error("--export-db and --import-db can not be used with --benchmark-import or --role");
+            exit(EXIT_FAILURE);
+        }
+        // the scanner neither answers clients nor announces itself on the network
+        bool contentOnly = opts.count("benchmark-import") > 0 || role == "scanner";
+
         log_debug("Datadir is: {}", dataDir.value_or("unset"));
 
+        fs::path benchmarkDatabase = fs::temp_directory_path() / fmt::format("gerbera-benchmark-{}.db", getpid());
+
         std::shared_ptr<ConfigManager> configManager;
         try {
             configManager = std::make_shared<ConfigManager>(
@@ -453,6 +561,10 @@ int main(int argc, char** argv, char** envp)
                 debug);
             configManager->load(home.value_or(""));
             portnum = in_port_t(configManager->getIntOption(CFG_SERVER_PORT));
+            if (opts.count("benchmark-import") > 0)
+                configManager->setupImportBenchmark(benchmarkDatabase);
+            if (role.has_value())
+                configManager->setupProcessRole(role.value());
         } catch (const ConfigParseException& ce) {
             log_error("Error parsing config file '{}': {}", (*config_file).c_str(), ce.what());
             exit(EXIT_FAILURE);
@@ -461,8 +573,16 @@ int main(int argc, char** argv, char** envp)
             exit(EXIT_FAILURE);
         }
 
+        if (exportFile.has_value() || importFile.has_value()) {
+            int ret = runDatabaseDump(configManager, exportFile.value_or(importFile.value_or("")), importFile.has_value());
+            configManager = nullptr;
+            exit(ret);
+        }
+
         sigset_t mask_set;
         sigfillset(&mask_set);
+        // the threads started by the server must not block the profiler's sampling signal
+        sigdelset(&mask_set, SIGPROF);
         pthread_sigmask(SIG_SETMASK, &mask_set, nullptr);
 
         installSignalHandler();
@@ -472,7 +592,10 @@ int main(int argc, char** argv, char** envp)
             auto config = std::static_pointer_cast<Config>(configManager);
             server = std::make_shared<Server>(config);
             server->init();
-            server->run();
+            if (contentOnly)
+                server->runContentOnly();
+            else
+                server->run();
         } catch (const UpnpException& ue) {
 
             sigemptyset(&mask_set);
@@ -507,6 +630,27 @@ int main(int argc, char** argv, char** envp)
             exit(EXIT_FAILURE);
         }
 
+        if (opts.count("benchmark-import") > 0) {
+            sigemptyset(&mask_set);
+            pthread_sigmask(SIG_SETMASK, &mask_set, nullptr);
+
+            int ret = EXIT_FAILURE;
+            try {
+                ret = runImportBenchmark(server, configManager, opts["benchmark-import"].as<std::string>());
+                server->shutdown();
+            } catch (const std::runtime_error& e) {
+                log_error("{}", e.what());
+                ret = EXIT_FAILURE;
+            }
+            server = nullptr;
+            configManager = nullptr;
+            for (auto&& suffix : { "", "-journal", "-wal", "-shm" }) {
+                std::error_code ec;
+                fs::remove(fs::path(benchmarkDatabase.string() + suffix), ec);
+            }
+            exit(ret);
+        }
+
         if (opts.count("add-file") > 0) {
             auto files = opts["add-file"].as<std::vector<std::string>>();
             for (const auto& f : files) {
@@ -539,7 +683,30 @@ int main(int argc, char** argv, char** envp)
         while (!_ctx.shutdown_flag) {
             _ctx.cond.wait(_ctx.lock);
 
+            if (_ctx.profile_flag != 0) {
+                _ctx.profile_flag = 0;
+                try {
+                    server->getProfiler()->start();
+                } catch (const std::runtime_error& e) {
+                    log_error("Could not start profiling: {}", e.what());
+                }
+            }
+
             if (_ctx.restart_flag != 0) {
+                // clients, transcoding profiles and layout mappings are reloaded without restarting the server
+                try {
+                    bool reloaded = configManager->reload(server->getDatabase());
+                    if (reloaded) {
+                        server->reloadConfig();
+                        _ctx.restart_flag = 0;
+                        continue;
+                    }
+                } catch (const std::runtime_error& e) {
+                    log_error("Could not reload configuration, keeping the running one: {}", e.what());
+                    _ctx.restart_flag = 0;
+                    continue;
+                }
+
                 log_info("Restarting Gerbera!");
                 try {
                     server->shutdown();
@@ -564,11 +731,17 @@ int main(int argc, char** argv, char** envp)
                         exit(EXIT_FAILURE);
                     }
 
+                    if (role.has_value())
+                        configManager->setupProcessRole(role.value());
+
                     ///  \todo fix this for SIGHUP
                     auto config = std::static_pointer_cast<Config>(configManager);
                     server = std::make_shared<Server>(config);
                     server->init();
-                    server->run();
+                    if (contentOnly)
+                        server->runContentOnly();
+                    else
+                        server->run();
 
                     _ctx.restart_flag = 0;
                 } catch (const std::runtime_error& e) {
@@ -0,0 +1,100 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    directory_index.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file directory_index.cc
+
+#include "directory_index.h" // API
+
+#include "util/tools.h"
+
+DirectoryIndex::DirectoryIndex(std::size_t capacity)
+    : capacity(capacity)
+{
+}
+
+std::shared_ptr<const DirectoryIndex::Listing> DirectoryIndex::getListing(const fs::path& folder)
+{
+    std::error_code ec;
+    auto mtime = fs::last_write_time(folder, ec);
+    if (ec)
+        return nullptr;
+
+    {
+        AutoLock lock(mutex);
+        auto entry = listings.find(folder);
+        if (entry != listings.end()) {
+            if (entry->second->mtime == mtime) {
+                listings.touch(entry);
+                return entry->second;
+            }
+            listings.erase(entry);
+        }
+    }
+
+    // list outside of the lock, the import threads look up other directories at the same time
+    auto listing = std::make_shared<Listing>();
+    listing->folder = folder;
+    listing->mtime = mtime;
+    for (auto&& dirEnt : fs::directory_iterator(folder, ec)) {
+        std::error_code fileEc;
+        if (!dirEnt.is_regular_file(fileEc))
+            continue;
+        auto name = dirEnt.path().filename().string();
+        listing->names.emplace(name, dirEnt.path());
+        listing->lowerNames.emplace(toLower(name), dirEnt.path());
+    }
+    if (ec) {
+        log_debug("Failed to list {}: {}", folder.c_str(), ec.message());
+        return nullptr;
+    }
+
+    AutoLock lock(mutex);
+    if (listings.find(folder) == listings.end()) {
+        listings.put(folder, listing);
+        while (listings.size() > capacity)
+            listings.pop_back();
+    }
+    return listing;
+}
+
+fs::path DirectoryIndex::find(const fs::path& folder, const std::vector<std::string>& names, bool caseSensitive)
+{
+    auto listing = getListing(folder);
+    if (listing == nullptr)
+        return "";
+
+    for (auto&& name : names) {
+        if (fs::path(name).has_parent_path()) {
+            // not in this directory, e.g. a subfolder for the artwork
+            std::error_code ec;
+            if (caseSensitive && isRegularFile(folder / name, ec))
+                return folder / name;
+            continue;
+        }
+        auto&& map = caseSensitive ? listing->names : listing->lowerNames;
+        auto entry = map.find(caseSensitive ? name : toLower(name));
+        if (entry != map.end())
+            return entry->second;
+    }
+    return "";
+}
@@ -0,0 +1,69 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    directory_index.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file directory_index.h
+#ifndef __DIRECTORY_INDEX_H__
+#define __DIRECTORY_INDEX_H__
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "util/lru_cache.h"
+namespace fs = std::filesystem;
+
+/// \brief Remembers the regular files of the recently imported directories
+///
+/// The fanart, subtitle and resource handlers look for files next to each item.
+/// The directory is listed once instead of checking every candidate name for every item.
+/// A listing is read again when the modification time of the directory changes.
+class DirectoryIndex {
+public:
+    explicit DirectoryIndex(std::size_t capacity = 64);
+
+    /// \brief the first of names that is a regular file in folder, empty if there is none
+    fs::path find(const fs::path& folder, const std::vector<std::string>& names, bool caseSensitive);
+
+protected:
+    struct Listing {
+        fs::path folder;
+        fs::file_time_type mtime;
+        std::map<std::string, fs::path> names;
+        /// \brief lower case file names, the first wins if only the case differs
+        std::map<std::string, fs::path> lowerNames;
+    };
+
+    std::shared_ptr<const Listing> getListing(const fs::path& folder);
+
+    std::size_t capacity;
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+
+    LruCache<fs::path, std::shared_ptr<const Listing>> listings;
+};
+
+#endif // __DIRECTORY_INDEX_H__
@@ -0,0 +1,173 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    duplicate_index.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file duplicate_index.cc
+
+#include "duplicate_index.h" // API
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+#include "cds_objects.h"
+#include "util/tools.h"
+
+/// \brief bytes hashed at the start and the end of a file
+static constexpr off_t FINGERPRINT_BLOCK = 64 * 1024;
+
+DuplicateIndex::DuplicateIndex(std::size_t capacity)
+    : capacity(capacity)
+{
+}
+
+bool DuplicateIndex::identify(const fs::path& path, FileIdentity& identity)
+{
+    identity.hasFingerprint = false;
+    identity.birthTime = 0;
+#ifdef STATX_BTIME
+    struct statx statxbuf;
+    if (statx(AT_FDCWD, path.c_str(), 0, STATX_BASIC_STATS | STATX_BTIME, &statxbuf) == 0) {
+        identity.device = makedev(statxbuf.stx_dev_major, statxbuf.stx_dev_minor);
+        identity.inode = statxbuf.stx_ino;
+        identity.size = statxbuf.stx_size;
+        identity.mtime = statxbuf.stx_mtime.tv_sec;
+        if (statxbuf.stx_mask & STATX_BTIME)
+            identity.birthTime = statxbuf.stx_btime.tv_sec;
+        return true;
+    }
+    // kernel or filesystem without statx
+#endif
+
+    struct stat statbuf;
+    if (stat(path.c_str(), &statbuf) != 0)
+        return false;
+
+    identity.device = statbuf.st_dev;
+    identity.inode = statbuf.st_ino;
+    identity.size = statbuf.st_size;
+    identity.mtime = statbuf.st_mtime;
+    return true;
+}
+
+bool DuplicateIndex::readFingerprint(const fs::path& path, FileIdentity& identity)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    std::string block(FINGERPRINT_BLOCK, '\0');
+    auto readBlock = [&](off_t offset, std::int64_t& hash) {
+        auto bytes = pread(fd, block.data(), block.size(), offset);
+        if (bytes < 0)
+            return false;
+        hash = stringHash(block.substr(0, bytes));
+        return true;
+    };
+    bool ok = readBlock(0, identity.head) && readBlock(std::max<off_t>(0, identity.size - FINGERPRINT_BLOCK), identity.tail);
+    close(fd);
+
+    identity.hasFingerprint = ok;
+    return ok;
+}
+
+std::shared_ptr<CdsItem> DuplicateIndex::find(const fs::path& path, FileIdentity& identity, const std::string& mimeType)
+{
+    auto matches = [&](const Entry& entry) {
+        return entry.identity.size == identity.size && entry.item->getMimeType() == mimeType;
+    };
+    auto use = [&](Cache::iterator entry) {
+        entries.touch(entry);
+        return entry->second.item;
+    };
+
+    {
+        AutoLock lock(mutex);
+        auto inode = entries.find({ identity.device, identity.inode });
+        if (inode != entries.end() && matches(inode->second) && inode->second.identity.mtime == identity.mtime) {
+            log_debug("{} is a hardlink of {}", path.c_str(), inode->second.item->getLocation().c_str());
+            return use(inode);
+        }
+    }
+
+    // read outside of the lock, the import threads look up files at the same time
+    if (!identity.hasFingerprint && !readFingerprint(path, identity))
+        return nullptr;
+
+    AutoLock lock(mutex);
+    auto fingerprint = byFingerprint.find({ identity.size, identity.head, identity.tail });
+    if (fingerprint == byFingerprint.end())
+        return nullptr;
+    auto entry = entries.find(fingerprint->second);
+    if (entry != entries.end() && matches(entry->second)) {
+        log_debug("{} is a copy of {}", path.c_str(), entry->second.item->getLocation().c_str());
+        return use(entry);
+    }
+    return nullptr;
+}
+
+void DuplicateIndex::add(const fs::path& path, FileIdentity& identity, const std::shared_ptr<CdsItem>& item)
+{
+    if (!identity.hasFingerprint)
+        readFingerprint(path, identity);
+
+    auto snapshot = std::make_shared<CdsItem>();
+    item->copyTo(snapshot);
+
+    InodeKey inode { identity.device, identity.inode };
+    AutoLock lock(mutex);
+    // the previous version of the file
+    auto entry = entries.find(inode);
+    if (entry != entries.end())
+        removeFingerprint(entry);
+    entries.put(inode, Entry { identity, snapshot });
+    if (identity.hasFingerprint)
+        byFingerprint[{ identity.size, identity.head, identity.tail }] = inode;
+
+    while (entries.size() > capacity) {
+        auto last = std::prev(entries.end());
+        removeFingerprint(last);
+        entries.erase(last);
+    }
+}
+
+void DuplicateIndex::removeFingerprint(Cache::iterator entry)
+{
+    const auto& identity = entry->second.identity;
+    if (!identity.hasFingerprint)
+        return;
+    auto fingerprint = byFingerprint.find({ identity.size, identity.head, identity.tail });
+    if (fingerprint != byFingerprint.end() && fingerprint->second == entry->first)
+        byFingerprint.erase(fingerprint);
+}
+
+void DuplicateIndex::copyMetadata(const std::shared_ptr<CdsItem>& original, const std::shared_ptr<CdsItem>& item)
+{
+    item->setMetadata(original->getMetadata());
+    item->setAuxData(original->getAuxData());
+    item->setFlag(original->getFlags());
+    item->setTrackNumber(original->getTrackNumber());
+    item->setPartNumber(original->getPartNumber());
+    for (auto&& resource : original->getResources())
+        item->addResource(resource->clone());
+}
@@ -0,0 +1,101 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    duplicate_index.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file duplicate_index.h
+#ifndef __DUPLICATE_INDEX_H__
+#define __DUPLICATE_INDEX_H__
+
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sys/types.h>
+#include <tuple>
+
+#include "common.h"
+#include "util/lru_cache.h"
+namespace fs = std::filesystem;
+
+// forward declaration
+class CdsItem;
+
+/// \brief Remembers the metadata read from files so identical copies are not parsed again
+///
+/// A file is identical if it is the same inode with the same size and modification time (hardlinks),
+/// or if size and the hashes of the first and last 64k match (copies and backups).
+/// Only data taken from the file content is kept, fanart and subtitles next to the file are not.
+class DuplicateIndex {
+public:
+    /// \brief identity of a file, the fingerprint is only read when the inode is unknown
+    struct FileIdentity {
+        dev_t device;
+        ino_t inode;
+        off_t size;
+        time_t mtime;
+        /// \brief creation time if the filesystem reports it, a replaced file gets a new one
+        time_t birthTime { 0 };
+        bool hasFingerprint { false };
+        std::int64_t head { 0 };
+        std::int64_t tail { 0 };
+    };
+
+    explicit DuplicateIndex(std::size_t capacity = 4096);
+
+    /// \brief stat the file, returns false if it cannot be read
+    static bool identify(const fs::path& path, FileIdentity& identity);
+
+    /// \brief hash the first and last 64k of the file
+    static bool readFingerprint(const fs::path& path, FileIdentity& identity);
+
+    /// \brief metadata of an identical file with the same mime type or nullptr
+    std::shared_ptr<CdsItem> find(const fs::path& path, FileIdentity& identity, const std::string& mimeType);
+
+    /// \brief remember the content metadata of item
+    void add(const fs::path& path, FileIdentity& identity, const std::shared_ptr<CdsItem>& item);
+
+    /// \brief copy the content metadata of original to item
+    static void copyMetadata(const std::shared_ptr<CdsItem>& original, const std::shared_ptr<CdsItem>& item);
+
+protected:
+    using InodeKey = std::pair<dev_t, ino_t>;
+    using FingerprintKey = std::tuple<off_t, std::int64_t, std::int64_t>;
+
+    struct Entry {
+        FileIdentity identity;
+        std::shared_ptr<CdsItem> item;
+    };
+    using Cache = LruCache<InodeKey, Entry>;
+
+    /// \brief drop the fingerprint of entry unless it was taken by another file, lock must be held
+    void removeFingerprint(Cache::iterator entry);
+
+    std::size_t capacity;
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+
+    Cache entries;
+    /// \brief the last file added with the fingerprint
+    std::map<FingerprintKey, InodeKey> byFingerprint;
+};
+
+#endif // __DUPLICATE_INDEX_H__
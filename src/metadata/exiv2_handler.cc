@@ -37,6 +37,7 @@
 #include "cds_objects.h"
 #include "config/config_manager.h"
 #include "iohandler/io_handler.h"
+#include "metadata/metadata_source.h"
 #include "util/string_converter.h"
 #include "util/tools.h"
 
@@ -51,8 +52,34 @@ void Exiv2Handler::fillMetadata(std::shared_ptr<CdsObject> item)
         std::string value;
         const auto sc = StringConverter::m2i(CFG_IMPORT_LIBOPTS_EXIV2_CHARSET, item->getLocation(), config);
 
-        const auto image = Exiv2::ImageFactory::open(item->getLocation().string());
-        image->readMetadata();
+        // exiv2 sees the start of the file first, the header of RAW and TIFF files is not all of the file
+        // the buffer has to live as long as the image reading it
+        std::vector<std::byte> header;
+        decltype(Exiv2::ImageFactory::open(std::string())) image;
+        auto headerSize = off_t(config->getIntOption(CFG_IMPORT_LIBOPTS_IMAGE_HEADER_SIZE)) * 1024;
+        if (source != nullptr && headerSize > 0 && source->getSize() > headerSize) {
+            header = source->readHead(headerSize);
+            try {
+                image = Exiv2::ImageFactory::open(reinterpret_cast<const Exiv2::byte*>(header.data()), header.size());
+                image->readMetadata();
+                auto& exif = image->exifData();
+                if (exif.empty() || exif.findKey(Exiv2::ExifKey("Exif.Photo.DateTimeOriginal")) == exif.end())
+                    image.reset();
+            } catch (Exiv2::AnyError& ex) {
+                image.reset();
+            }
+            if (image.get() == nullptr)
+                log_debug("Metadata of {} is not in the first {} bytes", item->getLocation().c_str(), header.size());
+        }
+
+        if (image.get() == nullptr) {
+            // the mapping of the shared source is read as memory, only the touched pages are loaded
+            auto data = source != nullptr ? source->map() : nullptr;
+            image = data != nullptr
+                ? Exiv2::ImageFactory::open(reinterpret_cast<const Exiv2::byte*>(data), source->getSize())
+                : Exiv2::ImageFactory::open(item->getLocation().string());
+            image->readMetadata();
+        }
         Exiv2::ExifData& exifData = image->exifData();
         Exiv2::XmpData& xmpData = image->xmpData();
 
@@ -61,11 +61,13 @@ extern "C" {
 
 #ifdef HAVE_FFMPEGTHUMBNAILER
 #include "iohandler/mem_io_handler.h"
+#include "metadata/thumbnail_service.h"
 #include <libffmpegthumbnailer/videothumbnailerc.h>
 #endif
 
 #include "cds_objects.h"
 #include "config/config_manager.h"
+#include "metadata/metadata_source.h"
 #include "util/string_converter.h"
 #include "util/tools.h"
 
@@ -78,6 +80,9 @@ extern "C" {
 // Default constructor
 FfmpegHandler::FfmpegHandler(const std::shared_ptr<Context>& context)
     : MetadataHandler(context)
+#ifdef HAVE_FFMPEGTHUMBNAILER
+    , thumbnailService(context->getThumbnailService())
+#endif
 {
 }
 
@@ -258,6 +263,11 @@ void FfmpegHandler::addFfmpegResourceFields(const std::shared_ptr<CdsItem>& item
             ffres->addAttribute(R_RESOLUTION, resolution);
             item->addResource(ffres);
             log_debug("Adding resource for video thumbnail");
+
+            if (thumbnailService && config->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_PREGENERATE) && config->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED)
+                && !thumbnailService->prefetch(item->getLocation(), item->getMTime(), item->getSizeOnDisk())) {
+                log_debug("Thumbnail queue is full, {} is generated on request", item->getLocation().c_str());
+            }
         }
     }
 #endif // FFMPEGTHUMBNAILER
@@ -269,6 +279,72 @@ static void FfmpegNoOutputStub(void* ptr, int level, const char* fmt, va_list vl
     // do nothing
 }
 
+/// \brief size of the buffer ffmpeg reads the shared source with
+static constexpr int SOURCE_IO_BUFFER = 32 * 1024;
+
+/// \brief position of ffmpeg in the shared source
+struct SourceIo {
+    MetadataSource* source;
+    int64_t position;
+};
+
+static int readSource(void* opaque, uint8_t* buf, int bufSize)
+{
+    auto io = static_cast<SourceIo*>(opaque);
+    auto bytes = io->source->read(io->position, buf, bufSize);
+    if (bytes < 0)
+        return AVERROR(EIO);
+    if (bytes == 0)
+        return AVERROR_EOF;
+    io->position += bytes;
+    return static_cast<int>(bytes);
+}
+
+static int64_t seekSource(void* opaque, int64_t offset, int whence)
+{
+    auto io = static_cast<SourceIo*>(opaque);
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE:
+        return io->source->getSize();
+    case SEEK_SET:
+        io->position = offset;
+        break;
+    case SEEK_CUR:
+        io->position += offset;
+        break;
+    case SEEK_END:
+        io->position = io->source->getSize() + offset;
+        break;
+    default:
+        return -1;
+    }
+    return io->position;
+}
+
+/// \brief the container header gives the duration and the codec parameters, find_stream_info is not needed
+static bool isHeaderComplete(AVFormatContext* pFormatCtx)
+{
+    if (pFormatCtx->iformat == nullptr || pFormatCtx->iformat->name == nullptr)
+        return false;
+    // only formats that store the codec parameters in the header
+    std::string format = pFormatCtx->iformat->name;
+    if (!startswith(format, "matroska") && !startswith(format, "mov,"))
+        return false;
+    if (pFormatCtx->duration <= 0 || pFormatCtx->nb_streams == 0)
+        return false;
+
+    for (unsigned int i = 0; i < pFormatCtx->nb_streams; i++) {
+        auto codecpar = as_codecpar(pFormatCtx->streams[i]);
+        if (codecpar->codec_id == AV_CODEC_ID_NONE)
+            return false;
+        if (codecpar->codec_type == AVMEDIA_TYPE_VIDEO && (codecpar->width <= 0 || codecpar->height <= 0))
+            return false;
+        if (codecpar->codec_type == AVMEDIA_TYPE_AUDIO && (codecpar->sample_rate <= 0 || codecpar->channels <= 0))
+            return false;
+    }
+    return true;
+}
+
 void FfmpegHandler::fillMetadata(std::shared_ptr<CdsObject> obj)
 {
     auto item = std::dynamic_pointer_cast<CdsItem>(obj);
@@ -286,15 +362,57 @@ void FfmpegHandler::fillMetadata(std::shared_ptr<CdsObject> obj)
     // Register all formats and codecs
     av_register_all();
 #endif
+    // read the file through the shared source, ffmpeg would open it once more
+    SourceIo sourceIo { source, 0 };
+    AVIOContext* ioCtx = nullptr;
+    auto freeIo = [&ioCtx] {
+        if (ioCtx == nullptr)
+            return;
+        av_freep(&ioCtx->buffer);
+        avio_context_free(&ioCtx);
+    };
+    if (source != nullptr) {
+        auto buffer = static_cast<unsigned char*>(av_malloc(SOURCE_IO_BUFFER));
+        ioCtx = buffer != nullptr ? avio_alloc_context(buffer, SOURCE_IO_BUFFER, 0, &sourceIo, readSource, nullptr, seekSource) : nullptr;
+        pFormatCtx = ioCtx != nullptr ? avformat_alloc_context() : nullptr;
+        if (pFormatCtx != nullptr) {
+            pFormatCtx->pb = ioCtx;
+        } else {
+            if (ioCtx == nullptr)
+                av_free(buffer);
+            freeIo();
+        }
+    }
+
+    // bound the probing, some recordings are decoded for seconds otherwise
+    AVDictionary* options = nullptr;
+    auto probeSize = config->getIntOption(CFG_IMPORT_LIBOPTS_FFMPEG_PROBESIZE);
+    if (probeSize > 0)
+        av_dict_set_int(&options, "probesize", probeSize, 0);
+    auto analyzeDuration = config->getIntOption(CFG_IMPORT_LIBOPTS_FFMPEG_ANALYZEDURATION);
+    if (analyzeDuration > 0)
+        av_dict_set_int(&options, "analyzeduration", int64_t(analyzeDuration) * 1000, 0);
+
     // Open video file
-    if (avformat_open_input(&pFormatCtx,
-            item->getLocation().c_str(), nullptr, nullptr)
-        != 0)
+    int openResult = avformat_open_input(&pFormatCtx, item->getLocation().c_str(), nullptr, &options);
+    av_dict_free(&options);
+    if (openResult != 0) {
+        // the format context is freed on failure, the io context is not
+        freeIo();
         return; // Couldn't open file
+    }
 
-    // Retrieve stream information
-    if (avformat_find_stream_info(pFormatCtx, nullptr) < 0) {
+    if (config->getBoolOption(CFG_IMPORT_LIBOPTS_FFMPEG_HEADER_ONLY) && isHeaderComplete(pFormatCtx)) {
+        log_debug("Using the {} header of {}", pFormatCtx->iformat->name, item->getLocation().c_str());
+        // find_stream_info would compute it from the streams
+        std::error_code ec;
+        auto fileSize = fs::file_size(item->getLocation(), ec);
+        if (pFormatCtx->bit_rate <= 0 && !ec)
+            pFormatCtx->bit_rate = int64_t(fileSize) * 8 * AV_TIME_BASE / pFormatCtx->duration;
+    } else if (avformat_find_stream_info(pFormatCtx, nullptr) < 0) {
+        // Retrieve stream information
         avformat_close_input(&pFormatCtx);
+        freeIo();
         return; // Couldn't find stream information
     }
     // Add metadata using ffmpeg library calls
@@ -306,6 +424,7 @@ void FfmpegHandler::fillMetadata(std::shared_ptr<CdsObject> obj)
 
     // Close the video file
     avformat_close_input(&pFormatCtx);
+    freeIo();
 }
 
 #ifdef HAVE_FFMPEGTHUMBNAILER
@@ -329,23 +448,16 @@ fs::path getThumbnailCachePath(const fs::path& base, const fs::path& movie)
     return path;
 }
 
-std::optional<std::vector<std::byte>> FfmpegHandler::readThumbnailCacheFile(const fs::path& movie_filename) const
-{
-    auto path = getThumbnailCachePath(getThumbnailCacheBasePath(*config), movie_filename);
-    return readBinaryFile(path);
-}
-
-void FfmpegHandler::writeThumbnailCacheFile(const fs::path& movie_filename, const std::byte* data, std::size_t size) const
+std::optional<std::vector<std::byte>> FfmpegHandler::takeLegacyThumbnail(Config& config, const fs::path& movie_filename)
 {
-    try {
-        auto path = getThumbnailCachePath(getThumbnailCacheBasePath(*config), movie_filename);
-        fs::create_directories(path.parent_path());
-        writeBinaryFile(path, data, size);
-    } catch (const std::runtime_error& e) {
-        log_error("Failed to write thumbnail cache: {}", e.what());
+    auto path = getThumbnailCachePath(getThumbnailCacheBasePath(config), movie_filename);
+    auto data = readBinaryFile(path);
+    if (data) {
+        std::error_code ec;
+        fs::remove(path, ec);
     }
+    return data;
 }
-#endif
 
 namespace {
 template <auto C, auto D>
@@ -356,27 +468,15 @@ inline auto wrap_unique_ptr()
 }
 } // namespace
 
-std::unique_ptr<IOHandler> FfmpegHandler::serveContent(std::shared_ptr<CdsObject> obj, int resNum)
+std::vector<std::byte> FfmpegHandler::generateThumbnail(Config& config, const fs::path& location)
 {
-    auto item = std::dynamic_pointer_cast<CdsItem>(obj);
-    if (item == nullptr)
-        return nullptr;
-
-#ifdef HAVE_FFMPEGTHUMBNAILER
-    if (!config->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_ENABLED))
-        return nullptr;
-
-    const auto cache_enabled = config->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED);
-
-    if (cache_enabled) {
-        if (auto data = readThumbnailCacheFile(item->getLocation())) {
-            log_debug("Returning cached thumbnail for file: {}", item->getLocation().c_str());
-            return std::make_unique<MemIOHandler>(data->data(), data->size());
+    if (config.getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED)) {
+        if (auto data = takeLegacyThumbnail(config, location)) {
+            log_debug("Moving thumbnail of {} into the cache", location.c_str());
+            return std::move(*data);
         }
     }
 
-    std::scoped_lock thumb_lock { thumb_mutex };
-
 #ifdef FFMPEGTHUMBNAILER_OLD_API
     auto th = wrap_unique_ptr<create_thumbnailer, destroy_thumbnailer>();
     auto img = wrap_unique_ptr<create_image_data, destroy_image_data>();
@@ -385,33 +485,46 @@ std::unique_ptr<IOHandler> FfmpegHandler::serveContent(std::shared_ptr<CdsObject
     auto img = wrap_unique_ptr<video_thumbnailer_create_image_data, video_thumbnailer_destroy_image_data>();
 #endif // old api
 
-    th->seek_percentage = config->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_SEEK_PERCENTAGE);
-    th->overlay_film_strip = config->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_FILMSTRIP_OVERLAY);
+    th->seek_percentage = config.getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_SEEK_PERCENTAGE);
+    th->overlay_film_strip = config.getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_FILMSTRIP_OVERLAY);
 
 #ifndef HAVE_FFMPEGTHUMBNAILER_SIZE_API
-    th->thumbnail_size = config->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THUMBSIZE);
+    th->thumbnail_size = config.getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THUMBSIZE);
 #else
-    video_thumbnailer_set_size(th.get(), config->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THUMBSIZE), config->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THUMBSIZE));
+    video_thumbnailer_set_size(th.get(), config.getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THUMBSIZE), config.getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THUMBSIZE));
 #endif // old api
-    th->thumbnail_image_quality = config->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_IMAGE_QUALITY);
+    th->thumbnail_image_quality = config.getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_IMAGE_QUALITY);
     th->thumbnail_image_type = Jpeg;
 
-    log_debug("Generating thumbnail for file: {}", item->getLocation().c_str());
-
 #ifdef FFMPEGTHUMBNAILER_OLD_API
-    if (generate_thumbnail_to_buffer(th.get(), item->getLocation().c_str(), img.get()) != 0)
+    if (generate_thumbnail_to_buffer(th.get(), location.c_str(), img.get()) != 0)
 #else
-    if (video_thumbnailer_generate_thumbnail_to_buffer(th.get(), item->getLocation().c_str(), img.get()) != 0)
+    if (video_thumbnailer_generate_thumbnail_to_buffer(th.get(), location.c_str(), img.get()) != 0)
 #endif // old api
     {
-        throw_std_runtime_error("Could not generate thumbnail for {}", item->getLocation().c_str());
-    }
-    if (cache_enabled) {
-        writeThumbnailCacheFile(item->getLocation(),
-            reinterpret_cast<std::byte*>(img->image_data_ptr), img->image_data_size);
+        throw_std_runtime_error("Could not generate thumbnail for {}", location.c_str());
     }
 
-    return std::make_unique<MemIOHandler>(reinterpret_cast<void*>(img->image_data_ptr), img->image_data_size);
+    auto data = reinterpret_cast<const std::byte*>(img->image_data_ptr);
+    return std::vector<std::byte>(data, data + img->image_data_size);
+}
+#endif
+
+std::unique_ptr<IOHandler> FfmpegHandler::serveContent(std::shared_ptr<CdsObject> obj, int resNum)
+{
+    auto item = std::dynamic_pointer_cast<CdsItem>(obj);
+    if (item == nullptr)
+        return nullptr;
+
+#ifdef HAVE_FFMPEGTHUMBNAILER
+    if (!config->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_ENABLED))
+        return nullptr;
+
+    // clients asking for the same file wait for one generation
+    auto thumbnail = thumbnailService ? thumbnailService->get(item->getLocation(), item->getMTime(), item->getSizeOnDisk())
+                                      : std::make_shared<const std::vector<std::byte>>(generateThumbnail(*config, item->getLocation()));
+    auto buffer = std::shared_ptr<const char>(thumbnail, reinterpret_cast<const char*>(thumbnail->data()));
+    return std::make_unique<MemIOHandler>(buffer, thumbnail->size());
 #else
     return nullptr;
 #endif
@@ -46,6 +46,7 @@ namespace fs = std::filesystem;
 
 // forward declaration
 class AVFormatContext;
+class ThumbnailService;
 
 /// \brief This class is responsible for reading id3 tags metadata
 class FfmpegHandler : public MetadataHandler {
@@ -55,19 +56,25 @@ public:
     std::unique_ptr<IOHandler> serveContent(std::shared_ptr<CdsObject> obj, int resNum) override;
     std::string getMimeType() override;
 
+#ifdef HAVE_FFMPEGTHUMBNAILER
+    /// \brief run ffmpegthumbnailer on location, a thumbnail of older versions is taken over instead
+    static std::vector<std::byte> generateThumbnail(Config& config, const fs::path& location);
+#endif
+
 private:
-    // The ffmpegthumbnailer code (ffmpeg?) is not threading safe.
-    // Add a lock around the usage to avoid crashing randomly.
-    std::mutex thumb_mutex;
+#ifdef HAVE_FFMPEGTHUMBNAILER
+    std::shared_ptr<ThumbnailService> thumbnailService;
+#endif
 
     void addFfmpegAuxdataFields(const std::shared_ptr<CdsItem>& item, AVFormatContext* pFormatCtx) const;
     void addFfmpegMetadataFields(const std::shared_ptr<CdsItem>& item, AVFormatContext* pFormatCtx) const;
     void addFfmpegResourceFields(const std::shared_ptr<CdsItem>& item, AVFormatContext* pFormatCtx) const;
-    std::optional<std::vector<std::byte>> readThumbnailCacheFile(const fs::path& movie_filename) const;
-    void writeThumbnailCacheFile(const fs::path& movie_filename, const std::byte* data, std::size_t size) const;
+    /// \brief read and remove the thumbnail stored next to the mirrored path of older versions
+    static std::optional<std::vector<std::byte>> takeLegacyThumbnail(Config& config, const fs::path& movie_filename);
 };
 
 fs::path getThumbnailCacheBasePath(Config& config);
+/// \brief path of a thumbnail in the layout of older versions, which mirrored the media tree
 fs::path getThumbnailCachePath(const fs::path& base, const fs::path& movie);
 
 #endif //__FFMPEG_HANDLER_H__
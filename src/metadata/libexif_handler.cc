@@ -33,10 +33,12 @@
 #include "libexif_handler.h" // API
 
 #include <iohandler/file_io_handler.h>
+#include <limits>
 
 #include "cds_objects.h"
 #include "config/config_manager.h"
 #include "iohandler/mem_io_handler.h"
+#include "metadata/metadata_source.h"
 #include "util/string_converter.h"
 #include "util/tools.h"
 
@@ -358,11 +360,27 @@ void LibExifHandler::fillMetadata(std::shared_ptr<CdsObject> obj)
     if (item == nullptr)
         return;
 
-    ExifData* ed;
+    ExifData* ed = nullptr;
 
     auto sc = StringConverter::m2i(CFG_IMPORT_LIBOPTS_EXIF_CHARSET, item->getLocation(), config);
 
-    ed = exif_data_new_from_file(item->getLocation().c_str());
+    // the exif segment is near the start, libexif only gets the whole file if it is not found there
+    auto headerSize = off_t(config->getIntOption(CFG_IMPORT_LIBOPTS_IMAGE_HEADER_SIZE)) * 1024;
+    if (source != nullptr && headerSize > 0 && source->getSize() > headerSize) {
+        auto header = source->readHead(headerSize);
+        ed = exif_data_new_from_data(reinterpret_cast<const unsigned char*>(header.data()), header.size());
+        if (!ed)
+            log_debug("No exif data in the first {} bytes of {}", header.size(), item->getLocation().c_str());
+    }
+
+    if (!ed) {
+        // the jpeg segments are searched in the mapping of the shared source
+        auto data = source != nullptr ? source->map() : nullptr;
+        if (data != nullptr && source->getSize() <= std::numeric_limits<unsigned int>::max())
+            ed = exif_data_new_from_data(reinterpret_cast<const unsigned char*>(data), source->getSize());
+        else
+            ed = exif_data_new_from_file(item->getLocation().c_str());
+    }
 
     if (!ed) {
         log_debug("Exif data not found, attempting to set resolution internally...");
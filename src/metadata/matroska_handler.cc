@@ -39,12 +39,14 @@
 #include <matroska/KaxAttachments.h>
 #include <matroska/KaxCluster.h>
 #include <matroska/KaxContexts.h>
+#include <matroska/KaxInfo.h>
 #include <matroska/KaxSeekHead.h>
 #include <matroska/KaxSegment.h>
 
 #include "cds_objects.h"
 #include "config/config_manager.h"
 #include "iohandler/mem_io_handler.h"
+#include "metadata/metadata_source.h"
 #include "util/mime.h"
 #include "util/string_converter.h"
 #include "util/tools.h"
@@ -117,6 +119,49 @@ public:
     }
 };
 
+// read through the file shared by the metadata handlers
+class source_io_callback : public IOCallback {
+private:
+    MetadataSource* source;
+    uint64 position { 0 };
+
+public:
+    explicit source_io_callback(MetadataSource* source)
+        : source(source)
+    {
+    }
+
+    uint32 read(void* buffer, size_t size) override
+    {
+        if (size == 0)
+            return 0;
+        auto bytes = source->read(position, buffer, size);
+        if (bytes <= 0)
+            return 0;
+        position += bytes;
+        return bytes;
+    }
+
+    void setFilePointer(int64_t offset, seek_mode mode = seek_beginning) override
+    {
+        assert(mode == SEEK_CUR || mode == SEEK_END || mode == SEEK_SET);
+        int64_t base = mode == SEEK_CUR ? position : (mode == SEEK_END ? source->getSize() : 0);
+        if (base + offset < 0)
+            throw_std_runtime_error("seek before the start of {}", source->getPath().c_str());
+        position = base + offset;
+    }
+
+    size_t write(const void* p_buffer, size_t i_size) override
+    {
+        // not needed
+        return 0;
+    }
+
+    uint64 getFilePointer() override { return position; }
+
+    void close() override { }
+};
+
 MatroskaHandler::MatroskaHandler(const std::shared_ptr<Context>& context)
     : MetadataHandler(context)
 {
@@ -145,34 +190,87 @@ std::unique_ptr<IOHandler> MatroskaHandler::serveContent(std::shared_ptr<CdsObje
     return h;
 }
 
+/// \brief bytes of a segment that are searched for Info and Attachments in front of the first cluster
+/// if the SeekHead does not point to them
+static constexpr uint64 MKV_SCAN_LIMIT = 4 * 1024 * 1024;
+
 void MatroskaHandler::parseMKV(const std::shared_ptr<CdsItem>& item, MemIOHandler** p_io_handler) const
 {
-    file_io_callback ebml_file(item->getLocation().c_str());
-    EbmlStream ebml_stream(ebml_file);
+    std::unique_ptr<IOCallback> ebml_file;
+    if (source != nullptr)
+        ebml_file = std::make_unique<source_io_callback>(source);
+    else
+        ebml_file = std::make_unique<file_io_callback>(item->getLocation().c_str());
+    EbmlStream ebml_stream(*ebml_file);
 
-    auto el_l0 = ebml_stream.FindNextID(LIBMATROSKA_NAMESPACE::KaxSegment::ClassInfos, ~0);
-    while (el_l0 != nullptr) {
-        int i_upper_level = 0;
-        auto el_l1 = ebml_stream.FindNextElement(el_l0->Generic().Context, i_upper_level, ~0, true);
-        while (el_l1 != nullptr) {
-            parseLevel1Element(item, ebml_stream, el_l1, p_io_handler);
+    // serveContent only needs the cover
+    bool wantInfo = p_io_handler == nullptr;
+    bool wantAttachments = p_io_handler != nullptr || config->getBoolOption(CFG_IMPORT_LIBOPTS_MKV_COVER_ART);
 
-            el_l1->SkipData(ebml_stream, el_l1->Generic().Context);
-            delete el_l1;
+    auto el_l0 = ebml_stream.FindNextID(LIBMATROSKA_NAMESPACE::KaxSegment::ClassInfos, ~0);
+    auto segment = dynamic_cast<LIBMATROSKA_NAMESPACE::KaxSegment*>(el_l0);
+    if (segment == nullptr) {
+        delete el_l0;
+        ebml_file->close();
+        return;
+    }
 
-            el_l1 = ebml_stream.FindNextElement(el_l0->Generic().Context, i_upper_level, ~0, true);
-        } // while elementLevel1
+    uint64 infoPosition = 0;
+    uint64 attachmentsPosition = 0;
+    auto scanEnd = segment->GetGlobalPosition(MKV_SCAN_LIMIT);
 
-        el_l0->SkipData(ebml_stream, LIBMATROSKA_NAMESPACE::KaxSegment_Context);
-        delete el_l0;
+    int i_upper_level = 0;
+    auto el_l1 = ebml_stream.FindNextElement(segment->Generic().Context, i_upper_level, ~0, true);
+    while (el_l1 != nullptr && (wantInfo || wantAttachments)) {
+        // the clusters with the media data follow, do not walk through them
+        if (EbmlId(*el_l1) == LIBMATROSKA_NAMESPACE::KaxCluster::ClassInfos.GlobalId || el_l1->GetElementPosition() > scanEnd) {
+            delete el_l1;
+            el_l1 = nullptr;
+            break;
+        }
 
-        el_l0 = ebml_stream.FindNextElement(LIBMATROSKA_NAMESPACE::KaxSegment_Context, i_upper_level, ~0, true);
-    } // while elementLevel0
+        auto seekHead = dynamic_cast<LIBMATROSKA_NAMESPACE::KaxSeekHead*>(el_l1);
+        if (seekHead != nullptr) {
+            EbmlElement* dummy_el;
+            int i_seek_level = 0;
+            seekHead->Read(ebml_stream, EBML_CONTEXT(seekHead), i_seek_level, dummy_el, true);
+            auto info = seekHead->FindFirstOf(LIBMATROSKA_NAMESPACE::KaxInfo::ClassInfos);
+            if (info != nullptr && infoPosition == 0)
+                infoPosition = segment->GetGlobalPosition(info->Location());
+            auto attachments = seekHead->FindFirstOf(LIBMATROSKA_NAMESPACE::KaxAttachments::ClassInfos);
+            if (attachments != nullptr && attachmentsPosition == 0)
+                attachmentsPosition = segment->GetGlobalPosition(attachments->Location());
+        } else {
+            parseLevel1Element(item, ebml_stream, el_l1, p_io_handler, wantInfo, wantAttachments);
+        }
 
-    ebml_file.close();
+        el_l1->SkipData(ebml_stream, el_l1->Generic().Context);
+        delete el_l1;
+
+        el_l1 = ebml_stream.FindNextElement(segment->Generic().Context, i_upper_level, ~0, true);
+    } // while elementLevel1
+    delete el_l1;
+
+    // jump to the elements behind the clusters
+    auto parseAt = [&](uint64 position) {
+        ebml_file->setFilePointer(position);
+        int i_seek_level = 0;
+        auto element = ebml_stream.FindNextElement(segment->Generic().Context, i_seek_level, ~0, true);
+        if (element != nullptr) {
+            parseLevel1Element(item, ebml_stream, element, p_io_handler, wantInfo, wantAttachments);
+            delete element;
+        }
+    };
+    if (wantInfo && infoPosition > 0)
+        parseAt(infoPosition);
+    if (wantAttachments && attachmentsPosition > 0)
+        parseAt(attachmentsPosition);
+
+    delete segment;
+    ebml_file->close();
 }
 
-void MatroskaHandler::parseLevel1Element(const std::shared_ptr<CdsItem>& item, EbmlStream& ebml_stream, EbmlElement* el_l1, MemIOHandler** p_io_handler) const
+void MatroskaHandler::parseLevel1Element(const std::shared_ptr<CdsItem>& item, EbmlStream& ebml_stream, EbmlElement* el_l1, MemIOHandler** p_io_handler, bool& wantInfo, bool& wantAttachments) const
 {
     // Looking at just at EbmlId is not reliable since it can be a dummy element.
     if (!el_l1->IsMaster())
@@ -182,10 +280,12 @@ void MatroskaHandler::parseLevel1Element(const std::shared_ptr<CdsItem>& item, E
         log_debug("dynamic_cast unexpectedly returned nullptr, seems to be broken");
         return;
     }
-    if (EbmlId(*master) == LIBMATROSKA_NAMESPACE::KaxInfo::ClassInfos.GlobalId) {
+    if (EbmlId(*master) == LIBMATROSKA_NAMESPACE::KaxInfo::ClassInfos.GlobalId && wantInfo) {
         parseInfo(item, ebml_stream, master);
-    } else if (EbmlId(*master) == LIBMATROSKA_NAMESPACE::KaxAttachments::ClassInfos.GlobalId) {
+        wantInfo = false;
+    } else if (EbmlId(*master) == LIBMATROSKA_NAMESPACE::KaxAttachments::ClassInfos.GlobalId && wantAttachments) {
         parseAttachments(item, ebml_stream, master, p_io_handler);
+        wantAttachments = false;
     }
 }
 
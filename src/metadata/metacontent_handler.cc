@@ -31,6 +31,7 @@
 #include "config/config.h"
 #include "config/directory_tweak.h"
 #include "iohandler/file_io_handler.h"
+#include "metadata/directory_index.h"
 #include "util/mime.h"
 #include "util/tools.h"
 
@@ -39,13 +40,24 @@ MetacontentHandler::MetacontentHandler(const std::shared_ptr<Context>& context)
 {
 }
 
-fs::path MetacontentHandler::getContentPath(const std::vector<std::string>& names, const std::shared_ptr<CdsObject>& obj, bool isCaseSensitive, fs::path folder)
+fs::path MetacontentHandler::getContentPath(const std::vector<std::string>& names, const std::shared_ptr<CdsObject>& obj, bool isCaseSensitive, fs::path folder) const
 {
     if (!names.empty()) {
         if (folder.empty())
             folder = obj->getLocation().parent_path();
         log_debug("Folder name: {}", folder.c_str());
 
+        if (directories != nullptr) {
+            std::vector<std::string> fileNames;
+            fileNames.reserve(names.size());
+            for (const auto& name : names)
+                fileNames.push_back(expandName(name, obj));
+            auto found = directories->find(folder, fileNames, isCaseSensitive);
+            if (!found.empty())
+                log_debug("{}: found", found.c_str());
+            return found;
+        }
+
         if (isCaseSensitive) {
             for (const auto& name : names) {
                 auto found = folder / expandName(name, obj);
@@ -86,6 +98,7 @@ static constexpr std::array<std::pair<std::string_view, metadata_fields_t>, 5> m
     { "%title%", M_TITLE },
 } };
 bool MetacontentHandler::caseSensitive = true;
+std::mutex MetacontentHandler::initMutex;
 
 std::string MetacontentHandler::expandName(const std::string& name, const std::shared_ptr<CdsObject>& obj)
 {
@@ -119,6 +132,7 @@ bool FanArtHandler::initDone = false;
 FanArtHandler::FanArtHandler(const std::shared_ptr<Context>& context)
     : MetacontentHandler(context)
 {
+    std::lock_guard<std::mutex> lock(initMutex);
     if (!initDone) {
         std::vector<std::string> files = this->config->getArrayOption(CFG_IMPORT_RESOURCES_FANART_FILE_LIST);
         names.insert(names.end(), files.begin(), files.end());
@@ -179,6 +193,7 @@ bool ContainerArtHandler::initDone = false;
 ContainerArtHandler::ContainerArtHandler(const std::shared_ptr<Context>& context)
     : MetacontentHandler(context)
 {
+    std::lock_guard<std::mutex> lock(initMutex);
     if (!initDone) {
         std::vector<std::string> files = this->config->getArrayOption(CFG_IMPORT_RESOURCES_CONTAINERART_FILE_LIST);
         names.insert(names.end(), files.begin(), files.end());
@@ -236,6 +251,7 @@ bool SubtitleHandler::initDone = false;
 SubtitleHandler::SubtitleHandler(const std::shared_ptr<Context>& context)
     : MetacontentHandler(context)
 {
+    std::lock_guard<std::mutex> lock(initMutex);
     if (!initDone) {
         std::vector<std::string> files = this->config->getArrayOption(CFG_IMPORT_RESOURCES_SUBTITLE_FILE_LIST);
         names.insert(names.end(), files.begin(), files.end());
@@ -297,6 +313,7 @@ bool ResourceHandler::initDone = false;
 ResourceHandler::ResourceHandler(const std::shared_ptr<Context>& context)
     : MetacontentHandler(context)
 {
+    std::lock_guard<std::mutex> lock(initMutex);
     if (!initDone) {
         std::vector<std::string> files = this->config->getArrayOption(CFG_IMPORT_RESOURCES_RESOURCE_FILE_LIST);
         names.insert(names.end(), files.begin(), files.end());
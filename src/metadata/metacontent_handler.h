@@ -28,18 +28,30 @@
 #define __METADATA_CONTENT_H__
 
 #include <filesystem>
+#include <mutex>
 namespace fs = std::filesystem;
 
 #include "metadata_handler.h"
 
+// forward declaration
+class DirectoryIndex;
+
 /// \brief This class is responsible for populating filesystem based metadata
 class MetacontentHandler : public MetadataHandler {
 public:
     explicit MetacontentHandler(const std::shared_ptr<Context>& context);
     static bool caseSensitive;
 
+    /// \brief look up the candidate files in directories instead of the filesystem
+    void setDirectoryIndex(DirectoryIndex* directories) { this->directories = directories; }
+
 protected:
-    static fs::path getContentPath(const std::vector<std::string>& names, const std::shared_ptr<CdsObject>& obj, bool isCaseSensitive, fs::path folder = "");
+    /// \brief guards the lazy init of the name lists, handlers are created by all import threads
+    static std::mutex initMutex;
+
+    DirectoryIndex* directories { nullptr };
+
+    fs::path getContentPath(const std::vector<std::string>& names, const std::shared_ptr<CdsObject>& obj, bool isCaseSensitive, fs::path folder = "") const;
     static std::string expandName(const std::string& name, const std::shared_ptr<CdsObject>& obj);
 };
 
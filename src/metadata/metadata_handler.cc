@@ -31,16 +31,18 @@
 
 #include "metadata_handler.h" // API
 
+#include <cstring>
 #include <filesystem>
 
 #include "cds_objects.h"
 #include "config/config_manager.h"
+#include "content/import_statistics.h"
+#include "metadata/duplicate_index.h"
+#include "metadata/metadata_registry.h"
+#include "metadata/metadata_source.h"
+#include "transcoding/pretranscode_queue.h"
 #include "util/tools.h"
 
-#ifdef HAVE_EXIV2
-#include "metadata/exiv2_handler.h"
-#endif
-
 #ifdef HAVE_TAGLIB
 #include "metadata/taglib_handler.h"
 #endif // HAVE_TAGLIB
@@ -65,57 +67,55 @@ MetadataHandler::MetadataHandler(const std::shared_ptr<Context>& context)
 {
 }
 
-void MetadataHandler::setMetadata(const std::shared_ptr<Context>& context, const std::shared_ptr<CdsItem>& item, const fs::directory_entry& dirEnt)
+std::shared_ptr<CdsResource> MetadataHandler::createDefaultResource(const std::string& mimetype, off_t filesize)
 {
-    std::error_code ec;
-    if (!isRegularFile(dirEnt, ec))
-        throw_std_runtime_error("Not a file: {}", dirEnt.path().c_str());
-    auto filesize = getFileSize(dirEnt);
-
-    std::string mimetype = item->getMimeType();
-
     auto resource = std::make_shared<CdsResource>(CH_DEFAULT);
     resource->addAttribute(R_PROTOCOLINFO, renderProtocolInfo(mimetype));
     resource->addAttribute(R_SIZE, fmt::to_string(filesize));
+    return resource;
+}
+
+void MetadataHandler::extractMetadata(const std::shared_ptr<Context>& context, const std::shared_ptr<CdsItem>& item, const fs::directory_entry& dirEnt, off_t filesize)
+{
+    std::string mimetype = item->getMimeType();
+    auto statistics = context->getImportStatistics().get();
 
-    item->addResource(resource);
+    item->addResource(createDefaultResource(mimetype, filesize));
 
     auto mappings = context->getConfig()->getDictionaryOption(CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
     std::string content_type = getValueOrDefault(mappings, mimetype);
 
-    if ((content_type == CONTENT_TYPE_OGG) && (isTheora(item->getLocation()))) {
-        item->setFlag(OBJECT_FLAG_OGG_THEORA);
-    }
-
-#ifdef HAVE_TAGLIB
-    if ((content_type == CONTENT_TYPE_MP3) || ((content_type == CONTENT_TYPE_OGG) && (!item->getFlag(OBJECT_FLAG_OGG_THEORA))) || (content_type == CONTENT_TYPE_WMA) || (content_type == CONTENT_TYPE_WAVPACK) || (content_type == CONTENT_TYPE_FLAC) || (content_type == CONTENT_TYPE_PCM) || (content_type == CONTENT_TYPE_AIFF) || (content_type == CONTENT_TYPE_APE) || (content_type == CONTENT_TYPE_MP4)) {
-        TagLibHandler(context).fillMetadata(item);
-    }
-#endif // HAVE_TAGLIB
-
-#ifdef HAVE_EXIV2
-    if (content_type == CONTENT_TYPE_JPG) {
-        Exiv2Handler(context).fillMetadata(item);
+    // one open and one read of the start and the end of the file for all handlers
+    std::unique_ptr<MetadataSource> fileSource;
+    try {
+        fileSource = std::make_unique<MetadataSource>(dirEnt.path());
+    } catch (const std::runtime_error& e) {
+        log_debug("{}, the handlers open the file themselves", e.what());
     }
-#endif
+    auto source = fileSource.get();
 
-#ifdef HAVE_LIBEXIF
-    if (content_type == CONTENT_TYPE_JPG) {
-        LibExifHandler(context).fillMetadata(item);
+    if (content_type == CONTENT_TYPE_OGG) {
+        bool theora;
+        if (source != nullptr) {
+            char buffer[7];
+            theora = source->read(0, buffer, 4) == 4 && memcmp(buffer, "OggS", 4) == 0
+                && source->read(28, buffer, 7) == 7 && memcmp(buffer, "\x80theora", 7) == 0;
+        } else {
+            theora = isTheora(item->getLocation());
+        }
+        if (theora)
+            item->setFlag(OBJECT_FLAG_OGG_THEORA);
     }
-#endif // HAVE_LIBEXIF
 
-#ifdef HAVE_MATROSKA
-    if (content_type == CONTENT_TYPE_MKV) {
-        MatroskaHandler(context).fillMetadata(item);
+    auto registry = context->getMetadataRegistry();
+    if (registry == nullptr)
+        registry = std::make_shared<MetadataRegistry>(context->getConfig());
+    for (auto&& extractor : registry->getExtractors(content_type, item)) {
+        ImportStatistics::StageTimer stageTimer(statistics, extractor->stage);
+        extractor->extract(context, item, source);
     }
-#endif
 
-#ifdef HAVE_FFMPEG
-    if (content_type != CONTENT_TYPE_PLAYLIST && ((content_type == CONTENT_TYPE_OGG && item->getFlag(OBJECT_FLAG_OGG_THEORA)) || startswith(item->getMimeType(), "video") || startswith(item->getMimeType(), "audio"))) {
-        FfmpegHandler(context).fillMetadata(item);
-    }
-#else
+#ifndef HAVE_FFMPEG
     if (content_type == CONTENT_TYPE_AVI) {
         std::string fourcc = getAVIFourCC(dirEnt.path().string());
         if (!fourcc.empty()) {
@@ -124,16 +124,60 @@ void MetadataHandler::setMetadata(const std::shared_ptr<Context>& context, const
         }
     }
 #endif // HAVE_FFMPEG
+}
+
+void MetadataHandler::setMetadata(const std::shared_ptr<Context>& context, const std::shared_ptr<CdsItem>& item, const fs::directory_entry& dirEnt, DuplicateIndex* duplicates, DirectoryIndex* directories)
+{
+    std::error_code ec;
+    if (!isRegularFile(dirEnt, ec))
+        throw_std_runtime_error("Not a file: {}", dirEnt.path().c_str());
+    auto filesize = getFileSize(dirEnt);
 
+    std::string mimetype = item->getMimeType();
+
+    DuplicateIndex::FileIdentity identity;
+    if (duplicates != nullptr && !DuplicateIndex::identify(dirEnt.path(), identity))
+        duplicates = nullptr;
+    auto original = duplicates != nullptr ? duplicates->find(dirEnt.path(), identity, mimetype) : nullptr;
+    if (original != nullptr) {
+        DuplicateIndex::copyMetadata(original, item);
+    } else {
+        extractMetadata(context, item, dirEnt, filesize);
+        if (duplicates != nullptr)
+            duplicates->add(dirEnt.path(), identity, item);
+    }
+
+    auto statistics = context->getImportStatistics().get();
     // Fanart for audio and video
-    if (startswith(mimetype, "video") || startswith(mimetype, "audio"))
-        FanArtHandler(context).fillMetadata(item);
+    if (startswith(mimetype, "video") || startswith(mimetype, "audio")) {
+        ImportStatistics::StageTimer stageTimer(statistics, ImportStatistics::Stage::FanArt);
+        FanArtHandler handler(context);
+        handler.setDirectoryIndex(directories);
+        handler.fillMetadata(item);
+    }
 
     // Subtitles for videos
-    if (startswith(mimetype, "video"))
-        SubtitleHandler(context).fillMetadata(item);
+    if (startswith(mimetype, "video")) {
+        ImportStatistics::StageTimer stageTimer(statistics, ImportStatistics::Stage::Subtitle);
+        SubtitleHandler handler(context);
+        handler.setDirectoryIndex(directories);
+        handler.fillMetadata(item);
+    }
 
-    ResourceHandler(context).fillMetadata(item);
+    ImportStatistics::StageTimer stageTimer(statistics, ImportStatistics::Stage::Resources);
+    ResourceHandler handler(context);
+    handler.setDirectoryIndex(directories);
+    handler.fillMetadata(item);
+}
+
+void MetadataHandler::setBasicMetadata(const std::shared_ptr<CdsItem>& item, const fs::directory_entry& dirEnt)
+{
+    std::error_code ec;
+    if (!isRegularFile(dirEnt, ec))
+        throw_std_runtime_error("Not a file: {}", dirEnt.path().c_str());
+
+    item->addResource(createDefaultResource(item->getMimeType(), getFileSize(dirEnt)));
+    item->setFlag(OBJECT_FLAG_PENDING_METADATA);
 }
 
 std::string MetadataHandler::getMetaFieldName(metadata_fields_t field)
@@ -183,6 +227,8 @@ std::unique_ptr<MetadataHandler> MetadataHandler::createHandler(const std::share
         return std::make_unique<SubtitleHandler>(context);
     case CH_RESOURCE:
         return std::make_unique<ResourceHandler>(context);
+    case CH_TRANSCODE:
+        return std::make_unique<PretranscodedHandler>(context);
     default:
         throw_std_runtime_error("Unknown content handler ID: {}", handlerType);
     }
@@ -42,7 +42,11 @@ namespace fs = std::filesystem;
 // forward declaration
 class CdsItem;
 class CdsObject;
+class CdsResource;
+class DirectoryIndex;
+class DuplicateIndex;
 class IOHandler;
+class MetadataSource;
 
 // content handler Id's
 #define CH_DEFAULT 0
@@ -183,17 +187,28 @@ class MetadataHandler {
 protected:
     std::shared_ptr<Config> config;
     std::shared_ptr<Mime> mime;
+    /// \brief the file opened once for all handlers of the item, nullptr to open it by path
+    MetadataSource* source { nullptr };
 
 public:
     /// \brief Definition of the supported metadata fields.
 
     explicit MetadataHandler(const std::shared_ptr<Context>& context);
 
-    static void setMetadata(const std::shared_ptr<Context>& context, const std::shared_ptr<CdsItem>& item, const fs::directory_entry& dirEnt);
+    /// \brief read the metadata of the file and look for fanart, subtitles and resources next to it
+    /// \param duplicates copies the content metadata of an identical file instead of parsing it, if given
+    /// \param directories looks up the files next to the item in the listing of its directory, if given
+    static void setMetadata(const std::shared_ptr<Context>& context, const std::shared_ptr<CdsItem>& item, const fs::directory_entry& dirEnt,
+        DuplicateIndex* duplicates = nullptr, DirectoryIndex* directories = nullptr);
+    /// \brief only add the resource of the file and mark the item for setMetadata() later on
+    static void setBasicMetadata(const std::shared_ptr<CdsItem>& item, const fs::directory_entry& dirEnt);
     static std::string getMetaFieldName(metadata_fields_t field);
     static std::string getResAttrName(resource_attributes_t attr);
     static std::unique_ptr<MetadataHandler> createHandler(const std::shared_ptr<Context>& context, int handlerType);
 
+    /// \brief read the file of the next fillMetadata() from source instead of opening it again
+    void setSource(MetadataSource* source) { this->source = source; }
+
     virtual void fillMetadata(std::shared_ptr<CdsObject> obj) = 0;
     virtual std::unique_ptr<IOHandler> serveContent(std::shared_ptr<CdsObject> obj, int resNum) = 0;
     virtual std::string getMimeType();
@@ -201,6 +216,11 @@ public:
     static const char* mapContentHandler2String(int ch);
 
     virtual ~MetadataHandler() = default;
+
+private:
+    static std::shared_ptr<CdsResource> createDefaultResource(const std::string& mimetype, off_t filesize);
+    /// \brief the part of setMetadata() that parses the file content
+    static void extractMetadata(const std::shared_ptr<Context>& context, const std::shared_ptr<CdsItem>& item, const fs::directory_entry& dirEnt, off_t filesize);
 };
 
 #endif // __METADATA_HANDLER_H__
@@ -0,0 +1,146 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    metadata_registry.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file metadata_registry.cc
+
+#include "metadata_registry.h" // API
+
+#include <algorithm>
+
+#include "cds_objects.h"
+#include "config/config.h"
+#include "metadata/metadata_handler.h"
+#include "util/tools.h"
+
+#ifdef HAVE_EXIV2
+#include "metadata/exiv2_handler.h"
+#endif
+
+#ifdef HAVE_TAGLIB
+#include "metadata/taglib_handler.h"
+#endif // HAVE_TAGLIB
+
+#ifdef HAVE_FFMPEG
+#include "metadata/ffmpeg_handler.h"
+#endif
+
+#ifdef HAVE_LIBEXIF
+#include "metadata/libexif_handler.h"
+#endif
+
+#ifdef HAVE_MATROSKA
+#include "metadata/matroska_handler.h"
+#endif
+
+/// \brief run the handler on item with the shared source
+template <class Handler>
+[[maybe_unused]] static void runHandler(const std::shared_ptr<Context>& context, const std::shared_ptr<CdsItem>& item, MetadataSource* source)
+{
+    Handler handler(context);
+    handler.setSource(source);
+    handler.fillMetadata(item);
+}
+
+MetadataRegistry::MetadataRegistry(const std::shared_ptr<Config>& config)
+{
+#ifdef HAVE_TAGLIB
+    add({ "taglib", ImportStatistics::Stage::TagLib,
+        [](const std::string& contentType, const std::shared_ptr<CdsItem>& item) {
+            return contentType == CONTENT_TYPE_MP3 || (contentType == CONTENT_TYPE_OGG && !item->getFlag(OBJECT_FLAG_OGG_THEORA)) || contentType == CONTENT_TYPE_WMA //
+                || contentType == CONTENT_TYPE_WAVPACK || contentType == CONTENT_TYPE_FLAC || contentType == CONTENT_TYPE_PCM //
+                || contentType == CONTENT_TYPE_AIFF || contentType == CONTENT_TYPE_APE || contentType == CONTENT_TYPE_MP4;
+        },
+        runHandler<TagLibHandler> });
+#endif // HAVE_TAGLIB
+
+#ifdef HAVE_EXIV2
+    add({ "exiv2", ImportStatistics::Stage::Exiv2,
+        [](const std::string& contentType, const std::shared_ptr<CdsItem>& item) { return contentType == CONTENT_TYPE_JPG; },
+        runHandler<Exiv2Handler> });
+#endif
+
+#ifdef HAVE_LIBEXIF
+    add({ "libexif", ImportStatistics::Stage::LibExif,
+        [](const std::string& contentType, const std::shared_ptr<CdsItem>& item) { return contentType == CONTENT_TYPE_JPG; },
+        runHandler<LibExifHandler> });
+#endif // HAVE_LIBEXIF
+
+#ifdef HAVE_MATROSKA
+    add({ "matroska", ImportStatistics::Stage::Matroska,
+        [](const std::string& contentType, const std::shared_ptr<CdsItem>& item) { return contentType == CONTENT_TYPE_MKV; },
+        runHandler<MatroskaHandler> });
+#endif
+
+#ifdef HAVE_FFMPEG
+    add({ "ffmpeg", ImportStatistics::Stage::Ffmpeg,
+        [](const std::string& contentType, const std::shared_ptr<CdsItem>& item) {
+            return contentType != CONTENT_TYPE_PLAYLIST
+                && ((contentType == CONTENT_TYPE_OGG && item->getFlag(OBJECT_FLAG_OGG_THEORA)) || startswith(item->getMimeType(), "video") || startswith(item->getMimeType(), "audio"));
+        },
+        runHandler<FfmpegHandler> });
+#endif // HAVE_FFMPEG
+
+    for (auto&& [mimeType, names] : config->getDictionaryOption(CFG_IMPORT_LIBOPTS_SKIP_EXTRACTORS)) {
+        for (auto&& name : splitString(names, ',')) {
+            trimStringInPlace(name);
+            if (std::none_of(extractors.begin(), extractors.end(), [&](auto&& extractor) { return extractor->name == name; }))
+                log_warning("Metadata extractor {} to skip for {} is not available", name, mimeType);
+            skipped[mimeType].insert(name);
+        }
+    }
+}
+
+void MetadataRegistry::add(Extractor extractor)
+{
+    AutoLock lock(mutex);
+    extractors.push_back(std::make_shared<const Extractor>(std::move(extractor)));
+    table.clear();
+}
+
+std::vector<std::shared_ptr<const MetadataRegistry::Extractor>> MetadataRegistry::getExtractors(const std::string& contentType, const std::shared_ptr<CdsItem>& item)
+{
+    auto mimeType = item->getMimeType();
+    // nothing else of the item is looked at to select the extractors
+    auto theora = item->getFlag(OBJECT_FLAG_OGG_THEORA) != 0;
+    auto key = fmt::format("{}\n{}\n{}", mimeType, contentType, theora);
+
+    AutoLock lock(mutex);
+    auto entry = table.find(key);
+    if (entry != table.end())
+        return entry->second;
+
+    auto skip = skipped.find(mimeType);
+    std::vector<std::shared_ptr<const Extractor>> result;
+    std::vector<std::string> names;
+    for (auto&& extractor : extractors) {
+        if (skip != skipped.end() && skip->second.find(extractor->name) != skip->second.end())
+            continue;
+        if (extractor->applies(contentType, item)) {
+            result.push_back(extractor);
+            names.push_back(extractor->name);
+        }
+    }
+    log_debug("Metadata extractors for {}: {}", mimeType, fmt::join(names, ", "));
+    table[key] = result;
+    return result;
+}
@@ -0,0 +1,82 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    metadata_registry.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file metadata_registry.h
+#ifndef __METADATA_REGISTRY_H__
+#define __METADATA_REGISTRY_H__
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "content/import_statistics.h"
+
+// forward declaration
+class CdsItem;
+class Config;
+class Context;
+class MetadataSource;
+
+/// \brief The metadata extractors that run on an imported file, in order
+///
+/// The extractors for a mime type are looked up once and kept in a table.
+/// Extractors listed in library-options/skip-extractors for a mime type are left out.
+class MetadataRegistry {
+public:
+    /// \brief whether the extractor handles the item of the content type
+    using Applies = std::function<bool(const std::string& contentType, const std::shared_ptr<CdsItem>& item)>;
+    using Extract = std::function<void(const std::shared_ptr<Context>& context, const std::shared_ptr<CdsItem>& item, MetadataSource* source)>;
+
+    struct Extractor {
+        std::string name;
+        /// \brief the import statistics show the time of each extractor in its stage
+        ImportStatistics::Stage stage;
+        Applies applies;
+        Extract extract;
+    };
+
+    /// \brief register the extractors of the libraries compiled in
+    explicit MetadataRegistry(const std::shared_ptr<Config>& config);
+
+    /// \brief run extractor after the registered ones
+    void add(Extractor extractor);
+
+    /// \brief extractors for the item in the order they run
+    std::vector<std::shared_ptr<const Extractor>> getExtractors(const std::string& contentType, const std::shared_ptr<CdsItem>& item);
+
+protected:
+    std::vector<std::shared_ptr<const Extractor>> extractors;
+    /// \brief extractor names by mime type
+    std::map<std::string, std::set<std::string>> skipped;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    /// \brief extractors by mime type, content type and ogg theora flag
+    std::map<std::string, std::vector<std::shared_ptr<const Extractor>>> table;
+};
+
+#endif // __METADATA_REGISTRY_H__
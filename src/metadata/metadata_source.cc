@@ -0,0 +1,137 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    metadata_source.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file metadata_source.cc
+
+#include "metadata_source.h" // API
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "util/tools.h"
+
+/// \brief bytes kept of the start and the end of the file
+static constexpr off_t SOURCE_BLOCK = 64 * 1024;
+
+MetadataSource::MetadataSource(fs::path path)
+    : path(std::move(path))
+{
+    fd = open(this->path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw_std_runtime_error("Could not open {}: {}", this->path.c_str(), std::strerror(errno));
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) != 0) {
+        close(fd);
+        throw_std_runtime_error("Could not stat {}: {}", this->path.c_str(), std::strerror(errno));
+    }
+    size = statbuf.st_size;
+
+    head.resize(std::min(size, SOURCE_BLOCK));
+    auto bytes = pread(fd, head.data(), head.size(), 0);
+    head.resize(std::max<ssize_t>(bytes, 0));
+    tailOffset = std::max<off_t>(size - SOURCE_BLOCK, head.size());
+}
+
+MetadataSource::~MetadataSource()
+{
+    if (mapping != nullptr)
+        munmap(mapping, size);
+    close(fd);
+}
+
+std::size_t MetadataSource::copyBlock(const std::vector<std::byte>& block, off_t blockOffset, off_t offset, void* buffer, std::size_t length)
+{
+    if (offset < blockOffset || offset >= blockOffset + off_t(block.size()))
+        return 0;
+    auto count = std::min<std::size_t>(length, blockOffset + block.size() - offset);
+    std::memcpy(buffer, block.data() + (offset - blockOffset), count);
+    return count;
+}
+
+void MetadataSource::readTail()
+{
+    tailRead = true;
+    if (tailOffset >= size)
+        return;
+    tail.resize(size - tailOffset);
+    auto bytes = pread(fd, tail.data(), tail.size(), tailOffset);
+    tail.resize(std::max<ssize_t>(bytes, 0));
+}
+
+ssize_t MetadataSource::read(off_t offset, void* buffer, std::size_t length)
+{
+    if (offset < 0)
+        return -1;
+    if (offset >= size || length == 0)
+        return 0;
+    length = std::min<std::size_t>(length, size - offset);
+
+    auto out = static_cast<std::byte*>(buffer);
+    std::size_t done = copyBlock(head, 0, offset, out, length);
+    while (done < length) {
+        auto pos = offset + off_t(done);
+        if (pos >= tailOffset) {
+            if (!tailRead)
+                readTail();
+            auto count = copyBlock(tail, tailOffset, pos, out + done, length - done);
+            if (count == 0)
+                break;
+            done += count;
+            continue;
+        }
+        // the middle of the file is not kept
+        auto count = std::min<std::size_t>(length - done, tailOffset - pos);
+        auto bytes = pread(fd, out + done, count, pos);
+        if (bytes < 0)
+            return done > 0 ? ssize_t(done) : -1;
+        if (bytes == 0)
+            break;
+        done += bytes;
+    }
+    return done;
+}
+
+std::vector<std::byte> MetadataSource::readHead(std::size_t length)
+{
+    std::vector<std::byte> data(std::min<off_t>(length, size));
+    auto bytes = read(0, data.data(), data.size());
+    data.resize(std::max<ssize_t>(bytes, 0));
+    return data;
+}
+
+const std::byte* MetadataSource::map()
+{
+    if (mapping == nullptr && size > 0) {
+        auto addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            log_debug("Could not map {}: {}", path.c_str(), std::strerror(errno));
+            return nullptr;
+        }
+        mapping = addr;
+    }
+    return static_cast<const std::byte*>(mapping);
+}
@@ -0,0 +1,78 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    metadata_source.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file metadata_source.h
+#ifndef __METADATA_SOURCE_H__
+#define __METADATA_SOURCE_H__
+
+#include <cstddef>
+#include <filesystem>
+#include <sys/types.h>
+#include <vector>
+namespace fs = std::filesystem;
+
+/// \brief The file the metadata handlers of one item read, opened once for all of them
+///
+/// The handlers mostly read the headers at the start and the tags at the end of the file,
+/// so both are read once and kept. Everything else is read with pread on the shared descriptor.
+class MetadataSource {
+public:
+    /// \brief open the file, throws if it cannot be read
+    explicit MetadataSource(fs::path path);
+    ~MetadataSource();
+
+    MetadataSource(const MetadataSource&) = delete;
+    MetadataSource& operator=(const MetadataSource&) = delete;
+
+    const fs::path& getPath() const { return path; }
+    off_t getSize() const { return size; }
+
+    /// \brief read up to length bytes at offset
+    /// \return number of bytes read, 0 at the end of the file, -1 on errors
+    ssize_t read(off_t offset, void* buffer, std::size_t length);
+
+    /// \brief copy of the first length bytes, less if the file is shorter
+    std::vector<std::byte> readHead(std::size_t length);
+
+    /// \brief the whole file mapped read only, pages are only read when they are accessed
+    /// \return nullptr if the file cannot be mapped
+    const std::byte* map();
+
+protected:
+    fs::path path;
+    int fd { -1 };
+    off_t size { 0 };
+
+    std::vector<std::byte> head;
+    std::vector<std::byte> tail;
+    off_t tailOffset { 0 };
+    bool tailRead { false };
+
+    void* mapping { nullptr };
+
+    /// \brief copy the part of [offset, offset + length) that is in the block at blockOffset
+    static std::size_t copyBlock(const std::vector<std::byte>& block, off_t blockOffset, off_t offset, void* buffer, std::size_t length);
+    void readTail();
+};
+
+#endif // __METADATA_SOURCE_H__
@@ -50,12 +50,76 @@
 #include "cds_objects.h"
 #include "config/config_manager.h"
 #include "iohandler/mem_io_handler.h"
+#include "metadata/metadata_source.h"
+#include "metadata/thumbnail_cache.h"
 #include "util/mime.h"
 #include "util/string_converter.h"
 #include "util/tools.h"
 
+#if TAGLIB_MAJOR_VERSION >= 2
+using taglib_offset_t = TagLib::offset_t;
+using taglib_size_t = size_t;
+#else
+using taglib_offset_t = long;
+using taglib_size_t = unsigned long;
+#endif
+
+/// \brief read only TagLib stream on the file shared by the metadata handlers
+class MetadataSourceStream : public TagLib::IOStream {
+private:
+    MetadataSource* source;
+    taglib_offset_t position { 0 };
+
+public:
+    explicit MetadataSourceStream(MetadataSource* source)
+        : source(source)
+    {
+    }
+
+    TagLib::FileName name() const override { return source->getPath().c_str(); }
+
+    TagLib::ByteVector readBlock(taglib_size_t length) override
+    {
+        TagLib::ByteVector data(static_cast<unsigned int>(length), 0);
+        auto bytes = source->read(position, data.data(), length);
+        if (bytes <= 0)
+            return {};
+        data.resize(static_cast<unsigned int>(bytes));
+        position += bytes;
+        return data;
+    }
+
+    void writeBlock(const TagLib::ByteVector& data) override { }
+    void insert(const TagLib::ByteVector& data, taglib_offset_t start, taglib_size_t replace) override { }
+    void removeBlock(taglib_offset_t start, taglib_size_t length) override { }
+    bool readOnly() const override { return true; }
+    bool isOpen() const override { return true; }
+
+    void seek(taglib_offset_t offset, Position p) override
+    {
+        switch (p) {
+        case Beginning:
+            position = offset;
+            break;
+        case Current:
+            position += offset;
+            break;
+        case End:
+            position = source->getSize() + offset;
+            break;
+        }
+        position = std::max<taglib_offset_t>(position, 0);
+    }
+
+    void clear() override { }
+    taglib_offset_t tell() const override { return position; }
+    taglib_offset_t length() override { return source->getSize(); }
+    void truncate(taglib_offset_t length) override { }
+};
+
 TagLibHandler::TagLibHandler(const std::shared_ptr<Context>& context)
     : MetadataHandler(context)
+    , artworkStore(context->getArtworkStore())
 {
     entrySeparator = this->config->getOption(CFG_IMPORT_LIBOPTS_ENTRY_SEP);
     legacyEntrySeparator = this->config->getOption(CFG_IMPORT_LIBOPTS_ENTRY_LEGACY_SEP);
@@ -235,24 +299,29 @@ void TagLibHandler::fillMetadata(std::shared_ptr<CdsObject> obj)
     auto mappings = config->getDictionaryOption(CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
     std::string content_type = getValueOrDefault(mappings, item->getMimeType());
 
-    TagLib::FileStream fs(item->getLocation().c_str(), true); // true = Read only
+    std::unique_ptr<TagLib::IOStream> stream;
+    if (source != nullptr)
+        stream = std::make_unique<MetadataSourceStream>(source);
+    else
+        stream = std::make_unique<TagLib::FileStream>(item->getLocation().c_str(), true); // true = Read only
+    auto fs = stream.get();
 
     if (content_type == CONTENT_TYPE_MP3) {
-        extractMP3(&fs, item);
+        extractMP3(fs, item);
     } else if (content_type == CONTENT_TYPE_FLAC) {
-        extractFLAC(&fs, item);
+        extractFLAC(fs, item);
     } else if (content_type == CONTENT_TYPE_MP4) {
-        extractMP4(&fs, item);
+        extractMP4(fs, item);
     } else if (content_type == CONTENT_TYPE_OGG) {
-        extractOgg(&fs, item);
+        extractOgg(fs, item);
     } else if (content_type == CONTENT_TYPE_APE) {
-        extractAPE(&fs, item);
+        extractAPE(fs, item);
     } else if (content_type == CONTENT_TYPE_WMA) {
-        extractASF(&fs, item);
+        extractASF(fs, item);
     } else if (content_type == CONTENT_TYPE_WAVPACK) {
-        extractWavPack(&fs, item);
+        extractWavPack(fs, item);
     } else if (content_type == CONTENT_TYPE_AIFF) {
-        extractAiff(&fs, item);
+        extractAiff(fs, item);
     } else {
         log_warning("TagLibHandler {}: Does not handle the {} content type", item->getLocation().c_str(), content_type.c_str());
     }
@@ -277,7 +346,7 @@ std::string TagLibHandler::getContentTypeFromByteVector(const TagLib::ByteVector
     return art_mimetype;
 }
 
-void TagLibHandler::addArtworkResource(const std::shared_ptr<CdsItem>& item, const std::string& art_mimetype)
+void TagLibHandler::addArtworkResource(const std::shared_ptr<CdsItem>& item, const std::string& art_mimetype, const TagLib::ByteVector& data) const
 {
     // if we could not determine the mimetype, then there is no
     // point to add the resource - it's probably garbage
@@ -287,6 +356,13 @@ void TagLibHandler::addArtworkResource(const std::shared_ptr<CdsItem>& item, con
         auto resource = std::make_shared<CdsResource>(CH_ID3);
         resource->addAttribute(R_PROTOCOLINFO, renderProtocolInfo(art_mimetype));
         resource->addParameter(RESOURCE_CONTENT_TYPE, ID3_ALBUM_ART);
+        if (artworkStore && !data.isEmpty()) {
+            // the tracks of an album share one copy
+            auto key = hexFastHash(data.data(), data.size());
+            auto bytes = reinterpret_cast<const std::byte*>(data.data());
+            artworkStore->put(key, std::vector<std::byte>(bytes, bytes + data.size()));
+            resource->addOption(RESOURCE_OPTION_ARTWORK, key);
+        }
         item->addResource(resource);
     }
 }
@@ -297,6 +373,13 @@ std::unique_ptr<IOHandler> TagLibHandler::serveContent(std::shared_ptr<CdsObject
     if (item == nullptr)
         return nullptr;
 
+    auto res = item->getResource(resNum);
+    if (auto key = res ? res->getOption(RESOURCE_OPTION_ARTWORK) : ""; artworkStore && !key.empty()) {
+        if (auto data = artworkStore->get(key))
+            return std::make_unique<MemIOHandler>(data->data(), data->size());
+        log_debug("Artwork of {} is gone from the store", item->getLocation().c_str());
+    }
+
     auto mappings = config->getDictionaryOption(CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
     std::string content_type = getValueOrDefault(mappings, item->getMimeType());
 
@@ -493,7 +576,7 @@ void TagLibHandler::extractMP3(TagLib::IOStream* roStream, const std::shared_ptr
             art_mimetype = getContentTypeFromByteVector(pic);
         }
 
-        addArtworkResource(item, art_mimetype);
+        addArtworkResource(item, art_mimetype, pic);
     }
 }
 
@@ -525,7 +608,7 @@ void TagLibHandler::extractOgg(TagLib::IOStream* roStream, const std::shared_ptr
     if (!isValidArtworkContentType(art_mimetype)) {
         art_mimetype = getContentTypeFromByteVector(data);
     }
-    addArtworkResource(item, art_mimetype);
+    addArtworkResource(item, art_mimetype, data);
 }
 
 void TagLibHandler::extractASF(TagLib::IOStream* roStream, const std::shared_ptr<CdsItem>& item) const
@@ -560,7 +643,7 @@ void TagLibHandler::extractASF(TagLib::IOStream* roStream, const std::shared_ptr
         if (!isValidArtworkContentType(art_mimetype)) {
             art_mimetype = getContentTypeFromByteVector(wmpic.picture());
         }
-        addArtworkResource(item, art_mimetype);
+        addArtworkResource(item, art_mimetype, wmpic.picture());
     }
 }
 
@@ -618,7 +701,7 @@ void TagLibHandler::extractFLAC(TagLib::IOStream* roStream, const std::shared_pt
     if (!isValidArtworkContentType(art_mimetype)) {
         art_mimetype = getContentTypeFromByteVector(data);
     }
-    addArtworkResource(item, art_mimetype);
+    addArtworkResource(item, art_mimetype, data);
 }
 
 void TagLibHandler::extractAPE(TagLib::IOStream* roStream, const std::shared_ptr<CdsItem>& item) const
@@ -692,7 +775,7 @@ void TagLibHandler::extractMP4(TagLib::IOStream* roStream, const std::shared_ptr
         auto& coverArt = coverArtList.front();
         if (auto art_mimetype = getContentTypeFromByteVector(coverArt.data());
             !art_mimetype.empty()) {
-            addArtworkResource(item, art_mimetype);
+            addArtworkResource(item, art_mimetype, coverArt.data());
         }
     } else {
         log_debug("TagLibHandler {}: mp4 file has no 'covr' item",
@@ -43,6 +43,9 @@
 
 #include "metadata_handler.h"
 
+// forward declaration
+class ThumbnailCache;
+
 /// \brief This class is responsible for reading id3 or ogg tags metadata
 class TagLibHandler : public MetadataHandler {
 public:
@@ -53,13 +56,15 @@ public:
 private:
     std::string entrySeparator;
     std::string legacyEntrySeparator;
+    /// \brief one copy of each embedded picture, nullptr to read it from the file on request
+    std::shared_ptr<ThumbnailCache> artworkStore;
 
     void addField(metadata_fields_t field, const TagLib::File& file, const TagLib::Tag* tag, const std::shared_ptr<CdsItem>& item) const;
 
     void populateGenericTags(const std::shared_ptr<CdsItem>& item, const TagLib::File& file) const;
     static bool isValidArtworkContentType(const std::string& art_mimetype);
     std::string getContentTypeFromByteVector(const TagLib::ByteVector& data) const;
-    static void addArtworkResource(const std::shared_ptr<CdsItem>& item, const std::string& art_mimetype);
+    void addArtworkResource(const std::shared_ptr<CdsItem>& item, const std::string& art_mimetype, const TagLib::ByteVector& data) const;
     void extractMP3(TagLib::IOStream* roStream, const std::shared_ptr<CdsItem>& item) const;
     void extractOgg(TagLib::IOStream* roStream, const std::shared_ptr<CdsItem>& item) const;
     void extractASF(TagLib::IOStream* roStream, const std::shared_ptr<CdsItem>& item) const;
@@ -0,0 +1,182 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    thumbnail_cache.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file thumbnail_cache.cc
+
+#include "thumbnail_cache.h" // API
+
+#include <algorithm>
+
+#include "util/logger.h"
+#include "util/tools.h"
+
+/// \brief hex digits of the key used for each directory level
+static constexpr std::size_t SHARD_LENGTH = 2;
+static constexpr std::size_t KEY_LENGTH = 32;
+
+ThumbnailCache::ThumbnailCache(fs::path base, std::size_t maxSize)
+    : base(std::move(base))
+    , maxSize(maxSize)
+{
+    // the thumbnails are on disk, only the index is in memory
+    memory = MemoryAccounting::getInstance().add("thumbnail-cache", [this] {
+        AutoLock lock(mutex);
+        std::size_t bytes = 0;
+        for (auto&& [key, size] : entries)
+            bytes += MemoryAccounting::LIST_NODE + sizeof(Cache::Entry) + MemoryAccounting::TREE_NODE + sizeof(Cache::IndexValue) + 2 * MemoryAccounting::estimate(key);
+        return bytes;
+    });
+}
+
+std::string ThumbnailCache::getKey(const fs::path& location, time_t mtime, off_t size)
+{
+    return hexStringFastHash(fmt::format("{}\n{}\n{}", location.string(), mtime, size));
+}
+
+fs::path ThumbnailCache::getPath(const std::string& key) const
+{
+    return base / key.substr(0, SHARD_LENGTH) / key.substr(SHARD_LENGTH, SHARD_LENGTH) / fmt::format("{}.jpg", key);
+}
+
+void ThumbnailCache::load()
+{
+    struct Found {
+        std::string key;
+        std::size_t size;
+        fs::file_time_type used;
+    };
+    std::vector<Found> found;
+
+    std::error_code ec;
+    auto isShard = [](const fs::directory_entry& dirEnt) {
+        auto name = dirEnt.path().filename().string();
+        return dirEnt.is_directory() && name.size() == SHARD_LENGTH && std::all_of(name.begin(), name.end(), ::isxdigit);
+    };
+    for (auto&& first : fs::directory_iterator(base, ec)) {
+        if (!isShard(first))
+            continue;
+        for (auto&& second : fs::directory_iterator(first.path(), ec)) {
+            if (!isShard(second))
+                continue;
+            for (auto&& file : fs::directory_iterator(second.path(), ec)) {
+                auto key = file.path().stem().string();
+                if (file.path().extension() != ".jpg" || key.size() != KEY_LENGTH || getPath(key) != file.path())
+                    continue;
+                std::error_code fileEc;
+                auto size = file.file_size(fileEc);
+                auto used = file.last_write_time(fileEc);
+                if (!fileEc)
+                    found.push_back({ key, size, used });
+            }
+        }
+    }
+
+    // the most recently used is put last and ends up first
+    std::sort(found.begin(), found.end(), [](auto&& a, auto&& b) { return a.used < b.used; });
+
+    AutoLock lock(mutex);
+    entries.clear();
+    totalSize = 0;
+    for (auto&& file : found) {
+        entries.put(file.key, file.size);
+        totalSize += file.size;
+    }
+    while (maxSize > 0 && totalSize > maxSize && !entries.empty())
+        removeOldest();
+    log_debug("Thumbnail cache {} holds {} files, {} bytes", base.c_str(), entries.size(), totalSize);
+}
+
+bool ThumbnailCache::contains(const std::string& key)
+{
+    AutoLock lock(mutex);
+    return entries.find(key) != entries.end();
+}
+
+std::optional<std::vector<std::byte>> ThumbnailCache::get(const std::string& key)
+{
+    {
+        AutoLock lock(mutex);
+        if (entries.get(key) == entries.end())
+            return std::nullopt;
+    }
+
+    auto path = getPath(key);
+    auto data = readBinaryFile(path);
+    if (!data) {
+        // removed behind our back
+        AutoLock lock(mutex);
+        auto entry = entries.find(key);
+        if (entry != entries.end()) {
+            totalSize -= entry->second;
+            entries.erase(entry);
+        }
+        return std::nullopt;
+    }
+
+    // keep the order for the next start
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    return data;
+}
+
+void ThumbnailCache::put(const std::string& key, const std::vector<std::byte>& data)
+{
+    if (contains(key))
+        return;
+
+    auto path = getPath(key);
+    try {
+        fs::create_directories(path.parent_path());
+        // readers never see a partial file
+        auto temp = path;
+        temp += fmt::format(".{}", generateRandomId());
+        writeBinaryFile(temp, data.data(), data.size());
+        fs::rename(temp, path);
+    } catch (const std::runtime_error& e) {
+        log_error("Failed to write thumbnail cache: {}", e.what());
+        return;
+    }
+
+    AutoLock lock(mutex);
+    if (entries.find(key) != entries.end())
+        return;
+    entries.put(key, data.size());
+    totalSize += data.size();
+    while (maxSize > 0 && totalSize > maxSize && entries.size() > 1)
+        removeOldest();
+}
+
+std::size_t ThumbnailCache::getSize()
+{
+    AutoLock lock(mutex);
+    return totalSize;
+}
+
+void ThumbnailCache::removeOldest()
+{
+    auto&& [key, size] = entries.back();
+    std::error_code ec;
+    fs::remove(getPath(key), ec);
+    totalSize -= size;
+    entries.pop_back();
+}
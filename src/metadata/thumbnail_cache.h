@@ -0,0 +1,86 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    thumbnail_cache.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file thumbnail_cache.h
+#ifndef __THUMBNAIL_CACHE_H__
+#define __THUMBNAIL_CACHE_H__
+
+#include <cstddef>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+namespace fs = std::filesystem;
+
+#include "util/lru_cache.h"
+#include "util/memory_accounting.h"
+
+/// \brief Thumbnails on disk, named by a hash of the file path, modification time and size
+///
+/// The files are spread over <base>/ab/cd/abcd....jpg, so no directory grows large and a changed
+/// file gets a new thumbnail. The index is read once, so lookups need no stat.
+/// The least recently used thumbnails are removed when the cache grows beyond its size.
+/// Without a size limit it also serves as store for embedded album art, keyed by the hash of the picture.
+class ThumbnailCache {
+public:
+    /// \param maxSize bytes on disk, 0 for no limit
+    ThumbnailCache(fs::path base, std::size_t maxSize);
+
+    /// \brief read the thumbnails already on disk into the index
+    void load();
+
+    /// \brief name of the thumbnail of a file in this version
+    static std::string getKey(const fs::path& location, time_t mtime, off_t size);
+
+    bool contains(const std::string& key);
+    /// \brief the cached thumbnail, nullopt if there is none
+    std::optional<std::vector<std::byte>> get(const std::string& key);
+    void put(const std::string& key, const std::vector<std::byte>& data);
+
+    std::size_t getSize();
+
+protected:
+    /// \brief bytes of the thumbnail by key
+    using Cache = LruCache<std::string, std::size_t>;
+
+    fs::path base;
+    std::size_t maxSize;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::size_t totalSize { 0 };
+
+    Cache entries;
+
+    fs::path getPath(const std::string& key) const;
+    /// \brief remove the least recently used entry from the index and from disk, lock must be held
+    void removeOldest();
+
+    std::unique_ptr<MemoryAccounting::Registration> memory;
+};
+
+#endif // __THUMBNAIL_CACHE_H__
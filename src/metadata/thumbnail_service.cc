@@ -0,0 +1,213 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    thumbnail_service.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file thumbnail_service.cc
+
+#include "thumbnail_service.h" // API
+
+#include <algorithm>
+
+#include "exceptions.h"
+#include "metadata/thumbnail_cache.h"
+
+ThumbnailService::ThumbnailService(std::shared_ptr<Config> config, Generator generator, std::size_t threadCount, std::size_t queueSize,
+    std::shared_ptr<ThumbnailCache> cache)
+    : config(std::move(config))
+    , generator(std::move(generator))
+    , threadCount(threadCount)
+    , queueSize(queueSize)
+    , cache(std::move(cache))
+{
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    if (!threads.empty())
+        shutdown();
+}
+
+void ThumbnailService::run()
+{
+    AutoLock lock(mutex);
+    for (std::size_t i = 0; i < threadCount; i++) {
+        auto thread = std::make_unique<StdThreadRunner>(fmt::format("Thumbnail{}", i), ThumbnailService::staticThreadProc, this, config);
+        if (!thread->isAlive())
+            throw_std_runtime_error("Could not start thumbnail thread");
+        threads.push_back(std::move(thread));
+    }
+    log_debug("started {} thumbnail threads", threads.size());
+}
+
+void ThumbnailService::shutdown()
+{
+    std::deque<std::shared_ptr<Job>> dropped;
+    std::vector<std::unique_ptr<StdThreadRunner>> running;
+    {
+        AutoLock lock(mutex);
+        shutdownFlag = true;
+        running.swap(threads);
+        // waiting clients generate their own job
+        std::copy_if(queue.begin(), queue.end(), std::back_inserter(dropped), [](auto&& job) { return job->background; });
+        queue.erase(std::remove_if(queue.begin(), queue.end(), [](auto&& job) { return job->background; }), queue.end());
+        for (auto&& job : dropped)
+            jobs.erase(job->location);
+        queueCond.notify_all();
+    }
+    for (auto&& thread : running)
+        thread->join();
+
+    for (auto&& job : dropped)
+        job->promise.set_exception(std::make_exception_ptr(std::runtime_error("thumbnail service shut down")));
+
+    // nobody is left to take the client jobs
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            AutoLock lock(mutex);
+            if (queue.empty())
+                break;
+            job = queue.front();
+            queue.pop_front();
+        }
+        generate(job);
+    }
+}
+
+ThumbnailService::Thumbnail ThumbnailService::get(const fs::path& location, time_t mtime, off_t size)
+{
+    std::string key;
+    if (cache) {
+        key = ThumbnailCache::getKey(location, mtime, size);
+        if (auto data = cache->get(key)) {
+            log_debug("Returning cached thumbnail for file: {}", location.c_str());
+            return std::make_shared<const std::vector<std::byte>>(std::move(*data));
+        }
+    }
+
+    std::shared_ptr<Job> job;
+    bool generateHere = false;
+    {
+        AutoLock lock(mutex);
+        auto existing = jobs.find(location);
+        if (existing != jobs.end()) {
+            job = existing->second;
+            auto queued = std::find(queue.begin(), queue.end(), job);
+            if (job->background && queued != queue.end()) {
+                // a client waits for it now
+                job->background = false;
+                queue.erase(queued);
+                auto firstBackground = std::find_if(queue.begin(), queue.end(), [](auto&& other) { return other->background; });
+                queue.insert(firstBackground, job);
+            }
+        } else {
+            job = std::make_shared<Job>();
+            job->location = location;
+            job->key = key;
+            job->background = false;
+            generateHere = threads.empty();
+            if (!generateHere) {
+                if (queue.size() >= queueSize)
+                    throw_std_runtime_error("Thumbnail queue is full, not generating {}", location.c_str());
+                auto firstBackground = std::find_if(queue.begin(), queue.end(), [](auto&& other) { return other->background; });
+                queue.insert(firstBackground, job);
+                queueCond.notify_one();
+            }
+            jobs[location] = job;
+        }
+    }
+
+    if (generateHere)
+        generate(job);
+    return job->result.get();
+}
+
+bool ThumbnailService::prefetch(const fs::path& location, time_t mtime, off_t size)
+{
+    std::string key;
+    if (cache) {
+        key = ThumbnailCache::getKey(location, mtime, size);
+        if (cache->contains(key))
+            return true;
+    }
+
+    AutoLock lock(mutex);
+    if (jobs.find(location) != jobs.end())
+        return true;
+    if (shutdownFlag || threads.empty() || queue.size() >= queueSize)
+        return false;
+
+    auto job = std::make_shared<Job>();
+    job->location = location;
+    job->key = key;
+    job->background = true;
+    jobs[location] = job;
+    queue.push_back(job);
+    queueCond.notify_one();
+    return true;
+}
+
+void ThumbnailService::generate(const std::shared_ptr<Job>& job)
+{
+    try {
+        log_debug("Generating thumbnail for file: {}", job->location.c_str());
+        auto thumbnail = std::make_shared<const std::vector<std::byte>>(generator(job->location));
+        if (cache && !job->key.empty())
+            cache->put(job->key, *thumbnail);
+        {
+            AutoLock lock(mutex);
+            jobs.erase(job->location);
+        }
+        job->promise.set_value(thumbnail);
+    } catch (const std::exception& e) {
+        if (job->background)
+            log_warning("Could not generate thumbnail for {}: {}", job->location.c_str(), e.what());
+        {
+            AutoLock lock(mutex);
+            jobs.erase(job->location);
+        }
+        job->promise.set_exception(std::current_exception());
+    }
+}
+
+void* ThumbnailService::staticThreadProc(void* arg)
+{
+    auto inst = static_cast<ThumbnailService*>(arg);
+    inst->threadProc();
+    return nullptr;
+}
+
+void ThumbnailService::threadProc()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!shutdownFlag) {
+        if (queue.empty()) {
+            queueCond.wait(lock);
+            continue;
+        }
+        auto job = queue.front();
+        queue.pop_front();
+        lock.unlock();
+        generate(job);
+        lock.lock();
+    }
+}
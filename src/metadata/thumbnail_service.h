@@ -0,0 +1,111 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    thumbnail_service.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file thumbnail_service.h
+#ifndef __THUMBNAIL_SERVICE_H__
+#define __THUMBNAIL_SERVICE_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+#include "util/thread_runner.h"
+namespace fs = std::filesystem;
+
+// forward declaration
+class Config;
+class ThumbnailCache;
+
+/// \brief Generates thumbnails of video files in a few background threads
+///
+/// Requests for a file that is already queued or being generated wait for that generation
+/// instead of starting another one. Thumbnails requested by a client are generated before
+/// the ones queued during the import. Generated thumbnails are kept in the cache if there is one.
+class ThumbnailService {
+public:
+    using Thumbnail = std::shared_ptr<const std::vector<std::byte>>;
+    /// \brief creates the thumbnail of a file, throws on failure
+    using Generator = std::function<std::vector<std::byte>(const fs::path& location)>;
+
+    /// \param queueSize number of files waiting for a thread, further requests are refused
+    ThumbnailService(std::shared_ptr<Config> config, Generator generator, std::size_t threadCount, std::size_t queueSize,
+        std::shared_ptr<ThumbnailCache> cache = nullptr);
+    ~ThumbnailService();
+
+    void run();
+    void shutdown();
+
+    /// \brief thumbnail of location, waits until it is generated
+    ///
+    /// Without threads the calling thread generates it. Throws if the queue is full or generation failed.
+    /// \param mtime modification time and size of the file select the cached thumbnail
+    Thumbnail get(const fs::path& location, time_t mtime, off_t size);
+
+    /// \brief queue the generation of location in the background unless it is cached
+    /// \return false if the queue is full or the service is shut down
+    bool prefetch(const fs::path& location, time_t mtime, off_t size);
+
+protected:
+    struct Job {
+        fs::path location;
+        /// \brief name in the cache, empty without cache
+        std::string key;
+        std::promise<Thumbnail> promise;
+        std::shared_future<Thumbnail> result { promise.get_future().share() };
+        bool background;
+    };
+
+    std::shared_ptr<Config> config;
+    Generator generator;
+    std::size_t threadCount;
+    std::size_t queueSize;
+    std::shared_ptr<ThumbnailCache> cache;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::condition_variable queueCond;
+    bool shutdownFlag { false };
+
+    /// \brief queued and running jobs by file
+    std::map<fs::path, std::shared_ptr<Job>> jobs;
+    /// \brief jobs of clients first, then the prefetched ones
+    std::deque<std::shared_ptr<Job>> queue;
+    std::vector<std::unique_ptr<StdThreadRunner>> threads;
+
+    /// \brief run job and remove it from jobs
+    void generate(const std::shared_ptr<Job>& job);
+
+    static void* staticThreadProc(void* arg);
+    void threadProc();
+};
+
+#endif // __THUMBNAIL_SERVICE_H__
@@ -0,0 +1,64 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    metrics_request_handler.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file metrics_request_handler.cc
+
+#include "metrics_request_handler.h" // API
+
+#include "iohandler/mem_io_handler.h"
+#include "util/memory_accounting.h"
+#include "util/metrics.h"
+#include "util/upnp_headers.h"
+
+/// \brief version 0.0.4 of the text exposition format, understood by Prometheus and OpenMetrics scrapers
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+MetricsRequestHandler::MetricsRequestHandler(std::shared_ptr<ContentManager> content)
+    : RequestHandler(std::move(content))
+{
+}
+
+void MetricsRequestHandler::getInfo(const char* filename, UpnpFileInfo* info)
+{
+    // rendered again in open(), the values change in between
+    UpnpFileInfo_set_FileLength(info, -1);
+    UpnpFileInfo_set_LastModified(info, 0);
+#if defined(USING_NPUPNP)
+    UpnpFileInfo_set_ContentType(info, METRICS_CONTENT_TYPE);
+#else
+    UpnpFileInfo_set_ContentType(info, ixmlCloneDOMString(METRICS_CONTENT_TYPE));
+#endif
+    UpnpFileInfo_set_IsReadable(info, 1);
+    UpnpFileInfo_set_IsDirectory(info, 0);
+
+    Headers headers;
+    headers.addHeader("Cache-Control", "no-cache");
+    headers.writeHeaders(info);
+}
+
+std::unique_ptr<IOHandler> MetricsRequestHandler::open(const char* filename, enum UpnpOpenFileMode mode)
+{
+    // the estimates are computed on request only
+    MemoryAccounting::getInstance().publish();
+    auto t = std::make_unique<MemIOHandler>(Metrics::getInstance().render());
+    t->open(mode);
+    return t;
+}
@@ -0,0 +1,39 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    metrics_request_handler.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file metrics_request_handler.h
+
+#ifndef GERBERA_METRICS_REQUEST_HANDLER_H
+#define GERBERA_METRICS_REQUEST_HANDLER_H
+
+#include "request_handler.h"
+#include <memory>
+
+/// \brief Serves the server metrics for Prometheus
+class MetricsRequestHandler : public RequestHandler {
+public:
+    explicit MetricsRequestHandler(std::shared_ptr<ContentManager> content);
+
+    void getInfo(const char* filename, UpnpFileInfo* info) override;
+    std::unique_ptr<IOHandler> open(const char* filename, enum UpnpOpenFileMode mode) override;
+};
+
+#endif // GERBERA_METRICS_REQUEST_HANDLER_H
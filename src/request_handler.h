@@ -81,6 +81,10 @@ public:
     std::map<std::string, std::string> parseParameters(const char* filename, const char* baseLink);
     std::shared_ptr<CdsObject> getObjectById(std::map<std::string, std::string> params);
 
+    /// \brief upnp request cookie, set by getInfo and passed to open of the same request
+    const void* getRequestCookie() const { return requestCookie; }
+    void setRequestCookie(const void* cookie) { requestCookie = cookie; }
+
     virtual ~RequestHandler() = default;
 
 protected:
@@ -90,6 +94,7 @@ protected:
     std::shared_ptr<Mime> mime;
     std::shared_ptr<Database> database;
     std::shared_ptr<Server> server;
+    const void* requestCookie { nullptr };
 };
 
 #endif // __REQUEST_HANDLER_H__
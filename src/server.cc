@@ -42,21 +42,46 @@
 #endif
 
 #include <chrono>
+#include <future>
 #include <thread>
 
+#include "asset_request_handler.h"
 #include "config/config_manager.h"
 #include "content/content_manager.h"
+#include "content/import_statistics.h"
+#include "browse_cache.h"
+#include "browse_snapshot.h"
 #include "database/database.h"
 #include "device_description_handler.h"
+#include "didl_cache.h"
+#include "file_request_cache.h"
 #include "file_request_handler.h"
+#include "iohandler/playback_predictor.h"
+#include "iohandler/read_ahead_pool.h"
+#include "iohandler/stream_statistics.h"
+#include "iohandler/thumbnail_store.h"
+#include "metadata/metadata_registry.h"
+#include "metadata/thumbnail_cache.h"
+#include "metadata/thumbnail_service.h"
+#include "metrics_request_handler.h"
 #include "serve_request_handler.h"
+#include "util/memory_accounting.h"
+#include "util/metrics.h"
 #include "util/mime.h"
+#include "util/profiler.h"
+#include "util/request_admission.h"
 #include "util/upnp_clients.h"
+#include "util/worker_pool.h"
 #include "web/pages.h"
 #include "web/session_manager.h"
 
 #ifdef HAVE_CURL
 #include "url_request_handler.h"
+#include "util/curl_engine.h"
+#endif
+
+#if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
+#include "metadata/ffmpeg_handler.h"
 #endif
 
 Server::Server(std::shared_ptr<Config> config)
@@ -65,6 +90,24 @@ Server::Server(std::shared_ptr<Config> config)
     server_shutdown_flag = false;
 }
 
+void Server::transferDatabase(const std::shared_ptr<Config>& config, const fs::path& path, bool import)
+{
+    auto timer = std::make_shared<Timer>(config);
+    timer->run();
+    try {
+        auto database = Database::createInstance(config, timer);
+        if (import)
+            database->importDatabase(path);
+        else
+            database->exportDatabase(path);
+        database->shutdown();
+    } catch (const std::runtime_error& e) {
+        timer->shutdown();
+        throw;
+    }
+    timer->shutdown();
+}
+
 void Server::init()
 {
     virtual_directory = SERVER_VIRTUAL_DIR;
@@ -80,15 +123,80 @@ void Server::init()
     auto self = shared_from_this();
     timer = std::make_shared<Timer>(config);
 
+    // the caches only walk their directories, do that while the database is opened and migrated
+    std::vector<std::future<void>> cacheLoads;
+    std::shared_ptr<ThumbnailCache> thumbnailCache;
+#if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
+    if (config->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_ENABLED) && config->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_DIR_ENABLED)) {
+        auto cacheSize = std::size_t(config->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_CACHE_SIZE)) * 1024 * 1024;
+        thumbnailCache = std::make_shared<ThumbnailCache>(getThumbnailCacheBasePath(*config), cacheSize);
+        cacheLoads.push_back(std::async(std::launch::async, [thumbnailCache] { thumbnailCache->load(); }));
+    }
+#endif
+    std::shared_ptr<ThumbnailCache> artworkStore;
+#ifdef HAVE_TAGLIB
+    if (auto artworkDir = config->getOption(CFG_IMPORT_LIBOPTS_ID3_ARTWORK_DIR); !artworkDir.empty()) {
+        artworkStore = std::make_shared<ThumbnailCache>(artworkDir, 0);
+        cacheLoads.push_back(std::async(std::launch::async, [artworkStore] { artworkStore->load(); }));
+    }
+#endif
+
     clients = std::make_shared<Clients>(config);
     mime = std::make_shared<Mime>(config);
     timer->run();
     database = Database::createInstance(config, timer);
+    for (auto&& load : cacheLoads)
+        load.get();
     config->updateConfigFromDatabase(database);
     session_manager = std::make_shared<web::SessionManager>(config, timer);
-    context = std::make_shared<Context>(config, clients, mime, database, self, session_manager);
-
+    auto importStatistics = std::make_shared<ImportStatistics>(config->getBoolOption(CFG_IMPORT_STATISTICS));
+    auto streamStatistics = std::make_shared<StreamStatistics>(config->getBoolOption(CFG_SERVER_STREAM_STATISTICS));
+    MemoryAccounting::getInstance().setEnabled(config->getBoolOption(CFG_SERVER_MEMORY_ACCOUNTING));
+    std::shared_ptr<ThumbnailService> thumbnailService;
+#if defined(HAVE_FFMPEG) && defined(HAVE_FFMPEGTHUMBNAILER)
+    if (config->getBoolOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_ENABLED)) {
+        thumbnailService = std::make_shared<ThumbnailService>(
+            config, [cfg = config](const fs::path& location) { return FfmpegHandler::generateThumbnail(*cfg, location); },
+            config->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_THREADS), config->getIntOption(CFG_SERVER_EXTOPTS_FFMPEGTHUMBNAILER_QUEUE_SIZE), thumbnailCache);
+        thumbnailService->run();
+    }
+#endif
+    context = std::make_shared<Context>(config, clients, mime, database, self, session_manager, importStatistics, streamStatistics, thumbnailService, artworkStore,
+        std::make_shared<MetadataRegistry>(config));
+
+    didlCache = std::make_shared<DidlCache>(DIDL_CACHE_SIZE);
+    browseCache = std::make_shared<BrowseCache>(std::chrono::seconds(BROWSE_CACHE_TTL), BROWSE_CACHE_SIZE);
+    if (config->getBoolOption(CFG_SERVER_BROWSE_SNAPSHOT_ENABLED))
+        browseSnapshot = std::make_shared<BrowseSnapshot>(config->getOption(CFG_SERVER_BROWSE_SNAPSHOT_FILE), std::chrono::seconds(config->getIntOption(CFG_SERVER_BROWSE_SNAPSHOT_DELAY)));
+    if (std::thread::hardware_concurrency() > 1) {
+        renderPool = std::make_shared<WorkerPool>(config, "Render", std::min<std::size_t>(DIDL_RENDER_THREADS, std::thread::hardware_concurrency() - 1));
+        renderPool->run();
+    }
     content = std::make_shared<ContentManager>(context, self, timer);
+
+    auto readAheadThreads = config->getIntOption(CFG_SERVER_READ_AHEAD_THREADS);
+    if (readAheadThreads > 0) {
+        auto cacheSize = std::size_t(config->getIntOption(CFG_SERVER_READ_AHEAD_CACHE_SIZE)) * 1024 * 1024;
+        readAheadPool = std::make_shared<ReadAheadPool>(config, readAheadThreads, READ_AHEAD_CHUNK_SIZE, config->getIntOption(CFG_SERVER_READ_AHEAD_CHUNKS), cacheSize);
+        readAheadPool->run();
+    }
+    auto predictNext = config->getIntOption(CFG_SERVER_READ_AHEAD_PREDICT_NEXT);
+    if (predictNext > 0) {
+        playbackPredictor = std::make_shared<PlaybackPredictor>(config, database, readAheadPool, std::size_t(predictNext) * 1024 * 1024);
+        playbackPredictor->run();
+    }
+    fileRequestCache = std::make_shared<FileRequestCache>(std::chrono::seconds(FILE_REQUEST_CACHE_TTL), FILE_REQUEST_CACHE_SIZE);
+    tracer = std::make_unique<Tracer>(config->getIntOption(CFG_SERVER_TRACE_SAMPLE), config->getOption(CFG_SERVER_TRACE_FILE));
+    profiler = std::make_shared<Profiler>(config, timer);
+
+    auto thumbnailStoreSize = std::size_t(config->getIntOption(CFG_SERVER_THUMBNAIL_STORE_SIZE)) * 1024 * 1024;
+    if (thumbnailStoreSize > 0) {
+        try {
+            thumbnailStore = std::make_shared<ThumbnailStore>(config->getOption(CFG_SERVER_THUMBNAIL_STORE_FILE), thumbnailStoreSize);
+        } catch (const std::runtime_error& e) {
+            log_warning("Thumbnail store disabled: {}", e.what());
+        }
+    }
 }
 
 Server::~Server() { log_debug("Server destroyed"); }
@@ -114,6 +222,13 @@ void Server::run()
     log_info("Initialising libupnp with interface: {}, port: {}", iface.empty() ? "<unset>" : iface, port == 0 ? "<unset>" : fmt::to_string(port));
     const char* IfName = iface.empty() ? nullptr : iface.c_str();
 
+    admission = std::make_unique<RequestAdmission>(config->getIntOption(CFG_SERVER_UPNP_WORKERS),
+        config->getIntOption(CFG_SERVER_UPNP_CONTROL_RESERVE), config->getIntOption(CFG_SERVER_UPNP_DATA_RESERVE));
+#if !defined(USING_NPUPNP)
+    // the thread pools are created by UpnpInit2
+    UpnpSetMaxJobsTotal(config->getIntOption(CFG_SERVER_UPNP_MAX_JOBS));
+#endif
+
     int ret = UPNP_E_INIT_FAILED;
     for (int attempt = 0; ret != UPNP_E_SUCCESS; attempt++) {
         ret = UpnpInit2(IfName, port);
@@ -129,6 +244,7 @@ void Server::run()
             std::this_thread::sleep_for(std::chrono::seconds(attempt + 1));
         }
     }
+    upnpStarted = true;
 
     port = UpnpGetServerPort();
     /* The IP libupnp picks is not always the same as passed into config, as we map it to an interface */
@@ -185,14 +301,15 @@ void Server::run()
     auto desc = xmlbuilder->renderDeviceDescription();
     std::ostringstream buf;
     desc->print(buf, "", 0);
-    std::string deviceDescription = buf.str();
-    //log_debug("Device Description: {}", deviceDescription.c_str());
+    device_description_document = buf.str();
+    deviceDescriptionTime = time(nullptr);
+    //log_debug("Device Description: {}", device_description_document.c_str());
 
     log_debug("Registering with UPnP...");
     ret = UpnpRegisterRootDevice2(
         UPNPREG_BUF_DESC,
-        deviceDescription.c_str(),
-        size_t(deviceDescription.length()) + 1,
+        device_description_document.c_str(),
+        size_t(device_description_document.length()) + 1,
         true,
         handleUpnpRootDeviceEventCallback,
         this,
@@ -201,6 +318,14 @@ void Server::run()
         throw UpnpException(ret, "run: UpnpRegisterRootDevice2 failed");
     }
 
+    // renderers that went away without unsubscribing are dropped once their subscription runs out
+    int subscriptionTimeout = config->getIntOption(CFG_SERVER_UPNP_EVENT_SUBSCRIPTION_TIMEOUT);
+    if (subscriptionTimeout > 0) {
+        ret = UpnpSetMaxSubscriptionTimeOut(rootDeviceHandle, subscriptionTimeout);
+        if (ret != UPNP_E_SUCCESS)
+            log_warning("Failed to limit the subscription timeout: {}", ret);
+    }
+
     ret = UpnpRegisterClient(
         handleUpnpClientEventCallback,
         this,
@@ -210,8 +335,8 @@ void Server::run()
     }
 
     log_debug("Creating ContentDirectoryService");
-    cds = std::make_unique<ContentDirectoryService>(context, xmlbuilder.get(), rootDeviceHandle,
-        config->getIntOption(CFG_SERVER_UPNP_TITLE_AND_DESC_STRING_LIMIT));
+    cds = std::make_unique<ContentDirectoryService>(context, content, xmlbuilder.get(), rootDeviceHandle,
+        config->getIntOption(CFG_SERVER_UPNP_TITLE_AND_DESC_STRING_LIMIT), didlCache, browseCache, renderPool, browseSnapshot);
 
     log_debug("Creating ConnectionManagerService");
     cmgr = std::make_unique<ConnectionManagerService>(context, xmlbuilder.get(), rootDeviceHandle);
@@ -230,6 +355,19 @@ void Server::run()
     // run what is needed
     content->run();
 
+    if (config->getIntOption(CFG_SERVER_STORAGE_WARM_UP_DEPTH) > 0) {
+        // clients are already answered, the first browses get faster as the walk proceeds
+        warmUpThread = std::make_unique<StdThreadRunner>("WarmUpThread", Server::staticWarmUpThread, this, config);
+        if (!warmUpThread->isAlive())
+            log_warning("Failed to start warm-up thread");
+    }
+
+    if (browseSnapshot) {
+        snapshotThread = std::make_unique<StdThreadRunner>("SnapshotThread", Server::staticSnapshotThread, this, config);
+        if (!snapshotThread->isAlive())
+            log_warning("Failed to start browse snapshot thread");
+    }
+
     std::string url = config->getOption(CFG_VIRTUAL_URL);
     if (url.empty()) {
         url = renderWebUri(ip, port);
@@ -241,6 +379,52 @@ void Server::run()
     log_info("The Web UI can be reached by following this link: {}/", url);
 }
 
+void* Server::staticWarmUpThread(void* arg)
+{
+    auto inst = static_cast<Server*>(arg);
+    inst->warmUpThreadProc();
+    return nullptr;
+}
+
+void Server::warmUpThreadProc()
+{
+    auto start = std::chrono::steady_clock::now();
+    try {
+        database->warmUpIndexes();
+        if (!server_shutdown_flag)
+            cds->warmUp(config->getIntOption(CFG_SERVER_STORAGE_WARM_UP_DEPTH), server_shutdown_flag);
+    } catch (const std::runtime_error& e) {
+        log_warning("Warm-up failed: {}", e.what());
+        return;
+    }
+    log_info("Warm-up finished in {} ms", std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+void* Server::staticSnapshotThread(void* arg)
+{
+    auto inst = static_cast<Server*>(arg);
+    inst->snapshotThreadProc();
+    return nullptr;
+}
+
+void Server::snapshotThreadProc()
+{
+    while (browseSnapshot->waitForRebuild()) {
+        try {
+            cds->buildSnapshot(server_shutdown_flag);
+        } catch (const std::runtime_error& e) {
+            // the changed containers stay stale and are answered from the database
+            log_warning("Browse snapshot failed: {}", e.what());
+        }
+    }
+}
+
+void Server::runContentOnly()
+{
+    log_debug("Starting content manager only...");
+    content->run();
+}
+
 void Server::writeBookmark(const std::string& addr)
 {
     const std::string data = config->getBoolOption(CFG_SERVER_UI_ENABLED)
@@ -272,37 +456,92 @@ bool Server::getShutdownStatus() const
     return server_shutdown_flag;
 }
 
+void Server::reloadConfig()
+{
+    clients->reload(config);
+    content->reloadConfig();
+    // the transcoded resources are part of the rendered objects
+    didlCache->clear();
+    browseCache->clear();
+    if (browseSnapshot)
+        browseSnapshot->clear();
+    log_info("Configuration reloaded");
+}
+
 void Server::shutdown()
 {
     int ret = 0; // return code
 
-    emptyBookmark();
     server_shutdown_flag = true;
 
     log_debug("Server shutting down");
 
-    ret = UpnpUnRegisterClient(clientHandle);
-    if (ret != UPNP_E_SUCCESS) {
-        log_error("UpnpUnRegisterClient failed ({})", ret);
+    if (warmUpThread) {
+        warmUpThread->join();
+        warmUpThread = nullptr;
+    }
+    if (snapshotThread) {
+        browseSnapshot->shutdown();
+        snapshotThread->join();
+        snapshotThread = nullptr;
     }
 
-    ret = UpnpUnRegisterRootDevice(rootDeviceHandle);
-    if (ret != UPNP_E_SUCCESS) {
-        log_error("UpnpUnRegisterRootDevice failed ({})", ret);
+    if (upnpStarted) {
+        emptyBookmark();
+
+        ret = UpnpUnRegisterClient(clientHandle);
+        if (ret != UPNP_E_SUCCESS) {
+            log_error("UpnpUnRegisterClient failed ({})", ret);
+        }
+
+        ret = UpnpUnRegisterRootDevice(rootDeviceHandle);
+        if (ret != UPNP_E_SUCCESS) {
+            log_error("UpnpUnRegisterRootDevice failed ({})", ret);
+        }
+
+        log_debug("now calling upnp finish");
+        UpnpFinish();
+        upnpStarted = false;
     }
 
 #ifdef HAVE_CURL
+    CurlEngine::getInstance().shutdown();
     curl_global_cleanup();
 #endif
 
-    log_debug("now calling upnp finish");
-    UpnpFinish();
-
     if (content) {
         content->shutdown();
         content = nullptr;
     }
 
+    if (context && context->getThumbnailService())
+        context->getThumbnailService()->shutdown();
+
+    if (playbackPredictor) {
+        playbackPredictor->shutdown();
+        playbackPredictor = nullptr;
+    }
+    if (readAheadPool) {
+        readAheadPool->shutdown();
+        readAheadPool = nullptr;
+    }
+    if (renderPool) {
+        renderPool->shutdown();
+        renderPool = nullptr;
+    }
+    if (fileRequestCache)
+        fileRequestCache->clear();
+    if (didlCache)
+        didlCache->clear();
+    if (browseCache)
+        browseCache->clear();
+    thumbnailStore = nullptr;
+
+    if (profiler) {
+        profiler->stop();
+        profiler = nullptr;
+    }
+
     session_manager = nullptr;
 
     if (database->threadCleanupRequired()) {
@@ -321,6 +560,12 @@ void Server::shutdown()
     clients = nullptr;
 }
 
+/// \brief requests refused because all workers of their kind were busy
+static Metrics::Counter& refusedRequests(const char* kind)
+{
+    return Metrics::getInstance().counter("gerbera_upnp_requests_refused_total", "Requests refused by the admission control", Metrics::label("kind", kind));
+}
+
 int Server::handleUpnpRootDeviceEventCallback(Upnp_EventType eventType, const void* event, void* cookie)
 {
     return static_cast<Server*>(cookie)->handleUpnpRootDeviceEvent(eventType, event);
@@ -341,19 +586,38 @@ int Server::handleUpnpRootDeviceEvent(Upnp_EventType eventType, const void* even
     // dispatch event based on event type
     switch (eventType) {
 
-    case UPNP_CONTROL_ACTION_REQUEST:
+    case UPNP_CONTROL_ACTION_REQUEST: {
         log_debug("UPNP_CONTROL_ACTION_REQUEST");
+        auto upnpRequest = static_cast<UpnpActionRequest*>(const_cast<void*>(event));
+        if (!admission->acquire(RequestAdmission::Kind::Control)) {
+            log_warning("All {} workers for control requests are busy, refusing {}", admission->getCapacity(RequestAdmission::Kind::Control), UpnpActionRequest_get_ActionName_cstr(upnpRequest));
+            refusedRequests("control").inc();
+            ret = UPNP_E_ACTION_FAILED;
+            UpnpActionRequest_set_ErrCode(upnpRequest, ret);
+            break;
+        }
+        auto trace = tracer->sample(UpnpActionRequest_get_ActionName_cstr(upnpRequest));
+        Trace::Scope traceScope(trace.get());
         try {
-            auto request = std::make_unique<ActionRequest>(context, static_cast<UpnpActionRequest*>(const_cast<void*>(event)));
+            std::unique_ptr<ActionRequest> request;
+            {
+                TraceSpan span("parse");
+                request = std::make_unique<ActionRequest>(context, upnpRequest);
+            }
             routeActionRequest(request);
+            TraceSpan span("serialize");
             request->update();
         } catch (const UpnpException& upnp_e) {
             ret = upnp_e.getErrorCode();
-            UpnpActionRequest_set_ErrCode(static_cast<UpnpActionRequest*>(const_cast<void*>(event)), ret);
+            UpnpActionRequest_set_ErrCode(upnpRequest, ret);
         } catch (const std::runtime_error& e) {
             log_info("Exception: {}", e.what());
         }
+        if (trace != nullptr)
+            tracer->finish(*trace);
+        admission->release(RequestAdmission::Kind::Control);
         break;
+    }
 
     case UPNP_EVENT_SUBSCRIPTION_REQUEST:
         log_debug("UPNP_EVENT_SUBSCRIPTION_REQUEST");
@@ -426,6 +690,10 @@ void Server::routeActionRequest(const std::unique_ptr<ActionRequest>& request) c
         throw UpnpException(UPNP_E_BAD_REQUEST, "routeActionRequest: request not for this device");
     }
 
+    auto serviceID = request->getServiceID();
+    auto labels = fmt::format("{},{}", Metrics::label("service", serviceID.substr(serviceID.rfind(':') + 1)), Metrics::label("action", request->getActionName()));
+    Metrics::Histogram::Timer timer(Metrics::getInstance().histogram("gerbera_upnp_action_duration_seconds", "Time to answer UPnP actions", labels));
+
     // we need to match the serviceID to one of our services
     if (request->getServiceID() == UPNP_DESC_CM_SERVICE_ID) {
         // this call is for the lifetime stats service
@@ -475,7 +743,8 @@ void Server::routeSubscriptionRequest(const std::unique_ptr<SubscriptionRequest>
 // Temp
 void Server::sendCDSSubscriptionUpdate(const std::string& updateString)
 {
-    cds->sendSubscriptionUpdate(updateString);
+    if (cds != nullptr)
+        cds->sendSubscriptionUpdate(updateString);
 }
 
 std::unique_ptr<RequestHandler> Server::createRequestHandler(const char* filename) const
@@ -486,7 +755,7 @@ std::unique_ptr<RequestHandler> Server::createRequestHandler(const char* filenam
     std::unique_ptr<RequestHandler> ret = nullptr;
 
     if (startswith(link, std::string("/") + SERVER_VIRTUAL_DIR + "/" + CONTENT_MEDIA_HANDLER)) {
-        ret = std::make_unique<FileRequestHandler>(content, xmlbuilder.get());
+        ret = std::make_unique<FileRequestHandler>(content, xmlbuilder.get(), readAheadPool, fileRequestCache, thumbnailStore, playbackPredictor);
     } else if (startswith(link, std::string("/") + SERVER_VIRTUAL_DIR + "/" + CONTENT_UI_HANDLER)) {
         std::string parameters;
         std::string path;
@@ -499,8 +768,15 @@ std::unique_ptr<RequestHandler> Server::createRequestHandler(const char* filenam
         std::string r_type = it != params.end() && !it->second.empty() ? it->second : "index";
 
         ret = web::createWebRequestHandler(content, r_type);
+    } else if (startswith(link, std::string("/") + SERVER_VIRTUAL_DIR + "/" + CONTENT_ASSETS_HANDLER + "/")) {
+        ret = std::make_unique<AssetRequestHandler>(content);
+    } else if (startswith(link, std::string("/") + SERVER_VIRTUAL_DIR + "/" + CONTENT_METRICS_HANDLER)) {
+        if (!config->getBoolOption(CFG_SERVER_METRICS_ENABLED))
+            throw_std_runtime_error("Metrics are not enabled in configuration");
+
+        ret = std::make_unique<MetricsRequestHandler>(content);
     } else if (startswith(link, std::string("/") + SERVER_VIRTUAL_DIR + "/" + DEVICE_DESCRIPTION_PATH)) {
-        ret = std::make_unique<DeviceDescriptionHandler>(content, xmlbuilder.get());
+        ret = std::make_unique<DeviceDescriptionHandler>(content, device_description_document, deviceDescriptionTime);
     } else if (startswith(link, std::string("/") + SERVER_VIRTUAL_DIR + "/" + CONTENT_SERVE_HANDLER)) {
         if (config->getOption(CFG_SERVER_SERVEDIR).empty())
             throw_std_runtime_error("Serving directories is not enabled in configuration");
@@ -520,6 +796,19 @@ std::unique_ptr<RequestHandler> Server::createRequestHandler(const char* filenam
     return ret;
 }
 
+bool Server::isDataRequest(const std::string& link)
+{
+    auto isHandler = [&](const char* handler) { return startswith(link, fmt::format("/{}/{}", SERVER_VIRTUAL_DIR, handler)); };
+    return isHandler(CONTENT_MEDIA_HANDLER) || isHandler(CONTENT_ONLINE_HANDLER) || isHandler(CONTENT_SERVE_HANDLER);
+}
+
+/// \brief files, streams and pages opened by the virtual dir callbacks and not closed yet
+static Metrics::Gauge& openStreams()
+{
+    static auto& gauge = Metrics::getInstance().gauge("gerbera_open_streams", "Files, streams and pages being served");
+    return gauge;
+}
+
 int Server::registerVirtualDirCallbacks()
 {
     log_debug("Setting UpnpVirtualDir GetInfoCallback");
@@ -528,6 +817,7 @@ int Server::registerVirtualDirCallbacks()
             auto reqHandler = static_cast<const Server*>(cookie)->createRequestHandler(filename);
             std::string link = urlUnescape(filename);
             reqHandler->getInfo(link.c_str(), info);
+            *requestCookie = reqHandler->getRequestCookie();
             return 0;
         } catch (const ServerShutdownException& se) {
             return -1;
@@ -544,22 +834,33 @@ int Server::registerVirtualDirCallbacks()
 
     log_debug("Setting UpnpVirtualDir OpenCallback");
     ret = UpnpVirtualDir_set_OpenCallback([](const char* filename, enum UpnpOpenFileMode mode, const void* cookie, const void* requestCookie) -> UpnpWebFileHandle {
+        auto server = static_cast<const Server*>(cookie);
+        std::string link = urlUnescape(filename);
+        bool isData = isDataRequest(link);
+        if (isData && !server->admission->acquire(RequestAdmission::Kind::Data)) {
+            log_warning("All {} workers for data requests are busy, refusing {}", server->admission->getCapacity(RequestAdmission::Kind::Data), filename);
+            refusedRequests("data").inc();
+            return nullptr;
+        }
         try {
-            auto reqHandler = static_cast<const Server*>(cookie)->createRequestHandler(filename);
-            std::string link = urlUnescape(filename);
+            auto reqHandler = server->createRequestHandler(filename);
+            reqHandler->setRequestCookie(requestCookie);
             auto ioHandler = reqHandler->open(link.c_str(), mode);
+            openStreams().inc();
             auto ioPtr = UpnpWebFileHandle(ioHandler.release());
+            if (isData)
+                server->admission->holdStream(ioPtr);
             //log_debug("{} open({})", ioPtr, filename);
             return ioPtr;
         } catch (const ServerShutdownException& se) {
-            return nullptr;
         } catch (const SubtitlesNotFoundException& sex) {
             log_info("SubtitlesNotFoundException: {}", sex.what());
-            return nullptr;
         } catch (const std::runtime_error& ex) {
             log_error("Exception: {}", ex.what());
-            return nullptr;
         }
+        if (isData)
+            server->admission->release(RequestAdmission::Kind::Data);
+        return nullptr;
     });
     if (ret != UPNP_E_SUCCESS)
         return ret;
@@ -611,8 +912,10 @@ int Server::registerVirtualDirCallbacks()
             ret_close = -1;
         }
 
+        static_cast<const Server*>(cookie)->admission->releaseStream(f);
         delete handler;
         handler = nullptr;
+        openStreams().dec();
 
         return ret_close;
     });
@@ -32,6 +32,8 @@
 #ifndef __SERVER_H__
 #define __SERVER_H__
 
+#include <atomic>
+
 #include "action_request.h"
 #include "context.h"
 #include "request_handler.h"
@@ -39,10 +41,22 @@
 #include "upnp_cds.h"
 #include "upnp_cm.h"
 #include "upnp_mrreg.h"
+#include "util/thread_runner.h"
+#include "util/trace.h"
 
 // forward declaration
 class Timer;
 class ContentManager;
+class PlaybackPredictor;
+class ReadAheadPool;
+class BrowseCache;
+class BrowseSnapshot;
+class DidlCache;
+class FileRequestCache;
+class Profiler;
+class RequestAdmission;
+class ThumbnailStore;
+class WorkerPool;
 
 /// \brief Provides methods to initialize and shutdown
 /// and to retrieve various information about the server.
@@ -64,6 +78,12 @@ public:
     /// update manager task, database task, content manager.
     void shutdown();
 
+    /// \brief Reinitializes the parts that depend on reloadable options
+    ///
+    /// Called after ConfigManager::reload(), the UPnP device, the database
+    /// and running streams are not touched.
+    void reloadConfig();
+
     /// \brief Initializes UPnP portion, only ip or interface can be given
     ///
     /// Reads information from the config and creates a
@@ -72,6 +92,17 @@ public:
     /// web callbacks. Starts the update manager task.
     void run();
 
+    /// \brief Starts the content manager without the UPnP portion
+    ///
+    /// Used by the import benchmark and the scanner role, nothing is announced
+    /// on the network and the bookmark file of a running server is left alone.
+    void runContentOnly();
+
+    /// \brief Writes the database to a dump file or replaces it by one
+    ///
+    /// Used by --export-db and --import-db, only the database is opened.
+    static void transferDatabase(const std::shared_ptr<Config>& config, const fs::path& path, bool import);
+
     /// \brief Returns the content url of the server.
     ///
     /// Returns a string representation of the server url. Although
@@ -90,6 +121,20 @@ public:
 
     std::shared_ptr<ContentManager> getContent() const { return content; }
 
+    std::shared_ptr<Database> getDatabase() const { return database; }
+
+    /// \brief rendered DIDL-Lite of browsed objects
+    std::shared_ptr<DidlCache> getDidlCache() const { return didlCache; }
+
+    /// \brief Browse results sent to clients
+    std::shared_ptr<BrowseCache> getBrowseCache() const { return browseCache; }
+
+    /// \brief mapped copy of the tree, nullptr if disabled
+    std::shared_ptr<BrowseSnapshot> getBrowseSnapshot() const { return browseSnapshot; }
+
+    /// \brief CPU and heap profiles started by the admin
+    std::shared_ptr<Profiler> getProfiler() const { return profiler; }
+
 protected:
     std::shared_ptr<Config> config;
     std::shared_ptr<Clients> clients;
@@ -101,8 +146,55 @@ protected:
     std::shared_ptr<Timer> timer;
     std::shared_ptr<ContentManager> content;
 
+    /// \brief reads served files in advance, nullptr if disabled
+    std::shared_ptr<ReadAheadPool> readAheadPool;
+
+    /// \brief reads the start of the next track of albums and playlists, nullptr if disabled
+    std::shared_ptr<PlaybackPredictor> playbackPredictor;
+
+    /// \brief rendered objects, the update manager drops changed ones
+    std::shared_ptr<DidlCache> didlCache;
+
+    /// \brief whole Browse results, the update manager drops changed ones
+    std::shared_ptr<BrowseCache> browseCache;
+
+    /// \brief answers Browse requests without a query, the update manager marks changed containers
+    std::shared_ptr<BrowseSnapshot> browseSnapshot;
+
+    /// \brief renders large Browse and Search results in parts, nullptr on a single core
+    std::shared_ptr<WorkerPool> renderPool;
+
+    /// \brief file requests resolved by getInfo for the following open
+    std::shared_ptr<FileRequestCache> fileRequestCache;
+
+    /// \brief album art and thumbnails served from disk, nullptr if disabled
+    std::shared_ptr<ThumbnailStore> thumbnailStore;
+
+    /// \brief picks the UPnP actions to trace
+    std::unique_ptr<Tracer> tracer;
+
+    std::shared_ptr<Profiler> profiler;
+
+    /// \brief keeps libupnp workers free for control and for data requests
+    std::unique_ptr<RequestAdmission> admission;
+
     /// \brief This flag is set to true by the upnp_cleanup() function.
-    bool server_shutdown_flag;
+    std::atomic_bool server_shutdown_flag;
+
+    /// \brief loads the first levels of the tree after startup, nullptr if disabled
+    std::unique_ptr<StdThreadRunner> warmUpThread;
+
+    static void* staticWarmUpThread(void* arg);
+    void warmUpThreadProc();
+
+    /// \brief writes the browse snapshot after changes, nullptr if disabled
+    std::unique_ptr<StdThreadRunner> snapshotThread;
+
+    static void* staticSnapshotThread(void* arg);
+    void snapshotThreadProc();
+
+    /// \brief libupnp was initialised by run() and has to be finished on shutdown
+    bool upnpStarted { false };
 
     /// \brief Handle for our upnp callbacks.
     UpnpDevice_Handle rootDeviceHandle;
@@ -129,13 +221,15 @@ protected:
     /// is returned by the getVirtualURL() function.
     std::string virtualUrl;
 
-    /// \brief Device description document is created on the fly and
+    /// \brief Device description document is created once in run() and
     /// stored here.
     ///
     /// All necessary values for the device description document are
-    /// read from the configuration and the device desc doc is created
-    /// on the fly.
+    /// read from the configuration, a configuration reload creates a new
+    /// server and with it a new document. Every fetch is served from here.
     std::string device_description_document;
+    /// \brief time the device description document was rendered, sent as Last-Modified
+    time_t deviceDescriptionTime {};
 
     /// \brief Time interval to send ssdp:alive advertisements.
     ///
@@ -188,6 +282,9 @@ protected:
     ///
     std::unique_ptr<RequestHandler> createRequestHandler(const char* filename) const;
 
+    /// \brief whether the link is a file transfer that holds a worker while the file is served
+    static bool isDataRequest(const std::string& link);
+
     /// \brief Registers callback functions for the internal web server.
     ///
     /// This function registers callbacks for the internal web server.
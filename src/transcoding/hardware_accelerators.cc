@@ -0,0 +1,107 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    hardware_accelerators.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file hardware_accelerators.cc
+
+#include "hardware_accelerators.h" // API
+
+#include <algorithm>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/videodev2.h>
+#endif
+
+#include "util/logger.h"
+#include "util/tools.h"
+
+/// \brief pci vendor id of intel, quick sync is only offered by intel gpus
+static constexpr auto PCI_VENDOR_INTEL = "0x8086";
+
+HardwareAccelerators::HardwareAccelerators(const fs::path& root)
+{
+    for (auto&& node : findDevices(root / "dev/dri", "renderD")) {
+        available.insert(HW_VAAPI);
+        std::string vendor;
+        std::ifstream(root / "sys/class/drm" / node.filename() / "device/vendor") >> vendor;
+        if (vendor == PCI_VENDOR_INTEL)
+            available.insert(HW_QSV);
+    }
+
+    if (!findDevices(root / "dev", "nvidia").empty() && fs::exists(root / "dev/nvidiactl"))
+        available.insert(HW_NVENC);
+
+    auto video = findDevices(root / "dev", "video");
+    if (std::any_of(video.begin(), video.end(), isMemToMem))
+        available.insert(HW_V4L2M2M);
+
+    if (available.empty())
+        log_info("No video accelerators found, transcoding in software");
+    else
+        log_info("Video accelerators found: {}", join(getAvailable(), ", "));
+}
+
+bool HardwareAccelerators::isAvailable(const std::string& name) const
+{
+    return name.empty() || available.find(name) != available.end();
+}
+
+std::vector<fs::path> HardwareAccelerators::findDevices(const fs::path& dir, const std::string& prefix)
+{
+    std::vector<fs::path> result;
+    std::error_code ec;
+    for (auto&& entry : fs::directory_iterator(dir, ec)) {
+        auto name = entry.path().filename().string();
+        // nvidiactl and nvidia-uvm are no gpus
+        if (!startswith(name, prefix) || name.find_first_not_of("0123456789", prefix.size()) != std::string::npos || name.size() == prefix.size())
+            continue;
+        // without access to the device the transcoder fails as it would without the device
+        if (access(entry.path().c_str(), R_OK | W_OK) == 0)
+            result.push_back(entry.path());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+bool HardwareAccelerators::isMemToMem(const fs::path& device)
+{
+#ifdef __linux__
+    int fd = open(device.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+    struct v4l2_capability caps {
+    };
+    bool result = ioctl(fd, VIDIOC_QUERYCAP, &caps) == 0;
+    if (result) {
+        auto flags = (caps.capabilities & V4L2_CAP_DEVICE_CAPS) ? caps.device_caps : caps.capabilities;
+        result = (flags & (V4L2_CAP_VIDEO_M2M | V4L2_CAP_VIDEO_M2M_MPLANE)) != 0;
+    }
+    close(fd);
+    return result;
+#else
+    return false;
+#endif
+}
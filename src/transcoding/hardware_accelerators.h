@@ -0,0 +1,64 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    hardware_accelerators.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file hardware_accelerators.h
+#ifndef __HARDWARE_ACCELERATORS_H__
+#define __HARDWARE_ACCELERATORS_H__
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include <vector>
+namespace fs = std::filesystem;
+
+#define HW_VAAPI "vaapi"
+#define HW_QSV "qsv"
+#define HW_NVENC "nvenc"
+#define HW_V4L2M2M "v4l2m2m"
+
+/// \brief Video accelerators the transcoders can use on this machine
+///
+/// The devices are probed once at startup. A profile that requires an accelerator
+/// which was not found is skipped in favour of its fallback profile.
+class HardwareAccelerators {
+public:
+    /// \param root directory containing dev and sys, only changed by tests
+    explicit HardwareAccelerators(const fs::path& root = "/");
+
+    /// \brief true if name is empty or the accelerator was found
+    bool isAvailable(const std::string& name) const;
+
+    std::vector<std::string> getAvailable() const { return { available.begin(), available.end() }; }
+
+    /// \brief names that can be used in the hardware option of a profile
+    static std::vector<std::string> getKnown() { return { HW_VAAPI, HW_QSV, HW_NVENC, HW_V4L2M2M }; }
+
+protected:
+    /// \brief device nodes in dir starting with prefix that the server may open
+    static std::vector<fs::path> findDevices(const fs::path& dir, const std::string& prefix);
+    static bool isMemToMem(const fs::path& device);
+
+    std::set<std::string> available;
+};
+
+#endif // __HARDWARE_ACCELERATORS_H__
@@ -0,0 +1,317 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    hls_session_manager.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file hls_session_manager.cc
+
+#include "hls_session_manager.h" // API
+
+#include <algorithm>
+#include <fstream>
+#include <thread>
+
+#include "cds_objects.h"
+#include "metadata/metadata_handler.h"
+#include "transcode_scheduler.h"
+#include "transcoding.h"
+#include "transcoding_process_executor.h"
+#include "util/metrics.h"
+#include "util/tools.h"
+
+HlsSessionManager::HlsSessionManager(std::shared_ptr<Timer> timer, std::shared_ptr<TranscodeScheduler> scheduler,
+    fs::path tmpDir, std::chrono::seconds idleTimeout, int segmentsAhead)
+    : timer(std::move(timer))
+    , scheduler(std::move(scheduler))
+    , tmpDir(std::move(tmpDir))
+    , idleTimeout(idleTimeout)
+    , segmentsAhead(segmentsAhead)
+{
+}
+
+HlsSessionManager::~HlsSessionManager()
+{
+    shutdown();
+}
+
+std::vector<std::string> HlsSessionManager::readSegments(const fs::path& playlist)
+{
+    std::vector<std::string> segments;
+    std::ifstream file(playlist);
+    std::string line;
+    while (std::getline(file, line)) {
+        trimStringInPlace(line);
+        // the init segment of fragmented mp4 is in the map tag
+        auto uri = line.find("URI=\"");
+        if (startswith(line, "#EXT-X-MAP:") && uri != std::string::npos)
+            segments.push_back(fs::path(line.substr(uri + 5, line.find('"', uri + 5) - uri - 5)).filename());
+        else if (!line.empty() && line[0] != '#')
+            segments.push_back(fs::path(line).filename());
+    }
+    return segments;
+}
+
+std::string HlsSessionManager::getMasterPlaylist(const std::shared_ptr<CdsItem>& item, const std::vector<std::shared_ptr<TranscodingProfile>>& variants,
+    std::map<std::string, std::string> params)
+{
+    params.erase(URL_FILE_EXTENSION);
+    params[URL_PARAM_HLS_VARIANT] = "1";
+
+    // upnp bitrate is in bytes per second
+    auto bitrate = item->getResourceCount() > 0 ? std::strtoll(item->getResource(0)->getAttribute(R_BITRATE).c_str(), nullptr, 10) * 8 : 0;
+    std::string playlist = "#EXTM3U\n";
+    for (auto&& variant : variants) {
+        playlist += fmt::format("#EXT-X-STREAM-INF:BANDWIDTH={}", variant->getBandwidth() > 0 ? variant->getBandwidth() : bitrate);
+        auto resolution = getValueOrDefault(variant->getAttributes(), MetadataHandler::getResAttrName(R_RESOLUTION));
+        if (!resolution.empty())
+            playlist += fmt::format(",RESOLUTION={}", resolution);
+        params[URL_PARAM_TRANSCODE_PROFILE_NAME] = variant->getName();
+        playlist += fmt::format("\n{}{}\n", LINK_FILE_REQUEST_HANDLER, dictEncodeSimple(params));
+    }
+    return playlist;
+}
+
+std::string HlsSessionManager::getPlaylist(const std::shared_ptr<CdsItem>& item, const std::shared_ptr<TranscodingProfile>& profile,
+    const std::string& client, std::map<std::string, std::string> params, int start, bool& started)
+{
+    auto key = fmt::format("{}|{}|{}|{}", client, item->getID(), profile->getName(), start);
+    auto findSession = [&]() -> std::shared_ptr<Session> {
+        if (shutdownFlag)
+            throw_std_runtime_error("Server is shutting down");
+        auto it = std::find_if(sessions.begin(), sessions.end(), [&](auto&& entry) { return entry.second->key == key; });
+        return it != sessions.end() ? it->second : nullptr;
+    };
+
+    std::shared_ptr<Session> session;
+    {
+        AutoLock lock(mutex);
+        session = findSession();
+        if (session != nullptr)
+            session->lastAccess = Clock::now();
+    }
+
+    started = false;
+    if (session == nullptr) {
+        // waiting for a slot and starting the transcoder must not block the other sessions
+        auto newSession = startSession(item, profile, key, start);
+        {
+            AutoLock lock(mutex);
+            session = shutdownFlag ? nullptr : findSession();
+            if (session == nullptr && !shutdownFlag) {
+                session = newSession;
+                sessions[session->id] = session;
+                checkTimer();
+                started = true;
+            }
+        }
+        // another request of the client was faster
+        if (!started) {
+            stop(newSession);
+            if (session == nullptr)
+                throw_std_runtime_error("Server is shutting down");
+        }
+    }
+
+    if (!waitForSegment(session, ""))
+        throw_std_runtime_error("Transcoder of hls session {} did not write a segment", session->id);
+
+    params.erase(URL_FILE_EXTENSION);
+    params.erase(URL_PARAM_HLS_VARIANT);
+    params[URL_PARAM_HLS_SESSION] = session->id;
+    auto segmentUrl = [&](const std::string& name) {
+        params[URL_PARAM_HLS_FILE] = fs::path(name).filename();
+        return fmt::format("{}{}", LINK_FILE_REQUEST_HANDLER, dictEncodeSimple(params));
+    };
+
+    std::string playlist;
+    std::ifstream file(session->directory / HLS_PLAYLIST_NAME);
+    std::string line;
+    while (std::getline(file, line)) {
+        trimStringInPlace(line);
+        auto uri = line.find("URI=\"");
+        if (startswith(line, "#EXT-X-MAP:") && uri != std::string::npos) {
+            auto end = line.find('"', uri + 5);
+            line.replace(uri + 5, end - uri - 5, segmentUrl(line.substr(uri + 5, end - uri - 5)));
+        } else if (!line.empty() && line[0] != '#') {
+            line = segmentUrl(line);
+        }
+        playlist += line + "\n";
+    }
+    return playlist;
+}
+
+fs::path HlsSessionManager::getSegment(const std::string& sessionId, const std::string& name)
+{
+    if (name.empty() || fs::path(name).filename() != name || name == ".." || name == HLS_PLAYLIST_NAME)
+        throw_std_runtime_error("Invalid hls segment {}", name);
+
+    std::shared_ptr<Session> session;
+    {
+        AutoLock lock(mutex);
+        auto it = sessions.find(sessionId);
+        if (it == sessions.end())
+            throw_std_runtime_error("Hls session {} has ended", sessionId);
+        session = it->second;
+        session->lastAccess = Clock::now();
+    }
+
+    if (!waitForSegment(session, name))
+        throw_std_runtime_error("Transcoder of hls session {} did not write {}", sessionId, name);
+
+    AutoLock lock(mutex);
+    auto segments = readSegments(session->directory / HLS_PLAYLIST_NAME);
+    auto it = std::find(segments.begin(), segments.end(), name);
+    session->requested = std::max(session->requested, int(std::distance(segments.begin(), it)));
+    throttle(session, segments.size());
+    return session->directory / name;
+}
+
+bool HlsSessionManager::waitForSegment(const std::shared_ptr<Session>& session, const std::string& name)
+{
+    auto playlist = session->directory / HLS_PLAYLIST_NAME;
+    auto deadline = Clock::now() + std::chrono::seconds(HLS_SEGMENT_TIMEOUT);
+    while (true) {
+        // the playlist only lists segments that are complete
+        auto segments = readSegments(playlist);
+        if (name.empty() ? !segments.empty() : std::find(segments.begin(), segments.end(), name) != segments.end())
+            return true;
+
+        {
+            AutoLock lock(mutex);
+            if (shutdownFlag || session->process == nullptr || Clock::now() > deadline)
+                return false;
+            // the client is waiting, so it is not ahead anymore
+            session->process->setPaused(false);
+            if (!session->process->isAlive()) {
+                segments = readSegments(playlist);
+                return name.empty() ? !segments.empty() : std::find(segments.begin(), segments.end(), name) != segments.end();
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
+
+std::shared_ptr<HlsSessionManager::Session> HlsSessionManager::startSession(const std::shared_ptr<CdsItem>& item, const std::shared_ptr<TranscodingProfile>& profile, const std::string& key, int start)
+{
+    fs::path check = profile->getCommand().is_absolute() ? profile->getCommand() : findInPath(profile->getCommand());
+    int err = 0;
+    if (check.empty() || !isExecutable(check, &err))
+        throw_std_runtime_error("Transcoder {} is not executable: {}", profile->getCommand().c_str(), std::strerror(err));
+
+    auto slot = scheduler->acquire({ profile });
+
+    auto session = std::make_shared<Session>();
+    session->key = key;
+    session->id = generateRandomId();
+    std::string directory = tmpDir / "grb_hls_XXXXXX";
+    if (mkdtemp(directory.data()) == nullptr)
+        throw_std_runtime_error("Could not create hls directory {}: {}", directory, std::strerror(errno));
+    session->directory = directory;
+
+    auto arglist = populateCommandLine(profile->getArguments(), item->getLocation(), session->directory / HLS_PLAYLIST_NAME, "", item->getTitle(), start);
+    try {
+        session->process = std::make_shared<TranscodingProcessExecutor>(profile->getCommand(), arglist);
+    } catch (const std::runtime_error&) {
+        std::error_code ec;
+        fs::remove_all(session->directory, ec);
+        throw;
+    }
+    session->process->setSlot(std::move(slot));
+    session->lastAccess = Clock::now();
+    log_debug("Started hls session {} for {} in {}", session->id, item->getLocation().c_str(), session->directory.c_str());
+    return session;
+}
+
+void HlsSessionManager::throttle(const std::shared_ptr<Session>& session, std::size_t segments)
+{
+    if (segmentsAhead == 0 || session->process == nullptr)
+        return;
+    // segments are produced on demand, a client that stopped watching does not make the transcoder run to the end
+    session->process->setPaused(int(segments) - 1 - session->requested >= int(segmentsAhead));
+}
+
+void HlsSessionManager::stop(const std::shared_ptr<Session>& session)
+{
+    log_debug("Ending hls session {}", session->id);
+    if (session->process != nullptr)
+        session->process->kill();
+    std::error_code ec;
+    fs::remove_all(session->directory, ec);
+}
+
+void HlsSessionManager::checkTimer()
+{
+    static auto& sessionCount = Metrics::getInstance().gauge("gerbera_sessions", "Open sessions", Metrics::label("type", "hls"));
+    sessionCount.set(sessions.size());
+
+    if (timer == nullptr)
+        return;
+    if (!sessions.empty() && !timerAdded) {
+        timer->addTimerSubscriber(this, HLS_SESSION_CHECK_INTERVAL);
+        timerAdded = true;
+    } else if (sessions.empty() && timerAdded) {
+        timer->removeTimerSubscriber(this);
+        timerAdded = false;
+    }
+}
+
+void HlsSessionManager::timerNotify(std::shared_ptr<Timer::Parameter> parameter)
+{
+    std::vector<std::shared_ptr<Session>> expired;
+    {
+        AutoLock lock(mutex);
+        auto now = Clock::now();
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            auto session = it->second;
+            if (now - session->lastAccess > idleTimeout) {
+                expired.push_back(session);
+                it = sessions.erase(it);
+                continue;
+            }
+            throttle(session, readSegments(session->directory / HLS_PLAYLIST_NAME).size());
+            ++it;
+        }
+        checkTimer();
+    }
+
+    // killing takes a while, the other sessions go on meanwhile
+    for (auto&& session : expired)
+        stop(session);
+}
+
+void HlsSessionManager::shutdown()
+{
+    std::map<std::string, std::shared_ptr<Session>> ended;
+    {
+        AutoLock lock(mutex);
+        shutdownFlag = true;
+        std::swap(ended, sessions);
+        checkTimer();
+    }
+    for (auto&& [id, session] : ended)
+        stop(session);
+}
+
+std::size_t HlsSessionManager::getSessionCount()
+{
+    AutoLock lock(mutex);
+    return sessions.size();
+}
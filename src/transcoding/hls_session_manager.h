@@ -0,0 +1,117 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    hls_session_manager.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file hls_session_manager.h
+#ifndef __HLS_SESSION_MANAGER_H__
+#define __HLS_SESSION_MANAGER_H__
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "util/timer.h"
+namespace fs = std::filesystem;
+
+// forward declaration
+class CdsItem;
+class TranscodeScheduler;
+class TranscodingProcessExecutor;
+class TranscodingProfile;
+
+/// \brief Runs transcoders of hls profiles that write segments and a playlist into a directory per session
+///
+/// A session belongs to a client, an item, a profile and a start position. The playlist handed
+/// to the client refers back to the file request handler for each segment. The transcoder is
+/// stopped while it is more than the configured number of segments ahead of the client and
+/// continued as soon as the client catches up. Sessions without requests for the idle timeout
+/// are ended and their directory is removed.
+class HlsSessionManager : public Timer::Subscriber {
+public:
+    /// \param segmentsAhead segments the transcoder may be ahead of the client, 0 for no limit
+    HlsSessionManager(std::shared_ptr<Timer> timer, std::shared_ptr<TranscodeScheduler> scheduler,
+        fs::path tmpDir, std::chrono::seconds idleTimeout, int segmentsAhead);
+    ~HlsSessionManager() override;
+
+    /// \brief media playlist of the session of the client, the session is started if there is none
+    /// \param params url parameters of the request, the playlist links back to the file request handler with them
+    /// \param started is set if a transcoder was started for the request
+    std::string getPlaylist(const std::shared_ptr<CdsItem>& item, const std::shared_ptr<TranscodingProfile>& profile,
+        const std::string& client, std::map<std::string, std::string> params, int start, bool& started);
+
+    /// \brief playlist that lists the media playlists of all variants, the client picks one by its bandwidth
+    static std::string getMasterPlaylist(const std::shared_ptr<CdsItem>& item, const std::vector<std::shared_ptr<TranscodingProfile>>& variants,
+        std::map<std::string, std::string> params);
+
+    /// \brief segment of a session, waits until the transcoder finished it
+    fs::path getSegment(const std::string& sessionId, const std::string& name);
+
+    void timerNotify(std::shared_ptr<Timer::Parameter> parameter) override;
+
+    /// \brief end all sessions
+    void shutdown();
+
+    std::size_t getSessionCount();
+
+    /// \brief segment names listed in a playlist
+    static std::vector<std::string> readSegments(const fs::path& playlist);
+
+protected:
+    using Clock = std::chrono::steady_clock;
+
+    struct Session {
+        std::string id;
+        std::string key;
+        fs::path directory;
+        std::shared_ptr<TranscodingProcessExecutor> process;
+        Clock::time_point lastAccess;
+        /// \brief index of the newest segment the client asked for, -1 before the first
+        int requested { -1 };
+    };
+
+    std::shared_ptr<Session> startSession(const std::shared_ptr<CdsItem>& item, const std::shared_ptr<TranscodingProfile>& profile, const std::string& key, int start);
+    /// \brief wait until the playlist lists the segment, or any segment if name is empty
+    bool waitForSegment(const std::shared_ptr<Session>& session, const std::string& name);
+    /// \brief pause the transcoder if it is far enough ahead, the mutex must be held
+    void throttle(const std::shared_ptr<Session>& session, std::size_t segments);
+    static void stop(const std::shared_ptr<Session>& session);
+    /// \brief add or remove the timer subscription, the mutex must be held
+    void checkTimer();
+
+    std::shared_ptr<Timer> timer;
+    std::shared_ptr<TranscodeScheduler> scheduler;
+    fs::path tmpDir;
+    std::chrono::seconds idleTimeout;
+    std::size_t segmentsAhead;
+    bool timerAdded { false };
+    bool shutdownFlag { false };
+
+    std::map<std::string, std::shared_ptr<Session>> sessions;
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+};
+
+#endif // __HLS_SESSION_MANAGER_H__
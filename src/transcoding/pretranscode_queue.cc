@@ -0,0 +1,305 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    pretranscode_queue.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file pretranscode_queue.cc
+
+#include "pretranscode_queue.h" // API
+
+#include <ctime>
+#include <thread>
+
+#include "cds_objects.h"
+#include "config/config.h"
+#include "content/content_manager.h"
+#include "database/database.h"
+#include "hardware_accelerators.h"
+#include "iohandler/file_io_handler.h"
+#include "transcode_scheduler.h"
+#include "transcoding.h"
+#include "util/process_executor.h"
+#include "util/tools.h"
+
+/// \brief flagged items handed to one task, the next task picks up the rest
+static constexpr std::size_t PRETRANSCODE_BATCH_SIZE = 100;
+
+PretranscodeQueue::PretranscodeQueue(std::shared_ptr<Config> config, std::shared_ptr<Timer> timer)
+    : config(std::move(config))
+    , timer(std::move(timer))
+{
+    directory = this->config->getOption(CFG_TRANSCODING_PRETRANSCODE_DIR);
+    niceness = this->config->getIntOption(CFG_TRANSCODING_PRETRANSCODE_NICE);
+    auto hours = this->config->getOption(CFG_TRANSCODING_PRETRANSCODE_HOURS);
+    if (!hours.empty())
+        parseHourRange(hours, startHour, endHour);
+}
+
+PretranscodeQueue::~PretranscodeQueue()
+{
+    shutdown();
+}
+
+void PretranscodeQueue::run(std::shared_ptr<ContentManager> content)
+{
+    this->content = std::move(content);
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec) {
+        // the flagged items wait for the next start
+        log_error("Could not create pretranscode directory {}, transcoding ahead of time is disabled: {}", directory.c_str(), ec.message());
+        return;
+    }
+
+    // results of removed items and transcoders interrupted by the last shutdown
+    auto database = this->content->getContext()->getDatabase();
+    for (auto&& entry : fs::directory_iterator(directory, ec)) {
+        auto name = entry.path().filename().string();
+        bool keep = entry.path().extension() != ".part";
+        if (keep) {
+            try {
+                keep = database->loadObject(std::stoi(name))->isItem();
+            } catch (const std::exception&) {
+                keep = false;
+            }
+        }
+        if (!keep) {
+            log_debug("Removing stale pretranscoded file {}", entry.path().c_str());
+            fs::remove(entry.path(), ec);
+        }
+    }
+
+    timer->addTimerSubscriber(this, PRETRANSCODE_CHECK_INTERVAL);
+    timerAdded = true;
+}
+
+void PretranscodeQueue::shutdown()
+{
+    if (shutdownFlag.exchange(true))
+        return;
+    if (timerAdded)
+        timer->removeTimerSubscriber(this, nullptr, true);
+}
+
+bool PretranscodeQueue::isIdleTime() const
+{
+    if (startHour == endHour)
+        return true;
+    auto now = std::time(nullptr);
+    std::tm local {};
+    localtime_r(&now, &local);
+    return isInHourRange(local.tm_hour, startHour, endHour);
+}
+
+fs::path PretranscodeQueue::getPath(int objectID, const std::string& profileName) const
+{
+    return directory / fmt::format("{}-{}", objectID, escape(profileName, '_', '/'));
+}
+
+std::vector<std::shared_ptr<TranscodingProfile>> PretranscodeQueue::getMissing(const std::shared_ptr<CdsItem>& item)
+{
+    std::vector<std::shared_ptr<TranscodingProfile>> result;
+    if (item->isVirtual() || item->isExternalItem())
+        return result;
+
+    auto profiles = config->getTranscodingProfileListOption(CFG_TRANSCODING_PROFILE_LIST)->get(item->getMimeType());
+    if (profiles == nullptr)
+        return result;
+
+    auto resources = item->getResources();
+    AutoLock lock(mutex);
+    for (auto&& [name, profile] : *profiles) {
+        if (!profile->isPretranscode() || profile->getType() != TR_External || profile->isThumbnail())
+            continue;
+        if (failed.find({ item->getID(), profile->getName() }) != failed.end())
+            continue;
+        bool done = std::any_of(resources.begin(), resources.end(), [&](auto&& res) {
+            return res->getHandlerType() == CH_TRANSCODE && res->getOption(RESOURCE_OPTION_PROFILE) == profile->getName();
+        });
+        if (!done)
+            result.push_back(profile);
+    }
+    return result;
+}
+
+void PretranscodeQueue::mark(const std::shared_ptr<CdsItem>& item)
+{
+    if (!getMissing(item).empty())
+        item->setFlag(OBJECT_FLAG_PENDING_TRANSCODE);
+}
+
+void PretranscodeQueue::timerNotify(std::shared_ptr<Timer::Parameter> parameter)
+{
+    if (shutdownFlag || !isIdleTime())
+        return;
+
+    AutoLock lock(mutex);
+    if (!task.expired())
+        return;
+
+    auto objectIDs = content->getContext()->getDatabase()->getFlaggedObjectIDs(OBJECT_FLAG_PENDING_TRANSCODE);
+    if (objectIDs.empty())
+        return;
+    if (objectIDs.size() > PRETRANSCODE_BATCH_SIZE)
+        objectIDs.resize(PRETRANSCODE_BATCH_SIZE);
+
+    auto newTask = std::make_shared<PretranscodeTask>(shared_from_this(), objectIDs);
+    newTask->setDescription(fmt::format("Transcoding {} items ahead of time", objectIDs.size()));
+    newTask->setGroup("pretranscode");
+    task = newTask;
+    content->addTask(newTask, TaskPriority::Background);
+}
+
+bool PretranscodeQueue::transcode(int objectID)
+{
+    auto database = content->getContext()->getDatabase();
+    auto load = [&]() -> std::shared_ptr<CdsItem> {
+        try {
+            return std::dynamic_pointer_cast<CdsItem>(database->loadObject(objectID));
+        } catch (const ObjectNotFoundException&) {
+            return nullptr;
+        }
+    };
+
+    auto item = load();
+    if (item == nullptr)
+        return true;
+
+    std::vector<std::shared_ptr<CdsResource>> results;
+    for (auto&& profile : getMissing(item)) {
+        if (shutdownFlag || !isIdleTime())
+            return false;
+        try {
+            auto res = transcode(item, profile);
+            if (res == nullptr) {
+                AutoLock lock(mutex);
+                failed.emplace(objectID, profile->getName());
+            } else {
+                results.push_back(res);
+            }
+        } catch (const std::runtime_error& e) {
+            // the clients use all transcoder slots, try again later
+            log_debug("Transcoding {} ahead of time postponed: {}", item->getLocation().c_str(), e.what());
+            return false;
+        }
+    }
+
+    // the item may have changed while the transcoder was running
+    item = load();
+    if (item == nullptr)
+        return true;
+    for (auto&& res : results) {
+        auto resources = item->getResources();
+        resources.erase(std::remove_if(resources.begin(), resources.end(), [&](auto&& old) {
+            return old->getHandlerType() == CH_TRANSCODE && old->getOption(RESOURCE_OPTION_PROFILE) == res->getOption(RESOURCE_OPTION_PROFILE);
+        }),
+            resources.end());
+        resources.push_back(res);
+        item->setResources(resources);
+    }
+    item->clearFlag(OBJECT_FLAG_PENDING_TRANSCODE);
+    content->updateObject(item, true);
+    return true;
+}
+
+std::shared_ptr<CdsResource> PretranscodeQueue::transcode(const std::shared_ptr<CdsItem>& item, const std::shared_ptr<TranscodingProfile>& profile)
+{
+    if (!content->getHardwareAccelerators()->isAvailable(profile->getHardware())) {
+        log_warning("Not transcoding {} ahead of time, profile {} requires {}", item->getLocation().c_str(), profile->getName(), profile->getHardware());
+        return nullptr;
+    }
+
+    auto target = getPath(item->getID(), profile->getName());
+    auto partial = fs::path(target.string() + ".part");
+    auto slot = content->getTranscodeScheduler()->acquire({ profile });
+
+    log_info("Transcoding {} ahead of time with profile {}", item->getLocation().c_str(), profile->getName());
+    auto arglist = populateCommandLine(profile->getArguments(), item->getLocation(), partial, "", item->getTitle());
+    int status;
+    try {
+        ProcessExecutor process(profile->getCommand(), arglist, -1, niceness);
+        while (process.isAlive() && !shutdownFlag)
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        process.kill();
+        status = process.getStatus();
+    } catch (const std::runtime_error& e) {
+        log_warning("Transcoding {} ahead of time with profile {} failed: {}", item->getLocation().c_str(), profile->getName(), e.what());
+        return nullptr;
+    }
+
+    std::error_code ec;
+    auto size = fs::file_size(partial, ec);
+    if (shutdownFlag || status != 0 || ec || size == 0) {
+        if (!shutdownFlag)
+            log_warning("Transcoding {} ahead of time with profile {} failed with status {}", item->getLocation().c_str(), profile->getName(), status);
+        fs::remove(partial, ec);
+        return nullptr;
+    }
+    fs::rename(partial, target, ec);
+    if (ec) {
+        log_warning("Could not store {}: {}", target.c_str(), ec.message());
+        fs::remove(partial, ec);
+        return nullptr;
+    }
+
+    auto res = std::make_shared<CdsResource>(CH_TRANSCODE);
+    res->addAttribute(R_PROTOCOLINFO, renderProtocolInfo(profile->getTargetMimeType()));
+    res->addAttribute(R_RESOURCE_FILE, target.string());
+    res->addAttribute(R_SIZE, fmt::to_string(size));
+    auto duration = item->getResourceCount() > 0 ? item->getResource(0)->getAttribute(R_DURATION) : "";
+    if (!duration.empty())
+        res->addAttribute(R_DURATION, duration);
+    res->mergeAttributes(profile->getAttributes());
+    res->addOption(RESOURCE_OPTION_PROFILE, profile->getName());
+    return res;
+}
+
+PretranscodeTask::PretranscodeTask(std::shared_ptr<PretranscodeQueue> queue, std::vector<int> objectIDs)
+    : GenericTask(TranscodeTask)
+    , queue(std::move(queue))
+    , objectIDs(std::move(objectIDs))
+{
+    this->taskType = Pretranscode;
+    this->cancellable = false;
+}
+
+void PretranscodeTask::run()
+{
+    for (auto objectID : objectIDs) {
+        if (!isValid() || !queue->transcode(objectID))
+            break;
+    }
+}
+
+PretranscodedHandler::PretranscodedHandler(const std::shared_ptr<Context>& context)
+    : MetadataHandler(context)
+{
+}
+
+std::unique_ptr<IOHandler> PretranscodedHandler::serveContent(std::shared_ptr<CdsObject> obj, int resNum)
+{
+    fs::path path = obj->getResource(resNum)->getAttribute(R_RESOURCE_FILE);
+    std::error_code ec;
+    if (path.empty() || !isRegularFile(path, ec))
+        throw_std_runtime_error("Pretranscoded file {} of {} is not available", path.c_str(), obj->getLocation().c_str());
+    return std::make_unique<FileIOHandler>(path);
+}
@@ -0,0 +1,125 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    pretranscode_queue.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file pretranscode_queue.h
+#ifndef __PRETRANSCODE_QUEUE_H__
+#define __PRETRANSCODE_QUEUE_H__
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "metadata/metadata_handler.h"
+#include "util/generic_task.h"
+#include "util/timer.h"
+namespace fs = std::filesystem;
+
+// forward declaration
+class CdsItem;
+class CdsResource;
+class Config;
+class ContentManager;
+class TranscodingProfile;
+
+/// \brief Transcodes items ahead of time with the profiles marked for it
+///
+/// Items whose mime type maps to such a profile are flagged when they are added or updated.
+/// During the configured hours the flagged items are transcoded one after the other at low
+/// priority into the pretranscode directory. The result is attached to the item as a resource,
+/// so clients get a plain file with a known size instead of a live transcoder.
+class PretranscodeQueue : public Timer::Subscriber, public std::enable_shared_from_this<PretranscodeQueue> {
+public:
+    PretranscodeQueue(std::shared_ptr<Config> config, std::shared_ptr<Timer> timer);
+    ~PretranscodeQueue() override;
+
+    /// \brief remove leftovers of the last run and start looking for flagged items
+    void run(std::shared_ptr<ContentManager> content);
+    void shutdown();
+
+    /// \brief flag the item if a pretranscode profile maps it and the result is missing
+    void mark(const std::shared_ptr<CdsItem>& item);
+
+    /// \brief pretranscode profiles of the item without a result
+    std::vector<std::shared_ptr<TranscodingProfile>> getMissing(const std::shared_ptr<CdsItem>& item);
+
+    /// \brief transcode the flagged item with its missing profiles
+    /// \return false if the item has to wait for the next idle time
+    bool transcode(int objectID);
+
+    void timerNotify(std::shared_ptr<Timer::Parameter> parameter) override;
+
+    /// \brief file the result of the profile for the object is kept in
+    fs::path getPath(int objectID, const std::string& profileName) const;
+
+    /// \brief true if the current hour is one of the configured hours
+    bool isIdleTime() const;
+
+protected:
+    /// \brief run the transcoder for item
+    /// \return resource of the result, nullptr if the transcoder failed
+    /// \throws std::runtime_error if no transcoder slot is free
+    std::shared_ptr<CdsResource> transcode(const std::shared_ptr<CdsItem>& item, const std::shared_ptr<TranscodingProfile>& profile);
+
+    std::shared_ptr<Config> config;
+    std::shared_ptr<Timer> timer;
+    std::shared_ptr<ContentManager> content;
+    fs::path directory;
+    int niceness;
+    /// \brief start and end of the idle hours, the same for any time
+    int startHour { 0 };
+    int endHour { 0 };
+
+    std::atomic<bool> shutdownFlag { false };
+    bool timerAdded { false };
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    /// \brief the queued or running task, there is only one at a time
+    std::weak_ptr<GenericTask> task;
+    /// \brief object id and profile of failed transcodings, they are not tried again until restart
+    std::set<std::pair<int, std::string>> failed;
+};
+
+/// \brief Task that transcodes flagged items until the idle time is over
+class PretranscodeTask : public GenericTask {
+public:
+    PretranscodeTask(std::shared_ptr<PretranscodeQueue> queue, std::vector<int> objectIDs);
+    void run() override;
+
+protected:
+    std::shared_ptr<PretranscodeQueue> queue;
+    std::vector<int> objectIDs;
+};
+
+/// \brief Serves the pretranscoded resources
+class PretranscodedHandler : public MetadataHandler {
+public:
+    explicit PretranscodedHandler(const std::shared_ptr<Context>& context);
+    void fillMetadata(std::shared_ptr<CdsObject> obj) override { }
+    std::unique_ptr<IOHandler> serveContent(std::shared_ptr<CdsObject> obj, int resNum) override;
+};
+
+#endif // __PRETRANSCODE_QUEUE_H__
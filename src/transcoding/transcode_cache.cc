@@ -0,0 +1,321 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    transcode_cache.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file transcode_cache.cc
+
+#include "transcode_cache.h" // API
+
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "iohandler/io_handler.h"
+#include "util/tools.h"
+
+/// \brief bytes copied from the transcoder at once
+static constexpr std::size_t TRANSCODE_CACHE_CHUNK = 64 * 1024;
+/// \brief a transcoder without readers is stopped after this time
+static constexpr auto TRANSCODE_CACHE_IDLE_TIMEOUT = std::chrono::seconds(30);
+static constexpr auto TRANSCODE_CACHE_PREFIX = "transcode-";
+static constexpr auto TRANSCODE_CACHE_EXTENSION = ".cache";
+
+/// \brief reads one cache file and waits for the transcoder at the end of the data written so far
+class TranscodeCache::Reader : public IOHandler {
+public:
+    Reader(std::shared_ptr<TranscodeCache> cache, std::shared_ptr<Entry> entry)
+        : cache(std::move(cache))
+        , entry(std::move(entry))
+    {
+    }
+
+    ~Reader() override
+    {
+        if (fd >= 0)
+            Reader::close();
+    }
+
+    void open(enum UpnpOpenFileMode mode) override
+    {
+        if (mode != UPNP_READ)
+            throw_std_runtime_error("Cached transcoding output is read only");
+        fd = ::open(entry->file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw_std_runtime_error("Failed to open cache file {}: {}", entry->file.c_str(), std::strerror(errno));
+
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        entry->readers++;
+        entry->lastUsed = std::chrono::steady_clock::now();
+    }
+
+    size_t read(char* buf, size_t length) override
+    {
+        off_t available;
+        {
+            std::unique_lock<std::mutex> lock(cache->mutex);
+            while (pos >= entry->size && entry->state == State::Writing && !cache->shutdownFlag)
+                cache->cond.wait_for(lock, std::chrono::milliseconds(100));
+            available = entry->size - pos;
+            if (available <= 0)
+                return entry->state == State::Complete ? 0 : -1;
+        }
+
+        auto bytes = pread(fd, buf, std::min<off_t>(length, available), pos);
+        if (bytes < 0) {
+            log_error("Failed to read cache file {}: {}", entry->file.c_str(), std::strerror(errno));
+            return -1;
+        }
+        pos += bytes;
+        return bytes;
+    }
+
+    void seek(off_t offset, int whence) override
+    {
+        off_t target;
+        {
+            std::lock_guard<std::mutex> lock(cache->mutex);
+            if (whence == SEEK_SET)
+                target = offset;
+            else if (whence == SEEK_CUR)
+                target = pos + offset;
+            else if (whence == SEEK_END && entry->state == State::Complete)
+                target = entry->size + offset;
+            else
+                throw_std_runtime_error("Cannot seek from the end of output still being transcoded");
+
+            // the transcoder cannot be skipped ahead, so only what it produced is reachable
+            if (target < 0 || target > entry->size)
+                throw_std_runtime_error("Seek to {} outside of {} transcoded bytes", target, entry->size);
+        }
+        pos = target;
+    }
+
+    off_t tell() override { return pos; }
+
+    void close() override
+    {
+        if (fd < 0)
+            return;
+        ::close(fd);
+        fd = -1;
+
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        entry->readers--;
+        entry->lastUsed = std::chrono::steady_clock::now();
+        cache->evict();
+    }
+
+private:
+    std::shared_ptr<TranscodeCache> cache;
+    std::shared_ptr<Entry> entry;
+    int fd { -1 };
+    off_t pos { 0 };
+};
+
+TranscodeCache::TranscodeCache(fs::path directory, std::size_t capacity)
+    : directory(std::move(directory))
+    , capacity(capacity)
+{
+    std::error_code ec;
+    fs::create_directories(this->directory, ec);
+    if (ec)
+        throw_std_runtime_error("Failed to create transcoding cache {}: {}", this->directory.c_str(), ec.message());
+
+    // the index is not persistent, files of an earlier run are of no use
+    for (auto&& file : fs::directory_iterator(this->directory, ec)) {
+        auto name = file.path().filename().string();
+        if (startswith(name, TRANSCODE_CACHE_PREFIX) && file.path().extension() == TRANSCODE_CACHE_EXTENSION)
+            fs::remove(file.path(), ec);
+    }
+}
+
+TranscodeCache::~TranscodeCache()
+{
+    shutdown();
+}
+
+std::unique_ptr<IOHandler> TranscodeCache::get(const std::string& key)
+{
+    AutoLock lock(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end() || it->second->state == State::Failed)
+        return nullptr;
+
+    log_debug("Serving transcoded {} from cache {}", key, it->second->file.c_str());
+    it->second->lastUsed = std::chrono::steady_clock::now();
+    return std::make_unique<Reader>(shared_from_this(), it->second);
+}
+
+std::unique_ptr<IOHandler> TranscodeCache::add(const std::string& key, std::unique_ptr<IOHandler> source)
+{
+    auto entry = std::make_shared<Entry>();
+    entry->key = key;
+    entry->lastUsed = std::chrono::steady_clock::now();
+    {
+        AutoLock lock(mutex);
+        if (shutdownFlag)
+            throw_std_runtime_error("Transcoding cache is shut down");
+        entry->file = directory / fmt::format("{}{}{}", TRANSCODE_CACHE_PREFIX, nextFile++, TRANSCODE_CACHE_EXTENSION);
+    }
+
+    // created here so the reader can be opened right away
+    int fd = ::open(entry->file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+        throw_std_runtime_error("Failed to create cache file {}: {}", entry->file.c_str(), std::strerror(errno));
+
+    {
+        AutoLock lock(mutex);
+        auto old = entries.find(key);
+        if (old != entries.end())
+            remove(old->second);
+        entries[key] = entry;
+        writers++;
+    }
+
+    // the writer opens the source, the transcoder may take a while to open its end of the fifo
+    std::thread(&TranscodeCache::writeProc, this, entry, fd, std::move(source)).detach();
+    return std::make_unique<Reader>(shared_from_this(), entry);
+}
+
+void TranscodeCache::writeProc(const std::shared_ptr<Entry>& entry, int fd, std::unique_ptr<IOHandler> source)
+{
+    State result = State::Failed;
+    try {
+        source->open(UPNP_READ);
+        // the output of a transcoder in a pipe goes into the file without passing the buffer
+        bool canSplice = true;
+        std::vector<char> buffer;
+        while (true) {
+            {
+                AutoLock lock(mutex);
+                if (shutdownFlag)
+                    break;
+                if (entry->readers == 0 && std::chrono::steady_clock::now() - entry->lastUsed > TRANSCODE_CACHE_IDLE_TIMEOUT) {
+                    log_debug("Nobody reads {} anymore, stopping the transcoder", entry->key);
+                    break;
+                }
+            }
+
+            size_t bytes = SPLICE_UNSUPPORTED;
+            if (canSplice) {
+                bytes = source->splice(fd, TRANSCODE_CACHE_CHUNK);
+                canSplice = bytes != size_t(SPLICE_UNSUPPORTED);
+            }
+            bool copy = !canSplice;
+            if (copy) {
+                buffer.resize(TRANSCODE_CACHE_CHUNK);
+                bytes = source->read(buffer.data(), buffer.size());
+            }
+
+            if (bytes == 0) {
+                result = State::Complete;
+                break;
+            }
+            if (bytes == size_t(CHECK_SOCKET))
+                continue;
+            if (bytes == size_t(-1))
+                break;
+
+            if (copy && ::write(fd, buffer.data(), bytes) != ssize_t(bytes)) {
+                log_error("Failed to write cache file {}: {}", entry->file.c_str(), std::strerror(errno));
+                break;
+            }
+
+            AutoLock lock(mutex);
+            entry->size += bytes;
+            cond.notify_all();
+        }
+    } catch (const std::runtime_error& ex) {
+        log_error("Transcoding into {} failed: {}", entry->file.c_str(), ex.what());
+    }
+    ::close(fd);
+
+    try {
+        source->close();
+    } catch (const std::runtime_error& ex) {
+        log_debug("Closing transcoder of {}: {}", entry->key, ex.what());
+    }
+
+    AutoLock lock(mutex);
+    entry->state = result;
+    if (result == State::Failed)
+        remove(entry);
+    else
+        evict();
+    writers--;
+    cond.notify_all();
+}
+
+void TranscodeCache::evict()
+{
+    auto total = getSizeUnlocked();
+    while (total > capacity) {
+        std::shared_ptr<Entry> oldest;
+        for (auto&& [key, entry] : entries) {
+            if (entry->state == State::Complete && entry->readers == 0 && (oldest == nullptr || entry->lastUsed < oldest->lastUsed))
+                oldest = entry;
+        }
+        if (oldest == nullptr)
+            break;
+        log_debug("Evicting {} from transcoding cache", oldest->key);
+        total -= oldest->size;
+        remove(oldest);
+    }
+}
+
+void TranscodeCache::remove(const std::shared_ptr<Entry>& entry)
+{
+    auto it = entries.find(entry->key);
+    if (it != entries.end() && it->second == entry)
+        entries.erase(it);
+    if (::unlink(entry->file.c_str()) != 0 && errno != ENOENT)
+        log_warning("Failed to remove cache file {}: {}", entry->file.c_str(), std::strerror(errno));
+}
+
+std::size_t TranscodeCache::getSizeUnlocked() const
+{
+    std::size_t total = 0;
+    for (auto&& [key, entry] : entries)
+        total += entry->size;
+    return total;
+}
+
+std::size_t TranscodeCache::getSize()
+{
+    AutoLock lock(mutex);
+    return getSizeUnlocked();
+}
+
+void TranscodeCache::shutdown()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    shutdownFlag = true;
+    cond.notify_all();
+    cond.wait(lock, [this] { return writers == 0; });
+
+    for (auto&& [key, entry] : entries) {
+        std::error_code ec;
+        fs::remove(entry->file, ec);
+    }
+    entries.clear();
+}
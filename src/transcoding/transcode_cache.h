@@ -0,0 +1,104 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    transcode_cache.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file transcode_cache.h
+#ifndef __TRANSCODE_CACHE_H__
+#define __TRANSCODE_CACHE_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+namespace fs = std::filesystem;
+
+// forward declaration
+class IOHandler;
+
+/// \brief Keeps the output of transcoders on disk, so the same output is not produced twice
+///
+/// The transcoder writes into a cache file on a thread of its own and all clients
+/// asking for the same output read that file, waiting for the transcoder when they
+/// reach the end of what has been produced. A transcoder nobody reads from anymore is
+/// stopped after a while and its output dropped. Finished files are evicted least
+/// recently used first when the cache is over its size, files still being read are kept.
+/// The index is not kept across restarts.
+class TranscodeCache : public std::enable_shared_from_this<TranscodeCache> {
+public:
+    TranscodeCache(fs::path directory, std::size_t capacity);
+    ~TranscodeCache();
+
+    /// \brief reader for the cached output of key, nullptr if it is neither cached nor being produced
+    std::unique_ptr<IOHandler> get(const std::string& key);
+
+    /// \brief write the output of source into the cache and return a reader for it
+    std::unique_ptr<IOHandler> add(const std::string& key, std::unique_ptr<IOHandler> source);
+
+    /// \brief stop all transcoders and remove the cache files
+    void shutdown();
+
+    /// \brief bytes in the cache files
+    std::size_t getSize();
+
+protected:
+    class Reader;
+
+    enum class State {
+        Writing,
+        Complete,
+        Failed,
+    };
+
+    struct Entry {
+        std::string key;
+        fs::path file;
+        off_t size { 0 };
+        State state { State::Writing };
+        int readers { 0 };
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    /// \brief copy source into fd, the file of entry, runs on a thread of its own
+    void writeProc(const std::shared_ptr<Entry>& entry, int fd, std::unique_ptr<IOHandler> source);
+    /// \brief drop finished entries nobody reads until the cache fits, the mutex must be held
+    void evict();
+    /// \brief forget the entry and remove its file, readers keep their descriptor
+    void remove(const std::shared_ptr<Entry>& entry);
+    std::size_t getSizeUnlocked() const;
+
+    fs::path directory;
+    std::size_t capacity;
+    std::size_t nextFile { 0 };
+    std::map<std::string, std::shared_ptr<Entry>> entries;
+    bool shutdownFlag { false };
+    /// \brief number of running writer threads
+    int writers { 0 };
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    using AutoLock = std::lock_guard<std::mutex>;
+};
+
+#endif // __TRANSCODE_CACHE_H__
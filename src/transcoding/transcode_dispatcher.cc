@@ -45,14 +45,15 @@ TranscodeDispatcher::TranscodeDispatcher(std::shared_ptr<ContentManager> content
 std::unique_ptr<IOHandler> TranscodeDispatcher::serveContent(std::shared_ptr<TranscodingProfile> profile,
     std::string location,
     std::shared_ptr<CdsObject> obj,
-    const std::string& range)
+    const std::string& range,
+    int start)
 {
     if (profile == nullptr)
         throw_std_runtime_error("Transcoding of file {} requested but no profile given ", location.c_str());
 
     if (profile->getType() == TR_External) {
         auto tr_ext = std::make_unique<TranscodeExternalHandler>(content);
-        return tr_ext->serveContent(profile, location, obj, range);
+        return tr_ext->serveContent(profile, location, obj, range, start);
     }
 
     throw_std_runtime_error("Unknown transcoding type for profile {}", profile->getName().c_str());
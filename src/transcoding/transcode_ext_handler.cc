@@ -31,6 +31,7 @@
 
 #include "transcode_ext_handler.h" // API
 
+#include <algorithm>
 #include <climits>
 #include <csignal>
 #include <cstdio>
@@ -49,7 +50,11 @@
 #include "iohandler/file_io_handler.h"
 #include "iohandler/io_handler_chainer.h"
 #include "iohandler/process_io_handler.h"
+#include "iohandler/spool_io_handler.h"
 #include "metadata/metadata_handler.h"
+#include "hardware_accelerators.h"
+#include "transcode_cache.h"
+#include "transcoding_io_handler.h"
 #include "transcoding_process_executor.h"
 #include "util/process.h"
 #include "util/tools.h"
@@ -59,6 +64,28 @@
 #include "iohandler/curl_io_handler.h"
 #endif
 
+/// \brief create the pipe a transcoder writes its output to
+static void openPipe(int pipeFds[2])
+{
+#ifdef __linux__
+    int ret = pipe2(pipeFds, O_CLOEXEC);
+#else
+    int ret = pipe(pipeFds);
+    if (ret == 0) {
+        fcntl(pipeFds[0], F_SETFD, FD_CLOEXEC);
+        fcntl(pipeFds[1], F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    if (ret == -1) {
+        log_error("Failed to create pipe for the transcoding process: {}", std::strerror(errno));
+        throw_std_runtime_error("Could not create pipe");
+    }
+#ifdef F_SETPIPE_SZ
+    if (fcntl(pipeFds[0], F_SETPIPE_SZ, TRANSCODE_PIPE_SIZE) == -1)
+        log_debug("Could not enlarge transcoding pipe: {}", std::strerror(errno));
+#endif
+}
+
 TranscodeExternalHandler::TranscodeExternalHandler(std::shared_ptr<ContentManager> content)
     : TranscodeHandler(std::move(content))
 {
@@ -67,15 +94,51 @@ TranscodeExternalHandler::TranscodeExternalHandler(std::shared_ptr<ContentManage
 std::unique_ptr<IOHandler> TranscodeExternalHandler::serveContent(std::shared_ptr<TranscodingProfile> profile,
     std::string location,
     std::shared_ptr<CdsObject> obj,
-    const std::string& range)
+    const std::string& range,
+    int start)
 {
-    log_debug("Start transcoding file: {}", location.c_str());
+    log_debug("Start transcoding file: {} at {} ms", location.c_str(), start);
 
     if (profile == nullptr)
         throw_std_runtime_error("Transcoding of file {} requested but no profile given", location.c_str());
 
     bool isURL = obj->isExternalItem();
 
+    // the requested profile first, then the ones to use while its slots are taken
+    std::vector<std::shared_ptr<TranscodingProfile>> candidates { profile };
+    auto profiles = config->getTranscodingProfileListOption(CFG_TRANSCODING_PROFILE_LIST);
+    for (auto fallback = profiles->getByName(profile->getFallback()); fallback != nullptr; fallback = profiles->getByName(fallback->getFallback())) {
+        if (std::find(candidates.begin(), candidates.end(), fallback) != candidates.end())
+            break;
+        candidates.push_back(fallback);
+    }
+    // a fallback that can not seek would play from the beginning
+    if (start > 0)
+        candidates.erase(std::remove_if(candidates.begin() + 1, candidates.end(), [](auto&& fallback) { return !fallback->isSeekable(); }), candidates.end());
+    // profiles for an accelerator this machine lacks would fail at once
+    auto hardware = content->getHardwareAccelerators();
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](auto&& prof) { return !hardware->isAvailable(prof->getHardware()); }), candidates.end());
+    if (candidates.empty())
+        throw_std_runtime_error("Transcoding profile {} requires {}, which was not found, and has no usable fallback", profile->getName(), profile->getHardware());
+
+    // online content may never end, so only local files are cached
+    auto cache = isURL ? nullptr : content->getTranscodeCache();
+    auto cacheKey = [&](const std::shared_ptr<TranscodingProfile>& prof) {
+        return fmt::format("{}|{}|{}|{}|{}|{}", obj->getID(), prof->getName(), prof->getCommand().string(), prof->getArguments(), range, prof->isSeekable() ? start : 0);
+    };
+    if (cache != nullptr) {
+        for (auto&& candidate : candidates) {
+            auto cached = cache->get(cacheKey(candidate));
+            if (cached != nullptr) {
+                content->triggerPlayHook(obj);
+                return cached;
+            }
+        }
+    }
+
+    auto slot = content->getTranscodeScheduler()->acquire(candidates);
+    profile = slot->getProfile();
+
 #if 0
     std::string mimeType = profile->getTargetMimeType();
     if (obj->isItem()) {
@@ -139,10 +202,24 @@ std::unique_ptr<IOHandler> TranscodeExternalHandler::serveContent(std::shared_pt
                 std::unique_ptr<IOHandler> c_ioh = std::make_unique<CurlIOHandler>(config, url, nullptr,
                     config->getIntOption(CFG_EXTERNAL_TRANSCODING_CURL_BUFFER_SIZE),
                     config->getIntOption(CFG_EXTERNAL_TRANSCODING_CURL_FILL_SIZE));
+                // a read ahead on disk covers network hiccups that are longer than the buffer
+                SpoolIOHandler* spool = nullptr;
+                auto spoolSize = config->getIntOption(CFG_EXTERNAL_TRANSCODING_CURL_SPOOL_SIZE);
+                if (spoolSize > 0) {
+                    auto s_ioh = std::make_unique<SpoolIOHandler>(config, std::move(c_ioh), config->getOption(CFG_SERVER_TMPDIR), spoolSize);
+                    spool = s_ioh.get();
+                    c_ioh = std::move(s_ioh);
+                }
                 std::unique_ptr<IOHandler> p_ioh = std::make_unique<ProcessIOHandler>(content, location, nullptr);
-                auto ch = std::make_shared<IOHandlerChainer>(c_ioh, p_ioh, 16384);
+                auto ch = std::make_shared<IOHandlerChainer>(c_ioh, p_ioh, 16384, config);
                 auto pr_item = std::make_shared<ProcListItem>(ch);
                 proc_list.push_back(pr_item);
+
+                auto spoolFill = config->getIntOption(CFG_EXTERNAL_TRANSCODING_CURL_SPOOL_FILL_SIZE);
+                if (spool != nullptr && spoolFill > 0) {
+                    [[maybe_unused]] auto fill = spool->waitForFill(spoolFill, std::chrono::seconds(CURL_SPOOL_FILL_TIMEOUT));
+                    log_debug("Read {} bytes of {} ahead before starting the transcoder", fill, url.c_str());
+                }
             } catch (const std::runtime_error& ex) {
                 unlink(location.c_str());
                 throw ex;
@@ -173,27 +250,85 @@ std::unique_ptr<IOHandler> TranscodeExternalHandler::serveContent(std::shared_pt
     if (!isExecutable(check, &err))
         throw_std_runtime_error("Transcoder {} is not executable: {}", profile->getCommand().c_str(), std::strerror(err));
 
-    log_debug("creating fifo: {}", fifo_name.c_str());
-    if (mkfifo(fifo_name.c_str(), O_RDWR) == -1) {
-        log_error("Failed to create fifo for the transcoding process!: {}", std::strerror(errno));
-        throw_std_runtime_error("Could not create fifo");
-    }
+    // the transcoder writes either into an anonymous pipe it inherits or into a fifo
+    bool usePipe = config->getBoolOption(CFG_TRANSCODING_USE_PIPES);
+    int pipeFds[2] = { -1, -1 };
+    std::string output;
+    if (usePipe) {
+        openPipe(pipeFds);
+        output = fmt::format("/dev/fd/{}", ProcessExecutor::OUTPUT_FD);
+    } else {
+        log_debug("creating fifo: {}", fifo_name.c_str());
+        if (mkfifo(fifo_name.c_str(), O_RDWR) == -1) {
+            log_error("Failed to create fifo for the transcoding process!: {}", std::strerror(errno));
+            throw_std_runtime_error("Could not create fifo");
+        }
 
-    chmod(fifo_name.c_str(), S_IWUSR | S_IRUSR);
+        chmod(fifo_name.c_str(), S_IWUSR | S_IRUSR);
+        output = fifo_name;
+    }
 
-    arglist = populateCommandLine(profile->getArguments(), location, fifo_name, range, obj->getTitle());
+    arglist = populateCommandLine(profile->getArguments(), location, output, range, obj->getTitle(), start);
 
     log_debug("Command: {}", profile->getCommand().c_str());
     log_debug("Arguments: {}", profile->getArguments().c_str());
-    auto main_proc = std::make_shared<TranscodingProcessExecutor>(profile->getCommand(), arglist);
-    main_proc->removeFile(fifo_name);
+    std::shared_ptr<TranscodingProcessExecutor> main_proc;
+    try {
+        main_proc = std::make_shared<TranscodingProcessExecutor>(profile->getCommand(), arglist, pipeFds[1], true);
+    } catch (const std::runtime_error&) {
+        if (usePipe) {
+            ::close(pipeFds[0]);
+            ::close(pipeFds[1]);
+        } else {
+            unlink(fifo_name.c_str());
+        }
+        throw;
+    }
+    if (usePipe) {
+        // only the child may keep the write end, otherwise the end of the output is never seen
+        ::close(pipeFds[1]);
+    } else {
+        main_proc->removeFile(fifo_name);
+    }
+    main_proc->setSlot(std::move(slot));
     if (isURL && (!profile->acceptURL())) {
         main_proc->removeFile(location);
     }
 
     content->triggerPlayHook(obj);
 
-    std::unique_ptr<IOHandler> u_ioh = std::make_unique<ProcessIOHandler>(content, fifo_name, main_proc, proc_list);
+    auto stallTimeout = std::chrono::seconds(config->getIntOption(CFG_TRANSCODING_STALL_TIMEOUT));
+    std::unique_ptr<IOHandler> u_ioh;
+    if (usePipe) {
+        // only a transcoder that can seek and reads the source itself can continue where it stopped
+        TranscodingIOHandler::Restarter restarter;
+        if (profile->isSeekable() && (!isURL || profile->acceptURL())) {
+            restarter = [profile, location, output, range, title = obj->getTitle(), position = start](long progress, int& pipeFd) mutable {
+                position += static_cast<int>(progress);
+                int fds[2];
+                openPipe(fds);
+                auto args = populateCommandLine(profile->getArguments(), location, output, range, title, position);
+                std::shared_ptr<TranscodingProcessExecutor> proc;
+                try {
+                    proc = std::make_shared<TranscodingProcessExecutor>(profile->getCommand(), args, fds[1], true);
+                } catch (const std::runtime_error&) {
+                    ::close(fds[0]);
+                    ::close(fds[1]);
+                    throw;
+                }
+                ::close(fds[1]);
+                pipeFd = fds[0];
+                return proc;
+            };
+        }
+        u_ioh = std::make_unique<TranscodingIOHandler>(content, pipeFds[0], main_proc, proc_list,
+            stallTimeout, config->getIntOption(CFG_TRANSCODING_STALL_RESTARTS), restarter);
+    } else {
+        u_ioh = std::make_unique<TranscodingIOHandler>(content, fifo_name, main_proc, proc_list, stallTimeout);
+    }
+    if (cache != nullptr)
+        return cache->add(cacheKey(profile), std::move(u_ioh));
+
     auto io_handler = std::make_unique<BufferedIOHandler>(
         config, u_ioh,
         profile->getBufferSize(), profile->getBufferChunkSize(), profile->getBufferInitialFillSize());
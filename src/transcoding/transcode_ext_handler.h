@@ -45,7 +45,8 @@ public:
     std::unique_ptr<IOHandler> serveContent(std::shared_ptr<TranscodingProfile> profile,
         std::string location,
         std::shared_ptr<CdsObject> obj,
-        const std::string& range) override;
+        const std::string& range,
+        int start) override;
 };
 
 #endif // __TRANSCODE_EXTERNAL_HANDLER_H__
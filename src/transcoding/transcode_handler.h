@@ -53,7 +53,8 @@ public:
     virtual std::unique_ptr<IOHandler> serveContent(std::shared_ptr<TranscodingProfile> profile,
         std::string location,
         std::shared_ptr<CdsObject> obj,
-        const std::string& range)
+        const std::string& range,
+        int start)
         = 0;
 
     virtual ~TranscodeHandler() = default;
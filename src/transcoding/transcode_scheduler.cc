@@ -0,0 +1,142 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    transcode_scheduler.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file transcode_scheduler.cc
+
+#include "transcode_scheduler.h" // API
+
+#include "transcoding.h"
+#include "util/tools.h"
+
+TranscodeScheduler::Slot::Slot(std::shared_ptr<TranscodeScheduler> scheduler, std::shared_ptr<TranscodingProfile> profile)
+    : scheduler(std::move(scheduler))
+    , profile(std::move(profile))
+    , start(std::chrono::steady_clock::now())
+{
+}
+
+TranscodeScheduler::Slot::~Slot()
+{
+    scheduler->release(*this);
+}
+
+TranscodeScheduler::TranscodeScheduler(int maxConcurrent, std::chrono::milliseconds queueTimeout)
+    : maxConcurrent(maxConcurrent)
+    , queueTimeout(queueTimeout)
+{
+}
+
+TranscodeScheduler::ProfileState& TranscodeScheduler::getState(const std::shared_ptr<TranscodingProfile>& profile)
+{
+    auto& state = profiles[profile->getName()];
+    state.name = profile->getName();
+    state.limit = profile->getMaxConcurrent();
+    return state;
+}
+
+int TranscodeScheduler::findFree(const std::vector<std::shared_ptr<TranscodingProfile>>& candidates)
+{
+    if (maxConcurrent > 0 && running >= maxConcurrent)
+        return -1;
+    for (std::size_t i = 0; i < candidates.size(); i++) {
+        auto& state = getState(candidates.at(i));
+        if (state.limit == 0 || state.running < state.limit)
+            return i;
+    }
+    return -1;
+}
+
+std::unique_ptr<TranscodeScheduler::Slot> TranscodeScheduler::acquire(const std::vector<std::shared_ptr<TranscodingProfile>>& candidates)
+{
+    if (candidates.empty())
+        throw_std_runtime_error("No transcoding profile given");
+
+    std::unique_lock<std::mutex> lock(mutex);
+    int index = findFree(candidates);
+    if (index < 0 && !shutdownFlag) {
+        log_debug("Waiting for a transcoding slot for {}", candidates.front()->getName());
+        queued++;
+        cond.wait_for(lock, queueTimeout, [&] { return shutdownFlag || (index = findFree(candidates)) >= 0; });
+        queued--;
+    }
+    if (shutdownFlag || index < 0) {
+        getState(candidates.front()).rejected++;
+        throw_std_runtime_error("All transcoding slots for {} are busy", candidates.front()->getName());
+    }
+
+    auto profile = candidates.at(index);
+    auto& state = getState(profile);
+    state.running++;
+    state.started++;
+    if (index > 0) {
+        log_debug("Transcoding with {} as {} is busy", profile->getName(), candidates.front()->getName());
+        state.fallbacks++;
+    }
+    running++;
+    return std::make_unique<Slot>(shared_from_this(), profile);
+}
+
+void TranscodeScheduler::release(const Slot& slot)
+{
+    AutoLock lock(mutex);
+    auto& state = getState(slot.profile);
+    state.running--;
+    state.bytes += slot.bytes;
+    state.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - slot.start).count();
+    state.mediaSeconds += slot.progress / 1000.0;
+    state.stalls += slot.stalls;
+    state.restarts += slot.restarts;
+    if (slot.failed)
+        state.failures++;
+    running--;
+    cond.notify_all();
+}
+
+void TranscodeScheduler::shutdown()
+{
+    AutoLock lock(mutex);
+    shutdownFlag = true;
+    cond.notify_all();
+}
+
+int TranscodeScheduler::getRunning()
+{
+    AutoLock lock(mutex);
+    return running;
+}
+
+int TranscodeScheduler::getQueued()
+{
+    AutoLock lock(mutex);
+    return queued;
+}
+
+std::vector<TranscodeScheduler::ProfileState> TranscodeScheduler::getProfileStates()
+{
+    AutoLock lock(mutex);
+    std::vector<ProfileState> result;
+    result.reserve(profiles.size());
+    for (auto&& [name, state] : profiles)
+        result.push_back(state);
+    return result;
+}
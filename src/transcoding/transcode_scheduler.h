@@ -0,0 +1,138 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    transcode_scheduler.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file transcode_scheduler.h
+#ifndef __TRANSCODE_SCHEDULER_H__
+#define __TRANSCODE_SCHEDULER_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// forward declaration
+class TranscodingProfile;
+
+/// \brief Limits the number of transcoders running at once
+///
+/// There is a global limit and each profile can have a limit of its own. A request for a
+/// transcoder waits for a free slot up to the queue timeout and is rejected afterwards.
+/// A request lists the acceptable profiles in order of preference, so a hardware profile
+/// with few slots can fall back to a software profile while its slots are taken.
+class TranscodeScheduler : public std::enable_shared_from_this<TranscodeScheduler> {
+public:
+    /// \brief a taken slot, it is given back when the slot is destroyed
+    class Slot {
+    public:
+        Slot(std::shared_ptr<TranscodeScheduler> scheduler, std::shared_ptr<TranscodingProfile> profile);
+        ~Slot();
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+
+        /// \brief the profile the slot was taken for
+        std::shared_ptr<TranscodingProfile> getProfile() const { return profile; }
+
+        /// \brief count output of the transcoder, added to the profile when the slot is given back
+        void addBytes(std::size_t length) { bytes += length; }
+        /// \brief milliseconds of media the transcoder reported as done
+        void setProgress(long ms) { progress = ms; }
+        void addStall() { stalls++; }
+        void addRestart() { restarts++; }
+        /// \brief the transcoder exited with an error
+        void setFailed() { failed = true; }
+
+    private:
+        friend class TranscodeScheduler;
+
+        std::shared_ptr<TranscodeScheduler> scheduler;
+        std::shared_ptr<TranscodingProfile> profile;
+        std::chrono::steady_clock::time_point start;
+        std::atomic<std::uint64_t> bytes { 0 };
+        std::atomic_long progress { 0 };
+        std::atomic_int stalls { 0 };
+        std::atomic_int restarts { 0 };
+        std::atomic_bool failed { false };
+    };
+
+    /// \brief slot usage of one profile
+    struct ProfileState {
+        std::string name;
+        int running { 0 };
+        /// \brief 0 if unlimited
+        int limit { 0 };
+        int started { 0 };
+        /// \brief slots given to this profile because a preferred one was busy
+        int fallbacks { 0 };
+        int rejected { 0 };
+
+        /// \brief totals of the slots given back so far
+        std::uint64_t bytes { 0 };
+        double seconds { 0 };
+        /// \brief media time transcoded, less than seconds if the profile is slower than real time
+        double mediaSeconds { 0 };
+        /// \brief transcoders that stopped producing output while running
+        int stalls { 0 };
+        int restarts { 0 };
+        int failures { 0 };
+    };
+
+    /// \param maxConcurrent transcoders running at once, 0 for no limit
+    /// \param queueTimeout time a request waits for a free slot, 0 rejects at once
+    TranscodeScheduler(int maxConcurrent, std::chrono::milliseconds queueTimeout);
+
+    /// \brief take a slot for the first of candidates with a free slot
+    /// \throws std::runtime_error if no slot got free within the queue timeout
+    std::unique_ptr<Slot> acquire(const std::vector<std::shared_ptr<TranscodingProfile>>& candidates);
+
+    /// \brief reject all waiting and future requests
+    void shutdown();
+
+    int getRunning();
+    int getQueued();
+    int getLimit() const { return maxConcurrent; }
+    /// \brief state of all profiles used so far
+    std::vector<ProfileState> getProfileStates();
+
+protected:
+    void release(const Slot& slot);
+    /// \brief index of the first candidate with a free slot or -1, the mutex must be held
+    int findFree(const std::vector<std::shared_ptr<TranscodingProfile>>& candidates);
+    ProfileState& getState(const std::shared_ptr<TranscodingProfile>& profile);
+
+    int maxConcurrent;
+    std::chrono::milliseconds queueTimeout;
+    int running { 0 };
+    int queued { 0 };
+    bool shutdownFlag { false };
+    std::map<std::string, ProfileState> profiles;
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    using AutoLock = std::lock_guard<std::mutex>;
+};
+
+#endif // __TRANSCODE_SCHEDULER_H__
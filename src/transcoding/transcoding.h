@@ -46,7 +46,8 @@ namespace fs = std::filesystem;
 enum transcoding_type_t {
     TR_None,
     TR_External,
-    TR_Remote
+    TR_Remote,
+    TR_Hls
 };
 
 enum avi_fourcc_listmode_t {
@@ -114,6 +115,9 @@ public:
     /// \brief retrieves the argument string
     std::string getArguments() const { return args; }
 
+    /// \brief profiles that pass the %start token to the transcoder can start at any position
+    bool isSeekable() const { return args.find("%start") != std::string::npos; }
+
     /// \brief identifies if the profile should be set as the first resource
     void setFirstResource(bool fr) { first_resource = fr; }
     bool firstResource() const { return first_resource; }
@@ -180,6 +184,31 @@ public:
     void setNumChannels(int chans) { number_of_channels = chans; }
     int getNumChannels() const { return number_of_channels; }
 
+    /// \brief Number of transcoders of this profile running at once, 0 for no limit
+    void setMaxConcurrent(int max) { max_concurrent = max; }
+    int getMaxConcurrent() const { return max_concurrent; }
+
+    /// \brief Profile used while all slots of this one are taken,
+    /// e.g. a software encoder for a hardware accelerated profile
+    void setFallback(const std::string& fallback) { this->fallback = fallback; }
+    std::string getFallback() const { return fallback; }
+
+    /// \brief Video accelerator the transcoder needs, e.g. vaapi, empty if it runs in software
+    void setHardware(const std::string& hardware) { this->hardware = hardware; }
+    std::string getHardware() const { return hardware; }
+
+    /// \brief Transcode the items mapped to this profile in the background and store the result
+    void setPretranscode(bool pretranscode) { this->pretranscode = pretranscode; }
+    bool isPretranscode() const { return pretranscode; }
+
+    /// \brief Bandwidth in bits per second announced for a HLS variant
+    void setBandwidth(int bandwidth) { this->bandwidth = bandwidth; }
+    int getBandwidth() const { return bandwidth; }
+
+    /// \brief HLS profiles offered next to this one in the master playlist
+    void setVariants(std::vector<std::string> variants) { this->variants = std::move(variants); }
+    std::vector<std::string> getVariants() const { return variants; }
+
     static std::string mapFourCcMode(avi_fourcc_listmode_t mode);
 
 protected:
@@ -200,6 +229,12 @@ protected:
     transcoding_type_t tr_type;
     int number_of_channels;
     int sample_frequency;
+    int max_concurrent;
+    std::string fallback;
+    std::string hardware;
+    bool pretranscode { false };
+    int bandwidth;
+    std::vector<std::string> variants;
     std::map<std::string, std::string> attributes;
     std::vector<std::string> fourcc_list;
     avi_fourcc_listmode_t fourcc_mode;
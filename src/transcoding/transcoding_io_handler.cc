@@ -0,0 +1,117 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    transcoding_io_handler.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file transcoding_io_handler.cc
+
+#include "transcoding_io_handler.h" // API
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "content/content_manager.h"
+#include "transcoding.h"
+#include "transcoding_process_executor.h"
+
+TranscodingIOHandler::TranscodingIOHandler(std::shared_ptr<ContentManager> content,
+    int pipeFd, const std::shared_ptr<TranscodingProcessExecutor>& mainProc,
+    std::vector<std::shared_ptr<ProcListItem>> procList,
+    std::chrono::seconds stallTimeout, int restarts, Restarter restarter)
+    : ProcessIOHandler(std::move(content), pipeFd, mainProc, std::move(procList))
+    , transcoder(mainProc)
+    , stallTimeout(stallTimeout)
+    , restarts(restarter != nullptr ? restarts : 0)
+    , restarter(std::move(restarter))
+{
+}
+
+TranscodingIOHandler::TranscodingIOHandler(std::shared_ptr<ContentManager> content,
+    const fs::path& filename, const std::shared_ptr<TranscodingProcessExecutor>& mainProc,
+    std::vector<std::shared_ptr<ProcListItem>> procList,
+    std::chrono::seconds stallTimeout)
+    : ProcessIOHandler(std::move(content), filename, mainProc, std::move(procList))
+    , transcoder(mainProc)
+    , stallTimeout(stallTimeout)
+{
+}
+
+void TranscodingIOHandler::onData(size_t length)
+{
+    auto slot = transcoder->getSlot();
+    if (slot != nullptr)
+        slot->addBytes(length);
+    transcoder->readErrors();
+}
+
+bool TranscodingIOHandler::onIdle(std::chrono::steady_clock::duration idle)
+{
+    transcoder->readErrors();
+    if (stallTimeout.count() == 0 || idle < stallTimeout)
+        return true;
+
+    auto slot = transcoder->getSlot();
+    auto name = slot != nullptr ? slot->getProfile()->getName() : std::string();
+    if (slot != nullptr)
+        slot->addStall();
+
+    if (restarts > 0 && transcoder->getProgress() >= 0) {
+        log_warning("Transcoder of profile {} wrote nothing for {} s, restarting it at {} ms", name, stallTimeout.count(), transcoder->getProgress());
+        restarts--;
+        if (restart())
+            return true;
+    } else {
+        log_warning("Transcoder of profile {} wrote nothing for {} s, stopping it: {}", name, stallTimeout.count(), transcoder->getLastMessage());
+    }
+
+    mainProc->kill();
+    killAll();
+    return false;
+}
+
+bool TranscodingIOHandler::restart()
+{
+    // a hardware transcoder may hold the device, so the old one goes first
+    transcoder->kill();
+
+    int pipeFd = -1;
+    std::shared_ptr<TranscodingProcessExecutor> next;
+    try {
+        next = restarter(transcoder->getProgress(), pipeFd);
+    } catch (const std::runtime_error& e) {
+        log_error("Could not restart transcoder: {}", e.what());
+        return false;
+    }
+
+    content->unregisterExecutor(mainProc);
+    next->setSlot(transcoder->takeSlot());
+    if (next->getSlot() != nullptr)
+        next->getSlot()->addRestart();
+
+    ::close(fd);
+    fd = pipeFd;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    transcoder = next;
+    mainProc = next;
+    content->registerExecutor(mainProc);
+    idleSince = std::chrono::steady_clock::time_point();
+    return true;
+}
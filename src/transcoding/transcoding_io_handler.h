@@ -0,0 +1,74 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    transcoding_io_handler.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file transcoding_io_handler.h
+#ifndef __TRANSCODING_IO_HANDLER_H__
+#define __TRANSCODING_IO_HANDLER_H__
+
+#include <chrono>
+#include <functional>
+#include <memory>
+
+#include "iohandler/process_io_handler.h"
+
+// forward declaration
+class TranscodingProcessExecutor;
+
+/// \brief Reads the output of a transcoder and watches its health
+///
+/// A transcoder that is still running but has not written anything for the stall timeout
+/// is killed. If a restarter is given, it is started again at the last position it reported,
+/// otherwise the stream ends. Output, stalls and restarts are counted in the transcoder's slot.
+class TranscodingIOHandler : public ProcessIOHandler {
+public:
+    /// \brief start a new transcoder at progress milliseconds after the last start
+    /// \param pipeFd receives the read end of the output pipe of the new transcoder
+    using Restarter = std::function<std::shared_ptr<TranscodingProcessExecutor>(long progress, int& pipeFd)>;
+
+    /// \param stallTimeout time without output before the transcoder counts as stalled, 0 to wait forever
+    /// \param restarts restart a stalled transcoder this many times
+    TranscodingIOHandler(std::shared_ptr<ContentManager> content,
+        int pipeFd, const std::shared_ptr<TranscodingProcessExecutor>& mainProc,
+        std::vector<std::shared_ptr<ProcListItem>> procList,
+        std::chrono::seconds stallTimeout, int restarts = 0, Restarter restarter = nullptr);
+
+    /// \param filename fifo the transcoder writes to, it cannot be restarted
+    TranscodingIOHandler(std::shared_ptr<ContentManager> content,
+        const fs::path& filename, const std::shared_ptr<TranscodingProcessExecutor>& mainProc,
+        std::vector<std::shared_ptr<ProcListItem>> procList,
+        std::chrono::seconds stallTimeout);
+
+protected:
+    void onData(size_t length) override;
+    bool onIdle(std::chrono::steady_clock::duration idle) override;
+
+    /// \brief replace the stalled transcoder, false if that failed
+    bool restart();
+
+    std::shared_ptr<TranscodingProcessExecutor> transcoder;
+    std::chrono::seconds stallTimeout;
+    int restarts { 0 };
+    Restarter restarter;
+};
+
+#endif // __TRANSCODING_IO_HANDLER_H__
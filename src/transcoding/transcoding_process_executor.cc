@@ -31,21 +31,139 @@
 
 #include "transcoding_process_executor.h" // API
 
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
 #include <unistd.h>
 
-TranscodingProcessExecutor::TranscodingProcessExecutor(const std::string& command, const std::vector<std::string>& arglist)
-    : ProcessExecutor(command, arglist)
+#include "util/metrics.h"
+#include "util/tools.h"
+
+/// \brief longest message kept while waiting for the end of the line
+#define MAX_ERROR_LINE 4096
+
+TranscodingProcessExecutor::ErrorPipe::ErrorPipe(bool capture, const std::string& command)
+{
+    if (!capture)
+        return;
+
+    // the transcoder must not block on its messages while nobody reads them, they are dropped instead
+#ifdef __linux__
+    int ret = pipe2(fds, O_CLOEXEC | O_NONBLOCK);
+#else
+    int ret = pipe(fds);
+    if (ret == 0) {
+        for (int fd : fds) {
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+    }
+#endif
+    if (ret == -1) {
+        log_warning("Could not capture the messages of {}: {}", command.c_str(), std::strerror(errno));
+        fds[0] = fds[1] = -1;
+    }
+}
+
+TranscodingProcessExecutor::ErrorPipe::~ErrorPipe()
+{
+    for (int fd : fds) {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+int TranscodingProcessExecutor::ErrorPipe::release()
+{
+    int fd = fds[0];
+    fds[0] = -1;
+    return fd;
+}
+
+static Metrics::Gauge& runningTranscoders()
+{
+    static auto& gauge = Metrics::getInstance().gauge("gerbera_transcoders_running", "Transcoding processes started and not cleaned up yet");
+    return gauge;
+}
+
+TranscodingProcessExecutor::TranscodingProcessExecutor(const std::string& command, const std::vector<std::string>& arglist, int outputFd, bool captureErrors)
+    : TranscodingProcessExecutor(command, arglist, outputFd, ErrorPipe(captureErrors, command))
 {
 }
 
+TranscodingProcessExecutor::TranscodingProcessExecutor(const std::string& command, const std::vector<std::string>& arglist, int outputFd, ErrorPipe&& errors)
+    : ProcessExecutor(command, arglist, outputFd, 0, errors.fds[1])
+    , command(command)
+    , errorFd(errors.release())
+{
+    runningTranscoders().inc();
+}
+
 void TranscodingProcessExecutor::removeFile(const std::string& filename)
 {
     file_list.push_back(filename);
 }
 
+long TranscodingProcessExecutor::parseProgress(const std::string& line)
+{
+    auto pos = line.rfind("time=");
+    if (pos == std::string::npos)
+        return -1;
+
+    unsigned int hours, minutes;
+    double seconds;
+    if (sscanf(line.c_str() + pos + 5, "%u:%u:%lf", &hours, &minutes, &seconds) != 3 || minutes > 59 || seconds < 0 || seconds >= 60)
+        return -1;
+    return (hours * 3600 + minutes * 60) * 1000L + static_cast<long>(seconds * 1000);
+}
+
+void TranscodingProcessExecutor::readErrors()
+{
+    if (errorFd < 0)
+        return;
+
+    char buf[1024];
+    ssize_t bytes;
+    while ((bytes = ::read(errorFd, buf, sizeof(buf))) > 0)
+        pending.append(buf, bytes);
+
+    // ffmpeg ends its status line with \r to overwrite it on a terminal
+    std::size_t start = 0;
+    std::size_t end;
+    while ((end = pending.find_first_of("\r\n", start)) != std::string::npos || pending.size() - start > MAX_ERROR_LINE) {
+        if (end == std::string::npos)
+            end = pending.size();
+        auto line = trimString(pending.substr(start, end - start));
+        start = end + 1;
+        if (line.empty())
+            continue;
+
+        log_debug("{}: {}", command.c_str(), line.c_str());
+        lastMessage = line;
+        auto time = parseProgress(line);
+        if (time >= 0) {
+            progress = time;
+            if (slot != nullptr)
+                slot->setProgress(time);
+        }
+    }
+    pending.erase(0, std::min(start, pending.size()));
+}
+
 TranscodingProcessExecutor::~TranscodingProcessExecutor()
 {
+    runningTranscoders().dec();
+    // the messages still in the pipe explain why the process ended
+    readErrors();
+    if (!isAlive() && exit_status != 0) {
+        log_warning("Transcoder {} failed with status {}{}{}", command.c_str(), exit_status, lastMessage.empty() ? "" : ": ", lastMessage.c_str());
+        if (slot != nullptr)
+            slot->setFailed();
+    }
+
     kill();
+    if (errorFd >= 0)
+        close(errorFd);
 
     for (const auto& name : file_list) {
         unlink(name.c_str());
@@ -32,22 +32,66 @@
 #ifndef __TRANSCODING_PROCESS_EXECUTOR_H__
 #define __TRANSCODING_PROCESS_EXECUTOR_H__
 
+#include <memory>
+#include <string>
+
+#include "transcode_scheduler.h"
 #include "util/process_executor.h"
 
 class TranscodingProcessExecutor : public ProcessExecutor {
 public:
+    /// \param captureErrors read the messages of the transcoder instead of passing them to the server's stderr
     TranscodingProcessExecutor(const std::string& command,
-        const std::vector<std::string>& arglist);
+        const std::vector<std::string>& arglist, int outputFd = -1, bool captureErrors = false);
     /// \brief This function adds a filename to a list, files in that list
     /// will be removed once the class is destroyed.
     void removeFile(const std::string& filename);
 
+    /// \brief The slot is given back when the process is gone.
+    void setSlot(std::unique_ptr<TranscodeScheduler::Slot> slot) { this->slot = std::move(slot); }
+    /// \brief hand the slot on to a process replacing this one
+    std::unique_ptr<TranscodeScheduler::Slot> takeSlot() { return std::move(slot); }
+    TranscodeScheduler::Slot* getSlot() const { return slot.get(); }
+
+    /// \brief log the messages the transcoder wrote since the last call and pick up its progress
+    void readErrors();
+    /// \brief milliseconds of media the transcoder reported as done, -1 if unknown
+    long getProgress() const { return progress; }
+    std::string getLastMessage() const { return lastMessage; }
+
+    /// \brief media time of a progress line like ffmpeg's "time=00:01:02.50", -1 if there is none
+    static long parseProgress(const std::string& line);
+
     ~TranscodingProcessExecutor() override;
 
 protected:
+    /// \brief owns the stderr pipe until the process has started
+    struct ErrorPipe {
+        int fds[2] { -1, -1 };
+        ErrorPipe(bool capture, const std::string& command);
+        ErrorPipe(const ErrorPipe&) = delete;
+        ErrorPipe& operator=(const ErrorPipe&) = delete;
+        ~ErrorPipe();
+        int release();
+    };
+
+    TranscodingProcessExecutor(const std::string& command,
+        const std::vector<std::string>& arglist, int outputFd, ErrorPipe&& errors);
+
+    std::string command;
+
     /// \brief The files in this list will be removed once the class is no
     /// longer in use.
     std::vector<std::string> file_list;
+
+    std::unique_ptr<TranscodeScheduler::Slot> slot;
+
+    /// \brief read end of the stderr pipe, -1 if the messages are not captured
+    int errorFd { -1 };
+    /// \brief incomplete line read from errorFd
+    std::string pending;
+    std::string lastMessage;
+    long progress { -1 };
 };
 
 #endif // __TRANSCODING_PROCESS_EXECUTOR_H__
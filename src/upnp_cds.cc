@@ -35,33 +35,194 @@
 #include <string>
 #include <vector>
 
+#include "browse_cache.h"
+#include "browse_snapshot.h"
 #include "config/config_manager.h"
+#include "content/content_manager.h"
 #include "database/database.h"
+#include "didl_cache.h"
+#include "util/trace.h"
 #include "util/upnp_quirks.h"
+#include "util/worker_pool.h"
+#include "util/xml_writer.h"
 
-ContentDirectoryService::ContentDirectoryService(const std::shared_ptr<Context>& context,
-    UpnpXMLBuilder* xmlBuilder, UpnpDevice_Handle deviceHandle, int stringLimit)
+/// \brief bytes to reserve per object in the DIDL-Lite result, a typical item with a few resources
+static constexpr std::size_t DIDL_OBJECT_RESERVE = 1024;
+
+/// \brief write declaration and the opened DIDL-Lite root element
+static void startDIDL(XmlStreamWriter& didl_lite)
+{
+    didl_lite.addDeclaration();
+    didl_lite.startElement("DIDL-Lite");
+    didl_lite.addAttribute(UPNP_XML_DIDL_LITE_NAMESPACE_ATTR, UPNP_XML_DIDL_LITE_NAMESPACE);
+    didl_lite.addAttribute(UPNP_XML_DC_NAMESPACE_ATTR, UPNP_XML_DC_NAMESPACE);
+    didl_lite.addAttribute(UPNP_XML_UPNP_NAMESPACE_ATTR, UPNP_XML_UPNP_NAMESPACE);
+    didl_lite.addAttribute(UPNP_XML_SEC_NAMESPACE_ATTR, UPNP_XML_SEC_NAMESPACE);
+}
+
+ContentDirectoryService::ContentDirectoryService(const std::shared_ptr<Context>& context, std::shared_ptr<ContentManager> content,
+    UpnpXMLBuilder* xmlBuilder, UpnpDevice_Handle deviceHandle, int stringLimit, std::shared_ptr<DidlCache> didlCache, std::shared_ptr<BrowseCache> browseCache,
+    std::shared_ptr<WorkerPool> renderPool, std::shared_ptr<BrowseSnapshot> browseSnapshot)
     : systemUpdateID(0)
     , stringLimit(stringLimit)
     , config(context->getConfig())
     , database(context->getDatabase())
+    , content(std::move(content))
     , deviceHandle(deviceHandle)
     , xmlBuilder(xmlBuilder)
+    , didlCache(std::move(didlCache))
+    , browseCache(std::move(browseCache))
+    , renderPool(std::move(renderPool))
+    , browseSnapshot(std::move(browseSnapshot))
+{
+}
+
+void ContentDirectoryService::renderObject(const std::shared_ptr<CdsObject>& obj, const std::shared_ptr<Quirks>& quirks, const DidlFilter& filter, XmlStreamWriter& didl_lite)
+{
+    if (!didlCache) {
+        xmlBuilder->renderObject(obj, stringLimit, didl_lite, quirks, &filter);
+        return;
+    }
+
+    auto quirkFlags = quirks ? quirks->getFlags() : QUIRK_FLAG_NONE;
+    std::string filterKey = filter.all() ? "" : filter.str();
+    auto fragment = didlCache->get(obj, quirkFlags, stringLimit, filterKey);
+    if (!fragment) {
+        XmlStreamWriter writer(DIDL_OBJECT_RESERVE);
+        xmlBuilder->renderObject(obj, stringLimit, writer, quirks, &filter);
+        fragment = didlCache->put(obj, quirkFlags, stringLimit, filterKey, writer.releaseFragment());
+    }
+    didl_lite.addFragment(*fragment);
+}
+
+void ContentDirectoryService::renderObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, const std::shared_ptr<Quirks>& quirks, const DidlFilter& filter, XmlStreamWriter& didl_lite)
 {
+    TraceSpan span("didl.render");
+    if (!renderPool || objects.size() < DIDL_PARALLEL_RENDER_MIN) {
+        for (const auto& obj : objects)
+            renderObject(obj, quirks, filter, didl_lite);
+        return;
+    }
+
+    // the parts are appended in order, the result is the same as rendering one object after the other
+    std::size_t parts = (objects.size() + DIDL_RENDER_CHUNK - 1) / DIDL_RENDER_CHUNK;
+    std::vector<std::string> fragments(parts);
+    renderPool->runBatch(parts, [&](std::size_t part) {
+        auto first = part * DIDL_RENDER_CHUNK;
+        auto last = std::min(first + DIDL_RENDER_CHUNK, objects.size());
+        XmlStreamWriter writer((last - first) * DIDL_OBJECT_RESERVE);
+        for (auto i = first; i < last; i++)
+            renderObject(objects[i], quirks, filter, writer);
+        fragments[part] = writer.releaseFragment();
+    });
+    for (const auto& fragment : fragments)
+        didl_lite.addFragment(fragment);
+}
+
+void ContentDirectoryService::markPlayed(const std::shared_ptr<CdsObject>& obj) const
+{
+    if (!config->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_ENABLED) || !obj->getFlag(OBJECT_FLAG_PLAYED))
+        return;
+
+    std::string title = obj->getTitle();
+    if (config->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_STRING_MODE_PREPEND))
+        title = config->getOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_STRING).append(title);
+    else
+        title.append(config->getOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_STRING));
+
+    obj->setTitle(title);
+}
+
+void ContentDirectoryService::warmUp(int depth, const std::atomic_bool& stop)
+{
+    unsigned int flag = BROWSE_DIRECT_CHILDREN | BROWSE_ITEMS | BROWSE_CONTAINERS | BROWSE_EXACT_CHILDCOUNT;
+    if (config->getBoolOption(CFG_SERVER_HIDE_PC_DIRECTORY))
+        flag |= BROWSE_HIDE_FS_ROOT;
+    // a client without quirks asking for all properties, the most common cache key
+    DidlFilter filter("*");
+
+    std::vector<int> level { CDS_ID_ROOT };
+    std::size_t loaded = 0;
+    for (int current = 0; current < depth && !level.empty() && !stop; current++) {
+        std::vector<int> next;
+        for (int containerID : level) {
+            if (stop)
+                return;
+            try {
+                auto parent = database->loadObject(containerID);
+                auto param = std::make_unique<BrowseParam>(containerID,
+                    (parent->getClass() == UPNP_CLASS_MUSIC_ALBUM || parent->getClass() == UPNP_CLASS_PLAYLIST_CONTAINER) ? flag | BROWSE_TRACK_SORT : flag);
+                auto arr = database->browse(param);
+                content->promoteMetadata(arr);
+
+                XmlStreamWriter writer(arr.size() * DIDL_OBJECT_RESERVE);
+                for (const auto& obj : arr) {
+                    markPlayed(obj);
+                    if (obj->isContainer() && current + 1 < depth)
+                        next.push_back(obj->getID());
+                }
+                if (didlCache)
+                    renderObjects(arr, nullptr, filter, writer);
+                loaded += arr.size();
+            } catch (const std::runtime_error& e) {
+                log_debug("Skipping container {} in warm-up: {}", containerID, e.what());
+            }
+        }
+        level = std::move(next);
+    }
+    log_debug("Warm-up loaded {} objects up to depth {}", loaded, depth);
+}
+
+void ContentDirectoryService::buildSnapshot(const std::atomic_bool& stop)
+{
+    unsigned int flag = BROWSE_DIRECT_CHILDREN | BROWSE_ITEMS | BROWSE_CONTAINERS | BROWSE_EXACT_CHILDCOUNT;
+    if (config->getBoolOption(CFG_SERVER_HIDE_PC_DIRECTORY))
+        flag |= BROWSE_HIDE_FS_ROOT;
+    // the requests answered from the snapshot
+    DidlFilter filter("*");
+    auto render = [&](const std::shared_ptr<CdsObject>& obj) {
+        markPlayed(obj);
+        XmlStreamWriter writer(DIDL_OBJECT_RESERVE);
+        renderObject(obj, nullptr, filter, writer);
+        return BrowseSnapshot::Object { obj->getID(), obj->isContainer(), writer.releaseFragment() };
+    };
+
+    auto root = database->loadObject(CDS_ID_ROOT);
+    browseSnapshot->rebuild(
+        render(root), [&](int containerID) {
+            std::vector<BrowseSnapshot::Object> objects;
+            try {
+                auto parent = database->loadObject(containerID);
+                auto param = std::make_unique<BrowseParam>(containerID, flag);
+                if ((parent->getClass() == UPNP_CLASS_MUSIC_ALBUM) || (parent->getClass() == UPNP_CLASS_PLAYLIST_CONTAINER))
+                    param->setFlag(BROWSE_TRACK_SORT);
+                auto arr = database->browse(param);
+                content->promoteMetadata(arr);
+                objects.reserve(arr.size());
+                for (const auto& obj : arr)
+                    objects.push_back(render(obj));
+            } catch (const std::runtime_error& e) {
+                // removed while the snapshot is written, its parent is stale already
+                log_debug("Skipping container {} in browse snapshot: {}", containerID, e.what());
+            }
+            return objects;
+        },
+        stop);
 }
 
 void ContentDirectoryService::doBrowse(const std::unique_ptr<ActionRequest>& request)
 {
+    TraceSpan span("cds.browse");
     log_debug("start");
 
     auto req = request->getRequest();
     auto req_root = req->document_element();
     std::string objID = req_root.child("ObjectID").text().as_string();
     std::string BrowseFlag = req_root.child("BrowseFlag").text().as_string();
-    //std::string Filter; // not yet supported
+    std::string Filter = req_root.child("Filter").text().as_string();
     std::string StartingIndex = req_root.child("StartingIndex").text().as_string();
     std::string RequestedCount = req_root.child("RequestedCount").text().as_string();
-    // std::string SortCriteria; // not yet supported
+    std::string SortCriteria = req_root.child("SortCriteria").text().as_string();
 
     log_debug("Browse received parameters: ObjectID [{}] BrowseFlag [{}] StartingIndex [{}] RequestedCount [{}]",
         objID.c_str(), BrowseFlag.c_str(), StartingIndex.c_str(), RequestedCount.c_str());
@@ -80,6 +241,29 @@ void ContentDirectoryService::doBrowse(const std::unique_ptr<ActionRequest>& req
         throw UpnpException(UPNP_SOAP_E_INVALID_ARGS,
             "invalid browse flag: " + BrowseFlag);
 
+    auto quirks = request->getQuirks();
+    BrowseCache::Key cacheKey { objectID, BrowseFlag, Filter, StartingIndex, RequestedCount, SortCriteria, quirks ? quirks->getFlags() : QUIRK_FLAG_NONE };
+    auto result = browseCache ? browseCache->get(cacheKey) : nullptr;
+    if (result) {
+        log_debug("Browse result of {} taken from cache", objectID);
+        setBrowseResponse(request, *result);
+        return;
+    }
+
+    int startingIndex = stoiString(StartingIndex);
+    int requestedCount = stoiString(RequestedCount);
+    if (browseSnapshot && Filter == "*" && SortCriteria.empty() && (!quirks || quirks->getFlags() == QUIRK_FLAG_NONE) && startingIndex >= 0 && requestedCount >= 0) {
+        XmlStreamWriter didl_lite;
+        startDIDL(didl_lite);
+        BrowseResult snapshotResult;
+        if (browseSnapshot->browse(objectID, flag & BROWSE_DIRECT_CHILDREN, startingIndex, requestedCount, didl_lite, snapshotResult)) {
+            didl_lite.endElement();
+            snapshotResult.didl = didl_lite.release();
+            setBrowseResponse(request, snapshotResult);
+            return;
+        }
+    }
+
     auto parent = database->loadObject(objectID);
     if ((parent->getClass() == UPNP_CLASS_MUSIC_ALBUM) || (parent->getClass() == UPNP_CLASS_PLAYLIST_CONTAINER))
         flag |= BROWSE_TRACK_SORT;
@@ -87,10 +271,22 @@ void ContentDirectoryService::doBrowse(const std::unique_ptr<ActionRequest>& req
     if (config->getBoolOption(CFG_SERVER_HIDE_PC_DIRECTORY))
         flag |= BROWSE_HIDE_FS_ROOT;
 
+    // only decode what the requested properties are rendered from
+    DidlFilter filter(Filter);
+    if (!filter.needsMetadata())
+        flag |= BROWSE_NO_METADATA;
+    if (!filter.needsResources())
+        flag |= BROWSE_NO_RESOURCES;
+
     auto param = std::make_unique<BrowseParam>(objectID, flag);
+    try {
+        param->setSortCriteria(BrowseParam::parseSortCriteria(SortCriteria));
+    } catch (const std::runtime_error& e) {
+        throw UpnpException(UPNP_E_UNSUPPORTED_SORT, e.what());
+    }
 
-    param->setStartingIndex(stoiString(StartingIndex));
-    param->setRequestedCount(stoiString(RequestedCount));
+    param->setStartingIndex(startingIndex);
+    param->setRequestedCount(requestedCount);
 
     std::vector<std::shared_ptr<CdsObject>> arr;
     try {
@@ -98,48 +294,44 @@ void ContentDirectoryService::doBrowse(const std::unique_ptr<ActionRequest>& req
     } catch (const std::runtime_error& e) {
         throw UpnpException(UPNP_E_NO_SUCH_ID, "no such object");
     }
+    content->promoteMetadata(arr);
 
-    pugi::xml_document didl_lite;
-    auto decl = didl_lite.prepend_child(pugi::node_declaration);
-    decl.append_attribute("version") = "1.0";
-    decl.append_attribute("encoding") = "UTF-8";
-    auto didl_lite_root = didl_lite.append_child("DIDL-Lite");
-    didl_lite_root.append_attribute(UPNP_XML_DIDL_LITE_NAMESPACE_ATTR) = UPNP_XML_DIDL_LITE_NAMESPACE;
-    didl_lite_root.append_attribute(UPNP_XML_DC_NAMESPACE_ATTR) = UPNP_XML_DC_NAMESPACE;
-    didl_lite_root.append_attribute(UPNP_XML_UPNP_NAMESPACE_ATTR) = UPNP_XML_UPNP_NAMESPACE;
-    didl_lite_root.append_attribute(UPNP_XML_SEC_NAMESPACE_ATTR) = UPNP_XML_SEC_NAMESPACE;
+    XmlStreamWriter didl_lite(arr.size() * DIDL_OBJECT_RESERVE);
+    startDIDL(didl_lite);
 
+    std::vector<int> objectIDs { objectID };
+    objectIDs.reserve(2 * arr.size() + 1);
     for (const auto& obj : arr) {
-        if (config->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_ENABLED) && obj->getFlag(OBJECT_FLAG_PLAYED)) {
-            std::string title = obj->getTitle();
-            if (config->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_STRING_MODE_PREPEND))
-                title = config->getOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_STRING).append(title);
-            else
-                title.append(config->getOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_STRING));
-
-            obj->setTitle(title);
-        }
+        objectIDs.push_back(obj->getID());
+        objectIDs.push_back(obj->getParentID());
 
-        xmlBuilder->renderObject(obj, stringLimit, &didl_lite_root, request->getQuirks());
+        markPlayed(obj);
     }
+    renderObjects(arr, quirks, filter, didl_lite);
 
-    std::ostringstream buf;
-    didl_lite.print(buf, "", 0);
-    std::string didl_lite_xml = buf.str();
+    didl_lite.endElement();
+    auto browseResult = std::make_shared<BrowseResult>(BrowseResult { didl_lite.release(), arr.size(), param->getTotalMatches() });
+    setBrowseResponse(request, *browseResult);
+    if (browseCache)
+        browseCache->put(cacheKey, std::move(objectIDs), std::move(browseResult));
 
+    log_debug("end");
+}
+
+void ContentDirectoryService::setBrowseResponse(const std::unique_ptr<ActionRequest>& request, const BrowseResult& result) const
+{
     auto response = UpnpXMLBuilder::createResponse(request->getActionName(), UPNP_DESC_CDS_SERVICE_TYPE);
     auto resp_root = response->document_element();
-    resp_root.append_child("Result").append_child(pugi::node_pcdata).set_value(didl_lite_xml.c_str());
-    resp_root.append_child("NumberReturned").append_child(pugi::node_pcdata).set_value(fmt::to_string(arr.size()).c_str());
-    resp_root.append_child("TotalMatches").append_child(pugi::node_pcdata).set_value(fmt::to_string(param->getTotalMatches()).c_str());
+    resp_root.append_child("Result").append_child(pugi::node_pcdata).set_value(result.didl.c_str());
+    resp_root.append_child("NumberReturned").append_child(pugi::node_pcdata).set_value(fmt::to_string(result.numberReturned).c_str());
+    resp_root.append_child("TotalMatches").append_child(pugi::node_pcdata).set_value(fmt::to_string(result.totalMatches).c_str());
     resp_root.append_child("UpdateID").append_child(pugi::node_pcdata).set_value(fmt::to_string(systemUpdateID).c_str());
     request->setResponse(response);
-
-    log_debug("end");
 }
 
 void ContentDirectoryService::doSearch(const std::unique_ptr<ActionRequest>& request)
 {
+    TraceSpan span("cds.search");
     log_debug("start");
 
     auto req = request->getRequest();
@@ -150,22 +342,13 @@ void ContentDirectoryService::doSearch(const std::unique_ptr<ActionRequest>& req
     // }
     std::string containerID = req_root.child("ContainerID").text().as_string();
     std::string searchCriteria = req_root.child("SearchCriteria").text().as_string();
+    DidlFilter filter(req_root.child("Filter").text().as_string());
     std::string startingIndex = req_root.child("StartingIndex").text().as_string();
     std::string requestedCount = req_root.child("RequestedCount").text().as_string();
 
     log_debug("Search received parameters: ContainerID [{}] SearchCriteria [{}] StartingIndex [{}] RequestedCount [{}]",
         containerID.c_str(), searchCriteria.c_str(), startingIndex.c_str(), requestedCount.c_str());
 
-    pugi::xml_document didl_lite;
-    auto decl = didl_lite.prepend_child(pugi::node_declaration);
-    decl.append_attribute("version") = "1.0";
-    decl.append_attribute("encoding") = "UTF-8";
-    auto didl_lite_root = didl_lite.append_child("DIDL-Lite");
-    didl_lite_root.append_attribute(UPNP_XML_DIDL_LITE_NAMESPACE_ATTR) = UPNP_XML_DIDL_LITE_NAMESPACE;
-    didl_lite_root.append_attribute(UPNP_XML_DC_NAMESPACE_ATTR) = UPNP_XML_DC_NAMESPACE;
-    didl_lite_root.append_attribute(UPNP_XML_UPNP_NAMESPACE_ATTR) = UPNP_XML_UPNP_NAMESPACE;
-    didl_lite_root.append_attribute(UPNP_XML_SEC_NAMESPACE_ATTR) = UPNP_XML_SEC_NAMESPACE;
-
     auto searchParam = std::make_unique<SearchParam>(containerID, searchCriteria,
         stoiString(startingIndex), stoiString(requestedCount));
 
@@ -179,6 +362,9 @@ void ContentDirectoryService::doSearch(const std::unique_ptr<ActionRequest>& req
         throw UpnpException(UPNP_E_NO_SUCH_ID, "no such object");
     }
 
+    XmlStreamWriter didl_lite(results.size() * DIDL_OBJECT_RESERVE);
+    startDIDL(didl_lite);
+
     for (const auto& cdsObject : results) {
         if (cdsObject->isItem() && config->getBoolOption(CFG_SERVER_EXTOPTS_MARK_PLAYED_ITEMS_ENABLED) && cdsObject->getFlag(OBJECT_FLAG_PLAYED)) {
             std::string title = cdsObject->getTitle();
@@ -189,13 +375,11 @@ void ContentDirectoryService::doSearch(const std::unique_ptr<ActionRequest>& req
 
             cdsObject->setTitle(title);
         }
-
-        xmlBuilder->renderObject(cdsObject, stringLimit, &didl_lite_root);
     }
+    renderObjects(results, nullptr, filter, didl_lite);
 
-    std::ostringstream buf;
-    didl_lite.print(buf, "", 0);
-    std::string didl_lite_xml = buf.str();
+    didl_lite.endElement();
+    std::string didl_lite_xml = didl_lite.release();
     log_debug("didl {}", didl_lite_xml);
 
     auto response = UpnpXMLBuilder::createResponse(request->getActionName(), UPNP_DESC_CDS_SERVICE_TYPE);
@@ -227,7 +411,7 @@ void ContentDirectoryService::doGetSortCapabilities(const std::unique_ptr<Action
 
     auto response = UpnpXMLBuilder::createResponse(request->getActionName(), UPNP_DESC_CDS_SERVICE_TYPE);
     auto root = response->document_element();
-    root.append_child("SortCaps").append_child(pugi::node_pcdata).set_value("");
+    root.append_child("SortCaps").append_child(pugi::node_pcdata).set_value(BROWSE_SORT_CAPABILITIES);
     request->setResponse(response);
 
     log_debug("end");
@@ -284,16 +468,27 @@ void ContentDirectoryService::processSubscriptionRequest(const std::unique_ptr<S
 {
     log_debug("start");
 
-    auto propset = UpnpXMLBuilder::createEventPropertySet();
-    auto property = propset->document_element().first_child();
-    property.append_child("SystemUpdateID").append_child(pugi::node_pcdata).set_value(fmt::to_string(systemUpdateID).c_str());
     auto obj = database->loadObject(0);
     auto cont = std::static_pointer_cast<CdsContainer>(obj);
-    property.append_child("ContainerUpdateIDs").append_child(pugi::node_pcdata).set_value(fmt::format("0,{}", +cont->getUpdateID()).c_str());
-
-    std::ostringstream buf;
-    propset->print(buf, "", 0);
-    std::string xml = buf.str();
+    std::string xml;
+    {
+        // renderers subscribing between two updates get the same event
+        std::lock_guard<std::mutex> lock(subscriptionEventMutex);
+        auto ids = std::make_pair(systemUpdateID, cont->getUpdateID());
+        if (ids != subscriptionEventIDs) {
+            XmlStreamWriter propset(256);
+            propset.startElement("e:propertyset");
+            propset.addAttribute("xmlns:e", "urn:schemas-upnp-org:event-1-0");
+            propset.startElement("e:property");
+            propset.addElement("SystemUpdateID", fmt::to_string(ids.first));
+            propset.addElement("ContainerUpdateIDs", fmt::format("0,{}", ids.second));
+            propset.endElement();
+            propset.endElement();
+            subscriptionEvent = propset.release();
+            subscriptionEventIDs = ids;
+        }
+        xml = subscriptionEvent;
+    }
 
 #if defined(USING_NPUPNP)
     UpnpAcceptSubscriptionXML(
@@ -319,16 +514,24 @@ void ContentDirectoryService::sendSubscriptionUpdate(const std::string& containe
 {
     log_debug("start");
 
-    systemUpdateID++;
-
-    auto propset = UpnpXMLBuilder::createEventPropertySet();
-    auto property = propset->document_element().first_child();
-    property.append_child("ContainerUpdateIDs").append_child(pugi::node_pcdata).set_value(containerUpdateIDs_CSV.c_str());
-    property.append_child("SystemUpdateID").append_child(pugi::node_pcdata).set_value(fmt::to_string(systemUpdateID).c_str());
+    int updateID;
+    {
+        std::lock_guard<std::mutex> lock(subscriptionEventMutex);
+        updateID = ++systemUpdateID;
+    }
 
-    std::ostringstream buf;
-    propset->print(buf, "", 0);
-    std::string xml = buf.str();
+    // written directly, this is sent for every moderated batch of changes
+    XmlStreamWriter propset(containerUpdateIDs_CSV.length() + 256);
+    propset.startElement("e:propertyset");
+    propset.addAttribute("xmlns:e", "urn:schemas-upnp-org:event-1-0");
+    propset.startElement("e:property");
+    // only the SystemUpdateID if the list was too long
+    if (!containerUpdateIDs_CSV.empty())
+        propset.addElement("ContainerUpdateIDs", containerUpdateIDs_CSV);
+    propset.addElement("SystemUpdateID", fmt::to_string(updateID));
+    propset.endElement();
+    propset.endElement();
+    std::string xml = propset.release();
 
 #if defined(USING_NPUPNP)
     UpnpNotifyXML(deviceHandle, config->getOption(CFG_SERVER_UDN).c_str(),
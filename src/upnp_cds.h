@@ -32,6 +32,7 @@
 #ifndef __UPNP_CDS_H__
 #define __UPNP_CDS_H__
 
+#include <atomic>
 #include <memory>
 
 #include "action_request.h"
@@ -39,8 +40,18 @@
 #include "context.h"
 #include "subscription_request.h"
 #include "upnp_xml.h"
+#include <mutex>
 #include <string>
 
+// forward declaration
+class BrowseCache;
+class BrowseSnapshot;
+class ContentManager;
+class DidlCache;
+class WorkerPool;
+class XmlStreamWriter;
+struct BrowseResult;
+
 /// \brief This class is responsible for the UPnP Content Directory Service operations.
 ///
 /// Handles subscription and action invocation requests for the CDS.
@@ -55,6 +66,12 @@ protected:
     /// action.
     int systemUpdateID;
 
+    /// \brief initial event of new subscriptions, rendered once per SystemUpdateID and update id of the root container
+    std::string subscriptionEvent;
+    std::pair<int, int> subscriptionEventIDs { -1, -1 };
+    /// \brief guards systemUpdateID and the initial event
+    std::mutex subscriptionEventMutex;
+
     /// \brief All strings in the XML will be cut at this length.
     int stringLimit;
 
@@ -74,6 +91,18 @@ protected:
     /// ui4 TotalMatches, ui4 UpdateID)
     void doSearch(const std::unique_ptr<ActionRequest>& request);
 
+    /// \brief set Result, NumberReturned, TotalMatches and UpdateID of a Browse response
+    void setBrowseResponse(const std::unique_ptr<ActionRequest>& request, const BrowseResult& result) const;
+
+    /// \brief append the DIDL-Lite of obj, taken from the cache if it was rendered before
+    void renderObject(const std::shared_ptr<CdsObject>& obj, const std::shared_ptr<Quirks>& quirks, const DidlFilter& filter, XmlStreamWriter& didl_lite);
+
+    /// \brief append the DIDL-Lite of all objects in order, large results are rendered in parts on the render pool
+    void renderObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, const std::shared_ptr<Quirks>& quirks, const DidlFilter& filter, XmlStreamWriter& didl_lite);
+
+    /// \brief add the configured played marker to the title of obj
+    void markPlayed(const std::shared_ptr<CdsObject>& obj) const;
+
     /// \brief UPnP standard defined action: GetSearchCapabilities()
     /// \param request Incoming ActionRequest.
     ///
@@ -99,15 +128,29 @@ protected:
 
     std::shared_ptr<Config> config;
     std::shared_ptr<Database> database;
+    std::shared_ptr<ContentManager> content;
 
     UpnpDevice_Handle deviceHandle;
     UpnpXMLBuilder* xmlBuilder;
 
+    /// \brief rendered objects, nullptr if disabled
+    std::shared_ptr<DidlCache> didlCache;
+
+    /// \brief whole Browse results, nullptr if disabled
+    std::shared_ptr<BrowseCache> browseCache;
+
+    /// \brief threads helping with large results, nullptr renders on the request thread only
+    std::shared_ptr<WorkerPool> renderPool;
+
+    /// \brief mapped copy of the tree, nullptr if disabled
+    std::shared_ptr<BrowseSnapshot> browseSnapshot;
+
 public:
     /// \brief Constructor for the CDS, saves the service type and service id
     /// in internal variables.
-    explicit ContentDirectoryService(const std::shared_ptr<Context>& context,
-        UpnpXMLBuilder* builder, UpnpDevice_Handle deviceHandle, int stringLimit);
+    explicit ContentDirectoryService(const std::shared_ptr<Context>& context, std::shared_ptr<ContentManager> content,
+        UpnpXMLBuilder* builder, UpnpDevice_Handle deviceHandle, int stringLimit, std::shared_ptr<DidlCache> didlCache = nullptr, std::shared_ptr<BrowseCache> browseCache = nullptr,
+        std::shared_ptr<WorkerPool> renderPool = nullptr, std::shared_ptr<BrowseSnapshot> browseSnapshot = nullptr);
     ~ContentDirectoryService() = default;
 
     /// \brief Dispatches the ActionRequest between the available actions.
@@ -130,7 +173,17 @@ public:
     /// When something in the content directory chagnes, we will send out
     /// an event to all subscribed devices. Container updates are supported,
     /// and of course the minimum required - systemUpdateID.
+    /// An empty containerUpdateIDs_CSV sends the systemUpdateID only.
     void sendSubscriptionUpdate(const std::string& containerUpdateIDs_CSV);
+
+    /// \brief Browse the containers of the first levels once to load their objects and fill the DIDL-Lite cache
+    /// \param depth number of levels below the root container
+    /// \param stop stops the walk when set
+    void warmUp(int depth, const std::atomic_bool& stop);
+
+    /// \brief Write the browse snapshot, listing the containers that changed since the last one
+    /// \param stop abandons the snapshot when set
+    void buildSnapshot(const std::atomic_bool& stop);
 };
 
 #endif // __UPNP_CDS_H__
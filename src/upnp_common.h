@@ -32,6 +32,7 @@
 /// \brief UPnP specific error code.
 #define UPNP_E_NO_SUCH_ID 701
 #define UPNP_E_NOT_EXIST 706
+#define UPNP_E_UNSUPPORTED_SORT 709
 
 // UPnP default classes
 #define UPNP_CLASS_CONTAINER "object.container"
@@ -53,6 +54,9 @@
 #define UPNP_DLNA_TRANSFER_MODE_STREAMING "Streaming"
 #define UPNP_DLNA_TRANSFER_MODE_INTERACTIVE "Interactive"
 
+// timeSeekRange
+#define UPNP_DLNA_TIME_SEEK_RANGE_HEADER "TimeSeekRange.dlna.org"
+
 // contentFeatures
 #define UPNP_DLNA_CONTENT_FEATURES_HEADER "contentFeatures.dlna.org"
 #define UPNP_DLNA_PROFILE "DLNA.ORG_PN"
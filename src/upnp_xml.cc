@@ -44,9 +44,60 @@ UpnpXMLBuilder::UpnpXMLBuilder(const std::shared_ptr<Context>& context,
     , database(context->getDatabase())
     , virtualURL(std::move(virtualUrl))
     , presentationURL(std::move(presentationURL))
+    , dlnaMimeTable(config->getDictionaryOption(CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST))
+    , transcodingProfiles(config->getTranscodingProfileListOption(CFG_TRANSCODING_PROFILE_LIST))
+    , transcodingTable(buildTranscodingTable())
 {
 }
 
+std::unordered_map<std::string, std::vector<UpnpXMLBuilder::TranscodingChoice>> UpnpXMLBuilder::buildTranscodingTable() const
+{
+    std::unordered_map<std::string, std::vector<TranscodingChoice>> table;
+    if (transcodingProfiles == nullptr)
+        return table;
+
+    for (auto&& [mimeType, profiles] : transcodingProfiles->getList()) {
+        const auto& ct = dlnaMimeTable.get(mimeType).contentType;
+        auto&& choices = table[mimeType];
+        for (const auto& [key, tp] : *profiles) {
+            if (tp == nullptr)
+                throw_std_runtime_error("Invalid profile encountered");
+
+            TranscodingChoice choice;
+            choice.profile = tp;
+            choice.name = tp->getName();
+            choice.targetMimeType = tp->getTargetMimeType();
+            choice.attributes = tp->getAttributes();
+            if (ct == CONTENT_TYPE_OGG) {
+                choice.checkTheora = true;
+                choice.theora = tp->isTheora();
+            }
+            // check user fourcc settings
+            else if (ct == CONTENT_TYPE_AVI && tp->getAVIFourCCListMode() != FCC_None) {
+                choice.checkFourcc = true;
+                choice.processFourcc = tp->getAVIFourCCListMode() == FCC_Process;
+                auto fccList = tp->getAVIFourCCList();
+                choice.fourcc.insert(fccList.begin(), fccList.end());
+            }
+            choices.push_back(std::move(choice));
+        }
+    }
+    return table;
+}
+
+bool UpnpXMLBuilder::TranscodingChoice::matches(bool itemTheora, const std::string& itemFourcc) const
+{
+    if (checkTheora)
+        return itemTheora == theora;
+    if (!checkFourcc)
+        return true;
+    // we can not do much if the item has no fourcc info, so we will transcode it anyway,
+    // the process mode only transcodes a matching fourcc though, which an invalid one is not
+    if (itemFourcc.empty())
+        return !processFourcc;
+    return fourcc.count(itemFourcc) > 0 ? processFourcc : !processFourcc;
+}
+
 std::unique_ptr<pugi::xml_document> UpnpXMLBuilder::createResponse(const std::string& actionName, const std::string& serviceType)
 {
     auto response = std::make_unique<pugi::xml_document>();
@@ -66,7 +117,7 @@ metadata_fields_t UpnpXMLBuilder::remapMetaDataField(const std::string& fieldNam
     return M_MAX;
 }
 
-void UpnpXMLBuilder::addField(pugi::xml_node& entry, const std::string& key, const std::string& val)
+void UpnpXMLBuilder::addField(XmlSink& entry, const std::string& key, const std::string& val)
 {
     // e.g. used for M_ALBUMARTIST
     // name@attr[val] => <name attr="val">
@@ -74,39 +125,62 @@ void UpnpXMLBuilder::addField(pugi::xml_node& entry, const std::string& key, con
     if (((i = key.find('@')) != std::string::npos)
         && ((j = key.find('[', i + 1)) != std::string::npos)
         && (key[key.length() - 1] == ']')) {
-        std::string attr_name = key.substr(i + 1, j - i - 1);
-        std::string attr_value = key.substr(j + 1, key.length() - j - 2);
-        std::string name = key.substr(0, i);
-        auto node = entry.append_child(name.c_str());
-        node.append_attribute(attr_name.c_str()) = attr_value.c_str();
-        node.append_child(pugi::node_pcdata).set_value(val.c_str());
+        auto keyView = std::string_view(key);
+        entry.startElement(keyView.substr(0, i));
+        entry.addAttribute(keyView.substr(i + 1, j - i - 1), keyView.substr(j + 1, key.length() - j - 2));
+        entry.addText(val);
+        entry.endElement();
     } else {
-        entry.append_child(key.c_str()).append_child(pugi::node_pcdata).set_value(val.c_str());
+        entry.addElement(key, val);
     }
 }
 
 void UpnpXMLBuilder::renderObject(const std::shared_ptr<CdsObject>& obj, size_t stringLimit, pugi::xml_node* parent, const std::shared_ptr<Quirks>& quirks)
 {
-    auto result = parent->append_child("");
+    PugiXmlSink sink(*parent);
+    renderObject(obj, stringLimit, sink, quirks);
+}
 
-    result.append_attribute("id") = obj->getID();
-    result.append_attribute("parentID") = obj->getParentID();
-    result.append_attribute("restricted") = obj->isRestricted() ? "1" : "0";
+void UpnpXMLBuilder::renderObject(const std::shared_ptr<CdsObject>& obj, size_t stringLimit, XmlSink& result, const std::shared_ptr<Quirks>& quirks, const DidlFilter* filter)
+{
+    if (filter == nullptr || filter->all()) {
+        renderProperties(obj, stringLimit, result, quirks, true);
+        return;
+    }
+    FilteringXmlSink filtered(result, *filter);
+    renderProperties(obj, stringLimit, filtered, quirks, filter->needsResources());
+}
+
+void UpnpXMLBuilder::renderProperties(const std::shared_ptr<CdsObject>& obj, size_t stringLimit, XmlSink& result, const std::shared_ptr<Quirks>& quirks, bool resources)
+{
+    result.startElement(obj->isItem() ? "item" : "container");
+
+    result.addAttribute("id", fmt::format_int(obj->getID()).c_str());
+    result.addAttribute("parentID", fmt::format_int(obj->getParentID()).c_str());
+    result.addAttribute("restricted", obj->isRestricted() ? "1" : "0");
+
+    std::shared_ptr<CdsContainer> cont;
+    if (obj->isContainer()) {
+        cont = std::static_pointer_cast<CdsContainer>(obj);
+        int childCount = cont->getChildCount();
+        if (childCount >= 0)
+            result.addAttribute("childCount", fmt::format_int(childCount).c_str());
+    }
 
     std::string tmp = obj->getTitle();
     if ((stringLimit != std::string::npos) && (tmp.length() > stringLimit)) {
         tmp = tmp.substr(0, getValidUTF8CutPosition(tmp, stringLimit - 3));
         tmp = tmp + "...";
     }
-    result.append_child("dc:title").append_child(pugi::node_pcdata).set_value(tmp.c_str());
+    result.addElement("dc:title", tmp);
 
-    result.append_child("upnp:class").append_child(pugi::node_pcdata).set_value(obj->getClass().c_str());
+    result.addElement("upnp:class", obj->getClass());
 
     if (obj->isItem()) {
         auto item = std::static_pointer_cast<CdsItem>(obj);
 
         if (quirks != nullptr)
-            quirks->restoreSamsungBookMarkedPosition(item, &result);
+            quirks->restoreSamsungBookMarkedPosition(item, result);
 
         auto meta = obj->getMetadata();
         std::string upnp_class = obj->getClass();
@@ -118,10 +192,10 @@ void UpnpXMLBuilder::renderObject(const std::shared_ptr<CdsObject>& obj, size_t
                     tmp = tmp.substr(0, getValidUTF8CutPosition(tmp, stringLimit - 3));
                     tmp.append("...");
                 }
-                result.append_child(key.c_str()).append_child(pugi::node_pcdata).set_value(tmp.c_str());
+                result.addElement(key, tmp);
             } else if (key == MetadataHandler::getMetaFieldName(M_TRACKNUMBER)) {
                 if (upnp_class == UPNP_CLASS_MUSIC_TRACK) {
-                    result.append_child(key.c_str()).append_child(pugi::node_pcdata).set_value(val.c_str());
+                    result.addElement(key, val);
                 }
             } else if (key != MetadataHandler::getMetaFieldName(M_TITLE)) {
                 addField(result, key, val);
@@ -135,17 +209,9 @@ void UpnpXMLBuilder::renderObject(const std::shared_ptr<CdsObject>& obj, size_t
             }
         }
 
-        addResources(item, &result);
-
-        result.set_name("item");
-    } else if (obj->isContainer()) {
-        auto cont = std::static_pointer_cast<CdsContainer>(obj);
-
-        result.set_name("container");
-        int childCount = cont->getChildCount();
-        if (childCount >= 0)
-            result.append_attribute("childCount") = childCount;
-
+        if (resources)
+            addResources(item, result);
+    } else if (cont != nullptr) {
         std::string upnp_class = obj->getClass();
         log_debug("container is class: {}", upnp_class.c_str());
         auto meta = obj->getMetadata();
@@ -166,17 +232,15 @@ void UpnpXMLBuilder::renderObject(const std::shared_ptr<CdsObject>& obj, size_t
                 }
             }
         }
-        if (upnp_class == UPNP_CLASS_MUSIC_ALBUM || upnp_class == UPNP_CLASS_MUSIC_ARTIST || upnp_class == UPNP_CLASS_CONTAINER) {
+        if (resources && (upnp_class == UPNP_CLASS_MUSIC_ALBUM || upnp_class == UPNP_CLASS_MUSIC_ARTIST || upnp_class == UPNP_CLASS_CONTAINER)) {
             std::string url;
             bool artAdded = renderContainerImage(virtualURL, cont, url);
             if (artAdded) {
-                result.append_child(MetadataHandler::getMetaFieldName(M_ALBUMARTURI).c_str()).append_child(pugi::node_pcdata).set_value(url.c_str());
+                result.addElement(MetadataHandler::getMetaFieldName(M_ALBUMARTURI), url);
             }
         }
     }
-    // std::ostringstream osr;
-    // result.print(osr, "  ");
-    // log_debug("Rendered DIDL: {}", osr.str());
+    result.endElement();
 }
 
 std::unique_ptr<pugi::xml_document> UpnpXMLBuilder::createEventPropertySet()
@@ -298,24 +362,26 @@ std::unique_ptr<pugi::xml_document> UpnpXMLBuilder::renderDeviceDescription()
     return doc;
 }
 
-void UpnpXMLBuilder::renderResource(const std::string& URL, const std::map<std::string, std::string>& attributes, pugi::xml_node* parent)
+void UpnpXMLBuilder::renderResource(std::string_view URL, const std::map<std::string, std::string>& attributes, XmlSink& parent)
 {
-    auto res = parent->append_child("res");
-    res.append_child(pugi::node_pcdata).set_value(URL.c_str());
-
+    parent.startElement("res");
     for (const auto& [key, val] : attributes) {
-        res.append_attribute(key.c_str()) = val.c_str();
+        parent.addAttribute(key, val);
     }
+    parent.addText(URL);
+    parent.endElement();
 }
 
 std::unique_ptr<UpnpXMLBuilder::PathBase> UpnpXMLBuilder::getPathBase(const std::shared_ptr<CdsItem>& item, bool forceLocal)
 {
+    // the constant parts of the paths, only the object id differs between items
+    static const auto mediaPrefix = RequestHandler::joinUrl({ CONTENT_MEDIA_HANDLER, URL_OBJECT_ID }, true);
+    static const auto onlinePrefix = RequestHandler::joinUrl({ CONTENT_ONLINE_HANDLER, URL_OBJECT_ID }, true);
+    static constexpr auto resIdSuffix = _URL_PARAM_SEPARATOR URL_RESOURCE_ID _URL_PARAM_SEPARATOR;
+
     auto pathBase = std::make_unique<PathBase>();
     /// \todo resource options must be read from configuration files
 
-    std::map<std::string, std::string> dict;
-    dict[URL_OBJECT_ID] = fmt::to_string(item->getID());
-
     pathBase->addResID = false;
     /// \todo move this down into the "for" loop and create different urls
     /// for each resource once the io handlers are ready    int objectType = ;
@@ -326,12 +392,12 @@ std::unique_ptr<UpnpXMLBuilder::PathBase> UpnpXMLBuilder::getPathBase(const std:
         }
 
         if ((item->getFlag(OBJECT_FLAG_ONLINE_SERVICE) && item->getFlag(OBJECT_FLAG_PROXY_URL)) || forceLocal) {
-            pathBase->pathBase = RequestHandler::joinUrl({ CONTENT_ONLINE_HANDLER, dictEncodeSimple(dict), URL_RESOURCE_ID }, true);
+            pathBase->pathBase = fmt::format("{}{}{}", onlinePrefix, item->getID(), resIdSuffix);
             pathBase->addResID = true;
             return pathBase;
         }
     }
-    pathBase->pathBase = RequestHandler::joinUrl({ CONTENT_MEDIA_HANDLER, dictEncodeSimple(dict), URL_RESOURCE_ID }, true);
+    pathBase->pathBase = fmt::format("{}{}{}", mediaPrefix, item->getID(), resIdSuffix);
     pathBase->addResID = true;
     return pathBase;
 }
@@ -344,9 +410,9 @@ std::string UpnpXMLBuilder::getFirstResourcePath(const std::shared_ptr<CdsItem>&
     if (item->isExternalItem() && !urlBase->addResID) { // a remote resource
         result = urlBase->pathBase;
     } else if (urlBase->addResID) { // a proxy, remote, resource
-        result = fmt::format(SERVER_VIRTUAL_DIR "{}0", urlBase->pathBase.c_str());
+        result.append(SERVER_VIRTUAL_DIR).append(urlBase->pathBase).append("0");
     } else { // a local resource
-        result = fmt::format(SERVER_VIRTUAL_DIR "{}", urlBase->pathBase.c_str());
+        result.append(SERVER_VIRTUAL_DIR).append(urlBase->pathBase);
     }
     return result;
 }
@@ -410,16 +476,11 @@ bool UpnpXMLBuilder::renderItemImage(const std::string& virtualURL, const std::s
             || (res->getHandlerType() == CH_LIBEXIF && res->getParameter(RESOURCE_CONTENT_TYPE) == EXIF_THUMBNAIL) //
             || (res->getHandlerType() == CH_FFTH && res->getOption(RESOURCE_CONTENT_TYPE) == THUMBNAIL) //
         ) {
-            auto res_attrs = res->getAttributes();
-            auto res_params = res->getParameters();
-            if (urlBase->addResID) {
-                url = fmt::format("{}{}{}{}", virtualURL.c_str(), urlBase->pathBase.c_str(), realCount, _URL_PARAM_SEPARATOR);
-            } else
-                url = virtualURL + urlBase->pathBase;
+            url.assign(virtualURL).append(urlBase->pathBase);
+            if (urlBase->addResID)
+                url.append(fmt::to_string(realCount)).append(_URL_PARAM_SEPARATOR);
 
-            if (!res_params.empty()) {
-                url.append(dictEncodeSimple(res_params));
-            }
+            dictEncodeSimple(res->getParameters(), url);
             artAdded = true;
             break;
         }
@@ -435,16 +496,11 @@ bool UpnpXMLBuilder::renderSubtitle(const std::string& virtualURL, const std::sh
     int realCount = 0;
     for (const auto& res : item->getResources()) {
         if (res->isMetaResource(VIDEO_SUB)) {
-            auto res_attrs = res->getAttributes();
-            auto res_params = res->getParameters();
-            if (urlBase->addResID) {
-                url = fmt::format("{}{}{}{}", virtualURL.c_str(), urlBase->pathBase, realCount, _URL_PARAM_SEPARATOR);
-            } else
-                url = virtualURL + urlBase->pathBase;
+            url.assign(virtualURL).append(urlBase->pathBase);
+            if (urlBase->addResID)
+                url.append(fmt::to_string(realCount)).append(_URL_PARAM_SEPARATOR);
 
-            if (!res_params.empty()) {
-                url.append(dictEncodeSimple(res_params));
-            }
+            dictEncodeSimple(res->getParameters(), url);
             srtAdded = true;
             break;
         }
@@ -477,13 +533,12 @@ std::string UpnpXMLBuilder::renderExtension(const std::string& contentType, cons
     return "";
 }
 
-void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xml_node* parent)
+void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, XmlSink& parent)
 {
     auto urlBase = getPathBase(item);
     bool skipURL = (item->isExternalItem() && !item->getFlag(OBJECT_FLAG_PROXY_URL));
 
     bool isExtThumbnail = false; // this sucks
-    auto mappings = config->getDictionaryOption(CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST);
 
     // this will be used to count only the "real" resources, omitting the
     // transcoded ones
@@ -499,60 +554,36 @@ void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xm
     // TODO: allow transcoding for URLs
 
     // now get the profile
-    auto tlist = config->getTranscodingProfileListOption(CFG_TRANSCODING_PROFILE_LIST);
-    auto tp_mt = tlist->get(item->getMimeType());
-    if (tp_mt != nullptr) {
-        for (const auto& [key, tp] : *tp_mt) {
-            if (tp == nullptr)
-                throw_std_runtime_error("Invalid profile encountered");
-
-            std::string ct = getValueOrDefault(mappings, item->getMimeType());
-            if (ct == CONTENT_TYPE_OGG) {
-                if (((item->getFlag(OBJECT_FLAG_OGG_THEORA)) && (!tp->isTheora())) || (!item->getFlag(OBJECT_FLAG_OGG_THEORA) && (tp->isTheora()))) {
-                    continue;
-                }
-            }
-            // check user fourcc settings
-            else if (ct == CONTENT_TYPE_AVI) {
-                avi_fourcc_listmode_t fcc_mode = tp->getAVIFourCCListMode();
-
-                std::vector<std::string> fcc_list = tp->getAVIFourCCList();
-                // mode is either process or ignore, so we will have to take a
-                // look at the settings
-                if (fcc_mode != FCC_None) {
-                    std::string current_fcc = item->getResource(0)->getOption(RESOURCE_OPTION_FOURCC);
-                    // we can not do much if the item has no fourcc info,
-                    // so we will transcode it anyway
-                    if (current_fcc.empty()) {
-                        // the process mode specifies that we will transcode
-                        // ONLY if the fourcc matches the list; since an invalid
-                        // fourcc can not match anything we will skip the item
-                        if (fcc_mode == FCC_Process)
-                            continue;
-                    }
-                    // we have the current and hopefully valid fcc string
-                    // let's have a look if it matches the list
-                    else {
-                        bool fcc_match = std::any_of(fcc_list.begin(), fcc_list.end(), [&](const auto& f) { return current_fcc == f; });
-
-                        if (!fcc_match && (fcc_mode == FCC_Process))
-                            continue;
-
-                        if (fcc_match && (fcc_mode == FCC_Ignore))
-                            continue;
-                    }
-                }
+    auto tp_mt = transcodingTable.find(item->getMimeType());
+    if (tp_mt != transcodingTable.end()) {
+        // the results of a transcoding ahead of time replace the live transcoders
+        std::unordered_set<std::string> pretranscoded;
+        for (auto&& res : item->getResources()) {
+            if (res->getHandlerType() == CH_TRANSCODE)
+                pretranscoded.insert(res->getOption(RESOURCE_OPTION_PROFILE));
+        }
+        bool theora = item->getFlag(OBJECT_FLAG_OGG_THEORA);
+        auto fourcc = item->getResourceCount() > 0 ? item->getResource(0)->getOption(RESOURCE_OPTION_FOURCC) : "";
+
+        for (auto&& choice : tp_mt->second) {
+            const auto& tp = choice.profile;
+            if (pretranscoded.count(choice.name) > 0) {
+                if (tp->hideOriginalResource())
+                    hide_original_resource = true;
+                continue;
             }
+            if (!choice.matches(theora, fourcc))
+                continue;
 
             auto t_res = std::make_shared<CdsResource>(CH_TRANSCODE);
-            t_res->addParameter(URL_PARAM_TRANSCODE_PROFILE_NAME, tp->getName());
+            t_res->addParameter(URL_PARAM_TRANSCODE_PROFILE_NAME, choice.name);
             // after transcoding resource was added we can not rely on
             // index 0, so we will make sure the ogg option is there
             t_res->addOption(CONTENT_TYPE_OGG,
                 item->getResource(0)->getOption(CONTENT_TYPE_OGG));
             t_res->addParameter(URL_PARAM_TRANSCODE, URL_VALUE_TRANSCODE);
 
-            std::string targetMimeType = tp->getTargetMimeType();
+            std::string targetMimeType = choice.targetMimeType;
 
             if (!tp->isThumbnail()) {
                 // duration should be the same for transcoded media, so we can
@@ -591,7 +622,7 @@ void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xm
             if (tp->isThumbnail())
                 t_res->addOption(RESOURCE_CONTENT_TYPE, EXIF_THUMBNAIL);
 
-            t_res->mergeAttributes(tp->getAttributes());
+            t_res->mergeAttributes(choice.attributes);
 
             if (tp->hideOriginalResource())
                 hide_original_resource = true;
@@ -607,6 +638,12 @@ void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xm
             urlBase_tr = getPathBase(item, true);
     }
 
+    // the urls of all resources are built in one buffer, behind the virtual url they share
+    std::string url;
+    url.reserve(virtualURL.length() + urlBase->pathBase.length() + 64);
+    const std::size_t pathStart = virtualURL.length();
+    const bool addVirtualURL = !item->isExternalItem() || hide_original_resource;
+
     size_t resCount = item->getResourceCount();
     for (size_t i = 0; i < resCount; i++) {
 
@@ -616,7 +653,7 @@ void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xm
 
         auto res = item->getResource(i);
         auto res_attrs = res->getAttributes();
-        auto res_params = res->getParameters();
+        const auto& res_params = res->getParameters();
         std::string protocolInfo = getValueOrDefault(res_attrs, MetadataHandler::getResAttrName(R_PROTOCOLINFO));
         std::string mimeType = getMTFromProtocolInfo(protocolInfo);
 
@@ -626,8 +663,8 @@ void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xm
         }
 
         assert(!mimeType.empty());
-        std::string contentType = getValueOrDefault(mappings, mimeType);
-        std::string url;
+        const auto& mimeInfo = dlnaMimeTable.get(mimeType);
+        const auto& contentType = mimeInfo.contentType;
 
         /// \todo who will sync mimetype that is part of the protocol info and
         /// that is lying in the resources with the information that is in the
@@ -644,34 +681,36 @@ void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xm
         // because a transcoded resource is identified by the profile name
         // flag if we are dealing with the transcoded resource
         bool transcoded = (getValueOrDefault(res_params, URL_PARAM_TRANSCODE) == URL_VALUE_TRANSCODE);
+        url.assign(virtualURL);
         if (!transcoded) {
-            if (urlBase->addResID) {
-                url = fmt::format("{}{}", urlBase->pathBase, realCount);
-            } else
-                url = urlBase->pathBase;
+            url.append(urlBase->pathBase);
+            if (urlBase->addResID)
+                url.append(fmt::to_string(realCount));
 
             realCount++;
         } else {
             if (!skipURL)
-                url = urlBase->pathBase + URL_VALUE_TRANSCODE_NO_RES_ID;
+                url.append(urlBase->pathBase).append(URL_VALUE_TRANSCODE_NO_RES_ID);
             else {
                 assert(urlBase_tr != nullptr);
-                url = urlBase_tr->pathBase + URL_VALUE_TRANSCODE_NO_RES_ID;
+                url.append(urlBase_tr->pathBase).append(URL_VALUE_TRANSCODE_NO_RES_ID);
             }
         }
         if (!res_params.empty()) {
             url.append(_URL_PARAM_SEPARATOR);
-            url.append(dictEncodeSimple(res_params));
+            dictEncodeSimple(res_params, url);
         }
 
         // ok this really sucks, I guess another rewrite of the resource manager
         // is necessary
         int handlerType = res->getHandlerType();
         if ((i > 0) && (handlerType == CH_EXTURL) && ((res->getOption(RESOURCE_CONTENT_TYPE) == THUMBNAIL) || (res->getOption(RESOURCE_CONTENT_TYPE) == ID3_ALBUM_ART))) {
-            url = res->getOption(RESOURCE_OPTION_URL);
-            if (url.empty())
+            const auto& thumbnailURL = res->getOption(RESOURCE_OPTION_URL);
+            if (thumbnailURL.empty())
                 throw_std_runtime_error("missing thumbnail URL");
 
+            url.assign(virtualURL).append(thumbnailURL);
+
             isExtThumbnail = true;
         }
 
@@ -682,21 +721,22 @@ void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xm
             || (res->getHandlerType() == CH_LIBEXIF && res->getParameter(RESOURCE_CONTENT_TYPE) == EXIF_THUMBNAIL) //
             || (res->getHandlerType() == CH_FFTH && res->getOption(RESOURCE_CONTENT_TYPE) == THUMBNAIL) //
         ) {
-            auto aa = parent->append_child(MetadataHandler::getMetaFieldName(M_ALBUMARTURI).c_str());
-            aa.append_child(pugi::node_pcdata).set_value((virtualURL + url).c_str());
-
+            parent.startElement(MetadataHandler::getMetaFieldName(M_ALBUMARTURI));
             /// \todo clean this up, make sure to check the mimetype and
             /// provide the profile correctly
-            aa.append_attribute("xmlns:dlna") = "urn:schemas-dlna-org:metadata-1-0";
-            aa.append_attribute("dlna:profileID") = "JPEG_TN";
+            parent.addAttribute("xmlns:dlna", "urn:schemas-dlna-org:metadata-1-0");
+            parent.addAttribute("dlna:profileID", "JPEG_TN");
+            parent.addText(url);
+            parent.endElement();
             if (res->isMetaResource(ID3_ALBUM_ART))
                 continue;
         }
         if (res->isMetaResource(VIDEO_SUB)) {
-            auto vs = parent->append_child("sec:CaptionInfoEx");
-            vs.append_child(pugi::node_pcdata).set_value((virtualURL + url).c_str());
-            vs.append_attribute("sec:type") = res->getAttribute(R_TYPE).c_str();
-            vs.append_attribute(MetadataHandler::getResAttrName(R_PROTOCOLINFO).c_str()) = protocolInfo.c_str();
+            parent.startElement("sec:CaptionInfoEx");
+            parent.addAttribute("sec:type", res->getAttribute(R_TYPE));
+            parent.addAttribute(MetadataHandler::getResAttrName(R_PROTOCOLINFO), protocolInfo);
+            parent.addText(url);
+            parent.endElement();
             continue;
         }
 
@@ -706,7 +746,7 @@ void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xm
             // content type here and that we will not limit ourselves to the
             // first resource
             if (!skipURL) {
-                url.append(renderExtension(contentType, transcoded ? "" : item->getLocation()));
+                url.append(renderExtension(contentType, transcoded || handlerType == CH_TRANSCODE ? "" : item->getLocation()));
             }
         }
 
@@ -725,22 +765,25 @@ void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xm
                 else if ((x <= 4096) && (y <= 4096))
                     extend = fmt::format("{}={};", UPNP_DLNA_PROFILE, UPNP_DLNA_PROFILE_JPEG_LRG);
             }
-        } else {
-            /* handle audio/video content */
-            extend = getDLNAprofileString(contentType);
-            if (!extend.empty())
-                extend.append(";");
         }
 
-        // we do not support seeking at all, so 00
+        // transcoded media can only be seeked by time if the profile passes
+        // the start to the transcoder, otherwise 00
         // and the media is converted, so set CI to 1
         if (!isExtThumbnail && transcoded) {
-            extend.append(fmt::format("{}={};{}={}", UPNP_DLNA_OP, UPNP_DLNA_OP_SEEK_DISABLED, UPNP_DLNA_CONVERSION_INDICATOR, UPNP_DLNA_CONVERSION));
+            auto tp = transcodingProfiles != nullptr ? transcodingProfiles->getByName(getValueOrDefault(res_params, URL_PARAM_TRANSCODE_PROFILE_NAME)) : nullptr;
+            auto seek = tp != nullptr && tp->isSeekable() ? UPNP_DLNA_OP_SEEK_TIME : UPNP_DLNA_OP_SEEK_DISABLED;
+            if (!mimeInfo.profile.empty())
+                extend = mimeInfo.profile + ";";
+            extend.append(fmt::format("{}={};{}={}", UPNP_DLNA_OP, seek, UPNP_DLNA_CONVERSION_INDICATOR, UPNP_DLNA_CONVERSION));
 
             if (startswith(mimeType, "audio") || startswith(mimeType, "video"))
                 extend.append(";" UPNP_DLNA_FLAGS "=" UPNP_DLNA_ORG_FLAGS_AV);
-        } else {
+        } else if (contentType == CONTENT_TYPE_JPG) {
             extend.append(fmt::format("{}={};{}={}", UPNP_DLNA_OP, UPNP_DLNA_OP_SEEK_RANGE, UPNP_DLNA_CONVERSION_INDICATOR, UPNP_DLNA_NO_CONVERSION));
+        } else {
+            // audio/video content, the strings only depend on the mime type
+            extend = mimeInfo.protocolInfoExtend;
         }
 
         protocolInfo = protocolInfo.substr(0, protocolInfo.rfind(':') + 1).append(extend);
@@ -748,12 +791,7 @@ void UpnpXMLBuilder::addResources(const std::shared_ptr<CdsItem>& item, pugi::xm
 
         log_debug("protocolInfo: {}", protocolInfo.c_str());
 
-        // URL is path until now
-        if (!item->isExternalItem() || (hide_original_resource && item->isExternalItem())) {
-            url.insert(0, virtualURL);
-        }
-
         if (!hide_original_resource || transcoded || (hide_original_resource && (original_resource != i)))
-            renderResource(url, res_attrs, parent);
+            renderResource(addVirtualURL ? std::string_view(url) : std::string_view(url).substr(pathStart), res_attrs, parent);
     }
 }
@@ -34,11 +34,20 @@
 
 #include <memory>
 #include <pugixml.hpp>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "cds_objects.h"
 #include "common.h"
 #include "context.h"
+#include "util/didl_filter.h"
+#include "util/tools.h"
 #include "util/upnp_quirks.h"
+#include "util/xml_writer.h"
+
+// forward declaration
+class TranscodingProfile;
+class TranscodingProfileList;
 
 class UpnpXMLBuilder {
 public:
@@ -62,6 +71,8 @@ public:
     /// This function looks at the object, and renders the DIDL-Lite representation of it -
     /// either a container or an item
     void renderObject(const std::shared_ptr<CdsObject>& obj, size_t stringLimit, pugi::xml_node* parent, const std::shared_ptr<Quirks>& quirks = nullptr);
+    /// \param filter properties to render, all if nullptr
+    void renderObject(const std::shared_ptr<CdsObject>& obj, size_t stringLimit, XmlSink& result, const std::shared_ptr<Quirks>& quirks = nullptr, const DidlFilter* filter = nullptr);
 
     /// \brief Renders XML for the event property set.
     /// \return pugi::xml_document representing the newly created XML.
@@ -77,13 +88,16 @@ public:
     /// \brief Renders a resource tag (part of DIDL-Lite XML)
     /// \param URL download location of the item (will be child element of the <res> tag)
     /// \param attributes Dictionary containing the <res> tag attributes (like resolution, etc.)
-    static void renderResource(const std::string& URL, const std::map<std::string, std::string>& attributes, pugi::xml_node* parent);
+    static void renderResource(std::string_view URL, const std::map<std::string, std::string>& attributes, XmlSink& parent);
 
     static bool renderContainerImage(const std::string& virtualURL, const std::shared_ptr<CdsContainer>& cont, std::string& url);
     static bool renderItemImage(const std::string& virtualURL, const std::shared_ptr<CdsItem>& item, std::string& url);
     static bool renderSubtitle(const std::string& virtualURL, const std::shared_ptr<CdsItem>& item, std::string& url);
 
-    void addResources(const std::shared_ptr<CdsItem>& item, pugi::xml_node* parent);
+    void addResources(const std::shared_ptr<CdsItem>& item, XmlSink& parent);
+
+    /// \brief precomputed DLNA strings of mimeType
+    const DLNAMimeInfo& getDLNAMimeInfo(const std::string& mimeType) const { return dlnaMimeTable.get(mimeType); }
 
     // FIXME: This needs to go, once we sort a nicer way for the webui code to access this
     static std::string getFirstResourcePath(const std::shared_ptr<CdsItem>& item);
@@ -94,6 +108,31 @@ protected:
 
     const std::string virtualURL;
     const std::string presentationURL;
+    const DLNAMimeTable dlnaMimeTable;
+    const std::shared_ptr<TranscodingProfileList> transcodingProfiles;
+
+    /// \brief a transcoding profile of a source mime type with what addResources needs of it
+    struct TranscodingChoice {
+        std::shared_ptr<TranscodingProfile> profile;
+        std::string name;
+        std::string targetMimeType;
+        std::map<std::string, std::string> attributes;
+        /// \brief ogg sources: the profile is for theora items only, or for the others only
+        bool checkTheora { false };
+        bool theora { false };
+        /// \brief avi sources: transcode only the listed fourccs (process) or all but them (ignore)
+        bool checkFourcc { false };
+        bool processFourcc { false };
+        std::unordered_set<std::string> fourcc;
+
+        /// \brief whether items of the source mime type with these properties are transcoded
+        bool matches(bool itemTheora, const std::string& itemFourcc) const;
+    };
+    /// \brief the profiles of each source mime type, built from CFG_TRANSCODING_PROFILE_LIST with the builder
+    ///
+    /// Like the DLNA table it is not changed afterwards, so it is read without locking.
+    const std::unordered_map<std::string, std::vector<TranscodingChoice>> transcodingTable;
+    std::unordered_map<std::string, std::vector<TranscodingChoice>> buildTranscodingTable() const;
 
     // Holds a part of path and bool which says if we need to append the resource
     // TODO: Remove this and use centralised routing instead of building URLs all over the place
@@ -106,7 +145,8 @@ protected:
     static std::unique_ptr<PathBase> getPathBase(const std::shared_ptr<CdsItem>& item, bool forceLocal = false);
     static std::string renderExtension(const std::string& contentType, const std::string& location);
     std::string getArtworkUrl(const std::shared_ptr<CdsItem>& item) const;
-    static void addField(pugi::xml_node& entry, const std::string& key, const std::string& val);
+    void renderProperties(const std::shared_ptr<CdsObject>& obj, size_t stringLimit, XmlSink& result, const std::shared_ptr<Quirks>& quirks, bool resources);
+    static void addField(XmlSink& entry, const std::string& key, const std::string& val);
     static metadata_fields_t remapMetaDataField(const std::string& fieldName);
 };
 #endif // __UPNP_XML_H__
@@ -162,7 +162,7 @@ std::unique_ptr<IOHandler> URLRequestHandler::open(const char* filename, enum Up
             throw_std_runtime_error("Transcoding of file {} but no profile matching the name {} found", url.c_str(), tr_profile.c_str());
 
         auto tr_d = std::make_unique<TranscodeDispatcher>(content);
-        auto io_handler = tr_d->serveContent(tp, url, item, "");
+        auto io_handler = tr_d->serveContent(tp, url, item, "", 0);
         io_handler->open(mode);
 
         log_debug("end");
@@ -0,0 +1,70 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    compression.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file compression.cc
+
+#include "compression.h" // API
+
+#include <algorithm>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "util/tools.h"
+
+bool acceptsEncoding(const std::string& acceptEncoding, const std::string& coding)
+{
+    auto accepted = splitString(toLower(acceptEncoding), ',');
+    return std::any_of(accepted.begin(), accepted.end(), [&](auto&& entry) {
+        auto params = splitString(entry, ';');
+        return !params.empty() && trimString(params[0]) == coding
+            && std::none_of(params.begin() + 1, params.end(), [](auto&& param) { return trimString(param) == "q=0"; });
+    });
+}
+
+#ifdef HAVE_ZLIB
+std::string gzipCompress(const std::string& data, int level)
+{
+    z_stream stream {};
+    // 16 added to the window bits writes a gzip header instead of a zlib one
+    if (deflateInit2(&stream, level, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw_std_runtime_error("Failed to initialize compression: {}", stream.msg != nullptr ? stream.msg : "");
+
+    std::string result(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    stream.avail_in = data.size();
+    stream.next_out = reinterpret_cast<Bytef*>(result.data());
+    stream.avail_out = result.size();
+
+    // the output buffer is large enough for a single call
+    int ret = deflate(&stream, Z_FINISH);
+    auto written = stream.total_out;
+    deflateEnd(&stream);
+    if (ret != Z_STREAM_END)
+        throw_std_runtime_error("Failed to compress {} bytes", data.size());
+
+    result.resize(written);
+    return result;
+}
+#endif
@@ -0,0 +1,39 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    compression.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file compression.h
+#ifndef __UTIL_COMPRESSION_H__
+#define __UTIL_COMPRESSION_H__
+
+#include <string>
+
+/// \brief true if the Accept-Encoding header lists coding without q=0
+bool acceptsEncoding(const std::string& acceptEncoding, const std::string& coding);
+
+#ifdef HAVE_ZLIB
+/// \brief compress data to the gzip format
+/// \param level zlib compression level, 1 is fastest and 9 smallest
+std::string gzipCompress(const std::string& data, int level);
+#endif
+
+#endif // __UTIL_COMPRESSION_H__
@@ -0,0 +1,262 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    curl_engine.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file curl_engine.cc
+
+#ifdef HAVE_CURL
+#include "curl_engine.h" // API
+
+#include "exceptions.h"
+
+/// \brief longest wait for socket activity, timeouts of the transfers are checked in between
+static constexpr int CURL_ENGINE_POLL_MS = 1000;
+
+CurlEngine& CurlEngine::getInstance()
+{
+    static CurlEngine instance;
+    return instance;
+}
+
+CurlEngine::CurlEngine()
+{
+    shared = curl_share_init();
+    if (shared == nullptr)
+        throw_std_runtime_error("failed to init curl");
+
+    curl_share_setopt(shared, CURLSHOPT_LOCKFUNC, CurlEngine::lockShare);
+    curl_share_setopt(shared, CURLSHOPT_UNLOCKFUNC, CurlEngine::unlockShare);
+    curl_share_setopt(shared, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(shared, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(shared, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+    curl_share_setopt(shared, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+}
+
+CurlEngine::~CurlEngine()
+{
+    shutdown();
+    // handles of online services may still point to the share
+    if (curl_share_cleanup(shared) != CURLSHE_OK)
+        log_debug("curl share still in use");
+}
+
+void CurlEngine::lockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr)
+{
+    static_cast<CurlEngine*>(userptr)->shareLocks.at(data).lock();
+}
+
+void CurlEngine::unlockShare(CURL* handle, curl_lock_data data, void* userptr)
+{
+    static_cast<CurlEngine*>(userptr)->shareLocks.at(data).unlock();
+}
+
+void CurlEngine::share(CURL* handle)
+{
+    curl_easy_setopt(handle, CURLOPT_SHARE, shared);
+}
+
+void CurlEngine::add(const std::shared_ptr<Config>& config, CURL* handle, Callback done)
+{
+    share(handle);
+    {
+        AutoLock lock(mutex);
+        if (shutdownFlag)
+            throw_std_runtime_error("curl engine is shut down");
+        if (thread == nullptr) {
+            // started with the first stream, the server restarts the engine after a shutdown
+            multi = curl_multi_init();
+            if (multi == nullptr)
+                throw_std_runtime_error("failed to init curl");
+            thread = std::make_unique<StdThreadRunner>("CurlEngineThread", CurlEngine::staticThreadProc, this, config);
+            if (!thread->isAlive()) {
+                thread = nullptr;
+                curl_multi_cleanup(multi);
+                multi = nullptr;
+                throw_std_runtime_error("Could not start curl engine thread");
+            }
+        }
+    }
+    queue(Command { Command::Type::Add, handle, std::move(done), nullptr });
+}
+
+void CurlEngine::remove(CURL* handle)
+{
+    auto removed = std::make_shared<std::promise<void>>();
+    auto future = removed->get_future();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (thread == nullptr || stopped)
+            return;
+        if (shutdownFlag) {
+            // the thread aborts all transfers before it ends
+            cond.wait(lock, [this] { return stopped; });
+            return;
+        }
+        commands.push_back(Command { Command::Type::Remove, handle, nullptr, removed });
+        cond.notify_all();
+    }
+    wakeup();
+    future.wait();
+}
+
+void CurlEngine::unpause(CURL* handle)
+{
+    queue(Command { Command::Type::Unpause, handle, nullptr, nullptr });
+}
+
+void CurlEngine::queue(Command command)
+{
+    {
+        AutoLock lock(mutex);
+        if (shutdownFlag)
+            return;
+        commands.push_back(std::move(command));
+        cond.notify_all();
+    }
+    wakeup();
+}
+
+void CurlEngine::wakeup()
+{
+#if LIBCURL_VERSION_NUM >= 0x074400
+    AutoLock lock(mutex);
+    if (multi != nullptr)
+        curl_multi_wakeup(multi);
+#endif
+}
+
+void CurlEngine::shutdown()
+{
+    {
+        AutoLock lock(mutex);
+        if (thread == nullptr)
+            return;
+        shutdownFlag = true;
+        cond.notify_all();
+    }
+    wakeup();
+    thread->join();
+
+    AutoLock lock(mutex);
+    thread = nullptr;
+    curl_multi_cleanup(multi);
+    multi = nullptr;
+    shutdownFlag = false;
+    stopped = false;
+}
+
+void* CurlEngine::staticThreadProc(void* arg)
+{
+    static_cast<CurlEngine*>(arg)->threadProc();
+    return nullptr;
+}
+
+void CurlEngine::apply(Command& command)
+{
+    switch (command.type) {
+    case Command::Type::Add:
+        if (curl_multi_add_handle(multi, command.handle) == CURLM_OK)
+            transfers[command.handle] = std::move(command.done);
+        else
+            command.done(CURLE_FAILED_INIT);
+        break;
+    case Command::Type::Remove:
+        // a finished transfer was removed already
+        if (transfers.erase(command.handle) > 0)
+            curl_multi_remove_handle(multi, command.handle);
+        command.removed->set_value();
+        break;
+    case Command::Type::Unpause:
+        if (transfers.find(command.handle) != transfers.end())
+            curl_easy_pause(command.handle, CURLPAUSE_CONT);
+        break;
+    }
+}
+
+void CurlEngine::finishTransfers()
+{
+    int left;
+    CURLMsg* message;
+    while ((message = curl_multi_info_read(multi, &left)) != nullptr) {
+        if (message->msg != CURLMSG_DONE)
+            continue;
+        auto handle = message->easy_handle;
+        auto result = message->data.result;
+        curl_multi_remove_handle(multi, handle);
+        auto transfer = transfers.find(handle);
+        if (transfer == transfers.end())
+            continue;
+        auto done = std::move(transfer->second);
+        transfers.erase(transfer);
+        done(result);
+    }
+}
+
+void CurlEngine::threadProc()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!shutdownFlag) {
+        while (!commands.empty()) {
+            auto command = std::move(commands.front());
+            commands.pop_front();
+            lock.unlock();
+            apply(command);
+            lock.lock();
+        }
+        if (transfers.empty()) {
+            cond.wait(lock, [this] { return shutdownFlag || !commands.empty(); });
+            continue;
+        }
+        lock.unlock();
+
+        int running;
+        curl_multi_perform(multi, &running);
+        finishTransfers();
+        if (!transfers.empty()) {
+#if LIBCURL_VERSION_NUM >= 0x074400
+            curl_multi_poll(multi, nullptr, 0, CURL_ENGINE_POLL_MS, nullptr);
+#else
+            // without wakeup new commands wait for the next timeout
+            curl_multi_wait(multi, nullptr, 0, 100, nullptr);
+#endif
+        }
+        lock.lock();
+    }
+
+    // the handlers are closed after the shutdown, they must not wait for data
+    for (auto&& [handle, done] : transfers) {
+        curl_multi_remove_handle(multi, handle);
+        done(CURLE_ABORTED_BY_CALLBACK);
+    }
+    transfers.clear();
+    for (auto&& command : commands) {
+        if (command.removed != nullptr)
+            command.removed->set_value();
+    }
+    commands.clear();
+    stopped = true;
+    cond.notify_all();
+}
+
+#endif // HAVE_CURL
@@ -0,0 +1,122 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    curl_engine.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file curl_engine.h
+
+#ifdef HAVE_CURL
+
+#ifndef __CURL_ENGINE_H__
+#define __CURL_ENGINE_H__
+
+#include <array>
+#include <condition_variable>
+#include <curl/curl.h>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "util/thread_runner.h"
+
+// forward declaration
+class Config;
+
+/// \brief Runs the transfers of the remote streams on one thread and shares connections
+///
+/// All transfers go through one curl multi handle, so a stream does not keep a thread busy.
+/// Connections, DNS lookups and TLS sessions are shared by all handles, also by the ones
+/// of online services that still call curl_easy_perform.
+class CurlEngine {
+public:
+    using Callback = std::function<void(CURLcode)>;
+
+    static CurlEngine& getInstance();
+    ~CurlEngine();
+
+    /// \brief start the transfer of handle, done is called on the engine thread when it ends
+    ///
+    /// The write callback of handle runs on the engine thread, it must not block and
+    /// returns CURL_WRITEFUNC_PAUSE if it cannot take the data.
+    void add(const std::shared_ptr<Config>& config, CURL* handle, Callback done);
+
+    /// \brief stop the transfer of handle, no callback of it runs after this returns
+    /// must not be called from a callback
+    void remove(CURL* handle);
+
+    /// \brief continue a transfer whose write callback returned CURL_WRITEFUNC_PAUSE
+    void unpause(CURL* handle);
+
+    /// \brief use the shared caches for handle, curl_easy_reset drops them
+    void share(CURL* handle);
+
+    /// \brief abort all transfers and stop the thread, must be called before curl_global_cleanup
+    /// the next add starts it again
+    void shutdown();
+
+protected:
+    CurlEngine();
+
+    struct Command {
+        enum class Type {
+            Add,
+            Remove,
+            Unpause,
+        } type;
+        CURL* handle;
+        Callback done;
+        std::shared_ptr<std::promise<void>> removed;
+    };
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::condition_variable cond;
+    bool shutdownFlag { false };
+    /// \brief the thread aborted all transfers and ended
+    bool stopped { false };
+    std::deque<Command> commands;
+    std::unique_ptr<StdThreadRunner> thread;
+
+    CURLM* multi { nullptr };
+    CURLSH* shared;
+    std::array<std::mutex, CURL_LOCK_DATA_LAST> shareLocks;
+
+    /// \brief running transfers, only used by the engine thread
+    std::map<CURL*, Callback> transfers;
+
+    void queue(Command command);
+    void wakeup();
+    void apply(Command& command);
+    void finishTransfers();
+
+    static void* staticThreadProc(void* arg);
+    void threadProc();
+
+    static void lockShare(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr);
+    static void unlockShare(CURL* handle, curl_lock_data data, void* userptr);
+};
+
+#endif // __CURL_ENGINE_H__
+
+#endif // HAVE_CURL
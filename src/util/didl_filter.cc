@@ -0,0 +1,125 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    didl_filter.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file didl_filter.cc
+
+#include "didl_filter.h" // API
+
+#include "util/tools.h"
+
+/// \brief elements that are sent without being asked for
+static bool isRequiredElement(std::string_view name)
+{
+    // the bookmark of the samsung quirks is not part of the specification
+    return name == "dc:title" || name == "upnp:class" || name == "sec:dcmInfo";
+}
+
+/// \brief elements rendered from resources instead of metadata
+static bool isResourceElement(std::string_view name)
+{
+    return name == "res" || name == "upnp:albumArtURI" || name == "sec:CaptionInfoEx";
+}
+
+DidlFilter::DidlFilter(const std::string& filter)
+    : filter(trimString(filter))
+{
+    if (this->filter.empty() || this->filter == "*")
+        return;
+
+    for (auto&& entry : splitString(this->filter, ',')) {
+        auto name = trimString(entry);
+        if (name == "*")
+            return;
+        if (name.empty())
+            continue;
+
+        auto at = name.find('@');
+        auto element = name.substr(0, at);
+        auto attribute = at == std::string::npos ? "" : name.substr(at + 1);
+        if (element.empty() || element == "item" || element == "container") {
+            objectAttributes.insert(attribute);
+            continue;
+        }
+        if (element == "res" && !attribute.empty())
+            resourceAttributes.insert(attribute);
+        if (isResourceElement(element))
+            resources = true;
+        else if (!isRequiredElement(element))
+            metadata = true;
+        elements.insert(element);
+    }
+    selectAll = false;
+}
+
+bool DidlFilter::hasElement(std::string_view name) const
+{
+    return selectAll || isRequiredElement(name) || elements.find(name) != elements.end();
+}
+
+bool DidlFilter::hasObjectAttribute(std::string_view name) const
+{
+    return selectAll || name == "id" || name == "parentID" || name == "restricted" || objectAttributes.find(name) != objectAttributes.end();
+}
+
+bool DidlFilter::hasResourceAttribute(std::string_view name) const
+{
+    return selectAll || name == "protocolInfo" || resourceAttributes.find(name) != resourceAttributes.end();
+}
+
+void FilteringXmlSink::startElement(std::string_view name)
+{
+    depth++;
+    if (skipped > 0 || (depth == 2 && !filter.hasElement(name))) {
+        skipped++;
+        return;
+    }
+    resource = depth == 2 && name == "res";
+    target.startElement(name);
+}
+
+void FilteringXmlSink::addAttribute(std::string_view name, std::string_view value)
+{
+    if (skipped > 0)
+        return;
+    if (depth == 1 && !filter.hasObjectAttribute(name))
+        return;
+    if (depth == 2 && resource && !filter.hasResourceAttribute(name))
+        return;
+    target.addAttribute(name, value);
+}
+
+void FilteringXmlSink::addText(std::string_view value)
+{
+    if (skipped == 0)
+        target.addText(value);
+}
+
+void FilteringXmlSink::endElement()
+{
+    depth--;
+    if (skipped > 0) {
+        skipped--;
+        return;
+    }
+    target.endElement();
+}
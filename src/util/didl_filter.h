@@ -0,0 +1,94 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    didl_filter.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file didl_filter.h
+#ifndef __DIDL_FILTER_H__
+#define __DIDL_FILTER_H__
+
+#include <set>
+#include <string>
+#include <string_view>
+
+#include "util/xml_writer.h"
+
+/// \brief Properties requested by the Filter argument of Browse and Search
+///
+/// An empty filter or "*" selects everything. Otherwise the comma separated names select
+/// child elements like "upnp:artist", attributes of the object like "@childCount" and
+/// attributes of resources like "res@duration". The properties required by the
+/// ContentDirectory specification are always returned.
+class DidlFilter {
+public:
+    explicit DidlFilter(const std::string& filter);
+
+    /// \brief no property is left out
+    bool all() const { return selectAll; }
+
+    bool hasElement(std::string_view name) const;
+    /// \brief attribute of the item or container element
+    bool hasObjectAttribute(std::string_view name) const;
+    bool hasResourceAttribute(std::string_view name) const;
+
+    /// \brief a requested element is rendered from the object metadata
+    bool needsMetadata() const { return selectAll || metadata; }
+    /// \brief a requested element is rendered from the object resources
+    bool needsResources() const { return selectAll || resources; }
+
+    const std::string& str() const { return filter; }
+
+protected:
+    std::string filter;
+    bool selectAll { true };
+    bool metadata { false };
+    bool resources { false };
+    std::set<std::string, std::less<>> elements;
+    std::set<std::string, std::less<>> objectAttributes;
+    std::set<std::string, std::less<>> resourceAttributes;
+};
+
+/// \brief Passes only the properties selected by a DidlFilter on to another sink
+///
+/// Expects the item or container element of one object.
+class FilteringXmlSink : public XmlSink {
+public:
+    FilteringXmlSink(XmlSink& target, const DidlFilter& filter)
+        : target(target)
+        , filter(filter)
+    {
+    }
+
+    void startElement(std::string_view name) override;
+    void addAttribute(std::string_view name, std::string_view value) override;
+    void addText(std::string_view value) override;
+    void endElement() override;
+
+private:
+    XmlSink& target;
+    const DidlFilter& filter;
+    int depth { 0 };
+    /// \brief depth below a left out element
+    int skipped { 0 };
+    bool resource { false };
+};
+
+#endif // __DIDL_FILTER_H__
@@ -38,5 +38,41 @@ GenericTask::GenericTask(task_owner_t taskOwner)
     taskType = Invalid;
     taskID = 0;
     parentTaskID = 0;
+    priority = TaskPriority::Normal;
     this->taskOwner = taskOwner;
 }
+
+void GenericTask::start()
+{
+    started = std::chrono::steady_clock::now().time_since_epoch().count();
+    startTime = std::time(nullptr);
+}
+
+GenericTask::Progress GenericTask::getProgress() const
+{
+    Progress progress { itemsDone, itemsTotal, bytesRead, startTime, std::chrono::milliseconds::zero() };
+    auto startedAt = started.load();
+    if (startedAt != 0) {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        progress.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - std::chrono::steady_clock::duration(startedAt));
+    }
+    return progress;
+}
+
+double GenericTask::Progress::itemsPerSecond() const
+{
+    return elapsed.count() > 0 ? itemsDone * 1000.0 / elapsed.count() : 0;
+}
+
+double GenericTask::Progress::bytesPerSecond() const
+{
+    return elapsed.count() > 0 ? bytesRead * 1000.0 / elapsed.count() : 0;
+}
+
+double GenericTask::Progress::eta() const
+{
+    auto rate = itemsPerSecond();
+    if (itemsTotal == 0 || rate <= 0)
+        return -1;
+    return itemsTotal > itemsDone ? (itemsTotal - itemsDone) / rate : 0;
+}
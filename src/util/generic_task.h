@@ -1,6 +1,11 @@
 /*MT*
  */
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
 #include "common.h"
 
 #ifndef __GENERIC_TASK_H__
@@ -12,12 +17,27 @@ enum task_type_t {
     RemoveObject,
     LoadAccounting,
     RescanDirectory,
-    FetchOnlineContent
+    FetchOnlineContent,
+    MoveObject,
+    ReadMetadata,
+    Pretranscode,
+    RebuildLayout
 };
 
 enum task_owner_t {
     ContentManagerTask,
-    TaskProcessorTask
+    TaskProcessorTask,
+    TranscodeTask
+};
+
+/// \brief order in which the task scheduler picks queued tasks
+enum class TaskPriority {
+    /// \brief started from the web UI
+    Interactive,
+    /// \brief single changes like inotify events
+    Normal,
+    /// \brief timed rescans and online service refreshes
+    Background
 };
 
 class GenericTask {
@@ -27,9 +47,20 @@ protected:
     task_owner_t taskOwner;
     unsigned int parentTaskID;
     unsigned int taskID;
-    bool valid;
+    /// \brief tasks of one group and priority run in order, groups take turns
+    std::string group;
+    TaskPriority priority;
+    /// \brief cancellation token, checked by long running tasks between steps
+    std::atomic<bool> valid;
     bool cancellable;
 
+    /// \brief progress counters, written by the task and read by the web UI
+    std::atomic<std::uint64_t> itemsDone { 0 };
+    std::atomic<std::uint64_t> itemsTotal { 0 };
+    std::atomic<std::uint64_t> bytesRead { 0 };
+    std::atomic<std::chrono::steady_clock::rep> started { 0 };
+    std::atomic<std::time_t> startTime { 0 };
+
 public:
     explicit GenericTask(task_owner_t taskOwner);
     virtual void run() = 0;
@@ -40,11 +71,41 @@ public:
     unsigned int getParentID() const { return parentTaskID; }
     void setID(unsigned int taskID) { this->taskID = taskID; }
     void setParentID(unsigned int parentTaskID = 0) { this->parentTaskID = parentTaskID; }
+    std::string getGroup() const { return group; }
+    void setGroup(const std::string& group) { this->group = group; }
+    TaskPriority getPriority() const { return priority; }
+    void setPriority(TaskPriority priority) { this->priority = priority; }
     bool isValid() const { return valid; }
     bool isCancellable() const { return cancellable; }
     void invalidate() { valid = false; }
     task_owner_t getOwner() const { return taskOwner; }
 
+    /// \brief snapshot of the progress counters
+    struct Progress {
+        std::uint64_t itemsDone;
+        /// \brief 0 while unknown, may grow while the task discovers more work
+        std::uint64_t itemsTotal;
+        std::uint64_t bytesRead;
+        /// \brief wall clock time the task started, 0 if it did not start yet
+        std::time_t startTime;
+        std::chrono::milliseconds elapsed;
+
+        double itemsPerSecond() const;
+        double bytesPerSecond() const;
+        /// \brief estimated seconds until the known items are done, -1 if unknown
+        double eta() const;
+    };
+
+    /// \brief called by the task scheduler before run()
+    void start();
+    void addItemsDone(std::uint64_t items, std::uint64_t bytes = 0)
+    {
+        itemsDone += items;
+        bytesRead += bytes;
+    }
+    void addItemsTotal(std::uint64_t items) { itemsTotal += items; }
+    Progress getProgress() const;
+
     virtual ~GenericTask() = default;
 };
 
@@ -31,6 +31,7 @@
 
 #include "tools.h" // API
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstdlib>
@@ -69,38 +70,92 @@ using uchar = unsigned char;
 #define M_DRI 0xDD
 
 #define ITEM_BUF_SIZE 16
+// bytes read from the handler at once
+#define SCAN_BLOCK_SIZE 4096
+
 static int Get16m(const void* Short)
 {
     return (static_cast<uchar*>(const_cast<void*>(Short))[0] << 8) | static_cast<uchar*>(const_cast<void*>(Short))[1];
 }
 
-static int ioh_fgetc(const std::unique_ptr<IOHandler>& ioh)
-{
-    uchar c[1] = { 0 };
-    int ret = ioh->read(reinterpret_cast<char*>(c), sizeof(char));
-    if (ret < 0)
-        return ret;
-    return int(c[0]);
-}
+/// \brief Reads the marker stream in blocks, segments are skipped in the buffer or with one seek
+class JpegScanner {
+public:
+    explicit JpegScanner(const std::unique_ptr<IOHandler>& ioh)
+        : ioh(ioh)
+    {
+    }
+
+    /// \brief next byte or -1 at the end of the data
+    int getc()
+    {
+        if (pos == end && !fill())
+            return -1;
+        return buffer[pos++];
+    }
+
+    /// \brief copy the next length bytes, false if the data ends before
+    bool read(uchar* data, std::size_t length)
+    {
+        while (length > 0) {
+            if (pos == end && !fill())
+                return false;
+            auto count = std::min(length, end - pos);
+            std::memcpy(data, buffer + pos, count);
+            pos += count;
+            data += count;
+            length -= count;
+        }
+        return true;
+    }
+
+    void skip(off_t length)
+    {
+        auto buffered = off_t(end - pos);
+        if (length <= buffered) {
+            pos += length;
+            return;
+        }
+        ioh->seek(length - buffered, SEEK_CUR);
+        pos = end = 0;
+    }
+
+private:
+    const std::unique_ptr<IOHandler>& ioh;
+    uchar buffer[SCAN_BLOCK_SIZE];
+    std::size_t pos { 0 };
+    std::size_t end { 0 };
+
+    bool fill()
+    {
+        auto got = ioh->read(reinterpret_cast<char*>(buffer), sizeof(buffer));
+        if (got == 0 || got > sizeof(buffer))
+            return false;
+        pos = 0;
+        end = got;
+        return true;
+    }
+};
 
 static void get_jpeg_resolution(const std::unique_ptr<IOHandler>& ioh, int* w, int* h)
 {
+    JpegScanner scanner(ioh);
     int a;
 
-    a = ioh_fgetc(ioh);
+    a = scanner.getc();
 
-    if (a != 0xff || ioh_fgetc(ioh) != M_SOI)
+    if (a != 0xff || scanner.getc() != M_SOI)
         throw_std_runtime_error("get_jpeg_resolution: could not read jpeg specs");
 
     for (;;) {
         int itemlen;
         off_t skip;
         int marker = 0;
-        int ll, lh, got;
+        int ll, lh;
         uchar Data[ITEM_BUF_SIZE];
 
         for (a = 0; a < 7; a++) {
-            marker = ioh_fgetc(ioh);
+            marker = scanner.getc();
             if (marker != 0xff)
                 break;
 
@@ -111,10 +166,14 @@ static void get_jpeg_resolution(const std::unique_ptr<IOHandler>& ioh, int* w, i
         // 0xff is legal padding, but if we get that many, something's wrong.
         if (marker == 0xff)
             throw_std_runtime_error("get_jpeg_resolution: too many padding bytes");
+        if (marker < 0)
+            throw_std_runtime_error("get_jpeg_resolution: Premature end of file?");
 
         // Read the length of the section.
-        lh = ioh_fgetc(ioh);
-        ll = ioh_fgetc(ioh);
+        lh = scanner.getc();
+        ll = scanner.getc();
+        if (ll < 0)
+            throw_std_runtime_error("get_jpeg_resolution: Premature end of file?");
 
         itemlen = (lh << 8) | ll;
 
@@ -131,11 +190,10 @@ static void get_jpeg_resolution(const std::unique_ptr<IOHandler>& ioh, int* w, i
         Data[0] = uchar(lh);
         Data[1] = uchar(ll);
 
-        got = ioh->read(reinterpret_cast<char*>(Data + 2), itemlen - 2);
-        if (got != itemlen - 2)
+        if (!scanner.read(Data + 2, itemlen - 2))
             throw_std_runtime_error("get_jpeg_resolution: Premature end of file?");
 
-        ioh->seek(skip, SEEK_CUR);
+        scanner.skip(skip);
 
         switch (marker) {
         case M_EOI: // in case it's a tables-only JPEG stream
@@ -0,0 +1,174 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    json_writer.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file json_writer.cc
+
+#include "json_writer.h" // API
+
+#include <fmt/format.h>
+
+#include "util/tools.h"
+
+void PugiJsonSink::startObject(std::string_view key)
+{
+    auto name = !arrays.empty() && !arrays.back().empty() ? arrays.back() : std::string(key);
+    current = current.append_child(name.c_str());
+    arrays.emplace_back();
+}
+
+void PugiJsonSink::startArray(std::string_view key)
+{
+    hints.setArrayName(current, std::string(key));
+    arrays.emplace_back(key);
+}
+
+void PugiJsonSink::end()
+{
+    if (arrays.empty())
+        throw_std_runtime_error("end without start");
+    if (arrays.back().empty())
+        current = current.parent();
+    arrays.pop_back();
+}
+
+void PugiJsonSink::addString(std::string_view key, std::string_view value)
+{
+    auto name = std::string(key);
+    current.append_attribute(name.c_str()) = std::string(value).c_str();
+    hints.setFieldType(name, "string");
+}
+
+void PugiJsonSink::addNumber(std::string_view key, std::int64_t value)
+{
+    current.append_attribute(std::string(key).c_str()) = static_cast<long long>(value);
+}
+
+void PugiJsonSink::addBool(std::string_view key, bool value)
+{
+    current.append_attribute(std::string(key).c_str()) = value;
+}
+
+JsonStreamWriter::JsonStreamWriter(std::size_t reserve)
+{
+    buffer.reserve(reserve);
+}
+
+void JsonStreamWriter::escape(std::string& out, std::string_view value)
+{
+    out.push_back('"');
+    auto start = value.begin();
+    for (auto it = value.begin(); it != value.end(); ++it) {
+        const char* replacement;
+        char code[7];
+        auto ch = static_cast<unsigned char>(*it);
+        switch (ch) {
+        case '"':
+            replacement = "\\\"";
+            break;
+        case '\\':
+            replacement = "\\\\";
+            break;
+        case '\n':
+            replacement = "\\n";
+            break;
+        case '\r':
+            replacement = "\\r";
+            break;
+        case '\t':
+            replacement = "\\t";
+            break;
+        default:
+            if (ch >= 32)
+                continue;
+            *fmt::format_to(code, "\\u{:04x}", ch) = '\0';
+            replacement = code;
+        }
+        out.append(start, it);
+        out.append(replacement);
+        start = it + 1;
+    }
+    out.append(start, value.end());
+    out.push_back('"');
+}
+
+void JsonStreamWriter::startMember(std::string_view key)
+{
+    if (!first)
+        buffer.push_back(',');
+    first = false;
+    if (arrays.empty() || !arrays.back()) {
+        escape(buffer, key);
+        buffer.push_back(':');
+    }
+}
+
+void JsonStreamWriter::startObject(std::string_view key)
+{
+    startMember(key);
+    buffer.push_back('{');
+    arrays.push_back(false);
+    first = true;
+}
+
+void JsonStreamWriter::startArray(std::string_view key)
+{
+    startMember(key);
+    buffer.push_back('[');
+    arrays.push_back(true);
+    first = true;
+}
+
+void JsonStreamWriter::end()
+{
+    if (arrays.empty())
+        throw_std_runtime_error("end without start");
+    buffer.push_back(arrays.back() ? ']' : '}');
+    arrays.pop_back();
+    first = false;
+}
+
+void JsonStreamWriter::addString(std::string_view key, std::string_view value)
+{
+    startMember(key);
+    escape(buffer, value);
+}
+
+void JsonStreamWriter::addNumber(std::string_view key, std::int64_t value)
+{
+    startMember(key);
+    fmt::format_to(std::back_inserter(buffer), "{}", value);
+}
+
+void JsonStreamWriter::addBool(std::string_view key, bool value)
+{
+    startMember(key);
+    buffer.append(value ? "true" : "false");
+}
+
+std::string JsonStreamWriter::releaseFragment()
+{
+    if (!arrays.empty())
+        throw_std_runtime_error("{} objects or arrays are not ended", arrays.size());
+    first = true;
+    return std::move(buffer);
+}
@@ -0,0 +1,115 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    json_writer.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file json_writer.h
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+#include <cstdint>
+#include <pugixml.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/xml_to_json.h"
+
+/// \brief Receives the members of a JSON response one at a time
+///
+/// Arrays hold objects only. An object holds values and at most one array, values come first,
+/// so the same calls can also build the XML tree Xml2Json expects.
+class JsonSink {
+public:
+    virtual ~JsonSink() = default;
+
+    /// \brief start an object, the key is ignored in arrays
+    virtual void startObject(std::string_view key) = 0;
+    /// \brief start an array, the key names the elements in XML
+    virtual void startArray(std::string_view key) = 0;
+    /// \brief end the current object or array
+    virtual void end() = 0;
+
+    virtual void addString(std::string_view key, std::string_view value) = 0;
+    virtual void addNumber(std::string_view key, std::int64_t value) = 0;
+    virtual void addBool(std::string_view key, bool value) = 0;
+};
+
+/// \brief Builds pugixml nodes for the calls, for the XML output of the web UI
+///
+/// Objects become elements and values become attributes. The hints tell Xml2Json about the arrays.
+class PugiJsonSink : public JsonSink {
+public:
+    PugiJsonSink(pugi::xml_node parent, Xml2Json::Hints& hints)
+        : current(parent)
+        , hints(hints)
+    {
+    }
+
+    void startObject(std::string_view key) override;
+    void startArray(std::string_view key) override;
+    void end() override;
+
+    void addString(std::string_view key, std::string_view value) override;
+    void addNumber(std::string_view key, std::int64_t value) override;
+    void addBool(std::string_view key, bool value) override;
+
+private:
+    pugi::xml_node current;
+    Xml2Json::Hints& hints;
+    /// \brief element names of the open arrays, empty for objects
+    std::vector<std::string> arrays;
+};
+
+/// \brief Writes the calls as JSON text straight into a string
+///
+/// The writer starts inside an object without the braces, so the members can be
+/// added to another JSON object.
+class JsonStreamWriter : public JsonSink {
+public:
+    /// \param reserve bytes to allocate up front
+    explicit JsonStreamWriter(std::size_t reserve = 0);
+
+    void startObject(std::string_view key) override;
+    void startArray(std::string_view key) override;
+    void end() override;
+
+    void addString(std::string_view key, std::string_view value) override;
+    void addNumber(std::string_view key, std::int64_t value) override;
+    void addBool(std::string_view key, bool value) override;
+
+    /// \brief the members written so far, all objects and arrays must be ended
+    std::string releaseFragment();
+
+    /// \brief append value to out as a quoted JSON string
+    static void escape(std::string& out, std::string_view value);
+
+private:
+    /// \brief comma and key of the next member
+    void startMember(std::string_view key);
+
+    std::string buffer;
+    /// \brief one entry per open object or array, true if it is an array
+    std::vector<bool> arrays;
+    bool first { true };
+};
+
+#endif // __JSON_WRITER_H__
@@ -0,0 +1,53 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    logger.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file logger.cc
+
+#include "logger.h" // API
+
+#include <algorithm>
+#include <string_view>
+
+/// \brief subsystems with debug output, empty for all
+static std::vector<std::string> debugSubsystems;
+
+void GrbLogger::setDebugSubsystems(const std::vector<std::string>& subsystems)
+{
+    debugSubsystems = subsystems;
+}
+
+bool GrbLogger::isDebugging(const char* file)
+{
+    if (debugSubsystems.empty())
+        return true;
+
+    std::string_view path(file);
+    auto pos = path.rfind("src/");
+    if (pos == std::string_view::npos)
+        return false;
+    path.remove_prefix(pos + 4);
+
+    auto slash = path.find('/');
+    auto subsystem = slash == std::string_view::npos ? std::string_view("server") : path.substr(0, slash);
+    return std::find(debugSubsystems.begin(), debugSubsystems.end(), subsystem) != debugSubsystems.end();
+}
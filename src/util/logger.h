@@ -33,11 +33,41 @@
 #define __LOGGER_H__
 
 #include <spdlog/spdlog.h>
+#include <string>
+#include <vector>
 
-#define log_debug SPDLOG_DEBUG
-#define log_info SPDLOG_INFO
-#define log_warning SPDLOG_WARN
-#define log_error SPDLOG_ERROR
-#define log_js SPDLOG_INFO
+namespace GrbLogger {
+/// \brief limit the debug output to the given subsystems, all are enabled if the list is empty
+///
+/// A subsystem is the source directory below src, e.g. "content" or "database",
+/// files directly in src belong to "server". Must be set before other threads log.
+void setDebugSubsystems(const std::vector<std::string>& subsystems);
+
+/// \brief whether debug output of the source file is enabled
+bool isDebugging(const char* file);
+} // namespace GrbLogger
+
+/// \brief the arguments are only evaluated if the level is enabled
+#define GRB_LOG(level, ...)                                                       \
+    do {                                                                          \
+        if (spdlog::should_log(level))                                            \
+            SPDLOG_LOGGER_CALL(spdlog::default_logger_raw(), level, __VA_ARGS__); \
+    } while (false)
+
+// builds without WITH_DEBUG drop the debug output at compile time
+#if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define log_debug(...)                                                                           \
+    do {                                                                                         \
+        if (spdlog::should_log(spdlog::level::debug) && GrbLogger::isDebugging(__FILE__))        \
+            SPDLOG_LOGGER_CALL(spdlog::default_logger_raw(), spdlog::level::debug, __VA_ARGS__); \
+    } while (false)
+#else
+#define log_debug(...) (void)0
+#endif
+
+#define log_info(...) GRB_LOG(spdlog::level::info, __VA_ARGS__)
+#define log_warning(...) GRB_LOG(spdlog::level::warn, __VA_ARGS__)
+#define log_error(...) GRB_LOG(spdlog::level::err, __VA_ARGS__)
+#define log_js(...) GRB_LOG(spdlog::level::info, __VA_ARGS__)
 
 #endif // __LOGGER_H__
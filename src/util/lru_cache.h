@@ -0,0 +1,119 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    lru_cache.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file lru_cache.h
+#ifndef __LRU_CACHE_H__
+#define __LRU_CACHE_H__
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <utility>
+
+/// \brief Entries ordered by use with a lookup by key
+///
+/// Only keeps the order, the owner decides when to evict and holds its own lock.
+/// Iterators stay valid until their entry is erased, also when it is moved to the front.
+/// Index is the map of keys to entries, std::map or std::unordered_map.
+template <typename K, typename V, template <typename...> class Index = std::map>
+class LruCache {
+public:
+    using Entry = std::pair<const K, V>;
+    using iterator = typename std::list<Entry>::iterator;
+    using IndexValue = typename Index<K, iterator>::value_type;
+
+    /// \brief entry of key or end(), does not change the order
+    iterator find(const K& key)
+    {
+        auto entry = index.find(key);
+        return entry != index.end() ? entry->second : entries.end();
+    }
+
+    /// \brief entry of key moved to the front or end()
+    iterator get(const K& key)
+    {
+        auto entry = find(key);
+        if (entry != entries.end())
+            touch(entry);
+        return entry;
+    }
+
+    /// \brief mark entry as most recently used
+    void touch(iterator entry) { entries.splice(entries.begin(), entries, entry); }
+
+    /// \brief store value as most recently used, replaces an entry of the same key
+    iterator put(const K& key, V value)
+    {
+        auto entry = index.find(key);
+        if (entry != index.end()) {
+            entry->second->second = std::move(value);
+            touch(entry->second);
+            return entry->second;
+        }
+        entries.emplace_front(key, std::move(value));
+        index.emplace(key, entries.begin());
+        return entries.begin();
+    }
+
+    /// \brief remove entry, returns the next less recently used one
+    iterator erase(iterator entry)
+    {
+        index.erase(entry->first);
+        return entries.erase(entry);
+    }
+
+    bool erase(const K& key)
+    {
+        auto entry = index.find(key);
+        if (entry == index.end())
+            return false;
+        entries.erase(entry->second);
+        index.erase(entry);
+        return true;
+    }
+
+    /// \brief least recently used entry, the cache must not be empty
+    Entry& back() { return entries.back(); }
+    void pop_back() { erase(std::prev(entries.end())); }
+
+    /// \brief most recently used first
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+
+    std::size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    /// \brief buckets of an unordered index
+    std::size_t bucket_count() const { return index.bucket_count(); }
+
+    void clear()
+    {
+        index.clear();
+        entries.clear();
+    }
+
+private:
+    std::list<Entry> entries;
+    Index<K, iterator> index;
+};
+
+#endif // __LRU_CACHE_H__
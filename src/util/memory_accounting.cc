@@ -0,0 +1,86 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    memory_accounting.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file memory_accounting.cc
+
+#include "memory_accounting.h" // API
+
+#include "metrics.h"
+
+MemoryAccounting& MemoryAccounting::getInstance()
+{
+    static MemoryAccounting instance;
+    return instance;
+}
+
+MemoryAccounting::Registration::~Registration()
+{
+    getInstance().remove(id);
+}
+
+std::unique_ptr<MemoryAccounting::Registration> MemoryAccounting::add(const std::string& subsystem, Estimate estimate)
+{
+    AutoLock lock(mutex);
+    auto id = nextID++;
+    estimates.emplace(id, std::make_pair(subsystem, std::move(estimate)));
+    return std::unique_ptr<Registration>(new Registration(id));
+}
+
+void MemoryAccounting::remove(std::size_t id)
+{
+    AutoLock lock(mutex);
+    estimates.erase(id);
+}
+
+std::map<std::string, std::size_t> MemoryAccounting::getUsage()
+{
+    std::map<std::string, std::size_t> usage;
+    if (!enabled)
+        return usage;
+
+    AutoLock lock(mutex);
+    for (auto&& [id, estimate] : estimates)
+        usage[estimate.first] += estimate.second();
+    return usage;
+}
+
+void MemoryAccounting::publish()
+{
+    for (auto&& [subsystem, bytes] : getUsage())
+        Metrics::getInstance().gauge("gerbera_memory_bytes", "Estimated memory held by the subsystems", Metrics::label("subsystem", subsystem)).set(bytes);
+}
+
+std::size_t MemoryAccounting::estimate(const std::string& str)
+{
+    // the capacity of the inline buffer of an empty string
+    static const std::size_t inlineCapacity = std::string().capacity();
+    return str.capacity() > inlineCapacity ? str.capacity() + 1 : 0;
+}
+
+std::size_t MemoryAccounting::estimate(const std::map<std::string, std::string>& dict)
+{
+    std::size_t bytes = 0;
+    for (auto&& [key, value] : dict)
+        bytes += TREE_NODE + sizeof(std::pair<const std::string, std::string>) + estimate(key) + estimate(value);
+    return bytes;
+}
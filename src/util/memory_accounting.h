@@ -0,0 +1,95 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    memory_accounting.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file memory_accounting.h
+#ifndef __MEMORY_ACCOUNTING_H__
+#define __MEMORY_ACCOUNTING_H__
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+/// \brief Estimated memory of the large holders of the server, by subsystem
+///
+/// The holders register a function that estimates their current size, it is only called
+/// when the usage is reported. Estimates count the payload and the node overhead of the
+/// standard containers, not the padding of the allocator.
+class MemoryAccounting {
+public:
+    using Estimate = std::function<std::size_t()>;
+
+    /// \brief removes the estimate when destroyed, keep it as last member of the holder
+    class Registration {
+    public:
+        ~Registration();
+
+    private:
+        friend class MemoryAccounting;
+        explicit Registration(std::size_t id)
+            : id(id)
+        {
+        }
+        std::size_t id;
+    };
+
+    static MemoryAccounting& getInstance();
+
+    void setEnabled(bool enabled) { this->enabled = enabled; }
+    bool isEnabled() const { return enabled; }
+
+    /// \brief add estimate to the bytes of subsystem, several holders can use the same subsystem
+    /// \param estimate called with the lock of the registry held, it must not register itself
+    std::unique_ptr<Registration> add(const std::string& subsystem, Estimate estimate);
+
+    /// \brief bytes per subsystem, empty if accounting is disabled
+    std::map<std::string, std::size_t> getUsage();
+
+    /// \brief copy the usage into the gerbera_memory_bytes gauges of the metrics
+    void publish();
+
+    /// \brief estimate of the heap memory of a string, short strings are stored inline
+    static std::size_t estimate(const std::string& str);
+    static std::size_t estimate(const std::map<std::string, std::string>& dict);
+
+    /// \brief overhead of one node of std::map and std::set
+    static constexpr std::size_t TREE_NODE = 4 * sizeof(void*);
+    /// \brief overhead of one node of std::unordered_map and std::unordered_set, buckets excluded
+    static constexpr std::size_t HASH_NODE = sizeof(void*) + sizeof(std::size_t);
+    /// \brief overhead of one node of std::list
+    static constexpr std::size_t LIST_NODE = 2 * sizeof(void*);
+
+protected:
+    MemoryAccounting() = default;
+
+    void remove(std::size_t id);
+
+    bool enabled { false };
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::size_t nextID { 0 };
+    std::map<std::size_t, std::pair<std::string, Estimate>> estimates;
+};
+
+#endif // __MEMORY_ACCOUNTING_H__
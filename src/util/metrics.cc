@@ -0,0 +1,141 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    metrics.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file metrics.cc
+
+#include "metrics.h" // API
+
+#include <algorithm>
+#include <mutex>
+
+#include "common.h"
+
+void Metrics::Histogram::observe(std::chrono::steady_clock::duration duration)
+{
+    auto seconds = std::chrono::duration<double>(duration).count();
+    auto bucket = std::lower_bound(BOUNDS.begin(), BOUNDS.end(), seconds) - BOUNDS.begin();
+    buckets.at(bucket).fetch_add(1, std::memory_order_relaxed);
+    sumMicros.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), std::memory_order_relaxed);
+}
+
+Metrics& Metrics::getInstance()
+{
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::CacheRequests::CacheRequests(std::string_view cache)
+    : hits(getInstance().counter("gerbera_cache_requests_total", "Lookups in the caches", fmt::format("{},{}", label("cache", cache), label("result", "hit"))))
+    , misses(getInstance().counter("gerbera_cache_requests_total", "Lookups in the caches", fmt::format("{},{}", label("cache", cache), label("result", "miss"))))
+{
+}
+
+template <class T>
+T& Metrics::get(const std::string& name, const std::string& help, const std::string& labels, Type type, std::map<std::string, std::unique_ptr<T>> Family::*metrics)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto family = families.find(name);
+        if (family != families.end() && family->second.type == type) {
+            auto metric = (family->second.*metrics).find(labels);
+            if (metric != (family->second.*metrics).end())
+                return *metric->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto&& family = families.try_emplace(name, Family { help, type, {}, {}, {} }).first->second;
+    if (family.type != type)
+        throw_std_runtime_error("Metric {} registered with another type", name);
+    auto&& metric = (family.*metrics)[labels];
+    if (metric == nullptr)
+        metric = std::make_unique<T>();
+    return *metric;
+}
+
+Metrics::Counter& Metrics::counter(const std::string& name, const std::string& help, const std::string& labels)
+{
+    return get(name, help, labels, Type::Counter, &Family::counters);
+}
+
+Metrics::Gauge& Metrics::gauge(const std::string& name, const std::string& help, const std::string& labels)
+{
+    return get(name, help, labels, Type::Gauge, &Family::gauges);
+}
+
+Metrics::Histogram& Metrics::histogram(const std::string& name, const std::string& help, const std::string& labels)
+{
+    return get(name, help, labels, Type::Histogram, &Family::histograms);
+}
+
+std::string Metrics::label(std::string_view key, std::string_view value)
+{
+    std::string result(key);
+    result.append("=\"");
+    for (auto c : value) {
+        if (c == '\\' || c == '"')
+            result.push_back('\\');
+        if (c == '\n')
+            result.append("\\n");
+        else
+            result.push_back(c);
+    }
+    result.push_back('"');
+    return result;
+}
+
+/// \brief name{labels} with the extra label appended
+static std::string series(const std::string& name, const std::string& labels, const std::string& extra = "")
+{
+    if (labels.empty() && extra.empty())
+        return name;
+    if (labels.empty() || extra.empty())
+        return fmt::format("{}{{{}{}}}", name, labels, extra);
+    return fmt::format("{}{{{},{}}}", name, labels, extra);
+}
+
+std::string Metrics::render() const
+{
+    static constexpr std::array<std::string_view, 3> TYPE_NAMES { "counter", "gauge", "histogram" };
+
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    std::string result;
+    for (auto&& [name, family] : families) {
+        result.append(fmt::format("# HELP {} {}\n# TYPE {} {}\n", name, family.help, name, TYPE_NAMES.at(static_cast<std::size_t>(family.type))));
+        for (auto&& [labels, counter] : family.counters)
+            result.append(fmt::format("{} {}\n", series(name, labels), counter->get()));
+        for (auto&& [labels, gauge] : family.gauges)
+            result.append(fmt::format("{} {}\n", series(name, labels), gauge->get()));
+        for (auto&& [labels, histogram] : family.histograms) {
+            std::uint64_t count = 0;
+            for (std::size_t i = 0; i < histogram->buckets.size(); i++) {
+                count += histogram->buckets.at(i).load(std::memory_order_relaxed);
+                auto bound = i < Histogram::BOUNDS.size() ? fmt::format("{}", Histogram::BOUNDS.at(i)) : "+Inf";
+                result.append(fmt::format("{} {}\n", series(name + "_bucket", labels, label("le", bound)), count));
+            }
+            result.append(fmt::format("{} {}\n", series(name + "_sum", labels), histogram->sumMicros.load(std::memory_order_relaxed) / 1e6));
+            result.append(fmt::format("{} {}\n", series(name + "_count", labels), count));
+        }
+    }
+    return result;
+}
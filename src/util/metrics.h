@@ -0,0 +1,136 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    metrics.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file metrics.h
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+/// \brief Counters, gauges and histograms of the whole server, rendered in the Prometheus text format
+///
+/// Updating a metric only touches atomics. Looking a metric up takes a shared lock, so call sites
+/// on hot paths keep the returned reference, metrics are never removed.
+class Metrics {
+public:
+    class Counter {
+    public:
+        void inc(std::uint64_t count = 1) { value.fetch_add(count, std::memory_order_relaxed); }
+        std::uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<std::uint64_t> value { 0 };
+    };
+
+    class Gauge {
+    public:
+        void inc(std::int64_t count = 1) { value.fetch_add(count, std::memory_order_relaxed); }
+        void dec(std::int64_t count = 1) { value.fetch_sub(count, std::memory_order_relaxed); }
+        void set(std::int64_t newValue) { value.store(newValue, std::memory_order_relaxed); }
+        std::int64_t get() const { return value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<std::int64_t> value { 0 };
+    };
+
+    class Histogram {
+    public:
+        /// \brief upper bounds of the buckets in seconds, the +Inf bucket follows
+        static constexpr std::array<double, 10> BOUNDS { 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10 };
+
+        void observe(std::chrono::steady_clock::duration duration);
+
+        /// \brief observes the time until it goes out of scope
+        class Timer {
+        public:
+            explicit Timer(Histogram& histogram)
+                : histogram(histogram)
+            {
+            }
+            ~Timer() { histogram.observe(std::chrono::steady_clock::now() - start); }
+
+        private:
+            Histogram& histogram;
+            std::chrono::steady_clock::time_point start { std::chrono::steady_clock::now() };
+        };
+
+    private:
+        friend class Metrics;
+        /// \brief observations per bucket, not cumulative
+        std::array<std::atomic<std::uint64_t>, BOUNDS.size() + 1> buckets {};
+        std::atomic<std::uint64_t> sumMicros { 0 };
+    };
+
+    /// \brief hit and miss counters of one cache in gerbera_cache_requests_total
+    struct CacheRequests {
+        explicit CacheRequests(std::string_view cache);
+        Counter& hits;
+        Counter& misses;
+    };
+
+    static Metrics& getInstance();
+
+    /// \param labels label list without braces, built with label()
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "");
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "");
+    Histogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+    /// \brief key="value" with the value escaped
+    static std::string label(std::string_view key, std::string_view value);
+
+    /// \brief all metrics in the Prometheus text exposition format
+    std::string render() const;
+
+protected:
+    Metrics() = default;
+
+    enum class Type {
+        Counter,
+        Gauge,
+        Histogram,
+    };
+
+    struct Family {
+        std::string help;
+        Type type;
+        std::map<std::string, std::unique_ptr<Counter>> counters;
+        std::map<std::string, std::unique_ptr<Gauge>> gauges;
+        std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    };
+
+    template <class T>
+    T& get(const std::string& name, const std::string& help, const std::string& labels, Type type, std::map<std::string, std::unique_ptr<T>> Family::*metrics);
+
+    mutable std::shared_mutex mutex;
+    std::map<std::string, Family> families;
+};
+
+#endif // __METRICS_H__
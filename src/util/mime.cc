@@ -25,13 +25,20 @@
 
 #include "mime.h" // API
 
+#include <cstdio>
+#include <string_view>
+
 #include "config/config_manager.h"
 #include "util/tools.h"
 
+/// \brief bytes read from a file to find its signature, two MPEG-TS packets and a sync byte fit
+static constexpr std::size_t SIGNATURE_SIZE = 2 * 188 + 1;
+
 Mime::Mime(const std::shared_ptr<Config>& config)
 {
     extension_map_case_sensitive = config->getBoolOption(CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_CASE_SENSITIVE);
-    extension_mimetype_map = config->getDictionaryOption(CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_LIST);
+    auto extensions = config->getDictionaryOption(CFG_IMPORT_MAPPINGS_EXTENSION_TO_MIMETYPE_LIST);
+    extension_mimetype_map.insert(extensions.begin(), extensions.end());
     mimetype_upnpclass_map = config->getDictionaryOption(CFG_IMPORT_MAPPINGS_MIMETYPE_TO_UPNP_CLASS_LIST);
 
     ignore_unknown_extensions = config->getBoolOption(CFG_IMPORT_MAPPINGS_IGNORE_UNKNOWN_EXTENSIONS);
@@ -43,39 +50,44 @@ Mime::Mime(const std::shared_ptr<Config>& config)
 
 #ifdef HAVE_MAGIC
     // init filemagic
-    int magicFlags = config->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS) ? MAGIC_MIME_TYPE | MAGIC_SYMLINK : MAGIC_MIME_TYPE;
-    magicCookie = magic_open(magicFlags);
-    if (magicCookie == nullptr) {
-        throw_std_runtime_error("magic_open failed");
-    }
-
-    std::string optMagicFile = config->getOption(CFG_IMPORT_MAGIC_FILE);
-    const char* magicFile = !optMagicFile.empty() ? optMagicFile.c_str() : nullptr;
-    if (magic_load(magicCookie, magicFile) == -1) {
-        auto errMsg = magic_error(magicCookie);
-        magic_close(magicCookie);
-        magicCookie = nullptr;
-        throw_std_runtime_error("magic_load failed: {}", errMsg);
-    }
+    magicFlags = config->getBoolOption(CFG_IMPORT_FOLLOW_SYMLINKS) ? MAGIC_MIME_TYPE | MAGIC_SYMLINK : MAGIC_MIME_TYPE;
+    magicFile = config->getOption(CFG_IMPORT_MAGIC_FILE);
+    // fail on startup if the magic file cannot be loaded
+    getMagicCookie();
 #endif // HAVE_MAGIC
 }
 
 #ifdef HAVE_MAGIC
 Mime::~Mime()
 {
-    if (magicCookie) {
+    for (auto&& [thread, cookie] : magicCookies)
+        magic_close(cookie);
+}
+
+magic_t Mime::getMagicCookie()
+{
+    std::lock_guard<std::mutex> lock(magicMutex);
+    auto entry = magicCookies.find(std::this_thread::get_id());
+    if (entry != magicCookies.end())
+        return entry->second;
+
+    auto magicCookie = magic_open(magicFlags);
+    if (magicCookie == nullptr) {
+        throw_std_runtime_error("magic_open failed");
+    }
+
+    if (magic_load(magicCookie, !magicFile.empty() ? magicFile.c_str() : nullptr) == -1) {
+        std::string errMsg = magic_error(magicCookie);
         magic_close(magicCookie);
-        magicCookie = nullptr;
+        throw_std_runtime_error("magic_load failed: {}", errMsg);
     }
+    magicCookies[std::this_thread::get_id()] = magicCookie;
+    return magicCookie;
 }
-#else
-Mime::~Mime() = default;
-#endif
 
-#ifdef HAVE_MAGIC
 std::string Mime::fileToMimeType(const fs::path& path, const std::string& defval)
 {
-    const char* mimeType = magic_file(magicCookie, path.c_str());
+    const char* mimeType = magic_file(getMagicCookie(), path.c_str());
     if (!mimeType || mimeType[0] == '\0') {
         return defval;
     }
@@ -85,11 +97,112 @@ std::string Mime::fileToMimeType(const fs::path& path, const std::string& defval
 
 std::string Mime::bufferToMimeType(const void* buffer, size_t length)
 {
-    const char* mimeType = magic_buffer(magicCookie, buffer, length);
-    return mimeType;
+    auto mimeType = sniffMimeType(static_cast<const char*>(buffer), length);
+    if (!mimeType.empty())
+        return mimeType;
+
+    const char* magicType = magic_buffer(getMagicCookie(), buffer, length);
+    return magicType ? magicType : "";
 }
+#else
+Mime::~Mime() = default;
 #endif
 
+std::string Mime::extensionToMimeType(const std::string& extension)
+{
+    // formats that are not mistaken for each other, everything else is left to the signature
+    static const std::unordered_map<std::string, std::string> mediaExtensions {
+        { "aif", "audio/x-aiff" },
+        { "aiff", "audio/x-aiff" },
+        { "avi", "video/x-msvideo" },
+        { "bmp", "image/bmp" },
+        { "flac", "audio/flac" },
+        { "gif", "image/gif" },
+        { "jpeg", "image/jpeg" },
+        { "jpg", "image/jpeg" },
+        { "m4a", "audio/mp4" },
+        { "m4v", "video/mp4" },
+        { "mov", "video/quicktime" },
+        { "mp4", "video/mp4" },
+        { "mpeg", "video/mpeg" },
+        { "mpg", "video/mpeg" },
+        { "png", "image/png" },
+        { "tif", "image/tiff" },
+        { "tiff", "image/tiff" },
+        { "wav", "audio/x-wav" },
+        { "webm", "video/webm" },
+        { "webp", "image/webp" },
+    };
+    auto entry = mediaExtensions.find(extension);
+    return entry != mediaExtensions.end() ? entry->second : "";
+}
+
+std::string Mime::sniffMimeType(const char* data, std::size_t length)
+{
+    auto has = [=](std::size_t offset, std::string_view signature) {
+        return length >= offset + signature.size() && std::string_view(data + offset, signature.size()) == signature;
+    };
+
+    if (has(0, "\xFF\xD8\xFF"))
+        return "image/jpeg";
+    if (has(0, "\x89PNG\r\n\x1A\n"))
+        return "image/png";
+    if (has(0, "GIF87a") || has(0, "GIF89a"))
+        return "image/gif";
+    if (has(0, std::string_view("II*\0", 4)) || has(0, std::string_view("MM\0*", 4)))
+        return "image/tiff";
+    if (has(0, "ID3"))
+        return "audio/mpeg";
+    if (has(0, "fLaC"))
+        return "audio/flac";
+    if (has(0, "OggS"))
+        return "application/ogg";
+    if (has(0, "wvpk"))
+        return "audio/x-wavpack";
+    if (has(0, "RIFF")) {
+        if (has(8, "WAVE"))
+            return "audio/x-wav";
+        if (has(8, "AVI "))
+            return "video/x-msvideo";
+        if (has(8, "WEBP"))
+            return "image/webp";
+    }
+    if (has(0, "FORM") && (has(8, "AIFF") || has(8, "AIFC")))
+        return "audio/x-aiff";
+    if (has(4, "ftyp")) {
+        if (has(8, "M4A ") || has(8, "M4B "))
+            return "audio/mp4";
+        if (has(8, "qt  "))
+            return "video/quicktime";
+        if (has(8, "heic") || has(8, "avif"))
+            return ""; // still images in the same container
+        return "video/mp4";
+    }
+    if (has(0, "\x1A\x45\xDF\xA3")) {
+        // the doctype follows in the EBML header
+        auto header = std::string_view(data, std::min<std::size_t>(length, 64));
+        return header.find("webm") != std::string_view::npos ? "video/webm" : "video/x-matroska";
+    }
+    if (has(0, "\x30\x26\xB2\x75\x8E\x66\xCF\x11"))
+        return "video/x-ms-asf";
+    if (has(0, std::string_view("\0\0\1\xBA", 4)))
+        return "video/mpeg";
+    if (length >= SIGNATURE_SIZE && data[0] == 0x47 && data[188] == 0x47 && data[376] == 0x47)
+        return "video/mp2t";
+    return "";
+}
+
+std::string Mime::fileSignatureToMimeType(const fs::path& path)
+{
+    char buffer[SIGNATURE_SIZE];
+    auto file = ::fopen(path.c_str(), "rb");
+    if (!file)
+        return "";
+    auto bytes = ::fread(buffer, 1, sizeof(buffer), file);
+    ::fclose(file);
+    return sniffMimeType(buffer, bytes);
+}
+
 std::string Mime::getMimeType(const fs::path& path, const std::string& defval)
 {
     std::string extension = path.extension();
@@ -99,7 +212,14 @@ std::string Mime::getMimeType(const fs::path& path, const std::string& defval)
     if (!extension_map_case_sensitive)
         extension = toLower(extension);
 
-    std::string mimeType = getValueOrDefault(extension_mimetype_map, extension, "");
+    auto entry = extension_mimetype_map.find(extension);
+    std::string mimeType = entry != extension_mimetype_map.end() ? entry->second : "";
+    if (mimeType.empty() && !ignore_unknown_extensions) {
+        // the configured mappings win, libmagic only reads the files nothing else knows
+        mimeType = extensionToMimeType(extension_map_case_sensitive ? toLower(extension) : extension);
+        if (mimeType.empty())
+            mimeType = fileSignatureToMimeType(path);
+    }
     if (mimeType.empty() && !ignore_unknown_extensions) {
 #ifdef HAVE_MAGIC
         auto fileMime = fileToMimeType(path, defval);
@@ -29,7 +29,10 @@
 #include <filesystem>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 namespace fs = std::filesystem;
 
 #ifdef HAVE_MAGIC
@@ -55,15 +58,31 @@ public:
     std::string mimeTypeToUpnpClass(const std::string& mimeType);
     std::string getMimeType(const fs::path& path, const std::string& defval = "");
 
+    /// \brief mimetype of the common media formats by their signature, empty if unknown
+    static std::string sniffMimeType(const char* data, std::size_t length);
+
+    /// \brief mimetype of the common media file extensions (lower case), empty if unknown
+    static std::string extensionToMimeType(const std::string& extension);
+
 private:
     bool extension_map_case_sensitive;
     bool ignore_unknown_extensions;
 
-    std::map<std::string, std::string> extension_mimetype_map;
+    std::unordered_map<std::string, std::string> extension_mimetype_map;
     std::map<std::string, std::string> mimetype_upnpclass_map;
 
+    /// \brief read the start of the file and sniff it
+    static std::string fileSignatureToMimeType(const fs::path& path);
+
 #ifdef HAVE_MAGIC
-    magic_t magicCookie;
+    int magicFlags;
+    std::string magicFile;
+    /// \brief magic_t is not thread safe, each import thread gets its own cookie
+    std::map<std::thread::id, magic_t> magicCookies;
+    std::mutex magicMutex;
+
+    /// \brief the cookie of the calling thread, opened on first use
+    magic_t getMagicCookie();
 
     /// \brief Extracts mimetype from a file using filemagic
     std::string fileToMimeType(const fs::path& path, const std::string& defval = "");
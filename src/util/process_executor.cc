@@ -31,14 +31,22 @@
 
 #include "process_executor.h" // API
 
+#include <algorithm>
+#include <cerrno>
 #include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
 #include <unistd.h>
 
 #include "exceptions.h"
 #include "logger.h"
 #include "process.h"
 
-ProcessExecutor::ProcessExecutor(const std::string& command, const std::vector<std::string>& arglist)
+extern char** environ;
+
+ProcessExecutor::ProcessExecutor(const std::string& command, const std::vector<std::string>& arglist, int outputFd, int niceness, int errorFd)
 {
 #define MAX_ARGS 255
     const char* argv[MAX_ARGS];
@@ -55,20 +63,51 @@ ProcessExecutor::ProcessExecutor(const std::string& command, const std::vector<s
 
     exit_status = 0;
 
-    process_id = fork();
-
-    switch (process_id) {
-    case -1:
-        throw_std_runtime_error("Failed to launch process {}", command.c_str());
+    // posix_spawn does not copy the page tables of the server like fork does,
+    // which takes a while with a large database cache
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (errorFd >= 0)
+        posix_spawn_file_actions_adddup2(&actions, errorFd, STDERR_FILENO);
+    int spareFd = -1;
+    if (outputFd >= 0) {
+        // dup2 does not pass on O_CLOEXEC, unless there is nothing to dup
+        if (outputFd == OUTPUT_FD) {
+            spareFd = fcntl(outputFd, F_DUPFD_CLOEXEC, OUTPUT_FD + 1);
+            if (spareFd < 0) {
+                posix_spawn_file_actions_destroy(&actions);
+                throw_std_runtime_error("Failed to launch process {}: {}", command.c_str(), std::strerror(errno));
+            }
+            outputFd = spareFd;
+        }
+        posix_spawn_file_actions_adddup2(&actions, outputFd, OUTPUT_FD);
+    }
 
-    case 0:
-        sigset_t mask_set;
-        pthread_sigmask(SIG_SETMASK, &mask_set, nullptr);
-        log_debug("Launching process: {}", command.c_str());
-        execvp(command.c_str(), const_cast<char**>(argv));
-        break;
-    default:
-        break;
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attr, &signals);
+    // the server ignores SIGPIPE, the child must not inherit that
+    sigaddset(&signals, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &signals);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    log_debug("Launching process: {}", command.c_str());
+    int err = posix_spawnp(&process_id, command.c_str(), &actions, &attr, const_cast<char**>(argv), environ);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    if (spareFd >= 0)
+        close(spareFd);
+    if (err != 0)
+        throw_std_runtime_error("Failed to launch process {}: {}", command.c_str(), std::strerror(err));
+
+    if (niceness > 0) {
+        // the child has no own threads yet, so lowering the priority of the process is enough
+        errno = 0;
+        int priority = getpriority(PRIO_PROCESS, 0);
+        if (errno == 0 && setpriority(PRIO_PROCESS, process_id, std::min(priority + niceness, 19)) != 0)
+            log_debug("Failed to lower the priority of {}: {}", command.c_str(), std::strerror(errno));
     }
 
     log_debug("Launched process {}, pid: {}", command.c_str(), process_id);
@@ -81,9 +120,19 @@ bool ProcessExecutor::isAlive()
 
 bool ProcessExecutor::kill()
 {
+    // a stopped process does not see the termination signals
+    setPaused(false);
     return kill_proc(process_id);
 }
 
+void ProcessExecutor::setPaused(bool paused)
+{
+    if (paused == this->paused)
+        return;
+    if (::kill(process_id, paused ? SIGSTOP : SIGCONT) == 0)
+        this->paused = paused;
+}
+
 int ProcessExecutor::getStatus()
 {
     is_alive(process_id, &exit_status);
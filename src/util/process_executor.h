@@ -41,16 +41,27 @@
 
 class ProcessExecutor : public Executor {
 public:
+    /// \brief descriptor of the output pipe in the child, it opens /dev/fd/3 to write to it
+    static constexpr int OUTPUT_FD = 3;
+
+    /// \param outputFd becomes OUTPUT_FD of the child if set
+    /// \param niceness added to the scheduling priority of the child
+    /// \param errorFd becomes stderr of the child if set
     ProcessExecutor(const std::string& command,
-        const std::vector<std::string>& arglist);
+        const std::vector<std::string>& arglist, int outputFd = -1, int niceness = 0, int errorFd = -1);
     bool isAlive() override;
     bool kill() override;
     int getStatus() override;
     ~ProcessExecutor() override;
 
+    /// \brief stop or continue the process, a stopped process is continued before it is killed
+    void setPaused(bool paused);
+    bool isPaused() const { return paused; }
+
 protected:
     pid_t process_id;
     int exit_status;
+    bool paused { false };
 };
 
 #endif // __PROCESS_EXECUTOR_H__
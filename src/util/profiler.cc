@@ -0,0 +1,235 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    profiler.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file profiler.cc
+
+#include "profiler.h" // API
+
+#include <csignal>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef HAVE_GPERFTOOLS
+#include <gperftools/profiler.h>
+#else
+#include <execinfo.h>
+#endif
+#ifdef HAVE_TCMALLOC
+#include <gperftools/heap-profiler.h>
+#endif
+
+#include "config/config.h"
+#include "util/tools.h"
+
+/// \brief interval of the SIGPROF samples in microseconds
+#define PROFILER_SAMPLE_INTERVAL 10000
+/// \brief samples kept per profile, about five minutes at the sample interval
+#define PROFILER_MAX_SAMPLES 30000
+
+Profiler::Profiler(const std::shared_ptr<Config>& config, std::shared_ptr<Timer> timer)
+    : enabled(config->getBoolOption(CFG_SERVER_PROFILING_ENABLED))
+    , directory(config->getOption(CFG_SERVER_PROFILING_DIRECTORY))
+    , duration(config->getIntOption(CFG_SERVER_PROFILING_DURATION))
+    , timer(std::move(timer))
+{
+    if (directory.empty())
+        directory = config->getOption(CFG_SERVER_HOME);
+}
+
+Profiler::~Profiler()
+{
+    stop();
+}
+
+bool Profiler::isRunning()
+{
+    AutoLock lock(mutex);
+    return running;
+}
+
+fs::path Profiler::start(unsigned int seconds)
+{
+    if (!enabled)
+        throw_std_runtime_error("Profiling is not enabled in configuration");
+
+    AutoLock lock(mutex);
+    if (running)
+        throw_std_runtime_error("Profile {} is still running", cpuFile.c_str());
+
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec)
+        throw_std_runtime_error("Could not create {}: {}", directory.c_str(), ec.message());
+
+    auto name = fmt::format("gerbera-{}-{}", getpid(), std::time(nullptr));
+    cpuFile = directory / (name + ".cpu.pprof");
+    heapPrefix = directory / name;
+    if (seconds == 0)
+        seconds = duration;
+
+#ifdef HAVE_GPERFTOOLS
+    if (!ProfilerStart(cpuFile.c_str()))
+        throw_std_runtime_error("Could not start the profiler writing {}", cpuFile.c_str());
+#else
+    startSampler();
+#endif
+#ifdef HAVE_TCMALLOC
+    HeapProfilerStart(heapPrefix.c_str());
+#else
+    log_warning("Heap profiles need tcmalloc, only the CPU is profiled");
+#endif
+
+    running = true;
+    timer->addTimerSubscriber(this, seconds, nullptr, true);
+    log_info("Profiling for {} s into {}", seconds, cpuFile.c_str());
+    return cpuFile;
+}
+
+void Profiler::timerNotify(std::shared_ptr<Timer::Parameter> parameter)
+{
+    stop();
+}
+
+void Profiler::stop()
+{
+    AutoLock lock(mutex);
+    if (!running)
+        return;
+    running = false;
+    timer->removeTimerSubscriber(this, nullptr, true);
+
+#ifdef HAVE_GPERFTOOLS
+    ProfilerStop();
+#else
+    writeSamples();
+#endif
+#ifdef HAVE_TCMALLOC
+    HeapProfilerDump("profile end");
+    HeapProfilerStop();
+    log_info("Heap profile written to {}.*.heap", heapPrefix.c_str());
+#endif
+    log_info("CPU profile written to {}", cpuFile.c_str());
+}
+
+#ifndef HAVE_GPERFTOOLS
+std::atomic<std::vector<Profiler::Sample>*> Profiler::samples { nullptr };
+std::atomic<std::size_t> Profiler::sampleCount { 0 };
+std::atomic<int> Profiler::handlersRunning { 0 };
+
+void Profiler::onSignal(int signum)
+{
+    auto errnoSaved = errno;
+    // counted before samples is read, so writeSamples waits for this handler once it saw the buffer
+    handlersRunning++;
+    auto all = samples.load();
+    if (all != nullptr) {
+        auto slot = sampleCount.fetch_add(1, std::memory_order_relaxed);
+        if (slot < all->size()) {
+            // nothing may throw in a signal handler, the slot is checked already
+            auto&& sample = (*all)[slot];
+            sample.depth = backtrace(sample.stack, std::size(sample.stack));
+            sample.stored.store(true, std::memory_order_release);
+        }
+    }
+    handlersRunning--;
+    errno = errnoSaved;
+}
+
+void Profiler::startSampler()
+{
+    // the first call loads libgcc, which must not happen in the signal handler
+    void* warmUp[1];
+    backtrace(warmUp, 1);
+
+    // the buffer of the previous profile, no handler uses it any more
+    static auto buffer = new std::vector<Sample>(PROFILER_MAX_SAMPLES);
+    for (auto&& sample : *buffer) {
+        sample.stored = false;
+        sample.depth = 0;
+    }
+    sampleCount = 0;
+    samples = buffer;
+
+    struct sigaction action = {};
+    action.sa_handler = onSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+
+    struct itimerval interval = {};
+    interval.it_interval.tv_usec = PROFILER_SAMPLE_INTERVAL;
+    interval.it_value.tv_usec = PROFILER_SAMPLE_INTERVAL;
+    setitimer(ITIMER_PROF, &interval, nullptr);
+}
+
+void Profiler::writeSamples()
+{
+    struct itimerval off = {};
+    setitimer(ITIMER_PROF, &off, nullptr);
+    // a signal already raised runs with the default action otherwise, which ends the process
+    signal(SIGPROF, SIG_IGN);
+
+    // no handler that starts now touches the buffer, wait for those that already see it
+    auto all = samples.exchange(nullptr);
+    while (handlersRunning > 0)
+        std::this_thread::yield();
+
+    // the legacy format counts each distinct stack once, the signal handler and the signal trampoline are the first frames
+    std::map<std::vector<std::uintptr_t>, std::uintptr_t> stacks;
+    std::size_t taken = std::min(sampleCount.load(), all->size());
+    for (std::size_t i = 0; i < taken; i++) {
+        auto&& sample = (*all)[i];
+        if (!sample.stored.load(std::memory_order_acquire) || sample.depth <= 2)
+            continue;
+        std::vector<std::uintptr_t> stack;
+        for (int frame = 2; frame < sample.depth; frame++)
+            stack.push_back(reinterpret_cast<std::uintptr_t>(sample.stack[frame]));
+        stacks[stack]++;
+    }
+    if (sampleCount > all->size())
+        log_warning("Profile full, {} samples dropped", sampleCount - all->size());
+
+    std::ofstream out(cpuFile, std::ios::binary);
+    auto word = [&](std::uintptr_t value) { out.write(reinterpret_cast<const char*>(&value), sizeof(value)); };
+    // header: header count, header words, version, sampling period, padding
+    for (std::uintptr_t value : { 0, 3, 0, PROFILER_SAMPLE_INTERVAL, 0 })
+        word(value);
+    for (auto&& [stack, count] : stacks) {
+        word(count);
+        word(stack.size());
+        for (auto pc : stack)
+            word(pc);
+    }
+    // trailer, then the mappings to resolve the addresses
+    for (std::uintptr_t value : { 0, 1, 0 })
+        word(value);
+    std::ifstream maps("/proc/self/maps");
+    out << maps.rdbuf();
+    if (!out)
+        log_error("Could not write {}", cpuFile.c_str());
+}
+#endif
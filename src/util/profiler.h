@@ -0,0 +1,95 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    profiler.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file profiler.h
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+namespace fs = std::filesystem;
+
+#include "util/timer.h"
+
+class Config;
+
+/// \brief CPU and heap profiles of the running server, started from the web UI or with SIGUSR2
+///
+/// With gperftools the CPU profile is taken by libprofiler and the heap profile by tcmalloc.
+/// Without it the CPU samples are taken with SIGPROF and written in the legacy CPU profile format
+/// of gperftools, so both variants are read by pprof. Heap profiles need tcmalloc.
+class Profiler : public Timer::Subscriber {
+public:
+    Profiler(const std::shared_ptr<Config>& config, std::shared_ptr<Timer> timer);
+    ~Profiler() override;
+
+    bool isEnabled() const { return enabled; }
+    bool isRunning();
+
+    /// \brief sample for seconds, then write the profiles
+    /// \param seconds duration, 0 for the configured one
+    /// \return path of the CPU profile
+    fs::path start(unsigned int seconds = 0);
+    /// \brief end a running profile and write the files
+    void stop();
+
+    void timerNotify(std::shared_ptr<Timer::Parameter> parameter) override;
+
+protected:
+    bool enabled;
+    fs::path directory;
+    unsigned int duration;
+    std::shared_ptr<Timer> timer;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    bool running { false };
+    fs::path cpuFile;
+    fs::path heapPrefix;
+
+#ifndef HAVE_GPERFTOOLS
+    /// \brief stack of one SIGPROF
+    struct Sample {
+        std::atomic<bool> stored { false };
+        int depth { 0 };
+        void* stack[64];
+    };
+
+    /// \brief written by the signal handler, which only reserves a slot with sampleCount
+    ///
+    /// The buffer is allocated by the first profile and reused by the later ones, it is never freed.
+    /// It is only set while sampling, handlersRunning counts the handlers that may still use it.
+    static std::atomic<std::vector<Sample>*> samples;
+    static std::atomic<std::size_t> sampleCount;
+    static std::atomic<int> handlersRunning;
+    static void onSignal(int signum);
+
+    void startSampler();
+    void writeSamples();
+#endif
+};
+
+#endif // __PROFILER_H__
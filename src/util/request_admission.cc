@@ -0,0 +1,73 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    request_admission.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file request_admission.cc
+
+#include "request_admission.h" // API
+
+#include "util/tools.h"
+
+RequestAdmission::RequestAdmission(int workers, int controlReserve, int dataReserve)
+{
+    if (workers <= 0)
+        return;
+    if (controlReserve >= workers || dataReserve >= workers)
+        throw_std_runtime_error("Reserve of {} and {} workers leaves nothing of the {} threads", controlReserve, dataReserve, workers);
+
+    capacity.at(static_cast<std::size_t>(Kind::Control)) = workers - dataReserve;
+    capacity.at(static_cast<std::size_t>(Kind::Data)) = workers - controlReserve;
+}
+
+bool RequestAdmission::acquire(Kind kind)
+{
+    auto index = static_cast<std::size_t>(kind);
+    auto&& count = active.at(index);
+    auto limit = capacity.at(index);
+    auto current = count.load();
+    do {
+        if (limit > 0 && current >= limit)
+            return false;
+    } while (!count.compare_exchange_weak(current, current + 1));
+    return true;
+}
+
+void RequestAdmission::release(Kind kind)
+{
+    active.at(static_cast<std::size_t>(kind))--;
+}
+
+void RequestAdmission::holdStream(const void* stream)
+{
+    AutoLock lock(mutex);
+    streams.insert(stream);
+}
+
+void RequestAdmission::releaseStream(const void* stream)
+{
+    {
+        AutoLock lock(mutex);
+        if (streams.erase(stream) == 0)
+            return;
+    }
+    release(Kind::Data);
+}
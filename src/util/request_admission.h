@@ -0,0 +1,73 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    request_admission.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file request_admission.h
+#ifndef __REQUEST_ADMISSION_H__
+#define __REQUEST_ADMISSION_H__
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
+/// \brief Keeps threads of the libupnp pool free for control requests while files are served and the other way round
+///
+/// Every SOAP action and every file transfer holds a pool thread until it is answered, the transfer
+/// of a transcoded stream until the client stops playing. Data requests may take all workers but
+/// the control reserve, control requests all but the data reserve.
+class RequestAdmission {
+public:
+    enum class Kind {
+        Control,
+        Data,
+    };
+
+    /// \param workers threads of the libupnp pool, 0 admits all requests
+    /// \param controlReserve workers data requests must leave to control requests
+    /// \param dataReserve workers control requests must leave to data requests
+    RequestAdmission(int workers, int controlReserve, int dataReserve);
+
+    /// \brief take a worker for a request of the kind, false if its capacity is used up
+    bool acquire(Kind kind);
+    void release(Kind kind);
+
+    /// \brief the data request returned the stream, its worker is released when the stream is
+    void holdStream(const void* stream);
+    /// \brief release the worker of the stream, if it holds one
+    void releaseStream(const void* stream);
+
+    /// \brief requests of the kind being answered
+    int getActive(Kind kind) const { return active.at(static_cast<std::size_t>(kind)); }
+    /// \brief requests of the kind that can be answered at the same time, 0 is unlimited
+    int getCapacity(Kind kind) const { return capacity.at(static_cast<std::size_t>(kind)); }
+
+protected:
+    std::array<std::atomic_int, 2> active {};
+    std::array<int, 2> capacity {};
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::unordered_set<const void*> streams;
+};
+
+#endif // __REQUEST_ADMISSION_H__
@@ -0,0 +1,140 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    storage_activity.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file storage_activity.cc
+
+#include "storage_activity.h" // API
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include "util/logger.h"
+#include "util/tools.h"
+
+/// \brief undo the octal escapes of spaces, tabs and backslashes in the mount table
+static std::string unescapeMountPoint(const std::string& value)
+{
+    std::string result;
+    for (std::size_t i = 0; i < value.size(); i++) {
+        if (value[i] == '\\' && i + 3 < value.size() && std::all_of(value.begin() + i + 1, value.begin() + i + 4, [](char c) { return c >= '0' && c <= '7'; })) {
+            result += char(std::stoi(value.substr(i + 1, 3), nullptr, 8));
+            i += 3;
+        } else {
+            result += value[i];
+        }
+    }
+    return result;
+}
+
+StorageActivity::StorageActivity(std::chrono::seconds idleTime, fs::path mountInfo, fs::path sysRoot)
+    : idleTime(idleTime)
+    , mountInfo(std::move(mountInfo))
+    , sysRoot(std::move(sysRoot))
+{
+}
+
+void StorageActivity::loadMounts()
+{
+    auto now = Clock::now();
+    if (!mounts.empty() && now - mountsLoaded < idleTime)
+        return;
+    mountsLoaded = now;
+    mounts.clear();
+
+    // 36 35 98:0 /mnt1 /mnt/parent rw,noatime master:1 - ext3 /dev/root rw,errors=continue
+    std::ifstream in(mountInfo);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string id, parent, device, root, point;
+        if (fields >> id >> parent >> device >> root >> point)
+            mounts.push_back({ unescapeMountPoint(point), device });
+    }
+    // a later mount on the same point hides the earlier one
+    std::reverse(mounts.begin(), mounts.end());
+    std::stable_sort(mounts.begin(), mounts.end(), [](const Mount& a, const Mount& b) { return a.point.native().size() > b.point.native().size(); });
+}
+
+std::string StorageActivity::resolveDisk(const std::string& device)
+{
+    auto cached = diskOfDevice.find(device);
+    if (cached != diskOfDevice.end())
+        return cached->second;
+
+    std::error_code ec;
+    auto dir = fs::canonical(sysRoot / "dev" / "block" / device, ec);
+    std::string disk;
+    if (!ec) {
+        // the counters of a partition do not tell whether the disk is spinning
+        if (fs::exists(dir / "partition", ec))
+            dir = dir.parent_path();
+        if (isRegularFile(dir / "stat", ec))
+            disk = dir.string();
+    }
+    log_debug("Device {} is on disk '{}'", device, disk);
+    diskOfDevice[device] = disk;
+    return disk;
+}
+
+std::string StorageActivity::getDisk(const fs::path& path)
+{
+    AutoLock lock(mutex);
+    loadMounts();
+    auto&& location = path.native();
+    for (auto&& mount : mounts) {
+        auto&& point = mount.point.native();
+        if (startswith(location, point) && (location.size() == point.size() || point == "/" || location[point.size()] == '/'))
+            return resolveDisk(mount.device);
+    }
+    return "";
+}
+
+bool StorageActivity::isActive(const std::string& disk)
+{
+    if (disk.empty())
+        return true;
+
+    // reads completed, reads merged, sectors read, time reading, the same for writes, requests in flight, ...
+    std::ifstream in(fs::path(disk) / "stat");
+    std::vector<std::string> fields { std::istream_iterator<std::string>(in), std::istream_iterator<std::string>() };
+    if (fields.size() < 9)
+        return true;
+    auto counters = fields[0] + ' ' + fields[4];
+    bool inFlight = fields[8] != "0";
+
+    AutoLock lock(mutex);
+    auto now = Clock::now();
+    auto&& state = disks[disk];
+    if (state.counters != counters) {
+        // a change since a sample older than the idle time may have been followed by a spin-down
+        if (!state.counters.empty() && now - state.lastSample < idleTime)
+            state.lastChange = now;
+        state.counters = counters;
+    }
+    state.lastSample = now;
+    if (inFlight)
+        state.lastChange = now;
+    return state.lastChange != Clock::time_point() && now - state.lastChange < idleTime;
+}
@@ -0,0 +1,92 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    storage_activity.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file storage_activity.h
+#ifndef __STORAGE_ACTIVITY_H__
+#define __STORAGE_ACTIVITY_H__
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+namespace fs = std::filesystem;
+
+/// \brief Tells whether the disk holding a path is spinning, without touching the disk
+///
+/// The device of a path is taken from the mount table and its disk from sysfs. A disk counts
+/// as active while its read and write counters in /sys/block/<disk>/stat changed within the
+/// idle time or requests are in flight. Paths on devices without such counters, e.g. network
+/// shares or tmpfs, are always active.
+class StorageActivity {
+public:
+    /// \param idleTime time without reads and writes after which a disk may have spun down
+    /// \param mountInfo mount table of the process
+    /// \param sysRoot mount point of sysfs
+    explicit StorageActivity(std::chrono::seconds idleTime, fs::path mountInfo = "/proc/self/mountinfo", fs::path sysRoot = "/sys");
+
+    /// \brief sysfs directory of the disk holding path, empty if it has no counters
+    std::string getDisk(const fs::path& path);
+
+    /// \brief whether the disk is spinning, always true for an empty disk
+    bool isActive(const std::string& disk);
+
+    /// \brief whether the disk holding path is spinning
+    bool isActive(const fs::path& path) { return isActive(getDisk(path)); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Mount {
+        fs::path point;
+        std::string device;
+    };
+
+    struct Disk {
+        std::string counters;
+        /// \brief the counters were not seen changing yet if unset
+        Clock::time_point lastChange;
+        Clock::time_point lastSample;
+    };
+
+    /// \brief read the mount table again if it is older than the idle time
+    void loadMounts();
+    /// \brief sysfs directory of the disk holding the partition or volume major:minor
+    std::string resolveDisk(const std::string& device);
+
+    std::chrono::seconds idleTime;
+    fs::path mountInfo;
+    fs::path sysRoot;
+
+    /// \brief longest mount point first
+    std::vector<Mount> mounts;
+    Clock::time_point mountsLoaded;
+    std::map<std::string, std::string> diskOfDevice;
+    std::map<std::string, Disk> disks;
+    std::mutex mutex;
+
+    using AutoLock = std::lock_guard<std::mutex>;
+};
+
+#endif // __STORAGE_ACTIVITY_H__
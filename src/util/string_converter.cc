@@ -31,27 +31,105 @@
 
 #include "string_converter.h" // API
 
+#include <cstdlib>
+#include <map>
+#include <vector>
+
 #include "config/config_manager.h"
 #include "config/directory_tweak.h"
-#include <cstdlib>
+#include "util/tools.h"
 
-StringConverter::StringConverter(const std::string& from, const std::string& to)
-    : cd(iconv_open(to.c_str(), from.c_str()))
-{
-    dirty = false;
+/// \brief descriptors kept per charset pair and thread
+static constexpr std::size_t ICONV_POOL_SIZE = 4;
 
-    if (!cd) {
-        cd = {};
-        throw_std_runtime_error("iconv: {}", std::strerror(errno));
+/// \brief iconv descriptors of finished converters, converters are created for every file and tag
+///
+/// A descriptor is used by one converter at a time, so each thread keeps its own without locking.
+class IconvPool {
+public:
+    IconvPool() { alive = true; }
+    ~IconvPool()
+    {
+        alive = false;
+        for (auto&& [charsets, descriptors] : pool)
+            for (auto cd : descriptors)
+                iconv_close(cd);
+    }
+
+    iconv_t get(const std::string& from, const std::string& to)
+    {
+        auto entry = pool.find({ from, to });
+        if (entry == pool.end() || entry->second.empty())
+            return nullptr;
+        auto cd = entry->second.back();
+        entry->second.pop_back();
+        return cd;
+    }
+
+    void put(const std::string& from, const std::string& to, iconv_t cd)
+    {
+        auto& descriptors = pool[{ from, to }];
+        if (descriptors.size() >= ICONV_POOL_SIZE) {
+            iconv_close(cd);
+            return;
+        }
+        // back to the initial shift state for the next user
+        iconv(cd, nullptr, nullptr, nullptr, nullptr);
+        descriptors.push_back(cd);
     }
+
+    /// \brief false before the pool of the thread is created and after it is gone
+    static thread_local bool alive;
+
+private:
+    std::map<std::pair<std::string, std::string>, std::vector<iconv_t>> pool;
+};
+
+thread_local bool IconvPool::alive = false;
+
+static thread_local IconvPool iconvPool;
+
+static bool isUTF8Charset(const std::string& charset)
+{
+    auto name = toLower(charset);
+    return name == "utf-8" || name == "utf8";
+}
+
+StringConverter::StringConverter(const std::string& from, const std::string& to)
+    : from(from)
+    , to(to)
+    , cd(nullptr)
+    , dirty(false)
+    , utf8Identity(isUTF8Charset(from) && isUTF8Charset(to))
+{
+    if (!utf8Identity)
+        acquire();
 }
 
 StringConverter::~StringConverter()
 {
-    if (cd)
+    if (!cd)
+        return;
+    // converters can outlive the pool of the thread they are destroyed on
+    if (IconvPool::alive)
+        iconvPool.put(from, to, cd);
+    else
         iconv_close(cd);
 }
 
+void StringConverter::acquire()
+{
+    cd = iconvPool.get(from, to);
+    if (cd)
+        return;
+
+    cd = iconv_open(to.c_str(), from.c_str());
+    if (cd == reinterpret_cast<iconv_t>(-1)) {
+        cd = nullptr;
+        throw_std_runtime_error("iconv: {}", std::strerror(errno));
+    }
+}
+
 std::string StringConverter::convert(std::string str, bool validate)
 {
     size_t stoppedAt = 0;
@@ -60,6 +138,10 @@ std::string StringConverter::convert(std::string str, bool validate)
     if (str.empty())
         return str;
 
+    // nothing to convert, only invalid sequences need iconv
+    if (utf8Identity && isValidUTF8(str))
+        return str;
+
     do {
         ret = ret + _convert(str, validate, &stoppedAt);
         if ((ret.length() > 0) && (stoppedAt == 0))
@@ -79,6 +161,8 @@ std::string StringConverter::convert(std::string str, bool validate)
 
 bool StringConverter::validate(const std::string& str)
 {
+    if (utf8Identity && isValidUTF8(str))
+        return true;
     try {
         _convert(str, true);
         return true;
@@ -92,6 +176,9 @@ std::string StringConverter::_convert(const std::string& str, bool validate,
 {
     std::string ret_str;
 
+    if (!cd)
+        acquire();
+
     auto input = str.c_str();
     auto output = new char[str.length() * 4];
     if (!output) {
@@ -176,7 +263,6 @@ std::string StringConverter::_convert(const std::string& str, bool validate,
     return ret_str;
 }
 
-/// \todo iconv caching
 std::unique_ptr<StringConverter> StringConverter::i2f(const std::shared_ptr<Config>& cm)
 {
     auto conv = std::make_unique<StringConverter>(
@@ -216,6 +302,7 @@ std::unique_ptr<StringConverter> StringConverter::j2i(const std::shared_ptr<Conf
         DEFAULT_INTERNAL_CHARSET);
     return conv;
 }
+#endif
 
 std::unique_ptr<StringConverter> StringConverter::p2i(const std::shared_ptr<Config>& cm)
 {
@@ -224,7 +311,6 @@ std::unique_ptr<StringConverter> StringConverter::p2i(const std::shared_ptr<Conf
         DEFAULT_INTERNAL_CHARSET);
     return conv;
 }
-#endif
 
 #if defined(HAVE_JS) || defined(HAVE_TAGLIB) || defined(ATRAILERS) || defined(HAVE_MATROSKA)
 std::unique_ptr<StringConverter> StringConverter::i2i(const std::shared_ptr<Config>& cm)
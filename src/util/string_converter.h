@@ -63,10 +63,10 @@ public:
 #ifdef HAVE_JS
     /// \brief scripting to internal
     static std::unique_ptr<StringConverter> j2i(const std::shared_ptr<Config>& cm);
+#endif
 
     /// \brief playlist to internal
     static std::unique_ptr<StringConverter> p2i(const std::shared_ptr<Config>& cm);
-#endif
 #if defined(HAVE_JS) || defined(HAVE_TAGLIB) || defined(ATRAILERS) || defined(HAVE_MATROSKA)
     /// \brief safeguard - internal to internal - needed to catch some
     /// scenarious where the user may have forgotten to add proper conversion
@@ -75,9 +75,19 @@ public:
 #endif
 
 protected:
+    std::string from;
+    std::string to;
+
+    /// \brief opened on first use if both sides are UTF-8, nullptr until then
     iconv_t cd;
     bool dirty;
 
+    /// \brief source and target are UTF-8, valid input is returned as it is
+    bool utf8Identity;
+
+    /// \brief take a descriptor for from and to of this thread or open a new one
+    void acquire();
+
     std::string _convert(const std::string& str, bool validate,
         size_t* stoppedAt = nullptr);
 };
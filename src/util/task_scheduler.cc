@@ -0,0 +1,254 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    task_scheduler.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file task_scheduler.cc
+
+#include "task_scheduler.h" // API
+
+#include <algorithm>
+
+#include "exceptions.h"
+#include "metrics.h"
+
+TaskScheduler::TaskScheduler(std::shared_ptr<Config> config, std::size_t workerCount, std::function<void()> threadCleanup)
+    : config(std::move(config))
+    , workerCount(std::max<std::size_t>(workerCount, 1))
+    , threadCleanup(std::move(threadCleanup))
+    , runningTasks(Metrics::getInstance().gauge("gerbera_tasks_running", "Tasks being run by the task threads"))
+{
+    static constexpr std::array<const char*, 3> priorities { "interactive", "normal", "background" };
+    for (std::size_t i = 0; i < queuedTasks.size(); i++)
+        queuedTasks.at(i) = &Metrics::getInstance().gauge("gerbera_tasks_queued", "Tasks waiting for a task thread", Metrics::label("priority", priorities.at(i)));
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    if (!workers.empty())
+        shutdown();
+}
+
+void TaskScheduler::run()
+{
+    AutoLock lock(mutex);
+    for (std::size_t i = 0; i < workerCount; i++) {
+        auto worker = std::make_unique<Worker>();
+        worker->scheduler = this;
+        worker->index = i;
+        worker->thread = std::make_unique<StdThreadRunner>(fmt::format("TaskThread{}", i), TaskScheduler::staticThreadProc, worker.get(), config);
+        if (!worker->thread->isAlive())
+            throw_std_runtime_error("Could not start task thread");
+        workers.push_back(std::move(worker));
+    }
+    log_debug("started {} task threads", workers.size());
+}
+
+void TaskScheduler::shutdown()
+{
+    log_debug("Shutting down TaskScheduler");
+    {
+        AutoLock lock(mutex);
+        shutdownFlag = true;
+        cond.notify_all();
+    }
+    for (auto&& worker : workers)
+        worker->thread->join();
+    workers.clear();
+    for (std::size_t i = 0; i < queues.size(); i++) {
+        for (auto&& group : queues.at(i))
+            queuedTasks.at(i)->dec(group.tasks.size());
+        queues.at(i).clear();
+    }
+}
+
+void TaskScheduler::addTask(const std::shared_ptr<GenericTask>& task, TaskPriority priority)
+{
+    AutoLock lock(mutex);
+
+    task->setID(taskID++);
+    task->setPriority(priority);
+
+    auto& queue = queues.at(static_cast<std::size_t>(priority));
+    auto group = std::find_if(queue.begin(), queue.end(), [&](auto&& g) { return g.name == task->getGroup(); });
+    if (group == queue.end())
+        group = queue.insert(queue.end(), Group { task->getGroup(), {} });
+    group->tasks.push_back(task);
+    queuedTasks.at(static_cast<std::size_t>(priority))->inc();
+
+    cond.notify_one();
+}
+
+void TaskScheduler::setConcurrency(task_owner_t owner, std::size_t count)
+{
+    AutoLock lock(mutex);
+    concurrency[owner] = std::max<std::size_t>(count, 1);
+}
+
+bool TaskScheduler::mayRun(const std::shared_ptr<GenericTask>& task) const
+{
+    std::size_t running = 0;
+    for (auto&& worker : workers) {
+        if (worker->task == nullptr || worker->task->getOwner() != task->getOwner())
+            continue;
+        if (worker->task->getGroup() == task->getGroup())
+            return false;
+        running++;
+    }
+    auto limit = concurrency.find(task->getOwner());
+    return running < (limit != concurrency.end() ? limit->second : 1);
+}
+
+std::shared_ptr<GenericTask> TaskScheduler::nextTask()
+{
+    for (std::size_t i = 0; i < queues.size(); i++) {
+        auto& queue = queues.at(i);
+        for (auto group = queue.begin(); group != queue.end();) {
+            auto& tasks = group->tasks;
+            while (!tasks.empty() && !tasks.front()->isValid()) {
+                tasks.pop_front();
+                queuedTasks.at(i)->dec();
+            }
+            if (tasks.empty()) {
+                group = queue.erase(group);
+                continue;
+            }
+
+            auto task = tasks.front();
+            if (!mayRun(task)) {
+                ++group;
+                continue;
+            }
+
+            tasks.pop_front();
+            queuedTasks.at(i)->dec();
+            // the next pick at this priority starts with the following group
+            if (tasks.empty())
+                queue.erase(group);
+            else
+                queue.splice(queue.end(), queue, group);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void* TaskScheduler::staticThreadProc(void* arg)
+{
+    auto worker = static_cast<Worker*>(arg);
+    worker->scheduler->threadProc(worker);
+    return nullptr;
+}
+
+void TaskScheduler::threadProc(Worker* worker)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!shutdownFlag) {
+        auto task = nextTask();
+        if (task == nullptr) {
+            /* if nothing to do, sleep until awakened */
+            cond.wait(lock);
+            continue;
+        }
+
+        worker->task = task;
+        lock.unlock();
+        runningTasks.inc();
+
+        try {
+            if (task->isValid()) {
+                task->start();
+                task->run();
+            }
+        } catch (const ServerShutdownException& se) {
+            lock.lock();
+            shutdownFlag = true;
+            cond.notify_all();
+            lock.unlock();
+        } catch (const std::runtime_error& e) {
+            log_error("Exception caught: {}", e.what());
+        }
+
+        runningTasks.dec();
+        lock.lock();
+        worker->task = nullptr;
+        // tasks of the same owner may have been waiting for this one
+        cond.notify_all();
+    }
+    lock.unlock();
+
+    if (threadCleanup)
+        threadCleanup();
+}
+
+std::vector<std::shared_ptr<GenericTask>> TaskScheduler::getWorkerTasks()
+{
+    AutoLock lock(mutex);
+    std::vector<std::shared_ptr<GenericTask>> result;
+    result.reserve(workers.size());
+    std::transform(workers.begin(), workers.end(), std::back_inserter(result), [](auto&& worker) { return worker->task; });
+    return result;
+}
+
+std::deque<std::shared_ptr<GenericTask>> TaskScheduler::getTasklist()
+{
+    AutoLock lock(mutex);
+    std::deque<std::shared_ptr<GenericTask>> taskList;
+    for (auto&& worker : workers) {
+        if (worker->task != nullptr)
+            taskList.push_back(worker->task);
+    }
+    for (auto&& queue : queues) {
+        for (auto&& group : queue)
+            std::copy_if(group.tasks.begin(), group.tasks.end(), std::back_inserter(taskList), [](auto&& task) { return task->isValid(); });
+    }
+    return taskList;
+}
+
+void TaskScheduler::forEachTask(const std::function<void(const std::shared_ptr<GenericTask>&)>& fn)
+{
+    AutoLock lock(mutex);
+    for (auto&& worker : workers) {
+        if (worker->task != nullptr)
+            fn(worker->task);
+    }
+    for (auto&& queue : queues) {
+        for (auto&& group : queue) {
+            for (auto&& task : group.tasks)
+                fn(task);
+        }
+    }
+}
+
+void TaskScheduler::invalidateTask(unsigned int taskID)
+{
+    forEachTask([=](auto&& task) {
+        if ((task->getID() == taskID) || (task->getParentID() == taskID))
+            task->invalidate();
+    });
+}
+
+bool TaskScheduler::isBusy()
+{
+    AutoLock lock(mutex);
+    return std::any_of(workers.begin(), workers.end(), [](auto&& worker) { return worker->task != nullptr; })
+        || std::any_of(queues.begin(), queues.end(), [](auto&& queue) { return !queue.empty(); });
+}
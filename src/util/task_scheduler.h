@@ -0,0 +1,120 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    task_scheduler.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file task_scheduler.h
+#ifndef __TASK_SCHEDULER_H__
+#define __TASK_SCHEDULER_H__
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "generic_task.h"
+#include "metrics.h"
+#include "thread_runner.h"
+
+// forward declaration
+class Config;
+
+/// \brief Runs the tasks of the content manager and the online services on a set of worker threads
+///
+/// Tasks are picked by priority first. Within one priority the groups of the queued tasks take turns,
+/// so a large rescan of one autoscan directory does not hold back the changes of another one.
+/// Tasks of the same owner run one at a time unless the owner allows more, tasks of the same group never run at the same time.
+class TaskScheduler {
+public:
+    /// \param threadCleanup called by each worker before it terminates
+    TaskScheduler(std::shared_ptr<Config> config, std::size_t workerCount, std::function<void()> threadCleanup = nullptr);
+    ~TaskScheduler();
+
+    void run();
+    void shutdown();
+
+    /// \brief let up to count tasks of owner run at the same time, each of a different group
+    void setConcurrency(task_owner_t owner, std::size_t count);
+
+    /// \brief queue a task and assign its id
+    void addTask(const std::shared_ptr<GenericTask>& task, TaskPriority priority);
+
+    /// \brief task of each worker, nullptr if the worker is idle
+    std::vector<std::shared_ptr<GenericTask>> getWorkerTasks();
+
+    /// \brief running tasks followed by the valid queued tasks
+    std::deque<std::shared_ptr<GenericTask>> getTasklist();
+
+    /// \brief invalidate the task with the id and all its subtasks
+    void invalidateTask(unsigned int taskID);
+
+    /// \brief call fn for the running and queued tasks while no task can be picked
+    void forEachTask(const std::function<void(const std::shared_ptr<GenericTask>&)>& fn);
+
+    bool isBusy();
+
+protected:
+    struct Worker {
+        TaskScheduler* scheduler;
+        std::size_t index;
+        std::shared_ptr<GenericTask> task;
+        std::unique_ptr<StdThreadRunner> thread;
+    };
+
+    struct Group {
+        std::string name;
+        std::deque<std::shared_ptr<GenericTask>> tasks;
+    };
+
+    std::shared_ptr<Config> config;
+    std::size_t workerCount;
+    std::function<void()> threadCleanup;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::condition_variable cond;
+
+    bool shutdownFlag { false };
+    unsigned int taskID { 1 };
+    std::vector<std::unique_ptr<Worker>> workers;
+    /// \brief groups with queued tasks for each priority, the front group is next
+    std::array<std::list<Group>, 3> queues;
+    /// \brief tasks of an owner that may run at the same time, 1 if not set
+    std::map<task_owner_t, std::size_t> concurrency;
+
+    Metrics::Gauge& runningTasks;
+    /// \brief queued tasks of each priority, invalid tasks count until they are dropped
+    std::array<Metrics::Gauge*, 3> queuedTasks {};
+
+    /// \brief take the next task that may run now, drops invalid tasks
+    std::shared_ptr<GenericTask> nextTask();
+    bool mayRun(const std::shared_ptr<GenericTask>& task) const;
+
+    static void* staticThreadProc(void* arg);
+    void threadProc(Worker* worker);
+};
+
+#endif // __TASK_SCHEDULER_H__
@@ -33,8 +33,15 @@
 
 #include <cassert>
 
+/// \brief upper bound of the delay added to the first notification
+static constexpr auto MAX_SPREAD = std::chrono::minutes(5);
+
+/// \brief threads running the notifications, a backup must not hold up session expiry
+static constexpr std::size_t NOTIFY_THREADS = 2;
+
 Timer::Timer(std::shared_ptr<Config> config)
     : shutdownFlag(false)
+    , random(std::random_device {}())
     , config(std::move(config))
 {
 }
@@ -46,6 +53,13 @@ void Timer::run()
 
     if (!threadRunner->isAlive())
         throw_std_runtime_error("Failed to start timer thread");
+
+    for (std::size_t i = 0; i < NOTIFY_THREADS; i++) {
+        auto thread = std::make_unique<StdThreadRunner>(fmt::format("TimerNotify{}", i), Timer::staticNotifyThreadProc, this, config);
+        if (!thread->isAlive())
+            throw_std_runtime_error("Failed to start timer notify thread");
+        notifyThreads.push_back(std::move(thread));
+    }
 }
 
 void* Timer::staticThreadProc(void* arg)
@@ -62,6 +76,67 @@ void Timer::threadProc()
     triggerWait();
 }
 
+void* Timer::staticNotifyThreadProc(void* arg)
+{
+    auto inst = static_cast<Timer*>(arg);
+    inst->notifyThreadProc();
+    return nullptr;
+}
+
+void Timer::notifyThreadProc()
+{
+    std::unique_lock<std::mutex> lock(notifyMutex);
+    while (!shutdownFlag) {
+        // skip subscribers that are busy on the other thread
+        auto next = std::find_if(pending.begin(), pending.end(), [this](const auto& element) {
+            return std::find(running.begin(), running.end(), element.getSubscriber()) == running.end();
+        });
+        if (next == pending.end()) {
+            notifyCond.wait(lock);
+            continue;
+        }
+
+        auto element = *next;
+        pending.erase(next);
+        running.push_back(element.getSubscriber());
+
+        lock.unlock();
+        element.notify();
+        lock.lock();
+
+        running.erase(std::find(running.begin(), running.end(), element.getSubscriber()));
+        notifyCond.notify_all();
+    }
+}
+
+void Timer::enqueue(const std::vector<TimerSubscriberElement>& elements)
+{
+    if (elements.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(notifyMutex);
+    for (auto&& element : elements) {
+        if (std::find(pending.begin(), pending.end(), element) == pending.end())
+            pending.push_back(element);
+        else
+            log_debug("Previous notification is still queued");
+    }
+    notifyCond.notify_all();
+}
+
+Timer::Clock::duration Timer::getSpread(const TimerSubscriberElement& element)
+{
+    // session and backup timers have no parameter and keep their exact interval
+    if (element.getParameter() == nullptr)
+        return Clock::duration::zero();
+
+    auto maxSpread = std::min<Clock::duration>(element.getInterval() / 10, MAX_SPREAD);
+    auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(maxSpread).count();
+    if (millis <= 0)
+        return Clock::duration::zero();
+    return std::chrono::milliseconds(std::uniform_int_distribution<long>(0, millis)(random));
+}
+
 void Timer::addTimerSubscriber(Subscriber* timerSubscriber, unsigned int notifyInterval, std::shared_ptr<Parameter> parameter, bool once)
 {
     log_debug("Adding subscriber... interval: {} once: {} ", notifyInterval, once);
@@ -71,14 +146,12 @@ void Timer::addTimerSubscriber(Subscriber* timerSubscriber, unsigned int notifyI
     auto lock = threadRunner->lockGuard();
     TimerSubscriberElement element(timerSubscriber, notifyInterval, std::move(parameter), once);
 
-    if (!subscribers.empty()) {
-        bool err = std::any_of(subscribers.begin(), subscribers.end(), [&](const auto& subscriber) { return subscriber == element; });
-        if (err) {
-            throw_std_runtime_error("Tried to add same timer twice");
-        }
+    bool err = std::any_of(subscribers.begin(), subscribers.end(), [&](const auto& subscriber) { return subscriber.second == element; });
+    if (err) {
+        throw_std_runtime_error("Tried to add same timer twice");
     }
 
-    subscribers.push_back(element);
+    subscribers.emplace(Clock::now() + element.getInterval() + getSpread(element), element);
     threadRunner->notify();
 }
 
@@ -86,16 +159,28 @@ void Timer::removeTimerSubscriber(Subscriber* timerSubscriber, std::shared_ptr<P
 {
     log_debug("Removing subscriber...");
     auto lock = threadRunner->lockGuard();
-    if (!subscribers.empty()) {
-        TimerSubscriberElement element(timerSubscriber, 0, std::move(parameter));
-        auto it = std::find(subscribers.begin(), subscribers.end(), element);
-        if (it != subscribers.end()) {
-            subscribers.erase(it);
-            threadRunner->notify();
-            log_debug("Removed subscriber...");
-            return;
+    TimerSubscriberElement element(timerSubscriber, 0, std::move(parameter));
+    auto it = std::find_if(subscribers.begin(), subscribers.end(), [&](const auto& subscriber) { return subscriber.second == element; });
+    bool found = it != subscribers.end();
+    if (found) {
+        subscribers.erase(it);
+        threadRunner->notify();
+    }
+
+    {
+        // the subscriber may be freed once it is removed
+        std::lock_guard<std::mutex> notifyLock(notifyMutex);
+        auto queued = std::find(pending.begin(), pending.end(), element);
+        if (queued != pending.end()) {
+            pending.erase(queued);
+            found = true;
         }
     }
+
+    if (found) {
+        log_debug("Removed subscriber...");
+        return;
+    }
     if (!dontFail) {
         throw_std_runtime_error("Tried to remove nonexistent timer");
     }
@@ -114,11 +199,8 @@ void Timer::triggerWait()
             continue;
         }
 
-        struct timespec* timeout = getNextNotifyTime();
-        struct timespec now;
-        getTimespecNow(&now);
-
-        long wait = getDeltaMillis(&now, timeout);
+        // round up so the wait does not end just before the subscriber is due
+        auto wait = std::chrono::ceil<std::chrono::milliseconds>(getNextNotifyTime() - Clock::now()).count();
         if (wait > 0) {
             auto ret = threadRunner->waitFor(lock, wait);
             if (ret != std::cv_status::timeout) {
@@ -138,50 +220,26 @@ void Timer::notify()
     auto lock = threadRunner->uniqueLock();
     assert(lock.owns_lock());
 
-    std::list<TimerSubscriberElement> toNotify;
-
-    if (!subscribers.empty()) {
-        for (auto it = subscribers.begin(); it != subscribers.end(); /*++it*/) {
-            TimerSubscriberElement& element = *it;
-
-            struct timespec now;
-            getTimespecNow(&now);
-            long wait = getDeltaMillis(&now, element.getNextNotify());
-
-            if (wait <= 0) {
-                toNotify.push_back(element);
-                if (element.isOnce()) {
-                    it = subscribers.erase(it);
-                } else {
-                    element.updateNextNotify();
-                    ++it;
-                }
-            } else {
-                ++it;
-            }
-        }
+    std::vector<TimerSubscriberElement> toNotify;
+
+    auto now = Clock::now();
+    while (!subscribers.empty() && subscribers.begin()->first <= now) {
+        auto element = subscribers.begin()->second;
+        subscribers.erase(subscribers.begin());
+        toNotify.push_back(element);
+        if (!element.isOnce())
+            subscribers.emplace(now + element.getInterval(), element);
     }
 
     // Unlock before we notify so that other threads can modify the subscribers
     lock.unlock();
-    for (auto& element : toNotify) {
-        element.notify();
-    }
+    enqueue(toNotify);
 }
 
-struct timespec* Timer::getNextNotifyTime()
+Timer::Clock::time_point Timer::getNextNotifyTime()
 {
     auto lock = threadRunner->lockGuard();
-    struct timespec* nextTime = nullptr;
-    if (!subscribers.empty()) {
-        for (auto& subscriber : subscribers) {
-            struct timespec* nextNotify = subscriber.getNextNotify();
-            if (nextTime == nullptr || getDeltaMillis(nextTime, nextNotify) < 0) {
-                nextTime = nextNotify;
-            }
-        }
-    }
-    return nextTime;
+    return subscribers.empty() ? Clock::time_point::max() : subscribers.begin()->first;
 }
 
 void Timer::shutdown()
@@ -189,4 +247,12 @@ void Timer::shutdown()
     shutdownFlag = true;
     threadRunner->notifyAll();
     threadRunner->join();
+
+    {
+        std::lock_guard<std::mutex> lock(notifyMutex);
+        pending.clear();
+        notifyCond.notify_all();
+    }
+    for (auto&& thread : notifyThreads)
+        thread->join();
 }
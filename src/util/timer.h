@@ -34,8 +34,13 @@
 
 #include <algorithm>
 #include <atomic>
-#include <list>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
 #include <memory>
+#include <random>
+#include <vector>
 
 #include "common.h"
 #include "thread_runner.h"
@@ -48,6 +53,10 @@ public:
     public:
         enum timer_param_t {
             IDAutoscan,
+            IDStorageCheck,
+            IDPlayState,
+            IDDatabaseMaintenance,
+            IDUpdateIDs,
 #ifdef ONLINE_SERVICES
             IDOnlineContent,
 #endif
@@ -82,6 +91,13 @@ public:
 
     /// \brief Add a subscriber
     ///
+    /// Subscribers with a parameter are notified up to a tenth of their interval
+    /// later, so timers with the same interval do not fire at the same time.
+    ///
+    /// Notifications run on a few notify threads, so a slow subscriber does not delay the others.
+    /// The notifications of one subscriber never run at the same time, and a notification that
+    /// is still queued when it is due again is not queued twice.
+    ///
     /// @param timerSubscriber Caller must ensure that before this pointer is
     /// freed the subscriber is removed by calling removeTimerSubscriber() with
     /// the same parameter argument, unless the subscription is for a one-shot
@@ -92,6 +108,8 @@ public:
     void triggerWait();
 
 protected:
+    using Clock = std::chrono::steady_clock;
+
     class TimerSubscriberElement {
     public:
         TimerSubscriberElement(Subscriber* subscriber, unsigned int notifyInterval, std::shared_ptr<Parameter> parameter, bool once = false)
@@ -100,7 +118,6 @@ protected:
             , parameter(std::move(parameter))
             , once(once)
         {
-            updateNextNotify();
         }
         void notify()
         {
@@ -110,11 +127,9 @@ protected:
                 log_error("timer caught exception!\n");
             }
         }
-        void updateNextNotify()
-        {
-            getTimespecAfterMillis(notifyInterval * 1000, &nextNotify);
-        }
-        struct timespec* getNextNotify() { return &nextNotify; }
+        Clock::duration getInterval() const { return std::chrono::seconds(notifyInterval); }
+
+        Subscriber* getSubscriber() const { return subscriber; }
 
         std::shared_ptr<Parameter> getParameter() const { return parameter; }
 
@@ -128,22 +143,39 @@ protected:
         Subscriber* subscriber;
         unsigned int notifyInterval;
         std::shared_ptr<Parameter> parameter;
-        struct timespec nextNotify;
         bool once;
     };
 
     std::mutex waitMutex;
-    std::list<TimerSubscriberElement> subscribers;
+    /// \brief subscribers ordered by their next notification, the first one is due next
+    std::multimap<Clock::time_point, TimerSubscriberElement> subscribers;
     std::atomic_bool shutdownFlag;
 
     void notify();
-    struct timespec* getNextNotifyTime();
+    Clock::time_point getNextNotifyTime();
+
+    /// \brief random delay of the first notification
+    Clock::duration getSpread(const TimerSubscriberElement& element);
+    std::mt19937 random;
+
+    std::mutex notifyMutex;
+    std::condition_variable notifyCond;
+    /// \brief due notifications in order, taken by the notify threads
+    std::deque<TimerSubscriberElement> pending;
+    /// \brief subscribers that are notified right now
+    std::vector<Subscriber*> running;
+
+    /// \brief hand the due elements to the notify threads
+    void enqueue(const std::vector<TimerSubscriberElement>& elements);
 
 private:
     static void* staticThreadProc(void* arg);
     void threadProc();
+    static void* staticNotifyThreadProc(void* arg);
+    void notifyThreadProc();
     std::shared_ptr<Config> config;
     std::unique_ptr<StdThreadRunner> threadRunner;
+    std::vector<std::unique_ptr<StdThreadRunner>> notifyThreads;
 };
 
 #endif // __TIMER_H__
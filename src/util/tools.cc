@@ -32,10 +32,13 @@
 #include "tools.h" // API
 
 #include <arpa/inet.h>
+#include <array>
 #include <cctype>
 #include <cerrno>
 #include <climits>
 #include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
 #include <filesystem>
 #include <fstream>
 #include <iterator>
@@ -234,6 +237,58 @@ bool isRegularFile(const fs::path& path, std::error_code& ec) noexcept
 #endif
 }
 
+std::vector<std::string> listDirectory(const fs::path& path, bool directories, bool hidden, std::error_code& ec)
+{
+    std::vector<std::string> result;
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr) {
+        ec = std::make_error_code(std::errc(errno));
+        return result;
+    }
+    ec.clear();
+
+    int dirFd = dirfd(dir);
+    while (auto entry = readdir(dir)) {
+        std::string_view name = entry->d_name;
+        if (name == "." || name == ".." || (!hidden && name.front() == '.'))
+            continue;
+
+        bool isDirectory = entry->d_type == DT_DIR;
+        bool isFile = entry->d_type == DT_REG;
+        if (entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+            struct stat statbuf;
+            if (fstatat(dirFd, entry->d_name, &statbuf, 0) != 0)
+                continue;
+            isDirectory = S_ISDIR(statbuf.st_mode);
+            isFile = S_ISREG(statbuf.st_mode);
+        }
+        if (directories ? isDirectory : isFile)
+            result.emplace_back(name);
+    }
+    closedir(dir);
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+bool hasDirectoryEntries(const fs::path& path)
+{
+    DIR* dir = opendir(path.c_str());
+    if (dir == nullptr)
+        return false;
+
+    bool result = false;
+    while (auto entry = readdir(dir)) {
+        std::string_view name = entry->d_name;
+        if (name != "." && name != "..") {
+            result = true;
+            break;
+        }
+    }
+    closedir(dir);
+    return result;
+}
+
 off_t getFileSize(const fs::path& path)
 {
     // unfortunately fs::file_size(path) is broken with old libstdc++ on 32bit systems (see #737)
@@ -250,6 +305,44 @@ off_t getFileSize(const fs::path& path)
 #endif
 }
 
+std::vector<ListedEntry> listDirectory(const fs::path& dir, bool followSymlinks)
+{
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        throw_std_runtime_error("{}: {}", std::strerror(errno), dir.c_str());
+    }
+    DIR* dirp = fdopendir(fd);
+    if (dirp == nullptr) {
+        int err = errno;
+        close(fd);
+        throw_std_runtime_error("{}: {}", std::strerror(err), dir.c_str());
+    }
+
+    // readdir() fetches the names in large getdents() batches, the stat calls only resolve names in this directory
+    std::vector<ListedEntry> result;
+    struct dirent* dent;
+    while ((dent = readdir(dirp)) != nullptr) {
+        const char* name = dent->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+            continue;
+
+        ListedEntry entry;
+        if (fstatat(fd, name, &entry.st, AT_SYMLINK_NOFOLLOW) != 0) {
+            log_debug("{}: {}", std::strerror(errno), (dir / name).c_str());
+            continue;
+        }
+        entry.isSymlink = S_ISLNK(entry.st.st_mode);
+        if (entry.isSymlink && followSymlinks && fstatat(fd, name, &entry.st, 0) != 0) {
+            log_debug("dangling link {}", (dir / name).c_str());
+            continue;
+        }
+        entry.path = dir / name;
+        result.push_back(std::move(entry));
+    }
+    closedir(dirp);
+    return result;
+}
+
 bool isExecutable(const fs::path& path, int* err)
 {
     int ret = access(path.c_str(), R_OK | X_OK);
@@ -293,22 +386,25 @@ std::string httpRedirectTo(const std::string& addr, const std::string& page)
     return fmt::format(R"(<html><head><meta http-equiv="Refresh" content="0;URL={}/{}"></head><body bgcolor="#dddddd"></body></html>)", addr, page);
 }
 
+/// \brief both hex digits of each byte value
+static constexpr auto HEX_PAIRS = [] {
+    std::array<char, 512> pairs {};
+    for (int c = 0; c < 256; c++) {
+        pairs[2 * c] = HEX_CHARS[c >> 4];
+        pairs[2 * c + 1] = HEX_CHARS[c & 0xF];
+    }
+    return pairs;
+}();
+
 std::string hexEncode(const void* data, int len)
 {
-    const unsigned char* chars;
-    int i;
-    unsigned char hi, lo;
-
-    std::ostringstream buf;
-
-    chars = static_cast<unsigned char*>(const_cast<void*>(data));
-    for (i = 0; i < len; i++) {
-        unsigned char c = chars[i];
-        hi = c >> 4;
-        lo = c & 0xF;
-        buf << HEX_CHARS[hi] << HEX_CHARS[lo];
+    auto chars = static_cast<const unsigned char*>(data);
+    std::string buf(len > 0 ? 2 * len : 0, '\0');
+    for (int i = 0; i < len; i++) {
+        buf[2 * i] = HEX_PAIRS[2 * chars[i]];
+        buf[2 * i + 1] = HEX_PAIRS[2 * chars[i] + 1];
     }
-    return buf.str();
+    return buf;
 }
 
 std::string hexDecodeString(const std::string& encoded)
@@ -344,6 +440,97 @@ std::string hexStringMd5(const std::string& str)
 {
     return hexMd5(str.c_str(), str.length());
 }
+
+static inline std::uint64_t rotl64(std::uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline std::uint64_t fmix64(std::uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+std::string hexFastHash(const void* data, std::size_t length)
+{
+    // MurmurHash3_x64_128 by Austin Appleby, public domain, blocks read as little endian
+    static constexpr std::uint64_t c1 = 0x87c37b91114253d5ULL;
+    static constexpr std::uint64_t c2 = 0x4cf5ad432745937fULL;
+    auto bytes = static_cast<const unsigned char*>(data);
+    auto block = [&](std::size_t offset) {
+        std::uint64_t k = 0;
+        for (int i = 7; i >= 0; i--)
+            k = (k << 8) | bytes[offset + i];
+        return k;
+    };
+
+    std::uint64_t h1 = 0;
+    std::uint64_t h2 = 0;
+    std::size_t blocks = length / 16;
+    for (std::size_t i = 0; i < blocks; i++) {
+        auto k1 = block(i * 16);
+        auto k2 = block(i * 16 + 8);
+
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+        h1 = rotl64(h1, 27);
+        h1 += h2;
+        h1 = h1 * 5 + 0x52dce729;
+
+        k2 *= c2;
+        k2 = rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+        h2 = rotl64(h2, 31);
+        h2 += h1;
+        h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    auto tail = bytes + blocks * 16;
+    std::uint64_t k1 = 0;
+    std::uint64_t k2 = 0;
+    auto rest = length & 15;
+    for (std::size_t i = rest; i > 8; i--)
+        k2 = (k2 << 8) | tail[i - 1];
+    if (rest > 8) {
+        k2 *= c2;
+        k2 = rotl64(k2, 33);
+        k2 *= c1;
+        h2 ^= k2;
+    }
+    for (std::size_t i = std::min<std::size_t>(rest, 8); i > 0; i--)
+        k1 = (k1 << 8) | tail[i - 1];
+    if (rest > 0) {
+        k1 *= c1;
+        k1 = rotl64(k1, 31);
+        k1 *= c2;
+        h1 ^= k1;
+    }
+
+    h1 ^= length;
+    h2 ^= length;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+
+    return fmt::format("{:016x}{:016x}", h1, h2);
+}
+
+std::string hexStringFastHash(std::string_view str)
+{
+    return hexFastHash(str.data(), str.length());
+}
+
 std::string generateRandomId()
 {
 #ifdef BSD_NATIVE_UUID
@@ -373,12 +560,28 @@ std::string generateRandomId()
 
 static constexpr const char* HEX_CHARS2 = "0123456789ABCDEF";
 
-std::string urlEscape(const std::string& str)
-{
-    std::ostringstream buf;
-    for (size_t i = 0; i < str.length();) {
-        auto c = str[i];
-        int cplen = 1;
+/// \brief characters urlEscape() keeps as they are
+static constexpr auto URL_SAFE_CHARS = [] {
+    std::array<bool, 256> safe {};
+    for (int c = 0; c < 256; c++)
+        safe[c] = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' || c == '-';
+    return safe;
+}();
+
+/// \brief value of a hex digit, -1 for other characters
+static constexpr auto HEX_VALUES = [] {
+    std::array<signed char, 256> values {};
+    for (int c = 0; c < 256; c++)
+        values[c] = (c >= '0' && c <= '9') ? c - '0' : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+    return values;
+}();
+
+/// \brief append the escaped str to buf
+static void urlEscape(std::string_view str, std::string& buf)
+{
+    for (std::size_t i = 0; i < str.length();) {
+        auto c = static_cast<unsigned char>(str[i]);
+        std::size_t cplen = 1;
         if ((c & 0xf8) == 0xf0)
             cplen = 4;
         else if ((c & 0xf0) == 0xe0)
@@ -388,66 +591,85 @@ std::string urlEscape(const std::string& str)
         if ((i + cplen) > str.length())
             cplen = 1;
 
-        if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' || c == '-') {
-            buf << char(c);
+        if (URL_SAFE_CHARS[c]) {
+            // copy the run of safe characters at once
+            auto run = i + 1;
+            while (run < str.length() && URL_SAFE_CHARS[static_cast<unsigned char>(str[run])])
+                run++;
+            buf.append(str, i, run - i);
+            i = run;
+            continue;
+        }
+        if (cplen > 1) {
+            buf.append(str, i, cplen);
         } else {
-            int hi = c >> 4;
-            int lo = c & 15;
-            if (cplen > 1)
-                buf << str.substr(i, cplen);
-            else
-                buf << '%' << HEX_CHARS2[hi] << HEX_CHARS2[lo];
+            buf.push_back('%');
+            buf.push_back(HEX_CHARS2[c >> 4]);
+            buf.push_back(HEX_CHARS2[c & 15]);
         }
         i += cplen;
     }
-    return buf.str();
 }
 
-std::string urlUnescape(const std::string& str)
+std::string urlEscape(std::string_view str)
 {
-    auto data = const_cast<char*>(str.c_str());
-    int len = str.length();
-    std::ostringstream buf;
-
-    int i = 0;
-    while (i < len) {
-        char c = data[i++];
-        if (c == '%') {
-            if (i + 2 > len)
-                break; // avoid buffer overrun
-            char chi = data[i++];
-            char clo = data[i++];
-            int hi, lo;
-
-            const char* pos;
-
-            pos = std::strchr(HEX_CHARS2, chi);
-            hi = pos ? pos - HEX_CHARS2 : 0;
+    std::string buf;
+    buf.reserve(str.length() + str.length() / 4);
+    urlEscape(str, buf);
+    return buf;
+}
 
-            pos = std::strchr(HEX_CHARS2, clo);
-            lo = pos ? pos - HEX_CHARS2 : 0;
+std::string urlUnescape(std::string_view str)
+{
+    std::string buf;
+    buf.reserve(str.length());
 
-            int ascii = (hi << 4) | lo;
-            buf << char(ascii);
-        } else if (c == '+') {
-            buf << ' ';
-        } else {
-            buf << c;
+    std::size_t i = 0;
+    while (i < str.length()) {
+        // most values have nothing to unescape, copy up to the next special character
+        auto next = str.find_first_of("%+", i);
+        if (next == std::string_view::npos) {
+            buf.append(str, i);
+            break;
+        }
+        buf.append(str, i, next - i);
+        i = next + 1;
+        if (str[next] == '+') {
+            buf.push_back(' ');
+            continue;
         }
+        if (i + 2 > str.length())
+            break; // avoid buffer overrun
+
+        int hi = HEX_VALUES[static_cast<unsigned char>(str[i])];
+        int lo = HEX_VALUES[static_cast<unsigned char>(str[i + 1])];
+        buf.push_back(char(((hi < 0 ? 0 : hi) << 4) | (lo < 0 ? 0 : lo)));
+        i += 2;
     }
-    return buf.str();
+    return buf;
 }
 
-static std::string dictEncode(const std::map<std::string, std::string>& dict, char sep1, char sep2)
+static void dictEncode(const std::map<std::string, std::string>& dict, char sep1, char sep2, std::string& buf)
 {
-    std::ostringstream buf;
+    std::size_t size = 0;
+    for (auto&& [key, value] : dict)
+        size += key.length() + value.length() + 2;
+
+    buf.reserve(buf.length() + size + size / 4);
     for (auto it = dict.begin(); it != dict.end(); it++) {
         if (it != dict.begin())
-            buf << sep1;
-        buf << urlEscape(it->first) << sep2
-            << urlEscape(it->second);
+            buf.push_back(sep1);
+        urlEscape(it->first, buf);
+        buf.push_back(sep2);
+        urlEscape(it->second, buf);
     }
-    return buf.str();
+}
+
+static std::string dictEncode(const std::map<std::string, std::string>& dict, char sep1, char sep2)
+{
+    std::string buf;
+    dictEncode(dict, sep1, sep2, buf);
+    return buf;
 }
 
 std::string dictEncode(const std::map<std::string, std::string>& dict)
@@ -460,43 +682,198 @@ std::string dictEncodeSimple(const std::map<std::string, std::string>& dict)
     return dictEncode(dict, '/', '/');
 }
 
-void dictDecode(const std::string& url, std::map<std::string, std::string>* dict)
+void dictEncodeSimple(const std::map<std::string, std::string>& dict, std::string& buf)
+{
+    dictEncode(dict, '/', '/', buf);
+}
+
+#define COMPACT_DICT_MARKER '\x01'
+#define COMPACT_DICT_ENTRY_SEP '\x02'
+#define COMPACT_DICT_VALUE_SEP '\x03'
+// followed by the character xor 0x40
+#define COMPACT_DICT_ESCAPE '\x04'
+// followed by COMPACT_DICT_WORD_BASE plus the index of the word
+#define COMPACT_DICT_WORD '\x05'
+#define COMPACT_DICT_WORD_BASE 0x21
+
+// stored rows refer to the words by index, new words may only be appended
+static constexpr std::array<std::string_view, 40> compactDictWords { {
+    "protocolInfo",
+    "size",
+    "duration",
+    "bitrate",
+    "sampleFrequency",
+    "nrAudioChannels",
+    "resolution",
+    "colorDepth",
+    "bitsPerSample",
+    "resFile",
+    "type",
+    "fanArtObject",
+    "fanArtResource",
+    "rct",
+    "rh",
+    "url",
+    "prx",
+    "4cc",
+    "prf",
+    "art",
+    "http-get:*:",
+    "audio/",
+    "video/",
+    "image/",
+    "text/",
+    "application/",
+    ":*",
+    "DLNA.ORG_PN=",
+    "DLNA.ORG_OP=",
+    "DLNA.ORG_CI=",
+    "DLNA.ORG_FLAGS=",
+    "00000000000000000000000000",
+    "http://",
+    "https://",
+    "Exif.Image.",
+    "Exif.Photo.",
+    "Xmp.",
+    "TXXX:",
+    "mpeg",
+    "jpeg",
+} };
+
+static bool isCompactDictSpecial(char c)
+{
+    return static_cast<unsigned char>(c) <= static_cast<unsigned char>(COMPACT_DICT_WORD) || c == '|' || c == '~';
+}
+
+static void compactEscape(std::string_view str, std::string& buf)
+{
+    for (std::size_t i = 0; i < str.length();) {
+        if (isCompactDictSpecial(str[i])) {
+            buf.push_back(COMPACT_DICT_ESCAPE);
+            buf.push_back(char(str[i] ^ 0x40));
+            i++;
+            continue;
+        }
+        // the longest word starting here
+        std::size_t word = compactDictWords.size();
+        for (std::size_t w = 0; w < compactDictWords.size(); w++) {
+            auto&& candidate = compactDictWords[w];
+            if (candidate.front() == str[i] && str.substr(i, candidate.length()) == candidate
+                && (word == compactDictWords.size() || candidate.length() > compactDictWords[word].length()))
+                word = w;
+        }
+        if (word < compactDictWords.size()) {
+            buf.push_back(COMPACT_DICT_WORD);
+            buf.push_back(char(COMPACT_DICT_WORD_BASE + word));
+            i += compactDictWords[word].length();
+            continue;
+        }
+        buf.push_back(str[i++]);
+    }
+}
+
+static std::string compactUnescape(std::string_view str)
+{
+    std::string buf;
+    buf.reserve(str.length() * 2);
+    for (std::size_t i = 0; i < str.length(); i++) {
+        char c = str[i];
+        if ((c != COMPACT_DICT_ESCAPE && c != COMPACT_DICT_WORD) || i + 1 >= str.length()) {
+            buf.push_back(c);
+            continue;
+        }
+        char next = str[++i];
+        if (c == COMPACT_DICT_ESCAPE) {
+            buf.push_back(char(next ^ 0x40));
+        } else {
+            std::size_t word = static_cast<unsigned char>(next) - COMPACT_DICT_WORD_BASE;
+            if (word < compactDictWords.size())
+                buf.append(compactDictWords[word]);
+        }
+    }
+    return buf;
+}
+
+std::string dictEncodeCompact(const std::map<std::string, std::string>& dict)
 {
-    auto data = url.c_str();
-    auto dataEnd = data + url.length();
-    while (data < dataEnd) {
-        auto ampPos = reinterpret_cast<const char*>(std::strchr(data, '&'));
-        if (!ampPos) {
-            ampPos = dataEnd;
+    if (dict.empty())
+        return {};
+
+    std::size_t size = 1;
+    for (auto&& [key, value] : dict)
+        size += key.length() + value.length() + 2;
+
+    std::string buf;
+    buf.reserve(size);
+    buf.push_back(COMPACT_DICT_MARKER);
+    for (auto it = dict.begin(); it != dict.end(); it++) {
+        if (it != dict.begin())
+            buf.push_back(COMPACT_DICT_ENTRY_SEP);
+        compactEscape(it->first, buf);
+        buf.push_back(COMPACT_DICT_VALUE_SEP);
+        compactEscape(it->second, buf);
+    }
+    return buf;
+}
+
+static void dictDecodeCompact(std::string_view data, std::map<std::string, std::string>* dict)
+{
+    // neither an escaped character nor a word index is one of the separators
+    std::size_t pos = 1;
+    while (pos < data.length()) {
+        auto entryEnd = data.find(COMPACT_DICT_ENTRY_SEP, pos);
+        if (entryEnd == std::string_view::npos)
+            entryEnd = data.length();
+        auto valuePos = data.find(COMPACT_DICT_VALUE_SEP, pos);
+        if (valuePos < entryEnd) {
+            auto key = compactUnescape(data.substr(pos, valuePos - pos));
+            auto it = dict->lower_bound(key);
+            if (it == dict->end() || it->first != key)
+                dict->emplace_hint(it, std::move(key), compactUnescape(data.substr(valuePos + 1, entryEnd - valuePos - 1)));
         }
-        auto eqPos = std::strchr(data, '=');
-        if (eqPos && eqPos < ampPos) {
-            std::string key(data, eqPos - data);
-            std::string value(eqPos + 1, ampPos - eqPos - 1);
-            key = urlUnescape(key);
-            value = urlUnescape(value);
-
-            dict->insert(std::pair(key, value));
+        pos = entryEnd + 1;
+    }
+}
+
+void dictDecode(std::string_view url, std::map<std::string, std::string>* dict)
+{
+    if (!url.empty() && url.front() == COMPACT_DICT_MARKER) {
+        dictDecodeCompact(url, dict);
+        return;
+    }
+
+    std::size_t pos = 0;
+    while (pos < url.length()) {
+        auto ampPos = url.find('&', pos);
+        if (ampPos == std::string_view::npos)
+            ampPos = url.length();
+        auto eqPos = url.find('=', pos);
+        if (eqPos < ampPos) {
+            auto key = urlUnescape(url.substr(pos, eqPos - pos));
+            // the first value of a key is kept
+            auto it = dict->lower_bound(key);
+            if (it == dict->end() || it->first != key)
+                dict->emplace_hint(it, std::move(key), urlUnescape(url.substr(eqPos + 1, ampPos - eqPos - 1)));
         }
-        data = ampPos + 1;
+        pos = ampPos + 1;
     }
 }
 
 // this is somewhat tricky as we need an exact amount of pairs
 // object_id=720&res_id=0
-void dictDecodeSimple(const std::string& url, std::map<std::string, std::string>* dict)
+void dictDecodeSimple(std::string_view url, std::map<std::string, std::string>* dict)
 {
     size_t pos;
     size_t last_pos = 0;
     do {
         pos = url.find('/', last_pos);
-        if (pos == std::string::npos || pos < last_pos + 1)
+        if (pos == std::string_view::npos || pos < last_pos + 1)
             break;
 
         std::string key = urlUnescape(url.substr(last_pos, pos - last_pos));
         last_pos = pos + 1;
         pos = url.find('/', last_pos);
-        if (pos == std::string::npos)
+        if (pos == std::string_view::npos)
             pos = url.length();
         if (pos < last_pos + 1)
             break;
@@ -504,7 +881,7 @@ void dictDecodeSimple(const std::string& url, std::map<std::string, std::string>
         std::string value = urlUnescape(url.substr(last_pos, pos - last_pos));
         last_pos = pos + 1;
 
-        dict->insert(std::pair(key, value));
+        dict->emplace(std::move(key), std::move(value));
     } while (last_pos < url.length());
 }
 
@@ -659,6 +1036,55 @@ int HMSFToMilliseconds(const std::string& time)
     return ((hours * 3600) + (minutes * 60) + seconds) * 1000 + ms;
 }
 
+int nptToMilliseconds(const std::string& time)
+{
+    // npt-sec = 1*DIGIT [ "." 1*3DIGIT ], npt-hhmmss = npt-hh ":" npt-mm ":" npt-ss [ "." 1*3DIGIT ]
+    auto parts = splitString(time, ':', true);
+    if (parts.empty() || parts.size() == 2 || parts.size() > 3)
+        return -1;
+
+    auto dot = parts.back().find('.');
+    auto fraction = dot != std::string::npos ? parts.back().substr(dot + 1) : "";
+    parts.back() = parts.back().substr(0, dot);
+    if (fraction.size() > 3 || (dot != std::string::npos && fraction.empty()))
+        return -1;
+
+    long long seconds = 0;
+    for (auto&& part : parts) {
+        if (part.empty() || part.size() > 9 || part.find_first_not_of("0123456789") != std::string::npos)
+            return -1;
+        seconds = seconds * 60 + std::stoll(part);
+    }
+    if (fraction.find_first_not_of("0123456789") != std::string::npos)
+        return -1;
+    fraction.resize(3, '0');
+
+    auto ms = seconds * 1000 + std::stoi(fraction);
+    return ms > INT_MAX ? -1 : int(ms);
+}
+
+bool parseHourRange(const std::string& range, int& start, int& end)
+{
+    auto parts = splitString(range, '-');
+    if (parts.size() != 2)
+        return false;
+    for (auto&& part : parts) {
+        trimStringInPlace(part);
+        if (part.empty() || part.size() > 2 || part.find_first_not_of("0123456789") != std::string::npos)
+            return false;
+    }
+    start = std::stoi(parts[0]);
+    end = std::stoi(parts[1]);
+    return start < 24 && end <= 24 && start != end;
+}
+
+bool isInHourRange(int hour, int start, int end)
+{
+    if (start < end)
+        return hour >= start && hour < end;
+    return hour >= start || hour < end;
+}
+
 bool checkResolution(const std::string& resolution, int* x, int* y)
 {
     if (x != nullptr)
@@ -761,14 +1187,14 @@ std::string fallbackString(const std::string& first, const std::string& fallback
     return first.empty() ? fallback : first;
 }
 
-unsigned int stringHash(const std::string& str)
+std::int64_t stringHash(const std::string& str)
 {
-    unsigned int hash = 5381;
-    auto data = str.c_str();
-    int c;
-    while ((c = *data++))
-        hash = ((hash << 5) + hash) ^ c; /* (hash * 33) ^ c */
-    return hash;
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : str) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<std::int64_t>(hash & 0x7fffffffffffffffULL);
 }
 
 std::string getValueOrDefault(const std::map<std::string, std::string>& m, const std::string& key, const std::string& defval)
@@ -872,9 +1298,10 @@ std::vector<std::string> populateCommandLine(const std::string& line,
     const std::string& in,
     const std::string& out,
     const std::string& range,
-    const std::string& title)
+    const std::string& title,
+    int start)
 {
-    log_debug("Template: '{}', in: '{}', out: '{}', range: '{}', title: '{}'", line, in, out, range, title);
+    log_debug("Template: '{}', in: '{}', out: '{}', range: '{}', title: '{}', start: {}", line, in, out, range, title, start);
     std::vector<std::string> params = splitString(line, ' ');
     if (in.empty() && out.empty())
         return params;
@@ -899,6 +1326,11 @@ std::vector<std::string> populateCommandLine(const std::string& line,
         if (titlePos != std::string::npos) {
             std::string newParam = param.replace(titlePos, 6, title);
         }
+
+        size_t startPos = param.find("%start");
+        if (startPos != std::string::npos) {
+            std::string newParam = param.replace(startPos, 6, fmt::format("{}.{:03}", start / 1000, start % 1000));
+        }
     }
 
     return params;
@@ -1070,6 +1502,54 @@ ssize_t getValidUTF8CutPosition(std::string str, ssize_t cutpos)
     return pos;
 }
 
+bool isValidUTF8(std::string_view str)
+{
+    for (std::size_t i = 0; i < str.size();) {
+        // skip plain ASCII a word at a time, most tags and names are
+        std::uint64_t word;
+        if (i + sizeof(word) <= str.size()) {
+            std::memcpy(&word, str.data() + i, sizeof(word));
+            if (!(word & 0x8080808080808080ULL)) {
+                i += sizeof(word);
+                continue;
+            }
+        }
+        auto c = static_cast<unsigned char>(str[i]);
+        std::size_t extra;
+        char32_t codepoint;
+        if (c < 0x80) {
+            i++;
+            continue;
+        }
+        if ((c & 0xe0) == 0xc0) {
+            extra = 1;
+            codepoint = c & 0x1f;
+        } else if ((c & 0xf0) == 0xe0) {
+            extra = 2;
+            codepoint = c & 0x0f;
+        } else if ((c & 0xf8) == 0xf0) {
+            extra = 3;
+            codepoint = c & 0x07;
+        } else
+            return false;
+
+        if (i + extra >= str.size())
+            return false;
+        for (std::size_t j = 1; j <= extra; j++) {
+            auto next = static_cast<unsigned char>(str[i + j]);
+            if ((next & 0xc0) != 0x80)
+                return false;
+            codepoint = (codepoint << 6) | (next & 0x3f);
+        }
+        // overlong forms, surrogates and values beyond unicode
+        static constexpr char32_t minimum[] = { 0, 0x80, 0x800, 0x10000 };
+        if (codepoint < minimum[extra] || (codepoint >= 0xd800 && codepoint <= 0xdfff) || codepoint > 0x10ffff)
+            return false;
+        i += extra + 1;
+    }
+    return true;
+}
+
 std::string getDLNAprofileString(const std::string& contentType)
 {
     std::string profile;
@@ -1115,6 +1595,39 @@ std::string getDLNATransferHeader(const std::shared_ptr<Config>& config, const s
     return transfer_parameter;
 }
 
+DLNAMimeTable::DLNAMimeTable(const std::map<std::string, std::string>& mimeToContentType)
+    : imageDefault(build("image/*", ""))
+    , mediaDefault(build("video/*", ""))
+    , otherDefault(build("", ""))
+{
+    for (auto&& [mimeType, contentType] : mimeToContentType)
+        table.emplace(mimeType, build(mimeType, contentType));
+}
+
+DLNAMimeInfo DLNAMimeTable::build(const std::string& mimeType, const std::string& contentType)
+{
+    DLNAMimeInfo info;
+    info.contentType = contentType;
+    info.profile = getDLNAprofileString(contentType);
+    info.protocolInfoExtend = info.profile.empty() ? "" : info.profile + ";";
+    info.protocolInfoExtend.append(fmt::format("{}={};{}={}", UPNP_DLNA_OP, UPNP_DLNA_OP_SEEK_RANGE, UPNP_DLNA_CONVERSION_INDICATOR, UPNP_DLNA_NO_CONVERSION));
+    info.contentFeatures = getDLNAContentHeader(nullptr, contentType);
+    info.transferMode = getDLNATransferHeader(nullptr, mimeType);
+    return info;
+}
+
+const DLNAMimeInfo& DLNAMimeTable::get(const std::string& mimeType) const
+{
+    auto entry = table.find(mimeType);
+    if (entry != table.end())
+        return entry->second;
+    if (startswith(mimeType, "image"))
+        return imageDefault;
+    if (startswith(mimeType, "audio") || startswith(mimeType, "video"))
+        return mediaDefault;
+    return otherDefault;
+}
+
 #ifndef HAVE_FFMPEG
 std::string getAVIFourCC(const fs::path& avi_filename)
 {
@@ -31,17 +31,21 @@
 #ifndef __TOOLS_H__
 #define __TOOLS_H__
 
+#include <cstdint>
 #include <filesystem>
 #include <map>
 #include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 namespace fs = std::filesystem;
 
 #include <netinet/in.h>
+#include <sys/stat.h>
 
 #include "common.h"
 
@@ -96,9 +100,31 @@ time_t getLastWriteTime(const fs::path& path);
 bool isRegularFile(const fs::path& path);
 bool isRegularFile(const fs::path& path, std::error_code& ec) noexcept;
 
+/// \brief Lists the subdirectories or the regular files of a directory, sorted by name
+///
+/// The type is taken from readdir, only symlinks and entries of unknown type are stat'ed.
+/// \param directories list directories instead of regular files
+/// \param hidden include names starting with a dot
+std::vector<std::string> listDirectory(const fs::path& path, bool directories, bool hidden, std::error_code& ec);
+
+/// \brief Checks if a directory has any entry, without looking at the entries
+bool hasDirectoryEntries(const fs::path& path);
+
 /// \brief Returns file size of give file, if it does not exist it will throw an exception
 off_t getFileSize(const fs::path& path);
 
+/// \brief Entry of listDirectory() with the result of its stat call
+struct ListedEntry {
+    fs::path path;
+    struct stat st;
+    bool isSymlink;
+};
+
+/// \brief Lists a directory with one stat per entry, relative to the open directory
+/// \param followSymlinks st describes the link target instead of the link, dangling links are left out
+/// \return the entries without "." and "..", throws if the directory can't be opened
+std::vector<ListedEntry> listDirectory(const fs::path& dir, bool followSymlinks);
+
 /// \brief Checks if the given binary is executable by our process
 /// \param path absolute path of the binary
 /// \param err if not NULL err will contain the errno result of the check
@@ -141,18 +167,35 @@ std::string hexMd5(const void* data, int length);
 /// \brief Generates hex md5 sum of the given string.
 std::string hexStringMd5(const std::string& str);
 
+/// \brief 128 bit hash (MurmurHash3) of the given data as 32 hex digits
+///
+/// Much faster than md5 for content keys of caches, it is not meant to resist deliberate collisions.
+std::string hexFastHash(const void* data, std::size_t length);
+
+/// \brief hexFastHash of the given string.
+std::string hexStringFastHash(std::string_view str);
+
 /// \brief Converts a string to a URL (meaning: %20 instead of space and so on)
 /// \param str String to be converted.
 /// \return string that contains the url-escaped representation of the original string.
-std::string urlEscape(const std::string& str);
+std::string urlEscape(std::string_view str);
 
 /// \brief Opposite of urlEscape :)
-std::string urlUnescape(const std::string& str);
+std::string urlUnescape(std::string_view str);
 
 std::string dictEncode(const std::map<std::string, std::string>& dict);
 std::string dictEncodeSimple(const std::map<std::string, std::string>& dict);
-void dictDecode(const std::string& url, std::map<std::string, std::string>* dict);
-void dictDecodeSimple(const std::string& url, std::map<std::string, std::string>* dict);
+/// \brief append the dictEncodeSimple form of dict to buf
+void dictEncodeSimple(const std::map<std::string, std::string>& dict, std::string& buf);
+/// \brief Shorter form of dictEncode for the database, read by dictDecode as well
+///
+/// Separators are control characters instead of escaped text and common resource attribute names,
+/// protocolInfo parts and mime type prefixes are written as two bytes. The result does not contain
+/// the separators of encoded resources ('|' and '~') or NUL.
+std::string dictEncodeCompact(const std::map<std::string, std::string>& dict);
+/// \brief decode the output of dictEncode or dictEncodeCompact, the first value of a key is kept
+void dictDecode(std::string_view url, std::map<std::string, std::string>* dict);
+void dictDecodeSimple(std::string_view url, std::map<std::string, std::string>* dict);
 
 /// \brief Convert an array of strings to a CSV list, with additional protocol information
 /// \param array that needs to be converted
@@ -196,6 +239,17 @@ std::string millisecondsToHMSF(int milliseconds);
 /// \brief converts a "H*:MM:SS.F*" representation to milliseconds
 int HMSFToMilliseconds(const std::string& time);
 
+/// \brief converts a DLNA npt time (seconds or H:MM:SS with optional fraction) to milliseconds
+/// \return -1 if time is not valid
+int nptToMilliseconds(const std::string& time);
+
+/// \brief parses a range of hours like 1-6, the end is not included and may be before the start to span midnight
+/// \return false if range is not valid
+bool parseHourRange(const std::string& range, int& start, int& end);
+
+/// \brief true if hour is in the range parsed by parseHourRange
+bool isInHourRange(int hour, int start, int end);
+
 /// \brief Extracts resolution from a JPEG image
 std::string get_jpeg_resolution(const std::unique_ptr<IOHandler>& ioh);
 
@@ -225,10 +279,10 @@ std::string xml_unescape(std::string string);
 /// \return return first if it isn't nullptr, otherwise fallback
 std::string fallbackString(const std::string& first, const std::string& fallback);
 
-/// \brief computes an (unsigned int) hash for the given string
+/// \brief computes a 64 bit FNV-1a hash for the given string
 /// \param str the string to compute the hash for
-/// \return return the (unsigned int) hash value
-unsigned int stringHash(const std::string& str);
+/// \return return the hash value, the top bit is cleared so it fits signed 64 bit database columns
+std::int64_t stringHash(const std::string& str);
 
 template <typename C, typename D>
 std::string join(const C& container, const D& delimiter)
@@ -275,13 +329,14 @@ bool validateYesNo(const std::string& value);
 ///
 /// This function splits a string into array parts, where space is used as the
 /// separator. In addition special %in and %out tokens are replaced by given
-/// strings.
+/// strings. %start is replaced by the start position in seconds.
 /// \todo add escaping
 std::vector<std::string> populateCommandLine(const std::string& line,
     const std::string& in = "",
     const std::string& out = "",
     const std::string& range = "",
-    const std::string& title = "");
+    const std::string& title = "",
+    int start = 0);
 
 /// \brief this is the mkstemp routine from glibc, the only difference is that
 /// it does not return an fd but just the name that we could use.
@@ -302,10 +357,45 @@ fs::path getLastPath(const fs::path& path);
 /// \return Caclulated position or -1 in case of an error.
 ssize_t getValidUTF8CutPosition(std::string str, ssize_t cutpos);
 
+/// \brief Checks that str is well formed UTF-8 without converting it.
+bool isValidUTF8(std::string_view str);
+
 std::string getDLNATransferHeader([[maybe_unused]] const std::shared_ptr<Config>& config, const std::string& mimeType);
 std::string getDLNAprofileString(const std::string& contentType);
 std::string getDLNAContentHeader([[maybe_unused]] const std::shared_ptr<Config>& config, const std::string& contentType);
 
+/// \brief DLNA strings of a mime type
+struct DLNAMimeInfo {
+    std::string contentType;
+    /// \brief DLNA.ORG_PN=..., empty if there is no profile for the content type
+    std::string profile;
+    /// \brief last field of the protocolInfo of a resource that is not transcoded
+    std::string protocolInfoExtend;
+    /// \brief value of the contentFeatures.dlna.org header
+    std::string contentFeatures;
+    /// \brief value of the transferMode.dlna.org header
+    std::string transferMode;
+};
+
+/// \brief DLNA strings of all mapped mime types, built once when the configuration is loaded
+///
+/// The table is not changed after construction, so it can be read from all threads without locking.
+class DLNAMimeTable {
+public:
+    explicit DLNAMimeTable(const std::map<std::string, std::string>& mimeToContentType);
+
+    /// \brief strings for mimeType, mime types without mapping get the defaults of their major type
+    const DLNAMimeInfo& get(const std::string& mimeType) const;
+
+protected:
+    static DLNAMimeInfo build(const std::string& mimeType, const std::string& contentType);
+
+    std::unordered_map<std::string, DLNAMimeInfo> table;
+    DLNAMimeInfo imageDefault;
+    DLNAMimeInfo mediaDefault;
+    DLNAMimeInfo otherDefault;
+};
+
 #ifndef HAVE_FFMPEG
 /// \brief Fallback code to retrieve the used fourcc from an AVI file.
 ///
@@ -0,0 +1,128 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    trace.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file trace.cc
+
+#include "trace.h" // API
+
+#include <fstream>
+#include <unistd.h>
+
+#include "json_writer.h"
+#include "logger.h"
+
+thread_local Trace* Trace::active = nullptr;
+
+Trace::Trace(std::string name, unsigned long id)
+    : id(id)
+{
+    spans.push_back(Span { std::move(name), std::chrono::steady_clock::now(), {}, 0 });
+    open.push_back(0);
+}
+
+std::size_t Trace::begin(std::string_view name)
+{
+    spans.push_back(Span { std::string(name), std::chrono::steady_clock::now(), {}, static_cast<int>(open.size()) });
+    open.push_back(spans.size() - 1);
+    return spans.size() - 1;
+}
+
+void Trace::end(std::size_t index)
+{
+    auto now = std::chrono::steady_clock::now();
+    // spans end in reverse order, unless an exception skipped the end of inner ones
+    while (!open.empty()) {
+        auto last = open.back();
+        if (last < index)
+            break;
+        spans.at(last).duration = now - spans.at(last).start;
+        open.pop_back();
+    }
+}
+
+void Trace::finish()
+{
+    end(0);
+}
+
+std::string Trace::summary() const
+{
+    auto ms = [](std::chrono::steady_clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+    std::string result = fmt::format("{} {:.3f} ms", spans.front().name, ms(spans.front().duration));
+    std::vector<std::string_view> path;
+    for (std::size_t i = 1; i < spans.size(); i++) {
+        auto&& span = spans.at(i);
+        path.resize(span.depth - 1);
+        path.push_back(span.name);
+        result.append(fmt::format("{} {} {:.3f} ms", i == 1 ? ":" : ",", fmt::join(path, "/"), ms(span.duration)));
+    }
+    return result;
+}
+
+std::string Trace::chromeEvents(std::chrono::steady_clock::time_point epoch) const
+{
+    auto us = [](std::chrono::steady_clock::duration duration) { return std::chrono::duration_cast<std::chrono::microseconds>(duration).count(); };
+
+    std::string result;
+    for (auto&& span : spans) {
+        result.append("{\"name\":");
+        JsonStreamWriter::escape(result, span.name);
+        // each request gets its own track
+        result.append(fmt::format(",\"cat\":\"upnp\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":{},\"tid\":{}}},\n", us(span.start - epoch), us(span.duration), getpid(), id));
+    }
+    return result;
+}
+
+Tracer::Tracer(unsigned int sampleRate, fs::path file)
+    : sampleRate(sampleRate)
+    , file(std::move(file))
+{
+}
+
+std::unique_ptr<Trace> Tracer::sample(std::string name)
+{
+    if (sampleRate == 0)
+        return nullptr;
+    auto request = requests++;
+    if (request % sampleRate != 0)
+        return nullptr;
+    return std::make_unique<Trace>(std::move(name), request / sampleRate + 1);
+}
+
+void Tracer::finish(Trace& trace)
+{
+    trace.finish();
+    log_info("Trace {}: {}", trace.getID(), trace.summary());
+    if (file.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    std::ofstream out(file, std::ios::app);
+    // the closing bracket is optional in the array format, so traces can be appended
+    if (out.tellp() == 0)
+        out << "[\n";
+    out << trace.chromeEvents(epoch);
+    if (!out)
+        log_warning("Could not write trace to {}", file.c_str());
+}
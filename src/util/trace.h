@@ -0,0 +1,144 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    trace.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file trace.h
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+namespace fs = std::filesystem;
+
+/// \brief Nested spans timed while one request was handled
+///
+/// A trace only collects the spans of the thread it is the current trace of,
+/// work handed to other threads counts to the span that waits for it.
+class Trace {
+public:
+    struct Span {
+        std::string name;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::duration duration;
+        /// \brief 0 for the span of the whole request
+        int depth;
+    };
+
+    /// \brief starts the span of the whole request
+    Trace(std::string name, unsigned long id);
+
+    unsigned long getID() const { return id; }
+    /// \brief spans by start time, the span of the whole request first
+    const std::vector<Span>& getSpans() const { return spans; }
+
+    /// \brief trace of the current thread, nullptr if the request is not traced
+    static Trace* current() { return active; }
+
+    /// \brief makes trace the trace of the current thread until it goes out of scope
+    class Scope {
+    public:
+        explicit Scope(Trace* trace)
+            : previous(active)
+        {
+            active = trace;
+        }
+        ~Scope() { active = previous; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Trace* previous;
+    };
+
+    /// \return index to pass to end
+    std::size_t begin(std::string_view name);
+    void end(std::size_t index);
+
+    /// \brief ends the span of the whole request and all spans still open
+    void finish();
+
+    /// \brief one line with the duration of each span, nested spans are named by their path
+    std::string summary() const;
+    /// \brief complete events of the Chrome trace event format, each followed by a comma
+    std::string chromeEvents(std::chrono::steady_clock::time_point epoch) const;
+
+private:
+    static thread_local Trace* active;
+
+    unsigned long id;
+    std::vector<Span> spans;
+    /// \brief spans begun and not ended yet
+    std::vector<std::size_t> open;
+};
+
+/// \brief times the enclosing scope as span of the current trace, does nothing if the request is not traced
+class TraceSpan {
+public:
+    explicit TraceSpan(std::string_view name)
+        : trace(Trace::current())
+    {
+        if (trace != nullptr)
+            index = trace->begin(name);
+    }
+    ~TraceSpan()
+    {
+        if (trace != nullptr)
+            trace->end(index);
+    }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    Trace* trace;
+    std::size_t index { 0 };
+};
+
+/// \brief Picks the requests to trace and writes their traces
+class Tracer {
+public:
+    /// \param sampleRate trace every sampleRate-th request, 0 to trace none
+    /// \param file append the spans to this file in the Chrome trace event format, empty to only log them
+    Tracer(unsigned int sampleRate, fs::path file);
+
+    bool isEnabled() const { return sampleRate > 0; }
+
+    /// \brief new trace if the request is picked, nullptr otherwise
+    std::unique_ptr<Trace> sample(std::string name);
+
+    /// \brief end the trace, log it and append it to the file
+    void finish(Trace& trace);
+
+private:
+    unsigned int sampleRate;
+    fs::path file;
+    std::chrono::steady_clock::time_point epoch { std::chrono::steady_clock::now() };
+    std::atomic_ulong requests { 0 };
+    std::mutex fileMutex;
+};
+
+#endif // __TRACE_H__
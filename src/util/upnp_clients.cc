@@ -34,6 +34,12 @@
 #include <upnp.h>
 
 // table of supported clients (reverse search, sequence of entries matters!)
+/// \brief number of address and user agent pairs remembered, more are matched every time
+static constexpr std::size_t RESOLVED_CLIENTS_MAX = 1024;
+
+/// \brief interval to refresh the last seen time of a resolved client in the client list
+static constexpr auto RESOLVED_TOUCH_INTERVAL = std::chrono::minutes(1);
+
 static const auto bultinClientInfo = std::array<ClientInfo, 8> {
     {
 
@@ -120,16 +126,46 @@ static const auto bultinClientInfo = std::array<ClientInfo, 8> {
 };
 
 Clients::Clients(const std::shared_ptr<Config>& config)
+    : clientInfo(readClientInfo(config))
+{
+    cache = std::make_shared<std::vector<ClientCacheEntry>>();
+}
+
+std::shared_ptr<const std::vector<ClientInfo>> Clients::readClientInfo(const std::shared_ptr<Config>& config)
 {
-    std::copy(bultinClientInfo.begin(), bultinClientInfo.end(), std::back_inserter(clientInfo));
+    auto result = std::make_shared<std::vector<ClientInfo>>(bultinClientInfo.begin(), bultinClientInfo.end());
     auto clientConfigList = config->getClientConfigListOption(CFG_CLIENTS_LIST);
     for (size_t i = 0; i < clientConfigList->size(); i++) {
         auto clientConfig = clientConfigList->get(i);
         auto client = clientConfig->getClientInfo();
-        clientInfo.push_back(*client);
+        result->push_back(*client);
     }
+    return result;
+}
 
-    cache = std::make_shared<std::vector<ClientCacheEntry>>();
+void Clients::reload(const std::shared_ptr<Config>& config)
+{
+    auto info = readClientInfo(config);
+    AutoLock lock(mutex);
+    retiredClientInfo.push_back(std::atomic_exchange(&clientInfo, info));
+    // clients are matched again with the new configuration
+    cache->clear();
+    std::unique_lock<std::shared_mutex> resolvedLock(resolvedMutex);
+    resolved.clear();
+}
+
+std::string Clients::resolvedKey(const struct sockaddr_storage* addr, const std::string& userAgent)
+{
+    std::string key;
+    if (addr->ss_family == AF_INET6) {
+        auto in6 = reinterpret_cast<const struct sockaddr_in6*>(addr);
+        key.assign(reinterpret_cast<const char*>(&in6->sin6_addr), sizeof(in6->sin6_addr));
+    } else {
+        auto in = reinterpret_cast<const struct sockaddr_in*>(addr);
+        key.assign(reinterpret_cast<const char*>(&in->sin_addr), sizeof(in->sin_addr));
+    }
+    key.push_back(static_cast<char>(addr->ss_family));
+    return key.append(userAgent);
 }
 
 void Clients::addClientByDiscovery(const struct sockaddr_storage* addr, const std::string& userAgent, const std::string& descLocation)
@@ -148,18 +184,50 @@ void Clients::addClientByDiscovery(const struct sockaddr_storage* addr, const st
 void Clients::getInfo(const struct sockaddr_storage* addr, const std::string& userAgent, const ClientInfo** ppInfo)
 {
     const ClientInfo* info = nullptr;
+    auto key = resolvedKey(addr, userAgent);
+    auto now = std::chrono::steady_clock::now();
+    {
+        // every request of a client has the same address and user agent
+        std::shared_lock<std::shared_mutex> resolvedLock(resolvedMutex);
+        auto entry = resolved.find(key);
+        if (entry != resolved.end()) {
+            info = entry->second.pInfo;
+            auto touched = entry->second.touched.load();
+            if (now.time_since_epoch().count() - touched > std::chrono::duration_cast<std::chrono::steady_clock::duration>(RESOLVED_TOUCH_INTERVAL).count()
+                && entry->second.touched.compare_exchange_strong(touched, now.time_since_epoch().count())) {
+                resolvedLock.unlock();
+                updateCache(addr, userAgent, info);
+            }
+            *ppInfo = info;
+            return;
+        }
+    }
+
+    auto clients = std::atomic_load(&clientInfo);
 
     // 1. by IP address
-    bool found = getInfoByAddr(addr, &info);
+    bool found = getInfoByAddr(*clients, addr, &info);
 
     if (!found) {
         // 2. by User-Agent
-        found = getInfoByType(userAgent, ClientMatchType::UserAgent, &info);
+        found = getInfoByType(*clients, userAgent, ClientMatchType::UserAgent, &info);
     }
 
     // update IP or User-Agent match in cache
     if (found) {
         updateCache(addr, userAgent, info);
+
+        std::unique_lock<std::shared_mutex> resolvedLock(resolvedMutex);
+        // a reload in between has cleared the entries of the old list, do not add to the new one
+        if (clients == std::atomic_load(&clientInfo)) {
+            if (resolved.size() >= RESOLVED_CLIENTS_MAX)
+                resolved.clear();
+            auto&& [entry, added] = resolved.try_emplace(key);
+            if (added) {
+                entry->second.pInfo = info;
+                entry->second.touched = now.time_since_epoch().count();
+            }
+        }
     }
 
     if (!found) {
@@ -170,8 +238,8 @@ void Clients::getInfo(const struct sockaddr_storage* addr, const std::string& us
 
     if (!found) {
         // always return something, 'Unknown' if we do not know better
-        assert(clientInfo[0].type == ClientType::Unknown);
-        info = &clientInfo[0];
+        assert((*clients)[0].type == ClientType::Unknown);
+        info = &(*clients)[0];
 
         // also add to cache, for web-ui proposes only
         updateCache(addr, userAgent, info);
@@ -181,9 +249,9 @@ void Clients::getInfo(const struct sockaddr_storage* addr, const std::string& us
     log_debug("client info: {} '{}' -> '{}' as {}", sockAddrGetNameInfo(reinterpret_cast<const struct sockaddr*>(addr)), userAgent, (*ppInfo)->name, ClientConfig::mapClientType((*ppInfo)->type));
 }
 
-bool Clients::getInfoByAddr(const struct sockaddr_storage* addr, const ClientInfo** ppInfo)
+bool Clients::getInfoByAddr(const std::vector<ClientInfo>& clients, const struct sockaddr_storage* addr, const ClientInfo** ppInfo)
 {
-    auto it = std::find_if(clientInfo.begin(), clientInfo.end(), [&](const auto& c) {
+    auto it = std::find_if(clients.begin(), clients.end(), [&](const auto& c) {
         if (c.matchType != ClientMatchType::IP) {
             return false;
         }
@@ -210,7 +278,7 @@ bool Clients::getInfoByAddr(const struct sockaddr_storage* addr, const ClientInf
         return false;
     });
 
-    if (it != clientInfo.end()) {
+    if (it != clients.end()) {
         *ppInfo = &(*it);
         auto ip = getHostName(reinterpret_cast<const struct sockaddr*>(addr));
         log_debug("found client by IP (ip='{}')", ip.c_str());
@@ -221,13 +289,13 @@ bool Clients::getInfoByAddr(const struct sockaddr_storage* addr, const ClientInf
     return false;
 }
 
-bool Clients::getInfoByType(const std::string& match, ClientMatchType type, const ClientInfo** ppInfo)
+bool Clients::getInfoByType(const std::vector<ClientInfo>& clients, const std::string& match, ClientMatchType type, const ClientInfo** ppInfo)
 {
     if (!match.empty()) {
-        auto it = std::find_if(clientInfo.rbegin(), clientInfo.rend(), [&](const auto& c) //
+        auto it = std::find_if(clients.rbegin(), clients.rend(), [&](const auto& c) //
             { return c.matchType == type && match.find(c.match) != std::string::npos; });
 
-        if (it != clientInfo.rend()) {
+        if (it != clients.rend()) {
             *ppInfo = &(*it);
             log_debug("found client by type (match='{}')", match.c_str());
             return true;
@@ -28,11 +28,14 @@
 #ifndef __UPNP_CLIENTS_H__
 #define __UPNP_CLIENTS_H__
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <mutex>
 #include <pugixml.hpp>
+#include <shared_mutex>
 #include <sys/socket.h>
+#include <unordered_map>
 #include <vector>
 
 #include "util/upnp_quirks.h"
@@ -87,24 +90,42 @@ public:
     // always return something, 'Unknown' if we do not know better
     void getInfo(const struct sockaddr_storage* addr, const std::string& userAgent, const ClientInfo** ppInfo);
 
+    /// \brief use the client configuration of config from now on
+    void reload(const std::shared_ptr<Config>& config);
+
     void addClientByDiscovery(const struct sockaddr_storage* addr, const std::string& userAgent, const std::string& descLocation);
     std::shared_ptr<std::vector<ClientCacheEntry>> getClientList() { return cache; }
 
 private:
-    bool getInfoByAddr(const struct sockaddr_storage* addr, const ClientInfo** ppInfo);
-    bool getInfoByType(const std::string& match, ClientMatchType type, const ClientInfo** ppInfo);
+    static std::shared_ptr<const std::vector<ClientInfo>> readClientInfo(const std::shared_ptr<Config>& config);
+    bool getInfoByAddr(const std::vector<ClientInfo>& clients, const struct sockaddr_storage* addr, const ClientInfo** ppInfo);
+    bool getInfoByType(const std::vector<ClientInfo>& clients, const std::string& match, ClientMatchType type, const ClientInfo** ppInfo);
 
     bool getInfoByCache(const struct sockaddr_storage* addr, const ClientInfo** ppInfo);
     void updateCache(const struct sockaddr_storage* addr, const std::string& userAgent, const ClientInfo* pInfo);
 
     bool downloadDescription(const std::string& location, std::unique_ptr<pugi::xml_document>& xml);
 
+    /// \brief key of the resolved clients, the address without port and the user agent
+    static std::string resolvedKey(const struct sockaddr_storage* addr, const std::string& userAgent);
+
 private:
     std::mutex mutex;
     using AutoLock = std::lock_guard<std::mutex>;
     std::shared_ptr<std::vector<ClientCacheEntry>> cache;
 
-    std::vector<ClientInfo> clientInfo;
+    /// \brief client matched by address or user agent, these do not change until the configuration does
+    struct Resolved {
+        const ClientInfo* pInfo {};
+        /// \brief last time the entry of the client list was refreshed
+        std::atomic<std::chrono::steady_clock::rep> touched {};
+    };
+    std::shared_mutex resolvedMutex;
+    std::unordered_map<std::string, Resolved> resolved;
+
+    std::shared_ptr<const std::vector<ClientInfo>> clientInfo;
+    /// \brief lists replaced by reload(), requests in progress may still point into them
+    std::vector<std::shared_ptr<const std::vector<ClientInfo>>> retiredClientInfo;
 };
 
 #endif // __UPNP_CLIENTS_H__
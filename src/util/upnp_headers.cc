@@ -32,7 +32,9 @@
 #include <ExtraHeaders.h>
 #endif
 #endif
+#include <algorithm>
 #include <string>
+#include <strings.h>
 
 #include "common.h"
 #include "util/tools.h"
@@ -134,3 +136,10 @@ std::unique_ptr<std::map<std::string, std::string>> Headers::readHeaders(UpnpFil
     return ret;
 #endif
 }
+
+std::string Headers::getHeader(UpnpFileInfo* fileInfo, const std::string& name)
+{
+    auto headers = readHeaders(fileInfo);
+    auto header = std::find_if(headers->begin(), headers->end(), [&](auto&& entry) { return strcasecmp(entry.first.c_str(), name.c_str()) == 0; });
+    return header != headers->end() ? header->second : "";
+}
@@ -37,6 +37,8 @@ public:
     void writeHeaders(UpnpFileInfo* fileInfo) const;
 
     static std::unique_ptr<std::map<std::string, std::string>> readHeaders(UpnpFileInfo* fileInfo);
+    /// \brief value of the request header, the name is compared case insensitive
+    static std::string getHeader(UpnpFileInfo* fileInfo, const std::string& name);
 
 private:
     static std::string formatHeader(const std::pair<std::string, std::string>& header, bool crlf);
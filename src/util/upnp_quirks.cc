@@ -35,6 +35,7 @@
 #include "util/tools.h"
 #include "util/upnp_clients.h"
 #include "util/upnp_headers.h"
+#include "util/xml_writer.h"
 
 Quirks::Quirks(std::shared_ptr<Context> context, const struct sockaddr_storage* addr, const std::string& userAgent)
     : context(std::move(context))
@@ -43,6 +44,11 @@ Quirks::Quirks(std::shared_ptr<Context> context, const struct sockaddr_storage*
     this->context->getClients()->getInfo(addr, userAgent, &pClientInfo);
 }
 
+QuirkFlags Quirks::getFlags() const
+{
+    return pClientInfo->flags;
+}
+
 void Quirks::addCaptionInfo(const std::shared_ptr<CdsItem>& item, std::unique_ptr<Headers>& headers) const
 {
     if ((pClientInfo->flags & QUIRK_FLAG_SAMSUNG) == 0)
@@ -57,7 +63,7 @@ void Quirks::addCaptionInfo(const std::shared_ptr<CdsItem>& item, std::unique_pt
     }
 }
 
-void Quirks::restoreSamsungBookMarkedPosition(const std::shared_ptr<CdsItem>& item, pugi::xml_node* result) const
+void Quirks::restoreSamsungBookMarkedPosition(const std::shared_ptr<CdsItem>& item, XmlSink& result) const
 {
     if ((pClientInfo->flags & QUIRK_FLAG_SAMSUNG_BOOKMARK_SEC) == 0 && (pClientInfo->flags & QUIRK_FLAG_SAMSUNG_BOOKMARK_MSEC) == 0)
         return;
@@ -70,7 +76,7 @@ void Quirks::restoreSamsungBookMarkedPosition(const std::shared_ptr<CdsItem>& it
         positionToRestore *= 1000;
 
     auto dcmInfo = fmt::format("CREATIONDATE=0,FOLDER={},BM={}", item->getTitle(), positionToRestore);
-    result->append_child("sec:dcmInfo").append_child(pugi::node_pcdata).set_value(dcmInfo.c_str());
+    result.addElement("sec:dcmInfo", dcmInfo);
 }
 
 void Quirks::saveSamsungBookMarkedPosition(const std::unique_ptr<ActionRequest>& request) const
@@ -81,16 +87,13 @@ void Quirks::saveSamsungBookMarkedPosition(const std::unique_ptr<ActionRequest>&
         auto divider = (pClientInfo->flags & QUIRK_FLAG_SAMSUNG_BOOKMARK_MSEC) == 0 ? 1 : 1000;
         auto req_root = request->getRequest()->document_element();
         auto objectID = req_root.child("ObjectID").text().as_string();
-        auto bookMarkPos = std::to_string(stoiString(req_root.child("PosSecond").text().as_string()) / divider);
+        auto bookMarkPos = stoiString(req_root.child("PosSecond").text().as_string()) / divider;
         auto categoryType = req_root.child("CategoryType").text().as_string();
         auto rID = req_root.child("RID").text().as_string();
 
         log_debug("saveSamsungBookMarkedPosition: ObjectID [{}] PosSecond [{}] CategoryType [{}] RID [{}]", objectID, bookMarkPos, categoryType, rID);
 
-        std::map<std::string, std::string> m = {
-            { "bookmarkpos", bookMarkPos },
-        };
-        content->updateObject(stoiString(objectID), m);
+        content->setBookmark(stoiString(objectID), bookMarkPos);
     }
     auto response = UpnpXMLBuilder::createResponse(request->getActionName(), UPNP_DESC_CDS_SERVICE_TYPE);
     request->setResponse(response);
@@ -44,6 +44,7 @@ class ContentManager;
 class Context;
 class CdsItem;
 class Headers;
+class XmlSink;
 struct ClientInfo;
 
 class Quirks {
@@ -54,14 +55,17 @@ public:
     // To be more compliant with original Samsung server we should check for getCaptionInfo.sec: 1 request header.
     void addCaptionInfo(const std::shared_ptr<CdsItem>& item, std::unique_ptr<Headers>& headers) const;
 
+    /// \brief quirk flags of the client, rendered DIDL-Lite differs per flags
+    QuirkFlags getFlags() const;
+
     /** \brief Add Samsung specific bookmark information to the request's result.
      *
      * \param item const std::shared_ptr<CdsItem>& Item which will be played and stores the bookmark information.
-     * \param result pugi::xml_node* Answer content.
+     * \param result XmlSink& Answer content.
      * \return void
      *
      */
-    void restoreSamsungBookMarkedPosition(const std::shared_ptr<CdsItem>& item, pugi::xml_node* result) const;
+    void restoreSamsungBookMarkedPosition(const std::shared_ptr<CdsItem>& item, XmlSink& result) const;
 
     /** \brief Stored bookmark information into the database
      *
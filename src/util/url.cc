@@ -32,9 +32,8 @@
 #ifdef HAVE_CURL
 #include "url.h" // API
 
-#include <sstream>
-
 #include "config/config_manager.h"
+#include "util/curl_engine.h"
 #include "util/tools.h"
 
 std::string URL::download(const std::string& URL, long* HTTP_retcode,
@@ -52,9 +51,11 @@ std::string URL::download(const std::string& URL, long* HTTP_retcode,
             throw_std_runtime_error("Invalid curl handle");
     }
 
-    std::ostringstream buffer;
+    std::string buffer;
 
     curl_easy_reset(curl_handle);
+    // reuse connections and TLS sessions of earlier downloads and streams
+    CurlEngine::getInstance().share(curl_handle);
 
     if (verbose) {
         bool logEnabled;
@@ -109,7 +110,7 @@ std::string URL::download(const std::string& URL, long* HTTP_retcode,
     if (cleanup)
         curl_easy_cleanup(curl_handle);
 
-    return buffer.str();
+    return buffer;
 }
 
 std::unique_ptr<URL::Stat> URL::getInfo(const std::string& URL, CURL* curl_handle)
@@ -173,10 +174,8 @@ std::unique_ptr<URL::Stat> URL::getInfo(const std::string& URL, CURL* curl_handl
 
 size_t URL::dl(void* buf, size_t size, size_t nmemb, void* data)
 {
-    auto& oss = *reinterpret_cast<std::ostringstream*>(data);
-
     size_t s = size * nmemb;
-    oss << std::string(reinterpret_cast<const char*>(buf), s);
+    static_cast<std::string*>(data)->append(static_cast<const char*>(buf), s);
 
     return s;
 }
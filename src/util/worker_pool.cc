@@ -0,0 +1,134 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    worker_pool.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file worker_pool.cc
+
+#include "worker_pool.h" // API
+
+#include <algorithm>
+
+#include "exceptions.h"
+
+WorkerPool::WorkerPool(std::shared_ptr<Config> config, std::string name, std::size_t threadCount)
+    : config(std::move(config))
+    , name(std::move(name))
+    , threadCount(threadCount)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    if (!threads.empty())
+        shutdown();
+}
+
+void WorkerPool::run()
+{
+    AutoLock lock(mutex);
+    for (std::size_t i = 0; i < threadCount; i++) {
+        auto thread = std::make_unique<StdThreadRunner>(fmt::format("{}{}", name, i), WorkerPool::staticThreadProc, this, config);
+        if (!thread->isAlive())
+            throw_std_runtime_error("Could not start {} thread", name);
+        threads.push_back(std::move(thread));
+    }
+    log_debug("started {} {} threads", threads.size(), name);
+}
+
+void WorkerPool::shutdown()
+{
+    {
+        AutoLock lock(mutex);
+        shutdownFlag = true;
+        queueCond.notify_all();
+    }
+    for (auto&& thread : threads)
+        thread->join();
+    threads.clear();
+}
+
+bool WorkerPool::runNext(std::unique_lock<std::mutex>& lock, const std::shared_ptr<Batch>& batch)
+{
+    if (batch->next >= batch->count)
+        return false;
+    auto index = batch->next++;
+    if (batch->next >= batch->count) {
+        auto queued = std::find(queue.begin(), queue.end(), batch);
+        if (queued != queue.end())
+            queue.erase(queued);
+    }
+
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+        batch->job(index);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    lock.lock();
+
+    if (error && !batch->error)
+        batch->error = error;
+    if (++batch->done == batch->count)
+        doneCond.notify_all();
+    return true;
+}
+
+void WorkerPool::runBatch(std::size_t count, const std::function<void(std::size_t)>& job)
+{
+    if (count == 0)
+        return;
+
+    auto batch = std::make_shared<Batch>(Batch { job, count });
+    std::unique_lock<std::mutex> lock(mutex);
+    if (count > 1 && !shutdownFlag && !threads.empty()) {
+        queue.push_back(batch);
+        queueCond.notify_all();
+    }
+
+    while (runNext(lock, batch)) {
+    }
+    doneCond.wait(lock, [&] { return batch->done == batch->count; });
+
+    if (batch->error)
+        std::rethrow_exception(batch->error);
+}
+
+void* WorkerPool::staticThreadProc(void* arg)
+{
+    auto inst = static_cast<WorkerPool*>(arg);
+    inst->threadProc();
+    return nullptr;
+}
+
+void WorkerPool::threadProc()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!shutdownFlag) {
+        if (queue.empty()) {
+            queueCond.wait(lock);
+            continue;
+        }
+        auto batch = queue.front();
+        runNext(lock, batch);
+    }
+}
@@ -0,0 +1,89 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    worker_pool.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file worker_pool.h
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "util/thread_runner.h"
+
+// forward declaration
+class Config;
+
+/// \brief A few threads that help a request thread with work that splits into independent parts
+///
+/// The calling thread works on its own batch as well, so a batch finishes even if all threads are busy
+/// with batches of other requests.
+class WorkerPool {
+public:
+    WorkerPool(std::shared_ptr<Config> config, std::string name, std::size_t threadCount);
+    ~WorkerPool();
+
+    void run();
+    void shutdown();
+
+    /// \brief call job with every index below count and return when all calls are done
+    ///
+    /// The first exception thrown by a job is rethrown once the others are done.
+    void runBatch(std::size_t count, const std::function<void(std::size_t)>& job);
+
+protected:
+    struct Batch {
+        const std::function<void(std::size_t)>& job;
+        std::size_t count;
+        std::size_t next { 0 };
+        std::size_t done { 0 };
+        std::exception_ptr error;
+    };
+
+    std::shared_ptr<Config> config;
+    std::string name;
+    std::size_t threadCount;
+
+    std::mutex mutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+    std::condition_variable queueCond;
+    std::condition_variable doneCond;
+    bool shutdownFlag { false };
+
+    /// \brief batches with indices nobody has taken yet
+    std::deque<std::shared_ptr<Batch>> queue;
+    std::vector<std::unique_ptr<StdThreadRunner>> threads;
+
+    /// \brief take the next index of batch and run it, false if all indices are taken
+    bool runNext(std::unique_lock<std::mutex>& lock, const std::shared_ptr<Batch>& batch);
+
+    static void* staticThreadProc(void* arg);
+    void threadProc();
+};
+
+#endif // __WORKER_POOL_H__
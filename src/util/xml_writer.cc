@@ -0,0 +1,183 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    xml_writer.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file xml_writer.cc
+
+#include "xml_writer.h" // API
+
+void PugiXmlSink::startElement(std::string_view name)
+{
+    current = current.append_child(std::string(name).c_str());
+}
+
+void PugiXmlSink::addAttribute(std::string_view name, std::string_view value)
+{
+    current.append_attribute(std::string(name).c_str()) = std::string(value).c_str();
+}
+
+void PugiXmlSink::addText(std::string_view value)
+{
+    current.append_child(pugi::node_pcdata).set_value(std::string(value).c_str());
+}
+
+void PugiXmlSink::endElement()
+{
+    current = current.parent();
+}
+
+XmlStreamWriter::XmlStreamWriter(std::size_t reserve)
+{
+    buffer.reserve(reserve);
+}
+
+void XmlStreamWriter::escape(std::string& out, std::string_view value, bool attribute)
+{
+    auto start = value.begin();
+    for (auto it = value.begin(); it != value.end(); ++it) {
+        const char* entity;
+        char code[6];
+        auto ch = static_cast<unsigned char>(*it);
+        switch (ch) {
+        case '&':
+            entity = "&amp;";
+            break;
+        case '<':
+            entity = "&lt;";
+            break;
+        case '>':
+            entity = "&gt;";
+            break;
+        case '"':
+            if (!attribute)
+                continue;
+            entity = "&quot;";
+            break;
+        case '\t':
+        case '\n':
+        case '\r':
+            if (!attribute)
+                continue;
+            [[fallthrough]];
+        default:
+            if (ch >= 32)
+                continue;
+            // control characters as two digit references like pugixml writes them
+            code[0] = '&';
+            code[1] = '#';
+            code[2] = static_cast<char>('0' + ch / 10);
+            code[3] = static_cast<char>('0' + ch % 10);
+            code[4] = ';';
+            code[5] = '\0';
+            entity = code;
+        }
+        out.append(start, it);
+        out.append(entity);
+        start = it + 1;
+    }
+    out.append(start, value.end());
+}
+
+void XmlStreamWriter::addDeclaration()
+{
+    buffer.append(R"(<?xml version="1.0" encoding="UTF-8"?>)");
+    newline = true;
+}
+
+void XmlStreamWriter::closeTag()
+{
+    if (tagOpen) {
+        buffer.push_back('>');
+        tagOpen = false;
+    }
+}
+
+void XmlStreamWriter::startElement(std::string_view name)
+{
+    closeTag();
+    if (newline)
+        buffer.push_back('\n');
+    buffer.push_back('<');
+    buffer.append(name);
+    tagOpen = true;
+    newline = true;
+
+    nameStarts.push_back(names.size());
+    names.append(name);
+}
+
+void XmlStreamWriter::addAttribute(std::string_view name, std::string_view value)
+{
+    buffer.push_back(' ');
+    buffer.append(name);
+    buffer.append("=\"");
+    escape(buffer, value, true);
+    buffer.push_back('"');
+}
+
+void XmlStreamWriter::addText(std::string_view value)
+{
+    closeTag();
+    escape(buffer, value, false);
+    newline = false;
+}
+
+void XmlStreamWriter::endElement()
+{
+    auto start = nameStarts.back();
+    nameStarts.pop_back();
+    if (tagOpen) {
+        buffer.append(" />");
+        tagOpen = false;
+    } else {
+        if (newline)
+            buffer.push_back('\n');
+        buffer.append("</");
+        buffer.append(names, start, std::string::npos);
+        buffer.push_back('>');
+    }
+    names.resize(start);
+    newline = true;
+}
+
+void XmlStreamWriter::addFragment(std::string_view fragment)
+{
+    closeTag();
+    if (newline)
+        buffer.push_back('\n');
+    buffer.append(fragment);
+    newline = true;
+}
+
+std::string XmlStreamWriter::release()
+{
+    if (newline)
+        buffer.push_back('\n');
+    newline = false;
+    return std::move(buffer);
+}
+
+std::string XmlStreamWriter::releaseFragment()
+{
+    newline = false;
+    return std::move(buffer);
+}
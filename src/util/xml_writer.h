@@ -0,0 +1,112 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    xml_writer.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file xml_writer.h
+#ifndef __XML_WRITER_H__
+#define __XML_WRITER_H__
+
+#include <pugixml.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// \brief Receives an XML tree one element at a time
+///
+/// Attributes have to be added right after the element is started, before any text or child.
+class XmlSink {
+public:
+    virtual ~XmlSink() = default;
+
+    virtual void startElement(std::string_view name) = 0;
+    virtual void addAttribute(std::string_view name, std::string_view value) = 0;
+    virtual void addText(std::string_view value) = 0;
+    virtual void endElement() = 0;
+
+    /// \brief element that only holds text
+    void addElement(std::string_view name, std::string_view value)
+    {
+        startElement(name);
+        addText(value);
+        endElement();
+    }
+};
+
+/// \brief Appends the elements as pugixml nodes below a parent
+class PugiXmlSink : public XmlSink {
+public:
+    explicit PugiXmlSink(pugi::xml_node parent)
+        : current(parent)
+    {
+    }
+
+    void startElement(std::string_view name) override;
+    void addAttribute(std::string_view name, std::string_view value) override;
+    void addText(std::string_view value) override;
+    void endElement() override;
+
+private:
+    pugi::xml_node current;
+};
+
+/// \brief Writes the elements as text straight into a string
+///
+/// The output is laid out like pugixml prints a document without indent, so both
+/// can be compared. Escaping happens while the text is copied into the buffer.
+class XmlStreamWriter : public XmlSink {
+public:
+    /// \param reserve bytes to allocate up front
+    explicit XmlStreamWriter(std::size_t reserve = 0);
+
+    /// \brief start with <?xml version="1.0" encoding="UTF-8"?>
+    void addDeclaration();
+
+    void startElement(std::string_view name) override;
+    void addAttribute(std::string_view name, std::string_view value) override;
+    void addText(std::string_view value) override;
+    void endElement() override;
+
+    /// \brief append an element written by releaseFragment of another writer
+    void addFragment(std::string_view fragment);
+
+    /// \brief the document, all elements must be ended
+    std::string release();
+
+    /// \brief the elements without the final newline, to be added to another writer
+    std::string releaseFragment();
+
+    /// \brief append value to out with the entities pugixml uses for text or attributes
+    static void escape(std::string& out, std::string_view value, bool attribute);
+
+private:
+    /// \brief end the start tag if it is still open
+    void closeTag();
+
+    std::string buffer;
+    /// \brief names of the open elements, one after the other
+    std::string names;
+    std::vector<std::size_t> nameStarts;
+    bool tagOpen { false };
+    bool newline { false };
+};
+
+#endif // __XML_WRITER_H__
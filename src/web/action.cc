@@ -33,6 +33,8 @@
 
 #include "config/config_manager.h"
 #include "content/content_manager.h"
+#include "server.h"
+#include "util/profiler.h"
 
 web::action::action(std::shared_ptr<ContentManager> content)
     : WebRequestHandler(std::move(content))
@@ -49,5 +51,11 @@ void web::action::process()
         throw_std_runtime_error("No action given");
     log_debug("action: {}", action.c_str());
 
+    if (action == "profile") {
+        auto file = content->getContext()->getServer()->getProfiler()->start(intParam("seconds", 0));
+        auto root = xmlDoc->document_element();
+        root.append_child("profile").append_child(pugi::node_pcdata).set_value(file.c_str());
+    }
+
     log_debug("action: returning");
 }
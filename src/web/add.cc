@@ -60,7 +60,7 @@ void web::add::process()
     std::error_code ec;
     auto dirEnt = fs::directory_entry(path, ec);
     if (!ec) {
-        content->addFile(dirEnt, asSetting);
+        content->addFile(dirEnt, asSetting, true, TaskPriority::Interactive);
     } else {
         log_error("Failed to read {}: {}", path.c_str(), ec.message());
     }
@@ -29,11 +29,18 @@
 #include "content/content_manager.h"
 #include "context.h"
 #include "database/database.h"
+#include "database/query_profiler.h"
+#include "iohandler/stream_statistics.h"
+#include "transcoding/transcode_scheduler.h"
 #include "upnp_xml.h"
+#include "util/memory_accounting.h"
 #include "util/upnp_clients.h"
 
 #include <fmt/chrono.h>
 
+/// \brief fingerprints sent to the web UI
+#define MAX_PROFILED_QUERIES 50
+
 web::clients::clients(std::shared_ptr<ContentManager> content)
     : WebRequestHandler(std::move(content))
 {
@@ -70,4 +77,107 @@ void web::clients::process()
         item.append_attribute("matchType") = ClientConfig::mapMatchType(obj.pInfo->matchType).c_str();
         item.append_attribute("clientType") = ClientConfig::mapClientType(obj.pInfo->type).c_str();
     }
+
+    auto statistics = content->getContext()->getStreamStatistics();
+    if (statistics != nullptr && statistics->isEnabled())
+        appendStreams(&root, statistics);
+
+    auto scheduler = content->getTranscodeScheduler();
+    if (scheduler != nullptr)
+        appendTranscoding(&root, scheduler);
+
+    auto profiler = database->getQueryProfiler();
+    if (profiler != nullptr && profiler->isAggregating())
+        appendQueries(&root, profiler);
+
+    if (MemoryAccounting::getInstance().isEnabled())
+        appendMemory(&root);
+}
+
+void web::clients::appendStreams(pugi::xml_node* parent, const std::shared_ptr<StreamStatistics>& statistics)
+{
+    auto streams = parent->append_child("streams");
+    xml2JsonHints->setArrayName(streams, "stream");
+
+    for (auto&& snapshot : statistics->getSnapshot()) {
+        auto item = streams.append_child("stream");
+        item.append_attribute("id") = snapshot.id;
+        item.append_attribute("ip") = snapshot.client.c_str();
+        item.append_attribute("objectId") = snapshot.objectID;
+        item.append_attribute("location") = snapshot.location.c_str();
+        item.append_attribute("active") = snapshot.active;
+        item.append_attribute("seconds") = snapshot.seconds;
+        item.append_attribute("firstByteMs") = snapshot.firstByteMs;
+        item.append_attribute("bytes") = static_cast<unsigned long long>(snapshot.bytes);
+        item.append_attribute("bytesPerSecond") = snapshot.bytesPerSecond;
+        item.append_attribute("reads") = snapshot.reads;
+        item.append_attribute("seeks") = snapshot.seeks;
+        item.append_attribute("stalls") = snapshot.stalls;
+
+        // read count per latency bucket, named by the upper bound in microseconds
+        auto latency = item.append_child("latency");
+        for (std::size_t i = 0; i < snapshot.latency.size(); i++) {
+            auto name = i < StreamStatistics::LATENCY_BOUNDS.size() ? fmt::format("le{}us", StreamStatistics::LATENCY_BOUNDS.at(i)) : std::string("inf");
+            latency.append_attribute(name.c_str()) = snapshot.latency.at(i);
+        }
+    }
+}
+
+void web::clients::appendTranscoding(pugi::xml_node* parent, const std::shared_ptr<TranscodeScheduler>& scheduler)
+{
+    auto transcoding = parent->append_child("transcoding");
+    transcoding.append_attribute("running") = scheduler->getRunning();
+    transcoding.append_attribute("queued") = scheduler->getQueued();
+    transcoding.append_attribute("limit") = scheduler->getLimit();
+    xml2JsonHints->setArrayName(transcoding, "profile");
+
+    for (auto&& state : scheduler->getProfileStates()) {
+        auto item = transcoding.append_child("profile");
+        item.append_attribute("name") = state.name.c_str();
+        item.append_attribute("running") = state.running;
+        item.append_attribute("limit") = state.limit;
+        item.append_attribute("started") = state.started;
+        item.append_attribute("fallbacks") = state.fallbacks;
+        item.append_attribute("rejected") = state.rejected;
+        item.append_attribute("bytes") = static_cast<unsigned long long>(state.bytes);
+        item.append_attribute("seconds") = state.seconds;
+        item.append_attribute("bytesPerSecond") = state.seconds > 0 ? state.bytes / state.seconds : 0;
+        // media time per second of running, below 1 the profile is slower than real time
+        item.append_attribute("speed") = state.seconds > 0 ? state.mediaSeconds / state.seconds : 0;
+        item.append_attribute("stalls") = state.stalls;
+        item.append_attribute("restarts") = state.restarts;
+        item.append_attribute("failures") = state.failures;
+    }
+}
+
+void web::clients::appendQueries(pugi::xml_node* parent, const std::shared_ptr<QueryProfiler>& profiler)
+{
+    auto queries = parent->append_child("queries");
+    xml2JsonHints->setArrayName(queries, "query");
+
+    auto statistics = profiler->getStatistics();
+    if (statistics.size() > MAX_PROFILED_QUERIES)
+        statistics.resize(MAX_PROFILED_QUERIES);
+    for (auto&& stats : statistics) {
+        auto item = queries.append_child("query");
+        item.append_attribute("fingerprint") = stats.fingerprint.c_str();
+        item.append_attribute("count") = stats.count;
+        item.append_attribute("slow") = stats.slow;
+        item.append_attribute("rows") = stats.rows;
+        item.append_attribute("totalMs") = stats.totalMs;
+        item.append_attribute("averageMs") = stats.totalMs / stats.count;
+        item.append_attribute("maxMs") = stats.maxMs;
+    }
+}
+
+void web::clients::appendMemory(pugi::xml_node* parent)
+{
+    auto memory = parent->append_child("memory");
+    xml2JsonHints->setArrayName(memory, "subsystem");
+
+    for (auto&& [name, bytes] : MemoryAccounting::getInstance().getUsage()) {
+        auto item = memory.append_child("subsystem");
+        item.append_attribute("name") = name.c_str();
+        item.append_attribute("bytes") = static_cast<unsigned long long>(bytes);
+    }
 }
@@ -142,6 +142,10 @@ void web::configLoad::process()
         item = values.append_child("item");
         createItem(item, "/status/attribute::imageVirtual", CFG_MAX, CFG_MAX);
         setValue(item, database->getTotalFiles(true, "image"));
+
+        item = values.append_child("item");
+        createItem(item, "/status/attribute::maintenance", CFG_MAX, CFG_MAX);
+        setValue(item, database->getMaintenanceStatus());
     }
 
     for (int i = 0; i < int(CFG_MAX); i++) {
@@ -253,7 +257,7 @@ void web::configLoad::process()
 
         item = values.append_child("item");
         createItem(item, cs->getItemPath(pr, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_TYPE), cs->option, ATTR_TRANSCODING_PROFILES_PROFLE_TYPE);
-        setValue(item, std::string((entry->getType() == TR_External) ? "external" : "none"));
+        setValue(item, std::string((entry->getType() == TR_External) ? "external" : (entry->getType() == TR_Hls) ? "hls" : "none"));
 
         item = values.append_child("item");
         createItem(item, cs->getItemPath(pr, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_MIMETYPE), cs->option, ATTR_TRANSCODING_PROFILES_PROFLE_MIMETYPE);
@@ -291,6 +295,30 @@ void web::configLoad::process()
         createItem(item, cs->getItemPath(pr, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_ACCOGG), cs->option, ATTR_TRANSCODING_PROFILES_PROFLE_ACCOGG);
         setValue(item, entry->isTheora());
 
+        item = values.append_child("item");
+        createItem(item, cs->getItemPath(pr, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_MAXCONCURRENT), cs->option, ATTR_TRANSCODING_PROFILES_PROFLE_MAXCONCURRENT);
+        setValue(item, entry->getMaxConcurrent());
+
+        item = values.append_child("item");
+        createItem(item, cs->getItemPath(pr, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_FALLBACK), cs->option, ATTR_TRANSCODING_PROFILES_PROFLE_FALLBACK);
+        setValue(item, entry->getFallback());
+
+        item = values.append_child("item");
+        createItem(item, cs->getItemPath(pr, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_HARDWARE), cs->option, ATTR_TRANSCODING_PROFILES_PROFLE_HARDWARE);
+        setValue(item, entry->getHardware());
+
+        item = values.append_child("item");
+        createItem(item, cs->getItemPath(pr, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_PRETRANSCODE), cs->option, ATTR_TRANSCODING_PROFILES_PROFLE_PRETRANSCODE);
+        setValue(item, entry->isPretranscode());
+
+        item = values.append_child("item");
+        createItem(item, cs->getItemPath(pr, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_HLS, ATTR_TRANSCODING_PROFILES_PROFLE_HLS_BANDWIDTH), cs->option, ATTR_TRANSCODING_PROFILES_PROFLE_HLS_BANDWIDTH);
+        setValue(item, entry->getBandwidth());
+
+        item = values.append_child("item");
+        createItem(item, cs->getItemPath(pr, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_HLS, ATTR_TRANSCODING_PROFILES_PROFLE_HLS_VARIANTS), cs->option, ATTR_TRANSCODING_PROFILES_PROFLE_HLS_VARIANTS);
+        setValue(item, join(entry->getVariants(), ","));
+
         item = values.append_child("item");
         createItem(item, cs->getItemPath(pr, ATTR_TRANSCODING_PROFILES_PROFLE, ATTR_TRANSCODING_PROFILES_PROFLE_AGENT, ATTR_TRANSCODING_PROFILES_PROFLE_AGENT_COMMAND), cs->option, ATTR_TRANSCODING_PROFILES_PROFLE_AGENT_COMMAND);
         setValue(item, entry->getCommand());
@@ -157,7 +157,7 @@ void web::configSave::process()
             }
             int objectID = database->findObjectIDByPath(target);
             if (objectID > 0 && autoscan != nullptr) {
-                content->rescanDirectory(autoscan, objectID, target);
+                content->rescanDirectory(autoscan, objectID, target, true, TaskPriority::Interactive);
                 auto taskEl = root.append_child("task");
                 taskEl.append_attribute("text") = fmt::format("Rescanning directory {}", target).c_str();
                 log_info("Rescanning directory {}", target);
@@ -167,7 +167,7 @@ void web::configSave::process()
         } else {
             auto autoScans = content->getAutoscanDirectories();
             for (const auto& autoscan : autoScans) {
-                content->rescanDirectory(autoscan, autoscan->getObjectID());
+                content->rescanDirectory(autoscan, autoscan->getObjectID(), "", true, TaskPriority::Interactive);
                 log_info("Rescanning directory {}", autoscan->getLocation().c_str());
             }
         }
@@ -51,32 +51,29 @@ void web::containers::process()
     if (parentID == INVALID_OBJECT_ID)
         throw_std_runtime_error("no parent_id given");
 
-    auto root = xmlDoc->document_element();
-
-    auto containers = root.append_child("containers");
-    xml2JsonHints->setArrayName(containers, "container");
-    xml2JsonHints->setFieldType("title", "string");
-    containers.append_attribute("parent_id") = parentID;
-    containers.append_attribute("type") = "database";
+    json->startObject("containers");
+    json->addNumber("parent_id", parentID);
+    json->addString("type", "database");
     if (!param("select_it").empty())
-        containers.append_attribute("select_it") = param("select_it").c_str();
+        json->addString("select_it", param("select_it"));
 
-    auto param = std::make_unique<BrowseParam>(parentID, BROWSE_DIRECT_CHILDREN | BROWSE_CONTAINERS);
+    auto param = std::make_unique<BrowseParam>(parentID, BROWSE_DIRECT_CHILDREN | BROWSE_CONTAINERS | BROWSE_NO_METADATA | BROWSE_NO_AUXDATA);
     auto arr = database->browse(param);
+    json->startArray("container");
     for (const auto& obj : arr) {
         //if (obj->isContainer())
         //{
         auto cont = std::static_pointer_cast<CdsContainer>(obj);
-        auto ce = containers.append_child("container");
-        ce.append_attribute("id") = cont->getID();
+        json->startObject("container");
+        json->addNumber("id", cont->getID());
         int childCount = cont->getChildCount();
-        ce.append_attribute("child_count") = childCount;
+        json->addNumber("child_count", childCount);
         int autoscanType = cont->getAutoscanType();
-        ce.append_attribute("autoscan_type") = mapAutoscanType(autoscanType).c_str();
+        json->addString("autoscan_type", mapAutoscanType(autoscanType));
 
         std::string url;
         if (UpnpXMLBuilder::renderContainerImage(server->getVirtualUrl(), cont, url)) {
-            ce.append_attribute("image") = url.c_str();
+            json->addString("image", url);
         }
 
         std::string autoscanMode = "none";
@@ -90,8 +87,11 @@ void web::containers::process()
             }
 #endif
         }
-        ce.append_attribute("autoscan_mode") = autoscanMode.c_str();
-        ce.append_attribute("title") = cont->getTitle().c_str();
+        json->addString("autoscan_mode", autoscanMode);
+        json->addString("title", cont->getTitle());
+        json->end();
         //}
     }
+    json->end();
+    json->end();
 }
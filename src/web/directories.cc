@@ -35,16 +35,15 @@
 #include "util/string_converter.h"
 #include "util/tools.h"
 
+/// \brief subdirectories are only opened to check for content in smaller listings,
+/// on network filesystems each check is a round trip
+#define MAX_CHILD_CHECKS 200
+
 web::directories::directories(std::shared_ptr<ContentManager> content)
     : WebRequestHandler(std::move(content))
 {
 }
 
-using dirInfo = struct {
-    fs::path filename;
-    bool hasContent;
-};
-
 void web::directories::process()
 {
     check_request();
@@ -52,15 +51,15 @@ void web::directories::process()
     std::string parentID = param("parent_id");
     auto path = fs::path { (parentID.empty() || parentID == "0") ? FS_ROOT_DIRECTORY : hexDecodeString(parentID) };
 
-    auto root = xmlDoc->document_element();
-
-    auto containers = root.append_child("containers");
-    xml2JsonHints->setArrayName(containers, "container");
-    xml2JsonHints->setFieldType("title", "string");
-    containers.append_attribute("parent_id") = parentID.c_str();
+    json->startObject("containers");
+    // the UI looks for the numeric root
+    if (parentID == "0")
+        json->addNumber("parent_id", 0);
+    else
+        json->addString("parent_id", parentID);
     if (!param("select_it").empty())
-        containers.append_attribute("select_it") = param("select_it").c_str();
-    containers.append_attribute("type") = "filesystem";
+        json->addString("select_it", param("select_it"));
+    json->addString("type", "filesystem");
 
     // don't bother users with system directorties
     const auto& excludes_fullpath = config->getArrayOption(CFG_IMPORT_SYSTEM_DIRECTORIES);
@@ -71,33 +70,27 @@ void web::directories::process()
     bool exclude_config_dirs = true;
 
     std::error_code ec;
-    std::map<std::string, dirInfo> filesMap;
+    auto names = listDirectory(path, true, !exclude_config_dirs, ec);
+    // larger directories show all children as expandable, expanding an empty one shows nothing
+    bool checkChildren = names.size() <= MAX_CHILD_CHECKS;
 
-    for (const auto& it : fs::directory_iterator(path, ec)) {
-        const fs::path& filepath = it.path();
-
-        if (!it.is_directory(ec))
-            continue;
+    auto f2i = StringConverter::f2i(config);
+    json->startArray("container");
+    for (const auto& name : names) {
+        auto filepath = path / name;
         if (std::count(excludes_fullpath.begin(), excludes_fullpath.end(), filepath))
             continue;
-        if (std::count(excludes_dirname.begin(), excludes_dirname.end(), filepath.filename())
-            || (exclude_config_dirs && startswith(filepath.filename(), ".")))
+        if (std::count(excludes_dirname.begin(), excludes_dirname.end(), name))
             continue;
 
-        const auto& dir = fs::directory_iterator(filepath, ec);
-        bool hasContent = std::any_of(fs::begin(dir), fs::end(dir), [&](const auto& sub) { return sub.is_directory(ec) || isRegularFile(sub, ec); });
-
+        json->startObject("container");
         /// \todo replace hexEncode with base64_encode?
-        std::string id = hexEncode(filepath.c_str(), filepath.string().length());
-        filesMap[id] = { filepath.filename(), hasContent };
-    }
-
-    auto f2i = StringConverter::f2i(config);
-    for (const auto& [key, val] : filesMap) {
-        auto ce = containers.append_child("container");
-        ce.append_attribute("id") = key.c_str();
-        ce.append_attribute("child_count") = val.hasContent;
+        json->addString("id", hexEncode(filepath.c_str(), filepath.string().length()));
+        json->addBool("child_count", !checkChildren || hasDirectoryEntries(filepath));
 
-        ce.append_attribute("title") = f2i->convert(val.filename).c_str();
+        json->addString("title", f2i->convert(name));
+        json->end();
     }
+    json->end();
+    json->end();
 }
@@ -46,36 +46,41 @@ void web::files::process()
 
     std::string parentID = param("parent_id");
     std::string path = (parentID == "0") ? FS_ROOT_DIRECTORY : hexDecodeString(parentID);
+    int start = intParam("start");
+    int count = intParam("count");
+    if (start < 0)
+        throw_std_runtime_error("illegal start parameter");
+    if (count < 0)
+        throw_std_runtime_error("illegal count parameter");
 
-    auto root = xmlDoc->document_element();
-
-    auto files = root.append_child("files");
-    xml2JsonHints->setArrayName(files, "file");
-    xml2JsonHints->setFieldType("filename", "string");
-    files.append_attribute("parent_id") = parentID.c_str();
-    files.append_attribute("location") = path.c_str();
+    json->startObject("files");
+    // the UI looks for the numeric root
+    if (parentID == "0")
+        json->addNumber("parent_id", 0);
+    else
+        json->addString("parent_id", parentID);
+    json->addString("location", path);
 
     bool exclude_config_files = true;
 
     std::error_code ec;
-    std::map<std::string, std::string> filesMap;
-
-    for (const auto& it : fs::directory_iterator(path, ec)) {
-        const fs::path& filepath = it.path();
+    auto names = listDirectory(path, false, !exclude_config_files, ec);
+    json->addNumber("start", start);
+    json->addNumber("total_matches", names.size());
 
-        if (!isRegularFile(it, ec))
-            continue;
-        if (exclude_config_files && startswith(filepath.filename(), "."))
-            continue;
-
-        std::string id = hexEncode(filepath.c_str(), filepath.string().length());
-        filesMap[id] = { filepath.filename().native() };
-    }
+    // only the page is encoded and converted, count 0 returns all files
+    auto first = std::min<std::size_t>(start, names.size());
+    auto last = count > 0 ? std::min<std::size_t>(first + count, names.size()) : names.size();
 
     auto f2i = StringConverter::f2i(config);
-    for (const auto& [key, val] : filesMap) {
-        auto fe = files.append_child("file");
-        fe.append_attribute("id") = key.c_str();
-        fe.append_attribute("filename") = f2i->convert(val).c_str();
+    json->startArray("file");
+    for (auto i = first; i < last; i++) {
+        auto filepath = fs::path(path) / names[i];
+        json->startObject("file");
+        json->addString("id", hexEncode(filepath.c_str(), filepath.string().length()));
+        json->addString("filename", f2i->convert(names[i]));
+        json->end();
     }
+    json->end();
+    json->end();
 }
@@ -54,26 +54,25 @@ void web::items::process()
     if (count < 0)
         throw_std_runtime_error("illegal count parameter");
 
-    auto root = xmlDoc->document_element();
+    // the scrolling list only shows titles and links, it does not need the resources for the images
+    bool basic = param("fields") == "basic";
 
-    auto items = root.append_child("items");
-    xml2JsonHints->setArrayName(items, "item");
-    xml2JsonHints->setFieldType("title", "string");
-    items.append_attribute("parent_id") = parentID;
+    json->startObject("items");
+    json->addNumber("parent_id", parentID);
 
     auto container = database->loadObject(parentID);
-    auto param = std::make_unique<BrowseParam>(parentID, BROWSE_DIRECT_CHILDREN | BROWSE_ITEMS);
+    auto param = std::make_unique<BrowseParam>(parentID, BROWSE_DIRECT_CHILDREN | BROWSE_ITEMS | (basic ? BROWSE_BASIC_PROPERTIES : BROWSE_NO_METADATA | BROWSE_NO_AUXDATA));
     param->setRange(start, count);
 
     if ((container->getClass() == UPNP_CLASS_MUSIC_ALBUM) || (container->getClass() == UPNP_CLASS_PLAYLIST_CONTAINER))
         param->setFlag(BROWSE_TRACK_SORT);
 
     auto arr = database->browse(param);
-    items.append_attribute("virtual") = container->isVirtual();
+    json->addBool("virtual", container->isVirtual());
 
-    items.append_attribute("start") = start;
-    //items.append_attribute("returned") = arr->size();
-    items.append_attribute("total_matches") = param->getTotalMatches();
+    json->addNumber("start", start);
+    //json->addNumber("returned", arr.size());
+    json->addNumber("total_matches", param->getTotalMatches());
 
     bool protectContainer = false;
     bool protectItems = false;
@@ -116,29 +115,32 @@ void web::items::process()
         }
     }
 #endif
-    items.append_attribute("autoscan_mode") = autoscanMode.c_str();
-    items.append_attribute("autoscan_type") = mapAutoscanType(autoscanType).c_str();
-    items.append_attribute("protect_container") = protectContainer;
-    items.append_attribute("protect_items") = protectItems;
+    json->addString("autoscan_mode", autoscanMode);
+    json->addString("autoscan_type", mapAutoscanType(autoscanType));
+    json->addBool("protect_container", protectContainer);
+    json->addBool("protect_items", protectItems);
 
+    json->startArray("item");
     for (const auto& arrayObj : arr) {
         //if (arrayObj->isItem())
         //{
-        auto item = items.append_child("item");
-        item.append_attribute("id") = arrayObj->getID();
-        item.append_child("title").append_child(pugi::node_pcdata).set_value(arrayObj->getTitle().c_str());
+        json->startObject("item");
+        json->addNumber("id", arrayObj->getID());
+        json->addString("title", arrayObj->getTitle());
         /// \todo clean this up, should have more generic options for online
         /// services
         // FIXME
         auto objItem = std::static_pointer_cast<CdsItem>(arrayObj);
-        std::string res = UpnpXMLBuilder::getFirstResourcePath(objItem);
-        item.append_child("res").append_child(pugi::node_pcdata).set_value(res.c_str());
+        json->addString("res", UpnpXMLBuilder::getFirstResourcePath(objItem));
 
         std::string url;
-        if (UpnpXMLBuilder::renderItemImage(server->getVirtualUrl(), objItem, url)) {
-            item.append_child("image").append_child(pugi::node_pcdata).set_value(url.c_str());
+        if (!basic && UpnpXMLBuilder::renderItemImage(server->getVirtualUrl(), objItem, url)) {
+            json->addString("image", url);
         }
-        //item.append_attribute("virtual") = arrayObj->isVirtual();
+        //json->addBool("virtual", arrayObj->isVirtual());
+        json->end();
         //}
     }
+    json->end();
+    json->end();
 }
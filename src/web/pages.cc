@@ -61,6 +61,8 @@ std::unique_ptr<WebRequestHandler> createWebRequestHandler(
         return std::make_unique<web::autoscan>(content);
     if (page == "void")
         return std::make_unique<web::voidType>(content);
+    if (page == "update_stream")
+        return std::make_unique<web::updateStream>(content);
     if (page == "tasks")
         return std::make_unique<web::tasks>(content);
     if (page == "action")
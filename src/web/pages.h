@@ -41,6 +41,9 @@
 // forward declaration
 class Config;
 class Database;
+class QueryProfiler;
+class StreamStatistics;
+class TranscodeScheduler;
 
 namespace web {
 
@@ -145,11 +148,27 @@ public:
     void process() override;
 };
 
+/// \brief server-sent events with the containers that changed
+class updateStream : public WebRequestHandler {
+public:
+    explicit updateStream(std::shared_ptr<ContentManager> content);
+    void process() override;
+
+protected:
+    std::string getMimeType() const override;
+    std::unique_ptr<IOHandler> open(enum UpnpOpenFileMode mode) override;
+    bool canCompress() const override { return false; }
+};
+
 /// \brief task list and task cancel
 class tasks : public WebRequestHandler {
 public:
     explicit tasks(std::shared_ptr<ContentManager> content);
     void process() override;
+
+protected:
+    /// \brief import stage timings, files per second and queue lengths
+    void appendStatistics(pugi::xml_node* parent);
 };
 
 /// \brief UI action button
@@ -171,6 +190,16 @@ class clients : public WebRequestHandler {
 public:
     explicit clients(std::shared_ptr<ContentManager> content);
     void process() override;
+
+protected:
+    /// \brief throughput, latency and stalls of active and recently finished streams
+    void appendStreams(pugi::xml_node* parent, const std::shared_ptr<StreamStatistics>& statistics);
+    /// \brief running and queued transcoders and the slots of each profile
+    void appendTranscoding(pugi::xml_node* parent, const std::shared_ptr<TranscodeScheduler>& scheduler);
+    /// \brief queries that took the most time in total
+    void appendQueries(pugi::xml_node* parent, const std::shared_ptr<QueryProfiler>& profiler);
+    /// \brief estimated memory of the subsystems
+    void appendMemory(pugi::xml_node* parent);
 };
 
 /// \brief load configuration
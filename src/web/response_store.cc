@@ -0,0 +1,85 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    response_store.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file response_store.cc
+
+#include "response_store.h" // API
+
+#include "util/memory_accounting.h"
+
+namespace web {
+
+ResponseStore::ResponseStore(std::chrono::seconds ttl, std::size_t capacity)
+    : ttl(ttl)
+    , capacity(capacity)
+{
+}
+
+const void* ResponseStore::put(std::string body)
+{
+    AutoLock lock(mutex);
+    auto now = Clock::now();
+    expire(now);
+    while (!entries.empty() && entries.size() >= capacity)
+        entries.erase(entries.begin());
+
+    auto token = nextToken++;
+    entries[token] = Entry { std::move(body), now + ttl };
+    return reinterpret_cast<const void*>(token);
+}
+
+bool ResponseStore::take(const void* token, std::string& body)
+{
+    AutoLock lock(mutex);
+    expire(Clock::now());
+    auto entry = entries.find(reinterpret_cast<std::uintptr_t>(token));
+    if (entry == entries.end())
+        return false;
+    body = std::move(entry->second.body);
+    entries.erase(entry);
+    return true;
+}
+
+void ResponseStore::expire(Clock::time_point now)
+{
+    // all entries share the ttl, so they expire in token order
+    while (!entries.empty() && entries.begin()->second.expires <= now)
+        entries.erase(entries.begin());
+}
+
+std::size_t ResponseStore::size()
+{
+    AutoLock lock(mutex);
+    return entries.size();
+}
+
+std::size_t ResponseStore::getMemoryUsage()
+{
+    AutoLock lock(mutex);
+    std::size_t bytes = 0;
+    for (auto&& [token, entry] : entries)
+        bytes += MemoryAccounting::TREE_NODE + sizeof(decltype(entries)::value_type) + MemoryAccounting::estimate(entry.body);
+    return bytes;
+}
+
+} // namespace web
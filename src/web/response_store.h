@@ -0,0 +1,77 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    response_store.h - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file response_store.h
+#ifndef __WEB_RESPONSE_STORE_H__
+#define __WEB_RESPONSE_STORE_H__
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace web {
+
+/// \brief Keeps UI responses rendered in getInfo until open of the same request
+///
+/// The size of a response is only known after the page ran, but libupnp sends the headers
+/// after getInfo. The body is kept here and the token is passed to open as upnp request cookie.
+/// Responses of requests that never open, like HEAD, expire.
+class ResponseStore {
+public:
+    ResponseStore(std::chrono::seconds ttl, std::size_t capacity);
+
+    /// \brief remember body and return the token for open
+    const void* put(std::string body);
+
+    /// \brief remove the body stored with token, false if it expired
+    bool take(const void* token, std::string& body);
+
+    std::size_t size();
+    /// \brief bytes of the stored bodies
+    std::size_t getMemoryUsage();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string body;
+        Clock::time_point expires;
+    };
+
+    void expire(Clock::time_point now);
+
+    std::chrono::seconds ttl;
+    std::size_t capacity;
+    /// \brief tokens are handed out in ascending order, so the first entry is the oldest
+    std::uintptr_t nextToken { 1 };
+    std::map<std::uintptr_t, Entry> entries;
+    std::mutex mutex;
+
+    using AutoLock = std::lock_guard<std::mutex>;
+};
+
+} // namespace web
+
+#endif // __WEB_RESPONSE_STORE_H__
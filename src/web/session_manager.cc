@@ -35,21 +35,20 @@
 #include <unordered_set>
 
 #include "config/config_manager.h"
+#include "util/metrics.h"
 #include "util/timer.h"
 #include "util/tools.h"
 
-#define UI_UPDATE_ID_HASH_SIZE 61
 #define MAX_UI_UPDATE_IDS 10
 
 namespace web {
 
 Session::Session(std::chrono::seconds timeout)
-    : uiUpdateIDs(std::make_shared<std::unordered_set<int>>())
 {
     this->timeout = timeout;
     loggedIn = false;
-    //(new DBRHash<int>(UI_UPDATE_ID_HASH_SIZE, MAX_UI_UPDATE_IDS + 5, INVALID_OBJECT_ID, INVALID_OBJECT_ID_2));
-    updateAll = false;
+    for (auto&& slot : uiUpdateRing)
+        slot = INVALID_OBJECT_ID;
     access();
 }
 
@@ -67,77 +66,129 @@ std::string Session::get(const std::string& key)
 
 void Session::containerChangedUI(int objectID)
 {
-    if (objectID == INVALID_OBJECT_ID)
+    if (objectID == INVALID_OBJECT_ID || updateAll)
         return;
-    if (!updateAll) {
-        AutoLockR lock(rmutex);
-        if (!updateAll) {
-            if (uiUpdateIDs->size() >= MAX_UI_UPDATE_IDS) {
-                updateAll = true;
-                uiUpdateIDs->clear();
-            } else
-                uiUpdateIDs->insert(objectID);
-        }
-    }
-}
 
-void Session::containerChangedUI(const std::vector<int>& objectIDs)
-{
-    if (updateAll)
+    auto subscribed = std::atomic_load(&subscriptions);
+    if (subscribed && subscribed->find(objectID) == subscribed->end())
         return;
 
-    size_t arSize = objectIDs.size();
-    AutoLockR lock(rmutex);
-
-    if (updateAll)
+    // imports change the same container over and over
+    if (lastUpdateID.exchange(objectID) == objectID && hasUIUpdateIDs())
         return;
 
-    if (uiUpdateIDs->size() + arSize >= MAX_UI_UPDATE_IDS) {
+    auto pos = ringWrite.fetch_add(1);
+    if (pos - ringRead.load() >= uiUpdateRing.size())
         updateAll = true;
-        uiUpdateIDs->clear();
-        return;
-    }
+    else
+        uiUpdateRing[pos % uiUpdateRing.size()] = objectID;
+    notifyWaiters();
+}
+
+void Session::containerChangedUI(const std::vector<int>& objectIDs)
+{
     for (int objectId : objectIDs) {
-        uiUpdateIDs->insert(objectId);
+        containerChangedUI(objectId);
     }
 }
 
+void Session::skipUpdateIDs()
+{
+    auto end = ringWrite.load();
+    for (auto pos = ringRead.load(); pos != end; pos++)
+        uiUpdateRing[pos % uiUpdateRing.size()] = INVALID_OBJECT_ID;
+    ringRead = end;
+}
+
 std::string Session::getUIUpdateIDs()
 {
     if (!hasUIUpdateIDs())
         return "";
-    AutoLockR lock(rmutex);
-    if (updateAll) {
-        updateAll = false;
+    AutoLock lock(readMutex);
+    if (updateAll.exchange(false)) {
+        skipUpdateIDs();
         return "all";
     }
-    std::string ret = toCSV(uiUpdateIDs);
-    if (!ret.empty())
-        uiUpdateIDs->clear();
-    return ret;
+
+    auto ids = std::make_shared<std::unordered_set<int>>();
+    auto end = ringWrite.load();
+    auto pos = ringRead.load();
+    for (; pos != end; pos++) {
+        int objectID = uiUpdateRing[pos % uiUpdateRing.size()].exchange(INVALID_OBJECT_ID);
+        if (objectID == INVALID_OBJECT_ID)
+            break; // reserved, but not stored yet, comes with the next call
+        ids->insert(objectID);
+    }
+    ringRead = pos;
+
+    if (ids->size() > MAX_UI_UPDATE_IDS)
+        return "all";
+    return toCSV(ids);
 }
 
 bool Session::hasUIUpdateIDs() const
 {
-    if (updateAll)
-        return true;
-    // AutoLock lock(mutex); only accessing an int - shouldn't be necessary
-    return (!uiUpdateIDs->empty());
+    return updateAll || ringRead.load() != ringWrite.load();
+}
+
+void Session::subscribe(std::unordered_set<int> objectIDs)
+{
+    std::shared_ptr<const std::unordered_set<int>> subscribed;
+    if (!objectIDs.empty())
+        subscribed = std::make_shared<const std::unordered_set<int>>(std::move(objectIDs));
+    std::atomic_store(&subscriptions, subscribed);
+}
+
+void Session::notifyWaiters()
+{
+    if (waiting > 0) {
+        AutoLock lock(waitMutex);
+        updateCondition.notify_all();
+    }
+}
+
+bool Session::waitForUIUpdateIDs(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(waitMutex);
+    waiting++;
+    bool result = updateCondition.wait_for(lock, timeout, [this] { return hasUIUpdateIDs(); });
+    waiting--;
+    return result;
 }
 
 void Session::clearUpdateIDs()
 {
     log_debug("clearing UI updateIDs");
-    AutoLockR lock(rmutex);
-    uiUpdateIDs->clear();
+    AutoLock lock(readMutex);
+    skipUpdateIDs();
     updateAll = false;
 }
 
 SessionManager::SessionManager(const std::shared_ptr<Config>& config, std::shared_ptr<Timer> timer)
+    : sessions(std::make_shared<const SessionMap>())
+    , responses(std::chrono::seconds(WEB_RESPONSE_STORE_TTL), WEB_RESPONSE_STORE_SIZE)
 {
     this->timer = std::move(timer);
     accounts = config->getDictionaryOption(CFG_SERVER_UI_ACCOUNT_LIST);
     timerAdded = false;
+    memory = MemoryAccounting::getInstance().add("web-sessions", [this] { return getMemoryUsage(); });
+}
+
+std::size_t SessionManager::getMemoryUsage()
+{
+    auto current = std::atomic_load(&sessions);
+    std::size_t bytes = responses.getMemoryUsage();
+    for (auto&& [sessionID, session] : *current) {
+        bytes += MemoryAccounting::HASH_NODE + sizeof(SessionMap::value_type) + MemoryAccounting::estimate(sessionID) + sizeof(Session);
+        {
+            Session::AutoLockR lock(session->rmutex);
+            bytes += MemoryAccounting::estimate(session->dict);
+        }
+        auto subscribed = std::atomic_load(&session->subscriptions);
+        if (subscribed != nullptr)
+            bytes += subscribed->size() * (MemoryAccounting::HASH_NODE + sizeof(int)) + subscribed->bucket_count() * sizeof(void*);
+    }
+    return bytes;
 }
 
 std::shared_ptr<Session> SessionManager::createSession(std::chrono::seconds timeout)
@@ -145,48 +196,42 @@ std::shared_ptr<Session> SessionManager::createSession(std::chrono::seconds time
     auto newSession = std::make_shared<Session>(timeout);
     AutoLock lock(mutex);
 
+    auto current = std::atomic_load(&sessions);
     int count = 0;
     std::string sessionID;
     do {
         sessionID = generateRandomId();
         if (count++ > 100)
             throw_std_runtime_error("There seems to be something wrong with the random numbers. I tried to get a unique id 100 times and failed. last sessionID: {}", sessionID);
-    } while (getSession(sessionID, false) != nullptr); // for the rare case, where we get a random id, that is already taken
+    } while (current->find(sessionID) != current->end()); // for the rare case, where we get a random id, that is already taken
 
     newSession->setID(sessionID);
-    sessions.push_back(newSession);
+    auto changed = std::make_shared<SessionMap>(*current);
+    changed->emplace(sessionID, newSession);
+    std::atomic_store(&sessions, std::shared_ptr<const SessionMap>(std::move(changed)));
     checkTimer();
     return newSession;
 }
 
-std::shared_ptr<Session> SessionManager::getSession(const std::string& sessionID, bool doLock)
+std::shared_ptr<Session> SessionManager::getSession(const std::string& sessionID) const
 {
-    if (sessions.empty()) {
-        return nullptr;
-    }
-
-    std::unique_lock lock(mutex, std::defer_lock);
-    if (doLock)
-        lock.lock();
-
-    auto it = std::find_if(sessions.begin(), sessions.end(), [&](const auto& s) { return s->getID() == sessionID; });
-    return it != sessions.end() ? *it : nullptr;
+    auto current = std::atomic_load(&sessions);
+    auto it = current->find(sessionID);
+    return it != current->end() ? it->second : nullptr;
 }
 
 void SessionManager::removeSession(const std::string& sessionID)
 {
-    if (sessions.empty()) {
-        return;
-    }
-
     AutoLock lock(mutex);
 
-    auto sess = std::find_if(sessions.begin(), sessions.end(), [&](const auto& s) { return s->getID() == sessionID; });
-    if (sess != sessions.end()) {
-        sess = sessions.erase(sess);
-        checkTimer();
+    auto current = std::atomic_load(&sessions);
+    if (current->find(sessionID) == current->end())
         return;
-    }
+
+    auto changed = std::make_shared<SessionMap>(*current);
+    changed->erase(sessionID);
+    std::atomic_store(&sessions, std::shared_ptr<const SessionMap>(std::move(changed)));
+    checkTimer();
 }
 
 std::string SessionManager::getUserPassword(const std::string& user)
@@ -196,10 +241,8 @@ std::string SessionManager::getUserPassword(const std::string& user)
 
 void SessionManager::containerChangedUI(int objectID)
 {
-    if (sessions.empty())
-        return;
-    AutoLock lock(mutex);
-    for (const auto& session : sessions) {
+    auto current = std::atomic_load(&sessions);
+    for (const auto& [sessionID, session] : *current) {
         if (session->isLoggedIn())
             session->containerChangedUI(objectID);
     }
@@ -207,10 +250,8 @@ void SessionManager::containerChangedUI(int objectID)
 
 void SessionManager::containerChangedUI(const std::vector<int>& objectIDs)
 {
-    if (sessions.empty())
-        return;
-    AutoLock lock(mutex);
-    for (const auto& session : sessions) {
+    auto current = std::atomic_load(&sessions);
+    for (const auto& [sessionID, session] : *current) {
         if (session->isLoggedIn())
             session->containerChangedUI(objectIDs);
     }
@@ -218,10 +259,15 @@ void SessionManager::containerChangedUI(const std::vector<int>& objectIDs)
 
 void SessionManager::checkTimer()
 {
-    if (!sessions.empty() && !timerAdded) {
+    static auto& sessionCount = Metrics::getInstance().gauge("gerbera_sessions", "Open sessions", Metrics::label("type", "ui"));
+    auto current = std::atomic_load(&sessions);
+    sessionCount.set(current->size());
+
+    bool empty = current->empty();
+    if (!empty && !timerAdded) {
         timer->addTimerSubscriber(this, SESSION_TIMEOUT_CHECK_INTERVAL);
         timerAdded = true;
-    } else if (sessions.empty() && timerAdded) {
+    } else if (empty && timerAdded) {
         timer->removeTimerSubscriber(this);
         timerAdded = false;
     }
@@ -229,22 +275,24 @@ void SessionManager::checkTimer()
 
 void SessionManager::timerNotify(std::shared_ptr<Timer::Parameter> parameter)
 {
-    log_debug("notified... {} web sessions.", sessions.size());
-
     AutoLock lock(mutex);
 
+    auto current = std::atomic_load(&sessions);
+    log_debug("notified... {} web sessions.", current->size());
+
     struct timespec now;
     getTimespecNow(&now);
 
-    for (auto it = sessions.begin(); it != sessions.end(); /*++it*/) {
-        const auto& session = *it;
-
+    auto changed = std::make_shared<SessionMap>();
+    for (const auto& [sessionID, session] : *current) {
         if (getDeltaMillis(session->getLastAccessTime(), &now) > 1000 * session->getTimeout().count()) {
-            log_debug("session timeout: {} - diff: {}", session->getID().c_str(), getDeltaMillis(session->getLastAccessTime(), &now));
-            it = sessions.erase(it);
-            checkTimer();
+            log_debug("session timeout: {} - diff: {}", sessionID.c_str(), getDeltaMillis(session->getLastAccessTime(), &now));
         } else
-            ++it;
+            changed->emplace(sessionID, session);
+    }
+    if (changed->size() != current->size()) {
+        std::atomic_store(&sessions, std::shared_ptr<const SessionMap>(std::move(changed)));
+        checkTimer();
     }
 }
 
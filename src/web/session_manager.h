@@ -32,11 +32,17 @@
 #ifndef __SESSION_MANAGER_H__
 #define __SESSION_MANAGER_H__
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "util/memory_accounting.h"
 #include "util/timer.h"
+#include "web/response_store.h"
 
 // forward declaration
 class Config;
@@ -91,6 +97,14 @@ public:
 
     void clearUpdateIDs();
 
+    /// \brief Only collect changes of these containers, all changes are collected while the set is empty.
+    /// \param objectIDs the containers shown in the tree of the UI
+    void subscribe(std::unordered_set<int> objectIDs);
+
+    /// \brief Waits until update ids are collected for the session.
+    /// \return false if nothing changed before the timeout
+    bool waitForUIUpdateIDs(std::chrono::milliseconds timeout);
+
 protected:
     /// \brief Is called by SessionManager if UI update is needed
     /// \param objectID the container that needs to be updated
@@ -98,15 +112,39 @@ protected:
 
     void containerChangedUI(const std::vector<int>& objectIDs);
 
+    /// \brief drop the update ids written so far, readMutex must be held
+    void skipUpdateIDs();
+
+    void notifyWaiters();
+
     std::recursive_mutex rmutex;
     using AutoLockR = std::lock_guard<decltype(rmutex)>;
     std::map<std::string, std::string> dict;
 
-    /// \brief True if the ui update id hash became to big and
+    /// \brief True if the ui update ring overflowed and
     /// the UI shall update every container
-    bool updateAll;
+    std::atomic<bool> updateAll { false };
+
+    /// \brief changed containers, written without locking by the import threads
+    ///
+    /// A writer reserves a slot by incrementing ringWrite and then stores the id,
+    /// the reader stops at slots that are reserved but not stored yet.
+    std::array<std::atomic<int>, 64> uiUpdateRing;
+    std::atomic<std::size_t> ringWrite { 0 };
+    std::atomic<std::size_t> ringRead { 0 };
+    std::atomic<int> lastUpdateID { INVALID_OBJECT_ID };
 
-    std::shared_ptr<std::unordered_set<int>> uiUpdateIDs;
+    /// \brief serializes the readers of the ring
+    std::mutex readMutex;
+    using AutoLock = std::lock_guard<std::mutex>;
+
+    /// \brief containers the UI shows, nullptr for all
+    std::shared_ptr<const std::unordered_set<int>> subscriptions;
+
+    /// \brief wakes the update stream of the session, only taken by writers if a stream waits
+    std::mutex waitMutex;
+    std::condition_variable updateCondition;
+    std::atomic<int> waiting { 0 };
 
     /// \brief maximum time the session can be idle (starting from last_access)
     std::chrono::seconds timeout;
@@ -117,7 +155,7 @@ protected:
     /// \brief arbitrary but unique string representing the ID of the session (returned by getID())
     std::string sessionID;
 
-    bool loggedIn;
+    std::atomic<bool> loggedIn { false };
 
     friend class SessionManager;
 };
@@ -127,17 +165,25 @@ class SessionManager : public Timer::Subscriber {
 protected:
     std::shared_ptr<Timer> timer;
 
+    /// \brief serializes changes of the session table
     std::mutex mutex;
     using AutoLock = std::lock_guard<decltype(mutex)>;
 
-    /// \brief This array is holding available sessions.
-    std::vector<std::shared_ptr<Session>> sessions;
+    using SessionMap = std::unordered_map<std::string, std::shared_ptr<Session>>;
+    /// \brief Available sessions by id, copied on every change so requests look up sessions without locking.
+    std::shared_ptr<const SessionMap> sessions;
 
     std::map<std::string, std::string> accounts;
 
     void checkTimer();
     bool timerAdded;
 
+    ResponseStore responses;
+
+    /// \brief estimate of the sessions with their values, update rings, subscriptions and the stored responses
+    std::size_t getMemoryUsage();
+    std::unique_ptr<MemoryAccounting::Registration> memory;
+
 public:
     /// \brief Constructor, initializes the array.
     SessionManager(const std::shared_ptr<Config>& config, std::shared_ptr<Timer> timer);
@@ -150,7 +196,7 @@ public:
     /// \brief Returns the instance to a Session with a given sessionID
     /// \param ID of the Session.
     /// \return instance of the Session with a given ID or nullptr if no session with that ID was found.
-    std::shared_ptr<Session> getSession(const std::string& sessionID, bool doLock = true);
+    std::shared_ptr<Session> getSession(const std::string& sessionID) const;
 
     /// \brief Removes a session
     void removeSession(const std::string& sessionID);
@@ -165,6 +211,9 @@ public:
 
     void containerChangedUI(const std::vector<int>& objectIDs);
 
+    /// \brief UI responses rendered in getInfo and sent by open
+    ResponseStore& getResponseStore() { return responses; }
+
     void timerNotify([[maybe_unused]] std::shared_ptr<Timer::Parameter> parameter) override;
 };
 
@@ -32,6 +32,7 @@
 #include "pages.h" // API
 
 #include "content/content_manager.h"
+#include "content/import_statistics.h"
 
 web::tasks::tasks(std::shared_ptr<ContentManager> content)
     : WebRequestHandler(std::move(content))
@@ -54,9 +55,54 @@ void web::tasks::process()
         for (const auto& task : taskList) {
             appendTask(task, &tasksEl);
         }
+
+        // what each task thread is working on, idle threads have no task
+        auto workersEl = root.append_child("workers");
+        xml2JsonHints->setArrayName(workersEl, "worker");
+        auto workerTasks = content->getWorkerTasks();
+        for (std::size_t i = 0; i < workerTasks.size(); i++) {
+            auto workerEl = workersEl.append_child("worker");
+            workerEl.append_attribute("id") = i;
+            workerEl.append_attribute("busy") = workerTasks[i] != nullptr;
+            appendTask(workerTasks[i], &workerEl);
+        }
+
+        auto statistics = content->getContext()->getImportStatistics();
+        if (statistics != nullptr && statistics->isEnabled())
+            appendStatistics(&root);
+    } else if (action == "statistics") {
+        appendStatistics(&root);
     } else if (action == "cancel") {
         int taskID = intParam("task_id");
         content->invalidateTask(taskID);
+    } else if (action == "relayout") {
+        // loads the changed script and builds the virtual containers again
+        content->rebuildLayout();
     } else
         throw_std_runtime_error("called with illegal action");
 }
+
+void web::tasks::appendStatistics(pugi::xml_node* parent)
+{
+    auto statistics = content->getContext()->getImportStatistics();
+    auto statsEl = parent->append_child("statistics");
+    statsEl.append_attribute("enabled") = statistics != nullptr && statistics->isEnabled();
+    statsEl.append_attribute("tasks") = content->getTasklist().size();
+    statsEl.append_attribute("import-queue") = content->getImportQueueLength();
+    if (statistics == nullptr)
+        return;
+
+    auto snapshot = statistics->getSnapshot();
+    statsEl.append_attribute("files") = snapshot.files;
+    statsEl.append_attribute("files-per-second") = snapshot.filesPerSecond;
+
+    auto stagesEl = statsEl.append_child("stages");
+    xml2JsonHints->setArrayName(stagesEl, "stage");
+    for (std::size_t i = 0; i < snapshot.stages.size(); i++) {
+        const auto& stage = snapshot.stages.at(i);
+        auto stageEl = stagesEl.append_child("stage");
+        stageEl.append_attribute("name") = ImportStatistics::getStageName(static_cast<ImportStatistics::Stage>(i));
+        stageEl.append_attribute("calls") = stage.calls;
+        stageEl.append_attribute("ms") = stage.time.count() / 1000.0;
+    }
+}
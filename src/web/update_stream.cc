@@ -0,0 +1,146 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    update_stream.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file update_stream.cc
+
+#include "pages.h" // API
+
+#include <atomic>
+#include <thread>
+
+#include "iohandler/mem_io_handler.h"
+#include "server.h"
+#include "util/tools.h"
+
+/// \brief changes arriving within this time are sent as one event
+#define UPDATE_STREAM_COALESCE std::chrono::milliseconds(500)
+/// \brief comment sent on an idle stream, a closed connection is noticed when it is written
+#define UPDATE_STREAM_KEEPALIVE std::chrono::seconds(15)
+/// \brief the stream ends after this time and the browser reconnects, so threads are returned regularly
+#define UPDATE_STREAM_LIFETIME std::chrono::minutes(5)
+/// \brief steps of waiting for changes, to notice a shutdown of the server
+#define UPDATE_STREAM_POLL std::chrono::seconds(1)
+
+namespace web {
+
+/// \brief Blocks in read until the session collected update ids and returns them as server-sent events
+class UpdateStreamIOHandler : public IOHandler {
+public:
+    UpdateStreamIOHandler(std::shared_ptr<Session> session, std::shared_ptr<Server> server)
+        : session(std::move(session))
+        , server(std::move(server))
+        , end(std::chrono::steady_clock::now() + UPDATE_STREAM_LIFETIME)
+    {
+        openStreams++;
+        // the browser reconnects after one second when the stream ends
+        pending = "retry: 1000\n\n";
+    }
+
+    ~UpdateStreamIOHandler() override { openStreams--; }
+
+    size_t read(char* buf, size_t length) override
+    {
+        while (pending.empty()) {
+            if (std::chrono::steady_clock::now() >= end || server->getShutdownStatus() || !session->isLoggedIn())
+                return 0;
+            if (!waitForUpdates()) {
+                pending = ": keepalive\n\n";
+                break;
+            }
+            // collect the rest of a burst of changes
+            std::this_thread::sleep_for(UPDATE_STREAM_COALESCE);
+            session->access();
+            auto ids = session->getUIUpdateIDs();
+            if (!ids.empty())
+                pending = fmt::format("event: update\ndata: {}\n\n", ids);
+        }
+
+        length = std::min(length, pending.size());
+        std::copy_n(pending.begin(), length, buf);
+        pending.erase(0, length);
+        return length;
+    }
+
+    static std::atomic<int> openStreams;
+
+private:
+    /// \brief true when update ids arrived before the keepalive is due
+    bool waitForUpdates()
+    {
+        auto keepalive = std::chrono::steady_clock::now() + UPDATE_STREAM_KEEPALIVE;
+        while (std::chrono::steady_clock::now() < std::min(keepalive, end) && !server->getShutdownStatus()) {
+            if (session->waitForUIUpdateIDs(UPDATE_STREAM_POLL))
+                return true;
+        }
+        return false;
+    }
+
+    std::shared_ptr<Session> session;
+    std::shared_ptr<Server> server;
+    std::chrono::steady_clock::time_point end;
+    std::string pending;
+};
+
+std::atomic<int> UpdateStreamIOHandler::openStreams { 0 };
+
+} // namespace web
+
+web::updateStream::updateStream(std::shared_ptr<ContentManager> content)
+    : WebRequestHandler(std::move(content))
+{
+}
+
+void web::updateStream::process()
+{
+    // the subscription is sent by the other requests, the browser reconnects with the same url
+    check_request();
+}
+
+std::string web::updateStream::getMimeType() const
+{
+    return MIMETYPE_EVENT_STREAM;
+}
+
+std::unique_ptr<IOHandler> web::updateStream::open(enum UpnpOpenFileMode mode)
+{
+    std::string event;
+    try {
+        process();
+        if (UpdateStreamIOHandler::openStreams >= config->getIntOption(CFG_SERVER_UI_UPDATE_STREAMS)) {
+            log_debug("too many update streams, UI falls back to polling");
+            event = "event: fallback\ndata: streams\n\n";
+        }
+    } catch (const std::runtime_error& e) {
+        log_debug("update stream: {}", e.what());
+        event = "event: fallback\ndata: error\n\n";
+    }
+
+    if (!event.empty()) {
+        auto ioHandler = std::make_unique<MemIOHandler>(event);
+        ioHandler->open(mode);
+        return ioHandler;
+    }
+
+    log_debug("UI: opening update stream for session {}", session->getID());
+    return std::make_unique<UpdateStreamIOHandler>(session, server);
+}
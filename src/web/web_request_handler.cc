@@ -36,6 +36,7 @@
 #include "config/config_manager.h"
 #include "content/content_manager.h"
 #include "iohandler/mem_io_handler.h"
+#include "util/compression.h"
 #include "util/tools.h"
 #include "util/upnp_headers.h"
 #include "util/xml_to_json.h"
@@ -103,9 +104,7 @@ void WebRequestHandler::getInfo(const char* filename, UpnpFileInfo* info)
     UpnpFileInfo_set_IsDirectory(info, 0);
     UpnpFileInfo_set_IsReadable(info, 1);
 
-    std::string returnType = param("return_type");
-    std::string mimetype = (returnType == "xml") ? MIMETYPE_XML : MIMETYPE_JSON;
-    std::string contentType = mimetype + "; charset=" + DEFAULT_INTERNAL_CHARSET;
+    std::string contentType = getMimeType() + "; charset=" + DEFAULT_INTERNAL_CHARSET;
 
 #if defined(USING_NPUPNP)
     UpnpFileInfo_set_ContentType(info, contentType);
@@ -114,10 +113,44 @@ void WebRequestHandler::getInfo(const char* filename, UpnpFileInfo* info)
 #endif
     Headers headers;
     headers.addHeader(std::string { "Cache-Control" }, std::string { "no-cache, must-revalidate" });
+#ifdef HAVE_ZLIB
+    int level = config->getIntOption(CFG_SERVER_UI_COMPRESSION_LEVEL);
+    if (level > 0 && canCompress()) {
+        headers.addHeader("Vary", "Accept-Encoding");
+        if (acceptsEncoding(Headers::getHeader(info, "Accept-Encoding"), "gzip")) {
+            // the encoding has to be known before the headers go out, so the page runs here
+            auto output = render();
+            if (output.size() >= static_cast<std::size_t>(config->getIntOption(CFG_SERVER_UI_COMPRESSION_THRESHOLD))) {
+                output = gzipCompress(output, level);
+                headers.addHeader("Content-Encoding", "gzip");
+            }
+            UpnpFileInfo_set_FileLength(info, output.size());
+            setRequestCookie(sessionManager->getResponseStore().put(std::move(output)));
+        }
+    }
+#endif
     headers.writeHeaders(info);
 }
 
+std::string WebRequestHandler::getMimeType() const
+{
+    return (param("return_type") == "xml") ? MIMETYPE_XML : MIMETYPE_JSON;
+}
+
 std::unique_ptr<IOHandler> WebRequestHandler::open(enum UpnpOpenFileMode mode)
+{
+    std::string output;
+    if (getRequestCookie() == nullptr)
+        output = render();
+    else if (!sessionManager->getResponseStore().take(getRequestCookie(), output))
+        throw_std_runtime_error("Response to {} expired", filename);
+
+    auto io_handler = std::make_unique<MemIOHandler>(output);
+    io_handler->open(mode);
+    return io_handler;
+}
+
+std::string WebRequestHandler::render()
 {
     xmlDoc = std::make_shared<pugi::xml_document>();
     auto decl = xmlDoc->prepend_child(pugi::node_declaration);
@@ -127,6 +160,16 @@ std::unique_ptr<IOHandler> WebRequestHandler::open(enum UpnpOpenFileMode mode)
 
     xml2JsonHints = std::make_shared<Xml2Json::Hints>();
 
+    std::string returnType = param("return_type");
+    JsonStreamWriter* jsonWriter = nullptr;
+    if (returnType == "xml") {
+        json = std::make_unique<PugiJsonSink>(root, *xml2JsonHints);
+    } else {
+        auto writer = std::make_unique<JsonStreamWriter>();
+        jsonWriter = writer.get();
+        json = std::move(writer);
+    }
+
     std::string error;
     int error_code = 0;
 
@@ -179,7 +222,6 @@ std::unique_ptr<IOHandler> WebRequestHandler::open(enum UpnpOpenFileMode mode)
         log_warning("Web Error: {} {}", error_code, error);
     }
 
-    std::string returnType = param("return_type");
     if (returnType == "xml") {
 #ifdef TOMBDEBUG
         try {
@@ -205,16 +247,22 @@ std::unique_ptr<IOHandler> WebRequestHandler::open(enum UpnpOpenFileMode mode)
             log_debug("XML-----------------------{}", output);
 #endif
             output = Xml2Json::getJson(root, *xml2JsonHints);
+            // a page that failed may have left its objects open
+            auto fragment = error.empty() ? jsonWriter->releaseFragment() : "";
+            if (!fragment.empty()) {
+                output.pop_back();
+                if (output.size() > 1)
+                    output.push_back(',');
+                output.append(fragment);
+                output.push_back('}');
+            }
         } catch (const std::runtime_error& e) {
             log_error("Exception: {}", e.what());
         }
     }
 
     log_debug("output-----------------------{}", output);
-
-    auto io_handler = std::make_unique<MemIOHandler>(output);
-    io_handler->open(mode);
-    return io_handler;
+    return output;
 }
 
 std::unique_ptr<IOHandler> WebRequestHandler::open(const char* filename, enum UpnpOpenFileMode mode)
@@ -246,6 +294,18 @@ void WebRequestHandler::handleUpdateIDs()
     }
 }
 
+void WebRequestHandler::handleSubscription()
+{
+    // session will be filled by check_request
+    if (params.find("subscribe") == params.end())
+        return;
+
+    std::unordered_set<int> objectIDs;
+    for (const auto& objectID : splitString(param("subscribe"), ','))
+        objectIDs.insert(std::stoi(objectID));
+    session->subscribe(std::move(objectIDs));
+}
+
 void WebRequestHandler::addUpdateIDs(const std::shared_ptr<Session>& session, pugi::xml_node* updateIDsEl)
 {
     std::string updateIDs = session->getUIUpdateIDs();
@@ -264,6 +324,18 @@ void WebRequestHandler::appendTask(const std::shared_ptr<GenericTask>& task, pug
     taskEl.append_attribute("id") = task->getID();
     taskEl.append_attribute("cancellable") = task->isCancellable();
     taskEl.append_attribute("text") = task->getDescription().c_str();
+
+    auto progress = task->getProgress();
+    if (progress.startTime == 0)
+        return;
+    taskEl.append_attribute("started") = progress.startTime;
+    taskEl.append_attribute("elapsed") = progress.elapsed.count() / 1000.0;
+    taskEl.append_attribute("done") = progress.itemsDone;
+    taskEl.append_attribute("total") = progress.itemsTotal;
+    taskEl.append_attribute("bytes") = progress.bytesRead;
+    taskEl.append_attribute("rate") = progress.itemsPerSecond();
+    taskEl.append_attribute("byte-rate") = progress.bytesPerSecond();
+    taskEl.append_attribute("eta") = progress.eta();
 }
 
 std::string WebRequestHandler::mapAutoscanType(int type)
@@ -40,6 +40,7 @@
 #include "request_handler.h"
 #include "session_manager.h"
 #include "util/generic_task.h"
+#include "util/json_writer.h"
 #include "util/xml_to_json.h"
 
 namespace web {
@@ -84,6 +85,10 @@ protected:
     /// \brief Hints for Xml2Json, such that we know when to create an array
     std::shared_ptr<Xml2Json::Hints> xml2JsonHints;
 
+    /// \brief The page content written directly as JSON, or into xmlDoc if XML was requested.
+    /// The members are added next to the ones converted from xmlDoc.
+    std::unique_ptr<JsonSink> json;
+
     /// \brief The current session, used for this request; will be filled by
     /// check_request()
     std::shared_ptr<Session> session;
@@ -112,7 +117,16 @@ protected:
     /// \brief Prepares the output buffer and calls the process function.
     /// \return IOHandler
     /// \todo Genych, chto tut proishodit, ya tolkom che to ne wrubaus??
-    std::unique_ptr<IOHandler> open(enum UpnpOpenFileMode mode);
+    virtual std::unique_ptr<IOHandler> open(enum UpnpOpenFileMode mode);
+
+    /// \brief Runs process() and returns the xml or json output, errors are part of the output.
+    std::string render();
+
+    /// \brief false for pages that stream their output, those cannot be rendered in getInfo
+    virtual bool canCompress() const { return true; }
+
+    /// \brief mime type of the response, xml or json depending on return_type
+    virtual std::string getMimeType() const;
 
     /// \brief add the ui update ids from the given session as xml tags to the given root element
     /// \param session the session from which the ui update ids should be taken
@@ -124,6 +138,10 @@ protected:
     /// must only be called after check_request
     void handleUpdateIDs();
 
+    /// \brief take the containers the UI shows from the subscribe parameter,
+    /// must only be called after check_request
+    void handleSubscription();
+
     /// \brief add the content manager task to the given xml element as xml elements
     /// \param task the task to add to the given xml element
     /// \param parent the xml element to add the elements to
@@ -38,4 +38,5 @@
 void web::voidType::process()
 {
     check_request();
+    handleSubscription();
 }
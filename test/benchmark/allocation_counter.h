@@ -0,0 +1,13 @@
+#ifndef __ALLOCATION_COUNTER_H__
+#define __ALLOCATION_COUNTER_H__
+
+#include <atomic>
+#include <cstddef>
+
+/// \brief operator new calls of the benchmark binary, see main.cc
+struct AllocationCounter {
+    static std::atomic<std::size_t> count;
+    static std::atomic<std::size_t> bytes;
+};
+
+#endif // __ALLOCATION_COUNTER_H__
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <fstream>
+#include <future>
+#include <random>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+
+#include "iohandler/buffered_io_handler.h"
+#include "iohandler/file_io_handler.h"
+#include "iohandler/io_handler_chainer.h"
+#include "iohandler/process_io_handler.h"
+#include "util/process_executor.h"
+
+#include "../mock/config_mock.h"
+
+/// \brief counts what the chainer writes and reports the end of the stream
+class CountingIOHandler : public IOHandler {
+public:
+    explicit CountingIOHandler(std::promise<std::size_t>& done)
+        : done(done)
+    {
+    }
+
+    void open(enum UpnpOpenFileMode mode) override { }
+
+    size_t write(char* buf, size_t length) override
+    {
+        bytes += length;
+        return length;
+    }
+
+    void close() override { done.set_value(bytes); }
+
+private:
+    std::promise<std::size_t>& done;
+    std::size_t bytes { 0 };
+};
+
+/// \brief one file streamed through each handler, with several chunk sizes and streams at once
+class IOHandlerBenchmark : public ::testing::Test {
+public:
+    static void SetUpTestSuite()
+    {
+        std::size_t megabytes = 64;
+        if (auto env = std::getenv("GERBERA_BENCHMARK_STREAM_SIZE"))
+            megabytes = std::max(1, std::atoi(env));
+        path = fs::temp_directory_path() / fmt::format("gerbera-benchmark-{}.bin", getpid());
+
+        std::mt19937 rng(1);
+        std::string block(1024 * 1024, '\0');
+        for (auto&& c : block)
+            c = static_cast<char>(rng());
+        std::ofstream file(path, std::ios::binary);
+        for (std::size_t i = 0; i < megabytes; i++)
+            file << block;
+        fileSize = megabytes * block.size();
+    }
+
+    static void TearDownTestSuite() { fs::remove(path); }
+
+    void SetUp() override
+    {
+        config = std::make_shared<NiceMock<ConfigMock>>();
+        if (auto env = std::getenv("GERBERA_BENCHMARK_STREAMS"))
+            streams = { std::max(1, std::atoi(env)) };
+    }
+
+    /// \brief read the handler to the end in chunks, returns the number of bytes
+    static std::size_t drain(IOHandler& handler, std::size_t chunkSize)
+    {
+        std::vector<char> buf(chunkSize);
+        std::size_t total = 0;
+        while (true) {
+            auto bytes = handler.read(buf.data(), buf.size());
+            if (bytes == 0)
+                break;
+            if (bytes > buf.size())
+                throw_std_runtime_error("read failed with {}", static_cast<ssize_t>(bytes));
+            total += bytes;
+        }
+        return total;
+    }
+
+    static std::chrono::microseconds cpuTime()
+    {
+        rusage usage {};
+        getrusage(RUSAGE_SELF, &usage);
+        auto toMicroseconds = [](const timeval& tv) { return std::chrono::seconds(tv.tv_sec) + std::chrono::microseconds(tv.tv_usec); };
+        return toMicroseconds(usage.ru_utime) + toMicroseconds(usage.ru_stime);
+    }
+
+    /// \brief run stream on parallel threads for each chunk size and print throughput and cpu time of this process
+    void measure(const std::string& name, const std::function<std::size_t(std::size_t chunkSize)>& stream)
+    {
+        fmt::print("{:<18} {:>8} {:>8} {:>10} {:>10} {:>12}\n", "handler", "chunk", "streams", "MB", "MB/s", "cpu ms/MB");
+        for (auto chunkSize : chunkSizes) {
+            for (auto count : streams) {
+                std::vector<std::future<std::size_t>> results;
+                auto cpu = cpuTime();
+                auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < count; i++)
+                    results.push_back(std::async(std::launch::async, stream, chunkSize));
+
+                std::size_t bytes = 0;
+                for (auto&& result : results) {
+                    auto streamed = result.get();
+                    EXPECT_EQ(streamed, fileSize) << name;
+                    bytes += streamed;
+                }
+                auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                auto cpuMs = std::chrono::duration<double, std::milli>(cpuTime() - cpu).count();
+                auto megabytes = bytes / 1048576.0;
+                fmt::print("{:<18} {:>8} {:>8} {:>10.0f} {:>10.1f} {:>12.3f}\n", name, chunkSize, count, megabytes, megabytes / seconds, cpuMs / megabytes);
+            }
+        }
+    }
+
+    static fs::path path;
+    static std::size_t fileSize;
+    std::vector<std::size_t> chunkSizes { 4096, 65536, 1048576 };
+    std::vector<int> streams { 1, 4, 16 };
+    std::shared_ptr<ConfigMock> config;
+};
+
+fs::path IOHandlerBenchmark::path;
+std::size_t IOHandlerBenchmark::fileSize;
+
+TEST_F(IOHandlerBenchmark, FileIOHandler)
+{
+    measure("FileIOHandler", [](std::size_t chunkSize) {
+        FileIOHandler handler(path);
+        handler.open(UPNP_READ);
+        auto bytes = drain(handler, chunkSize);
+        handler.close();
+        return bytes;
+    });
+}
+
+// BufferedIOHandler is the IOHandlerBufferHelper with a reader thread, which the helper alone does not have
+TEST_F(IOHandlerBenchmark, BufferedIOHandler)
+{
+    measure("BufferedIOHandler", [this](std::size_t chunkSize) {
+        std::unique_ptr<IOHandler> file = std::make_unique<FileIOHandler>(path);
+        BufferedIOHandler handler(config, file, std::max<std::size_t>(chunkSize * 4, 1024 * 1024), chunkSize, 0);
+        handler.open(UPNP_READ);
+        auto bytes = drain(handler, chunkSize);
+        handler.close();
+        return bytes;
+    });
+}
+
+// the output of cat through a pipe, as the transcoders deliver it
+TEST_F(IOHandlerBenchmark, ProcessIOHandler)
+{
+    measure("ProcessIOHandler", [](std::size_t chunkSize) {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) != 0)
+            throw_std_runtime_error("pipe failed: {}", std::strerror(errno));
+        auto cat = std::make_shared<ProcessExecutor>("/bin/sh", std::vector<std::string> { "-c", fmt::format("exec cat '{}' > /dev/fd/{}", path.string(), ProcessExecutor::OUTPUT_FD) }, fds[1]);
+        ::close(fds[1]);
+
+        // without the main process the handler needs no content manager to register it
+        ProcessIOHandler handler(nullptr, fds[0], nullptr);
+        handler.open(UPNP_READ);
+        auto bytes = drain(handler, chunkSize);
+        handler.close();
+        // cat may still be exiting after closing its end, kill() would wait a second for it
+        while (cat->isAlive())
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        return bytes;
+    });
+}
+
+TEST_F(IOHandlerBenchmark, IOHandlerChainer)
+{
+    measure("IOHandlerChainer", [this](std::size_t chunkSize) {
+        std::promise<std::size_t> done;
+        auto written = done.get_future();
+        std::unique_ptr<IOHandler> readFrom = std::make_unique<FileIOHandler>(path);
+        std::unique_ptr<IOHandler> writeTo = std::make_unique<CountingIOHandler>(done);
+        IOHandlerChainer chainer(readFrom, writeTo, chunkSize, config);
+        auto bytes = written.get();
+        chainer.kill();
+        return bytes;
+    });
+}
@@ -0,0 +1,275 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fmt/format.h>
+#include <fstream>
+#include <unistd.h>
+
+#include "cds_objects.h"
+#include "config/directory_tweak.h"
+#include "context.h"
+#include "metadata/metadata_handler.h"
+#include "util/mime.h"
+
+#ifdef HAVE_EXIV2
+#include "metadata/exiv2_handler.h"
+#endif
+#ifdef HAVE_FFMPEG
+#include "metadata/ffmpeg_handler.h"
+#endif
+#ifdef HAVE_LIBEXIF
+#include "metadata/libexif_handler.h"
+#endif
+#ifdef HAVE_MATROSKA
+#include "metadata/matroska_handler.h"
+#endif
+#ifdef HAVE_TAGLIB
+#include "metadata/taglib_handler.h"
+#endif
+
+#include "../mock/config_mock.h"
+#include "allocation_counter.h"
+
+/// \brief the options the metadata handlers read, with the defaults of the server
+class BenchmarkConfig : public ConfigMock {
+public:
+    BenchmarkConfig()
+    {
+        ON_CALL(*this, getOption(_)).WillByDefault(Return(""));
+        ON_CALL(*this, getOption(CFG_IMPORT_METADATA_CHARSET)).WillByDefault(Return("UTF-8"));
+        ON_CALL(*this, getOption(CFG_IMPORT_LIBOPTS_ENTRY_SEP)).WillByDefault(Return("; "));
+    }
+
+    int getIntOption(config_option_t option) const override
+    {
+        return option == CFG_IMPORT_LIBOPTS_IMAGE_HEADER_SIZE ? 256 : 0;
+    }
+
+    std::map<std::string, std::string> getDictionaryOption(config_option_t option) const override
+    {
+        if (option == CFG_IMPORT_MAPPINGS_MIMETYPE_TO_CONTENTTYPE_LIST)
+            return {
+                { "audio/mpeg", CONTENT_TYPE_MP3 },
+                { "audio/flac", CONTENT_TYPE_FLAC },
+                { "audio/x-wav", CONTENT_TYPE_PCM },
+                { "audio/mp4", CONTENT_TYPE_MP4 },
+                { "video/mp4", CONTENT_TYPE_MP4 },
+                { "image/jpeg", CONTENT_TYPE_JPG },
+                { "video/x-matroska", CONTENT_TYPE_MKV },
+                { "application/ogg", CONTENT_TYPE_OGG },
+            };
+        return ConfigMock::getDictionaryOption(option);
+    }
+
+    std::shared_ptr<DirectoryConfigList> getDirectoryTweakOption(config_option_t option) const override
+    {
+        return directories;
+    }
+
+private:
+    std::shared_ptr<DirectoryConfigList> directories = std::make_shared<DirectoryConfigList>();
+};
+
+/// \brief small files in the formats of the handlers, written when the benchmark starts
+class MetadataBenchmark : public ::testing::Test {
+public:
+    static void SetUpTestSuite()
+    {
+        dir = fs::temp_directory_path() / fmt::format("gerbera-benchmark-{}", getpid());
+        fs::create_directories(dir);
+        write("tagged.mp3", mp3());
+        write("tagged.wav", wav());
+        write("exif.jpg", jpeg());
+        write("titled.mkv", mkv());
+    }
+
+    static void TearDownTestSuite() { fs::remove_all(dir); }
+
+    void SetUp() override
+    {
+        config = std::make_shared<NiceMock<BenchmarkConfig>>();
+        mime = std::make_shared<Mime>(config);
+        context = std::make_shared<Context>(config, nullptr, mime, nullptr, nullptr, nullptr);
+        if (auto env = std::getenv("GERBERA_BENCHMARK_ITERATIONS"))
+            iterations = std::max(1, std::atoi(env));
+    }
+
+    /// \brief the generated files and GERBERA_BENCHMARK_MEDIA with one of the mime types
+    std::vector<fs::path> files(const std::vector<std::string>& mimeTypes) const
+    {
+        std::vector<fs::path> result;
+        auto add = [&](const fs::path& directory) {
+            std::error_code ec;
+            for (auto&& dirEnt : fs::recursive_directory_iterator(directory, ec)) {
+                if (dirEnt.is_regular_file(ec) && std::find(mimeTypes.begin(), mimeTypes.end(), mime->getMimeType(dirEnt.path())) != mimeTypes.end())
+                    result.push_back(dirEnt.path());
+            }
+        };
+        add(dir);
+        if (auto media = std::getenv("GERBERA_BENCHMARK_MEDIA"))
+            add(media);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    /// \brief run the handler on each file and print time and allocations per file
+    template <class Handler>
+    void measure(const std::string& name, const std::vector<std::string>& mimeTypes)
+    {
+        auto paths = files(mimeTypes);
+        ASSERT_FALSE(paths.empty());
+
+        fmt::print("{:<10} {:>12} {:>10} {:>12} {:>7}  {}\n", "handler", "us/file", "allocs", "bytes", "fields", "file");
+        for (auto&& path : paths) {
+            std::size_t fields = 0;
+            std::size_t allocations = 0;
+            std::size_t bytes = 0;
+            std::chrono::nanoseconds total {};
+            for (int i = 0; i < iterations; i++) {
+                auto item = std::make_shared<CdsItem>();
+                item->setLocation(path);
+                item->setMimeType(mime->getMimeType(path));
+                item->setSizeOnDisk(fs::file_size(path));
+
+                auto count = AllocationCounter::count.load();
+                auto size = AllocationCounter::bytes.load();
+                auto start = std::chrono::steady_clock::now();
+                try {
+                    Handler handler(context);
+                    handler.fillMetadata(item);
+                } catch (const std::runtime_error& e) {
+                    fmt::print("{:<10} failed on {}: {}\n", name, path.c_str(), e.what());
+                    break;
+                }
+                total += std::chrono::steady_clock::now() - start;
+                allocations += AllocationCounter::count.load() - count;
+                bytes += AllocationCounter::bytes.load() - size;
+                fields = item->getMetadata().size() + item->getResourceCount();
+            }
+            fmt::print("{:<10} {:>12.1f} {:>10} {:>12} {:>7}  {}\n", name,
+                std::chrono::duration<double, std::micro>(total).count() / iterations,
+                allocations / iterations, bytes / iterations, fields, path.filename().c_str());
+        }
+    }
+
+    static void write(const std::string& name, const std::string& data)
+    {
+        std::ofstream(dir / name, std::ios::binary) << data;
+    }
+
+    /// \brief little endian integer of width bytes
+    static std::string le(std::uint32_t value, int width)
+    {
+        std::string result;
+        for (int i = 0; i < width; i++)
+            result.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+        return result;
+    }
+
+    /// \brief ID3v2.3 title and artist followed by silent MPEG-1 layer III frames
+    static std::string mp3()
+    {
+        auto frame = [](const std::string& id, const std::string& text) {
+            auto size = text.size() + 1;
+            return id + std::string { 0, 0, static_cast<char>(size >> 7), static_cast<char>(size & 0x7F), 0, 0, 0 } + text;
+        };
+        auto tags = frame("TIT2", "Benchmark") + frame("TPE1", "Gerbera") + frame("TALB", "Fixtures");
+        std::string result = std::string("ID3\x03\x00\x00", 6) + std::string { 0, 0, static_cast<char>(tags.size() >> 7), static_cast<char>(tags.size() & 0x7F) } + tags;
+        // 128 kbit/s at 44.1 kHz, 417 bytes per frame
+        std::string mpegFrame("\xFF\xFB\x90\x64", 4);
+        mpegFrame.resize(417, '\0');
+        for (int i = 0; i < 40; i++)
+            result += mpegFrame;
+        return result;
+    }
+
+    /// \brief one second of 16 bit silence with a RIFF INFO title
+    static std::string wav()
+    {
+        std::string title = "Benchmark";
+        title.push_back('\0');
+        auto info = std::string("INFOINAM") + le(title.size(), 4) + title;
+        auto list = std::string("LIST") + le(info.size(), 4) + info;
+        auto format = std::string("fmt ") + le(16, 4) + le(1, 2) + le(1, 2) + le(44100, 4) + le(88200, 4) + le(2, 2) + le(16, 2);
+        auto data = std::string("data") + le(88200, 4) + std::string(88200, '\0');
+        auto body = std::string("WAVE") + format + list + data;
+        return std::string("RIFF") + le(body.size(), 4) + body;
+    }
+
+    /// \brief JPEG markers with an exif block holding make, model and date
+    static std::string jpeg()
+    {
+        std::vector<std::pair<std::uint16_t, std::string>> entries {
+            { 0x010F, "Gerbera" },
+            { 0x0110, "Benchmark" },
+            { 0x0132, "2021:06:01 12:00:00" },
+        };
+        auto dataOffset = 8 + 2 + 12 * entries.size() + 4;
+        std::string ifd = le(entries.size(), 2);
+        std::string values;
+        for (auto&& [tag, text] : entries) {
+            auto value = text + '\0';
+            ifd += le(tag, 2) + le(2, 2) + le(value.size(), 4) + le(dataOffset + values.size(), 4);
+            values += value;
+        }
+        ifd += le(0, 4);
+        auto tiff = std::string("II*\0", 4) + le(8, 4) + ifd + values;
+        auto exif = std::string("Exif\0\0", 6) + tiff;
+        auto length = exif.size() + 2;
+        return std::string("\xFF\xD8\xFF\xE1", 4) + static_cast<char>(length >> 8) + static_cast<char>(length & 0xFF) + exif + std::string("\xFF\xD9", 2);
+    }
+
+    /// \brief EBML header and a segment with the title in the info
+    static std::string mkv()
+    {
+        auto element = [](const std::string& id, const std::string& data) {
+            return id + static_cast<char>(0x80 | data.size()) + data;
+        };
+        auto header = element("\x1A\x45\xDF\xA3", element("\x42\x82", "matroska") + element("\x42\x87", "\x04") + element("\x42\x85", "\x02"));
+        auto info = element("\x15\x49\xA9\x66", element(std::string("\x2A\xD7\xB1", 3), std::string("\x0F\x42\x40", 3)) + element("\x7B\xA9", "Benchmark"));
+        return header + element("\x18\x53\x80\x67", info);
+    }
+
+    static fs::path dir;
+    int iterations { 20 };
+    std::shared_ptr<ConfigMock> config;
+    std::shared_ptr<Mime> mime;
+    std::shared_ptr<Context> context;
+};
+
+fs::path MetadataBenchmark::dir;
+
+#ifdef HAVE_TAGLIB
+TEST_F(MetadataBenchmark, TagLib)
+{
+    measure<TagLibHandler>("taglib", { "audio/mpeg", "audio/flac", "audio/x-wav", "audio/mp4", "application/ogg" });
+}
+#endif
+
+#ifdef HAVE_FFMPEG
+TEST_F(MetadataBenchmark, Ffmpeg)
+{
+    measure<FfmpegHandler>("ffmpeg", { "audio/mpeg", "audio/flac", "audio/x-wav", "audio/mp4", "video/mp4", "video/x-matroska" });
+}
+#endif
+
+#ifdef HAVE_EXIV2
+TEST_F(MetadataBenchmark, Exiv2)
+{
+    measure<Exiv2Handler>("exiv2", { "image/jpeg" });
+}
+#endif
+
+#ifdef HAVE_LIBEXIF
+TEST_F(MetadataBenchmark, LibExif)
+{
+    measure<LibExifHandler>("libexif", { "image/jpeg" });
+}
+#endif
+
+#ifdef HAVE_MATROSKA
+TEST_F(MetadataBenchmark, Matroska)
+{
+    measure<MatroskaHandler>("matroska", { "video/x-matroska" });
+}
+#endif
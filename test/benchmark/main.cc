@@ -0,0 +1,36 @@
+#include <atomic>
+#include <cstdlib>
+#include <gmock/gmock.h>
+#include <new>
+
+#include "allocation_counter.h"
+
+std::atomic<std::size_t> AllocationCounter::count { 0 };
+std::atomic<std::size_t> AllocationCounter::bytes { 0 };
+
+// count the allocations with operator new, malloc of the C libraries is not seen
+void* operator new(std::size_t size)
+{
+    AllocationCounter::count++;
+    AllocationCounter::bytes += size;
+    if (auto ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleMock(&argc, argv);
+    int ret = RUN_ALL_TESTS();
+    return ret;
+}
@@ -8,6 +8,8 @@
 #include "config/config_manager.h"
 #include "util/tools.h"
 
+#include "../mock/database_mock.h"
+
 class ConfigManagerTest : public ::testing::Test {
 
 public:
@@ -137,3 +139,21 @@ TEST_F(ConfigManagerTest, LoadsConfigFromDefaultHomeWhenExistsButNotSpecified)
     ASSERT_FALSE(shared->getBoolOption(CFG_SERVER_UI_ACCOUNTS_ENABLED));
     ASSERT_EQ(30, shared->getIntOption(CFG_SERVER_UI_SESSION_TIMEOUT));
 }
+
+TEST_F(ConfigManagerTest, ReloadsTranscodingProfilesWithoutRestart)
+{
+    auto shared = std::shared_ptr<ConfigManager>(new ConfigManager(config_file, home, confdir, prefix, magic, "", "", 0, false));
+    shared->load(home);
+    auto database = std::make_shared<DatabaseMock>(shared);
+    auto content = readTextFile(config_file);
+
+    writeTextFile(config_file, replaceAllString(content, "ogg2mp3", "ogg2mp3-reloaded"));
+    ASSERT_TRUE(shared->reload(database));
+    auto profiles = shared->getTranscodingProfileListOption(CFG_TRANSCODING_PROFILE_LIST);
+    EXPECT_NE(profiles->getByName("ogg2mp3-reloaded", true), nullptr);
+    EXPECT_EQ(profiles->getByName("ogg2mp3", true), nullptr);
+
+    // anything else needs a restart
+    writeTextFile(config_file, replaceAllString(content, "<name>Gerbera</name>", "<name>Reloaded</name>"));
+    EXPECT_FALSE(shared->reload(database));
+}
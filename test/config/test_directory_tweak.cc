@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include "config/directory_tweak.h"
+
+TEST(DirectoryConfigListTest, FindsNearestTweak)
+{
+    DirectoryConfigList list;
+    auto music = std::make_shared<DirectoryTweak>("/media/music", true);
+    auto single = std::make_shared<DirectoryTweak>("/media/music/single", false);
+    auto root = std::make_shared<DirectoryTweak>("/", true);
+    list.add(music);
+    list.add(single);
+    list.add(root);
+
+    EXPECT_EQ(list.get("/media/music/song.mp3"), music);
+    EXPECT_EQ(list.get("/media/music/album/song.mp3"), music);
+    EXPECT_EQ(list.get("/media/music/album/song.mp3"), music);
+    EXPECT_EQ(list.get("/media/music/single/song.mp3"), single);
+    // not inherited by the subdirectories
+    EXPECT_EQ(list.get("/media/music/single/cd1/song.mp3"), music);
+    EXPECT_EQ(list.get("/media/musicals/song.mp3"), nullptr);
+    EXPECT_EQ(list.get("/media/song.mp3"), nullptr);
+
+    single->setLocation("/media/other");
+    list.updateIndex();
+    EXPECT_EQ(list.get("/media/music/single/song.mp3"), music);
+    EXPECT_EQ(list.get("/media/other/song.mp3"), single);
+
+    list.remove(0);
+    EXPECT_EQ(list.get("/media/music/album/song.mp3"), nullptr);
+}
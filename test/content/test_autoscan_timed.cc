@@ -1,8 +1,49 @@
 #include <gtest/gtest.h>
 
+#include "content/autoscan.h"
+
+#include <thread>
+
 using namespace ::testing;
 
 TEST(AutoscanTimedTest, millisecondsToHMSF)
 {
 
 }
+
+TEST(AutoscanTimedTest, collectsStaleObjectsOfTheScan)
+{
+    AutoscanDirectory adir("/media", ScanMode::Timed, true, true);
+    adir.addStaleObjects({ 10, 11 });
+    adir.addStaleObject(12);
+    adir.addStaleObject(10);
+    adir.addListedDirectory(5, 1000);
+
+    EXPECT_EQ(adir.takeStaleObjects(), (std::unordered_set<int> { 10, 11, 12 }));
+    EXPECT_TRUE(adir.takeStaleObjects().empty());
+
+    auto listed = adir.takeListedDirectories();
+    ASSERT_EQ(listed.size(), 1U);
+    EXPECT_EQ(listed[0], std::make_pair(5, time_t(1000)));
+    EXPECT_TRUE(adir.takeListedDirectories().empty());
+}
+
+TEST(AutoscanTimedTest, collectsStaleObjectsFromSeveralTasks)
+{
+    AutoscanDirectory adir("/media", ScanMode::Timed, true, true);
+    std::thread other([&adir] {
+        for (int id = 0; id < 1000; id++)
+            adir.addStaleObject(id);
+    });
+    std::unordered_set<int> taken;
+    for (int id = 1000; id < 2000; id++) {
+        adir.addStaleObject(id);
+        auto part = adir.takeStaleObjects();
+        taken.insert(part.begin(), part.end());
+    }
+    other.join();
+    auto rest = adir.takeStaleObjects();
+    taken.insert(rest.begin(), rest.end());
+
+    EXPECT_EQ(taken.size(), 2000U);
+}
@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include "browse_cache.h"
+
+static BrowseCache::Key makeKey(int objectID, const std::string& startingIndex = "0", unsigned int quirkFlags = 0)
+{
+    return BrowseCache::Key { objectID, "BrowseDirectChildren", "*", startingIndex, "20", "", quirkFlags };
+}
+
+static std::shared_ptr<const BrowseResult> makeResult(const std::string& didl)
+{
+    return std::make_shared<BrowseResult>(BrowseResult { didl, 1, 1 });
+}
+
+TEST(BrowseCacheTest, ReturnsResultOfSameRequest)
+{
+    BrowseCache cache(std::chrono::seconds(60), 16);
+    cache.put(makeKey(2), { 2, 10 }, makeResult("<DIDL-Lite />"));
+
+    auto result = cache.get(makeKey(2));
+    ASSERT_NE(result, nullptr);
+    EXPECT_EQ(result->didl, "<DIDL-Lite />");
+    EXPECT_EQ(cache.get(makeKey(2, "20")), nullptr);
+    EXPECT_EQ(cache.get(makeKey(2, "0", 1)), nullptr);
+    EXPECT_EQ(cache.get(makeKey(3)), nullptr);
+}
+
+TEST(BrowseCacheTest, InvalidatesResultsContainingObject)
+{
+    BrowseCache cache(std::chrono::seconds(60), 16);
+    cache.put(makeKey(2), { 2, 10, 11 }, makeResult("2"));
+    cache.put(makeKey(2, "20"), { 2, 12 }, makeResult("2"));
+    cache.put(makeKey(1), { 1, 2, 3 }, makeResult("1"));
+    cache.put(makeKey(3), { 3, 13 }, makeResult("3"));
+
+    cache.invalidate(2);
+    EXPECT_EQ(cache.get(makeKey(2)), nullptr);
+    EXPECT_EQ(cache.get(makeKey(2, "20")), nullptr);
+    EXPECT_EQ(cache.get(makeKey(1)), nullptr);
+    EXPECT_NE(cache.get(makeKey(3)), nullptr);
+}
+
+TEST(BrowseCacheTest, ExpiresAndEvicts)
+{
+    BrowseCache expiring(std::chrono::seconds(0), 16);
+    expiring.put(makeKey(2), { 2 }, makeResult("2"));
+    EXPECT_EQ(expiring.get(makeKey(2)), nullptr);
+
+    BrowseCache cache(std::chrono::seconds(60), 2);
+    cache.put(makeKey(1), { 1 }, makeResult("1"));
+    cache.put(makeKey(2), { 2 }, makeResult("2"));
+    cache.get(makeKey(1));
+    cache.put(makeKey(3), { 3 }, makeResult("3"));
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_NE(cache.get(makeKey(1)), nullptr);
+    EXPECT_EQ(cache.get(makeKey(2)), nullptr);
+}
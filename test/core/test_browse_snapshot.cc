@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <map>
+#include <optional>
+#include <unistd.h>
+
+#include "browse_cache.h"
+#include "browse_snapshot.h"
+#include "util/xml_writer.h"
+
+class BrowseSnapshotTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        file = fs::temp_directory_path() / fmt::format("gerbera-browse-{}.snapshot", getpid());
+        // 0 has the containers 1 and 2, which has the container 3, 1 has the items 10 and 11, 3 is empty
+        tree = { { 0, { 1, 2 } }, { 1, { 10, 11 } }, { 2, { 3 } }, { 3, {} } };
+    }
+
+    void TearDown() override { fs::remove(file); }
+
+    BrowseSnapshot::Object object(int id)
+    {
+        return { id, tree.count(id) > 0, fmt::format("<o id=\"{}\" v=\"{}\"/>", id, version) };
+    }
+
+    void rebuild(BrowseSnapshot& snapshot)
+    {
+        std::atomic_bool stop { false };
+        snapshot.rebuild(
+            object(0), [this](int containerID) {
+                listed.push_back(containerID);
+                std::vector<BrowseSnapshot::Object> objects;
+                for (int id : tree.at(containerID))
+                    objects.push_back(object(id));
+                return objects;
+            },
+            stop);
+    }
+
+    static std::optional<std::pair<std::string, BrowseResult>> browse(BrowseSnapshot& snapshot, int objectID, bool directChildren, std::size_t start = 0, std::size_t count = 0)
+    {
+        XmlStreamWriter didl;
+        BrowseResult result {};
+        if (!snapshot.browse(objectID, directChildren, start, count, didl, result))
+            return std::nullopt;
+        // the writer ends each element with a newline
+        auto text = didl.release();
+        text.erase(std::remove(text.begin(), text.end(), '\n'), text.end());
+        return std::make_pair(text, result);
+    }
+
+    fs::path file;
+    std::map<int, std::vector<int>> tree;
+    std::vector<int> listed;
+    int version { 1 };
+};
+
+TEST_F(BrowseSnapshotTest, AnswersFromSnapshot)
+{
+    BrowseSnapshot snapshot(file, std::chrono::seconds(30));
+    EXPECT_FALSE(browse(snapshot, 1, true));
+
+    rebuild(snapshot);
+    EXPECT_EQ(snapshot.size(), 6u);
+
+    auto page = browse(snapshot, 1, true);
+    ASSERT_TRUE(page);
+    EXPECT_EQ(page->first, R"(<o id="10" v="1"/><o id="11" v="1"/>)");
+    EXPECT_EQ(page->second.numberReturned, 2u);
+    EXPECT_EQ(page->second.totalMatches, 2);
+
+    page = browse(snapshot, 0, true, 1, 5);
+    ASSERT_TRUE(page);
+    EXPECT_EQ(page->first, R"(<o id="2" v="1"/>)");
+    EXPECT_EQ(page->second.numberReturned, 1u);
+    EXPECT_EQ(page->second.totalMatches, 2);
+
+    page = browse(snapshot, 11, false);
+    ASSERT_TRUE(page);
+    EXPECT_EQ(page->first, R"(<o id="11" v="1"/>)");
+
+    EXPECT_EQ(browse(snapshot, 3, true)->second.totalMatches, 0);
+    EXPECT_FALSE(browse(snapshot, 10, true));
+    EXPECT_FALSE(browse(snapshot, 99, false));
+}
+
+TEST_F(BrowseSnapshotTest, RebuildsChangedContainersOnly)
+{
+    BrowseSnapshot snapshot(file, std::chrono::seconds(30));
+    rebuild(snapshot);
+    EXPECT_EQ(listed, std::vector<int>({ 0, 1, 2, 3 }));
+
+    version = 2;
+    tree[1] = { 11, 12 };
+    snapshot.invalidate(1);
+    // the container and its parent, which lists the element of the container
+    EXPECT_FALSE(browse(snapshot, 1, true));
+    EXPECT_FALSE(browse(snapshot, 1, false));
+    EXPECT_FALSE(browse(snapshot, 0, true));
+    EXPECT_TRUE(browse(snapshot, 2, true));
+
+    listed.clear();
+    rebuild(snapshot);
+    EXPECT_EQ(listed, std::vector<int>({ 0, 1 }));
+    EXPECT_EQ(browse(snapshot, 1, true)->first, R"(<o id="11" v="2"/><o id="12" v="2"/>)");
+    // listed again with its parent
+    EXPECT_EQ(browse(snapshot, 2, false)->first, R"(<o id="2" v="2"/>)");
+    // kept from the previous file
+    EXPECT_EQ(browse(snapshot, 3, false)->first, R"(<o id="3" v="1"/>)");
+    EXPECT_FALSE(browse(snapshot, 10, false));
+
+    snapshot.clear();
+    EXPECT_FALSE(browse(snapshot, 2, true));
+    listed.clear();
+    rebuild(snapshot);
+    EXPECT_EQ(listed, std::vector<int>({ 0, 1, 2, 3 }));
+}
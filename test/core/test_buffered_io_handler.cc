@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include "iohandler/buffered_io_handler.h"
+#include "iohandler/mem_io_handler.h"
+
+#include "../mock/config_mock.h"
+
+static std::string readAll(IOHandler& handler)
+{
+    std::string result;
+    std::string buf(1000, '\0');
+    std::size_t bytes;
+    while ((bytes = handler.read(buf.data(), buf.size())) > 0)
+        result.append(buf, 0, bytes);
+    return result;
+}
+
+TEST(BufferedIOHandlerTest, ReusesPooledBuffers)
+{
+    auto config = std::make_shared<ConfigMock>();
+    std::string content(50000, 'x');
+    for (std::size_t i = 0; i < content.size(); i++)
+        content[i] = static_cast<char>(i % 249);
+
+    char* lastBuffer = nullptr;
+    for (int i = 0; i < 3; i++) {
+        std::unique_ptr<IOHandler> mem = std::make_unique<MemIOHandler>(content);
+        BufferedIOHandler handler(config, mem, 4096, 1024, 0);
+        handler.open(UPNP_READ);
+        EXPECT_EQ(readAll(handler), content);
+        handler.close();
+
+        // the buffer of a closed handler goes to the next one of the same size
+        auto buffer = IOBufferPool::getInstance().getBuffer(4096);
+        if (lastBuffer != nullptr)
+            EXPECT_EQ(buffer, lastBuffer);
+        lastBuffer = buffer;
+        IOBufferPool::getInstance().returnBuffer(buffer, 4096);
+    }
+}
+
+TEST(BufferedIOHandlerTest, SeeksWithinBuffer)
+{
+    auto config = std::make_shared<ConfigMock>();
+    std::string content(50000, 'x');
+    for (std::size_t i = 0; i < content.size(); i++)
+        content[i] = static_cast<char>(i % 249);
+
+    std::unique_ptr<IOHandler> mem = std::make_unique<MemIOHandler>(content);
+    // the first read waits until the buffer is full
+    BufferedIOHandler handler(config, mem, 4096, 1024, 4096);
+    handler.open(UPNP_READ);
+
+    std::string buf(100, '\0');
+    ASSERT_EQ(handler.read(buf.data(), buf.size()), buf.size());
+    EXPECT_EQ(buf, content.substr(0, 100));
+
+    // back into the data that was read already
+    handler.seek(50, SEEK_SET);
+    ASSERT_EQ(handler.read(buf.data(), 10), 10u);
+    EXPECT_EQ(buf.substr(0, 10), content.substr(50, 10));
+
+    // forward into the buffered data
+    handler.seek(2000, SEEK_SET);
+    ASSERT_EQ(handler.read(buf.data(), buf.size()), buf.size());
+    EXPECT_EQ(buf, content.substr(2000, 100));
+
+    // too far back, the underlying handler would have to seek
+    EXPECT_THROW(handler.seek(0, SEEK_SET), std::runtime_error);
+    handler.close();
+}
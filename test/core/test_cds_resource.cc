@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include "cds_resource.h"
+
+TEST(CdsResourceTest, DecodesEncodedResource)
+{
+    auto resource = std::make_shared<CdsResource>(CH_DEFAULT);
+    resource->addAttribute(R_PROTOCOLINFO, "http-get:*:audio/mpeg:*");
+    resource->addParameter("rct", "aa");
+    resource->addOption(RESOURCE_OPTION_URL, "http://host/a~b|c");
+
+    auto decoded = CdsResource::decode(resource->encode());
+    EXPECT_TRUE(decoded->equals(resource));
+    EXPECT_EQ(decoded->getOption(RESOURCE_OPTION_URL), "http://host/a~b|c");
+}
+
+TEST(CdsResourceTest, EncodesCompactly)
+{
+    auto resource = std::make_shared<CdsResource>(CH_DEFAULT);
+    resource->addAttribute(R_PROTOCOLINFO, "http-get:*:video/mp4:*");
+    resource->addAttribute(R_SIZE, "1234");
+
+    // the url encoded form written by earlier versions
+    auto legacy = CdsResource::decode("0~protocolInfo=http-get%3A%2A%3Avideo%2Fmp4%3A%2A&size=1234~~");
+    EXPECT_TRUE(legacy->equals(resource));
+
+    auto encoded = resource->encode();
+    EXPECT_LT(encoded.length(), std::string("0~protocolInfo=http-get%3A%2A%3Avideo%2Fmp4%3A%2A&size=1234~~").length());
+    EXPECT_TRUE(CdsResource::decode(encoded)->equals(resource));
+}
+
+TEST(CdsResourceTest, DecodesResourceWithoutOptions)
+{
+    auto decoded = CdsResource::decode("0~protocolInfo=http-get%3A%2A%3Avideo%2Fmp4%3A%2A~");
+    EXPECT_EQ(decoded->getHandlerType(), CH_DEFAULT);
+    EXPECT_EQ(decoded->getAttribute(R_PROTOCOLINFO), "http-get:*:video/mp4:*");
+    EXPECT_TRUE(decoded->getParameters().empty());
+    EXPECT_TRUE(decoded->getOptions().empty());
+
+    EXPECT_THROW(CdsResource::decode("0"), std::runtime_error);
+    EXPECT_THROW(CdsResource::decode("0~a~b~c~d"), std::runtime_error);
+}
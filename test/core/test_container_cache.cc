@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include "content/container_cache.h"
+
+#include "common.h"
+
+TEST(ContainerCacheTest, ReturnsStoredIds)
+{
+    ContainerCache cache;
+    cache.put("/Audio/Artists/A", 42);
+
+    EXPECT_EQ(cache.get("/Audio/Artists/A"), 42);
+    EXPECT_EQ(cache.get("/Audio/Artists/B"), INVALID_OBJECT_ID);
+
+    cache.clear();
+    EXPECT_EQ(cache.get("/Audio/Artists/A"), INVALID_OBJECT_ID);
+}
+
+TEST(ContainerCacheTest, EvictsLeastRecentlyUsed)
+{
+    ContainerCache cache(2);
+    cache.put("/a", 1);
+    cache.put("/b", 2);
+    EXPECT_EQ(cache.get("/a"), 1);
+    cache.put("/c", 3);
+
+    EXPECT_EQ(cache.get("/a"), 1);
+    EXPECT_EQ(cache.get("/b"), INVALID_OBJECT_ID);
+    EXPECT_EQ(cache.get("/c"), 3);
+}
+
+TEST(ContainerCacheTest, RemembersArtUntilCleared)
+{
+    ContainerCache cache(2);
+    EXPECT_EQ(cache.getArt(7), ContainerCache::Art::Unknown);
+    cache.setArt(7, ContainerCache::Art::NoFile);
+    cache.setArt(8, ContainerCache::Art::Assigned);
+    EXPECT_EQ(cache.getArt(7), ContainerCache::Art::NoFile);
+    EXPECT_EQ(cache.getArt(8), ContainerCache::Art::Assigned);
+
+    // a full cache starts over
+    cache.setArt(9, ContainerCache::Art::Assigned);
+    EXPECT_EQ(cache.getArt(7), ContainerCache::Art::Unknown);
+    EXPECT_EQ(cache.getArt(9), ContainerCache::Art::Assigned);
+
+    cache.clear();
+    EXPECT_EQ(cache.getArt(9), ContainerCache::Art::Unknown);
+}
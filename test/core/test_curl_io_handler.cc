@@ -0,0 +1,180 @@
+#ifdef HAVE_CURL
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include "iohandler/curl_io_handler.h"
+
+#include "../mock/config_mock.h"
+
+/// \brief answers GET requests with content, honours "Range: bytes=N-"
+class HttpServer {
+public:
+    explicit HttpServer(std::string content, bool ranges = true)
+        : content(std::move(content))
+        , ranges(ranges)
+    {
+        listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listenSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        listen(listenSocket, 8);
+        socklen_t len = sizeof(addr);
+        getsockname(listenSocket, reinterpret_cast<sockaddr*>(&addr), &len);
+        port = ntohs(addr.sin_port);
+        thread = std::thread([this] { serve(); });
+    }
+
+    ~HttpServer()
+    {
+        shutdown(listenSocket, SHUT_RDWR);
+        close(listenSocket);
+        thread.join();
+    }
+
+    std::string getURL() const { return fmt::format("http://127.0.0.1:{}/stream", port); }
+
+    std::atomic<int> connections { 0 };
+
+private:
+    void serve()
+    {
+        int client;
+        while ((client = accept(listenSocket, nullptr, nullptr)) >= 0) {
+            connections++;
+            std::thread([this, client] { answer(client); }).detach();
+        }
+    }
+
+    void answer(int client)
+    {
+        std::string request;
+        char buf[1024];
+        ssize_t bytes;
+        while (request.find("\r\n\r\n") == std::string::npos && (bytes = recv(client, buf, sizeof(buf), 0)) > 0)
+            request.append(buf, bytes);
+
+        std::size_t start = 0;
+        auto range = request.find("Range: bytes=");
+        if (ranges && range != std::string::npos)
+            start = std::stoul(request.substr(range + 13));
+        auto header = start > 0
+            ? fmt::format("HTTP/1.1 206 Partial Content\r\nContent-Range: bytes {}-{}/{}\r\n", start, content.size() - 1, content.size())
+            : std::string("HTTP/1.1 200 OK\r\n");
+        header += fmt::format("Content-Length: {}\r\nConnection: close\r\n\r\n", content.size() - start);
+        send(client, header.data(), header.size(), MSG_NOSIGNAL);
+        // sending blocks while the client pauses the transfer
+        for (std::size_t pos = start; pos < content.size();) {
+            bytes = send(client, content.data() + pos, std::min<std::size_t>(4096, content.size() - pos), MSG_NOSIGNAL);
+            if (bytes <= 0)
+                break;
+            pos += bytes;
+        }
+        close(client);
+    }
+
+    std::string content;
+    bool ranges;
+    int listenSocket;
+    int port;
+    std::thread thread;
+};
+
+class CurlIOHandlerTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        config = std::make_shared<ConfigMock>();
+        content.resize(1024 * 1024);
+        for (std::size_t i = 0; i < content.size(); i++)
+            content[i] = static_cast<char>(i % 251);
+        server = std::make_unique<HttpServer>(content);
+    }
+
+    static std::string readAll(IOHandler& handler, std::size_t chunk = 1000)
+    {
+        std::string result;
+        std::string buf(chunk, '\0');
+        std::size_t bytes;
+        while ((bytes = handler.read(buf.data(), buf.size())) > 0 && bytes != std::size_t(-1))
+            result.append(buf, 0, bytes);
+        return result;
+    }
+
+    std::shared_ptr<ConfigMock> config;
+    std::string content;
+    std::unique_ptr<HttpServer> server;
+};
+
+TEST_F(CurlIOHandlerTest, StreamsThroughSmallBuffer)
+{
+    // both transfers pause whenever their buffer is full
+    CurlIOHandler first(config, server->getURL(), nullptr, 2 * CURL_MAX_WRITE_SIZE, 0);
+    CurlIOHandler second(config, server->getURL(), nullptr, 2 * CURL_MAX_WRITE_SIZE, 0);
+    first.open(UPNP_READ);
+    second.open(UPNP_READ);
+
+    auto firstContent = readAll(first);
+    EXPECT_EQ(firstContent.size(), content.size());
+    EXPECT_TRUE(firstContent == content);
+    auto secondContent = readAll(second, 7000);
+    EXPECT_EQ(secondContent.size(), content.size());
+    EXPECT_TRUE(secondContent == content);
+    first.close();
+    second.close();
+}
+
+TEST_F(CurlIOHandlerTest, SeeksBehindBuffer)
+{
+    CurlIOHandler handler(config, server->getURL(), nullptr, 2 * CURL_MAX_WRITE_SIZE, 0);
+    handler.open(UPNP_READ);
+
+    std::string buf(100, '\0');
+    ASSERT_EQ(handler.read(buf.data(), buf.size()), buf.size());
+    EXPECT_EQ(buf, content.substr(0, 100));
+
+    handler.seek(700000, SEEK_SET);
+    auto rest = readAll(handler);
+    EXPECT_EQ(rest.size(), content.size() - 700000);
+    EXPECT_TRUE(rest == content.substr(700000));
+    handler.close();
+    EXPECT_EQ(server->connections.load(), 2);
+}
+
+TEST_F(CurlIOHandlerTest, ReadsThroughShortSeeks)
+{
+    CurlIOHandler handler(config, server->getURL(), nullptr, 2 * CURL_MAX_WRITE_SIZE, 0);
+    handler.open(UPNP_READ);
+
+    std::string buf(100, '\0');
+    ASSERT_EQ(handler.read(buf.data(), buf.size()), buf.size());
+    handler.seek(2 * CURL_MAX_WRITE_SIZE + 1000, SEEK_CUR);
+    ASSERT_EQ(handler.read(buf.data(), buf.size()), buf.size());
+    EXPECT_EQ(buf, content.substr(2 * CURL_MAX_WRITE_SIZE + 1100, 100));
+
+    handler.seek(-1000, SEEK_END);
+    auto rest = readAll(handler);
+    EXPECT_TRUE(rest == content.substr(content.size() - 1000));
+    handler.close();
+    EXPECT_EQ(server->connections.load(), 2);
+}
+
+TEST_F(CurlIOHandlerTest, SeeksWithoutRanges)
+{
+    HttpServer plain(content, false);
+    CurlIOHandler handler(config, plain.getURL(), nullptr, 2 * CURL_MAX_WRITE_SIZE, 0);
+    handler.open(UPNP_READ);
+
+    std::string buf(100, '\0');
+    ASSERT_EQ(handler.read(buf.data(), buf.size()), buf.size());
+    handler.seek(700000, SEEK_SET);
+    ASSERT_EQ(handler.read(buf.data(), buf.size()), buf.size());
+    EXPECT_EQ(buf, content.substr(700000, 100));
+    handler.close();
+}
+#endif
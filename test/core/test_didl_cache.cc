@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include "cds_objects.h"
+#include "didl_cache.h"
+
+static std::shared_ptr<CdsItem> makeItem(int id, int parentID)
+{
+    auto item = std::make_shared<CdsItem>();
+    item->setID(id);
+    item->setParentID(parentID);
+    item->setTitle("Title");
+    return item;
+}
+
+TEST(DidlCacheTest, ReturnsFragmentOfUnchangedObject)
+{
+    DidlCache cache(16);
+    auto item = makeItem(10, 2);
+    cache.put(item, 0, 100, "", "<item />");
+
+    auto fragment = cache.get(makeItem(10, 2), 0, 100, "");
+    ASSERT_NE(fragment, nullptr);
+    EXPECT_EQ(*fragment, "<item />");
+    EXPECT_EQ(cache.get(item, 1, 100, ""), nullptr);
+    EXPECT_EQ(cache.get(item, 0, 50, ""), nullptr);
+    EXPECT_EQ(cache.get(item, 0, 100, "dc:title"), nullptr);
+}
+
+TEST(DidlCacheTest, IgnoresChangedObjects)
+{
+    DidlCache cache(16);
+    cache.put(makeItem(10, 2), 0, 100, "", "<item />");
+
+    auto changed = makeItem(10, 2);
+    changed->setTitle("Title *");
+    EXPECT_EQ(cache.get(changed, 0, 100, ""), nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+
+    auto container = std::make_shared<CdsContainer>();
+    container->setID(2);
+    container->setUpdateID(1);
+    cache.put(container, 0, 100, "", "<container />");
+    container->setUpdateID(2);
+    EXPECT_EQ(cache.get(container, 0, 100, ""), nullptr);
+}
+
+TEST(DidlCacheTest, InvalidatesContainerAndChildren)
+{
+    DidlCache cache(16);
+    auto container = std::make_shared<CdsContainer>();
+    container->setID(2);
+    container->setParentID(1);
+    cache.put(container, 0, 100, "", "<container />");
+    cache.put(makeItem(10, 2), 0, 100, "", "<item />");
+    cache.put(makeItem(11, 3), 0, 100, "", "<item />");
+
+    cache.invalidate(2);
+    EXPECT_EQ(cache.get(container, 0, 100, ""), nullptr);
+    EXPECT_EQ(cache.get(makeItem(10, 2), 0, 100, ""), nullptr);
+    EXPECT_NE(cache.get(makeItem(11, 3), 0, 100, ""), nullptr);
+}
+
+TEST(DidlCacheTest, EvictsLeastRecentlyUsed)
+{
+    DidlCache cache(2);
+    cache.put(makeItem(10, 2), 0, 100, "", "<item />");
+    cache.put(makeItem(11, 2), 0, 100, "", "<item />");
+    cache.get(makeItem(10, 2), 0, 100, "");
+    cache.put(makeItem(12, 2), 0, 100, "", "<item />");
+
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_NE(cache.get(makeItem(10, 2), 0, 100, ""), nullptr);
+    EXPECT_EQ(cache.get(makeItem(11, 2), 0, 100, ""), nullptr);
+}
+
+TEST(DidlCacheTest, InvalidatesOnlyTheCurrentParent)
+{
+    DidlCache cache(16);
+    cache.put(makeItem(10, 2), 0, 100, "", "<item />");
+    // moved to another container
+    cache.put(makeItem(10, 3), 0, 100, "", "<item />");
+
+    cache.invalidate(2);
+    EXPECT_NE(cache.get(makeItem(10, 3), 0, 100, ""), nullptr);
+    cache.invalidate(3);
+    EXPECT_EQ(cache.size(), 0u);
+}
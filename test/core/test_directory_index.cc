@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+#include <fstream>
+#include <unistd.h>
+
+#include "metadata/directory_index.h"
+
+class DirectoryIndexTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        dir = fs::temp_directory_path() / fmt::format("gerbera-directories-{}", getpid());
+        fs::create_directories(dir / "covers");
+    }
+
+    void TearDown() override { fs::remove_all(dir); }
+
+    fs::path write(const fs::path& name)
+    {
+        auto path = dir / name;
+        std::ofstream(path) << "data";
+        return path;
+    }
+
+    fs::path dir;
+};
+
+TEST_F(DirectoryIndexTest, FindsFirstCandidate)
+{
+    DirectoryIndex index;
+    write("movie.mkv");
+    auto cover = write("Cover.jpg");
+    auto folder = write("folder.jpg");
+
+    EXPECT_EQ(index.find(dir, { "poster.jpg", "folder.jpg", "Cover.jpg" }, true), folder);
+    EXPECT_EQ(index.find(dir, { "cover.jpg" }, true), "");
+    EXPECT_EQ(index.find(dir, { "cover.jpg" }, false), cover);
+    // directories are not candidates
+    EXPECT_EQ(index.find(dir, { "covers" }, true), "");
+}
+
+TEST_F(DirectoryIndexTest, ListsAgainWhenDirectoryChanges)
+{
+    DirectoryIndex index;
+    write("movie.mkv");
+    EXPECT_EQ(index.find(dir, { "movie.srt" }, true), "");
+
+    auto subtitle = write("movie.srt");
+    // the listing is only read again if the directory mtime differs
+    fs::last_write_time(dir, fs::last_write_time(dir) + std::chrono::seconds(2));
+    EXPECT_EQ(index.find(dir, { "movie.srt" }, true), subtitle);
+}
+
+TEST_F(DirectoryIndexTest, ChecksNamesInSubfolders)
+{
+    DirectoryIndex index;
+    auto cover = write("covers/front.jpg");
+    EXPECT_EQ(index.find(dir, { "covers/front.jpg" }, true), cover);
+    EXPECT_EQ(index.find(dir / "missing", { "front.jpg" }, true), "");
+}
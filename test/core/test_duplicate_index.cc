@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "cds_objects.h"
+#include "metadata/duplicate_index.h"
+#include "metadata/metadata_handler.h"
+
+class DuplicateIndexTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        dir = fs::temp_directory_path() / fmt::format("gerbera-duplicates-{}", getpid());
+        fs::create_directories(dir);
+        // larger than both fingerprint blocks so the middle is not hashed
+        content.resize(200 * 1024);
+        for (std::size_t i = 0; i < content.size(); i++)
+            content[i] = static_cast<char>(i * 7 % 251);
+    }
+
+    void TearDown() override { fs::remove_all(dir); }
+
+    fs::path write(const std::string& name, const std::string& data)
+    {
+        auto path = dir / name;
+        std::ofstream(path, std::ios::binary) << data;
+        return path;
+    }
+
+    std::shared_ptr<CdsItem> find(DuplicateIndex& index, const fs::path& path, const std::string& mimeType = "audio/mpeg")
+    {
+        DuplicateIndex::FileIdentity identity;
+        EXPECT_TRUE(DuplicateIndex::identify(path, identity));
+        return index.find(path, identity, mimeType);
+    }
+
+    void add(DuplicateIndex& index, const fs::path& path)
+    {
+        auto item = std::make_shared<CdsItem>();
+        item->setLocation(path);
+        item->setMimeType("audio/mpeg");
+        item->setMetadata(M_TITLE, "Original");
+        DuplicateIndex::FileIdentity identity;
+        ASSERT_TRUE(DuplicateIndex::identify(path, identity));
+        index.add(path, identity, item);
+    }
+
+    fs::path dir;
+    std::string content;
+};
+
+TEST_F(DuplicateIndexTest, FindsCopiesAndHardlinks)
+{
+    DuplicateIndex index;
+    auto original = write("original.mp3", content);
+    add(index, original);
+
+    auto copy = find(index, write("copy.mp3", content));
+    ASSERT_NE(copy, nullptr);
+    EXPECT_EQ(copy->getMetadata(M_TITLE), "Original");
+
+    auto link = dir / "link.mp3";
+    fs::create_hard_link(original, link);
+    EXPECT_NE(find(index, link), nullptr);
+}
+
+TEST_F(DuplicateIndexTest, IgnoresDifferentFiles)
+{
+    DuplicateIndex index;
+    add(index, write("original.mp3", content));
+
+    auto changed = content;
+    changed.back() ^= 1;
+    EXPECT_EQ(find(index, write("changed.mp3", changed)), nullptr);
+    EXPECT_EQ(find(index, write("shorter.mp3", content.substr(1))), nullptr);
+    EXPECT_EQ(find(index, write("other.bin", content), "application/octet-stream"), nullptr);
+}
+
+TEST_F(DuplicateIndexTest, EvictsOldestEntries)
+{
+    DuplicateIndex index(1);
+    auto first = write("first.mp3", content);
+    add(index, first);
+    add(index, write("second.mp3", content.substr(1)));
+
+    EXPECT_EQ(find(index, write("first-copy.mp3", content)), nullptr);
+    EXPECT_NE(find(index, write("second-copy.mp3", content.substr(1))), nullptr);
+}
+
+TEST_F(DuplicateIndexTest, TouchKeepsIdentity)
+{
+    auto path = write("touched.mp3", content);
+    DuplicateIndex::FileIdentity before;
+    ASSERT_TRUE(DuplicateIndex::identify(path, before));
+    ASSERT_TRUE(DuplicateIndex::readFingerprint(path, before));
+
+    fs::last_write_time(path, fs::last_write_time(path) + std::chrono::hours(1));
+    DuplicateIndex::FileIdentity after;
+    ASSERT_TRUE(DuplicateIndex::identify(path, after));
+    ASSERT_TRUE(DuplicateIndex::readFingerprint(path, after));
+    EXPECT_NE(after.mtime, before.mtime);
+    EXPECT_EQ(after.inode, before.inode);
+    EXPECT_EQ(after.birthTime, before.birthTime);
+    EXPECT_EQ(after.head, before.head);
+    EXPECT_EQ(after.tail, before.tail);
+}
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "iohandler/file_io_handler.h"
+
+#include "../mock/config_mock.h"
+
+TEST(FileIOHandlerTest, ReadsRangeAfterSeek)
+{
+    auto path = fs::temp_directory_path() / fmt::format("gerbera-fileio-{}", getpid());
+    std::string content(100000, '\0');
+    for (std::size_t i = 0; i < content.size(); i++)
+        content[i] = static_cast<char>(i % 253);
+    std::ofstream(path, std::ios::binary) << content;
+
+    FileIOHandler handler(path);
+    handler.open(UPNP_READ);
+    handler.seek(1000, SEEK_SET);
+    EXPECT_EQ(handler.tell(), 1000);
+
+    std::string buf(40000, '\0');
+    EXPECT_EQ(handler.read(buf.data(), buf.size()), buf.size());
+    EXPECT_EQ(buf, content.substr(1000, 40000));
+
+    handler.seek(-10, SEEK_END);
+    EXPECT_EQ(handler.read(buf.data(), buf.size()), 10u);
+    EXPECT_EQ(buf.substr(0, 10), content.substr(content.size() - 10));
+    EXPECT_EQ(handler.read(buf.data(), buf.size()), 0u);
+    handler.close();
+
+    fs::remove(path);
+}
+
+TEST(FileIOHandlerTest, SeeksRelativeAfterReading)
+{
+    auto path = fs::temp_directory_path() / fmt::format("gerbera-fileio-seek-{}", getpid());
+    std::ofstream(path, std::ios::binary) << "0123456789abcdef";
+
+    FileIOHandler handler(path);
+    handler.open(UPNP_READ);
+    std::string buf(4, '\0');
+    EXPECT_EQ(handler.read(buf.data(), buf.size()), 4u);
+    EXPECT_EQ(buf, "0123");
+
+    handler.seek(6, SEEK_CUR);
+    EXPECT_EQ(handler.tell(), 10);
+    EXPECT_EQ(handler.read(buf.data(), buf.size()), 4u);
+    EXPECT_EQ(buf, "abcd");
+
+    handler.seek(2, SEEK_SET);
+    EXPECT_EQ(handler.read(buf.data(), buf.size()), 4u);
+    EXPECT_EQ(buf, "2345");
+    EXPECT_THROW(handler.seek(-1, SEEK_SET), std::runtime_error);
+    handler.close();
+
+    fs::remove(path);
+}
+
+TEST(FileIOHandlerTest, ReadsThroughReadAheadPool)
+{
+    auto path = fs::temp_directory_path() / fmt::format("gerbera-fileio-pool-{}", getpid());
+    std::string content(10000, '\0');
+    for (std::size_t i = 0; i < content.size(); i++)
+        content[i] = static_cast<char>(i % 251);
+    std::ofstream(path, std::ios::binary) << content;
+
+    auto pool = std::make_shared<ReadAheadPool>(std::make_shared<ConfigMock>(), 2, 1024, 3);
+    pool->run();
+    {
+        FileIOHandler handler(path, pool);
+        handler.open(UPNP_READ);
+
+        // reads straddle chunk borders and pass the end of the file
+        std::string result;
+        std::string buf(700, '\0');
+        std::size_t bytes;
+        while ((bytes = handler.read(buf.data(), buf.size())) > 0)
+            result.append(buf, 0, bytes);
+        EXPECT_EQ(result, content);
+
+        handler.seek(5000, SEEK_SET);
+        EXPECT_EQ(handler.read(buf.data(), buf.size()), buf.size());
+        EXPECT_EQ(buf, content.substr(5000, 700));
+        handler.close();
+    }
+    pool->shutdown();
+
+    fs::remove(path);
+}
+
+TEST(FileIOHandlerTest, SharesCachedChunks)
+{
+    auto path = fs::temp_directory_path() / fmt::format("gerbera-fileio-cache-{}", getpid());
+    std::string content(5000, '\0');
+    for (std::size_t i = 0; i < content.size(); i++)
+        content[i] = static_cast<char>(i % 241);
+    std::ofstream(path, std::ios::binary) << content;
+
+    auto pool = std::make_shared<ReadAheadPool>(std::make_shared<ConfigMock>(), 2, 1024, 2, 16 * 1024);
+    pool->run();
+    {
+        FileIOHandler first(path, pool);
+        FileIOHandler second(path, pool);
+        first.open(UPNP_READ);
+        second.open(UPNP_READ);
+
+        std::string buf(300, '\0');
+        EXPECT_EQ(first.read(buf.data(), buf.size()), buf.size());
+        // an unaligned start within a chunk the first stream requested already
+        second.seek(100, SEEK_SET);
+        EXPECT_EQ(second.read(buf.data(), buf.size()), buf.size());
+        EXPECT_EQ(buf, content.substr(100, 300));
+
+        first.close();
+        second.seek(4900, SEEK_SET);
+        EXPECT_EQ(second.read(buf.data(), buf.size()), 100u);
+        EXPECT_EQ(buf.substr(0, 100), content.substr(4900));
+        second.close();
+    }
+    pool->shutdown();
+
+    fs::remove(path);
+}
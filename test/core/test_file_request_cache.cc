@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "file_request_cache.h"
+
+TEST(FileRequestCache, ReusesRequestOfClient)
+{
+    FileRequestCache cache(std::chrono::seconds(60), 4);
+    auto request = std::make_shared<ResolvedFileRequest>();
+    auto token = cache.put("/content/media/object_id/1", "10.0.0.2", request);
+
+    const void* found = nullptr;
+    EXPECT_EQ(cache.get("/content/media/object_id/1", "10.0.0.2", found), request);
+    EXPECT_EQ(found, token);
+    EXPECT_EQ(cache.get("/content/media/object_id/1", "10.0.0.3", found), nullptr);
+
+    EXPECT_EQ(cache.get(token, "/content/media/object_id/1"), request);
+    EXPECT_EQ(cache.get(token, "/content/media/object_id/2"), nullptr);
+    EXPECT_EQ(cache.get(nullptr, "/content/media/object_id/1"), nullptr);
+}
+
+TEST(FileRequestCache, ReplacesAndEvicts)
+{
+    FileRequestCache cache(std::chrono::seconds(60), 2);
+    auto first = cache.put("/a", "client", std::make_shared<ResolvedFileRequest>());
+    auto second = cache.put("/a", "client", std::make_shared<ResolvedFileRequest>());
+    EXPECT_EQ(cache.get(first, "/a"), nullptr);
+    EXPECT_NE(cache.get(second, "/a"), nullptr);
+    EXPECT_EQ(cache.size(), 1u);
+
+    cache.put("/b", "client", std::make_shared<ResolvedFileRequest>());
+    cache.put("/c", "client", std::make_shared<ResolvedFileRequest>());
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(cache.get(second, "/a"), nullptr);
+}
+
+TEST(FileRequestCache, ExpiresEntries)
+{
+    FileRequestCache cache(std::chrono::seconds(0), 4);
+    auto token = cache.put("/a", "client", std::make_shared<ResolvedFileRequest>());
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    EXPECT_EQ(cache.get(token, "/a"), nullptr);
+    EXPECT_EQ(cache.size(), 0u);
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "transcoding/hardware_accelerators.h"
+#include "util/tools.h"
+
+class HardwareAcceleratorsTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        root = fs::temp_directory_path() / fmt::format("gerbera-hardware-{}", getpid());
+        fs::create_directories(root / "dev/dri");
+    }
+
+    void TearDown() override { fs::remove_all(root); }
+
+    void touch(const fs::path& path, const std::string& content = "")
+    {
+        fs::create_directories(root / path.parent_path());
+        std::ofstream(root / path) << content;
+    }
+
+    fs::path root;
+};
+
+TEST_F(HardwareAcceleratorsTest, FindsNothingWithoutDevices)
+{
+    touch("dev/dri/card0");
+    touch("dev/nvidiactl");
+
+    HardwareAccelerators accelerators(root);
+    EXPECT_TRUE(accelerators.getAvailable().empty());
+    EXPECT_TRUE(accelerators.isAvailable(""));
+    EXPECT_FALSE(accelerators.isAvailable(HW_VAAPI));
+    EXPECT_FALSE(accelerators.isAvailable(HW_NVENC));
+}
+
+TEST_F(HardwareAcceleratorsTest, FindsRenderNodes)
+{
+    touch("dev/dri/renderD128");
+    touch("sys/class/drm/renderD128/device/vendor", "0x1002\n");
+
+    HardwareAccelerators amd(root);
+    EXPECT_TRUE(amd.isAvailable(HW_VAAPI));
+    EXPECT_FALSE(amd.isAvailable(HW_QSV));
+
+    touch("dev/dri/renderD129");
+    touch("sys/class/drm/renderD129/device/vendor", "0x8086\n");
+    HardwareAccelerators intel(root);
+    EXPECT_EQ(intel.getAvailable(), std::vector<std::string>({ HW_QSV, HW_VAAPI }));
+}
+
+TEST_F(HardwareAcceleratorsTest, FindsNvidia)
+{
+    touch("dev/nvidia0");
+    EXPECT_FALSE(HardwareAccelerators(root).isAvailable(HW_NVENC));
+
+    touch("dev/nvidiactl");
+    EXPECT_TRUE(HardwareAccelerators(root).isAvailable(HW_NVENC));
+}
+
+TEST_F(HardwareAcceleratorsTest, SkipsDevicesWithoutAccess)
+{
+    if (getuid() == 0)
+        GTEST_SKIP() << "root can open every device";
+    touch("dev/dri/renderD128");
+    fs::permissions(root / "dev/dri/renderD128", fs::perms::none);
+    EXPECT_FALSE(HardwareAccelerators(root).isAvailable(HW_VAAPI));
+}
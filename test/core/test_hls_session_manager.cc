@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "cds_objects.h"
+#include "transcoding/hls_session_manager.h"
+#include "transcoding/transcode_scheduler.h"
+#include "transcoding/transcoding.h"
+#include "util/tools.h"
+
+class HlsSessionManagerTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        dir = fs::temp_directory_path() / fmt::format("gerbera-hls-{}", getpid());
+        fs::create_directories(dir);
+
+        // writes two segments and lists them in the playlist given as argument
+        script = dir / "transcoder.sh";
+        std::ofstream(script) << "d=$(dirname \"$1\")\n"
+                                 "echo one > \"$d/seg0.ts\"\n"
+                                 "echo two > \"$d/seg1.ts\"\n"
+                                 "printf '#EXTM3U\\n#EXTINF:4.0,\\nseg0.ts\\n#EXTINF:4.0,\\nseg1.ts\\n#EXT-X-ENDLIST\\n' > \"$1\"\n";
+
+        item = std::make_shared<CdsItem>();
+        item->setID(42);
+        item->setLocation(script);
+        item->setTitle("movie");
+    }
+
+    void TearDown() override { fs::remove_all(dir); }
+
+    std::shared_ptr<TranscodingProfile> profile(const std::string& name)
+    {
+        auto result = std::make_shared<TranscodingProfile>(TR_Hls, name);
+        result->setCommand("/bin/sh");
+        result->setArguments(fmt::format("{} %out", script.c_str()));
+        return result;
+    }
+
+    fs::path dir;
+    fs::path script;
+    std::shared_ptr<CdsItem> item;
+};
+
+TEST_F(HlsSessionManagerTest, ReadsSegmentsAndInitSegment)
+{
+    auto playlist = dir / "list.m3u8";
+    std::ofstream(playlist) << "#EXTM3U\n#EXT-X-MAP:URI=\"init.mp4\"\n#EXTINF:4.0,\nseg0.m4s\n#EXTINF:4.0,\n/abs/seg1.m4s\n";
+
+    EXPECT_EQ(HlsSessionManager::readSegments(playlist), std::vector<std::string>({ "init.mp4", "seg0.m4s", "seg1.m4s" }));
+    EXPECT_TRUE(HlsSessionManager::readSegments(dir / "missing.m3u8").empty());
+}
+
+TEST_F(HlsSessionManagerTest, ListsVariants)
+{
+    auto high = profile("hls-high");
+    high->setBandwidth(5000000);
+    auto low = profile("hls-low");
+
+    auto master = HlsSessionManager::getMasterPlaylist(item, { high, low }, { { "object_id", "42" } });
+    EXPECT_NE(master.find("#EXT-X-STREAM-INF:BANDWIDTH=5000000\n"), std::string::npos);
+    EXPECT_NE(master.find("#EXT-X-STREAM-INF:BANDWIDTH=0\n"), std::string::npos);
+    EXPECT_NE(master.find("pr_name/hls-low"), std::string::npos);
+    EXPECT_NE(master.find(fmt::format("{}/1", URL_PARAM_HLS_VARIANT)), std::string::npos);
+}
+
+TEST_F(HlsSessionManagerTest, ServesSegmentsOfSession)
+{
+    auto scheduler = std::make_shared<TranscodeScheduler>(0, std::chrono::milliseconds(0));
+    HlsSessionManager manager(nullptr, scheduler, dir, std::chrono::seconds(60), 1);
+
+    bool started = false;
+    auto playlist = manager.getPlaylist(item, profile("hls"), "client", { { "object_id", "42" } }, 0, started);
+    EXPECT_TRUE(started);
+    EXPECT_EQ(manager.getSessionCount(), 1u);
+    EXPECT_EQ(playlist.find("\nseg0.ts\n"), std::string::npos);
+    EXPECT_NE(playlist.find(fmt::format("{}/seg0%2Ets", URL_PARAM_HLS_FILE)), std::string::npos);
+
+    auto session = playlist.find(URL_PARAM_HLS_SESSION);
+    ASSERT_NE(session, std::string::npos);
+    auto sessionId = playlist.substr(session + strlen(URL_PARAM_HLS_SESSION) + 1);
+    sessionId = sessionId.substr(0, sessionId.find('/'));
+
+    auto segment = manager.getSegment(sessionId, "seg1.ts");
+    EXPECT_TRUE(fs::exists(segment));
+    EXPECT_THROW(manager.getSegment(sessionId, "../transcoder.sh"), std::runtime_error);
+    EXPECT_THROW(manager.getSegment("unknown", "seg0.ts"), std::runtime_error);
+
+    // the same client gets the running session
+    manager.getPlaylist(item, profile("hls"), "client", { { "object_id", "42" } }, 0, started);
+    EXPECT_FALSE(started);
+    EXPECT_EQ(manager.getSessionCount(), 1u);
+
+    manager.shutdown();
+    EXPECT_EQ(manager.getSessionCount(), 0u);
+    EXPECT_FALSE(fs::exists(segment.parent_path()));
+}
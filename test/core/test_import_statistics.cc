@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include "content/import_statistics.h"
+
+using Stage = ImportStatistics::Stage;
+
+TEST(ImportStatisticsTest, RecordsStagesWhenEnabled)
+{
+    ImportStatistics statistics(true);
+    {
+        ImportStatistics::StageTimer stageTimer(&statistics, Stage::Mime);
+    }
+    {
+        ImportStatistics::StageTimer stageTimer(&statistics, Stage::Mime);
+    }
+    statistics.addFiles(2);
+
+    auto snapshot = statistics.getSnapshot();
+    EXPECT_EQ(snapshot.stages.at(static_cast<std::size_t>(Stage::Mime)).calls, 2u);
+    EXPECT_EQ(snapshot.stages.at(static_cast<std::size_t>(Stage::Layout)).calls, 0u);
+    EXPECT_EQ(snapshot.files, 2u);
+}
+
+TEST(ImportStatisticsTest, IgnoresEverythingWhenDisabled)
+{
+    ImportStatistics statistics(false);
+    {
+        ImportStatistics::StageTimer stageTimer(&statistics, Stage::Layout);
+        ImportStatistics::StageTimer noStatistics(nullptr, Stage::Layout);
+    }
+    statistics.addFiles(5);
+
+    auto snapshot = statistics.getSnapshot();
+    EXPECT_EQ(snapshot.stages.at(static_cast<std::size_t>(Stage::Layout)).calls, 0u);
+    EXPECT_EQ(snapshot.files, 0u);
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "iohandler/io_handler_chainer.h"
+#include "iohandler/mem_io_handler.h"
+
+#include "../mock/config_mock.h"
+
+/// \brief collects everything written, slowly
+class SinkIOHandler : public IOHandler {
+public:
+    explicit SinkIOHandler(std::string& data)
+        : data(data)
+    {
+    }
+
+    size_t write(char* buf, size_t length) override
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        data.append(buf, length);
+        return length;
+    }
+
+private:
+    std::string& data;
+};
+
+TEST(IOHandlerChainer, CopiesAllData)
+{
+    std::string source;
+    for (int i = 0; i < 200000; i++)
+        source += static_cast<char>('a' + i % 26);
+
+    std::string received;
+    std::unique_ptr<IOHandler> readFrom = std::make_unique<MemIOHandler>(source);
+    std::unique_ptr<IOHandler> writeTo = std::make_unique<SinkIOHandler>(received);
+    IOHandlerChainer chainer(readFrom, writeTo, 1024, std::make_shared<ConfigMock>());
+
+    for (int i = 0; i < 1000 && chainer.getStatus() == 0; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    chainer.kill();
+
+    EXPECT_EQ(chainer.getStatus(), IOHC_NORMAL_SHUTDOWN);
+    EXPECT_EQ(received, source);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include "cds_objects.h"
+#include "metadata/metadata_registry.h"
+
+#include "../mock/config_mock.h"
+
+class SkipConfigMock : public ConfigMock {
+public:
+    std::map<std::string, std::string> getDictionaryOption(config_option_t option) const override
+    {
+        if (option == CFG_IMPORT_LIBOPTS_SKIP_EXTRACTORS)
+            return { { "audio/flac", "second, missing" } };
+        return ConfigMock::getDictionaryOption(option);
+    }
+};
+
+class MetadataRegistryTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        registry = std::make_shared<TestRegistry>(std::make_shared<SkipConfigMock>());
+        add("first", "audio");
+        add("second", "audio");
+        add("third", "image");
+    }
+
+    /// \brief registry without the extractors of the libraries compiled in
+    class TestRegistry : public MetadataRegistry {
+    public:
+        explicit TestRegistry(const std::shared_ptr<Config>& config)
+            : MetadataRegistry(config)
+        {
+            extractors.clear();
+        }
+        std::size_t getTableSize() const { return table.size(); }
+    };
+
+    void add(const std::string& name, const std::string& type)
+    {
+        registry->add({ name, ImportStatistics::Stage::Ffmpeg,
+            [this, type](const std::string& contentType, const std::shared_ptr<CdsItem>& item) {
+                applied++;
+                return startswith(item->getMimeType(), type);
+            },
+            [](const std::shared_ptr<Context>& context, const std::shared_ptr<CdsItem>& item, MetadataSource* source) {} });
+    }
+
+    std::vector<std::string> names(const std::string& mimeType)
+    {
+        auto item = std::make_shared<CdsItem>();
+        item->setMimeType(mimeType);
+        std::vector<std::string> result;
+        for (auto&& extractor : registry->getExtractors("", item))
+            result.push_back(extractor->name);
+        return result;
+    }
+
+    std::shared_ptr<TestRegistry> registry;
+    int applied { 0 };
+};
+
+TEST_F(MetadataRegistryTest, SelectsByMimeTypeInOrder)
+{
+    EXPECT_EQ(names("audio/mpeg"), std::vector<std::string>({ "first", "second" }));
+    EXPECT_EQ(names("image/png"), std::vector<std::string>({ "third" }));
+    EXPECT_TRUE(names("text/plain").empty());
+}
+
+TEST_F(MetadataRegistryTest, SkipsConfiguredExtractors)
+{
+    EXPECT_EQ(names("audio/flac"), std::vector<std::string>({ "first" }));
+}
+
+TEST_F(MetadataRegistryTest, KeepsDispatchTable)
+{
+    names("audio/mpeg");
+    EXPECT_EQ(applied, 3);
+    names("audio/mpeg");
+    EXPECT_EQ(applied, 3);
+    EXPECT_EQ(registry->getTableSize(), 1u);
+
+    add("fourth", "audio");
+    EXPECT_EQ(names("audio/mpeg"), std::vector<std::string>({ "first", "second", "fourth" }));
+}
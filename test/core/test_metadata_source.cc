@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "metadata/metadata_source.h"
+#include "util/tools.h"
+
+class MetadataSourceTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        path = fs::temp_directory_path() / fmt::format("gerbera-source-{}", getpid());
+        content.resize(300 * 1024);
+        for (std::size_t i = 0; i < content.size(); i++)
+            content[i] = static_cast<char>(i * 13 % 251);
+        std::ofstream(path, std::ios::binary) << content;
+    }
+
+    void TearDown() override { fs::remove(path); }
+
+    std::string read(MetadataSource& source, off_t offset, std::size_t length)
+    {
+        std::string buffer(length, '\0');
+        auto bytes = source.read(offset, buffer.data(), length);
+        EXPECT_GE(bytes, 0);
+        buffer.resize(std::max<ssize_t>(bytes, 0));
+        return buffer;
+    }
+
+    fs::path path;
+    std::string content;
+};
+
+TEST_F(MetadataSourceTest, ReadsAcrossBlocks)
+{
+    MetadataSource source(path);
+    EXPECT_EQ(source.getSize(), off_t(content.size()));
+
+    EXPECT_EQ(read(source, 0, 100), content.substr(0, 100));
+    // head into the middle, middle into the tail
+    EXPECT_EQ(read(source, 60 * 1024, 10 * 1024), content.substr(60 * 1024, 10 * 1024));
+    EXPECT_EQ(read(source, 230 * 1024, 10 * 1024), content.substr(230 * 1024, 10 * 1024));
+    EXPECT_EQ(read(source, 0, content.size()), content);
+    // the end is cut off
+    EXPECT_EQ(read(source, content.size() - 10, 100), content.substr(content.size() - 10));
+    EXPECT_EQ(read(source, content.size(), 100), "");
+}
+
+TEST_F(MetadataSourceTest, MapsTheFile)
+{
+    MetadataSource source(path);
+    auto data = source.map();
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(data), content.size()), content);
+}
+
+TEST_F(MetadataSourceTest, ReadsHead)
+{
+    MetadataSource source(path);
+    auto head = source.readHead(100 * 1024);
+    EXPECT_EQ(std::string(reinterpret_cast<const char*>(head.data()), head.size()), content.substr(0, 100 * 1024));
+    EXPECT_EQ(source.readHead(content.size() * 2).size(), content.size());
+}
+
+TEST_F(MetadataSourceTest, ThrowsOnMissingFile)
+{
+    EXPECT_THROW(MetadataSource(path.string() + ".missing"), std::runtime_error);
+}
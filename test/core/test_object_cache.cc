@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include "cds_objects.h"
+#include "database/object_cache.h"
+
+static std::shared_ptr<CdsObject> makeItem(int id, int refID = 0)
+{
+    auto item = std::make_shared<CdsItem>();
+    item->setID(id);
+    item->setRefID(refID);
+    item->setTitle("Title");
+    return item;
+}
+
+TEST(ObjectCache, ReturnsCopies)
+{
+    ObjectCache cache(4);
+    auto item = makeItem(10);
+    cache.put(item, cache.getGeneration());
+
+    auto cached = cache.get(10);
+    ASSERT_NE(cached, nullptr);
+    EXPECT_EQ(cached->getTitle(), "Title");
+
+    cached->setTitle("Changed");
+    EXPECT_EQ(cache.get(10)->getTitle(), "Title");
+    EXPECT_EQ(cache.getHits(), 2u);
+
+    EXPECT_EQ(cache.get(11), nullptr);
+    EXPECT_EQ(cache.getMisses(), 1u);
+}
+
+TEST(ObjectCache, EvictsLeastRecentlyUsed)
+{
+    ObjectCache cache(2);
+    cache.put(makeItem(1), cache.getGeneration());
+    cache.put(makeItem(2), cache.getGeneration(), "F/tmp/two");
+    cache.get(1);
+    cache.put(makeItem(3), cache.getGeneration());
+
+    EXPECT_NE(cache.get(1), nullptr);
+    EXPECT_EQ(cache.get(2), nullptr);
+    EXPECT_EQ(cache.getByLocation("F/tmp/two"), nullptr);
+    EXPECT_NE(cache.get(3), nullptr);
+}
+
+TEST(ObjectCache, EraseDropsReferencingObjects)
+{
+    ObjectCache cache(4);
+    cache.put(makeItem(1), cache.getGeneration(), "F/tmp/one");
+    cache.put(makeItem(2, 1), cache.getGeneration());
+    cache.put(makeItem(3), cache.getGeneration());
+
+    cache.erase({ 1 });
+    EXPECT_EQ(cache.getByLocation("F/tmp/one"), nullptr);
+    EXPECT_EQ(cache.get(2), nullptr);
+    EXPECT_NE(cache.get(3), nullptr);
+}
+
+TEST(ObjectCache, IgnoresObjectsLoadedBeforeInvalidation)
+{
+    ObjectCache cache(4);
+    auto generation = cache.getGeneration();
+    cache.erase({ 5 });
+    cache.put(makeItem(5), generation);
+    EXPECT_EQ(cache.get(5), nullptr);
+}
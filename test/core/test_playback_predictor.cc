@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "cds_objects.h"
+#include "iohandler/playback_predictor.h"
+#include "iohandler/read_ahead_pool.h"
+
+#include "../mock/config_mock.h"
+
+class CountingReadAheadPool : public ReadAheadPool {
+public:
+    using ReadAheadPool::ReadAheadPool;
+
+    std::size_t cachedChunks()
+    {
+        AutoLock lock(mutex);
+        return cache.size();
+    }
+};
+
+static std::shared_ptr<CdsObject> item(int id, const std::string& location)
+{
+    auto obj = std::make_shared<CdsItem>();
+    obj->setID(id);
+    obj->setLocation(location);
+    return obj;
+}
+
+TEST(PlaybackPredictorTest, FindsNextItemWithFile)
+{
+    auto container = std::make_shared<CdsContainer>();
+    container->setID(5);
+    std::vector<std::shared_ptr<CdsObject>> children { item(1, "/music/01.flac"), item(2, "/music/02.flac"), item(3, ""), container, item(4, "/music/04.flac") };
+
+    EXPECT_EQ(PlaybackPredictor::findNext(children, 1)->getID(), 2);
+    EXPECT_EQ(PlaybackPredictor::findNext(children, 2)->getID(), 4);
+    EXPECT_EQ(PlaybackPredictor::findNext(children, 4), nullptr);
+    EXPECT_EQ(PlaybackPredictor::findNext(children, 9), nullptr);
+}
+
+TEST(PlaybackPredictorTest, PrefetchesIntoCache)
+{
+    auto path = fs::temp_directory_path() / fmt::format("gerbera-predict-{}", getpid());
+    std::ofstream(path, std::ios::binary) << std::string(5000, 'x');
+
+    auto config = std::make_shared<ConfigMock>();
+    auto pool = std::make_shared<CountingReadAheadPool>(config, 1, 1024, 2, 16 * 1024);
+    pool->run();
+    PlaybackPredictor predictor(config, nullptr, pool, 3000);
+    predictor.prefetch(path);
+    // the chunks up to the prefetch size, rounded up to the chunk size
+    EXPECT_EQ(pool->cachedChunks(), 3u);
+    pool->shutdown();
+
+    // without a cache the kernel reads ahead
+    PlaybackPredictor advising(config, nullptr, nullptr, 3000);
+    advising.prefetch(path);
+    advising.prefetch(path.string() + ".missing");
+
+    fs::remove(path);
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+#include "content/playlist_parser.h"
+
+class PlaylistReader : public PlaylistParser {
+public:
+    using PlaylistParser::Entry;
+    using PlaylistParser::readM3u;
+    using PlaylistParser::readPls;
+};
+
+TEST(PlaylistParserTest, ReadsM3uWithTitles)
+{
+    std::istringstream file("#EXTM3U\r\n"
+                            "#EXTINF:123,First Song\r\n"
+                            "music/first.mp3\r\n"
+                            "\r\n"
+                            "# comment\n"
+                            "http://radio.example.com/stream\n");
+    auto entries = PlaylistReader::readM3u(file, nullptr);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].location, "music/first.mp3");
+    EXPECT_EQ(entries[0].title, "First Song");
+    EXPECT_EQ(entries[0].order, 0);
+    EXPECT_EQ(entries[1].location, "http://radio.example.com/stream");
+    EXPECT_EQ(entries[1].title, "");
+}
+
+TEST(PlaylistParserTest, ReadsPlsEntries)
+{
+    std::istringstream file("[playlist]\n"
+                            "NumberOfEntries=3\n"
+                            "File1=http://radio.example.com/one\n"
+                            "Title1=One\n"
+                            "Length1=-1\n"
+                            "Title2=Only a title\n"
+                            "file3 = /music/three.mp3\n"
+                            "Version=2\n");
+    auto entries = PlaylistReader::readPls(file, nullptr);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].location, "http://radio.example.com/one");
+    EXPECT_EQ(entries[0].title, "One");
+    EXPECT_EQ(entries[0].order, 1);
+    EXPECT_EQ(entries[1].location, "/music/three.mp3");
+    EXPECT_EQ(entries[1].title, "");
+    EXPECT_EQ(entries[1].order, 3);
+}
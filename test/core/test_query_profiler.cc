@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+
+#include "database/query_profiler.h"
+
+TEST(QueryProfilerTest, FingerprintReplacesLiterals)
+{
+    EXPECT_EQ(QueryProfiler::fingerprint("SELECT  *\n FROM \"mt_cds_object\" WHERE \"id\" = 42 AND \"dc_title\" = 'it''s 7'"),
+        "SELECT * FROM \"mt_cds_object\" WHERE \"id\" = ? AND \"dc_title\" = ?");
+    EXPECT_EQ(QueryProfiler::fingerprint("DELETE FROM mt_metadata WHERE item_id IN (1, 2,3)"),
+        "DELETE FROM mt_metadata WHERE item_id IN (?)");
+    EXPECT_EQ(QueryProfiler::fingerprint("INSERT INTO grb_file_state (a, b) VALUES (1, 'x'), (2, 'y')"),
+        "INSERT INTO grb_file_state (a, b) VALUES (?)");
+    EXPECT_EQ(QueryProfiler::fingerprint("SELECT col2 FROM t1 LIMIT 10"), "SELECT col2 FROM t1 LIMIT ?");
+}
+
+TEST(QueryProfilerTest, SumsUpPerFingerprint)
+{
+    QueryProfiler profiler(true, std::chrono::milliseconds(100), 2);
+    profiler.record("SELECT a FROM t WHERE id = 1", 1, std::chrono::milliseconds(10));
+    profiler.record("SELECT a FROM t WHERE id = 2", 0, std::chrono::milliseconds(200));
+    profiler.record("UPDATE t SET a = 3", -1, std::chrono::milliseconds(5));
+    // the limit of fingerprints is reached
+    profiler.record("DELETE FROM t", -1, std::chrono::seconds(1));
+
+    auto statistics = profiler.getStatistics();
+    ASSERT_EQ(statistics.size(), 2u);
+    EXPECT_EQ(statistics[0].fingerprint, "SELECT a FROM t WHERE id = ?");
+    EXPECT_EQ(statistics[0].count, 2u);
+    EXPECT_EQ(statistics[0].slow, 1u);
+    EXPECT_EQ(statistics[0].rows, 1u);
+    EXPECT_DOUBLE_EQ(statistics[0].totalMs, 210);
+    EXPECT_DOUBLE_EQ(statistics[0].maxMs, 200);
+    EXPECT_EQ(statistics[1].fingerprint, "UPDATE t SET a = ?");
+}
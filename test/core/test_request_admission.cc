@@ -0,0 +1,48 @@
+#include <gtest/gtest.h>
+
+#include "util/request_admission.h"
+
+TEST(RequestAdmission, KeepsReserveForTheOtherKind)
+{
+    RequestAdmission admission(4, 1, 2);
+    EXPECT_EQ(admission.getCapacity(RequestAdmission::Kind::Data), 3);
+    EXPECT_EQ(admission.getCapacity(RequestAdmission::Kind::Control), 2);
+
+    int streams[3];
+    for (auto&& stream : streams) {
+        ASSERT_TRUE(admission.acquire(RequestAdmission::Kind::Data));
+        admission.holdStream(&stream);
+    }
+    EXPECT_FALSE(admission.acquire(RequestAdmission::Kind::Data));
+    EXPECT_EQ(admission.getActive(RequestAdmission::Kind::Data), 3);
+
+    // the reserve still answers actions
+    EXPECT_TRUE(admission.acquire(RequestAdmission::Kind::Control));
+    EXPECT_TRUE(admission.acquire(RequestAdmission::Kind::Control));
+    EXPECT_FALSE(admission.acquire(RequestAdmission::Kind::Control));
+    admission.release(RequestAdmission::Kind::Control);
+    EXPECT_TRUE(admission.acquire(RequestAdmission::Kind::Control));
+
+    admission.releaseStream(&streams[1]);
+    EXPECT_EQ(admission.getActive(RequestAdmission::Kind::Data), 2);
+    // a stream without a data worker, like a page of the web UI
+    int page;
+    admission.releaseStream(&page);
+    admission.releaseStream(&streams[1]);
+    EXPECT_EQ(admission.getActive(RequestAdmission::Kind::Data), 2);
+    EXPECT_TRUE(admission.acquire(RequestAdmission::Kind::Data));
+}
+
+TEST(RequestAdmission, NoWorkersAdmitsAll)
+{
+    RequestAdmission admission(0, 2, 2);
+    for (int i = 0; i < 100; i++)
+        EXPECT_TRUE(admission.acquire(RequestAdmission::Kind::Data));
+    EXPECT_EQ(admission.getCapacity(RequestAdmission::Kind::Data), 0);
+}
+
+TEST(RequestAdmission, RefusesReserveOfAllWorkers)
+{
+    EXPECT_THROW(RequestAdmission(4, 4, 0), std::runtime_error);
+    EXPECT_THROW(RequestAdmission(4, 0, 5), std::runtime_error);
+}
@@ -372,11 +372,46 @@ TEST(SearchParser, SearchCriteriaWithExtendsOperator)
     DefaultSQLEmitter sqlEmitter;
     // derivedfromOpExpr
     EXPECT_TRUE(executeSearchParserTest(sqlEmitter, "upnp:class derivedfrom \"object.item.audioItem\"",
-        "c.upnp_class like lower('object.item.audioItem%')"));
+        "(c.upnp_class >= 'object.item.audioItem' and c.upnp_class < 'object.item.audioItem/')"));
 
     // derivedfromOpExpr and (containsOpExpr or containsOpExpr)
-    EXPECT_TRUE(executeSearchParserTest(sqlEmitter, "upnp:class derivedfrom \"object.item.audioItem\" and (dc:title contains \"britain\" or dc:creator contains \"britain\"", "c.upnp_class like lower('object.item.audioItem%') and ((m.property_name='dc:title' and lower(m.property_value) like lower('%britain%') and c.upnp_class is not null) or (m.property_name='dc:creator' and lower(m.property_value) like lower('%britain%') and c.upnp_class is not null))"));
+    EXPECT_TRUE(executeSearchParserTest(sqlEmitter, "upnp:class derivedfrom \"object.item.audioItem\" and (dc:title contains \"britain\" or dc:creator contains \"britain\"", "(c.upnp_class >= 'object.item.audioItem' and c.upnp_class < 'object.item.audioItem/') and ((m.property_name='dc:title' and lower(m.property_value) like lower('%britain%') and c.upnp_class is not null) or (m.property_name='dc:creator' and lower(m.property_value) like lower('%britain%') and c.upnp_class is not null))"));
 
     // derivedFromOpExpr and (containsOpExpr or containsOpExpr)
-    EXPECT_TRUE(executeSearchParserTest(sqlEmitter, "upnp:class derivedFrom \"object.item.audioItem\" and (dc:title contains \"britain\" or dc:creator contains \"britain\"", "c.upnp_class like lower('object.item.audioItem%') and ((m.property_name='dc:title' and lower(m.property_value) like lower('%britain%') and c.upnp_class is not null) or (m.property_name='dc:creator' and lower(m.property_value) like lower('%britain%') and c.upnp_class is not null))"));
+    EXPECT_TRUE(executeSearchParserTest(sqlEmitter, "upnp:class derivedFrom \"object.item.audioItem\" and (dc:title contains \"britain\" or dc:creator contains \"britain\"", "(c.upnp_class >= 'object.item.audioItem' and c.upnp_class < 'object.item.audioItem/') and ((m.property_name='dc:title' and lower(m.property_value) like lower('%britain%') and c.upnp_class is not null) or (m.property_name='dc:creator' and lower(m.property_value) like lower('%britain%') and c.upnp_class is not null))"));
+}
+
+TEST(SearchParser, SearchCriteriaUsingContainsOperatorWithFulltextIndex)
+{
+    SqliteFulltextSQLEmitter sqliteEmitter;
+    EXPECT_TRUE(executeSearchParserTest(sqliteEmitter, "upnp:album contains \"Scraps At\"",
+        "(m.property_name='upnp:album' and m.id in (select rowid from grb_metadata_fts where grb_metadata_fts match '\"Scraps\"* \"At\"*') and c.upnp_class is not null)"));
+
+    MysqlFulltextSQLEmitter mysqlEmitter;
+    EXPECT_TRUE(executeSearchParserTest(mysqlEmitter, "upnp:album contains \"Scraps At\"",
+        "(m.property_name='upnp:album' and match(m.property_value) against('+Scraps* +At*' in boolean mode) and c.upnp_class is not null)"));
+    // only operators, looked up literally
+    EXPECT_TRUE(executeSearchParserTest(mysqlEmitter, "upnp:album contains \"'-' ~\"",
+        "(m.property_name='upnp:album' and lower(m.property_value) like lower('%''-'' ~%') escape '|' and c.upnp_class is not null)"));
+
+    // other operators are not affected
+    EXPECT_TRUE(executeSearchParserTest(sqliteEmitter, "upnp:class derivedfrom \"object.item.audioItem\" and dc:title doesNotContain \"britain\"",
+        "(c.upnp_class >= 'object.item.audioItem' and c.upnp_class < 'object.item.audioItem/') and (m.property_name='dc:title' and lower(m.property_value) not like lower('%britain%') and c.upnp_class is not null)"));
+}
+
+TEST(SearchParser, DerivedFromUsesClassRange)
+{
+    DefaultSQLEmitter sqlEmitter;
+    EXPECT_TRUE(executeSearchParserTest(sqlEmitter, "upnp:class derivedfrom \"OBJECT.ITEM.videoitem\"",
+        "(c.upnp_class >= 'object.item.videoItem' and c.upnp_class < 'object.item.videoItem/')"));
+    EXPECT_TRUE(executeSearchParserTest(sqlEmitter, "upnp:class derivedfrom \"object.item.custom\"",
+        "(c.upnp_class >= 'object.item.custom' and c.upnp_class < 'object.item.custom/')"));
+}
+
+TEST(SearchParser, NormalizeCriteriaKeepsQuotedWhitespace)
+{
+    EXPECT_EQ(SearchParser::normalizeCriteria("  upnp:class   derivedfrom\t\"object.item.audioItem\" "),
+        "upnp:class derivedfrom \"object.item.audioItem\"");
+    EXPECT_EQ(SearchParser::normalizeCriteria("dc:title contains \"two  \\\"spaced  \" and  upnp:artist exists true"),
+        "dc:title contains \"two  \\\"spaced  \" and upnp:artist exists true");
 }
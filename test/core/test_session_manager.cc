@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "util/timer.h"
+#include "web/session_manager.h"
+
+#include "../mock/config_mock.h"
+
+class SessionManagerTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        config = std::make_shared<ConfigMock>();
+        timer = std::make_shared<Timer>(config);
+        timer->run();
+        sessionManager = std::make_unique<web::SessionManager>(config, timer);
+        session = sessionManager->createSession(std::chrono::seconds(60));
+        session->logIn();
+    }
+
+    void TearDown() override
+    {
+        sessionManager->removeSession(session->getID());
+        timer->shutdown();
+    }
+
+    std::shared_ptr<ConfigMock> config;
+    std::shared_ptr<Timer> timer;
+    std::unique_ptr<web::SessionManager> sessionManager;
+    std::shared_ptr<web::Session> session;
+};
+
+TEST_F(SessionManagerTest, CollectsSubscribedContainers)
+{
+    sessionManager->containerChangedUI(5);
+    EXPECT_EQ(session->getUIUpdateIDs(), "5");
+
+    session->subscribe({ 0, 7 });
+    sessionManager->containerChangedUI(5);
+    sessionManager->containerChangedUI(std::vector<int>({ 6, 8 }));
+    EXPECT_FALSE(session->hasUIUpdateIDs());
+
+    sessionManager->containerChangedUI(std::vector<int>({ 6, 7 }));
+    EXPECT_EQ(session->getUIUpdateIDs(), "7");
+}
+
+TEST_F(SessionManagerTest, WakesWaitingStream)
+{
+    EXPECT_FALSE(session->waitForUIUpdateIDs(std::chrono::milliseconds(10)));
+
+    std::thread change([this] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        sessionManager->containerChangedUI(3);
+    });
+    EXPECT_TRUE(session->waitForUIUpdateIDs(std::chrono::seconds(10)));
+    change.join();
+    EXPECT_EQ(session->getUIUpdateIDs(), "3");
+}
+
+TEST_F(SessionManagerTest, ReportsAllWhenTooManyChange)
+{
+    for (int i = 0; i < 100; i++)
+        sessionManager->containerChangedUI(4);
+    EXPECT_EQ(session->getUIUpdateIDs(), "4");
+
+    for (int i = 0; i < 20; i++)
+        sessionManager->containerChangedUI(i);
+    EXPECT_EQ(session->getUIUpdateIDs(), "all");
+    EXPECT_FALSE(session->hasUIUpdateIDs());
+
+    for (int i = 0; i < 1000; i++)
+        sessionManager->containerChangedUI(i);
+    EXPECT_EQ(session->getUIUpdateIDs(), "all");
+    sessionManager->containerChangedUI(9);
+    EXPECT_EQ(session->getUIUpdateIDs(), "9");
+}
+
+TEST_F(SessionManagerTest, FindsSessions)
+{
+    auto other = sessionManager->createSession(std::chrono::seconds(60));
+    EXPECT_EQ(sessionManager->getSession(other->getID()), other);
+    EXPECT_EQ(sessionManager->getSession(session->getID()), session);
+
+    sessionManager->removeSession(other->getID());
+    EXPECT_EQ(sessionManager->getSession(other->getID()), nullptr);
+    EXPECT_EQ(sessionManager->getSession(session->getID()), session);
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include "iohandler/mem_io_handler.h"
+#include "iohandler/spool_io_handler.h"
+
+#include "../mock/config_mock.h"
+
+class SpoolIOHandlerTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        config = std::make_shared<ConfigMock>();
+        content.resize(200000);
+        for (std::size_t i = 0; i < content.size(); i++)
+            content[i] = static_cast<char>(i % 251);
+    }
+
+    std::shared_ptr<ConfigMock> config;
+    std::string content;
+};
+
+TEST_F(SpoolIOHandlerTest, PassesDataThroughRing)
+{
+    // smaller than the content, so the file is written around several times
+    SpoolIOHandler handler(config, std::make_unique<MemIOHandler>(content), fs::temp_directory_path(), 7000);
+    handler.open(UPNP_READ);
+
+    std::string result;
+    std::string buf(3000, '\0');
+    std::size_t bytes;
+    while ((bytes = handler.read(buf.data(), buf.size())) > 0)
+        result.append(buf, 0, bytes);
+    handler.close();
+    EXPECT_EQ(result, content);
+}
+
+TEST_F(SpoolIOHandlerTest, WaitsForFillUpToSize)
+{
+    SpoolIOHandler handler(config, std::make_unique<MemIOHandler>(content), fs::temp_directory_path(), 50000);
+    handler.open(UPNP_READ);
+
+    // never more than the size is read ahead
+    EXPECT_EQ(handler.waitForFill(100000, std::chrono::seconds(10)), 50000u);
+
+    std::string buf(10, '\0');
+    ASSERT_EQ(handler.read(buf.data(), buf.size()), buf.size());
+    EXPECT_EQ(buf, content.substr(0, 10));
+    handler.close();
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "iohandler/mem_io_handler.h"
+#include "iohandler/metered_io_handler.h"
+#include "iohandler/stream_statistics.h"
+
+TEST(StreamStatistics, CountsReadsAndSeeks)
+{
+    auto statistics = std::make_shared<StreamStatistics>(true);
+    auto stream = statistics->start("10.0.0.2", 42, "/media/song.mp3");
+    {
+        MeteredIOHandler handler(std::make_unique<MemIOHandler>(std::string(1000, 'x')), statistics, stream);
+        handler.open(UPNP_READ);
+        char buf[400];
+        EXPECT_EQ(handler.read(buf, sizeof(buf)), 400u);
+        handler.seek(100, SEEK_SET);
+        EXPECT_EQ(handler.read(buf, sizeof(buf)), 400u);
+
+        auto snapshot = statistics->getSnapshot();
+        ASSERT_EQ(snapshot.size(), 1u);
+        EXPECT_TRUE(snapshot[0].active);
+        EXPECT_EQ(snapshot[0].client, "10.0.0.2");
+        EXPECT_EQ(snapshot[0].objectID, 42);
+        EXPECT_EQ(snapshot[0].bytes, 800u);
+        EXPECT_EQ(snapshot[0].reads, 2u);
+        EXPECT_EQ(snapshot[0].seeks, 1u);
+        EXPECT_GE(snapshot[0].firstByteMs, 0);
+        unsigned long reads = 0;
+        for (auto count : snapshot[0].latency)
+            reads += count;
+        EXPECT_EQ(reads, 2u);
+    }
+    // destroyed without close
+    auto snapshot = statistics->getSnapshot();
+    ASSERT_EQ(snapshot.size(), 1u);
+    EXPECT_FALSE(snapshot[0].active);
+}
+
+TEST(StreamStatistics, KeepsRecentlyFinished)
+{
+    StreamStatistics statistics(true, 2);
+    auto running = statistics.start("a", 1, "/1");
+    for (int i = 2; i <= 4; i++)
+        statistics.finish(statistics.start("a", i, "/" + std::to_string(i)));
+
+    auto snapshot = statistics.getSnapshot();
+    ASSERT_EQ(snapshot.size(), 3u);
+    EXPECT_EQ(snapshot[0].objectID, 1);
+    EXPECT_EQ(snapshot[1].objectID, 4);
+    EXPECT_EQ(snapshot[2].objectID, 3);
+    EXPECT_EQ(snapshot[1].firstByteMs, -1);
+}
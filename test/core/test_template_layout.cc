@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+
+#include "content/layout/template_layout.h"
+#include "upnp_common.h"
+
+TEST(TemplateLayoutTest, ExpandsPlaceholders)
+{
+    auto chain = TemplateLayout::parseChain("/Audio/Artists/%albumartist,artist%/%album|Unknown%");
+    EXPECT_EQ(chain.lastClass, UPNP_CLASS_MUSIC_ALBUM);
+
+    std::map<std::string, std::string> values { { "artist", "Artist" }, { "album", "Album" } };
+    EXPECT_EQ(TemplateLayout::expandChain(chain, values), "/Audio/Artists/Artist/Album");
+
+    values = { { "albumartist", "Various" }, { "artist", "Artist" } };
+    EXPECT_EQ(TemplateLayout::expandChain(chain, values), "/Audio/Artists/Various/Unknown");
+}
+
+TEST(TemplateLayoutTest, SkipsChainsWithoutValue)
+{
+    auto chain = TemplateLayout::parseChain("/Audio/Genres/%genre%");
+    EXPECT_EQ(chain.lastClass, UPNP_CLASS_MUSIC_GENRE);
+    EXPECT_EQ(TemplateLayout::expandChain(chain, {}), std::nullopt);
+
+    chain = TemplateLayout::parseChain("/Audio/Year %year%");
+    EXPECT_EQ(chain.lastClass, "");
+    EXPECT_EQ(TemplateLayout::expandChain(chain, { { "year", "2021" } }), "/Audio/Year 2021");
+}
+
+TEST(TemplateLayoutTest, RejectsBrokenTemplates)
+{
+    EXPECT_THROW(TemplateLayout::parseChain("/Audio/%artist"), std::runtime_error);
+    EXPECT_THROW(TemplateLayout::parseChain("/Audio/%|Unknown%"), std::runtime_error);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+#include <fstream>
+#include <unistd.h>
+
+#include "metadata/thumbnail_cache.h"
+
+class ThumbnailCacheTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        dir = fs::temp_directory_path() / fmt::format("gerbera-thumbnails-{}", getpid());
+        fs::create_directories(dir);
+    }
+
+    void TearDown() override { fs::remove_all(dir); }
+
+    static std::vector<std::byte> thumbnail(std::size_t size, char fill)
+    {
+        return std::vector<std::byte>(size, std::byte(fill));
+    }
+
+    fs::path dir;
+};
+
+TEST_F(ThumbnailCacheTest, KeyDependsOnFileVersion)
+{
+    auto key = ThumbnailCache::getKey("/video/a.mkv", 100, 2000);
+    EXPECT_EQ(key.size(), 32u);
+    EXPECT_EQ(key, ThumbnailCache::getKey("/video/a.mkv", 100, 2000));
+    EXPECT_NE(key, ThumbnailCache::getKey("/video/a.mkv", 101, 2000));
+    EXPECT_NE(key, ThumbnailCache::getKey("/video/a.mkv", 100, 2001));
+    EXPECT_NE(key, ThumbnailCache::getKey("/video/b.mkv", 100, 2000));
+}
+
+TEST_F(ThumbnailCacheTest, StoresInShards)
+{
+    ThumbnailCache cache(dir, 0);
+    auto key = ThumbnailCache::getKey("/video/a.mkv", 100, 2000);
+    EXPECT_FALSE(cache.get(key));
+    cache.put(key, thumbnail(10, 'a'));
+
+    EXPECT_TRUE(fs::exists(dir / key.substr(0, 2) / key.substr(2, 2) / (key + ".jpg")));
+    auto data = cache.get(key);
+    ASSERT_TRUE(data);
+    EXPECT_EQ(*data, thumbnail(10, 'a'));
+    EXPECT_EQ(cache.getSize(), 10u);
+}
+
+TEST_F(ThumbnailCacheTest, EvictsLeastRecentlyUsed)
+{
+    ThumbnailCache cache(dir, 25);
+    auto first = ThumbnailCache::getKey("/video/first.mkv", 1, 1);
+    auto second = ThumbnailCache::getKey("/video/second.mkv", 1, 1);
+    auto third = ThumbnailCache::getKey("/video/third.mkv", 1, 1);
+    cache.put(first, thumbnail(10, '1'));
+    cache.put(second, thumbnail(10, '2'));
+    ASSERT_TRUE(cache.get(first));
+    cache.put(third, thumbnail(10, '3'));
+
+    EXPECT_TRUE(cache.contains(first));
+    EXPECT_FALSE(cache.contains(second));
+    EXPECT_TRUE(cache.contains(third));
+    EXPECT_EQ(cache.getSize(), 20u);
+    EXPECT_FALSE(fs::exists(dir / second.substr(0, 2) / second.substr(2, 2) / (second + ".jpg")));
+}
+
+TEST_F(ThumbnailCacheTest, LoadsExistingThumbnails)
+{
+    auto key = ThumbnailCache::getKey("/video/a.mkv", 100, 2000);
+    {
+        ThumbnailCache cache(dir, 0);
+        cache.put(key, thumbnail(10, 'a'));
+    }
+    // thumbnails of the old layout are left alone
+    fs::create_directories(dir / "video");
+    std::ofstream(dir / "video" / "b.mkv-thumb.jpg") << "old";
+
+    ThumbnailCache cache(dir, 0);
+    EXPECT_FALSE(cache.contains(key));
+    cache.load();
+    EXPECT_TRUE(cache.contains(key));
+    EXPECT_EQ(cache.getSize(), 10u);
+    EXPECT_TRUE(fs::exists(dir / "video" / "b.mkv-thumb.jpg"));
+}
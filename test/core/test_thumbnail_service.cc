@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "metadata/thumbnail_service.h"
+
+#include "../mock/config_mock.h"
+
+class ThumbnailServiceTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        config = std::make_shared<ConfigMock>();
+        gate = release.get_future().share();
+    }
+
+    /// \brief generator that records the files and waits for release on the first one
+    ThumbnailService::Generator recording()
+    {
+        return [this](const fs::path& location) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                generated.push_back(location);
+            }
+            if (location == "/video/first.mkv") {
+                started.set_value();
+                gate.wait();
+            }
+            if (location == "/video/broken.mkv")
+                throw std::runtime_error("broken");
+            auto name = location.filename().string();
+            return std::vector<std::byte>(reinterpret_cast<const std::byte*>(name.data()), reinterpret_cast<const std::byte*>(name.data()) + name.size());
+        };
+    }
+
+    /// \brief occupy the only thread with the first file
+    std::thread blockThread(ThumbnailService& service)
+    {
+        std::thread client([&service] { service.get("/video/first.mkv", 0, 0); });
+        started.get_future().wait();
+        return client;
+    }
+
+    std::shared_ptr<ConfigMock> config;
+    std::promise<void> started;
+    std::promise<void> release;
+    std::shared_future<void> gate;
+    std::mutex mutex;
+    std::vector<fs::path> generated;
+};
+
+TEST_F(ThumbnailServiceTest, GeneratesEachFileOnce)
+{
+    ThumbnailService service(config, recording(), 2, 10);
+    service.run();
+    auto first = blockThread(service);
+
+    std::vector<ThumbnailService::Thumbnail> results(3);
+    std::vector<std::thread> waiters;
+    for (auto&& result : results)
+        waiters.emplace_back([&] { result = service.get("/video/first.mkv", 0, 0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release.set_value();
+    first.join();
+    for (auto&& waiter : waiters)
+        waiter.join();
+
+    EXPECT_EQ(generated, std::vector<fs::path>({ "/video/first.mkv" }));
+    for (auto&& result : results) {
+        ASSERT_NE(result, nullptr);
+        EXPECT_EQ(result, results.front());
+        EXPECT_EQ(result->size(), std::string("first.mkv").size());
+    }
+    service.shutdown();
+}
+
+TEST_F(ThumbnailServiceTest, ClientsGoBeforePrefetch)
+{
+    ThumbnailService service(config, recording(), 1, 10);
+    service.run();
+    auto first = blockThread(service);
+
+    EXPECT_TRUE(service.prefetch("/video/a.mkv", 0, 0));
+    EXPECT_TRUE(service.prefetch("/video/b.mkv", 0, 0));
+    std::thread client([&] { service.get("/video/b.mkv", 0, 0); });
+    std::thread other([&] { service.get("/video/c.mkv", 0, 0); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    release.set_value();
+    first.join();
+    client.join();
+    other.join();
+    service.shutdown();
+
+    // the prefetched a either ran last or was dropped at shutdown
+    ASSERT_GE(generated.size(), 3u);
+    std::sort(generated.begin() + 1, generated.begin() + 3);
+    EXPECT_EQ(std::vector<fs::path>(generated.begin(), generated.begin() + 3), std::vector<fs::path>({ "/video/first.mkv", "/video/b.mkv", "/video/c.mkv" }));
+}
+
+TEST_F(ThumbnailServiceTest, BoundsTheQueue)
+{
+    ThumbnailService service(config, recording(), 1, 1);
+    service.run();
+    auto first = blockThread(service);
+
+    EXPECT_TRUE(service.prefetch("/video/a.mkv", 0, 0));
+    EXPECT_FALSE(service.prefetch("/video/b.mkv", 0, 0));
+    EXPECT_THROW(service.get("/video/c.mkv", 0, 0), std::runtime_error);
+    release.set_value();
+    first.join();
+    service.shutdown();
+    EXPECT_FALSE(service.prefetch("/video/d.mkv", 0, 0));
+}
+
+TEST_F(ThumbnailServiceTest, GeneratesInCallerWithoutThreads)
+{
+    ThumbnailService service(config, recording(), 0, 10);
+    service.run();
+    EXPECT_FALSE(service.prefetch("/video/a.mkv", 0, 0));
+    auto thumbnail = service.get("/video/c.mkv", 0, 0);
+    ASSERT_NE(thumbnail, nullptr);
+    EXPECT_THROW(service.get("/video/broken.mkv", 0, 0), std::runtime_error);
+    EXPECT_EQ(generated, std::vector<fs::path>({ "/video/c.mkv", "/video/broken.mkv" }));
+}
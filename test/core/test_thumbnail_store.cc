@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include "iohandler/io_handler.h"
+#include "iohandler/thumbnail_store.h"
+
+class ThumbnailStoreTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        file = fs::temp_directory_path() / fmt::format("gerbera-thumbnails-{}.store", getpid());
+        statbuf = {};
+        statbuf.st_mtime = 1000;
+        statbuf.st_size = 4711;
+    }
+
+    void TearDown() override { fs::remove(file); }
+
+    static std::string readAll(std::unique_ptr<IOHandler> handler)
+    {
+        std::string data;
+        char buf[7];
+        handler->open(UPNP_READ);
+        for (std::size_t bytes; (bytes = handler->read(buf, sizeof(buf))) > 0;)
+            data.append(buf, bytes);
+        handler->close();
+        return data;
+    }
+
+    fs::path file;
+    struct stat statbuf;
+};
+
+TEST_F(ThumbnailStoreTest, ServesStoredData)
+{
+    ThumbnailStore store(file, 4096);
+    EXPECT_EQ(store.get(1, 0, statbuf), nullptr);
+
+    auto stored = store.put(1, 0, statbuf, "cover of one");
+    ASSERT_NE(stored, nullptr);
+    EXPECT_EQ(readAll(std::move(stored)), "cover of one");
+    EXPECT_EQ(readAll(store.get(1, 0, statbuf)), "cover of one");
+    EXPECT_EQ(store.get(1, 1, statbuf), nullptr);
+
+    auto changed = statbuf;
+    changed.st_mtime++;
+    EXPECT_EQ(store.get(1, 0, changed), nullptr);
+
+    // larger than a quarter of the store
+    EXPECT_EQ(store.put(2, 0, statbuf, std::string(2048, 'x')), nullptr);
+}
+
+TEST_F(ThumbnailStoreTest, KeepsDataAcrossRestarts)
+{
+    {
+        ThumbnailStore store(file, 4096);
+        store.put(1, 0, statbuf, "first");
+        store.put(2, 3, statbuf, "second");
+        store.put(1, 0, statbuf, "replaced");
+    }
+    ThumbnailStore store(file, 4096);
+    EXPECT_EQ(store.getCount(), 2u);
+    EXPECT_EQ(readAll(store.get(1, 0, statbuf)), "replaced");
+    EXPECT_EQ(readAll(store.get(2, 3, statbuf)), "second");
+}
+
+TEST_F(ThumbnailStoreTest, StartsOverWhenFull)
+{
+    ThumbnailStore store(file, 4096);
+    auto first = store.put(1, 0, statbuf, std::string(900, 'a'));
+    for (int id = 2; id <= 5; id++)
+        store.put(id, 0, statbuf, std::string(900, 'b'));
+
+    EXPECT_EQ(store.get(1, 0, statbuf), nullptr);
+    EXPECT_NE(store.get(5, 0, statbuf), nullptr);
+    EXPECT_EQ(store.getCount(), 1u);
+    // served data stays valid after the file was replaced
+    EXPECT_EQ(readAll(std::move(first)), std::string(900, 'a'));
+}
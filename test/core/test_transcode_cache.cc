@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <future>
+
+#include "iohandler/mem_io_handler.h"
+#include "transcoding/transcode_cache.h"
+
+/// \brief hands out its data one chunk per released permit, like a slow transcoder
+class GatedIOHandler : public IOHandler {
+public:
+    explicit GatedIOHandler(std::string data)
+        : data(std::move(data))
+    {
+    }
+
+    void release(std::size_t chunks = 1)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        permits += chunks;
+        cond.notify_all();
+    }
+
+    void open(enum UpnpOpenFileMode mode) override { }
+
+    size_t read(char* buf, size_t length) override
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this] { return permits > 0 || closed; });
+        if (closed)
+            return -1;
+        permits--;
+        auto bytes = std::min(length, std::min(CHUNK, data.size() - pos));
+        data.copy(buf, bytes, pos);
+        pos += bytes;
+        return bytes;
+    }
+
+    void close() override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        cond.notify_all();
+    }
+
+    static constexpr std::size_t CHUNK = 10;
+
+private:
+    std::string data;
+    std::size_t pos { 0 };
+    std::size_t permits { 0 };
+    bool closed { false };
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+class TranscodeCacheTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        dir = fs::temp_directory_path() / fmt::format("gerbera-transcode-cache-{}", getpid());
+    }
+
+    void TearDown() override { fs::remove_all(dir); }
+
+    static std::string readAll(IOHandler& handler)
+    {
+        std::string result;
+        char buf[7];
+        size_t bytes;
+        while ((bytes = handler.read(buf, sizeof(buf))) > 0 && bytes != size_t(-1))
+            result.append(buf, bytes);
+        return result;
+    }
+
+    static std::unique_ptr<IOHandler> source(const std::string& data)
+    {
+        return std::make_unique<MemIOHandler>(data);
+    }
+
+    fs::path dir;
+};
+
+TEST_F(TranscodeCacheTest, ServesRepeatedRequestsFromCache)
+{
+    auto cache = std::make_shared<TranscodeCache>(dir, 1024);
+    EXPECT_EQ(cache->get("1|mp3"), nullptr);
+
+    auto first = cache->add("1|mp3", source("transcoded output"));
+    first->open(UPNP_READ);
+    EXPECT_EQ(readAll(*first), "transcoded output");
+    first->close();
+
+    auto second = cache->get("1|mp3");
+    ASSERT_NE(second, nullptr);
+    second->open(UPNP_READ);
+    second->seek(-6, SEEK_END);
+    EXPECT_EQ(readAll(*second), "output");
+    second->close();
+    EXPECT_EQ(cache->get("1|ogg"), nullptr);
+}
+
+TEST_F(TranscodeCacheTest, ReadersFollowTheTranscoder)
+{
+    auto cache = std::make_shared<TranscodeCache>(dir, 1024);
+    std::string data(35, 'x');
+    for (std::size_t i = 0; i < data.size(); i++)
+        data[i] = char('a' + i % 26);
+    auto gated = std::make_unique<GatedIOHandler>(data);
+    auto gate = gated.get();
+
+    auto first = cache->add("2|mp3", std::move(gated));
+    first->open(UPNP_READ);
+    gate->release();
+    char buf[64];
+    EXPECT_EQ(first->read(buf, sizeof(buf)), GatedIOHandler::CHUNK);
+
+    // a second client joins while the transcoder is still running
+    auto second = cache->get("2|mp3");
+    ASSERT_NE(second, nullptr);
+    second->open(UPNP_READ);
+    EXPECT_THROW(second->seek(0, SEEK_END), std::runtime_error);
+    EXPECT_THROW(second->seek(20, SEEK_SET), std::runtime_error);
+
+    auto rest = std::async(std::launch::async, [&] { return readAll(*second); });
+    gate->release(5);
+    EXPECT_EQ(rest.get(), data);
+    EXPECT_EQ(readAll(*first), data.substr(GatedIOHandler::CHUNK));
+    first->close();
+    second->close();
+}
+
+TEST_F(TranscodeCacheTest, EvictsLeastRecentlyUsed)
+{
+    auto cache = std::make_shared<TranscodeCache>(dir, 25);
+    for (auto&& key : { "a", "b", "c" }) {
+        auto reader = cache->add(key, source(std::string(10, key[0])));
+        reader->open(UPNP_READ);
+        EXPECT_EQ(readAll(*reader), std::string(10, key[0]));
+        reader->close();
+        if (std::string(key) == "b") {
+            // keep a in use so b is the oldest one
+            reader = cache->get("a");
+            reader->open(UPNP_READ);
+            reader->close();
+        }
+    }
+
+    EXPECT_NE(cache->get("a"), nullptr);
+    EXPECT_EQ(cache->get("b"), nullptr);
+    EXPECT_NE(cache->get("c"), nullptr);
+    EXPECT_LE(cache->getSize(), 25u);
+}
+
+TEST_F(TranscodeCacheTest, DropsFailedTranscoding)
+{
+    auto cache = std::make_shared<TranscodeCache>(dir, 1024);
+    auto gated = std::make_unique<GatedIOHandler>("never produced");
+    auto gate = gated.get();
+    auto reader = cache->add("3|mp3", std::move(gated));
+    reader->open(UPNP_READ);
+    auto result = std::async(std::launch::async, [&] { char buf[8]; return reader->read(buf, sizeof(buf)); });
+
+    // the transcoding process dies
+    gate->close();
+    ASSERT_EQ(result.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(result.get(), size_t(-1));
+    reader->close();
+    EXPECT_EQ(cache->get("3|mp3"), nullptr);
+
+    cache->shutdown();
+    EXPECT_THROW(cache->add("4|mp3", source("late")), std::runtime_error);
+}
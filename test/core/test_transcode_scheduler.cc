@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <future>
+#include <thread>
+
+#include "transcoding/transcode_scheduler.h"
+#include "transcoding/transcoding.h"
+#include "transcoding/transcoding_process_executor.h"
+
+class TranscodeSchedulerTest : public ::testing::Test {
+public:
+    static std::shared_ptr<TranscodingProfile> profile(const std::string& name, int maxConcurrent = 0)
+    {
+        auto result = std::make_shared<TranscodingProfile>(TR_External, name);
+        result->setMaxConcurrent(maxConcurrent);
+        return result;
+    }
+};
+
+TEST_F(TranscodeSchedulerTest, LimitsProfiles)
+{
+    auto scheduler = std::make_shared<TranscodeScheduler>(0, std::chrono::milliseconds(0));
+    auto hardware = profile("vaapi", 1);
+
+    auto first = scheduler->acquire({ hardware });
+    EXPECT_EQ(first->getProfile(), hardware);
+    EXPECT_THROW(scheduler->acquire({ hardware }), std::runtime_error);
+
+    first.reset();
+    EXPECT_NE(scheduler->acquire({ hardware }), nullptr);
+
+    auto states = scheduler->getProfileStates();
+    ASSERT_EQ(states.size(), 1u);
+    EXPECT_EQ(states.front().started, 2);
+    EXPECT_EQ(states.front().rejected, 1);
+    EXPECT_EQ(scheduler->getRunning(), 0);
+}
+
+TEST_F(TranscodeSchedulerTest, PrefersFirstFreeCandidate)
+{
+    auto scheduler = std::make_shared<TranscodeScheduler>(0, std::chrono::milliseconds(0));
+    auto hardware = profile("vaapi", 1);
+    auto software = profile("x264");
+
+    auto first = scheduler->acquire({ hardware, software });
+    auto second = scheduler->acquire({ hardware, software });
+    EXPECT_EQ(first->getProfile(), hardware);
+    EXPECT_EQ(second->getProfile(), software);
+
+    first.reset();
+    EXPECT_EQ(scheduler->acquire({ hardware, software })->getProfile(), hardware);
+}
+
+TEST_F(TranscodeSchedulerTest, QueuesUntilSlotIsFree)
+{
+    auto scheduler = std::make_shared<TranscodeScheduler>(1, std::chrono::seconds(10));
+    auto first = scheduler->acquire({ profile("a") });
+
+    auto waiting = std::async(std::launch::async, [&] { return scheduler->acquire({ profile("b") }); });
+    while (scheduler->getQueued() == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_EQ(waiting.wait_for(std::chrono::milliseconds(10)), std::future_status::timeout);
+
+    first.reset();
+    ASSERT_EQ(waiting.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(waiting.get()->getProfile()->getName(), "b");
+    EXPECT_EQ(scheduler->getQueued(), 0);
+}
+
+TEST_F(TranscodeSchedulerTest, ShutdownRejectsWaiting)
+{
+    auto scheduler = std::make_shared<TranscodeScheduler>(1, std::chrono::seconds(10));
+    auto first = scheduler->acquire({ profile("a") });
+
+    auto waiting = std::async(std::launch::async, [&] { return scheduler->acquire({ profile("a") }); });
+    while (scheduler->getQueued() == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    scheduler->shutdown();
+    ASSERT_EQ(waiting.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_THROW(waiting.get(), std::runtime_error);
+}
+
+TEST_F(TranscodeSchedulerTest, CountsHealthOfGivenBackSlots)
+{
+    auto scheduler = std::make_shared<TranscodeScheduler>(0, std::chrono::milliseconds(0));
+    {
+        auto slot = scheduler->acquire({ profile("x264") });
+        slot->addBytes(1000);
+        slot->addStall();
+        slot->addRestart();
+    }
+    {
+        // a failing transcoder with an ffmpeg style status line
+        auto process = std::make_shared<TranscodingProcessExecutor>("/bin/sh",
+            std::vector<std::string> { "-c", "printf 'frame=  50 time=00:01:02.50 bitrate=N/A\\r' >&2; exit 1" }, -1, true);
+        process->setSlot(scheduler->acquire({ profile("x264") }));
+        while (process->isAlive())
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        process->readErrors();
+        EXPECT_EQ(process->getProgress(), 62500);
+    }
+
+    auto states = scheduler->getProfileStates();
+    ASSERT_EQ(states.size(), 1u);
+    EXPECT_EQ(states.front().bytes, 1000u);
+    EXPECT_EQ(states.front().stalls, 1);
+    EXPECT_EQ(states.front().restarts, 1);
+    EXPECT_EQ(states.front().failures, 1);
+    EXPECT_DOUBLE_EQ(states.front().mediaSeconds, 62.5);
+    EXPECT_GT(states.front().seconds, 0);
+}
+
+TEST_F(TranscodeSchedulerTest, ParsesProgressLines)
+{
+    EXPECT_EQ(TranscodingProcessExecutor::parseProgress("size=  1024kB time=01:00:00.04 bitrate= 800kbits/s"), 3600040);
+    EXPECT_EQ(TranscodingProcessExecutor::parseProgress("size=  1024kB time=N/A bitrate=N/A"), -1);
+    EXPECT_EQ(TranscodingProcessExecutor::parseProgress("Input #0, matroska,webm, from 'movie.mkv':"), -1);
+}
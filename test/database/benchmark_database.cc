@@ -0,0 +1,276 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    benchmark_database.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file benchmark_database.cc
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fmt/format.h>
+#include <set>
+#include <unistd.h>
+
+#include "cds_objects.h"
+#include "database/sqlite3/sqlite_database.h"
+#include "metadata/metadata_handler.h"
+#include "upnp_common.h"
+#include "util/timer.h"
+#include "util/tools.h"
+
+#ifdef HAVE_MYSQL
+#include "database/mysql/mysql_database.h"
+#endif
+
+#include "../mock/config_mock.h"
+
+/// \brief tracks per album and albums per artist of the generated library
+static constexpr int TRACKS_PER_ALBUM = 10;
+static constexpr int ALBUMS_PER_ARTIST = 10;
+
+static std::string env(const char* name, const std::string& defaultValue = "")
+{
+    auto value = std::getenv(name);
+    return value ? value : defaultValue;
+}
+
+/// \brief the storage options of both drivers, with the defaults of the server
+class DatabaseBenchmarkConfig : public ConfigMock {
+public:
+    DatabaseBenchmarkConfig(const fs::path& databaseFile)
+    {
+        ON_CALL(*this, getOption(_)).WillByDefault(Return(""));
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE)).WillByDefault(Return(databaseFile.string()));
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_SQLITE_INIT_SQL_FILE)).WillByDefault(Return(GERBERA_SOURCE_DIR "/src/database/sqlite3/sqlite3.sql"));
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_SQLITE_JOURNAL_MODE)).WillByDefault(Return(DEFAULT_SQLITE_JOURNAL_MODE));
+#ifdef HAVE_MYSQL
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_MYSQL_HOST)).WillByDefault(Return(env("GERBERA_BENCHMARK_MYSQL_HOST")));
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_MYSQL_DATABASE)).WillByDefault(Return(env("GERBERA_BENCHMARK_MYSQL_DATABASE", DEFAULT_MYSQL_DB)));
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_MYSQL_USERNAME)).WillByDefault(Return(env("GERBERA_BENCHMARK_MYSQL_USERNAME", DEFAULT_MYSQL_USER)));
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_MYSQL_PASSWORD)).WillByDefault(Return(env("GERBERA_BENCHMARK_MYSQL_PASSWORD")));
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_MYSQL_INIT_SQL_FILE)).WillByDefault(Return(GERBERA_SOURCE_DIR "/src/database/mysql/mysql.sql"));
+#endif
+    }
+
+    int getIntOption(config_option_t option) const override
+    {
+        switch (option) {
+        case CFG_SERVER_STORAGE_SQLITE_READERS:
+            return DEFAULT_SQLITE_READERS;
+        case CFG_SERVER_STORAGE_SQLITE_CACHE_SIZE:
+            return DEFAULT_SQLITE_CACHE_SIZE;
+        case CFG_SERVER_STORAGE_SQLITE_MMAP_SIZE:
+            return DEFAULT_SQLITE_MMAP_SIZE;
+#ifdef HAVE_MYSQL
+        case CFG_SERVER_STORAGE_MYSQL_CONNECTIONS:
+            return DEFAULT_MYSQL_CONNECTIONS;
+#endif
+        default:
+            return 0;
+        }
+    }
+
+    bool getBoolOption(config_option_t option) const override
+    {
+        // creates the missing database file
+        return option == CFG_SERVER_STORAGE_SQLITE_RESTORE;
+    }
+};
+
+/// \brief synthetic libraries of /media/Artist/Album/Track.mp3, the sizes count the items
+///
+/// GERBERA_BENCHMARK_SIZES=10000,100000 selects the sizes, the MySQL driver runs when
+/// GERBERA_BENCHMARK_MYSQL_HOST names a server with an empty database.
+class DatabaseBenchmark : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        databaseFile = fs::temp_directory_path() / fmt::format("gerbera-benchmark-{}.db", getpid());
+        config = std::make_shared<NiceMock<DatabaseBenchmarkConfig>>(databaseFile);
+        for (auto&& size : splitString(env("GERBERA_BENCHMARK_SIZES", "10000,100000,1000000"), ','))
+            sizes.push_back(std::max(TRACKS_PER_ALBUM * ALBUMS_PER_ARTIST, std::stoi(size)));
+        if (auto repeat = std::getenv("GERBERA_BENCHMARK_ITERATIONS"))
+            iterations = std::max(1, std::atoi(repeat));
+        spdlog::set_level(spdlog::level::warn);
+    }
+
+    void TearDown() override { removeDatabaseFile(); }
+
+    void removeDatabaseFile() const
+    {
+        std::error_code ec;
+        for (auto&& suffix : { "", "-wal", "-shm" })
+            fs::remove(fs::path(databaseFile.string() + suffix), ec);
+    }
+
+    static fs::path trackPath(int track)
+    {
+        int album = track / TRACKS_PER_ALBUM;
+        int artist = album / ALBUMS_PER_ARTIST;
+        return fmt::format("/media/Artist {}/Album {}/Track {}.mp3", artist, album, track);
+    }
+
+    static std::shared_ptr<CdsItem> createItem(int track)
+    {
+        auto path = trackPath(track);
+        auto item = std::make_shared<CdsItem>();
+        item->setLocation(path);
+        item->setTitle(path.stem());
+        item->setMimeType("audio/mpeg");
+        item->setClass(UPNP_CLASS_MUSIC_TRACK);
+        item->setSizeOnDisk(4 * 1024 * 1024);
+        item->setTrackNumber(track % TRACKS_PER_ALBUM + 1);
+        item->setMetadata(M_TITLE, path.stem());
+        item->setMetadata(M_ARTIST, path.parent_path().parent_path().filename());
+        item->setMetadata(M_ALBUM, path.parent_path().filename());
+        item->setMetadata(M_GENRE, fmt::format("Genre {}", track % 20));
+        item->setMetadata(M_DATE, fmt::format("{}-01-01", 1960 + track % 60));
+        auto resource = std::make_shared<CdsResource>(CH_DEFAULT);
+        resource->addAttribute(R_PROTOCOLINFO, renderProtocolInfo(item->getMimeType()));
+        resource->addAttribute(R_SIZE, "4194304");
+        resource->addAttribute(R_DURATION, "00:03:30");
+        item->addResource(resource);
+        return item;
+    }
+
+    /// \brief run fn count times and print the total and the time per call
+    template <class Fn>
+    void measure(const std::string& driver, int size, const std::string& operation, int count, Fn&& fn)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++)
+            fn(i);
+        auto total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        fmt::print("{:<8} {:>9} {:<28} {:>8} {:>12.1f} {:>12.1f}\n", driver, size, operation, count, total, total * 1000 / count);
+    }
+
+    void run(const std::string& driver, const std::function<std::shared_ptr<Database>()>& create)
+    {
+        fmt::print("{:<8} {:>9} {:<28} {:>8} {:>12} {:>12}\n", "driver", "items", "operation", "calls", "ms", "us/call");
+        for (auto size : sizes) {
+            auto database = create();
+            try {
+                runLibrary(database, driver, size);
+            } catch (const std::runtime_error& e) {
+                database->shutdown();
+                FAIL() << driver << ": " << e.what();
+            }
+            database->shutdown();
+        }
+    }
+
+    void runLibrary(const std::shared_ptr<Database>& database, const std::string& driver, int size)
+    {
+        int albums = size / TRACKS_PER_ALBUM;
+        int artists = albums / ALBUMS_PER_ARTIST;
+        std::vector<int> albumIDs(albums);
+        std::vector<int> artistIDs(artists);
+        int changed;
+        measure(driver, size, "ensurePathExistence", albums, [&](int album) {
+            albumIDs[album] = database->ensurePathExistence(trackPath(album * TRACKS_PER_ALBUM).parent_path(), &changed);
+        });
+        measure(driver, size, "addObject", albums * TRACKS_PER_ALBUM, [&](int track) {
+            auto item = createItem(track);
+            item->setParentID(albumIDs[track / TRACKS_PER_ALBUM]);
+            database->addObject(item, &changed);
+        });
+        for (int artist = 0; artist < artists; artist++)
+            artistIDs[artist] = database->findObjectIDByPath(trackPath(artist * ALBUMS_PER_ARTIST * TRACKS_PER_ALBUM).parent_path().parent_path());
+        int mediaID = database->findObjectIDByPath("/media");
+        ASSERT_GT(mediaID, 0);
+
+        // the media container holds one child per artist, the pages are at the start, the middle and the end
+        for (auto offset : std::set<int> { 0, artists / 2, std::max(0, artists - 50) }) {
+            measure(driver, size, fmt::format("browse offset {}", offset), iterations, [&](int) {
+                auto param = std::make_unique<BrowseParam>(mediaID, BROWSE_DIRECT_CHILDREN | BROWSE_ITEMS | BROWSE_CONTAINERS);
+                param->setStartingIndex(offset);
+                param->setRequestedCount(50);
+                database->browse(param);
+            });
+        }
+        measure(driver, size, "browse album", iterations, [&](int i) {
+            auto param = std::make_unique<BrowseParam>(albumIDs[i * 7919 % albums], BROWSE_DIRECT_CHILDREN | BROWSE_ITEMS | BROWSE_CONTAINERS);
+            database->browse(param);
+        });
+
+        std::vector<std::pair<std::string, std::string>> searches {
+            { "search title contains", R"(upnp:class derivedfrom "object.item.audioItem" and dc:title contains "Track 5")" },
+            { "search artist", fmt::format(R"(upnp:artist = "Artist {}")", artists / 2) },
+        };
+        for (auto&& [name, criteria] : searches) {
+            measure(driver, size, name, iterations, [&, &criteria = criteria](int) {
+                int numMatches = 0;
+                auto param = std::make_unique<SearchParam>("0", criteria, 0, 50);
+                database->search(param, &numMatches);
+            });
+        }
+
+        int lookups = std::min(size, 1000);
+        measure(driver, size, "findObjectByPath", lookups, [&](int i) {
+            auto object = database->findObjectByPath(trackPath(i * (size / lookups)), true);
+            EXPECT_NE(object, nullptr);
+        });
+
+        measure(driver, size, "incrementUpdateIDs", iterations, [&](int i) {
+            auto ids = std::make_unique<std::unordered_set<int>>();
+            for (int album = 0; album < std::min(albums, 100); album++)
+                ids->insert(albumIDs[(i * 100 + album) % albums]);
+            database->incrementUpdateIDs(ids);
+        });
+
+        // artist subtrees of ALBUMS_PER_ARTIST containers and their tracks, the rest is removed untimed
+        int removals = std::min(artists, 10);
+        measure(driver, size, "removeObject artist", removals, [&](int artist) {
+            database->removeObject(artistIDs[artist], true);
+        });
+        database->removeObject(mediaID, true);
+    }
+
+    std::shared_ptr<Config> config;
+    fs::path databaseFile;
+    std::vector<int> sizes;
+    int iterations = 20;
+};
+
+TEST_F(DatabaseBenchmark, Sqlite)
+{
+    run("sqlite3", [this] {
+        removeDatabaseFile();
+        std::shared_ptr<Database> database = std::make_shared<Sqlite3Database>(config, std::make_shared<Timer>(config));
+        database->init();
+        return database;
+    });
+}
+
+TEST_F(DatabaseBenchmark, MySQL)
+{
+#ifdef HAVE_MYSQL
+    if (env("GERBERA_BENCHMARK_MYSQL_HOST").empty())
+        GTEST_SKIP() << "GERBERA_BENCHMARK_MYSQL_HOST is not set";
+    run("mysql", [this] {
+        std::shared_ptr<Database> database = std::make_shared<MySQLDatabase>(config);
+        database->init();
+        return database;
+    });
+#else
+    GTEST_SKIP() << "Gerbera was built without MySQL";
+#endif
+}
@@ -0,0 +1,205 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    test_search_performance.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file test_search_performance.cc
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fmt/format.h>
+#include <fstream>
+#include <sqlite3.h>
+#include <unistd.h>
+
+#include "database/search_handler.h"
+#include "util/tools.h"
+
+/// \brief items of the seeded library, each with a title, artist, album and genre
+static constexpr int LIBRARY_SIZE = 100000;
+/// \brief upper bound of the page and the count query of one criteria in milliseconds
+static constexpr double SEARCH_LATENCY_LIMIT = 250;
+
+/// \brief the SQL of SearchParser run on a sqlite library of LIBRARY_SIZE items created by sqlite3.sql
+///
+/// The statements are the ones of SQLDatabase::search: a page of 50 ordered by id and the count of all matches.
+/// GERBERA_TEST_LATENCY_FACTOR scales the latency limit for slow builds, e.g. with sanitizers.
+class SearchPerformanceTest : public ::testing::Test {
+public:
+    static void SetUpTestSuite()
+    {
+        databaseFile = fs::temp_directory_path() / fmt::format("gerbera-search-{}.db", getpid());
+        fs::remove(databaseFile);
+        if (sqlite3_open(databaseFile.c_str(), &db) != SQLITE_OK)
+            throw_std_runtime_error("Could not open {}", databaseFile.c_str());
+
+        std::ifstream schema(GERBERA_SOURCE_DIR "/src/database/sqlite3/sqlite3.sql");
+        exec(std::string(std::istreambuf_iterator<char>(schema), {}));
+        // the optional full-text index as created by Sqlite3Database, filled by its trigger
+        exec(R"(CREATE VIRTUAL TABLE "grb_metadata_fts" USING fts5("property_value", content='mt_metadata', content_rowid='id'))");
+        exec(R"(CREATE TRIGGER "grb_metadata_fts_insert" AFTER INSERT ON "mt_metadata" BEGIN
+            INSERT INTO "grb_metadata_fts"("rowid", "property_value") VALUES (new."id", new."property_value"); END)");
+
+        // one in ten items is a video and one a photo, ten tracks per album and ten albums per artist
+        exec("BEGIN TRANSACTION");
+        exec(fmt::format(R"(WITH RECURSIVE n(i) AS (SELECT 0 UNION ALL SELECT i + 1 FROM n WHERE i < {})
+            INSERT INTO mt_cds_object(id, parent_id, object_type, upnp_class, dc_title, location, mime_type, track_number)
+            SELECT 1000 + i, 1, 2,
+                CASE i % 10 WHEN 0 THEN 'object.item.videoItem' WHEN 1 THEN 'object.item.imageItem.photo' ELSE 'object.item.audioItem.musicTrack' END,
+                'Track ' || i, '/media/Artist ' || (i / 100) || '/Album ' || (i / 10) || '/Track ' || i || '.mp3', 'audio/mpeg', i % 10 + 1
+            FROM n)",
+            LIBRARY_SIZE - 1));
+        for (auto&& [property, value] : std::vector<std::pair<std::string, std::string>> {
+                 { "dc:title", "dc_title" },
+                 { "upnp:artist", "'Artist ' || ((id - 1000) / 100)" },
+                 { "upnp:album", "'Album ' || ((id - 1000) / 10)" },
+                 { "upnp:genre", "'Genre ' || ((id - 1000) % 20)" },
+             }) {
+            exec(fmt::format("INSERT INTO mt_metadata(item_id, property_name, property_value) SELECT id, '{}', {} FROM mt_cds_object WHERE id >= 1000", property, value));
+        }
+        exec("COMMIT");
+
+        if (auto factor = std::getenv("GERBERA_TEST_LATENCY_FACTOR"))
+            latencyLimit *= std::max(1.0, std::atof(factor));
+    }
+
+    static void TearDownTestSuite()
+    {
+        sqlite3_close(db);
+        db = nullptr;
+        fs::remove(databaseFile);
+    }
+
+    static void exec(const std::string& sql)
+    {
+        char* err = nullptr;
+        if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+            std::string message = err ? err : "unknown error";
+            sqlite3_free(err);
+            throw_std_runtime_error("{}: {}", message, sql);
+        }
+    }
+
+    /// \brief the detail column of EXPLAIN QUERY PLAN
+    static std::vector<std::string> queryPlan(const std::string& sql)
+    {
+        std::vector<std::string> plan;
+        auto collect = [](void* arg, int columns, char** values, char** names) {
+            static_cast<std::vector<std::string>*>(arg)->emplace_back(values[columns - 1] ? values[columns - 1] : "");
+            return 0;
+        };
+        char* err = nullptr;
+        if (sqlite3_exec(db, ("EXPLAIN QUERY PLAN " + sql).c_str(), collect, &plan, &err) != SQLITE_OK) {
+            std::string message = err ? err : "unknown error";
+            sqlite3_free(err);
+            throw_std_runtime_error("{}: {}", message, sql);
+        }
+        return plan;
+    }
+
+    /// \brief the fastest of three runs in milliseconds, the first one warms the page cache
+    static double latency(const std::string& sql)
+    {
+        auto best = std::numeric_limits<double>::max();
+        for (int run = 0; run < 3; run++) {
+            auto start = std::chrono::steady_clock::now();
+            exec(sql);
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    /// \brief a step of the plan reading all rows of the objects or the metadata
+    static bool isFullScan(const std::string& step)
+    {
+        return startswith(step, "SCAN c") || startswith(step, "SCAN m");
+    }
+
+    static std::string searchSQL(const SQLEmitter& emitter, const std::string& criteria)
+    {
+        SearchParser parser(emitter, criteria);
+        return parser.parse()->emitSQL();
+    }
+
+    static std::string pageSQL(const std::string& search)
+    {
+        return fmt::format("SELECT distinct c.id, c.ref_id, c.parent_id, c.object_type, c.upnp_class, c.dc_title, c.metadata,"
+                           " c.resources, c.mime_type, c.track_number, c.location {} order by c.id limit 50 offset 0",
+            search);
+    }
+
+    static std::string countSQL(const std::string& search) { return fmt::format("select count(*) {}", search); }
+
+    /// \brief criteria of the control points that are expected to be answered from an index
+    const std::vector<std::string> commonCriteria {
+        R"(upnp:artist = "Artist 500")",
+        R"(upnp:class derivedfrom "object.item.audioItem" and dc:title contains "Track 5")",
+        R"(upnp:class derivedfrom "object.item.videoItem" and dc:title contains "Track")",
+        R"(upnp:album = "Album 42" and upnp:class derivedfrom "object.item.audioItem")",
+        R"(dc:title startsWith "Track 99")",
+        R"(upnp:genre = "Genre 3" or upnp:artist = "Artist 3")",
+        R"(upnp:album exists true)",
+    };
+
+    static fs::path databaseFile;
+    static sqlite3* db;
+    static double latencyLimit;
+};
+
+fs::path SearchPerformanceTest::databaseFile;
+sqlite3* SearchPerformanceTest::db = nullptr;
+double SearchPerformanceTest::latencyLimit = SEARCH_LATENCY_LIMIT;
+
+TEST_F(SearchPerformanceTest, CommonCriteriaUseIndexes)
+{
+    DefaultSQLEmitter emitter;
+    for (auto&& criteria : commonCriteria) {
+        auto search = searchSQL(emitter, criteria);
+        for (auto&& sql : { countSQL(search), pageSQL(search) }) {
+            auto plan = queryPlan(sql);
+            auto scan = std::find_if(plan.begin(), plan.end(), isFullScan);
+            EXPECT_EQ(scan, plan.end()) << criteria << ": " << fmt::format("{}", fmt::join(plan, ", "));
+        }
+    }
+}
+
+TEST_F(SearchPerformanceTest, FulltextContainsUsesFtsIndex)
+{
+    SqliteFulltextSQLEmitter emitter;
+    auto search = searchSQL(emitter, R"(upnp:class derivedfrom "object.item.audioItem" and dc:title contains "Track 5")");
+    auto plan = queryPlan(countSQL(search));
+    EXPECT_EQ(std::find_if(plan.begin(), plan.end(), isFullScan), plan.end()) << fmt::format("{}", fmt::join(plan, ", "));
+    EXPECT_NE(std::find_if(plan.begin(), plan.end(), [](auto&& step) { return step.find("grb_metadata_fts") != std::string::npos; }), plan.end())
+        << fmt::format("{}", fmt::join(plan, ", "));
+}
+
+TEST_F(SearchPerformanceTest, CommonCriteriaAreFast)
+{
+    DefaultSQLEmitter emitter;
+    SqliteFulltextSQLEmitter fulltextEmitter;
+    for (const SQLEmitter* sqlEmitter : std::initializer_list<const SQLEmitter*> { &emitter, &fulltextEmitter }) {
+        for (auto&& criteria : commonCriteria) {
+            auto search = searchSQL(*sqlEmitter, criteria);
+            EXPECT_LT(latency(pageSQL(search)), latencyLimit) << criteria;
+            EXPECT_LT(latency(countSQL(search)), latencyLimit) << criteria;
+        }
+    }
+}
@@ -0,0 +1,265 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    test_sqlite_database.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file test_sqlite_database.cc
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <fmt/format.h>
+#include <optional>
+#include <unistd.h>
+
+#include "cds_objects.h"
+#include "database/sqlite3/sqlite_database.h"
+#include "upnp_common.h"
+#include "util/timer.h"
+
+#include "../mock/config_mock.h"
+
+/// \brief the sqlite options with the defaults of the server
+class SqliteDatabaseConfig : public ConfigMock {
+public:
+    SqliteDatabaseConfig(const fs::path& databaseFile)
+    {
+        ON_CALL(*this, getOption(_)).WillByDefault(Return(""));
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_SQLITE_DATABASE_FILE)).WillByDefault(Return(databaseFile.string()));
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_SQLITE_INIT_SQL_FILE)).WillByDefault(Return(GERBERA_SOURCE_DIR "/src/database/sqlite3/sqlite3.sql"));
+        ON_CALL(*this, getOption(CFG_SERVER_STORAGE_SQLITE_JOURNAL_MODE)).WillByDefault(Return(DEFAULT_SQLITE_JOURNAL_MODE));
+    }
+
+    int getIntOption(config_option_t option) const override
+    {
+        switch (option) {
+        case CFG_SERVER_STORAGE_SQLITE_READERS:
+            return DEFAULT_SQLITE_READERS;
+        case CFG_SERVER_STORAGE_SQLITE_CACHE_SIZE:
+            return DEFAULT_SQLITE_CACHE_SIZE;
+        case CFG_SERVER_STORAGE_SQLITE_MMAP_SIZE:
+            return DEFAULT_SQLITE_MMAP_SIZE;
+        default:
+            return 0;
+        }
+    }
+
+    bool getBoolOption(config_option_t option) const override
+    {
+        // creates the missing database file
+        return option == CFG_SERVER_STORAGE_SQLITE_RESTORE;
+    }
+};
+
+/// \brief sqlite databases in temporary files, created by the server schema
+class SqliteDatabaseTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        database = openDatabase("library");
+    }
+
+    void TearDown() override
+    {
+        for (auto&& [file, db] : databases) {
+            db->shutdown();
+            removeDatabaseFile(file);
+        }
+        databases.clear();
+    }
+
+    std::shared_ptr<SQLDatabase> openDatabase(const std::string& name)
+    {
+        auto file = fs::temp_directory_path() / fmt::format("gerbera-sqlite-{}-{}.db", getpid(), name);
+        removeDatabaseFile(file);
+        std::shared_ptr<Config> config = std::make_shared<NiceMock<SqliteDatabaseConfig>>(file);
+        std::shared_ptr<Database> db = std::make_shared<Sqlite3Database>(config, std::make_shared<Timer>(config));
+        db->init();
+        auto sqlDatabase = std::dynamic_pointer_cast<SQLDatabase>(db);
+        databases.emplace_back(file, sqlDatabase);
+        return sqlDatabase;
+    }
+
+    static void removeDatabaseFile(const fs::path& file)
+    {
+        std::error_code ec;
+        for (auto&& suffix : { "", "-wal", "-shm" })
+            fs::remove(fs::path(file.string() + suffix), ec);
+    }
+
+    std::shared_ptr<CdsItem> addItem(int parentID, const std::string& title)
+    {
+        auto item = std::make_shared<CdsItem>();
+        item->setParentID(parentID);
+        item->setLocation(fmt::format("/media/Album/{}.mp3", title));
+        item->setTitle(title);
+        item->setMimeType("audio/mpeg");
+        item->setClass(UPNP_CLASS_MUSIC_TRACK);
+        int changed;
+        database->addObject(item, &changed);
+        return item;
+    }
+
+    /// \brief ids of all children of parentID, read one page of pageSize after the other
+    std::vector<int> browsePages(int parentID, const std::string& sortCriteria, int pageSize)
+    {
+        std::vector<int> ids;
+        for (int start = 0;; start += pageSize) {
+            auto param = std::make_unique<BrowseParam>(parentID, BROWSE_DIRECT_CHILDREN | BROWSE_ITEMS | BROWSE_CONTAINERS);
+            param->setSortCriteria(BrowseParam::parseSortCriteria(sortCriteria));
+            param->setStartingIndex(start);
+            param->setRequestedCount(pageSize);
+            auto page = database->browse(param);
+            for (auto&& obj : page)
+                ids.push_back(obj->getID());
+            if (page.size() < static_cast<std::size_t>(pageSize))
+                return ids;
+        }
+    }
+
+    /// \brief all rows of the tables of a database dump ordered by their first column, std::nullopt for NULL
+    static std::vector<std::vector<std::optional<std::string>>> dumpRows(const std::shared_ptr<SQLDatabase>& db)
+    {
+        static const std::vector<std::pair<std::string, std::string>> tables {
+            { "mt_cds_object", R"("id","ref_id","parent_id","object_type","upnp_class","dc_title","location","location_hash","metadata","auxdata","resources","update_id","mime_type","flags","part_number","track_number","service_id","bookmark_pos","last_modified","child_count")" },
+            { "mt_metadata", R"("id","item_id","property_name","property_value")" },
+            { "mt_autoscan", R"("id","obj_id","scan_level","scan_mode","recursive","hidden","interval","last_modified","persistent","location","path_ids","touched")" },
+            { "grb_config_value", R"("item","key","item_value","status")" },
+            { "grb_directory_state", R"("id","mtime","child_count")" },
+            { "grb_file_state", R"("id","size","inode","birth_time","head","tail")" },
+        };
+        std::vector<std::vector<std::optional<std::string>>> rows;
+        for (auto&& [table, columns] : tables) {
+            auto columnCount = std::count(columns.begin(), columns.end(), ',') + 1;
+            auto res = db->select(fmt::format(R"(SELECT {} FROM "{}" ORDER BY 1)", columns, table));
+            std::unique_ptr<SQLRow> row;
+            while (res != nullptr && (row = res->nextRow()) != nullptr) {
+                std::vector<std::optional<std::string>> values { table };
+                for (int i = 0; i < columnCount; i++) {
+                    auto value = row->col_c_str(i);
+                    values.push_back(value != nullptr ? std::optional<std::string>(value) : std::nullopt);
+                }
+                rows.push_back(std::move(values));
+            }
+        }
+        return rows;
+    }
+
+    /// \brief a library with a NULL title, metadata, an autoscan with NULL columns and file states
+    void fillLibrary(const std::shared_ptr<SQLDatabase>& db)
+    {
+        int changed;
+        int albumID = db->ensurePathExistence("/media/Album", &changed);
+        auto track = std::make_shared<CdsItem>();
+        track->setParentID(albumID);
+        track->setLocation("/media/Album/Track.mp3");
+        track->setTitle("Track");
+        track->setMimeType("audio/mpeg");
+        track->setClass(UPNP_CLASS_MUSIC_TRACK);
+        track->setMetadata(M_ARTIST, "Artist");
+        track->setMetadata(M_ALBUM, "Album");
+        db->addObject(track, &changed);
+        db->exec(fmt::format(R"(UPDATE "mt_cds_object" SET "dc_title" = NULL WHERE "id" = {})", albumID));
+        db->exec(fmt::format(R"(INSERT INTO "mt_autoscan" ("obj_id", "scan_level", "scan_mode", "recursive", "hidden", "interval", "last_modified", "persistent", "location", "path_ids", "touched")
+            VALUES ({}, 'full', 'inotify', 1, 0, NULL, NULL, 1, '/media/Album', NULL, 1))",
+            albumID));
+        db->setDirectoryState(albumID, 1600000000);
+        db->setFileState(track->getID(), { 4096, 42, 1500000000, 0x1234, -1 });
+    }
+
+    /// \brief by file, shut down and removed by TearDown
+    std::vector<std::pair<fs::path, std::shared_ptr<SQLDatabase>>> databases;
+    std::shared_ptr<SQLDatabase> database;
+};
+
+TEST_F(SqliteDatabaseTest, BrowsePagesKeepNullTitlesWhenDescending)
+{
+    int changed;
+    int albumID = database->ensurePathExistence("/media/Album", &changed);
+    auto b = addItem(albumID, "B");
+    auto a = addItem(albumID, "A");
+    auto untitled = addItem(albumID, "untitled");
+    auto c = addItem(albumID, "C");
+    database->exec(fmt::format(R"(UPDATE "mt_cds_object" SET "dc_title" = NULL WHERE "id" = {})", untitled->getID()));
+
+    // NULL sorts last when descending, each page seeks behind the last row of the previous one
+    std::vector<int> expected { c->getID(), b->getID(), a->getID(), untitled->getID() };
+    EXPECT_EQ(browsePages(albumID, "-dc:title", 1), expected);
+    EXPECT_EQ(browsePages(albumID, "-dc:title", 2), expected);
+
+    std::vector<int> ascending { untitled->getID(), a->getID(), b->getID(), c->getID() };
+    EXPECT_EQ(browsePages(albumID, "+dc:title", 1), ascending);
+}
+
+TEST_F(SqliteDatabaseTest, ImportRestoresTheExportedRows)
+{
+    fillLibrary(database);
+    auto dump = fs::temp_directory_path() / fmt::format("gerbera-sqlite-{}.dump", getpid());
+    database->exportDatabase(dump);
+
+    auto target = openDatabase("target");
+    int changed;
+    target->ensurePathExistence("/media/Other", &changed);
+    target->importDatabase(dump);
+    fs::remove(dump);
+
+    auto rows = dumpRows(database);
+    EXPECT_EQ(dumpRows(target), rows);
+    // the NULLs stay NULL instead of becoming empty strings
+    EXPECT_TRUE(std::any_of(rows.begin(), rows.end(), [](auto&& row) { return row.at(0) == "mt_cds_object" && !row.at(6).has_value(); }));
+    EXPECT_TRUE(std::any_of(rows.begin(), rows.end(), [](auto&& row) { return row.at(0) == "mt_autoscan" && !row.at(11).has_value(); }));
+    EXPECT_TRUE(std::any_of(rows.begin(), rows.end(), [](auto&& row) { return row.at(0) == "grb_file_state"; }));
+}
+
+TEST_F(SqliteDatabaseTest, ImportRejectsTruncatedDump)
+{
+    fillLibrary(database);
+    auto dump = fs::temp_directory_path() / fmt::format("gerbera-sqlite-{}.dump", getpid());
+    database->exportDatabase(dump);
+    // cuts the rows of the last table and the end of the dump
+    fs::resize_file(dump, fs::file_size(dump) - 8);
+
+    auto target = openDatabase("target");
+    int changed;
+    target->ensurePathExistence("/media/Other", &changed);
+    auto before = dumpRows(target);
+    EXPECT_THROW(target->importDatabase(dump), std::runtime_error);
+    fs::remove(dump);
+
+    // the tables deleted by the import are rolled back
+    EXPECT_EQ(dumpRows(target), before);
+}
+
+TEST_F(SqliteDatabaseTest, ImportRejectsOtherSchemaVersion)
+{
+    fillLibrary(database);
+    database->exec(R"(UPDATE "mt_internal_setting" SET "value" = '0' WHERE "key" = 'db_version')");
+    auto dump = fs::temp_directory_path() / fmt::format("gerbera-sqlite-{}.dump", getpid());
+    database->exportDatabase(dump);
+
+    auto target = openDatabase("target");
+    int changed;
+    target->ensurePathExistence("/media/Other", &changed);
+    auto before = dumpRows(target);
+    EXPECT_THROW(target->importDatabase(dump), std::runtime_error);
+    fs::remove(dump);
+
+    EXPECT_EQ(dumpRows(target), before);
+}
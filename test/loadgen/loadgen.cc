@@ -0,0 +1,831 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    loadgen.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file loadgen.cc
+/// \brief simulated UPnP control points sending discovery, browse, search,
+/// event subscriptions and ranged downloads to a running server
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fmt/format.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <netdb.h>
+#include <poll.h>
+#include <pugixml.hpp>
+#include <random>
+#include <sstream>
+#include <strings.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "contrib/cxxopts.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr auto SSDP_ADDRESS = "239.255.255.250";
+static constexpr int SSDP_PORT = 1900;
+static constexpr auto MEDIA_SERVER = "urn:schemas-upnp-org:device:MediaServer:1";
+static constexpr auto CONTENT_DIRECTORY = "urn:schemas-upnp-org:service:ContentDirectory:1";
+static constexpr int SOCKET_TIMEOUT = 30;
+/// \brief containers and resources a control point remembers to pick the next request from
+static constexpr std::size_t MAX_REMEMBERED = 1000;
+
+/// \brief http://host:port/path split for the socket calls
+struct Url {
+    std::string host;
+    std::string port = "80";
+    std::string path = "/";
+
+    /// \brief parse an absolute url or resolve a path against base
+    static Url parse(const std::string& url, const Url* base = nullptr)
+    {
+        if (url.rfind("http://", 0) != 0) {
+            if (base == nullptr)
+                throw std::runtime_error(fmt::format("Not an http url: {}", url));
+            Url result = *base;
+            result.path = url.empty() || url[0] == '/' ? url : base->path.substr(0, base->path.rfind('/') + 1) + url;
+            return result;
+        }
+        Url result;
+        auto hostStart = 7;
+        auto pathStart = url.find('/', hostStart);
+        auto hostPort = url.substr(hostStart, pathStart == std::string::npos ? std::string::npos : pathStart - hostStart);
+        if (pathStart != std::string::npos)
+            result.path = url.substr(pathStart);
+        auto colon = hostPort.rfind(':');
+        if (colon != std::string::npos && hostPort.find(']', colon) == std::string::npos) {
+            result.port = hostPort.substr(colon + 1);
+            hostPort = hostPort.substr(0, colon);
+        }
+        if (hostPort.size() > 1 && hostPort.front() == '[')
+            hostPort = hostPort.substr(1, hostPort.size() - 2);
+        result.host = hostPort;
+        return result;
+    }
+};
+
+struct HttpResponse {
+    int status = 0;
+    /// \brief header names in lower case
+    std::map<std::string, std::string> headers;
+    std::string body;
+    std::size_t bodyBytes = 0;
+};
+
+static std::string toLower(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c) { return std::tolower(c); });
+    return str;
+}
+
+static int connectTo(const std::string& host, const std::string& port, int type)
+{
+    addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = type;
+    addrinfo* addresses = nullptr;
+    int ret = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+    if (ret != 0)
+        throw std::runtime_error(fmt::format("Cannot resolve {}: {}", host, gai_strerror(ret)));
+
+    int fd = -1;
+    for (auto address = addresses; address != nullptr && fd < 0; address = address->ai_next) {
+        fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0)
+            continue;
+        timeval timeout { SOCKET_TIMEOUT, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        if (connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0)
+        throw std::runtime_error(fmt::format("Cannot connect to {}:{}: {}", host, port, std::strerror(errno)));
+    return fd;
+}
+
+static void sendAll(int fd, const std::string& data)
+{
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        auto bytes = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (bytes <= 0)
+            throw std::runtime_error(fmt::format("Send failed: {}", std::strerror(errno)));
+        sent += bytes;
+    }
+}
+
+/// \brief join the chunks of a chunked transfer encoded body
+static std::string dechunk(const std::string& body)
+{
+    std::string result;
+    std::size_t pos = 0;
+    while (pos < body.size()) {
+        auto lineEnd = body.find("\r\n", pos);
+        if (lineEnd == std::string::npos)
+            break;
+        auto size = std::stoul(body.substr(pos, lineEnd - pos), nullptr, 16);
+        if (size == 0)
+            break;
+        result.append(body, lineEnd + 2, size);
+        pos = lineEnd + 2 + size + 2;
+    }
+    return result;
+}
+
+/// \brief one request per connection, as most control points do for SOAP and GENA
+static HttpResponse httpRequest(const Url& url, const std::string& method, const std::vector<std::string>& headers = {}, const std::string& body = "", bool keepBody = true)
+{
+    int fd = connectTo(url.host, url.port, SOCK_STREAM);
+    std::string request = fmt::format("{} {} HTTP/1.1\r\nHost: {}:{}\r\nConnection: close\r\nUser-Agent: gerbera-loadgen UPnP/1.0\r\n", method, url.path, url.host, url.port);
+    for (auto&& header : headers)
+        request += header + "\r\n";
+    if (!body.empty())
+        request += fmt::format("Content-Length: {}\r\n", body.size());
+    request += "\r\n" + body;
+
+    HttpResponse response;
+    std::string data;
+    try {
+        sendAll(fd, request);
+        char buffer[64 * 1024];
+        std::size_t headerEnd = std::string::npos;
+        ssize_t bytes;
+        while ((bytes = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            if (headerEnd == std::string::npos || keepBody) {
+                data.append(buffer, bytes);
+                if (headerEnd == std::string::npos && (headerEnd = data.find("\r\n\r\n")) != std::string::npos)
+                    response.bodyBytes = data.size() - headerEnd - 4;
+            } else {
+                response.bodyBytes += bytes;
+            }
+            if (keepBody && headerEnd != std::string::npos)
+                response.bodyBytes = data.size() - headerEnd - 4;
+        }
+        if (bytes < 0)
+            throw std::runtime_error(fmt::format("Receive failed: {}", std::strerror(errno)));
+        if (headerEnd == std::string::npos)
+            throw std::runtime_error("Incomplete response");
+
+        std::istringstream head(data.substr(0, headerEnd));
+        std::string line;
+        std::getline(head, line);
+        if (line.size() < 12)
+            throw std::runtime_error(fmt::format("Bad status line: {}", line));
+        response.status = std::stoi(line.substr(9, 3));
+        while (std::getline(head, line)) {
+            auto colon = line.find(':');
+            if (colon == std::string::npos)
+                continue;
+            auto value = line.substr(colon + 1);
+            value.erase(0, value.find_first_not_of(' '));
+            if (!value.empty() && value.back() == '\r')
+                value.pop_back();
+            response.headers[toLower(line.substr(0, colon))] = value;
+        }
+        if (keepBody) {
+            response.body = data.substr(headerEnd + 4);
+            if (toLower(response.headers["transfer-encoding"]) == "chunked")
+                response.body = dechunk(response.body);
+        }
+    } catch (const std::runtime_error&) {
+        close(fd);
+        throw;
+    }
+    close(fd);
+    return response;
+}
+
+/// \brief latency of the requests by operation, printed as percentiles at the end
+class Stats {
+public:
+    void add(const std::string& operation, Clock::duration duration)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        latencies[operation].push_back(std::chrono::duration<double, std::milli>(duration).count());
+    }
+
+    void error(const std::string& operation, const std::string& message)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (errors[operation]++ == 0)
+            std::cerr << operation << " failed: " << message << std::endl;
+    }
+
+    std::atomic<std::uint64_t> downloadedBytes { 0 };
+    std::atomic<std::uint64_t> notifications { 0 };
+
+    void print(double seconds)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fmt::print("{:<16} {:>8} {:>7} {:>9} {:>9} {:>9} {:>9} {:>9}\n", "operation", "calls", "errors", "calls/s", "p50 ms", "p90 ms", "p99 ms", "max ms");
+        std::map<std::string, bool> operations;
+        for (auto&& [operation, values] : latencies)
+            operations[operation] = true;
+        for (auto&& [operation, count] : errors)
+            operations[operation] = true;
+        for (auto&& [operation, unused] : operations) {
+            auto& values = latencies[operation];
+            std::sort(values.begin(), values.end());
+            auto percentile = [&](double p) { return values.empty() ? 0.0 : values[std::min(values.size() - 1, static_cast<std::size_t>(p * values.size()))]; };
+            fmt::print("{:<16} {:>8} {:>7} {:>9.1f} {:>9.1f} {:>9.1f} {:>9.1f} {:>9.1f}\n", operation, values.size(), errors[operation],
+                values.size() / seconds, percentile(0.5), percentile(0.9), percentile(0.99), values.empty() ? 0.0 : values.back());
+        }
+        fmt::print("\ndownloaded {:.1f} MiB, {:.1f} MiB/s, {} event notifications received\n",
+            downloadedBytes / 1048576.0, downloadedBytes / 1048576.0 / seconds, notifications.load());
+    }
+
+private:
+    std::mutex mutex;
+    std::map<std::string, std::vector<double>> latencies;
+    std::map<std::string, std::size_t> errors;
+};
+
+/// \brief run fn and record its latency or the error
+template <class Fn>
+static bool timed(Stats& stats, const std::string& operation, Fn&& fn)
+{
+    auto start = Clock::now();
+    try {
+        fn();
+    } catch (const std::runtime_error& e) {
+        stats.error(operation, e.what());
+        return false;
+    }
+    stats.add(operation, Clock::now() - start);
+    return true;
+}
+
+/// \brief send an M-SEARCH for media servers and return the LOCATION of the first answer
+/// matching host, or of any server if host is empty
+static std::string discover(const std::string& host, int timeoutMs)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        throw std::runtime_error(fmt::format("Cannot create SSDP socket: {}", std::strerror(errno)));
+    int ttl = 2;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(SSDP_PORT);
+    inet_pton(AF_INET, SSDP_ADDRESS, &address.sin_addr);
+    auto search = fmt::format("M-SEARCH * HTTP/1.1\r\nHOST: {}:{}\r\nMAN: \"ssdp:discover\"\r\nMX: {}\r\nST: {}\r\n\r\n",
+        SSDP_ADDRESS, SSDP_PORT, std::max(1, timeoutMs / 1000), MEDIA_SERVER);
+    if (sendto(fd, search.data(), search.size(), 0, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        close(fd);
+        throw std::runtime_error(fmt::format("Cannot send M-SEARCH: {}", std::strerror(errno)));
+    }
+
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    char buffer[4096];
+    while (Clock::now() < deadline) {
+        pollfd pfd { fd, POLLIN, 0 };
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        if (poll(&pfd, 1, std::max<long>(1, remaining)) <= 0)
+            continue;
+        auto bytes = recv(fd, buffer, sizeof(buffer) - 1, 0);
+        if (bytes <= 0)
+            continue;
+        std::istringstream answer(std::string(buffer, bytes));
+        std::string line;
+        while (std::getline(answer, line)) {
+            if (strncasecmp(line.c_str(), "LOCATION:", 9) != 0)
+                continue;
+            auto location = line.substr(9);
+            location.erase(0, location.find_first_not_of(' '));
+            if (!location.empty() && location.back() == '\r')
+                location.pop_back();
+            if (host.empty() || Url::parse(location).host == host) {
+                close(fd);
+                return location;
+            }
+        }
+    }
+    close(fd);
+    throw std::runtime_error("No media server answered the M-SEARCH");
+}
+
+/// \brief element by local name, the prefixes of the SOAP and description documents differ between servers
+static pugi::xml_node findChild(const pugi::xml_node& node, const std::string& localName)
+{
+    for (auto&& child : node.children()) {
+        std::string name = child.name();
+        auto colon = name.find(':');
+        if ((colon == std::string::npos ? name : name.substr(colon + 1)) == localName)
+            return child;
+        auto found = findChild(child, localName);
+        if (found)
+            return found;
+    }
+    return {};
+}
+
+/// \brief the ContentDirectory urls of the device description
+struct Device {
+    Url control;
+    Url events;
+
+    static Device load(const std::string& location)
+    {
+        auto base = Url::parse(location);
+        auto response = httpRequest(base, "GET");
+        if (response.status != 200)
+            throw std::runtime_error(fmt::format("Device description returned {}", response.status));
+        pugi::xml_document xml;
+        if (!xml.load_string(response.body.c_str()))
+            throw std::runtime_error("Cannot parse device description");
+        auto urlBase = findChild(xml, "URLBase");
+        if (urlBase && *urlBase.child_value())
+            base = Url::parse(urlBase.child_value());
+
+        for (auto service = findChild(xml, "service"); service; service = service.next_sibling()) {
+            if (std::string(service.child_value("serviceType")) == CONTENT_DIRECTORY)
+                return { Url::parse(service.child_value("controlURL"), &base), Url::parse(service.child_value("eventSubURL"), &base) };
+        }
+        throw std::runtime_error("The device has no ContentDirectory service");
+    }
+};
+
+/// \brief one Browse or Search with the arguments a client sent
+struct Request {
+    std::string action = "Browse";
+    std::string objectID = "0";
+    std::string browseFlag = "BrowseDirectChildren";
+    std::string filter = "*";
+    int start = 0;
+    int count = 0;
+    std::string sort;
+    std::string criteria;
+
+    /// \brief "Browse <id> <flag> <start> <count> [sort]" or "Search <id> <start> <count> <criteria>"
+    static Request parse(const std::string& line)
+    {
+        std::istringstream in(line);
+        Request request;
+        in >> request.action >> request.objectID;
+        if (request.action == "Browse") {
+            in >> request.browseFlag >> request.start >> request.count >> request.sort;
+        } else if (request.action == "Search") {
+            in >> request.start >> request.count;
+            std::getline(in, request.criteria);
+            request.criteria.erase(0, request.criteria.find_first_not_of(' '));
+        } else {
+            throw std::runtime_error(fmt::format("Unknown action in trace: {}", line));
+        }
+        if (in.fail() && !in.eof())
+            throw std::runtime_error(fmt::format("Bad trace line: {}", line));
+        return request;
+    }
+};
+
+static std::string xmlEscape(const std::string& text)
+{
+    std::string result;
+    for (auto c : text) {
+        switch (c) {
+        case '<':
+            result += "&lt;";
+            break;
+        case '>':
+            result += "&gt;";
+            break;
+        case '&':
+            result += "&amp;";
+            break;
+        case '"':
+            result += "&quot;";
+            break;
+        default:
+            result += c;
+        }
+    }
+    return result;
+}
+
+/// \brief the browse pattern of a client family, taken from request logs of these clients
+struct Profile {
+    std::string name;
+    /// \brief BrowseMetadata of a container before its children
+    bool browseMetadata;
+    int pageSize;
+    /// \brief pages of a container requested before moving on, like scrolling a list
+    int pages;
+    std::string sort;
+    /// \brief every n-th request is this search, 0 for none
+    int searchEvery;
+    std::string criteria;
+};
+
+static const std::vector<Profile> profiles {
+    { "samsung", true, 40, 2, "", 0, "" },
+    { "bubbleupnp", false, 64, 3, "+dc:title", 5, R"(upnp:class derivedfrom "object.item.audioItem" and dc:title contains "a")" },
+    { "vlc", false, 0, 1, "", 0, "" },
+};
+
+/// \brief item urls found by the control points, picked at random by the downloaders
+class ResourcePool {
+public:
+    struct Resource {
+        Url url;
+        std::uint64_t size;
+    };
+
+    void add(Resource resource)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (resources.size() < MAX_REMEMBERED * 10)
+            resources.push_back(std::move(resource));
+        else
+            resources[random() % resources.size()] = std::move(resource);
+    }
+
+    bool pick(std::mt19937& rng, Resource& resource)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (resources.empty())
+            return false;
+        resource = resources[rng() % resources.size()];
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<Resource> resources;
+};
+
+class ControlPoint {
+public:
+    ControlPoint(int id, const Device& device, const Profile& profile, const std::vector<Request>& trace, Stats& stats, ResourcePool& pool)
+        : id(id)
+        , device(device)
+        , profile(profile)
+        , trace(trace)
+        , stats(stats)
+        , pool(pool)
+        , rng(id)
+    {
+    }
+
+    void run(Clock::time_point deadline, std::chrono::milliseconds think)
+    {
+        std::size_t step = trace.empty() ? 0 : id * trace.size() / 7 % trace.size();
+        while (Clock::now() < deadline) {
+            if (!trace.empty()) {
+                send(trace[step++ % trace.size()]);
+            } else {
+                browseNext();
+            }
+            if (think.count() > 0)
+                std::this_thread::sleep_for(think);
+        }
+    }
+
+private:
+    /// \brief continue in a container seen before, search every few requests
+    void browseNext()
+    {
+        if (profile.searchEvery > 0 && ++requests % profile.searchEvery == 0) {
+            Request search;
+            search.action = "Search";
+            search.count = profile.pageSize;
+            search.criteria = profile.criteria;
+            send(search);
+            return;
+        }
+
+        std::string container = containers.empty() || rng() % 10 == 0 ? "0" : containers[rng() % containers.size()];
+        if (profile.browseMetadata) {
+            Request metadata;
+            metadata.objectID = container;
+            metadata.browseFlag = "BrowseMetadata";
+            send(metadata);
+        }
+        for (int page = 0; page < profile.pages; page++) {
+            Request children;
+            children.objectID = container;
+            children.start = page * profile.pageSize;
+            children.count = profile.pageSize;
+            children.sort = profile.sort;
+            if (send(children) < profile.pageSize || profile.pageSize == 0)
+                break;
+        }
+    }
+
+    /// \brief send the action and remember the containers and resources of the result, returns the number of results
+    int send(const Request& request)
+    {
+        std::string arguments;
+        if (request.action == "Browse") {
+            arguments = fmt::format("<ObjectID>{}</ObjectID><BrowseFlag>{}</BrowseFlag><Filter>{}</Filter>"
+                                    "<StartingIndex>{}</StartingIndex><RequestedCount>{}</RequestedCount><SortCriteria>{}</SortCriteria>",
+                xmlEscape(request.objectID), request.browseFlag, xmlEscape(request.filter), request.start, request.count, xmlEscape(request.sort));
+        } else {
+            arguments = fmt::format("<ContainerID>{}</ContainerID><SearchCriteria>{}</SearchCriteria><Filter>{}</Filter>"
+                                    "<StartingIndex>{}</StartingIndex><RequestedCount>{}</RequestedCount><SortCriteria>{}</SortCriteria>",
+                xmlEscape(request.objectID), xmlEscape(request.criteria), xmlEscape(request.filter), request.start, request.count, xmlEscape(request.sort));
+        }
+        auto body = fmt::format(R"(<?xml version="1.0" encoding="utf-8"?>)"
+                                R"(<s:Envelope xmlns:s="http://schemas.xmlsoap.org/soap/envelope/" s:encodingStyle="http://schemas.xmlsoap.org/soap/encoding/">)"
+                                R"(<s:Body><u:{0} xmlns:u="{1}">{2}</u:{0}></s:Body></s:Envelope>)",
+            request.action, CONTENT_DIRECTORY, arguments);
+
+        auto operation = request.action == "Browse" && request.browseFlag == "BrowseMetadata" ? "BrowseMetadata" : request.action;
+        std::string result;
+        timed(stats, operation, [&] {
+            auto response = httpRequest(device.control, "POST",
+                { "Content-Type: text/xml; charset=\"utf-8\"", fmt::format("SOAPACTION: \"{}#{}\"", CONTENT_DIRECTORY, request.action) }, body);
+            if (response.status != 200)
+                throw std::runtime_error(fmt::format("{} returned {}", request.action, response.status));
+            pugi::xml_document xml;
+            if (!xml.load_string(response.body.c_str()))
+                throw std::runtime_error("Cannot parse SOAP response");
+            result = findChild(xml, "Result").child_value();
+        });
+        return remember(result);
+    }
+
+    int remember(const std::string& result)
+    {
+        pugi::xml_document didl;
+        if (result.empty() || !didl.load_string(result.c_str()))
+            return 0;
+        int count = 0;
+        for (auto&& object : didl.document_element().children()) {
+            count++;
+            if (std::string(object.name()) == "container") {
+                std::string containerID = object.attribute("id").value();
+                if (containers.size() < MAX_REMEMBERED)
+                    containers.push_back(containerID);
+                else
+                    containers[rng() % containers.size()] = containerID;
+            } else if (auto res = object.child("res")) {
+                try {
+                    pool.add({ Url::parse(res.child_value()), std::strtoull(res.attribute("size").value(), nullptr, 10) });
+                } catch (const std::runtime_error&) {
+                    // resources of other protocols
+                }
+            }
+        }
+        return count;
+    }
+
+    int id;
+    const Device& device;
+    const Profile& profile;
+    const std::vector<Request>& trace;
+    Stats& stats;
+    ResourcePool& pool;
+    std::mt19937 rng;
+    std::vector<std::string> containers;
+    int requests = 0;
+};
+
+/// \brief ranged GETs of random resources, as players seeking in a file
+static void download(Stats& stats, ResourcePool& pool, Clock::time_point deadline, std::uint64_t rangeSize, int seed)
+{
+    std::mt19937 rng(seed);
+    while (Clock::now() < deadline) {
+        ResourcePool::Resource resource;
+        if (!pool.pick(rng, resource)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        std::uint64_t offset = resource.size > rangeSize ? rng() % (resource.size - rangeSize) : 0;
+        timed(stats, "Download", [&] {
+            auto response = httpRequest(resource.url, "GET", { fmt::format("Range: bytes={}-{}", offset, offset + rangeSize - 1) }, "", false);
+            if (response.status != 206 && response.status != 200)
+                throw std::runtime_error(fmt::format("GET {} returned {}", resource.url.path, response.status));
+            stats.downloadedBytes += response.bodyBytes;
+        });
+    }
+}
+
+/// \brief accepts the GENA NOTIFY requests of the subscriptions
+class EventListener {
+public:
+    EventListener(const Url& server, Stats& stats)
+        : stats(stats)
+    {
+        // the address the server reaches us on is the one of the route to the server
+        int probe = connectTo(server.host, server.port, SOCK_DGRAM);
+        sockaddr_storage local {};
+        socklen_t length = sizeof(local);
+        getsockname(probe, reinterpret_cast<sockaddr*>(&local), &length);
+        close(probe);
+
+        fd = socket(local.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (local.ss_family == AF_INET6)
+            reinterpret_cast<sockaddr_in6*>(&local)->sin6_port = 0;
+        else
+            reinterpret_cast<sockaddr_in*>(&local)->sin_port = 0;
+        if (fd < 0 || bind(fd, reinterpret_cast<sockaddr*>(&local), length) != 0 || listen(fd, 64) != 0)
+            throw std::runtime_error(fmt::format("Cannot listen for events: {}", std::strerror(errno)));
+        getsockname(fd, reinterpret_cast<sockaddr*>(&local), &length);
+
+        char host[INET6_ADDRSTRLEN];
+        char port[8];
+        getnameinfo(reinterpret_cast<sockaddr*>(&local), length, host, sizeof(host), port, sizeof(port), NI_NUMERICHOST | NI_NUMERICSERV);
+        callback = local.ss_family == AF_INET6 ? fmt::format("http://[{}]:{}/", host, port) : fmt::format("http://{}:{}/", host, port);
+        thread = std::thread([this] { accept(); });
+    }
+
+    ~EventListener()
+    {
+        stop = true;
+        thread.join();
+        close(fd);
+    }
+
+    std::string callback;
+
+private:
+    void accept()
+    {
+        while (!stop) {
+            pollfd pfd { fd, POLLIN, 0 };
+            if (poll(&pfd, 1, 200) <= 0)
+                continue;
+            int client = ::accept4(fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0)
+                continue;
+            timeval timeout { 5, 0 };
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            std::string data;
+            char buffer[4096];
+            ssize_t bytes;
+            std::size_t headerEnd = std::string::npos;
+            std::size_t length = 0;
+            while ((bytes = recv(client, buffer, sizeof(buffer), 0)) > 0) {
+                data.append(buffer, bytes);
+                if (headerEnd == std::string::npos && (headerEnd = data.find("\r\n\r\n")) != std::string::npos) {
+                    auto header = toLower(data.substr(0, headerEnd));
+                    auto pos = header.find("content-length:");
+                    if (pos != std::string::npos)
+                        length = std::stoul(header.substr(pos + 15));
+                }
+                if (headerEnd != std::string::npos && data.size() >= headerEnd + 4 + length)
+                    break;
+            }
+            if (headerEnd != std::string::npos) {
+                stats.notifications++;
+                std::string ok = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+                send(client, ok.data(), ok.size(), MSG_NOSIGNAL);
+            }
+            close(client);
+        }
+    }
+
+    Stats& stats;
+    int fd;
+    std::atomic<bool> stop { false };
+    std::thread thread;
+};
+
+int main(int argc, char** argv)
+{
+    cxxopts::Options options("gerbera-loadgen", "Simulated UPnP control points against a running media server");
+
+    options.add_options() //
+        ("u,url", "Device description url, found by SSDP if not set", cxxopts::value<std::string>()) //
+        ("n,clients", "Number of control points", cxxopts::value<int>()->default_value("10")) //
+        ("d,duration", "Seconds to run", cxxopts::value<int>()->default_value("60")) //
+        ("p,profile", "Client pattern: samsung, bubbleupnp, vlc or mixed", cxxopts::value<std::string>()->default_value("mixed")) //
+        ("t,trace", "Replay Browse and Search requests of a trace file instead of a profile", cxxopts::value<std::string>(), "FILE") //
+        ("downloads", "Parallel ranged downloads", cxxopts::value<int>()->default_value("4")) //
+        ("range-size", "Bytes per ranged download", cxxopts::value<std::uint64_t>()->default_value("1048576")) //
+        ("subscribe", "Subscribe each control point to ContentDirectory events") //
+        ("think", "Milliseconds between the requests of a control point", cxxopts::value<int>()->default_value("0")) //
+        ("ssdp-timeout", "Milliseconds to wait for M-SEARCH answers", cxxopts::value<int>()->default_value("3000")) //
+        ("h,help", "Print this help and exit") //
+        ;
+
+    try {
+        auto opts = options.parse(argc, argv);
+        if (opts.count("help") > 0) {
+            std::cout << options.help() << std::endl;
+            return EXIT_SUCCESS;
+        }
+        int clients = std::max(1, opts["clients"].as<int>());
+        auto duration = std::chrono::seconds(std::max(1, opts["duration"].as<int>()));
+        auto ssdpTimeout = opts["ssdp-timeout"].as<int>();
+        auto rangeSize = std::max<std::uint64_t>(1, opts["range-size"].as<std::uint64_t>());
+
+        std::vector<const Profile*> selected;
+        auto profileName = opts["profile"].as<std::string>();
+        for (auto&& profile : profiles) {
+            if (profileName == "mixed" || profile.name == profileName)
+                selected.push_back(&profile);
+        }
+        if (selected.empty())
+            throw std::runtime_error(fmt::format("Unknown profile {}", profileName));
+
+        std::vector<Request> trace;
+        if (opts.count("trace") > 0) {
+            std::ifstream in(opts["trace"].as<std::string>());
+            if (!in)
+                throw std::runtime_error(fmt::format("Cannot read {}", opts["trace"].as<std::string>()));
+            std::string line;
+            while (std::getline(in, line)) {
+                if (!line.empty() && line[0] != '#')
+                    trace.push_back(Request::parse(line));
+            }
+        }
+
+        Stats stats;
+        std::string location = opts.count("url") > 0 ? opts["url"].as<std::string>() : "";
+        // every control point searches like after its start, the first answer is the server to load
+        std::vector<std::thread> threads;
+        std::mutex locationMutex;
+        for (int i = 0; i < clients; i++) {
+            threads.emplace_back([&] {
+                timed(stats, "M-SEARCH", [&] {
+                    auto found = discover(location.empty() ? "" : Url::parse(location).host, ssdpTimeout);
+                    std::lock_guard<std::mutex> lock(locationMutex);
+                    if (location.empty())
+                        location = found;
+                });
+            });
+        }
+        for (auto&& thread : threads)
+            thread.join();
+        threads.clear();
+        if (location.empty())
+            throw std::runtime_error("No media server found, set --url");
+
+        auto device = Device::load(location);
+        fmt::print("Loading {} with {} control points for {} s\n\n", location, clients, duration.count());
+
+        std::unique_ptr<EventListener> listener;
+        std::vector<std::string> subscriptions(clients);
+        if (opts.count("subscribe") > 0) {
+            listener = std::make_unique<EventListener>(device.events, stats);
+            for (int i = 0; i < clients; i++) {
+                timed(stats, "SUBSCRIBE", [&] {
+                    auto response = httpRequest(device.events, "SUBSCRIBE", { fmt::format("CALLBACK: <{}>", listener->callback), "NT: upnp:event", "TIMEOUT: Second-1800" });
+                    if (response.status != 200)
+                        throw std::runtime_error(fmt::format("SUBSCRIBE returned {}", response.status));
+                    subscriptions[i] = response.headers["sid"];
+                });
+            }
+        }
+
+        ResourcePool pool;
+        auto start = Clock::now();
+        auto deadline = start + duration;
+        std::vector<std::unique_ptr<ControlPoint>> controlPoints;
+        for (int i = 0; i < clients; i++) {
+            controlPoints.push_back(std::make_unique<ControlPoint>(i, device, *selected[i % selected.size()], trace, stats, pool));
+            threads.emplace_back([&, controlPoint = controlPoints.back().get()] { controlPoint->run(deadline, std::chrono::milliseconds(opts["think"].as<int>())); });
+        }
+        for (int i = 0; i < opts["downloads"].as<int>(); i++)
+            threads.emplace_back([&, i] { download(stats, pool, deadline, rangeSize, i); });
+        for (auto&& thread : threads)
+            thread.join();
+        auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        for (auto&& sid : subscriptions) {
+            if (!sid.empty())
+                timed(stats, "UNSUBSCRIBE", [&] { httpRequest(device.events, "UNSUBSCRIBE", { "SID: " + sid }); });
+        }
+        listener.reset();
+        stats.print(seconds);
+    } catch (const cxxopts::OptionException& e) {
+        std::cerr << "Failed to parse arguments: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
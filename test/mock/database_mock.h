@@ -18,13 +18,18 @@ public:
 
     void init() override { }
     void shutdown() override { }
+    void warmUpIndexes() override { }
 
     void addObject(std::shared_ptr<CdsObject> object, int* changedContainer) override { }
+    void addObjects(const std::vector<std::shared_ptr<CdsObject>>& objects, int* changedContainer) override { }
     void addContainerChain(std::string path, const std::string& lastClass, int lastRefID, int* containerID,
         std::vector<int>& updateID, const std::map<std::string, std::string>& lastMetadata) override { }
     fs::path buildContainerPath(int parentID, const std::string& title) override { return ""; }
 
-    void updateObject(std::shared_ptr<CdsObject> object, int* changedContainer) override { }
+    bool updateObject(std::shared_ptr<CdsObject> object, int* changedContainer) override { return true; }
+    void updatePlayStates(const std::map<int, int>& flags, const std::map<int, int>& bookmarks) override { }
+    void exportDatabase(const fs::path& path) override { }
+    void importDatabase(const fs::path& path) override { }
 
     std::vector<std::shared_ptr<CdsObject>> browse(const std::unique_ptr<BrowseParam>& param) override { return std::vector<std::shared_ptr<CdsObject>>(); }
     std::vector<std::shared_ptr<CdsObject>> search(const std::unique_ptr<SearchParam>& param, int* numMatches) override { return std::vector<std::shared_ptr<CdsObject>>(); }
@@ -39,11 +44,28 @@ public:
 
     std::unique_ptr<ChangedContainers> removeObject(int objectID, bool all) override { return nullptr; }
     std::unique_ptr<std::unordered_set<int>> getObjects(int parentID, bool withoutContainer) override { return nullptr; }
+    std::vector<int> getSubtreeItems(int containerID, std::size_t limit) override { return {}; }
+    std::vector<int> getItemIDs(int afterID, std::size_t limit) override { return {}; }
+    int addShadowContainer(const std::string& title) override { return INVALID_OBJECT_ID; }
+    std::unique_ptr<ChangedContainers> swapShadowContainer(int shadowID) override { return nullptr; }
+    std::unordered_map<std::string, ObjectStat> getChildStats(int parentID, bool withoutContainer) override { return {}; }
+    bool isDirectoryUnchanged(int objectID, time_t mtime) override { return false; }
+    void setDirectoryState(int objectID, time_t mtime) override { }
+    bool getFileState(int objectID, FileState& state) override { return false; }
+    void setFileState(int objectID, const FileState& state) override { }
     std::unique_ptr<ChangedContainers> removeObjects(const std::unique_ptr<std::unordered_set<int>>& list, bool all = false) override { return nullptr; }
+    std::unique_ptr<ChangedContainers> relocateSubtree(const fs::path& oldPath, const fs::path& newPath) override { return nullptr; }
 
     std::shared_ptr<CdsObject> loadObjectByServiceID(const std::string& serviceID) override { return nullptr; }
-    std::unique_ptr<std::vector<int>> getServiceObjectIDs(char servicePrefix) override { return nullptr; }
-
+    std::map<std::string, ServiceObject> getServiceObjects(char servicePrefix) override { return {}; }
+    void storeScrobbles(const std::vector<Scrobble>& scrobbles) override { }
+    std::vector<Scrobble> takeScrobbles() override { return {}; }
+    std::int64_t getChangeLogSequence() override { return 0; }
+    ChangeLog readChangeLog(const ChangeLog& previous) override { return previous; }
+
+    void runMaintenance() override { }
+    std::string getMaintenanceStatus() override { return ""; }
+    void storeUpdateIDs() override { }
     int getTotalFiles(bool isVirtual = false, const std::string& mimeType = "", const std::string& upnpClass = "") override { return 0; }
 
     std::string getInternalSetting(const std::string& key) override { return ""; }
@@ -70,6 +92,7 @@ public:
     int ensurePathExistence(fs::path path, int* changedContainer) override { return 0; }
 
     void clearFlagInDB(int flag) override { }
+    std::vector<int> getFlaggedObjectIDs(int flag) override { return {}; }
     std::string getFsRootName() override { return ""; }
 
     void threadCleanup() override { }
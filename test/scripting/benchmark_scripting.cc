@@ -0,0 +1,582 @@
+/*GRB*
+
+    Gerbera - https://gerbera.io/
+
+    benchmark_scripting.cc - this file is part of Gerbera.
+
+    Copyright (C) 2021 Gerbera Contributors
+
+    Gerbera is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License version 2
+    as published by the Free Software Foundation.
+
+    Gerbera is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Gerbera.  If not, see <http://www.gnu.org/licenses/>.
+
+    $Id$
+*/
+
+/// \file benchmark_scripting.cc
+#ifdef HAVE_JS
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <duktape.h>
+#include <fmt/format.h>
+#include <thread>
+#include <unordered_map>
+
+#include "cds_objects.h"
+#include "content/scripting/script_names.h"
+#include "content/scripting/scripting_runtime.h"
+#include "metadata/metadata_handler.h"
+#include "upnp_common.h"
+#include "util/tools.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double milliseconds(Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/// \brief one script in its own context of a runtime, with the native functions of the server
+///
+/// The native functions read their arguments as completely as the ones of the server do and answer with made up ids,
+/// so the time is spent in Duktape and the bridge only. The garbage collector runs as Script::collectGarbage does.
+class BenchmarkScript {
+public:
+    BenchmarkScript(std::shared_ptr<ScriptingRuntime> runtime, const std::string& name, const std::string& audioLayout)
+        : runtime(std::move(runtime))
+        , name(name)
+    {
+        ScriptingRuntime::AutoLock lock(this->runtime->getMutex());
+        ctx = this->runtime->createContext(name);
+        duk_push_thread_stash(ctx, ctx);
+        duk_push_pointer(ctx, this);
+        duk_put_prop_string(ctx, -2, "this");
+        duk_pop(ctx);
+        defineGlobals(audioLayout);
+        run(compile(fs::path(SCRIPTS_DIR) / "js" / "common.js"));
+    }
+
+    ~BenchmarkScript()
+    {
+        ScriptingRuntime::AutoLock lock(runtime->getMutex());
+        runtime->destroyContext(name);
+    }
+
+    /// \brief the compiled script on top of the stack
+    duk_idx_t compile(const fs::path& scriptPath)
+    {
+        auto scriptText = readTextFile(scriptPath);
+        duk_push_string(ctx, scriptPath.c_str());
+        if (duk_pcompile_lstring_filename(ctx, 0, scriptText.c_str(), scriptText.length()) != 0)
+            throw_std_runtime_error("Failed to compile {}: {}", scriptPath.c_str(), duk_safe_to_string(ctx, -1));
+        return duk_get_top_index(ctx);
+    }
+
+    /// \brief keep the compiled script on top of the stack as the one to run for each object
+    void setScript()
+    {
+        duk_push_thread_stash(ctx, ctx);
+        duk_swap_top(ctx, -2);
+        duk_put_prop_string(ctx, -2, "script");
+        duk_pop(ctx);
+    }
+
+    /// \brief run the script for the object as ImportScript::processCdsObject does
+    void processObject(const std::shared_ptr<CdsObject>& obj)
+    {
+        ScriptingRuntime::AutoLock lock(runtime->getMutex());
+        pushObject(obj);
+        duk_put_global_string(ctx, "orig");
+        duk_push_string(ctx, "/media/");
+        duk_put_global_string(ctx, "object_script_path");
+        runScript();
+        collectGarbage();
+    }
+
+    /// \brief run the script for the playlist as PlaylistParserScript::processPlaylistObject does
+    void processPlaylist(const std::shared_ptr<CdsObject>& obj, std::vector<std::string> playlistLines)
+    {
+        ScriptingRuntime::AutoLock lock(runtime->getMutex());
+        lines = std::move(playlistLines);
+        currentLine = 0;
+        pushObject(obj);
+        duk_put_global_string(ctx, "playlist");
+        runScript();
+        duk_push_undefined(ctx);
+        duk_put_global_string(ctx, "playlist");
+        collectGarbage();
+    }
+
+    static BenchmarkScript* getSelf(duk_context* ctx)
+    {
+        duk_push_thread_stash(ctx, ctx);
+        duk_get_prop_string(ctx, -1, "this");
+        auto self = static_cast<BenchmarkScript*>(duk_get_pointer(ctx, -1));
+        duk_pop_2(ctx);
+        return self;
+    }
+
+    /// \brief the properties of the object at idx converted to strings, one level deep like meta, aux and res
+    static std::size_t readObject(duk_context* ctx, duk_idx_t idx, int depth = 1)
+    {
+        std::size_t values = 0;
+        duk_enum(ctx, idx, DUK_ENUM_OWN_PROPERTIES_ONLY);
+        while (duk_next(ctx, -1, 1)) {
+            if (depth > 0 && duk_is_object(ctx, -1)) {
+                values += readObject(ctx, -1, depth - 1);
+            } else {
+                std::string value = duk_to_string(ctx, -1);
+                values += !value.empty();
+            }
+            duk_pop_2(ctx);
+        }
+        duk_pop(ctx);
+        return values;
+    }
+
+    int containerID(const std::string& path)
+    {
+        auto container = containers.find(path);
+        if (container != containers.end())
+            return container->second;
+        int id = int(containers.size()) + 100;
+        containers.emplace(path, id);
+        return id;
+    }
+
+    std::size_t addedObjects { 0 };
+    std::size_t readValues { 0 };
+    std::size_t gcRuns { 0 };
+    Clock::duration gcTime {};
+    duk_context* ctx;
+
+private:
+    void defineGlobals(const std::string& audioLayout)
+    {
+        for (auto&& [field, sym] : ot_names) {
+            duk_push_int(ctx, field);
+            duk_put_global_string(ctx, sym);
+        }
+        for (auto&& [field, sym] : upnp_classes) {
+            duk_push_string(ctx, field);
+            duk_put_global_string(ctx, sym);
+        }
+        for (auto&& [field, sym] : mt_names) {
+            duk_push_string(ctx, MetadataHandler::getMetaFieldName(field).c_str());
+            duk_put_global_string(ctx, sym);
+        }
+        for (auto&& [field, sym] : res_names) {
+            duk_push_string(ctx, MetadataHandler::getResAttrName(field).c_str());
+            duk_put_global_string(ctx, sym);
+        }
+        for (auto&& [sym, value] : std::vector<std::pair<const char*, int>> {
+                 { "ONLINE_SERVICE_NONE", 0 },
+                 { "ONLINE_SERVICE_YOUTUBE", -1 },
+                 { "ONLINE_SERVICE_APPLE_TRAILERS", -1 },
+                 { "ONLINE_SERVICE_SOPCAST", -1 },
+             }) {
+            duk_push_int(ctx, value);
+            duk_put_global_string(ctx, sym);
+        }
+        duk_push_object(ctx);
+        duk_push_string(ctx, audioLayout.c_str());
+        duk_put_prop_string(ctx, -2, "/import/scripting/virtual-layout/attribute::audio-layout");
+        duk_put_global_string(ctx, "config");
+
+        static const duk_function_list_entry functions[] = {
+            { "print", js_print, DUK_VARARGS },
+            { "addCdsObject", js_addCdsObject, 3 },
+            { "addContainerTree", js_addContainerTree, 1 },
+            { "copyObject", js_copyObject, 1 },
+            { "getCdsObject", js_getCdsObject, 1 },
+            { "readln", js_readln, 0 },
+            { nullptr, nullptr, 0 },
+        };
+        duk_push_global_object(ctx);
+        duk_put_function_list(ctx, -1, functions);
+        duk_pop(ctx);
+    }
+
+    /// \brief the properties of the object as Script::cdsObject2dukObject sets them
+    void pushObject(const std::shared_ptr<CdsObject>& obj)
+    {
+        duk_push_object(ctx);
+        duk_push_int(ctx, obj->getObjectType());
+        duk_put_prop_string(ctx, -2, "objectType");
+        duk_push_int(ctx, obj->getID());
+        duk_put_prop_string(ctx, -2, "id");
+        duk_push_string(ctx, obj->getTitle().c_str());
+        duk_put_prop_string(ctx, -2, "title");
+        duk_push_string(ctx, obj->getClass().c_str());
+        duk_put_prop_string(ctx, -2, "upnpclass");
+        duk_push_string(ctx, obj->getLocation().c_str());
+        duk_put_prop_string(ctx, -2, "location");
+        duk_push_int(ctx, 0);
+        duk_put_prop_string(ctx, -2, "theora");
+        duk_push_int(ctx, 0);
+        duk_put_prop_string(ctx, -2, "onlineservice");
+        if (obj->isItem()) {
+            duk_push_string(ctx, std::static_pointer_cast<CdsItem>(obj)->getMimeType().c_str());
+            duk_put_prop_string(ctx, -2, "mimetype");
+        }
+
+        auto pushMap = [this](const std::map<std::string, std::string>& values, const char* property) {
+            duk_push_object(ctx);
+            for (auto&& [key, value] : values) {
+                duk_push_string(ctx, value.c_str());
+                duk_put_prop_string(ctx, -2, key.c_str());
+            }
+            duk_put_prop_string(ctx, -2, property);
+        };
+        pushMap(obj->getMetadata(), "meta");
+        pushMap(obj->getAuxData(), "aux");
+        if (obj->getResourceCount() > 0)
+            pushMap(obj->getResource(0)->getAttributes(), "res");
+    }
+
+    void run(duk_idx_t function)
+    {
+        duk_dup(ctx, function);
+        if (duk_pcall(ctx, 0) != DUK_EXEC_SUCCESS)
+            throw_std_runtime_error("Failed to run {}: {}", name, duk_safe_to_string(ctx, -1));
+        duk_pop_2(ctx);
+    }
+
+    void runScript()
+    {
+        duk_push_thread_stash(ctx, ctx);
+        duk_get_prop_string(ctx, -1, "script");
+        duk_remove(ctx, -2);
+        if (duk_pcall(ctx, 0) != DUK_EXEC_SUCCESS)
+            throw_std_runtime_error("Failed to run {}: {}", name, duk_safe_to_string(ctx, -1));
+        duk_pop(ctx);
+    }
+
+    void collectGarbage()
+    {
+        gcCounter++;
+        bool countReached = gcCounter >= DEFAULT_JS_GC_INTERVAL;
+        bool heapGrown = runtime->getHeapSize() > heapAfterGc + std::size_t(DEFAULT_JS_GC_HEAP_GROWTH) * 1024;
+        if (!countReached && !heapGrown)
+            return;
+
+        auto start = Clock::now();
+        duk_gc(ctx, 0);
+        gcTime += Clock::now() - start;
+        gcRuns++;
+        heapAfterGc = runtime->getHeapSize();
+        gcCounter = 0;
+    }
+
+    static duk_ret_t js_print(duk_context* ctx) { return 0; }
+
+    static duk_ret_t js_addCdsObject(duk_context* ctx)
+    {
+        auto self = getSelf(ctx);
+        if (!duk_is_object(ctx, 0))
+            return 0;
+        self->readValues += readObject(ctx, 0);
+        std::string parent = duk_to_string(ctx, 1);
+        self->addedObjects++;
+        duk_push_string(ctx, parent.c_str());
+        return 1;
+    }
+
+    static duk_ret_t js_addContainerTree(duk_context* ctx)
+    {
+        auto self = getSelf(ctx);
+        if (!duk_is_array(ctx, 0))
+            return 0;
+        std::string tree;
+        auto length = duk_get_length(ctx, 0);
+        for (duk_size_t i = 0; i < length; i++) {
+            duk_get_prop_index(ctx, 0, i);
+            if (duk_is_object(ctx, -1)) {
+                self->readValues += readObject(ctx, -1);
+                duk_get_prop_string(ctx, -1, "title");
+                tree = fmt::format("{}/{}", tree, duk_to_string(ctx, -1));
+                duk_pop(ctx);
+            }
+            duk_pop(ctx);
+        }
+        duk_push_string(ctx, fmt::to_string(self->containerID(tree)).c_str());
+        return 1;
+    }
+
+    static duk_ret_t js_copyObject(duk_context* ctx)
+    {
+        auto self = getSelf(ctx);
+        if (!duk_is_object(ctx, 0))
+            return 0;
+        self->readValues += readObject(ctx, 0);
+        duk_push_object(ctx);
+        duk_enum(ctx, 0, DUK_ENUM_OWN_PROPERTIES_ONLY);
+        while (duk_next(ctx, -1, 1))
+            duk_put_prop(ctx, -4);
+        duk_pop(ctx);
+        return 1;
+    }
+
+    static duk_ret_t js_getCdsObject(duk_context* ctx)
+    {
+        auto self = getSelf(ctx);
+        fs::path location = duk_to_string(ctx, 0);
+        auto item = std::make_shared<CdsItem>();
+        item->setID(self->containerID(location));
+        item->setLocation(location);
+        item->setTitle(location.stem());
+        item->setMimeType("audio/mpeg");
+        item->setClass(UPNP_CLASS_MUSIC_TRACK);
+        item->setMetadata(M_TITLE, location.stem());
+        self->pushObject(item);
+        return 1;
+    }
+
+    static duk_ret_t js_readln(duk_context* ctx)
+    {
+        auto self = getSelf(ctx);
+        duk_push_string(ctx, self->currentLine < self->lines.size() ? self->lines[self->currentLine++].c_str() : "");
+        return 1;
+    }
+
+    std::shared_ptr<ScriptingRuntime> runtime;
+    std::string name;
+    std::unordered_map<std::string, int> containers;
+    std::vector<std::string> lines;
+    std::size_t currentLine { 0 };
+    int gcCounter { 0 };
+    std::size_t heapAfterGc { 0 };
+};
+
+/// \brief import.js and playlists.js over generated objects, GERBERA_BENCHMARK_OBJECTS=5000 sets their number
+///
+/// GERBERA_BENCHMARK_WORKERS=4 sets the number of threads importing at once.
+class ScriptingBenchmark : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        if (auto env = std::getenv("GERBERA_BENCHMARK_OBJECTS"))
+            objectCount = std::max(1, std::atoi(env));
+        if (auto env = std::getenv("GERBERA_BENCHMARK_WORKERS"))
+            workers = std::max(1, std::atoi(env));
+        for (int i = 0; i < objectCount; i++)
+            objects.push_back(createObject(i));
+    }
+
+    /// \brief eight of ten objects are tracks, one a video and one a photo
+    static std::shared_ptr<CdsObject> createObject(int number)
+    {
+        auto item = std::make_shared<CdsItem>();
+        item->setID(number + 1000);
+        auto resource = std::make_shared<CdsResource>(CH_DEFAULT);
+        int kind = number % 10;
+        if (kind < 8) {
+            int album = number / 10;
+            int artist = album / 10;
+            fs::path location = fmt::format("/media/Music/Artist {}/Album {}/Track {}.mp3", artist, album, number);
+            item->setLocation(location);
+            item->setTitle(location.stem());
+            item->setMimeType("audio/mpeg");
+            item->setClass(UPNP_CLASS_MUSIC_TRACK);
+            item->setMetadata(M_TITLE, location.stem());
+            item->setMetadata(M_ARTIST, fmt::format("Artist {}", artist));
+            item->setMetadata(M_ALBUM, fmt::format("Album {}", album));
+            item->setMetadata(M_GENRE, fmt::format("Genre {}", number % 20));
+            item->setMetadata(M_DATE, fmt::format("{}-01-01", 1960 + number % 60));
+            item->setMetadata(M_COMPOSER, fmt::format("Composer {}", number % 50));
+            item->setMetadata(M_TRACKNUMBER, fmt::to_string(number % 10 + 1));
+            resource->addAttribute(R_DURATION, "00:03:30");
+            resource->addAttribute(R_BITRATE, "40000");
+        } else if (kind == 8) {
+            fs::path location = fmt::format("/media/Video/Series {}/Episode {}.mp4", number / 100, number);
+            item->setLocation(location);
+            item->setTitle(location.stem());
+            item->setMimeType("video/mp4");
+            item->setClass(UPNP_CLASS_VIDEO_ITEM);
+            item->setMetadata(M_TITLE, location.stem());
+            resource->addAttribute(R_DURATION, "00:45:00");
+            resource->addAttribute(R_RESOLUTION, "1920x1080");
+        } else {
+            fs::path location = fmt::format("/media/Photos/{}/IMG_{}.jpg", 2000 + number % 20, number);
+            item->setLocation(location);
+            item->setTitle(location.stem());
+            item->setMimeType("image/jpeg");
+            item->setClass(UPNP_CLASS_IMAGE_ITEM);
+            item->setMetadata(M_TITLE, location.stem());
+            item->setMetadata(M_DATE, fmt::format("{}-{:02}-01", 2000 + number % 20, number % 12 + 1));
+            resource->addAttribute(R_RESOLUTION, "4000x3000");
+        }
+        resource->addAttribute(R_PROTOCOLINFO, renderProtocolInfo(item->getMimeType()));
+        resource->addAttribute(R_SIZE, "4194304");
+        item->addResource(resource);
+        return item;
+    }
+
+    void printHeader(const std::string& first)
+    {
+        fmt::print("{:<26} {:>8} {:>8} {:>12} {:>10} {:>8} {:>11} {:>11}\n", first, "objects", "added", "objects/s", "gc ms", "gc runs", "heap kB", "peak kB");
+    }
+
+    int objectCount = 5000;
+    int workers = 4;
+    std::vector<std::shared_ptr<CdsObject>> objects;
+};
+
+// compiling common.js and import.js again for each context against loading the bytecode dumped once
+TEST_F(ScriptingBenchmark, Compile)
+{
+    auto runtime = std::make_shared<ScriptingRuntime>();
+    BenchmarkScript script(runtime, "compile", "Default");
+    auto ctx = script.ctx;
+    constexpr int iterations = 100;
+
+    fmt::print("{:<26} {:>8} {:>12} {:>12}\n", "script", "calls", "compile us", "load us");
+    for (auto&& name : { "common.js", "import.js", "playlists.js" }) {
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            script.compile(fs::path(SCRIPTS_DIR) / "js" / name);
+            duk_pop(ctx);
+        }
+        auto compileTime = Clock::now() - start;
+
+        script.compile(fs::path(SCRIPTS_DIR) / "js" / name);
+        duk_dump_function(ctx);
+        duk_size_t size;
+        auto buffer = duk_get_buffer(ctx, -1, &size);
+        std::string bytecode(static_cast<const char*>(buffer), size);
+        duk_pop(ctx);
+        start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            auto target = duk_push_fixed_buffer(ctx, bytecode.size());
+            std::memcpy(target, bytecode.data(), bytecode.size());
+            duk_load_function(ctx);
+            EXPECT_TRUE(duk_is_function(ctx, -1));
+            duk_pop(ctx);
+        }
+        auto loadTime = Clock::now() - start;
+        fmt::print("{:<26} {:>8} {:>12.1f} {:>12.1f}\n", name, iterations, milliseconds(compileTime) * 1000 / iterations, milliseconds(loadTime) * 1000 / iterations);
+    }
+}
+
+TEST_F(ScriptingBenchmark, ImportLayouts)
+{
+    printHeader("layout");
+    for (auto&& layout : { "Default", "Structured" }) {
+        auto runtime = std::make_shared<ScriptingRuntime>();
+        BenchmarkScript script(runtime, "import", layout);
+        script.compile(fs::path(SCRIPTS_DIR) / "js" / "import.js");
+        script.setScript();
+
+        std::size_t peakHeap = 0;
+        auto start = Clock::now();
+        for (auto&& obj : objects) {
+            script.processObject(obj);
+            peakHeap = std::max(peakHeap, runtime->getHeapSize());
+        }
+        auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        EXPECT_GE(script.addedObjects, objects.size()) << layout;
+        fmt::print("{:<26} {:>8} {:>8} {:>12.0f} {:>10.1f} {:>8} {:>11} {:>11}\n", layout, objects.size(), script.addedObjects,
+            objects.size() / seconds, milliseconds(script.gcTime), script.gcRuns, runtime->getHeapSize() / 1024, peakHeap / 1024);
+    }
+}
+
+// the threads of the import share one runtime and wait for its lock, or each has its own heap
+TEST_F(ScriptingBenchmark, ImportWorkers)
+{
+    printHeader("runtime");
+    for (bool shared : { true, false }) {
+        auto sharedRuntime = std::make_shared<ScriptingRuntime>();
+        std::vector<std::shared_ptr<ScriptingRuntime>> runtimes;
+        std::vector<std::unique_ptr<BenchmarkScript>> scripts;
+        for (int i = 0; i < workers; i++) {
+            runtimes.push_back(shared ? sharedRuntime : std::make_shared<ScriptingRuntime>());
+            scripts.push_back(std::make_unique<BenchmarkScript>(runtimes.back(), fmt::format("import{}", i), "Default"));
+            scripts.back()->compile(fs::path(SCRIPTS_DIR) / "js" / "import.js");
+            scripts.back()->setScript();
+        }
+
+        auto start = Clock::now();
+        std::vector<std::thread> threads;
+        for (int worker = 0; worker < workers; worker++) {
+            threads.emplace_back([&, worker] {
+                for (std::size_t i = worker; i < objects.size(); i += workers)
+                    scripts[worker]->processObject(objects[i]);
+            });
+        }
+        for (auto&& thread : threads)
+            thread.join();
+        auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        std::size_t added = 0;
+        std::size_t gcRuns = 0;
+        Clock::duration gcTime {};
+        for (auto&& script : scripts) {
+            added += script->addedObjects;
+            gcRuns += script->gcRuns;
+            gcTime += script->gcTime;
+        }
+        std::size_t heap = 0;
+        for (auto&& runtime : shared ? std::vector<std::shared_ptr<ScriptingRuntime>> { sharedRuntime } : runtimes)
+            heap += runtime->getHeapSize();
+        EXPECT_GE(added, objects.size());
+        fmt::print("{:<26} {:>8} {:>8} {:>12.0f} {:>10.1f} {:>8} {:>11} {:>11}\n", fmt::format("{} x {}", workers, shared ? "shared" : "own heap"),
+            objects.size(), added, objects.size() / seconds, milliseconds(gcTime), gcRuns, heap / 1024, "");
+    }
+}
+
+TEST_F(ScriptingBenchmark, Playlists)
+{
+    printHeader("playlist");
+    // ten playlists of a hundred entries, local files and streams
+    constexpr int playlists = 10;
+    constexpr int entries = 100;
+    std::vector<std::pair<std::string, std::vector<std::string>>> formats;
+    std::vector<std::string> m3u { "#EXTM3U" };
+    std::vector<std::string> pls { "[playlist]", fmt::format("NumberOfEntries={}", entries) };
+    for (int i = 0; i < entries; i++) {
+        auto location = i % 2 ? fmt::format("Artist {}/Album {}/Track {}.mp3", i / 10, i, i) : fmt::format("http://radio.example.com/stream{}", i);
+        m3u.push_back(fmt::format("#EXTINF:210,Artist {} - Track {}", i / 10, i));
+        m3u.push_back(location);
+        pls.push_back(fmt::format("File{}={}", i + 1, location));
+        pls.push_back(fmt::format("Title{}=Track {}", i + 1, i));
+        pls.push_back(fmt::format("Length{}=210", i + 1));
+    }
+    formats.emplace_back("audio/x-mpegurl", m3u);
+    formats.emplace_back("audio/x-scpls", pls);
+
+    for (auto&& [mimeType, lines] : formats) {
+        auto runtime = std::make_shared<ScriptingRuntime>();
+        BenchmarkScript script(runtime, "playlist", "Default");
+        script.compile(fs::path(SCRIPTS_DIR) / "js" / "playlists.js");
+        script.setScript();
+
+        std::size_t peakHeap = 0;
+        auto start = Clock::now();
+        for (int i = 0; i < playlists; i++) {
+            auto playlist = std::make_shared<CdsItem>();
+            playlist->setID(i + 1);
+            playlist->setLocation(fmt::format("/media/Music/Playlist {}.{}", i, mimeType == "audio/x-scpls" ? "pls" : "m3u"));
+            playlist->setTitle(playlist->getLocation().filename());
+            playlist->setMimeType(mimeType);
+            playlist->setClass(UPNP_CLASS_ITEM);
+            script.processPlaylist(playlist, lines);
+            peakHeap = std::max(peakHeap, runtime->getHeapSize());
+        }
+        auto seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        EXPECT_GE(script.addedObjects, std::size_t(playlists * entries)) << mimeType;
+        fmt::print("{:<26} {:>8} {:>8} {:>12.0f} {:>10.1f} {:>8} {:>11} {:>11}\n", mimeType, playlists * entries, script.addedObjects,
+            playlists * entries / seconds, milliseconds(script.gcTime), script.gcRuns, runtime->getHeapSize() / 1024, peakHeap / 1024);
+    }
+}
+
+#endif // HAVE_JS
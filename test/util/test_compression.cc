@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "util/compression.h"
+#include "web/response_store.h"
+
+TEST(CompressionTest, AcceptsEncoding)
+{
+    EXPECT_TRUE(acceptsEncoding("gzip, deflate, br", "gzip"));
+    EXPECT_TRUE(acceptsEncoding("deflate;q=0.5, GZIP;q=0.8", "gzip"));
+    EXPECT_FALSE(acceptsEncoding("gzip;q=0, br", "gzip"));
+    EXPECT_FALSE(acceptsEncoding("identity", "gzip"));
+    EXPECT_FALSE(acceptsEncoding("", "gzip"));
+}
+
+#ifdef HAVE_ZLIB
+TEST(CompressionTest, GzipRoundTrip)
+{
+    std::string data;
+    for (int i = 0; i < 1000; i++)
+        data.append(R"({"id":)" + std::to_string(i) + R"(,"title":"Item )" + std::to_string(i) + "\"},");
+
+    auto compressed = gzipCompress(data, 6);
+    ASSERT_LT(compressed.size(), data.size() / 4);
+    EXPECT_EQ(compressed.substr(0, 2), "\x1f\x8b");
+
+    z_stream stream {};
+    ASSERT_EQ(inflateInit2(&stream, MAX_WBITS + 16), Z_OK);
+    std::string result(data.size(), '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(compressed.data());
+    stream.avail_in = compressed.size();
+    stream.next_out = reinterpret_cast<Bytef*>(result.data());
+    stream.avail_out = result.size();
+    EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+    EXPECT_EQ(stream.total_out, data.size());
+    inflateEnd(&stream);
+    EXPECT_EQ(result, data);
+}
+#endif
+
+TEST(CompressionTest, ResponseStoreHandsOutBodyOnce)
+{
+    web::ResponseStore store(std::chrono::seconds(30), 2);
+    auto first = store.put("first");
+    auto second = store.put("second");
+    auto third = store.put("third");
+    EXPECT_EQ(store.size(), 2u);
+
+    std::string body;
+    EXPECT_FALSE(store.take(first, body));
+    EXPECT_TRUE(store.take(third, body));
+    EXPECT_EQ(body, "third");
+    EXPECT_FALSE(store.take(third, body));
+    EXPECT_TRUE(store.take(second, body));
+    EXPECT_EQ(body, "second");
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include "util/didl_filter.h"
+
+static std::string render(const DidlFilter& filter)
+{
+    XmlStreamWriter writer;
+    FilteringXmlSink sink(writer, filter);
+    sink.startElement("item");
+    sink.addAttribute("id", "1");
+    sink.addAttribute("parentID", "0");
+    sink.addAttribute("restricted", "1");
+    sink.addAttribute("childCount", "2");
+    sink.addElement("dc:title", "Title");
+    sink.addElement("upnp:class", "object.item");
+    sink.addElement("upnp:artist", "Artist");
+    sink.startElement("res");
+    sink.addAttribute("duration", "0:01:00");
+    sink.addAttribute("protocolInfo", "http-get:*:audio/mpeg:*");
+    sink.addAttribute("size", "100");
+    sink.addText("http://server/1");
+    sink.endElement();
+    sink.endElement();
+    return writer.releaseFragment();
+}
+
+TEST(DidlFilterTest, SelectsEverythingWithWildcard)
+{
+    for (auto&& value : { "", "*", " * ", "dc:creator,*" }) {
+        DidlFilter filter(value);
+        EXPECT_TRUE(filter.all()) << value;
+        EXPECT_TRUE(filter.needsMetadata());
+        EXPECT_TRUE(filter.needsResources());
+    }
+}
+
+TEST(DidlFilterTest, KeepsRequiredAndRequestedProperties)
+{
+    DidlFilter filter("dc:title, res, res@duration, upnp:class");
+    EXPECT_FALSE(filter.all());
+    EXPECT_FALSE(filter.needsMetadata());
+    EXPECT_TRUE(filter.needsResources());
+
+    EXPECT_EQ(render(filter),
+        "<item id=\"1\" parentID=\"0\" restricted=\"1\">\n"
+        "<dc:title>Title</dc:title>\n"
+        "<upnp:class>object.item</upnp:class>\n"
+        "<res duration=\"0:01:00\" protocolInfo=\"http-get:*:audio/mpeg:*\">http://server/1</res>\n"
+        "</item>");
+}
+
+TEST(DidlFilterTest, LeavesOutResources)
+{
+    DidlFilter filter("upnp:artist,@childCount");
+    EXPECT_TRUE(filter.needsMetadata());
+    EXPECT_FALSE(filter.needsResources());
+
+    EXPECT_EQ(render(filter),
+        "<item id=\"1\" parentID=\"0\" restricted=\"1\" childCount=\"2\">\n"
+        "<dc:title>Title</dc:title>\n"
+        "<upnp:class>object.item</upnp:class>\n"
+        "<upnp:artist>Artist</upnp:artist>\n"
+        "</item>");
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include "util/json_writer.h"
+
+static void writeList(JsonSink& json)
+{
+    json.startObject("items");
+    json.addNumber("parent_id", 7);
+    json.addBool("virtual", true);
+    json.addString("autoscan_mode", "none");
+    json.startArray("item");
+    json.startObject("item");
+    json.addNumber("id", 8);
+    json.addString("title", "123");
+    json.end();
+    json.startObject("item");
+    json.addNumber("id", 9);
+    json.addString("title", "Title");
+    json.end();
+    json.end();
+    json.end();
+}
+
+TEST(JsonWriterTest, WritesNestedMembers)
+{
+    JsonStreamWriter writer;
+    writer.addBool("success", true);
+    writeList(writer);
+
+    EXPECT_EQ(writer.releaseFragment(),
+        "\"success\":true,"
+        "\"items\":{\"parent_id\":7,\"virtual\":true,\"autoscan_mode\":\"none\","
+        "\"item\":[{\"id\":8,\"title\":\"123\"},{\"id\":9,\"title\":\"Title\"}]}");
+}
+
+TEST(JsonWriterTest, EscapesStrings)
+{
+    std::string out;
+    JsonStreamWriter::escape(out, "a\"b\\c\nd\te\x01/");
+    EXPECT_EQ(out, "\"a\\\"b\\\\c\\nd\\te\\u0001/\"");
+}
+
+TEST(JsonWriterTest, ThrowsOnOpenObjects)
+{
+    JsonStreamWriter writer;
+    writer.startObject("items");
+    EXPECT_THROW(writer.releaseFragment(), std::runtime_error);
+}
+
+TEST(JsonWriterTest, MatchesXml2Json)
+{
+    pugi::xml_document doc;
+    auto root = doc.append_child("root");
+    Xml2Json::Hints hints;
+    PugiJsonSink sink(root, hints);
+    writeList(sink);
+
+    JsonStreamWriter writer;
+    writeList(writer);
+    EXPECT_EQ(Xml2Json::getJson(root, hints), "{" + writer.releaseFragment() + "}");
+}
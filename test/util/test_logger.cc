@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+
+#include "util/logger.h"
+
+TEST(LoggerTest, FiltersDebugBySubsystem)
+{
+    EXPECT_TRUE(GrbLogger::isDebugging("/build/src/database/sql_database.cc"));
+
+    GrbLogger::setDebugSubsystems({ "content", "server" });
+    EXPECT_TRUE(GrbLogger::isDebugging("/build/src/content/content_manager.cc"));
+    EXPECT_TRUE(GrbLogger::isDebugging("src/content/scripting/script.cc"));
+    EXPECT_TRUE(GrbLogger::isDebugging("/build/src/server.cc"));
+    EXPECT_FALSE(GrbLogger::isDebugging("/build/src/database/sql_database.cc"));
+    EXPECT_FALSE(GrbLogger::isDebugging("/build/test/util/test_logger.cc"));
+
+    GrbLogger::setDebugSubsystems({});
+    EXPECT_TRUE(GrbLogger::isDebugging("/build/src/database/sql_database.cc"));
+}
+
+TEST(LoggerTest, SkipsArgumentsOfDisabledLevels)
+{
+    auto level = spdlog::get_level();
+    spdlog::set_level(spdlog::level::err);
+    int evaluated = 0;
+    log_info("{}", ++evaluated);
+    log_warning("{}", ++evaluated);
+    EXPECT_EQ(evaluated, 0);
+    spdlog::set_level(level);
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "util/lru_cache.h"
+
+template <typename Cache>
+static std::vector<int> keys(Cache& cache)
+{
+    std::vector<int> result;
+    for (auto&& [key, value] : cache)
+        result.push_back(key);
+    return result;
+}
+
+TEST(LruCacheTest, KeepsMostRecentlyUsedFirst)
+{
+    LruCache<int, std::string> cache;
+    cache.put(1, "one");
+    cache.put(2, "two");
+    cache.put(3, "three");
+    EXPECT_EQ(keys(cache), (std::vector<int> { 3, 2, 1 }));
+
+    ASSERT_NE(cache.get(1), cache.end());
+    EXPECT_EQ(keys(cache), (std::vector<int> { 1, 3, 2 }));
+    ASSERT_NE(cache.find(2), cache.end());
+    EXPECT_EQ(keys(cache), (std::vector<int> { 1, 3, 2 }));
+    EXPECT_EQ(cache.find(4), cache.end());
+
+    EXPECT_EQ(cache.back().first, 2);
+    cache.pop_back();
+    EXPECT_EQ(keys(cache), (std::vector<int> { 1, 3 }));
+}
+
+TEST(LruCacheTest, ReplacesEntryOfSameKey)
+{
+    LruCache<int, std::string, std::unordered_map> cache;
+    cache.put(1, "one");
+    auto entry = cache.put(2, "two");
+    cache.put(1, "uno");
+
+    EXPECT_EQ(cache.size(), 2u);
+    EXPECT_EQ(cache.find(1)->second, "uno");
+    EXPECT_EQ(keys(cache), (std::vector<int> { 1, 2 }));
+    // moving other entries keeps the iterator
+    EXPECT_EQ(entry->second, "two");
+}
+
+TEST(LruCacheTest, ErasesByKeyAndIterator)
+{
+    LruCache<int, int> cache;
+    for (int i = 0; i < 4; i++)
+        cache.put(i, i);
+
+    EXPECT_TRUE(cache.erase(2));
+    EXPECT_FALSE(cache.erase(2));
+    auto next = cache.erase(cache.find(3));
+    ASSERT_NE(next, cache.end());
+    EXPECT_EQ(next->first, 1);
+    EXPECT_EQ(keys(cache), (std::vector<int> { 1, 0 }));
+
+    cache.clear();
+    EXPECT_TRUE(cache.empty());
+    EXPECT_EQ(cache.find(1), cache.end());
+}
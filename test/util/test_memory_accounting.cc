@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+
+#include "util/memory_accounting.h"
+#include "util/metrics.h"
+
+TEST(MemoryAccountingTest, SumsRegisteredHolders)
+{
+    auto& accounting = MemoryAccounting::getInstance();
+    auto first = accounting.add("test-holder", [] { return std::size_t(100); });
+    auto second = accounting.add("test-holder", [] { return std::size_t(20); });
+
+    accounting.setEnabled(false);
+    EXPECT_TRUE(accounting.getUsage().empty());
+
+    accounting.setEnabled(true);
+    EXPECT_EQ(accounting.getUsage()["test-holder"], 120u);
+
+    accounting.publish();
+    EXPECT_NE(Metrics::getInstance().render().find("gerbera_memory_bytes{subsystem=\"test-holder\"} 120\n"), std::string::npos);
+
+    // a destroyed holder is not asked again
+    second.reset();
+    EXPECT_EQ(accounting.getUsage()["test-holder"], 100u);
+    first.reset();
+    EXPECT_EQ(accounting.getUsage().count("test-holder"), 0u);
+    accounting.setEnabled(false);
+}
+
+TEST(MemoryAccountingTest, EstimatesStrings)
+{
+    EXPECT_EQ(MemoryAccounting::estimate(std::string("short")), 0u);
+    std::string heap(1000, 'x');
+    EXPECT_GE(MemoryAccounting::estimate(heap), 1000u);
+    EXPECT_GE(MemoryAccounting::estimate(std::map<std::string, std::string> { { "key", heap } }), 1000u + MemoryAccounting::TREE_NODE);
+}
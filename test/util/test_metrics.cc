@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include "util/metrics.h"
+
+TEST(MetricsTest, RendersCountersAndGauges)
+{
+    auto& metrics = Metrics::getInstance();
+    metrics.counter("test_requests_total", "Requests", Metrics::label("path", "/a")).inc(3);
+    auto& gauge = metrics.gauge("test_open", "Open things");
+    gauge.inc();
+    gauge.inc();
+    gauge.dec();
+
+    auto text = metrics.render();
+    EXPECT_NE(text.find("# HELP test_requests_total Requests\n# TYPE test_requests_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("test_requests_total{path=\"/a\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_open gauge\ntest_open 1\n"), std::string::npos);
+
+    // registering again returns the same metric
+    EXPECT_EQ(&metrics.gauge("test_open", "Open things"), &gauge);
+    EXPECT_THROW(metrics.counter("test_open", "Open things"), std::runtime_error);
+}
+
+TEST(MetricsTest, HistogramBucketsAreCumulative)
+{
+    auto& histogram = Metrics::getInstance().histogram("test_duration_seconds", "Durations", Metrics::label("kind", "x"));
+    histogram.observe(std::chrono::microseconds(200));
+    histogram.observe(std::chrono::milliseconds(20));
+    histogram.observe(std::chrono::seconds(60));
+
+    auto text = Metrics::getInstance().render();
+    EXPECT_NE(text.find("test_duration_seconds_bucket{kind=\"x\",le=\"0.0005\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("test_duration_seconds_bucket{kind=\"x\",le=\"0.05\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_duration_seconds_bucket{kind=\"x\",le=\"10\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_duration_seconds_bucket{kind=\"x\",le=\"+Inf\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("test_duration_seconds_sum{kind=\"x\"} 60.0202\n"), std::string::npos);
+    EXPECT_NE(text.find("test_duration_seconds_count{kind=\"x\"} 3\n"), std::string::npos);
+}
+
+TEST(MetricsTest, EscapesLabelValues)
+{
+    EXPECT_EQ(Metrics::label("file", "a\"b\\c\nd"), "file=\"a\\\"b\\\\c\\nd\"");
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+#include <fstream>
+#include <unistd.h>
+
+#include "util/mime.h"
+
+#include "../mock/config_mock.h"
+
+TEST(MimeTest, SniffsMediaSignatures)
+{
+    using namespace std::string_literals;
+    auto sniff = [](const std::string& data) { return Mime::sniffMimeType(data.data(), data.size()); };
+
+    EXPECT_EQ(sniff("\xFF\xD8\xFF\xE1....Exif"), "image/jpeg");
+    EXPECT_EQ(sniff("\x89PNG\r\n\x1A\n...."), "image/png");
+    EXPECT_EQ(sniff("ID3\x04\x00"s), "audio/mpeg");
+    EXPECT_EQ(sniff("fLaC\x00\x00"s), "audio/flac");
+    EXPECT_EQ(sniff("RIFF\x10\x00\x00\x00WAVEfmt "s), "audio/x-wav");
+    EXPECT_EQ(sniff("RIFF\x10\x00\x00\x00" "AVI LIST"s), "video/x-msvideo");
+    EXPECT_EQ(sniff("\0\0\0\x20" "ftypM4A "s), "audio/mp4");
+    EXPECT_EQ(sniff("\0\0\0\x20" "ftypisom"s), "video/mp4");
+    EXPECT_EQ(sniff("\x1A\x45\xDF\xA3\x01\x42\x82\x84webm"), "video/webm");
+    EXPECT_EQ(sniff("\x1A\x45\xDF\xA3\x01\x42\x82\x88matroska"), "video/x-matroska");
+
+    std::string ts(2 * 188 + 1, '\0');
+    ts[0] = ts[188] = ts[376] = 0x47;
+    EXPECT_EQ(sniff(ts), "video/mp2t");
+
+    EXPECT_EQ(sniff("RIFF"), "");
+    EXPECT_EQ(sniff("plain text"), "");
+}
+
+TEST(MimeTest, FallsBackToBuiltinMappings)
+{
+    auto dir = fs::temp_directory_path() / fmt::format("gerbera-mime-{}", getpid());
+    fs::create_directories(dir);
+    std::ofstream(dir / "photo.bin", std::ios::binary) << "\xFF\xD8\xFF\xE0";
+
+    Mime mime(std::make_shared<NiceMock<ConfigMock>>());
+    // the default mock maps no extensions
+    EXPECT_EQ(mime.getMimeType(dir / "photo.bin"), "image/jpeg");
+    EXPECT_EQ(mime.getMimeType(dir / "clip.WEBM"), "video/webm");
+    EXPECT_EQ(Mime::extensionToMimeType("jpg"), "image/jpeg");
+    EXPECT_EQ(Mime::extensionToMimeType("xyz"), "");
+
+    fs::remove_all(dir);
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <unistd.h>
+
+#include "util/process_executor.h"
+
+static int openPipe(int fds[2])
+{
+    int ret = pipe(fds);
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return ret;
+}
+
+static std::string readPipe(int fd)
+{
+    std::string result;
+    char buf[64];
+    ssize_t bytes;
+    while ((bytes = read(fd, buf, sizeof(buf))) > 0)
+        result.append(buf, bytes);
+    return result;
+}
+
+TEST(ProcessExecutorTest, WritesIntoOutputPipe)
+{
+    int fds[2];
+    ASSERT_EQ(openPipe(fds), 0);
+
+    ProcessExecutor exec("/bin/sh", { "-c", "echo transcoded > /dev/fd/3" }, fds[1]);
+    close(fds[1]);
+    EXPECT_EQ(readPipe(fds[0]), "transcoded\n");
+    close(fds[0]);
+
+    while (exec.isAlive())
+        usleep(1000);
+    EXPECT_EQ(exec.getStatus(), EXIT_SUCCESS);
+}
+
+TEST(ProcessExecutorTest, DoesNotLeakOtherDescriptors)
+{
+    int fds[2];
+    int other[2];
+    ASSERT_EQ(openPipe(fds), 0);
+    ASSERT_EQ(openPipe(other), 0);
+
+    auto script = fmt::format("if [ -e /dev/fd/{} ]; then echo leaked; else echo closed; fi > /dev/fd/3", other[1]);
+    ProcessExecutor exec("/bin/sh", { "-c", script }, fds[1]);
+    close(fds[1]);
+    EXPECT_EQ(readPipe(fds[0]), "closed\n");
+    close(fds[0]);
+    close(other[0]);
+    close(other[1]);
+}
+
+TEST(ProcessExecutorTest, LowersPriority)
+{
+    int fds[2];
+    ASSERT_EQ(openPipe(fds), 0);
+
+    errno = 0;
+    int current = nice(0);
+    ASSERT_EQ(errno, 0);
+    ProcessExecutor exec("/bin/sh", { "-c", "nice > /dev/fd/3" }, fds[1], 5);
+    close(fds[1]);
+    EXPECT_EQ(readPipe(fds[0]), fmt::format("{}\n", std::min(current + 5, 19)));
+    close(fds[0]);
+}
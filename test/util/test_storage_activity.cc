@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <fmt/format.h>
+#include <fstream>
+#include <unistd.h>
+
+#include "util/storage_activity.h"
+
+class StorageActivityTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        root = fs::temp_directory_path() / fmt::format("gerbera-storage-{}", getpid());
+        disk = root / "sys" / "devices" / "pci0000:00" / "block" / "sda";
+        fs::create_directories(disk / "sda1");
+        fs::create_directories(root / "sys" / "dev" / "block");
+        std::ofstream(disk / "sda1" / "partition") << "1\n";
+        writeStat(disk / "sda1", 5, 0);
+        writeStat(disk, 10, 0);
+        fs::create_directory_symlink("../../devices/pci0000:00/block/sda/sda1", root / "sys" / "dev" / "block" / "8:1");
+
+        std::ofstream(root / "mountinfo")
+            << "21 1 0:20 / / rw,relatime - overlay overlay rw\n"
+            << "36 21 8:1 / /media/disk rw,noatime master:1 - ext4 /dev/sda1 rw\n"
+            << "37 21 8:1 /other /media/old\\040disk rw,noatime - ext4 /dev/sda1 rw\n";
+    }
+
+    void TearDown() override { fs::remove_all(root); }
+
+    static void writeStat(const fs::path& dir, int reads, int inFlight)
+    {
+        std::ofstream(dir / "stat") << fmt::format("{:8} 0 {} 120 {:8} 0 0 0 {:8} 130 250\n", reads, reads * 8, 3, inFlight);
+    }
+
+    fs::path root;
+    fs::path disk;
+};
+
+TEST_F(StorageActivityTest, FindsDiskOfPath)
+{
+    StorageActivity storage(std::chrono::seconds(600), root / "mountinfo", root / "sys");
+    auto sda = fs::canonical(disk).string();
+
+    EXPECT_EQ(storage.getDisk("/media/disk/Movies/film.mkv"), sda);
+    EXPECT_EQ(storage.getDisk("/media/disk"), sda);
+    EXPECT_EQ(storage.getDisk("/media/old disk/song.mp3"), sda);
+    // no counters for the root file system, a longer name is not below the mount point
+    EXPECT_EQ(storage.getDisk("/media/diskette/song.mp3"), "");
+    EXPECT_EQ(storage.getDisk("/home"), "");
+}
+
+TEST_F(StorageActivityTest, DetectsActivity)
+{
+    StorageActivity storage(std::chrono::seconds(600), root / "mountinfo", root / "sys");
+    auto sda = storage.getDisk("/media/disk/film.mkv");
+
+    EXPECT_TRUE(storage.isActive(std::string()));
+    // nothing known about the disk yet
+    EXPECT_FALSE(storage.isActive(sda));
+    EXPECT_FALSE(storage.isActive(sda));
+
+    writeStat(disk, 11, 0);
+    EXPECT_TRUE(storage.isActive(sda));
+    // still within the idle time
+    EXPECT_TRUE(storage.isActive(sda));
+
+    StorageActivity busy(std::chrono::seconds(600), root / "mountinfo", root / "sys");
+    writeStat(disk, 11, 2);
+    EXPECT_TRUE(busy.isActive(fs::path("/media/disk/film.mkv")));
+}
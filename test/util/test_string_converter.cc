@@ -0,0 +1,26 @@
+#include <gtest/gtest.h>
+
+#include "util/string_converter.h"
+
+TEST(StringConverterTest, KeepsValidUTF8)
+{
+    StringConverter conv("UTF-8", "utf8");
+    EXPECT_EQ(conv.convert("Motörhead – Ace of Spades"), "Motörhead – Ace of Spades");
+    EXPECT_TRUE(conv.validate("Motörhead"));
+}
+
+TEST(StringConverterTest, ReplacesInvalidUTF8)
+{
+    StringConverter conv("UTF-8", "UTF-8");
+    EXPECT_FALSE(conv.validate("Mot\xf6rhead"));
+    EXPECT_EQ(conv.convert("Mot\xf6rhead"), "Mot?rhead");
+}
+
+TEST(StringConverterTest, ConvertsWithReusedDescriptor)
+{
+    for (int i = 0; i < 3; i++) {
+        StringConverter conv("ISO-8859-1", "UTF-8");
+        EXPECT_EQ(conv.convert("Mot\xf6rhead"), "Motörhead");
+    }
+    EXPECT_THROW(StringConverter("NO-SUCH-CHARSET", "UTF-8"), std::runtime_error);
+}
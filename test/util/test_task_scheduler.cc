@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <future>
+#include <thread>
+
+#include "util/task_scheduler.h"
+
+#include "../mock/config_mock.h"
+
+using namespace ::testing;
+
+class TestTask : public GenericTask {
+public:
+    TestTask(std::function<void()> fn, const std::string& group = "", task_owner_t owner = ContentManagerTask)
+        : GenericTask(owner)
+        , fn(std::move(fn))
+    {
+        setGroup(group);
+    }
+    void run() override { fn(); }
+
+private:
+    std::function<void()> fn;
+};
+
+class TaskSchedulerTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        config = std::make_shared<ConfigMock>();
+    }
+
+    std::shared_ptr<GenericTask> record(const std::string& name, const std::string& group = "")
+    {
+        return std::make_shared<TestTask>([this, name] { runOrder.push_back(name); }, group);
+    }
+
+    /// \brief start the scheduler and wait until all queued tasks ran
+    void runAll(TaskScheduler& scheduler)
+    {
+        std::promise<void> done;
+        scheduler.addTask(std::make_shared<TestTask>([&] { done.set_value(); }, "done"), TaskPriority::Background);
+        scheduler.run();
+        ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+        scheduler.shutdown();
+    }
+
+    std::shared_ptr<ConfigMock> config;
+    std::vector<std::string> runOrder;
+};
+
+TEST_F(TaskSchedulerTest, RunsHigherPriorityFirst)
+{
+    TaskScheduler scheduler(config, 1);
+    scheduler.addTask(record("rescan"), TaskPriority::Background);
+    scheduler.addTask(record("change"), TaskPriority::Normal);
+    scheduler.addTask(record("ui"), TaskPriority::Interactive);
+
+    runAll(scheduler);
+    EXPECT_EQ(runOrder, std::vector<std::string>({ "ui", "change", "rescan" }));
+}
+
+TEST_F(TaskSchedulerTest, GroupsTakeTurns)
+{
+    TaskScheduler scheduler(config, 1);
+    scheduler.addTask(record("video1", "/video"), TaskPriority::Normal);
+    scheduler.addTask(record("video2", "/video"), TaskPriority::Normal);
+    scheduler.addTask(record("video3", "/video"), TaskPriority::Normal);
+    scheduler.addTask(record("music1", "/music"), TaskPriority::Normal);
+
+    runAll(scheduler);
+    EXPECT_EQ(runOrder, std::vector<std::string>({ "video1", "music1", "video2", "video3" }));
+}
+
+TEST_F(TaskSchedulerTest, SkipsInvalidatedTasks)
+{
+    TaskScheduler scheduler(config, 1);
+    auto parent = record("parent");
+    scheduler.addTask(parent, TaskPriority::Normal);
+    auto child = record("child");
+    child->setParentID(parent->getID());
+    scheduler.addTask(child, TaskPriority::Normal);
+    scheduler.addTask(record("other"), TaskPriority::Normal);
+
+    scheduler.invalidateTask(parent->getID());
+    EXPECT_EQ(scheduler.getTasklist().size(), 1u);
+
+    runAll(scheduler);
+    EXPECT_EQ(runOrder, std::vector<std::string>({ "other" }));
+}
+
+TEST_F(TaskSchedulerTest, RunsTasksOfOneOwnerOneAtATime)
+{
+    TaskScheduler scheduler(config, 3);
+    std::atomic<int> running { 0 };
+    std::atomic<int> maxRunning { 0 };
+    for (int i = 0; i < 6; i++) {
+        scheduler.addTask(std::make_shared<TestTask>([&] {
+            int now = ++running;
+            maxRunning = std::max(maxRunning.load(), now);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            --running;
+        },
+                              std::to_string(i)),
+            TaskPriority::Normal);
+    }
+
+    runAll(scheduler);
+    EXPECT_EQ(maxRunning.load(), 1);
+}
+
+TEST_F(TaskSchedulerTest, ReportsProgress)
+{
+    TaskScheduler scheduler(config, 1);
+    auto task = record("import");
+    EXPECT_EQ(task->getProgress().startTime, 0);
+    EXPECT_EQ(task->getProgress().eta(), -1);
+    scheduler.addTask(task, TaskPriority::Normal);
+    runAll(scheduler);
+
+    task->addItemsTotal(4);
+    task->addItemsDone(1, 100);
+    auto progress = task->getProgress();
+    EXPECT_NE(progress.startTime, 0);
+    EXPECT_EQ(progress.itemsDone, 1u);
+    EXPECT_EQ(progress.itemsTotal, 4u);
+    EXPECT_EQ(progress.bytesRead, 100u);
+
+    progress.elapsed = std::chrono::seconds(2);
+    EXPECT_DOUBLE_EQ(progress.itemsPerSecond(), 0.5);
+    EXPECT_DOUBLE_EQ(progress.bytesPerSecond(), 50);
+    EXPECT_DOUBLE_EQ(progress.eta(), 6);
+}
+
+TEST_F(TaskSchedulerTest, RunsGroupsOfOwnerInParallel)
+{
+    TaskScheduler scheduler(config, 4);
+    scheduler.setConcurrency(TaskProcessorTask, 2);
+    std::atomic<int> running { 0 };
+    std::atomic<int> maxRunning { 0 };
+    std::atomic<int> runningA { 0 };
+    std::atomic<int> maxRunningA { 0 };
+    for (int i = 0; i < 6; i++) {
+        auto group = i % 3 == 0 ? "a" : std::to_string(i);
+        scheduler.addTask(std::make_shared<TestTask>([&, group] {
+            int now = ++running;
+            maxRunning = std::max(maxRunning.load(), now);
+            if (group == "a")
+                maxRunningA = std::max(maxRunningA.load(), ++runningA);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            if (group == "a")
+                --runningA;
+            --running;
+        },
+                              group, TaskProcessorTask),
+            TaskPriority::Normal);
+    }
+
+    runAll(scheduler);
+    EXPECT_EQ(maxRunning.load(), 2);
+    EXPECT_EQ(maxRunningA.load(), 1);
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+
+#include <future>
+#include <thread>
+
+#include "util/timer.h"
+
+#include "../mock/config_mock.h"
+
+using namespace ::testing;
+
+class RecordingSubscriber : public Timer::Subscriber {
+public:
+    void timerNotify(std::shared_ptr<Timer::Parameter> parameter) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        notified.push_back(parameter == nullptr ? -1 : parameter->getID());
+        if (notified.size() == expected)
+            done.set_value();
+    }
+
+    std::mutex mutex;
+    std::vector<int> notified;
+    std::size_t expected { 0 };
+    std::promise<void> done;
+};
+
+class TimerTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        config = std::make_shared<ConfigMock>();
+        timer = std::make_shared<Timer>(config);
+        timer->run();
+    }
+
+    void TearDown() override { timer->shutdown(); }
+
+    std::shared_ptr<ConfigMock> config;
+    std::shared_ptr<Timer> timer;
+};
+
+TEST_F(TimerTest, NotifiesInDueOrder)
+{
+    RecordingSubscriber subscriber;
+    subscriber.expected = 2;
+    auto later = std::make_shared<Timer::Parameter>(Timer::Parameter::IDAutoscan, 2);
+    auto removed = std::make_shared<Timer::Parameter>(Timer::Parameter::IDAutoscan, 3);
+    timer->addTimerSubscriber(&subscriber, 2, later, true);
+    timer->addTimerSubscriber(&subscriber, 1, removed, true);
+    timer->addTimerSubscriber(&subscriber, 1, nullptr, true);
+    timer->removeTimerSubscriber(&subscriber, removed);
+
+    ASSERT_EQ(subscriber.done.get_future().wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    std::lock_guard<std::mutex> lock(subscriber.mutex);
+    EXPECT_EQ(subscriber.notified, std::vector<int>({ -1, 2 }));
+}
+
+TEST_F(TimerTest, RejectsDuplicateSubscribers)
+{
+    RecordingSubscriber subscriber;
+    auto parameter = std::make_shared<Timer::Parameter>(Timer::Parameter::IDAutoscan, 1);
+    timer->addTimerSubscriber(&subscriber, 60, parameter);
+    EXPECT_THROW(timer->addTimerSubscriber(&subscriber, 60, parameter), std::runtime_error);
+    timer->removeTimerSubscriber(&subscriber, parameter);
+    EXPECT_THROW(timer->removeTimerSubscriber(&subscriber, parameter), std::runtime_error);
+}
+
+TEST_F(TimerTest, SlowSubscriberDoesNotDelayOthers)
+{
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    class BlockingSubscriber : public Timer::Subscriber {
+    public:
+        explicit BlockingSubscriber(std::shared_future<void> released)
+            : released(std::move(released))
+        {
+        }
+        void timerNotify(std::shared_ptr<Timer::Parameter> parameter) override { released.wait(); }
+        std::shared_future<void> released;
+    } slow(released);
+
+    RecordingSubscriber fast;
+    fast.expected = 1;
+    timer->addTimerSubscriber(&slow, 1, nullptr, true);
+    timer->addTimerSubscriber(&fast, 1, nullptr, true);
+
+    auto status = fast.done.get_future().wait_for(std::chrono::seconds(10));
+    release.set_value();
+    EXPECT_EQ(status, std::future_status::ready);
+    // wait for the slow notification before the subscribers go away
+    timer->shutdown();
+}
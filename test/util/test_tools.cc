@@ -1,7 +1,11 @@
 #include "util/tools.h"
 
+#include <fstream>
 #include <gtest/gtest.h>
 
+#include "iohandler/mem_io_handler.h"
+#include "metadata/metadata_handler.h"
+
 using namespace ::testing;
 
 TEST(ToolsTest, millisecondsToHMSF)
@@ -12,6 +16,48 @@ TEST(ToolsTest, millisecondsToHMSF)
     EXPECT_EQ(millisecondsToHMSF((3600 + 60 + 2) * 1000 + 123), "1:01:02.123");
 }
 
+TEST(ToolsTest, nptToMilliseconds)
+{
+    EXPECT_EQ(nptToMilliseconds("0"), 0);
+    EXPECT_EQ(nptToMilliseconds("75.5"), 75500);
+    EXPECT_EQ(nptToMilliseconds("1:01:02.123"), (3600 + 60 + 2) * 1000 + 123);
+    EXPECT_EQ(nptToMilliseconds("0:00:10"), 10000);
+    EXPECT_EQ(nptToMilliseconds(""), -1);
+    EXPECT_EQ(nptToMilliseconds("1:02"), -1);
+    EXPECT_EQ(nptToMilliseconds("10."), -1);
+    EXPECT_EQ(nptToMilliseconds("10.1234"), -1);
+    EXPECT_EQ(nptToMilliseconds("-5"), -1);
+}
+
+TEST(ToolsTest, parseHourRange)
+{
+    int start;
+    int end;
+    EXPECT_TRUE(parseHourRange("1-6", start, end));
+    EXPECT_EQ(start, 1);
+    EXPECT_EQ(end, 6);
+    EXPECT_TRUE(isInHourRange(1, start, end));
+    EXPECT_FALSE(isInHourRange(6, start, end));
+
+    EXPECT_TRUE(parseHourRange("22 - 5", start, end));
+    EXPECT_TRUE(isInHourRange(23, start, end));
+    EXPECT_TRUE(isInHourRange(0, start, end));
+    EXPECT_FALSE(isInHourRange(12, start, end));
+
+    EXPECT_FALSE(parseHourRange("", start, end));
+    EXPECT_FALSE(parseHourRange("3-3", start, end));
+    EXPECT_FALSE(parseHourRange("1-25", start, end));
+    EXPECT_FALSE(parseHourRange("1-2-3", start, end));
+    EXPECT_FALSE(parseHourRange("a-6", start, end));
+}
+
+TEST(ToolsTest, populateCommandLineStart)
+{
+    auto args = populateCommandLine("-ss %start -i %in %out", "in.mkv", "out", "", "title", 75500);
+    EXPECT_EQ(args, std::vector<std::string>({ "-ss", "75.500", "-i", "in.mkv", "out" }));
+    EXPECT_EQ(populateCommandLine("-ss %start %out", "in.mkv", "out")[1], "0.000");
+}
+
 TEST(ToolsTest, readWriteBinaryFile)
 {
     std::string source = "This is a test, \0, binary";
@@ -55,4 +101,143 @@ TEST(ToolsTest, renderWebUriV4)
 TEST(ToolsTest, renderWebUriV6)
 {
     EXPECT_EQ(renderWebUri("2001:0db8:85a3:0000:0000:8a2e:0370:7334", 7777), "[2001:0db8:85a3:0000:0000:8a2e:0370:7334]:7777");
-}
\ No newline at end of file
+}
+TEST(ToolsTest, stringHashIs64BitAndPositive)
+{
+    EXPECT_EQ(stringHash(""), 5472609002491880229LL);
+    EXPECT_EQ(stringHash("a"), 3414815163700866188LL);
+    EXPECT_NE(stringHash("F/music/a.mp3"), stringHash("F/music/b.mp3"));
+    EXPECT_GE(stringHash("F/home/music/a.mp3"), 0);
+}
+
+TEST(ToolsTest, jpegResolutionSkipsLargeSegments)
+{
+    std::string jpeg("\xff\xd8", 2);
+    // an exif block larger than the scan buffer
+    std::string exif(20000, 'x');
+    auto length = exif.size() + 2;
+    jpeg += std::string("\xff\xe1", 2) + char(length >> 8) + char(length & 0xff) + exif;
+    // SOF0: length, precision, height 480, width 640
+    jpeg += std::string("\xff\xc0\x00\x11\x08\x01\xe0\x02\x80", 9) + std::string(12, '\0');
+
+    auto ioh = std::unique_ptr<IOHandler>(std::make_unique<MemIOHandler>(jpeg));
+    ioh->open(UPNP_READ);
+    EXPECT_EQ(get_jpeg_resolution(ioh), "640x480");
+
+    auto truncated = std::unique_ptr<IOHandler>(std::make_unique<MemIOHandler>(jpeg.substr(0, 100)));
+    truncated->open(UPNP_READ);
+    EXPECT_THROW(get_jpeg_resolution(truncated), std::runtime_error);
+}
+
+TEST(ToolsTest, listDirectorySortsByType)
+{
+    auto dir = fs::temp_directory_path() / fmt::format("gerbera-list-{}", getpid());
+    fs::create_directories(dir / "b-dir");
+    fs::create_directories(dir / "a-dir");
+    fs::create_directories(dir / "empty");
+    fs::create_directories(dir / ".hidden");
+    std::ofstream(dir / "b-dir" / "z.mp3") << "z";
+    std::ofstream(dir / "y.mp3") << "y";
+    std::ofstream(dir / "x.mp3") << "x";
+    std::ofstream(dir / ".x.mp3") << "x";
+    fs::create_symlink(dir / "a-dir", dir / "c-link");
+
+    std::error_code ec;
+    EXPECT_EQ(listDirectory(dir, true, false, ec), std::vector<std::string>({ "a-dir", "b-dir", "c-link", "empty" }));
+    EXPECT_EQ(listDirectory(dir, false, false, ec), std::vector<std::string>({ "x.mp3", "y.mp3" }));
+    EXPECT_EQ(listDirectory(dir, false, true, ec), std::vector<std::string>({ ".x.mp3", "x.mp3", "y.mp3" }));
+    EXPECT_FALSE(ec);
+    EXPECT_TRUE(hasDirectoryEntries(dir / "b-dir"));
+    EXPECT_FALSE(hasDirectoryEntries(dir / "empty"));
+
+    listDirectory(dir / "missing", true, false, ec);
+    EXPECT_TRUE(ec);
+    fs::remove_all(dir);
+}
+
+TEST(ToolsTest, isValidUTF8)
+{
+    EXPECT_TRUE(isValidUTF8(""));
+    EXPECT_TRUE(isValidUTF8("<title>Gr\xc3\xbc\xc3\x9f \xe2\x82\xac \xf0\x9f\x8e\xac</title>"));
+    EXPECT_FALSE(isValidUTF8("Gr\xfc\xdf"));
+    EXPECT_FALSE(isValidUTF8("cut \xe2\x82"));
+    EXPECT_FALSE(isValidUTF8("overlong \xc0\xaf"));
+    EXPECT_FALSE(isValidUTF8("surrogate \xed\xa0\x80"));
+}
+
+TEST(ToolsTest, urlEscapeRoundTrip)
+{
+    EXPECT_EQ(urlEscape("a b&c=d/ü"), "a%20b%26c%3Dd%2Fü");
+    EXPECT_EQ(urlUnescape("a%20b%26c%3Dd%2f+x"), "a b&c=d/ x");
+    EXPECT_EQ(urlUnescape("trailing%2"), "trailing");
+}
+
+TEST(ToolsTest, dictDecodeKeepsFirstValue)
+{
+    std::map<std::string, std::string> dict;
+    dictDecode("b=2&a=1%261&novalue&b=3", &dict);
+    EXPECT_EQ(dict, (std::map<std::string, std::string> { { "a", "1&1" }, { "b", "2" } }));
+    EXPECT_EQ(dictEncode(dict), "a=1%261&b=2");
+
+    std::map<std::string, std::string> simple;
+    dictDecodeSimple("object_id/720/res_id/0", &simple);
+    EXPECT_EQ(dictEncodeSimple(simple), "object_id/720/res_id/0");
+}
+
+TEST(ToolsTest, hexEncodeAndAppendEncoding)
+{
+    const unsigned char data[] = { 0x00, 0x7f, 0xab, 0xff };
+    EXPECT_EQ(hexEncode(data, 4), "007fabff");
+    EXPECT_EQ(hexDecodeString("007fabff"), std::string(reinterpret_cast<const char*>(data), 4));
+    EXPECT_EQ(hexEncode(data, 0), "");
+
+    std::string url = "/content/media/object_id/1/res_id/0/";
+    dictEncodeSimple({ { "rct", "aa" }, { "pr name", "a/b" } }, url);
+    EXPECT_EQ(url, "/content/media/object_id/1/res_id/0/pr%20name/a%2Fb/rct/aa");
+}
+
+TEST(ToolsTest, dictEncodeCompactRoundTrip)
+{
+    std::map<std::string, std::string> dict {
+        { "protocolInfo", "http-get:*:audio/mpeg:*" },
+        { "url", "http://host/a~b|c&d=e" },
+        { "ctrl", std::string("\x01\x04\x05", 3) },
+        { "empty", "" },
+    };
+    auto compact = dictEncodeCompact(dict);
+    EXPECT_LT(compact.length(), dictEncode(dict).length());
+    EXPECT_EQ(compact.find_first_of(std::string("|~\0", 3)), std::string::npos);
+
+    std::map<std::string, std::string> decoded;
+    dictDecode(compact, &decoded);
+    EXPECT_EQ(decoded, dict);
+
+    EXPECT_EQ(dictEncodeCompact({}), "");
+}
+
+TEST(ToolsTest, hexFastHashMatchesMurmurHash3)
+{
+    // reference values of MurmurHash3_x64_128 with seed 0
+    EXPECT_EQ(hexStringFastHash(""), "00000000000000000000000000000000");
+    EXPECT_EQ(hexStringFastHash("hello"), "cbd8a7b341bd9b025b1e906a48ae1d19");
+    EXPECT_EQ(hexStringFastHash("The quick brown fox jumps over the lazy dog"), "e34bbc7bbc071b6c7a433ca9c49a9347");
+    EXPECT_EQ(hexStringFastHash("hello").size(), 32u);
+}
+
+TEST(ToolsTest, dlnaMimeTableMatchesHeaders)
+{
+    DLNAMimeTable table({ { "audio/mpeg", CONTENT_TYPE_MP3 }, { "image/jpeg", CONTENT_TYPE_JPG } });
+
+    auto&& mp3 = table.get("audio/mpeg");
+    EXPECT_EQ(mp3.contentType, CONTENT_TYPE_MP3);
+    EXPECT_EQ(mp3.profile, "DLNA.ORG_PN=MP3");
+    EXPECT_EQ(mp3.protocolInfoExtend, "DLNA.ORG_PN=MP3;DLNA.ORG_OP=01;DLNA.ORG_CI=0");
+    EXPECT_EQ(mp3.contentFeatures, getDLNAContentHeader(nullptr, CONTENT_TYPE_MP3));
+    EXPECT_EQ(mp3.transferMode, "Streaming");
+
+    EXPECT_EQ(table.get("image/jpeg").transferMode, "Interactive");
+    EXPECT_EQ(table.get("image/png").transferMode, "Interactive");
+    EXPECT_EQ(table.get("video/unknown").contentFeatures, getDLNAContentHeader(nullptr, ""));
+    EXPECT_EQ(table.get("video/unknown").transferMode, "Streaming");
+    EXPECT_EQ(table.get("text/plain").transferMode, "");
+}
@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "util/trace.h"
+
+TEST(TraceTest, CollectsNestedSpans)
+{
+    Trace trace("Browse", 1);
+    {
+        Trace::Scope scope(&trace);
+        TraceSpan browse("cds.browse");
+        {
+            TraceSpan db("db.browse");
+        }
+        TraceSpan render("didl.render");
+    }
+    // not traced once the scope ended
+    TraceSpan ignored("ignored");
+    trace.finish();
+
+    auto&& spans = trace.getSpans();
+    ASSERT_EQ(spans.size(), 4u);
+    EXPECT_EQ(spans[1].name, "cds.browse");
+    EXPECT_EQ(spans[1].depth, 1);
+    EXPECT_EQ(spans[2].depth, 2);
+    EXPECT_EQ(spans[3].depth, 2);
+    EXPECT_GE(spans[0].duration, spans[1].duration);
+
+    auto summary = trace.summary();
+    EXPECT_EQ(summary.find("Browse "), 0u);
+    EXPECT_NE(summary.find(": cds.browse "), std::string::npos);
+    EXPECT_NE(summary.find(", cds.browse/db.browse "), std::string::npos);
+    EXPECT_NE(summary.find(", cds.browse/didl.render "), std::string::npos);
+
+    auto events = trace.chromeEvents(spans[0].start);
+    EXPECT_EQ(events.find("{\"name\":\"Browse\",\"cat\":\"upnp\",\"ph\":\"X\",\"ts\":0,"), 0u);
+    EXPECT_NE(events.find(",\"tid\":1},\n"), std::string::npos);
+}
+
+TEST(TraceTest, SamplesEveryNthRequest)
+{
+    Tracer disabled(0, "");
+    EXPECT_EQ(disabled.sample("Browse"), nullptr);
+
+    Tracer tracer(3, "");
+    std::vector<unsigned long> ids;
+    for (int i = 0; i < 7; i++) {
+        auto trace = tracer.sample("Browse");
+        if (trace != nullptr)
+            ids.push_back(trace->getID());
+    }
+    EXPECT_EQ(ids, std::vector<unsigned long>({ 1, 2, 3 }));
+}
@@ -156,6 +156,23 @@ TEST_F(UpnpClientsTest, multipleClientsOnSameIP)
     EXPECT_EQ(pInfo->type, ClientType::StandardUPnP);
 }
 
+TEST_F(UpnpClientsTest, reloadMatchesAgain)
+{
+    const ClientInfo* pInfo = nullptr;
+    struct sockaddr_storage addr;
+    fillAddr(&addr, "192.168.1.43");
+
+    // the second request is answered from the resolved clients
+    subject->getInfo(&addr, "Microsoft-Windows/10.0 UPnP/1.0 Microsoft-DLNA DLNADOC/1.50", &pInfo);
+    subject->getInfo(&addr, "Microsoft-Windows/10.0 UPnP/1.0 Microsoft-DLNA DLNADOC/1.50", &pInfo);
+    EXPECT_EQ(pInfo->type, ClientType::StandardUPnP);
+
+    config->list->add(std::make_shared<ClientConfig>(7, "192.168.1.43", "added by reload"), 1);
+    subject->reload(config);
+    subject->getInfo(&addr, "Microsoft-Windows/10.0 UPnP/1.0 Microsoft-DLNA DLNADOC/1.50", &pInfo);
+    EXPECT_EQ(pInfo->flags, 7);
+}
+
 // keep this at the end of all tests (otherwise we need a removeClientInfo function...)
 TEST_F(UpnpClientsTest, configuredIP)
 {
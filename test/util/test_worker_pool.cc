@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include "util/worker_pool.h"
+
+#include "../mock/config_mock.h"
+
+class WorkerPoolTest : public ::testing::Test {
+public:
+    void SetUp() override
+    {
+        config = std::make_shared<ConfigMock>();
+    }
+
+    std::shared_ptr<ConfigMock> config;
+};
+
+TEST_F(WorkerPoolTest, RunsEveryIndexOnce)
+{
+    WorkerPool pool(config, "Test", 3);
+    pool.run();
+
+    std::vector<int> calls(100);
+    std::atomic<int> total { 0 };
+    pool.runBatch(calls.size(), [&](std::size_t index) {
+        calls[index]++;
+        total++;
+    });
+    EXPECT_EQ(total.load(), 100);
+    EXPECT_EQ(calls, std::vector<int>(100, 1));
+    pool.shutdown();
+}
+
+TEST_F(WorkerPoolTest, RethrowsAfterAllJobs)
+{
+    WorkerPool pool(config, "Test", 2);
+    pool.run();
+
+    std::atomic<int> total { 0 };
+    EXPECT_THROW(pool.runBatch(10, [&](std::size_t index) {
+        total++;
+        if (index == 3)
+            throw std::runtime_error("failed");
+    }),
+        std::runtime_error);
+    EXPECT_EQ(total.load(), 10);
+    pool.shutdown();
+}
+
+TEST_F(WorkerPoolTest, RunsWithoutThreads)
+{
+    WorkerPool pool(config, "Test", 2);
+    std::vector<std::thread::id> threads;
+    pool.runBatch(5, [&](std::size_t) { threads.push_back(std::this_thread::get_id()); });
+    EXPECT_EQ(threads, std::vector<std::thread::id>(5, std::this_thread::get_id()));
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include "util/xml_writer.h"
+
+TEST(XmlWriterTest, WritesLikePugixmlPrint)
+{
+    XmlStreamWriter writer;
+    writer.addDeclaration();
+    writer.startElement("DIDL-Lite");
+    writer.addAttribute("xmlns", "urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/");
+    writer.startElement("item");
+    writer.addAttribute("id", "1");
+    writer.addElement("dc:title", "Title");
+    writer.startElement("upnp:albumArtURI");
+    writer.addAttribute("dlna:profileID", "JPEG_TN");
+    writer.addText("http://server/aa");
+    writer.endElement();
+    writer.startElement("desc");
+    writer.endElement();
+    writer.endElement();
+    writer.endElement();
+
+    EXPECT_EQ(writer.release(),
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<DIDL-Lite xmlns=\"urn:schemas-upnp-org:metadata-1-0/DIDL-Lite/\">\n"
+        "<item id=\"1\">\n"
+        "<dc:title>Title</dc:title>\n"
+        "<upnp:albumArtURI dlna:profileID=\"JPEG_TN\">http://server/aa</upnp:albumArtURI>\n"
+        "<desc />\n"
+        "</item>\n"
+        "</DIDL-Lite>\n");
+}
+
+TEST(XmlWriterTest, EscapesTextAndAttributes)
+{
+    std::string text;
+    XmlStreamWriter::escape(text, "a&b <c> \"d\" 'e'\tf\x01", false);
+    EXPECT_EQ(text, "a&amp;b &lt;c&gt; \"d\" 'e'\tf&#01;");
+
+    std::string attribute;
+    XmlStreamWriter::escape(attribute, "a&b <c> \"d\" 'e'\tf\x01", true);
+    EXPECT_EQ(attribute, "a&amp;b &lt;c&gt; &quot;d&quot; 'e'&#09;f&#01;");
+}
+
+TEST(XmlWriterTest, AddsFragmentsOfOtherWriters)
+{
+    XmlStreamWriter fragment;
+    fragment.startElement("item");
+    fragment.addElement("dc:title", "Title");
+    fragment.endElement();
+
+    XmlStreamWriter writer;
+    writer.startElement("DIDL-Lite");
+    writer.addAttribute("xmlns", "urn");
+    writer.addFragment(fragment.releaseFragment());
+    writer.addFragment("<container />");
+    writer.endElement();
+
+    EXPECT_EQ(writer.release(),
+        "<DIDL-Lite xmlns=\"urn\">\n"
+        "<item>\n"
+        "<dc:title>Title</dc:title>\n"
+        "</item>\n"
+        "<container />\n"
+        "</DIDL-Lite>\n");
+}
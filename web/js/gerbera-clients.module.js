@@ -23,17 +23,63 @@
 import {GerberaApp} from './gerbera-app.module.js';
 import {Auth} from './gerbera-auth.module.js';
 
+const streamHeadings = {
+  ip: 'Client',
+  objectId: 'Object',
+  location: 'Location',
+  state: 'State',
+  seconds: 'Duration (s)',
+  firstByteMs: 'First Byte (ms)',
+  bytes: 'Bytes',
+  rate: 'KiB/s',
+  reads: 'Reads',
+  seeks: 'Seeks',
+  stalls: 'Stalls',
+  latency: 'Read Latency (<0.1/1/10/100/1000/more ms)'
+};
+
+const transcodeHeadings = {
+  name: 'Profile',
+  running: 'Running',
+  limit: 'Limit',
+  queued: 'Queued',
+  started: 'Started',
+  fallbacks: 'As Fallback',
+  rejected: 'Rejected'
+};
+
+const queryHeadings = {
+  fingerprint: 'Query',
+  count: 'Count',
+  slow: 'Slow',
+  rows: 'Rows',
+  totalMs: 'Total (ms)',
+  averageMs: 'Average (ms)',
+  maxMs: 'Max (ms)'
+};
+
+const memoryHeadings = {
+  name: 'Subsystem',
+  size: 'Memory (KiB)'
+};
+
 const destroy = () => {
-  const datagrid = $('#clientgrid');
-  if (datagrid.hasClass('grb-clients')) {
-    datagrid.clients('destroy');
-  } else {
-    datagrid.html('');
-  }
+  ['#clientgrid', '#streamgrid', '#transcodegrid', '#querygrid', '#memorygrid'].forEach((id) => {
+    const datagrid = $(id);
+    if (datagrid.hasClass('grb-clients')) {
+      datagrid.clients('destroy');
+    } else {
+      datagrid.html('');
+    }
+  });
 };
 
 const initialize = () => {
   $('#clientgrid').html('');
+  $('#streamgrid').html('');
+  $('#transcodegrid').html('');
+  $('#querygrid').html('');
+  $('#memorygrid').html('');
   return Promise.resolve();
 };
 
@@ -70,9 +116,116 @@ const loadItems = (response) => {
       data: items,
       itemType: 'clients'
     });
+
+    const streamgrid = $('#streamgrid');
+    if (streamgrid.hasClass('grb-clients')) {
+      streamgrid.clients('destroy');
+    }
+    if (response.streams) {
+      streamgrid.clients({
+        data: transformStreams(response.streams.stream || []),
+        itemType: 'streams',
+        headings: streamHeadings,
+        props: Object.keys(streamHeadings),
+        emptyText: 'No Streams found'
+      });
+    }
+
+    const transcodegrid = $('#transcodegrid');
+    if (transcodegrid.hasClass('grb-clients')) {
+      transcodegrid.clients('destroy');
+    }
+    if (response.transcoding) {
+      transcodegrid.clients({
+        data: transformTranscoding(response.transcoding),
+        itemType: 'transcoding',
+        headings: transcodeHeadings,
+        props: Object.keys(transcodeHeadings),
+        emptyText: 'No Transcoders found'
+      });
+    }
+
+    const querygrid = $('#querygrid');
+    if (querygrid.hasClass('grb-clients')) {
+      querygrid.clients('destroy');
+    }
+    if (response.queries) {
+      querygrid.clients({
+        data: transformQueries(response.queries.query || []),
+        itemType: 'queries',
+        headings: queryHeadings,
+        props: Object.keys(queryHeadings),
+        emptyText: 'No Queries found'
+      });
+    }
+
+    const memorygrid = $('#memorygrid');
+    if (memorygrid.hasClass('grb-clients')) {
+      memorygrid.clients('destroy');
+    }
+    if (response.memory) {
+      memorygrid.clients({
+        data: transformMemory(response.memory.subsystem || []),
+        itemType: 'memory',
+        headings: memoryHeadings,
+        props: Object.keys(memoryHeadings),
+        emptyText: 'No Memory accounted'
+      });
+    }
   }
 };
 
+const transformQueries = (queries) => {
+  return queries.map((query) => {
+    return Object.assign({}, query, {
+      totalMs: Number(query.totalMs).toFixed(1),
+      averageMs: Number(query.averageMs).toFixed(2),
+      maxMs: Number(query.maxMs).toFixed(1)
+    });
+  });
+};
+
+const transformMemory = (subsystems) => {
+  const total = subsystems.reduce((sum, subsystem) => sum + Number(subsystem.bytes), 0);
+  return subsystems.concat([{ name: 'all', bytes: total }]).map((subsystem) => {
+    return Object.assign({}, subsystem, {
+      size: (subsystem.bytes / 1024).toFixed(0)
+    });
+  });
+};
+
+const transformTranscoding = (transcoding) => {
+  const limit = (value) => value > 0 ? value : 'unlimited';
+  const total = {
+    name: 'all',
+    running: transcoding.running,
+    limit: limit(transcoding.limit),
+    queued: transcoding.queued,
+    started: '',
+    fallbacks: '',
+    rejected: ''
+  };
+  return [total].concat((transcoding.profile || []).map((profile) => {
+    return Object.assign({}, profile, {
+      limit: limit(profile.limit),
+      queued: ''
+    });
+  }));
+};
+
+const transformStreams = (streams) => {
+  return streams.map((stream) => {
+    const latency = stream.latency || {};
+    return Object.assign({}, stream, {
+      state: stream.active ? 'active' : 'done',
+      seconds: Number(stream.seconds).toFixed(1),
+      firstByteMs: stream.firstByteMs < 0 ? '' : Number(stream.firstByteMs).toFixed(1),
+      rate: (stream.bytesPerSecond / 1024).toFixed(0),
+      latency: ['le100us', 'le1000us', 'le10000us', 'le100000us', 'le1000000us', 'inf'].map((b) => latency[b] || 0).join(' / ')
+    });
+  });
+};
+
 const iptoi = (addr) => {
   var parts = addr.split('.').map((str) => { return parseInt(str); });
   
@@ -118,5 +271,8 @@ export const Clients = {
   loadItems,
   initialize,
   transformItems,
+  transformMemory,
+  transformStreams,
+  transformTranscoding,
   menuSelected,
 };
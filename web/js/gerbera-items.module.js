@@ -25,6 +25,11 @@ import {Auth} from './gerbera-auth.module.js';
 import {Trail} from './gerbera-trail.module.js';
 import {Updates} from "./gerbera-updates.module.js";
 
+// containers with more items scroll through one list instead of showing a pager
+const VIRTUAL_SCROLL_LIMIT = 1000;
+const VIRTUAL_PAGE_SIZE = 100;
+const VIRTUAL_ROW_HEIGHT = 49;
+
 const destroy = () => {
   const datagrid = $('#datagrid');
   if (datagrid.hasClass('grb-dataitems')) {
@@ -47,19 +52,42 @@ const treeItemSelected = function (data) {
     .catch((err) => GerberaApp.error(err));
 };
 
-const retrieveGerberaItems = (type, parentId, start, count) => {
+const retrieveGerberaItems = (type, parentId, start, count, fields) => {
+  const data = {
+    req_type: type,
+    sid: Auth.getSessionId(),
+    parent_id: parentId,
+    start: start,
+    count: count,
+    updates: 'check'
+  };
+  if (fields) {
+    data.fields = fields;
+  }
   return $.ajax({
     url: GerberaApp.clientConfig.api,
     type: 'get',
-    data: {
-      req_type: type,
-      sid: Auth.getSessionId(),
-      parent_id: parentId,
-      start: start,
-      count: count,
-      updates: 'check'
-    }
+    data: data
+  });
+};
+
+const virtualScrolling = (response) => {
+  const parentId = response.items.parent_id;
+  const items = {};
+  transformItems(response.items.item).forEach((item, offset) => {
+    items[response.items.start + offset] = item;
   });
+  return {
+    totalMatches: response.items.total_matches,
+    pageSize: VIRTUAL_PAGE_SIZE,
+    rowHeight: VIRTUAL_ROW_HEIGHT,
+    height: Math.max(VIRTUAL_ROW_HEIGHT * 10, $(window).height() - $('#datagrid').offset().top - 20),
+    items: items,
+    fetch: (start, count) => {
+      return retrieveGerberaItems('items', parentId, start, count, 'basic')
+        .then((page) => page.success ? transformItems(page.items.item) : []);
+    }
+  };
 };
 
 const loadItems = (response) => {
@@ -68,8 +96,14 @@ const loadItems = (response) => {
     let items;
     let parentItem;
     let pager;
+    let virtual;
 
-    if (type === 'db') {
+    if (type === 'db' && response.items.total_matches > VIRTUAL_SCROLL_LIMIT) {
+      items = [];
+      parentItem = response.items;
+      setPage(1); // reset page
+      virtual = virtualScrolling(response);
+    } else if (type === 'db') {
       items = transformItems(response.items.item);
       parentItem = response.items;
       setPage(1); // reset page
@@ -86,6 +120,17 @@ const loadItems = (response) => {
     } else if (type === 'fs') {
       items = transformFiles(response.files.file);
       parentItem = response.files;
+      setPage(1); // reset page
+      pager = {
+        currentPage: Math.ceil(response.files.start / GerberaApp.viewItems()) + 1,
+        pageCount: 10,
+        onClick: Items.retrieveItemsForPage,
+        onNext: Items.nextPage,
+        onPrevious: Items.previousPage,
+        totalMatches: response.files.total_matches,
+        itemsPerPage: GerberaApp.viewItems(),
+        parentId: response.files.parent_id
+      };
     }
 
     const datagrid = $('#datagrid');
@@ -97,6 +142,7 @@ const loadItems = (response) => {
     datagrid.dataitems({
       data: items,
       pager: pager,
+      virtual: virtual,
       onEdit: editItem,
       onDelete: deleteItemFromList,
       onDownload: downloadItem,
@@ -96,6 +96,7 @@ const onItemExpanded = (event) => {
         tree.tree('append', $(folderList), childTree);
 
         initSelection(pendingItems);
+        Updates.subscribe();
       })
     } else {
       tree.tree('collapse', $(folderList));
@@ -141,6 +142,7 @@ const loadTree = (response, config) => {
     if (pendingItems){
       initSelection(pendingItems);
     }
+    Updates.subscribe();
   }
 };
 
@@ -252,6 +254,7 @@ const reloadTreeItem = (folderList) => {
     tree.tree('append', folderList, childTree);
     selectTreeItem(folderList);
     Items.treeItemSelected(item);
+    Updates.subscribe();
   });
 };
 
@@ -26,6 +26,9 @@ import {Tree} from "./gerbera-tree.module.js";
 
 let POLLING_INTERVAL;
 let UI_TIMEOUT;
+let EVENT_SOURCE;
+let STREAMS_EXHAUSTED = false;
+let SUBSCRIBE_TIMEOUT;
 
 const initialize = () => {
   $('#toast').toast();
@@ -64,6 +67,26 @@ const showTask = (message, callback, type, icon) => {
   $('#toast').toast('showTask', toast);
 };
 
+const formatDuration = (seconds) => {
+  const minutes = Math.floor(seconds / 60);
+  const rest = Math.floor(seconds % 60);
+  return minutes + ':' + (rest < 10 ? '0' : '') + rest;
+};
+
+const taskText = (task) => {
+  if (!task.done) {
+    return task.text;
+  }
+  const progress = [task.total ? task.done + '/' + task.total : task.done];
+  if (task.rate) {
+    progress.push(task.rate.toFixed(1) + '/s');
+  }
+  if (task.eta >= 0) {
+    progress.push('ETA ' + formatDuration(task.eta));
+  }
+  return task.text + ' (' + progress.join(', ') + ')';
+};
+
 const getUpdates = (force) => {
   if (GerberaApp.isLoggedIn()) {
     let requestData = {
@@ -72,7 +95,7 @@ const getUpdates = (force) => {
     };
 
     let checkUpdates;
-    if (GerberaApp.getType() !== 'db') {
+    if (GerberaApp.getType() !== 'db' || (isStreaming() && !force)) {
       checkUpdates = {};
     } else {
       checkUpdates = {
@@ -102,7 +125,7 @@ const updateTask = (response) => {
       if (taskId === -1) {
         promise = Updates.clearTaskInterval(response);
       } else {
-        showTask(response.task.text, undefined, 'info', 'fa-refresh fa-spin fa-fw');
+        showTask(taskText(response.task), undefined, 'info', 'fa-refresh fa-spin fa-fw');
         Updates.addTaskInterval();
         promise = Promise.resolve(response);
       }
@@ -163,6 +186,66 @@ const isPolling = () => {
   return POLLING_INTERVAL;
 };
 
+const isStreaming = () => {
+  return EVENT_SOURCE;
+};
+
+// the containers shown in the tree, the server only reports changes of those
+const subscribedIds = () => {
+  return $('#tree li').map(function () {
+    return $(this).data('grb-id');
+  }).get();
+};
+
+const subscribe = () => {
+  if (SUBSCRIBE_TIMEOUT) {
+    window.clearTimeout(SUBSCRIBE_TIMEOUT);
+  }
+  SUBSCRIBE_TIMEOUT = window.setTimeout(function () {
+    SUBSCRIBE_TIMEOUT = false;
+    if (!GerberaApp.isLoggedIn() || GerberaApp.getType() !== 'db') {
+      Updates.closeStream();
+      return;
+    }
+    $.ajax({
+      url: GerberaApp.clientConfig.api,
+      type: 'get',
+      data: {
+        req_type: 'void',
+        sid: Auth.getSessionId(),
+        subscribe: subscribedIds().join(',')
+      }
+    })
+      .then(() => Updates.openStream())
+      .catch((err) => console.log(err));
+  }, 300);
+};
+
+const openStream = () => {
+  if (EVENT_SOURCE || STREAMS_EXHAUSTED || !window.EventSource || !GerberaApp.serverConfig['update-streams']) {
+    return;
+  }
+  EVENT_SOURCE = new EventSource(GerberaApp.clientConfig.api + '?' + $.param({
+    req_type: 'update_stream',
+    sid: Auth.getSessionId()
+  }));
+  EVENT_SOURCE.addEventListener('update', (event) => {
+    updateTreeByIds({success: true, update_ids: {updates: true, ids: event.data}});
+  });
+  EVENT_SOURCE.addEventListener('fallback', (event) => {
+    // all streams are taken by other tabs, keep polling
+    STREAMS_EXHAUSTED = event.data === 'streams';
+    Updates.closeStream();
+  });
+};
+
+const closeStream = () => {
+  if (EVENT_SOURCE) {
+    EVENT_SOURCE.close();
+    EVENT_SOURCE = false;
+  }
+};
+
 const clearAll = (response) => {
   Updates.clearUiTimer(response);
   Updates.clearTaskInterval(response);
@@ -207,12 +290,16 @@ export const Updates = {
   clearAll,
   clearTaskInterval,
   clearUiTimer,
+  closeStream,
   errorCheck,
   getUpdates,
   initialize,
   isPolling,
+  isStreaming,
   isTimer,
+  openStream,
   showMessage,
+  subscribe,
   updateTask,
   updateTreeByIds,
   updateUi,
@@ -30,7 +30,7 @@ $.widget('grb.clients', {
     const thead = $('<thead></thead>');
     const data = this.options.data;
     let row, content, text;
-    const headings = {
+    const headings = this.options.headings || {
       ip: 'IP Address',
       time: 'First Seen',
       last: 'Last Seen',
@@ -45,7 +45,7 @@ $.widget('grb.clients', {
 
     if (data.length > 0) {
 
-      const props = ['ip', 'host', 'name', 'userAgent', 'matchType', 'match', 'clientType', 'time', 'last', 'flags' ];
+      const props = this.options.props || ['ip', 'host', 'name', 'userAgent', 'matchType', 'match', 'clientType', 'time', 'last', 'flags' ];
       row = $('<tr></tr>');
       props.forEach( function(p) {
           content = $('<th></th>');
@@ -78,7 +78,7 @@ $.widget('grb.clients', {
     } else {
       row = $('<tr></tr>');
       content = $('<td></td>');
-      $('<span>No Clients found</span>').appendTo(content);
+      $('<span></span>').text(this.options.emptyText || 'No Clients found').appendTo(content);
       row.append(content);
       tbody.append(row);
     }
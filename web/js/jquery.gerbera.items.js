@@ -25,107 +25,222 @@ $.widget('grb.dataitems', {
   _create: function () {
     this.element.html('');
     this.element.addClass('grb-dataitems');
+    if (this.options.virtual) {
+      this.buildVirtual(this.options.virtual);
+      return;
+    }
     const table = $('<table></table>').addClass('table');
     const tbody = $('<tbody></tbody>');
     const data = this.options.data;
+    const pager = this.options.pager;
+
+    if (data.length > 0) {
+      for (let i = 0; i < data.length; i++) {
+        tbody.append(this.buildRow(data[i]));
+      }
+    } else {
+      tbody.append(this.buildEmptyRow());
+    }
+    tbody.appendTo(table);
+
+    const tfoot = this.buildFooter(pager);
+    table.append(tfoot);
+
+    this.element.append(table);
+    this.element.addClass('with-data');
+  },
+
+  buildEmptyRow: function () {
+    const row = $('<tr></tr>');
+    const content = $('<td></td>');
+    $('<span>No Items found</span>').appendTo(content);
+    row.append(content);
+    return row;
+  },
+
+  buildRow: function (item) {
     const onDelete = this.options.onDelete;
     const onEdit = this.options.onEdit;
     const onDownload = this.options.onDownload;
     const onAdd = this.options.onAdd;
     const itemType = this.options.itemType;
-    const pager = this.options.pager;
-    let row, content, text;
+    const row = $('<tr></tr>');
+    const content = $('<td></td>');
+    let text;
 
-    if (data.length > 0) {
-      for (let i = 0; i < data.length; i++) {
-        const item = data[i];
-        row = $('<tr></tr>');
-        content = $('<td></td>');
-
-        if (item.img) {
-          const img = $('<img src=""/>');
-          img.attr('src', item.img);
-          img.attr('style', 'height: 25px');
-          img.addClass('rounded float-left');
-          img.appendTo(content);
-        }
+    if (item.img) {
+      const img = $('<img src=""/>');
+      img.attr('src', item.img);
+      img.attr('style', 'height: 25px');
+      img.addClass('rounded float-left');
+      img.appendTo(content);
+    }
 
-        if (item.url) {
-          text = $('<a></a>');
-          text.attr('href', item.url).text(item.text).appendTo(content);
-        } else {
-          text = $('<span></span>');
-          text.text(item.text).appendTo(content);
-        }
-      if (item.image) {
-        text.prepend($('<img style="margin-right: 10px" width="36" src="' + item.image + '"/>'));
+    if (item.url) {
+      text = $('<a></a>');
+      text.attr('href', item.url).text(item.text).appendTo(content);
+    } else {
+      text = $('<span></span>');
+      text.text(item.text).appendTo(content);
+    }
+    if (item.image) {
+      text.prepend($('<img style="margin-right: 10px" width="36" src="' + item.image + '"/>'));
+    }
+    text.addClass('grb-item-url');
+
+    let buttons;
+    if (itemType === 'db') {
+      buttons = $('<div></div>');
+      buttons.addClass('grb-item-buttons pull-right');
+
+      const downloadIcon = $('<span></span>');
+      downloadIcon.prop('title', 'Download item');
+      downloadIcon.addClass('grb-item-download fa fa-download');
+      downloadIcon.appendTo(buttons);
+      if (onDownload) {
+        downloadIcon.click(item, onDownload);
       }
-        text.addClass('grb-item-url');
-
-        let buttons;
-        if (itemType === 'db') {
-          buttons = $('<div></div>');
-          buttons.addClass('grb-item-buttons pull-right');
-
-          const downloadIcon = $('<span></span>');
-          downloadIcon.prop('title', 'Download item');
-          downloadIcon.addClass('grb-item-download fa fa-download');
-          downloadIcon.appendTo(buttons);
-          if (onDownload) {
-            downloadIcon.click(item, onDownload);
-          }
 
-          const editIcon = $('<span></span>');
-          editIcon.prop('title', 'Edit item');
-          editIcon.addClass('grb-item-edit fa fa-pencil');
-          editIcon.appendTo(buttons);
-          if (onEdit) {
-            editIcon.click(item, onEdit);
-          }
+      const editIcon = $('<span></span>');
+      editIcon.prop('title', 'Edit item');
+      editIcon.addClass('grb-item-edit fa fa-pencil');
+      editIcon.appendTo(buttons);
+      if (onEdit) {
+        editIcon.click(item, onEdit);
+      }
 
-          const deleteIcon = $('<span></span>');
-          deleteIcon.prop('title', 'Delete item');
-          deleteIcon.addClass('grb-item-delete fa fa-trash-o');
-          deleteIcon.appendTo(buttons);
-          if (onDelete) {
-            deleteIcon.click(item, function (event) {
-              row.remove();
-              onDelete(event);
-            });
-          }
-          buttons.appendTo(content);
-        } else if (itemType === 'fs') {
-          buttons = $('<div></div>');
-          buttons.addClass('grb-item-buttons pull-right');
-
-          const addIcon = $('<span></span>');
-          addIcon.prop('title', 'Add item');
-          addIcon.addClass('grb-item-add fa fa-plus');
-          addIcon.appendTo(buttons);
-          if (onAdd) {
-            addIcon.click(item, onAdd);
-          }
-          buttons.appendTo(content);
-        }
+      const deleteIcon = $('<span></span>');
+      deleteIcon.prop('title', 'Delete item');
+      deleteIcon.addClass('grb-item-delete fa fa-trash-o');
+      deleteIcon.appendTo(buttons);
+      if (onDelete) {
+        deleteIcon.click(item, function (event) {
+          row.remove();
+          onDelete(event);
+        });
+      }
+      buttons.appendTo(content);
+    } else if (itemType === 'fs') {
+      buttons = $('<div></div>');
+      buttons.addClass('grb-item-buttons pull-right');
 
-        row.addClass('grb-item');
-        row.append(content);
-        tbody.append(row);
+      const addIcon = $('<span></span>');
+      addIcon.prop('title', 'Add item');
+      addIcon.addClass('grb-item-add fa fa-plus');
+      addIcon.appendTo(buttons);
+      if (onAdd) {
+        addIcon.click(item, onAdd);
       }
-    } else {
-      row = $('<tr></tr>');
-      content = $('<td></td>');
-      $('<span>No Items found</span>').appendTo(content);
-      row.append(content);
-      tbody.append(row);
+      buttons.appendTo(content);
     }
-    tbody.appendTo(table);
 
-    const tfoot = this.buildFooter(pager);
-    table.append(tfoot);
+    row.addClass('grb-item');
+    row.append(content);
+    return row;
+  },
 
-    this.element.append(table);
+  // Only the rows in view exist in the table, spacer rows stand in for the others.
+  // virtual: {totalMatches, pageSize, rowHeight, height, items: {index: item}, fetch: (start, count) => Promise of items}
+  buildVirtual: function (virtual) {
+    const viewport = $('<div class="grb-virtual-items"></div>');
+    viewport.css({ height: virtual.height + 'px', 'overflow-y': 'auto' });
+    const table = $('<table></table>').addClass('table');
+    const tbody = $('<tbody></tbody>');
+    tbody.appendTo(table);
+    table.appendTo(viewport);
+    this.element.append(viewport);
     this.element.addClass('with-data');
+
+    this.virtualRows = new Map(Object.entries(virtual.items || {}).map(([index, item]) => [Number(index), item]));
+    this.pendingPages = new Set();
+    this.viewport = viewport;
+    this.virtualBody = tbody;
+
+    if (virtual.totalMatches === 0) {
+      tbody.append(this.buildEmptyRow());
+      return;
+    }
+    viewport.on('scroll', () => {
+      if (!this.scrollFrame) {
+        this.scrollFrame = window.requestAnimationFrame(() => {
+          this.scrollFrame = null;
+          this.renderVirtual();
+        });
+      }
+    });
+    this.renderVirtual();
+  },
+
+  buildSpacer: function (height) {
+    const row = $('<tr class="grb-virtual-spacer"></tr>');
+    $('<td></td>').css({ height: height + 'px', padding: 0, border: 0 }).appendTo(row);
+    return row;
+  },
+
+  renderVirtual: function () {
+    const virtual = this.options.virtual;
+    const overscan = 10;
+    const scrollTop = this.viewport.scrollTop();
+    const first = Math.max(0, Math.floor(scrollTop / virtual.rowHeight) - overscan);
+    const last = Math.min(virtual.totalMatches, Math.ceil((scrollTop + virtual.height) / virtual.rowHeight) + overscan);
+
+    const tbody = this.virtualBody;
+    tbody.empty();
+    tbody.append(this.buildSpacer(first * virtual.rowHeight));
+    for (let index = first; index < last; index++) {
+      const item = this.virtualRows.get(index);
+      let row;
+      if (item) {
+        row = this.buildRow(item);
+      } else {
+        row = $('<tr class="grb-item"><td><span class="grb-item-url">Loading...</span></td></tr>');
+      }
+      row.css('height', virtual.rowHeight + 'px');
+      tbody.append(row);
+    }
+    tbody.append(this.buildSpacer((virtual.totalMatches - last) * virtual.rowHeight));
+
+    this.fetchMissing(first, last);
+    this.evictRows(first, last);
+  },
+
+  fetchMissing: function (first, last) {
+    const virtual = this.options.virtual;
+    for (let page = Math.floor(first / virtual.pageSize); page * virtual.pageSize < last; page++) {
+      const start = page * virtual.pageSize;
+      const end = Math.min(start + virtual.pageSize, virtual.totalMatches);
+      let missing = false;
+      for (let index = start; index < end && !missing; index++) {
+        missing = !this.virtualRows.has(index);
+      }
+      if (!missing || this.pendingPages.has(page)) {
+        continue;
+      }
+      this.pendingPages.add(page);
+      virtual.fetch(start, virtual.pageSize)
+        .then((items) => {
+          this.pendingPages.delete(page);
+          if (!this.virtualBody) {
+            return;
+          }
+          items.forEach((item, offset) => this.virtualRows.set(start + offset, item));
+          this.renderVirtual();
+        })
+        .catch(() => this.pendingPages.delete(page));
+    }
+  },
+
+  // keep the memory bounded when scrolling through very large containers
+  evictRows: function (first, last) {
+    const keep = this.options.virtual.pageSize * 20;
+    if (this.virtualRows.size <= keep * 2) {
+      return;
+    }
+    for (const index of this.virtualRows.keys()) {
+      if (index < first - keep || index > last + keep) {
+        this.virtualRows.delete(index);
+      }
+    }
   },
 
   buildFooter: function (pager) {
@@ -199,7 +314,13 @@ $.widget('grb.dataitems', {
   },
 
   _destroy: function () {
+    if (this.scrollFrame) {
+      window.cancelAnimationFrame(this.scrollFrame);
+      this.scrollFrame = null;
+    }
+    this.virtualBody = null;
     this.element.children('table').remove();
+    this.element.children('.grb-virtual-items').remove();
     this.element.removeClass('grb-dataitems');
     this.element.removeClass('with-data');
   }